@@ -0,0 +1,341 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "benchmarks/adversarial_benchmarks.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include "absl/functional/function_ref.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "benchmarks/adversarial_messages.pb.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/json/json.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/text_format.h"
+#include "google/protobuf/wire_format.h"
+#include "google/protobuf/wire_format_lite.h"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+namespace {
+
+using internal::WireFormat;
+using internal::WireFormatLite;
+using ::protobuf_benchmarks::Hostile;
+using ::protobuf_benchmarks::HostileSet;
+
+// Inputs are grown to about this many bytes.
+constexpr int kInputSize = 1 << 20;
+// Below the default recursion limit of 100 of the binary and JSON parsers, so
+// that nested inputs are parsed all the way down.
+constexpr int kMaxDepth = 90;
+
+// An input and the type it is parsed into.
+struct Input {
+  const Message* prototype;
+  std::string data;
+};
+
+std::string Encode(absl::FunctionRef<void(io::CodedOutputStream&)> write) {
+  std::string out;
+  {
+    io::StringOutputStream stream(&out);
+    io::CodedOutputStream output(&stream);
+    write(output);
+  }
+  return out;
+}
+
+// Calls `write` with increasing indices until the output reaches kInputSize.
+std::string Repeat(absl::FunctionRef<void(io::CodedOutputStream&, int)> write) {
+  return Encode([write](io::CodedOutputStream& output) {
+    for (int i = 0; output.ByteCount() < kInputSize; ++i) write(output, i);
+  });
+}
+
+void WriteLengthDelimited(int field_number, absl::string_view value,
+                          io::CodedOutputStream& output) {
+  WireFormatLite::WriteTag(field_number,
+                           WireFormatLite::WIRETYPE_LENGTH_DELIMITED, &output);
+  output.WriteVarint32(static_cast<uint32_t>(value.size()));
+  output.WriteRaw(value.data(), static_cast<int>(value.size()));
+}
+
+// Every field has a number of its own, so each one is a new unknown field.
+std::string TinyUnknownFields() {
+  return Repeat([](io::CodedOutputStream& output, int i) {
+    WireFormatLite::WriteTag(100 + i % 100000, WireFormatLite::WIRETYPE_VARINT,
+                             &output);
+    output.WriteVarint32(0);
+  });
+}
+
+std::string DeepUnknownGroups() {
+  return Repeat([](io::CodedOutputStream& output, int) {
+    for (int depth = 0; depth < kMaxDepth; ++depth) {
+      WireFormatLite::WriteTag(100 + depth,
+                               WireFormatLite::WIRETYPE_START_GROUP, &output);
+    }
+    for (int depth = kMaxDepth; depth-- > 0;) {
+      WireFormatLite::WriteTag(100 + depth, WireFormatLite::WIRETYPE_END_GROUP,
+                               &output);
+    }
+  });
+}
+
+// `children` elements nested as Group.child.Group.child... to kMaxDepth.
+std::string DeepGroups() {
+  Hostile chain;
+  Hostile* level = &chain;
+  for (int depth = 1; depth < kMaxDepth / 2; ++depth) {
+    level = level->mutable_group()->mutable_child();
+  }
+  level->set_id(1);
+  const std::string element = chain.SerializeAsString();
+  return Repeat([&element](io::CodedOutputStream& output, int) {
+    WriteLengthDelimited(Hostile::kChildrenFieldNumber, element, output);
+  });
+}
+
+// Tags padded to 5 bytes and values padded to the maximum of 10 bytes.
+std::string OverlongVarints() {
+  static constexpr char kIdTag[] = "\x88\x80\x80\x80\x00";
+  static constexpr char kValueTag[] = "\x90\x80\x80\x80\x00";
+  static constexpr char kOne[] = "\x81\x80\x80\x80\x80\x80\x80\x80\x80\x00";
+  return Repeat([](io::CodedOutputStream& output, int i) {
+    output.WriteRaw(i % 2 == 0 ? kIdTag : kValueTag, 5);
+    output.WriteRaw(kOne, 10);
+  });
+}
+
+std::string OverlongPackedVarints() {
+  static constexpr char kOne[] = "\x81\x80\x80\x80\x80\x80\x80\x80\x80\x00";
+  std::string values;
+  for (int i = 0; i < 1000; ++i) values.append(kOne, 10);
+  return Repeat([&values](io::CodedOutputStream& output, int) {
+    WriteLengthDelimited(Hostile::kVarintsFieldNumber, values, output);
+  });
+}
+
+// Every entry overwrites the previous one.
+std::string RepeatedMapKeys() {
+  const std::string entry = Encode([](io::CodedOutputStream& output) {
+    WriteLengthDelimited(1, std::string(32, 'k'), output);
+    WireFormatLite::WriteTag(2, WireFormatLite::WIRETYPE_VARINT, &output);
+    output.WriteVarint32(1);
+  });
+  return Repeat([&entry](io::CodedOutputStream& output, int) {
+    WriteLengthDelimited(Hostile::kCountsFieldNumber, entry, output);
+  });
+}
+
+// A packed field claiming 1GiB, of which only kInputSize bytes follow.
+std::string PackedWrongLength(int field_number, char fill) {
+  std::string data = Encode([field_number](io::CodedOutputStream& output) {
+    WireFormatLite::WriteTag(field_number,
+                             WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+                             &output);
+    output.WriteVarint32(uint32_t{1} << 30);
+  });
+  data.append(kInputSize, fill);
+  return data;
+}
+
+// Items with the message before the type id, alternating between the known
+// extension, which is merged into over and over, and unknown type ids.
+std::string MessageSetAbuse() {
+  return Repeat([](io::CodedOutputStream& output, int i) {
+    Hostile message;
+    message.set_id(i);
+    WireFormatLite::WriteTag(WireFormatLite::kMessageSetItemNumber,
+                             WireFormatLite::WIRETYPE_START_GROUP, &output);
+    WriteLengthDelimited(WireFormatLite::kMessageSetMessageNumber,
+                         message.SerializeAsString(), output);
+    WireFormatLite::WriteTag(WireFormatLite::kMessageSetTypeIdNumber,
+                             WireFormatLite::WIRETYPE_VARINT, &output);
+    output.WriteVarint32(i % 2 == 0 ? Hostile::kMessageSetExtensionFieldNumber
+                                    : 2000 + i);
+    WireFormatLite::WriteTag(WireFormatLite::kMessageSetItemNumber,
+                             WireFormatLite::WIRETYPE_END_GROUP, &output);
+  });
+}
+
+// Appends `element(i)` separated by `separator` until kInputSize is reached.
+std::string Join(absl::string_view prefix,
+                 absl::FunctionRef<std::string(int)> element,
+                 absl::string_view separator, absl::string_view suffix) {
+  std::string out(prefix);
+  for (int i = 0; out.size() < static_cast<size_t>(kInputSize); ++i) {
+    if (i > 0) out.append(separator.data(), separator.size());
+    out += element(i);
+  }
+  out.append(suffix.data(), suffix.size());
+  return out;
+}
+
+// `open` kMaxDepth / 2 times around `leaf`, closed by as many `close`.
+std::string Nest(absl::string_view open, absl::string_view leaf,
+                 absl::string_view close) {
+  std::string out;
+  for (int depth = 1; depth < kMaxDepth / 2; ++depth) {
+    absl::StrAppend(&out, open);
+  }
+  absl::StrAppend(&out, leaf);
+  for (int depth = 1; depth < kMaxDepth / 2; ++depth) {
+    absl::StrAppend(&out, close);
+  }
+  return out;
+}
+
+template <typename Parse>
+void Register(absl::string_view input_name, absl::string_view parser_name,
+              std::shared_ptr<const Input> input, Parse parse) {
+  benchmark::RegisterBenchmark(
+      absl::StrCat("Adversarial/", input_name, "/", parser_name).c_str(),
+      [input, parse](benchmark::State& state) {
+        std::unique_ptr<Message> message(input->prototype->New());
+        for (auto _ : state) {
+          message->Clear();
+          benchmark::DoNotOptimize(parse(input->data, message.get()));
+        }
+        const int64_t bytes = static_cast<int64_t>(state.iterations()) *
+                              static_cast<int64_t>(input->data.size());
+        state.SetBytesProcessed(bytes);
+        state.counters["time_per_byte"] = benchmark::Counter(
+            static_cast<double>(bytes),
+            benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+      });
+}
+
+void RegisterBinary(absl::string_view name, const Message& prototype,
+                    std::string data) {
+  auto input =
+      std::make_shared<const Input>(Input{&prototype, std::move(data)});
+  Register(name, "TcParser", input,
+           [](const std::string& data, Message* message) {
+             return message->ParsePartialFromString(data);
+           });
+  Register(name, "WireFormat", input,
+           [](const std::string& data, Message* message) {
+             io::CodedInputStream stream(
+                 reinterpret_cast<const uint8_t*>(data.data()),
+                 static_cast<int>(data.size()));
+             return WireFormat::ParseAndMergePartial(&stream, message);
+           });
+}
+
+void RegisterJson(absl::string_view name, std::string data) {
+  auto input = std::make_shared<const Input>(
+      Input{&Hostile::default_instance(), std::move(data)});
+  Register(name, "Json", input, [](const std::string& data, Message* message) {
+    json::ParseOptions options;
+    options.ignore_unknown_fields = true;
+    return json::JsonStringToMessage(data, message, options).ok();
+  });
+}
+
+void RegisterTextFormat(absl::string_view name, std::string data) {
+  auto input = std::make_shared<const Input>(
+      Input{&Hostile::default_instance(), std::move(data)});
+  Register(name, "TextFormat", input,
+           [](const std::string& data, Message* message) {
+             TextFormat::Parser parser;
+             parser.AllowUnknownField(true);
+             return parser.ParseFromString(data, message);
+           });
+}
+
+}  // namespace
+
+void RegisterAdversarialBenchmarks() {
+  const Message& hostile = Hostile::default_instance();
+  RegisterBinary("TinyUnknownFields", hostile, TinyUnknownFields());
+  RegisterBinary("DeepUnknownGroups", hostile, DeepUnknownGroups());
+  RegisterBinary("DeepGroups", hostile, DeepGroups());
+  RegisterBinary("OverlongVarints", hostile, OverlongVarints());
+  RegisterBinary("OverlongPackedVarints", hostile, OverlongPackedVarints());
+  RegisterBinary("RepeatedMapKeys", hostile, RepeatedMapKeys());
+  RegisterBinary("PackedFixedWrongLength", hostile,
+                 PackedWrongLength(Hostile::kFixedsFieldNumber, '\x01'));
+  RegisterBinary("PackedVarintWrongLength", hostile,
+                 PackedWrongLength(Hostile::kVarintsFieldNumber, '\x01'));
+  RegisterBinary("MessageSetAbuse", HostileSet::default_instance(),
+                 MessageSetAbuse());
+
+  RegisterJson("TinyUnknownFields",
+               Join("{", [](int i) { return absl::StrCat("\"u", i, "\":0"); },
+                    ",", "}"));
+  RegisterJson("DeepNesting",
+               Join("{\"children\":[",
+                    [](int) {
+                      return Nest("{\"child\":", "{\"id\":1}", "}");
+                    },
+                    ",", "]}"));
+  RegisterJson("RepeatedMapKeys",
+               Join("{\"counts\":{",
+                    [](int) {
+                      return absl::StrCat("\"", std::string(32, 'k'), "\":1");
+                    },
+                    ",", "}}"));
+  RegisterJson("EscapedStrings",
+               Join("{\"u\":\"", [](int) { return "\\u00e9"; }, "", "\"}"));
+
+  RegisterTextFormat(
+      "TinyUnknownFields",
+      Join("", [](int i) { return absl::StrCat("u", i, ": 0"); }, " ", ""));
+  RegisterTextFormat(
+      "DeepGroups",
+      Join("",
+           [](int) {
+             return absl::StrCat("children ",
+                                 Nest("{ Group { child ", "{ id: 1 }", "} }"));
+           },
+           " ", ""));
+  RegisterTextFormat(
+      "RepeatedMapKeys",
+      Join("",
+           [](int) {
+             return absl::StrCat("counts { key: \"", std::string(32, 'k'),
+                                 "\" value: 1 }");
+           },
+           " ", ""));
+  RegisterTextFormat(
+      "EscapedStrings",
+      Join("u: \"", [](int) { return "\\303\\251"; }, "", "\""));
+}
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
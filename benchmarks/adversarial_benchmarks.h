@@ -0,0 +1,54 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// Worst-case parse cost: each parser is fed about 1MiB of input built to be
+// as expensive as possible per byte while staying within the default limits,
+// e.g. many tiny unknown fields, deeply nested groups, overlong varints, map
+// entries repeating one key, packed fields claiming more bytes than there are,
+// and MessageSet items in unusual order. Inputs that a parser rejects are
+// measured up to the point where it gives up.
+
+#ifndef GOOGLE_PROTOBUF_BENCHMARKS_ADVERSARIAL_BENCHMARKS_H__
+#define GOOGLE_PROTOBUF_BENCHMARKS_ADVERSARIAL_BENCHMARKS_H__
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+
+// Registers the benchmarks, named "Adversarial/<input>/<parser>" where parser
+// is one of TcParser (generated code), WireFormat (reflection), Json and
+// TextFormat. Besides the throughput, each reports the time per input byte as
+// the `time_per_byte` counter.
+void RegisterAdversarialBenchmarks();
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
+
+#endif  // GOOGLE_PROTOBUF_BENCHMARKS_ADVERSARIAL_BENCHMARKS_H__
@@ -0,0 +1,327 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Runs the message benchmarks on the bundled datasets, or on a message of
+// your own:
+//
+//   protoc --include_imports --descriptor_set_out=my.pb my.proto
+//   protobuf-benchmark --descriptor_set=my.pb --message_type=my.Request \
+//       --message_data=request.binpb
+//
+// where request.binpb is a serialized my.Request. Google Benchmark's own
+// flags, such as --benchmark_filter, work in both modes.
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "benchmarks/adversarial_benchmarks.h"
+#include "benchmarks/benchmark_messages.pb.h"
+#include "benchmarks/compression_benchmarks.h"
+#include "benchmarks/descriptor_benchmarks.h"
+#include "benchmarks/differencer_benchmarks.h"
+#include "benchmarks/dynamic_message_benchmarks.h"
+#include "benchmarks/json_benchmarks.h"
+#include "benchmarks/map_benchmarks.h"
+#include "benchmarks/message_benchmarks.h"
+#include "benchmarks/packed_benchmarks.h"
+#include "benchmarks/text_format_benchmarks.h"
+#include "benchmarks/time_util_benchmarks.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/dynamic_message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+namespace {
+
+using ::protobuf_benchmarks::DeepNesting;
+using ::protobuf_benchmarks::MapHeavy;
+using ::protobuf_benchmarks::PackedNumerics;
+using ::protobuf_benchmarks::RepeatedMessages;
+using ::protobuf_benchmarks::SmallRequest;
+using ::protobuf_benchmarks::StringHeavy;
+using ::protobuf_benchmarks::Utf8Text;
+using ::protobuf_benchmarks::WellKnownTypes;
+
+void FillSmallRequest(int i, SmallRequest* request) {
+  request->set_method("/google.example.Library/GetShelf");
+  request->set_request_id(0x123456789 + i);
+  request->set_deadline_ms(250);
+  request->set_idempotent(true);
+  request->set_user(absl::StrCat("user-", i));
+  request->set_auth_token(std::string(32, static_cast<char>('A' + i % 26)));
+  request->add_tags("canary");
+  request->add_tags("us-east");
+}
+
+void RegisterBundledDatasets() {
+  SmallRequest small;
+  FillSmallRequest(0, &small);
+  RegisterMessageBenchmarks("SmallRequest", small);
+  RegisterCompressionBenchmarks("SmallRequest", small);
+  RegisterJsonBenchmarks("SmallRequest", small);
+  RegisterTextFormatBenchmarks("SmallRequest", small);
+  RegisterDynamicMessageBenchmarks("SmallRequest", small);
+
+  MapHeavy maps;
+  for (int i = 0; i < 1000; ++i) {
+    (*maps.mutable_labels())[absl::StrCat("label-", i)] =
+        absl::StrCat("value-", i * 7919);
+    (*maps.mutable_values())[int64_t{i} * 104729] = i / 3.0;
+  }
+  for (int i = 0; i < 100; ++i) {
+    FillSmallRequest(i, &(*maps.mutable_requests())[absl::StrCat("req-", i)]);
+  }
+  RegisterMessageBenchmarks("MapHeavy", maps);
+  RegisterCompressionBenchmarks("MapHeavy", maps);
+  RegisterJsonBenchmarks("MapHeavy", maps);
+  RegisterTextFormatBenchmarks("MapHeavy", maps);
+  RegisterMapBenchmarks();
+  RegisterPackedBenchmarks();
+  RegisterDescriptorBenchmarks();
+  RegisterDifferencerBenchmarks();
+  RegisterTimeUtilBenchmarks();
+  RegisterAdversarialBenchmarks();
+
+  StringHeavy strings;
+  strings.set_title("The quick brown fox jumps over the lazy dog");
+  strings.set_body(std::string(64 << 10, 'b'));
+  for (int i = 0; i < 1000; ++i) {
+    strings.add_lines(std::string(80, static_cast<char>('a' + i % 26)));
+  }
+  for (int i = 0; i < 16; ++i) strings.add_chunks(std::string(4 << 10, 'c'));
+  RegisterMessageBenchmarks("StringHeavy", strings);
+  RegisterCompressionBenchmarks("StringHeavy", strings);
+  RegisterJsonBenchmarks("StringHeavy", strings);
+  RegisterTextFormatBenchmarks("StringHeavy", strings);
+  RegisterDynamicMessageBenchmarks("StringHeavy", strings);
+
+  // Mostly short strings, plus some longer than the 1KiB blocks of the
+  // chunked parse, so that strings validated in the input buffer and copies
+  // that straddled two blocks are both measured.
+  Utf8Text utf8;
+  for (int i = 0; i < 1000; ++i) {
+    const int repeat = i % 10 == 0 ? 64 : 2;
+    std::string ascii, multibyte;
+    for (int j = 0; j < repeat; ++j) {
+      absl::StrAppend(&ascii, "The quick brown fox jumps over the lazy dog. ");
+      // Latin-1 accents, Cyrillic, CJK and an emoji.
+      absl::StrAppend(&multibyte,
+                      "\xC3\x9C" "n\xC3\xAF" "c\xC3\xB6" "d\xC3\xA9 ",
+                      "\xD0\x91\xD1\x8B\xD1\x81\xD1\x82\xD1\x80\xD0\xBE ",
+                      "\xE9\x80\x9F\xE3\x81\x84\xE7\x8B\x90 ",
+                      "\xF0\x9F\xA6\x8A ");
+    }
+    utf8.add_ascii(ascii);
+    utf8.add_multibyte(multibyte);
+  }
+  RegisterMessageBenchmarks("Utf8Text", utf8);
+  RegisterJsonBenchmarks("Utf8Text", utf8);
+
+  // Stays well within the parser's default recursion limit of 100.
+  DeepNesting nesting;
+  DeepNesting* level = &nesting;
+  for (int depth = 0; depth < 64; ++depth) {
+    level->set_depth(depth);
+    level->set_name(absl::StrCat("level-", depth));
+    level->add_values(depth);
+    level = level->mutable_child();
+  }
+  RegisterMessageBenchmarks("DeepNesting", nesting);
+  RegisterCompressionBenchmarks("DeepNesting", nesting);
+  RegisterJsonBenchmarks("DeepNesting", nesting);
+  RegisterTextFormatBenchmarks("DeepNesting", nesting);
+  RegisterDynamicMessageBenchmarks("DeepNesting", nesting);
+
+  // Values of all encoded lengths, as in real numeric data.
+  PackedNumerics numerics;
+  for (int i = 0; i < 10000; ++i) {
+    const int64_t value = (int64_t{1} << (i % 63)) + i;
+    numerics.add_int32s(static_cast<int32_t>(value));
+    numerics.add_int64s(value);
+    numerics.add_sint64s(i % 2 == 0 ? value : -value);
+    numerics.add_fixed32s(static_cast<uint32_t>(value));
+    numerics.add_doubles(value * 0.5);
+    numerics.add_bools(i % 3 == 0);
+  }
+  RegisterMessageBenchmarks("PackedNumerics", numerics);
+  RegisterCompressionBenchmarks("PackedNumerics", numerics);
+  RegisterJsonBenchmarks("PackedNumerics", numerics);
+  RegisterTextFormatBenchmarks("PackedNumerics", numerics);
+  RegisterDynamicMessageBenchmarks("PackedNumerics", numerics);
+
+  RepeatedMessages repeated;
+  for (int i = 0; i < 100000; ++i) {
+    FillSmallRequest(i, repeated.add_requests());
+  }
+  RegisterMessageBenchmarks("RepeatedMessages", repeated);
+  RegisterCompressionBenchmarks("RepeatedMessages", repeated);
+  RegisterTextFormatBenchmarks("RepeatedMessages", repeated);
+
+  WellKnownTypes wkt;
+  wkt.mutable_create_time()->set_seconds(1700000000);
+  wkt.mutable_create_time()->set_nanos(123456789);
+  wkt.mutable_ttl()->set_seconds(3600);
+  wkt.mutable_ttl()->set_nanos(500000000);
+  auto& fields = *wkt.mutable_attributes()->mutable_fields();
+  for (int i = 0; i < 50; ++i) {
+    fields[absl::StrCat("attr-", i)].set_string_value(absl::StrCat("v", i));
+    auto* list = fields[absl::StrCat("list-", i)].mutable_list_value();
+    list->add_values()->set_number_value(i * 1.5);
+    list->add_values()->set_bool_value(i % 2 == 0);
+  }
+  for (int i = 0; i < 20; ++i) {
+    SmallRequest detail;
+    FillSmallRequest(i, &detail);
+    wkt.add_details()->PackFrom(detail);
+  }
+  wkt.mutable_update_mask()->add_paths("create_time");
+  wkt.mutable_update_mask()->add_paths("attributes");
+  for (int i = 0; i < 100; ++i) wkt.add_versions()->set_value(int64_t{i} << 40);
+  RegisterJsonBenchmarks("WellKnownTypes", wkt);
+  RegisterTextFormatBenchmarks("WellKnownTypes", wkt);
+}
+
+bool ReadFile(const std::string& path, std::string* contents) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  *contents = buffer.str();
+  return true;
+}
+
+// Benchmarks the message given on the command line. Returns false, after
+// printing the reason, if it cannot be loaded.
+bool RegisterUserDataset(const std::string& descriptor_set_path,
+                         const std::string& message_type,
+                         const std::string& message_data_path) {
+  std::string contents;
+  FileDescriptorSet descriptor_set;
+  if (!ReadFile(descriptor_set_path, &contents) ||
+      !descriptor_set.ParseFromString(contents)) {
+    fprintf(stderr, "Cannot read a descriptor set from %s\n",
+            descriptor_set_path.c_str());
+    return false;
+  }
+  // Leaked, since the registered benchmarks keep using messages of these
+  // types until the process exits.
+  auto* pool = new DescriptorPool;
+  for (const FileDescriptorProto& file : descriptor_set.file()) {
+    if (pool->BuildFile(file) == nullptr) {
+      fprintf(stderr, "Cannot build %s; was it generated with "
+              "--include_imports?\n", file.name().c_str());
+      return false;
+    }
+  }
+  const Descriptor* descriptor = pool->FindMessageTypeByName(message_type);
+  if (descriptor == nullptr) {
+    fprintf(stderr, "No message type %s in %s\n", message_type.c_str(),
+            descriptor_set_path.c_str());
+    return false;
+  }
+  auto* factory = new DynamicMessageFactory(pool);
+  std::unique_ptr<Message> message(factory->GetPrototype(descriptor)->New());
+  if (!ReadFile(message_data_path, &contents) ||
+      !message->ParseFromString(contents)) {
+    fprintf(stderr, "Cannot parse a %s from %s\n", message_type.c_str(),
+            message_data_path.c_str());
+    return false;
+  }
+  RegisterMessageBenchmarks(message_type, *message);
+  RegisterCompressionBenchmarks(message_type, *message);
+  RegisterDynamicMessageBenchmarks(message_type, *message);
+  RegisterJsonBenchmarks(message_type, *message);
+  RegisterTextFormatBenchmarks(message_type, *message);
+  return true;
+}
+
+bool ParseFlag(absl::string_view arg, absl::string_view name,
+               std::string* value) {
+  const std::string prefix = absl::StrCat("--", name, "=");
+  if (!absl::StartsWith(arg, prefix)) return false;
+  *value = std::string(arg.substr(prefix.size()));
+  return true;
+}
+
+int Main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  std::string descriptor_set, message_type, message_data;
+  for (int i = 1; i < argc; ++i) {
+    if (!ParseFlag(argv[i], "descriptor_set", &descriptor_set) &&
+        !ParseFlag(argv[i], "message_type", &message_type) &&
+        !ParseFlag(argv[i], "message_data", &message_data)) {
+      fprintf(stderr, "Unknown flag: %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (descriptor_set.empty() && message_type.empty() && message_data.empty()) {
+    RegisterBundledDatasets();
+  } else if (descriptor_set.empty() || message_type.empty() ||
+             message_data.empty()) {
+    fprintf(stderr,
+            "--descriptor_set, --message_type and --message_data must be "
+            "given together\n");
+    return 1;
+  } else if (!RegisterUserDataset(descriptor_set, message_type,
+                                  message_data)) {
+    return 1;
+  }
+  // Whether the generated parser chains fields through guaranteed tail calls
+  // or returns to its parse loop after each one; compare runs across
+  // compilers with this in mind.
+  benchmark::AddCustomContext("tc_parser_tail_calls",
+                              PROTOBUF_TAILCALL ? "true" : "false");
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
+
+int main(int argc, char** argv) {
+  return google::protobuf::benchmarks::Main(argc, argv);
+}
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,190 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "benchmarks/compression_benchmarks.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message.h"
+
+#if HAVE_ZLIB
+#include "google/protobuf/io/gzip_stream.h"
+#endif
+#if HAVE_ZSTD
+#include "google/protobuf/io/zstd_stream.h"
+#endif
+#if HAVE_LZ4
+#include "google/protobuf/io/lz4_stream.h"
+#endif
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+namespace {
+
+// Compresses `input` into `output`.
+using CompressFn =
+    std::function<void(const std::string& input, std::string* output)>;
+// Decompresses `input` and returns the number of bytes produced.
+using DecompressFn = std::function<int64_t(const std::string& input)>;
+
+// Writes `data` through the compressing `stream`.
+void WriteAll(absl::string_view data, io::ZeroCopyOutputStream* stream) {
+  void* buffer;
+  int size;
+  while (!data.empty()) {
+    ABSL_CHECK(stream->Next(&buffer, &size));
+    const size_t n = std::min(data.size(), static_cast<size_t>(size));
+    memcpy(buffer, data.data(), n);
+    data.remove_prefix(n);
+    if (n < static_cast<size_t>(size)) {
+      stream->BackUp(size - static_cast<int>(n));
+    }
+  }
+}
+
+// Reads the decompressing `stream` to the end.
+int64_t ReadAll(io::ZeroCopyInputStream* stream) {
+  const void* data;
+  int size;
+  while (stream->Next(&data, &size)) {
+    benchmark::DoNotOptimize(data);
+  }
+  return stream->ByteCount();
+}
+
+void RegisterCodec(absl::string_view name, absl::string_view codec,
+                   std::shared_ptr<const std::string> data,
+                   CompressFn compress, DecompressFn decompress) {
+  auto compressed = std::make_shared<std::string>();
+  compress(*data, compressed.get());
+  const double ratio = static_cast<double>(data->size()) /
+                       std::max<size_t>(1, compressed->size());
+
+  benchmark::RegisterBenchmark(
+      absl::StrCat(name, "/Compress/", codec).c_str(),
+      [data, compress, ratio](benchmark::State& state) {
+        std::string output;
+        for (auto _ : state) {
+          output.clear();
+          compress(*data, &output);
+          benchmark::DoNotOptimize(output.data());
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                                static_cast<int64_t>(data->size()));
+        state.counters["ratio"] = ratio;
+      });
+  benchmark::RegisterBenchmark(
+      absl::StrCat(name, "/Decompress/", codec).c_str(),
+      [data, compressed, decompress, ratio](benchmark::State& state) {
+        for (auto _ : state) {
+          ABSL_CHECK_EQ(decompress(*compressed),
+                        static_cast<int64_t>(data->size()));
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                                static_cast<int64_t>(data->size()));
+        state.counters["ratio"] = ratio;
+      });
+}
+
+}  // namespace
+
+void RegisterCompressionBenchmarks(absl::string_view name,
+                                   const Message& message) {
+  auto data = std::make_shared<const std::string>(message.SerializeAsString());
+  // Unused if the library was built without any compression support.
+  (void)data;
+
+#if HAVE_ZLIB
+  RegisterCodec(
+      name, "Gzip", data,
+      [](const std::string& input, std::string* output) {
+        io::StringOutputStream sink(output);
+        io::GzipOutputStream stream(&sink);
+        WriteAll(input, &stream);
+        ABSL_CHECK(stream.Close());
+      },
+      [](const std::string& input) {
+        io::ArrayInputStream source(input.data(),
+                                    static_cast<int>(input.size()));
+        io::GzipInputStream stream(&source);
+        return ReadAll(&stream);
+      });
+#endif  // HAVE_ZLIB
+
+#if HAVE_ZSTD
+  RegisterCodec(
+      name, "Zstd", data,
+      [](const std::string& input, std::string* output) {
+        io::StringOutputStream sink(output);
+        io::ZstdOutputStream stream(&sink);
+        WriteAll(input, &stream);
+        ABSL_CHECK(stream.Close());
+      },
+      [](const std::string& input) {
+        io::ArrayInputStream source(input.data(),
+                                    static_cast<int>(input.size()));
+        io::ZstdInputStream stream(&source);
+        return ReadAll(&stream);
+      });
+#endif  // HAVE_ZSTD
+
+#if HAVE_LZ4
+  RegisterCodec(
+      name, "Lz4", data,
+      [](const std::string& input, std::string* output) {
+        io::StringOutputStream sink(output);
+        io::Lz4OutputStream stream(&sink);
+        WriteAll(input, &stream);
+        ABSL_CHECK(stream.Close());
+      },
+      [](const std::string& input) {
+        io::ArrayInputStream source(input.data(),
+                                    static_cast<int>(input.size()));
+        io::Lz4InputStream stream(&source);
+        return ReadAll(&stream);
+      });
+#endif  // HAVE_LZ4
+}
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
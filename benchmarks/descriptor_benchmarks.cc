@@ -0,0 +1,144 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "benchmarks/descriptor_benchmarks.h"
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+namespace {
+
+// Builds, once, a message type with `field_count` fields.  Field numbers are
+// spaced out so that looking them up cannot just index into the fields.
+const Descriptor* MessageWithFields(int field_count) {
+  static auto* pool = new DescriptorPool;
+  const std::string name = absl::StrCat("Fields", field_count);
+  if (const Descriptor* found =
+          pool->FindMessageTypeByName(absl::StrCat("bench.", name))) {
+    return found;
+  }
+  FileDescriptorProto file;
+  file.set_name(absl::StrCat("bench/", name, ".proto"));
+  file.set_package("bench");
+  DescriptorProto* message = file.add_message_type();
+  message->set_name(name);
+  for (int i = 0; i < field_count; ++i) {
+    FieldDescriptorProto* field = message->add_field();
+    field->set_name(absl::StrCat("field_name_", i));
+    field->set_number(i * 3 + 1);
+    field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+    field->set_type(FieldDescriptorProto::TYPE_INT32);
+  }
+  return pool->BuildFile(file)->message_type(0);
+}
+
+template <typename Key>
+void RunLookups(benchmark::State& state, const Descriptor* descriptor,
+                const std::vector<Key>& keys,
+                const FieldDescriptor* (Descriptor::*find)(Key) const) {
+  for (auto _ : state) {
+    for (const Key& key : keys) {
+      benchmark::DoNotOptimize((descriptor->*find)(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+void BM_FindFieldByName(benchmark::State& state) {
+  const Descriptor* descriptor = MessageWithFields(state.range(0));
+  std::vector<absl::string_view> keys;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    keys.push_back(descriptor->field(i)->name());
+  }
+  RunLookups(state, descriptor, keys, &Descriptor::FindFieldByName);
+}
+
+void BM_FindFieldByNumber(benchmark::State& state) {
+  const Descriptor* descriptor = MessageWithFields(state.range(0));
+  std::vector<int> keys;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    keys.push_back(descriptor->field(i)->number());
+  }
+  RunLookups(state, descriptor, keys, &Descriptor::FindFieldByNumber);
+}
+
+void BM_FindFieldByLowercaseName(benchmark::State& state) {
+  const Descriptor* descriptor = MessageWithFields(state.range(0));
+  std::vector<absl::string_view> keys;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    keys.push_back(descriptor->field(i)->lowercase_name());
+  }
+  RunLookups(state, descriptor, keys, &Descriptor::FindFieldByLowercaseName);
+}
+
+void BM_FindFieldByCamelcaseName(benchmark::State& state) {
+  const Descriptor* descriptor = MessageWithFields(state.range(0));
+  std::vector<absl::string_view> keys;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    keys.push_back(descriptor->field(i)->camelcase_name());
+  }
+  RunLookups(state, descriptor, keys, &Descriptor::FindFieldByCamelcaseName);
+}
+
+}  // namespace
+
+void RegisterDescriptorBenchmarks() {
+  struct Op {
+    absl::string_view name;
+    void (*fn)(benchmark::State&);
+  };
+  const Op ops[] = {
+      {"FindFieldByName", &BM_FindFieldByName},
+      {"FindFieldByNumber", &BM_FindFieldByNumber},
+      {"FindFieldByLowercaseName", &BM_FindFieldByLowercaseName},
+      {"FindFieldByCamelcaseName", &BM_FindFieldByCamelcaseName},
+  };
+  for (const Op& op : ops) {
+    benchmark::RegisterBenchmark(
+        absl::StrCat("Descriptor/", op.name).c_str(), op.fn)
+        ->Arg(4)
+        ->Arg(8)
+        ->Arg(16)
+        ->Arg(64);
+  }
+}
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,109 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "benchmarks/differencer_benchmarks.h"
+
+#include <benchmark/benchmark.h>
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "benchmarks/benchmark_messages.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/util/message_differencer.h"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+namespace {
+
+using ::protobuf_benchmarks::RepeatedMessages;
+
+enum class Treatment { kList, kSet, kMap };
+
+// `n` requests, in order or reversed.
+RepeatedMessages MakeRequests(int n, bool reversed) {
+  RepeatedMessages message;
+  for (int k = 0; k < n; ++k) {
+    const int i = reversed ? n - 1 - k : k;
+    auto* request = message.add_requests();
+    request->set_method("/google.example.Library/GetShelf");
+    request->set_request_id(0x123456789 + i);
+    request->set_user(absl::StrCat("user-", i % 64));
+    request->add_tags("canary");
+  }
+  return message;
+}
+
+void BM_Compare(benchmark::State& state, Treatment treatment) {
+  const RepeatedMessages message1 = MakeRequests(state.range(0), false);
+  const RepeatedMessages message2 = MakeRequests(state.range(0), true);
+  const FieldDescriptor* requests =
+      RepeatedMessages::descriptor()->FindFieldByName("requests");
+  util::MessageDifferencer differencer;
+  if (treatment == Treatment::kSet) {
+    differencer.TreatAsSet(requests);
+  } else if (treatment == Treatment::kMap) {
+    differencer.TreatAsMap(
+        requests, requests->message_type()->FindFieldByName("request_id"));
+  }
+  for (auto _ : state) {
+    bool equal = differencer.Compare(message1, message2);
+    benchmark::DoNotOptimize(equal);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+void RegisterDifferencerBenchmarks() {
+  struct Case {
+    absl::string_view name;
+    Treatment treatment;
+  };
+  const Case cases[] = {
+      {"List", Treatment::kList},
+      {"Set", Treatment::kSet},
+      {"Map", Treatment::kMap},
+  };
+  for (const Case& c : cases) {
+    benchmark::RegisterBenchmark(
+        absl::StrCat("Differencer/", c.name).c_str(),
+        [treatment = c.treatment](benchmark::State& state) {
+          BM_Compare(state, treatment);
+        })
+        ->Arg(16)
+        ->Arg(1 << 10)
+        ->Arg(1 << 13);
+  }
+}
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,175 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "benchmarks/dynamic_message_benchmarks.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/wire_format.h"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+namespace {
+
+using internal::WireFormat;
+
+// A DynamicMessage holding the same data as the message it was made from.
+class Source {
+ public:
+  Source(const Message& message, bool compile)
+      : factory_(message.GetDescriptor()->file()->pool()),
+        serialized_(message.SerializeAsString()) {
+    factory_.SetCompileTypes(compile);
+    message_.reset(factory_.GetPrototype(message.GetDescriptor())->New());
+    message_->ParseFromString(serialized_);
+  }
+  Source(const Source&) = delete;
+  Source& operator=(const Source&) = delete;
+
+  const Message& message() const { return *message_; }
+  const std::string& serialized() const { return serialized_; }
+
+ private:
+  DynamicMessageFactory factory_;
+  std::unique_ptr<Message> message_;
+  std::string serialized_;
+};
+
+template <typename Body>
+void Register(const std::string& name, std::shared_ptr<const Source> source,
+              Body body) {
+  benchmark::RegisterBenchmark(
+      name.c_str(), [source, body](benchmark::State& state) {
+        body(state, *source);
+        state.SetBytesProcessed(
+            static_cast<int64_t>(state.iterations()) *
+            static_cast<int64_t>(source->serialized().size()));
+      });
+}
+
+}  // namespace
+
+void RegisterDynamicMessageBenchmarks(absl::string_view name,
+                                      const Message& message) {
+  const std::string prefix = absl::StrCat(name, "/Dynamic/");
+  for (bool compile : {false, true}) {
+    auto source = std::make_shared<const Source>(message, compile);
+    const std::string variant = compile ? "Compiled/" : "Plan/";
+    Register(prefix + variant + "Serialize", source,
+             [](benchmark::State& state, const Source& source) {
+               std::string output;
+               for (auto _ : state) {
+                 source.message().SerializeToString(&output);
+                 benchmark::DoNotOptimize(output.data());
+               }
+             });
+    Register(prefix + variant + "ByteSize", source,
+             [](benchmark::State& state, const Source& source) {
+               for (auto _ : state) {
+                 benchmark::DoNotOptimize(source.message().ByteSizeLong());
+               }
+             });
+  }
+
+  auto source = std::make_shared<const Source>(message, false);
+  // Mirrors MessageLite::SerializeToString(): size the message, then write
+  // it with the cached sizes.
+  Register(prefix + "Reflection/Serialize", source,
+           [](benchmark::State& state, const Source& source) {
+             std::string output;
+             for (auto _ : state) {
+               output.clear();
+               const size_t size = WireFormat::ByteSize(source.message());
+               io::StringOutputStream stream(&output);
+               io::CodedOutputStream coded(&stream);
+               WireFormat::SerializeWithCachedSizes(
+                   source.message(), static_cast<int>(size), &coded);
+               benchmark::DoNotOptimize(output.data());
+             }
+           });
+  Register(prefix + "Reflection/ByteSize", source,
+           [](benchmark::State& state, const Source& source) {
+             for (auto _ : state) {
+               benchmark::DoNotOptimize(WireFormat::ByteSize(source.message()));
+             }
+           });
+
+  // Prototype lookups and message creation from many threads at once, as in
+  // a server handling dynamic types. Both only read what the factory built
+  // on first use, so they should scale with the thread count.
+  const Descriptor* descriptor = message.GetDescriptor();
+  auto factory =
+      std::make_shared<DynamicMessageFactory>(descriptor->file()->pool());
+  factory->GetPrototype(descriptor);
+  benchmark::RegisterBenchmark(
+      (prefix + "GetPrototype").c_str(),
+      [factory, descriptor](benchmark::State& state) {
+        for (auto _ : state) {
+          benchmark::DoNotOptimize(factory->GetPrototype(descriptor));
+        }
+      })
+      ->ThreadRange(1, 64);
+  benchmark::RegisterBenchmark(
+      (prefix + "New").c_str(),
+      [factory, descriptor](benchmark::State& state) {
+        for (auto _ : state) {
+          std::unique_ptr<Message> created(
+              factory->GetPrototype(descriptor)->New());
+          benchmark::DoNotOptimize(created.get());
+        }
+      })
+      ->ThreadRange(1, 64);
+  if (descriptor->file()->pool() == DescriptorPool::generated_pool()) {
+    benchmark::RegisterBenchmark(
+        (prefix + "GeneratedFactory/GetPrototype").c_str(),
+        [descriptor](benchmark::State& state) {
+          for (auto _ : state) {
+            benchmark::DoNotOptimize(
+                MessageFactory::generated_factory()->GetPrototype(descriptor));
+          }
+        })
+        ->ThreadRange(1, 64);
+  }
+}
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,63 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Benchmarks for serializing a DynamicMessage and computing its
+// ByteSizeLong(), through the serialization plan DynamicMessageFactory builds
+// for each type, through that plan compiled to native code (only when
+// protobuf is built with -Dprotobuf_WITH_LLVM=ON; otherwise the same as the
+// plan), and through the reflection-based WireFormat routines the plan
+// replaces. Also measures looking up prototypes and creating messages from
+// up to 64 threads at once.
+
+#ifndef GOOGLE_PROTOBUF_BENCHMARKS_DYNAMIC_MESSAGE_BENCHMARKS_H__
+#define GOOGLE_PROTOBUF_BENCHMARKS_DYNAMIC_MESSAGE_BENCHMARKS_H__
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/message.h"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+
+// Registers the benchmarks for a dynamic copy of `message`, named
+// "<name>/Dynamic/<Plan|Compiled|Reflection>/<operation>". Throughput is
+// reported in serialized bytes per second. The reflection variants only
+// bypass the plan for the top-level message; submessages are still sized and
+// serialized through their own ByteSizeLong() and _InternalSerialize().
+// "<name>/Dynamic/<GetPrototype|New>" and, for generated types,
+// "<name>/Dynamic/GeneratedFactory/GetPrototype" run on 1 to 64 threads.
+void RegisterDynamicMessageBenchmarks(absl::string_view name,
+                                      const Message& message);
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
+
+#endif  // GOOGLE_PROTOBUF_BENCHMARKS_DYNAMIC_MESSAGE_BENCHMARKS_H__
@@ -0,0 +1,147 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "benchmarks/json_benchmarks.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/json/json.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/util/type_resolver.h"
+#include "google/protobuf/util/type_resolver_util.h"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+namespace {
+
+constexpr absl::string_view kUrlPrefix = "type.googleapis.com";
+
+// Everything the benchmarks of one message share.
+struct JsonSource {
+  std::unique_ptr<Message> message;
+  std::string serialized;
+  std::string json;
+  std::string type_url;
+  std::unique_ptr<util::TypeResolver> resolver;
+  // Wraps `resolver`, so it is declared after it.
+  std::unique_ptr<util::TypeResolver> cached_resolver;
+};
+
+void SetJsonBytesProcessed(benchmark::State& state, const JsonSource& source) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.json.size()));
+}
+
+}  // namespace
+
+void RegisterJsonBenchmarks(absl::string_view name, const Message& message) {
+  auto source = std::make_shared<JsonSource>();
+  source->message.reset(message.New());
+  source->message->CopyFrom(message);
+  source->serialized = message.SerializeAsString();
+  ABSL_CHECK_OK(json::MessageToJsonString(message, &source->json));
+  source->type_url =
+      absl::StrCat(kUrlPrefix, "/", message.GetDescriptor()->full_name());
+  source->resolver.reset(util::NewTypeResolverForDescriptorPool(
+      kUrlPrefix, message.GetDescriptor()->file()->pool()));
+
+  benchmark::RegisterBenchmark(
+      absl::StrCat(name, "/Json/MessageToJson").c_str(),
+      [source](benchmark::State& state) {
+        std::string json;
+        for (auto _ : state) {
+          json.clear();
+          ABSL_CHECK_OK(json::MessageToJsonString(*source->message, &json));
+          benchmark::DoNotOptimize(json.data());
+        }
+        SetJsonBytesProcessed(state, *source);
+      });
+  benchmark::RegisterBenchmark(
+      absl::StrCat(name, "/Json/JsonToMessage").c_str(),
+      [source](benchmark::State& state) {
+        std::unique_ptr<Message> message(source->message->New());
+        for (auto _ : state) {
+          message->Clear();
+          ABSL_CHECK_OK(json::JsonStringToMessage(source->json, message.get()));
+          benchmark::DoNotOptimize(message.get());
+        }
+        SetJsonBytesProcessed(state, *source);
+      });
+  source->cached_resolver.reset(
+      util::NewCachingTypeResolver(source->resolver.get()));
+
+  struct Resolver {
+    absl::string_view suffix;
+    util::TypeResolver* resolver;
+  };
+  const Resolver resolvers[] = {
+      {"", source->resolver.get()},
+      {"Cached", source->cached_resolver.get()},
+  };
+  for (const Resolver& r : resolvers) {
+    benchmark::RegisterBenchmark(
+        absl::StrCat(name, "/Json/BinaryToJson", r.suffix).c_str(),
+        [source, resolver = r.resolver](benchmark::State& state) {
+          std::string json;
+          for (auto _ : state) {
+            json.clear();
+            ABSL_CHECK_OK(json::BinaryToJsonString(
+                resolver, source->type_url, source->serialized, &json));
+            benchmark::DoNotOptimize(json.data());
+          }
+          SetJsonBytesProcessed(state, *source);
+        });
+    benchmark::RegisterBenchmark(
+        absl::StrCat(name, "/Json/JsonToBinary", r.suffix).c_str(),
+        [source, resolver = r.resolver](benchmark::State& state) {
+          std::string binary;
+          for (auto _ : state) {
+            binary.clear();
+            ABSL_CHECK_OK(json::JsonToBinaryString(
+                resolver, source->type_url, source->json, &binary));
+            benchmark::DoNotOptimize(binary.data());
+          }
+          SetJsonBytesProcessed(state, *source);
+        });
+  }
+}
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,57 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Throughput benchmarks for the JSON transcoding paths in
+// google/protobuf/json: printing and parsing a message through reflection,
+// and converting between its binary and JSON forms through a TypeResolver.
+
+#ifndef GOOGLE_PROTOBUF_BENCHMARKS_JSON_BENCHMARKS_H__
+#define GOOGLE_PROTOBUF_BENCHMARKS_JSON_BENCHMARKS_H__
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/message.h"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+
+// Registers the benchmarks for a copy of `message`, named
+// "<name>/Json/<MessageToJson|JsonToMessage|BinaryToJson|JsonToBinary>".
+// BinaryToJson and JsonToBinary are also registered with a "Cached" suffix,
+// going through a resolver from util::NewCachingTypeResolver().
+// Throughput is reported in JSON bytes per second. Any types referenced by
+// the message must be in the pool of its descriptor.
+void RegisterJsonBenchmarks(absl::string_view name, const Message& message);
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
+
+#endif  // GOOGLE_PROTOBUF_BENCHMARKS_JSON_BENCHMARKS_H__
@@ -0,0 +1,176 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "benchmarks/map_benchmarks.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/map.h"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+namespace {
+
+// `n` distinct keys, scattered the way ids and hashes are.
+template <typename Key>
+std::vector<Key> MakeKeys(int n, int salt);
+
+template <>
+std::vector<int32_t> MakeKeys<int32_t>(int n, int salt) {
+  std::vector<int32_t> keys;
+  for (int i = 0; i < n; ++i) {
+    keys.push_back(static_cast<int32_t>((i * 2 + salt) * 0x9E3779B1u));
+  }
+  return keys;
+}
+
+template <>
+std::vector<int64_t> MakeKeys<int64_t>(int n, int salt) {
+  std::vector<int64_t> keys;
+  for (int i = 0; i < n; ++i) {
+    keys.push_back(static_cast<int64_t>((i * 2 + salt) *
+                                        uint64_t{0x9E3779B97F4A7C15}));
+  }
+  return keys;
+}
+
+template <>
+std::vector<std::string> MakeKeys<std::string>(int n, int salt) {
+  std::vector<std::string> keys;
+  for (int i = 0; i < n; ++i) {
+    keys.push_back(absl::StrCat("key-", i * 2 + salt));
+  }
+  return keys;
+}
+
+template <typename Key>
+Map<Key, int64_t> MakeMap(const std::vector<Key>& keys) {
+  Map<Key, int64_t> map;
+  for (const Key& key : keys) map[key] = 1;
+  return map;
+}
+
+template <typename Key>
+void BM_Insert(benchmark::State& state) {
+  const std::vector<Key> keys = MakeKeys<Key>(state.range(0), 0);
+  for (auto _ : state) {
+    Map<Key, int64_t> map;
+    for (const Key& key : keys) map[key] = 1;
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Key>
+void BM_Find(benchmark::State& state) {
+  const std::vector<Key> keys = MakeKeys<Key>(state.range(0), 0);
+  const Map<Key, int64_t> map = MakeMap(keys);
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const Key& key : keys) sum += map.find(key)->second;
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Key>
+void BM_FindMissing(benchmark::State& state) {
+  const Map<Key, int64_t> map = MakeMap(MakeKeys<Key>(state.range(0), 0));
+  const std::vector<Key> missing = MakeKeys<Key>(state.range(0), 1);
+  for (auto _ : state) {
+    int found = 0;
+    for (const Key& key : missing) found += map.contains(key);
+    benchmark::DoNotOptimize(found);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Key>
+void BM_Iterate(benchmark::State& state) {
+  const Map<Key, int64_t> map = MakeMap(MakeKeys<Key>(state.range(0), 0));
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto& entry : map) sum += entry.second;
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Key>
+void BM_Erase(benchmark::State& state) {
+  const std::vector<Key> keys = MakeKeys<Key>(state.range(0), 0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    Map<Key, int64_t> map = MakeMap(keys);
+    state.ResumeTiming();
+    for (const Key& key : keys) map.erase(key);
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Key>
+void RegisterForKey(absl::string_view key_name) {
+  struct Op {
+    absl::string_view name;
+    void (*fn)(benchmark::State&);
+  };
+  const Op ops[] = {
+      {"Insert", &BM_Insert<Key>},   {"Find", &BM_Find<Key>},
+      {"FindMissing", &BM_FindMissing<Key>},
+      {"Iterate", &BM_Iterate<Key>}, {"Erase", &BM_Erase<Key>},
+  };
+  for (const Op& op : ops) {
+    benchmark::RegisterBenchmark(
+        absl::StrCat("Map/", key_name, "/", op.name).c_str(), op.fn)
+        ->Arg(16)
+        ->Arg(1 << 10)
+        ->Arg(1 << 16);
+  }
+}
+
+}  // namespace
+
+void RegisterMapBenchmarks() {
+  RegisterForKey<int32_t>("Int32");
+  RegisterForKey<int64_t>("Int64");
+  RegisterForKey<std::string>("String");
+}
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,234 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "benchmarks/message_benchmarks.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include "absl/log/absl_check.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message.h"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+namespace {
+
+// Block size of the chunked input stream, smaller than most payloads of the
+// larger datasets so that they straddle buffers as they do off the network.
+constexpr int kChunkSize = 1024;
+
+// The message an operation reads, on the heap or on an arena.
+class Source {
+ public:
+  Source(const Message& message, bool use_arena)
+      : arena_(use_arena ? new Arena : nullptr),
+        message_(message.New(arena_.get())),
+        serialized_(message.SerializeAsString()),
+        serialized_cord_(serialized_) {
+    message_->CopyFrom(message);
+  }
+  Source(const Source&) = delete;
+  Source& operator=(const Source&) = delete;
+  ~Source() {
+    if (arena_ == nullptr) delete message_;
+  }
+
+  bool use_arena() const { return arena_ != nullptr; }
+  const Message& message() const { return *message_; }
+  const std::string& serialized() const { return serialized_; }
+  // The serialized bytes split into flats, as a cord read off the network
+  // would be.
+  const absl::Cord& serialized_cord() const { return serialized_cord_; }
+
+ private:
+  std::unique_ptr<Arena> arena_;
+  Message* message_;
+  std::string serialized_;
+  absl::Cord serialized_cord_;
+};
+
+// Calls `fn` with a new, empty message of the source's type that lives where
+// the source does. Arena messages get a fresh arena, as a per-request arena
+// would.
+template <typename Fn>
+void WithNewMessage(const Source& source, Fn fn) {
+  if (source.use_arena()) {
+    Arena arena;
+    fn(source.message().New(&arena));
+  } else {
+    std::unique_ptr<Message> message(source.message().New());
+    fn(message.get());
+  }
+}
+
+void SetThroughput(benchmark::State& state, const Source& source) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.serialized().size()));
+}
+
+template <typename Body>
+void Register(const std::string& name, std::shared_ptr<const Source> source,
+              Body body) {
+  benchmark::RegisterBenchmark(name.c_str(),
+                               [source, body](benchmark::State& state) {
+                                 body(state, *source);
+                                 SetThroughput(state, *source);
+                               });
+}
+
+}  // namespace
+
+void RegisterMessageBenchmarks(absl::string_view name,
+                               const Message& message) {
+  for (bool use_arena : {false, true}) {
+    auto source = std::make_shared<const Source>(message, use_arena);
+    const std::string prefix =
+        absl::StrCat(name, use_arena ? "/Arena/" : "/Heap/");
+
+    Register(prefix + "Parse", source,
+             [](benchmark::State& state, const Source& source) {
+               for (auto _ : state) {
+                 WithNewMessage(source, [&](Message* message) {
+                   ABSL_CHECK(message->ParseFromString(source.serialized()));
+                   benchmark::DoNotOptimize(message);
+                 });
+               }
+               // Memory held by a parsed message, to compare representations.
+               WithNewMessage(source, [&](Message* message) {
+                 ABSL_CHECK(message->ParseFromString(source.serialized()));
+                 state.counters["space_used"] =
+                     static_cast<double>(message->SpaceUsedLong());
+               });
+             });
+    // Parses from a stream handing out small blocks, so long string and
+    // packed payloads span several buffers and are copied piecewise.
+    Register(prefix + "ParseChunked", source,
+             [](benchmark::State& state, const Source& source) {
+               for (auto _ : state) {
+                 WithNewMessage(source, [&](Message* message) {
+                   io::ArrayInputStream input(
+                       source.serialized().data(),
+                       static_cast<int>(source.serialized().size()),
+                       kChunkSize);
+                   ABSL_CHECK(message->ParseFromZeroCopyStream(&input));
+                   benchmark::DoNotOptimize(message);
+                 });
+               }
+             });
+    Register(prefix + "Serialize", source,
+             [](benchmark::State& state, const Source& source) {
+               std::string output;
+               for (auto _ : state) {
+                 source.message().SerializeToString(&output);
+                 benchmark::DoNotOptimize(output.data());
+               }
+             });
+    // Serializes into a new string each time, so every iteration pays for
+    // growing the output buffer as a freshly built RPC payload would.
+    Register(prefix + "SerializeToNewString", source,
+             [](benchmark::State& state, const Source& source) {
+               for (auto _ : state) {
+                 std::string output = source.message().SerializeAsString();
+                 benchmark::DoNotOptimize(output.data());
+               }
+             });
+    // Deterministic serialization sorts map entries, which is what it costs
+    // over Serialize on map-heavy messages.
+    Register(prefix + "SerializeDeterministic", source,
+             [](benchmark::State& state, const Source& source) {
+               std::string output;
+               for (auto _ : state) {
+                 output.clear();
+                 io::StringOutputStream stream(&output);
+                 io::CodedOutputStream coded(&stream);
+                 coded.SetSerializationDeterministic(true);
+                 ABSL_CHECK(source.message().SerializeToCodedStream(&coded));
+                 benchmark::DoNotOptimize(output.data());
+               }
+             });
+    Register(prefix + "ParseFromCord", source,
+             [](benchmark::State& state, const Source& source) {
+               for (auto _ : state) {
+                 WithNewMessage(source, [&](Message* message) {
+                   ABSL_CHECK(
+                       message->ParseFromCord(source.serialized_cord()));
+                   benchmark::DoNotOptimize(message);
+                 });
+               }
+             });
+    Register(prefix + "SerializeToCord", source,
+             [](benchmark::State& state, const Source& source) {
+               for (auto _ : state) {
+                 absl::Cord output = source.message().SerializeAsCord();
+                 benchmark::DoNotOptimize(output);
+               }
+             });
+    Register(prefix + "ByteSize", source,
+             [](benchmark::State& state, const Source& source) {
+               for (auto _ : state) {
+                 benchmark::DoNotOptimize(source.message().ByteSizeLong());
+               }
+             });
+    Register(prefix + "Copy", source,
+             [](benchmark::State& state, const Source& source) {
+               for (auto _ : state) {
+                 WithNewMessage(source, [&](Message* message) {
+                   message->CopyFrom(source.message());
+                   benchmark::DoNotOptimize(message);
+                 });
+               }
+             });
+    // Merges into a message that is cleared between iterations, so the
+    // destination's repeated fields and strings keep their capacity.
+    Register(prefix + "Merge", source,
+             [](benchmark::State& state, const Source& source) {
+               WithNewMessage(source, [&](Message* message) {
+                 for (auto _ : state) {
+                   message->Clear();
+                   message->MergeFrom(source.message());
+                   benchmark::DoNotOptimize(message);
+                 }
+               });
+             });
+  }
+}
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,151 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "benchmarks/packed_benchmarks.h"
+
+#include <cstdint>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/repeated_field.h"
+#include "google/protobuf/wire_format_lite.h"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+namespace {
+
+using internal::WireFormatLite;
+
+enum class Values { kOneByte, kTwoBytes, kMixed, kNegative };
+
+RepeatedField<int32_t> MakeValues(Values values, int n) {
+  RepeatedField<int32_t> field;
+  for (int i = 0; i < n; ++i) {
+    const uint32_t scrambled = static_cast<uint32_t>(i) * 0x9E3779B1u;
+    switch (values) {
+      case Values::kOneByte:
+        field.Add(static_cast<int32_t>(scrambled % 64));
+        break;
+      case Values::kTwoBytes:
+        field.Add(static_cast<int32_t>(128 + scrambled % 8000));
+        break;
+      case Values::kMixed:
+        field.Add(static_cast<int32_t>(scrambled >> (scrambled % 31)));
+        break;
+      case Values::kNegative:
+        field.Add(-static_cast<int32_t>(1 + scrambled % 1000));
+        break;
+    }
+  }
+  return field;
+}
+
+void BM_Int32Size(benchmark::State& state, Values values) {
+  const RepeatedField<int32_t> field = MakeValues(values, state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(WireFormatLite::Int32Size(field));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_SInt32Size(benchmark::State& state, Values values) {
+  const RepeatedField<int32_t> field = MakeValues(values, state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(WireFormatLite::SInt32Size(field));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Encodes into a reused buffer large enough for the whole field, as
+// serializing a message to a flat array does.
+template <bool kZigZag>
+void BM_WritePacked(benchmark::State& state, Values values) {
+  const RepeatedField<int32_t> field = MakeValues(values, state.range(0));
+  const int size = static_cast<int>(kZigZag ? WireFormatLite::SInt32Size(field)
+                                            : WireFormatLite::Int32Size(field));
+  std::string buffer(size + 16, '\0');
+  for (auto _ : state) {
+    io::ArrayOutputStream output(&buffer[0], static_cast<int>(buffer.size()));
+    io::CodedOutputStream coded(&output);
+    uint8_t* ptr = coded.Cur();
+    ptr = kZigZag ? coded.EpsCopy()->WriteSInt32Packed(1, field, size, ptr)
+                  : coded.EpsCopy()->WriteInt32Packed(1, field, size, ptr);
+    coded.SetCur(ptr);
+    coded.Trim();
+    ABSL_CHECK(!coded.HadError());
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+void RegisterPackedBenchmarks() {
+  struct Op {
+    absl::string_view name;
+    void (*fn)(benchmark::State&, Values);
+  };
+  const Op ops[] = {
+      {"Int32Size", &BM_Int32Size},
+      {"SInt32Size", &BM_SInt32Size},
+      {"WriteInt32", &BM_WritePacked<false>},
+      {"WriteSInt32", &BM_WritePacked<true>},
+  };
+  struct Distribution {
+    absl::string_view name;
+    Values values;
+  };
+  const Distribution distributions[] = {
+      {"OneByte", Values::kOneByte},
+      {"TwoBytes", Values::kTwoBytes},
+      {"Mixed", Values::kMixed},
+      {"Negative", Values::kNegative},
+  };
+  for (const Op& op : ops) {
+    for (const Distribution& distribution : distributions) {
+      benchmark::RegisterBenchmark(
+          absl::StrCat("Packed/", op.name, "/", distribution.name).c_str(),
+          op.fn, distribution.values)
+          ->Arg(16)
+          ->Arg(1 << 10)
+          ->Arg(1 << 16);
+    }
+  }
+}
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,108 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "benchmarks/text_format_benchmarks.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include "absl/log/absl_check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/text_format.h"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+namespace {
+
+// Everything the benchmarks of one message share.
+struct TextSource {
+  std::unique_ptr<Message> message;
+  std::string text;
+};
+
+void SetTextBytesProcessed(benchmark::State& state, const TextSource& source) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.text.size()));
+}
+
+}  // namespace
+
+void RegisterTextFormatBenchmarks(absl::string_view name,
+                                  const Message& message) {
+  auto source = std::make_shared<TextSource>();
+  source->message.reset(message.New());
+  source->message->CopyFrom(message);
+  ABSL_CHECK(TextFormat::PrintToString(message, &source->text));
+
+  benchmark::RegisterBenchmark(
+      absl::StrCat(name, "/TextFormat/Print").c_str(),
+      [source](benchmark::State& state) {
+        std::string text;
+        for (auto _ : state) {
+          text.clear();
+          ABSL_CHECK(TextFormat::PrintToString(*source->message, &text));
+          benchmark::DoNotOptimize(text.data());
+        }
+        SetTextBytesProcessed(state, *source);
+      });
+  benchmark::RegisterBenchmark(
+      absl::StrCat(name, "/TextFormat/Parse").c_str(),
+      [source](benchmark::State& state) {
+        std::unique_ptr<Message> message(source->message->New());
+        for (auto _ : state) {
+          ABSL_CHECK(TextFormat::ParseFromString(source->text, message.get()));
+          benchmark::DoNotOptimize(message.get());
+        }
+        SetTextBytesProcessed(state, *source);
+      });
+  // A fresh arena per parse, as when loading a configuration into an arena
+  // that owns it.
+  benchmark::RegisterBenchmark(
+      absl::StrCat(name, "/TextFormat/ParseOnArena").c_str(),
+      [source](benchmark::State& state) {
+        for (auto _ : state) {
+          Arena arena;
+          Message* message = source->message->New(&arena);
+          ABSL_CHECK(TextFormat::ParseFromString(source->text, message));
+          benchmark::DoNotOptimize(message);
+        }
+        SetTextBytesProcessed(state, *source);
+      });
+}
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
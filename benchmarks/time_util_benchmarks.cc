@@ -0,0 +1,198 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "benchmarks/time_util_benchmarks.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "google/protobuf/duration.pb.h"
+#include "google/protobuf/repeated_ptr_field.h"
+#include "google/protobuf/timestamp.pb.h"
+#include "google/protobuf/util/time_util.h"
+
+namespace google {
+namespace protobuf {
+namespace benchmarks {
+namespace {
+
+using util::TimeUtil;
+
+constexpr int kBatchSize = 1024;
+
+// `kBatchSize` timestamps a little over a millisecond apart, with nanosecond
+// precision, as an event stream would record them.
+RepeatedPtrField<Timestamp> MakeTimestamps() {
+  RepeatedPtrField<Timestamp> timestamps;
+  for (int i = 0; i < kBatchSize; ++i) {
+    *timestamps.Add() = TimeUtil::NanosecondsToTimestamp(
+        int64_t{1700000000} * 1000000000 + int64_t{i} * 1000003);
+  }
+  return timestamps;
+}
+
+std::vector<std::string> MakeTimestampStrings() {
+  std::vector<std::string> strings;
+  TimeUtil::ToStrings(MakeTimestamps(), &strings);
+  return strings;
+}
+
+void BM_TimestampToString(benchmark::State& state) {
+  const RepeatedPtrField<Timestamp> timestamps = MakeTimestamps();
+  for (auto _ : state) {
+    for (const Timestamp& timestamp : timestamps) {
+      std::string s = TimeUtil::ToString(timestamp);
+      benchmark::DoNotOptimize(s);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+void BM_TimestampToChars(benchmark::State& state) {
+  const RepeatedPtrField<Timestamp> timestamps = MakeTimestamps();
+  char buffer[TimeUtil::kTimestampStringMaxLength];
+  for (auto _ : state) {
+    for (const Timestamp& timestamp : timestamps) {
+      size_t size = TimeUtil::ToChars(timestamp, buffer);
+      benchmark::DoNotOptimize(size);
+      benchmark::DoNotOptimize(buffer);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+void BM_TimestampsToStrings(benchmark::State& state) {
+  const RepeatedPtrField<Timestamp> timestamps = MakeTimestamps();
+  std::vector<std::string> strings;
+  for (auto _ : state) {
+    strings.clear();
+    TimeUtil::ToStrings(timestamps, &strings);
+    benchmark::DoNotOptimize(strings);
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+void BM_AbslFormatTime(benchmark::State& state) {
+  const RepeatedPtrField<Timestamp> timestamps = MakeTimestamps();
+  for (auto _ : state) {
+    for (const Timestamp& timestamp : timestamps) {
+      std::string s = absl::FormatTime(
+          absl::RFC3339_full,
+          absl::FromUnixSeconds(timestamp.seconds()) +
+              absl::Nanoseconds(timestamp.nanos()),
+          absl::UTCTimeZone());
+      benchmark::DoNotOptimize(s);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+void BM_TimestampFromString(benchmark::State& state) {
+  const std::vector<std::string> strings = MakeTimestampStrings();
+  Timestamp timestamp;
+  for (auto _ : state) {
+    for (const std::string& s : strings) {
+      bool ok = TimeUtil::FromString(s, &timestamp);
+      benchmark::DoNotOptimize(ok);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+void BM_TimestampsFromStrings(benchmark::State& state) {
+  const std::vector<std::string> strings = MakeTimestampStrings();
+  const std::vector<absl::string_view> views(strings.begin(), strings.end());
+  RepeatedPtrField<Timestamp> timestamps;
+  for (auto _ : state) {
+    timestamps.Clear();
+    bool ok = TimeUtil::FromStrings(views, &timestamps);
+    benchmark::DoNotOptimize(ok);
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+void BM_AbslParseTime(benchmark::State& state) {
+  const std::vector<std::string> strings = MakeTimestampStrings();
+  absl::Time time;
+  for (auto _ : state) {
+    for (const std::string& s : strings) {
+      bool ok = absl::ParseTime(absl::RFC3339_full, s, &time, nullptr);
+      benchmark::DoNotOptimize(ok);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+void BM_DurationToString(benchmark::State& state) {
+  const Duration duration = TimeUtil::NanosecondsToDuration(-12345678901);
+  for (auto _ : state) {
+    std::string s = TimeUtil::ToString(duration);
+    benchmark::DoNotOptimize(s);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_DurationFromString(benchmark::State& state) {
+  Duration duration;
+  for (auto _ : state) {
+    bool ok = TimeUtil::FromString("-12.345678901s", &duration);
+    benchmark::DoNotOptimize(ok);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+void RegisterTimeUtilBenchmarks() {
+  benchmark::RegisterBenchmark("TimeUtil/TimestampToString",
+                               BM_TimestampToString);
+  benchmark::RegisterBenchmark("TimeUtil/TimestampToChars",
+                               BM_TimestampToChars);
+  benchmark::RegisterBenchmark("TimeUtil/TimestampsToStrings",
+                               BM_TimestampsToStrings);
+  benchmark::RegisterBenchmark("TimeUtil/AbslFormatTime", BM_AbslFormatTime);
+  benchmark::RegisterBenchmark("TimeUtil/TimestampFromString",
+                               BM_TimestampFromString);
+  benchmark::RegisterBenchmark("TimeUtil/TimestampsFromStrings",
+                               BM_TimestampsFromStrings);
+  benchmark::RegisterBenchmark("TimeUtil/AbslParseTime", BM_AbslParseTime);
+  benchmark::RegisterBenchmark("TimeUtil/DurationToString",
+                               BM_DurationToString);
+  benchmark::RegisterBenchmark("TimeUtil/DurationFromString",
+                               BM_DurationFromString);
+}
+
+}  // namespace benchmarks
+}  // namespace protobuf
+}  // namespace google
@@ -54,6 +54,7 @@ else()
     absl::cleanup
     absl::cord
     absl::core_headers
+    absl::crc32c
     absl::debugging
     absl::die_if_null
     absl::dynamic_annotations
@@ -0,0 +1,95 @@
+find_package(benchmark REQUIRED)
+
+add_custom_command(
+  OUTPUT
+    ${protobuf_SOURCE_DIR}/benchmarks/benchmark_messages.pb.h
+    ${protobuf_SOURCE_DIR}/benchmarks/benchmark_messages.pb.cc
+  DEPENDS ${protobuf_PROTOC_EXE} ${protobuf_SOURCE_DIR}/benchmarks/benchmark_messages.proto
+  COMMAND ${protobuf_PROTOC_EXE} ${protobuf_SOURCE_DIR}/benchmarks/benchmark_messages.proto
+      --proto_path=${protobuf_SOURCE_DIR}
+      --proto_path=${protobuf_SOURCE_DIR}/src
+      --cpp_out=${protobuf_SOURCE_DIR}
+)
+
+add_custom_command(
+  OUTPUT
+    ${protobuf_SOURCE_DIR}/benchmarks/adversarial_messages.pb.h
+    ${protobuf_SOURCE_DIR}/benchmarks/adversarial_messages.pb.cc
+  DEPENDS ${protobuf_PROTOC_EXE} ${protobuf_SOURCE_DIR}/benchmarks/adversarial_messages.proto
+  COMMAND ${protobuf_PROTOC_EXE} ${protobuf_SOURCE_DIR}/benchmarks/adversarial_messages.proto
+      --proto_path=${protobuf_SOURCE_DIR}
+      --cpp_out=${protobuf_SOURCE_DIR}
+)
+
+set(protobuf_benchmark_files
+  ${protobuf_SOURCE_DIR}/benchmarks/adversarial_benchmarks.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/adversarial_benchmarks.h
+  ${protobuf_SOURCE_DIR}/benchmarks/adversarial_messages.pb.h
+  ${protobuf_SOURCE_DIR}/benchmarks/adversarial_messages.pb.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/benchmark_main.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/compression_benchmarks.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/compression_benchmarks.h
+  ${protobuf_SOURCE_DIR}/benchmarks/descriptor_benchmarks.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/descriptor_benchmarks.h
+  ${protobuf_SOURCE_DIR}/benchmarks/differencer_benchmarks.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/differencer_benchmarks.h
+  ${protobuf_SOURCE_DIR}/benchmarks/dynamic_message_benchmarks.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/dynamic_message_benchmarks.h
+  ${protobuf_SOURCE_DIR}/benchmarks/json_benchmarks.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/json_benchmarks.h
+  ${protobuf_SOURCE_DIR}/benchmarks/map_benchmarks.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/map_benchmarks.h
+  ${protobuf_SOURCE_DIR}/benchmarks/message_benchmarks.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/message_benchmarks.h
+  ${protobuf_SOURCE_DIR}/benchmarks/packed_benchmarks.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/packed_benchmarks.h
+  ${protobuf_SOURCE_DIR}/benchmarks/text_format_benchmarks.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/text_format_benchmarks.h
+  ${protobuf_SOURCE_DIR}/benchmarks/time_util_benchmarks.cc
+  ${protobuf_SOURCE_DIR}/benchmarks/time_util_benchmarks.h
+)
+
+# Links a benchmark binary from the common sources and the given generated
+# benchmark_messages.pb.{h,cc}.
+function(protobuf_add_benchmark_executable target messages_dir)
+  add_executable(${target}
+    ${protobuf_benchmark_files}
+    ${messages_dir}/benchmarks/benchmark_messages.pb.h
+    ${messages_dir}/benchmarks/benchmark_messages.pb.cc
+  )
+  # The messages directory comes first, so that benchmarks/ includes of
+  # benchmark_messages.pb.h find the variant built for this binary.
+  target_include_directories(${target} BEFORE PRIVATE ${messages_dir})
+  target_include_directories(${target} PRIVATE ${protobuf_SOURCE_DIR})
+  target_include_directories(${target} PRIVATE ${ABSL_ROOT_DIR})
+  target_link_libraries(${target}
+    ${protobuf_LIB_PROTOBUF}
+    ${protobuf_ABSL_USED_TARGETS}
+    benchmark::benchmark
+  )
+endfunction()
+
+# Builds the benchmarks as 'target' with benchmark_messages.proto generated
+# with the C++ generator options 'cpp_options', to compare that generated
+# code against the default.
+function(protobuf_add_benchmark_variant target cpp_options)
+  set(messages_dir ${CMAKE_CURRENT_BINARY_DIR}/${target})
+  add_custom_command(
+    OUTPUT
+      ${messages_dir}/benchmarks/benchmark_messages.pb.h
+      ${messages_dir}/benchmarks/benchmark_messages.pb.cc
+    DEPENDS ${protobuf_PROTOC_EXE} ${protobuf_SOURCE_DIR}/benchmarks/benchmark_messages.proto
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${messages_dir}
+    COMMAND ${protobuf_PROTOC_EXE} ${protobuf_SOURCE_DIR}/benchmarks/benchmark_messages.proto
+        --proto_path=${protobuf_SOURCE_DIR}
+        --proto_path=${protobuf_SOURCE_DIR}/src
+        --cpp_out=${cpp_options}:${messages_dir}
+  )
+  protobuf_add_benchmark_executable(${target} ${messages_dir})
+endfunction()
+
+protobuf_add_benchmark_executable(protobuf-benchmark ${protobuf_SOURCE_DIR})
+protobuf_add_benchmark_variant(protobuf-benchmark-table-serialization
+  table_driven_serialization)
+protobuf_add_benchmark_variant(protobuf-benchmark-table-methods
+  table_driven_methods)
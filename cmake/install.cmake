@@ -16,6 +16,9 @@ set(_protobuf_PC_CFLAGS)
 if (protobuf_BUILD_SHARED_LIBS)
   set(_protobuf_PC_CFLAGS -DPROTOBUF_USE_DLLS)
 endif ()
+if (protobuf_GCC_MUSTTAIL)
+  string(APPEND _protobuf_PC_CFLAGS " -DPROTOBUF_ENABLE_GCC_MUSTTAIL")
+endif ()
 
 configure_file(${CMAKE_CURRENT_SOURCE_DIR}/cmake/protobuf.pc.cmake
                ${CMAKE_CURRENT_BINARY_DIR}/protobuf.pc @ONLY)
@@ -63,6 +66,7 @@ install(FILES ${CMAKE_CURRENT_BINARY_DIR}/protobuf.pc ${CMAKE_CURRENT_BINARY_DIR
 include(${protobuf_SOURCE_DIR}/src/file_lists.cmake)
 set(protobuf_HEADERS
   ${libprotobuf_hdrs}
+  ${libprotobuf_compression_hdrs}
   ${libprotoc_hdrs}
   ${wkt_protos_files}
   ${descriptor_proto_proto_srcs}
@@ -29,6 +29,9 @@ if(protobuf_BUILD_SHARED_LIBS)
     PUBLIC  PROTOBUF_USE_DLLS
     PRIVATE LIBPROTOBUF_EXPORTS)
 endif()
+if(protobuf_GCC_MUSTTAIL)
+  target_compile_definitions(libprotobuf-lite PUBLIC PROTOBUF_ENABLE_GCC_MUSTTAIL)
+endif()
 set_target_properties(libprotobuf-lite PROPERTIES
     VERSION ${protobuf_VERSION}
     OUTPUT_NAME ${LIB_PREFIX}protobuf-lite
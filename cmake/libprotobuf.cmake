@@ -19,6 +19,33 @@ target_link_libraries(libprotobuf PRIVATE ${CMAKE_THREAD_LIBS_INIT})
 if(protobuf_WITH_ZLIB)
   target_link_libraries(libprotobuf PRIVATE ${ZLIB_LIBRARIES})
 endif()
+# The Zstandard and LZ4 streams are optional, so they are not in the Bazel
+# generated file lists.
+set(libprotobuf_compression_hdrs)
+if(HAVE_ZSTD)
+  list(APPEND libprotobuf_compression_hdrs
+    ${protobuf_SOURCE_DIR}/src/google/protobuf/io/zstd_stream.h)
+  target_sources(libprotobuf PRIVATE
+    ${protobuf_SOURCE_DIR}/src/google/protobuf/io/zstd_stream.cc)
+  target_include_directories(libprotobuf PUBLIC ${ZSTD_INCLUDE_DIR})
+  target_link_libraries(libprotobuf PRIVATE ${ZSTD_LIBRARY})
+endif()
+if(HAVE_LZ4)
+  list(APPEND libprotobuf_compression_hdrs
+    ${protobuf_SOURCE_DIR}/src/google/protobuf/io/lz4_stream.h)
+  target_sources(libprotobuf PRIVATE
+    ${protobuf_SOURCE_DIR}/src/google/protobuf/io/lz4_stream.cc)
+  target_include_directories(libprotobuf PUBLIC ${LZ4_INCLUDE_DIR})
+  target_link_libraries(libprotobuf PRIVATE ${LZ4_LIBRARY})
+endif()
+# Likewise the DynamicMessage JIT, whose header is always built.
+if(HAVE_LLVM)
+  target_sources(libprotobuf PRIVATE
+    ${protobuf_SOURCE_DIR}/src/google/protobuf/dynamic_message_jit.cc)
+  target_include_directories(libprotobuf PRIVATE ${LLVM_INCLUDE_DIRS})
+  llvm_map_components_to_libnames(protobuf_LLVM_LIBRARIES orcjit native passes)
+  target_link_libraries(libprotobuf PRIVATE ${protobuf_LLVM_LIBRARIES})
+endif()
 if(protobuf_LINK_LIBATOMIC)
   target_link_libraries(libprotobuf PRIVATE atomic)
 endif()
@@ -32,6 +59,9 @@ if(protobuf_BUILD_SHARED_LIBS)
     PUBLIC  PROTOBUF_USE_DLLS
     PRIVATE LIBPROTOBUF_EXPORTS)
 endif()
+if(protobuf_GCC_MUSTTAIL)
+  target_compile_definitions(libprotobuf PUBLIC PROTOBUF_ENABLE_GCC_MUSTTAIL)
+endif()
 set_target_properties(libprotobuf PROPERTIES
     VERSION ${protobuf_VERSION}
     OUTPUT_NAME ${LIB_PREFIX}protobuf
@@ -17,6 +17,9 @@ if(protobuf_HAVE_LD_VERSION_SCRIPT)
 endif()
 target_link_libraries(libprotoc PRIVATE libprotobuf)
 target_link_libraries(libprotoc PUBLIC ${protobuf_ABSL_USED_TARGETS})
+if(protobuf_WITH_ZLIB)
+  target_link_libraries(libprotoc PRIVATE ${ZLIB_LIBRARIES})
+endif()
 if(protobuf_BUILD_SHARED_LIBS)
   target_compile_definitions(libprotoc
     PUBLIC  PROTOBUF_USE_DLLS
@@ -37,6 +37,21 @@ foreach(proto_file ${lite_test_protos})
   set(lite_test_proto_files ${lite_test_proto_files} ${pb_src} ${pb_hdr})
 endforeach(proto_file)
 
+# unittest_bitpacked_lite.proto needs generator options, so it does not go
+# through compile_proto_file.
+set(bitpacked_lite_test_proto
+  ${protobuf_SOURCE_DIR}/src/google/protobuf/unittest_bitpacked_lite.proto)
+string(REPLACE .proto .pb.h pb_hdr ${bitpacked_lite_test_proto})
+string(REPLACE .proto .pb.cc pb_src ${bitpacked_lite_test_proto})
+add_custom_command(
+  OUTPUT ${pb_hdr} ${pb_src}
+  DEPENDS ${protobuf_PROTOC_EXE} ${bitpacked_lite_test_proto}
+  COMMAND ${protobuf_PROTOC_EXE} ${bitpacked_lite_test_proto}
+      --proto_path=${protobuf_SOURCE_DIR}/src
+      --cpp_out=bitpacked_fields=protobuf_unittest.TestBitPackedLite.packed_flags+protobuf_unittest.TestBitPackedLite.unpacked_flags,table_driven_serialization:${protobuf_SOURCE_DIR}/src
+)
+set(lite_test_proto_files ${lite_test_proto_files} ${pb_src} ${pb_hdr})
+
 set(tests_proto_files)
 foreach(proto_file ${tests_protos})
   compile_proto_file(${proto_file})
@@ -32,18 +32,31 @@
 #include <stdarg.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <memory>
+#include <new>
+#include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/message.h"
 #include "google/protobuf/text_format.h"
 #include "google/protobuf/util/json_util.h"
 #include "google/protobuf/util/type_resolver_util.h"
+#include "absl/container/btree_map.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "conformance/conformance.pb.h"
 #include "conformance/conformance.pb.h"
 #include "google/protobuf/test_messages_proto2.pb.h"
@@ -55,6 +68,19 @@
 // Must be included last.
 #include "google/protobuf/port_def.inc"
 
+// Counts heap allocations, so that the benchmark mode can report them.
+static std::atomic<uint64_t> allocation_count{0};
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) std::abort();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
 namespace google {
 namespace protobuf {
 namespace {
@@ -111,6 +137,11 @@ class Harness {
   // Returns Ok(true) if we're done processing requests.
   absl::StatusOr<bool> ServeConformanceRequest();
 
+  // Replays every request of a corpus recorded with
+  // `conformance_test_runner --corpus_out` `iterations` times in-process, and
+  // prints the throughput and allocations of each category of requests.
+  absl::Status RunBenchmark(const std::string& corpus_path, int iterations);
+
  private:
   bool verbose_ = false;
   std::unique_ptr<TypeResolver> resolver_;
@@ -252,12 +283,115 @@ absl::StatusOr<bool> Harness::ServeConformanceRequest() {
   }
   return false;
 }
+std::string PayloadName(const ConformanceRequest& request) {
+  switch (request.payload_case()) {
+    case ConformanceRequest::kProtobufPayload:
+      return "PROTOBUF";
+    case ConformanceRequest::kJsonPayload:
+      return "JSON";
+    case ConformanceRequest::kTextPayload:
+      return "TEXT_FORMAT";
+    default:
+      return "OTHER";
+  }
+}
+
+size_t PayloadSize(const ConformanceRequest& request) {
+  switch (request.payload_case()) {
+    case ConformanceRequest::kProtobufPayload:
+      return request.protobuf_payload().size();
+    case ConformanceRequest::kJsonPayload:
+      return request.json_payload().size();
+    case ConformanceRequest::kTextPayload:
+      return request.text_payload().size();
+    default:
+      return 0;
+  }
+}
+
+absl::Status Harness::RunBenchmark(const std::string& corpus_path,
+                                   int iterations) {
+  std::ifstream file(corpus_path, std::ios::binary);
+  if (!file.is_open()) {
+    return absl::NotFoundError(
+        absl::StrCat("Couldn't open corpus file: ", corpus_path));
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  const std::string corpus = contents.str();
+
+  std::vector<ConformanceRequest> requests;
+  size_t pos = 0;
+  while (pos < corpus.size()) {
+    uint32_t len;
+    if (corpus.size() - pos < sizeof(len)) {
+      return absl::DataLossError("truncated corpus");
+    }
+    memcpy(&len, corpus.data() + pos, sizeof(len));
+    pos += sizeof(len);
+    if (corpus.size() - pos < len) {
+      return absl::DataLossError("truncated corpus");
+    }
+    if (!requests.emplace_back().ParseFromArray(corpus.data() + pos, len)) {
+      return absl::DataLossError("corpus contains an invalid request");
+    }
+    pos += len;
+  }
+
+  struct CategoryStats {
+    int64_t requests = 0;
+    int64_t bytes = 0;
+    uint64_t allocations = 0;
+    absl::Duration time;
+  };
+  absl::btree_map<std::string, CategoryStats> stats;
+  for (const ConformanceRequest& request : requests) {
+    CategoryStats& category = stats[absl::StrCat(
+        PayloadName(request), "->",
+        conformance::WireFormat_Name(request.requested_output_format()), " ",
+        conformance::TestCategory_Name(request.test_category()))];
+    uint64_t allocations = allocation_count.load(std::memory_order_relaxed);
+    absl::Time start = absl::Now();
+    for (int i = 0; i < iterations; ++i) {
+      RETURN_IF_ERROR(RunTest(request).status());
+    }
+    category.time += absl::Now() - start;
+    category.allocations +=
+        allocation_count.load(std::memory_order_relaxed) - allocations;
+    category.requests += iterations;
+    category.bytes += static_cast<int64_t>(PayloadSize(request)) * iterations;
+  }
+
+  absl::PrintF("%-50s %12s %10s %12s\n", "category", "requests/s", "MB/s",
+               "allocs/req");
+  for (const auto& entry : stats) {
+    const CategoryStats& category = entry.second;
+    double seconds = absl::ToDoubleSeconds(category.time);
+    if (seconds <= 0) seconds = 1e-9;
+    absl::PrintF("%-50s %12.0f %10.2f %12.1f\n", entry.first,
+                 category.requests / seconds, category.bytes / seconds / 1e6,
+                 static_cast<double>(category.allocations) / category.requests);
+  }
+  return absl::OkStatus();
+}
 }  // namespace
 }  // namespace protobuf
 }  // namespace google
 
-int main() {
+int main(int argc, char* argv[]) {
   google::protobuf::Harness harness;
+  if (argc >= 3 && strcmp(argv[1], "--benchmark") == 0) {
+    int iterations = 100;
+    if (argc >= 4 && !absl::SimpleAtoi(argv[3], &iterations)) {
+      ABSL_LOG(FATAL) << "Invalid iteration count: " << argv[3];
+    }
+    absl::Status status = harness.RunBenchmark(argv[2], iterations);
+    if (!status.ok()) {
+      ABSL_LOG(FATAL) << status;
+    }
+    return 0;
+  }
+
   int total_runs = 0;
   while (true) {
     auto is_done = harness.ServeConformanceRequest();
@@ -420,6 +420,12 @@ void ConformanceTestSuite::RunTest(const string& test_name,
   string serialized_response;
   request.SerializeToString(&serialized_request);
 
+  if (corpus_.is_open()) {
+    uint32_t len = serialized_request.size();
+    corpus_.write(reinterpret_cast<const char*>(&len), sizeof(len));
+    corpus_.write(serialized_request.data(), serialized_request.size());
+  }
+
   runner_->RunTest(test_name, serialized_request, &serialized_response);
 
   if (!response->ParseFromString(serialized_response)) {
@@ -475,7 +481,17 @@ bool ConformanceTestSuite::RunSuite(ConformanceTestRunner* runner,
   for (const string& failure : failure_list->failure()) {
     AddExpectedFailedTest(failure);
   }
+  if (!corpus_output_.empty()) {
+    // Several suites may record into the same corpus.
+    corpus_.open(corpus_output_, std::ios::binary | std::ios::app);
+    if (!corpus_.is_open()) {
+      ABSL_LOG(FATAL) << "Couldn't open corpus file: " << corpus_output_;
+    }
+  }
   RunSuiteImpl();
+  if (corpus_.is_open()) {
+    corpus_.close();
+  }
 
   bool ok = true;
   if (!CheckSetEmpty(
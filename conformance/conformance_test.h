@@ -38,6 +38,7 @@
 #ifndef CONFORMANCE_CONFORMANCE_TEST_H
 #define CONFORMANCE_CONFORMANCE_TEST_H
 
+#include <fstream>
 #include <functional>
 #include <string>
 #include <vector>
@@ -186,6 +187,13 @@ class ConformanceTestSuite {
     output_dir_ = output_dir;
   }
 
+  // Sets a file to append every request sent to the testee to, framed the
+  // same way as on the pipe. The recorded corpus can be replayed later, e.g.
+  // with `conformance_cpp --benchmark`.
+  void SetCorpusOutput(const char* corpus_output) {
+    corpus_output_ = corpus_output;
+  }
+
   // Run all the conformance tests against the given test runner.
   // Test output will be stored in "output".
   //
@@ -314,6 +322,8 @@ class ConformanceTestSuite {
   bool enforce_recommended_;
   std::string output_;
   std::string output_dir_;
+  std::string corpus_output_;
+  std::ofstream corpus_;
   std::string failure_list_flag_name_;
   std::string failure_list_filename_;
 
@@ -144,6 +144,10 @@ void UsageError() {
   fprintf(stderr,
           "  --output_dir                <dirname> Directory to write\n"
           "                              output files.\n");
+  fprintf(stderr,
+          "  --corpus_out                <filename> Append every request\n"
+          "                              sent to the test program to this\n"
+          "                              file, for replaying as a benchmark.\n");
   exit(1);
 }
 
@@ -223,6 +227,9 @@ int ForkPipeRunner::Run(int argc, char *argv[],
       } else if (strcmp(argv[arg], "--output_dir") == 0) {
         if (++arg == argc) UsageError();
         suite->SetOutputDir(argv[arg]);
+      } else if (strcmp(argv[arg], "--corpus_out") == 0) {
+        if (++arg == argc) UsageError();
+        suite->SetCorpusOutput(argv[arg]);
       } else if (argv[arg][0] == '-') {
         bool recognized_flag = false;
         for (ConformanceTestSuite *suite : suites) {
@@ -37,6 +37,11 @@ in generated code.
 
 __author__ = 'jieluo@google.com (Jie Luo)'
 
+import importlib
+import importlib.util
+import os
+
+from google.protobuf.internal import api_implementation
 from google.protobuf.internal import enum_type_wrapper
 from google.protobuf.internal import python_message
 from google.protobuf import message as _message
@@ -45,6 +50,73 @@ from google.protobuf import symbol_database as _symbol_database
 
 _sym_db = _symbol_database.Default()
 
+# With the C++ implementation, generated modules can build their message
+# classes and descriptor attributes on first access instead of at import time,
+# which makes importing modules with many messages much faster. Lazily built
+# classes are only registered in the symbol database once accessed, and are not
+# picked up by `from ... import *`.
+_LAZY_MESSAGE_CLASSES = (
+    api_implementation.Type() == 'cpp' and
+    os.getenv('PROTOCOL_BUFFERS_PYTHON_LAZY_MESSAGE_CLASSES', '0') == '1')
+
+
+class _LazyModuleAttributes(object):
+  """Module-level __getattr__ building attributes of a _pb2 module on use."""
+
+  def __init__(self, module):
+    self._module = module
+    self._build_descriptors = None
+    self._build_message = None
+    self._file_des = None
+    self._message_names = set()
+
+  def DeferDescriptors(self, build_descriptors):
+    self._build_descriptors = build_descriptors
+
+  def DeferMessages(self, file_des, build_message):
+    self._file_des = file_des
+    self._build_message = build_message
+    self._message_names.update(file_des.message_types_by_name)
+
+  def __call__(self, name):
+    if name in self._message_names:
+      self._message_names.discard(name)
+      msg_des = self._file_des.message_types_by_name[name]
+      message_class = self._module[name] = self._build_message(msg_des)
+      return message_class
+    if name.startswith('_') and self._build_descriptors is not None:
+      build_descriptors, self._build_descriptors = self._build_descriptors, None
+      build_descriptors()
+      if name in self._module:
+        return self._module[name]
+    raise AttributeError('module %r has no attribute %r' %
+                         (self._module.get('__name__'), name))
+
+
+def _GetLazyModuleAttributes(module):
+  lazy = module.get('__getattr__')
+  if not isinstance(lazy, _LazyModuleAttributes):
+    lazy = module['__getattr__'] = _LazyModuleAttributes(module)
+  return lazy
+
+
+def ImportCppExtension(module_name):
+  """Imports the C++ extension generated next to a _pb2 module, if built.
+
+  The extension is generated with the cpp_extension option of the Python
+  generator, and links the generated C++ classes of the file into the process.
+  It is only useful with the C++ implementation, and must be imported before
+  the file is added to the default pool.
+
+  Args:
+    module_name: The full name of the extension module.
+  """
+  if api_implementation.Type() != 'cpp':
+    return
+  if importlib.util.find_spec(module_name) is None:
+    return
+  importlib.import_module(module_name)
+
 
 def BuildMessageAndEnumDescriptors(file_des, module):
   """Builds message and enum descriptors.
@@ -62,10 +134,16 @@ def BuildMessageAndEnumDescriptors(file_des, module):
     for enum_des in msg_des.enum_types:
       module[prefix + enum_des.name.upper()] = enum_des
 
-  for (name, msg_des) in file_des.message_types_by_name.items():
-    module_name = '_' + name.upper()
-    module[module_name] = msg_des
-    BuildNestedDescriptors(msg_des, module_name + '_')
+  def BuildDescriptors():
+    for (name, msg_des) in file_des.message_types_by_name.items():
+      module_name = '_' + name.upper()
+      module[module_name] = msg_des
+      BuildNestedDescriptors(msg_des, module_name + '_')
+
+  if _LAZY_MESSAGE_CLASSES:
+    _GetLazyModuleAttributes(module).DeferDescriptors(BuildDescriptors)
+  else:
+    BuildDescriptors()
 
 
 def BuildTopDescriptorsAndMessages(file_des, module_name, module):
@@ -105,6 +183,9 @@ def BuildTopDescriptorsAndMessages(file_des, module_name, module):
     module['_' + name.upper()] = service
 
   # Build messages.
+  if _LAZY_MESSAGE_CLASSES:
+    _GetLazyModuleAttributes(module).DeferMessages(file_des, BuildMessage)
+    return
   for (name, msg_des) in file_des.message_types_by_name.items():
     module[name] = BuildMessage(msg_des)
 
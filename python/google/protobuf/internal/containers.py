@@ -45,6 +45,7 @@ import copy
 import pickle
 from typing import (
     Any,
+    Dict,
     Iterable,
     Iterator,
     List,
@@ -445,6 +446,9 @@ class ScalarMap(MutableMapping[_K, _V]):
   def __repr__(self) -> str:
     return repr(self._values)
 
+  def to_dict(self) -> Dict[_K, _V]:
+    return dict(self._values)
+
   def MergeFrom(self, other: 'ScalarMap[_K, _V]') -> None:
     self._values.update(other._values)
     self._message_listener.Modified()
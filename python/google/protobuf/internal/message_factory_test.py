@@ -32,16 +32,20 @@
 
 __author__ = 'matthewtoia@google.com (Matt Toia)'
 
+import types
 import unittest
 
 from google.protobuf import descriptor_pb2
 from google.protobuf.internal import api_implementation
+from google.protobuf.internal import builder
 from google.protobuf.internal import factory_test1_pb2
 from google.protobuf.internal import factory_test2_pb2
 from google.protobuf.internal import testing_refleaks
 from google.protobuf import descriptor_database
 from google.protobuf import descriptor_pool
+from google.protobuf import message as message_module
 from google.protobuf import message_factory
+from google.protobuf import reflection
 
 
 @testing_refleaks.TestCase
@@ -109,6 +113,51 @@ class MessageFactoryTest(unittest.TestCase):
     self.assertIsInstance(msg.factory_1_message,
                           factory_test1_pb2.Factory1Message)
 
+  def testGeneratedClassReusesFactoryClass(self):
+    db = descriptor_database.DescriptorDatabase()
+    pool = descriptor_pool.DescriptorPool(db)
+    db.Add(self.factory_test1_fd)
+    db.Add(self.factory_test2_fd)
+    desc = pool.FindMessageTypeByName(
+        'google.protobuf.python.internal.Factory2Message')
+    cls = message_factory.GetMessageClass(desc)
+    msg = cls(mandatory=1)
+    generated_cls = reflection.GeneratedProtocolMessageType(
+        desc.name, (message_module.Message,),
+        {'DESCRIPTOR': desc, '__module__': 'factory_test2_pb2'})
+    self.assertIs(cls, generated_cls)
+    self.assertIsInstance(msg, generated_cls)
+
+  @unittest.skipIf(api_implementation.Type() == 'upb',
+                   'Lazy message classes are not supported with upb')
+  def testLazyMessageClasses(self):
+    db = descriptor_database.DescriptorDatabase()
+    pool = descriptor_pool.DescriptorPool(db)
+    db.Add(self.factory_test1_fd)
+    db.Add(self.factory_test2_fd)
+    file_des = pool.FindFileByName(self.factory_test2_fd.name)
+    module = types.ModuleType('lazy_factory_test2_pb2')
+    old_lazy = builder._LAZY_MESSAGE_CLASSES
+    builder._LAZY_MESSAGE_CLASSES = True
+    try:
+      builder.BuildMessageAndEnumDescriptors(file_des, module.__dict__)
+      builder.BuildTopDescriptorsAndMessages(file_des, module.__name__,
+                                             module.__dict__)
+    finally:
+      builder._LAZY_MESSAGE_CLASSES = old_lazy
+    self.assertNotIn('Factory2Message', module.__dict__)
+    self.assertNotIn('_FACTORY2MESSAGE', module.__dict__)
+
+    cls = module.Factory2Message
+    self.assertIs(cls, module.Factory2Message)
+    self.assertIn('Factory2Message', module.__dict__)
+    self.assertEqual(file_des.message_types_by_name['Factory2Message'],
+                     cls.DESCRIPTOR)
+    self.assertIs(cls.DESCRIPTOR, module._FACTORY2MESSAGE)
+    self._ExerciseDynamicClass(cls)
+    with self.assertRaises(AttributeError):
+      module.NoSuchMessage
+
   def testGetMessages(self):
     # performed twice because multiple calls with the same input must be allowed
     for _ in range(2):
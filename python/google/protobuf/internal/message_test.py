@@ -38,6 +38,7 @@ serialization code in the whole library.
 
 __author__ = 'gps@google.com (Gregory P. Smith)'
 
+import array
 import collections
 import copy
 import math
@@ -45,6 +46,7 @@ import operator
 import pickle
 import pydoc
 import sys
+import threading
 import unittest
 import warnings
 
@@ -2282,6 +2284,53 @@ class Proto3Test(unittest.TestCase):
     matching_dict = {2: 4, 3: 6, 4: 8}
     self.assertMapIterEquals(msg.map_int32_int32.items(), matching_dict)
 
+  @unittest.skipIf(api_implementation.Type() == 'upb',
+                   'to_dict() is not implemented for upb maps.')
+  def testScalarMapToDict(self):
+    msg = map_unittest_pb2.TestMap()
+    self.assertEqual({}, msg.map_int32_int32.to_dict())
+
+    msg.map_int32_int32[2] = 4
+    msg.map_int64_int64[-2**40] = 2**40
+    msg.map_uint64_uint64[2**63] = 1
+    msg.map_bool_bool[True] = False
+    msg.map_int32_double[1] = 0.5
+    msg.map_string_string['abc'] = 'def'
+    msg.map_int32_bytes[1] = b'\xff'
+    msg.map_int32_enum[3] = map_unittest_pb2.MAP_ENUM_BAR
+
+    self.assertEqual({2: 4}, msg.map_int32_int32.to_dict())
+    self.assertEqual({-2**40: 2**40}, msg.map_int64_int64.to_dict())
+    self.assertEqual({2**63: 1}, msg.map_uint64_uint64.to_dict())
+    self.assertEqual({True: False}, msg.map_bool_bool.to_dict())
+    self.assertEqual({1: 0.5}, msg.map_int32_double.to_dict())
+    self.assertEqual({'abc': 'def'}, msg.map_string_string.to_dict())
+    self.assertEqual({1: b'\xff'}, msg.map_int32_bytes.to_dict())
+    self.assertEqual({3: map_unittest_pb2.MAP_ENUM_BAR},
+                     msg.map_int32_enum.to_dict())
+
+    # The result is a copy.
+    d = msg.map_int32_int32.to_dict()
+    d[5] = 10
+    self.assertEqual(1, len(msg.map_int32_int32))
+
+  def testScalarMapUpdate(self):
+    msg = map_unittest_pb2.TestMap()
+    msg.map_string_int32['a'] = 1
+    msg.map_string_int32.update({'a': 2, 'b': 3})
+    msg.map_string_int32.update([('c', 4)], d=5)
+    msg.map_string_int32.update(e=6)
+    self.assertEqual({'a': 2, 'b': 3, 'c': 4, 'd': 5, 'e': 6},
+                     dict(msg.map_string_int32))
+
+    msg.map_int32_int32.update({})
+    self.assertEqual(0, len(msg.map_int32_int32))
+
+    with self.assertRaises(TypeError):
+      msg.map_string_int32.update({'f': 'not an int'})
+    with self.assertRaises(TypeError):
+      msg.map_string_int32.update({1: 1})
+
   def testMapItems(self):
     # Map items used to have strange behaviors when use c extension. Because
     # [] may reorder the map and invalidate any existing iterators.
@@ -2611,6 +2660,191 @@ class PackedFieldTest(unittest.TestCase):
     self.assertEqual(golden_data, message.SerializeToString())
 
 
+@unittest.skipIf(api_implementation.Type() != 'cpp',
+                 'explicit tests of the C++ implementation')
+@testing_refleaks.TestCase
+class RepeatedScalarBufferTest(unittest.TestCase):
+
+  def testMemoryView(self):
+    m = unittest_pb2.TestAllTypes()
+    m.repeated_int64.extend([1, -2, 3])
+    view = memoryview(m.repeated_int64)
+    self.assertTrue(view.readonly)
+    self.assertEqual('q', view.format)
+    self.assertEqual([1, -2, 3], view.tolist())
+    view.release()
+
+    m.repeated_double.append(1.5)
+    m.repeated_bool.extend([True, False])
+    m.repeated_nested_enum.append(unittest_pb2.TestAllTypes.BAZ)
+    self.assertEqual([1.5], memoryview(m.repeated_double).tolist())
+    self.assertEqual([True, False], memoryview(m.repeated_bool).tolist())
+    self.assertEqual([unittest_pb2.TestAllTypes.BAZ],
+                     memoryview(m.repeated_nested_enum).tolist())
+    self.assertEqual([], memoryview(m.repeated_float).tolist())
+
+  def testStringFieldHasNoBuffer(self):
+    m = unittest_pb2.TestAllTypes()
+    with self.assertRaises(TypeError):
+      memoryview(m.repeated_string)
+
+  def testNoModificationWhileExported(self):
+    m = unittest_pb2.TestAllTypes()
+    m.repeated_int32.append(1)
+    with memoryview(m.repeated_int32):
+      with self.assertRaises(BufferError):
+        m.repeated_int32.append(2)
+      with self.assertRaises(BufferError):
+        m.repeated_int32[0] = 2
+    m.repeated_int32.append(2)
+    self.assertEqual([1, 2], m.repeated_int32)
+
+  def testExtendFromBuffer(self):
+    m = unittest_pb2.TestAllTypes()
+    m.repeated_int32.append(7)
+    m.repeated_int32.extend(array.array('i', [1, 2, 3]))
+    self.assertEqual([7, 1, 2, 3], m.repeated_int32)
+    m.repeated_float.extend(array.array('f', [0.5, 1.5]))
+    self.assertEqual([0.5, 1.5], m.repeated_float)
+    m.repeated_uint64.extend(array.array('Q', [2**64 - 1]))
+    self.assertEqual([2**64 - 1], m.repeated_uint64)
+    m.repeated_int64.extend(memoryview(array.array('q', [])))
+    self.assertEqual([], m.repeated_int64)
+
+  def testExtendFromMismatchedBuffer(self):
+    m = unittest_pb2.TestAllTypes()
+    # Buffers of another element type are converted one element at a time.
+    m.repeated_int64.extend(array.array('i', [1]))
+    m.repeated_double.extend(array.array('i', [2]))
+    self.assertEqual([1], m.repeated_int64)
+    self.assertEqual([2.0], m.repeated_double)
+    with self.assertRaises(ValueError):
+      m.repeated_uint32.extend(array.array('i', [-1]))
+
+  def testExtendFromRepeatedField(self):
+    m = unittest_pb2.TestAllTypes()
+    m.repeated_int32.extend([1, 2])
+    m.repeated_int32.extend(m.repeated_int32[:])
+    self.assertEqual([1, 2, 1, 2], m.repeated_int32)
+    other = unittest_pb2.TestAllTypes()
+    other.repeated_int32.extend(m.repeated_int32)
+    self.assertEqual([1, 2, 1, 2], other.repeated_int32)
+
+
+@testing_refleaks.TestCase
+class LargeMessageTest(unittest.TestCase):
+  """The C++ implementation parses large inputs into an arena, and parses and
+  serializes large messages without holding the GIL."""
+
+  def LargeMessage(self):
+    msg = unittest_pb2.TestAllTypes()
+    for i in range(1000):
+      msg.repeated_nested_message.add(bb=i)
+      msg.repeated_string.append('x' * (i % 10))
+    msg.optional_nested_message.bb = 7
+    return msg
+
+  def testFromString(self):
+    golden = self.LargeMessage()
+    msg = unittest_pb2.TestAllTypes.FromString(golden.SerializeToString())
+    self.assertEqual(golden, msg)
+
+  def testFromStrings(self):
+    golden = self.LargeMessage()
+    serialized = [golden.SerializeToString(), b'', b'\x08\x05']
+    for num_threads in (1, 4):
+      msgs = unittest_pb2.TestAllTypes.FromStrings(serialized, num_threads)
+      self.assertEqual(3, len(msgs))
+      self.assertEqual(golden, msgs[0])
+      self.assertEqual(unittest_pb2.TestAllTypes(), msgs[1])
+      self.assertEqual(5, msgs[2].optional_int32)
+    nested = msgs[0].repeated_nested_message[1]
+    del msgs
+    self.assertEqual(1, nested.bb)
+    nested.bb = 2
+    self.assertEqual(2, nested.bb)
+
+  def testFromStringsError(self):
+    serialized = [b'\x08\x05', b'\x08', b'\xff']
+    with self.assertRaises(message.DecodeError) as context:
+      unittest_pb2.TestAllTypes.FromStrings(serialized, num_threads=2)
+    if api_implementation.Type() == 'cpp':
+      self.assertIn('index 1', str(context.exception))
+
+  def testReleasedMessagesOutliveParent(self):
+    serialized = self.LargeMessage().SerializeToString()
+    msg = unittest_pb2.TestAllTypes.FromString(serialized)
+    first = msg.repeated_nested_message[0]
+    last = msg.repeated_nested_message.pop()
+    nested = msg.optional_nested_message
+    del msg.repeated_nested_message[:10]
+    msg.ParseFromString(serialized)
+    msg.Clear()
+    del msg
+    self.assertEqual(0, first.bb)
+    self.assertEqual(999, last.bb)
+    self.assertEqual(7, nested.bb)
+    first.bb = 1
+    self.assertEqual(1, first.bb)
+
+  def testParseAgain(self):
+    golden = self.LargeMessage()
+    serialized = golden.SerializeToString()
+    msg = unittest_pb2.TestAllTypes()
+    for _ in range(3):
+      msg.ParseFromString(serialized)
+      self.assertEqual(golden, msg)
+    other = unittest_pb2.TestAllTypes()
+    other.CopyFrom(msg)
+    msg.Clear()
+    self.assertEqual(golden, other)
+
+  def testFromStringInThreads(self):
+    golden = self.LargeMessage()
+    golden.repeated_bytes.append(b'x' * 100000)
+    serialized = golden.SerializeToString()
+    results = []
+
+    def Parse():
+      for _ in range(10):
+        results.append(unittest_pb2.TestAllTypes.FromString(serialized))
+
+    threads = [threading.Thread(target=Parse) for _ in range(4)]
+    for thread in threads:
+      thread.start()
+    for thread in threads:
+      thread.join()
+    self.assertEqual(40, len(results))
+    for result in results:
+      self.assertEqual(golden, result)
+
+  def testModifyWhileSerializingInAnotherThread(self):
+    msg = self.LargeMessage()
+    msg.repeated_bytes.append(b'x' * 100000)
+    serialized = []
+
+    def Serialize():
+      for _ in range(20):
+        serialized.append(msg.SerializeToString())
+
+    thread = threading.Thread(target=Serialize)
+    thread.start()
+    for i in range(1000):
+      msg.repeated_nested_message[i].bb = -i
+      msg.repeated_int32.append(i)
+    thread.join()
+    for data in serialized:
+      # Every serialization sees the message between two modifications.
+      result = unittest_pb2.TestAllTypes.FromString(data)
+      count = len(result.repeated_int32)
+      self.assertEqual(list(range(count)), result.repeated_int32)
+      for i, nested in enumerate(result.repeated_nested_message):
+        if i < count:
+          self.assertEqual(-i, nested.bb)
+        elif i > count:
+          self.assertEqual(i, nested.bb)
+
+
 @unittest.skipIf(api_implementation.Type() == 'python',
                  'explicit tests of the C++ implementation')
 @testing_refleaks.TestCase
@@ -783,6 +783,11 @@ def _AddStaticMethods(cls):
     return message
   cls.FromString = staticmethod(FromString)
 
+  def FromStrings(serialized, num_threads=1):
+    del num_threads  # Only the C++ implementation parses in parallel.
+    return [FromString(s) for s in serialized]
+  cls.FromStrings = staticmethod(FromStrings)
+
 
 def _IsPresent(item):
   """Given a (FieldDescriptor, value) tuple from _fields, return true if the
@@ -367,6 +367,23 @@ class Message(object):
   def FromString(cls, s):
     raise NotImplementedError
 
+  @classmethod
+  def FromStrings(cls, serialized, num_threads=1):
+    """Parses each of a sequence of serialized messages.
+
+    Args:
+      serialized: A sequence of bytes-like objects.
+      num_threads (int): The C++ implementation parses on up to this many
+        threads when every input is an immutable bytes object.
+
+    Returns:
+      A list with one new message per input, in the same order.
+
+    Raises:
+      DecodeError: If any input cannot be parsed.
+    """
+    raise NotImplementedError
+
   @staticmethod
   def RegisterExtension(field_descriptor):
     raise NotImplementedError
@@ -33,6 +33,7 @@
 #include "google/protobuf/pyext/map_container.h"
 
 #include <cstdint>
+#include <initializer_list>
 #include <memory>
 #include <string>
 
@@ -66,6 +67,25 @@ class MapReflectionFriend {
   static int MessageMapSetItem(PyObject* _self, PyObject* key, PyObject* v);
   static PyObject* ScalarMapToStr(PyObject* _self);
   static PyObject* MessageMapToStr(PyObject* _self);
+
+  // Bulk conversions of scalar maps.
+  static PyObject* ScalarMapToDict(PyObject* _self);
+  static PyObject* ScalarMapUpdate(PyObject* _self, PyObject* args,
+                                   PyObject* kwargs);
+
+ private:
+  // Calls fn(key, value) with new Python objects for every entry of the map,
+  // or fn(key, nullptr) if with_values is false. Returns false with a Python
+  // error set if a conversion or fn fails.
+  template <typename Fn>
+  static bool ForEachEntry(MapContainer* self, bool with_values, Fn fn);
+  template <typename Key, typename Fn>
+  static bool ForEachTypedEntry(MapContainer* self,
+                                const internal::MapFieldBase* field,
+                                bool with_values, Fn& fn);
+  static bool SetScalarMapItem(MapContainer* self, Message* message,
+                               PyObject* key, PyObject* v);
+  static PyObject* NewKeysList(MapContainer* self);
 };
 
 struct MapIterator {
@@ -94,6 +114,11 @@ struct MapIterator {
   // We store this so that if the map is modified during iteration we can throw
   // an error.
   uint64_t version;
+
+  // Scalar maps are iterated over a list of their keys, built in one pass
+  // instead of one reflection call per key. Unused (nullptr) for message maps.
+  PyObject* keys;
+  Py_ssize_t index;
 };
 
 Message* MapContainer::GetMutableMessage() {
@@ -299,6 +324,182 @@ static bool PythonToMapValueRef(MapContainer* self, PyObject* obj,
   }
 }
 
+// Bulk map traversal //////////////////////////////////////////////////////////
+
+// Map fields of generated messages and of DynamicMessage are both backed by an
+// internal::TypeDefinedMapFieldBase, whose Map can be walked directly instead
+// of going through a heap-allocated MapIterator and a virtual call per entry.
+static PyObject* EntryToPython(MapContainer*, const FieldDescriptor*,
+                               int32_t value) {
+  return PyLong_FromLong(value);
+}
+static PyObject* EntryToPython(MapContainer*, const FieldDescriptor*,
+                               int64_t value) {
+  return PyLong_FromLongLong(value);
+}
+static PyObject* EntryToPython(MapContainer*, const FieldDescriptor*,
+                               uint32_t value) {
+  return PyLong_FromSize_t(value);
+}
+static PyObject* EntryToPython(MapContainer*, const FieldDescriptor*,
+                               uint64_t value) {
+  return PyLong_FromUnsignedLongLong(value);
+}
+static PyObject* EntryToPython(MapContainer*, const FieldDescriptor*,
+                               float value) {
+  return PyFloat_FromDouble(value);
+}
+static PyObject* EntryToPython(MapContainer*, const FieldDescriptor*,
+                               double value) {
+  return PyFloat_FromDouble(value);
+}
+static PyObject* EntryToPython(MapContainer*, const FieldDescriptor*,
+                               bool value) {
+  return PyBool_FromLong(value);
+}
+static PyObject* EntryToPython(MapContainer*,
+                               const FieldDescriptor* field_descriptor,
+                               const std::string& value) {
+  return ToStringObject(field_descriptor, value);
+}
+static PyObject* EntryToPython(MapContainer* self, const FieldDescriptor*,
+                               const MapKey& key) {
+  return MapKeyToPython(self, key);
+}
+static PyObject* EntryToPython(MapContainer* self, const FieldDescriptor*,
+                               const MapValueRef& value) {
+  return MapValueRefToPython(self, value);
+}
+
+template <typename Key, typename T, typename Fn>
+static bool VisitMap(MapContainer* self, const Map<Key, T>& map,
+                     bool with_values, Fn& fn) {
+  const Descriptor* entry = self->parent_field_descriptor->message_type();
+  ScopedPyObjectPtr key;
+  ScopedPyObjectPtr value;
+  for (const auto& kv : map) {
+    key.reset(EntryToPython(self, entry->map_key(), kv.first));
+    if (key == nullptr) {
+      return false;
+    }
+    if (with_values) {
+      value.reset(EntryToPython(self, entry->map_value(), kv.second));
+      if (value == nullptr) {
+        return false;
+      }
+    }
+    if (!fn(key.get(), value.get())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename Key, typename Fn>
+bool MapReflectionFriend::ForEachTypedEntry(MapContainer* self,
+                                            const internal::MapFieldBase* field,
+                                            bool with_values, Fn& fn) {
+  using internal::TypeDefinedMapFieldBase;
+  switch (self->parent_field_descriptor->message_type()
+              ->map_value()
+              ->cpp_type()) {
+#define VISIT_TYPED_MAP(CPPTYPE, T)                                     \
+  case FieldDescriptor::CPPTYPE:                                        \
+    return VisitMap(                                                    \
+        self,                                                           \
+        static_cast<const TypeDefinedMapFieldBase<Key, T>*>(field)      \
+            ->GetMap(),                                                 \
+        with_values, fn);
+    VISIT_TYPED_MAP(CPPTYPE_INT32, int32_t)
+    VISIT_TYPED_MAP(CPPTYPE_INT64, int64_t)
+    VISIT_TYPED_MAP(CPPTYPE_UINT32, uint32_t)
+    VISIT_TYPED_MAP(CPPTYPE_UINT64, uint64_t)
+    VISIT_TYPED_MAP(CPPTYPE_FLOAT, float)
+    VISIT_TYPED_MAP(CPPTYPE_DOUBLE, double)
+    VISIT_TYPED_MAP(CPPTYPE_BOOL, bool)
+    VISIT_TYPED_MAP(CPPTYPE_STRING, std::string)
+#undef VISIT_TYPED_MAP
+    default:
+      PyErr_Format(PyExc_SystemError, "Unexpected map value type %d",
+                   self->parent_field_descriptor->message_type()
+                       ->map_value()
+                       ->cpp_type());
+      return false;
+  }
+}
+
+template <typename Fn>
+bool MapReflectionFriend::ForEachEntry(MapContainer* self, bool with_values,
+                                       Fn fn) {
+  const Message* message = self->parent->message;
+  const Reflection* reflection = message->GetReflection();
+  const FieldDescriptor* key_descriptor =
+      self->parent_field_descriptor->message_type()->map_key();
+  const FieldDescriptor* value_descriptor =
+      self->parent_field_descriptor->message_type()->map_value();
+  const internal::MapFieldBase* field =
+      reflection->GetMapData(*message, self->parent_field_descriptor);
+
+  if (reflection->GetMessageFactory() ==
+      cmessage::GetFactoryForMessage(self->parent)->message_factory) {
+    // DynamicMessage stores every map as Map<MapKey, MapValueRef>.
+    return VisitMap(
+        self,
+        static_cast<const internal::TypeDefinedMapFieldBase<MapKey,
+                                                            MapValueRef>*>(
+            field)
+            ->GetMap(),
+        with_values, fn);
+  }
+
+  // Generated maps store enum values as the generated enum type, and the
+  // scalar types below are the only other ones a ScalarMap can hold.
+  if (reflection->GetMessageFactory() == MessageFactory::generated_factory() &&
+      value_descriptor->cpp_type() != FieldDescriptor::CPPTYPE_ENUM &&
+      value_descriptor->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+    switch (key_descriptor->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        return ForEachTypedEntry<int32_t>(self, field, with_values, fn);
+      case FieldDescriptor::CPPTYPE_INT64:
+        return ForEachTypedEntry<int64_t>(self, field, with_values, fn);
+      case FieldDescriptor::CPPTYPE_UINT32:
+        return ForEachTypedEntry<uint32_t>(self, field, with_values, fn);
+      case FieldDescriptor::CPPTYPE_UINT64:
+        return ForEachTypedEntry<uint64_t>(self, field, with_values, fn);
+      case FieldDescriptor::CPPTYPE_BOOL:
+        return ForEachTypedEntry<bool>(self, field, with_values, fn);
+      case FieldDescriptor::CPPTYPE_STRING:
+        return ForEachTypedEntry<std::string>(self, field, with_values, fn);
+      default:
+        break;
+    }
+  }
+
+  // Reflection iteration needs a mutable message.
+  Message* mutable_message = self->GetMutableMessage();
+  ScopedPyObjectPtr key;
+  ScopedPyObjectPtr value;
+  for (google::protobuf::MapIterator it = reflection->MapBegin(
+           mutable_message, self->parent_field_descriptor);
+       it != reflection->MapEnd(mutable_message, self->parent_field_descriptor);
+       ++it) {
+    key.reset(MapKeyToPython(self, it.GetKey()));
+    if (key == nullptr) {
+      return false;
+    }
+    if (with_values) {
+      value.reset(MapValueRefToPython(self, it.GetValueRef()));
+      if (value == nullptr) {
+        return false;
+      }
+    }
+    if (!fn(key.get(), value.get())) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Map methods common to ScalarMap and MessageMap //////////////////////////////
 
 static MapContainer* GetMap(PyObject* obj) {
@@ -417,6 +618,27 @@ PyObject* MapReflectionFriend::ScalarMapGetItem(PyObject* _self,
   return MapValueRefToPython(self, value);
 }
 
+bool MapReflectionFriend::SetScalarMapItem(MapContainer* self,
+                                           Message* message, PyObject* key,
+                                           PyObject* v) {
+  const Reflection* reflection = message->GetReflection();
+  MapKey map_key;
+  MapValueRef value;
+
+  if (!PythonToMapKey(self, key, &map_key)) {
+    return false;
+  }
+  if (reflection->InsertOrLookupMapValue(message, self->parent_field_descriptor,
+                                         map_key, &value)) {
+    self->version++;
+  }
+  return PythonToMapValueRef(self, v,
+                             !self->parent_field_descriptor->message_type()
+                                  ->map_value()
+                                  ->legacy_enum_field_treated_as_closed(),
+                             &value);
+}
+
 int MapReflectionFriend::ScalarMapSetItem(PyObject* _self, PyObject* key,
                                           PyObject* v) {
   MapContainer* self = GetMap(_self);
@@ -424,28 +646,14 @@ int MapReflectionFriend::ScalarMapSetItem(PyObject* _self, PyObject* key,
   Message* message = self->GetMutableMessage();
   const Reflection* reflection = message->GetReflection();
   MapKey map_key;
-  MapValueRef value;
-
-  if (!PythonToMapKey(self, key, &map_key)) {
-    return -1;
-  }
 
   if (v) {
     // Set item to v.
-    if (reflection->InsertOrLookupMapValue(
-            message, self->parent_field_descriptor, map_key, &value)) {
-      self->version++;
-    }
-
-    if (!PythonToMapValueRef(self, v,
-                             !self->parent_field_descriptor->message_type()
-                                  ->map_value()
-                                  ->legacy_enum_field_treated_as_closed(),
-                             &value)) {
+    return SetScalarMapItem(self, message, key, v) ? 0 : -1;
+  } else {
+    if (!PythonToMapKey(self, key, &map_key)) {
       return -1;
     }
-    return 0;
-  } else {
     // Delete key from map.
     if (reflection->DeleteMapValue(message, self->parent_field_descriptor,
                                    map_key)) {
@@ -486,34 +694,67 @@ static PyObject* ScalarMapGet(PyObject* self, PyObject* args,
   }
 }
 
-PyObject* MapReflectionFriend::ScalarMapToStr(PyObject* _self) {
+PyObject* MapReflectionFriend::ScalarMapToDict(PyObject* _self) {
   ScopedPyObjectPtr dict(PyDict_New());
   if (dict == nullptr) {
     return nullptr;
   }
-  ScopedPyObjectPtr key;
-  ScopedPyObjectPtr value;
+  if (!ForEachEntry(GetMap(_self), /*with_values=*/true,
+                    [&dict](PyObject* key, PyObject* value) {
+                      return PyDict_SetItem(dict.get(), key, value) == 0;
+                    })) {
+    return nullptr;
+  }
+  return dict.release();
+}
+
+PyObject* MapReflectionFriend::ScalarMapToStr(PyObject* _self) {
+  ScopedPyObjectPtr dict(ScalarMapToDict(_self));
+  if (dict == nullptr) {
+    return nullptr;
+  }
+  return PyObject_Repr(dict.get());
+}
 
+PyObject* MapReflectionFriend::ScalarMapUpdate(PyObject* _self, PyObject* args,
+                                               PyObject* kwargs) {
   MapContainer* self = GetMap(_self);
-  Message* message = self->GetMutableMessage();
-  const Reflection* reflection = message->GetReflection();
-  for (google::protobuf::MapIterator it = reflection->MapBegin(
-           message, self->parent_field_descriptor);
-       it != reflection->MapEnd(message, self->parent_field_descriptor);
-       ++it) {
-    key.reset(MapKeyToPython(self, it.GetKey()));
-    if (key == nullptr) {
+  PyObject* other = nullptr;
+  if (!PyArg_UnpackTuple(args, "update", 0, 1, &other)) {
+    return nullptr;
+  }
+
+  if (other != nullptr && !PyDict_CheckExact(other)) {
+    // Other mappings and iterables of pairs keep the MutableMapping semantics.
+    ScopedPyObjectPtr update(PyObject_GetAttrString(
+        reinterpret_cast<PyObject*>(ScalarMapContainer_Type->tp_base),
+        "update"));
+    if (update == nullptr) {
       return nullptr;
     }
-    value.reset(MapValueRefToPython(self, it.GetValueRef()));
-    if (value == nullptr) {
+    ScopedPyObjectPtr update_args(PyTuple_Pack(2, _self, other));
+    if (update_args == nullptr) {
       return nullptr;
     }
-    if (PyDict_SetItem(dict.get(), key.get(), value.get()) < 0) {
-      return nullptr;
+    return PyObject_Call(update.get(), update_args.get(), kwargs);
+  }
+
+  // Plain dicts are copied in with a single AssureWritable() on the parent.
+  Message* message = self->GetMutableMessage();
+  for (PyObject* dict : {other, kwargs}) {
+    if (dict == nullptr) {
+      continue;
+    }
+    PyObject* key;
+    PyObject* value;
+    Py_ssize_t pos = 0;
+    while (PyDict_Next(dict, &pos, &key, &value)) {
+      if (!SetScalarMapItem(self, message, key, value)) {
+        return nullptr;
+      }
     }
   }
-  return PyObject_Repr(dict.get());
+  Py_RETURN_NONE;
 }
 
 static void ScalarMapDealloc(PyObject* _self) {
@@ -538,6 +779,11 @@ static PyMethodDef ScalarMapMethods[] = {
      "Return the class used to build Entries of (key, value) pairs."},
     {"MergeFrom", (PyCFunction)MapReflectionFriend::MergeFrom, METH_O,
      "Merges a map into the current map."},
+    {"to_dict", (PyCFunction)MapReflectionFriend::ScalarMapToDict, METH_NOARGS,
+     "Returns a dict with a copy of the map's entries."},
+    {"update", (PyCFunction)MapReflectionFriend::ScalarMapUpdate,
+     METH_VARARGS | METH_KEYWORDS,
+     "Updates the map from a mapping or iterable of pairs, and keywords."},
     /*
     { "__deepcopy__", (PyCFunction)DeepCopy, METH_VARARGS,
       "Makes a deep copy of the class." },
@@ -637,9 +883,14 @@ int MapReflectionFriend::MessageMapSetItem(PyObject* _self, PyObject* key,
     // otherwise we just discard the C++ value.
     if (CMessage* released =
             self->parent->MaybeReleaseSubMessage(sub_message)) {
+      // Stay on the arena of the parent, if it has one of its own, so that
+      // the contents are swapped rather than copied.
+      PyObject* arena_owner = cmessage::GetArenaOwner(self->parent);
       Message* msg = released->message;
-      released->message = msg->New();
+      released->message = msg->New(arena_owner ? msg->GetArena() : nullptr);
       msg->GetReflection()->Swap(msg, released->message);
+      Py_XINCREF(arena_owner);
+      released->arena = arena_owner;
     }
 
     // Delete key from map.
@@ -785,6 +1036,20 @@ static MapIterator* GetIter(PyObject* obj) {
   return reinterpret_cast<MapIterator*>(obj);
 }
 
+PyObject* MapReflectionFriend::NewKeysList(MapContainer* self) {
+  ScopedPyObjectPtr keys(PyList_New(0));
+  if (keys == nullptr) {
+    return nullptr;
+  }
+  if (!ForEachEntry(self, /*with_values=*/false,
+                    [&keys](PyObject* key, PyObject*) {
+                      return PyList_Append(keys.get(), key) == 0;
+                    })) {
+    return nullptr;
+  }
+  return keys.release();
+}
+
 PyObject* MapReflectionFriend::GetIterator(PyObject *_self) {
   MapContainer* self = GetMap(_self);
 
@@ -801,7 +1066,12 @@ PyObject* MapReflectionFriend::GetIterator(PyObject *_self) {
   Py_INCREF(self->parent);
   iter->parent = self->parent;
 
-  if (MapReflectionFriend::Length(_self) > 0) {
+  if (PyObject_TypeCheck(_self, ScalarMapContainer_Type)) {
+    iter->keys = NewKeysList(self);
+    if (iter->keys == nullptr) {
+      return nullptr;
+    }
+  } else if (MapReflectionFriend::Length(_self) > 0) {
     Message* message = self->GetMutableMessage();
     const Reflection* reflection = message->GetReflection();
 
@@ -826,6 +1096,15 @@ PyObject* MapReflectionFriend::IterNext(PyObject* _self) {
                         "Map cleared during iteration.");
   }
 
+  if (self->keys != nullptr) {
+    if (self->index >= PyList_GET_SIZE(self->keys)) {
+      return nullptr;
+    }
+    PyObject* key = PyList_GET_ITEM(self->keys, self->index++);
+    Py_INCREF(key);
+    return key;
+  }
+
   if (self->iter.get() == nullptr) {
     return nullptr;
   }
@@ -848,6 +1127,7 @@ PyObject* MapReflectionFriend::IterNext(PyObject* _self) {
 static void DeallocMapIterator(PyObject* _self) {
   MapIterator* self = GetIter(_self);
   self->iter.reset();
+  Py_CLEAR(self->keys);
   Py_CLEAR(self->container);
   Py_CLEAR(self->parent);
   Py_TYPE(_self)->tp_free(_self);
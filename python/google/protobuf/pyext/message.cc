@@ -35,15 +35,19 @@
 
 #include <structmember.h>  // A Python header file.
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "absl/log/absl_check.h"
 #include "absl/strings/match.h"
+#include "absl/synchronization/mutex.h"
 
 #ifndef PyVarObject_HEAD_INIT
 #define PyVarObject_HEAD_INIT(type, size) PyObject_HEAD_INIT(type) size,
@@ -201,6 +205,43 @@ static int AddDescriptors(PyObject* cls, const Descriptor* descriptor) {
   return 0;
 }
 
+// Returns a new reference to the class created by the message factory for
+// `descriptor`, after setting the attributes in `dict` on it. Returns nullptr,
+// without an exception, if the factory has no such class, or if the class
+// already belongs to a module.
+static PyObject* AdoptFactoryClass(const Descriptor* descriptor,
+                                   PyObject* dict) {
+  PyDescriptorPool* py_descriptor_pool =
+      GetDescriptorPool_FromPool(descriptor->file()->pool());
+  if (py_descriptor_pool == nullptr) {
+    return nullptr;
+  }
+  PyMessageFactory* factory = py_descriptor_pool->py_message_factory;
+  auto it = factory->classes_by_descriptor->find(descriptor);
+  if (it == factory->classes_by_descriptor->end()) {
+    return nullptr;
+  }
+  PyObject* existing_class = it->second->AsPyObject();
+  PyObject* module = PyDict_GetItemString(
+      reinterpret_cast<PyTypeObject*>(existing_class)->tp_dict, "__module__");
+  if (module != Py_None) {
+    return nullptr;
+  }
+  Py_ssize_t pos = 0;
+  PyObject* key;
+  PyObject* value;
+  while (PyDict_Next(dict, &pos, &key, &value)) {
+    if (PyObject_RichCompareBool(key, kDESCRIPTOR, Py_EQ) == 1) {
+      continue;
+    }
+    if (PyObject_SetAttr(existing_class, key, value) < 0) {
+      return nullptr;
+    }
+  }
+  Py_INCREF(existing_class);
+  return existing_class;
+}
+
 static PyObject* New(PyTypeObject* type, PyObject* args, PyObject* kwargs) {
   static const char* kwlist[] = {"name", "bases", "dict", nullptr};
   PyObject *bases, *dict;
@@ -239,6 +280,15 @@ static PyObject* New(PyTypeObject* type, PyObject* args, PyObject* kwargs) {
     return nullptr;
   }
 
+  // The message factory may already have created a class for this descriptor,
+  // e.g. for a submessage field, before a generated module that builds its
+  // classes lazily got to it. Adopt that class rather than replacing it, so
+  // that existing messages keep the same type as the generated class.
+  ScopedPyObjectPtr existing_class(AdoptFactoryClass(message_descriptor, dict));
+  if (existing_class != nullptr || PyErr_Occurred()) {
+    return existing_class.release();
+  }
+
   // Messages have no __dict__
   ScopedPyObjectPtr slots(PyTuple_New(0));
   if (PyDict_SetItemString(dict, "__slots__", slots.get()) < 0) {
@@ -850,8 +900,50 @@ int FixupMessageAfterMerge(CMessage* self) {
 // ---------------------------------------------------------------------
 // Making a message writable
 
+// Serializing a large message releases the GIL so that other threads can run
+// meanwhile.  Modifications to its tree wait until that is done.
+static constexpr size_t kMinSizeToReleaseGil = 64 * 1024;
+
+ABSL_CONST_INIT absl::Mutex gil_free_mutex(absl::kConstInit);
+
+// Returns the message at the top of the tree self belongs to, or NULL if the
+// tree is owned externally.
+static CMessage* GetRoot(CMessage* self) {
+  while (self->parent != nullptr) {
+    if (self->parent->AsPyObject() == Py_None) {
+      return nullptr;
+    }
+    self = self->parent;
+  }
+  return self;
+}
+
+static bool HasNoGilFreeReaders(CMessage* root) {
+  return root->gil_free_readers.load(std::memory_order_relaxed) == 0;
+}
+
+// Waits, with the GIL released, until no thread is serializing the tree of
+// self without the GIL.  Readers only start while holding the GIL, so none is
+// running once this returns.
+static void WaitForGilFreeReaders(CMessage* self) {
+  CMessage* root = GetRoot(self);
+  if (root == nullptr) {
+    return;
+  }
+  while (root->gil_free_readers.load(std::memory_order_acquire) != 0) {
+    Py_BEGIN_ALLOW_THREADS
+    gil_free_mutex.LockWhen(absl::Condition(HasNoGilFreeReaders, root));
+    gil_free_mutex.Unlock();
+    Py_END_ALLOW_THREADS
+  }
+}
+
 int AssureWritable(CMessage* self) {
-  if (self == nullptr || !self->read_only) {
+  if (self == nullptr) {
+    return 0;
+  }
+  WaitForGilFreeReaders(self);
+  if (!self->read_only) {
     return 0;
   }
 
@@ -988,8 +1080,10 @@ int DeleteRepeatedField(
   }
 
   Arena* arena = Arena::InternalGetArenaForAllocation(message);
-  ABSL_DCHECK_EQ(arena, nullptr)
-      << "python protobuf is expected to be allocated from heap";
+  PyObject* arena_owner = GetArenaOwner(self);
+  ABSL_DCHECK(arena == nullptr || arena_owner != nullptr)
+      << "python protobuf is expected to be allocated from heap or from its "
+         "own arena";
   // Remove items, starting from the end.
   for (; length > to; length--) {
     if (field_descriptor->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
@@ -1008,14 +1102,18 @@ int DeleteRepeatedField(
     // redundant. The current approach takes extra cautious path not to disrupt
     // production.
     Message* sub_message =
-        (arena == nullptr)
+        (arena == nullptr || arena_owner != nullptr)
             ? reflection->UnsafeArenaReleaseLast(message, field_descriptor)
             : reflection->ReleaseLast(message, field_descriptor);
     // If there is a live weak reference to an item being removed, we "Release"
-    // it, and it takes ownership of the message.
+    // it, and it takes ownership of the message, or shares the arena it is on.
     if (CMessage* released = self->MaybeReleaseSubMessage(sub_message)) {
       released->message = sub_message;
-    } else {
+      if (sub_message->GetArena() != nullptr) {
+        Py_XINCREF(arena_owner);
+        released->arena = arena_owner;
+      }
+    } else if (sub_message->GetArena() == nullptr) {
       // sub_message was not transferred, delete it.
       delete sub_message;
     }
@@ -1212,6 +1310,8 @@ CMessage* NewEmptyMessage(CMessageClass* type) {
   self->child_submessages = nullptr;
 
   self->unknown_field_set = nullptr;
+  self->arena = nullptr;
+  self->gil_free_readers.store(0, std::memory_order_relaxed);
 
   return self;
 }
@@ -1280,8 +1380,12 @@ static void Dealloc(CMessage* self) {
 
   CMessage* parent = self->parent;
   if (!parent) {
-    // No parent, we own the message.
-    delete self->message;
+    // No parent, we own the message, or share the arena that owns it.
+    if (self->arena) {
+      Py_CLEAR(self->arena);
+    } else {
+      delete self->message;
+    }
   } else if (parent->AsPyObject() == Py_None) {
     // Message owned externally: Nothing to dealloc
     Py_CLEAR(self->parent);
@@ -1477,7 +1581,13 @@ static int InternalReparentFields(
   if (new_message == nullptr) {
     return -1;
   }
-  new_message->message = self->message->New(nullptr);
+  // Released messages stay on the arena of self, if it has one of its own,
+  // so that their fields can be swapped rather than copied.
+  PyObject* arena_owner = GetArenaOwner(self);
+  new_message->message =
+      self->message->New(arena_owner ? self->message->GetArena() : nullptr);
+  Py_XINCREF(arena_owner);
+  new_message->arena = arena_owner;
   ScopedPyObjectPtr holder(reinterpret_cast<PyObject*>(new_message));
   new_message->child_submessages = new CMessage::SubMessagesMap();
   new_message->composite_fields = new CMessage::CompositeFieldsMap();
@@ -1714,7 +1824,19 @@ static PyObject* InternalSerializeToString(
   if (deterministic_obj != Py_None) {
     coded_out.SetSerializationDeterministic(deterministic);
   }
-  self->message->SerializeWithCachedSizes(&coded_out);
+  CMessage* root = GetRoot(self);
+  if (root != nullptr && size >= kMinSizeToReleaseGil) {
+    root->gil_free_readers.fetch_add(1, std::memory_order_relaxed);
+    Py_BEGIN_ALLOW_THREADS
+    self->message->SerializeWithCachedSizes(&coded_out);
+    {
+      absl::MutexLock lock(&gil_free_mutex);
+      root->gil_free_readers.fetch_sub(1, std::memory_order_release);
+    }
+    Py_END_ALLOW_THREADS
+  } else {
+    self->message->SerializeWithCachedSizes(&coded_out);
+  }
   ABSL_CHECK(!coded_out.HadError());
   return result;
 }
@@ -1873,7 +1995,62 @@ PyObject* SetAllowOversizeProtos(PyObject* m, PyObject* arg) {
   }
 }
 
-static PyObject* MergeFromString(CMessage* self, PyObject* arg) {
+static const char kArenaCapsuleName[] = "google.protobuf.pyext._message.Arena";
+
+// Parsing into an arena is faster than allocating every submessage, string
+// and repeated field on the heap, and freeing them one by one, but the arena
+// is not worth its own allocations for small messages.
+static constexpr Py_ssize_t kMinArenaParseSize = 4096;
+
+static void DeleteArena(PyObject* capsule) {
+  delete static_cast<Arena*>(PyCapsule_GetPointer(capsule, kArenaCapsuleName));
+}
+
+PyObject* GetArenaOwner(CMessage* self) {
+  CMessage* root = GetRoot(self);
+  return root != nullptr ? root->arena : nullptr;
+}
+
+// Before `serialized` is parsed into a message that was just cleared, moves
+// its C++ message to a new arena if the input is large enough, and if nothing
+// else points into the message.
+static int MaybeMoveToArena(CMessage* self, PyObject* serialized) {
+  if (self->parent != nullptr || self->unknown_field_set != nullptr ||
+      (self->composite_fields && !self->composite_fields->empty()) ||
+      (self->child_submessages && !self->child_submessages->empty())) {
+    return 0;
+  }
+  // Released messages may still use the current arena.
+  if (self->arena != nullptr && Py_REFCNT(self->arena) > 1) {
+    return 0;
+  }
+  Py_ssize_t size = PyObject_Length(serialized);
+  if (size < kMinArenaParseSize) {
+    PyErr_Clear();
+    return 0;
+  }
+
+  Arena* arena = new Arena();
+  PyObject* arena_owner = PyCapsule_New(arena, kArenaCapsuleName, DeleteArena);
+  if (arena_owner == nullptr) {
+    delete arena;
+    return -1;
+  }
+  Message* message = self->message->New(arena);
+  if (self->arena != nullptr) {
+    Py_DECREF(self->arena);
+  } else {
+    delete self->message;
+  }
+  self->message = message;
+  self->arena = arena_owner;
+  return 0;
+}
+
+// Parses arg into self.  With release_gil, the C++ parse runs without the
+// GIL, which is only safe if no other thread can reach self or change arg.
+static PyObject* InternalMergeFromString(CMessage* self, PyObject* arg,
+                                         bool release_gil) {
   Py_buffer data;
   if (PyObject_GetBuffer(arg, &data, PyBUF_SIMPLE) < 0) {
     return nullptr;
@@ -1893,7 +2070,13 @@ static PyObject* MergeFromString(CMessage* self, PyObject* arg) {
   ctx.data().pool = factory->pool->pool;
   ctx.data().factory = factory->message_factory;
 
-  ptr = self->message->_InternalParse(ptr, &ctx);
+  if (release_gil) {
+    Py_BEGIN_ALLOW_THREADS
+    ptr = self->message->_InternalParse(ptr, &ctx);
+    Py_END_ALLOW_THREADS
+  } else {
+    ptr = self->message->_InternalParse(ptr, &ctx);
+  }
 
   // Child message might be lazily created before MergeFrom. Make sure they
   // are mutable at this point if child messages are really created.
@@ -1932,10 +2115,17 @@ static PyObject* MergeFromString(CMessage* self, PyObject* arg) {
   return PyLong_FromLong(data.len);
 }
 
+static PyObject* MergeFromString(CMessage* self, PyObject* arg) {
+  return InternalMergeFromString(self, arg, /*release_gil=*/false);
+}
+
 static PyObject* ParseFromString(CMessage* self, PyObject* arg) {
   if (ScopedPyObjectPtr(Clear(self)) == nullptr) {
     return nullptr;
   }
+  if (MaybeMoveToArena(self, arg) < 0) {
+    return nullptr;
+  }
   return MergeFromString(self, arg);
 }
 
@@ -2348,7 +2538,18 @@ PyObject* FromString(PyTypeObject* cls, PyObject* serialized) {
   }
   CMessage* cmsg = reinterpret_cast<CMessage*>(py_cmsg);
 
-  ScopedPyObjectPtr py_length(MergeFromString(cmsg, serialized));
+  if (MaybeMoveToArena(cmsg, serialized) < 0) {
+    Py_DECREF(py_cmsg);
+    return nullptr;
+  }
+  // Nothing else can reach the new message, nor change an immutable bytes
+  // object, so a large input is parsed without the GIL.
+  bool release_gil = Py_REFCNT(py_cmsg) == 1 &&
+                     PyBytes_CheckExact(serialized) &&
+                     static_cast<size_t>(PyBytes_GET_SIZE(serialized)) >=
+                         kMinSizeToReleaseGil;
+  ScopedPyObjectPtr py_length(
+      InternalMergeFromString(cmsg, serialized, release_gil));
   if (py_length == nullptr) {
     Py_DECREF(py_cmsg);
     return nullptr;
@@ -2357,6 +2558,156 @@ PyObject* FromString(PyTypeObject* cls, PyObject* serialized) {
   return py_cmsg;
 }
 
+// Parses one message of a batch, with or without the GIL.
+static bool ParseOneOfMany(Message* message, const Py_buffer& data,
+                           PyMessageFactory* factory) {
+  int depth = allow_oversize_protos
+                  ? INT_MAX
+                  : io::CodedInputStream::GetDefaultRecursionLimit();
+  const char* ptr;
+  internal::ParseContext ctx(
+      depth, false, &ptr,
+      absl::string_view(static_cast<const char*>(data.buf), data.len));
+  ctx.data().pool = factory->pool->pool;
+  ctx.data().factory = factory->message_factory;
+  ptr = message->_InternalParse(ptr, &ctx);
+  return ptr != nullptr && ctx.EndedAtLimit();
+}
+
+PyObject* FromStrings(PyTypeObject* cls, PyObject* args, PyObject* kwargs) {
+  static const char* kwlist[] = {"serialized", "num_threads", nullptr};
+  PyObject* serialized;
+  int num_threads = 1;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|i",
+                                   const_cast<char**>(kwlist), &serialized,
+                                   &num_threads)) {
+    return nullptr;
+  }
+  CMessageClass* type = CheckMessageClass(cls);
+  if (type == nullptr) {
+    return nullptr;
+  }
+  ScopedPyObjectPtr items(
+      PySequence_Fast(serialized, "FromStrings() expects a sequence"));
+  if (items == nullptr) {
+    return nullptr;
+  }
+  const Py_ssize_t count = PySequence_Fast_GET_SIZE(items.get());
+  PyObject** item_array = PySequence_Fast_ITEMS(items.get());
+
+  // A class with its own __init__ needs each message built by calling it.
+  if (cls->tp_init != reinterpret_cast<initproc>(Init)) {
+    ScopedPyObjectPtr result(PyList_New(count));
+    if (result == nullptr) {
+      return nullptr;
+    }
+    for (Py_ssize_t i = 0; i < count; ++i) {
+      PyObject* message = FromString(cls, item_array[i]);
+      if (message == nullptr) {
+        return nullptr;
+      }
+      PyList_SET_ITEM(result.get(), i, message);
+    }
+    return result.release();
+  }
+
+  const Message* prototype =
+      type->py_message_factory->message_factory->GetPrototype(
+          type->message_descriptor);
+  if (prototype == nullptr) {
+    PyErr_SetString(PyExc_TypeError,
+                    type->message_descriptor->full_name().c_str());
+    return nullptr;
+  }
+
+  std::vector<Py_buffer> buffers;
+  buffers.reserve(count);
+  auto release_buffers = [&buffers] {
+    for (Py_buffer& buffer : buffers) {
+      PyBuffer_Release(&buffer);
+    }
+  };
+  // The GIL is only released if no other thread can change the inputs.
+  bool release_gil = true;
+  for (Py_ssize_t i = 0; i < count; ++i) {
+    Py_buffer buffer;
+    if (PyObject_GetBuffer(item_array[i], &buffer, PyBUF_SIMPLE) < 0) {
+      release_buffers();
+      return nullptr;
+    }
+    buffers.push_back(buffer);
+    release_gil = release_gil && PyBytes_CheckExact(item_array[i]);
+  }
+
+  // All messages share one arena, which lives as long as any of them.
+  Arena* arena = new Arena();
+  ScopedPyObjectPtr arena_owner(
+      PyCapsule_New(arena, kArenaCapsuleName, DeleteArena));
+  if (arena_owner == nullptr) {
+    delete arena;
+    release_buffers();
+    return nullptr;
+  }
+  std::vector<Message*> messages(count);
+  for (Py_ssize_t i = 0; i < count; ++i) {
+    messages[i] = prototype->New(arena);
+  }
+
+  // Index of the first input that fails to parse, or count.
+  std::atomic<Py_ssize_t> first_error(count);
+  std::atomic<Py_ssize_t> next(0);
+  PyMessageFactory* factory = type->py_message_factory;
+  auto parse_all = [&] {
+    for (Py_ssize_t i = next++; i < count; i = next++) {
+      if (!ParseOneOfMany(messages[i], buffers[i], factory)) {
+        Py_ssize_t expected = first_error.load();
+        while (i < expected &&
+               !first_error.compare_exchange_weak(expected, i)) {
+        }
+      }
+    }
+  };
+  if (release_gil) {
+    Py_BEGIN_ALLOW_THREADS
+    std::vector<std::thread> threads;
+    for (Py_ssize_t i = 1; i < std::min<Py_ssize_t>(num_threads, count); ++i) {
+      threads.emplace_back(parse_all);
+    }
+    parse_all();
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    Py_END_ALLOW_THREADS
+  } else {
+    parse_all();
+  }
+  release_buffers();
+
+  if (first_error.load() < count) {
+    PyErr_Format(DecodeError_class,
+                 "Error parsing message with type '%s' at index %zd",
+                 type->message_descriptor->full_name().c_str(),
+                 first_error.load());
+    return nullptr;
+  }
+
+  ScopedPyObjectPtr result(PyList_New(count));
+  if (result == nullptr) {
+    return nullptr;
+  }
+  for (Py_ssize_t i = 0; i < count; ++i) {
+    CMessage* cmsg = NewEmptyMessage(type);
+    if (cmsg == nullptr) {
+      return nullptr;
+    }
+    cmsg->message = messages[i];
+    Py_INCREF(arena_owner.get());
+    cmsg->arena = arena_owner.get();
+    PyList_SET_ITEM(result.get(), i, cmsg->AsPyObject());
+  }
+  return result.release();
+}
+
 PyObject* DeepCopy(CMessage* self, PyObject* arg) {
   PyObject* clone =
       PyObject_CallObject(reinterpret_cast<PyObject*>(Py_TYPE(self)), nullptr);
@@ -2477,6 +2828,10 @@ static PyMethodDef Methods[] = {
      METH_NOARGS, "Finds unset required fields."},
     {"FromString", (PyCFunction)FromString, METH_O | METH_CLASS,
      "Creates new method instance from given serialized data."},
+    {"FromStrings", (PyCFunction)FromStrings,
+     METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+     "Creates new message instances from a sequence of serialized data, "
+     "parsed on up to num_threads threads into an arena they share."},
     {"HasExtension", (PyCFunction)HasExtension, METH_O,
      "Checks if a message field is set."},
     {"HasField", (PyCFunction)HasField, METH_O,
@@ -2651,7 +3006,11 @@ int SetFieldValue(CMessage* self, const FieldDescriptor* field_descriptor,
 PyObject* ContainerBase::DeepCopy() {
   CMessage* new_parent =
       cmessage::NewEmptyMessage(this->parent->GetMessageClass());
-  new_parent->message = this->parent->message->New(nullptr);
+  PyObject* arena_owner = cmessage::GetArenaOwner(this->parent);
+  new_parent->message = this->parent->message->New(
+      arena_owner ? this->parent->message->GetArena() : nullptr);
+  Py_XINCREF(arena_owner);
+  new_parent->arena = arena_owner;
 
   // Copy the map field into the new message.
   this->parent->message->GetReflection()->SwapFields(
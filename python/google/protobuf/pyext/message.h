@@ -37,6 +37,7 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -130,6 +131,16 @@ typedef struct CMessage : public ContainerBase {
   // Implements the "weakref" protocol for this object.
   PyObject* weakreflist;
 
+  // For a message without a parent, an owned reference to the capsule of the
+  // Arena its C++ message lives on, or NULL if it is on the heap.  Messages
+  // released from it share the reference, so the arena lives as long as the
+  // last of them.
+  PyObject* arena;
+
+  // For a message without a parent, the number of threads serializing it with
+  // the GIL released.  Modifications anywhere in its tree wait for them.
+  std::atomic<int> gil_free_readers;
+
   // Return a *borrowed* reference to the message class.
   CMessageClass* GetMessageClass() {
     return reinterpret_cast<CMessageClass*>(Py_TYPE(this));
@@ -191,6 +202,10 @@ const FieldDescriptor* GetExtensionDescriptor(PyObject* extension);
 CMessage* InternalGetSubMessage(
     CMessage* self, const FieldDescriptor* field_descriptor);
 
+// Returns a borrowed reference to the capsule of the arena that the C++
+// message of self lives on, or NULL if it is on the heap or owned externally.
+PyObject* GetArenaOwner(CMessage* self);
+
 // Deletes a range of items in a repeated field (following a
 // removal in a RepeatedCompositeContainer).
 //
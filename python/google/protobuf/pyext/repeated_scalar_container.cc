@@ -33,7 +33,9 @@
 
 #include "google/protobuf/pyext/repeated_scalar_container.h"
 
+#include <climits>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 
@@ -45,6 +47,7 @@
 #include "google/protobuf/pyext/descriptor_pool.h"
 #include "google/protobuf/pyext/message.h"
 #include "google/protobuf/pyext/scoped_pyobject_ptr.h"
+#include "google/protobuf/repeated_field.h"
 
 #define PyString_AsString(ob) \
   (PyUnicode_Check(ob) ? PyUnicode_AsUTF8(ob) : PyBytes_AsString(ob))
@@ -53,10 +56,198 @@ namespace google {
 namespace protobuf {
 namespace python {
 
+// Gives the buffer protocol direct access to the RepeatedField behind a
+// repeated numeric field.
+class RepeatedScalarReflectionFriend {
+ public:
+  static const void* GetRawRepeatedField(const Message& message,
+                                         const FieldDescriptor* field) {
+    return message.GetReflection()->GetRawRepeatedField(
+        message, field, field->cpp_type(), -1, nullptr);
+  }
+  static void* MutableRawRepeatedField(Message* message,
+                                       const FieldDescriptor* field) {
+    return message->GetReflection()->MutableRawRepeatedField(
+        message, field, field->cpp_type(), -1, nullptr);
+  }
+};
+
 namespace repeated_scalar_container {
 
+// Returns the struct module format of the elements of a repeated numeric
+// field, or nullptr for a string field.
+static const char* BufferFormat(const FieldDescriptor* field_descriptor) {
+  switch (field_descriptor->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return "i";
+    case FieldDescriptor::CPPTYPE_INT64:
+      return "q";
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return "I";
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return "Q";
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return "f";
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return "d";
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return "?";
+    default:
+      return nullptr;
+  }
+}
+
+static Py_ssize_t BufferItemSize(const FieldDescriptor* field_descriptor) {
+  switch (field_descriptor->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_ENUM:
+    case FieldDescriptor::CPPTYPE_UINT32:
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return 4;
+    case FieldDescriptor::CPPTYPE_INT64:
+    case FieldDescriptor::CPPTYPE_UINT64:
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return 8;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return sizeof(bool);
+    default:
+      return 0;
+  }
+}
+
+template <typename T>
+static const void* FieldData(const void* raw_field) {
+  return static_cast<const RepeatedField<T>*>(raw_field)->data();
+}
+
+// Returns the elements of a non-empty repeated numeric field.
+static const void* FieldData(const Message& message,
+                             const FieldDescriptor* field_descriptor) {
+  const void* raw_field = RepeatedScalarReflectionFriend::GetRawRepeatedField(
+      message, field_descriptor);
+  switch (field_descriptor->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return FieldData<int32_t>(raw_field);
+    case FieldDescriptor::CPPTYPE_INT64:
+      return FieldData<int64_t>(raw_field);
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return FieldData<uint32_t>(raw_field);
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return FieldData<uint64_t>(raw_field);
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return FieldData<float>(raw_field);
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return FieldData<double>(raw_field);
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return FieldData<bool>(raw_field);
+    default:
+      return nullptr;
+  }
+}
+
+template <typename T>
+static void AddElements(Message* message,
+                        const FieldDescriptor* field_descriptor,
+                        const void* data, int count) {
+  RepeatedField<T>* field = static_cast<RepeatedField<T>*>(
+      RepeatedScalarReflectionFriend::MutableRawRepeatedField(
+          message, field_descriptor));
+  field->Reserve(field->size() + count);
+  memcpy(field->AddNAlreadyReserved(count), data, count * sizeof(T));
+}
+
+static void AddElements(Message* message,
+                        const FieldDescriptor* field_descriptor,
+                        const void* data, int count) {
+  switch (field_descriptor->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_ENUM:
+      AddElements<int32_t>(message, field_descriptor, data, count);
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      AddElements<int64_t>(message, field_descriptor, data, count);
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      AddElements<uint32_t>(message, field_descriptor, data, count);
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      AddElements<uint64_t>(message, field_descriptor, data, count);
+      break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      AddElements<float>(message, field_descriptor, data, count);
+      break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      AddElements<double>(message, field_descriptor, data, count);
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      AddElements<bool>(message, field_descriptor, data, count);
+      break;
+    default:
+      break;
+  }
+}
+
+// Returns true if the buffer holds exactly the C type of the field, so that
+// its contents can be copied in without converting each element.
+static bool BufferMatchesField(const Py_buffer& view,
+                               const FieldDescriptor* field_descriptor) {
+  const char* format = view.format;
+  if (format == nullptr || view.ndim != 1 ||
+      view.itemsize != BufferItemSize(field_descriptor)) {
+    return false;
+  }
+  if (*format == '@' || *format == '=') ++format;
+  if (format[0] == '\0' || format[1] != '\0') return false;
+
+  // Closed enums must check every value.
+  if (field_descriptor->cpp_type() == FieldDescriptor::CPPTYPE_ENUM &&
+      field_descriptor->legacy_enum_field_treated_as_closed()) {
+    return false;
+  }
+
+  const char* kinds;
+  switch (field_descriptor->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_ENUM:
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_INT64:
+      kinds = "bhilqn";
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+    case FieldDescriptor::CPPTYPE_UINT64:
+      kinds = "BHILQN";
+      break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      kinds = "fd";
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      kinds = "?";
+      break;
+    default:
+      return false;
+  }
+  return strchr(kinds, format[0]) != nullptr;
+}
+
+// Fails with a BufferError if buffer views of the field are alive, since
+// modifying it could move the memory they point to.
+static bool CheckNotExported(RepeatedScalarContainer* self) {
+  if (self->buffer_exports == 0) {
+    return true;
+  }
+  PyErr_SetString(PyExc_BufferError,
+                  "Existing exports of data: repeated field cannot be "
+                  "modified");
+  return false;
+}
+
 static int InternalAssignRepeatedField(RepeatedScalarContainer* self,
                                        PyObject* list) {
+  if (!CheckNotExported(self)) {
+    return -1;
+  }
   Message* message = self->parent->message;
   message->GetReflection()->ClearField(message, self->parent_field_descriptor);
   for (Py_ssize_t i = 0; i < PyList_GET_SIZE(list); ++i) {
@@ -80,6 +271,9 @@ static int AssignItem(PyObject* pself, Py_ssize_t index, PyObject* arg) {
   RepeatedScalarContainer* self =
       reinterpret_cast<RepeatedScalarContainer*>(pself);
 
+  if (!CheckNotExported(self)) {
+    return -1;
+  }
   cmessage::AssureWritable(self->parent);
   Message* message = self->parent->message;
   const FieldDescriptor* field_descriptor = self->parent_field_descriptor;
@@ -326,6 +520,9 @@ static PyObject* Subscript(PyObject* pself, PyObject* slice) {
 }
 
 PyObject* Append(RepeatedScalarContainer* self, PyObject* item) {
+  if (!CheckNotExported(self)) {
+    return nullptr;
+  }
   cmessage::AssureWritable(self->parent);
   Message* message = self->parent->message;
   const FieldDescriptor* field_descriptor = self->parent_field_descriptor;
@@ -420,6 +617,9 @@ static int AssSubscript(PyObject* pself, PyObject* slice, PyObject* value) {
   Py_ssize_t slicelength;
   bool create_list = false;
 
+  if (!CheckNotExported(self)) {
+    return -1;
+  }
   cmessage::AssureWritable(self->parent);
   Message* message = self->parent->message;
   const FieldDescriptor* field_descriptor = self->parent_field_descriptor;
@@ -462,7 +662,47 @@ static int AssSubscript(PyObject* pself, PyObject* slice, PyObject* value) {
   return InternalAssignRepeatedField(self, new_list.get());
 }
 
+// Appends the contents of `value` with a single copy if it is a contiguous
+// buffer of the field's C type.  Returns 1 if it did, 0 if `value` must be
+// iterated over instead, or -1 with an exception set.
+static int ExtendFromBuffer(RepeatedScalarContainer* self, PyObject* value) {
+  const FieldDescriptor* field_descriptor = self->parent_field_descriptor;
+  // Another container may be a view of this very field, which the copy
+  // could move.
+  if (BufferFormat(field_descriptor) == nullptr ||
+      PyObject_TypeCheck(value, &RepeatedScalarContainer_Type)) {
+    return 0;
+  }
+  Py_buffer view;
+  if (PyObject_GetBuffer(value, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) <
+      0) {
+    PyErr_Clear();
+    return 0;
+  }
+  int result = 0;
+  if (BufferMatchesField(view, field_descriptor)) {
+    Message* message = self->parent->message;
+    Py_ssize_t count = view.len / view.itemsize;
+    if (count > INT_MAX - message->GetReflection()->FieldSize(
+                              *message, field_descriptor)) {
+      PyErr_SetString(PyExc_OverflowError, "Repeated field is too large");
+      result = -1;
+    } else {
+      if (count > 0) {
+        AddElements(message, field_descriptor, view.buf,
+                    static_cast<int>(count));
+      }
+      result = 1;
+    }
+  }
+  PyBuffer_Release(&view);
+  return result;
+}
+
 PyObject* Extend(RepeatedScalarContainer* self, PyObject* value) {
+  if (!CheckNotExported(self)) {
+    return nullptr;
+  }
   cmessage::AssureWritable(self->parent);
 
   // TODO(ptucker): Deprecate this behavior. b/18413862
@@ -473,6 +713,16 @@ PyObject* Extend(RepeatedScalarContainer* self, PyObject* value) {
     Py_RETURN_NONE;
   }
 
+  if (PyObject_CheckBuffer(value)) {
+    int copied = ExtendFromBuffer(self, value);
+    if (copied < 0) {
+      return nullptr;
+    }
+    if (copied > 0) {
+      Py_RETURN_NONE;
+    }
+  }
+
   ScopedPyObjectPtr iter(PyObject_GetIter(value));
   if (iter == nullptr) {
     PyErr_SetString(PyExc_TypeError, "Value must be iterable");
@@ -678,6 +928,56 @@ RepeatedScalarContainer* NewContainer(
   return self;
 }
 
+// Exports a read-only view of a repeated numeric field, without copying.
+static int GetBuffer(PyObject* pself, Py_buffer* view, int flags) {
+  RepeatedScalarContainer* self =
+      reinterpret_cast<RepeatedScalarContainer*>(pself);
+  const FieldDescriptor* field_descriptor = self->parent_field_descriptor;
+  const char* format = BufferFormat(field_descriptor);
+  if (format == nullptr) {
+    PyErr_SetString(PyExc_BufferError,
+                    "Only repeated numeric fields support the buffer "
+                    "protocol");
+    view->obj = nullptr;
+    return -1;
+  }
+  if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+    PyErr_SetString(PyExc_BufferError, "Repeated field buffers are read-only");
+    view->obj = nullptr;
+    return -1;
+  }
+
+  static const int64_t kEmpty = 0;
+  Message* message = self->parent->message;
+  Py_ssize_t size = Len(pself);
+  Py_ssize_t* shape = new Py_ssize_t(size);
+
+  view->buf = const_cast<void*>(
+      size == 0 ? &kEmpty : FieldData(*message, field_descriptor));
+  view->obj = pself;
+  Py_INCREF(pself);
+  view->itemsize = BufferItemSize(field_descriptor);
+  view->len = size * view->itemsize;
+  view->readonly = 1;
+  view->format =
+      (flags & PyBUF_FORMAT) == PyBUF_FORMAT ? const_cast<char*>(format)
+                                             : nullptr;
+  view->ndim = 1;
+  view->shape = (flags & PyBUF_ND) == PyBUF_ND ? shape : nullptr;
+  view->strides =
+      (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &view->itemsize : nullptr;
+  view->suboffsets = nullptr;
+  view->internal = shape;
+
+  ++self->buffer_exports;
+  return 0;
+}
+
+static void ReleaseBuffer(PyObject* pself, Py_buffer* view) {
+  delete static_cast<Py_ssize_t*>(view->internal);
+  --reinterpret_cast<RepeatedScalarContainer*>(pself)->buffer_exports;
+}
+
 PyObject* DeepCopy(PyObject* pself, PyObject* arg) {
   return reinterpret_cast<RepeatedScalarContainer*>(pself)->DeepCopy();
 }
@@ -702,6 +1002,11 @@ static PyMappingMethods MpMethods = {
     AssSubscript, /* mp_ass_subscript */
 };
 
+static PyBufferProcs BufferProcs = {
+    GetBuffer,     /* bf_getbuffer */
+    ReleaseBuffer, /* bf_releasebuffer */
+};
+
 static PyMethodDef Methods[] = {
     {"__deepcopy__", DeepCopy, METH_VARARGS, "Makes a deep copy of the class."},
     {"__reduce__", Reduce, METH_NOARGS,
@@ -749,7 +1054,7 @@ PyTypeObject RepeatedScalarContainer_Type = {
     nullptr,                                //  tp_str
     nullptr,                                //  tp_getattro
     nullptr,                                //  tp_setattro
-    nullptr,                                //  tp_as_buffer
+    &repeated_scalar_container::BufferProcs,  //  tp_as_buffer
 #if PY_VERSION_HEX >= 0x030A0000
     Py_TPFLAGS_DEFAULT | Py_TPFLAGS_SEQUENCE,  //  tp_flags
 #else
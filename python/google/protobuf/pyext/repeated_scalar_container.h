@@ -45,6 +45,9 @@ namespace protobuf {
 namespace python {
 
 typedef struct RepeatedScalarContainer : public ContainerBase {
+  // The number of live buffer views over the field, for numeric fields.  The
+  // container refuses to modify the field while there are any.
+  Py_ssize_t buffer_exports;
 } RepeatedScalarContainer;
 
 extern PyTypeObject RepeatedScalarContainer_Type;
@@ -62,7 +65,9 @@ extern RepeatedScalarContainer* NewContainer(
 // unsuccessful.
 PyObject* Append(RepeatedScalarContainer* self, PyObject* item);
 
-// Appends all the elements in the input iterator to the container.
+// Appends all the elements in the input iterator to the container.  A
+// contiguous buffer of the field's exact C type, such as a NumPy array or an
+// array.array, is copied in with a single memcpy.
 //
 // Returns None if successful; returns NULL and sets an exception if
 // unsuccessful.
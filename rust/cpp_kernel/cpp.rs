@@ -38,9 +38,23 @@ use std::fmt;
 use std::marker::PhantomData;
 use std::mem::MaybeUninit;
 use std::ops::Deref;
+use std::ptr;
 use std::ptr::NonNull;
 use std::slice;
 
+/// Alignment of the memory returned by [`Arena::alloc()`]. See
+/// `__pb_rust_Arena_alloc` in `cpp_api.cc`.
+const ARENA_ALIGN: usize = 8;
+
+/// A C++-managed pointer to a raw `proto2::Arena`.
+pub type RawArena = NonNull<RawArenaData>;
+
+/// The data behind a [`RawArena`]. Do not use this type.
+#[repr(C)]
+pub struct RawArenaData {
+    _data: [u8; 0],
+}
+
 /// A wrapper over a `proto2::Arena`.
 ///
 /// This is not a safe wrapper per se, because the allocation functions still
@@ -51,50 +65,70 @@ use std::slice;
 ///
 /// Note that this type is neither `Sync` nor `Send`.
 pub struct Arena {
-    ptr: NonNull<u8>,
+    raw: RawArena,
     _not_sync: PhantomData<UnsafeCell<()>>,
 }
 
+// Defined in `cpp_api.cc`.
+extern "C" {
+    fn __pb_rust_Arena_new() -> RawArena;
+    fn __pb_rust_Arena_delete(arena: RawArena);
+    fn __pb_rust_Arena_alloc(arena: RawArena, size: usize) -> *mut u8;
+}
+
 impl Arena {
     /// Allocates a fresh arena.
     #[inline]
     pub fn new() -> Self {
-        Self { ptr: NonNull::dangling(), _not_sync: PhantomData }
+        Self { raw: unsafe { __pb_rust_Arena_new() }, _not_sync: PhantomData }
     }
 
     /// Returns the raw, C++-managed pointer to the arena.
     #[inline]
-    pub fn raw(&self) -> ! {
-        unimplemented!()
+    pub fn raw(&self) -> RawArena {
+        self.raw
     }
 
     /// Allocates some memory on the arena.
     ///
     /// # Safety
     ///
-    /// `layout`'s alignment must be less than `UPB_MALLOC_ALIGN`.
+    /// `layout`'s alignment must be less than `ARENA_ALIGN`.
     #[inline]
     pub unsafe fn alloc(&self, layout: Layout) -> &mut [MaybeUninit<u8>] {
-        unimplemented!()
+        debug_assert!(layout.align() <= ARENA_ALIGN);
+        let ptr = __pb_rust_Arena_alloc(self.raw, layout.size());
+        if ptr.is_null() {
+            alloc::handle_alloc_error(layout);
+        }
+
+        slice::from_raw_parts_mut(ptr.cast(), layout.size())
     }
 
     /// Resizes some memory on the arena.
     ///
+    /// C++ arenas can't grow an allocation in place, so this allocates anew
+    /// and copies the old contents; the old memory is freed with the arena.
+    ///
     /// # Safety
     ///
     /// After calling this function, `ptr` is essentially zapped. `old` must
     /// be the layout `ptr` was allocated with via [`Arena::alloc()`]. `new`'s
-    /// alignment must be less than `UPB_MALLOC_ALIGN`.
+    /// alignment must be less than `ARENA_ALIGN`.
     #[inline]
     pub unsafe fn resize(&self, ptr: *mut u8, old: Layout, new: Layout) -> &[MaybeUninit<u8>] {
-        unimplemented!()
+        let resized = self.alloc(new);
+        ptr::copy_nonoverlapping(ptr, resized.as_mut_ptr().cast(), old.size().min(new.size()));
+        resized
     }
 }
 
 impl Drop for Arena {
     #[inline]
     fn drop(&mut self) {
-        // unimplemented
+        unsafe {
+            __pb_rust_Arena_delete(self.raw);
+        }
     }
 }
 
@@ -155,6 +189,28 @@ mod tests {
         (content.as_mut_ptr(), content.len())
     }
 
+    #[test]
+    fn test_arena_new_and_free() {
+        let arena = Arena::new();
+        drop(arena);
+    }
+
+    #[test]
+    fn test_arena_alloc_and_resize() {
+        let arena = Arena::new();
+        unsafe {
+            let bytes = arena.alloc(Layout::array::<u8>(4).unwrap());
+            bytes.copy_from_slice(&[MaybeUninit::new(7); 4]);
+            let resized = arena.resize(
+                bytes.as_mut_ptr().cast(),
+                Layout::array::<u8>(4).unwrap(),
+                Layout::array::<u8>(16).unwrap(),
+            );
+            assert_eq!(resized.len(), 16);
+            assert_eq!(resized[3].assume_init(), 7);
+        }
+    }
+
     #[test]
     fn test_serialized_data_roundtrip() {
         let (ptr, len) = allocate_byte_array(b"Hello world");
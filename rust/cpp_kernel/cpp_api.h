@@ -34,7 +34,9 @@
 #define GOOGLE_PROTOBUF_RUST_CPP_KERNEL_CPP_H__
 
 #include <cstddef>
+#include <cstdint>
 
+#include "google/protobuf/arena.h"
 #include "google/protobuf/message.h"
 
 namespace google {
@@ -65,12 +67,23 @@ extern "C" void* __pb_rust_alloc(size_t size, size_t align);
 inline SerializedData SerializeMsg(const google::protobuf::Message* msg) {
   size_t len = msg->ByteSizeLong();
   void* bytes = __pb_rust_alloc(len, alignof(char));
-  if (!msg->SerializeToArray(bytes, static_cast<int>(len))) {
-    ABSL_LOG(FATAL) << "Couldn't serialize the message.";
-  }
+  // ByteSizeLong() just cached the sizes, so don't compute them again.
+  msg->SerializeWithCachedSizesToArray(static_cast<uint8_t*>(bytes));
   return SerializedData(static_cast<char*>(bytes), len);
 }
 
+// Serializes `msg` into a buffer owned by Rust, which must be exactly as large
+// as the last `msg->ByteSizeLong()`, with no changes to `msg` in between.
+// Returns false, without writing, if `len` doesn't match the cached size.
+inline bool SerializeMsgInto(const google::protobuf::Message* msg, char* data,
+                             size_t len) {
+  if (static_cast<size_t>(msg->GetCachedSize()) != len) {
+    return false;
+  }
+  msg->SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(data));
+  return true;
+}
+
 // Represents an ABI-stable version of &[u8]/string_view (borrowed slice of
 // bytes) for FFI use only.
 struct PtrAndLen {
@@ -81,6 +94,20 @@ struct PtrAndLen {
   PtrAndLen(const char* ptr, size_t len) : ptr(ptr), len(len) {}
 };
 
+// Parses `msg` directly from bytes borrowed from Rust.
+inline bool ParseMsg(google::protobuf::Message* msg, PtrAndLen data) {
+  return msg->ParseFromArray(data.ptr, static_cast<int>(data.len));
+}
+
+// C++ arenas for Rust. `proto2::Arena` is opaque to Rust, which refers to it
+// through `RawArena` and only manages it with these functions.
+//
+// These functions are defined in `cpp_api.cc`.
+extern "C" google::protobuf::Arena* __pb_rust_Arena_new();
+extern "C" void __pb_rust_Arena_delete(google::protobuf::Arena* arena);
+extern "C" void* __pb_rust_Arena_alloc(google::protobuf::Arena* arena,
+                                       size_t size);
+
 }  // namespace rust_internal
 }  // namespace protobuf
 }  // namespace google
@@ -0,0 +1,115 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+//! Measures the per-call cost of the Rust Protobuf API on one kernel. The same
+//! source is built against both kernels, see `BUILD`, so that their numbers
+//! can be compared side by side:
+//!
+//!   bazel run -c opt //rust/test/benchmarks:kernel_benchmark_cpp
+//!   bazel run -c opt //rust/test/benchmarks:kernel_benchmark_upb
+//!
+//! `RustFieldRead` reads a field of a plain Rust struct; the difference
+//! between it and `GetInt64` is what crossing into the kernel costs per call.
+
+use std::hint::black_box;
+use std::time::{Duration, Instant};
+use unittest_proto::proto2_unittest::TestAllTypes;
+
+#[cfg(cpp_kernel)]
+const KERNEL: &str = "cpp";
+#[cfg(upb_kernel)]
+const KERNEL: &str = "upb";
+
+/// Runs `f` in batches of doubling size until a batch takes long enough to be
+/// timed reliably, then prints the time per call.
+fn bench(name: &str, mut f: impl FnMut()) {
+    let mut iterations: u64 = 1;
+    loop {
+        let start = Instant::now();
+        for _ in 0..iterations {
+            f();
+        }
+        let elapsed = start.elapsed();
+        if elapsed >= Duration::from_millis(500) {
+            let nanos = elapsed.as_nanos() as f64 / iterations as f64;
+            println!("{KERNEL}/{name:<16} {nanos:>10.1} ns/call");
+            return;
+        }
+        iterations *= 2;
+    }
+}
+
+struct PlainMessage {
+    optional_int64: i64,
+}
+
+fn main() {
+    let mut msg = TestAllTypes::new();
+    msg.optional_int64_set(Some(42));
+    msg.optional_bool_set(Some(true));
+    msg.optional_bytes_set(Some(&[b'x'; 64]));
+    let serialized = msg.serialize();
+    let serialized: &[u8] = &serialized;
+    let payload: &[u8] = b"payload";
+
+    bench("New", || {
+        black_box(TestAllTypes::new());
+    });
+    // Includes New.
+    bench("Parse", || {
+        let mut parsed = TestAllTypes::new();
+        black_box(parsed.deserialize(black_box(serialized)).is_ok());
+        black_box(parsed);
+    });
+    bench("Serialize", || {
+        black_box(black_box(&msg).serialize());
+    });
+
+    bench("GetInt64", || {
+        black_box(black_box(&msg).optional_int64());
+    });
+    bench("SetInt64", || {
+        black_box(&mut msg).optional_int64_set(black_box(Some(7)));
+    });
+    bench("GetBool", || {
+        black_box(black_box(&msg).optional_bool());
+    });
+    bench("GetBytes", || {
+        black_box(black_box(&msg).optional_bytes());
+    });
+    bench("SetBytes", || {
+        black_box(&mut msg).optional_bytes_set(black_box(Some(payload)));
+    });
+
+    let plain = PlainMessage { optional_int64: 42 };
+    bench("RustFieldRead", || {
+        black_box(black_box(&plain).optional_int64);
+    });
+}
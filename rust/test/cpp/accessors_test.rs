@@ -0,0 +1,94 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2023 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// Tests covering accessors for repeated fields, which only the cpp kernel
+/// supports so far.
+use unittest_proto::proto2_unittest::TestAllTypes;
+
+#[test]
+fn test_repeated_int32_accessors() {
+    let mut msg = TestAllTypes::new();
+    assert!(msg.repeated_int32().is_empty());
+    assert!(msg.repeated_int32_mut().is_empty());
+
+    msg.repeated_int32_push(1);
+    msg.repeated_int32_push(2);
+    msg.repeated_int32_push(3);
+    assert_eq!(msg.repeated_int32(), &[1, 2, 3]);
+
+    msg.repeated_int32_mut()[1] = 42;
+    assert_eq!(msg.repeated_int32(), &[1, 42, 3]);
+
+    msg.repeated_int32_clear();
+    assert!(msg.repeated_int32().is_empty());
+}
+
+#[test]
+fn test_repeated_double_and_bool_accessors() {
+    let mut msg = TestAllTypes::new();
+    msg.repeated_double_push(0.5);
+    msg.repeated_bool_push(true);
+    msg.repeated_bool_push(false);
+    assert_eq!(msg.repeated_double(), &[0.5]);
+    assert_eq!(msg.repeated_bool(), &[true, false]);
+}
+
+#[test]
+fn test_repeated_bytes_accessors() {
+    let mut msg = TestAllTypes::new();
+    assert_eq!(msg.repeated_string_len(), 0);
+    assert_eq!(msg.repeated_string_get(0), None);
+
+    msg.repeated_string_push(b"first");
+    msg.repeated_string_push(b"");
+    msg.repeated_bytes_push(b"\x00\xff");
+    assert_eq!(msg.repeated_string_len(), 2);
+    assert_eq!(msg.repeated_string_get(0).unwrap(), b"first");
+    assert_eq!(msg.repeated_string_get(1).unwrap(), b"");
+    assert_eq!(msg.repeated_string_get(2), None);
+    assert_eq!(msg.repeated_bytes_get(0).unwrap(), b"\x00\xff");
+
+    msg.repeated_string_clear();
+    assert_eq!(msg.repeated_string_len(), 0);
+}
+
+#[test]
+fn test_repeated_fields_survive_serialization() {
+    let mut msg = TestAllTypes::new();
+    msg.repeated_fixed64_push(7);
+    msg.repeated_float_push(1.5);
+    msg.repeated_bytes_push(b"abc");
+
+    let mut msg2 = TestAllTypes::new();
+    msg2.deserialize(&msg.serialize()).unwrap();
+    assert_eq!(msg2.repeated_fixed64(), &[7]);
+    assert_eq!(msg2.repeated_float(), &[1.5]);
+    assert_eq!(msg2.repeated_bytes_get(0).unwrap(), b"abc");
+}
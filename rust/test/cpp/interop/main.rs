@@ -115,3 +115,34 @@ fn smuggle_extension() {
     };
     assert_eq!(&*bytes, b"smuggled");
 }
+
+#[test]
+fn serialize_into_rust_buffer() {
+    let mut msg1 = TestAllTypes::new();
+    msg1.optional_int64_set(Some(-1));
+    msg1.optional_bytes_set(Some(b"some cool data I guess"));
+
+    let mut buf = b"prefix".to_vec();
+    msg1.serialize_into(&mut buf);
+    assert_eq!(&buf[..6], b"prefix");
+    assert_eq!(&buf[6..], &*msg1.serialize());
+
+    let mut msg2 = TestAllTypes::new();
+    msg2.deserialize(&buf[6..]).unwrap();
+    proto_assert_eq!(msg1, msg2);
+}
+
+#[test]
+fn message_on_cpp_arena() {
+    let arena = protobuf_cpp::__runtime::Arena::new();
+    let mut msg1 = TestAllTypes::new();
+    msg1.optional_int64_set(Some(42));
+    msg1.optional_bytes_set(Some(b"on an arena"));
+
+    let mut msg2 = unsafe { TestAllTypes::new_on_arena(&arena) };
+    msg2.deserialize(&msg1.serialize()).unwrap();
+    proto_assert_eq!(msg1, msg2);
+
+    drop(msg2);
+    drop(arena);
+}
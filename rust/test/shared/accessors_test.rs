@@ -28,7 +28,7 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
-/// Tests covering accessors for singular bool, int64, and bytes fields.
+/// Tests covering accessors for singular bool, int64, string and bytes fields.
 use unittest_proto::proto2_unittest::TestAllTypes;
 
 #[test]
@@ -66,3 +66,15 @@ fn test_optional_bytes_accessors() {
     msg.optional_bytes_set(None);
     assert_eq!(msg.optional_bytes(), None);
 }
+
+#[test]
+fn test_optional_string_accessors() {
+    let mut msg = TestAllTypes::new();
+    assert_eq!(msg.optional_string(), None);
+
+    msg.optional_string_set(Some(b"accessors_test"));
+    assert_eq!(msg.optional_string().unwrap(), b"accessors_test");
+
+    msg.optional_string_set(None);
+    assert_eq!(msg.optional_string(), None);
+}
@@ -117,6 +117,10 @@ class PROTOBUF_EXPORT AnyMetadata {
   bool InternalPackFrom(Arena* arena, const MessageLite& message,
                         absl::string_view type_url_prefix,
                         absl::string_view type_name);
+  // Sets the type URL for `type_name`, reusing the storage of the current one.
+  // Packing the same type again leaves the type URL untouched.
+  void InternalSetTypeUrl(Arena* arena, absl::string_view type_url_prefix,
+                          absl::string_view type_name);
   bool InternalUnpackTo(absl::string_view type_name,
                         MessageLite* message) const;
   bool InternalIs(absl::string_view type_name) const;
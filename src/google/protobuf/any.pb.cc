@@ -245,6 +245,8 @@ const ::_pbi::TcParseTable<1, 2, 0, 36, 2> Any::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_Any_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // bytes value = 2;
     {::_pbi::TcParser::FastBS1,
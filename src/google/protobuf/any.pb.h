@@ -190,6 +190,11 @@ class PROTOBUF_EXPORT Any final :
   Any* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Any>(arena);
   }
+  Any* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Any* copy = CreateMaybeMessage<Any>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Any& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -56,10 +56,30 @@ const char kTypeGoogleProdComPrefix[] = "type.googleprod.com/";
 bool AnyMetadata::InternalPackFrom(Arena* arena, const MessageLite& message,
                                    absl::string_view type_url_prefix,
                                    absl::string_view type_name) {
-  type_url_->Set(GetTypeUrl(type_name, type_url_prefix), arena);
+  InternalSetTypeUrl(arena, type_url_prefix, type_name);
+  // SerializeToString() reuses the capacity of the previous payload.
   return message.SerializeToString(value_->Mutable(arena));
 }
 
+void AnyMetadata::InternalSetTypeUrl(Arena* arena,
+                                     absl::string_view type_url_prefix,
+                                     absl::string_view type_name) {
+  // Same result as GetTypeUrl(), without the temporary string.
+  absl::string_view separator =
+      !type_url_prefix.empty() && type_url_prefix.back() == '/' ? "" : "/";
+  absl::string_view current = type_url_->Get();
+  if (current.size() ==
+          type_url_prefix.size() + separator.size() + type_name.size() &&
+      absl::StartsWith(current, type_url_prefix) &&
+      absl::EndsWith(current, type_name) &&
+      (separator.empty() || current[type_url_prefix.size()] == '/')) {
+    return;
+  }
+  std::string* type_url = type_url_->Mutable(arena);
+  type_url->clear();
+  absl::StrAppend(type_url, type_url_prefix, separator, type_name);
+}
+
 bool AnyMetadata::InternalUnpackTo(absl::string_view type_name,
                                    MessageLite* message) const {
   if (!InternalIs(type_name)) {
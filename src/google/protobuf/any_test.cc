@@ -145,6 +145,35 @@ TEST(AnyTest, TestIs) {
   EXPECT_FALSE(any.Is<protobuf_unittest::TestAny>());
 }
 
+TEST(AnyTest, RepackReusesStorage) {
+  protobuf_unittest::TestAny payload;
+  payload.set_int32_value(12345);
+  payload.set_text("a payload long enough to live outside of the string");
+
+  Arena arena;
+  auto* any = Arena::CreateMessage<google::protobuf::Any>(&arena);
+  ASSERT_TRUE(any->PackFrom(payload));
+  const char* type_url = any->type_url().data();
+  const char* value = any->value().data();
+
+  // A smaller payload fits in the existing buffer.
+  payload.clear_int32_value();
+  ASSERT_TRUE(any->PackFrom(payload));
+  EXPECT_EQ(type_url, any->type_url().data());
+  EXPECT_EQ(value, any->value().data());
+  EXPECT_EQ("type.googleapis.com/protobuf_unittest.TestAny", any->type_url());
+
+  ASSERT_TRUE(any->PackFrom(payload, "type.myservice.com"));
+  EXPECT_EQ("type.myservice.com/protobuf_unittest.TestAny", any->type_url());
+  ASSERT_TRUE(any->PackFrom(static_cast<const Message&>(payload), ""));
+  EXPECT_EQ("/protobuf_unittest.TestAny", any->type_url());
+
+  payload.Clear();
+  ASSERT_TRUE(any->UnpackTo(&payload));
+  EXPECT_EQ("a payload long enough to live outside of the string",
+            payload.text());
+}
+
 TEST(AnyTest, MoveConstructor) {
   protobuf_unittest::TestAny payload;
   payload.set_int32_value(12345);
@@ -383,6 +383,8 @@ const ::_pbi::TcParseTable<3, 7, 4, 39, 2> Api::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_Api_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // string name = 1;
@@ -460,6 +462,7 @@ const ::_pbi::TcParseTable<3, 7, 4, 39, 2> Api::_table_ = {
   // repeated .google.protobuf.Method methods = 2;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_methods_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_methods(), i);
     const auto& repfield = this->_internal_methods().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(2, repfield, repfield.GetCachedSize(), target, stream);
@@ -468,6 +471,7 @@ const ::_pbi::TcParseTable<3, 7, 4, 39, 2> Api::_table_ = {
   // repeated .google.protobuf.Option options = 3;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_options_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_options(), i);
     const auto& repfield = this->_internal_options().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(3, repfield, repfield.GetCachedSize(), target, stream);
@@ -492,6 +496,7 @@ const ::_pbi::TcParseTable<3, 7, 4, 39, 2> Api::_table_ = {
   // repeated .google.protobuf.Mixin mixins = 6;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_mixins_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_mixins(), i);
     const auto& repfield = this->_internal_mixins().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(6, repfield, repfield.GetCachedSize(), target, stream);
@@ -522,23 +527,26 @@ const ::_pbi::TcParseTable<3, 7, 4, 39, 2> Api::_table_ = {
 
   // repeated .google.protobuf.Method methods = 2;
   total_size += 1UL * this->_internal_methods_size();
-  for (const auto& msg : this->_internal_methods()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_methods_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_methods(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_methods().Get(i));
   }
 
   // repeated .google.protobuf.Option options = 3;
   total_size += 1UL * this->_internal_options_size();
-  for (const auto& msg : this->_internal_options()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_options_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_options(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_options().Get(i));
   }
 
   // repeated .google.protobuf.Mixin mixins = 6;
   total_size += 1UL * this->_internal_mixins_size();
-  for (const auto& msg : this->_internal_mixins()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_mixins_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_mixins(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_mixins().Get(i));
   }
 
   // string name = 1;
@@ -604,6 +612,24 @@ void Api::MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobu
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void Api::MergeFrom(Api&& from) {
+  Api* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_methods()->MergeFrom(
+      std::move(*from._internal_mutable_methods()));
+  _this->_internal_mutable_options()->MergeFrom(
+      std::move(*from._internal_mutable_options()));
+  _this->_internal_mutable_mixins()->MergeFrom(
+      std::move(*from._internal_mutable_mixins()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const Api&>(from));
+}
+
 void Api::CopyFrom(const Api& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.Api)
   if (&from == this) return;
@@ -775,6 +801,8 @@ const ::_pbi::TcParseTable<3, 7, 1, 68, 2> Method::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_Method_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // string name = 1;
@@ -880,6 +908,7 @@ const ::_pbi::TcParseTable<3, 7, 1, 68, 2> Method::_table_ = {
   // repeated .google.protobuf.Option options = 6;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_options_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_options(), i);
     const auto& repfield = this->_internal_options().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(6, repfield, repfield.GetCachedSize(), target, stream);
@@ -910,9 +939,10 @@ const ::_pbi::TcParseTable<3, 7, 1, 68, 2> Method::_table_ = {
 
   // repeated .google.protobuf.Option options = 6;
   total_size += 1UL * this->_internal_options_size();
-  for (const auto& msg : this->_internal_options()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_options_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_options(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_options().Get(i));
   }
 
   // string name = 1;
@@ -989,6 +1019,20 @@ void Method::MergeImpl(::google::protobuf::Message& to_msg, const ::google::prot
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void Method::MergeFrom(Method&& from) {
+  Method* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_options()->MergeFrom(
+      std::move(*from._internal_mutable_options()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const Method&>(from));
+}
+
 void Method::CopyFrom(const Method& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.Method)
   if (&from == this) return;
@@ -1125,6 +1169,8 @@ const ::_pbi::TcParseTable<1, 2, 0, 38, 2> Mixin::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_Mixin_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // string root = 2;
     {::_pbi::TcParser::FastUS1,
@@ -167,6 +167,11 @@ class PROTOBUF_EXPORT Api final :
   Api* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Api>(arena);
   }
+  Api* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Api* copy = CreateMaybeMessage<Api>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Api& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -176,6 +181,7 @@ class PROTOBUF_EXPORT Api final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(Api&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -437,6 +443,11 @@ class PROTOBUF_EXPORT Method final :
   Method* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Method>(arena);
   }
+  Method* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Method* copy = CreateMaybeMessage<Method>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Method& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -446,6 +457,7 @@ class PROTOBUF_EXPORT Method final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(Method&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -691,6 +703,11 @@ class PROTOBUF_EXPORT Mixin final :
   Mixin* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Mixin>(arena);
   }
+  Mixin* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Mixin* copy = CreateMaybeMessage<Mixin>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Mixin& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -43,6 +43,7 @@
 #include "absl/synchronization/mutex.h"
 #include "google/protobuf/arena_allocation_policy.h"
 #include "google/protobuf/arenaz_sampler.h"
+#include "google/protobuf/message_trace.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/serial_arena.h"
 #include "google/protobuf/thread_safe_arena.h"
@@ -52,6 +53,12 @@
 #include <sanitizer/asan_interface.h>
 #endif  // ADDRESS_SANITIZER
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+
 // Must be included last.
 #include "google/protobuf/port_def.inc"
 
@@ -81,27 +88,250 @@ ArenaBlock* SentryArenaBlock() {
 }
 #endif
 
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+// A bounded, per-thread cache of arena blocks. Arenas that opt in through
+// `ArenaOptions::thread_block_cache_size` push their blocks here when they are
+// destroyed or reset, and take blocks from here before falling back to the
+// system allocator. This makes the common pattern of one short-lived arena per
+// request on a worker thread mostly malloc-free.
+//
+// Only blocks whose size is a power of two in [2^kLogMinSize, 2^kLogMaxSize]
+// are cached; these are the natural growth sizes of arena blocks. Blocks are
+// kept in one LIFO list per size so that the most recently freed (and likely
+// still cache-hot) block is reused first.
+//
+// The state is a trivially destructible thread local so that it remains valid
+// while other thread locals (which may own arenas) are destroyed at thread
+// exit. A separate `Reaper` releases cached blocks when the thread exits.
+class ThreadBlockCache {
+ public:
+  // Returns a cached block of exactly `size` bytes, or {nullptr, 0} if there
+  // is none.
+  static SizedPtr Pop(size_t size) {
+    if (!IsCacheableSize(size)) return {nullptr, 0};
+    State& state = state_;
+    Node*& head = state.bins[BinIndex(size)];
+    Node* node = head;
+    if (node == nullptr) return {nullptr, 0};
+    PROTOBUF_UNPOISON_MEMORY_REGION(node, size);
+    head = node->next;
+    state.cached_bytes -= size;
+    return {node, size};
+  }
+
+  // Takes ownership of `mem` if it is of a cacheable size and caching it keeps
+  // this thread's cache within `max_cached_bytes`. Returns false otherwise, in
+  // which case the caller remains responsible for deallocating `mem`.
+  static bool Push(SizedPtr mem, size_t max_cached_bytes) {
+    if (!IsCacheableSize(mem.n)) return false;
+    State& state = state_;
+    if (state.shut_down || mem.n > max_cached_bytes ||
+        state.cached_bytes > max_cached_bytes - mem.n) {
+      return false;
+    }
+    if (PROTOBUF_PREDICT_FALSE(!state.reaper_installed)) {
+      state.reaper_installed = true;
+      InstallReaper();
+    }
+    Node*& head = state.bins[BinIndex(mem.n)];
+    Node* node = new (mem.p) Node{head};
+    head = node;
+    state.cached_bytes += mem.n;
+    PROTOBUF_POISON_MEMORY_REGION(node + 1, mem.n - sizeof(Node));
+    return true;
+  }
+
+ private:
+  static constexpr size_t kLogMinSize = 8;
+  static constexpr size_t kLogMaxSize = 20;
+  static constexpr size_t kNumBins = kLogMaxSize - kLogMinSize + 1;
+
+  struct Node {
+    Node* next;
+  };
+
+  struct State {
+    Node* bins[kNumBins];
+    size_t cached_bytes;
+    bool reaper_installed;
+    // Set once the thread is exiting; blocks freed afterwards are not cached.
+    bool shut_down;
+  };
+
+  // Releases all cached blocks of the current thread on thread exit.
+  struct Reaper {
+    ~Reaper() {
+      State& state = state_;
+      state.shut_down = true;
+      for (size_t i = 0; i < kNumBins; ++i) {
+        const size_t size = size_t{1} << (i + kLogMinSize);
+        while (Node* node = state.bins[i]) {
+          PROTOBUF_UNPOISON_MEMORY_REGION(node, size);
+          state.bins[i] = node->next;
+          internal::SizedDelete(node, size);
+        }
+      }
+      state.cached_bytes = 0;
+    }
+  };
+
+  static void InstallReaper() {
+    static thread_local Reaper reaper;
+    (void)reaper;
+  }
+
+  static bool IsCacheableSize(size_t size) {
+    return absl::has_single_bit(size) && size >= (size_t{1} << kLogMinSize) &&
+           size <= (size_t{1} << kLogMaxSize);
+  }
+
+  static size_t BinIndex(size_t size) {
+    return absl::bit_width(size) - 1 - kLogMinSize;
+  }
+
+  static PROTOBUF_THREAD_LOCAL State state_;
+};
+
+PROTOBUF_CONSTINIT PROTOBUF_THREAD_LOCAL ThreadBlockCache::State
+    ThreadBlockCache::state_{};
+#else   // ABSL_HAVE_THREAD_LOCAL
+class ThreadBlockCache {
+ public:
+  static SizedPtr Pop(size_t) { return {nullptr, 0}; }
+  static bool Push(SizedPtr, size_t) { return false; }
+};
+#endif  // ABSL_HAVE_THREAD_LOCAL
+
+#if defined(__linux__) && defined(SYS_getcpu) && defined(SYS_mbind)
+// Binds the pages fully contained in `mem` to the NUMA node the calling thread
+// is running on, migrating any page that was already touched. We issue the
+// syscalls directly to avoid a dependency on libnuma.
+void BindToLocalNumaNode(SizedPtr mem) {
+  // Values from <linux/mempolicy.h>.
+  constexpr int kMpolPreferred = 1;
+  constexpr unsigned kMpolMfMove = 1 << 1;
+
+  static const uintptr_t page_size =
+      static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t begin = reinterpret_cast<uintptr_t>(mem.p);
+  uintptr_t end = begin + mem.n;
+  begin = (begin + page_size - 1) & ~(page_size - 1);
+  end &= ~(page_size - 1);
+  if (begin >= end) return;
+
+  unsigned cpu, node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return;
+  constexpr unsigned kBitsPerWord = 8 * sizeof(unsigned long);  // NOLINT
+  if (node >= 64 * kBitsPerWord) return;
+  unsigned long nodemask[64] = {};  // NOLINT
+  nodemask[node / kBitsPerWord] = 1UL << (node % kBitsPerWord);
+  // Failure (e.g. no NUMA support in the kernel) just leaves the default
+  // placement in effect.
+  syscall(SYS_mbind, begin, end - begin, kMpolPreferred, nodemask,
+          64 * kBitsPerWord, kMpolMfMove);
+}
+#else   // __linux__ && SYS_getcpu && SYS_mbind
+void BindToLocalNumaNode(SizedPtr) {}
+#endif  // __linux__ && SYS_getcpu && SYS_mbind
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+constexpr bool kHugePageBlocksSupported = true;
+#else
+constexpr bool kHugePageBlocksSupported = false;
+#endif
+
+// Huge page blocks are always a multiple of the (x86-64 and aarch64 default)
+// transparent huge page size.
+constexpr size_t kHugePageSize = size_t{2} << 20;
+
+constexpr size_t RoundUpToHugePage(size_t n) {
+  return (n + kHugePageSize - 1) & ~(kHugePageSize - 1);
+}
+
+// Maps `size` bytes, which must be a multiple of kHugePageSize, aligned to
+// kHugePageSize so that the kernel can back the whole range with huge pages.
+void* AllocateHugePageBlock(size_t size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  ABSL_DCHECK_EQ(size % kHugePageSize, 0u);
+  // Over-allocate so that we can trim the mapping to an aligned range.
+  const size_t mapped = size + kHugePageSize;
+  void* p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ABSL_CHECK(p != MAP_FAILED) << "Failed to map " << mapped << " bytes.";
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(p);
+  const uintptr_t aligned = RoundUpToHugePage(begin);
+  const uintptr_t end = begin + mapped;
+  if (aligned != begin) munmap(p, aligned - begin);
+  if (end != aligned + size) {
+    munmap(reinterpret_cast<void*>(aligned + size), end - aligned - size);
+  }
+  // Failure only means the range stays backed by regular pages.
+  madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+  return reinterpret_cast<void*>(aligned);
+#else
+  (void)size;
+  ABSL_LOG(FATAL) << "Huge page blocks are not supported on this platform.";
+  return nullptr;
+#endif
+}
+
+void FreeHugePageBlock(void* p, size_t size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  munmap(p, size);
+#else
+  (void)p;
+  (void)size;
+#endif
+}
+
 }  // namespace
 
 static SizedPtr AllocateMemory(const AllocationPolicy* policy_ptr,
-                               size_t last_size, size_t min_bytes) {
+                               size_t last_size, size_t min_bytes,
+                               ThreadSafeArenaStats* stats) {
   AllocationPolicy policy;  // default policy
   if (policy_ptr) policy = *policy_ptr;
+  const bool huge_pages =
+      kHugePageBlocksSupported && policy.UsesHugePageBlocks();
   size_t size;
   if (last_size != 0) {
     // Double the current block size, up to a limit.
     auto max_size = policy.max_block_size;
+    if (huge_pages) {
+      max_size = RoundUpToHugePage(std::max(max_size, kHugePageSize));
+    }
     size = std::min(2 * last_size, max_size);
   } else {
     size = policy.start_block_size;
   }
   // Verify that min_bytes + kBlockHeaderSize won't overflow.
   ABSL_CHECK_LE(min_bytes, std::numeric_limits<size_t>::max() -
-                               SerialArena::kBlockHeaderSize);
+                               SerialArena::kBlockHeaderSize - kHugePageSize);
   size = std::max(size, SerialArena::kBlockHeaderSize + min_bytes);
 
+  // In huge page mode every block of at least kHugePageSize is mapped, which
+  // is how GetDeallocator tells them apart from regular blocks.
+  if (huge_pages && size >= kHugePageSize) {
+    size = RoundUpToHugePage(size);
+    ThreadSafeArenaStats::RecordHugePageAllocation(stats, size);
+    SizedPtr mem = {AllocateHugePageBlock(size), size};
+    if (policy.numa_local_blocks) BindToLocalNumaNode(mem);
+    return mem;
+  }
+
   if (policy.block_alloc == nullptr) {
-    return AllocateAtLeast(size);
+    SizedPtr mem = {nullptr, 0};
+    if (policy.UsesThreadBlockCache()) {
+      mem = ThreadBlockCache::Pop(size);
+      if (mem.p != nullptr) {
+        ThreadSafeArenaStats::RecordBlockCacheHit(stats, mem.n);
+      }
+    }
+    if (mem.p == nullptr) mem = AllocateAtLeast(size);
+    // Cached blocks may have been bound to another node by their previous
+    // owner, so they are rebound too.
+    if (policy.numa_local_blocks) BindToLocalNumaNode(mem);
+    return mem;
   }
   return {policy.block_alloc(size), size};
 }
@@ -110,6 +340,11 @@ class GetDeallocator {
  public:
   GetDeallocator(const AllocationPolicy* policy, size_t* space_allocated)
       : dealloc_(policy ? policy->block_dealloc : nullptr),
+        cache_size_(policy && policy->UsesThreadBlockCache()
+                        ? policy->thread_block_cache_size
+                        : 0),
+        huge_pages_(kHugePageBlocksSupported && policy &&
+                    policy->UsesHugePageBlocks()),
         space_allocated_(space_allocated) {}
 
   void operator()(SizedPtr mem) const {
@@ -118,7 +353,11 @@ class GetDeallocator {
     // so return it in an unpoisoned state.
     ASAN_UNPOISON_MEMORY_REGION(mem.p, mem.n);
 #endif  // ADDRESS_SANITIZER
-    if (dealloc_) {
+    if (huge_pages_ && mem.n >= kHugePageSize) {
+      FreeHugePageBlock(mem.p, mem.n);
+    } else if (cache_size_ != 0 && ThreadBlockCache::Push(mem, cache_size_)) {
+      // The block is now owned by the thread-local block cache.
+    } else if (dealloc_) {
       dealloc_(mem.p, mem.n);
     } else {
       internal::SizedDelete(mem.p, mem.n);
@@ -128,6 +367,8 @@ class GetDeallocator {
 
  private:
   void (*dealloc_)(void*, size_t);
+  size_t cache_size_;
+  bool huge_pages_;
   size_t* space_allocated_;
 };
 
@@ -228,13 +469,16 @@ void* SerialArena::AllocateFromStringBlockFallback() {
 
   void* ptr;
   size_t size = StringBlock::NextSize(string_block_);
-  if (MaybeAllocateAligned(size, &ptr)) {
+  // String block sizes are powers of two, so they fit returned arrays well.
+  if ((ptr = TryAllocateFromCachedBlock(size)) != nullptr ||
+      MaybeAllocateAligned(size, &ptr)) {
     // Correct space_used_ to avoid double counting
     AddSpaceUsed(-size);
     string_block_ = StringBlock::Emplace(ptr, size, string_block_);
   } else {
     string_block_ = StringBlock::New(string_block_);
     AddSpaceAllocated(string_block_->allocated_size());
+    parent_.CheckMaxTotalBytes();
   }
   size_t unused = string_block_->effective_size() - sizeof(std::string);
   string_block_unused_.store(unused, std::memory_order_relaxed);
@@ -275,11 +519,13 @@ void SerialArena::AllocateNewBlock(size_t n) {
   // but with a CPU regression. The regression might have been an artifact of
   // the microbenchmark.
 
-  auto mem = AllocateMemory(parent_.AllocPolicy(), old_head->size, n);
+  auto mem = AllocateMemory(parent_.AllocPolicy(), old_head->size, n,
+                            parent_.arena_stats_.MutableStats());
   // We don't want to emit an expensive RMW instruction that requires
   // exclusive access to a cacheline. Hence we write it in terms of a
   // regular add.
   AddSpaceAllocated(mem.n);
+  parent_.CheckMaxTotalBytes();
   ThreadSafeArenaStats::RecordAllocateStats(parent_.arena_stats_.MutableStats(),
                                             /*used=*/used,
                                             /*allocated=*/mem.n, wasted);
@@ -344,17 +590,98 @@ void SerialArena::CleanupList() {
   if (b->IsSentry()) return;
 
   b->cleanup_nodes = limit_;
+  CleanupBlocks(b);
+}
+
+void SerialArena::CleanupBlocks(ArenaBlock* b) {
   do {
     char* limit = b->Limit();
     char* it = reinterpret_cast<char*>(b->cleanup_nodes);
     ABSL_DCHECK(!b->IsSentry() || it == limit);
-    while (it < limit) {
-      it += cleanup::DestroyNode(it);
-    }
+    cleanup::DestroyNodes(it, limit);
     b = b->next;
   } while (b);
 }
 
+void SerialArena::RewindStringBlocks(const Checkpoint& checkpoint) {
+  // Strings are allocated from the end of each StringBlock towards its start,
+  // so the ones allocated after the checkpoint are in [unused, end) of every
+  // newer block, and in [unused, checkpoint unused) of the checkpoint block.
+  size_t unused = string_block_unused_.load(std::memory_order_relaxed);
+  StringBlock* string_block = string_block_;
+  while (string_block != checkpoint.string_block) {
+    ABSL_DCHECK(string_block != nullptr);
+    StringBlock* next = string_block->next();
+    std::string* end = string_block->end();
+    for (std::string* s = string_block->AtOffset(unused); s != end; ++s) {
+      s->~basic_string();
+    }
+    // Emplaced blocks live in arena blocks and return 0 here.
+    AddSpaceAllocated(-StringBlock::Delete(string_block));
+    string_block = next;
+    unused = 0;
+  }
+  if (string_block != nullptr) {
+    std::string* end = string_block->AtOffset(checkpoint.string_block_unused);
+    for (std::string* s = string_block->AtOffset(unused); s != end; ++s) {
+      s->~basic_string();
+    }
+  }
+  string_block_ = checkpoint.string_block;
+  string_block_unused_.store(checkpoint.string_block_unused,
+                             std::memory_order_relaxed);
+}
+
+template <typename Deallocator>
+void SerialArena::RewindTo(const Checkpoint& checkpoint,
+                           Deallocator deallocator) {
+  ArenaBlock* const checkpoint_head = checkpoint.head;
+  ArenaBlock* b = head();
+
+  // Run cleanups in the same order as CleanupList(): newest block first, and
+  // newest node first within each block.
+  if (b != checkpoint_head) {
+    b->cleanup_nodes = limit_;
+    for (ArenaBlock* it = b; it != checkpoint_head; it = it->next) {
+      cleanup::DestroyNodes(static_cast<char*>(it->cleanup_nodes), it->Limit());
+    }
+    if (!checkpoint_head->IsSentry()) {
+      cleanup::DestroyNodes(static_cast<char*>(checkpoint_head->cleanup_nodes),
+                            checkpoint.limit);
+    }
+  } else {
+    cleanup::DestroyNodes(limit_, checkpoint.limit);
+  }
+
+  RewindStringBlocks(checkpoint);
+
+  // Free all blocks allocated after the checkpoint.
+  size_t freed = 0;
+  while (b != checkpoint_head) {
+    ArenaBlock* next = b->next;
+    freed += b->size;
+    deallocator(SizedPtr{b, b->size});
+    b = next;
+  }
+
+  head_.store(checkpoint_head, std::memory_order_relaxed);
+  set_ptr(checkpoint.ptr);
+  limit_ = checkpoint.limit;
+  space_used_.store(checkpoint.space_used, std::memory_order_relaxed);
+  AddSpaceAllocated(-freed);
+
+  // Returned arrays may have been allocated after the checkpoint, so the free
+  // lists cannot be trusted anymore. Dropping them only forgoes some reuse.
+  cached_block_length_ = 0;
+  cached_blocks_ = nullptr;
+
+#ifdef ADDRESS_SANITIZER
+  if (!checkpoint_head->IsSentry()) {
+    ASAN_POISON_MEMORY_REGION(ptr(), limit_ - ptr());
+  }
+#endif  // ADDRESS_SANITIZER
+}
+
 // Stores arrays of void* and SerialArena* instead of linked list of
 // SerialArena* to speed up traversing all SerialArena. The cost of walk is non
 // trivial when there are many nodes. Separately storing "ids" minimizes cache
@@ -510,6 +837,117 @@ ThreadSafeArena::SerialArenaChunk* ThreadSafeArena::SentrySerialArenaChunk() {
       const_cast<SerialArenaChunkHeader*>(&kSentryArenaChunk));
 }
 
+// Open-addressed hash table, with linear probing, from the id of a thread to
+// its SerialArena. It is an index over the chunked list: every entry is also
+// in a chunk, which stays the source of truth for walks and Free().
+//
+// Each thread only ever inserts and looks up its own id, so a slot is claimed
+// by a CAS on the id and the SerialArena is published afterwards. Tables are
+// never more than half full, which bounds probe sequences and guarantees that
+// a reserved insert finds an empty slot. A full table is replaced by a larger
+// one; the old one stays alive (readers may still use it) until Free().
+class ThreadSafeArena::SerialArenaTable {
+ public:
+  static SerialArenaTable* New(uint32_t capacity, SerialArenaTable* prev) {
+    ABSL_DCHECK(absl::has_single_bit(capacity));
+    void* mem = internal::AllocateAtLeast(AllocSize(capacity)).p;
+    return new (mem) SerialArenaTable(capacity, prev);
+  }
+
+  // Deletes `table` and all the tables it replaced.
+  static void Delete(SerialArenaTable* table) {
+    while (table != nullptr) {
+      SerialArenaTable* prev = table->prev_;
+      internal::SizedDelete(table, AllocSize(table->capacity_));
+      table = prev;
+    }
+  }
+
+  uint32_t capacity() const { return capacity_; }
+
+  SerialArena* Find(void* id) const {
+    const uint32_t mask = capacity_ - 1;
+    for (uint32_t i = Hash(id) & mask;; i = (i + 1) & mask) {
+      void* slot_id = slots()[i].id.load(std::memory_order_acquire);
+      if (slot_id == id) {
+        return slots()[i].serial.load(std::memory_order_acquire);
+      }
+      if (slot_id == nullptr) return nullptr;
+    }
+  }
+
+  // Returns false, without inserting, if the table is already half full.
+  bool Insert(void* id, SerialArena* serial) {
+    if (size_.fetch_add(1, std::memory_order_relaxed) >= capacity_ / 2) {
+      // Write old value back to avoid potential overflow.
+      size_.store(capacity_ / 2, std::memory_order_relaxed);
+      return false;
+    }
+    const uint32_t mask = capacity_ - 1;
+    for (uint32_t i = Hash(id) & mask;; i = (i + 1) & mask) {
+      void* expected = nullptr;
+      if (slots()[i].id.compare_exchange_strong(expected, id,
+                                                std::memory_order_acq_rel)) {
+        slots()[i].serial.store(serial, std::memory_order_release);
+        return true;
+      }
+    }
+  }
+
+ private:
+  struct Slot {
+    std::atomic<void*> id;
+    std::atomic<SerialArena*> serial;
+  };
+
+  SerialArenaTable(uint32_t capacity, SerialArenaTable* prev)
+      : prev_(prev), capacity_(capacity), size_(0) {
+    for (uint32_t i = 0; i < capacity; ++i) {
+      new (&slots()[i]) Slot{{nullptr}, {nullptr}};
+    }
+  }
+
+  static constexpr size_t AllocSize(uint32_t capacity) {
+    return sizeof(SerialArenaTable) + capacity * sizeof(Slot);
+  }
+
+  // Ids are addresses of thread locals: drop the alignment bits and mix.
+  static uint32_t Hash(void* id) {
+    uint64_t x = reinterpret_cast<uintptr_t>(id) >> 4;
+    return static_cast<uint32_t>((x * uint64_t{0x9E3779B97F4A7C15}) >> 32);
+  }
+
+  Slot* slots() { return reinterpret_cast<Slot*>(this + 1); }
+  const Slot* slots() const { return reinterpret_cast<const Slot*>(this + 1); }
+
+  SerialArenaTable* prev_;
+  uint32_t capacity_;
+  std::atomic<uint32_t> size_;
+};
+
+namespace {
+// Guards the membership of all fuse groups. Fusing is rare enough for a single
+// mutex not to matter.
+ABSL_CONST_INIT absl::Mutex fuse_mutex(absl::kConstInit);
+}  // namespace
+
+// Keeps the blocks and cleanups of fused arenas that were destroyed or Reset()
+// until the last arena of the group goes away.
+class ThreadSafeArena::FuseGroup {
+ public:
+  // What is left of a SerialArena of an arena that left the group. The cleanup
+  // nodes of `head` are synced to the SerialArena's limit.
+  struct Retired {
+    ArenaBlock* head;
+    StringBlock* string_block;
+    size_t string_block_unused;
+  };
+
+  // The arenas currently in the group.
+  std::vector<ThreadSafeArena*> members;
+  // In the order CleanupList() would have run them for each arena.
+  std::vector<Retired> retired;
+};
 
 alignas(kCacheAlignment) ABSL_CONST_INIT
     std::atomic<ThreadSafeArena::LifecycleId> ThreadSafeArena::lifecycle_id_{0};
@@ -560,7 +998,8 @@ ArenaBlock* ThreadSafeArena::FirstBlock(void* buf, size_t size,
 
   SizedPtr mem;
   if (buf == nullptr || size < kBlockHeaderSize + kAllocPolicySize) {
-    mem = AllocateMemory(&policy, 0, kAllocPolicySize);
+    // Stats are not sampled yet; see Init().
+    mem = AllocateMemory(&policy, 0, kAllocPolicySize, nullptr);
   } else {
     mem = {buf, size};
     // Record user-owned block.
@@ -600,6 +1039,17 @@ void ThreadSafeArena::InitializeWithPolicy(const AllocationPolicy& policy) {
 #undef ABSL_DCHECK_POLICY_FLAGS_
 }
 
+void ThreadSafeArena::CheckMaxTotalBytes() {
+  const AllocationPolicy* policy = AllocPolicy();
+  if (PROTOBUF_PREDICT_TRUE(policy == nullptr ||
+                            policy->max_total_bytes == 0)) {
+    return;
+  }
+  if (SpaceAllocated() > policy->max_total_bytes) {
+    max_total_bytes_exceeded_.store(true, std::memory_order_relaxed);
+  }
+}
+
 uint64_t ThreadSafeArena::GetNextLifeCycleId() {
   ThreadCache& tc = thread_cache();
   uint64_t id = tc.next_lifecycle_id;
@@ -659,7 +1109,10 @@ void ThreadSafeArena::AddSerialArena(void* id, SerialArena* serial) {
   // Refetch and if someone else installed a new head, try allocating on that!
   SerialArenaChunk* new_head = head_.load(std::memory_order_acquire);
   if (new_head != head) {
-    if (new_head->insert(id, serial)) return;
+    if (new_head->insert(id, serial)) {
+      AddToSerialArenaTable(id, serial, /*new_chunk=*/false);
+      return;
+    }
     // Update head to link to the latest one.
     head = new_head;
   }
@@ -670,10 +1123,72 @@ void ThreadSafeArena::AddSerialArena(void* id, SerialArena* serial) {
   // Use "std::memory_order_release" to make sure prior stores are visible after
   // this one.
   head_.store(new_head, std::memory_order_release);
+  AddToSerialArenaTable(id, serial, /*new_chunk=*/true);
+}
+
+void ThreadSafeArena::AddToSerialArenaTable(void* id, SerialArena* serial,
+                                            bool new_chunk) {
+  // Below this many chunk entries, walking the chunks is as fast as a lookup.
+  constexpr uint32_t kMinSerialArenasForTable = 16;
+  constexpr uint32_t kMinTableCapacity = 64;
+
+  SerialArenaTable* table = table_.load(std::memory_order_acquire);
+  if (table != nullptr && table->Insert(id, serial)) return;
+  if (table == nullptr && !new_chunk) return;
+
+  absl::MutexLock lock(&mutex_);
+  SerialArenaTable* current = table_.load(std::memory_order_acquire);
+  if (current != table) {
+    // Someone else installed a table; it may or may not have our entry, which
+    // is fine as duplicates resolve to the same SerialArena.
+    if (current->Insert(id, serial)) return;
+    table = current;
+  }
+
+  uint32_t num_serial_arenas = 0;
+  WalkConstSerialArenaChunk([&](const SerialArenaChunk* chunk) {
+    num_serial_arenas += chunk->ids().size();
+  });
+  if (table == nullptr && num_serial_arenas < kMinSerialArenasForTable) return;
+
+  // Leave room for the table to double before it fills up again.
+  uint32_t capacity =
+      absl::bit_ceil(std::max(kMinTableCapacity, 4 * num_serial_arenas));
+  if (table != nullptr) capacity = std::max(capacity, 2 * table->capacity());
+  SerialArenaTable* new_table = SerialArenaTable::New(capacity, table);
+  WalkConstSerialArenaChunk([&](const SerialArenaChunk* chunk) {
+    absl::Span<const std::atomic<void*>> ids = chunk->ids();
+    for (uint32_t i = 0; i < ids.size(); ++i) {
+      void* chunk_id = ids[i].load(std::memory_order_relaxed);
+      SerialArena* chunk_serial =
+          chunk->arena(i).load(std::memory_order_acquire);
+      // Entries still being inserted are added by their owner, or on their
+      // owner's next table miss.
+      if (chunk_id == nullptr || chunk_serial == nullptr) continue;
+      new_table->Insert(chunk_id, chunk_serial);
+    }
+  });
+  table_.store(new_table, std::memory_order_release);
+}
+
+SerialArena* ThreadSafeArena::FindSerialArenaInChunks(void* id) const {
+  SerialArena* serial = nullptr;
+  WalkConstSerialArenaChunk([&serial, id](const SerialArenaChunk* chunk) {
+    absl::Span<const std::atomic<void*>> ids = chunk->ids();
+    for (uint32_t i = 0; i < ids.size(); ++i) {
+      if (ids[i].load(std::memory_order_relaxed) == id) {
+        serial = chunk->arena(i).load(std::memory_order_relaxed);
+        ABSL_DCHECK_NE(serial, nullptr);
+        break;
+      }
+    }
+  });
+  return serial;
 }
 
 void ThreadSafeArena::Init() {
   tag_and_id_ = GetNextLifeCycleId();
+  max_total_bytes_exceeded_.store(false, std::memory_order_relaxed);
   arena_stats_ = Sample();
   head_.store(SentrySerialArenaChunk(), std::memory_order_relaxed);
   first_owner_ = &thread_cache();
@@ -690,6 +1205,15 @@ void ThreadSafeArena::Init() {
 }
 
 ThreadSafeArena::~ThreadSafeArena() {
+  MessageTraceScope trace(MessageTraceEvent::kArenaDestroy, nullptr);
+  if (PROTOBUF_PREDICT_FALSE(fuse_group_.load(std::memory_order_relaxed) !=
+                             nullptr)) {
+    // The last arena of the group frees the blocks.
+    LeaveFuseGroup();
+    trace.Done(true);
+    return;
+  }
+
   // Have to do this in a first pass, because some of the destructors might
   // refer to memory in other blocks.
   CleanupList();
@@ -705,6 +1229,8 @@ ThreadSafeArena::~ThreadSafeArena() {
   } else if (mem.n > 0) {
     GetDeallocator(alloc_policy_.get(), &space_allocated)(mem);
   }
+  trace.set_bytes(space_allocated);
+  trace.Done(true);
 }
 
 SizedPtr ThreadSafeArena::Free(size_t* space_allocated) {
@@ -731,12 +1257,29 @@ SizedPtr ThreadSafeArena::Free(size_t* space_allocated) {
                           SerialArenaChunk::AllocSize(chunk->capacity()));
   });
 
+  SerialArenaTable::Delete(table_.load(std::memory_order_relaxed));
+  table_.store(nullptr, std::memory_order_relaxed);
+
   // The first block of the first arena is special and let the caller handle it.
   *space_allocated += first_arena_.FreeStringBlocks();
   return first_arena_.Free(deallocator);
 }
 
 uint64_t ThreadSafeArena::Reset() {
+  MessageTraceScope trace(MessageTraceEvent::kArenaReset, nullptr);
+  if (PROTOBUF_PREDICT_FALSE(fuse_group_.load(std::memory_order_relaxed) !=
+                             nullptr)) {
+    // Objects on other arenas of the group may still refer to ours, so our
+    // blocks go to the group and we start over unfused.
+    const uint64_t space_allocated = SpaceAllocated();
+    LeaveFuseGroup();
+    first_arena_.Init(SentryArenaBlock(), 0);
+    Init();
+    trace.set_bytes(space_allocated);
+    trace.Done(true);
+    return space_allocated;
+  }
+
   // Have to do this in a first pass, because some of the destructors might
   // refer to memory in other blocks.
   CleanupList();
@@ -764,9 +1307,124 @@ uint64_t ThreadSafeArena::Reset() {
   // preserved, this can be initialized by Init().
   Init();
 
+  trace.set_bytes(space_allocated);
+  trace.Done(true);
   return space_allocated;
 }
 
+bool ThreadSafeArena::IsFusable() const {
+  return alloc_policy_.get() == nullptr &&
+         !alloc_policy_.is_user_owned_initial_block();
+}
+
+bool ThreadSafeArena::Fuse(ThreadSafeArena& other) {
+  if (&other == this) return true;
+  if (!IsFusable() || !other.IsFusable()) return false;
+
+  absl::MutexLock lock(&fuse_mutex);
+  FuseGroup* group = fuse_group_.load(std::memory_order_relaxed);
+  if (group == nullptr) {
+    group = new FuseGroup;
+    group->members.push_back(this);
+    fuse_group_.store(group, std::memory_order_relaxed);
+  }
+  FuseGroup* other_group = other.fuse_group_.load(std::memory_order_relaxed);
+  if (other_group == nullptr) {
+    group->members.push_back(&other);
+    other.fuse_group_.store(group, std::memory_order_relaxed);
+    return true;
+  }
+  if (other_group == group) return true;
+
+  // Move the members of the smaller group so that fusing n arenas one by one
+  // takes O(n log n) time.
+  if (group->members.size() < other_group->members.size()) {
+    std::swap(group, other_group);
+  }
+  for (ThreadSafeArena* member : other_group->members) {
+    member->fuse_group_.store(group, std::memory_order_relaxed);
+    group->members.push_back(member);
+  }
+  group->retired.insert(group->retired.end(), other_group->retired.begin(),
+                        other_group->retired.end());
+  delete other_group;
+  return true;
+}
+
+void ThreadSafeArena::LeaveFuseGroup() {
+  std::vector<FuseGroup::Retired> retired;
+  const auto retire = [&retired](SerialArena& serial) {
+    ArenaBlock* head = serial.head();
+    if (!head->IsSentry()) head->cleanup_nodes = serial.limit_;
+    retired.push_back(
+        {head, serial.string_block_,
+         serial.string_block_unused_.load(std::memory_order_relaxed)});
+  };
+  // Same order as CleanupList(), with the first arena last.
+  WalkSerialArenaChunk([&retire](SerialArenaChunk* chunk) {
+    absl::Span<std::atomic<SerialArena*>> span = chunk->arenas();
+    for (auto it = span.rbegin(); it != span.rend(); ++it) {
+      SerialArena* serial = it->load(std::memory_order_relaxed);
+      ABSL_DCHECK_NE(serial, nullptr);
+      retire(*serial);
+    }
+    internal::SizedDelete(chunk,
+                          SerialArenaChunk::AllocSize(chunk->capacity()));
+  });
+  head_.store(SentrySerialArenaChunk(), std::memory_order_relaxed);
+  SerialArenaTable::Delete(table_.load(std::memory_order_relaxed));
+  table_.store(nullptr, std::memory_order_relaxed);
+  retire(first_arena_);
+
+  FuseGroup* group;
+  {
+    absl::MutexLock lock(&fuse_mutex);
+    group = fuse_group_.load(std::memory_order_relaxed);
+    fuse_group_.store(nullptr, std::memory_order_relaxed);
+    std::vector<ThreadSafeArena*>& members = group->members;
+    members.erase(std::find(members.begin(), members.end(), this));
+    group->retired.insert(group->retired.end(), retired.begin(),
+                          retired.end());
+    if (!members.empty()) return;
+  }
+
+  // We were the last member. As in the destructor, run all cleanups before
+  // freeing any block, since destructors may refer to memory in other blocks.
+  for (const FuseGroup::Retired& each : group->retired) {
+    if (!each.head->IsSentry()) SerialArena::CleanupBlocks(each.head);
+  }
+  size_t space_allocated = 0;
+  GetDeallocator deallocator(nullptr, &space_allocated);
+  for (const FuseGroup::Retired& each : group->retired) {
+    if (each.string_block != nullptr) {
+      SerialArena::FreeStringBlocks(each.string_block,
+                                    each.string_block_unused);
+    }
+    for (ArenaBlock* b = each.head; b != nullptr && !b->IsSentry();) {
+      ArenaBlock* next = b->next;
+      deallocator(SizedPtr{b, b->size});
+      b = next;
+    }
+  }
+  delete group;
+}
+
+ThreadSafeArena::Checkpoint ThreadSafeArena::CreateCheckpoint() {
+  SerialArena* serial = GetSerialArena();
+  return {tag_and_id_, serial, serial->CreateCheckpoint()};
+}
+
+void ThreadSafeArena::RewindTo(const Checkpoint& checkpoint) {
+  ABSL_CHECK_EQ(checkpoint.lifecycle_id, tag_and_id_)
+      << "Checkpoint was taken before the arena was last Reset().";
+  SerialArena* serial = GetSerialArena();
+  ABSL_CHECK_EQ(checkpoint.serial, serial)
+      << "RewindTo() must be called on the thread that created the checkpoint.";
+  size_t space_freed = 0;
+  serial->RewindTo(checkpoint.state,
+                   GetDeallocator(alloc_policy_.get(), &space_freed));
+}
+
 void* ThreadSafeArena::AllocateAlignedWithCleanup(size_t n, size_t align,
                                                   void (*destructor)(void*)) {
   SerialArena* arena;
@@ -892,25 +1550,27 @@ SerialArena* ThreadSafeArena::GetSerialArenaFallback(size_t n) {
     return &first_arena_;
   }
 
-  // Search matching SerialArena.
+  // Search matching SerialArena, preferably through the lookup table. The
+  // table may miss our entry if it was rebuilt while we were being added; we
+  // then walk the chunks once and add ourselves to the current table.
   SerialArena* serial = nullptr;
-  WalkConstSerialArenaChunk([&serial, id](const SerialArenaChunk* chunk) {
-    absl::Span<const std::atomic<void*>> ids = chunk->ids();
-    for (uint32_t i = 0; i < ids.size(); ++i) {
-      if (ids[i].load(std::memory_order_relaxed) == id) {
-        serial = chunk->arena(i).load(std::memory_order_relaxed);
-        ABSL_DCHECK_NE(serial, nullptr);
-        break;
-      }
+  SerialArenaTable* table = table_.load(std::memory_order_acquire);
+  if (table != nullptr) serial = table->Find(id);
+  if (!serial) {
+    serial = FindSerialArenaInChunks(id);
+    if (serial != nullptr && table != nullptr) {
+      AddToSerialArenaTable(id, serial, /*new_chunk=*/false);
     }
-  });
+  }
 
   if (!serial) {
     // This thread doesn't have any SerialArena, which also means it doesn't
     // have any blocks yet.  So we'll allocate its first block now. It must be
     // big enough to host SerialArena and the pending request.
     serial = SerialArena::New(
-        AllocateMemory(alloc_policy_.get(), 0, n + kSerialArenaSize), *this);
+        AllocateMemory(alloc_policy_.get(), 0, n + kSerialArenaSize,
+                       arena_stats_.MutableStats()),
+        *this);
 
     AddSerialArena(id, serial);
   }
@@ -932,6 +1592,14 @@ void* Arena::AllocateAlignedWithCleanup(size_t n, size_t align,
   return impl_.AllocateAlignedWithCleanup(n, align, destructor);
 }
 
+ArenaCheckpoint Arena::Checkpoint() {
+  return ArenaCheckpoint(impl_.CreateCheckpoint());
+}
+
+void Arena::RewindTo(const ArenaCheckpoint& checkpoint) {
+  impl_.RewindTo(checkpoint.state_);
+}
+
 std::vector<void*> Arena::PeekCleanupListForTesting() {
   return impl_.PeekCleanupListForTesting();
 }
@@ -49,8 +49,10 @@ using type_info = ::type_info;
 #endif
 
 #include "absl/meta/type_traits.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/arena_align.h"
 #include "google/protobuf/arena_config.h"
+#include "google/protobuf/arenaz_sampler.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/serial_arena.h"
 #include "google/protobuf/thread_safe_arena.h"
@@ -67,10 +69,14 @@ namespace protobuf {
 
 struct ArenaOptions;  // defined below
 class Arena;    // defined below
+class StringInternTable;  // defined in string_intern_table.h
 class Message;  // defined in message.h
 class MessageLite;
 template <typename Key, typename T>
 class Map;
+template <typename T>
+class ArenaAllocator;       // defined in arena_allocator.h
+class ArenaMemoryResource;  // defined in arena_allocator.h
 
 namespace arena_metrics {
 
@@ -94,6 +100,9 @@ class TcParser;              // defined in generated_message_tctable_impl.h
 template <typename Type>
 class GenericTypeHandler;  // defined in repeated_field.h
 
+template <typename U>
+class MapAllocator;  // defined in map.h
+
 template <bool destructor_skippable, typename T>
 struct ObjectDestructor {
   constexpr static void (*destructor)(void*) =
@@ -144,6 +153,56 @@ struct ArenaOptions {
   // calls free.
   void (*block_dealloc)(void*, size_t) = nullptr;
 
+  // If non-zero, blocks released by this arena on destruction or Reset() are
+  // kept in a thread-local cache holding at most this many bytes, and new
+  // blocks are taken from that cache before asking the system allocator. This
+  // lets short-lived arenas created and destroyed on the same thread (e.g. one
+  // per request) recycle their memory. Only blocks of the natural power-of-two
+  // growth sizes are cached. Ignored if block_alloc or block_dealloc is set.
+  size_t thread_block_cache_size = 0;
+
+  // If true, each block allocated by the default block allocator is bound to
+  // the NUMA node of the thread allocating it. Since every thread allocates
+  // from its own blocks, objects created by a worker thread end up in memory
+  // local to that thread's socket, and the first block follows the thread
+  // creating the arena. Only the pages fully contained in a block are bound,
+  // so this mostly matters for arenas whose blocks grow beyond the page size.
+  // This is a no-op on platforms without NUMA memory policy support (only
+  // Linux is supported) and if block_alloc is set.
+  bool numa_local_blocks = false;
+
+  // If true, the block size growth limit is raised to (a multiple of) 2MB and
+  // blocks of at least 2MB are mapped directly from the OS, 2MB aligned, and
+  // advised to be backed by transparent huge pages. This reduces TLB misses
+  // when traversing large, long-lived arenas. Smaller blocks are allocated as
+  // usual. Only supported on Linux; ignored elsewhere and if block_alloc or
+  // block_dealloc is set.
+  bool huge_page_blocks = false;
+
+  // If true, the payload of cord (`[ctype = CORD]`) fields parsed into
+  // messages on this arena is copied into the arena and referenced as external
+  // memory of the cord, instead of being copied into heap allocated cord
+  // chunks. Payloads shared with the input (e.g. when parsing from a
+  // CordInputStream) are still shared. The caller must ensure that no cord
+  // referencing such a field, including copies of the field, outlives the
+  // arena.
+  bool arena_owned_cords = false;
+
+  // If non-zero, a soft limit on SpaceAllocated(). Allocations never fail,
+  // but once the blocks of the arena add up to more than this many bytes,
+  // parsing into messages on the arena fails (e.g. ParseFromString() returns
+  // false) at the end of the message being parsed. This bounds the memory a
+  // crafted input can make a parse consume to roughly this limit plus the
+  // largest single allocation the input can cause.
+  size_t max_total_bytes = 0;
+
+  // If set, string fields parsed into messages on this arena whose value is
+  // short enough for the table (see StringInternTable) share the table's copy
+  // of that value instead of allocating their own. This saves memory when many
+  // messages hold the same few values, e.g. host names or labels. A field gets
+  // a private copy again once it is mutated. The table must outlive the arena.
+  StringInternTable* string_intern_table = nullptr;
+
  private:
   internal::AllocationPolicy AllocationPolicy() const {
     internal::AllocationPolicy res;
@@ -151,6 +210,12 @@ struct ArenaOptions {
     res.max_block_size = max_block_size;
     res.block_alloc = block_alloc;
     res.block_dealloc = block_dealloc;
+    res.thread_block_cache_size = thread_block_cache_size;
+    res.numa_local_blocks = numa_local_blocks;
+    res.huge_page_blocks = huge_page_blocks;
+    res.arena_owned_cords = arena_owned_cords;
+    res.max_total_bytes = max_total_bytes;
+    res.string_intern_table = string_intern_table;
     return res;
   }
 
@@ -158,6 +223,22 @@ struct ArenaOptions {
   friend class ArenaOptionsTestFriend;
 };
 
+// An opaque position in an arena, returned by Arena::Checkpoint() and consumed
+// by Arena::RewindTo().
+class ArenaCheckpoint {
+ public:
+  ArenaCheckpoint(const ArenaCheckpoint&) = default;
+  ArenaCheckpoint& operator=(const ArenaCheckpoint&) = default;
+
+ private:
+  explicit ArenaCheckpoint(internal::ThreadSafeArena::Checkpoint state)
+      : state_(state) {}
+
+  internal::ThreadSafeArena::Checkpoint state_;
+
+  friend class Arena;
+};
+
 // Arena allocator. Arena allocation replaces ordinary (heap-based) allocation
 // with new/delete, and improves performance by aggregating allocations into
 // larger blocks and freeing allocations all at once. Protocol messages are
@@ -343,6 +424,12 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
   // to overestimates (up to the current block size).
   uint64_t SpaceUsed() const { return impl_.SpaceUsed(); }
 
+  // Returns true if the arena has allocated more than
+  // ArenaOptions::max_total_bytes since it was created or last Reset().
+  bool MaxTotalBytesExceeded() const {
+    return impl_.max_total_bytes_exceeded();
+  }
+
   // Frees all storage allocated by this arena after calling destructors
   // registered with OwnDestructor() and freeing objects registered with Own().
   // Any objects allocated on this arena are unusable after this call. It also
@@ -350,6 +437,40 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
   // of the allocated blocks. This method is not thread-safe.
   uint64_t Reset() { return impl_.Reset(); }
 
+  // Records the current allocation position of the calling thread in this
+  // arena. Passing the result to RewindTo() later, from the same thread, gives
+  // back everything that thread allocated on the arena in between: destructors
+  // and cleanups registered after the checkpoint are run, and blocks allocated
+  // after it are freed. This allows bounding peak memory of scratch objects
+  // built on a long-lived arena without Reset()ing it.
+  //
+  // Objects allocated by the calling thread after the checkpoint must not be
+  // used after rewinding, and objects allocated before it must not reference
+  // them (e.g. a message created before the checkpoint must not have gained
+  // arena-allocated fields after it). Allocations from other threads are not
+  // affected. A checkpoint is invalidated by Reset() and by rewinding to an
+  // earlier checkpoint.
+  ArenaCheckpoint Checkpoint();
+  void RewindTo(const ArenaCheckpoint& checkpoint);
+
+  // Joins the lifetimes of this arena and `other`, along with all arenas either
+  // was fused with before. Their blocks are freed, and the destructors
+  // registered on them run, only once every arena of the group was destroyed
+  // or Reset(). Objects on one arena may then refer to objects on the other,
+  // e.g. a submessage can be moved between messages on the two arenas in O(1)
+  // with unsafe_arena_release_*() and unsafe_arena_set_allocated_*(), or the
+  // messages can be UnsafeArenaSwap()ped, instead of being deep copied.
+  //
+  // Reset() hands the memory of a fused arena over to its group, after which
+  // the arena starts over unfused. SpaceAllocated() and SpaceUsed() only
+  // account for the arena's own blocks.
+  //
+  // Returns false, without fusing, if either arena was given an initial block
+  // or non-default ArenaOptions, as their blocks cannot outlive the arena.
+  // Fusing is thread-safe, but must not race with the destruction or Reset()
+  // of this arena or `other`.
+  bool Fuse(Arena& other) { return impl_.Fuse(other.impl_); }
+
   // Adds |object| to a list of heap-allocated objects to be freed with |delete|
   // when the arena is destroyed or reset.
   template <typename T>
@@ -433,6 +554,26 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
 
     static void InternalSwap(T* a, T* b) { a->InternalSwap(b); }
 
+    // Generated messages keep FullMessageName() private, but befriend this
+    // class.
+    static absl::string_view ArenazTypeName() {
+      return ArenazTypeName<T>(Rank0{});
+    }
+
+    template <typename U>
+    static auto ArenazTypeName(Rank0) -> decltype(U::FullMessageName()) {
+      return U::FullMessageName();
+    }
+
+    template <typename U>
+    static absl::string_view ArenazTypeName(Rank1) {
+#if PROTOBUF_RTTI
+      return typeid(U).name();
+#else
+      return "<unknown>";
+#endif
+    }
+
     static Arena* GetArenaForAllocation(T* p) {
       return GetArenaForAllocation(Rank0{}, p);
     }
@@ -602,8 +743,22 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
                                    std::forward<Args>(args)...);
   }
 
+  // Name of `T` in the arenaz type profile: the full message name for
+  // generated messages, the mangled type name otherwise.
+  template <typename T>
+  struct ArenazTypeName {
+    static absl::string_view Get() {
+      return InternalHelper<T>::ArenazTypeName();
+    }
+  };
+
+  void RecordTypeAllocation(internal::ArenazTypeNameFn type_name, size_t n) {
+    impl_.RecordTypeAllocation(type_name, n);
+  }
+
   template <typename T, typename... Args>
   PROTOBUF_NDEBUG_INLINE T* DoCreateMessage(Args&&... args) {
+    RecordTypeAllocation(&ArenazTypeName<T>::Get, sizeof(T));
     return InternalHelper<T>::Construct(
         AllocateInternal<T, is_destructor_skippable<T>::value>(), this,
         std::forward<Args>(args)...);
@@ -688,11 +843,18 @@ class PROTOBUF_EXPORT PROTOBUF_ALIGNAS(8) Arena final {
   template <typename>
   friend class RepeatedField;                   // For ReturnArrayMemory
   friend class internal::RepeatedPtrFieldBase;  // For ReturnArrayMemory
+  template <typename>
+  friend class internal::MapAllocator;  // For ReturnArrayMemory
+  template <typename>
+  friend class ArenaAllocator;       // For array memory
+  friend class ArenaMemoryResource;  // For array memory
   friend struct internal::ArenaTestPeer;
 };
 
 template <>
 inline void* Arena::AllocateInternal<std::string, false>() {
+  RecordTypeAllocation([] { return absl::string_view("std::string"); },
+                       sizeof(std::string));
   return impl_.AllocateFromStringBlock();
 }
 
@@ -38,6 +38,9 @@
 
 namespace google {
 namespace protobuf {
+
+class StringInternTable;  // defined in string_intern_table.h
+
 namespace internal {
 
 // `AllocationPolicy` defines `Arena` allocation policies. Applications can
@@ -54,10 +57,51 @@ struct AllocationPolicy {
   void* (*block_alloc)(size_t) = nullptr;
   void (*block_dealloc)(void*, size_t) = nullptr;
 
+  // Upper bound, in bytes, of the thread-local block cache that blocks freed
+  // by this arena may be recycled into. Zero disables the cache.
+  size_t thread_block_cache_size = 0;
+
+  // If true, blocks are placed on the NUMA node of the thread that allocates
+  // them. See ArenaOptions::numa_local_blocks.
+  bool numa_local_blocks = false;
+
+  // If true, large blocks are backed by transparent huge pages. See
+  // ArenaOptions::huge_page_blocks.
+  bool huge_page_blocks = false;
+
+  // If true, the payload of parsed cord fields is copied into the arena. See
+  // ArenaOptions::arena_owned_cords.
+  bool arena_owned_cords = false;
+
+  // Soft limit on the total size of the blocks, zero if unlimited. See
+  // ArenaOptions::max_total_bytes.
+  size_t max_total_bytes = 0;
+
+  // Table shared by short strings parsed into this arena, or null. See
+  // ArenaOptions::string_intern_table.
+  StringInternTable* string_intern_table = nullptr;
+
   bool IsDefault() const {
     return start_block_size == kDefaultStartBlockSize &&
            max_block_size == GetDefaultArenaMaxBlockSize() &&
-           block_alloc == nullptr && block_dealloc == nullptr;
+           block_alloc == nullptr && block_dealloc == nullptr &&
+           thread_block_cache_size == 0 && !numa_local_blocks &&
+           !huge_page_blocks && !arena_owned_cords && max_total_bytes == 0 &&
+           string_intern_table == nullptr;
+  }
+
+  // Returns true if blocks may be recycled through the thread-local block
+  // cache. Custom allocators own their blocks, so they never use the cache.
+  bool UsesThreadBlockCache() const {
+    return thread_block_cache_size != 0 && block_alloc == nullptr &&
+           block_dealloc == nullptr;
+  }
+
+  // Returns true if large blocks are mapped as huge pages. As above, custom
+  // allocators take precedence.
+  bool UsesHugePageBlocks() const {
+    return huge_page_blocks && block_alloc == nullptr &&
+           block_dealloc == nullptr;
   }
 };
 
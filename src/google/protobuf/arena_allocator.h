@@ -0,0 +1,169 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Lets containers that live alongside messages allocate from the messages'
+// Arena, so that they are bump-allocated and freed in bulk with it:
+//
+//   Arena arena;
+//   std::vector<const MyMessage*, ArenaAllocator<const MyMessage*>> index(
+//       ArenaAllocator<const MyMessage*>(&arena));
+//
+// or, where std::pmr is available:
+//
+//   ArenaMemoryResource resource(&arena);
+//   std::pmr::vector<const MyMessage*> index(&resource);
+//
+// Allocations go through the same per-thread SerialArenas as messages do.
+// Like the memory of repeated fields, memory given back by a container, e.g.
+// when a vector grows, is put on the arena's free lists and reused by later
+// array allocations of the same size class; otherwise it is released along
+// with the arena.
+// Destructors of the containers still have to run: the arena does not know
+// about objects allocated this way.
+
+#ifndef GOOGLE_PROTOBUF_ARENA_ALLOCATOR_H__
+#define GOOGLE_PROTOBUF_ARENA_ALLOCATOR_H__
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include "google/protobuf/arena.h"
+#include "google/protobuf/port.h"
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>) && __cplusplus >= 201703L
+#include <memory_resource>
+#endif
+#endif
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+// An STL allocator that allocates from an Arena, or from the heap if the
+// arena is null. Allocators compare equal if they use the same arena.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  // Containers on one arena may swap or move their storage, but one that is
+  // copied allocates from the arena of the copy's allocator.
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  constexpr ArenaAllocator() : arena_(nullptr) {}
+  explicit constexpr ArenaAllocator(Arena* arena) : arena_(arena) {}
+  template <typename U>
+  constexpr ArenaAllocator(  // NOLINT(runtime/explicit)
+      const ArenaAllocator<U>& other)
+      : arena_(other.arena()) {}
+
+  // The heap fallback relies on ::operator new's alignment.
+  static_assert(alignof(T) <= alignof(std::max_align_t),
+                "over-aligned types are not supported");
+
+  T* allocate(size_t n) {
+    if (arena_ == nullptr) {
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    return static_cast<T*>(
+        arena_->AllocateAlignedForArray(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    if (arena_ == nullptr) {
+      internal::SizedDelete(p, n * sizeof(T));
+    } else if (alignof(T) <= 8 && n * sizeof(T) >= 16) {
+      // Let later array allocations, such as this container's next growth,
+      // reuse the memory.
+      arena_->ReturnArrayMemory(p, n * sizeof(T));
+    }
+  }
+
+  Arena* arena() const { return arena_; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena();
+  }
+
+ private:
+  Arena* arena_;
+};
+
+#if defined(__cpp_lib_memory_resource)
+
+// A std::pmr::memory_resource that allocates from an Arena. It must not
+// outlive the arena. Two resources compare equal only if they are the same
+// object, as std::pmr requires of resources that are not interchangeable.
+class ArenaMemoryResource final : public std::pmr::memory_resource {
+ public:
+  explicit ArenaMemoryResource(Arena* arena) : arena_(arena) {}
+
+  Arena* arena() const { return arena_; }
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    return arena_->AllocateAlignedForArray(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    if (alignment <= 8 && bytes >= 16) arena_->ReturnArrayMemory(p, bytes);
+  }
+
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  Arena* arena_;
+};
+
+#endif  // __cpp_lib_memory_resource
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_ARENA_ALLOCATOR_H__
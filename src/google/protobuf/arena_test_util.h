@@ -85,6 +85,10 @@ struct ArenaTestPeer {
   static auto PeekCleanupListForTesting(Arena* arena) {
     return arena->PeekCleanupListForTesting();
   }
+  template <typename T>
+  static absl::string_view ArenazTypeName() {
+    return Arena::ArenazTypeName<T>::Get();
+  }
 };
 
 struct CleanupGrowthInfo {
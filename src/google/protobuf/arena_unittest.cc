@@ -47,15 +47,19 @@
 #include "absl/log/absl_check.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/barrier.h"
+#include "google/protobuf/arena_allocator.h"
 #include "google/protobuf/arena_test_util.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/extension_set.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/map.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/message_lite.h"
+#include "google/protobuf/message_pool.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/repeated_field.h"
+#include "google/protobuf/string_intern_table.h"
 #include "google/protobuf/test_util.h"
 #include "google/protobuf/unittest.pb.h"
 #include "google/protobuf/unittest_arena.pb.h"
@@ -178,6 +182,21 @@ TEST(ArenaTest, DestructorSkippable) {
   EXPECT_FALSE(Arena::is_destructor_skippable<Arena>::type::value);
 }
 
+TEST(ArenaTest, ArenazTypeName) {
+  // FullMessageName() is private in generated messages.
+  EXPECT_EQ(internal::ArenaTestPeer::ArenazTypeName<TestAllTypes>(),
+            "protobuf_unittest.TestAllTypes");
+  EXPECT_EQ(
+      internal::ArenaTestPeer::ArenazTypeName<TestAllTypes::NestedMessage>(),
+      "protobuf_unittest.TestAllTypes.NestedMessage");
+  EXPECT_EQ(internal::ArenaTestPeer::ArenazTypeName<ArenaMessage>(),
+            "proto2_arena_unittest.ArenaMessage");
+#if PROTOBUF_RTTI
+  EXPECT_EQ(internal::ArenaTestPeer::ArenazTypeName<std::string>(),
+            typeid(std::string).name());
+#endif
+}
+
 TEST(ArenaTest, BasicCreate) {
   Arena arena;
   EXPECT_TRUE(Arena::Create<int32_t>(&arena) != nullptr);
@@ -1468,6 +1487,319 @@ TEST(ArenaTest, BlockSizeSmallerThanAllocation) {
   }
 }
 
+TEST(ArenaTest, ManyThreadsShareArena) {
+  constexpr int kThreads = 64;
+  constexpr int kAllocations = 100;
+  Arena arena;
+  for (int round = 0; round < 2; ++round) {
+    std::vector<std::vector<int*>> values(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&, t] {
+        for (int i = 0; i < kAllocations; ++i) {
+          values[t].push_back(Arena::Create<int>(&arena, t * kAllocations + i));
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+
+    for (int t = 0; t < kThreads; ++t) {
+      for (int i = 0; i < kAllocations; ++i) {
+        EXPECT_EQ(*values[t][i], t * kAllocations + i);
+      }
+    }
+    EXPECT_GE(arena.SpaceUsed(), kThreads * kAllocations * sizeof(int));
+    // Start over with fresh serial arenas and lookup table.
+    arena.Reset();
+  }
+}
+
+TEST(ArenaTest, ArenaOwnedCords) {
+  protobuf_unittest::TestCord source;
+  source.set_optional_bytes_cord(std::string(1000, 'x'));
+  const std::string data = source.SerializeAsString();
+
+  for (bool arena_owned : {false, true}) {
+    SCOPED_TRACE(arena_owned);
+    ArenaOptions options;
+    options.arena_owned_cords = arena_owned;
+    Arena arena(options);
+    auto* message = Arena::CreateMessage<protobuf_unittest::TestCord>(&arena);
+    const uint64_t space_used = arena.SpaceUsed();
+    ASSERT_TRUE(message->ParseFromString(data));
+    EXPECT_EQ(message->optional_bytes_cord(), std::string(1000, 'x'));
+    // The payload is only accounted to the arena if it lives there.
+    EXPECT_EQ(arena.SpaceUsed() >= space_used + 1000, arena_owned);
+  }
+}
+
+TEST(ArenaTest, StringInternTable) {
+  protobuf_unittest::TestAllTypes source;
+  source.set_optional_string("host-1.example.com");
+  source.set_optional_bytes(std::string(100, 'x'));
+  const std::string data = source.SerializeAsString();
+
+  StringInternTable table(/*max_length=*/32);
+  ArenaOptions options;
+  options.string_intern_table = &table;
+  Arena arena(options);
+  auto* m1 = Arena::CreateMessage<protobuf_unittest::TestAllTypes>(&arena);
+  auto* m2 = Arena::CreateMessage<protobuf_unittest::TestAllTypes>(&arena);
+  ASSERT_TRUE(m1->ParseFromString(data));
+  ASSERT_TRUE(m2->ParseFromString(data));
+
+  // Short values are shared, long ones are not interned.
+  EXPECT_EQ(&m1->optional_string(), &m2->optional_string());
+  EXPECT_EQ(&m1->optional_string(), table.Intern("host-1.example.com"));
+  EXPECT_NE(&m1->optional_bytes(), &m2->optional_bytes());
+  EXPECT_EQ(table.size(), 1u);
+
+  // Mutating or clearing one field leaves the shared value alone.
+  m1->mutable_optional_string()->append("x");
+  EXPECT_EQ(m1->optional_string(), "host-1.example.comx");
+  EXPECT_EQ(m2->optional_string(), "host-1.example.com");
+  m2->Clear();
+  EXPECT_EQ(*table.Intern("host-1.example.com"), "host-1.example.com");
+}
+
+TEST(ArenaTest, CleanupRunsNewestFirst) {
+  struct Recorder {
+    Recorder(std::vector<int>* order, int id) : order(order), id(id) {}
+    ~Recorder() { order->push_back(id); }
+    std::vector<int>* order;
+    int id;
+  };
+  // Enough objects to span several blocks and the prefetch window.
+  constexpr int kObjects = 1000;
+  std::vector<int> order;
+  {
+    Arena arena;
+    for (int i = 0; i < kObjects; ++i) {
+      Arena::Create<Recorder>(&arena, &order, i);
+      // Interleave strings, whose cleanups are tagged nodes.
+      Arena::Create<std::string>(&arena, "abc");
+    }
+  }
+  ASSERT_EQ(order.size(), kObjects);
+  for (int i = 0; i < kObjects; ++i) EXPECT_EQ(order[i], kObjects - 1 - i);
+}
+
+TEST(ArenaTest, MaxTotalBytesFailsParse) {
+  TestAllTypes source;
+  for (int i = 0; i < 1000; ++i) {
+    source.add_repeated_nested_message()->set_bb(i);
+  }
+  const std::string data = source.SerializeAsString();
+
+  ArenaOptions options;
+  options.max_total_bytes = 4096;
+  Arena arena(options);
+  auto* message = Arena::CreateMessage<TestAllTypes>(&arena);
+  EXPECT_FALSE(message->ParseFromString(data));
+  EXPECT_TRUE(arena.MaxTotalBytesExceeded());
+  // A parse that fails on the budget stops well short of the full input.
+  EXPECT_LT(message->repeated_nested_message_size(), 1000);
+  EXPECT_LT(arena.SpaceAllocated(), 64 * 1024);
+
+  // The budget starts over on Reset().
+  arena.Reset();
+  EXPECT_FALSE(arena.MaxTotalBytesExceeded());
+  message = Arena::CreateMessage<TestAllTypes>(&arena);
+  TestAllTypes small;
+  small.set_optional_int32(1);
+  EXPECT_TRUE(message->ParseFromString(small.SerializeAsString()));
+}
+
+TEST(ArenaTest, ThreadBlockCacheRecyclesBlocks) {
+  ArenaOptions options;
+  options.thread_block_cache_size = 1 << 20;
+
+  std::vector<void*> first_pointers;
+  {
+    Arena arena(options);
+    for (int i = 0; i < 100; ++i) {
+      first_pointers.push_back(Arena::CreateArray<char>(&arena, 64));
+    }
+  }
+
+  // The first block is the last one freed, so it is the first one handed out
+  // again by the thread-local cache.
+  Arena arena(options);
+  EXPECT_EQ(Arena::CreateArray<char>(&arena, 64), first_pointers[0]);
+
+  // Reset() recycles blocks through the cache as well.
+  for (int i = 0; i < 100; ++i) Arena::CreateArray<char>(&arena, 64);
+  uint64_t space_allocated = arena.SpaceAllocated();
+  EXPECT_EQ(space_allocated, arena.Reset());
+  for (int i = 0; i < 100; ++i) Arena::CreateArray<char>(&arena, 64);
+  EXPECT_EQ(space_allocated, arena.SpaceAllocated());
+}
+
+namespace {
+int custom_allocs = 0;
+int custom_deallocs = 0;
+
+void* CountingAlloc(size_t size) {
+  ++custom_allocs;
+  return ::operator new(size);
+}
+
+void CountingDealloc(void* p, size_t size) {
+  ++custom_deallocs;
+  internal::SizedDelete(p, size);
+}
+}  // namespace
+
+TEST(ArenaTest, ThreadBlockCacheIgnoredWithCustomAllocator) {
+  custom_allocs = custom_deallocs = 0;
+  ArenaOptions options;
+  options.thread_block_cache_size = 1 << 20;
+  options.block_alloc = &CountingAlloc;
+  options.block_dealloc = &CountingDealloc;
+  for (int round = 0; round < 2; ++round) {
+    Arena arena(options);
+    for (int i = 0; i < 100; ++i) Arena::CreateArray<char>(&arena, 64);
+  }
+  EXPECT_GT(custom_allocs, 2);
+  EXPECT_EQ(custom_allocs, custom_deallocs);
+}
+
+TEST(ArenaTest, NumaLocalBlocks) {
+  ArenaOptions options;
+  options.numa_local_blocks = true;
+  options.max_block_size = 1 << 20;
+  Arena arena(options);
+  TestAllTypes* message = Arena::CreateMessage<TestAllTypes>(&arena);
+  TestUtil::SetAllFields(message);
+  for (int i = 0; i < 100; ++i) {
+    memset(Arena::CreateArray<char>(&arena, 8192), 0xAB, 8192);
+  }
+  TestUtil::ExpectAllFieldsSet(*message);
+  EXPECT_GE(arena.SpaceAllocated(), 100 * 8192);
+}
+
+TEST(ArenaTest, HugePageBlocks) {
+  ArenaOptions options;
+  options.huge_page_blocks = true;
+  Arena arena(options);
+  constexpr size_t kSize = 3 << 20;
+  char* large = Arena::CreateArray<char>(&arena, kSize);
+  memset(large, 0xAB, kSize);
+  EXPECT_GE(arena.SpaceAllocated(), kSize);
+
+  // Regular allocations grow blocks past the default max block size.
+  const uint64_t space_allocated = arena.SpaceAllocated();
+  while (arena.SpaceAllocated() - space_allocated < (8 << 20)) {
+    memset(Arena::CreateArray<char>(&arena, 1024), 0xCD, 1024);
+  }
+  EXPECT_EQ(0xAB, static_cast<unsigned char>(large[kSize - 1]));
+}
+
+TEST(ArenaTest, RewindToCheckpointReusesMemory) {
+  Arena arena;
+  Arena::CreateArray<char>(&arena, 64);
+  const uint64_t space_allocated = arena.SpaceAllocated();
+  const uint64_t space_used = arena.SpaceUsed();
+
+  ArenaCheckpoint checkpoint = arena.Checkpoint();
+  void* first = Arena::CreateArray<char>(&arena, 64);
+  for (int i = 0; i < 1000; ++i) Arena::CreateArray<char>(&arena, 64);
+  EXPECT_GT(arena.SpaceAllocated(), space_allocated);
+
+  arena.RewindTo(checkpoint);
+  EXPECT_EQ(space_allocated, arena.SpaceAllocated());
+  EXPECT_EQ(space_used, arena.SpaceUsed());
+  EXPECT_EQ(first, Arena::CreateArray<char>(&arena, 64));
+}
+
+TEST(ArenaTest, RewindToCheckpointRunsCleanups) {
+  Notifier before;
+  Notifier after;
+  {
+    Arena arena;
+    Arena::Create<SimpleDataType>(&arena)->SetNotifier(&before);
+    std::string* kept = Arena::Create<std::string>(&arena, "kept");
+
+    ArenaCheckpoint checkpoint = arena.Checkpoint();
+    for (int i = 0; i < 100; ++i) {
+      Arena::Create<SimpleDataType>(&arena)->SetNotifier(&after);
+      Arena::Create<std::string>(&arena, std::string(100, 'x'));
+    }
+    arena.RewindTo(checkpoint);
+    EXPECT_EQ(0, before.GetCount());
+    EXPECT_EQ(100, after.GetCount());
+    EXPECT_EQ("kept", *kept);
+
+    // The arena remains fully usable after rewinding.
+    Arena::Create<SimpleDataType>(&arena)->SetNotifier(&after);
+    TestAllTypes* message = Arena::CreateMessage<TestAllTypes>(&arena);
+    TestUtil::SetAllFields(message);
+    TestUtil::ExpectAllFieldsSet(*message);
+  }
+  EXPECT_EQ(1, before.GetCount());
+  EXPECT_EQ(101, after.GetCount());
+}
+
+TEST(ArenaTest, FusedArenasShareLifetime) {
+  Notifier notifier;
+  auto source = std::make_unique<Arena>();
+  Arena target;
+  ASSERT_TRUE(target.Fuse(*source));
+
+  TestAllTypes* request = Arena::CreateMessage<TestAllTypes>(source.get());
+  request->mutable_optional_nested_message()->set_bb(42);
+  request->set_optional_string(std::string(100, 'x'));
+  Arena::Create<SimpleDataType>(source.get())->SetNotifier(&notifier);
+  TestAllTypes* response = Arena::CreateMessage<TestAllTypes>(&target);
+  response->unsafe_arena_set_allocated_optional_nested_message(
+      request->unsafe_arena_release_optional_nested_message());
+  response->UnsafeArenaSwap(request);
+
+  source.reset();
+  EXPECT_EQ(0, notifier.GetCount());
+  EXPECT_EQ(42, request->optional_nested_message().bb());
+  EXPECT_EQ(std::string(100, 'x'), response->optional_string());
+  target.Reset();
+  EXPECT_EQ(1, notifier.GetCount());
+}
+
+TEST(ArenaTest, FuseMergesGroups) {
+  Notifier notifier;
+  {
+    Arena a, b, c, d;
+    ASSERT_TRUE(a.Fuse(b));
+    ASSERT_TRUE(c.Fuse(d));
+    ASSERT_TRUE(b.Fuse(c));
+    EXPECT_TRUE(d.Fuse(a));
+    EXPECT_TRUE(a.Fuse(a));
+    for (Arena* arena : {&a, &b, &c, &d}) {
+      Arena::Create<SimpleDataType>(arena)->SetNotifier(&notifier);
+      Arena::Create<std::string>(arena, std::string(100, 'x'));
+    }
+
+    // A reset arena leaves the group, but its objects stay alive.
+    b.Reset();
+    EXPECT_EQ(0, notifier.GetCount());
+    Arena::Create<SimpleDataType>(&b)->SetNotifier(&notifier);
+    b.Reset();
+    EXPECT_EQ(1, notifier.GetCount());
+  }
+  EXPECT_EQ(5, notifier.GetCount());
+}
+
+TEST(ArenaTest, FuseRequiresArenaOwnedBlocks) {
+  alignas(8) char block[256];
+  Arena with_block(block, sizeof(block));
+  Arena plain;
+  EXPECT_FALSE(plain.Fuse(with_block));
+  EXPECT_FALSE(with_block.Fuse(plain));
+
+  ArenaOptions options;
+  options.start_block_size = 4096;
+  Arena with_options(options);
+  EXPECT_FALSE(plain.Fuse(with_options));
+}
+
 TEST(ArenaTest, GetArenaShouldReturnTheArenaForArenaAllocatedMessages) {
   Arena arena;
   ArenaMessage* message = Arena::CreateMessage<ArenaMessage>(&arena);
@@ -1526,6 +1858,32 @@ TEST(ArenaTest, SpaceReuseForArraysSizeChecks) {
   }
 }
 
+TEST(ArenaTest, StringBlockReusesReturnedArrays) {
+  Arena arena;
+  // The first returned array becomes the storage of the free lists.
+  internal::ArenaTestPeer::ReturnArrayMemory(
+      &arena, Arena::CreateArray<char>(&arena, 1024), 1024);
+  char* p = Arena::CreateArray<char>(&arena, 256);
+  internal::ArenaTestPeer::ReturnArrayMemory(&arena, p, 256);
+
+  // The initial string block is 256 bytes and is carved out of `p`.
+  char* s = reinterpret_cast<char*>(Arena::Create<std::string>(&arena, "abc"));
+  EXPECT_GE(s, p);
+  EXPECT_LT(s, p + 256);
+}
+
+TEST(ArenaTest, MapReturnsOldTablesToArena) {
+  Arena arena;
+  auto* map = Arena::CreateMessage<Map<int32_t, int32_t>>(&arena);
+  for (int i = 0; i < 1000; ++i) (*map)[i] = i;
+
+  // Rehashing returned the 16 entry table, so an array of that size is served
+  // without bumping the arena.
+  const uint64_t space_used = arena.SpaceUsed();
+  Arena::CreateArray<char>(&arena, 16 * sizeof(void*));
+  EXPECT_EQ(space_used, arena.SpaceUsed());
+}
+
 TEST(ArenaTest, SpaceReusePoisonsAndUnpoisonsMemory) {
 #ifdef ADDRESS_SANITIZER
   char buf[1024]{};
@@ -1566,6 +1924,121 @@ TEST(ArenaTest, SpaceReusePoisonsAndUnpoisonsMemory) {
 #endif  // ADDRESS_SANITIZER
 }
 
+TEST(ArenaTest, ArenaAllocator) {
+  Arena arena;
+  const uint64_t space_used = arena.SpaceUsed();
+  std::vector<int, ArenaAllocator<int>> ints{ArenaAllocator<int>(&arena)};
+  for (int i = 0; i < 1000; ++i) ints.push_back(i);
+  EXPECT_GE(arena.SpaceUsed(), space_used + 1000 * sizeof(int));
+  EXPECT_EQ(ints[999], 999);
+
+  // Rebound copies of the allocator share the arena.
+  ArenaAllocator<std::string> strings(ints.get_allocator());
+  EXPECT_EQ(strings.arena(), &arena);
+  EXPECT_TRUE(strings == ints.get_allocator());
+
+  // Without an arena, the heap is used.
+  std::vector<int, ArenaAllocator<int>> heap_ints;
+  heap_ints.assign(100, 1);
+  EXPECT_EQ(heap_ints.get_allocator().arena(), nullptr);
+}
+
+TEST(ArenaTest, ArenaAllocatorReusesReturnedMemory) {
+  Arena arena;
+  ArenaAllocator<char> allocator(&arena);
+  // The first block returned becomes the arena's free list itself.
+  allocator.deallocate(allocator.allocate(64), 64);
+  char* block = allocator.allocate(64);
+  allocator.deallocate(block, 64);
+  EXPECT_EQ(allocator.allocate(64), block);
+}
+
+#if defined(__cpp_lib_memory_resource)
+TEST(ArenaTest, ArenaMemoryResource) {
+  Arena arena;
+  ArenaMemoryResource resource(&arena);
+  const uint64_t space_used = arena.SpaceUsed();
+  std::pmr::vector<std::pmr::string> strings(&resource);
+  for (int i = 0; i < 100; ++i) {
+    strings.emplace_back(64, static_cast<char>('a' + i % 26));
+  }
+  EXPECT_GT(arena.SpaceUsed(), space_used);
+  EXPECT_EQ(strings[42].get_allocator().resource(), &resource);
+
+  // Over-aligned allocations are honored.
+  void* p = resource.allocate(10, 64);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 64, 0);
+  resource.deallocate(p, 10, 64);
+
+  ArenaMemoryResource other(&arena);
+  EXPECT_TRUE(resource.is_equal(resource));
+  EXPECT_FALSE(resource.is_equal(other));
+}
+#endif  // __cpp_lib_memory_resource
+
+TEST(ArenaTest, MessagePoolRecyclesArenas) {
+  using Pool = MessagePool<protobuf_unittest::TestAllTypes>;
+  const MessagePoolStats before = Pool::GetStats();
+  {
+    auto message = Pool::Acquire();
+    ASSERT_TRUE(message);
+    EXPECT_EQ(message->GetArena(), message.arena());
+    message->set_optional_int32(1);
+    Arena::Create<std::string>(message.arena(), "scratch");
+  }
+  {
+    // The arena comes back with a freshly constructed message on it.
+    auto message = Pool::Acquire();
+    EXPECT_EQ(message->GetArena(), message.arena());
+    EXPECT_FALSE(message->has_optional_int32());
+  }
+  const MessagePoolStats after = Pool::GetStats();
+  EXPECT_EQ(after.acquires - before.acquires, 2u);
+  EXPECT_EQ(after.hits - before.hits, 1u);
+  EXPECT_EQ(after.releases - before.releases, 2u);
+  Pool::ClearThreadCache();
+}
+
+TEST(ArenaTest, MessagePoolSizesFirstBlockFromUsage) {
+  using Pool = MessagePool<protobuf_unittest::ForeignMessage>;
+  const MessagePoolStats before = Pool::GetStats();
+  for (int i = 0; i < 3; ++i) {
+    auto message = Pool::Acquire();
+    Arena::CreateArray<char>(message.arena(), 20000);
+  }
+  // After the first release the first block holds a whole request, so the
+  // arena does not grow past it anymore.
+  auto message = Pool::Acquire();
+  const uint64_t allocated = message.arena()->SpaceAllocated();
+  EXPECT_GE(allocated, 20000u);
+  Arena::CreateArray<char>(message.arena(), 20000);
+  EXPECT_EQ(message.arena()->SpaceAllocated(), allocated);
+  message.reset();
+  EXPECT_FALSE(message);
+  EXPECT_EQ(Pool::GetStats().resizes - before.resizes, 1u);
+  Pool::ClearThreadCache();
+}
+
+TEST(ArenaTest, MessagePoolBoundsThreadCache) {
+  using Pool = MessagePool<protobuf_unittest::TestEmptyMessage>;
+  MessagePoolOptions options;
+  options.max_cached_per_thread = 2;
+  Pool::Configure(options);
+  const MessagePoolStats before = Pool::GetStats();
+  {
+    std::vector<Pool::Handle> messages;
+    for (int i = 0; i < 5; ++i) messages.push_back(Pool::Acquire());
+  }
+  for (int i = 0; i < 5; ++i) Pool::Acquire();
+  const MessagePoolStats after = Pool::GetStats();
+  EXPECT_EQ(after.discards - before.discards, 3u);
+  EXPECT_EQ(after.hits - before.hits, 5u);
+  EXPECT_EQ(after.acquires - before.acquires, 10u);
+  EXPECT_DOUBLE_EQ(after.hit_rate(),
+                   static_cast<double>(after.hits) / after.acquires);
+  Pool::Configure(MessagePoolOptions());
+  Pool::ClearThreadCache();
+}
 
 }  // namespace protobuf
 }  // namespace google
@@ -38,6 +38,7 @@
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/parse_context.h"
+#include "google/protobuf/string_intern_table.h"
 
 // clang-format off
 #include "google/protobuf/port_def.inc"
@@ -117,9 +118,10 @@ TaggedStringPtr CreateArenaString(Arena& arena, absl::string_view s) {
 
 void ArenaStringPtr::Set(absl::string_view value, Arena* arena) {
   ScopedCheckPtrInvariants check(&tagged_ptr_);
-  if (IsDefault()) {
+  if (IsDefault() || IsFixedSizeArena()) {
     // If we're not on an arena, skip straight to a true string to avoid
-    // possible copy cost later.
+    // possible copy cost later. Fixed size arena strings can't be assigned
+    // in place, their old contents stay with the arena.
     tagged_ptr_ = arena != nullptr ? CreateArenaString(*arena, value)
                                    : CreateString(value);
   } else {
@@ -142,9 +144,10 @@ void ArenaStringPtr::Set(absl::string_view value, Arena* arena) {
 template <>
 void ArenaStringPtr::Set(const std::string& value, Arena* arena) {
   ScopedCheckPtrInvariants check(&tagged_ptr_);
-  if (IsDefault()) {
+  if (IsDefault() || IsFixedSizeArena()) {
     // If we're not on an arena, skip straight to a true string to avoid
-    // possible copy cost later.
+    // possible copy cost later. Fixed size arena strings can't be assigned
+    // in place, their old contents stay with the arena.
     tagged_ptr_ = arena != nullptr ? CreateArenaString(*arena, value)
                                    : CreateString(value);
   } else {
@@ -169,10 +172,8 @@ void ArenaStringPtr::Set(std::string&& value, Arena* arena) {
   if (IsDefault()) {
     NewString(arena, std::move(value));
   } else if (IsFixedSizeArena()) {
-    std::string* current = tagged_ptr_.Get();
-    auto* s = new (current) std::string(std::move(value));
-    arena->OwnDestructor(s);
-    tagged_ptr_.SetMutableArena(s);
+    // The current value may be shared, so it can't be reused in place.
+    NewString(arena, std::move(value));
   } else /* !IsFixedSizeArena() */ {
     *UnsafeMutablePointer() = std::move(value);
   }
@@ -202,7 +203,7 @@ std::string* ArenaStringPtr::MutableNoCopy(Arena* arena) {
   if (tagged_ptr_.IsMutable()) {
     return tagged_ptr_.Get();
   } else {
-    ABSL_DCHECK(IsDefault());
+    ABSL_DCHECK(IsDefault() || IsFixedSizeArena());
     // Allocate empty. The contents are not relevant.
     return NewString(arena);
   }
@@ -211,6 +212,11 @@ std::string* ArenaStringPtr::MutableNoCopy(Arena* arena) {
 template <typename... Lazy>
 std::string* ArenaStringPtr::MutableSlow(::google::protobuf::Arena* arena,
                                          const Lazy&... lazy_default) {
+  if (IsFixedSizeArena()) {
+    // Fixed size arena strings can't grow: continue on a mutable copy.
+    ABSL_DCHECK(arena != nullptr);
+    return NewString(arena, *tagged_ptr_.Get());
+  }
   ABSL_DCHECK(IsDefault());
 
   // For empty defaults, this ends up calling the default constructor which is
@@ -260,6 +266,9 @@ void ArenaStringPtr::ClearToEmpty() {
   ScopedCheckPtrInvariants check(&tagged_ptr_);
   if (IsDefault()) {
     // Already set to default -- do nothing.
+  } else if (IsFixedSizeArena()) {
+    // Possibly shared: drop it rather than clearing it in place.
+    InitDefault();
   } else {
     // Unconditionally mask away the tag.
     //
@@ -276,6 +285,8 @@ void ArenaStringPtr::ClearToDefault(const LazyString& default_value,
   (void)arena;
   if (IsDefault()) {
     // Already set to default -- do nothing.
+  } else if (IsFixedSizeArena()) {
+    NewString(arena, default_value.get());
   } else {
     UnsafeMutablePointer()->assign(default_value.get());
   }
@@ -290,6 +301,16 @@ const char* EpsCopyInputStream::ReadArenaString(const char* ptr,
   int size = ReadSize(&ptr);
   if (!ptr) return nullptr;
 
+  if (size <= buffer_end_ + kSlopBytes - ptr) {
+    if (StringInternTable* table = arena->impl_.string_intern_table()) {
+      if (const std::string* interned =
+              table->Intern(absl::string_view(ptr, size))) {
+        s->tagged_ptr_.SetFixedSizeArena(const_cast<std::string*>(interned));
+        return ptr + size;
+      }
+    }
+  }
+
   auto* str = s->NewString(arena);
   ptr = ReadString(ptr, size, str);
   GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
@@ -121,10 +121,10 @@ class TaggedStringPtr {
 
     // Fixed size arena strings are strings where both the string instance and
     // the string contents are fully owned by the arena. Fixed size arena
-    // strings are a platform and c++ library specific customization. Fixed
-    // size arena strings are immutable, with the exception of custom internal
-    // updates to the content that fit inside the existing capacity.
-    // Fixed size arena strings must never be deleted or destroyed.
+    // strings are a platform and c++ library specific customization. Strings
+    // interned in a StringInternTable are held the same way, and may be shared
+    // by many fields. Fixed size arena strings are immutable and must never be
+    // deleted or destroyed.
     kFixedSizeArena = kArenaBit,
   };
 
@@ -370,7 +370,7 @@ struct PROTOBUF_EXPORT ArenaStringPtr {
 
   TaggedStringPtr tagged_ptr_;
 
-  bool IsFixedSizeArena() const { return false; }
+  bool IsFixedSizeArena() const { return tagged_ptr_.IsFixedSizeArena(); }
 
   // Swaps tagged pointer without debug hardening. This is to allow python
   // protobuf to maintain pointer stability even in DEBUG builds.
@@ -473,6 +473,11 @@ inline PROTOBUF_NDEBUG_INLINE void ArenaStringPtr::InternalSwap(  //
 }
 
 inline void ArenaStringPtr::ClearNonDefaultToEmpty() {
+  if (PROTOBUF_PREDICT_FALSE(IsFixedSizeArena())) {
+    // Possibly shared: drop it rather than clearing it in place.
+    InitDefault();
+    return;
+  }
   // Unconditionally mask away the tag.
   tagged_ptr_.Get()->clear();
 }
@@ -110,6 +110,36 @@ TEST_P(SingleArena, NullDefault) {
   field.Destroy();
 }
 
+TEST_P(SingleArena, MutateLongValue) {
+  // Values too long for the inline buffer of std::string.
+  auto arena = GetArena();
+  const std::string value = "Test long long long long value";
+  ArenaStringPtr field;
+  field.InitDefault();
+
+  field.Set(value, arena.get());
+  field.Mutable(arena.get())->append(" and more");
+  EXPECT_EQ(value + " and more", field.Get());
+
+  field.Set(absl::string_view(value), arena.get());
+  *field.MutableNoCopy(arena.get()) = "x";
+  EXPECT_EQ("x", field.Get());
+
+  field.Set(value, arena.get());
+  field.ClearToEmpty();
+  EXPECT_EQ("", field.Get());
+
+  field.Set(value, arena.get());
+  field.ClearToDefault(nonempty_default, arena.get());
+  EXPECT_EQ("default", field.Get());
+
+  field.Set(value, arena.get());
+  std::unique_ptr<std::string> released(field.Release());
+  EXPECT_EQ(value, *released);
+  EXPECT_EQ("", field.Get());
+  field.Destroy();
+}
+
 class DualArena : public testing::TestWithParam<std::tuple<bool, bool>> {
  public:
   std::unique_ptr<Arena> GetLhsArena() {
@@ -30,10 +30,17 @@
 
 #include "google/protobuf/arenaz_sampler.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <limits>
+#include <string>
 #include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 
 
 // Must be included last.
@@ -57,6 +64,7 @@ namespace {
 
 PROTOBUF_CONSTINIT std::atomic<bool> g_arenaz_enabled{true};
 PROTOBUF_CONSTINIT std::atomic<int32_t> g_arenaz_sample_parameter{1 << 10};
+PROTOBUF_CONSTINIT std::atomic<bool> g_arenaz_type_profile_enabled{false};
 PROTOBUF_CONSTINIT std::atomic<ThreadSafeArenazConfigListener>
     g_arenaz_config_listener{nullptr};
 PROTOBUF_THREAD_LOCAL absl::profiling_internal::ExponentialBiased
@@ -82,10 +90,25 @@ void ThreadSafeArenaStats::BlockStats::PrepareForSampling() {
   bytes_wasted.store(0, std::memory_order_relaxed);
 }
 
+void ThreadSafeArenaStats::CachedBlockStats::PrepareForSampling() {
+  hits.store(0, std::memory_order_relaxed);
+  misses.store(0, std::memory_order_relaxed);
+}
+
 void ThreadSafeArenaStats::PrepareForSampling(int64_t stride) {
   for (auto& blockstats : block_histogram) blockstats.PrepareForSampling();
+  for (auto& classstats : cached_block_classes) {
+    classstats.PrepareForSampling();
+  }
   max_block_size.store(0, std::memory_order_relaxed);
   thread_ids.store(0, std::memory_order_relaxed);
+  num_block_cache_hits.store(0, std::memory_order_relaxed);
+  bytes_from_block_cache.store(0, std::memory_order_relaxed);
+  bytes_from_huge_pages.store(0, std::memory_order_relaxed);
+  {
+    absl::MutexLock lock(&type_mu);
+    type_histogram.clear();
+  }
   weight = stride;
   // The inliner makes hardcoded skip_count difficult (especially when combined
   // with LTO).  We use the ability to exclude stacks by regex when encoding
@@ -135,6 +158,34 @@ void RecordAllocateSlow(ThreadSafeArenaStats* info, size_t used,
   info->thread_ids.fetch_or(tid, std::memory_order_relaxed);
 }
 
+void RecordBlockCacheHitSlow(ThreadSafeArenaStats* info, size_t bytes) {
+  info->num_block_cache_hits.fetch_add(1, std::memory_order_relaxed);
+  info->bytes_from_block_cache.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void RecordHugePageAllocationSlow(ThreadSafeArenaStats* info, size_t bytes) {
+  info->bytes_from_huge_pages.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void RecordCachedBlockLookupSlow(ThreadSafeArenaStats* info, size_t size_class,
+                                 bool hit) {
+  size_class = std::min(size_class,
+                        ThreadSafeArenaStats::kCachedBlockSizeClasses - 1);
+  ThreadSafeArenaStats::CachedBlockStats& stats =
+      info->cached_block_classes[size_class];
+  (hit ? stats.hits : stats.misses).fetch_add(1, std::memory_order_relaxed);
+}
+
+void RecordTypeAllocationSlow(ThreadSafeArenaStats* info,
+                              ArenazTypeNameFn type_name, size_t bytes) {
+  if (!g_arenaz_type_profile_enabled.load(std::memory_order_relaxed)) return;
+  absl::string_view name = type_name();
+  absl::MutexLock lock(&info->type_mu);
+  ThreadSafeArenaStats::TypeStats& stats = info->type_histogram[name];
+  ++stats.num_allocations;
+  stats.bytes_allocated += bytes;
+}
+
 ThreadSafeArenaStats* SampleSlow(SamplingState& sampling_state) {
   bool first = sampling_state.next_sample < 0;
   const int64_t next_stride = g_exponential_biased_generator.GetStride(
@@ -222,6 +273,56 @@ void SetThreadSafeArenazGlobalNextSample(int64_t next_sample) {
   }
 }
 
+void SetThreadSafeArenazTypeProfileEnabled(bool enabled) {
+  g_arenaz_type_profile_enabled.store(enabled, std::memory_order_release);
+  TriggerThreadSafeArenazConfigListener();
+}
+
+bool IsThreadSafeArenazTypeProfileEnabled() {
+  return g_arenaz_type_profile_enabled.load(std::memory_order_acquire);
+}
+
+std::string ThreadSafeArenazTypeProfile() {
+  absl::flat_hash_map<absl::string_view, ThreadSafeArenaStats::TypeStats>
+      totals;
+  GlobalThreadSafeArenazSampler().Iterate(
+      [&](const ThreadSafeArenaStats& info) {
+        const size_t weight =
+            static_cast<size_t>(std::max<int64_t>(info.weight, 1));
+        absl::MutexLock lock(&info.type_mu);
+        for (const auto& entry : info.type_histogram) {
+          ThreadSafeArenaStats::TypeStats& total = totals[entry.first];
+          total.num_allocations += entry.second.num_allocations * weight;
+          total.bytes_allocated += entry.second.bytes_allocated * weight;
+        }
+      });
+
+  std::vector<std::pair<absl::string_view, ThreadSafeArenaStats::TypeStats>>
+      sorted(totals.begin(), totals.end());
+  std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+    if (a.second.bytes_allocated != b.second.bytes_allocated) {
+      return a.second.bytes_allocated > b.second.bytes_allocated;
+    }
+    return a.first < b.first;
+  });
+
+  ThreadSafeArenaStats::TypeStats sum;
+  for (const auto& entry : sorted) {
+    sum.num_allocations += entry.second.num_allocations;
+    sum.bytes_allocated += entry.second.bytes_allocated;
+  }
+  std::string out = absl::StrCat(
+      "heap profile: ", sum.num_allocations, ": ", sum.bytes_allocated, " [",
+      sum.num_allocations, ": ", sum.bytes_allocated, "] @ arenaz_types\n");
+  for (const auto& entry : sorted) {
+    absl::StrAppend(&out, entry.second.num_allocations, ": ",
+                    entry.second.bytes_allocated, " [",
+                    entry.second.num_allocations, ": ",
+                    entry.second.bytes_allocated, "] @ ", entry.first, "\n");
+  }
+  return out;
+}
+
 #else
 ThreadSafeArenaStats* SampleSlow(int64_t* next_sample) {
   *next_sample = std::numeric_limits<int64_t>::max();
@@ -239,6 +340,11 @@ void SetThreadSafeArenazMaxSamples(int32_t max) {}
 void SetThreadSafeArenazMaxSamplesInternal(int32_t max) {}
 size_t ThreadSafeArenazMaxSamples() { return 0; }
 void SetThreadSafeArenazGlobalNextSample(int64_t next_sample) {}
+void SetThreadSafeArenazTypeProfileEnabled(bool enabled) {}
+bool IsThreadSafeArenazTypeProfileEnabled() { return false; }
+std::string ThreadSafeArenazTypeProfile() {
+  return "heap profile: 0: 0 [0: 0] @ arenaz_types\n";
+}
 #endif  // defined(PROTOBUF_ARENAZ_SAMPLE)
 
 }  // namespace internal
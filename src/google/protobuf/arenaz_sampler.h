@@ -35,8 +35,12 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <string>
 #include <utility>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -45,10 +49,20 @@ namespace google {
 namespace protobuf {
 namespace internal {
 
+// Returns the name an allocation is attributed to in the type profile. It is
+// only called for sampled arenas while the type profile is enabled.
+using ArenazTypeNameFn = absl::string_view (*)();
+
 #if defined(PROTOBUF_ARENAZ_SAMPLE)
 struct ThreadSafeArenaStats;
 void RecordAllocateSlow(ThreadSafeArenaStats* info, size_t used,
                         size_t allocated, size_t wasted);
+void RecordBlockCacheHitSlow(ThreadSafeArenaStats* info, size_t bytes);
+void RecordHugePageAllocationSlow(ThreadSafeArenaStats* info, size_t bytes);
+void RecordCachedBlockLookupSlow(ThreadSafeArenaStats* info, size_t size_class,
+                                 bool hit);
+void RecordTypeAllocationSlow(ThreadSafeArenaStats* info,
+                              ArenazTypeNameFn type_name, size_t bytes);
 // Stores information about a sampled thread safe arena.  All mutations to this
 // *must* be made through `Record*` functions below.  All reads from this *must*
 // only occur in the callback to `ThreadSafeArenazSampler::Iterate`.
@@ -89,6 +103,19 @@ struct ThreadSafeArenaStats
       1 << (kLogMaxSizeForBinZero + kBlockHistogramBins - 2);
   std::array<BlockStats, kBlockHistogramBins> block_histogram;
 
+  // Hits and misses of the per-SerialArena free lists of returned arrays
+  // (repeated field, map and string block memory). Size class `i` serves
+  // requests of up to `16 << i` bytes; the final class also counts all larger
+  // requests.
+  struct CachedBlockStats {
+    std::atomic<size_t> hits;
+    std::atomic<size_t> misses;
+
+    void PrepareForSampling();
+  };
+  static constexpr size_t kCachedBlockSizeClasses = 16;
+  std::array<CachedBlockStats, kCachedBlockSizeClasses> cached_block_classes;
+
   // Records the largest block allocated for the arena.
   std::atomic<size_t> max_block_size;
   // Bit `i` is set to 1 indicates that a thread with `tid % 63 = i` accessed
@@ -96,6 +123,23 @@ struct ThreadSafeArenaStats
   // bit mixing for thread-ids; `% 64` would only grab the low bits and might
   // create sampling artifacts.
   std::atomic<uint64_t> thread_ids;
+  // Number of blocks, and their total size in bytes, that were served from the
+  // thread-local block cache instead of the system allocator.
+  std::atomic<size_t> num_block_cache_hits;
+  std::atomic<size_t> bytes_from_block_cache;
+  // Total size in bytes of the blocks backed by huge pages.
+  std::atomic<size_t> bytes_from_huge_pages;
+
+  // Number of allocations, and their total size in bytes, per message type
+  // (or container kind for repeated field, map and string storage). Only
+  // filled in while `IsThreadSafeArenazTypeProfileEnabled()`.
+  struct TypeStats {
+    size_t num_allocations = 0;
+    size_t bytes_allocated = 0;
+  };
+  mutable absl::Mutex type_mu;
+  absl::flat_hash_map<absl::string_view, TypeStats> type_histogram
+      ABSL_GUARDED_BY(type_mu);
 
   // All of the fields below are set by `PrepareForSampling`, they must not
   // be mutated in `Record*` functions.  They are logically `const` in that
@@ -110,6 +154,25 @@ struct ThreadSafeArenaStats
     if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
     RecordAllocateSlow(info, used, allocated, wasted);
   }
+  static void RecordBlockCacheHit(ThreadSafeArenaStats* info, size_t bytes) {
+    if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
+    RecordBlockCacheHitSlow(info, bytes);
+  }
+  static void RecordHugePageAllocation(ThreadSafeArenaStats* info,
+                                       size_t bytes) {
+    if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
+    RecordHugePageAllocationSlow(info, bytes);
+  }
+  static void RecordCachedBlockLookup(ThreadSafeArenaStats* info,
+                                      size_t size_class, bool hit) {
+    if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
+    RecordCachedBlockLookupSlow(info, size_class, hit);
+  }
+  static void RecordTypeAllocation(ThreadSafeArenaStats* info,
+                                   ArenazTypeNameFn type_name, size_t bytes) {
+    if (PROTOBUF_PREDICT_TRUE(info == nullptr)) return;
+    RecordTypeAllocationSlow(info, type_name, bytes);
+  }
 
   // Returns the bin for the provided size.
   static size_t FindBin(size_t bytes);
@@ -190,6 +253,13 @@ using SamplingState = int64_t;
 struct ThreadSafeArenaStats {
   static void RecordAllocateStats(ThreadSafeArenaStats*, size_t /*requested*/,
                                   size_t /*allocated*/, size_t /*wasted*/) {}
+  static void RecordBlockCacheHit(ThreadSafeArenaStats*, size_t /*bytes*/) {}
+  static void RecordHugePageAllocation(ThreadSafeArenaStats*,
+                                       size_t /*bytes*/) {}
+  static void RecordCachedBlockLookup(ThreadSafeArenaStats*,
+                                      size_t /*size_class*/, bool /*hit*/) {}
+  static void RecordTypeAllocation(ThreadSafeArenaStats*, ArenazTypeNameFn,
+                                   size_t /*bytes*/) {}
 };
 
 ThreadSafeArenaStats* SampleSlow(SamplingState& next_sample);
@@ -253,6 +323,25 @@ size_t ThreadSafeArenazMaxSamples();
 // Sets the current value for when arenas should be next sampled.
 void SetThreadSafeArenazGlobalNextSample(int64_t next_sample);
 
+// Enables or disables attributing the allocations of sampled arenas to the
+// message types (and repeated field, map and string storage) they were made
+// for. Off by default, as it takes a lock per allocation on sampled arenas.
+void SetThreadSafeArenazTypeProfileEnabled(bool enabled);
+
+// Returns true if the type profile is collected, false otherwise.
+bool IsThreadSafeArenazTypeProfileEnabled();
+
+// Returns the type profile of all live sampled arenas in the legacy pprof
+// heap profile text format, with the type name standing in for the stack:
+//
+//   heap profile: <count>: <bytes> [<count>: <bytes>] @ arenaz_types
+//   <count>: <bytes> [<count>: <bytes>] @ <type name>
+//   ...
+//
+// Counts are scaled by the sampling weight of each arena, so they estimate
+// the totals over all arenas. Types are ordered by decreasing bytes.
+std::string ThreadSafeArenazTypeProfile();
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
@@ -101,6 +101,9 @@ TEST(ThreadSafeArenaStatsTest, PrepareForSampling) {
     EXPECT_EQ(block_stats.bytes_wasted.load(std::memory_order_relaxed), 0);
   }
   EXPECT_EQ(info.max_block_size.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.num_block_cache_hits.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.bytes_from_block_cache.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.bytes_from_huge_pages.load(std::memory_order_relaxed), 0);
   EXPECT_EQ(info.weight, kTestStride);
 
   for (auto& block_stats : info.block_histogram) {
@@ -110,6 +113,9 @@ TEST(ThreadSafeArenaStatsTest, PrepareForSampling) {
     block_stats.bytes_wasted.store(1, std::memory_order_relaxed);
   }
   info.max_block_size.store(1, std::memory_order_relaxed);
+  info.num_block_cache_hits.store(1, std::memory_order_relaxed);
+  info.bytes_from_block_cache.store(1, std::memory_order_relaxed);
+  info.bytes_from_huge_pages.store(1, std::memory_order_relaxed);
 
   info.PrepareForSampling(2 * kTestStride);
   for (auto& block_stats : info.block_histogram) {
@@ -119,9 +125,108 @@ TEST(ThreadSafeArenaStatsTest, PrepareForSampling) {
     EXPECT_EQ(block_stats.bytes_wasted.load(std::memory_order_relaxed), 0);
   }
   EXPECT_EQ(info.max_block_size.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.num_block_cache_hits.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.bytes_from_block_cache.load(std::memory_order_relaxed), 0);
+  EXPECT_EQ(info.bytes_from_huge_pages.load(std::memory_order_relaxed), 0);
   EXPECT_EQ(info.weight, 2 * kTestStride);
 }
 
+TEST(ThreadSafeArenaStatsTest, RecordBlockCacheHitSlow) {
+  ThreadSafeArenaStats info;
+  constexpr int64_t kTestStride = 458;
+  absl::MutexLock l(&info.init_mu);
+  info.PrepareForSampling(kTestStride);
+  RecordBlockCacheHitSlow(&info, /*bytes=*/256);
+  RecordBlockCacheHitSlow(&info, /*bytes=*/512);
+  EXPECT_EQ(info.num_block_cache_hits.load(std::memory_order_relaxed), 2);
+  EXPECT_EQ(info.bytes_from_block_cache.load(std::memory_order_relaxed), 768);
+}
+
+TEST(ThreadSafeArenaStatsTest, RecordCachedBlockLookupSlow) {
+  ThreadSafeArenaStats info;
+  constexpr int64_t kTestStride = 458;
+  absl::MutexLock l(&info.init_mu);
+  info.PrepareForSampling(kTestStride);
+  RecordCachedBlockLookupSlow(&info, /*size_class=*/0, /*hit=*/true);
+  RecordCachedBlockLookupSlow(&info, /*size_class=*/0, /*hit=*/false);
+  RecordCachedBlockLookupSlow(&info, /*size_class=*/0, /*hit=*/false);
+  RecordCachedBlockLookupSlow(&info, /*size_class=*/63, /*hit=*/true);
+  EXPECT_EQ(info.cached_block_classes[0].hits.load(std::memory_order_relaxed),
+            1);
+  EXPECT_EQ(
+      info.cached_block_classes[0].misses.load(std::memory_order_relaxed), 2);
+  EXPECT_EQ(info.cached_block_classes.back().hits.load(
+                std::memory_order_relaxed),
+            1);
+
+  info.PrepareForSampling(kTestStride);
+  for (const auto& class_stats : info.cached_block_classes) {
+    EXPECT_EQ(class_stats.hits.load(std::memory_order_relaxed), 0);
+    EXPECT_EQ(class_stats.misses.load(std::memory_order_relaxed), 0);
+  }
+}
+
+TEST(ThreadSafeArenaStatsTest, RecordHugePageAllocationSlow) {
+  ThreadSafeArenaStats info;
+  constexpr int64_t kTestStride = 458;
+  absl::MutexLock l(&info.init_mu);
+  info.PrepareForSampling(kTestStride);
+  RecordHugePageAllocationSlow(&info, /*bytes=*/2 << 20);
+  RecordHugePageAllocationSlow(&info, /*bytes=*/4 << 20);
+  EXPECT_EQ(info.bytes_from_huge_pages.load(std::memory_order_relaxed),
+            6 << 20);
+}
+
+TEST(ThreadSafeArenaStatsTest, RecordTypeAllocationSlow) {
+  ThreadSafeArenaStats info;
+  constexpr int64_t kTestStride = 458;
+  absl::MutexLock l(&info.init_mu);
+  info.PrepareForSampling(kTestStride);
+  auto foo = [] { return absl::string_view("Foo"); };
+  auto bar = [] { return absl::string_view("Bar"); };
+
+  // Nothing is recorded unless the type profile is enabled.
+  RecordTypeAllocationSlow(&info, foo, 16);
+  {
+    absl::MutexLock type_lock(&info.type_mu);
+    EXPECT_TRUE(info.type_histogram.empty());
+  }
+
+  SetThreadSafeArenazTypeProfileEnabled(true);
+  RecordTypeAllocationSlow(&info, foo, 16);
+  RecordTypeAllocationSlow(&info, foo, 32);
+  RecordTypeAllocationSlow(&info, bar, 8);
+  SetThreadSafeArenazTypeProfileEnabled(false);
+  {
+    absl::MutexLock type_lock(&info.type_mu);
+    ASSERT_EQ(info.type_histogram.size(), 2);
+    EXPECT_EQ(info.type_histogram["Foo"].num_allocations, 2);
+    EXPECT_EQ(info.type_histogram["Foo"].bytes_allocated, 48);
+    EXPECT_EQ(info.type_histogram["Bar"].num_allocations, 1);
+    EXPECT_EQ(info.type_histogram["Bar"].bytes_allocated, 8);
+  }
+
+  info.PrepareForSampling(kTestStride);
+  absl::MutexLock type_lock(&info.type_mu);
+  EXPECT_TRUE(info.type_histogram.empty());
+}
+
+TEST(ThreadSafeArenazSamplerTest, TypeProfile) {
+  SetThreadSafeArenazTypeProfileEnabled(true);
+  ThreadSafeArenazSampler& sampler = GlobalThreadSafeArenazSampler();
+  ThreadSafeArenaStats* info = sampler.Register(/*weight=*/2);
+  RecordTypeAllocationSlow(
+      info, [] { return absl::string_view("Small"); }, 8);
+  RecordTypeAllocationSlow(
+      info, [] { return absl::string_view("Large"); }, 100);
+  SetThreadSafeArenazTypeProfileEnabled(false);
+
+  EXPECT_THAT(ThreadSafeArenazTypeProfile(),
+              ::testing::HasSubstr("2: 200 [2: 200] @ Large\n"
+                                   "2: 16 [2: 16] @ Small\n"));
+  sampler.Unregister(info);
+}
+
 TEST(ThreadSafeArenaStatsTest, FindBin) {
   size_t current_bin = 0;
   size_t bytes = 1;
@@ -0,0 +1,205 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Tests for repeated bool fields generated with the bitpacked_fields option.
+// unittest_bitpacked_lite.proto is also generated with
+// table_driven_serialization, which must leave TestBitPackedLite out.
+
+#include <string>
+#include <type_traits>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/arena.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/repeated_bit_field.h"
+#include "google/protobuf/unittest_bitpacked_lite.pb.h"
+#include "google/protobuf/wire_format_lite.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using ::protobuf_unittest::TestBitPackedLite;
+using ::protobuf_unittest::TestBitPackedLiteReference;
+using internal::WireFormatLite;
+
+static_assert(std::is_same<decltype(std::declval<const TestBitPackedLite&>()
+                                        .packed_flags()),
+                           const RepeatedBitField&>::value,
+              "bit-packed fields are stored as a RepeatedBitField");
+
+// Spans a few 64-bit words, with a partial last one.
+constexpr int kNumFlags = 150;
+
+bool FlagAt(int i) { return i % 3 == 0 || i % 7 == 0; }
+
+TestBitPackedLiteReference MakeReference() {
+  TestBitPackedLiteReference reference;
+  reference.set_id(42);
+  reference.set_name("flags");
+  for (int i = 0; i < kNumFlags; ++i) {
+    reference.add_packed_flags(FlagAt(i));
+    reference.add_unpacked_flags(!FlagAt(i));
+  }
+  return reference;
+}
+
+void ExpectFlagsSet(const TestBitPackedLite& message) {
+  EXPECT_EQ(message.id(), 42);
+  EXPECT_EQ(message.name(), "flags");
+  ASSERT_EQ(message.packed_flags_size(), kNumFlags);
+  ASSERT_EQ(message.unpacked_flags_size(), kNumFlags);
+  for (int i = 0; i < kNumFlags; ++i) {
+    EXPECT_EQ(message.packed_flags(i), FlagAt(i)) << i;
+    EXPECT_EQ(message.unpacked_flags(i), !FlagAt(i)) << i;
+  }
+}
+
+TEST(BitPackedLiteTest, Accessors) {
+  TestBitPackedLite message;
+  EXPECT_EQ(message.packed_flags_size(), 0);
+  message.add_packed_flags(true);
+  message.add_packed_flags(false);
+  message.add_packed_flags(true);
+  EXPECT_EQ(message.packed_flags_size(), 3);
+  EXPECT_TRUE(message.packed_flags(0));
+  EXPECT_FALSE(message.packed_flags(1));
+  message.set_packed_flags(1, true);
+  message.set_packed_flags(2, false);
+  EXPECT_TRUE(message.packed_flags(1));
+  EXPECT_FALSE(message.packed_flags(2));
+  EXPECT_EQ(message.packed_flags().size(), 3);
+
+  message.mutable_packed_flags()->RemoveLast();
+  EXPECT_EQ(message.packed_flags_size(), 2);
+  message.clear_packed_flags();
+  EXPECT_EQ(message.packed_flags_size(), 0);
+}
+
+TEST(BitPackedLiteTest, SameWireFormatAsRepeatedBool) {
+  const TestBitPackedLiteReference reference = MakeReference();
+  const std::string serialized = reference.SerializeAsString();
+
+  TestBitPackedLite message;
+  ASSERT_TRUE(message.ParseFromString(serialized));
+  ExpectFlagsSet(message);
+  EXPECT_EQ(message.ByteSizeLong(), serialized.size());
+  EXPECT_EQ(message.SerializeAsString(), serialized);
+}
+
+TEST(BitPackedLiteTest, ParseEitherEncoding) {
+  // The packed field arrives unpacked and the unpacked one packed, as both
+  // encodings are valid for either.
+  std::string data;
+  {
+    io::StringOutputStream stream(&data);
+    io::CodedOutputStream out(&stream);
+    for (int i = 0; i < kNumFlags; ++i) {
+      WireFormatLite::WriteBool(2, FlagAt(i), &out);
+    }
+    WireFormatLite::WriteTag(3, WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+                             &out);
+    out.WriteVarint32(kNumFlags);
+    for (int i = 0; i < kNumFlags; ++i) {
+      WireFormatLite::WriteBoolNoTag(!FlagAt(i), &out);
+    }
+    WireFormatLite::WriteInt32(1, 42, &out);
+    WireFormatLite::WriteString(4, "flags", &out);
+  }
+
+  TestBitPackedLite message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  ExpectFlagsSet(message);
+
+  // Serializing uses the declared encodings again.
+  EXPECT_EQ(message.SerializeAsString(), MakeReference().SerializeAsString());
+}
+
+TEST(BitPackedLiteTest, ParseFromChunkedStream) {
+  const std::string serialized = MakeReference().SerializeAsString();
+  io::ArrayInputStream input(serialized.data(),
+                             static_cast<int>(serialized.size()),
+                             /*block_size=*/7);
+  TestBitPackedLite message;
+  ASSERT_TRUE(message.ParseFromZeroCopyStream(&input));
+  ExpectFlagsSet(message);
+}
+
+TEST(BitPackedLiteTest, RejectsTruncatedPackedField) {
+  std::string serialized = MakeReference().SerializeAsString();
+  TestBitPackedLite message;
+  // Cuts into the packed flags, which come right after the id.
+  EXPECT_FALSE(message.ParseFromString(serialized.substr(0, 10)));
+}
+
+TEST(BitPackedLiteTest, CopyMergeAndSwap) {
+  TestBitPackedLite message;
+  ASSERT_TRUE(message.ParseFromString(MakeReference().SerializeAsString()));
+
+  TestBitPackedLite copy(message);
+  ExpectFlagsSet(copy);
+
+  TestBitPackedLite merged;
+  merged.add_packed_flags(true);
+  merged.MergeFrom(message);
+  EXPECT_EQ(merged.packed_flags_size(), kNumFlags + 1);
+  EXPECT_TRUE(merged.packed_flags(0));
+  for (int i = 0; i < kNumFlags; ++i) {
+    EXPECT_EQ(merged.packed_flags(i + 1), FlagAt(i)) << i;
+  }
+
+  TestBitPackedLite other;
+  other.Swap(&copy);
+  ExpectFlagsSet(other);
+  EXPECT_EQ(copy.packed_flags_size(), 0);
+
+  other.Clear();
+  EXPECT_EQ(other.packed_flags_size(), 0);
+  EXPECT_EQ(other.unpacked_flags_size(), 0);
+  EXPECT_EQ(other.ByteSizeLong(), 0);
+}
+
+TEST(BitPackedLiteTest, OnArena) {
+  Arena arena;
+  auto* message = Arena::CreateMessage<TestBitPackedLite>(&arena);
+  const std::string serialized = MakeReference().SerializeAsString();
+  ASSERT_TRUE(message->ParseFromString(serialized));
+  ExpectFlagsSet(*message);
+  EXPECT_EQ(message->SerializeAsString(), serialized);
+
+  auto* copy = Arena::CreateMessage<TestBitPackedLite>(&arena);
+  copy->CopyFrom(*message);
+  ExpectFlagsSet(*copy);
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
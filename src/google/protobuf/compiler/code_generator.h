@@ -119,6 +119,14 @@ class PROTOC_EXPORT CodeGenerator {
   // This must be a bitwise OR of values from the Feature enum above (or zero).
   virtual uint64_t GetSupportedFeatures() const { return 0; }
 
+  // Implement this to return true if Generate() may be called concurrently
+  // for different files, each time with a separate GeneratorContext. The
+  // output for one file must then not open, append to or insert into the
+  // output of another. When protoc is run with --jobs, it calls Generate()
+  // for all files in parallel instead of calling GenerateAll(), and merges
+  // their outputs in file order.
+  virtual bool SupportsConcurrentGenerate() const { return false; }
+
   // This is no longer used, but this class is part of the opensource protobuf
   // library, so it has to remain to keep vtables the same for the current
   // version of the library. When protobufs does a api breaking change, the
@@ -180,6 +188,12 @@ class PROTOC_EXPORT GeneratorContext {
   // this GeneratorContext.
   virtual void GetCompilerVersion(Version* version) const;
 
+  // Returns how many threads a generator may use within one call to
+  // Generate() or GenerateAll(), as granted by protoc's --jobs. Generators
+  // may render independent outputs concurrently, but must still open them
+  // from the calling thread, in an order that does not depend on scheduling.
+  virtual int GetMaxJobs() const { return 1; }
+
 };
 
 // The type GeneratorContext was once called OutputDirectory. This typedef
@@ -60,6 +60,8 @@
 #include <ctype.h>
 #include <errno.h>
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 
@@ -67,6 +69,7 @@
 
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -80,12 +83,16 @@
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "google/protobuf/compiler/code_generator.h"
 #include "google/protobuf/compiler/importer.h"
 #include "google/protobuf/compiler/plugin.pb.h"
@@ -349,6 +356,28 @@ void GetTransitiveDependencies(
   }
 }
 
+// Calls task(i) for every i in [0, count) on up to `jobs` threads, the
+// calling one included, and returns false if any call did. Once a call has
+// failed, the tasks that have not started yet are skipped.
+bool RunTasks(int jobs, size_t count, absl::FunctionRef<bool(size_t)> task) {
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+  auto work = [&] {
+    while (!failed.load(std::memory_order_relaxed)) {
+      const size_t i = next.fetch_add(1, std::memory_order_relaxed);
+      if (i >= count) return;
+      if (!task(i)) failed.store(true, std::memory_order_relaxed);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < std::min(static_cast<size_t>(jobs), count); ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (std::thread& thread : threads) thread.join();
+  return !failed.load();
+}
+
 }  // namespace
 
 // A MultiFileErrorCollector that prints errors to stderr.
@@ -460,8 +489,9 @@ class CommandLineInterface::GeneratorContextImpl : public GeneratorContext {
   bool WriteAllToDisk(const std::string& prefix);
 
   // Write the contents of this directory to a ZIP-format archive with the
-  // given name.
-  bool WriteAllToZip(const std::string& filename);
+  // given name, compressing entries on up to `jobs` threads.  The contents of
+  // each file are released once it is written; only the names remain.
+  bool WriteAllToZip(const std::string& filename, int jobs);
 
   // Add a boilerplate META-INF/MANIFEST.MF file as required by the Java JAR
   // format, unless one has already been written.
@@ -469,6 +499,11 @@ class CommandLineInterface::GeneratorContextImpl : public GeneratorContext {
 
   // Get name of all output files.
   void GetOutputFilenames(std::vector<std::string>* output_filenames);
+
+  // Moves the files written to `other` into this directory, as if they had
+  // been written here. Used to merge the outputs of files that were generated
+  // concurrently.
+  void MergeFrom(GeneratorContextImpl* other);
   // implements GeneratorContext --------------------------------------
   io::ZeroCopyOutputStream* Open(const std::string& filename) override;
   io::ZeroCopyOutputStream* OpenForAppend(const std::string& filename) override;
@@ -480,6 +515,9 @@ class CommandLineInterface::GeneratorContextImpl : public GeneratorContext {
   void ListParsedFiles(std::vector<const FileDescriptor*>* output) override {
     *output = parsed_files_;
   }
+  int GetMaxJobs() const override { return max_jobs_; }
+
+  void set_max_jobs(int max_jobs) { max_jobs_ = max_jobs; }
 
  private:
   friend class MemoryOutputStream;
@@ -490,6 +528,7 @@ class CommandLineInterface::GeneratorContextImpl : public GeneratorContext {
   absl::btree_map<std::string, std::string> files_;
   const std::vector<const FileDescriptor*>& parsed_files_;
   bool had_error_;
+  int max_jobs_ = 1;
 };
 
 class CommandLineInterface::MemoryOutputStream
@@ -631,7 +670,7 @@ bool CommandLineInterface::GeneratorContextImpl::WriteAllToDisk(
 }
 
 bool CommandLineInterface::GeneratorContextImpl::WriteAllToZip(
-    const std::string& filename) {
+    const std::string& filename, int jobs) {
   if (had_error_) {
     return false;
   }
@@ -653,8 +692,26 @@ bool CommandLineInterface::GeneratorContextImpl::WriteAllToZip(
   io::FileOutputStream stream(file_descriptor);
   ZipWriter zip_writer(&stream);
 
-  for (const auto& pair : files_) {
-    zip_writer.Write(pair.first, pair.second);
+  // Entries are compressed a window at a time and written out in order as
+  // each window completes, so only a window's compressed data is held at
+  // once.
+  std::vector<std::pair<const std::string*, std::string*>> files;
+  files.reserve(files_.size());
+  for (auto& pair : files_) {
+    files.emplace_back(&pair.first, &pair.second);
+  }
+  const size_t window = 4 * static_cast<size_t>(std::max(jobs, 1));
+  std::vector<ZipWriter::Entry> entries;
+  for (size_t start = 0; start < files.size(); start += window) {
+    entries.resize(std::min(window, files.size() - start));
+    RunTasks(jobs, entries.size(), [&](size_t i) {
+      entries[i] = ZipWriter::PrepareEntry(*files[start + i].second);
+      return true;
+    });
+    for (size_t i = 0; i < entries.size(); i++) {
+      zip_writer.WriteEntry(*files[start + i].first, entries[i]);
+      std::string().swap(*files[start + i].second);
+    }
   }
 
   zip_writer.WriteDirectory();
@@ -689,6 +746,22 @@ void CommandLineInterface::GeneratorContextImpl::GetOutputFilenames(
   }
 }
 
+void CommandLineInterface::GeneratorContextImpl::MergeFrom(
+    GeneratorContextImpl* other) {
+  had_error_ |= other->had_error_;
+  for (auto& pair : other->files_) {
+    auto inserted = files_.insert({pair.first, ""});
+    if (!inserted.second) {
+      std::cerr << pair.first << ": Tried to write the same file twice."
+                << std::endl;
+      had_error_ = true;
+      continue;
+    }
+    inserted.first->second.swap(pair.second);
+  }
+  other->files_.clear();
+}
+
 io::ZeroCopyOutputStream* CommandLineInterface::GeneratorContextImpl::Open(
     const std::string& filename) {
   return new MemoryOutputStream(this, filename, false);
@@ -1289,6 +1362,15 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
       break;
   }
 
+  // Wall time of each phase, for --print_timing.
+  absl::Time phase_start = absl::Now();
+  std::vector<std::pair<std::string, absl::Duration>> timings;
+  auto end_phase = [&](std::string name) {
+    absl::Time now = absl::Now();
+    timings.emplace_back(std::move(name), now - phase_start);
+    phase_start = now;
+  };
+
   std::vector<const FileDescriptor*> parsed_files;
   std::unique_ptr<DiskSourceTree> disk_source_tree;
   std::unique_ptr<ErrorPrinter> error_collector;
@@ -1351,6 +1433,13 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
     source_tree_database.reset(new SourceTreeDescriptorDatabase(
         disk_source_tree.get(), descriptor_set_in_database.get()));
     source_tree_database->RecordErrorsTo(error_collector.get());
+    if (!parse_cache_dir_.empty()) {
+      source_tree_database->SetParseCacheDirectory(parse_cache_dir_);
+    }
+    // Only code generators and --include_source_info look at the source code
+    // info, so e.g. --encode and --decode do without it.
+    source_tree_database->SetRecordSourceCodeInfo(
+        !output_directives_.empty() || source_info_in_descriptor_set_);
 
     descriptor_pool.reset(new DescriptorPool(
         source_tree_database.get(),
@@ -1414,6 +1503,7 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
   if (validation_error) {
     return 1;
   }
+  end_phase("parse");
 
   // We construct a separate GeneratorContext for each output location.  Note
   // that two code generators may output to the same location, in which case
@@ -1422,6 +1512,13 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
 
   // Generate output.
   if (mode_ == MODE_COMPILE) {
+    // The directives for one location run in command line order. Those for
+    // different locations are independent, so they run concurrently with
+    // --jobs.
+    std::vector<std::pair<GeneratorContextImpl*,
+                          std::vector<const OutputDirective*>>>
+        locations;
+    absl::flat_hash_map<GeneratorContextImpl*, size_t> location_index;
     for (int i = 0; i < output_directives_.size(); i++) {
       std::string output_location = output_directives_[i].output_location;
       if (!absl::EndsWith(output_location, ".zip") &&
@@ -1435,13 +1532,41 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
       if (!generator) {
         // First time we've seen this output location.
         generator = std::make_unique<GeneratorContextImpl>(parsed_files);
+        location_index[generator.get()] = locations.size();
+        locations.push_back({generator.get(), {}});
       }
-
-      if (!GenerateOutput(parsed_files, output_directives_[i],
-                          generator.get())) {
-        return 1;
-      }
+      locations[location_index[generator.get()]].second.push_back(
+          &output_directives_[i]);
+    }
+
+    // Threads left over by the locations go to generating files in parallel.
+    const int concurrent_locations =
+        std::max(1, std::min(jobs_, static_cast<int>(locations.size())));
+    const int file_jobs = std::max(1, jobs_ / concurrent_locations);
+    for (const auto& location : locations) {
+      location.first->set_max_jobs(file_jobs);
+    }
+    // Indexed like output_directives_, so each task writes its own slots.
+    std::vector<absl::Duration> directive_times(output_directives_.size());
+    if (!RunTasks(jobs_, locations.size(), [&](size_t i) {
+          for (const OutputDirective* directive : locations[i].second) {
+            absl::Time start = absl::Now();
+            if (!GenerateOutput(parsed_files, *directive, locations[i].first,
+                                file_jobs)) {
+              return false;
+            }
+            directive_times[directive - output_directives_.data()] =
+                absl::Now() - start;
+          }
+          return true;
+        })) {
+      return 1;
+    }
+    // With --jobs the generators overlap, so list each one's own time.
+    for (size_t i = 0; i < output_directives_.size(); i++) {
+      timings.emplace_back(output_directives_[i].name, directive_times[i]);
     }
+    end_phase("generate");
   }
 
   for (const auto& pair : output_directories) {
@@ -1456,7 +1581,7 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
         directory->AddJarManifest();
       }
 
-      if (!directory->WriteAllToZip(location)) {
+      if (!directory->WriteAllToZip(location, jobs_)) {
         return 1;
       }
     }
@@ -1475,6 +1600,14 @@ int CommandLineInterface::Run(int argc, const char* const argv[]) {
       return 1;
     }
   }
+  end_phase("write");
+
+  if (print_timing_) {
+    for (const auto& timing : timings) {
+      std::cerr << "protoc timing: " << timing.first << ": "
+                << absl::FormatDuration(timing.second) << std::endl;
+    }
+  }
 
   if (mode_ == MODE_ENCODE || mode_ == MODE_DECODE) {
     if (codec_type_.empty()) {
@@ -1526,7 +1659,9 @@ bool CommandLineInterface::InitializeDiskSourceTree(
     DiskSourceTree* source_tree, DescriptorDatabase* fallback_database) {
   AddDefaultProtoPaths(&proto_path_);
 
-  // Set up the source tree.
+  // Set up the source tree. Nothing writes to the proto paths while we
+  // parse, so missing files and directories need only be looked up once.
+  source_tree->EnableLookupCache(true);
   for (int i = 0; i < proto_path_.size(); i++) {
     source_tree->MapPath(proto_path_[i].first, proto_path_[i].second);
   }
@@ -1536,6 +1671,10 @@ bool CommandLineInterface::InitializeDiskSourceTree(
     return false;
   }
 
+  if (jobs_ > 1) {
+    source_tree->Prefetch(input_files_, jobs_);
+  }
+
   return true;
 }
 
@@ -1702,6 +1841,10 @@ void CommandLineInterface::Clear() {
   disallow_services_ = false;
   direct_dependencies_explicitly_set_ = false;
   deterministic_output_ = false;
+  jobs_ = 1;
+  print_timing_ = false;
+  plugin_shared_memory_ = false;
+  parse_cache_dir_.clear();
 }
 
 bool CommandLineInterface::MakeProtoProtoPathRelative(
@@ -2013,7 +2156,8 @@ bool CommandLineInterface::ParseArgument(const char* arg, std::string* name,
       *name == "--decode_raw" ||
       *name == "--print_free_field_numbers" ||
       *name == "--experimental_allow_proto3_optional" ||
-      *name == "--deterministic_output" || *name == "--fatal_warnings") {
+      *name == "--deterministic_output" || *name == "--fatal_warnings" ||
+      *name == "--plugin_shared_memory" || *name == "--print_timing") {
     // HACK:  These are the only flags that don't take a value.
     //   They probably should not be hard-coded like this but for now it's
     //   not worth doing better.
@@ -2191,6 +2335,17 @@ CommandLineInterface::InterpretArgument(const std::string& name,
     }
     dependency_out_name_ = value;
 
+  } else if (name == "--parse_cache_dir") {
+    if (!parse_cache_dir_.empty()) {
+      std::cerr << name << " may only be passed once." << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    if (value.empty()) {
+      std::cerr << name << " requires a non-empty value." << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    parse_cache_dir_ = value;
+
   } else if (name == "--include_imports") {
     if (imports_in_descriptor_set_) {
       std::cerr << name << " may only be passed once." << std::endl;
@@ -2227,6 +2382,9 @@ CommandLineInterface::InterpretArgument(const std::string& name,
   } else if (name == "--disallow_services") {
     disallow_services_ = true;
 
+  } else if (name == "--print_timing") {
+    print_timing_ = true;
+
 
   } else if (name == "--experimental_allow_proto3_optional") {
     // Flag is no longer observed, but we allow it for backward compat.
@@ -2273,12 +2431,23 @@ CommandLineInterface::InterpretArgument(const std::string& name,
       return PARSE_ARGUMENT_FAIL;
     }
 
+  } else if (name == "-j" || name == "--jobs") {
+    if (!absl::SimpleAtoi(value, &jobs_) || jobs_ < 0) {
+      std::cerr << "Invalid number of jobs: " << value << std::endl;
+      return PARSE_ARGUMENT_FAIL;
+    }
+    if (jobs_ == 0) {
+      jobs_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+
   } else if (name == "--fatal_warnings") {
     if (fatal_warnings_) {
       std::cerr << name << " may only be passed once." << std::endl;
       return PARSE_ARGUMENT_FAIL;
     }
     fatal_warnings_ = true;
+  } else if (name == "--plugin_shared_memory") {
+    plugin_shared_memory_ = true;
   } else if (name == "--plugin") {
     if (plugin_prefix_.empty()) {
       std::cerr << "This compiler does not support plugins." << std::endl;
@@ -2456,9 +2625,28 @@ Parse PROTO_FILES and generate output based on the options given:
   --dependency_out=FILE       Write a dependency output file in the format
                               expected by make. This writes the transitive
                               set of input file paths to FILE
+  --parse_cache_dir=DIR       Keep the parsed form of every .proto file read
+                              in the existing directory DIR, and reuse it
+                              in later runs while the file is unchanged, so
+                              that shared imports are only parsed once.
   --error_format=FORMAT       Set the format in which to print errors.
                               FORMAT may be 'gcc' (the default) or 'msvs'
                               (Microsoft Visual Studio format).
+  -jN, --jobs=N               Run up to N code generators and plugins
+                              writing to different output locations at
+                              once, and generate files (or the classes
+                              within a file) in parallel with the
+                              generators that support it. Input
+                              files and their imports are also read on N
+                              threads before parsing. N=0 uses one job
+                              per CPU. The output is the same as with
+                              the default of 1.
+  --plugin_shared_memory      Pass plugins their request and take their
+                              response through memory-mapped temporary
+                              files rather than pipes. Plugins built with
+                              PluginMain() then parse and serialize them
+                              in place; others read and write them as
+                              usual. Ignored on Windows.
   --fatal_warnings            Make warnings be fatal (similar to -Werr in
                               gcc). This flag will make protoc return
                               with a non-zero exit code if any warnings
@@ -2466,6 +2654,9 @@ Parse PROTO_FILES and generate output based on the options given:
   --print_free_field_numbers  Print the free field numbers of the messages
                               defined in the given proto files. Extension ranges
                               are counted as occupied fields numbers.
+  --print_timing              Print to stderr how long parsing, each code
+                              generator and plugin, and writing the output
+                              took.
   --enable_codegen_trace      Enables tracing which parts of protoc are
                               responsible for what codegen output. Not supported
                               by all backends or on all platforms.)";
@@ -2533,7 +2724,7 @@ bool CommandLineInterface::EnforceProto3OptionalSupport(
 bool CommandLineInterface::GenerateOutput(
     const std::vector<const FileDescriptor*>& parsed_files,
     const OutputDirective& output_directive,
-    GeneratorContext* generator_context) {
+    GeneratorContextImpl* generator_context, int jobs) {
   // Call the generator.
   std::string error;
   if (output_directive.generator == nullptr) {
@@ -2544,11 +2735,14 @@ bool CommandLineInterface::GenerateOutput(
 
     std::string plugin_name = PluginName(plugin_prefix_, output_directive.name);
     std::string parameters = output_directive.parameter;
-    if (!plugin_parameters_[plugin_name].empty()) {
+    // Lookups must not insert, as other directives may run concurrently.
+    auto plugin_parameters = plugin_parameters_.find(plugin_name);
+    if (plugin_parameters != plugin_parameters_.end() &&
+        !plugin_parameters->second.empty()) {
       if (!parameters.empty()) {
         parameters.append(",");
       }
-      parameters.append(plugin_parameters_[plugin_name]);
+      parameters.append(plugin_parameters->second);
     }
     if (!GeneratePluginOutput(parsed_files, plugin_name, parameters,
                               generator_context, &error)) {
@@ -2558,11 +2752,14 @@ bool CommandLineInterface::GenerateOutput(
   } else {
     // Regular generator.
     std::string parameters = output_directive.parameter;
-    if (!generator_parameters_[output_directive.name].empty()) {
+    auto generator_parameters =
+        generator_parameters_.find(output_directive.name);
+    if (generator_parameters != generator_parameters_.end() &&
+        !generator_parameters->second.empty()) {
       if (!parameters.empty()) {
         parameters.append(",");
       }
-      parameters.append(generator_parameters_[output_directive.name]);
+      parameters.append(generator_parameters->second);
     }
     if (!EnforceProto3OptionalSupport(
             output_directive.name,
@@ -2570,8 +2767,37 @@ bool CommandLineInterface::GenerateOutput(
       return false;
     }
 
-    if (!output_directive.generator->GenerateAll(parsed_files, parameters,
-                                                 generator_context, &error)) {
+    if (jobs > 1 && parsed_files.size() > 1 &&
+        output_directive.generator->SupportsConcurrentGenerate()) {
+      // Each file is generated into a directory of its own, and those are
+      // merged in file order, so the output does not depend on scheduling.
+      std::vector<std::unique_ptr<GeneratorContextImpl>> file_outputs(
+          parsed_files.size());
+      std::vector<std::string> errors(parsed_files.size());
+      RunTasks(jobs, parsed_files.size(), [&](size_t i) {
+        file_outputs[i] = std::make_unique<GeneratorContextImpl>(parsed_files);
+        if (!output_directive.generator->Generate(parsed_files[i], parameters,
+                                                  file_outputs[i].get(),
+                                                  &errors[i]) &&
+            errors[i].empty()) {
+          errors[i] =
+              "Code generator returned false but provided no error "
+              "description.";
+        }
+        return errors[i].empty();
+      });
+      for (size_t i = 0; i < parsed_files.size(); i++) {
+        if (!errors[i].empty()) {
+          std::cerr << output_directive.name << ": " << parsed_files[i]->name()
+                    << ": " << errors[i] << std::endl;
+          return false;
+        }
+        if (file_outputs[i] != nullptr) {
+          generator_context->MergeFrom(file_outputs[i].get());
+        }
+      }
+    } else if (!output_directive.generator->GenerateAll(
+                   parsed_files, parameters, generator_context, &error)) {
       // Generator returned an error.
       std::cerr << output_directive.name << ": " << error << std::endl;
       return false;
@@ -2687,6 +2913,7 @@ bool CommandLineInterface::GeneratePluginOutput(
 
   // Invoke the plugin.
   Subprocess subprocess;
+  if (plugin_shared_memory_) subprocess.EnableSharedMemoryTransport();
 
   if (plugins_.count(plugin_name) > 0) {
     subprocess.Start(plugins_[plugin_name], Subprocess::EXACT_NAME);
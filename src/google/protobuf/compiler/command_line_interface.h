@@ -286,11 +286,12 @@ class PROTOC_EXPORT CommandLineInterface {
                        DiskSourceTree* source_tree,
                        std::vector<const FileDescriptor*>* parsed_files);
 
-  // Generate the given output file from the given input.
+  // Generate the given output file from the given input, on up to `jobs`
+  // threads if the generator supports it.
   struct OutputDirective;  // see below
   bool GenerateOutput(const std::vector<const FileDescriptor*>& parsed_files,
                       const OutputDirective& output_directive,
-                      GeneratorContext* generator_context);
+                      GeneratorContextImpl* generator_context, int jobs);
   bool GeneratePluginOutput(
       const std::vector<const FileDescriptor*>& parsed_files,
       const std::string& plugin_name, const std::string& parameter,
@@ -447,6 +448,18 @@ class PROTOC_EXPORT CommandLineInterface {
 
   // When using --encode, this will be passed to SetSerializationDeterministic.
   bool deterministic_output_ = false;
+
+  // The number of threads to generate code on, from --jobs.
+  int jobs_ = 1;
+
+  // Was the --print_timing flag used?
+  bool print_timing_ = false;
+
+  // Was the --plugin_shared_memory flag used?
+  bool plugin_shared_memory_ = false;
+
+  // The directory given with --parse_cache_dir, or empty.
+  std::string parse_cache_dir_;
 };
 
 }  // namespace compiler
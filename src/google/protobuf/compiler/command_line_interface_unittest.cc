@@ -1086,6 +1086,77 @@ TEST_F(CommandLineInterfaceTest, CreateDirectory) {
   ExpectGenerated("test_plugin", "", "bar/baz/foo.proto", "Foo", "plugout");
 }
 
+TEST_F(CommandLineInterfaceTest, Jobs) {
+  // Test that generators writing to different locations can run concurrently.
+
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+  CreateTempDir("out");
+  CreateTempDir("plugout");
+
+  Run("protocol_compiler -j4 --test_out=$tmpdir/out --plug_out=$tmpdir/plugout "
+      "--proto_path=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  ExpectGenerated("test_generator", "", "foo.proto", "Foo", "out");
+  ExpectGenerated("test_plugin", "", "foo.proto", "Foo", "plugout");
+}
+
+TEST_F(CommandLineInterfaceTest, InvalidJobs) {
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+
+  Run("protocol_compiler --jobs=many --test_out=$tmpdir "
+      "--proto_path=$tmpdir foo.proto");
+
+  ExpectErrorText("Invalid number of jobs: many\n");
+}
+
+TEST_F(CommandLineInterfaceTest, PrintTiming) {
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+
+  Run("protocol_compiler --print_timing --test_out=$tmpdir "
+      "--proto_path=$tmpdir foo.proto");
+
+  ExpectCapturedStderrSubstringWithZeroReturnCode("protoc timing: parse: ");
+  ExpectCapturedStderrSubstringWithZeroReturnCode(
+      "protoc timing: --test_out: ");
+  ExpectCapturedStderrSubstringWithZeroReturnCode("protoc timing: write: ");
+  ExpectGenerated("test_generator", "", "foo.proto", "Foo");
+}
+
+TEST_F(CommandLineInterfaceTest, PluginSharedMemory) {
+  // Test that plugins work when their request and response go through files.
+
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message Foo {}\n");
+  CreateTempDir("plugout");
+
+  Run("protocol_compiler --plugin_shared_memory -j2 --test_out=$tmpdir "
+      "--plug_out=$tmpdir/plugout --proto_path=$tmpdir foo.proto");
+
+  ExpectNoErrors();
+  ExpectGenerated("test_generator", "", "foo.proto", "Foo");
+  ExpectGenerated("test_plugin", "", "foo.proto", "Foo", "plugout");
+}
+
+TEST_F(CommandLineInterfaceTest, PluginSharedMemoryError) {
+  CreateTempFile("foo.proto",
+                 "syntax = \"proto2\";\n"
+                 "message MockCodeGenerator_Error {}\n");
+
+  Run("protocol_compiler --plugin_shared_memory "
+      "--plug_out=TestParameter:$tmpdir --proto_path=$tmpdir foo.proto");
+
+  ExpectErrorSubstring(
+      "--plug_out: foo.proto: Saw message type MockCodeGenerator_Error.");
+}
+
 TEST_F(CommandLineInterfaceTest, GeneratorParameters) {
   // Test that generator parameters are correctly parsed from the command line.
 
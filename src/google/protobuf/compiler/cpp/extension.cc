@@ -109,6 +109,16 @@ ExtensionGenerator::ExtensionGenerator(const FieldDescriptor* descriptor,
           ? absl::StrCat("&", FieldMessageTypeName(descriptor_, options_),
                          "::InternalVerify")
           : "nullptr";
+
+  // Singular message extensions may be kept as bytes until first accessed.
+  // Lazy fields that must be verified eagerly are parsed eagerly instead.
+  bool is_lazy =
+      descriptor_->type() == FieldDescriptor::TYPE_MESSAGE &&
+      !descriptor_->is_repeated() &&
+      (descriptor_->options().unverified_lazy() ||
+       (options_.unverified_lazy_message_sets &&
+        descriptor_->containing_type()->options().message_set_wire_format()));
+  variables_["lazy_arg"] = is_lazy ? ", true" : "";
 }
 
 ExtensionGenerator::~ExtensionGenerator() {}
@@ -176,7 +186,7 @@ void ExtensionGenerator::GenerateDefinition(io::Printer* printer) {
       "PROTOBUF_ATTRIBUTE_INIT_PRIORITY2 "
       "::$proto_ns$::internal::ExtensionIdentifier< $extendee$,\n"
       "    ::$proto_ns$::internal::$type_traits$, $field_type$, $packed$>\n"
-      "  $scoped_name$($constant_name$, $1$, $verify_fn$);\n",
+      "  $scoped_name$($constant_name$, $1$, $verify_fn$$lazy_arg$);\n",
       default_str);
 }
 
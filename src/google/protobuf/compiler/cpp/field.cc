@@ -153,6 +153,9 @@ std::unique_ptr<FieldGeneratorBase> MakeGenerator(const FieldDescriptor* field,
   if (field->is_map()) {
     return MakeMapGenerator(field, options, scc);
   }
+  if (IsBitPacked(field, options)) {
+    return MakeRepeatedBitPackedGenerator(field, options, scc);
+  }
   if (field->is_repeated()) {
     switch (field->cpp_type()) {
       case FieldDescriptor::CPPTYPE_MESSAGE:
@@ -402,7 +402,7 @@ void RepeatedEnum::GenerateSerializeWithCachedSizesToArray(
     p->Emit(R"cc(
       {
         int byte_size = $cached_size_$.Get();
-        if (byte_size > 0) {
+        if (byte_size > 0 || stream->BackpatchesLengths()) {
           target = stream->WriteEnumPacked($number$, _internal_$name$(),
                                            byte_size, target);
         }
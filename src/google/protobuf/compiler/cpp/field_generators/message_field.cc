@@ -38,6 +38,7 @@
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "google/protobuf/compiler/cpp/field.h"
@@ -705,6 +706,31 @@ void OneofMessage::GenerateIsInitialized(io::Printer* p) const {
       "}\n");
 }
 
+// Returns the fields of the element type of `field` that get a column
+// accessor: its singular numeric, bool and enum fields, if `field` was named
+// in the columnar_fields option.
+std::vector<const FieldDescriptor*> ColumnFields(const FieldDescriptor* field,
+                                                 const Options& opts,
+                                                 bool weak) {
+  std::vector<const FieldDescriptor*> columns;
+  if (weak || !opts.columnar_fields.contains(field->full_name())) {
+    return columns;
+  }
+  const Descriptor* element = field->message_type();
+  for (int i = 0; i < element->field_count(); ++i) {
+    const FieldDescriptor* column = element->field(i);
+    if (column->is_repeated()) continue;
+    switch (column->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_STRING:
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        break;
+      default:
+        columns.push_back(column);
+    }
+  }
+  return columns;
+}
+
 class RepeatedMessage : public FieldGeneratorBase {
  public:
   RepeatedMessage(const FieldDescriptor* field, const Options& opts,
@@ -713,7 +739,8 @@ class RepeatedMessage : public FieldGeneratorBase {
         field_(field),
         opts_(&opts),
         weak_(IsImplicitWeakField(field, opts, scc)),
-        has_required_(scc->HasRequiredFields(field->message_type())) {}
+        has_required_(scc->HasRequiredFields(field->message_type())),
+        columns_(ColumnFields(field, opts, weak_)) {}
 
   ~RepeatedMessage() override = default;
 
@@ -724,6 +751,7 @@ class RepeatedMessage : public FieldGeneratorBase {
   void GeneratePrivateMembers(io::Printer* p) const override;
   void GenerateAccessorDeclarations(io::Printer* p) const override;
   void GenerateInlineAccessorDefinitions(io::Printer* p) const override;
+  void GenerateNonInlineAccessorDefinitions(io::Printer* p) const override;
   void GenerateClearingCode(io::Printer* p) const override;
   void GenerateMergingCode(io::Printer* p) const override;
   void GenerateSwappingCode(io::Printer* p) const override;
@@ -735,12 +763,30 @@ class RepeatedMessage : public FieldGeneratorBase {
   void GenerateIsInitialized(io::Printer* p) const override;
 
  private:
+  // Variables for the column accessor of `column`.
+  std::vector<Sub> ColumnVars(const FieldDescriptor* column) const;
+
   const FieldDescriptor* field_;
   const Options* opts_;
   bool weak_;
   bool has_required_;
+  std::vector<const FieldDescriptor*> columns_;
 };
 
+std::vector<Sub> RepeatedMessage::ColumnVars(
+    const FieldDescriptor* column) const {
+  bool is_enum = column->cpp_type() == FieldDescriptor::CPPTYPE_ENUM;
+  return {
+      {"column", FieldName(column)},
+      {"ColumnType",
+       is_enum ? "int" : PrimitiveTypeName(*opts_, column->cpp_type())},
+      {"column_value", is_enum ? absl::StrCat("static_cast<int>(element.",
+                                              FieldName(column), "())")
+                               : absl::StrCat("element.", FieldName(column),
+                                              "()")},
+  };
+}
+
 void RepeatedMessage::GeneratePrivateMembers(io::Printer* p) const {
   p->Emit("$pb$::$Weak$RepeatedPtrField< $Submsg$ > $name$_;\n");
 }
@@ -774,6 +820,14 @@ void RepeatedMessage::GenerateAccessorDeclarations(io::Printer* p) const {
       "$DEPRECATED$ const $pb$::RepeatedPtrField< $Submsg$ >&\n"
       "    ${1$$name$$}$() const;\n",
       field_);
+  for (const FieldDescriptor* column : columns_) {
+    auto v = p->WithVars(ColumnVars(column));
+    p->Emit(R"cc(
+      // Replaces the contents of `column` with `$column$` of each element.
+      void $name$_$column$_column(
+          $pb$::RepeatedField<$ColumnType$>* column) const;
+    )cc");
+  }
 }
 
 void RepeatedMessage::GenerateInlineAccessorDefinitions(io::Printer* p) const {
@@ -846,6 +900,24 @@ void RepeatedMessage::GenerateInlineAccessorDefinitions(io::Printer* p) const {
   }
 }
 
+void RepeatedMessage::GenerateNonInlineAccessorDefinitions(
+    io::Printer* p) const {
+  for (const FieldDescriptor* column : columns_) {
+    auto v = p->WithVars(ColumnVars(column));
+    p->Emit(R"cc(
+      void $Msg$::$name$_$column$_column(
+          $pb$::RepeatedField<$ColumnType$>* column) const {
+        const auto& elements = _internal_$name$();
+        column->Clear();
+        column->Reserve(elements.size());
+        for (const auto& element : elements) {
+          column->AddAlreadyReserved($column_value$);
+        }
+      }
+    )cc");
+  }
+}
+
 void RepeatedMessage::GenerateClearingCode(io::Printer* p) const {
   if (weak_) {
     p->Emit("$field_$.Clear();\n");
@@ -910,6 +982,7 @@ void RepeatedMessage::GenerateSerializeWithCachedSizesToArray(
         "for (unsigned i = 0,\n"
         "    n = static_cast<unsigned>(this->_internal_$name$_size());"
         " i < n; i++) {\n");
+    p->Emit("  $pbi$::PrefetchRepeatedPtrAhead(this->_internal_$name$(), i);\n");
     if (field_->type() == FieldDescriptor::TYPE_MESSAGE) {
       p->Emit(
           "  const auto& repfield = this->_internal_$name$().Get(i);\n"
@@ -931,13 +1004,18 @@ void RepeatedMessage::GenerateSerializeWithCachedSizesToArray(
 void RepeatedMessage::GenerateByteSize(io::Printer* p) const {
   p->Emit("total_size += $tag_size$UL * this->_internal_$name$_size();\n");
   if (weak_) {
-    p->Emit("for (const auto& msg : this->$field_$) {\n");
-  } else {
-    p->Emit("for (const auto& msg : this->_internal_$name$()) {\n");
+    p->Emit(
+        "for (const auto& msg : this->$field_$) {\n"
+        "  total_size +=\n"
+        "    $pbi$::WireFormatLite::$declared_type$Size(msg);\n"
+        "}\n");
+    return;
   }
   p->Emit(
-      "  total_size +=\n"
-      "    $pbi$::WireFormatLite::$declared_type$Size(msg);\n"
+      "for (int i = 0, n = this->_internal_$name$_size(); i < n; ++i) {\n"
+      "  $pbi$::PrefetchRepeatedPtrAhead(this->_internal_$name$(), i);\n"
+      "  total_size += $pbi$::WireFormatLite::$declared_type$Size(\n"
+      "      this->_internal_$name$().Get(i));\n"
       "}\n");
 }
 
@@ -488,7 +488,7 @@ void RepeatedPrimitive::GenerateSerializeWithCachedSizesToArray(
   p->Emit(R"cc(
     {
       int byte_size = $_field_cached_byte_size_$.Get();
-      if (byte_size > 0) {
+      if (byte_size > 0 || stream->BackpatchesLengths()) {
         target = stream->Write$DeclaredType$Packed($number$, _internal_$name$(),
                                                    byte_size, target);
       }
@@ -550,6 +550,181 @@ void RepeatedPrimitive::GenerateByteSize(io::Printer* p) const {
         }
       )cc");
 }
+// A repeated bool field named in the bitpacked_fields option, stored as a
+// RepeatedBitField. It has no cached size: every element is one byte on the
+// wire, so the packed size is the element count.
+class RepeatedBitPacked final : public FieldGeneratorBase {
+ public:
+  RepeatedBitPacked(const FieldDescriptor* field, const Options& opts)
+      : FieldGeneratorBase(field, opts), field_(field), opts_(&opts) {}
+  ~RepeatedBitPacked() override = default;
+
+  std::vector<Sub> MakeVars() const override { return Vars(field_, *opts_); }
+
+  void GenerateClearingCode(io::Printer* p) const override {
+    p->Emit(R"cc(
+      _internal_mutable_$name$()->Clear();
+    )cc");
+  }
+
+  void GenerateMergingCode(io::Printer* p) const override {
+    p->Emit(R"cc(
+      _this->$field_$.MergeFrom(from.$field_$);
+    )cc");
+  }
+
+  void GenerateSwappingCode(io::Printer* p) const override {
+    p->Emit(R"cc(
+      $field_$.InternalSwap(&other->$field_$);
+    )cc");
+  }
+
+  void GenerateDestructorCode(io::Printer* p) const override {
+    p->Emit(R"cc(
+      $field_$.~RepeatedBitField();
+    )cc");
+  }
+
+  void GenerateConstructorCode(io::Printer* p) const override {}
+
+  void GenerateCopyConstructorCode(io::Printer* p) const override {}
+
+  void GenerateConstexprAggregateInitializer(io::Printer* p) const override {
+    p->Emit(R"cc(
+      /*decltype($field_$)*/ {},
+    )cc");
+  }
+
+  void GenerateAggregateInitializer(io::Printer* p) const override {
+    p->Emit(R"cc(
+      decltype($field_$){arena},
+    )cc");
+  }
+
+  void GenerateCopyAggregateInitializer(io::Printer* p) const override {
+    p->Emit(R"cc(
+      decltype($field_$){from.$field_$},
+    )cc");
+  }
+
+  void GeneratePrivateMembers(io::Printer* p) const override {
+    p->Emit(R"cc(
+      $pb$::RepeatedBitField $name$_;
+    )cc");
+  }
+
+  void GenerateAccessorDeclarations(io::Printer* p) const override;
+  void GenerateInlineAccessorDefinitions(io::Printer* p) const override;
+  void GenerateSerializeWithCachedSizesToArray(io::Printer* p) const override;
+  void GenerateByteSize(io::Printer* p) const override;
+
+ private:
+  const FieldDescriptor* field_;
+  const Options* opts_;
+};
+
+void RepeatedBitPacked::GenerateAccessorDeclarations(io::Printer* p) const {
+  auto v = p->WithVars(
+      AnnotatedAccessors(field_, {"", "_internal_", "_internal_mutable_"}));
+  auto vs =
+      p->WithVars(AnnotatedAccessors(field_, {"set_", "add_"}, Semantic::kSet));
+  auto va =
+      p->WithVars(AnnotatedAccessors(field_, {"mutable_"}, Semantic::kAlias));
+  p->Emit(R"cc(
+    $DEPRECATED$ bool $name$(int index) const;
+    $DEPRECATED$ void $set_name$(int index, bool value);
+    $DEPRECATED$ void $add_name$(bool value);
+    $DEPRECATED$ const $pb$::RepeatedBitField& $name$() const;
+    $DEPRECATED$ $pb$::RepeatedBitField* $mutable_name$();
+
+    private:
+    const $pb$::RepeatedBitField& $_internal_name$() const;
+    $pb$::RepeatedBitField* $_internal_mutable_name$();
+
+    public:
+  )cc");
+}
+
+void RepeatedBitPacked::GenerateInlineAccessorDefinitions(
+    io::Printer* p) const {
+  p->Emit(R"cc(
+    inline bool $Msg$::$name$(int index) const {
+      $annotate_get$;
+      // @@protoc_insertion_point(field_get:$pkg.Msg.field$)
+      return _internal_$name$().Get(index);
+    }
+    inline void $Msg$::set_$name$(int index, bool value) {
+      $annotate_set$;
+      _internal_mutable_$name$()->Set(index, value);
+      // @@protoc_insertion_point(field_set:$pkg.Msg.field$)
+    }
+    inline void $Msg$::add_$name$(bool value) {
+      _internal_mutable_$name$()->Add(value);
+      $annotate_add$;
+      // @@protoc_insertion_point(field_add:$pkg.Msg.field$)
+    }
+    inline const $pb$::RepeatedBitField& $Msg$::$name$() const {
+      $annotate_list$;
+      // @@protoc_insertion_point(field_list:$pkg.Msg.field$)
+      return _internal_$name$();
+    }
+    inline $pb$::RepeatedBitField* $Msg$::mutable_$name$() {
+      $annotate_mutable_list$;
+      // @@protoc_insertion_point(field_mutable_list:$pkg.Msg.field$)
+      return _internal_mutable_$name$();
+    }
+
+    inline const $pb$::RepeatedBitField& $Msg$::_internal_$name$() const {
+      return $field_$;
+    }
+    inline $pb$::RepeatedBitField* $Msg$::_internal_mutable_$name$() {
+      return &$field_$;
+    }
+  )cc");
+}
+
+void RepeatedBitPacked::GenerateSerializeWithCachedSizesToArray(
+    io::Printer* p) const {
+  if (!field_->is_packed()) {
+    p->Emit(R"cc(
+      for (int i = 0, n = this->_internal_$name$_size(); i < n; ++i) {
+        target = stream->EnsureSpace(target);
+        target = ::_pbi::WireFormatLite::WriteBoolToArray(
+            $number$, this->_internal_$name$().Get(i), target);
+      }
+    )cc");
+    return;
+  }
+
+  p->Emit(R"cc(
+    if (this->_internal_$name$_size() > 0) {
+      target = _internal_$name$().InternalWritePacked($number$, target, stream);
+    }
+  )cc");
+}
+
+void RepeatedBitPacked::GenerateByteSize(io::Printer* p) const {
+  if (!field_->is_packed()) {
+    p->Emit(R"cc(
+      total_size += std::size_t{$kTagBytes$ + 1} *
+                    ::_pbi::FromIntSize(this->_internal_$name$_size());
+    )cc");
+    return;
+  }
+
+  p->Emit(R"cc(
+    {
+      std::size_t data_size =
+          ::_pbi::FromIntSize(this->_internal_$name$_size());
+      if (data_size > 0) {
+        total_size += $kTagBytes$ +
+                      ::_pbi::WireFormatLite::Int32Size(
+                          static_cast<int32_t>(data_size)) +
+                      data_size;
+      }
+    }
+  )cc");
+}
 }  // namespace
 
 std::unique_ptr<FieldGeneratorBase> MakeSinguarPrimitiveGenerator(
@@ -564,6 +739,12 @@ std::unique_ptr<FieldGeneratorBase> MakeRepeatedPrimitiveGenerator(
   return absl::make_unique<RepeatedPrimitive>(desc, options);
 }
 
+std::unique_ptr<FieldGeneratorBase> MakeRepeatedBitPackedGenerator(
+    const FieldDescriptor* desc, const Options& options,
+    MessageSCCAnalyzer* scc) {
+  return absl::make_unique<RepeatedBitPacked>(desc, options);
+}
+
 }  // namespace cpp
 }  // namespace compiler
 }  // namespace protobuf
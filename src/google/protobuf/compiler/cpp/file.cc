@@ -34,6 +34,7 @@
 
 #include "google/protobuf/compiler/cpp/file.h"
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -476,6 +477,15 @@ void FileGenerator::GenerateSourceIncludes(io::Printer* p) {
     IncludeFile("third_party/protobuf/generated_message_tctable_impl.h", p);
   }
 
+  if (std::any_of(message_generators_.begin(), message_generators_.end(),
+                  [](const auto& generator) {
+                    return generator->UsesHasBitScan();
+                  })) {
+    p->Emit(R"(
+      #include "absl/numeric/bits.h"
+    )");
+  }
+
   if (options_.proto_h) {
     // Use the smaller .proto.h files.
     for (int i = 0; i < file_->dependency_count(); ++i) {
@@ -813,6 +823,12 @@ void FileGenerator::GenerateGlobalSource(io::Printer* p) {
   }
 }
 
+void FileGenerator::GenerateLayoutReport(io::Printer* p) {
+  for (auto& generator : message_generators_) {
+    generator->GenerateLayoutReport(p);
+  }
+}
+
 void FileGenerator::GenerateSource(io::Printer* p) {
   auto v = p->WithVars(FileVars(file_, options_));
 
@@ -1134,8 +1150,10 @@ void FileGenerator::GenerateReflectionInitializationCode(io::Printer* p) {
   // For descriptor.proto we want to avoid doing any dynamic initialization,
   // because in some situations that would otherwise pull in a lot of
   // unnecessary code that can't be stripped by --gc-sections. Descriptor
-  // initialization will still be performed lazily when it's needed.
-  if (file_->name() != "net/proto2/proto/descriptor.proto") {
+  // initialization will still be performed lazily when it's needed. The
+  // lazy_descriptor_registration option asks for the same behavior.
+  if (file_->name() != "net/proto2/proto/descriptor.proto" &&
+      !options_.lazy_descriptor_registration) {
     p->Emit({{"dummy", UniqueName("dynamic_init_dummy", file_, options_)}},
             R"cc(
               // Force running AddDescriptors() at dynamic initialization time.
@@ -1351,8 +1369,10 @@ void FileGenerator::GenerateLibraryIncludes(io::Printer* p) {
   IncludeFile("third_party/protobuf/io/coded_stream.h", p);
   IncludeFile("third_party/protobuf/arena.h", p);
   IncludeFile("third_party/protobuf/arenastring.h", p);
-  if ((options_.force_inline_string || options_.profile_driven_inline_string) &&
-      !options_.opensource_runtime) {
+  if (((options_.force_inline_string ||
+        options_.profile_driven_inline_string) &&
+       !options_.opensource_runtime) ||
+      options_.field_access_profile != nullptr) {
     IncludeFile("third_party/protobuf/inlined_string_field.h", p);
   }
   if (HasSimpleBaseClasses(file_, options_)) {
@@ -1392,11 +1412,19 @@ void FileGenerator::GenerateLibraryIncludes(io::Printer* p) {
       IncludeFile("third_party/protobuf/string_piece_field_support.h", p);
     }
   }
+  if (HasBitPackedFields(file_, options_)) {
+    IncludeFile("third_party/protobuf/repeated_bit_field.h", p);
+  }
   if (HasCordFields(file_, options_)) {
     p->Emit(R"(
       #include "absl/strings/cord.h"
       )");
   }
+  if (options_.bulk_assign) {
+    p->Emit(R"(
+      #include "absl/types/optional.h"
+      )");
+  }
   if (HasMapFields(file_)) {
     IncludeFileAndExport("third_party/protobuf/map.h", p);
     if (HasDescriptorMethods(file_, options_)) {
@@ -77,6 +77,9 @@ class FileGenerator {
   // output) to the metadata file describing this PB header.
   void GeneratePBHeader(io::Printer* p, absl::string_view info_path);
   void GenerateSource(io::Printer* p);
+  // Generates the layout report of the file's messages, one JSON object per
+  // line.
+  void GenerateLayoutReport(io::Printer* p);
 
   // The following member functions are used when the lite_implicit_weak_fields
   // option is set. In this mode the code is organized a bit differently to
@@ -35,13 +35,17 @@
 #include "google/protobuf/compiler/cpp/generator.h"
 
 #include <cstdlib>
+#include <fstream>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/compiler/cpp/file.h"
 #include "google/protobuf/compiler/cpp/helpers.h"
@@ -96,6 +100,38 @@ absl::flat_hash_map<absl::string_view, std::string> CommonVars(
        "K"},
   };
 }
+
+// Reads a field presence or access profile, named `kind` in errors: one
+// `<full field name> <probability>` pair per line. Empty lines and lines
+// starting with `#` are ignored.
+bool LoadFieldProfile(const std::string& path, absl::string_view kind,
+                      FieldPresenceProfile* profile, std::string* error) {
+  std::ifstream input(path);
+  if (!input) {
+    *error = absl::StrCat("Could not open ", kind, ": ", path);
+    return false;
+  }
+  std::string line;
+  for (int line_number = 1; std::getline(input, line); ++line_number) {
+    absl::string_view stripped = absl::StripAsciiWhitespace(line);
+    if (stripped.empty() || stripped[0] == '#') continue;
+    std::vector<absl::string_view> parts =
+        absl::StrSplit(stripped, absl::ByAnyChar(" \t"), absl::SkipEmpty());
+    float probability;
+    size_t dot = parts.empty() ? absl::string_view::npos : parts[0].rfind('.');
+    if (parts.size() != 2 || dot == absl::string_view::npos ||
+        !absl::SimpleAtof(parts[1], &probability) || probability < 0 ||
+        probability > 1) {
+      *error = absl::StrCat(path, ":", line_number,
+                            ": expected `<full field name> <probability>`.");
+      return false;
+    }
+    profile->fields[parts[0]] = probability;
+    profile->messages.emplace(parts[0].substr(0, dot));
+  }
+  return true;
+}
+
 }  // namespace
 
 bool CppGenerator::Generate(const FileDescriptor* file,
@@ -126,7 +162,72 @@ bool CppGenerator::Generate(const FileDescriptor* file,
   //
   // If the lite option is passed to the compiler, we will generate the
   // current files and all transitive dependencies using the LITE runtime.
+  //
+  // The field_presence_profile option names a file with the fraction of
+  // parsed messages that contain each field (see LoadFieldProfile).
+  // The hottest fields then get the fast-path parse table slots.
+  //
+  // The field_access_profile option names a file with how often each field is
+  // accessed, as written by WriteFieldAccessProfile() from a binary built with
+  // PROTOBUF_FIELD_ACCESS_SAMPLER (see field_access_sampler.h). Rarely
+  // accessed fields are moved to the split struct of their message, and the
+  // most accessed strings are inlined.
+  //
+  // The columnar_fields option takes a '+'-separated list of full names of
+  // repeated message fields, e.g. "pkg.Table.rows+pkg.Log.entries". Each
+  // gets a `<field>_<subfield>_column()` accessor per singular scalar field of
+  // the element type, which copies that subfield of every element into a
+  // RepeatedField so that scans over one column run over contiguous memory.
+  //
+  // The bitpacked_fields option takes a '+'-separated list of full names of
+  // repeated bool fields, stored as a RepeatedBitField with one bit per
+  // element instead of one byte. Their accessors return and take the
+  // RepeatedBitField. Only files without descriptor methods (LITE_RUNTIME)
+  // may use it, since reflection expects a RepeatedField<bool>.
+  //
+  // If the table_driven_serialization option is passed to the compiler,
+  // _InternalSerialize walks the parse table of the message instead of
+  // writing each field inline. This trades some serialization speed for
+  // smaller code, and is skipped for messages the table cannot describe
+  // (extensions, maps, lazy, split and weak fields).
+  //
+  // The table_driven_methods option goes further for very large schemas:
+  // besides _InternalSerialize, ByteSizeLong and Clear of the same messages
+  // become calls into the parse table, leaving little per-message code.
+  // Clear keeps its generated form for messages with inlined strings or
+  // string fields with a non-empty default.
+  //
+  // If the lazy_descriptor_registration option is passed to the compiler,
+  // the file does not register its descriptor with the generated pool during
+  // dynamic initialization. That happens on the first descriptor() or
+  // GetReflection() call for one of its types instead, so lite-style users
+  // never pay for it. Until then, the types cannot be found by name in
+  // DescriptorPool::generated_pool() or MessageFactory::generated_factory().
+  //
+  // If the bulk_assign option is passed to the compiler, messages with
+  // singular scalar or enum fields outside of oneofs get a nested
+  // `AssignValues` struct of absl::optional values and an `Assign()` method
+  // which sets all present ones at once, updating each has-bit word once
+  // rather than once per field.
+  //
+  // If the hash_and_equality option is passed to the compiler, messages get
+  // operator==, operator!= and AbslHashValue() over their fields, so they can
+  // be keys of absl hash containers without being serialized. Fields that are
+  // absent by their has-bits are skipped, runs of scalar fields are compared
+  // and hashed as one block of memory, and floating point values compare by
+  // their bits. Extensions and unknown fields are ignored. Message fields of
+  // types from other files compare by their deterministic serialization.
+  //
+  // If the layout_report option is passed to the compiler, a
+  // <basename>.pb.layout.jsonl file is written next to the sources, with one
+  // JSON object per message describing the layout the generator chose: the
+  // padding between its fields, against the padding in declaration order,
+  // its has-bit words, its split and inlined string fields, and how its
+  // fields share the fast-path parse table slots. CI can diff it to catch
+  // layout regressions.
   Options file_options;
+  FieldPresenceProfile field_presence_profile;
+  FieldAccessProfile field_access_profile;
 
   file_options.opensource_runtime = opensource_runtime_;
   file_options.runtime_include_base = runtime_include_base_;
@@ -184,6 +285,40 @@ bool CppGenerator::Generate(const FileDescriptor* file,
               .emplace(value.substr(pos, next_pos - pos));
         pos = next_pos + 1;
       } while (pos < value.size());
+    } else if (key == "columnar_fields") {
+      for (absl::string_view name :
+           absl::StrSplit(value, '+', absl::SkipEmpty())) {
+        file_options.columnar_fields.emplace(name);
+      }
+    } else if (key == "bitpacked_fields") {
+      for (absl::string_view name :
+           absl::StrSplit(value, '+', absl::SkipEmpty())) {
+        file_options.bitpacked_fields.emplace(name);
+      }
+    } else if (key == "field_presence_profile") {
+      if (!LoadFieldProfile(value, "field presence profile",
+                            &field_presence_profile, error)) {
+        return false;
+      }
+      file_options.field_presence_profile = &field_presence_profile;
+    } else if (key == "field_access_profile") {
+      if (!LoadFieldProfile(value, "field access profile",
+                            &field_access_profile, error)) {
+        return false;
+      }
+      file_options.field_access_profile = &field_access_profile;
+    } else if (key == "table_driven_serialization") {
+      file_options.table_driven_serialization = true;
+    } else if (key == "table_driven_methods") {
+      file_options.table_driven_methods = true;
+    } else if (key == "lazy_descriptor_registration") {
+      file_options.lazy_descriptor_registration = true;
+    } else if (key == "bulk_assign") {
+      file_options.bulk_assign = true;
+    } else if (key == "hash_and_equality") {
+      file_options.hash_and_equality = true;
+    } else if (key == "layout_report") {
+      file_options.layout_report = true;
     } else if (key == "unverified_lazy_message_sets") {
       file_options.unverified_lazy_message_sets = true;
     } else if (key == "force_eagerly_verified_lazy") {
@@ -212,6 +347,30 @@ bool CppGenerator::Generate(const FileDescriptor* file,
     return false;
   }
 
+  // Names of fields from other files in the same invocation are fine; fields
+  // of this file that are named must be able to hold a RepeatedBitField.
+  if (!file_options.bitpacked_fields.empty()) {
+    bool ok = true;
+    ForEachField(file, [&](const FieldDescriptor* field) {
+      if (!ok || field->is_extension() ||
+          !file_options.bitpacked_fields.contains(field->full_name())) {
+        return;
+      }
+      if (!field->is_repeated() ||
+          field->cpp_type() != FieldDescriptor::CPPTYPE_BOOL) {
+        *error = absl::StrCat("bitpacked_fields: ", field->full_name(),
+                              " is not a repeated bool field.");
+        ok = false;
+      } else if (HasDescriptorMethods(file, file_options)) {
+        *error = absl::StrCat("bitpacked_fields: ", field->full_name(),
+                              " is in a file with descriptor methods; use "
+                              "optimize_for = LITE_RUNTIME or the lite option.");
+        ok = false;
+      }
+    });
+    if (!ok) return false;
+  }
+
   // -----------------------------------------------------------------
 
 
@@ -347,6 +506,13 @@ bool CppGenerator::Generate(const FileDescriptor* file,
     file_generator.GenerateSource(&p);
   }
 
+  if (file_options.layout_report) {
+    auto output = absl::WrapUnique(
+        generator_context->Open(absl::StrCat(basename, ".pb.layout.jsonl")));
+    io::Printer p(output.get());
+    file_generator.GenerateLayoutReport(&p);
+  }
+
   return true;
 }
 }  // namespace cpp
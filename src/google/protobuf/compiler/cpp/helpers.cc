@@ -890,13 +890,80 @@ std::string SafeFunctionName(const Descriptor* descriptor,
 bool IsProfileDriven(const Options& options) {
   return options.access_info_map != nullptr;
 }
+
+float GetPresenceProbability(const FieldDescriptor* field,
+                             const Options& options) {
+  const FieldPresenceProfile* profile = options.field_presence_profile;
+  if (profile == nullptr ||
+      !profile->messages.contains(field->containing_type()->full_name())) {
+    return 1;
+  }
+  auto it = profile->fields.find(field->full_name());
+  return it == profile->fields.end() ? 0 : it->second;
+}
+// Returns how often `field` is accessed relative to the most accessed field of
+// its message according to the field access profile, or 1 if the profile does
+// not cover the field's message.
+static float GetAccessShare(const FieldDescriptor* field,
+                            const Options& options) {
+  const FieldAccessProfile* profile = options.field_access_profile;
+  if (profile == nullptr ||
+      !profile->messages.contains(field->containing_type()->full_name())) {
+    return 1;
+  }
+  auto it = profile->fields.find(field->full_name());
+  return it == profile->fields.end() ? 0 : it->second;
+}
+
+// Fields accessed less than this often, relative to the most accessed field of
+// their message, are moved to the split struct.
+static constexpr float kColdFieldAccessShare = 0.01f;
+
+// Strings accessed at least this often, relative to the most accessed field of
+// their message, are inlined.
+static constexpr float kHotStringAccessShare = 0.5f;
+
 bool IsStringInlined(const FieldDescriptor* descriptor,
                      const Options& options) {
-  (void)descriptor;
-  (void)options;
+  if (!options.profile_driven_inline_string ||
+      options.field_access_profile == nullptr ||
+      !options.field_access_profile->messages.contains(
+          descriptor->containing_type()->full_name())) {
+    return false;
+  }
+  // Inlined strings must have an empty default, and cannot be in a oneof.
+  if (!IsString(descriptor, options) || descriptor->is_repeated() ||
+      descriptor->is_extension() || descriptor->real_containing_oneof() ||
+      !descriptor->default_value_string().empty()) {
+    return false;
+  }
+  return GetAccessShare(descriptor, options) >= kHotStringAccessShare;
+}
+
+bool IsBitPacked(const FieldDescriptor* field, const Options& options) {
+  return !options.bitpacked_fields.empty() && field->is_repeated() &&
+         !field->is_extension() &&
+         field->cpp_type() == FieldDescriptor::CPPTYPE_BOOL &&
+         options.bitpacked_fields.contains(field->full_name());
+}
+
+bool HasBitPackedFields(const Descriptor* descriptor, const Options& options) {
+  if (options.bitpacked_fields.empty()) return false;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    if (IsBitPacked(descriptor->field(i), options)) return true;
+  }
   return false;
 }
 
+bool HasBitPackedFields(const FileDescriptor* file, const Options& options) {
+  if (options.bitpacked_fields.empty()) return false;
+  bool result = false;
+  ForEachField(file, [&](const FieldDescriptor* field) {
+    result = result || IsBitPacked(field, options);
+  });
+  return result;
+}
+
 static bool HasLazyFields(const Descriptor* descriptor, const Options& options,
                           MessageSCCAnalyzer* scc_analyzer) {
   for (int field_idx = 0; field_idx < descriptor->field_count(); field_idx++) {
@@ -934,8 +1001,33 @@ bool HasLazyFields(const FileDescriptor* file, const Options& options,
   return false;
 }
 
-bool ShouldSplit(const Descriptor*, const Options&) { return false; }
-bool ShouldSplit(const FieldDescriptor*, const Options&) { return false; }
+bool ShouldSplit(const Descriptor* desc, const Options& options) {
+  for (int i = 0; i < desc->field_count(); ++i) {
+    if (ShouldSplit(desc->field(i), options)) return true;
+  }
+  return false;
+}
+
+bool ShouldSplit(const FieldDescriptor* field, const Options& options) {
+  if (!options.force_split && (!options.profile_driven_split ||
+                               options.field_access_profile == nullptr)) {
+    return false;
+  }
+  // The split struct is trivially copyable and destructible, so it can only
+  // hold singular fields stored as plain values or pointers. Splitting also
+  // needs the reflection runtime.
+  const Descriptor* desc = field->containing_type();
+  if (!HasDescriptorMethods(desc->file(), options) ||
+      IsMapEntryMessage(desc) || HasSimpleBaseClass(desc, options) ||
+      field->is_repeated() || field->is_extension() ||
+      field->real_containing_oneof() || IsWeak(field, options) ||
+      IsExplicitLazy(field) || IsCord(field, options) ||
+      IsStringPiece(field, options) || IsStringInlined(field, options)) {
+    return false;
+  }
+  return options.force_split ||
+         GetAccessShare(field, options) < kColdFieldAccessShare;
+}
 
 bool ShouldForceAllocationOnConstruction(const Descriptor* desc,
                                          const Options& options) {
@@ -1529,21 +1621,9 @@ static bool HasExtensionFromFile(const Message& msg, const FileDescriptor* file,
   return false;
 }
 
-static bool HasBootstrapProblem(const FileDescriptor* file,
-                                const Options& options,
-                                bool* has_opt_codesize_extension) {
-  struct BoostrapGlobals {
-    absl::Mutex mutex;
-    absl::flat_hash_set<const FileDescriptor*> cached ABSL_GUARDED_BY(mutex);
-    absl::flat_hash_set<const FileDescriptor*> non_cached
-        ABSL_GUARDED_BY(mutex);
-  };
-  static auto& bootstrap_cache = *new BoostrapGlobals();
-
-  absl::MutexLock lock(&bootstrap_cache.mutex);
-  if (bootstrap_cache.cached.contains(file)) return true;
-  if (bootstrap_cache.non_cached.contains(file)) return false;
-
+static bool ComputeHasBootstrapProblem(const FileDescriptor* file,
+                                       const Options& options,
+                                       bool* has_opt_codesize_extension) {
   // In order to build the data structures for the reflective parse, it needs
   // to parse the serialized descriptor describing all the messages defined in
   // this file. Obviously this presents a bootstrap problem for descriptor
@@ -1581,12 +1661,34 @@ static bool HasBootstrapProblem(const FileDescriptor* file,
 
   bool res = HasExtensionFromFile(*fd_proto, file, options,
                                   has_opt_codesize_extension);
+  delete fd_proto;
+  return res;
+}
+
+static bool HasBootstrapProblem(const FileDescriptor* file,
+                                const Options& options,
+                                bool* has_opt_codesize_extension) {
+  struct BoostrapGlobals {
+    absl::Mutex mutex;
+    absl::flat_hash_set<const FileDescriptor*> cached ABSL_GUARDED_BY(mutex);
+    absl::flat_hash_set<const FileDescriptor*> non_cached
+        ABSL_GUARDED_BY(mutex);
+  };
+  static auto& bootstrap_cache = *new BoostrapGlobals();
+
+  absl::MutexLock lock(&bootstrap_cache.mutex);
+  if (bootstrap_cache.cached.contains(file)) return true;
+  if (bootstrap_cache.non_cached.contains(file)) return false;
+
+  // Cache every outcome, including the early ones: GetOptimizeFor() asks
+  // about the same file for each of its messages and fields.
+  bool res =
+      ComputeHasBootstrapProblem(file, options, has_opt_codesize_extension);
   if (res) {
     bootstrap_cache.cached.insert(file);
   } else {
     bootstrap_cache.non_cached.insert(file);
   }
-  delete fd_proto;
   return res;
 }
 
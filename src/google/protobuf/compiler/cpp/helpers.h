@@ -347,8 +347,26 @@ inline bool IsWeak(const FieldDescriptor* field, const Options& options) {
 
 bool IsProfileDriven(const Options& options);
 
+// Returns how likely `field` is to be present in a parsed message according
+// to the field presence profile, or 1 if the profile does not cover the
+// field's message. Fields of a covered message that the profile does not
+// mention are assumed to be absent.
+float GetPresenceProbability(const FieldDescriptor* field,
+                             const Options& options);
+
 bool IsStringInlined(const FieldDescriptor* descriptor, const Options& options);
 
+// Is `field` a repeated bool stored as a RepeatedBitField, as requested by the
+// bitpacked_fields option?
+bool IsBitPacked(const FieldDescriptor* field, const Options& options);
+
+// Does the message have any field for which IsBitPacked() is true?
+bool HasBitPackedFields(const Descriptor* descriptor, const Options& options);
+
+// Does the file have any field for which IsBitPacked() is true, necessitating
+// the file to include repeated_bit_field.h?
+bool HasBitPackedFields(const FileDescriptor* file, const Options& options);
+
 inline bool IsCord(const FieldDescriptor* field, const Options& options) {
   return field->cpp_type() == FieldDescriptor::CPPTYPE_STRING &&
          internal::cpp::EffectiveStringCType(field) == FieldOptions::CORD;
@@ -40,11 +40,13 @@
 #include <cstdint>
 #include <functional>
 #include <limits>
+#include <map>
 #include <memory>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/absl_check.h"
@@ -86,6 +88,31 @@ using Sub = ::google::protobuf::io::Printer::Sub;
 
 static constexpr int kNoHasbit = -1;
 
+// Messages with at least this many optional fields of one kind loop over the
+// set has-bits of those fields in Clear() and ByteSizeLong(), instead of
+// testing each field's has-bit in turn.
+static constexpr int kMinHasBitScanFields = 16;
+
+// Whether `descriptor`'s class declares `name` for one of its nested types,
+// nested enum values or extensions, so that a generated member function of
+// that name would clash with it.
+bool DeclaresNestedName(const Descriptor* descriptor, absl::string_view name) {
+  for (int i = 0; i < descriptor->nested_type_count(); ++i) {
+    if (descriptor->nested_type(i)->name() == name) return true;
+  }
+  for (int i = 0; i < descriptor->enum_type_count(); ++i) {
+    const EnumDescriptor* enum_type = descriptor->enum_type(i);
+    if (enum_type->name() == name) return true;
+    for (int j = 0; j < enum_type->value_count(); ++j) {
+      if (enum_type->value(j)->name() == name) return true;
+    }
+  }
+  for (int i = 0; i < descriptor->extension_count(); ++i) {
+    if (descriptor->extension(i)->name() == name) return true;
+  }
+  return false;
+}
+
 // Create an expression that evaluates to
 //  "for all i, (_has_bits_[i] & masks[i]) == masks[i]"
 // masks is allowed to be shorter than _has_bits_, but at least one element of
@@ -301,6 +328,55 @@ bool ShouldSerializeInOrder(const Descriptor* descriptor,
   return true;
 }
 
+// Returns true if _InternalSerialize should walk the parse table instead of
+// writing each field inline. The table describes neither extensions nor
+// message sets, and TcParser::SerializeFields does not handle maps, lazy,
+// split, weak or bit-packed fields.
+bool ShouldSerializeWithTable(const Descriptor* descriptor,
+                              const Options& options,
+                              MessageSCCAnalyzer* scc_analyzer) {
+  if (!(options.table_driven_serialization || options.table_driven_methods) ||
+      options.tctable_mode == Options::kTCTableNever ||
+      descriptor->extension_range_count() > 0 ||
+      descriptor->options().message_set_wire_format()) {
+    return false;
+  }
+  for (const auto* field : FieldRange(descriptor)) {
+    if (field->is_map() || field->options().weak() ||
+        IsLazy(field, options, scc_analyzer) || ShouldSplit(field, options) ||
+        IsBitPacked(field, options)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if ByteSizeLong should walk the parse table. It does so for
+// the same messages as _InternalSerialize, which then does not rely on the
+// cached sizes of packed fields that only the generated ByteSizeLong sets.
+bool ShouldSizeWithTable(const Descriptor* descriptor, const Options& options,
+                         MessageSCCAnalyzer* scc_analyzer) {
+  return options.table_driven_methods &&
+         ShouldSerializeWithTable(descriptor, options, scc_analyzer);
+}
+
+// Returns true if Clear should walk the parse table. TcParser::ClearFields
+// resets strings to empty, so strings with a non-empty default and inlined
+// strings (which track donation) keep their generated Clear.
+bool ShouldClearWithTable(const Descriptor* descriptor, const Options& options,
+                          MessageSCCAnalyzer* scc_analyzer) {
+  if (!ShouldSizeWithTable(descriptor, options, scc_analyzer)) return false;
+  for (const auto* field : FieldRange(descriptor)) {
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING &&
+        !field->is_repeated() &&
+        (!field->default_value_string().empty() ||
+         IsStringInlined(field, options))) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool IsCrossFileMapField(const FieldDescriptor* field) {
   if (!field->is_map()) {
     return false;
@@ -334,6 +410,61 @@ bool HasNonSplitOptionalString(const Descriptor* desc, const Options& options) {
   return false;
 }
 
+// Returns true if Assign() sets `field`: singular scalar and enum fields
+// outside oneofs, which are stored in place and need no arena.
+bool IsAssignable(const FieldDescriptor* field, const Options& options) {
+  if (field->is_repeated() || field->real_containing_oneof() != nullptr ||
+      ShouldSplit(field, options)) {
+    return false;
+  }
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_STRING:
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return false;
+    default:
+      return true;
+  }
+}
+
+// Returns true if the merge from an rvalue can take over the elements of
+// `field` by pointer: repeated string and message fields, and maps.
+bool IsMoveMergeable(const FieldDescriptor* field, const Options& options,
+                     MessageSCCAnalyzer* scc_analyzer) {
+  if (!field->is_repeated() || ShouldSplit(field, options)) return false;
+  if (field->is_map()) return true;
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_STRING:
+      return IsString(field, options);
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return !IsWeak(field, options) &&
+             !IsImplicitWeakField(field, options, scc_analyzer);
+    default:
+      return false;
+  }
+}
+
+// Returns an expression for `expr`, a value of `field`, that the generated
+// operator== and AbslHashValue() can compare and hash as is: floating point
+// values by their bits, and messages of types from other files, which may have
+// been generated without the hash_and_equality option, by their serialization.
+std::string ComparableValue(const FieldDescriptor* field,
+                            const Options& options, absl::string_view expr) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return absl::StrCat("::absl::bit_cast<::uint32_t>(", expr, ")");
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return absl::StrCat("::absl::bit_cast<::uint64_t>(", expr, ")");
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      if (field->message_type()->file() != field->file()) {
+        return absl::StrCat("::", ProtobufNamespace(options),
+                            "::internal::SerializeForComparison(", expr, ")");
+      }
+      return std::string(expr);
+    default:
+      return std::string(expr);
+  }
+}
+
 // Collects neighboring fields based on a given criteria (equivalent predicate).
 template <typename Predicate>
 std::vector<std::vector<const FieldDescriptor*>> CollectFields(
@@ -534,6 +665,7 @@ MessageGenerator::MessageGenerator(
       index_in_file_messages_(index_in_file_messages),
       options_(options),
       field_generators_(descriptor),
+      should_split_(ShouldSplit(descriptor, options)),
       scc_analyzer_(scc_analyzer) {
 
   if (!message_layout_helper_) {
@@ -1463,6 +1595,7 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
       "  $DCHK$(GetOwningArena() == other->GetOwningArena());\n"
       "  InternalSwap(other);\n"
       "}\n");
+  GenerateHashAndEqualityDecl(p);
 
   format(
       "\n"
@@ -1471,6 +1604,21 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
       "$classname$* New(::$proto_ns$::Arena* arena = nullptr) const final {\n"
       "  return CreateMaybeMessage<$classname$>(arena);\n"
       "}\n");
+  // Classes that declare a nested name Clone keep only the inherited
+  // Clone(), reached through a Message or MessageLite reference.
+  if (HasGeneratedMethods(descriptor_->file(), options_) &&
+      !DeclaresNestedName(descriptor_, "Clone")) {
+    // The new instance is known to be empty, so the copy is built by merging
+    // into it, or by overwriting it for all-scalar messages, rather than by
+    // CopyFrom()'s Clear() and merge.
+    format(
+        "$classname$* Clone(::$proto_ns$::Arena* arena = nullptr) const {\n"
+        "  $classname$* copy = CreateMaybeMessage<$classname$>(arena);\n"
+        "  copy->$1$(*this);\n"
+        "  return copy;\n"
+        "}\n",
+        CanCopyByOverwriting() ? "CopyFrom" : "MergeFrom");
+  }
 
   // For instances that derive from Message (rather than MessageLite), some
   // methods are virtual and should be marked as final.
@@ -1518,6 +1666,12 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
           "void CopyFrom(const $classname$& from);\n"
           "void MergeFrom(const $classname$& from);\n");
     }
+    if (HasMoveMergeableFields()) {
+      format("void MergeFrom($classname$&& from);\n");
+    }
+    if (HasAssignableFields()) {
+      GenerateAssignDecl(p);
+    }
 
     if (!HasSimpleBaseClass(descriptor_, options_)) {
       format(
@@ -1613,7 +1767,7 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
         "\n");
   }
 
-  if (ShouldSplit(descriptor_, options_)) {
+  if (should_split_) {
     format(
         "private:\n"
         "inline bool IsSplitMessageDefault() const {\n"
@@ -1772,7 +1926,7 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
       field_generators_.get(field).GeneratePrivateMembers(p);
     }
   }
-  if (ShouldSplit(descriptor_, options_)) {
+  if (should_split_) {
     format("struct Split {\n");
     format.Indent();
     for (auto field : optimized_order_) {
@@ -1841,7 +1995,7 @@ void MessageGenerator::GenerateClassDefinition(io::Printer* p) {
     format("union { Impl_ _impl_; };\n");
   }
 
-  if (ShouldSplit(descriptor_, options_)) {
+  if (should_split_) {
     format("friend struct $1$;\n",
            DefaultInstanceType(descriptor_, options_, /*split=*/true));
   }
@@ -1877,6 +2031,8 @@ void MessageGenerator::GenerateInlineMethods(io::Printer* p) {
           }
         )cc");
   }
+
+  GenerateHash(p);
 }
 
 void MessageGenerator::GenerateSchema(io::Printer* p, int offset,
@@ -2046,6 +2202,10 @@ void MessageGenerator::GenerateClassMethods(io::Printer* p) {
     GenerateClassSpecificMergeImpl(p);
     format("\n");
 
+    GenerateMoveMergeFrom(p);
+
+    GenerateAssign(p);
+
     GenerateCopyFrom(p);
     format("\n");
 
@@ -2053,7 +2213,7 @@ void MessageGenerator::GenerateClassMethods(io::Printer* p) {
     format("\n");
   }
 
-  if (ShouldSplit(descriptor_, options_)) {
+  if (should_split_) {
     format(
         "void $classname$::PrepareSplitMessageForWrite() {\n"
         "  if (IsSplitMessageDefault()) {\n"
@@ -2071,6 +2231,8 @@ void MessageGenerator::GenerateClassMethods(io::Printer* p) {
   GenerateSwap(p);
   format("\n");
 
+  GenerateEquals(p);
+
   if (HasDescriptorMethods(descriptor_->file(), options_)) {
     if (!descriptor_->options().map_entry()) {
       format(
@@ -2139,7 +2301,7 @@ std::pair<size_t, size_t> MessageGenerator::GenerateOffsets(io::Printer* p) {
   } else {
     format("~0u,  // no _inlined_string_donated_\n");
   }
-  if (ShouldSplit(descriptor_, options_)) {
+  if (should_split_) {
     format(
         "PROTOBUF_FIELD_OFFSET($classtype$, $split$),\n"
         "sizeof($classtype$::Impl_::Split),\n");
@@ -2261,7 +2423,7 @@ void MessageGenerator::GenerateSharedConstructorCode(io::Printer* p) {
                }
                field_generators_.get(field).GenerateAggregateInitializer(p);
              }
-             if (ShouldSplit(descriptor_, options_)) {
+             if (should_split_) {
                // We can't assign the default split to this->split without the
                // const_cast because the former is a const. The const_cast is
                // safe because we don't intend to modify the default split
@@ -2382,7 +2544,7 @@ void MessageGenerator::GenerateSharedConstructorCode(io::Printer* p) {
 }
 
 void MessageGenerator::GenerateInitDefaultSplitInstance(io::Printer* p) {
-  if (!ShouldSplit(descriptor_, options_)) return;
+  if (!should_split_) return;
 
   auto v = p->WithVars(ClassVars(descriptor_, options_));
   auto t = p->WithVars(MakeTrackerCalls(descriptor_, options_));
@@ -2416,7 +2578,7 @@ void MessageGenerator::GenerateSharedDestructorCode(io::Printer* p) {
           {"field_dtors", [&] { emit_field_dtors(/* split_fields= */ false); }},
           {"split_field_dtors",
            [&] {
-             if (!ShouldSplit(descriptor_, options_)) return;
+             if (!should_split_) return;
              p->Emit(
                  {
                      {"split_field_dtors_impl",
@@ -2499,7 +2661,7 @@ void MessageGenerator::GenerateArenaDestructorCode(io::Printer* p) {
           {"field_dtors", [&] { emit_field_dtors(/* split_fields= */ false); }},
           {"split_field_dtors",
            [&] {
-             if (!ShouldSplit(descriptor_, options_)) return;
+             if (!should_split_) return;
              p->Emit(
                  {
                      {"split_field_dtors_impl",
@@ -2578,7 +2740,7 @@ void MessageGenerator::GenerateConstexprConstructor(io::Printer* p) {
                field_generators_.get(field)
                    .GenerateConstexprAggregateInitializer(p);
              }
-             if (ShouldSplit(descriptor_, options_)) {
+             if (should_split_) {
                p->Emit({{"name", DefaultInstanceName(descriptor_, options_,
                                                      /*split=*/true)}},
                        R"cc(
@@ -2671,7 +2833,7 @@ void MessageGenerator::GenerateCopyConstructorBody(io::Printer* p) const {
     }
   }
 
-  if (ShouldSplit(descriptor_, options_)) {
+  if (should_split_) {
     format("if (!from.IsSplitMessageDefault()) {\n");
     format.Indent();
     format("_this->PrepareSplitMessageForWrite();\n");
@@ -2687,7 +2849,7 @@ void MessageGenerator::GenerateCopyConstructorBody(io::Printer* p) const {
 }
 
 bool MessageGenerator::ImplHasCopyCtor() const {
-  if (ShouldSplit(descriptor_, options_)) return false;
+  if (should_split_) return false;
   if (HasSimpleBaseClass(descriptor_, options_)) return false;
   if (descriptor_->extension_range_count() > 0) return false;
   if (descriptor_->real_oneof_decl_count() > 0) return false;
@@ -2752,7 +2914,7 @@ void MessageGenerator::GenerateCopyConstructorBodyImpl(io::Printer* p) const {
             if (ShouldSplit(field, options_)) continue;
             field_generators_.get(field).GenerateCopyAggregateInitializer(p);
           }
-          if (ShouldSplit(descriptor_, options_)) {
+          if (should_split_) {
             p->Emit({{"name", DefaultInstanceName(descriptor_, options_,
                                                   /*split=*/true)}},
                     R"cc(
@@ -2966,10 +3128,6 @@ void MessageGenerator::GenerateClear(io::Printer* p) {
   if (HasSimpleBaseClass(descriptor_, options_)) return;
   Formatter format(p);
 
-  // The maximum number of bytes we will memset to zero without checking their
-  // hasbit to see if a zero-init is necessary.
-  const int kMaxUnconditionalPrimitiveBytesClear = 4;
-
   format(
       "PROTOBUF_NOINLINE void $classname$::Clear() {\n"
       "// @@protoc_insertion_point(message_clear_start:$full_name$)\n");
@@ -2986,6 +3144,42 @@ void MessageGenerator::GenerateClear(io::Printer* p) {
     format("$extensions$.Clear();\n");
   }
 
+  if (ShouldClearWithTable(descriptor_, options_, scc_analyzer_)) {
+    // Oneofs and has-bits are cleared below.
+    format("::_pbi::TcParser::ClearFields(this, &_table_.header);\n");
+  } else {
+    GenerateClearFieldsBody(p);
+  }
+
+  // Step 4: Unions.
+  for (auto oneof : OneOfRange(descriptor_)) {
+    format("clear_$1$();\n", oneof->name());
+  }
+
+  if (num_weak_fields_) {
+    format("$weak_field_map$.ClearAll();\n");
+  }
+
+  // We don't clear donated status.
+
+  if (!has_bit_indices_.empty()) {
+    // Step 5: Everything else.
+    format("$has_bits$.Clear();\n");
+  }
+
+  format("_internal_metadata_.Clear<$unknown_fields_type$>();\n");
+
+  format.Outdent();
+  format("}\n");
+}
+
+void MessageGenerator::GenerateClearFieldsBody(io::Printer* p) {
+  Formatter format(p);
+
+  // The maximum number of bytes we will memset to zero without checking their
+  // hasbit to see if a zero-init is necessary.
+  const int kMaxUnconditionalPrimitiveBytesClear = 4;
+
   // Collect fields into chunks. Each chunk may have an if() condition that
   // checks all hasbits in the chunk and skips it if none are set.
   int zero_init_bytes = 0;
@@ -2997,6 +3191,21 @@ void MessageGenerator::GenerateClear(io::Printer* p) {
   bool merge_zero_init = zero_init_bytes > kMaxUnconditionalPrimitiveBytesClear;
   int chunk_count = 0;
 
+  // Sparse strings and messages are cleared by a loop over their set
+  // has-bits, and are kept in chunks of their own which are skipped below.
+  const std::vector<const FieldDescriptor*> scanned = ClearScanFields();
+  auto is_scanned = [&](const FieldDescriptor* field) {
+    return std::find(scanned.begin(), scanned.end(), field) != scanned.end();
+  };
+  if (!scanned.empty()) {
+    GenerateHasBitScan(
+        scanned, "",
+        [&](const FieldDescriptor* field) {
+          field_generators_.get(field).GenerateMessageClearingCode(p);
+        },
+        p);
+  }
+
   std::vector<std::vector<const FieldDescriptor*>> chunks = CollectFields(
       optimized_order_,
       [&](const FieldDescriptor* a, const FieldDescriptor* b) -> bool {
@@ -3007,6 +3216,7 @@ void MessageGenerator::GenerateClear(io::Printer* p) {
             HasByteIndex(a) == HasByteIndex(b) &&
             a->is_repeated() == b->is_repeated() &&
             ShouldSplit(a, options_) == ShouldSplit(b, options_) &&
+            is_scanned(a) == is_scanned(b) &&
             (CanClearByZeroing(a) == CanClearByZeroing(b) ||
              (CanClearByZeroing(a) && (chunk_count == 1 || merge_zero_init)));
         if (!same) chunk_count = 0;
@@ -3021,6 +3231,13 @@ void MessageGenerator::GenerateClear(io::Printer* p) {
     std::vector<const FieldDescriptor*>& chunk = chunks[chunk_index];
     cold_skipper.OnStartChunk(chunk_index, cached_has_word_index, "", p);
 
+    if (is_scanned(chunk.front())) {
+      if (cold_skipper.OnEndChunk(chunk_index, p)) {
+        cached_has_word_index = -1;
+      }
+      continue;
+    }
+
     const FieldDescriptor* memset_start = nullptr;
     const FieldDescriptor* memset_end = nullptr;
     bool saw_non_zero_init = false;
@@ -3133,27 +3350,88 @@ void MessageGenerator::GenerateClear(io::Printer* p) {
       cached_has_word_index = -1;
     }
   }
+}
 
-  // Step 4: Unions.
-  for (auto oneof : OneOfRange(descriptor_)) {
-    format("clear_$1$();\n", oneof->name());
+std::vector<const FieldDescriptor*> MessageGenerator::ClearScanFields() const {
+  std::vector<const FieldDescriptor*> fields;
+  for (const auto* field : optimized_order_) {
+    // The fields Clear() would otherwise test one has-bit at a time.
+    if (field->is_repeated() || HasBitIndex(field) == kNoHasbit ||
+        ShouldSplit(field, options_) || IsWeak(field, options_) ||
+        IsStringInlined(field, options_) ||
+        (field->cpp_type() != FieldDescriptor::CPPTYPE_STRING &&
+         field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE)) {
+      continue;
+    }
+    fields.push_back(field);
   }
+  if (fields.size() < kMinHasBitScanFields) fields.clear();
+  return fields;
+}
 
-  if (num_weak_fields_) {
-    format("$weak_field_map$.ClearAll();\n");
+std::vector<const FieldDescriptor*> MessageGenerator::ByteSizeScanFields()
+    const {
+  std::vector<const FieldDescriptor*> fields;
+  for (const auto* field : optimized_order_) {
+    if (field->is_repeated() || field->is_required() ||
+        HasBitIndex(field) == kNoHasbit || ShouldSplit(field, options_)) {
+      continue;
+    }
+    fields.push_back(field);
   }
+  if (fields.size() < kMinHasBitScanFields) fields.clear();
+  return fields;
+}
 
-  // We don't clear donated status.
-
-  if (!has_bit_indices_.empty()) {
-    // Step 5: Everything else.
-    format("$has_bits$.Clear();\n");
+bool MessageGenerator::UsesHasBitScan() const {
+  if (!HasGeneratedMethods(descriptor_->file(), options_) ||
+      HasSimpleBaseClass(descriptor_, options_)) {
+    return false;
   }
+  return !ClearScanFields().empty() || !ByteSizeScanFields().empty();
+}
 
-  format("_internal_metadata_.Clear<$unknown_fields_type$>();\n");
-
-  format.Outdent();
-  format("}\n");
+void MessageGenerator::GenerateHasBitScan(
+    const std::vector<const FieldDescriptor*>& fields,
+    absl::string_view source,
+    absl::FunctionRef<void(const FieldDescriptor*)> emit_field,
+    io::Printer* p) {
+  Formatter format(p);
+  // Group the fields by has-bit word, in has-bit order.
+  std::map<int, std::vector<const FieldDescriptor*>> by_word;
+  for (const auto* field : fields) {
+    by_word[HasWordIndex(field)].push_back(field);
+  }
+  for (auto& word : by_word) {
+    std::sort(word.second.begin(), word.second.end(),
+              [&](const FieldDescriptor* a, const FieldDescriptor* b) {
+                return HasBitIndex(a) < HasBitIndex(b);
+              });
+    format("cached_has_bits = $1$$has_bits$[$2$] & 0x$3$u;\n", source,
+           word.first,
+           absl::StrCat(absl::Hex(GenChunkMask(word.second, has_bit_indices_),
+                                  absl::kZeroPad8)));
+    format(
+        "while (cached_has_bits != 0) {\n"
+        "  switch (::absl::countr_zero(cached_has_bits)) {\n");
+    format.Indent();
+    format.Indent();
+    for (const auto* field : word.second) {
+      PrintFieldComment(format, field);
+      format("case $1$: {\n", HasBitIndex(field) % 32);
+      format.Indent();
+      emit_field(field);
+      format("break;\n");
+      format.Outdent();
+      format("}\n");
+    }
+    format.Outdent();
+    format.Outdent();
+    format(
+        "  }\n"
+        "  cached_has_bits &= cached_has_bits - 1;\n"
+        "}\n");
+  }
 }
 
 void MessageGenerator::GenerateOneofClear(io::Printer* p) {
@@ -3272,7 +3550,7 @@ void MessageGenerator::GenerateSwap(io::Printer* p) {
         field_generators_.get(field).GenerateSwappingCode(p);
       }
     }
-    if (ShouldSplit(descriptor_, options_)) {
+    if (should_split_) {
       format("swap($split$, other->$split$);\n");
     }
 
@@ -3382,18 +3660,34 @@ void MessageGenerator::GenerateClassSpecificMergeImpl(io::Printer* p) {
       "$uint32$ cached_has_bits = 0;\n"
       "(void) cached_has_bits;\n\n");
 
-  if (ShouldSplit(descriptor_, options_)) {
+  if (should_split_) {
     format(
         "if (!from.IsSplitMessageDefault()) {\n"
         "  _this->PrepareSplitMessageForWrite();\n"
         "}\n");
   }
 
+  // The sparse strings and messages that Clear() loops over are merged by a
+  // loop over the set has-bits of `from` too.
+  const std::vector<const FieldDescriptor*> scanned = ClearScanFields();
+  auto is_scanned = [&](const FieldDescriptor* field) {
+    return std::find(scanned.begin(), scanned.end(), field) != scanned.end();
+  };
+  if (!scanned.empty()) {
+    GenerateHasBitScan(
+        scanned, "from.",
+        [&](const FieldDescriptor* field) {
+          field_generators_.get(field).GenerateMergingCode(p);
+        },
+        p);
+  }
+
   std::vector<std::vector<const FieldDescriptor*>> chunks = CollectFields(
       optimized_order_,
       [&](const FieldDescriptor* a, const FieldDescriptor* b) -> bool {
         return HasByteIndex(a) == HasByteIndex(b) &&
-               ShouldSplit(a, options_) == ShouldSplit(b, options_);
+               ShouldSplit(a, options_) == ShouldSplit(b, options_) &&
+               is_scanned(a) == is_scanned(b);
       });
 
   ColdChunkSkipper cold_skipper(descriptor_, options_, chunks, has_bit_indices_,
@@ -3410,6 +3704,13 @@ void MessageGenerator::GenerateClassSpecificMergeImpl(io::Printer* p) {
         chunk.size() > 1 && HasByteIndex(chunk.front()) != kNoHasbit;
     cold_skipper.OnStartChunk(chunk_index, cached_has_word_index, "from.", p);
 
+    if (is_scanned(chunk.front())) {
+      if (cold_skipper.OnEndChunk(chunk_index, p)) {
+        cached_has_word_index = -1;
+      }
+      continue;
+    }
+
     if (have_outer_if) {
       // Emit an if() that will let us skip the whole chunk if none are set.
       uint32_t chunk_mask = GenChunkMask(chunk, has_bit_indices_);
@@ -3432,11 +3733,43 @@ void MessageGenerator::GenerateClassSpecificMergeImpl(io::Printer* p) {
       format.Indent();
     }
 
+    // Runs of scalars whose has-bits are deferred to the end of the chunk are
+    // copied with a single memcpy() when all of their fields are set.
+    const RunMap runs =
+        have_outer_if ? FindRuns(chunk,
+                                 [this](const FieldDescriptor* field) {
+                                   return IsPOD(field) && HasHasbit(field) &&
+                                          !ShouldSplit(field, options_);
+                                 })
+                      : RunMap();
+    const FieldDescriptor* run_end = nullptr;
+
     // Go back and emit merging code for each of the fields we processed.
     bool deferred_has_bit_changes = false;
-    for (const auto field : chunk) {
+    for (size_t i = 0; i < chunk.size(); ++i) {
+      const FieldDescriptor* field = chunk[i];
       const auto& generator = field_generators_.get(field);
 
+      const auto run = runs.find(field);
+      if (run != runs.end() && run->second > 1) {
+        std::vector<const FieldDescriptor*> run_fields(
+            chunk.begin() + i, chunk.begin() + i + run->second);
+        run_end = run_fields.back();
+        const std::string run_mask = absl::StrCat(absl::Hex(
+            GenChunkMask(run_fields, has_bit_indices_), absl::kZeroPad8));
+        format(
+            "if ((cached_has_bits & 0x$1$u) == 0x$1$u) {\n"
+            "  ::memcpy(&_this->$2$, &from.$2$,\n"
+            "      static_cast<::size_t>(\n"
+            "          reinterpret_cast<const char*>(&from.$3$) -\n"
+            "          reinterpret_cast<const char*>(&from.$2$)) +\n"
+            "      sizeof(from.$3$));\n"
+            "} else {\n",
+            run_mask, FieldMemberName(field, /*split=*/false),
+            FieldMemberName(run_end, /*split=*/false));
+        format.Indent();
+      }
+
       if (field->is_repeated()) {
         generator.GenerateMergingCode(p);
       } else if (field->is_optional() && !HasHasbit(field)) {
@@ -3481,6 +3814,12 @@ void MessageGenerator::GenerateClassSpecificMergeImpl(io::Printer* p) {
         format.Outdent();
         format("}\n");
       }
+
+      if (field == run_end) {
+        format.Outdent();
+        format("}\n");
+        run_end = nullptr;
+      }
     }
 
     if (have_outer_if) {
@@ -3544,6 +3883,402 @@ void MessageGenerator::GenerateClassSpecificMergeImpl(io::Printer* p) {
   format("}\n");
 }
 
+bool MessageGenerator::HasMoveMergeableFields() const {
+  if (HasSimpleBaseClass(descriptor_, options_)) return false;
+  for (const auto* field : FieldRange(descriptor_)) {
+    if (IsMoveMergeable(field, options_, scc_analyzer_)) return true;
+  }
+  return false;
+}
+
+bool MessageGenerator::CanCopyByOverwriting() const {
+  // Oneof fields are not in optimized_order_.
+  if (HasSimpleBaseClass(descriptor_, options_) || optimized_order_.empty() ||
+      optimized_order_.size() !=
+          static_cast<size_t>(descriptor_->field_count()) ||
+      descriptor_->extension_range_count() > 0 ||
+      should_split_) {
+    return false;
+  }
+  for (const auto* field : optimized_order_) {
+    if (!IsPOD(field)) return false;
+  }
+  return true;
+}
+
+bool MessageGenerator::HasAssignableFields() const {
+  if (!options_.bulk_assign || HasSimpleBaseClass(descriptor_, options_)) {
+    return false;
+  }
+  for (const auto* field : FieldRange(descriptor_)) {
+    if (IsAssignable(field, options_)) return true;
+  }
+  return false;
+}
+
+void MessageGenerator::GenerateAssignDecl(io::Printer* p) {
+  p->Emit(
+      {{"values",
+        [&] {
+          for (const auto* field : FieldRange(descriptor_)) {
+            if (!IsAssignable(field, options_)) continue;
+            p->Emit(
+                {{"type", field->cpp_type() == FieldDescriptor::CPPTYPE_ENUM
+                              ? QualifiedClassName(field->enum_type(), options_)
+                              : PrimitiveTypeName(options_, field->cpp_type())},
+                 {"name", FieldName(field)}},
+                R"cc(
+                  ::absl::optional<$type$> $name$;
+                )cc");
+          }
+        }}},
+      R"cc(
+        // Values for Assign(); fields left empty are not touched.
+        struct AssignValues {
+          $values$;
+        };
+        // Sets every field present in `values`, as the setters would, with
+        // one has-bit update per word.
+        void Assign(const AssignValues& values);
+      )cc");
+}
+
+void MessageGenerator::GenerateAssign(io::Printer* p) {
+  if (!HasAssignableFields()) return;
+  Formatter format(p);
+  format("void $classname$::Assign(const AssignValues& values) {\n");
+  format.Indent();
+
+  // Has-bits are collected in a local per word and stored once at the end.
+  std::vector<int> words;
+  for (const auto* field : optimized_order_) {
+    if (!IsAssignable(field, options_)) continue;
+    const int word = HasWordIndex(field);
+    if (word != kNoHasbit &&
+        std::find(words.begin(), words.end(), word) == words.end()) {
+      words.push_back(word);
+      format("$uint32$ has_bits_$1$ = 0;\n", word);
+    }
+  }
+  for (const auto* field : optimized_order_) {
+    if (!IsAssignable(field, options_)) continue;
+    auto t = p->WithVars(MakeTrackerCalls(field, options_));
+    const std::string name = FieldName(field);
+    format("if (values.$1$.has_value()) {\n", name);
+    format.Indent();
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_ENUM &&
+        !internal::cpp::HasPreservingUnknownEnumSemantics(field)) {
+      format("assert($1$_IsValid(*values.$2$));\n",
+             QualifiedClassName(field->enum_type(), options_), name);
+    }
+    format("$1$ = *values.$2$;\n", FieldMemberName(field, false), name);
+    const int has_bit_index = HasBitIndex(field);
+    if (has_bit_index != kNoHasbit) {
+      format("has_bits_$1$ |= 0x$2$u;\n", has_bit_index / 32,
+             absl::StrCat(absl::Hex(1u << (has_bit_index % 32),
+                                    absl::kZeroPad8)));
+    }
+    p->Emit(R"cc(
+      $annotate_set$;
+    )cc");
+    format.Outdent();
+    format("}\n");
+  }
+  for (int word : words) {
+    format("$has_bits$[$1$] |= has_bits_$1$;\n", word);
+  }
+  format.Outdent();
+  format("}\n\n");
+}
+
+bool MessageGenerator::HasHashAndEquality() const {
+  if (!options_.hash_and_equality || IsMapEntryMessage(descriptor_)) {
+    return false;
+  }
+  for (const auto* field : FieldRange(descriptor_)) {
+    if (IsWeak(field, options_) ||
+        IsImplicitWeakField(field, options_, scc_analyzer_) ||
+        IsBitPacked(field, options_)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MessageGenerator::GenerateHashAndEqualityDecl(io::Printer* p) {
+  if (!HasHashAndEquality()) return;
+  p->Emit(R"cc(
+    // Compare and hash the fields of the message, leaving out extensions
+    // and unknown fields. Floating point fields compare by their bits.
+    friend bool operator==(const $classname$& a, const $classname$& b) {
+      return a.InternalEquals(b);
+    }
+    friend bool operator!=(const $classname$& a, const $classname$& b) {
+      return !a.InternalEquals(b);
+    }
+    template <typename H>
+    friend H AbslHashValue(H h, const $classname$& message) {
+      return message.InternalHash(std::move(h));
+    }
+
+    private:
+    bool InternalEquals(const $classname$& other) const;
+    template <typename H>
+    H InternalHash(H h) const;
+
+    public:
+  )cc");
+}
+
+void MessageGenerator::GenerateEquals(io::Printer* p) {
+  if (!HasHashAndEquality()) return;
+  Formatter format(p);
+  format(
+      "bool $classname$::InternalEquals(const $classname$& other) const {\n");
+  format.Indent();
+  GenerateHashOrEqualsBody(p, /*hash=*/false);
+  format("return true;\n");
+  format.Outdent();
+  format("}\n\n");
+}
+
+void MessageGenerator::GenerateHash(io::Printer* p) {
+  if (!HasHashAndEquality()) return;
+  Formatter format(p);
+  format(
+      "template <typename H>\n"
+      "H $classname$::InternalHash(H h) const {\n");
+  format.Indent();
+  GenerateHashOrEqualsBody(p, /*hash=*/true);
+  format("return h;\n");
+  format.Outdent();
+  format("}\n\n");
+}
+
+void MessageGenerator::GenerateHashOrEqualsBody(io::Printer* p, bool hash) {
+  Formatter format(p);
+  if (!hash && descriptor_->field_count() == 0) {
+    format("(void)other;\n");
+    return;
+  }
+
+  // Compares or hashes two values as returned by ComparableValue().
+  auto combine = [&](absl::string_view value, absl::string_view other_value) {
+    if (hash) {
+      format("h = H::combine(std::move(h), $1$);\n", value);
+    } else {
+      format("if (!($1$ == $2$)) return false;\n", value, other_value);
+    }
+  };
+  // Compares or hashes `size` bytes of memory starting at the member `name`.
+  // The arguments are part of the format string, so they may use variables.
+  auto combine_bytes = [&](absl::string_view name, absl::string_view size) {
+    const std::string code =
+        hash ? absl::StrCat("h = H::combine_contiguous(\n"
+                            "    std::move(h), reinterpret_cast<const unsigned "
+                            "char*>(&",
+                            name, "),\n    ", size, ");\n")
+             : absl::StrCat("if (::memcmp(&", name, ", &other.", name,
+                            ",\n    ", size, ") != 0) {\n  return false;\n}\n");
+    format(code.c_str());
+  };
+
+  // Has-bits settle the presence of every field that has one, so fields
+  // below need only be looked at when present.
+  if (HasBitsSize() > 0) {
+    combine_bytes("$has_bits$", "sizeof($has_bits$)");
+  }
+
+  // Neighboring scalars of the same size have no padding between them, so
+  // each run of them is handled as a single block of memory. Absent scalars
+  // hold their default value and so need no has-bit check.
+  std::vector<std::vector<const FieldDescriptor*>> chunks = CollectFields(
+      optimized_order_,
+      [&](const FieldDescriptor* a, const FieldDescriptor* b) -> bool {
+        return IsPOD(a) && IsPOD(b) && !ShouldSplit(a, options_) &&
+               !ShouldSplit(b, options_) &&
+               EstimateAlignmentSize(a) == EstimateAlignmentSize(b);
+      });
+  for (const auto& chunk : chunks) {
+    const FieldDescriptor* first = chunk.front();
+    if (IsPOD(first) && !ShouldSplit(first, options_)) {
+      const std::string first_name = FieldMemberName(first, /*split=*/false);
+      const std::string last_name =
+          FieldMemberName(chunk.back(), /*split=*/false);
+      combine_bytes(first_name,
+                    chunk.size() == 1
+                        ? absl::StrCat("sizeof(", first_name, ")")
+                        : absl::StrCat("static_cast<::size_t>(\n"
+                                       "        reinterpret_cast<const char*>(&",
+                                       last_name,
+                                       ") -\n"
+                                       "        reinterpret_cast<const char*>(&",
+                                       first_name, ")) +\n    sizeof(",
+                                       last_name, ")"));
+      continue;
+    }
+    for (const auto* field : chunk) {
+      const std::string name = FieldName(field);
+      const bool has_hasbit = HasHasbit(field);
+      if (has_hasbit) {
+        const int has_bit_index = HasBitIndex(field);
+        format("if (($has_bits$[$1$] & 0x$2$u) != 0) {\n",
+               has_bit_index / 32,
+               absl::StrCat(absl::Hex(1u << (has_bit_index % 32),
+                                      absl::kZeroPad8)));
+        format.Indent();
+      }
+      if (field->is_map()) {
+        const FieldDescriptor* value_field =
+            field->message_type()->map_value();
+        if (hash) {
+          // Map iteration order is unspecified, so a map contributes only
+          // its size.
+          format("h = H::combine(std::move(h), _internal_$1$().size());\n",
+                 name);
+        } else {
+          format(
+              "if (_internal_$1$().size() != other._internal_$1$().size()) {\n"
+              "  return false;\n"
+              "}\n"
+              "for (const auto& entry : _internal_$1$()) {\n"
+              "  auto it = other._internal_$1$().find(entry.first);\n"
+              "  if (it == other._internal_$1$().end() ||\n"
+              "      !($2$ == $3$)) {\n"
+              "    return false;\n"
+              "  }\n"
+              "}\n",
+              name, ComparableValue(value_field, options_, "entry.second"),
+              ComparableValue(value_field, options_, "it->second"));
+        }
+      } else if (field->is_repeated() &&
+                 field->cpp_type() != FieldDescriptor::CPPTYPE_STRING &&
+                 field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+        // RepeatedField keeps its elements in one array.
+        if (hash) {
+          format(
+              "h = H::combine(std::move(h), _internal_$1$().size());\n"
+              "h = H::combine_contiguous(\n"
+              "    std::move(h),\n"
+              "    reinterpret_cast<const unsigned char*>(_internal_$1$().data()),"
+              "\n"
+              "    _internal_$1$().size() * sizeof(*_internal_$1$().data()));\n",
+              name);
+        } else {
+          format(
+              "if (_internal_$1$().size() != other._internal_$1$().size() ||\n"
+              "    (!_internal_$1$().empty() &&\n"
+              "     ::memcmp(_internal_$1$().data(), "
+              "other._internal_$1$().data(),\n"
+              "              _internal_$1$().size() *\n"
+              "                  sizeof(*_internal_$1$().data())) != 0)) {\n"
+              "  return false;\n"
+              "}\n",
+              name);
+        }
+      } else if (field->is_repeated()) {
+        if (hash) {
+          format(
+              "h = H::combine(std::move(h), _internal_$1$().size());\n"
+              "for (const auto& element : _internal_$1$()) {\n",
+              name);
+          format.Indent();
+          combine(ComparableValue(field, options_, "element"), "");
+          format.Outdent();
+          format("}\n");
+        } else {
+          format(
+              "if (_internal_$1$().size() != other._internal_$1$().size()) {\n"
+              "  return false;\n"
+              "}\n"
+              "for (int i = 0; i < _internal_$1$().size(); ++i) {\n",
+              name);
+          format.Indent();
+          combine(ComparableValue(field, options_,
+                                  absl::StrCat("_internal_", name, "().Get(i)")),
+                  ComparableValue(
+                      field, options_,
+                      absl::StrCat("other._internal_", name, "().Get(i)")));
+          format.Outdent();
+          format("}\n");
+        }
+      } else {
+        combine(ComparableValue(field, options_,
+                                absl::StrCat("_internal_", name, "()")),
+                ComparableValue(field, options_,
+                                absl::StrCat("other._internal_", name, "()")));
+      }
+      if (has_hasbit) {
+        format.Outdent();
+        format("}\n");
+      }
+    }
+  }
+
+  for (const auto* oneof : OneOfRange(descriptor_)) {
+    if (hash) {
+      format("h = H::combine(std::move(h), static_cast<int>($1$_case()));\n",
+             oneof->name());
+    } else {
+      format("if ($1$_case() != other.$1$_case()) return false;\n",
+             oneof->name());
+    }
+    format("switch ($1$_case()) {\n", oneof->name());
+    format.Indent();
+    for (const auto* field : FieldRange(oneof)) {
+      const std::string name = FieldName(field);
+      format("case $1$:\n", OneofCaseConstantName(field));
+      format.Indent();
+      combine(ComparableValue(field, options_,
+                              absl::StrCat("_internal_", name, "()")),
+              ComparableValue(field, options_,
+                              absl::StrCat("other._internal_", name, "()")));
+      format("break;\n");
+      format.Outdent();
+    }
+    format(
+        "case $1$_NOT_SET:\n"
+        "  break;\n",
+        absl::AsciiStrToUpper(oneof->name()));
+    format.Outdent();
+    format("}\n");
+  }
+}
+
+void MessageGenerator::GenerateMoveMergeFrom(io::Printer* p) {
+  if (!HasMoveMergeableFields()) return;
+  Formatter format(p);
+  format(
+      "void $classname$::MergeFrom($classname$&& from) {\n"
+      "  $classname$* const _this = this;\n"
+      "  $DCHK$_NE(&from, _this);\n"
+      "  // Take over the repeated and map fields and the unknown fields\n"
+      "  // first. Repeated and map fields are moved by pointer when both\n"
+      "  // messages share an arena, and `from` is left with all of them\n"
+      "  // empty for the copying merge below either way.\n");
+  format.Indent();
+  for (const auto* field : optimized_order_) {
+    if (!IsMoveMergeable(field, options_, scc_analyzer_)) continue;
+    if (field->is_map()) {
+      format(
+          "::_pbi::MapMergeFrom(*_this->_internal_mutable_$1$(),\n"
+          "                     std::move(*from._internal_mutable_$1$()));\n",
+          FieldName(field));
+    } else {
+      format(
+          "_this->_internal_mutable_$1$()->MergeFrom(\n"
+          "    std::move(*from._internal_mutable_$1$()));\n",
+          FieldName(field));
+    }
+  }
+  format(
+      "_this->_internal_metadata_.MergeFrom<$unknown_fields_type$>(\n"
+      "    std::move(from._internal_metadata_));\n"
+      "MergeFrom(static_cast<const $classname$&>(from));\n");
+  format.Outdent();
+  format("}\n\n");
+}
+
 void MessageGenerator::GenerateCopyFrom(io::Printer* p) {
   if (HasSimpleBaseClass(descriptor_, options_)) return;
   Formatter format(p);
@@ -3569,6 +4304,34 @@ void MessageGenerator::GenerateCopyFrom(io::Printer* p) {
 
   format("if (&from == this) return;\n");
 
+  if (CanCopyByOverwriting()) {
+    // Every field is a scalar that holds its default value when not present,
+    // so copying all of them and the has-bits leaves the same state as
+    // Clear() followed by MergeFrom().
+    if (!has_bit_indices_.empty()) {
+      format("$has_bits$ = from.$has_bits$;\n");
+    }
+    const FieldDescriptor* first = optimized_order_.front();
+    const FieldDescriptor* last = optimized_order_.back();
+    if (first == last) {
+      format("$1$ = from.$1$;\n", FieldMemberName(first, /*split=*/false));
+    } else {
+      format(
+          "::memcpy(&$1$, &from.$1$,\n"
+          "    static_cast<::size_t>(reinterpret_cast<char*>(&$2$) -\n"
+          "    reinterpret_cast<char*>(&$1$)) + sizeof($2$));\n",
+          FieldMemberName(first, /*split=*/false),
+          FieldMemberName(last, /*split=*/false));
+    }
+    format(
+        "_internal_metadata_.Clear<$unknown_fields_type$>();\n"
+        "_internal_metadata_.MergeFrom<$unknown_fields_type$>(\n"
+        "    from._internal_metadata_);\n");
+    format.Outdent();
+    format("}\n");
+    return;
+  }
+
   if (!options_.opensource_runtime && HasMessageFieldOrExtension(descriptor_)) {
     // This check is disabled in the opensource release because we're
     // concerned that many users do not define NDEBUG in their release builds.
@@ -3717,6 +4480,16 @@ void MessageGenerator::GenerateSerializeWithCachedSizesToArray(io::Printer* p) {
 
   format("// @@protoc_insertion_point(serialize_to_array_start:$full_name$)\n");
 
+  if (ShouldSerializeWithTable(descriptor_, options_, scc_analyzer_)) {
+    GenerateSerializeWithTableBody(p);
+    format("// @@protoc_insertion_point(serialize_to_array_end:$full_name$)\n");
+    format.Outdent();
+    format(
+        "  return target;\n"
+        "}\n");
+    return;
+  }
+
   if (!ShouldSerializeInOrder(descriptor_, options_)) {
     format.Outdent();
     format("#ifdef NDEBUG\n");
@@ -3946,6 +4719,28 @@ void MessageGenerator::GenerateSerializeWithCachedSizesBody(io::Printer* p) {
   format("}\n");
 }
 
+void MessageGenerator::GenerateSerializeWithTableBody(io::Printer* p) {
+  Formatter format(p);
+  format(
+      "target = ::_pbi::TcParser::SerializeFields(this, &_table_.header,\n"
+      "                                           target, stream);\n");
+  format("if (PROTOBUF_PREDICT_FALSE($have_unknown_fields$)) {\n");
+  format.Indent();
+  if (UseUnknownFieldSet(descriptor_->file(), options_)) {
+    format(
+        "target = "
+        "::_pbi::WireFormat::"
+        "InternalSerializeUnknownFieldsToArray(\n"
+        "    $unknown_fields$, target, stream);\n");
+  } else {
+    format(
+        "target = stream->WriteRaw($unknown_fields$.data(),\n"
+        "    static_cast<int>($unknown_fields$.size()), target);\n");
+  }
+  format.Outdent();
+  format("}\n");
+}
+
 void MessageGenerator::GenerateSerializeWithCachedSizesBodyShuffled(
     io::Printer* p) {
   Formatter format(p);
@@ -4102,6 +4897,38 @@ void MessageGenerator::GenerateByteSize(io::Printer* p) {
     format("}\n");
   }
 
+  // Adds the size of unknown fields, caches the total and closes the function.
+  auto emit_tail = [&] {
+    if (UseUnknownFieldSet(descriptor_->file(), options_)) {
+      // We go out of our way to put the computation of the uncommon path of
+      // unknown fields in tail position. This allows for better code generation
+      // of this function for simple protos.
+      format(
+          "return MaybeComputeUnknownFieldsSize(total_size, "
+          "&$cached_size$);\n");
+    } else {
+      format("if (PROTOBUF_PREDICT_FALSE($have_unknown_fields$)) {\n");
+      format("  total_size += $unknown_fields$.size();\n");
+      format("}\n");
+
+      // We update _cached_size_ even though this is a const method.  Because
+      // const methods might be called concurrently this needs to be atomic
+      // operations or the program is undefined.  In practice, since any
+      // concurrent writes will be writing the exact same value, normal writes
+      // will work on all common processors. We use a dedicated wrapper class
+      // to abstract away the underlying atomic. This makes it easier on
+      // platforms where even relaxed memory order might have perf impact to
+      // replace it with ordinary loads and stores.
+      format(
+          "int cached_size = ::_pbi::ToCachedSize(total_size);\n"
+          "SetCachedSize(cached_size);\n"
+          "return total_size;\n");
+    }
+
+    format.Outdent();
+    format("}\n");
+  };
+
   format(
       "::size_t $classname$::ByteSizeLong() const {\n"
       "$annotate_bytesize$"
@@ -4117,6 +4944,15 @@ void MessageGenerator::GenerateByteSize(io::Printer* p) {
         "\n");
   }
 
+  if (ShouldSizeWithTable(descriptor_, options_, scc_analyzer_)) {
+    format(
+        "total_size += ::_pbi::TcParser::ByteSizeFields(this, "
+        "&_table_.header);\n"
+        "\n");
+    emit_tail();
+    return;
+  }
+
   // Handle required fields (if any).  We expect all of them to be
   // present, so emit one conditional that checks for that.  If they are all
   // present then the fast path executes; otherwise the slow path executes.
@@ -4164,6 +5000,24 @@ void MessageGenerator::GenerateByteSize(io::Printer* p) {
   chunks.erase(std::remove_if(chunks.begin(), chunks.end(), IsRequired),
                chunks.end());
 
+  // Sparse optional fields are sized by a loop over their set has-bits.
+  const std::vector<const FieldDescriptor*> scanned = ByteSizeScanFields();
+  for (auto& chunk : chunks) {
+    chunk.erase(std::remove_if(chunk.begin(), chunk.end(),
+                               [&](const FieldDescriptor* field) {
+                                 return std::find(scanned.begin(),
+                                                  scanned.end(),
+                                                  field) != scanned.end();
+                               }),
+                chunk.end());
+  }
+  chunks.erase(
+      std::remove_if(chunks.begin(), chunks.end(),
+                     [](const std::vector<const FieldDescriptor*>& chunk) {
+                       return chunk.empty();
+                     }),
+      chunks.end());
+
   ColdChunkSkipper cold_skipper(descriptor_, options_, chunks, has_bit_indices_,
                                 kColdRatio);
   int cached_has_word_index = -1;
@@ -4173,6 +5027,15 @@ void MessageGenerator::GenerateByteSize(io::Printer* p) {
       "// Prevent compiler warnings about cached_has_bits being unused\n"
       "(void) cached_has_bits;\n\n");
 
+  if (!scanned.empty()) {
+    GenerateHasBitScan(
+        scanned, "",
+        [&](const FieldDescriptor* field) {
+          field_generators_.get(field).GenerateByteSize(p);
+        },
+        p);
+  }
+
   for (int chunk_index = 0; chunk_index < chunks.size(); chunk_index++) {
     const std::vector<const FieldDescriptor*>& chunk = chunks[chunk_index];
     const bool have_outer_if =
@@ -4273,33 +5136,7 @@ void MessageGenerator::GenerateByteSize(io::Printer* p) {
     format("total_size += $weak_field_map$.ByteSizeLong();\n");
   }
 
-  if (UseUnknownFieldSet(descriptor_->file(), options_)) {
-    // We go out of our way to put the computation of the uncommon path of
-    // unknown fields in tail position. This allows for better code generation
-    // of this function for simple protos.
-    format(
-        "return MaybeComputeUnknownFieldsSize(total_size, &$cached_size$);\n");
-  } else {
-    format("if (PROTOBUF_PREDICT_FALSE($have_unknown_fields$)) {\n");
-    format("  total_size += $unknown_fields$.size();\n");
-    format("}\n");
-
-    // We update _cached_size_ even though this is a const method.  Because
-    // const methods might be called concurrently this needs to be atomic
-    // operations or the program is undefined.  In practice, since any
-    // concurrent writes will be writing the exact same value, normal writes
-    // will work on all common processors. We use a dedicated wrapper class to
-    // abstract away the underlying atomic. This makes it easier on platforms
-    // where even relaxed memory order might have perf impact to replace it with
-    // ordinary loads and stores.
-    format(
-        "int cached_size = ::_pbi::ToCachedSize(total_size);\n"
-        "SetCachedSize(cached_size);\n"
-        "return total_size;\n");
-  }
-
-  format.Outdent();
-  format("}\n");
+  emit_tail();
 }
 
 void MessageGenerator::GenerateIsInitialized(io::Printer* p) {
@@ -4396,6 +5233,90 @@ void MessageGenerator::GenerateIsInitialized(io::Printer* p) {
       )cc");
 }
 
+namespace {
+
+// Returns the padding between `fields` when they are laid out in order, each
+// aligned to its own alignment.
+int InteriorPadding(const std::vector<const FieldDescriptor*>& fields) {
+  int offset = 0;
+  int padding = 0;
+  for (const FieldDescriptor* field : fields) {
+    int alignment = EstimateAlignmentSize(field);
+    int aligned = (offset + alignment - 1) / alignment * alignment;
+    padding += aligned - offset;
+    // Every field is a multiple of its alignment in size, so advancing by the
+    // alignment keeps the offsets right modulo any later alignment.
+    offset = aligned + alignment;
+  }
+  return padding;
+}
+
+std::string JsonFieldNames(const std::vector<const FieldDescriptor*>& fields) {
+  return absl::StrCat(
+      "[",
+      absl::StrJoin(fields, ", ",
+                    [](std::string* out, const FieldDescriptor* field) {
+                      absl::StrAppend(out, "\"", field->name(), "\"");
+                    }),
+      "]");
+}
+
+}  // namespace
+
+void MessageGenerator::GenerateLayoutReport(io::Printer* p) {
+  std::vector<const FieldDescriptor*> fields;
+  std::vector<const FieldDescriptor*> split_fields;
+  std::vector<const FieldDescriptor*> inlined_string_fields;
+  for (const FieldDescriptor* field : optimized_order_) {
+    if (ShouldSplit(field, options_)) {
+      split_fields.push_back(field);
+    } else {
+      fields.push_back(field);
+    }
+    if (IsStringInlined(field, options_)) {
+      inlined_string_fields.push_back(field);
+    }
+  }
+  std::vector<const FieldDescriptor*> declaration_order = fields;
+  absl::c_sort(declaration_order,
+               [](const FieldDescriptor* a, const FieldDescriptor* b) {
+                 return a->index() < b->index();
+               });
+
+  // Fields without a fast-path slot are parsed by MiniParse.
+  const internal::TailCallTableInfo* table =
+      parse_function_generator_->tc_table_info();
+  size_t fast_table_slots = 0;
+  size_t fast_table_fields = 0;
+  std::vector<const FieldDescriptor*> mini_parse_fields;
+  if (table != nullptr) {
+    absl::flat_hash_set<const FieldDescriptor*> fast_fields;
+    for (const auto& entry : table->fast_path_fields) {
+      if (entry.field != nullptr) fast_fields.insert(entry.field);
+    }
+    for (const auto& entry : table->field_entries) {
+      if (!fast_fields.contains(entry.field)) {
+        mini_parse_fields.push_back(entry.field);
+      }
+    }
+    fast_table_slots = table->fast_path_fields.size();
+    fast_table_fields = fast_fields.size();
+  }
+
+  p->PrintRaw(absl::StrCat(
+      "{\"message\": \"", descriptor_->full_name(), "\"",
+      ", \"padding_bytes\": ", InteriorPadding(fields),
+      ", \"declaration_order_padding_bytes\": ",
+      InteriorPadding(declaration_order),
+      ", \"has_bit_words\": ", HasBitsSize(),
+      ", \"split_fields\": ", JsonFieldNames(split_fields),
+      ", \"inlined_string_fields\": ", JsonFieldNames(inlined_string_fields),
+      ", \"tail_call_table\": ", table != nullptr ? "true" : "false",
+      ", \"fast_table_slots\": ", fast_table_slots,
+      ", \"fast_table_fields\": ", fast_table_fields,
+      ", \"mini_parse_fields\": ", JsonFieldNames(mini_parse_fields), "}\n"));
+}
+
 }  // namespace cpp
 }  // namespace compiler
 }  // namespace protobuf
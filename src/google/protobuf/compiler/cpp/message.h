@@ -43,6 +43,7 @@
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "google/protobuf/compiler/cpp/enum.h"
 #include "google/protobuf/compiler/cpp/extension.h"
 #include "google/protobuf/compiler/cpp/field.h"
@@ -84,6 +85,14 @@ class MessageGenerator {
   // Generate all non-inline methods for this class.
   void GenerateClassMethods(io::Printer* p);
 
+  // Generate the line describing this class in the layout report (see the
+  // layout_report option in generator.cc).
+  void GenerateLayoutReport(io::Printer* p);
+
+  // Returns whether the generated methods use absl::countr_zero() to scan
+  // has-bits.
+  bool UsesHasBitScan() const;
+
   // Generate source file code that should go outside any namespace.
   void GenerateSourceInProto2Namespace(io::Printer* p);
 
@@ -123,15 +132,27 @@ class MessageGenerator {
 
   // Generate standard Message methods.
   void GenerateClear(io::Printer* p);
+  // Clears the non-oneof fields of the message in Clear().
+  void GenerateClearFieldsBody(io::Printer* p);
   void GenerateOneofClear(io::Printer* p);
   void GenerateVerify(io::Printer* p);
   void GenerateSerializeWithCachedSizes(io::Printer* p);
   void GenerateSerializeWithCachedSizesToArray(io::Printer* p);
   void GenerateSerializeWithCachedSizesBody(io::Printer* p);
   void GenerateSerializeWithCachedSizesBodyShuffled(io::Printer* p);
+  void GenerateSerializeWithTableBody(io::Printer* p);
   void GenerateByteSize(io::Printer* p);
   void GenerateMergeFrom(io::Printer* p);
   void GenerateClassSpecificMergeImpl(io::Printer* p);
+  void GenerateMoveMergeFrom(io::Printer* p);
+  void GenerateAssignDecl(io::Printer* p);
+  void GenerateAssign(io::Printer* p);
+  void GenerateHashAndEqualityDecl(io::Printer* p);
+  void GenerateEquals(io::Printer* p);
+  void GenerateHash(io::Printer* p);
+  // Emits the field comparisons of InternalEquals() or, if `hash`, the
+  // combining of fields into `h` of InternalHash().
+  void GenerateHashOrEqualsBody(io::Printer* p, bool hash);
   void GenerateCopyFrom(io::Printer* p);
   void GenerateSwap(io::Printer* p);
   void GenerateIsInitialized(io::Printer* p);
@@ -164,6 +185,36 @@ class MessageGenerator {
   // Returns whether impl_ has a copy ctor.
   bool ImplHasCopyCtor() const;
 
+  // Returns whether the message gets a MergeFrom(T&&) overload, i.e. has
+  // repeated or map fields whose elements can be moved by pointer.
+  bool HasMoveMergeableFields() const;
+
+  // Returns the fields that Clear() and ByteSizeLong() handle with a loop over
+  // their set has-bits, or nothing if there are too few of them for it to pay
+  // off.
+  std::vector<const FieldDescriptor*> ClearScanFields() const;
+  std::vector<const FieldDescriptor*> ByteSizeScanFields() const;
+  // Emits a loop over the set has-bits of `fields`, one has-bit word at a
+  // time, which runs the code from `emit_field` for each set field.  The
+  // has-bits are read from `source`, e.g. "from.", or from `this` if empty.
+  void GenerateHasBitScan(
+      const std::vector<const FieldDescriptor*>& fields,
+      absl::string_view source,
+      absl::FunctionRef<void(const FieldDescriptor*)> emit_field,
+      io::Printer* p);
+
+  // Returns whether CopyFrom() can overwrite every field instead of clearing
+  // the message and merging, i.e. all fields are singular scalars.
+  bool CanCopyByOverwriting() const;
+
+  // Returns whether the message gets an Assign(const AssignValues&) method,
+  // i.e. the bulk_assign option is set and it has singular scalar fields.
+  bool HasAssignableFields() const;
+
+  // Returns whether the message gets operator== and AbslHashValue(), i.e. the
+  // hash_and_equality option is set and it has no weak fields.
+  bool HasHashAndEquality() const;
+
   // Generates the body of the message's copy constructor.
   void GenerateCopyConstructorBody(io::Printer* p) const;
   void GenerateCopyConstructorBodyImpl(io::Printer* p) const;
@@ -194,6 +245,8 @@ class MessageGenerator {
   int index_in_file_messages_;
   Options options_;
   FieldGeneratorTable field_generators_;
+  // ShouldSplit() for the message, which the generator asks about many times.
+  bool should_split_;
   // optimized_order_ is the order we layout the message's fields in the
   // class. This is reused to initialize the fields in-order for cache
   // efficiency.
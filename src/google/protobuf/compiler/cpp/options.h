@@ -35,6 +35,7 @@
 
 #include <string>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 
 namespace google {
@@ -57,15 +58,37 @@ struct FieldListenerOptions {
   absl::flat_hash_set<std::string> forbidden_field_listener_events;
 };
 
+// How often fields are present in parsed messages, as collected from a
+// running binary.
+struct FieldPresenceProfile {
+  // Maps full field names to the fraction of parsed messages that contain
+  // them, from 0 to 1.
+  absl::flat_hash_map<std::string, float> fields;
+  // Full names of the messages with at least one entry in `fields`.
+  absl::flat_hash_set<std::string> messages;
+};
+
+// How often the fields of each message are accessed, as sampled from a running
+// binary by FieldAccessSampler (see field_access_sampler.h). Uses the same
+// format as the presence profile, with each value being the share of a field's
+// accesses relative to the most accessed field of its message.
+using FieldAccessProfile = FieldPresenceProfile;
+
 // Generator options (see generator.cc for a description of each):
 struct Options {
   const AccessInfoMap* access_info_map = nullptr;
+  const FieldPresenceProfile* field_presence_profile = nullptr;
+  const FieldAccessProfile* field_access_profile = nullptr;
   const SplitMap* split_map = nullptr;
   std::string dllexport_decl;
   std::string runtime_include_base;
   std::string annotation_pragma_name;
   std::string annotation_guard_name;
   FieldListenerOptions field_listener_options;
+  // Full names of repeated message fields that get column accessors.
+  absl::flat_hash_set<std::string> columnar_fields;
+  // Full names of repeated bool fields stored one bit per element.
+  absl::flat_hash_set<std::string> bitpacked_fields;
   EnforceOptimizeMode enforce_mode = EnforceOptimizeMode::kNoEnforcement;
   enum { kTCTableNever, kTCTableAlways } tctable_mode = kTCTableAlways;
   int num_cc_files = 0;
@@ -81,6 +104,12 @@ struct Options {
   bool profile_driven_inline_string = true;
   bool force_split = false;
   bool profile_driven_split = true;
+  bool table_driven_serialization = false;
+  bool table_driven_methods = false;
+  bool lazy_descriptor_registration = false;
+  bool bulk_assign = false;
+  bool hash_and_equality = false;
+  bool layout_report = false;
 #ifdef PROTOBUF_STABLE_EXPERIMENTS
   bool force_eagerly_verified_lazy = true;
   bool force_inline_string = true;
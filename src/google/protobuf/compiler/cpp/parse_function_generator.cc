@@ -77,7 +77,7 @@ bool UseDirectTcParserTable(const FieldDescriptor* field,
   return !m->options().message_set_wire_format() &&
          m->file()->options().optimize_for() != FileOptions::CODE_SIZE &&
          !HasSimpleBaseClass(m, options) && !HasTracker(m, options) &&
-         !HasWeakFields(m)
+         !HasWeakFields(m) && !HasBitPackedFields(m, options)
       ;  // NOLINT(whitespace/semicolon)
 }
 
@@ -122,6 +122,7 @@ class ParseFunctionGenerator::GeneratedOptionProvider final
             FileOptions::LITE_RUNTIME,
         ShouldSplit(field, gen_->options_),
         /* uses_codegen */ true,
+        GetPresenceProbability(field, gen_->options_),
     };
   }
 
@@ -207,6 +208,10 @@ bool ParseFunctionGenerator::should_generate_tctable() const {
   if (HasSimpleBaseClass(descriptor_, options_) || HasWeakFields(descriptor_)) {
     return false;
   }
+  // The table has no field type for RepeatedBitField.
+  if (HasBitPackedFields(descriptor_, options_)) {
+    return false;
+  }
   return true;
 }
 
@@ -287,6 +292,8 @@ void ParseFunctionGenerator::GenerateLoopingParseFunction(Formatter& format) {
       "$annotate_deserialize$"
       "#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure\n");
   format.Indent();
+  // Only the table-driven parser tracks required fields.
+  format("ctx->SetMaybeUninitialized();\n");
   format.Set("msg", "");
   format.Set("this", "this");
   int hasbits_size = 0;
@@ -462,8 +469,12 @@ void ParseFunctionGenerator::GenerateTailCallTable(Formatter& format) {
       format(
           "&$1$._instance,\n"
           "$2$,  // fallback\n"
+          "$3$,  // required_fields_mask\n"
+          "$4$,  // tracks_required_fields\n"
           "",
-          DefaultInstanceName(descriptor_, options_), fallback);
+          DefaultInstanceName(descriptor_, options_), fallback,
+          tc_table_info_->required_fields_mask,
+          tc_table_info_->tracks_required_fields ? "true" : "false");
     }
     format("}, {{\n");
     {
@@ -581,13 +592,16 @@ void ParseFunctionGenerator::GenerateTailCallTable(Formatter& format) {
                     map_value->type() == FieldDescriptor::TYPE_ENUM &&
                     !internal::cpp::HasPreservingUnknownEnumSemantics(
                         map_value);
+                const bool value_has_required_fields =
+                    map_value->message_type() != nullptr &&
+                    scc_analyzer_->HasRequiredFields(map_value->message_type());
                 format(
                     "{::_pbi::TcParser::GetMapAuxInfo<decltype($classname$("
-                    ").$1$)>($2$, $3$, $4$)},\n",
+                    ").$1$)>($2$, $3$, $4$, $5$)},\n",
                     FieldMemberName(aux_entry.field, /*split=*/false),
                     utf8_check == internal::cpp::Utf8CheckMode::kStrict,
                     utf8_check == internal::cpp::Utf8CheckMode::kVerify,
-                    validated_enum);
+                    validated_enum, value_has_required_fields);
                 break;
               }
               case TailCallTableInfo::kCreateInArena:
@@ -972,7 +986,12 @@ void ParseFunctionGenerator::GenerateStrings(Formatter& format,
 
 void ParseFunctionGenerator::GenerateLengthDelim(Formatter& format,
                                                  const FieldDescriptor* field) {
-  if (field->is_packable()) {
+  if (IsBitPacked(field, options_)) {
+    format(
+        "ptr = ::$proto_ns$::internal::PackedBitFieldParser("
+        "$msg$_internal_mutable_$name$(), ptr, ctx);\n"
+        "CHK_(ptr);\n");
+  } else if (field->is_packable()) {
     if (field->type() == FieldDescriptor::TYPE_ENUM &&
         !internal::cpp::HasPreservingUnknownEnumSemantics(field)) {
       std::string enum_type = QualifiedClassName(field->enum_type(), options_);
@@ -70,6 +70,11 @@ class ParseFunctionGenerator {
   // Emits out-of-class data member definitions to `printer`:
   void GenerateDataDefinitions(io::Printer* printer);
 
+  // The tail-call table of the message, or null if it does not get one.
+  const internal::TailCallTableInfo* tc_table_info() const {
+    return tc_table_info_.get();
+  }
+
  private:
   class GeneratedOptionProvider;
 
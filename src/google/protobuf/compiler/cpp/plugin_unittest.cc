@@ -41,6 +41,7 @@
 #include "google/protobuf/compiler/cpp/generator.h"
 #include "google/protobuf/compiler/command_line_interface.h"
 #include "google/protobuf/testing/googletest.h"
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "absl/log/absl_check.h"
 #include "google/protobuf/io/printer.h"
@@ -230,6 +231,43 @@ TEST(CppPluginTest, PluginTest) {
   EXPECT_EQ(0, cli.Run(5, argv));
 }
 
+TEST(CppPluginTest, LayoutReport) {
+  ABSL_CHECK_OK(
+      File::SetContents(absl::StrCat(TestTempDir(), "/layout.proto"),
+                        "syntax = \"proto2\";\n"
+                        "package foo;\n"
+                        "message Padded {\n"
+                        "  optional bool a = 1;\n"
+                        "  optional int64 b = 2;\n"
+                        "  optional bool c = 3;\n"
+                        "  optional int64 d = 4;\n"
+                        "}\n",
+                        true));
+
+  CommandLineInterface cli;
+  cli.SetInputsAreProtoPathRelative(true);
+  CppGenerator cpp_generator;
+  cli.RegisterGenerator("--cpp_out", &cpp_generator, "");
+
+  std::string proto_path = absl::StrCat("-I", TestTempDir());
+  std::string cpp_out = absl::StrCat("--cpp_out=layout_report:", TestTempDir());
+  const char* argv[] = {"protoc", proto_path.c_str(), cpp_out.c_str(),
+                        "layout.proto"};
+  ASSERT_EQ(0, cli.Run(4, argv));
+
+  std::string report;
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(TestTempDir(), "/layout.pb.layout.jsonl"), &report, true));
+  // Declared order pads after each bool; the optimized order packs them.
+  EXPECT_THAT(report,
+              testing::StartsWith(
+                  "{\"message\": \"foo.Padded\", \"padding_bytes\": 0, "
+                  "\"declaration_order_padding_bytes\": 14, "
+                  "\"has_bit_words\": 1, "));
+  EXPECT_THAT(report,
+              testing::HasSubstr("\"mini_parse_fields\": []}\n"));
+}
+
 }  // namespace
 }  // namespace cpp
 }  // namespace compiler
@@ -120,6 +120,23 @@ TEST(GENERATED_MESSAGE_TEST_NAME, TestConflictingMessageNames) {
   EXPECT_EQ(message.int_(), 123);
 }
 
+TEST(GENERATED_MESSAGE_TEST_NAME, TestConflictingCloneNames) {
+  protobuf_unittest::TestConflictingCloneMessage message;
+  message.mutable_clone();
+  std::unique_ptr<Message> copy(static_cast<const Message&>(message).Clone());
+  EXPECT_TRUE(
+      static_cast<protobuf_unittest::TestConflictingCloneMessage*>(copy.get())
+          ->has_clone());
+
+  protobuf_unittest::TestConflictingCloneEnumValue enum_message;
+  enum_message.set_clone(
+      protobuf_unittest::TestConflictingCloneEnumValue::Clone);
+  copy.reset(static_cast<const Message&>(enum_message).Clone());
+  EXPECT_TRUE(
+      static_cast<protobuf_unittest::TestConflictingCloneEnumValue*>(
+          copy.get())->has_clone());
+}
+
 TEST(GENERATED_MESSAGE_TEST_NAME, TestConflictingExtension) {
   protobuf_unittest::TestConflictingSymbolNames message;
   message.SetExtension(protobuf_unittest::void_, 123);
@@ -45,19 +45,35 @@
 #include <sys/types.h>
 
 #include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
 #include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/compiler/parser.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/io_win32.h"
 #include "google/protobuf/io/tokenizer.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/stubs/common.h"
 
 #ifdef _WIN32
 #include <ctype.h>
@@ -88,6 +104,104 @@ static bool IsWindowsAbsolutePath(absl::string_view text) {
 
 MultiFileErrorCollector::~MultiFileErrorCollector() {}
 
+namespace {
+
+// Starts every parse cache entry, followed by GOOGLE_PROTOBUF_VERSION.
+constexpr absl::string_view kParseCacheMagic = "protoc parse cache\n";
+
+void ReadAll(io::ZeroCopyInputStream* input, std::string* content) {
+  const void* data;
+  int size;
+  while (input->Next(&data, &size)) {
+    content->append(static_cast<const char*>(data), size);
+  }
+}
+
+// Adds to `paths` the path from the root to `message` and each of its
+// submessages, as pairs of field number and index, keyed by address.
+void CollectPaths(
+    const Message& message, std::vector<int>* path,
+    absl::flat_hash_map<const Message*, std::vector<int>>* paths) {
+  (*paths)[&message] = *path;
+  const Reflection* reflection = message.GetReflection();
+  std::vector<const FieldDescriptor*> fields;
+  reflection->ListFields(message, &fields);
+  for (const FieldDescriptor* field : fields) {
+    if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) continue;
+    const int count =
+        field->is_repeated() ? reflection->FieldSize(message, field) : 1;
+    for (int i = 0; i < count; ++i) {
+      path->push_back(field->number());
+      path->push_back(i);
+      CollectPaths(field->is_repeated()
+                       ? reflection->GetRepeatedMessage(message, field, i)
+                       : reflection->GetMessage(message, field),
+                   path, paths);
+      path->resize(path->size() - 2);
+    }
+  }
+}
+
+// Returns the submessage of `root` at `path`, or null if there is none.
+const Message* FindByPath(const Message& root, const std::vector<int>& path) {
+  const Message* message = &root;
+  for (size_t i = 0; i + 1 < path.size(); i += 2) {
+    const Reflection* reflection = message->GetReflection();
+    const FieldDescriptor* field =
+        message->GetDescriptor()->FindFieldByNumber(path[i]);
+    if (field == nullptr ||
+        field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+      return nullptr;
+    }
+    if (field->is_repeated()) {
+      if (path[i + 1] >= reflection->FieldSize(*message, field)) {
+        return nullptr;
+      }
+      message = &reflection->GetRepeatedMessage(*message, field, path[i + 1]);
+    } else {
+      if (!reflection->HasField(*message, field)) return nullptr;
+      message = &reflection->GetMessage(*message, field);
+    }
+  }
+  return message;
+}
+
+void WriteBytes(absl::string_view bytes, io::CodedOutputStream* output) {
+  output->WriteVarint32(static_cast<uint32_t>(bytes.size()));
+  output->WriteRaw(bytes.data(), static_cast<int>(bytes.size()));
+}
+
+bool ReadBytes(io::CodedInputStream* input, std::string* bytes) {
+  uint32_t size;
+  return input->ReadVarint32(&size) &&
+         input->ReadString(bytes, static_cast<int>(size));
+}
+
+// Replaces the file at `path` with `data`, so that concurrent readers see
+// either the old or the new content.
+void ReplaceFile(const std::string& path, absl::string_view data) {
+  const std::string temp_path =
+      absl::StrCat(path, ".", std::random_device()(), ".tmp");
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file.good()) {
+      file.close();
+      std::remove(temp_path.c_str());
+      return;
+    }
+  }
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    // Windows does not replace existing files.
+    std::remove(path.c_str());
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+      std::remove(temp_path.c_str());
+    }
+  }
+}
+
+}  // namespace
+
 // This class serves two purposes:
 // - It implements the ErrorCollector interface (used by Tokenizer and Parser)
 //   in terms of MultiFileErrorCollector, using a particular filename.
@@ -154,6 +268,18 @@ bool SourceTreeDescriptorDatabase::FindFileByName(const std::string& filename,
     return false;
   }
 
+  const bool use_parse_cache = !parse_cache_directory_.empty();
+  std::string content;
+  if (use_parse_cache) {
+    ReadAll(input.get(), &content);
+    if (ReadParseCache(filename, content, output)) {
+      if (!record_source_code_info_) output->clear_source_code_info();
+      return true;
+    }
+    input = std::make_unique<io::ArrayInputStream>(
+        content.data(), static_cast<int>(content.size()));
+  }
+
   // Set up the tokenizer and parser.
   SingleFileErrorCollector file_error_collector(filename, error_collector_);
   io::Tokenizer tokenizer(input.get(), &file_error_collector);
@@ -162,13 +288,159 @@ bool SourceTreeDescriptorDatabase::FindFileByName(const std::string& filename,
   if (error_collector_ != nullptr) {
     parser.RecordErrorsTo(&file_error_collector);
   }
-  if (using_validation_error_collector_) {
+  parser.SetRecordSourceCodeInfo(record_source_code_info_);
+  // With the parse cache, the locations of this file are recorded separately
+  // first, so that they can be written to the cache.
+  SourceLocationTable file_locations;
+  if (use_parse_cache) {
+    parser.RecordSourceLocationsTo(&file_locations);
+  } else if (using_validation_error_collector_) {
     parser.RecordSourceLocationsTo(&source_locations_);
   }
 
   // Parse it.
   output->set_name(filename);
-  return parser.Parse(&tokenizer, output) && !file_error_collector.had_errors();
+  if (!parser.Parse(&tokenizer, output) || file_error_collector.had_errors()) {
+    return false;
+  }
+  if (use_parse_cache) {
+    // Entries always hold the source code info, for the runs that need it.
+    if (record_source_code_info_) {
+      WriteParseCache(filename, content, *output, file_locations);
+    }
+    file_locations.ForEach(
+        [&](const Message* descriptor,
+            DescriptorPool::ErrorCollector::ErrorLocation location,
+            absl::string_view import_name, int line, int column) {
+          if (location == DescriptorPool::ErrorCollector::IMPORT) {
+            source_locations_.AddImport(descriptor, std::string(import_name),
+                                        line, column);
+          } else {
+            source_locations_.Add(descriptor, location, line, column);
+          }
+        });
+  }
+  return true;
+}
+
+std::string SourceTreeDescriptorDatabase::ParseCachePath(
+    const std::string& filename) const {
+  // The entry names the file it is for, so FNV-1a is good enough to spread
+  // the file names over entries.
+  uint64_t hash = 0xcbf29ce484222325;
+  for (char c : filename) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3;
+  }
+  return absl::StrFormat("%s/%016x.protocache", parse_cache_directory_, hash);
+}
+
+bool SourceTreeDescriptorDatabase::ReadParseCache(const std::string& filename,
+                                                  absl::string_view content,
+                                                  FileDescriptorProto* output) {
+  std::ifstream file(ParseCachePath(filename), std::ios::binary);
+  if (!file) return false;
+  std::string entry((std::istreambuf_iterator<char>(file)),
+                    std::istreambuf_iterator<char>());
+
+  io::CodedInputStream input(reinterpret_cast<const uint8_t*>(entry.data()),
+                             static_cast<int>(entry.size()));
+  std::string magic;
+  uint32_t version;
+  std::string cached_content;
+  std::string serialized_file;
+  uint32_t location_count;
+  if (!input.ReadString(&magic, static_cast<int>(kParseCacheMagic.size())) ||
+      magic != kParseCacheMagic || !input.ReadVarint32(&version) ||
+      version != GOOGLE_PROTOBUF_VERSION ||
+      !ReadBytes(&input, &cached_content) || cached_content != content ||
+      !ReadBytes(&input, &serialized_file) ||
+      !output->ParseFromString(serialized_file) ||
+      output->name() != filename || !input.ReadVarint32(&location_count)) {
+    output->Clear();
+    return false;
+  }
+
+  // The cached locations only matter for validation errors, and a damaged
+  // one just loses its line number.
+  std::vector<int> path;
+  std::string import_name;
+  for (uint32_t i = 0; i < location_count; ++i) {
+    uint32_t path_size, location, line, column;
+    if (!input.ReadVarint32(&path_size)) break;
+    path.resize(path_size);
+    bool ok = true;
+    for (int& element : path) {
+      uint32_t value;
+      ok = ok && input.ReadVarint32(&value);
+      element = static_cast<int>(value);
+    }
+    if (!ok || !input.ReadVarint32(&location) || !input.ReadVarint32(&line) ||
+        !input.ReadVarint32(&column) || !ReadBytes(&input, &import_name)) {
+      break;
+    }
+    if (!using_validation_error_collector_) continue;
+    const Message* descriptor = FindByPath(*output, path);
+    if (descriptor == nullptr) continue;
+    const auto error_location =
+        static_cast<DescriptorPool::ErrorCollector::ErrorLocation>(location);
+    if (error_location == DescriptorPool::ErrorCollector::IMPORT) {
+      source_locations_.AddImport(descriptor, import_name,
+                                  static_cast<int>(line),
+                                  static_cast<int>(column));
+    } else {
+      source_locations_.Add(descriptor, error_location, static_cast<int>(line),
+                            static_cast<int>(column));
+    }
+  }
+  return true;
+}
+
+void SourceTreeDescriptorDatabase::WriteParseCache(
+    const std::string& filename, absl::string_view content,
+    const FileDescriptorProto& file,
+    const SourceLocationTable& locations) const {
+  absl::flat_hash_map<const Message*, std::vector<int>> paths;
+  std::vector<int> path;
+  CollectPaths(file, &path, &paths);
+
+  // Locations of messages that the proto does not contain, if any, are left
+  // out.
+  std::string records;
+  uint32_t record_count = 0;
+  {
+    io::StringOutputStream stream(&records);
+    io::CodedOutputStream output(&stream);
+    locations.ForEach(
+        [&](const Message* descriptor,
+            DescriptorPool::ErrorCollector::ErrorLocation location,
+            absl::string_view import_name, int line, int column) {
+          auto it = paths.find(descriptor);
+          if (it == paths.end()) return;
+          output.WriteVarint32(static_cast<uint32_t>(it->second.size()));
+          for (int element : it->second) {
+            output.WriteVarint32(static_cast<uint32_t>(element));
+          }
+          output.WriteVarint32(static_cast<uint32_t>(location));
+          output.WriteVarint32(static_cast<uint32_t>(line));
+          output.WriteVarint32(static_cast<uint32_t>(column));
+          WriteBytes(import_name, &output);
+          ++record_count;
+        });
+  }
+
+  std::string entry;
+  {
+    io::StringOutputStream stream(&entry);
+    io::CodedOutputStream output(&stream);
+    output.WriteRaw(kParseCacheMagic.data(),
+                    static_cast<int>(kParseCacheMagic.size()));
+    output.WriteVarint32(GOOGLE_PROTOBUF_VERSION);
+    WriteBytes(content, &output);
+    WriteBytes(file.SerializeAsString(), &output);
+    output.WriteVarint32(record_count);
+    output.WriteRaw(records.data(), static_cast<int>(records.size()));
+  }
+  ReplaceFile(ParseCachePath(filename), entry);
 }
 
 bool SourceTreeDescriptorDatabase::FindFileContainingSymbol(
@@ -463,10 +735,21 @@ io::ZeroCopyInputStream* DiskSourceTree::OpenVirtualFile(
     return nullptr;
   }
 
+  auto prefetched = prefetched_.find(virtual_file);
+  if (prefetched != prefetched_.end()) {
+    if (disk_file != nullptr) {
+      *disk_file = prefetched->second.disk_file;
+    }
+    const std::string& contents = prefetched->second.contents;
+    return new io::ArrayInputStream(contents.data(),
+                                    static_cast<int>(contents.size()));
+  }
+
   for (const auto& mapping : mappings_) {
     std::string temp_disk_file;
     if (ApplyMapping(virtual_file, mapping.virtual_path, mapping.disk_path,
                      &temp_disk_file)) {
+      if (!MightExist(temp_disk_file)) continue;
       io::ZeroCopyInputStream* stream = OpenDiskFile(temp_disk_file);
       if (stream != nullptr) {
         if (disk_file != nullptr) {
@@ -481,6 +764,7 @@ io::ZeroCopyInputStream* DiskSourceTree::OpenVirtualFile(
             absl::StrCat("Read access is denied for file: ", temp_disk_file);
         return nullptr;
       }
+      if (errno == ENOENT) RecordMissing(temp_disk_file);
     }
   }
   last_error_message_ = "File not found.";
@@ -518,6 +802,203 @@ io::ZeroCopyInputStream* DiskSourceTree::OpenDiskFile(
   }
 }
 
+// Returns false if `path` is known not to be a directory.
+static bool MightBeDirectory(const std::string& path) {
+  struct stat sb;
+  int ret = 0;
+  do {
+    ret = stat(path.c_str(), &sb);
+  } while (ret != 0 && errno == EINTR);
+  if (ret != 0) {
+    return errno != ENOENT && errno != ENOTDIR;
+  }
+#if defined(_WIN32)
+  return (sb.st_mode & S_IFDIR) != 0;
+#else
+  return S_ISDIR(sb.st_mode);
+#endif
+}
+
+bool DiskSourceTree::MightExist(absl::string_view disk_file) {
+  if (!cache_lookups_) return true;
+  const size_t slash = disk_file.find_last_of('/');
+  std::string directory;
+  {
+    absl::MutexLock lock(&cache_mutex_);
+    if (missing_files_.contains(disk_file)) return false;
+    if (slash == absl::string_view::npos || slash == 0) return true;
+    directory = std::string(disk_file.substr(0, slash));
+    auto it = directories_.find(directory);
+    if (it != directories_.end()) return it->second;
+  }
+  // Stat without holding the lock, so that prefetching threads do not wait
+  // on each other's filesystem round trips.
+  const bool exists = MightBeDirectory(directory);
+  absl::MutexLock lock(&cache_mutex_);
+  directories_.try_emplace(std::move(directory), exists);
+  return exists;
+}
+
+void DiskSourceTree::RecordMissing(absl::string_view disk_file) {
+  if (!cache_lookups_) return;
+  absl::MutexLock lock(&cache_mutex_);
+  missing_files_.insert(std::string(disk_file));
+}
+
+bool DiskSourceTree::ReadVirtualFile(absl::string_view virtual_file,
+                                     PrefetchedFile* file) {
+  if (virtual_file != CanonicalizePath(virtual_file) ||
+      ContainsParentReference(virtual_file)) {
+    return false;
+  }
+  for (const auto& mapping : mappings_) {
+    std::string disk_file;
+    if (!ApplyMapping(virtual_file, mapping.virtual_path, mapping.disk_path,
+                      &disk_file) ||
+        !MightExist(disk_file)) {
+      continue;
+    }
+    int file_descriptor;
+    do {
+      file_descriptor = open(disk_file.c_str(), O_RDONLY);
+    } while (file_descriptor < 0 && errno == EINTR);
+    if (file_descriptor < 0) {
+      // Leave errors other than a missing file for Open() to report.
+      if (errno != ENOENT) return false;
+      RecordMissing(disk_file);
+      continue;
+    }
+    io::FileInputStream input(file_descriptor);
+    input.SetCloseOnDelete(true);
+    file->contents.clear();
+    ReadAll(&input, &file->contents);
+    // Directories, for one, open fine but fail to read.
+    if (input.GetErrno() != 0) return false;
+    file->disk_file = std::move(disk_file);
+    return true;
+  }
+  return false;
+}
+
+namespace {
+
+class IgnoringErrorCollector : public io::ErrorCollector {
+ public:
+  void RecordError(int line, io::ColumnNumber column,
+                   absl::string_view message) override {}
+};
+
+// Appends to `imports` the files that top-level import statements in
+// `contents` name. This only needs to be good enough to find what to
+// prefetch; the parser has the final say.
+void ScanImports(const std::string& contents,
+                 std::vector<std::string>* imports) {
+  IgnoringErrorCollector error_collector;
+  io::ArrayInputStream input(contents.data(),
+                             static_cast<int>(contents.size()));
+  io::Tokenizer tokenizer(&input, &error_collector);
+  int depth = 0;
+  bool after_import = false;
+  while (tokenizer.Next()) {
+    const io::Tokenizer::Token& token = tokenizer.current();
+    if (after_import) {
+      if (token.type == io::Tokenizer::TYPE_IDENTIFIER &&
+          (token.text == "public" || token.text == "weak")) {
+        continue;
+      }
+      if (token.type == io::Tokenizer::TYPE_STRING) {
+        imports->emplace_back();
+        io::Tokenizer::ParseStringAppend(token.text, &imports->back());
+      }
+      after_import = false;
+    }
+    if (token.type == io::Tokenizer::TYPE_SYMBOL) {
+      if (token.text == "{") {
+        ++depth;
+      } else if (token.text == "}") {
+        --depth;
+      }
+    } else if (depth == 0 && token.type == io::Tokenizer::TYPE_IDENTIFIER &&
+               token.text == "import") {
+      after_import = true;
+    }
+  }
+}
+
+// Files left to prefetch, shared by the prefetching threads.
+template <typename File>
+struct PrefetchQueue {
+  absl::Mutex mutex;
+  std::vector<std::string> pending ABSL_GUARDED_BY(mutex);
+  absl::flat_hash_set<std::string> seen ABSL_GUARDED_BY(mutex);
+  absl::flat_hash_map<std::string, File> read ABSL_GUARDED_BY(mutex);
+  // Threads reading a file, which may add more to `pending`.
+  int busy ABSL_GUARDED_BY(mutex) = 0;
+
+  bool HasWorkOrDone() const ABSL_SHARED_LOCKS_REQUIRED(mutex) {
+    return !pending.empty() || busy == 0;
+  }
+};
+
+}  // namespace
+
+void DiskSourceTree::Prefetch(const std::vector<std::string>& virtual_files,
+                              int num_threads) {
+  PrefetchQueue<PrefetchedFile> queue;
+  {
+    absl::MutexLock lock(&queue.mutex);
+    for (const std::string& virtual_file : virtual_files) {
+      if (queue.seen.insert(virtual_file).second &&
+          !prefetched_.contains(virtual_file)) {
+        queue.pending.push_back(virtual_file);
+      }
+    }
+  }
+
+  auto work = [&] {
+    std::vector<std::string> imports;
+    queue.mutex.Lock();
+    while (true) {
+      queue.mutex.Await(absl::Condition(
+          &queue, &PrefetchQueue<PrefetchedFile>::HasWorkOrDone));
+      if (queue.pending.empty()) break;
+      std::string virtual_file = std::move(queue.pending.back());
+      queue.pending.pop_back();
+      ++queue.busy;
+      queue.mutex.Unlock();
+
+      PrefetchedFile file;
+      imports.clear();
+      const bool read = ReadVirtualFile(virtual_file, &file);
+      if (read) ScanImports(file.contents, &imports);
+
+      queue.mutex.Lock();
+      --queue.busy;
+      if (!read) continue;
+      for (std::string& import : imports) {
+        if (queue.seen.insert(import).second &&
+            !prefetched_.contains(import)) {
+          queue.pending.push_back(std::move(import));
+        }
+      }
+      queue.read.try_emplace(std::move(virtual_file), std::move(file));
+    }
+    queue.mutex.Unlock();
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (std::thread& thread : threads) thread.join();
+
+  absl::MutexLock lock(&queue.mutex);
+  for (auto& entry : queue.read) {
+    prefetched_.insert(std::move(entry));
+  }
+}
+
 }  // namespace compiler
 }  // namespace protobuf
 }  // namespace google
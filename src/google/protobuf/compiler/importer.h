@@ -41,7 +41,11 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/compiler/parser.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor_database.h"
@@ -106,6 +110,22 @@ class PROTOBUF_EXPORT SourceTreeDescriptorDatabase : public DescriptorDatabase {
     return &validation_error_collector_;
   }
 
+  // Makes FindFileByName() keep the result of parsing each file in
+  // `directory`, so that later runs, e.g. of protoc, neither tokenize nor
+  // parse the files that did not change. A cached result is only used for
+  // the same file name, byte-for-byte identical content and the same
+  // protobuf version. The source locations that the validation error
+  // collector reports are cached with it. `directory` must exist; files that
+  // cannot be written to it are simply not cached.
+  void SetParseCacheDirectory(absl::string_view directory) {
+    parse_cache_directory_ = std::string(directory);
+  }
+
+  // Call SetRecordSourceCodeInfo(false) to leave source_code_info out of the
+  // files that FindFileByName() returns, which makes parsing faster.  The
+  // validation error collector still reports exact line and column numbers.
+  void SetRecordSourceCodeInfo(bool value) { record_source_code_info_ = value; }
+
   // implements DescriptorDatabase -----------------------------------
   bool FindFileByName(const std::string& filename,
                       FileDescriptorProto* output) override;
@@ -143,9 +163,19 @@ class PROTOBUF_EXPORT SourceTreeDescriptorDatabase : public DescriptorDatabase {
   };
   friend class ValidationErrorCollector;
 
+  // Implements SetParseCacheDirectory().
+  std::string ParseCachePath(const std::string& filename) const;
+  bool ReadParseCache(const std::string& filename, absl::string_view content,
+                      FileDescriptorProto* output);
+  void WriteParseCache(const std::string& filename, absl::string_view content,
+                       const FileDescriptorProto& file,
+                       const SourceLocationTable& locations) const;
+
   bool using_validation_error_collector_;
   SourceLocationTable source_locations_;
   ValidationErrorCollector validation_error_collector_;
+  std::string parse_cache_directory_;
+  bool record_source_code_info_ = true;
 };
 
 // Simple interface for parsing .proto files.  This wraps the process
@@ -321,12 +351,33 @@ class PROTOBUF_EXPORT DiskSourceTree : public SourceTree {
   bool VirtualFileToDiskFile(absl::string_view virtual_file,
                              std::string* disk_file);
 
+  // Remember which files and directories were found missing, so that
+  // looking files up under many mappings stats each missing directory once
+  // instead of trying to open every candidate path in it. Only enable this
+  // while the mapped directories do not change.
+  void EnableLookupCache(bool enable) { cache_lookups_ = enable; }
+
+  // Reads `virtual_files` and everything they import, directly or
+  // indirectly, on up to `num_threads` threads, and keeps their contents so
+  // that Open() serves them from memory. This overlaps the latency of slow
+  // (e.g. network) filesystems instead of paying it once per file as the
+  // parser reaches each import. Imports are found by scanning for import
+  // statements, not by parsing, and files that cannot be read are left for
+  // Open() to report. Must not be called concurrently with other methods.
+  void Prefetch(const std::vector<std::string>& virtual_files,
+                int num_threads);
+
   // implements SourceTree -------------------------------------------
   io::ZeroCopyInputStream* Open(absl::string_view filename) override;
 
   std::string GetLastErrorMessage() override;
 
  private:
+  struct PrefetchedFile {
+    std::string disk_file;
+    std::string contents;
+  };
+
   struct Mapping {
     std::string virtual_path;
     std::string disk_path;
@@ -345,6 +396,26 @@ class PROTOBUF_EXPORT DiskSourceTree : public SourceTree {
 
   // Like Open() but given the actual on-disk path.
   io::ZeroCopyInputStream* OpenDiskFile(absl::string_view filename);
+
+  // With the lookup cache enabled, returns false if `disk_file` or its
+  // directory is known not to exist. Returns true otherwise.
+  bool MightExist(absl::string_view disk_file);
+  // Remembers that `disk_file` does not exist, if the cache is enabled.
+  void RecordMissing(absl::string_view disk_file);
+
+  // Reads the first file `virtual_file` maps to into `file`, the way
+  // OpenVirtualFile() would find it. Safe to call from several threads.
+  bool ReadVirtualFile(absl::string_view virtual_file, PrefetchedFile* file);
+
+  bool cache_lookups_ = false;
+  absl::Mutex cache_mutex_;
+  // Directories by path, mapped to whether they exist.
+  absl::flat_hash_map<std::string, bool> directories_
+      ABSL_GUARDED_BY(cache_mutex_);
+  // Files found not to exist.
+  absl::flat_hash_set<std::string> missing_files_ ABSL_GUARDED_BY(cache_mutex_);
+  // Files read by Prefetch(), by virtual path.
+  absl::flat_hash_map<std::string, PrefetchedFile> prefetched_;
 };
 
 }  // namespace compiler
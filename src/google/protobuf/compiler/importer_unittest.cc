@@ -254,6 +254,53 @@ TEST_F(ImporterTest, LiteRuntimeImport) {
       error_collector_.text_);
 }
 
+TEST(SourceTreeDescriptorDatabaseTest, ParseCache) {
+  const std::string cache_dir = absl::StrCat(TestTempDir(), "/parse_cache");
+  if (FileExists(cache_dir)) {
+    File::DeleteRecursively(cache_dir, NULL, NULL);
+  }
+  ABSL_CHECK_OK(File::CreateDir(cache_dir, 0777));
+
+  MockSourceTree source_tree;
+  source_tree.AddFile("foo.proto",
+                      "syntax = \"proto2\";\n"
+                      "message Foo {\n"
+                      "  optional Bar bar = 1;\n"
+                      "}\n");
+
+  FileDescriptorProto parsed;
+  {
+    SourceTreeDescriptorDatabase database(&source_tree);
+    database.SetParseCacheDirectory(cache_dir);
+    ASSERT_TRUE(database.FindFileByName("foo.proto", &parsed));
+  }
+
+  // A second database reads the file from the cache, along with the source
+  // locations needed to report validation errors.
+  MockErrorCollector error_collector;
+  SourceTreeDescriptorDatabase database(&source_tree);
+  database.SetParseCacheDirectory(cache_dir);
+  database.RecordErrorsTo(&error_collector);
+  FileDescriptorProto cached;
+  ASSERT_TRUE(database.FindFileByName("foo.proto", &cached));
+  EXPECT_EQ(cached.SerializeAsString(), parsed.SerializeAsString());
+
+  DescriptorPool pool(&database, database.GetValidationErrorCollector());
+  EXPECT_TRUE(pool.FindFileByName("foo.proto") == nullptr);
+  EXPECT_EQ("foo.proto:2:11: \"Bar\" is not defined.\n",
+            error_collector.text_);
+
+  // A changed file is parsed again.
+  source_tree.AddFile("foo.proto",
+                      "syntax = \"proto2\";\n"
+                      "message Baz {}\n");
+  FileDescriptorProto changed;
+  ASSERT_TRUE(database.FindFileByName("foo.proto", &changed));
+  ASSERT_EQ(1, changed.message_type_size());
+  EXPECT_EQ("Baz", changed.message_type(0).name());
+
+  File::DeleteRecursively(cache_dir, NULL, NULL);
+}
 
 // ===================================================================
 
@@ -543,6 +590,55 @@ TEST_F(DiskSourceTreeTest, VirtualFileToDiskFile) {
   EXPECT_FALSE(source_tree_.VirtualFileToDiskFile("baz/foo", nullptr));
 }
 
+TEST_F(DiskSourceTreeTest, LookupCache) {
+  // Test that the lookup cache skips files and directories found missing.
+
+  AddFile(absl::StrCat(dirnames_[1], "/foo"), "Hello World!");
+  source_tree_.EnableLookupCache(true);
+  source_tree_.MapPath("", absl::StrCat(dirnames_[0], "/missing"));
+  source_tree_.MapPath("", dirnames_[0]);
+  source_tree_.MapPath("", dirnames_[1]);
+
+  ExpectFileContents("foo", "Hello World!");
+  ExpectCannotOpenFile("bar", "File not found.");
+
+  // Files and directories added later are not seen.
+  AddSubdir(absl::StrCat(dirnames_[0], "/missing"));
+  AddFile(absl::StrCat(dirnames_[0], "/missing/foo"), "Hidden!");
+  AddFile(absl::StrCat(dirnames_[0], "/bar"), "Goodbye World!");
+  ExpectFileContents("foo", "Hello World!");
+  ExpectCannotOpenFile("bar", "File not found.");
+}
+
+TEST_F(DiskSourceTreeTest, Prefetch) {
+  // Test that Prefetch() reads files and their imports up front.
+
+  AddFile(absl::StrCat(dirnames_[0], "/foo.proto"),
+          "syntax = \"proto2\";\n"
+          "import \"bar.proto\";\n"
+          "import public \"baz.proto\";\n"
+          "message Foo { optional string import = 1; }\n");
+  AddFile(absl::StrCat(dirnames_[1], "/bar.proto"),
+          "import weak \"qux.proto\";");
+  AddFile(absl::StrCat(dirnames_[1], "/baz.proto"), "");
+  AddFile(absl::StrCat(dirnames_[1], "/qux.proto"), "// qux");
+  AddFile(absl::StrCat(dirnames_[1], "/unused.proto"), "// unused");
+  source_tree_.MapPath("", dirnames_[0]);
+  source_tree_.MapPath("", dirnames_[1]);
+
+  source_tree_.Prefetch({"foo.proto", "missing.proto"}, 4);
+  File::DeleteRecursively(dirnames_[0], NULL, NULL);
+  File::DeleteRecursively(dirnames_[1], NULL, NULL);
+
+  ExpectFileContents("baz.proto", "");
+  ExpectFileContents("qux.proto", "// qux");
+  std::string disk_file;
+  EXPECT_TRUE(source_tree_.VirtualFileToDiskFile("bar.proto", &disk_file));
+  EXPECT_EQ(absl::StrCat(dirnames_[1], "/bar.proto"), disk_file);
+  ExpectCannotOpenFile("unused.proto", "File not found.");
+  ExpectCannotOpenFile("missing.proto", "File not found.");
+}
+
 }  // namespace
 
 }  // namespace compiler
@@ -34,12 +34,18 @@
 
 #include "google/protobuf/compiler/java/file.h"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "absl/container/btree_set.h"
 #include "absl/log/absl_log.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/compiler/code_generator.h"
 #include "google/protobuf/compiler/java/context.h"
 #include "google/protobuf/compiler/java/enum.h"
@@ -54,8 +60,10 @@
 #include "google/protobuf/compiler/retention.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/printer.h"
 #include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 
 // Must be last.
 #include "google/protobuf/port_def.inc"
@@ -599,91 +607,125 @@ void FileGenerator::GenerateDescriptorInitializationCodeForMutable(
   printer->Print("}\n");
 }
 
-template <typename GeneratorClass, typename DescriptorClass>
-static void GenerateSibling(
-    const std::string& package_dir, const std::string& java_package,
-    const DescriptorClass* descriptor, GeneratorContext* context,
-    std::vector<std::string>* file_list, bool annotate_code,
-    std::vector<std::string>* annotation_list, const std::string& name_suffix,
-    GeneratorClass* generator,
-    void (GeneratorClass::*pfn)(io::Printer* printer)) {
-  std::string filename =
-      absl::StrCat(package_dir, descriptor->name(), name_suffix, ".java");
-  file_list->push_back(filename);
-  std::string info_full_path = absl::StrCat(filename, ".pb.meta");
+namespace {
+
+// A class written to a file of its own. Siblings are rendered into memory so
+// that they can be rendered concurrently and still be opened in a fixed order.
+struct SiblingFile {
+  std::string filename;
+  std::function<void(io::Printer*)> generate;
+  std::string content;
+  std::string annotations;
+};
+
+void RenderSibling(const std::string& java_package, const FileDescriptor* file,
+                   bool annotate_code, SiblingFile* sibling) {
   GeneratedCodeInfo annotations;
   io::AnnotationProtoCollector<GeneratedCodeInfo> annotation_collector(
       &annotations);
+  {
+    io::StringOutputStream output(&sibling->content);
+    io::Printer printer(&output, '$',
+                        annotate_code ? &annotation_collector : NULL);
 
-  std::unique_ptr<io::ZeroCopyOutputStream> output(context->Open(filename));
-  io::Printer printer(output.get(), '$',
-                      annotate_code ? &annotation_collector : NULL);
-
-  printer.Print(
-      "// Generated by the protocol buffer compiler.  DO NOT EDIT!\n"
-      "// source: $filename$\n"
-      "\n",
-      "filename", descriptor->file()->name());
-  if (!java_package.empty()) {
     printer.Print(
-        "package $package$;\n"
+        "// Generated by the protocol buffer compiler.  DO NOT EDIT!\n"
+        "// source: $filename$\n"
         "\n",
-        "package", java_package);
-  }
-
-  (generator->*pfn)(&printer);
+        "filename", file->name());
+    if (!java_package.empty()) {
+      printer.Print(
+          "package $package$;\n"
+          "\n",
+          "package", java_package);
+    }
 
+    sibling->generate(&printer);
+  }
   if (annotate_code) {
-    std::unique_ptr<io::ZeroCopyOutputStream> info_output(
-        context->Open(info_full_path));
-    annotations.SerializeToZeroCopyStream(info_output.get());
-    annotation_list->push_back(info_full_path);
+    annotations.SerializeToString(&sibling->annotations);
   }
 }
 
+}  // namespace
+
 void FileGenerator::GenerateSiblings(
     const std::string& package_dir, GeneratorContext* context,
     std::vector<std::string>* file_list,
     std::vector<std::string>* annotation_list) {
-  if (MultipleJavaFiles(file_, immutable_api_)) {
-    for (int i = 0; i < file_->enum_type_count(); i++) {
-      if (HasDescriptorMethods(file_, context_->EnforceLite())) {
-        EnumGenerator generator(file_->enum_type(i), immutable_api_,
-                                context_.get());
-        GenerateSibling<EnumGenerator>(
-            package_dir, java_package_, file_->enum_type(i), context, file_list,
-            options_.annotate_code, annotation_list, "", &generator,
-            &EnumGenerator::Generate);
-      } else {
-        EnumLiteGenerator generator(file_->enum_type(i), immutable_api_,
-                                    context_.get());
-        GenerateSibling<EnumLiteGenerator>(
-            package_dir, java_package_, file_->enum_type(i), context, file_list,
-            options_.annotate_code, annotation_list, "", &generator,
-            &EnumLiteGenerator::Generate);
-      }
+  if (!MultipleJavaFiles(file_, immutable_api_)) return;
+
+  std::vector<SiblingFile> siblings;
+  auto add_sibling = [&](absl::string_view name, absl::string_view suffix,
+                         std::function<void(io::Printer*)> generate) {
+    siblings.push_back({absl::StrCat(package_dir, name, suffix, ".java"),
+                        std::move(generate)});
+  };
+  for (int i = 0; i < file_->enum_type_count(); i++) {
+    const EnumDescriptor* descriptor = file_->enum_type(i);
+    if (HasDescriptorMethods(file_, context_->EnforceLite())) {
+      add_sibling(descriptor->name(), "", [this, descriptor](io::Printer* p) {
+        EnumGenerator(descriptor, immutable_api_, context_.get()).Generate(p);
+      });
+    } else {
+      add_sibling(descriptor->name(), "", [this, descriptor](io::Printer* p) {
+        EnumLiteGenerator(descriptor, immutable_api_, context_.get())
+            .Generate(p);
+      });
     }
-    for (int i = 0; i < file_->message_type_count(); i++) {
-      if (immutable_api_) {
-        GenerateSibling<MessageGenerator>(
-            package_dir, java_package_, file_->message_type(i), context,
-            file_list, options_.annotate_code, annotation_list, "OrBuilder",
-            message_generators_[i].get(), &MessageGenerator::GenerateInterface);
-      }
-      GenerateSibling<MessageGenerator>(
-          package_dir, java_package_, file_->message_type(i), context,
-          file_list, options_.annotate_code, annotation_list, "",
-          message_generators_[i].get(), &MessageGenerator::Generate);
+  }
+  for (int i = 0; i < file_->message_type_count(); i++) {
+    MessageGenerator* generator = message_generators_[i].get();
+    if (immutable_api_) {
+      add_sibling(file_->message_type(i)->name(), "OrBuilder",
+                  [generator](io::Printer* p) {
+                    generator->GenerateInterface(p);
+                  });
     }
-    if (HasGenericServices(file_, context_->EnforceLite())) {
-      for (int i = 0; i < file_->service_count(); i++) {
-        std::unique_ptr<ServiceGenerator> generator(
-            generator_factory_->NewServiceGenerator(file_->service(i)));
-        GenerateSibling<ServiceGenerator>(
-            package_dir, java_package_, file_->service(i), context, file_list,
-            options_.annotate_code, annotation_list, "", generator.get(),
-            &ServiceGenerator::Generate);
-      }
+    add_sibling(file_->message_type(i)->name(), "",
+                [generator](io::Printer* p) { generator->Generate(p); });
+  }
+  std::vector<std::unique_ptr<ServiceGenerator>> service_generators;
+  if (HasGenericServices(file_, context_->EnforceLite())) {
+    for (int i = 0; i < file_->service_count(); i++) {
+      service_generators.emplace_back(
+          generator_factory_->NewServiceGenerator(file_->service(i)));
+      ServiceGenerator* generator = service_generators.back().get();
+      add_sibling(file_->service(i)->name(), "",
+                  [generator](io::Printer* p) { generator->Generate(p); });
+    }
+  }
+
+  // The classes only read the shared Context, so with --jobs they are
+  // rendered on several threads.
+  std::atomic<size_t> next{0};
+  auto render = [&] {
+    for (size_t i; (i = next.fetch_add(1)) < siblings.size();) {
+      RenderSibling(java_package_, file_, options_.annotate_code,
+                    &siblings[i]);
+    }
+  };
+  const int threads = static_cast<int>(
+      std::min<size_t>(context->GetMaxJobs(), siblings.size()));
+  std::vector<std::thread> workers;
+  for (int i = 1; i < threads; i++) workers.emplace_back(render);
+  render();
+  for (std::thread& worker : workers) worker.join();
+
+  for (const SiblingFile& sibling : siblings) {
+    file_list->push_back(sibling.filename);
+    {
+      std::unique_ptr<io::ZeroCopyOutputStream> output(
+          context->Open(sibling.filename));
+      io::CodedOutputStream(output.get()).WriteString(sibling.content);
+    }
+    if (options_.annotate_code) {
+      std::string info_full_path = absl::StrCat(sibling.filename, ".pb.meta");
+      std::unique_ptr<io::ZeroCopyOutputStream> info_output(
+          context->Open(info_full_path));
+      io::CodedOutputStream(info_output.get())
+          .WriteString(sibling.annotations);
+      annotation_list->push_back(info_full_path);
     }
   }
 }
@@ -159,19 +159,24 @@ std::string ClassNameResolver::GetFileDefaultImmutableClassName(
 
 std::string ClassNameResolver::GetFileImmutableClassName(
     const FileDescriptor* file) {
-  std::string& class_name = file_immutable_outer_class_names_[file];
-  if (class_name.empty()) {
-    if (file->options().has_java_outer_classname()) {
-      class_name = file->options().java_outer_classname();
-    } else {
-      class_name = GetFileDefaultImmutableClassName(file);
-      if (HasConflictingClassName(file, class_name,
-                                  NameEquality::EXACT_EQUAL)) {
-        class_name += kOuterClassNameSuffix;
-      }
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = file_immutable_outer_class_names_.find(file);
+    if (it != file_immutable_outer_class_names_.end()) return it->second;
+  }
+  std::string class_name;
+  if (file->options().has_java_outer_classname()) {
+    class_name = file->options().java_outer_classname();
+  } else {
+    class_name = GetFileDefaultImmutableClassName(file);
+    if (HasConflictingClassName(file, class_name,
+                                NameEquality::EXACT_EQUAL)) {
+      class_name += kOuterClassNameSuffix;
     }
   }
-  return class_name;
+  absl::MutexLock lock(&mutex_);
+  return file_immutable_outer_class_names_.try_emplace(file, class_name)
+      .first->second;
 }
 
 std::string ClassNameResolver::GetFileClassName(const FileDescriptor* file,
@@ -33,7 +33,9 @@
 
 #include <string>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/compiler/java/options.h"
 #include "google/protobuf/port.h"
 
@@ -148,9 +150,11 @@ class ClassNameResolver {
   std::string GetJavaClassFullName(absl::string_view name_without_package,
                                    const FileDescriptor* file, bool immutable,
                                    bool kotlin);
-  // Caches the result to provide better performance.
+  // Caches the result to provide better performance. Guarded because the
+  // file generator may render sibling classes on several threads.
+  absl::Mutex mutex_;
   absl::flat_hash_map<const FileDescriptor*, std::string>
-      file_immutable_outer_class_names_;
+      file_immutable_outer_class_names_ ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace java
@@ -32,6 +32,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "google/protobuf/testing/file.h"
 #include "google/protobuf/testing/file.h"
@@ -131,6 +132,53 @@ TEST(JavaPluginTest, PluginTest) {
   (void)found_generated_annotation;
 }
 
+// With --jobs the sibling classes of a java_multiple_files proto are rendered
+// on several threads; the output must not change.
+TEST(JavaPluginTest, MultipleFilesWithJobs) {
+  ABSL_CHECK_OK(
+      File::SetContents(absl::StrCat(TestTempDir(), "/multi.proto"),
+                        "syntax = \"proto2\";\n"
+                        "package foo;\n"
+                        "option java_package = \"\";\n"
+                        "option java_multiple_files = true;\n"
+                        "option java_generic_services = true;\n"
+                        "message Bar { optional Qux qux = 1; }\n"
+                        "message Baz { repeated Bar bar = 1; }\n"
+                        "enum Qux { BLAH = 1; }\n"
+                        "service Svc { rpc Call(Bar) returns (Baz); }\n",
+                        true));
+
+  const std::vector<std::string> files = {
+      "Bar.java", "BarOrBuilder.java", "Baz.java", "BazOrBuilder.java",
+      "Qux.java", "Svc.java",          "Multi.java"};
+  std::vector<std::string> outputs[2];
+  for (int run = 0; run < 2; run++) {
+    std::string out_dir =
+        absl::StrCat(TestTempDir(), run == 0 ? "/serial" : "/parallel");
+    ABSL_CHECK_OK(File::RecursivelyCreateDir(out_dir, 0777));
+
+    CommandLineInterface cli;
+    cli.SetInputsAreProtoPathRelative(true);
+    JavaGenerator java_generator;
+    cli.RegisterGenerator("--java_out", &java_generator, "");
+
+    std::string proto_path = absl::StrCat("-I", TestTempDir());
+    std::string java_out = absl::StrCat("--java_out=", out_dir);
+    std::string jobs = run == 0 ? "--jobs=1" : "--jobs=4";
+    const char* argv[] = {"protoc", proto_path.c_str(), java_out.c_str(),
+                          jobs.c_str(), "multi.proto"};
+    ASSERT_EQ(0, cli.Run(5, argv));
+
+    for (const std::string& file : files) {
+      std::string content;
+      ABSL_CHECK_OK(File::GetContents(absl::StrCat(out_dir, "/", file),
+                                      &content, true));
+      outputs[run].push_back(content);
+    }
+  }
+  EXPECT_EQ(outputs[0], outputs[1]);
+}
+
 }  // namespace
 }  // namespace java
 }  // namespace compiler
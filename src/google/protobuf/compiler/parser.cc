@@ -197,7 +197,8 @@ Parser::Parser()
       source_location_table_(nullptr),
       had_errors_(false),
       require_syntax_identifier_(false),
-      stop_after_syntax_identifier_(false) {
+      stop_after_syntax_identifier_(false),
+      record_source_code_info_(true) {
 }
 
 Parser::~Parser() {}
@@ -427,9 +428,13 @@ void Parser::RecordWarning(absl::string_view warning) {
 Parser::LocationRecorder::LocationRecorder(Parser* parser)
     : parser_(parser),
       source_code_info_(parser->source_code_info_),
-      location_(parser_->source_code_info_->add_location()) {
-  location_->add_span(parser_->input_->current().line);
-  location_->add_span(parser_->input_->current().column);
+      location_(nullptr),
+      start_(parser_->input_->current()) {
+  if (source_code_info_ != nullptr) {
+    location_ = source_code_info_->add_location();
+    location_->add_span(start_.line);
+    location_->add_span(start_.column);
+  }
 }
 
 Parser::LocationRecorder::LocationRecorder(const LocationRecorder& parent) {
@@ -460,35 +465,55 @@ void Parser::LocationRecorder::Init(const LocationRecorder& parent,
                                     SourceCodeInfo* source_code_info) {
   parser_ = parent.parser_;
   source_code_info_ = source_code_info;
+  location_ = nullptr;
+  start_ = TokenPosition(parser_->input_->current());
+  if (source_code_info_ == nullptr) return;
 
   location_ = source_code_info_->add_location();
-  location_->mutable_path()->CopyFrom(parent.location_->path());
+  if (parent.location_ != nullptr) {
+    location_->mutable_path()->CopyFrom(parent.location_->path());
+  }
 
-  location_->add_span(parser_->input_->current().line);
-  location_->add_span(parser_->input_->current().column);
+  location_->add_span(start_.line);
+  location_->add_span(start_.column);
 }
 
 Parser::LocationRecorder::~LocationRecorder() {
-  if (location_->span_size() <= 2) {
+  if (location_ != nullptr && location_->span_size() <= 2) {
     EndAt(parser_->input_->previous());
   }
 }
 
 void Parser::LocationRecorder::AddPath(int path_component) {
-  location_->add_path(path_component);
+  if (location_ != nullptr) location_->add_path(path_component);
 }
 
 void Parser::LocationRecorder::StartAt(const io::Tokenizer::Token& token) {
+  StartAt(TokenPosition(token));
+}
+
+void Parser::LocationRecorder::StartAt(const TokenPosition& token) {
+  start_.line = token.line;
+  start_.column = token.column;
+  if (location_ == nullptr) return;
   location_->set_span(0, token.line);
   location_->set_span(1, token.column);
 }
 
 void Parser::LocationRecorder::StartAt(const LocationRecorder& other) {
-  location_->set_span(0, other.location_->span(0));
-  location_->set_span(1, other.location_->span(1));
+  start_.line = other.start_.line;
+  start_.column = other.start_.column;
+  if (location_ == nullptr) return;
+  location_->set_span(0, start_.line);
+  location_->set_span(1, start_.column);
 }
 
 void Parser::LocationRecorder::EndAt(const io::Tokenizer::Token& token) {
+  EndAt(TokenPosition(token));
+}
+
+void Parser::LocationRecorder::EndAt(const TokenPosition& token) {
+  if (location_ == nullptr) return;
   if (token.line != location_->span(0)) {
     location_->add_span(token.line);
   }
@@ -499,26 +524,32 @@ void Parser::LocationRecorder::RecordLegacyLocation(
     const Message* descriptor,
     DescriptorPool::ErrorCollector::ErrorLocation location) {
   if (parser_->source_location_table_ != nullptr) {
-    parser_->source_location_table_->Add(
-        descriptor, location, location_->span(0), location_->span(1));
+    parser_->source_location_table_->Add(descriptor, location, start_.line,
+                                         start_.column);
   }
 }
 
 void Parser::LocationRecorder::RecordLegacyImportLocation(
     const Message* descriptor, const std::string& name) {
   if (parser_->source_location_table_ != nullptr) {
-    parser_->source_location_table_->AddImport(
-        descriptor, name, location_->span(0), location_->span(1));
+    parser_->source_location_table_->AddImport(descriptor, name, start_.line,
+                                               start_.column);
   }
 }
 
 int Parser::LocationRecorder::CurrentPathSize() const {
-  return location_->path_size();
+  return location_ != nullptr ? location_->path_size() : 0;
 }
 
 void Parser::LocationRecorder::AttachComments(
     std::string* leading, std::string* trailing,
     std::vector<std::string>* detached_comments) const {
+  if (location_ == nullptr) {
+    leading->clear();
+    trailing->clear();
+    detached_comments->clear();
+    return;
+  }
   ABSL_CHECK(!location_->has_leading_comments());
   ABSL_CHECK(!location_->has_trailing_comments());
 
@@ -643,12 +674,19 @@ bool Parser::Parse(io::Tokenizer* input, FileDescriptorProto* file) {
   had_errors_ = false;
   syntax_identifier_.clear();
 
-  // Note that |file| could be NULL at this point if
-  // stop_after_syntax_identifier_ is true.  So, we conservatively allocate
-  // SourceCodeInfo on the stack, then swap it into the FileDescriptorProto
-  // later on.
-  SourceCodeInfo source_code_info;
-  source_code_info_ = &source_code_info;
+  // Locations are built in place, so that they are allocated on the arena of
+  // |file|, if any.  Note that |file| could be NULL at this point if
+  // stop_after_syntax_identifier_ is true, in which case the locations are
+  // only needed until we return.
+  SourceCodeInfo scratch_source_code_info;
+  if (!record_source_code_info_) {
+    source_code_info_ = nullptr;
+  } else if (file != nullptr && !stop_after_syntax_identifier_) {
+    source_code_info_ = file->mutable_source_code_info();
+    source_code_info_->Clear();
+  } else {
+    source_code_info_ = &scratch_source_code_info;
+  }
 
   if (LookingAtType(io::Tokenizer::TYPE_START)) {
     // Advance to first token.
@@ -702,7 +740,6 @@ bool Parser::Parse(io::Tokenizer* input, FileDescriptorProto* file) {
   input_ = nullptr;
   source_code_info_ = nullptr;
   assert(file != nullptr);
-  source_code_info.Swap(file->mutable_source_code_info());
   return !had_errors_;
 }
 
@@ -714,7 +751,7 @@ bool Parser::ParseSyntaxIdentifier(const LocationRecorder& parent) {
                "\"proto2\";'."));
 
   DO(Consume("="));
-  io::Tokenizer::Token syntax_token = input_->current();
+  TokenPosition syntax_token(input_->current());
   std::string syntax;
   DO(ConsumeString(&syntax, "Expected syntax identifier."));
   DO(ConsumeEndOfDeclaration(";", &syntax_location));
@@ -1042,7 +1079,7 @@ bool Parser::ParseMessageFieldNoLabel(
   }
 
   // Parse name and '='.
-  io::Tokenizer::Token name_token = input_->current();
+  TokenPosition name_token(input_->current());
   {
     LocationRecorder location(field_location,
                               FieldDescriptorProto::kNameFieldNumber);
@@ -1654,12 +1691,12 @@ bool Parser::ParseExtensions(DescriptorProto* message,
                                   DescriptorPool::ErrorCollector::NUMBER);
 
     int start, end;
-    io::Tokenizer::Token start_token;
+    TokenPosition start_token;
 
     {
       LocationRecorder start_location(
           location, DescriptorProto::ExtensionRange::kStartFieldNumber);
-      start_token = input_->current();
+      start_token = TokenPosition(input_->current());
       DO(ConsumeInteger(&start, "Expected field number range."));
     }
 
@@ -1693,6 +1730,8 @@ bool Parser::ParseExtensions(DescriptorProto* message,
   if (LookingAt("[")) {
     int range_number_index = extensions_location.CurrentPathSize();
     SourceCodeInfo info;
+    SourceCodeInfo* range_source_code_info =
+        source_code_info_ != nullptr ? &info : nullptr;
 
     // Parse extension range options in the first range.
     ExtensionRangeOptions* options =
@@ -1701,7 +1740,7 @@ bool Parser::ParseExtensions(DescriptorProto* message,
     {
       LocationRecorder index_location(
           extensions_location, 0 /* we fill this in w/ actual index below */,
-          &info);
+          range_source_code_info);
       LocationRecorder location(
           index_location, DescriptorProto::ExtensionRange::kOptionsFieldNumber);
       DO(Consume("["));
@@ -1742,7 +1781,7 @@ bool Parser::ParseExtensions(DescriptorProto* message,
 // name literals.
 bool Parser::ParseReserved(DescriptorProto* message,
                            const LocationRecorder& message_location) {
-  io::Tokenizer::Token start_token = input_->current();
+  TokenPosition start_token(input_->current());
   // Parse the declaration.
   DO(Consume("reserved"));
   if (LookingAtType(io::Tokenizer::TYPE_STRING)) {
@@ -1792,11 +1831,11 @@ bool Parser::ParseReservedNumbers(DescriptorProto* message,
 
     DescriptorProto::ReservedRange* range = message->add_reserved_range();
     int start, end;
-    io::Tokenizer::Token start_token;
+    TokenPosition start_token;
     {
       LocationRecorder start_location(
           location, DescriptorProto::ReservedRange::kStartFieldNumber);
-      start_token = input_->current();
+      start_token = TokenPosition(input_->current());
       DO(ConsumeInteger(&start, (first ? "Expected field name or number range."
                                        : "Expected field number range.")));
     }
@@ -1835,7 +1874,7 @@ bool Parser::ParseReservedNumbers(DescriptorProto* message,
 
 bool Parser::ParseReserved(EnumDescriptorProto* proto,
                            const LocationRecorder& enum_location) {
-  io::Tokenizer::Token start_token = input_->current();
+  TokenPosition start_token(input_->current());
   // Parse the declaration.
   DO(Consume("reserved"));
   if (LookingAtType(io::Tokenizer::TYPE_STRING)) {
@@ -1869,11 +1908,11 @@ bool Parser::ParseReservedNumbers(EnumDescriptorProto* proto,
 
     EnumDescriptorProto::EnumReservedRange* range = proto->add_reserved_range();
     int start, end;
-    io::Tokenizer::Token start_token;
+    TokenPosition start_token;
     {
       LocationRecorder start_location(
           location, EnumDescriptorProto::EnumReservedRange::kStartFieldNumber);
-      start_token = input_->current();
+      start_token = TokenPosition(input_->current());
       DO(ConsumeSignedInteger(&start,
                               (first ? "Expected enum value or number range."
                                      : "Expected enum number range.")));
@@ -1915,7 +1954,7 @@ bool Parser::ParseExtend(RepeatedPtrField<FieldDescriptorProto>* extensions,
   DO(Consume("extend"));
 
   // Parse the extendee type.
-  io::Tokenizer::Token extendee_start = input_->current();
+  TokenPosition extendee_start(input_->current());
   std::string extendee;
   DO(ParseUserDefinedType(&extendee));
   io::Tokenizer::Token extendee_end = input_->previous();
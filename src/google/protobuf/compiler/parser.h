@@ -77,7 +77,9 @@ class PROTOBUF_EXPORT Parser {
   ~Parser();
 
   // Parse the entire input and construct a FileDescriptorProto representing
-  // it.  Returns true if no errors occurred, false otherwise.
+  // it.  Returns true if no errors occurred, false otherwise.  If |file| is
+  // allocated on an arena, everything the parser adds to it, including the
+  // SourceCodeInfo, is allocated on that arena.
   bool Parse(io::Tokenizer* input, FileDescriptorProto* file);
 
   // Optional features:
@@ -123,10 +125,32 @@ class PROTOBUF_EXPORT Parser {
     stop_after_syntax_identifier_ = value;
   }
 
+  // Call SetRecordSourceCodeInfo(false) to leave source_code_info out of the
+  // FileDescriptorProto.  Building a location, with its path, span and
+  // comments, for every declaration is a large part of the cost of parsing,
+  // so callers that never look at the locations should turn it off.  Errors
+  // and the SourceLocationTable given to RecordSourceLocationsTo() are not
+  // affected.
+  void SetRecordSourceCodeInfo(bool value) { record_source_code_info_ = value; }
+
  private:
   class LocationRecorder;
   struct MapField;
 
+  // The position of a token, for use after the tokenizer has moved past it.
+  // Unlike a copy of the io::Tokenizer::Token, it does not copy the text.
+  struct TokenPosition {
+    TokenPosition() = default;
+    explicit TokenPosition(const io::Tokenizer::Token& token)
+        : line(token.line),
+          column(token.column),
+          end_column(token.end_column) {}
+
+    int line = 0;
+    io::ColumnNumber column = 0;
+    io::ColumnNumber end_column = 0;
+  };
+
   // =================================================================
   // Error recovery helpers
 
@@ -259,6 +283,7 @@ class PROTOBUF_EXPORT Parser {
     // the time the LocationRecorder is created.  StartAt() sets the start
     // location to the given token instead.
     void StartAt(const io::Tokenizer::Token& token);
+    void StartAt(const TokenPosition& token);
 
     // Start at the same location as some other LocationRecorder.
     void StartAt(const LocationRecorder& other);
@@ -267,6 +292,7 @@ class PROTOBUF_EXPORT Parser {
     // the time the LocationRecorder is destroyed.  EndAt() sets the end
     // location to the given token instead.
     void EndAt(const io::Tokenizer::Token& token);
+    void EndAt(const TokenPosition& token);
 
     // Records the start point of this location to the SourceLocationTable that
     // was passed to RecordSourceLocationsTo(), if any.  SourceLocationTable
@@ -292,8 +318,11 @@ class PROTOBUF_EXPORT Parser {
 
    private:
     Parser* parser_;
+    // Both are NULL if SourceCodeInfo is not being recorded.
     SourceCodeInfo* source_code_info_;
     SourceCodeInfo::Location* location_;
+    // The start of the location, which the legacy locations are recorded at.
+    TokenPosition start_;
 
     void Init(const LocationRecorder& parent, SourceCodeInfo* source_code_info);
   };
@@ -543,6 +572,7 @@ class PROTOBUF_EXPORT Parser {
   bool had_errors_;
   bool require_syntax_identifier_;
   bool stop_after_syntax_identifier_;
+  bool record_source_code_info_;
   std::string syntax_identifier_;
 
   // Leading doc comments for the next declaration.  These are not complete
@@ -591,6 +621,22 @@ class PROTOBUF_EXPORT SourceLocationTable {
   // Clears the contents of the table.
   void Clear();
 
+  // Calls visit(descriptor, location, import_name, line, column) for every
+  // location in the table. `location` is IMPORT for the locations added with
+  // AddImport(), and `import_name` is empty for all others.
+  template <typename Visit>
+  void ForEach(Visit visit) const {
+    for (const auto& entry : location_map_) {
+      visit(entry.first.first, entry.first.second, absl::string_view(),
+            entry.second.first, entry.second.second);
+    }
+    for (const auto& entry : import_location_map_) {
+      visit(entry.first.first, DescriptorPool::ErrorCollector::IMPORT,
+            absl::string_view(entry.first.second), entry.second.first,
+            entry.second.second);
+    }
+  }
+
  private:
   using LocationMap = absl::flat_hash_map<
       std::pair<const Message*, DescriptorPool::ErrorCollector::ErrorLocation>,
@@ -41,6 +41,7 @@
 #include <vector>
 
 #include "google/protobuf/any.pb.h"
+#include "google/protobuf/arena.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/text_format.h"
 #include "google/protobuf/testing/googletest.h"
@@ -284,6 +285,54 @@ TEST_F(ParserTest, WarnIfFieldNameContainsNumberImmediatelyFollowUnderscore) {
                   "song_name_1.") != std::string::npos);
 }
 
+TEST_F(ParserTest, SkipSourceCodeInfo) {
+  const char* text =
+      "syntax = \"proto2\";\n"
+      "// Foo leading\n"
+      "message Foo {\n"
+      "  optional int32 bar = 1;  // bar trailing\n"
+      "  extensions 10 to 19, 30 [(baz) = 1];\n"
+      "}\n";
+
+  SetupParser(text);
+  FileDescriptorProto expected;
+  ASSERT_TRUE(parser_->Parse(input_.get(), &expected));
+  EXPECT_GT(expected.source_code_info().location_size(), 0);
+  expected.clear_source_code_info();
+
+  SetupParser(text);
+  parser_->SetRecordSourceCodeInfo(false);
+  SourceLocationTable source_locations;
+  parser_->RecordSourceLocationsTo(&source_locations);
+  FileDescriptorProto actual;
+  ASSERT_TRUE(parser_->Parse(input_.get(), &actual));
+  EXPECT_EQ("", error_collector_.text_);
+  EXPECT_FALSE(actual.has_source_code_info());
+  EXPECT_EQ(expected.DebugString(), actual.DebugString());
+
+  // The locations for validation errors are still recorded.
+  int line, column;
+  ASSERT_TRUE(source_locations.Find(&actual.message_type(0).field(0),
+                                    DescriptorPool::ErrorCollector::NAME,
+                                    &line, &column));
+  EXPECT_EQ(3, line);
+  EXPECT_EQ(17, column);
+}
+
+TEST_F(ParserTest, ParseOntoArena) {
+  SetupParser(
+      "syntax = \"proto2\";\n"
+      "message Foo {\n"
+      "  optional int32 bar = 1;\n"
+      "}\n");
+  Arena arena;
+  FileDescriptorProto* file = Arena::CreateMessage<FileDescriptorProto>(&arena);
+  ASSERT_TRUE(parser_->Parse(input_.get(), file));
+  EXPECT_EQ("Foo", file->message_type(0).name());
+  EXPECT_EQ(&arena, file->source_code_info().GetArena());
+  EXPECT_GT(file->source_code_info().location_size(), 0);
+}
+
 // ===================================================================
 
 typedef ParserTest ParseMessageTest;
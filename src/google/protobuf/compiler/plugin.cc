@@ -41,6 +41,7 @@
 
 #include "google/protobuf/compiler/code_generator.h"
 #include "google/protobuf/compiler/plugin.pb.h"
+#include "google/protobuf/compiler/plugin_transport.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/io/io_win32.h"
@@ -166,8 +167,13 @@ int PluginMain(int argc, char* argv[], const CodeGenerator* generator) {
   setmode(STDOUT_FILENO, _O_BINARY);
 #endif
 
+  // With --plugin_shared_memory, protoc passes the request and takes the
+  // response through files, which are mapped rather than streamed.
   CodeGeneratorRequest request;
-  if (!request.ParseFromFileDescriptor(STDIN_FILENO)) {
+  bool parsed = IsMappableFile(STDIN_FILENO)
+                    ? ParseFromMappedFile(STDIN_FILENO, &request)
+                    : request.ParseFromFileDescriptor(STDIN_FILENO);
+  if (!parsed) {
     std::cerr << argv[0] << ": protoc sent unparseable request to plugin."
               << std::endl;
     return 1;
@@ -178,7 +184,10 @@ int PluginMain(int argc, char* argv[], const CodeGenerator* generator) {
   CodeGeneratorResponse response;
 
   if (GenerateCode(request, *generator, &response, &error_msg)) {
-    if (!response.SerializeToFileDescriptor(STDOUT_FILENO)) {
+    bool written = IsMappableFile(STDOUT_FILENO)
+                       ? SerializeToMappedFile(response, STDOUT_FILENO)
+                       : response.SerializeToFileDescriptor(STDOUT_FILENO);
+    if (!written) {
       std::cerr << argv[0] << ": Error writing to stdout." << std::endl;
       return 1;
     }
@@ -412,6 +412,8 @@ const ::_pbi::TcParseTable<2, 4, 0, 47, 2> Version::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_Version_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // optional string suffix = 4;
     {::_pbi::TcParser::FastSS1,
@@ -551,14 +553,22 @@ void Version::MergeImpl(::google::protobuf::Message& to_msg, const ::google::pro
     if (cached_has_bits & 0x00000001u) {
       _this->_internal_set_suffix(from._internal_suffix());
     }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.major_ = from._impl_.major_;
-    }
-    if (cached_has_bits & 0x00000004u) {
-      _this->_impl_.minor_ = from._impl_.minor_;
-    }
-    if (cached_has_bits & 0x00000008u) {
-      _this->_impl_.patch_ = from._impl_.patch_;
+    if ((cached_has_bits & 0x0000000eu) == 0x0000000eu) {
+      ::memcpy(&_this->_impl_.major_, &from._impl_.major_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.patch_) -
+              reinterpret_cast<const char*>(&from._impl_.major_)) +
+          sizeof(from._impl_.patch_));
+    } else {
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.major_ = from._impl_.major_;
+      }
+      if (cached_has_bits & 0x00000004u) {
+        _this->_impl_.minor_ = from._impl_.minor_;
+      }
+      if (cached_has_bits & 0x00000008u) {
+        _this->_impl_.patch_ = from._impl_.patch_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -724,6 +734,8 @@ const ::_pbi::TcParseTable<3, 4, 2, 79, 2> CodeGeneratorRequest::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_CodeGeneratorRequest_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // repeated string file_to_generate = 1;
@@ -800,6 +812,7 @@ const ::_pbi::TcParseTable<3, 4, 2, 79, 2> CodeGeneratorRequest::_table_ = {
   // repeated .google.protobuf.FileDescriptorProto proto_file = 15;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_proto_file_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_proto_file(), i);
     const auto& repfield = this->_internal_proto_file().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(15, repfield, repfield.GetCachedSize(), target, stream);
@@ -830,9 +843,10 @@ const ::_pbi::TcParseTable<3, 4, 2, 79, 2> CodeGeneratorRequest::_table_ = {
 
   // repeated .google.protobuf.FileDescriptorProto proto_file = 15;
   total_size += 1UL * this->_internal_proto_file_size();
-  for (const auto& msg : this->_internal_proto_file()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_proto_file_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_proto_file(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_proto_file().Get(i));
   }
 
   cached_has_bits = _impl_._has_bits_[0];
@@ -884,6 +898,22 @@ void CodeGeneratorRequest::MergeImpl(::google::protobuf::Message& to_msg, const
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void CodeGeneratorRequest::MergeFrom(CodeGeneratorRequest&& from) {
+  CodeGeneratorRequest* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_file_to_generate()->MergeFrom(
+      std::move(*from._internal_mutable_file_to_generate()));
+  _this->_internal_mutable_proto_file()->MergeFrom(
+      std::move(*from._internal_mutable_proto_file()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const CodeGeneratorRequest&>(from));
+}
+
 void CodeGeneratorRequest::CopyFrom(const CodeGeneratorRequest& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.compiler.CodeGeneratorRequest)
   if (&from == this) return;
@@ -1076,6 +1106,8 @@ const ::_pbi::TcParseTable<2, 4, 1, 86, 2> CodeGeneratorResponse_File::_table_ =
     offsetof(decltype(_table_), aux_entries),
     &_CodeGeneratorResponse_File_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // optional .google.protobuf.GeneratedCodeInfo generated_code_info = 16;
     {::_pbi::TcParser::FastMtS2,
@@ -1373,6 +1405,8 @@ const ::_pbi::TcParseTable<2, 3, 1, 60, 2> CodeGeneratorResponse::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_CodeGeneratorResponse_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string error = 1;
@@ -1430,6 +1464,7 @@ const ::_pbi::TcParseTable<2, 3, 1, 60, 2> CodeGeneratorResponse::_table_ = {
   // repeated .google.protobuf.compiler.CodeGeneratorResponse.File file = 15;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_file_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_file(), i);
     const auto& repfield = this->_internal_file().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(15, repfield, repfield.GetCachedSize(), target, stream);
@@ -1453,9 +1488,10 @@ const ::_pbi::TcParseTable<2, 3, 1, 60, 2> CodeGeneratorResponse::_table_ = {
 
   // repeated .google.protobuf.compiler.CodeGeneratorResponse.File file = 15;
   total_size += 1UL * this->_internal_file_size();
-  for (const auto& msg : this->_internal_file()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_file_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_file(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_file().Get(i));
   }
 
   cached_has_bits = _impl_._has_bits_[0];
@@ -1505,6 +1541,20 @@ void CodeGeneratorResponse::MergeImpl(::google::protobuf::Message& to_msg, const
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void CodeGeneratorResponse::MergeFrom(CodeGeneratorResponse&& from) {
+  CodeGeneratorResponse* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_file()->MergeFrom(
+      std::move(*from._internal_mutable_file()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const CodeGeneratorResponse&>(from));
+}
+
 void CodeGeneratorResponse::CopyFrom(const CodeGeneratorResponse& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.compiler.CodeGeneratorResponse)
   if (&from == this) return;
@@ -209,6 +209,11 @@ class PROTOC_EXPORT Version final :
   Version* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Version>(arena);
   }
+  Version* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Version* copy = CreateMaybeMessage<Version>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Version& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -412,6 +417,11 @@ class PROTOC_EXPORT CodeGeneratorRequest final :
   CodeGeneratorRequest* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<CodeGeneratorRequest>(arena);
   }
+  CodeGeneratorRequest* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    CodeGeneratorRequest* copy = CreateMaybeMessage<CodeGeneratorRequest>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const CodeGeneratorRequest& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -421,6 +431,7 @@ class PROTOC_EXPORT CodeGeneratorRequest final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(CodeGeneratorRequest&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -643,6 +654,11 @@ class PROTOC_EXPORT CodeGeneratorResponse_File final :
   CodeGeneratorResponse_File* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<CodeGeneratorResponse_File>(arena);
   }
+  CodeGeneratorResponse_File* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    CodeGeneratorResponse_File* copy = CreateMaybeMessage<CodeGeneratorResponse_File>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const CodeGeneratorResponse_File& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -862,6 +878,11 @@ class PROTOC_EXPORT CodeGeneratorResponse final :
   CodeGeneratorResponse* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<CodeGeneratorResponse>(arena);
   }
+  CodeGeneratorResponse* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    CodeGeneratorResponse* copy = CreateMaybeMessage<CodeGeneratorResponse>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const CodeGeneratorResponse& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -871,6 +892,7 @@ class PROTOC_EXPORT CodeGeneratorResponse final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(CodeGeneratorResponse&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
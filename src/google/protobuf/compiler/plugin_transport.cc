@@ -0,0 +1,105 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/compiler/plugin_transport.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+#include "google/protobuf/message_lite.h"
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+
+#ifdef _WIN32
+
+bool IsMappableFile(int fd) { return false; }
+
+bool ParseFromMappedFile(int fd, MessageLite* message) { return false; }
+
+bool SerializeToMappedFile(const MessageLite& message, int fd) {
+  return false;
+}
+
+#else  // _WIN32
+
+bool IsMappableFile(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+  int flags = fcntl(fd, F_GETFL);
+  // Writes to an O_APPEND file do not go where the mapping puts them.
+  return flags != -1 && (flags & O_APPEND) == 0 &&
+         lseek(fd, 0, SEEK_CUR) == 0;
+}
+
+bool ParseFromMappedFile(int fd, MessageLite* message) {
+  struct stat st;
+  if (fstat(fd, &st) != 0) return false;
+  const size_t size = static_cast<size_t>(st.st_size);
+  if (size == 0) return message->ParseFromArray(nullptr, 0);
+  if (size > static_cast<size_t>(INT_MAX)) return false;
+
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) return false;
+  bool parsed = message->ParseFromArray(data, static_cast<int>(size));
+  munmap(data, size);
+  return parsed && lseek(fd, 0, SEEK_END) != -1;
+}
+
+bool SerializeToMappedFile(const MessageLite& message, int fd) {
+  if (!message.IsInitialized()) return false;
+  const size_t size = message.ByteSizeLong();
+  if (size > static_cast<size_t>(INT_MAX)) return false;
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) return false;
+  if (size > 0) {
+    void* data =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) return false;
+    // The size was just computed, so serialize without computing it again.
+    message.SerializeWithCachedSizesToArray(static_cast<uint8_t*>(data));
+    munmap(data, size);
+  }
+  return lseek(fd, static_cast<off_t>(size), SEEK_SET) != -1;
+}
+
+#endif  // !_WIN32
+
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,67 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Helpers for passing a CodeGeneratorRequest or CodeGeneratorResponse through
+// a memory-mapped file instead of a stream.  With --plugin_shared_memory,
+// protoc makes a plugin's stdin and stdout unlinked temporary files rather
+// than pipes.  PluginMain() then parses and serializes them in place, while
+// any other plugin reads and writes them like it would a pipe.
+
+#ifndef GOOGLE_PROTOBUF_COMPILER_PLUGIN_TRANSPORT_H__
+#define GOOGLE_PROTOBUF_COMPILER_PLUGIN_TRANSPORT_H__
+
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace compiler {
+
+// Returns true if `fd` is a regular file positioned at its start, as the
+// functions below require.  Always false on Windows.
+PROTOC_EXPORT bool IsMappableFile(int fd);
+
+// Parses `message` from the whole file `fd`, and leaves the file positioned
+// at its end.
+PROTOC_EXPORT bool ParseFromMappedFile(int fd, MessageLite* message);
+
+// Replaces the contents of the file `fd` with `message`, serialized straight
+// into the mapping, and leaves the file positioned at its end.
+PROTOC_EXPORT bool SerializeToMappedFile(const MessageLite& message, int fd);
+
+}  // namespace compiler
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_COMPILER_PLUGIN_TRANSPORT_H__
@@ -62,6 +62,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
 #include "absl/strings/substitute.h"
+#include "google/protobuf/compiler/cpp/helpers.h"
 #include "google/protobuf/compiler/python/helpers.h"
 #include "google/protobuf/compiler/python/pyi_generator.h"
 #include "google/protobuf/compiler/retention.h"
@@ -216,6 +217,8 @@ GeneratorOptions Generator::ParseParameter(absl::string_view parameter,
       options.generate_pyi = true;
     } else if (option.first == "annotate_code") {
       options.annotate_pyi = true;
+    } else if (option.first == "cpp_extension") {
+      options.cpp_extension = true;
     } else {
       *error = absl::StrCat("Unknown generator option: ", option.first);
     }
@@ -292,6 +295,16 @@ bool Generator::Generate(const FileDescriptor* file,
     }
   }
 
+  std::string module_name = ModuleName(file->name());
+  if (!opensource_runtime_) {
+    module_name =
+        std::string(absl::StripPrefix(module_name, kThirdPartyPrefix));
+  }
+
+  if (options.cpp_extension && !GenerateCppExtension(context)) {
+    return false;
+  }
+
   std::unique_ptr<io::ZeroCopyOutputStream> output(context->Open(filename));
   ABSL_CHECK(output.get());
   io::Printer printer(output.get(), '$');
@@ -299,6 +312,12 @@ bool Generator::Generate(const FileDescriptor* file,
 
   PrintTopBoilerplate();
   PrintImports();
+  if (options.cpp_extension) {
+    // Must run before the file is added to the pool, so that the descriptors
+    // of the linked C++ code are picked up.
+    printer_->Print("_builder.ImportCppExtension('$module_name$_cpp')\n\n",
+                    "module_name", module_name);
+  }
   PrintFileDescriptor();
   printer_->Print("_globals = globals()\n");
   if (GeneratingDescriptorProto()) {
@@ -319,11 +338,6 @@ bool Generator::Generate(const FileDescriptor* file,
   if (GeneratingDescriptorProto()) {
     printer_->Outdent();
   }
-  std::string module_name = ModuleName(file->name());
-  if (!opensource_runtime_) {
-    module_name =
-        std::string(absl::StripPrefix(module_name, kThirdPartyPrefix));
-  }
   printer_->Print(
       "_builder.BuildTopDescriptorsAndMessages(DESCRIPTOR, '$module_name$', "
       "_globals)\n",
@@ -385,6 +399,75 @@ void Generator::PrintTopBoilerplate() const {
   printer_->Print("\n\n");
 }
 
+// Prints a Python extension module which links the C++ code generated for
+// |file| into the process. Importing it registers the file in the C++
+// generated pool, which the C++ implementation of the Python runtime uses as
+// the underlay of its default pool, so the messages of |file| are then
+// generated C++ classes instead of DynamicMessages.
+bool Generator::GenerateCppExtension(GeneratorContext* context) const {
+  std::string module_name = ModuleName(file_->name());
+  absl::flat_hash_map<absl::string_view, std::string> m;
+  m["filename"] = file_->name();
+  m["header"] = absl::StrCat(StripProto(file_->name()), ".pb.h");
+  m["module_name"] = absl::StrCat(module_name, "_cpp");
+  m["init_name"] = absl::StrCat(
+      "PyInit_", module_name.substr(module_name.rfind('.') + 1), "_cpp");
+  m["descriptor_table"] = absl::StrCat(
+      "descriptor_table_", cpp::FilenameIdentifier(file_->name()));
+
+  std::unique_ptr<io::ZeroCopyOutputStream> output(
+      context->Open(GetFileName(file_, "_cpp.cc")));
+  ABSL_CHECK(output.get());
+  io::Printer printer(output.get(), '$');
+  printer.Print(
+      m,
+      "// Generated by the protocol buffer compiler.  DO NOT EDIT!\n"
+      "// source: $filename$\n"
+      "//\n"
+      "// Python extension linking the generated C++ code for $filename$.\n"
+      "// It must be linked against the same libprotobuf as\n"
+      "// google.protobuf.pyext._message.\n"
+      "\n"
+      "#define PY_SSIZE_T_CLEAN\n"
+      "#include <Python.h>\n"
+      "\n"
+      "#include \"$header$\"\n"
+      "#include \"google/protobuf/descriptor.h\"\n"
+      "#include \"google/protobuf/generated_message_reflection.h\"\n"
+      "#include \"google/protobuf/proto_api.h\"\n"
+      "\n"
+      "static struct PyModuleDef _module = {\n"
+      "    PyModuleDef_HEAD_INIT, \"$module_name$\", nullptr, -1, nullptr};\n"
+      "\n"
+      "PyMODINIT_FUNC $init_name$() {\n"
+      "  using ::google::protobuf::DescriptorPool;\n"
+      "  using ::google::protobuf::python::PyProto_API;\n"
+      "  using ::google::protobuf::python::PyProtoAPICapsuleName;\n"
+      "\n"
+      "  // Registers the file and its dependencies in the generated pool.\n"
+      "  ::google::protobuf::internal::AssignDescriptors(\n"
+      "      &::$descriptor_table$, /*eager=*/true);\n"
+      "  const auto* py_proto_api = static_cast<const PyProto_API*>(\n"
+      "      PyCapsule_Import(PyProtoAPICapsuleName(), 0));\n"
+      "  if (py_proto_api == nullptr) {\n"
+      "    return nullptr;\n"
+      "  }\n"
+      "  const char kFilename[] = \"$filename$\";\n"
+      "  if (py_proto_api->GetDefaultDescriptorPool()->FindFileByName(\n"
+      "          kFilename) !=\n"
+      "      DescriptorPool::generated_pool()->FindFileByName(kFilename)) {\n"
+      "    PyErr_SetString(PyExc_ImportError,\n"
+      "                    \"$filename$ was loaded without its C++ \"\n"
+      "                    \"code, or $module_name$ does not share \"\n"
+      "                    \"libprotobuf with \"\n"
+      "                    \"google.protobuf.pyext._message\");\n"
+      "    return nullptr;\n"
+      "  }\n"
+      "  return PyModule_Create(&_module);\n"
+      "}\n");
+  return !printer.failed();
+}
+
 // Prints Python imports for all modules imported by |file|.
 void Generator::PrintImports() const {
   for (int i = 0; i < file_->dependency_count(); ++i) {
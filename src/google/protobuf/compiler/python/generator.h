@@ -72,6 +72,9 @@ struct GeneratorOptions {
   bool generate_pyi = false;
   bool annotate_pyi = false;
   bool bootstrap = false;
+  // Also emit a <module>_pb2_cpp.cc Python extension linking in the generated
+  // C++ code, which the C++ runtime then uses instead of DynamicMessage.
+  bool cpp_extension = false;
 };
 
 class PROTOC_EXPORT Generator : public CodeGenerator {
@@ -96,6 +99,7 @@ class PROTOC_EXPORT Generator : public CodeGenerator {
   GeneratorOptions ParseParameter(absl::string_view parameter,
                                   std::string* error) const;
   void PrintImports() const;
+  bool GenerateCppExtension(GeneratorContext* context) const;
   void PrintFileDescriptor() const;
   void PrintAllNestedEnumsInFile() const;
   void PrintNestedEnums(const Descriptor& descriptor) const;
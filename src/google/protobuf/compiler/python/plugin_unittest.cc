@@ -124,6 +124,39 @@ TEST(PythonPluginTest, ImportTest) {
   EXPECT_TRUE(found_expected_import);
 }
 
+TEST(PythonPluginTest, CppExtensionTest) {
+  ABSL_CHECK_OK(
+      File::SetContents(absl::StrCat(TestTempDir(), "/cpp_ext.proto"),
+                        "syntax = \"proto3\";\n"
+                        "package foo;\n"
+                        "message Message1 {}\n",
+                        true));
+
+  compiler::CommandLineInterface cli;
+  cli.SetInputsAreProtoPathRelative(true);
+  python::Generator python_generator;
+  cli.RegisterGenerator("--python_out", &python_generator, "");
+  std::string proto_path = absl::StrCat("-I", TestTempDir());
+  std::string python_out =
+      absl::StrCat("--python_out=cpp_extension:", TestTempDir());
+  const char* argv[] = {"protoc", proto_path.c_str(), python_out.c_str(),
+                        "cpp_ext.proto"};
+  ASSERT_EQ(0, cli.Run(4, argv));
+
+  std::string output;
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(TestTempDir(), "/cpp_ext_pb2.py"), &output, true));
+  EXPECT_TRUE(absl::StrContains(
+      output, "_builder.ImportCppExtension('cpp_ext_pb2_cpp')"));
+
+  ABSL_CHECK_OK(File::GetContents(
+      absl::StrCat(TestTempDir(), "/cpp_ext_pb2_cpp.cc"), &output, true));
+  EXPECT_TRUE(absl::StrContains(output, "#include \"cpp_ext.pb.h\""));
+  EXPECT_TRUE(absl::StrContains(output, "PyInit_cpp_ext_pb2_cpp()"));
+  EXPECT_TRUE(
+      absl::StrContains(output, "&::descriptor_table_cpp_5fext_2eproto"));
+}
+
 }  // namespace
 }  // namespace python
 }  // namespace compiler
@@ -48,13 +48,40 @@ std::unique_ptr<AccessorGenerator> AccessorGenerator::For(
     return nullptr;
   }
 
+  if (field.desc().is_repeated()) {
+    // Repeated fields lend their C++ storage to Rust, which upb can't do
+    // through the same thunks.
+    if (field.is_upb()) return nullptr;
+    switch (field.desc().type()) {
+      case FieldDescriptor::TYPE_INT32:
+      case FieldDescriptor::TYPE_INT64:
+      case FieldDescriptor::TYPE_UINT32:
+      case FieldDescriptor::TYPE_UINT64:
+      case FieldDescriptor::TYPE_SINT32:
+      case FieldDescriptor::TYPE_SINT64:
+      case FieldDescriptor::TYPE_FIXED32:
+      case FieldDescriptor::TYPE_FIXED64:
+      case FieldDescriptor::TYPE_SFIXED32:
+      case FieldDescriptor::TYPE_SFIXED64:
+      case FieldDescriptor::TYPE_FLOAT:
+      case FieldDescriptor::TYPE_DOUBLE:
+      case FieldDescriptor::TYPE_BOOL:
+        return ForRepeatedScalar(field);
+      case FieldDescriptor::TYPE_STRING:
+      case FieldDescriptor::TYPE_BYTES:
+        return ForRepeatedBytes(field);
+
+      default:
+        return nullptr;
+    }
+  }
+
   switch (field.desc().type()) {
     case FieldDescriptor::TYPE_INT64:
     case FieldDescriptor::TYPE_BOOL:
-      if (field.desc().is_repeated()) return nullptr;
       return ForSingularScalar(field);
+    case FieldDescriptor::TYPE_STRING:
     case FieldDescriptor::TYPE_BYTES:
-      if (field.desc().is_repeated()) return nullptr;
       return ForSingularBytes(field);
 
     default:
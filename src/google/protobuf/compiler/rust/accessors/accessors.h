@@ -91,6 +91,10 @@ class AccessorGenerator {
       Context<FieldDescriptor> field);
   static std::unique_ptr<AccessorGenerator> ForSingularBytes(
       Context<FieldDescriptor> field);
+  static std::unique_ptr<AccessorGenerator> ForRepeatedScalar(
+      Context<FieldDescriptor> field);
+  static std::unique_ptr<AccessorGenerator> ForRepeatedBytes(
+      Context<FieldDescriptor> field);
 };
 
 inline AccessorGenerator::~AccessorGenerator() = default;
@@ -121,11 +121,7 @@ void MessageDeserialize(Context<Descriptor> msg) {
           },
           R"rs(
           let success = unsafe {
-            let data = $pb$::SerializedData::from_raw_parts(
-              $NonNull$::new(data.as_ptr() as *mut _).unwrap(),
-              data.len(),
-            );
-
+            let data = $pb$::PtrAndLen { ptr: data.as_ptr(), len: data.len() };
             $deserialize_thunk$(self.msg, data)
           };
           success.then_some(()).ok_or($pb$::ParseError)
@@ -167,12 +163,18 @@ void MessageExterns(Context<Descriptor> msg) {
               {"delete_thunk", Thunk(msg, "delete")},
               {"serialize_thunk", Thunk(msg, "serialize")},
               {"deserialize_thunk", Thunk(msg, "deserialize")},
+              {"new_on_arena_thunk", Thunk(msg, "new_on_arena")},
+              {"byte_size_thunk", Thunk(msg, "byte_size")},
+              {"serialize_into_thunk", Thunk(msg, "serialize_into")},
           },
           R"rs(
           fn $new_thunk$() -> $NonNull$<u8>;
           fn $delete_thunk$(raw_msg: $NonNull$<u8>);
           fn $serialize_thunk$(raw_msg: $NonNull$<u8>) -> $pb$::SerializedData;
-          fn $deserialize_thunk$(raw_msg: $NonNull$<u8>, data: $pb$::SerializedData) -> bool;
+          fn $deserialize_thunk$(raw_msg: $NonNull$<u8>, data: $pb$::PtrAndLen) -> bool;
+          fn $new_on_arena_thunk$(arena: $pbi$::RawArena) -> $NonNull$<u8>;
+          fn $byte_size_thunk$(raw_msg: $NonNull$<u8>) -> usize;
+          fn $serialize_into_thunk$(raw_msg: $NonNull$<u8>, data: *mut u8, len: usize) -> bool;
         )rs");
       return;
 
@@ -322,8 +324,33 @@ void MessageGenerator::GenerateRs(Context<Descriptor> msg) {
 
   if (msg.is_cpp()) {
     msg.printer().PrintRaw("\n");
-    msg.Emit({{"Msg", msg.desc().name()}}, R"rs(
+    msg.Emit({{"Msg", msg.desc().name()},
+              {"new_on_arena_thunk", Thunk(msg, "new_on_arena")},
+              {"byte_size_thunk", Thunk(msg, "byte_size")},
+              {"serialize_into_thunk", Thunk(msg, "serialize_into")}},
+             R"rs(
       impl $Msg$ {
+        /// Creates an empty message on a C++ arena, which frees it.
+        ///
+        /// # Safety
+        ///
+        /// `arena` must outlive the returned message.
+        pub unsafe fn new_on_arena(arena: &$pbi$::Arena) -> Self {
+          Self { msg: $new_on_arena_thunk$(arena.raw()) }
+        }
+
+        /// Appends the serialized message to `out`, serializing directly into
+        /// its spare capacity.
+        pub fn serialize_into(&self, out: &mut $std$::vec::Vec<u8>) {
+          let len = unsafe { $byte_size_thunk$(self.msg) };
+          out.reserve(len);
+          unsafe {
+            let end = out.as_mut_ptr().add(out.len());
+            assert!($serialize_into_thunk$(self.msg, end, len));
+            out.set_len(out.len() + len);
+          }
+        }
+
         pub fn __unstable_wrap_cpp_grant_permission_to_break(msg: $NonNull$<u8>) -> Self {
           Self { msg }
         }
@@ -348,6 +375,9 @@ void MessageGenerator::GenerateThunksCc(Context<Descriptor> msg) {
           {"delete_thunk", Thunk(msg, "delete")},
           {"serialize_thunk", Thunk(msg, "serialize")},
           {"deserialize_thunk", Thunk(msg, "deserialize")},
+          {"new_on_arena_thunk", Thunk(msg, "new_on_arena")},
+          {"byte_size_thunk", Thunk(msg, "byte_size")},
+          {"serialize_into_thunk", Thunk(msg, "serialize_into")},
           {"nested_msg_thunks",
            [&] {
              for (int i = 0; i < msg.desc().nested_type_count(); ++i) {
@@ -374,13 +404,26 @@ void MessageGenerator::GenerateThunksCc(Context<Descriptor> msg) {
         // clang-format off
         extern $abi$ {
         void* $new_thunk$(){return new $QualifiedMsg$(); }
-        void $delete_thunk$(void* ptr) { delete static_cast<$QualifiedMsg$*>(ptr); }
+        void $delete_thunk$(void* ptr) {
+          auto* msg = static_cast<$QualifiedMsg$*>(ptr);
+          //~ Messages on an arena are freed with the arena.
+          if (msg->GetArena() == nullptr) delete msg;
+        }
         google::protobuf::rust_internal::SerializedData $serialize_thunk$($QualifiedMsg$* msg) {
           return google::protobuf::rust_internal::SerializeMsg(msg);
         }
         bool $deserialize_thunk$($QualifiedMsg$* msg,
-                                 google::protobuf::rust_internal::SerializedData data) {
-          return msg->ParseFromArray(data.data, data.len);
+                                 google::protobuf::rust_internal::PtrAndLen data) {
+          return google::protobuf::rust_internal::ParseMsg(msg, data);
+        }
+        void* $new_on_arena_thunk$(google::protobuf::Arena* arena) {
+          return google::protobuf::Arena::CreateMessage<$QualifiedMsg$>(arena);
+        }
+        size_t $byte_size_thunk$(const $QualifiedMsg$* msg) {
+          return msg->ByteSizeLong();
+        }
+        bool $serialize_into_thunk$(const $QualifiedMsg$* msg, char* data, size_t len) {
+          return google::protobuf::rust_internal::SerializeMsgInto(msg, data, len);
         }
 
         $accessor_thunks$
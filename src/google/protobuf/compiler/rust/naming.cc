@@ -110,8 +110,25 @@ absl::string_view PrimitiveRsTypeName(Context<FieldDescriptor> field) {
   switch (field.desc().type()) {
     case FieldDescriptor::TYPE_BOOL:
       return "bool";
+    case FieldDescriptor::TYPE_INT32:
+    case FieldDescriptor::TYPE_SINT32:
+    case FieldDescriptor::TYPE_SFIXED32:
+      return "i32";
     case FieldDescriptor::TYPE_INT64:
+    case FieldDescriptor::TYPE_SINT64:
+    case FieldDescriptor::TYPE_SFIXED64:
       return "i64";
+    case FieldDescriptor::TYPE_UINT32:
+    case FieldDescriptor::TYPE_FIXED32:
+      return "u32";
+    case FieldDescriptor::TYPE_UINT64:
+    case FieldDescriptor::TYPE_FIXED64:
+      return "u64";
+    case FieldDescriptor::TYPE_FLOAT:
+      return "f32";
+    case FieldDescriptor::TYPE_DOUBLE:
+      return "f64";
+    case FieldDescriptor::TYPE_STRING:
     case FieldDescriptor::TYPE_BYTES:
       return "&[u8]";
     default:
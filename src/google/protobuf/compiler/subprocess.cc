@@ -33,21 +33,26 @@
 #include "google/protobuf/compiler/subprocess.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 
 #ifndef _WIN32
 #include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <sys/select.h>
 #include <sys/wait.h>
 #endif
 
+#include "absl/base/attributes.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/compiler/plugin_transport.h"
 #include "google/protobuf/io/io_win32.h"
 #include "google/protobuf/message.h"
 
@@ -55,6 +60,15 @@ namespace google {
 namespace protobuf {
 namespace compiler {
 
+namespace {
+
+// Subprocesses may be started from several threads at once, as protoc --jobs
+// does. They are started one at a time so that no child inherits the pipes
+// of another one, which would keep them open after that one exits.
+ABSL_CONST_INIT absl::Mutex start_mutex(absl::kConstInit);
+
+}  // namespace
+
 #ifdef _WIN32
 
 static void CloseHandleOrDie(HANDLE handle) {
@@ -80,6 +94,16 @@ Subprocess::~Subprocess() {
 }
 
 void Subprocess::Start(const std::string& program, SearchMode search_mode) {
+  if (shared_memory_) {
+    // The child may only read its stdin once the request is in place, so it
+    // is started by Communicate().
+    program_ = program;
+    search_mode_ = search_mode;
+    return;
+  }
+
+  absl::MutexLock lock(&start_mutex);
+
   // Create the pipes.
   HANDLE stdin_pipe_read;
   HANDLE stdin_pipe_write;
@@ -311,6 +335,31 @@ Subprocess::~Subprocess() {
 }
 
 namespace {
+
+// The "sighandler_t" typedef is GNU-specific, so define our own.
+typedef void SignalHandler(int);
+
+ABSL_CONST_INIT absl::Mutex sigpipe_mutex(absl::kConstInit);
+int sigpipe_ignorers ABSL_GUARDED_BY(sigpipe_mutex) = 0;
+SignalHandler* old_pipe_handler ABSL_GUARDED_BY(sigpipe_mutex) = nullptr;
+
+// Make sure SIGPIPE is disabled so that if a child dies it doesn't kill us.
+// Several Communicate() calls may run at once, and the last one to finish
+// restores the handler.
+void IgnoreSigpipe() {
+  absl::MutexLock lock(&sigpipe_mutex);
+  if (sigpipe_ignorers++ == 0) old_pipe_handler = signal(SIGPIPE, SIG_IGN);
+}
+
+void RestoreSigpipe() {
+  absl::MutexLock lock(&sigpipe_mutex);
+  if (--sigpipe_ignorers == 0) signal(SIGPIPE, old_pipe_handler);
+}
+
+void SetCloseOnExec(int fd) {
+  ABSL_CHECK(fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC) != -1);
+}
+
 char* portable_strdup(const char* s) {
   char* ns = (char*)malloc(strlen(s) + 1);
   if (ns != nullptr) {
@@ -318,11 +367,92 @@ char* portable_strdup(const char* s) {
   }
   return ns;
 }
+
+// Runs argv[0] in the forked child, whose stdin and stdout are already set up.
+ABSL_ATTRIBUTE_NORETURN void ExecChild(char* argv[],
+                                       Subprocess::SearchMode search_mode) {
+  switch (search_mode) {
+    case Subprocess::SEARCH_PATH:
+      execvp(argv[0], argv);
+      break;
+    case Subprocess::EXACT_NAME:
+      execv(argv[0], argv);
+      break;
+  }
+
+  // Write directly to STDERR_FILENO to avoid stdio code paths that may do
+  // stuff that is unsafe here.
+  int ignored;
+  ignored = write(STDERR_FILENO, argv[0], strlen(argv[0]));
+  const char* message =
+      ": program not found or is not executable\n"
+      "Please specify a program using absolute path or make sure "
+      "the program is available in your PATH system variable\n";
+  ignored = write(STDERR_FILENO, message, strlen(message));
+  (void)ignored;
+
+  // Must use _exit() rather than exit() to avoid flushing output buffers
+  // that will also be flushed by the parent.
+  _exit(1);
+}
+
+int WaitForChild(pid_t child_pid) {
+  int status;
+  while (waitpid(child_pid, &status, 0) == -1) {
+    if (errno != EINTR) {
+      ABSL_LOG(FATAL) << "waitpid: " << strerror(errno);
+    }
+  }
+  return status;
+}
+
+// Returns false and sets *error unless the child exited successfully.
+bool CheckExitStatus(int status, std::string* error) {
+  if (WIFEXITED(status)) {
+    if (WEXITSTATUS(status) != 0) {
+      int error_code = WEXITSTATUS(status);
+      *error =
+          absl::Substitute("Plugin failed with status code $0.", error_code);
+      return false;
+    }
+  } else if (WIFSIGNALED(status)) {
+    int signal = WTERMSIG(status);
+    *error = absl::Substitute("Plugin killed by signal $0.", signal);
+    return false;
+  } else {
+    *error = "Neither WEXITSTATUS nor WTERMSIG is true?";
+    return false;
+  }
+  return true;
+}
+
+// Creates an unlinked, close-on-exec temporary file, or returns -1.
+int CreateUnlinkedTempFile() {
+  const char* tmpdir = getenv("TMPDIR");
+  std::string path = absl::StrCat(
+      tmpdir != nullptr && *tmpdir != '\0' ? tmpdir : "/tmp",
+      "/protoc-plugin-XXXXXX");
+  int fd = mkstemp(&path[0]);
+  if (fd == -1) return -1;
+  unlink(path.c_str());
+  SetCloseOnExec(fd);
+  return fd;
+}
 }  // namespace
 
 void Subprocess::Start(const std::string& program, SearchMode search_mode) {
-  // Note that we assume that there are no other threads, thus we don't have to
-  // do crazy stuff like using socket pairs or avoiding libc locks.
+  if (shared_memory_) {
+    // The child may only read its stdin once the request is in place, so it
+    // is started by Communicate().
+    program_ = program;
+    search_mode_ = search_mode;
+    return;
+  }
+
+  // The pipes are close-on-exec, so that children started later do not
+  // inherit them. Otherwise we don't do crazy stuff like using socket pairs or
+  // avoiding libc locks.
+  absl::MutexLock lock(&start_mutex);
 
   // [0] is read end, [1] is write end.
   int stdin_pipe[2];
@@ -330,6 +460,10 @@ void Subprocess::Start(const std::string& program, SearchMode search_mode) {
 
   ABSL_CHECK(pipe(stdin_pipe) != -1);
   ABSL_CHECK(pipe(stdout_pipe) != -1);
+  for (int fd :
+       {stdin_pipe[0], stdin_pipe[1], stdout_pipe[0], stdout_pipe[1]}) {
+    SetCloseOnExec(fd);
+  }
 
   char* argv[2] = {portable_strdup(program.c_str()), nullptr};
 
@@ -346,29 +480,7 @@ void Subprocess::Start(const std::string& program, SearchMode search_mode) {
     close(stdout_pipe[0]);
     close(stdout_pipe[1]);
 
-    switch (search_mode) {
-      case SEARCH_PATH:
-        execvp(argv[0], argv);
-        break;
-      case EXACT_NAME:
-        execv(argv[0], argv);
-        break;
-    }
-
-    // Write directly to STDERR_FILENO to avoid stdio code paths that may do
-    // stuff that is unsafe here.
-    int ignored;
-    ignored = write(STDERR_FILENO, argv[0], strlen(argv[0]));
-    const char* message =
-        ": program not found or is not executable\n"
-        "Please specify a program using absolute path or make sure "
-        "the program is available in your PATH system variable\n";
-    ignored = write(STDERR_FILENO, message, strlen(message));
-    (void)ignored;
-
-    // Must use _exit() rather than exit() to avoid flushing output buffers
-    // that will also be flushed by the parent.
-    _exit(1);
+    ExecChild(argv, search_mode);
   } else {
     free(argv[0]);
 
@@ -382,19 +494,17 @@ void Subprocess::Start(const std::string& program, SearchMode search_mode) {
 
 bool Subprocess::Communicate(const Message& input, Message* output,
                              std::string* error) {
-  ABSL_CHECK_NE(child_stdin_, -1) << "Must call Start() first.";
-
-  // The "sighandler_t" typedef is GNU-specific, so define our own.
-  typedef void SignalHandler(int);
+  if (shared_memory_) return CommunicateThroughFiles(input, output, error);
 
-  // Make sure SIGPIPE is disabled so that if the child dies it doesn't kill us.
-  SignalHandler* old_pipe_handler = signal(SIGPIPE, SIG_IGN);
+  ABSL_CHECK_NE(child_stdin_, -1) << "Must call Start() first.";
 
   std::string input_data;
   if (!input.SerializeToString(&input_data)) {
     *error = "Failed to serialize request.";
     return false;
   }
+
+  IgnoreSigpipe();
   std::string output_data;
 
   int input_pos = 0;
@@ -460,31 +570,12 @@ bool Subprocess::Communicate(const Message& input, Message* output,
     child_stdin_ = -1;
   }
 
-  int status;
-  while (waitpid(child_pid_, &status, 0) == -1) {
-    if (errno != EINTR) {
-      ABSL_LOG(FATAL) << "waitpid: " << strerror(errno);
-    }
-  }
+  int status = WaitForChild(child_pid_);
 
   // Restore SIGPIPE handling.
-  signal(SIGPIPE, old_pipe_handler);
+  RestoreSigpipe();
 
-  if (WIFEXITED(status)) {
-    if (WEXITSTATUS(status) != 0) {
-      int error_code = WEXITSTATUS(status);
-      *error =
-          absl::Substitute("Plugin failed with status code $0.", error_code);
-      return false;
-    }
-  } else if (WIFSIGNALED(status)) {
-    int signal = WTERMSIG(status);
-    *error = absl::Substitute("Plugin killed by signal $0.", signal);
-    return false;
-  } else {
-    *error = "Neither WEXITSTATUS nor WTERMSIG is true?";
-    return false;
-  }
+  if (!CheckExitStatus(status, error)) return false;
 
   if (!output->ParseFromString(output_data)) {
     *error = absl::StrCat("Plugin output is unparseable: ",
@@ -495,6 +586,67 @@ bool Subprocess::Communicate(const Message& input, Message* output,
   return true;
 }
 
+bool Subprocess::CommunicateThroughFiles(const Message& input, Message* output,
+                                         std::string* error) {
+  ABSL_CHECK(!program_.empty()) << "Must call Start() first.";
+
+  // The files are created under start_mutex, like the pipes in Start(), so
+  // that no other child inherits them before they are close-on-exec.
+  int request_fd;
+  int response_fd;
+  {
+    absl::MutexLock lock(&start_mutex);
+    request_fd = CreateUnlinkedTempFile();
+    response_fd = request_fd == -1 ? -1 : CreateUnlinkedTempFile();
+  }
+  if (response_fd == -1) {
+    *error = absl::StrCat("Failed to create a temporary file: ",
+                          strerror(errno));
+    if (request_fd != -1) close(request_fd);
+    return false;
+  }
+
+  if (!SerializeToMappedFile(input, request_fd) ||
+      lseek(request_fd, 0, SEEK_SET) != 0) {
+    *error = "Failed to serialize request.";
+    close(request_fd);
+    close(response_fd);
+    return false;
+  }
+
+  char* argv[2] = {portable_strdup(program_.c_str()), nullptr};
+  {
+    absl::MutexLock lock(&start_mutex);
+    child_pid_ = fork();
+    if (child_pid_ == -1) {
+      ABSL_LOG(FATAL) << "fork: " << strerror(errno);
+    } else if (child_pid_ == 0) {
+      // We are the child.  Both files are close-on-exec, but dup2() clears
+      // that flag on the copies.
+      dup2(request_fd, STDIN_FILENO);
+      dup2(response_fd, STDOUT_FILENO);
+      ExecChild(argv, search_mode_);
+    }
+  }
+  free(argv[0]);
+  close(request_fd);
+
+  int status = WaitForChild(child_pid_);
+  if (!CheckExitStatus(status, error)) {
+    close(response_fd);
+    return false;
+  }
+
+  bool parsed = ParseFromMappedFile(response_fd, output);
+  close(response_fd);
+  if (!parsed) {
+    *error = "Plugin output is unparseable.";
+    return false;
+  }
+
+  return true;
+}
+
 #endif  // !_WIN32
 
 }  // namespace compiler
@@ -67,6 +67,12 @@ class PROTOC_EXPORT Subprocess {
     EXACT_NAME    // Program is an exact file name; don't use the PATH.
   };
 
+  // Pass the request and response through unlinked temporary files, mapped
+  // into memory, instead of pipes.  The child is then started by
+  // Communicate() once its request is written.  Must be called before
+  // Start().  Has no effect on Windows.
+  void EnableSharedMemoryTransport() { shared_memory_ = true; }
+
   // Start the subprocess.  Currently we don't provide a way to specify
   // arguments as protoc plugins don't have any.
   void Start(const std::string& program, SearchMode search_mode);
@@ -85,6 +91,8 @@ class PROTOC_EXPORT Subprocess {
 #endif
 
  private:
+  bool shared_memory_ = false;
+
 #ifdef _WIN32
   DWORD process_start_error_;
   HANDLE child_handle_;
@@ -102,6 +110,13 @@ class PROTOC_EXPORT Subprocess {
   int child_stdin_;
   int child_stdout_;
 
+  // With the shared memory transport, the program to start in Communicate().
+  std::string program_;
+  SearchMode search_mode_ = SEARCH_PATH;
+
+  bool CommunicateThroughFiles(const Message& input, Message* output,
+                               std::string* error);
+
 #endif  // !_WIN32
 };
 
@@ -36,9 +36,14 @@
 #include "google/protobuf/compiler/zip_writer.h"
 
 #include <cstdint>
+#include <string>
 
 #include "google/protobuf/io/coded_stream.h"
 
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 namespace google {
 namespace protobuf {
 namespace compiler {
@@ -47,6 +52,17 @@ namespace compiler {
 // see https://msdn.microsoft.com/en-us/library/9kkf9tah.aspx
 static const uint16_t kDosEpoch = 1 << 5 | 1;
 
+// Compression methods.
+static const uint16_t kStored = 0;
+static const uint16_t kDeflated = 8;
+
+// The version needed to extract an entry, in the format of the
+// "version made by" field: 1.0 for stored data, 2.0 for deflate.
+static uint16_t VersionNeeded(uint16_t method) {
+  return method == kDeflated ? 20 : 10;
+}
+
+#if !HAVE_ZLIB
 static const uint32_t kCRC32Table[256] = {
     0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
     0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
@@ -100,6 +116,7 @@ static uint32_t ComputeCRC32(const std::string& buf) {
   }
   return ~x;
 }
+#endif  // !HAVE_ZLIB
 
 static void WriteShort(io::CodedOutputStream* out, uint16_t val) {
   uint8_t p[2];
@@ -108,37 +125,89 @@ static void WriteShort(io::CodedOutputStream* out, uint16_t val) {
   out->WriteRaw(p, 2);
 }
 
+#if HAVE_ZLIB
+// Deflates `contents` into `data` as a raw deflate stream.  Returns false if
+// that fails or does not make the data smaller.
+static bool Deflate(const std::string& contents, std::string* data) {
+  z_stream zcontext;
+  zcontext.zalloc = Z_NULL;
+  zcontext.zfree = Z_NULL;
+  zcontext.opaque = Z_NULL;
+  // Negative windowBits: no zlib header or trailer, as zip requires.
+  if (deflateInit2(&zcontext, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15,
+                   /* memLevel (default) */ 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  data->resize(deflateBound(&zcontext, contents.size()));
+  zcontext.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(contents.data()));
+  zcontext.avail_in = contents.size();
+  zcontext.next_out = reinterpret_cast<Bytef*>(&(*data)[0]);
+  zcontext.avail_out = data->size();
+  // The output holds deflateBound() bytes, so one call finishes the stream.
+  const bool finished = deflate(&zcontext, Z_FINISH) == Z_STREAM_END;
+  data->resize(zcontext.total_out);
+  deflateEnd(&zcontext);
+  return finished && data->size() < contents.size();
+}
+#endif  // HAVE_ZLIB
+
 ZipWriter::ZipWriter(io::ZeroCopyOutputStream* raw_output)
     : raw_output_(raw_output) {}
 ZipWriter::~ZipWriter() {}
 
+ZipWriter::Entry ZipWriter::PrepareEntry(const std::string& contents) {
+  Entry entry;
+  entry.size = contents.size();
+#if HAVE_ZLIB
+  entry.crc32 = crc32(crc32(0, Z_NULL, 0),
+                      reinterpret_cast<const Bytef*>(contents.data()),
+                      contents.size());
+  if (Deflate(contents, &entry.data)) {
+    entry.method = kDeflated;
+    return entry;
+  }
+#else
+  entry.crc32 = ComputeCRC32(contents);
+#endif
+  entry.method = kStored;
+  entry.data = contents;
+  return entry;
+}
+
 bool ZipWriter::Write(const std::string& filename,
                       const std::string& contents) {
+  return WriteEntry(filename, PrepareEntry(contents));
+}
+
+bool ZipWriter::WriteEntry(const std::string& filename, const Entry& entry) {
   FileInfo info;
 
   info.name = filename;
   uint16_t filename_size = filename.size();
   info.offset = raw_output_->ByteCount();
-  info.size = contents.size();
-  info.crc32 = ComputeCRC32(contents);
+  info.method = entry.method;
+  info.size = entry.size;
+  info.compressed_size = entry.data.size();
+  info.crc32 = entry.crc32;
 
   files_.push_back(info);
 
   // write file header
   io::CodedOutputStream output(raw_output_);
   output.WriteLittleEndian32(0x04034b50);  // magic
-  WriteShort(&output, 10);                 // version needed to extract
-  WriteShort(&output, 0);                  // flags
-  WriteShort(&output, 0);                  // compression method: stored
+  WriteShort(&output, VersionNeeded(info.method));  // version needed
+  WriteShort(&output, 0);                           // flags
+  WriteShort(&output, info.method);                 // compression method
   WriteShort(&output, 0);                  // last modified time
   WriteShort(&output, kDosEpoch);          // last modified date
   output.WriteLittleEndian32(info.crc32);  // crc-32
-  output.WriteLittleEndian32(info.size);   // compressed size
-  output.WriteLittleEndian32(info.size);   // uncompressed size
+  output.WriteLittleEndian32(info.compressed_size);  // compressed size
+  output.WriteLittleEndian32(info.size);             // uncompressed size
   WriteShort(&output, filename_size);      // file name length
   WriteShort(&output, 0);                  // extra field length
   output.WriteString(filename);            // file name
-  output.WriteString(contents);            // file data
+  output.WriteString(entry.data);          // file data
 
   return !output.HadError();
 }
@@ -152,20 +221,22 @@ bool ZipWriter::WriteDirectory() {
   for (int i = 0; i < num_entries; ++i) {
     const std::string& filename = files_[i].name;
     uint16_t filename_size = filename.size();
+    uint16_t method = files_[i].method;
     uint32_t crc32 = files_[i].crc32;
     uint32_t size = files_[i].size;
+    uint32_t compressed_size = files_[i].compressed_size;
     uint32_t offset = files_[i].offset;
 
-    output.WriteLittleEndian32(0x02014b50);  // magic
-    WriteShort(&output, 10);                 // version made by
-    WriteShort(&output, 10);                 // version needed to extract
-    WriteShort(&output, 0);                  // flags
-    WriteShort(&output, 0);                  // compression method: stored
+    output.WriteLittleEndian32(0x02014b50);     // magic
+    WriteShort(&output, VersionNeeded(method));  // version made by
+    WriteShort(&output, VersionNeeded(method));  // version needed to extract
+    WriteShort(&output, 0);                      // flags
+    WriteShort(&output, method);                 // compression method
     WriteShort(&output, 0);                  // last modified time
     WriteShort(&output, kDosEpoch);          // last modified date
     output.WriteLittleEndian32(crc32);       // crc-32
-    output.WriteLittleEndian32(size);        // compressed size
-    output.WriteLittleEndian32(size);        // uncompressed size
+    output.WriteLittleEndian32(compressed_size);  // compressed size
+    output.WriteLittleEndian32(size);             // uncompressed size
     WriteShort(&output, filename_size);      // file name length
     WriteShort(&output, 0);                  // extra field length
     WriteShort(&output, 0);                  // file comment length
@@ -33,6 +33,7 @@
 #define GOOGLE_PROTOBUF_COMPILER_ZIP_WRITER_H__
 
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "google/protobuf/stubs/common.h"
@@ -47,14 +48,31 @@ class ZipWriter {
   ZipWriter(io::ZeroCopyOutputStream* raw_output);
   ~ZipWriter();
 
+  // The data of one archive entry: deflated if zlib is available and that
+  // makes it smaller, stored otherwise.
+  struct Entry {
+    uint16_t method;
+    uint32_t size;
+    uint32_t crc32;
+    std::string data;
+  };
+
+  // Compresses `contents` for an entry.  This is most of the cost of writing
+  // an entry and does not touch any ZipWriter, so callers may prepare
+  // several entries on different threads.
+  static Entry PrepareEntry(const std::string& contents);
+
   bool Write(const std::string& filename, const std::string& contents);
+  bool WriteEntry(const std::string& filename, const Entry& entry);
   bool WriteDirectory();
 
  private:
   struct FileInfo {
     std::string name;
     uint32_t offset;
+    uint16_t method;
     uint32_t size;
+    uint32_t compressed_size;
     uint32_t crc32;
   };
 
@@ -36,6 +36,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstdlib>
 #include <functional>
 #include <iterator>
@@ -69,6 +70,8 @@
 #include "absl/strings/strip.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "google/protobuf/any.h"
 #include "google/protobuf/descriptor.pb.h"
@@ -259,6 +262,13 @@ using IntT = int;
 template <typename T>
 using PointerT = T*;
 
+// Memory used by an object stored in a FlatAllocation, including sizeof(T).
+// Defined below, once the types are complete.
+inline size_t ElementSpaceUsedLong(char) { return sizeof(char); }
+size_t ElementSpaceUsedLong(const std::string& str);
+size_t ElementSpaceUsedLong(const Message& message);
+size_t ElementSpaceUsedLong(const FileDescriptorTables& tables);
+
 // Manages an allocation of sequential arrays of type `T...`.
 // It is more space efficient than storing N (ptr, size) pairs, by storing only
 // the pointer to the head and the boundaries between the arrays.
@@ -289,6 +299,13 @@ class FlatAllocation {
     return out;
   }
 
+  // The size of the allocation plus any memory owned by the objects in it.
+  size_t SpaceUsedLong() const {
+    size_t total = total_bytes();
+    Fold({(total += SpaceUsedExcludingSelf<T>())...});
+    return total;
+  }
+
 
  private:
   // Total number of bytes used by all arrays.
@@ -346,6 +363,17 @@ class FlatAllocation {
     return true;
   }
 
+  template <typename U>
+  size_t SpaceUsedExcludingSelf() const {
+    // The `char` block only holds trivial types.
+    if (std::is_same<U, char>::value) return 0;
+    size_t total = 0;
+    for (const U *it = Begin<U>(), *end = End<U>(); it != end; ++it) {
+      total += ElementSpaceUsedLong(*it) - sizeof(U);
+    }
+    return total;
+  }
+
   template <typename U>
   bool Destroy() {
     if (std::is_trivially_destructible<U>::value) return true;
@@ -657,6 +685,19 @@ class Symbol {
 
 #undef DEFINE_MEMBERS
 
+  // Wraps an object which is already in the symbol table of some pool.  Unlike
+  // the constructors above this does not write to the object, which may be
+  // shared with other threads.
+  template <typename T>
+  static Symbol Existing(const T* value) {
+    Symbol s;
+    s.ptr_ = value;
+    return s;
+  }
+  static Symbol Existing(const EnumValueDescriptor* value) {
+    return Existing(static_cast<const internal::SymbolBaseN<0>*>(value));
+  }
+
   Type type() const { return static_cast<Type>(ptr_->symbol_type_); }
   bool IsNull() const { return type() == NULL_SYMBOL; }
   bool IsType() const { return type() == MESSAGE || type() == ENUM; }
@@ -965,6 +1006,97 @@ struct SymbolByFullNameEq {
 using SymbolsByNameSet =
     absl::flat_hash_set<Symbol, SymbolByFullNameHash, SymbolByFullNameEq>;
 
+// An insert-only hash set of symbols which can be searched concurrently with a
+// single writer.  Pools which have a mutex publish their committed symbols
+// here so that lookups of symbols which have already been built do not need to
+// take the lock.
+//
+// Slots are filled with release stores and probed with acquire loads, so a
+// reader which finds a symbol also sees the fully built descriptor behind it.
+// Once the table is half full it is replaced by one twice as large.  Readers
+// may still be probing the old table, so it is kept until the set is
+// destroyed; in total this at most doubles the memory used.
+class PublishedSymbolSet {
+ public:
+  PublishedSymbolSet() = default;
+  PublishedSymbolSet(const PublishedSymbolSet&) = delete;
+  PublishedSymbolSet& operator=(const PublishedSymbolSet&) = delete;
+
+  // Returns a null Symbol if no symbol named `name` has been inserted.  Safe
+  // to call concurrently with Insert().
+  Symbol Find(absl::string_view name) const {
+    const Table* table = current_.load(std::memory_order_acquire);
+    if (table == nullptr) return Symbol();
+    for (size_t i = absl::HashOf(name) & table->mask;;
+         i = (i + 1) & table->mask) {
+      Symbol symbol = table->slots[i].load(std::memory_order_acquire);
+      if (symbol.IsNull() || symbol.full_name() == name) return symbol;
+    }
+  }
+
+  // Includes the tables which have been replaced but are kept for readers.
+  // Must not be called concurrently with Insert().
+  size_t SpaceUsedExcludingSelfLong() const {
+    size_t total = tables_.capacity() * sizeof(tables_[0]);
+    for (const auto& table : tables_) {
+      total += sizeof(*table) + (table->mask + 1) * sizeof(table->slots[0]);
+    }
+    return total;
+  }
+
+  // The symbol must not already be in the set.  Calls must be serialized.
+  void Insert(Symbol symbol) {
+    if (tables_.empty() || (size_ + 1) * 2 > tables_.back()->mask + 1) {
+      Grow();
+    }
+    InsertInto(*tables_.back(), symbol);
+    ++size_;
+  }
+
+ private:
+  struct Table {
+    explicit Table(size_t capacity)
+        : mask(capacity - 1), slots(new std::atomic<Symbol>[capacity]) {
+      for (size_t i = 0; i < capacity; ++i) {
+        slots[i].store(Symbol(), std::memory_order_relaxed);
+      }
+    }
+
+    size_t mask;
+    std::unique_ptr<std::atomic<Symbol>[]> slots;
+  };
+
+  static void InsertInto(Table& table, Symbol symbol) {
+    for (size_t i = absl::HashOf(symbol.full_name()) & table.mask;;
+         i = (i + 1) & table.mask) {
+      if (table.slots[i].load(std::memory_order_relaxed).IsNull()) {
+        table.slots[i].store(symbol, std::memory_order_release);
+        return;
+      }
+    }
+  }
+
+  void Grow() {
+    const size_t capacity =
+        tables_.empty() ? size_t{64} : 2 * (tables_.back()->mask + 1);
+    auto table = absl::make_unique<Table>(capacity);
+    if (!tables_.empty()) {
+      const Table& old = *tables_.back();
+      for (size_t i = 0; i <= old.mask; ++i) {
+        Symbol symbol = old.slots[i].load(std::memory_order_relaxed);
+        if (!symbol.IsNull()) InsertInto(*table, symbol);
+      }
+    }
+    current_.store(table.get(), std::memory_order_release);
+    tables_.push_back(std::move(table));
+  }
+
+  std::atomic<const Table*> current_{nullptr};
+  // Every table ever published; the last one is `current_`.
+  std::vector<std::unique_ptr<Table>> tables_;
+  size_t size_ = 0;
+};
+
 struct ParentNameQuery {
   std::pair<const void*, absl::string_view> query;
   std::pair<const void*, absl::string_view> parent_name_key() const {
@@ -1173,6 +1305,9 @@ class FileDescriptorTables {
   // we are going to roll back to the last checkpoint.
   void FinalizeTables();
 
+  // Memory owned by the tables, for DescriptorPool::SpaceUsedLong().
+  size_t SpaceUsedExcludingSelfLong() const;
+
  private:
   const void* FindParentForFieldsByMap(const FieldDescriptor* field) const;
   static void FieldsByLowercaseNamesLazyInitStatic(
@@ -1296,12 +1431,33 @@ class DescriptorPool::Tables {
   // set of extensions numbers from fallback_database_.
   absl::flat_hash_set<const Descriptor*> extensions_loaded_from_db_;
 
+  // Counters for DescriptorPool::GetDatabaseBuildStats().  Building a file
+  // from the database can recursively build others, so only the outermost
+  // build is timed.
+  DescriptorPool::DatabaseBuildStats database_build_stats_;
+  int database_build_depth_ = 0;
+
+  // Fingerprints of the FileDescriptorProtos of the files which
+  // DescriptorPool::BuildFilesReusing() built or reused, and the pools it
+  // reused files from, which are kept alive for them.
+  absl::flat_hash_map<const FileDescriptor*, uint64_t> file_fingerprints_;
+  std::vector<std::shared_ptr<const DescriptorPool>> reused_pools_;
+
+  // Options shared through InternOptions(), keyed by the default instance of
+  // their type and their serialized form.
+  using InternedOptionsKey = std::pair<const void*, std::string>;
+  absl::flat_hash_map<InternedOptionsKey, const Message*> interned_options_;
+
   // Maps type name to Descriptor::WellKnownType.  This is logically global
   // and const, but we make it a member here to simplify its construction and
   // destruction.  This only has 20-ish entries and is one per DescriptorPool,
   // so the overhead is small.
   absl::flat_hash_map<std::string, Descriptor::WellKnownType> well_known_types_;
 
+  // Makes committed symbols findable by FindPublishedSymbol().  Called by
+  // pools which have a mutex, before any symbols are added.
+  void EnableSymbolPublishing() { publish_symbols_ = true; }
+
   // -----------------------------------------------------------------
   // Finding items.
 
@@ -1309,6 +1465,13 @@ class DescriptorPool::Tables {
   // if not found.
   inline Symbol FindSymbol(absl::string_view key) const;
 
+  // Like FindSymbol(), but only finds committed symbols, and may be called
+  // without holding the pool's mutex.  Always returns a null Symbol unless
+  // EnableSymbolPublishing() has been called.
+  Symbol FindPublishedSymbol(absl::string_view key) const {
+    return published_symbols_.Find(key);
+  }
+
   // This implements the body of DescriptorPool::Find*ByName().  It should
   // really be a private method of DescriptorPool, but that would require
   // declaring Symbol in descriptor.h, which would drag all kinds of other
@@ -1333,6 +1496,17 @@ class DescriptorPool::Tables {
   bool AddFile(const FileDescriptor* file);
   bool AddExtension(const FieldDescriptor* field);
 
+  // Adds `file`, which was built by another pool, along with its symbols and
+  // extensions, so that it can be found in this one.  Returns false if any of
+  // them are already defined here.
+  bool AddFileBuiltElsewhere(const FileDescriptor* file);
+
+  // Returns a previously interned options message equal to `*options`, or
+  // interns `options` itself.  Descriptors with identical non-default
+  // options share one instance; the storage of a duplicate is released.
+  template <typename OptionsT>
+  const OptionsT* InternOptions(OptionsT* options);
+
   // -----------------------------------------------------------------
   // Allocating memory.
 
@@ -1355,6 +1529,9 @@ class DescriptorPool::Tables {
   internal::FlatAllocator::Allocation* CreateFlatAlloc(
       const TypeMap<IntT, T...>& sizes);
 
+  // Implements DescriptorPool::SpaceUsedLong().
+  size_t SpaceUsedLong() const;
+
 
  private:
   // All memory allocated in the pool.  Must be first as other objects can
@@ -1375,6 +1552,9 @@ class DescriptorPool::Tables {
       flat_allocs_;
 
   SymbolsByNameSet symbols_by_name_;
+  // The committed subset of symbols_by_name_, when publish_symbols_ is set.
+  PublishedSymbolSet published_symbols_;
+  bool publish_symbols_ = false;
   DescriptorsByNameSet<FileDescriptor> files_by_name_;
   ExtensionsGroupedByDescriptorMap extensions_;
 
@@ -1389,17 +1569,21 @@ class DescriptorPool::Tables {
           pending_files_before_checkpoint(
               tables->files_after_checkpoint_.size()),
           pending_extensions_before_checkpoint(
-              tables->extensions_after_checkpoint_.size()) {}
+              tables->extensions_after_checkpoint_.size()),
+          pending_options_before_checkpoint(
+              tables->options_after_checkpoint_.size()) {}
     int flat_allocations_before_checkpoint;
     int misc_allocations_before_checkpoint;
     int pending_symbols_before_checkpoint;
     int pending_files_before_checkpoint;
     int pending_extensions_before_checkpoint;
+    int pending_options_before_checkpoint;
   };
   std::vector<CheckPoint> checkpoints_;
   std::vector<Symbol> symbols_after_checkpoint_;
   std::vector<const FileDescriptor*> files_after_checkpoint_;
   std::vector<std::pair<const Descriptor*, int>> extensions_after_checkpoint_;
+  std::vector<std::pair<const void*, const Message*>> options_after_checkpoint_;
 };
 
 DescriptorPool::Tables::Tables() {
@@ -1448,9 +1632,15 @@ void DescriptorPool::Tables::ClearLastCheckpoint() {
   if (checkpoints_.empty()) {
     // All checkpoints have been cleared: we can now commit all of the pending
     // data.
+    if (publish_symbols_) {
+      for (Symbol symbol : symbols_after_checkpoint_) {
+        published_symbols_.Insert(symbol);
+      }
+    }
     symbols_after_checkpoint_.clear();
     files_after_checkpoint_.clear();
     extensions_after_checkpoint_.clear();
+    options_after_checkpoint_.clear();
   }
 }
 
@@ -1470,12 +1660,21 @@ void DescriptorPool::Tables::RollbackToLastCheckpoint() {
        i < extensions_after_checkpoint_.size(); i++) {
     extensions_.erase(extensions_after_checkpoint_[i]);
   }
+  // The interned messages are still alive here: they are only freed along
+  // with their flat allocation below.
+  for (size_t i = checkpoint.pending_options_before_checkpoint;
+       i < options_after_checkpoint_.size(); i++) {
+    interned_options_.erase(InternedOptionsKey(
+        options_after_checkpoint_[i].first,
+        options_after_checkpoint_[i].second->SerializeAsString()));
+  }
 
   symbols_after_checkpoint_.resize(
       checkpoint.pending_symbols_before_checkpoint);
   files_after_checkpoint_.resize(checkpoint.pending_files_before_checkpoint);
   extensions_after_checkpoint_.resize(
       checkpoint.pending_extensions_before_checkpoint);
+  options_after_checkpoint_.resize(checkpoint.pending_options_before_checkpoint);
 
   flat_allocs_.resize(checkpoint.flat_allocations_before_checkpoint);
   misc_allocs_.resize(checkpoint.misc_allocations_before_checkpoint);
@@ -1498,10 +1697,16 @@ inline Symbol FileDescriptorTables::FindNestedSymbol(
 Symbol DescriptorPool::Tables::FindByNameHelper(const DescriptorPool* pool,
                                                 absl::string_view name) {
   if (pool->mutex_ != nullptr) {
+    // Fastest path: the Symbol has already been built and committed, so it can
+    // be found without locking.  Skipping the reset of the known-bad sets below
+    // is fine since nothing is loaded from the fallback database.
+    Symbol result = FindPublishedSymbol(name);
+    if (!result.IsNull()) return result;
+
     // Fast path: the Symbol is already cached.  This is just a hash lookup.
     absl::ReaderMutexLock lock(pool->mutex_);
     if (known_bad_symbols_.empty() && known_bad_files_.empty()) {
-      Symbol result = FindSymbol(name);
+      result = FindSymbol(name);
       if (!result.IsNull()) return result;
     }
   }
@@ -1735,8 +1940,81 @@ bool DescriptorPool::Tables::AddFile(const FileDescriptor* file) {
   }
 }
 
+template <typename OptionsT>
+const OptionsT* DescriptorPool::Tables::InternOptions(OptionsT* options) {
+  const void* type_key = &OptionsT::default_instance();
+  auto it_inserted = interned_options_.try_emplace(
+      InternedOptionsKey(type_key, options->SerializeAsString()), options);
+  if (it_inserted.second) {
+    options_after_checkpoint_.emplace_back(type_key, options);
+    return options;
+  }
+  // Nothing points at the duplicate any more, but it is only destroyed with
+  // its flat allocation, so give up whatever it owns now.
+  OptionsT().Swap(options);
+  return DownCast<const OptionsT*>(it_inserted.first->second);
+}
+
 void FileDescriptorTables::FinalizeTables() {}
 
+namespace {
+
+// Estimates the memory owned by a hash container: its slots, plus one control
+// byte per slot.  Memory owned by the elements themselves is not included.
+template <typename Container>
+size_t HashTableSpaceUsedExcludingSelfLong(const Container& container) {
+  return container.capacity() *
+         (sizeof(typename Container::value_type) + 1);
+}
+
+template <typename T>
+size_t VectorSpaceUsedExcludingSelfLong(const std::vector<T>& vector) {
+  return vector.capacity() * sizeof(T);
+}
+
+size_t StringSetSpaceUsedExcludingSelfLong(
+    const absl::flat_hash_set<std::string>& set) {
+  size_t total = HashTableSpaceUsedExcludingSelfLong(set);
+  for (const std::string& str : set) {
+    total += internal::StringSpaceUsedExcludingSelfLong(str);
+  }
+  return total;
+}
+
+size_t ElementSpaceUsedLong(const std::string& str) {
+  return sizeof(str) + internal::StringSpaceUsedExcludingSelfLong(str);
+}
+
+size_t ElementSpaceUsedLong(const Message& message) {
+  return message.SpaceUsedLong();
+}
+
+size_t ElementSpaceUsedLong(const FileDescriptorTables& tables) {
+  return sizeof(tables) + tables.SpaceUsedExcludingSelfLong();
+}
+
+}  // namespace
+
+size_t FileDescriptorTables::SpaceUsedExcludingSelfLong() const {
+  size_t total = HashTableSpaceUsedExcludingSelfLong(symbols_by_parent_) +
+                 HashTableSpaceUsedExcludingSelfLong(fields_by_number_) +
+                 HashTableSpaceUsedExcludingSelfLong(enum_values_by_number_);
+  for (const auto* map :
+       {fields_by_lowercase_name_.load(std::memory_order_acquire),
+        fields_by_camelcase_name_.load(std::memory_order_acquire)}) {
+    if (map != nullptr) {
+      total += sizeof(*map) + HashTableSpaceUsedExcludingSelfLong(*map);
+    }
+  }
+  {
+    absl::ReaderMutexLock lock(&unknown_enum_values_mu_);
+    total += HashTableSpaceUsedExcludingSelfLong(unknown_enum_values_by_number_);
+  }
+  // locations_by_path_ is left out: it may be being built by another thread,
+  // and only exists once source locations have been looked up.
+  return total;
+}
+
 bool FileDescriptorTables::AddFieldByNumber(FieldDescriptor* field) {
   // Skip fields that are at the start of the sequence.
   if (field->containing_type() != nullptr && field->number() >= 1 &&
@@ -1809,6 +2087,37 @@ internal::FlatAllocator::Allocation* DescriptorPool::Tables::CreateFlatAlloc(
   return res;
 }
 
+size_t DescriptorPool::Tables::SpaceUsedLong() const {
+  size_t total = sizeof(*this);
+  for (const auto& alloc : flat_allocs_) total += alloc->SpaceUsedLong();
+  for (const auto& alloc : misc_allocs_) {
+    total += *alloc + RoundUpTo<8>(sizeof(int));
+  }
+  total += VectorSpaceUsedExcludingSelfLong(flat_allocs_) +
+           VectorSpaceUsedExcludingSelfLong(misc_allocs_);
+
+  total += HashTableSpaceUsedExcludingSelfLong(symbols_by_name_) +
+           published_symbols_.SpaceUsedExcludingSelfLong() +
+           HashTableSpaceUsedExcludingSelfLong(files_by_name_) +
+           // Ignores the btree's per-node overhead.
+           extensions_.size() *
+               sizeof(ExtensionsGroupedByDescriptorMap::value_type) +
+           HashTableSpaceUsedExcludingSelfLong(extensions_loaded_from_db_) +
+           StringSetSpaceUsedExcludingSelfLong(known_bad_files_) +
+           StringSetSpaceUsedExcludingSelfLong(known_bad_symbols_) +
+           HashTableSpaceUsedExcludingSelfLong(file_fingerprints_) +
+           VectorSpaceUsedExcludingSelfLong(reused_pools_);
+  for (const auto& entry : interned_options_) {
+    total += internal::StringSpaceUsedExcludingSelfLong(entry.first.second);
+  }
+  total += HashTableSpaceUsedExcludingSelfLong(interned_options_);
+  for (const auto& entry : well_known_types_) {
+    total += internal::StringSpaceUsedExcludingSelfLong(entry.first);
+  }
+  total += HashTableSpaceUsedExcludingSelfLong(well_known_types_);
+  return total;
+}
+
 void FileDescriptorTables::BuildLocationsByPath(
     std::pair<const FileDescriptorTables*, const SourceCodeInfo*>* p) {
   for (int i = 0, len = p->second->location_size(); i < len; ++i) {
@@ -1890,7 +2199,9 @@ DescriptorPool::DescriptorPool(DescriptorDatabase* fallback_database,
       enforce_weak_(false),
       enforce_extension_declarations_(false),
       disallow_enforce_utf8_(false),
-      deprecated_legacy_json_field_conflicts_(false) {}
+      deprecated_legacy_json_field_conflicts_(false) {
+  tables_->EnableSymbolPublishing();
+}
 
 DescriptorPool::DescriptorPool(const DescriptorPool* underlay)
     : mutex_(nullptr),
@@ -1910,6 +2221,69 @@ DescriptorPool::~DescriptorPool() {
   if (mutex_ != nullptr) delete mutex_;
 }
 
+size_t DescriptorPool::SpaceUsedLong() const {
+  absl::MutexLockMaybe lock(mutex_);
+  size_t total = sizeof(*this) + tables_->SpaceUsedLong();
+  if (mutex_ != nullptr) total += sizeof(*mutex_);
+  return total;
+}
+
+DescriptorPool::DatabaseBuildStats DescriptorPool::GetDatabaseBuildStats()
+    const {
+  absl::MutexLockMaybe lock(mutex_);
+  return tables_->database_build_stats_;
+}
+
+namespace {
+
+// Forces everything a lazily built file resolves on first use: its
+// dependencies, and the types referred to by its fields and methods.
+void ResolveLazyParts(const Descriptor* message) {
+  for (int i = 0; i < message->field_count(); ++i) {
+    message->field(i)->type();
+  }
+  for (int i = 0; i < message->extension_count(); ++i) {
+    message->extension(i)->type();
+  }
+  for (int i = 0; i < message->nested_type_count(); ++i) {
+    ResolveLazyParts(message->nested_type(i));
+  }
+}
+
+void ResolveLazyParts(const FileDescriptor* file,
+                      absl::flat_hash_set<const FileDescriptor*>* seen) {
+  if (file == nullptr || !seen->insert(file).second) return;
+  for (int i = 0; i < file->dependency_count(); ++i) {
+    ResolveLazyParts(file->dependency(i), seen);
+  }
+  for (int i = 0; i < file->message_type_count(); ++i) {
+    ResolveLazyParts(file->message_type(i));
+  }
+  for (int i = 0; i < file->extension_count(); ++i) {
+    file->extension(i)->type();
+  }
+  for (int i = 0; i < file->service_count(); ++i) {
+    const ServiceDescriptor* service = file->service(i);
+    for (int j = 0; j < service->method_count(); ++j) {
+      service->method(j)->input_type();
+      service->method(j)->output_type();
+    }
+  }
+}
+
+}  // namespace
+
+void DescriptorPool::PrefetchFilesAsync(
+    std::vector<std::string> file_names,
+    const std::function<void(std::function<void()>)>& executor) const {
+  for (std::string& name : file_names) {
+    executor([this, name = std::move(name)] {
+      absl::flat_hash_set<const FileDescriptor*> seen;
+      ResolveLazyParts(FindFileByName(name), &seen);
+    });
+  }
+}
+
 // DescriptorPool::BuildFile() defined later.
 // DescriptorPool::BuildFileCollectingErrors() defined later.
 
@@ -1996,7 +2370,10 @@ void DescriptorPool::InternalAddGeneratedFile(
   // Therefore, when we parse one, we have to be very careful to avoid using
   // any descriptor-based operations, since this might cause infinite recursion
   // or deadlock.
-  ABSL_CHECK(GeneratedDatabase()->Add(encoded_file_descriptor, size));
+  //
+  // Even indexing the file's symbols means parsing it, so that is deferred as
+  // well, to the first lookup in the generated database.
+  GeneratedDatabase()->AddDeferred(encoded_file_descriptor, size);
 }
 
 
@@ -2211,7 +2588,47 @@ void DescriptorPool::FindAllExtensions(
 
 // -------------------------------------------------------------------
 
+namespace {
+
+// Messages with at most this many fields are searched by scanning their fields
+// rather than through the file's lookup tables: comparing a few names is
+// cheaper than hashing the (parent, name) key and probing a table shared by
+// the whole file.  For lowercase and camelcase names it also avoids building
+// the file's lazily initialized maps.
+constexpr int kMaxFieldsToScan = 4;
+
+// Returns the first of `fields` for which `get` returns `key`.
+const FieldDescriptor* ScanFields(const FieldDescriptor* fields, int count,
+                                  int (FieldDescriptor::*get)() const,
+                                  int key) {
+  for (int i = 0; i < count; ++i) {
+    if ((fields[i].*get)() == key) return &fields[i];
+  }
+  return nullptr;
+}
+const FieldDescriptor* ScanFields(
+    const FieldDescriptor* fields, int count,
+    const std::string& (FieldDescriptor::*get)() const,
+    absl::string_view key) {
+  if (key.empty()) return nullptr;
+  for (int i = 0; i < count; ++i) {
+    const std::string& name = (fields[i].*get)();
+    // Names often share a prefix, so check the last character before
+    // comparing the whole name.
+    if (name.size() == key.size() && name.back() == key.back() &&
+        memcmp(name.data(), key.data(), key.size()) == 0) {
+      return &fields[i];
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
 const FieldDescriptor* Descriptor::FindFieldByNumber(int key) const {
+  if (field_count_ <= kMaxFieldsToScan) {
+    return ScanFields(fields_, field_count_, &FieldDescriptor::number, key);
+  }
   const FieldDescriptor* result = file()->tables_->FindFieldByNumber(this, key);
   if (result == nullptr || result->is_extension()) {
     return nullptr;
@@ -2222,6 +2639,9 @@ const FieldDescriptor* Descriptor::FindFieldByNumber(int key) const {
 
 const FieldDescriptor* Descriptor::FindFieldByLowercaseName(
     absl::string_view key) const {
+  if (field_count_ <= kMaxFieldsToScan) {
+    return ScanFields(fields_, field_count_, &FieldDescriptor::lowercase_name, key);
+  }
   const FieldDescriptor* result =
       file()->tables_->FindFieldByLowercaseName(this, key);
   if (result == nullptr || result->is_extension()) {
@@ -2233,6 +2653,9 @@ const FieldDescriptor* Descriptor::FindFieldByLowercaseName(
 
 const FieldDescriptor* Descriptor::FindFieldByCamelcaseName(
     absl::string_view key) const {
+  if (field_count_ <= kMaxFieldsToScan) {
+    return ScanFields(fields_, field_count_, &FieldDescriptor::camelcase_name, key);
+  }
   const FieldDescriptor* result =
       file()->tables_->FindFieldByCamelcaseName(this, key);
   if (result == nullptr || result->is_extension()) {
@@ -2244,6 +2667,9 @@ const FieldDescriptor* Descriptor::FindFieldByCamelcaseName(
 
 const FieldDescriptor* Descriptor::FindFieldByName(
     absl::string_view key) const {
+  if (field_count_ <= kMaxFieldsToScan) {
+    return ScanFields(fields_, field_count_, &FieldDescriptor::name, key);
+  }
   const FieldDescriptor* field =
       file()->tables_->FindNestedSymbol(this, key).field_descriptor();
   return field != nullptr && !field->is_extension() ? field : nullptr;
@@ -4017,6 +4443,14 @@ class DescriptorBuilder {
   void LogUnusedDependency(const FileDescriptorProto& proto,
                            const FileDescriptor* result);
 
+  // Shares the options of every descriptor in a successfully built file with
+  // the identical ones already in the pool.  Must be run after options have
+  // been interpreted.
+  void InternFileOptions(FileDescriptor* file);
+  void InternMessageOptions(Descriptor* message);
+  template <typename OptionsT>
+  void InternOptions(const OptionsT*& options);
+
   // Must be run only after building.
   //
   // NOTE: Options will not be available during cross-linking, as they
@@ -4282,17 +4716,226 @@ const FileDescriptor* DescriptorPool::BuildFileCollectingErrors(
       ->BuildFile(proto);
 }
 
+std::vector<const FileDescriptor*> DescriptorPool::BuildFiles(
+    absl::Span<const FileDescriptorProto* const> protos) {
+  return BuildFilesCollectingErrors(protos, nullptr);
+}
+
+std::vector<const FileDescriptor*> DescriptorPool::BuildFilesCollectingErrors(
+    absl::Span<const FileDescriptorProto* const> protos,
+    ErrorCollector* error_collector) {
+  return BuildFilesInternal(protos, error_collector, false, nullptr);
+}
+
+std::vector<const FileDescriptor*> DescriptorPool::BuildFilesReusing(
+    absl::Span<const FileDescriptorProto* const> protos,
+    std::shared_ptr<const DescriptorPool> previous) {
+  std::vector<const FileDescriptor*> result =
+      BuildFilesInternal(protos, nullptr, true, previous.get());
+  if (!result.empty() && previous != nullptr) {
+    tables_->reused_pools_.push_back(std::move(previous));
+  }
+  return result;
+}
+
+namespace {
+
+uint64_t FingerprintFileProto(const FileDescriptorProto& proto) {
+  return absl::HashOf(proto.SerializeAsString());
+}
+
+}  // namespace
+
+bool DescriptorPool::Tables::AddFileBuiltElsewhere(
+    const FileDescriptor* file) {
+  if (!AddFile(file)) return false;
+
+  // Add the package and any of its parents which are not known yet.
+  absl::string_view package = file->package();
+  while (!package.empty()) {
+    Symbol existing = FindSymbol(package);
+    if (!existing.IsNull()) {
+      if (!existing.IsPackage()) return false;
+      break;
+    }
+    auto* subpackage = Allocate<Symbol::Subpackage>();
+    subpackage->name_size = static_cast<int>(package.size());
+    subpackage->file = file;
+    AddSymbol(package, Symbol(subpackage));
+    size_t dot_pos = package.rfind('.');
+    package = dot_pos == absl::string_view::npos ? absl::string_view()
+                                                 : package.substr(0, dot_pos);
+  }
+
+  bool ok = true;
+  auto add_symbol = [&](Symbol symbol) {
+    ok = ok && AddSymbol(symbol.full_name(), symbol);
+  };
+  auto add_enum = [&](const EnumDescriptor* enum_type) {
+    add_symbol(Symbol::Existing(enum_type));
+    for (int i = 0; i < enum_type->value_count(); ++i) {
+      add_symbol(Symbol::Existing(enum_type->value(i)));
+    }
+  };
+  auto add_extension = [&](const FieldDescriptor* extension) {
+    add_symbol(Symbol::Existing(extension));
+    ok = ok && AddExtension(extension);
+  };
+  std::vector<const Descriptor*> messages;
+  for (int i = 0; i < file->message_type_count(); ++i) {
+    messages.push_back(file->message_type(i));
+  }
+  while (!messages.empty()) {
+    const Descriptor* message = messages.back();
+    messages.pop_back();
+    add_symbol(Symbol::Existing(message));
+    for (int i = 0; i < message->field_count(); ++i) {
+      add_symbol(Symbol::Existing(message->field(i)));
+    }
+    for (int i = 0; i < message->oneof_decl_count(); ++i) {
+      add_symbol(Symbol::Existing(message->oneof_decl(i)));
+    }
+    for (int i = 0; i < message->enum_type_count(); ++i) {
+      add_enum(message->enum_type(i));
+    }
+    for (int i = 0; i < message->extension_count(); ++i) {
+      add_extension(message->extension(i));
+    }
+    for (int i = 0; i < message->nested_type_count(); ++i) {
+      messages.push_back(message->nested_type(i));
+    }
+  }
+  for (int i = 0; i < file->enum_type_count(); ++i) {
+    add_enum(file->enum_type(i));
+  }
+  for (int i = 0; i < file->extension_count(); ++i) {
+    add_extension(file->extension(i));
+  }
+  for (int i = 0; i < file->service_count(); ++i) {
+    const ServiceDescriptor* service = file->service(i);
+    add_symbol(Symbol::Existing(service));
+    for (int j = 0; j < service->method_count(); ++j) {
+      add_symbol(Symbol::Existing(service->method(j)));
+    }
+  }
+  return ok;
+}
+
+std::vector<const FileDescriptor*> DescriptorPool::BuildFilesInternal(
+    absl::Span<const FileDescriptorProto* const> protos,
+    ErrorCollector* error_collector, bool reusing,
+    const DescriptorPool* previous) {
+  ABSL_CHECK(fallback_database_ == nullptr)
+      << "Cannot call BuildFiles on a DescriptorPool that uses a "
+         "DescriptorDatabase.  You must instead find a way to get your files "
+         "into the underlying database.";
+  ABSL_CHECK(mutex_ == nullptr);  // Implied by the above ABSL_CHECK.
+  tables_->known_bad_symbols_.clear();
+  tables_->known_bad_files_.clear();
+
+  // Order the files so that each one comes after the files in the batch that
+  // it depends on.  Cycles are left for the builder to report.
+  absl::flat_hash_map<absl::string_view, int> index_by_name;
+  for (size_t i = 0; i < protos.size(); ++i) {
+    index_by_name.emplace(protos[i]->name(), static_cast<int>(i));
+  }
+  std::vector<int> order;
+  order.reserve(protos.size());
+  std::vector<bool> visited(protos.size(), false);
+  // Pairs of (file, index of the next dependency to visit).
+  std::vector<std::pair<int, int>> stack;
+  for (size_t root = 0; root < protos.size(); ++root) {
+    if (visited[root]) continue;
+    visited[root] = true;
+    stack.emplace_back(static_cast<int>(root), 0);
+    while (!stack.empty()) {
+      const int file = stack.back().first;
+      const int next = stack.back().second++;
+      if (next < protos[file]->dependency_size()) {
+        auto it = index_by_name.find(protos[file]->dependency(next));
+        if (it != index_by_name.end() && !visited[it->second]) {
+          visited[it->second] = true;
+          stack.emplace_back(it->second, 0);
+        }
+      } else {
+        order.push_back(file);
+        stack.pop_back();
+      }
+    }
+  }
+
+  // The outer checkpoint holds back the whole batch until every file has been
+  // built successfully.
+  std::vector<const FileDescriptor*> result(protos.size());
+  std::vector<uint64_t> fingerprints(reusing ? protos.size() : 0);
+  tables_->AddCheckpoint();
+  for (int i : order) {
+    if (reusing) fingerprints[i] = FingerprintFileProto(*protos[i]);
+    if (previous != nullptr) {
+      result[i] = ReuseFile(*previous, protos[i]->name(), fingerprints[i]);
+      if (result[i] != nullptr) continue;
+    }
+    result[i] = DescriptorBuilder::New(this, tables_.get(), error_collector)
+                    ->BuildFile(*protos[i]);
+    if (result[i] == nullptr) {
+      tables_->RollbackToLastCheckpoint();
+      return {};
+    }
+  }
+  tables_->ClearLastCheckpoint();
+  for (size_t i = 0; i < fingerprints.size(); ++i) {
+    tables_->file_fingerprints_[result[i]] = fingerprints[i];
+  }
+  return result;
+}
+
+const FileDescriptor* DescriptorPool::ReuseFile(const DescriptorPool& previous,
+                                                absl::string_view name,
+                                                uint64_t fingerprint) {
+  const FileDescriptor* file = previous.tables_->FindFile(name);
+  if (file == nullptr) return nullptr;
+  auto it = previous.tables_->file_fingerprints_.find(file);
+  if (it == previous.tables_->file_fingerprints_.end() ||
+      it->second != fingerprint) {
+    return nullptr;
+  }
+  // The file's descriptors point at those of its dependencies, so these must
+  // not have been rebuilt.
+  for (int i = 0; i < file->dependency_count(); ++i) {
+    const FileDescriptor* dependency = file->dependency(i);
+    if (dependency == nullptr ||
+        FindFileByName(dependency->name()) != dependency) {
+      return nullptr;
+    }
+  }
+  tables_->AddCheckpoint();
+  if (!tables_->AddFileBuiltElsewhere(file)) {
+    // Something conflicts; building the file will report what.
+    tables_->RollbackToLastCheckpoint();
+    return nullptr;
+  }
+  tables_->ClearLastCheckpoint();
+  return file;
+}
+
 const FileDescriptor* DescriptorPool::BuildFileFromDatabase(
     const FileDescriptorProto& proto) const {
   mutex_->AssertHeld();
   if (tables_->known_bad_files_.contains(proto.name())) {
     return nullptr;
   }
+  const absl::Time start =
+      tables_->database_build_depth_++ == 0 ? absl::Now() : absl::Time();
   const FileDescriptor* result =
       DescriptorBuilder::New(this, tables_.get(), default_error_collector_)
           ->BuildFile(proto);
+  if (--tables_->database_build_depth_ == 0) {
+    tables_->database_build_stats_.build_time += absl::Now() - start;
+  }
   if (result == nullptr) {
     tables_->known_bad_files_.insert(proto.name());
+  } else {
+    ++tables_->database_build_stats_.files_built;
   }
   return result;
 }
@@ -5502,8 +6145,65 @@ FileDescriptor* DescriptorBuilder::BuildFileImpl(
 
   if (had_errors_) {
     return nullptr;
-  } else {
-    return result;
+  }
+  InternFileOptions(result);
+  return result;
+}
+
+template <typename OptionsT>
+void DescriptorBuilder::InternOptions(const OptionsT*& options) {
+  // Default options are already shared.
+  if (options == &OptionsT::default_instance()) return;
+  options = tables_->InternOptions(const_cast<OptionsT*>(options));
+}
+
+void DescriptorBuilder::InternFileOptions(FileDescriptor* file) {
+  InternOptions(file->options_);
+  for (int i = 0; i < file->message_type_count(); ++i) {
+    InternMessageOptions(&file->message_types_[i]);
+  }
+  for (int i = 0; i < file->enum_type_count(); ++i) {
+    EnumDescriptor* enum_type = &file->enum_types_[i];
+    InternOptions(enum_type->options_);
+    for (int j = 0; j < enum_type->value_count(); ++j) {
+      InternOptions(enum_type->values_[j].options_);
+    }
+  }
+  for (int i = 0; i < file->extension_count(); ++i) {
+    InternOptions(file->extensions_[i].options_);
+  }
+  for (int i = 0; i < file->service_count(); ++i) {
+    ServiceDescriptor* service = &file->services_[i];
+    InternOptions(service->options_);
+    for (int j = 0; j < service->method_count(); ++j) {
+      InternOptions(service->methods_[j].options_);
+    }
+  }
+}
+
+void DescriptorBuilder::InternMessageOptions(Descriptor* message) {
+  InternOptions(message->options_);
+  for (int i = 0; i < message->field_count(); ++i) {
+    InternOptions(message->fields_[i].options_);
+  }
+  for (int i = 0; i < message->oneof_decl_count(); ++i) {
+    InternOptions(message->oneof_decls_[i].options_);
+  }
+  for (int i = 0; i < message->extension_range_count(); ++i) {
+    InternOptions(message->extension_ranges_[i].options_);
+  }
+  for (int i = 0; i < message->extension_count(); ++i) {
+    InternOptions(message->extensions_[i].options_);
+  }
+  for (int i = 0; i < message->nested_type_count(); ++i) {
+    InternMessageOptions(&message->nested_types_[i]);
+  }
+  for (int i = 0; i < message->enum_type_count(); ++i) {
+    EnumDescriptor* enum_type = &message->enum_types_[i];
+    InternOptions(enum_type->options_);
+    for (int j = 0; j < enum_type->value_count(); ++j) {
+      InternOptions(enum_type->values_[j].options_);
+    }
   }
 }
 
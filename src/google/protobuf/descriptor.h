@@ -56,6 +56,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <iterator>
 #include <memory>
 #include <string>
@@ -71,7 +72,9 @@
 #include "absl/log/absl_log.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "google/protobuf/port.h"
 
 // Must be included last.
@@ -2099,6 +2102,59 @@ class PROTOBUF_EXPORT DescriptorPool {
   const FileDescriptor* BuildFileCollectingErrors(
       const FileDescriptorProto& proto, ErrorCollector* error_collector);
 
+  // Builds a batch of files which may depend on each other, in any order, as
+  // well as on files already in the pool.  Each file is built after those of
+  // its dependencies which are in the batch.  Either every file is added to
+  // the pool, or, if any of them has problems, none are.  Returns the
+  // resulting FileDescriptors in the same order as `protos`, or an empty
+  // vector on failure.  Errors are written to ABSL_LOG(ERROR).
+  std::vector<const FileDescriptor*> BuildFiles(
+      absl::Span<const FileDescriptorProto* const> protos);
+
+  // Same as BuildFiles() except errors are sent to the given ErrorCollector.
+  std::vector<const FileDescriptor*> BuildFilesCollectingErrors(
+      absl::Span<const FileDescriptorProto* const> protos,
+      ErrorCollector* error_collector);
+
+  // Like BuildFiles(), but for reloading a schema which was previously built
+  // in `previous`.  Files whose FileDescriptorProto is identical to one that
+  // `previous` built or reused through this method, and whose dependencies
+  // are still the same FileDescriptors, are not built again: this pool finds
+  // the FileDescriptors of `previous` instead.  Reloading a schema so costs
+  // time and memory in proportion to the files which changed and the files
+  // which depend on them.  Reused descriptors keep reporting the pool which
+  // built them as their pool(); this pool keeps `previous` alive for them.
+  // `previous` must not be modified after it is passed here.
+  std::vector<const FileDescriptor*> BuildFilesReusing(
+      absl::Span<const FileDescriptorProto* const> protos,
+      std::shared_ptr<const DescriptorPool> previous);
+
+  // Returns an estimate of the number of bytes of memory used by this pool:
+  // the descriptors it has built, including their names and options, and the
+  // tables used to look them up.  The underlay and the fallback database, if
+  // any, are not included.
+  size_t SpaceUsedLong() const;
+
+  // Statistics about the files this pool has built from its fallback
+  // database, either because they were looked up or because a lazily built
+  // dependency was used for the first time.
+  struct DatabaseBuildStats {
+    int64_t files_built = 0;
+    // Wall time spent building those files.
+    absl::Duration build_time;
+  };
+  DatabaseBuildStats GetDatabaseBuildStats() const;
+
+  // Builds the named files from the fallback database ahead of their first
+  // use, along with their dependencies and the types they refer to, so that
+  // later lookups do not pay for building them even when dependencies are
+  // built lazily.  Each file is built by a task passed to `executor`, which may
+  // run it on any thread; the pool must outlive those tasks.  Files which are
+  // not found or fail to build are skipped.
+  void PrefetchFilesAsync(
+      std::vector<std::string> file_names,
+      const std::function<void(std::function<void()>)>& executor) const;
+
   // By default, it is an error if a FileDescriptorProto contains references
   // to types or other files that are not found in the DescriptorPool (or its
   // backing DescriptorDatabase, if any).  If you call
@@ -2145,6 +2201,10 @@ class PROTOBUF_EXPORT DescriptorPool {
   // bad design anyway.  So, instead, you could use generated_pool() as an
   // underlay for a new DescriptorPool in which you add only the new file.
   //
+  // Any number of pools may share one underlay, and nothing built in the
+  // underlay is copied into them.  To also share the underlay's dynamic
+  // message prototypes, see DynamicMessageFactory::SetUnderlayFactory().
+  //
   // WARNING:  Use of underlays can lead to many subtle gotchas.  Instead,
   //   try to formulate what you want to do in terms of DescriptorDatabases.
   explicit DescriptorPool(const DescriptorPool* underlay);
@@ -2250,6 +2310,20 @@ class PROTOBUF_EXPORT DescriptorPool {
   const FileDescriptor* BuildFileFromDatabase(
       const FileDescriptorProto& proto) const;
 
+  // Implements BuildFilesCollectingErrors() and, with `reusing` set,
+  // BuildFilesReusing().
+  std::vector<const FileDescriptor*> BuildFilesInternal(
+      absl::Span<const FileDescriptorProto* const> protos,
+      ErrorCollector* error_collector, bool reusing,
+      const DescriptorPool* previous);
+
+  // Adds the file named `name` in `previous` to this pool if it can be reused
+  // for a FileDescriptorProto with the given fingerprint, for
+  // BuildFilesReusing().  Returns nullptr if it cannot.
+  const FileDescriptor* ReuseFile(const DescriptorPool& previous,
+                                  absl::string_view name,
+                                  uint64_t fingerprint);
+
   // Helper for when lazily_build_dependencies_ is set, can look up a symbol
   // after the file's descriptor is built, and can build the file where that
   // symbol is defined if necessary. Will create a placeholder if the type
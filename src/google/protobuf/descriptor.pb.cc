@@ -12,6 +12,7 @@
 #include "google/protobuf/reflection_ops.h"
 #include "google/protobuf/wire_format.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
+#include "absl/numeric/bits.h"
 // @@protoc_insertion_point(includes)
 
 // Must be included last.
@@ -2054,6 +2055,8 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> FileDescriptorSet::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_FileDescriptorSet_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // repeated .google.protobuf.FileDescriptorProto file = 1;
     {::_pbi::TcParser::FastMtR1,
@@ -2079,6 +2082,7 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> FileDescriptorSet::_table_ = {
   // repeated .google.protobuf.FileDescriptorProto file = 1;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_file_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_file(), i);
     const auto& repfield = this->_internal_file().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(1, repfield, repfield.GetCachedSize(), target, stream);
@@ -2102,9 +2106,10 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> FileDescriptorSet::_table_ = {
 
   // repeated .google.protobuf.FileDescriptorProto file = 1;
   total_size += 1UL * this->_internal_file_size();
-  for (const auto& msg : this->_internal_file()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_file_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_file(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_file().Get(i));
   }
 
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
@@ -2129,6 +2134,20 @@ void FileDescriptorSet::MergeImpl(::google::protobuf::Message& to_msg, const ::g
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void FileDescriptorSet::MergeFrom(FileDescriptorSet&& from) {
+  FileDescriptorSet* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_file()->MergeFrom(
+      std::move(*from._internal_mutable_file()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const FileDescriptorSet&>(from));
+}
+
 void FileDescriptorSet::CopyFrom(const FileDescriptorSet& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.FileDescriptorSet)
   if (&from == this) return;
@@ -2373,6 +2392,8 @@ constexpr ::_pbi::TcParseTable<4, 13, 6, 86, 2> FileDescriptorProto::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_FileDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -2510,6 +2531,7 @@ constexpr ::_pbi::TcParseTable<4, 13, 6, 86, 2> FileDescriptorProto::_table_ = {
   // repeated .google.protobuf.DescriptorProto message_type = 4;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_message_type_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_message_type(), i);
     const auto& repfield = this->_internal_message_type().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(4, repfield, repfield.GetCachedSize(), target, stream);
@@ -2518,6 +2540,7 @@ constexpr ::_pbi::TcParseTable<4, 13, 6, 86, 2> FileDescriptorProto::_table_ = {
   // repeated .google.protobuf.EnumDescriptorProto enum_type = 5;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_enum_type_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_enum_type(), i);
     const auto& repfield = this->_internal_enum_type().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(5, repfield, repfield.GetCachedSize(), target, stream);
@@ -2526,6 +2549,7 @@ constexpr ::_pbi::TcParseTable<4, 13, 6, 86, 2> FileDescriptorProto::_table_ = {
   // repeated .google.protobuf.ServiceDescriptorProto service = 6;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_service_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_service(), i);
     const auto& repfield = this->_internal_service().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(6, repfield, repfield.GetCachedSize(), target, stream);
@@ -2534,6 +2558,7 @@ constexpr ::_pbi::TcParseTable<4, 13, 6, 86, 2> FileDescriptorProto::_table_ = {
   // repeated .google.protobuf.FieldDescriptorProto extension = 7;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_extension_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_extension(), i);
     const auto& repfield = this->_internal_extension().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(7, repfield, repfield.GetCachedSize(), target, stream);
@@ -2608,30 +2633,34 @@ constexpr ::_pbi::TcParseTable<4, 13, 6, 86, 2> FileDescriptorProto::_table_ = {
 
   // repeated .google.protobuf.DescriptorProto message_type = 4;
   total_size += 1UL * this->_internal_message_type_size();
-  for (const auto& msg : this->_internal_message_type()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_message_type_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_message_type(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_message_type().Get(i));
   }
 
   // repeated .google.protobuf.EnumDescriptorProto enum_type = 5;
   total_size += 1UL * this->_internal_enum_type_size();
-  for (const auto& msg : this->_internal_enum_type()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_enum_type_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_enum_type(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_enum_type().Get(i));
   }
 
   // repeated .google.protobuf.ServiceDescriptorProto service = 6;
   total_size += 1UL * this->_internal_service_size();
-  for (const auto& msg : this->_internal_service()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_service_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_service(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_service().Get(i));
   }
 
   // repeated .google.protobuf.FieldDescriptorProto extension = 7;
   total_size += 1UL * this->_internal_extension_size();
-  for (const auto& msg : this->_internal_extension()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_extension_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_extension(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_extension().Get(i));
   }
 
   // repeated int32 public_dependency = 10;
@@ -2748,6 +2777,28 @@ void FileDescriptorProto::MergeImpl(::google::protobuf::Message& to_msg, const :
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void FileDescriptorProto::MergeFrom(FileDescriptorProto&& from) {
+  FileDescriptorProto* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_dependency()->MergeFrom(
+      std::move(*from._internal_mutable_dependency()));
+  _this->_internal_mutable_message_type()->MergeFrom(
+      std::move(*from._internal_mutable_message_type()));
+  _this->_internal_mutable_enum_type()->MergeFrom(
+      std::move(*from._internal_mutable_enum_type()));
+  _this->_internal_mutable_service()->MergeFrom(
+      std::move(*from._internal_mutable_service()));
+  _this->_internal_mutable_extension()->MergeFrom(
+      std::move(*from._internal_mutable_extension()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const FileDescriptorProto&>(from));
+}
+
 void FileDescriptorProto::CopyFrom(const FileDescriptorProto& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.FileDescriptorProto)
   if (&from == this) return;
@@ -2916,6 +2967,8 @@ constexpr ::_pbi::TcParseTable<2, 3, 1, 0, 2> DescriptorProto_ExtensionRange::_t
     offsetof(decltype(_table_), aux_entries),
     &_DescriptorProto_ExtensionRange_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional int32 start = 1;
@@ -3035,11 +3088,19 @@ void DescriptorProto_ExtensionRange::MergeImpl(::google::protobuf::Message& to_m
       _this->_internal_mutable_options()->::google::protobuf::ExtensionRangeOptions::MergeFrom(
           from._internal_options());
     }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.start_ = from._impl_.start_;
-    }
-    if (cached_has_bits & 0x00000004u) {
-      _this->_impl_.end_ = from._impl_.end_;
+    if ((cached_has_bits & 0x00000006u) == 0x00000006u) {
+      ::memcpy(&_this->_impl_.start_, &from._impl_.start_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.end_) -
+              reinterpret_cast<const char*>(&from._impl_.start_)) +
+          sizeof(from._impl_.end_));
+    } else {
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.start_ = from._impl_.start_;
+      }
+      if (cached_has_bits & 0x00000004u) {
+        _this->_impl_.end_ = from._impl_.end_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -3160,6 +3221,8 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 0, 2> DescriptorProto_ReservedRange::_ta
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_DescriptorProto_ReservedRange_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // optional int32 end = 2;
     {::_pbi::TcParser::SingularVarintNoZag1<::uint32_t, offsetof(DescriptorProto_ReservedRange, _impl_.end_), 1>(),
@@ -3254,11 +3317,19 @@ void DescriptorProto_ReservedRange::MergeImpl(::google::protobuf::Message& to_ms
 
   cached_has_bits = from._impl_._has_bits_[0];
   if (cached_has_bits & 0x00000003u) {
-    if (cached_has_bits & 0x00000001u) {
-      _this->_impl_.start_ = from._impl_.start_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.end_ = from._impl_.end_;
+    if ((cached_has_bits & 0x00000003u) == 0x00000003u) {
+      ::memcpy(&_this->_impl_.start_, &from._impl_.start_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.end_) -
+              reinterpret_cast<const char*>(&from._impl_.start_)) +
+          sizeof(from._impl_.end_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        _this->_impl_.start_ = from._impl_.start_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.end_ = from._impl_.end_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -3268,8 +3339,13 @@ void DescriptorProto_ReservedRange::MergeImpl(::google::protobuf::Message& to_ms
 void DescriptorProto_ReservedRange::CopyFrom(const DescriptorProto_ReservedRange& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.DescriptorProto.ReservedRange)
   if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  _impl_._has_bits_ = from._impl_._has_bits_;
+  ::memcpy(&_impl_.start_, &from._impl_.start_,
+      static_cast<::size_t>(reinterpret_cast<char*>(&_impl_.end_) -
+      reinterpret_cast<char*>(&_impl_.start_)) + sizeof(_impl_.end_));
+  _internal_metadata_.Clear<::google::protobuf::UnknownFieldSet>();
+  _internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      from._internal_metadata_);
 }
 
 PROTOBUF_NOINLINE bool DescriptorProto_ReservedRange::IsInitialized() const {
@@ -3440,6 +3516,8 @@ constexpr ::_pbi::TcParseTable<4, 10, 8, 65, 2> DescriptorProto::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_DescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -3545,6 +3623,7 @@ constexpr ::_pbi::TcParseTable<4, 10, 8, 65, 2> DescriptorProto::_table_ = {
   // repeated .google.protobuf.FieldDescriptorProto field = 2;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_field_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_field(), i);
     const auto& repfield = this->_internal_field().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(2, repfield, repfield.GetCachedSize(), target, stream);
@@ -3553,6 +3632,7 @@ constexpr ::_pbi::TcParseTable<4, 10, 8, 65, 2> DescriptorProto::_table_ = {
   // repeated .google.protobuf.DescriptorProto nested_type = 3;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_nested_type_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_nested_type(), i);
     const auto& repfield = this->_internal_nested_type().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(3, repfield, repfield.GetCachedSize(), target, stream);
@@ -3561,6 +3641,7 @@ constexpr ::_pbi::TcParseTable<4, 10, 8, 65, 2> DescriptorProto::_table_ = {
   // repeated .google.protobuf.EnumDescriptorProto enum_type = 4;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_enum_type_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_enum_type(), i);
     const auto& repfield = this->_internal_enum_type().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(4, repfield, repfield.GetCachedSize(), target, stream);
@@ -3569,6 +3650,7 @@ constexpr ::_pbi::TcParseTable<4, 10, 8, 65, 2> DescriptorProto::_table_ = {
   // repeated .google.protobuf.DescriptorProto.ExtensionRange extension_range = 5;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_extension_range_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_extension_range(), i);
     const auto& repfield = this->_internal_extension_range().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(5, repfield, repfield.GetCachedSize(), target, stream);
@@ -3577,6 +3659,7 @@ constexpr ::_pbi::TcParseTable<4, 10, 8, 65, 2> DescriptorProto::_table_ = {
   // repeated .google.protobuf.FieldDescriptorProto extension = 6;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_extension_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_extension(), i);
     const auto& repfield = this->_internal_extension().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(6, repfield, repfield.GetCachedSize(), target, stream);
@@ -3592,6 +3675,7 @@ constexpr ::_pbi::TcParseTable<4, 10, 8, 65, 2> DescriptorProto::_table_ = {
   // repeated .google.protobuf.OneofDescriptorProto oneof_decl = 8;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_oneof_decl_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_oneof_decl(), i);
     const auto& repfield = this->_internal_oneof_decl().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(8, repfield, repfield.GetCachedSize(), target, stream);
@@ -3600,6 +3684,7 @@ constexpr ::_pbi::TcParseTable<4, 10, 8, 65, 2> DescriptorProto::_table_ = {
   // repeated .google.protobuf.DescriptorProto.ReservedRange reserved_range = 9;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_reserved_range_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_reserved_range(), i);
     const auto& repfield = this->_internal_reserved_range().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(9, repfield, repfield.GetCachedSize(), target, stream);
@@ -3631,51 +3716,58 @@ constexpr ::_pbi::TcParseTable<4, 10, 8, 65, 2> DescriptorProto::_table_ = {
 
   // repeated .google.protobuf.FieldDescriptorProto field = 2;
   total_size += 1UL * this->_internal_field_size();
-  for (const auto& msg : this->_internal_field()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_field_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_field(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_field().Get(i));
   }
 
   // repeated .google.protobuf.DescriptorProto nested_type = 3;
   total_size += 1UL * this->_internal_nested_type_size();
-  for (const auto& msg : this->_internal_nested_type()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_nested_type_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_nested_type(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_nested_type().Get(i));
   }
 
   // repeated .google.protobuf.EnumDescriptorProto enum_type = 4;
   total_size += 1UL * this->_internal_enum_type_size();
-  for (const auto& msg : this->_internal_enum_type()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_enum_type_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_enum_type(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_enum_type().Get(i));
   }
 
   // repeated .google.protobuf.DescriptorProto.ExtensionRange extension_range = 5;
   total_size += 1UL * this->_internal_extension_range_size();
-  for (const auto& msg : this->_internal_extension_range()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_extension_range_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_extension_range(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_extension_range().Get(i));
   }
 
   // repeated .google.protobuf.FieldDescriptorProto extension = 6;
   total_size += 1UL * this->_internal_extension_size();
-  for (const auto& msg : this->_internal_extension()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_extension_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_extension(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_extension().Get(i));
   }
 
   // repeated .google.protobuf.OneofDescriptorProto oneof_decl = 8;
   total_size += 1UL * this->_internal_oneof_decl_size();
-  for (const auto& msg : this->_internal_oneof_decl()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_oneof_decl_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_oneof_decl(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_oneof_decl().Get(i));
   }
 
   // repeated .google.protobuf.DescriptorProto.ReservedRange reserved_range = 9;
   total_size += 1UL * this->_internal_reserved_range_size();
-  for (const auto& msg : this->_internal_reserved_range()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_reserved_range_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_reserved_range(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_reserved_range().Get(i));
   }
 
   // repeated string reserved_name = 10;
@@ -3740,6 +3832,34 @@ void DescriptorProto::MergeImpl(::google::protobuf::Message& to_msg, const ::goo
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void DescriptorProto::MergeFrom(DescriptorProto&& from) {
+  DescriptorProto* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_field()->MergeFrom(
+      std::move(*from._internal_mutable_field()));
+  _this->_internal_mutable_nested_type()->MergeFrom(
+      std::move(*from._internal_mutable_nested_type()));
+  _this->_internal_mutable_enum_type()->MergeFrom(
+      std::move(*from._internal_mutable_enum_type()));
+  _this->_internal_mutable_extension_range()->MergeFrom(
+      std::move(*from._internal_mutable_extension_range()));
+  _this->_internal_mutable_extension()->MergeFrom(
+      std::move(*from._internal_mutable_extension()));
+  _this->_internal_mutable_oneof_decl()->MergeFrom(
+      std::move(*from._internal_mutable_oneof_decl()));
+  _this->_internal_mutable_reserved_range()->MergeFrom(
+      std::move(*from._internal_mutable_reserved_range()));
+  _this->_internal_mutable_reserved_name()->MergeFrom(
+      std::move(*from._internal_mutable_reserved_name()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const DescriptorProto&>(from));
+}
+
 void DescriptorProto::CopyFrom(const DescriptorProto& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.DescriptorProto)
   if (&from == this) return;
@@ -3937,6 +4057,8 @@ constexpr ::_pbi::TcParseTable<3, 6, 0, 71, 2> ExtensionRangeOptions_Declaration
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_ExtensionRangeOptions_Declaration_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional int32 number = 1;
@@ -4118,17 +4240,25 @@ void ExtensionRangeOptions_Declaration::MergeImpl(::google::protobuf::Message& t
     if (cached_has_bits & 0x00000002u) {
       _this->_internal_set_type(from._internal_type());
     }
-    if (cached_has_bits & 0x00000004u) {
-      _this->_impl_.number_ = from._impl_.number_;
-    }
-    if (cached_has_bits & 0x00000008u) {
-      _this->_impl_.is_repeated_ = from._impl_.is_repeated_;
-    }
-    if (cached_has_bits & 0x00000010u) {
-      _this->_impl_.reserved_ = from._impl_.reserved_;
-    }
-    if (cached_has_bits & 0x00000020u) {
-      _this->_impl_.repeated_ = from._impl_.repeated_;
+    if ((cached_has_bits & 0x0000003cu) == 0x0000003cu) {
+      ::memcpy(&_this->_impl_.number_, &from._impl_.number_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.repeated_) -
+              reinterpret_cast<const char*>(&from._impl_.number_)) +
+          sizeof(from._impl_.repeated_));
+    } else {
+      if (cached_has_bits & 0x00000004u) {
+        _this->_impl_.number_ = from._impl_.number_;
+      }
+      if (cached_has_bits & 0x00000008u) {
+        _this->_impl_.is_repeated_ = from._impl_.is_repeated_;
+      }
+      if (cached_has_bits & 0x00000010u) {
+        _this->_impl_.reserved_ = from._impl_.reserved_;
+      }
+      if (cached_has_bits & 0x00000020u) {
+        _this->_impl_.repeated_ = from._impl_.repeated_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -4265,6 +4395,8 @@ constexpr ::_pbi::TcParseTable<1, 3, 3, 0, 7> ExtensionRangeOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_ExtensionRangeOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // repeated .google.protobuf.ExtensionRangeOptions.Declaration declaration = 2 [retention = RETENTION_SOURCE];
     {::_pbi::TcParser::FastMtR1,
@@ -4303,6 +4435,7 @@ constexpr ::_pbi::TcParseTable<1, 3, 3, 0, 7> ExtensionRangeOptions::_table_ = {
   // repeated .google.protobuf.ExtensionRangeOptions.Declaration declaration = 2 [retention = RETENTION_SOURCE];
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_declaration_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_declaration(), i);
     const auto& repfield = this->_internal_declaration().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(2, repfield, repfield.GetCachedSize(), target, stream);
@@ -4319,6 +4452,7 @@ constexpr ::_pbi::TcParseTable<1, 3, 3, 0, 7> ExtensionRangeOptions::_table_ = {
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_uninterpreted_option_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
     const auto& repfield = this->_internal_uninterpreted_option().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(999, repfield, repfield.GetCachedSize(), target, stream);
@@ -4348,16 +4482,18 @@ constexpr ::_pbi::TcParseTable<1, 3, 3, 0, 7> ExtensionRangeOptions::_table_ = {
 
   // repeated .google.protobuf.ExtensionRangeOptions.Declaration declaration = 2 [retention = RETENTION_SOURCE];
   total_size += 1UL * this->_internal_declaration_size();
-  for (const auto& msg : this->_internal_declaration()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_declaration_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_declaration(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_declaration().Get(i));
   }
 
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   total_size += 2UL * this->_internal_uninterpreted_option_size();
-  for (const auto& msg : this->_internal_uninterpreted_option()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_uninterpreted_option_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_uninterpreted_option().Get(i));
   }
 
   // optional .google.protobuf.ExtensionRangeOptions.VerificationState verification = 3 [default = UNVERIFIED];
@@ -4394,6 +4530,22 @@ void ExtensionRangeOptions::MergeImpl(::google::protobuf::Message& to_msg, const
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void ExtensionRangeOptions::MergeFrom(ExtensionRangeOptions&& from) {
+  ExtensionRangeOptions* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_declaration()->MergeFrom(
+      std::move(*from._internal_mutable_declaration()));
+  _this->_internal_mutable_uninterpreted_option()->MergeFrom(
+      std::move(*from._internal_mutable_uninterpreted_option()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const ExtensionRangeOptions&>(from));
+}
+
 void ExtensionRangeOptions::CopyFrom(const ExtensionRangeOptions& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.ExtensionRangeOptions)
   if (&from == this) return;
@@ -4658,6 +4810,8 @@ constexpr ::_pbi::TcParseTable<4, 11, 3, 96, 2> FieldDescriptorProto::_table_ =
     offsetof(decltype(_table_), aux_entries),
     &_FieldDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -4961,23 +5115,39 @@ void FieldDescriptorProto::MergeImpl(::google::protobuf::Message& to_msg, const
       _this->_internal_mutable_options()->::google::protobuf::FieldOptions::MergeFrom(
           from._internal_options());
     }
-    if (cached_has_bits & 0x00000040u) {
-      _this->_impl_.number_ = from._impl_.number_;
-    }
-    if (cached_has_bits & 0x00000080u) {
-      _this->_impl_.oneof_index_ = from._impl_.oneof_index_;
+    if ((cached_has_bits & 0x000000c0u) == 0x000000c0u) {
+      ::memcpy(&_this->_impl_.number_, &from._impl_.number_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.oneof_index_) -
+              reinterpret_cast<const char*>(&from._impl_.number_)) +
+          sizeof(from._impl_.oneof_index_));
+    } else {
+      if (cached_has_bits & 0x00000040u) {
+        _this->_impl_.number_ = from._impl_.number_;
+      }
+      if (cached_has_bits & 0x00000080u) {
+        _this->_impl_.oneof_index_ = from._impl_.oneof_index_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
   if (cached_has_bits & 0x00000700u) {
-    if (cached_has_bits & 0x00000100u) {
-      _this->_impl_.proto3_optional_ = from._impl_.proto3_optional_;
-    }
-    if (cached_has_bits & 0x00000200u) {
-      _this->_impl_.label_ = from._impl_.label_;
-    }
-    if (cached_has_bits & 0x00000400u) {
-      _this->_impl_.type_ = from._impl_.type_;
+    if ((cached_has_bits & 0x00000700u) == 0x00000700u) {
+      ::memcpy(&_this->_impl_.proto3_optional_, &from._impl_.proto3_optional_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.type_) -
+              reinterpret_cast<const char*>(&from._impl_.proto3_optional_)) +
+          sizeof(from._impl_.type_));
+    } else {
+      if (cached_has_bits & 0x00000100u) {
+        _this->_impl_.proto3_optional_ = from._impl_.proto3_optional_;
+      }
+      if (cached_has_bits & 0x00000200u) {
+        _this->_impl_.label_ = from._impl_.label_;
+      }
+      if (cached_has_bits & 0x00000400u) {
+        _this->_impl_.type_ = from._impl_.type_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -5142,6 +5312,8 @@ constexpr ::_pbi::TcParseTable<1, 2, 1, 49, 2> OneofDescriptorProto::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_OneofDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // optional .google.protobuf.OneofOptions options = 2;
     {::_pbi::TcParser::FastMtS1,
@@ -5365,6 +5537,8 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 0, 2> EnumDescriptorProto_EnumReservedRa
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_EnumDescriptorProto_EnumReservedRange_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // optional int32 end = 2;
     {::_pbi::TcParser::SingularVarintNoZag1<::uint32_t, offsetof(EnumDescriptorProto_EnumReservedRange, _impl_.end_), 1>(),
@@ -5459,11 +5633,19 @@ void EnumDescriptorProto_EnumReservedRange::MergeImpl(::google::protobuf::Messag
 
   cached_has_bits = from._impl_._has_bits_[0];
   if (cached_has_bits & 0x00000003u) {
-    if (cached_has_bits & 0x00000001u) {
-      _this->_impl_.start_ = from._impl_.start_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.end_ = from._impl_.end_;
+    if ((cached_has_bits & 0x00000003u) == 0x00000003u) {
+      ::memcpy(&_this->_impl_.start_, &from._impl_.start_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.end_) -
+              reinterpret_cast<const char*>(&from._impl_.start_)) +
+          sizeof(from._impl_.end_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        _this->_impl_.start_ = from._impl_.start_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.end_ = from._impl_.end_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -5473,8 +5655,13 @@ void EnumDescriptorProto_EnumReservedRange::MergeImpl(::google::protobuf::Messag
 void EnumDescriptorProto_EnumReservedRange::CopyFrom(const EnumDescriptorProto_EnumReservedRange& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.EnumDescriptorProto.EnumReservedRange)
   if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  _impl_._has_bits_ = from._impl_._has_bits_;
+  ::memcpy(&_impl_.start_, &from._impl_.start_,
+      static_cast<::size_t>(reinterpret_cast<char*>(&_impl_.end_) -
+      reinterpret_cast<char*>(&_impl_.start_)) + sizeof(_impl_.end_));
+  _internal_metadata_.Clear<::google::protobuf::UnknownFieldSet>();
+  _internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      from._internal_metadata_);
 }
 
 PROTOBUF_NOINLINE bool EnumDescriptorProto_EnumReservedRange::IsInitialized() const {
@@ -5625,6 +5812,8 @@ constexpr ::_pbi::TcParseTable<3, 5, 3, 61, 2> EnumDescriptorProto::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_EnumDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -5692,6 +5881,7 @@ constexpr ::_pbi::TcParseTable<3, 5, 3, 61, 2> EnumDescriptorProto::_table_ = {
   // repeated .google.protobuf.EnumValueDescriptorProto value = 2;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_value_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_value(), i);
     const auto& repfield = this->_internal_value().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(2, repfield, repfield.GetCachedSize(), target, stream);
@@ -5707,6 +5897,7 @@ constexpr ::_pbi::TcParseTable<3, 5, 3, 61, 2> EnumDescriptorProto::_table_ = {
   // repeated .google.protobuf.EnumDescriptorProto.EnumReservedRange reserved_range = 4;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_reserved_range_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_reserved_range(), i);
     const auto& repfield = this->_internal_reserved_range().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(4, repfield, repfield.GetCachedSize(), target, stream);
@@ -5738,16 +5929,18 @@ constexpr ::_pbi::TcParseTable<3, 5, 3, 61, 2> EnumDescriptorProto::_table_ = {
 
   // repeated .google.protobuf.EnumValueDescriptorProto value = 2;
   total_size += 1UL * this->_internal_value_size();
-  for (const auto& msg : this->_internal_value()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_value_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_value(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_value().Get(i));
   }
 
   // repeated .google.protobuf.EnumDescriptorProto.EnumReservedRange reserved_range = 4;
   total_size += 1UL * this->_internal_reserved_range_size();
-  for (const auto& msg : this->_internal_reserved_range()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_reserved_range_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_reserved_range(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_reserved_range().Get(i));
   }
 
   // repeated string reserved_name = 5;
@@ -5807,6 +6000,24 @@ void EnumDescriptorProto::MergeImpl(::google::protobuf::Message& to_msg, const :
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void EnumDescriptorProto::MergeFrom(EnumDescriptorProto&& from) {
+  EnumDescriptorProto* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_value()->MergeFrom(
+      std::move(*from._internal_mutable_value()));
+  _this->_internal_mutable_reserved_range()->MergeFrom(
+      std::move(*from._internal_mutable_reserved_range()));
+  _this->_internal_mutable_reserved_name()->MergeFrom(
+      std::move(*from._internal_mutable_reserved_name()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const EnumDescriptorProto&>(from));
+}
+
 void EnumDescriptorProto::CopyFrom(const EnumDescriptorProto& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.EnumDescriptorProto)
   if (&from == this) return;
@@ -5965,6 +6176,8 @@ constexpr ::_pbi::TcParseTable<2, 3, 1, 53, 2> EnumValueDescriptorProto::_table_
     offsetof(decltype(_table_), aux_entries),
     &_EnumValueDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -6253,6 +6466,8 @@ constexpr ::_pbi::TcParseTable<2, 3, 2, 51, 2> ServiceDescriptorProto::_table_ =
     offsetof(decltype(_table_), aux_entries),
     &_ServiceDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -6304,6 +6519,7 @@ constexpr ::_pbi::TcParseTable<2, 3, 2, 51, 2> ServiceDescriptorProto::_table_ =
   // repeated .google.protobuf.MethodDescriptorProto method = 2;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_method_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_method(), i);
     const auto& repfield = this->_internal_method().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(2, repfield, repfield.GetCachedSize(), target, stream);
@@ -6334,9 +6550,10 @@ constexpr ::_pbi::TcParseTable<2, 3, 2, 51, 2> ServiceDescriptorProto::_table_ =
 
   // repeated .google.protobuf.MethodDescriptorProto method = 2;
   total_size += 1UL * this->_internal_method_size();
-  for (const auto& msg : this->_internal_method()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_method_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_method(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_method().Get(i));
   }
 
   cached_has_bits = _impl_._has_bits_[0];
@@ -6387,6 +6604,20 @@ void ServiceDescriptorProto::MergeImpl(::google::protobuf::Message& to_msg, cons
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void ServiceDescriptorProto::MergeFrom(ServiceDescriptorProto&& from) {
+  ServiceDescriptorProto* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_method()->MergeFrom(
+      std::move(*from._internal_mutable_method()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const ServiceDescriptorProto&>(from));
+}
+
 void ServiceDescriptorProto::CopyFrom(const ServiceDescriptorProto& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.ServiceDescriptorProto)
   if (&from == this) return;
@@ -6591,6 +6822,8 @@ constexpr ::_pbi::TcParseTable<3, 6, 1, 71, 2> MethodDescriptorProto::_table_ =
     offsetof(decltype(_table_), aux_entries),
     &_MethodDescriptorProto_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string name = 1;
@@ -6783,11 +7016,19 @@ void MethodDescriptorProto::MergeImpl(::google::protobuf::Message& to_msg, const
       _this->_internal_mutable_options()->::google::protobuf::MethodOptions::MergeFrom(
           from._internal_options());
     }
-    if (cached_has_bits & 0x00000010u) {
-      _this->_impl_.client_streaming_ = from._impl_.client_streaming_;
-    }
-    if (cached_has_bits & 0x00000020u) {
-      _this->_impl_.server_streaming_ = from._impl_.server_streaming_;
+    if ((cached_has_bits & 0x00000030u) == 0x00000030u) {
+      ::memcpy(&_this->_impl_.client_streaming_, &from._impl_.client_streaming_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.server_streaming_) -
+              reinterpret_cast<const char*>(&from._impl_.client_streaming_)) +
+          sizeof(from._impl_.server_streaming_));
+    } else {
+      if (cached_has_bits & 0x00000010u) {
+        _this->_impl_.client_streaming_ = from._impl_.client_streaming_;
+      }
+      if (cached_has_bits & 0x00000020u) {
+        _this->_impl_.server_streaming_ = from._impl_.server_streaming_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -7188,6 +7429,8 @@ constexpr ::_pbi::TcParseTable<5, 21, 2, 202, 12> FileOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_FileOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional string java_package = 1;
@@ -7505,6 +7748,7 @@ constexpr ::_pbi::TcParseTable<5, 21, 2, 202, 12> FileOptions::_table_ = {
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_uninterpreted_option_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
     const auto& repfield = this->_internal_uninterpreted_option().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(999, repfield, repfield.GetCachedSize(), target, stream);
@@ -7532,131 +7776,131 @@ constexpr ::_pbi::TcParseTable<5, 21, 2, 202, 12> FileOptions::_table_ = {
   // Prevent compiler warnings about cached_has_bits being unused
   (void) cached_has_bits;
 
+  cached_has_bits = _impl_._has_bits_[0] & 0x000fffffu;
+  while (cached_has_bits != 0) {
+    switch (::absl::countr_zero(cached_has_bits)) {
+      // optional string java_package = 1;
+      case 0: {
+        total_size += 1 + ::google::protobuf::internal::WireFormatLite::StringSize(
+                                        this->_internal_java_package());
+        break;
+      }
+      // optional string java_outer_classname = 8;
+      case 1: {
+        total_size += 1 + ::google::protobuf::internal::WireFormatLite::StringSize(
+                                        this->_internal_java_outer_classname());
+        break;
+      }
+      // optional string go_package = 11;
+      case 2: {
+        total_size += 1 + ::google::protobuf::internal::WireFormatLite::StringSize(
+                                        this->_internal_go_package());
+        break;
+      }
+      // optional string objc_class_prefix = 36;
+      case 3: {
+        total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
+                                        this->_internal_objc_class_prefix());
+        break;
+      }
+      // optional string csharp_namespace = 37;
+      case 4: {
+        total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
+                                        this->_internal_csharp_namespace());
+        break;
+      }
+      // optional string swift_prefix = 39;
+      case 5: {
+        total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
+                                        this->_internal_swift_prefix());
+        break;
+      }
+      // optional string php_class_prefix = 40;
+      case 6: {
+        total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
+                                        this->_internal_php_class_prefix());
+        break;
+      }
+      // optional string php_namespace = 41;
+      case 7: {
+        total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
+                                        this->_internal_php_namespace());
+        break;
+      }
+      // optional string php_metadata_namespace = 44;
+      case 8: {
+        total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
+                                        this->_internal_php_metadata_namespace());
+        break;
+      }
+      // optional string ruby_package = 45;
+      case 9: {
+        total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
+                                        this->_internal_ruby_package());
+        break;
+      }
+      // optional bool java_multiple_files = 10 [default = false];
+      case 10: {
+        total_size += 2;
+        break;
+      }
+      // optional bool java_generate_equals_and_hash = 20 [deprecated = true];
+      case 11: {
+        total_size += 3;
+        break;
+      }
+      // optional bool java_string_check_utf8 = 27 [default = false];
+      case 12: {
+        total_size += 3;
+        break;
+      }
+      // optional bool cc_generic_services = 16 [default = false];
+      case 13: {
+        total_size += 3;
+        break;
+      }
+      // optional bool java_generic_services = 17 [default = false];
+      case 14: {
+        total_size += 3;
+        break;
+      }
+      // optional bool py_generic_services = 18 [default = false];
+      case 15: {
+        total_size += 3;
+        break;
+      }
+      // optional bool php_generic_services = 42 [default = false];
+      case 16: {
+        total_size += 3;
+        break;
+      }
+      // optional bool deprecated = 23 [default = false];
+      case 17: {
+        total_size += 3;
+        break;
+      }
+      // optional .google.protobuf.FileOptions.OptimizeMode optimize_for = 9 [default = SPEED];
+      case 18: {
+        total_size += 1 +
+                      ::_pbi::WireFormatLite::EnumSize(this->_internal_optimize_for());
+        break;
+      }
+      // optional bool cc_enable_arenas = 31 [default = true];
+      case 19: {
+        total_size += 3;
+        break;
+      }
+    }
+    cached_has_bits &= cached_has_bits - 1;
+  }
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   total_size += 2UL * this->_internal_uninterpreted_option_size();
-  for (const auto& msg : this->_internal_uninterpreted_option()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_uninterpreted_option_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_uninterpreted_option().Get(i));
   }
 
-  cached_has_bits = _impl_._has_bits_[0];
-  if (cached_has_bits & 0x000000ffu) {
-    // optional string java_package = 1;
-    if (cached_has_bits & 0x00000001u) {
-      total_size += 1 + ::google::protobuf::internal::WireFormatLite::StringSize(
-                                      this->_internal_java_package());
-    }
-
-    // optional string java_outer_classname = 8;
-    if (cached_has_bits & 0x00000002u) {
-      total_size += 1 + ::google::protobuf::internal::WireFormatLite::StringSize(
-                                      this->_internal_java_outer_classname());
-    }
-
-    // optional string go_package = 11;
-    if (cached_has_bits & 0x00000004u) {
-      total_size += 1 + ::google::protobuf::internal::WireFormatLite::StringSize(
-                                      this->_internal_go_package());
-    }
-
-    // optional string objc_class_prefix = 36;
-    if (cached_has_bits & 0x00000008u) {
-      total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
-                                      this->_internal_objc_class_prefix());
-    }
-
-    // optional string csharp_namespace = 37;
-    if (cached_has_bits & 0x00000010u) {
-      total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
-                                      this->_internal_csharp_namespace());
-    }
-
-    // optional string swift_prefix = 39;
-    if (cached_has_bits & 0x00000020u) {
-      total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
-                                      this->_internal_swift_prefix());
-    }
-
-    // optional string php_class_prefix = 40;
-    if (cached_has_bits & 0x00000040u) {
-      total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
-                                      this->_internal_php_class_prefix());
-    }
-
-    // optional string php_namespace = 41;
-    if (cached_has_bits & 0x00000080u) {
-      total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
-                                      this->_internal_php_namespace());
-    }
-
-  }
-  if (cached_has_bits & 0x0000ff00u) {
-    // optional string php_metadata_namespace = 44;
-    if (cached_has_bits & 0x00000100u) {
-      total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
-                                      this->_internal_php_metadata_namespace());
-    }
-
-    // optional string ruby_package = 45;
-    if (cached_has_bits & 0x00000200u) {
-      total_size += 2 + ::google::protobuf::internal::WireFormatLite::StringSize(
-                                      this->_internal_ruby_package());
-    }
-
-    // optional bool java_multiple_files = 10 [default = false];
-    if (cached_has_bits & 0x00000400u) {
-      total_size += 2;
-    }
-
-    // optional bool java_generate_equals_and_hash = 20 [deprecated = true];
-    if (cached_has_bits & 0x00000800u) {
-      total_size += 3;
-    }
-
-    // optional bool java_string_check_utf8 = 27 [default = false];
-    if (cached_has_bits & 0x00001000u) {
-      total_size += 3;
-    }
-
-    // optional bool cc_generic_services = 16 [default = false];
-    if (cached_has_bits & 0x00002000u) {
-      total_size += 3;
-    }
-
-    // optional bool java_generic_services = 17 [default = false];
-    if (cached_has_bits & 0x00004000u) {
-      total_size += 3;
-    }
-
-    // optional bool py_generic_services = 18 [default = false];
-    if (cached_has_bits & 0x00008000u) {
-      total_size += 3;
-    }
-
-  }
-  if (cached_has_bits & 0x000f0000u) {
-    // optional bool php_generic_services = 42 [default = false];
-    if (cached_has_bits & 0x00010000u) {
-      total_size += 3;
-    }
-
-    // optional bool deprecated = 23 [default = false];
-    if (cached_has_bits & 0x00020000u) {
-      total_size += 3;
-    }
-
-    // optional .google.protobuf.FileOptions.OptimizeMode optimize_for = 9 [default = SPEED];
-    if (cached_has_bits & 0x00040000u) {
-      total_size += 1 +
-                    ::_pbi::WireFormatLite::EnumSize(this->_internal_optimize_for());
-    }
-
-    // optional bool cc_enable_arenas = 31 [default = true];
-    if (cached_has_bits & 0x00080000u) {
-      total_size += 3;
-    }
-
-  }
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
@@ -7710,38 +7954,54 @@ void FileOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::google:
     if (cached_has_bits & 0x00000200u) {
       _this->_internal_set_ruby_package(from._internal_ruby_package());
     }
-    if (cached_has_bits & 0x00000400u) {
-      _this->_impl_.java_multiple_files_ = from._impl_.java_multiple_files_;
-    }
-    if (cached_has_bits & 0x00000800u) {
-      _this->_impl_.java_generate_equals_and_hash_ = from._impl_.java_generate_equals_and_hash_;
-    }
-    if (cached_has_bits & 0x00001000u) {
-      _this->_impl_.java_string_check_utf8_ = from._impl_.java_string_check_utf8_;
-    }
-    if (cached_has_bits & 0x00002000u) {
-      _this->_impl_.cc_generic_services_ = from._impl_.cc_generic_services_;
-    }
-    if (cached_has_bits & 0x00004000u) {
-      _this->_impl_.java_generic_services_ = from._impl_.java_generic_services_;
-    }
-    if (cached_has_bits & 0x00008000u) {
-      _this->_impl_.py_generic_services_ = from._impl_.py_generic_services_;
+    if ((cached_has_bits & 0x0000fc00u) == 0x0000fc00u) {
+      ::memcpy(&_this->_impl_.java_multiple_files_, &from._impl_.java_multiple_files_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.py_generic_services_) -
+              reinterpret_cast<const char*>(&from._impl_.java_multiple_files_)) +
+          sizeof(from._impl_.py_generic_services_));
+    } else {
+      if (cached_has_bits & 0x00000400u) {
+        _this->_impl_.java_multiple_files_ = from._impl_.java_multiple_files_;
+      }
+      if (cached_has_bits & 0x00000800u) {
+        _this->_impl_.java_generate_equals_and_hash_ = from._impl_.java_generate_equals_and_hash_;
+      }
+      if (cached_has_bits & 0x00001000u) {
+        _this->_impl_.java_string_check_utf8_ = from._impl_.java_string_check_utf8_;
+      }
+      if (cached_has_bits & 0x00002000u) {
+        _this->_impl_.cc_generic_services_ = from._impl_.cc_generic_services_;
+      }
+      if (cached_has_bits & 0x00004000u) {
+        _this->_impl_.java_generic_services_ = from._impl_.java_generic_services_;
+      }
+      if (cached_has_bits & 0x00008000u) {
+        _this->_impl_.py_generic_services_ = from._impl_.py_generic_services_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
   if (cached_has_bits & 0x000f0000u) {
-    if (cached_has_bits & 0x00010000u) {
-      _this->_impl_.php_generic_services_ = from._impl_.php_generic_services_;
-    }
-    if (cached_has_bits & 0x00020000u) {
-      _this->_impl_.deprecated_ = from._impl_.deprecated_;
-    }
-    if (cached_has_bits & 0x00040000u) {
-      _this->_impl_.optimize_for_ = from._impl_.optimize_for_;
-    }
-    if (cached_has_bits & 0x00080000u) {
-      _this->_impl_.cc_enable_arenas_ = from._impl_.cc_enable_arenas_;
+    if ((cached_has_bits & 0x000f0000u) == 0x000f0000u) {
+      ::memcpy(&_this->_impl_.php_generic_services_, &from._impl_.php_generic_services_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.cc_enable_arenas_) -
+              reinterpret_cast<const char*>(&from._impl_.php_generic_services_)) +
+          sizeof(from._impl_.cc_enable_arenas_));
+    } else {
+      if (cached_has_bits & 0x00010000u) {
+        _this->_impl_.php_generic_services_ = from._impl_.php_generic_services_;
+      }
+      if (cached_has_bits & 0x00020000u) {
+        _this->_impl_.deprecated_ = from._impl_.deprecated_;
+      }
+      if (cached_has_bits & 0x00040000u) {
+        _this->_impl_.optimize_for_ = from._impl_.optimize_for_;
+      }
+      if (cached_has_bits & 0x00080000u) {
+        _this->_impl_.cc_enable_arenas_ = from._impl_.cc_enable_arenas_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -7749,6 +8009,20 @@ void FileOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::google:
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void FileOptions::MergeFrom(FileOptions&& from) {
+  FileOptions* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_uninterpreted_option()->MergeFrom(
+      std::move(*from._internal_mutable_uninterpreted_option()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const FileOptions&>(from));
+}
+
 void FileOptions::CopyFrom(const FileOptions& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.FileOptions)
   if (&from == this) return;
@@ -7925,6 +8199,8 @@ constexpr ::_pbi::TcParseTable<3, 6, 1, 0, 7> MessageOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_MessageOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional bool message_set_wire_format = 1 [default = false];
@@ -8016,6 +8292,7 @@ constexpr ::_pbi::TcParseTable<3, 6, 1, 0, 7> MessageOptions::_table_ = {
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_uninterpreted_option_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
     const auto& repfield = this->_internal_uninterpreted_option().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(999, repfield, repfield.GetCachedSize(), target, stream);
@@ -8045,9 +8322,10 @@ constexpr ::_pbi::TcParseTable<3, 6, 1, 0, 7> MessageOptions::_table_ = {
 
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   total_size += 2UL * this->_internal_uninterpreted_option_size();
-  for (const auto& msg : this->_internal_uninterpreted_option()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_uninterpreted_option_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_uninterpreted_option().Get(i));
   }
 
   cached_has_bits = _impl_._has_bits_[0];
@@ -8099,20 +8377,28 @@ void MessageOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::goog
   _this->_internal_mutable_uninterpreted_option()->MergeFrom(from._internal_uninterpreted_option());
   cached_has_bits = from._impl_._has_bits_[0];
   if (cached_has_bits & 0x0000001fu) {
-    if (cached_has_bits & 0x00000001u) {
-      _this->_impl_.message_set_wire_format_ = from._impl_.message_set_wire_format_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.no_standard_descriptor_accessor_ = from._impl_.no_standard_descriptor_accessor_;
-    }
-    if (cached_has_bits & 0x00000004u) {
-      _this->_impl_.deprecated_ = from._impl_.deprecated_;
-    }
-    if (cached_has_bits & 0x00000008u) {
-      _this->_impl_.map_entry_ = from._impl_.map_entry_;
-    }
-    if (cached_has_bits & 0x00000010u) {
-      _this->_impl_.deprecated_legacy_json_field_conflicts_ = from._impl_.deprecated_legacy_json_field_conflicts_;
+    if ((cached_has_bits & 0x0000001fu) == 0x0000001fu) {
+      ::memcpy(&_this->_impl_.message_set_wire_format_, &from._impl_.message_set_wire_format_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.deprecated_legacy_json_field_conflicts_) -
+              reinterpret_cast<const char*>(&from._impl_.message_set_wire_format_)) +
+          sizeof(from._impl_.deprecated_legacy_json_field_conflicts_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        _this->_impl_.message_set_wire_format_ = from._impl_.message_set_wire_format_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.no_standard_descriptor_accessor_ = from._impl_.no_standard_descriptor_accessor_;
+      }
+      if (cached_has_bits & 0x00000004u) {
+        _this->_impl_.deprecated_ = from._impl_.deprecated_;
+      }
+      if (cached_has_bits & 0x00000008u) {
+        _this->_impl_.map_entry_ = from._impl_.map_entry_;
+      }
+      if (cached_has_bits & 0x00000010u) {
+        _this->_impl_.deprecated_legacy_json_field_conflicts_ = from._impl_.deprecated_legacy_json_field_conflicts_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -8120,6 +8406,20 @@ void MessageOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::goog
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void MessageOptions::MergeFrom(MessageOptions&& from) {
+  MessageOptions* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_uninterpreted_option()->MergeFrom(
+      std::move(*from._internal_mutable_uninterpreted_option()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const MessageOptions&>(from));
+}
+
 void MessageOptions::CopyFrom(const MessageOptions& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.MessageOptions)
   if (&from == this) return;
@@ -8308,6 +8608,8 @@ constexpr ::_pbi::TcParseTable<4, 12, 6, 0, 7> FieldOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_FieldOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // optional bool debug_redact = 16 [default = false];
     {::_pbi::TcParser::FastV8S2,
@@ -8483,6 +8785,7 @@ constexpr ::_pbi::TcParseTable<4, 12, 6, 0, 7> FieldOptions::_table_ = {
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_uninterpreted_option_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
     const auto& repfield = this->_internal_uninterpreted_option().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(999, repfield, repfield.GetCachedSize(), target, stream);
@@ -8525,9 +8828,10 @@ constexpr ::_pbi::TcParseTable<4, 12, 6, 0, 7> FieldOptions::_table_ = {
 
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   total_size += 2UL * this->_internal_uninterpreted_option_size();
-  for (const auto& msg : this->_internal_uninterpreted_option()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_uninterpreted_option_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_uninterpreted_option().Get(i));
   }
 
   cached_has_bits = _impl_._has_bits_[0];
@@ -8611,38 +8915,54 @@ void FieldOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::google
   _this->_internal_mutable_uninterpreted_option()->MergeFrom(from._internal_uninterpreted_option());
   cached_has_bits = from._impl_._has_bits_[0];
   if (cached_has_bits & 0x000000ffu) {
-    if (cached_has_bits & 0x00000001u) {
-      _this->_impl_.ctype_ = from._impl_.ctype_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.jstype_ = from._impl_.jstype_;
-    }
-    if (cached_has_bits & 0x00000004u) {
-      _this->_impl_.packed_ = from._impl_.packed_;
-    }
-    if (cached_has_bits & 0x00000008u) {
-      _this->_impl_.lazy_ = from._impl_.lazy_;
-    }
-    if (cached_has_bits & 0x00000010u) {
-      _this->_impl_.unverified_lazy_ = from._impl_.unverified_lazy_;
-    }
-    if (cached_has_bits & 0x00000020u) {
-      _this->_impl_.deprecated_ = from._impl_.deprecated_;
-    }
-    if (cached_has_bits & 0x00000040u) {
-      _this->_impl_.weak_ = from._impl_.weak_;
-    }
-    if (cached_has_bits & 0x00000080u) {
-      _this->_impl_.debug_redact_ = from._impl_.debug_redact_;
+    if ((cached_has_bits & 0x000000ffu) == 0x000000ffu) {
+      ::memcpy(&_this->_impl_.ctype_, &from._impl_.ctype_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.debug_redact_) -
+              reinterpret_cast<const char*>(&from._impl_.ctype_)) +
+          sizeof(from._impl_.debug_redact_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        _this->_impl_.ctype_ = from._impl_.ctype_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.jstype_ = from._impl_.jstype_;
+      }
+      if (cached_has_bits & 0x00000004u) {
+        _this->_impl_.packed_ = from._impl_.packed_;
+      }
+      if (cached_has_bits & 0x00000008u) {
+        _this->_impl_.lazy_ = from._impl_.lazy_;
+      }
+      if (cached_has_bits & 0x00000010u) {
+        _this->_impl_.unverified_lazy_ = from._impl_.unverified_lazy_;
+      }
+      if (cached_has_bits & 0x00000020u) {
+        _this->_impl_.deprecated_ = from._impl_.deprecated_;
+      }
+      if (cached_has_bits & 0x00000040u) {
+        _this->_impl_.weak_ = from._impl_.weak_;
+      }
+      if (cached_has_bits & 0x00000080u) {
+        _this->_impl_.debug_redact_ = from._impl_.debug_redact_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
   if (cached_has_bits & 0x00000300u) {
-    if (cached_has_bits & 0x00000100u) {
-      _this->_impl_.retention_ = from._impl_.retention_;
-    }
-    if (cached_has_bits & 0x00000200u) {
-      _this->_impl_.target_obsolete_do_not_use_ = from._impl_.target_obsolete_do_not_use_;
+    if ((cached_has_bits & 0x00000300u) == 0x00000300u) {
+      ::memcpy(&_this->_impl_.retention_, &from._impl_.retention_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.target_obsolete_do_not_use_) -
+              reinterpret_cast<const char*>(&from._impl_.retention_)) +
+          sizeof(from._impl_.target_obsolete_do_not_use_));
+    } else {
+      if (cached_has_bits & 0x00000100u) {
+        _this->_impl_.retention_ = from._impl_.retention_;
+      }
+      if (cached_has_bits & 0x00000200u) {
+        _this->_impl_.target_obsolete_do_not_use_ = from._impl_.target_obsolete_do_not_use_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -8650,6 +8970,20 @@ void FieldOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::google
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void FieldOptions::MergeFrom(FieldOptions&& from) {
+  FieldOptions* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_uninterpreted_option()->MergeFrom(
+      std::move(*from._internal_mutable_uninterpreted_option()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const FieldOptions&>(from));
+}
+
 void FieldOptions::CopyFrom(const FieldOptions& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.FieldOptions)
   if (&from == this) return;
@@ -8766,6 +9100,8 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 7> OneofOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_OneofOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
     {::_pbi::TcParser::FastMtR2,
@@ -8793,6 +9129,7 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 7> OneofOptions::_table_ = {
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_uninterpreted_option_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
     const auto& repfield = this->_internal_uninterpreted_option().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(999, repfield, repfield.GetCachedSize(), target, stream);
@@ -8822,9 +9159,10 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 7> OneofOptions::_table_ = {
 
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   total_size += 2UL * this->_internal_uninterpreted_option_size();
-  for (const auto& msg : this->_internal_uninterpreted_option()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_uninterpreted_option_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_uninterpreted_option().Get(i));
   }
 
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
@@ -8850,6 +9188,20 @@ void OneofOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::google
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void OneofOptions::MergeFrom(OneofOptions&& from) {
+  OneofOptions* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_uninterpreted_option()->MergeFrom(
+      std::move(*from._internal_mutable_uninterpreted_option()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const OneofOptions&>(from));
+}
+
 void OneofOptions::CopyFrom(const OneofOptions& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.OneofOptions)
   if (&from == this) return;
@@ -8984,6 +9336,8 @@ constexpr ::_pbi::TcParseTable<3, 4, 1, 0, 7> EnumOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_EnumOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     {::_pbi::TcParser::MiniParse, {}},
@@ -9055,6 +9409,7 @@ constexpr ::_pbi::TcParseTable<3, 4, 1, 0, 7> EnumOptions::_table_ = {
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_uninterpreted_option_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
     const auto& repfield = this->_internal_uninterpreted_option().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(999, repfield, repfield.GetCachedSize(), target, stream);
@@ -9084,9 +9439,10 @@ constexpr ::_pbi::TcParseTable<3, 4, 1, 0, 7> EnumOptions::_table_ = {
 
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   total_size += 2UL * this->_internal_uninterpreted_option_size();
-  for (const auto& msg : this->_internal_uninterpreted_option()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_uninterpreted_option_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_uninterpreted_option().Get(i));
   }
 
   cached_has_bits = _impl_._has_bits_[0];
@@ -9128,14 +9484,22 @@ void EnumOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::google:
   _this->_internal_mutable_uninterpreted_option()->MergeFrom(from._internal_uninterpreted_option());
   cached_has_bits = from._impl_._has_bits_[0];
   if (cached_has_bits & 0x00000007u) {
-    if (cached_has_bits & 0x00000001u) {
-      _this->_impl_.allow_alias_ = from._impl_.allow_alias_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.deprecated_ = from._impl_.deprecated_;
-    }
-    if (cached_has_bits & 0x00000004u) {
-      _this->_impl_.deprecated_legacy_json_field_conflicts_ = from._impl_.deprecated_legacy_json_field_conflicts_;
+    if ((cached_has_bits & 0x00000007u) == 0x00000007u) {
+      ::memcpy(&_this->_impl_.allow_alias_, &from._impl_.allow_alias_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.deprecated_legacy_json_field_conflicts_) -
+              reinterpret_cast<const char*>(&from._impl_.allow_alias_)) +
+          sizeof(from._impl_.deprecated_legacy_json_field_conflicts_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        _this->_impl_.allow_alias_ = from._impl_.allow_alias_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.deprecated_ = from._impl_.deprecated_;
+      }
+      if (cached_has_bits & 0x00000004u) {
+        _this->_impl_.deprecated_legacy_json_field_conflicts_ = from._impl_.deprecated_legacy_json_field_conflicts_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -9143,6 +9507,20 @@ void EnumOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::google:
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void EnumOptions::MergeFrom(EnumOptions&& from) {
+  EnumOptions* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_uninterpreted_option()->MergeFrom(
+      std::move(*from._internal_mutable_uninterpreted_option()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const EnumOptions&>(from));
+}
+
 void EnumOptions::CopyFrom(const EnumOptions& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.EnumOptions)
   if (&from == this) return;
@@ -9270,6 +9648,8 @@ constexpr ::_pbi::TcParseTable<2, 2, 1, 0, 7> EnumValueOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_EnumValueOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional bool deprecated = 1 [default = false];
@@ -9313,6 +9693,7 @@ constexpr ::_pbi::TcParseTable<2, 2, 1, 0, 7> EnumValueOptions::_table_ = {
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_uninterpreted_option_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
     const auto& repfield = this->_internal_uninterpreted_option().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(999, repfield, repfield.GetCachedSize(), target, stream);
@@ -9342,9 +9723,10 @@ constexpr ::_pbi::TcParseTable<2, 2, 1, 0, 7> EnumValueOptions::_table_ = {
 
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   total_size += 2UL * this->_internal_uninterpreted_option_size();
-  for (const auto& msg : this->_internal_uninterpreted_option()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_uninterpreted_option_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_uninterpreted_option().Get(i));
   }
 
   // optional bool deprecated = 1 [default = false];
@@ -9379,6 +9761,20 @@ void EnumValueOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::go
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void EnumValueOptions::MergeFrom(EnumValueOptions&& from) {
+  EnumValueOptions* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_uninterpreted_option()->MergeFrom(
+      std::move(*from._internal_mutable_uninterpreted_option()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const EnumValueOptions&>(from));
+}
+
 void EnumValueOptions::CopyFrom(const EnumValueOptions& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.EnumValueOptions)
   if (&from == this) return;
@@ -9501,6 +9897,8 @@ constexpr ::_pbi::TcParseTable<2, 2, 1, 0, 12> ServiceOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_ServiceOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional bool deprecated = 33 [default = false];
@@ -9545,6 +9943,7 @@ constexpr ::_pbi::TcParseTable<2, 2, 1, 0, 12> ServiceOptions::_table_ = {
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_uninterpreted_option_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
     const auto& repfield = this->_internal_uninterpreted_option().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(999, repfield, repfield.GetCachedSize(), target, stream);
@@ -9574,9 +9973,10 @@ constexpr ::_pbi::TcParseTable<2, 2, 1, 0, 12> ServiceOptions::_table_ = {
 
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   total_size += 2UL * this->_internal_uninterpreted_option_size();
-  for (const auto& msg : this->_internal_uninterpreted_option()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_uninterpreted_option_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_uninterpreted_option().Get(i));
   }
 
   // optional bool deprecated = 33 [default = false];
@@ -9611,6 +10011,20 @@ void ServiceOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::goog
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void ServiceOptions::MergeFrom(ServiceOptions&& from) {
+  ServiceOptions* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_uninterpreted_option()->MergeFrom(
+      std::move(*from._internal_mutable_uninterpreted_option()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const ServiceOptions&>(from));
+}
+
 void ServiceOptions::CopyFrom(const ServiceOptions& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.ServiceOptions)
   if (&from == this) return;
@@ -9745,6 +10159,8 @@ constexpr ::_pbi::TcParseTable<2, 3, 2, 0, 12> MethodOptions::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_MethodOptions_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // optional bool deprecated = 33 [default = false];
@@ -9802,6 +10218,7 @@ constexpr ::_pbi::TcParseTable<2, 3, 2, 0, 12> MethodOptions::_table_ = {
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_uninterpreted_option_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
     const auto& repfield = this->_internal_uninterpreted_option().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(999, repfield, repfield.GetCachedSize(), target, stream);
@@ -9831,9 +10248,10 @@ constexpr ::_pbi::TcParseTable<2, 3, 2, 0, 12> MethodOptions::_table_ = {
 
   // repeated .google.protobuf.UninterpretedOption uninterpreted_option = 999;
   total_size += 2UL * this->_internal_uninterpreted_option_size();
-  for (const auto& msg : this->_internal_uninterpreted_option()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_uninterpreted_option_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_uninterpreted_option(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_uninterpreted_option().Get(i));
   }
 
   cached_has_bits = _impl_._has_bits_[0];
@@ -9871,11 +10289,19 @@ void MethodOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::googl
   _this->_internal_mutable_uninterpreted_option()->MergeFrom(from._internal_uninterpreted_option());
   cached_has_bits = from._impl_._has_bits_[0];
   if (cached_has_bits & 0x00000003u) {
-    if (cached_has_bits & 0x00000001u) {
-      _this->_impl_.deprecated_ = from._impl_.deprecated_;
-    }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.idempotency_level_ = from._impl_.idempotency_level_;
+    if ((cached_has_bits & 0x00000003u) == 0x00000003u) {
+      ::memcpy(&_this->_impl_.deprecated_, &from._impl_.deprecated_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.idempotency_level_) -
+              reinterpret_cast<const char*>(&from._impl_.deprecated_)) +
+          sizeof(from._impl_.idempotency_level_));
+    } else {
+      if (cached_has_bits & 0x00000001u) {
+        _this->_impl_.deprecated_ = from._impl_.deprecated_;
+      }
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.idempotency_level_ = from._impl_.idempotency_level_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -9883,6 +10309,20 @@ void MethodOptions::MergeImpl(::google::protobuf::Message& to_msg, const ::googl
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void MethodOptions::MergeFrom(MethodOptions&& from) {
+  MethodOptions* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_uninterpreted_option()->MergeFrom(
+      std::move(*from._internal_mutable_uninterpreted_option()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const MethodOptions&>(from));
+}
+
 void MethodOptions::CopyFrom(const MethodOptions& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.MethodOptions)
   if (&from == this) return;
@@ -10024,6 +10464,8 @@ constexpr ::_pbi::TcParseTable<1, 2, 0, 62, 2> UninterpretedOption_NamePart::_ta
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_UninterpretedOption_NamePart_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    3,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // required bool is_extension = 2;
     {::_pbi::TcParser::SingularVarintNoZag1<bool, offsetof(UninterpretedOption_NamePart, _impl_.is_extension_), 1>(),
@@ -10341,6 +10783,8 @@ constexpr ::_pbi::TcParseTable<3, 7, 1, 75, 2> UninterpretedOption::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_UninterpretedOption_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // optional string aggregate_value = 8;
     {::_pbi::TcParser::FastSS1,
@@ -10407,6 +10851,7 @@ constexpr ::_pbi::TcParseTable<3, 7, 1, 75, 2> UninterpretedOption::_table_ = {
   // repeated .google.protobuf.UninterpretedOption.NamePart name = 2;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_name_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_name(), i);
     const auto& repfield = this->_internal_name().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(2, repfield, repfield.GetCachedSize(), target, stream);
@@ -10474,9 +10919,10 @@ constexpr ::_pbi::TcParseTable<3, 7, 1, 75, 2> UninterpretedOption::_table_ = {
 
   // repeated .google.protobuf.UninterpretedOption.NamePart name = 2;
   total_size += 1UL * this->_internal_name_size();
-  for (const auto& msg : this->_internal_name()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_name_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_name(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_name().Get(i));
   }
 
   cached_has_bits = _impl_._has_bits_[0];
@@ -10547,20 +10993,42 @@ void UninterpretedOption::MergeImpl(::google::protobuf::Message& to_msg, const :
     if (cached_has_bits & 0x00000004u) {
       _this->_internal_set_aggregate_value(from._internal_aggregate_value());
     }
-    if (cached_has_bits & 0x00000008u) {
-      _this->_impl_.positive_int_value_ = from._impl_.positive_int_value_;
-    }
-    if (cached_has_bits & 0x00000010u) {
-      _this->_impl_.negative_int_value_ = from._impl_.negative_int_value_;
-    }
-    if (cached_has_bits & 0x00000020u) {
-      _this->_impl_.double_value_ = from._impl_.double_value_;
+    if ((cached_has_bits & 0x00000038u) == 0x00000038u) {
+      ::memcpy(&_this->_impl_.positive_int_value_, &from._impl_.positive_int_value_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.double_value_) -
+              reinterpret_cast<const char*>(&from._impl_.positive_int_value_)) +
+          sizeof(from._impl_.double_value_));
+    } else {
+      if (cached_has_bits & 0x00000008u) {
+        _this->_impl_.positive_int_value_ = from._impl_.positive_int_value_;
+      }
+      if (cached_has_bits & 0x00000010u) {
+        _this->_impl_.negative_int_value_ = from._impl_.negative_int_value_;
+      }
+      if (cached_has_bits & 0x00000020u) {
+        _this->_impl_.double_value_ = from._impl_.double_value_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void UninterpretedOption::MergeFrom(UninterpretedOption&& from) {
+  UninterpretedOption* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_name()->MergeFrom(
+      std::move(*from._internal_mutable_name()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const UninterpretedOption&>(from));
+}
+
 void UninterpretedOption::CopyFrom(const UninterpretedOption& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.UninterpretedOption)
   if (&from == this) return;
@@ -10734,6 +11202,8 @@ constexpr ::_pbi::TcParseTable<3, 5, 0, 106, 2> SourceCodeInfo_Location::_table_
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_SourceCodeInfo_Location_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // repeated int32 path = 1 [packed = true];
@@ -10791,7 +11261,7 @@ constexpr ::_pbi::TcParseTable<3, 5, 0, 106, 2> SourceCodeInfo_Location::_table_
   // repeated int32 path = 1 [packed = true];
   {
     int byte_size = _impl_._path_cached_byte_size_.Get();
-    if (byte_size > 0) {
+    if (byte_size > 0 || stream->BackpatchesLengths()) {
       target = stream->WriteInt32Packed(1, _internal_path(),
                                                  byte_size, target);
     }
@@ -10800,7 +11270,7 @@ constexpr ::_pbi::TcParseTable<3, 5, 0, 106, 2> SourceCodeInfo_Location::_table_
   // repeated int32 span = 2 [packed = true];
   {
     int byte_size = _impl_._span_cached_byte_size_.Get();
-    if (byte_size > 0) {
+    if (byte_size > 0 || stream->BackpatchesLengths()) {
       target = stream->WriteInt32Packed(2, _internal_span(),
                                                  byte_size, target);
     }
@@ -10930,6 +11400,20 @@ void SourceCodeInfo_Location::MergeImpl(::google::protobuf::Message& to_msg, con
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void SourceCodeInfo_Location::MergeFrom(SourceCodeInfo_Location&& from) {
+  SourceCodeInfo_Location* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_leading_detached_comments()->MergeFrom(
+      std::move(*from._internal_mutable_leading_detached_comments()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const SourceCodeInfo_Location&>(from));
+}
+
 void SourceCodeInfo_Location::CopyFrom(const SourceCodeInfo_Location& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.SourceCodeInfo.Location)
   if (&from == this) return;
@@ -11035,6 +11519,8 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> SourceCodeInfo::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_SourceCodeInfo_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // repeated .google.protobuf.SourceCodeInfo.Location location = 1;
     {::_pbi::TcParser::FastMtR1,
@@ -11060,6 +11546,7 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> SourceCodeInfo::_table_ = {
   // repeated .google.protobuf.SourceCodeInfo.Location location = 1;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_location_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_location(), i);
     const auto& repfield = this->_internal_location().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(1, repfield, repfield.GetCachedSize(), target, stream);
@@ -11083,9 +11570,10 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> SourceCodeInfo::_table_ = {
 
   // repeated .google.protobuf.SourceCodeInfo.Location location = 1;
   total_size += 1UL * this->_internal_location_size();
-  for (const auto& msg : this->_internal_location()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_location_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_location(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_location().Get(i));
   }
 
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
@@ -11110,6 +11598,20 @@ void SourceCodeInfo::MergeImpl(::google::protobuf::Message& to_msg, const ::goog
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void SourceCodeInfo::MergeFrom(SourceCodeInfo&& from) {
+  SourceCodeInfo* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_location()->MergeFrom(
+      std::move(*from._internal_mutable_location()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const SourceCodeInfo&>(from));
+}
+
 void SourceCodeInfo::CopyFrom(const SourceCodeInfo& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.SourceCodeInfo)
   if (&from == this) return;
@@ -11257,6 +11759,8 @@ constexpr ::_pbi::TcParseTable<3, 5, 1, 64, 2> GeneratedCodeInfo_Annotation::_ta
     offsetof(decltype(_table_), aux_entries),
     &_GeneratedCodeInfo_Annotation_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // repeated int32 path = 1 [packed = true];
@@ -11312,7 +11816,7 @@ constexpr ::_pbi::TcParseTable<3, 5, 1, 64, 2> GeneratedCodeInfo_Annotation::_ta
   // repeated int32 path = 1 [packed = true];
   {
     int byte_size = _impl_._path_cached_byte_size_.Get();
-    if (byte_size > 0) {
+    if (byte_size > 0 || stream->BackpatchesLengths()) {
       target = stream->WriteInt32Packed(1, _internal_path(),
                                                  byte_size, target);
     }
@@ -11429,14 +11933,22 @@ void GeneratedCodeInfo_Annotation::MergeImpl(::google::protobuf::Message& to_msg
     if (cached_has_bits & 0x00000001u) {
       _this->_internal_set_source_file(from._internal_source_file());
     }
-    if (cached_has_bits & 0x00000002u) {
-      _this->_impl_.begin_ = from._impl_.begin_;
-    }
-    if (cached_has_bits & 0x00000004u) {
-      _this->_impl_.end_ = from._impl_.end_;
-    }
-    if (cached_has_bits & 0x00000008u) {
-      _this->_impl_.semantic_ = from._impl_.semantic_;
+    if ((cached_has_bits & 0x0000000eu) == 0x0000000eu) {
+      ::memcpy(&_this->_impl_.begin_, &from._impl_.begin_,
+          static_cast<::size_t>(
+              reinterpret_cast<const char*>(&from._impl_.semantic_) -
+              reinterpret_cast<const char*>(&from._impl_.begin_)) +
+          sizeof(from._impl_.semantic_));
+    } else {
+      if (cached_has_bits & 0x00000002u) {
+        _this->_impl_.begin_ = from._impl_.begin_;
+      }
+      if (cached_has_bits & 0x00000004u) {
+        _this->_impl_.end_ = from._impl_.end_;
+      }
+      if (cached_has_bits & 0x00000008u) {
+        _this->_impl_.semantic_ = from._impl_.semantic_;
+      }
     }
     _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
@@ -11549,6 +12061,8 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> GeneratedCodeInfo::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_GeneratedCodeInfo_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // repeated .google.protobuf.GeneratedCodeInfo.Annotation annotation = 1;
     {::_pbi::TcParser::FastMtR1,
@@ -11574,6 +12088,7 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> GeneratedCodeInfo::_table_ = {
   // repeated .google.protobuf.GeneratedCodeInfo.Annotation annotation = 1;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_annotation_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_annotation(), i);
     const auto& repfield = this->_internal_annotation().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(1, repfield, repfield.GetCachedSize(), target, stream);
@@ -11597,9 +12112,10 @@ constexpr ::_pbi::TcParseTable<0, 1, 1, 0, 2> GeneratedCodeInfo::_table_ = {
 
   // repeated .google.protobuf.GeneratedCodeInfo.Annotation annotation = 1;
   total_size += 1UL * this->_internal_annotation_size();
-  for (const auto& msg : this->_internal_annotation()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_annotation_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_annotation(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_annotation().Get(i));
   }
 
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
@@ -11624,6 +12140,20 @@ void GeneratedCodeInfo::MergeImpl(::google::protobuf::Message& to_msg, const ::g
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void GeneratedCodeInfo::MergeFrom(GeneratedCodeInfo&& from) {
+  GeneratedCodeInfo* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_annotation()->MergeFrom(
+      std::move(*from._internal_mutable_annotation()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const GeneratedCodeInfo&>(from));
+}
+
 void GeneratedCodeInfo::CopyFrom(const GeneratedCodeInfo& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.GeneratedCodeInfo)
   if (&from == this) return;
@@ -607,6 +607,11 @@ class PROTOBUF_EXPORT FileDescriptorSet final :
   FileDescriptorSet* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<FileDescriptorSet>(arena);
   }
+  FileDescriptorSet* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    FileDescriptorSet* copy = CreateMaybeMessage<FileDescriptorSet>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const FileDescriptorSet& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -616,6 +621,7 @@ class PROTOBUF_EXPORT FileDescriptorSet final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(FileDescriptorSet&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -771,6 +777,11 @@ class PROTOBUF_EXPORT FileDescriptorProto final :
   FileDescriptorProto* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<FileDescriptorProto>(arena);
   }
+  FileDescriptorProto* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    FileDescriptorProto* copy = CreateMaybeMessage<FileDescriptorProto>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const FileDescriptorProto& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -780,6 +791,7 @@ class PROTOBUF_EXPORT FileDescriptorProto final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(FileDescriptorProto&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -1176,6 +1188,11 @@ class PROTOBUF_EXPORT DescriptorProto_ExtensionRange final :
   DescriptorProto_ExtensionRange* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<DescriptorProto_ExtensionRange>(arena);
   }
+  DescriptorProto_ExtensionRange* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    DescriptorProto_ExtensionRange* copy = CreateMaybeMessage<DescriptorProto_ExtensionRange>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const DescriptorProto_ExtensionRange& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -1364,6 +1381,11 @@ class PROTOBUF_EXPORT DescriptorProto_ReservedRange final :
   DescriptorProto_ReservedRange* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<DescriptorProto_ReservedRange>(arena);
   }
+  DescriptorProto_ReservedRange* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    DescriptorProto_ReservedRange* copy = CreateMaybeMessage<DescriptorProto_ReservedRange>(arena);
+    copy->CopyFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const DescriptorProto_ReservedRange& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -1535,6 +1557,11 @@ class PROTOBUF_EXPORT DescriptorProto final :
   DescriptorProto* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<DescriptorProto>(arena);
   }
+  DescriptorProto* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    DescriptorProto* copy = CreateMaybeMessage<DescriptorProto>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const DescriptorProto& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -1544,6 +1571,7 @@ class PROTOBUF_EXPORT DescriptorProto final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(DescriptorProto&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -1889,6 +1917,11 @@ class PROTOBUF_EXPORT ExtensionRangeOptions_Declaration final :
   ExtensionRangeOptions_Declaration* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<ExtensionRangeOptions_Declaration>(arena);
   }
+  ExtensionRangeOptions_Declaration* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    ExtensionRangeOptions_Declaration* copy = CreateMaybeMessage<ExtensionRangeOptions_Declaration>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const ExtensionRangeOptions_Declaration& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -2124,6 +2157,11 @@ class PROTOBUF_EXPORT ExtensionRangeOptions final :
   ExtensionRangeOptions* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<ExtensionRangeOptions>(arena);
   }
+  ExtensionRangeOptions* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    ExtensionRangeOptions* copy = CreateMaybeMessage<ExtensionRangeOptions>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const ExtensionRangeOptions& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -2133,6 +2171,7 @@ class PROTOBUF_EXPORT ExtensionRangeOptions final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(ExtensionRangeOptions&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -2497,6 +2536,11 @@ class PROTOBUF_EXPORT FieldDescriptorProto final :
   FieldDescriptorProto* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<FieldDescriptorProto>(arena);
   }
+  FieldDescriptorProto* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    FieldDescriptorProto* copy = CreateMaybeMessage<FieldDescriptorProto>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const FieldDescriptorProto& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -2876,6 +2920,11 @@ class PROTOBUF_EXPORT OneofDescriptorProto final :
   OneofDescriptorProto* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<OneofDescriptorProto>(arena);
   }
+  OneofDescriptorProto* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    OneofDescriptorProto* copy = CreateMaybeMessage<OneofDescriptorProto>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const OneofDescriptorProto& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -3057,6 +3106,11 @@ class PROTOBUF_EXPORT EnumDescriptorProto_EnumReservedRange final :
   EnumDescriptorProto_EnumReservedRange* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<EnumDescriptorProto_EnumReservedRange>(arena);
   }
+  EnumDescriptorProto_EnumReservedRange* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    EnumDescriptorProto_EnumReservedRange* copy = CreateMaybeMessage<EnumDescriptorProto_EnumReservedRange>(arena);
+    copy->CopyFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const EnumDescriptorProto_EnumReservedRange& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -3228,6 +3282,11 @@ class PROTOBUF_EXPORT EnumDescriptorProto final :
   EnumDescriptorProto* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<EnumDescriptorProto>(arena);
   }
+  EnumDescriptorProto* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    EnumDescriptorProto* copy = CreateMaybeMessage<EnumDescriptorProto>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const EnumDescriptorProto& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -3237,6 +3296,7 @@ class PROTOBUF_EXPORT EnumDescriptorProto final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(EnumDescriptorProto&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -3481,6 +3541,11 @@ class PROTOBUF_EXPORT EnumValueDescriptorProto final :
   EnumValueDescriptorProto* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<EnumValueDescriptorProto>(arena);
   }
+  EnumValueDescriptorProto* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    EnumValueDescriptorProto* copy = CreateMaybeMessage<EnumValueDescriptorProto>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const EnumValueDescriptorProto& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -3675,6 +3740,11 @@ class PROTOBUF_EXPORT ServiceDescriptorProto final :
   ServiceDescriptorProto* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<ServiceDescriptorProto>(arena);
   }
+  ServiceDescriptorProto* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    ServiceDescriptorProto* copy = CreateMaybeMessage<ServiceDescriptorProto>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const ServiceDescriptorProto& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -3684,6 +3754,7 @@ class PROTOBUF_EXPORT ServiceDescriptorProto final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(ServiceDescriptorProto&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -3876,6 +3947,11 @@ class PROTOBUF_EXPORT MethodDescriptorProto final :
   MethodDescriptorProto* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<MethodDescriptorProto>(arena);
   }
+  MethodDescriptorProto* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    MethodDescriptorProto* copy = CreateMaybeMessage<MethodDescriptorProto>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const MethodDescriptorProto& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -4121,6 +4197,11 @@ class PROTOBUF_EXPORT FileOptions final :
   FileOptions* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<FileOptions>(arena);
   }
+  FileOptions* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    FileOptions* copy = CreateMaybeMessage<FileOptions>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const FileOptions& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -4130,6 +4211,7 @@ class PROTOBUF_EXPORT FileOptions final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(FileOptions&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -4780,6 +4862,11 @@ class PROTOBUF_EXPORT MessageOptions final :
   MessageOptions* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<MessageOptions>(arena);
   }
+  MessageOptions* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    MessageOptions* copy = CreateMaybeMessage<MessageOptions>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const MessageOptions& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -4789,6 +4876,7 @@ class PROTOBUF_EXPORT MessageOptions final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(MessageOptions&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -5163,6 +5251,11 @@ class PROTOBUF_EXPORT FieldOptions final :
   FieldOptions* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<FieldOptions>(arena);
   }
+  FieldOptions* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    FieldOptions* copy = CreateMaybeMessage<FieldOptions>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const FieldOptions& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -5172,6 +5265,7 @@ class PROTOBUF_EXPORT FieldOptions final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(FieldOptions&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -5723,6 +5817,11 @@ class PROTOBUF_EXPORT OneofOptions final :
   OneofOptions* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<OneofOptions>(arena);
   }
+  OneofOptions* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    OneofOptions* copy = CreateMaybeMessage<OneofOptions>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const OneofOptions& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -5732,6 +5831,7 @@ class PROTOBUF_EXPORT OneofOptions final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(OneofOptions&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -6040,6 +6140,11 @@ class PROTOBUF_EXPORT EnumOptions final :
   EnumOptions* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<EnumOptions>(arena);
   }
+  EnumOptions* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    EnumOptions* copy = CreateMaybeMessage<EnumOptions>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const EnumOptions& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -6049,6 +6154,7 @@ class PROTOBUF_EXPORT EnumOptions final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(EnumOptions&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -6397,6 +6503,11 @@ class PROTOBUF_EXPORT EnumValueOptions final :
   EnumValueOptions* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<EnumValueOptions>(arena);
   }
+  EnumValueOptions* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    EnumValueOptions* copy = CreateMaybeMessage<EnumValueOptions>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const EnumValueOptions& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -6406,6 +6517,7 @@ class PROTOBUF_EXPORT EnumValueOptions final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(EnumValueOptions&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -6728,6 +6840,11 @@ class PROTOBUF_EXPORT ServiceOptions final :
   ServiceOptions* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<ServiceOptions>(arena);
   }
+  ServiceOptions* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    ServiceOptions* copy = CreateMaybeMessage<ServiceOptions>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const ServiceOptions& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -6737,6 +6854,7 @@ class PROTOBUF_EXPORT ServiceOptions final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(ServiceOptions&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -7059,6 +7177,11 @@ class PROTOBUF_EXPORT MethodOptions final :
   MethodOptions* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<MethodOptions>(arena);
   }
+  MethodOptions* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    MethodOptions* copy = CreateMaybeMessage<MethodOptions>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const MethodOptions& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -7068,6 +7191,7 @@ class PROTOBUF_EXPORT MethodOptions final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(MethodOptions&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -7424,6 +7548,11 @@ class PROTOBUF_EXPORT UninterpretedOption_NamePart final :
   UninterpretedOption_NamePart* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<UninterpretedOption_NamePart>(arena);
   }
+  UninterpretedOption_NamePart* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    UninterpretedOption_NamePart* copy = CreateMaybeMessage<UninterpretedOption_NamePart>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const UninterpretedOption_NamePart& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -7604,6 +7733,11 @@ class PROTOBUF_EXPORT UninterpretedOption final :
   UninterpretedOption* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<UninterpretedOption>(arena);
   }
+  UninterpretedOption* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    UninterpretedOption* copy = CreateMaybeMessage<UninterpretedOption>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const UninterpretedOption& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -7613,6 +7747,7 @@ class PROTOBUF_EXPORT UninterpretedOption final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(UninterpretedOption&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -7867,6 +8002,11 @@ class PROTOBUF_EXPORT SourceCodeInfo_Location final :
   SourceCodeInfo_Location* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<SourceCodeInfo_Location>(arena);
   }
+  SourceCodeInfo_Location* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    SourceCodeInfo_Location* copy = CreateMaybeMessage<SourceCodeInfo_Location>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const SourceCodeInfo_Location& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -7876,6 +8016,7 @@ class PROTOBUF_EXPORT SourceCodeInfo_Location final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(SourceCodeInfo_Location&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -8122,6 +8263,11 @@ class PROTOBUF_EXPORT SourceCodeInfo final :
   SourceCodeInfo* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<SourceCodeInfo>(arena);
   }
+  SourceCodeInfo* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    SourceCodeInfo* copy = CreateMaybeMessage<SourceCodeInfo>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const SourceCodeInfo& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -8131,6 +8277,7 @@ class PROTOBUF_EXPORT SourceCodeInfo final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(SourceCodeInfo&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -8288,6 +8435,11 @@ class PROTOBUF_EXPORT GeneratedCodeInfo_Annotation final :
   GeneratedCodeInfo_Annotation* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<GeneratedCodeInfo_Annotation>(arena);
   }
+  GeneratedCodeInfo_Annotation* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    GeneratedCodeInfo_Annotation* copy = CreateMaybeMessage<GeneratedCodeInfo_Annotation>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const GeneratedCodeInfo_Annotation& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -8533,6 +8685,11 @@ class PROTOBUF_EXPORT GeneratedCodeInfo final :
   GeneratedCodeInfo* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<GeneratedCodeInfo>(arena);
   }
+  GeneratedCodeInfo* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    GeneratedCodeInfo* copy = CreateMaybeMessage<GeneratedCodeInfo>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const GeneratedCodeInfo& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -8542,6 +8699,7 @@ class PROTOBUF_EXPORT GeneratedCodeInfo final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(GeneratedCodeInfo&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
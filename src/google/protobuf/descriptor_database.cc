@@ -35,11 +35,17 @@
 #include "google/protobuf/descriptor_database.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 #include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_replace.h"
@@ -413,11 +419,14 @@ class EncodedDescriptorDatabase::DescriptorIndex {
   Value FindFile(absl::string_view filename);
   Value FindSymbol(absl::string_view name);
   Value FindSymbolOnlyFlat(absl::string_view name) const;
+  Value FindSymbolHashed(absl::string_view name) const;
   Value FindExtension(absl::string_view containing_type, int field_number);
   bool FindAllExtensionNumbers(absl::string_view containing_type,
                                std::vector<int>* output);
   void FindAllFileNames(std::vector<std::string>* output) const;
 
+  void EnableHashIndex() { hash_index_enabled_ = true; }
+
  private:
   friend class EncodedDescriptorDatabase;
 
@@ -562,10 +571,102 @@ class EncodedDescriptorDatabase::DescriptorIndex {
   absl::btree_set<ExtensionEntry, ExtensionCompare> by_extension_{
       ExtensionCompare{*this}};
   std::vector<ExtensionEntry> by_extension_flat_;
+
+  // Optional hash indexes over the flat vectors above, holding positions in
+  // them.  They are rebuilt by EnsureFlat() whenever the vectors change.
+  void BuildHashIndex();
+
+  // Symbols are keyed by (package, name).  Since the indexed names are
+  // top-level, a full name splits into that pair at its last '.'.
+  using SymbolKey = std::pair<absl::string_view, absl::string_view>;
+  struct SymbolPositionHash {
+    using is_transparent = void;
+    const DescriptorIndex& index;
+
+    size_t operator()(SymbolKey key) const { return absl::HashOf(key); }
+    size_t operator()(int i) const { return (*this)(index.SymbolKeyAt(i)); }
+  };
+  struct SymbolPositionEq {
+    using is_transparent = void;
+    const DescriptorIndex& index;
+
+    bool operator()(int a, int b) const { return a == b; }
+    bool operator()(int a, SymbolKey b) const {
+      return index.SymbolKeyAt(a) == b;
+    }
+    bool operator()(SymbolKey a, int b) const { return (*this)(b, a); }
+  };
+  SymbolKey SymbolKeyAt(int i) const {
+    return {by_symbol_flat_[i].package(*this),
+            by_symbol_flat_[i].symbol(*this)};
+  }
+
+  // Extensions are keyed by (extendee, number).
+  using ExtensionKey = std::tuple<absl::string_view, int>;
+  struct ExtensionPositionHash {
+    using is_transparent = void;
+    const DescriptorIndex& index;
+
+    size_t operator()(ExtensionKey key) const { return absl::HashOf(key); }
+    size_t operator()(int i) const { return (*this)(index.ExtensionKeyAt(i)); }
+  };
+  struct ExtensionPositionEq {
+    using is_transparent = void;
+    const DescriptorIndex& index;
+
+    bool operator()(int a, int b) const { return a == b; }
+    bool operator()(int a, ExtensionKey b) const {
+      return index.ExtensionKeyAt(a) == b;
+    }
+    bool operator()(ExtensionKey a, int b) const { return (*this)(b, a); }
+  };
+  ExtensionKey ExtensionKeyAt(int i) const {
+    return {by_extension_flat_[i].extendee(*this),
+            by_extension_flat_[i].extension_number};
+  }
+
+  // Extendees point at the first entry of their run in by_extension_flat_.
+  struct ExtendeePositionHash {
+    using is_transparent = void;
+    const DescriptorIndex& index;
+
+    size_t operator()(absl::string_view key) const { return absl::HashOf(key); }
+    size_t operator()(int i) const {
+      return (*this)(index.by_extension_flat_[i].extendee(index));
+    }
+  };
+  struct ExtendeePositionEq {
+    using is_transparent = void;
+    const DescriptorIndex& index;
+
+    bool operator()(int a, int b) const { return a == b; }
+    bool operator()(int a, absl::string_view b) const {
+      return index.by_extension_flat_[a].extendee(index) == b;
+    }
+    bool operator()(absl::string_view a, int b) const { return (*this)(b, a); }
+  };
+
+  bool hash_index_enabled_ = false;
+  // Whether the hash indexes are missing or out of date.
+  bool hash_index_stale_ = true;
+  // False if some symbol name contains a '.', which the hash index cannot
+  // split correctly; lookups then fall back to the binary search.
+  bool hash_index_usable_ = false;
+  absl::flat_hash_set<int, SymbolPositionHash, SymbolPositionEq>
+      symbols_by_hash_{0, SymbolPositionHash{*this}, SymbolPositionEq{*this}};
+  absl::flat_hash_set<int, ExtensionPositionHash, ExtensionPositionEq>
+      extensions_by_hash_{0, ExtensionPositionHash{*this},
+                          ExtensionPositionEq{*this}};
+  absl::flat_hash_set<int, ExtendeePositionHash, ExtendeePositionEq>
+      extendees_by_hash_{0, ExtendeePositionHash{*this},
+                         ExtendeePositionEq{*this}};
 };
 
 bool EncodedDescriptorDatabase::Add(const void* encoded_file_descriptor,
                                     int size) {
+  // Keep the order in which files were added, so that conflicts are reported
+  // against the same file either way.
+  IndexDeferred();
   FileDescriptorProto file;
   if (file.ParseFromArray(encoded_file_descriptor, size)) {
     return index_->AddFile(file, std::make_pair(encoded_file_descriptor, size));
@@ -584,18 +685,57 @@ bool EncodedDescriptorDatabase::AddCopy(const void* encoded_file_descriptor,
   return Add(copy, size);
 }
 
+void EncodedDescriptorDatabase::AddDeferred(
+    const void* encoded_file_descriptor, int size) {
+  deferred_.emplace_back(encoded_file_descriptor, size);
+}
+
+void EncodedDescriptorDatabase::IndexDeferredSlow() {
+  std::vector<std::pair<const void*, int>> deferred;
+  deferred.swap(deferred_);
+  for (const auto& file : deferred) {
+    ABSL_CHECK(Add(file.first, file.second));
+  }
+}
+
 bool EncodedDescriptorDatabase::FindFileByName(const std::string& filename,
                                                FileDescriptorProto* output) {
+  IndexDeferred();
   return MaybeParse(index_->FindFile(filename), output);
 }
 
 bool EncodedDescriptorDatabase::FindFileContainingSymbol(
     const std::string& symbol_name, FileDescriptorProto* output) {
+  IndexDeferred();
   return MaybeParse(index_->FindSymbol(symbol_name), output);
 }
 
+void EncodedDescriptorDatabase::EnableHashIndex() { index_->EnableHashIndex(); }
+
+bool EncodedDescriptorDatabase::FindFilesContainingSymbols(
+    const std::vector<std::string>& symbol_names,
+    std::vector<FileDescriptorProto>* output) {
+  IndexDeferred();
+  bool success = true;
+  absl::flat_hash_set<const void*> seen;
+  for (const std::string& name : symbol_names) {
+    auto encoded_file = index_->FindSymbol(name);
+    if (encoded_file.first == nullptr) {
+      success = false;
+    } else if (seen.insert(encoded_file.first).second) {
+      output->emplace_back();
+      if (!MaybeParse(encoded_file, &output->back())) {
+        output->pop_back();
+        success = false;
+      }
+    }
+  }
+  return success;
+}
+
 bool EncodedDescriptorDatabase::FindNameOfFileContainingSymbol(
     const std::string& symbol_name, std::string* output) {
+  IndexDeferred();
   auto encoded_file = index_->FindSymbol(symbol_name);
   if (encoded_file.first == nullptr) return false;
 
@@ -625,12 +765,14 @@ bool EncodedDescriptorDatabase::FindNameOfFileContainingSymbol(
 bool EncodedDescriptorDatabase::FindFileContainingExtension(
     const std::string& containing_type, int field_number,
     FileDescriptorProto* output) {
+  IndexDeferred();
   return MaybeParse(index_->FindExtension(containing_type, field_number),
                     output);
 }
 
 bool EncodedDescriptorDatabase::FindAllExtensionNumbers(
     const std::string& extendee_type, std::vector<int>* output) {
+  IndexDeferred();
   return index_->FindAllExtensionNumbers(extendee_type, output);
 }
 
@@ -786,9 +928,30 @@ bool EncodedDescriptorDatabase::DescriptorIndex::AddExtension(
 std::pair<const void*, int>
 EncodedDescriptorDatabase::DescriptorIndex::FindSymbol(absl::string_view name) {
   EnsureFlat();
+  if (hash_index_usable_) return FindSymbolHashed(name);
   return FindSymbolOnlyFlat(name);
 }
 
+std::pair<const void*, int>
+EncodedDescriptorDatabase::DescriptorIndex::FindSymbolHashed(
+    absl::string_view name) const {
+  // `name` matches an indexed symbol if it is that symbol or one of its
+  // sub-symbols, so try each of its prefixes, longest first.
+  while (true) {
+    size_t dot_pos = name.rfind('.');
+    SymbolKey key = dot_pos == absl::string_view::npos
+                        ? SymbolKey(absl::string_view(), name)
+                        : SymbolKey(name.substr(0, dot_pos),
+                                    name.substr(dot_pos + 1));
+    auto it = symbols_by_hash_.find(key);
+    if (it != symbols_by_hash_.end()) {
+      return all_values_[by_symbol_flat_[*it].data_offset].value();
+    }
+    if (dot_pos == absl::string_view::npos) return Value();
+    name = name.substr(0, dot_pos);
+  }
+}
+
 std::pair<const void*, int>
 EncodedDescriptorDatabase::DescriptorIndex::FindSymbolOnlyFlat(
     absl::string_view name) const {
@@ -806,6 +969,14 @@ EncodedDescriptorDatabase::DescriptorIndex::FindExtension(
     absl::string_view containing_type, int field_number) {
   EnsureFlat();
 
+  if (hash_index_usable_) {
+    auto it = extensions_by_hash_.find(
+        std::make_tuple(containing_type, field_number));
+    return it == extensions_by_hash_.end()
+               ? std::make_pair(nullptr, 0)
+               : all_values_[by_extension_flat_[*it].data_offset].value();
+  }
+
   auto it = std::lower_bound(
       by_extension_flat_.begin(), by_extension_flat_.end(),
       std::make_tuple(containing_type, field_number), by_extension_.key_comp());
@@ -828,10 +999,40 @@ static void MergeIntoFlat(absl::btree_set<T, Less>* s, std::vector<T>* flat) {
 
 void EncodedDescriptorDatabase::DescriptorIndex::EnsureFlat() {
   all_values_.shrink_to_fit();
+  if (!by_symbol_.empty() || !by_extension_.empty()) hash_index_stale_ = true;
   // Merge each of the sets into their flat counterpart.
   MergeIntoFlat(&by_name_, &by_name_flat_);
   MergeIntoFlat(&by_symbol_, &by_symbol_flat_);
   MergeIntoFlat(&by_extension_, &by_extension_flat_);
+  if (hash_index_enabled_ && hash_index_stale_) BuildHashIndex();
+}
+
+void EncodedDescriptorDatabase::DescriptorIndex::BuildHashIndex() {
+  hash_index_stale_ = false;
+  hash_index_usable_ = true;
+  symbols_by_hash_.clear();
+  symbols_by_hash_.reserve(by_symbol_flat_.size());
+  for (int i = 0; i < static_cast<int>(by_symbol_flat_.size()); ++i) {
+    if (by_symbol_flat_[i].symbol(*this).find('.') !=
+        absl::string_view::npos) {
+      hash_index_usable_ = false;
+      symbols_by_hash_.clear();
+      extensions_by_hash_.clear();
+      extendees_by_hash_.clear();
+      return;
+    }
+    symbols_by_hash_.insert(i);
+  }
+  extensions_by_hash_.clear();
+  extensions_by_hash_.reserve(by_extension_flat_.size());
+  extendees_by_hash_.clear();
+  for (int i = 0; i < static_cast<int>(by_extension_flat_.size()); ++i) {
+    extensions_by_hash_.insert(i);
+    if (i == 0 || by_extension_flat_[i].extendee(*this) !=
+                      by_extension_flat_[i - 1].extendee(*this)) {
+      extendees_by_hash_.insert(i);
+    }
+  }
 }
 
 bool EncodedDescriptorDatabase::DescriptorIndex::FindAllExtensionNumbers(
@@ -839,9 +1040,15 @@ bool EncodedDescriptorDatabase::DescriptorIndex::FindAllExtensionNumbers(
   EnsureFlat();
 
   bool success = false;
-  auto it = std::lower_bound(
-      by_extension_flat_.begin(), by_extension_flat_.end(),
-      std::make_tuple(containing_type, 0), by_extension_.key_comp());
+  auto it = by_extension_flat_.end();
+  if (hash_index_usable_) {
+    auto run = extendees_by_hash_.find(containing_type);
+    if (run != extendees_by_hash_.end()) it = by_extension_flat_.begin() + *run;
+  } else {
+    it = std::lower_bound(by_extension_flat_.begin(), by_extension_flat_.end(),
+                          std::make_tuple(containing_type, 0),
+                          by_extension_.key_comp());
+  }
   for (;
        it != by_extension_flat_.end() && it->extendee(*this) == containing_type;
        ++it) {
@@ -881,6 +1088,7 @@ EncodedDescriptorDatabase::DescriptorIndex::FindFile(
 
 bool EncodedDescriptorDatabase::FindAllFileNames(
     std::vector<std::string>* output) {
+  IndexDeferred();
   index_->FindAllFileNames(output);
   return true;
 }
@@ -900,6 +1108,327 @@ EncodedDescriptorDatabase::~EncodedDescriptorDatabase() {
   }
 }
 
+// -------------------------------------------------------------------
+// Descriptor images.
+//
+// An image starts with an ImageHeader, followed by the file, symbol and
+// extension tables, each sorted by its key, and then the bytes of all the
+// strings and encoded files they refer to.  Everything is addressed by its
+// offset from the start of the image, so it can be loaded at any address.
+
+namespace {
+
+constexpr char kImageMagic[4] = {'p', 'b', 'd', 'i'};
+constexpr uint32_t kImageVersion = 1;
+
+struct ImageHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t file_count;
+  uint32_t symbol_count;
+  uint32_t extension_count;
+  uint32_t files_offset;
+  uint32_t symbols_offset;
+  uint32_t extensions_offset;
+};
+
+struct ImageString {
+  uint32_t offset;
+  uint32_t size;
+};
+
+struct ImageFile {
+  ImageString name;
+  ImageString data;  // The encoded FileDescriptorProto.
+};
+
+struct ImageSymbol {
+  ImageString name;  // Fully-qualified.
+  uint32_t file;
+};
+
+struct ImageExtension {
+  ImageString extendee;  // Fully-qualified, without the leading '.'.
+  int32_t number;
+  uint32_t file;
+};
+
+const ImageHeader& GetImageHeader(const char* image) {
+  return *reinterpret_cast<const ImageHeader*>(image);
+}
+
+template <typename Record>
+const Record* GetImageTable(const char* image, uint32_t offset) {
+  return reinterpret_cast<const Record*>(image + offset);
+}
+
+absl::string_view GetImageString(const char* image, ImageString str) {
+  return absl::string_view(image + str.offset, str.size);
+}
+
+}  // namespace
+
+bool EncodedDescriptorDatabase::WriteImage(std::string* output) {
+  IndexDeferred();
+  DescriptorIndex& index = *index_;
+  index.EnsureFlat();
+
+  // Symbols and extensions refer to files by their position in the sorted
+  // file table.  Values without a file entry were rejected by AddFile().
+  std::vector<int> file_of_value(index.all_values_.size(), -1);
+  for (size_t i = 0; i < index.by_name_flat_.size(); ++i) {
+    file_of_value[index.by_name_flat_[i].data_offset] = static_cast<int>(i);
+  }
+  // The flat tables are already sorted the way the image needs them.
+  std::vector<std::pair<std::string, int>> symbols;
+  for (const auto& entry : index.by_symbol_flat_) {
+    int file = file_of_value[entry.data_offset];
+    if (file >= 0) symbols.emplace_back(entry.AsString(index), file);
+  }
+  std::vector<const DescriptorIndex::ExtensionEntry*> extensions;
+  for (const auto& entry : index.by_extension_flat_) {
+    if (file_of_value[entry.data_offset] >= 0) extensions.push_back(&entry);
+  }
+
+  const size_t files_offset = sizeof(ImageHeader);
+  const size_t symbols_offset =
+      files_offset + index.by_name_flat_.size() * sizeof(ImageFile);
+  const size_t extensions_offset =
+      symbols_offset + symbols.size() * sizeof(ImageSymbol);
+  const size_t strings_offset =
+      extensions_offset + extensions.size() * sizeof(ImageExtension);
+
+  std::string image(strings_offset, '\0');
+  auto append = [&image](absl::string_view str) {
+    ImageString result = {static_cast<uint32_t>(image.size()),
+                          static_cast<uint32_t>(str.size())};
+    image.append(str.data(), str.size());
+    return result;
+  };
+
+  std::vector<ImageFile> file_records;
+  file_records.reserve(index.by_name_flat_.size());
+  for (const auto& entry : index.by_name_flat_) {
+    const auto& value = index.all_values_[entry.data_offset];
+    ImageFile record;
+    record.name = append(entry.name(index));
+    record.data = append(absl::string_view(
+        static_cast<const char*>(value.data), value.size));
+    file_records.push_back(record);
+  }
+  std::vector<ImageSymbol> symbol_records;
+  symbol_records.reserve(symbols.size());
+  for (const auto& symbol : symbols) {
+    symbol_records.push_back(
+        {append(symbol.first), static_cast<uint32_t>(symbol.second)});
+  }
+  std::vector<ImageExtension> extension_records;
+  extension_records.reserve(extensions.size());
+  for (const auto* entry : extensions) {
+    extension_records.push_back(
+        {append(entry->extendee(index)), entry->extension_number,
+         static_cast<uint32_t>(file_of_value[entry->data_offset])});
+  }
+
+  if (image.size() > std::numeric_limits<uint32_t>::max()) {
+    ABSL_LOG(ERROR) << "Descriptor image would be too large: " << image.size()
+                    << " bytes.";
+    return false;
+  }
+
+  // All offsets fit in 32 bits now that the whole image does.
+  ImageHeader header;
+  memcpy(header.magic, kImageMagic, sizeof(header.magic));
+  header.version = kImageVersion;
+  header.file_count = static_cast<uint32_t>(file_records.size());
+  header.symbol_count = static_cast<uint32_t>(symbol_records.size());
+  header.extension_count = static_cast<uint32_t>(extension_records.size());
+  header.files_offset = static_cast<uint32_t>(files_offset);
+  header.symbols_offset = static_cast<uint32_t>(symbols_offset);
+  header.extensions_offset = static_cast<uint32_t>(extensions_offset);
+  memcpy(&image[0], &header, sizeof(header));
+  if (!file_records.empty()) {
+    memcpy(&image[files_offset], file_records.data(),
+           file_records.size() * sizeof(ImageFile));
+  }
+  if (!symbol_records.empty()) {
+    memcpy(&image[symbols_offset], symbol_records.data(),
+           symbol_records.size() * sizeof(ImageSymbol));
+  }
+  if (!extension_records.empty()) {
+    memcpy(&image[extensions_offset], extension_records.data(),
+           extension_records.size() * sizeof(ImageExtension));
+  }
+  *output = std::move(image);
+  return true;
+}
+
+// ===================================================================
+
+MappedDescriptorDatabase::MappedDescriptorDatabase() {}
+MappedDescriptorDatabase::~MappedDescriptorDatabase() {}
+
+bool MappedDescriptorDatabase::Init(const void* image, size_t size) {
+  image_ = nullptr;
+  const char* bytes = static_cast<const char*>(image);
+  if (reinterpret_cast<uintptr_t>(bytes) % alignof(ImageHeader) != 0) {
+    ABSL_LOG(ERROR) << "Descriptor image is not 4-byte aligned.";
+    return false;
+  }
+  if (size < sizeof(ImageHeader) ||
+      memcmp(GetImageHeader(bytes).magic, kImageMagic, sizeof(kImageMagic)) !=
+          0 ||
+      GetImageHeader(bytes).version != kImageVersion) {
+    ABSL_LOG(ERROR) << "Data is not a descriptor image of a supported version.";
+    return false;
+  }
+
+  // Check every offset up front, so lookups can trust them.  The tables are
+  // small next to the encoded files, which are not touched.
+  const ImageHeader& header = GetImageHeader(bytes);
+  auto table_fits = [size](uint32_t offset, uint32_t count,
+                           size_t record_size) {
+    return offset % alignof(ImageHeader) == 0 && offset <= size &&
+           count <= (size - offset) / record_size;
+  };
+  auto string_fits = [size](ImageString str) {
+    return str.offset <= size && str.size <= size - str.offset;
+  };
+  bool valid = table_fits(header.files_offset, header.file_count,
+                          sizeof(ImageFile)) &&
+               table_fits(header.symbols_offset, header.symbol_count,
+                          sizeof(ImageSymbol)) &&
+               table_fits(header.extensions_offset, header.extension_count,
+                          sizeof(ImageExtension));
+  if (valid) {
+    const auto* files = GetImageTable<ImageFile>(bytes, header.files_offset);
+    for (uint32_t i = 0; valid && i < header.file_count; ++i) {
+      valid = string_fits(files[i].name) && string_fits(files[i].data) &&
+              files[i].data.size <= std::numeric_limits<int>::max();
+    }
+    const auto* symbols =
+        GetImageTable<ImageSymbol>(bytes, header.symbols_offset);
+    for (uint32_t i = 0; valid && i < header.symbol_count; ++i) {
+      valid = string_fits(symbols[i].name) &&
+              symbols[i].file < header.file_count;
+    }
+    const auto* extensions =
+        GetImageTable<ImageExtension>(bytes, header.extensions_offset);
+    for (uint32_t i = 0; valid && i < header.extension_count; ++i) {
+      valid = string_fits(extensions[i].extendee) &&
+              extensions[i].file < header.file_count;
+    }
+  }
+  if (!valid) {
+    ABSL_LOG(ERROR) << "Descriptor image is corrupt.";
+    return false;
+  }
+
+  image_ = bytes;
+  return true;
+}
+
+bool MappedDescriptorDatabase::ParseFile(uint32_t file,
+                                         FileDescriptorProto* output) const {
+  const ImageFile& record = GetImageTable<ImageFile>(
+      image_, GetImageHeader(image_).files_offset)[file];
+  return output->ParseFromArray(image_ + record.data.offset,
+                                static_cast<int>(record.data.size));
+}
+
+bool MappedDescriptorDatabase::FindFileByName(const std::string& filename,
+                                              FileDescriptorProto* output) {
+  if (image_ == nullptr) return false;
+  const ImageHeader& header = GetImageHeader(image_);
+  const auto* begin = GetImageTable<ImageFile>(image_, header.files_offset);
+  const auto* end = begin + header.file_count;
+  const auto* it = std::lower_bound(
+      begin, end, filename,
+      [this](const ImageFile& file, absl::string_view name) {
+        return GetImageString(image_, file.name) < name;
+      });
+  if (it == end || GetImageString(image_, it->name) != filename) return false;
+  return ParseFile(static_cast<uint32_t>(it - begin), output);
+}
+
+bool MappedDescriptorDatabase::FindFileContainingSymbol(
+    const std::string& symbol_name, FileDescriptorProto* output) {
+  if (image_ == nullptr) return false;
+  const ImageHeader& header = GetImageHeader(image_);
+  const auto* begin = GetImageTable<ImageSymbol>(image_, header.symbols_offset);
+  const auto* end = begin + header.symbol_count;
+  // Like the other databases, match the last symbol which sorts less than or
+  // equal to the name if it is the name itself or one of its parents.
+  const auto* it = std::upper_bound(
+      begin, end, symbol_name,
+      [this](absl::string_view name, const ImageSymbol& symbol) {
+        return name < GetImageString(image_, symbol.name);
+      });
+  if (it == begin) return false;
+  --it;
+  if (!IsSubSymbol(GetImageString(image_, it->name), symbol_name)) {
+    return false;
+  }
+  return ParseFile(it->file, output);
+}
+
+bool MappedDescriptorDatabase::FindFileContainingExtension(
+    const std::string& containing_type, int field_number,
+    FileDescriptorProto* output) {
+  if (image_ == nullptr) return false;
+  const ImageHeader& header = GetImageHeader(image_);
+  const auto* begin =
+      GetImageTable<ImageExtension>(image_, header.extensions_offset);
+  const auto* end = begin + header.extension_count;
+  const auto key = std::make_tuple(absl::string_view(containing_type),
+                                   field_number);
+  const auto* it = std::lower_bound(
+      begin, end, key,
+      [this](const ImageExtension& extension,
+             const std::tuple<absl::string_view, int>& key) {
+        return std::make_tuple(GetImageString(image_, extension.extendee),
+                               extension.number) < key;
+      });
+  if (it == end || GetImageString(image_, it->extendee) != containing_type ||
+      it->number != field_number) {
+    return false;
+  }
+  return ParseFile(it->file, output);
+}
+
+bool MappedDescriptorDatabase::FindAllExtensionNumbers(
+    const std::string& extendee_type, std::vector<int>* output) {
+  if (image_ == nullptr) return false;
+  const ImageHeader& header = GetImageHeader(image_);
+  const auto* begin =
+      GetImageTable<ImageExtension>(image_, header.extensions_offset);
+  const auto* end = begin + header.extension_count;
+  const auto* it = std::lower_bound(
+      begin, end, extendee_type,
+      [this](const ImageExtension& extension, absl::string_view extendee) {
+        return GetImageString(image_, extension.extendee) < extendee;
+      });
+  bool success = false;
+  for (; it != end && GetImageString(image_, it->extendee) == extendee_type;
+       ++it) {
+    output->push_back(it->number);
+    success = true;
+  }
+  return success;
+}
+
+bool MappedDescriptorDatabase::FindAllFileNames(
+    std::vector<std::string>* output) {
+  if (image_ == nullptr) return true;
+  const ImageHeader& header = GetImageHeader(image_);
+  const auto* files = GetImageTable<ImageFile>(image_, header.files_offset);
+  output->reserve(output->size() + header.file_count);
+  for (uint32_t i = 0; i < header.file_count; ++i) {
+    output->emplace_back(GetImageString(image_, files[i].name));
+  }
+  return true;
+}
+
 // ===================================================================
 
 DescriptorPoolDatabase::DescriptorPoolDatabase(const DescriptorPool& pool)
@@ -59,6 +59,7 @@ namespace protobuf {
 class DescriptorDatabase;
 class SimpleDescriptorDatabase;
 class EncodedDescriptorDatabase;
+class MappedDescriptorDatabase;
 class DescriptorPoolDatabase;
 class MergedDescriptorDatabase;
 
@@ -305,10 +306,36 @@ class PROTOBUF_EXPORT EncodedDescriptorDatabase : public DescriptorDatabase {
   // need to keep it around.
   bool AddCopy(const void* encoded_file_descriptor, int size);
 
+  // Like Add(), but only remembers the bytes.  They are parsed and indexed
+  // the first time the database is queried, which keeps that work out of
+  // static initialization when generated code registers its files.  As any
+  // error only shows up then, invalid or conflicting files are fatal.
+  void AddDeferred(const void* encoded_file_descriptor, int size);
+
+  // Also indexes symbols and extensions in hash tables, so that symbol and
+  // extension lookups take a few hash probes instead of a binary search over
+  // every entry.  The tables are (re)built on the first lookup after files are
+  // added and cost several more bytes per symbol and extension.  Off by
+  // default.
+  void EnableHashIndex();
+
   // Like FindFileContainingSymbol but returns only the name of the file.
   bool FindNameOfFileContainingSymbol(const std::string& symbol_name,
                                       std::string* output);
 
+  // Looks up all of the given symbols at once and adds the files containing
+  // them to *output, each file only once no matter how many of the symbols it
+  // defines.  Returns false if any symbol was not found or a file could not be
+  // parsed; the files which were found are still added.
+  bool FindFilesContainingSymbols(const std::vector<std::string>& symbol_names,
+                                  std::vector<FileDescriptorProto>* output);
+
+  // Writes all files in the database, along with the index used to look them
+  // up, to *output as a single relocatable image which can be served by
+  // MappedDescriptorDatabase.  Returns false and logs an error if the image
+  // would be too large.
+  bool WriteImage(std::string* output);
+
   // implements DescriptorDatabase -----------------------------------
   bool FindFileByName(const std::string& filename,
                       FileDescriptorProto* output) override;
@@ -327,6 +354,14 @@ class PROTOBUF_EXPORT EncodedDescriptorDatabase : public DescriptorDatabase {
   // cleaner header.
   std::unique_ptr<DescriptorIndex> index_;
   std::vector<void*> files_to_delete_;
+  // Files passed to AddDeferred() which are not in index_ yet.
+  std::vector<std::pair<const void*, int>> deferred_;
+
+  // Adds the files in deferred_ to index_.  Called before every lookup.
+  void IndexDeferred() {
+    if (!deferred_.empty()) IndexDeferredSlow();
+  }
+  void IndexDeferredSlow();
 
   // If encoded_file.first is non-nullptr, parse the data into *output and
   // return true, otherwise return false.
@@ -334,6 +369,47 @@ class PROTOBUF_EXPORT EncodedDescriptorDatabase : public DescriptorDatabase {
                   FileDescriptorProto* output);
 };
 
+// A DescriptorDatabase which serves files straight out of an image written by
+// EncodedDescriptorDatabase::WriteImage().  Nothing is parsed or indexed when
+// the image is loaded, so it can be mmap()ed and used immediately, and its
+// pages are shared by every process which maps the same file.  Wrapping it in
+// a DescriptorPool then builds descriptors only as they are needed.
+//
+// Images use the byte order of the machine that wrote them.
+class PROTOBUF_EXPORT MappedDescriptorDatabase : public DescriptorDatabase {
+ public:
+  MappedDescriptorDatabase();
+  MappedDescriptorDatabase(const MappedDescriptorDatabase&) = delete;
+  MappedDescriptorDatabase& operator=(const MappedDescriptorDatabase&) =
+      delete;
+  ~MappedDescriptorDatabase() override;
+
+  // Serves the given image, replacing any previous one.  The database does not
+  // make a copy of the bytes, which must be 4-byte aligned and remain valid for
+  // the life of the database.  Returns false and logs an error, leaving the
+  // database empty, if the bytes are not a valid image.
+  bool Init(const void* image, size_t size);
+
+  // implements DescriptorDatabase -----------------------------------
+  bool FindFileByName(const std::string& filename,
+                      FileDescriptorProto* output) override;
+  bool FindFileContainingSymbol(const std::string& symbol_name,
+                                FileDescriptorProto* output) override;
+  bool FindFileContainingExtension(const std::string& containing_type,
+                                   int field_number,
+                                   FileDescriptorProto* output) override;
+  bool FindAllExtensionNumbers(const std::string& extendee_type,
+                               std::vector<int>* output) override;
+  bool FindAllFileNames(std::vector<std::string>* output) override;
+
+ private:
+  // Parses the file at the given index of the image's file table.
+  bool ParseFile(uint32_t file, FileDescriptorProto* output) const;
+
+  // nullptr until Init() succeeds.
+  const char* image_ = nullptr;
+};
+
 // A DescriptorDatabase that fetches files from a given pool.
 class PROTOBUF_EXPORT DescriptorPoolDatabase : public DescriptorDatabase {
  public:
@@ -37,7 +37,10 @@
 #include "google/protobuf/descriptor_database.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <string>
 
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor.h"
@@ -113,6 +116,11 @@ class EncodedDescriptorDatabaseTestCase : public DescriptorDatabaseTestCase {
   static DescriptorDatabaseTestCase* New() {
     return new EncodedDescriptorDatabaseTestCase;
   }
+  static DescriptorDatabaseTestCase* NewHashed() {
+    auto* test_case = new EncodedDescriptorDatabaseTestCase;
+    test_case->database_.EnableHashIndex();
+    return test_case;
+  }
 
   virtual ~EncodedDescriptorDatabaseTestCase() {}
 
@@ -127,6 +135,32 @@ class EncodedDescriptorDatabaseTestCase : public DescriptorDatabaseTestCase {
   EncodedDescriptorDatabase database_;
 };
 
+// Specialization for MappedDescriptorDatabase, which serves an image of an
+// EncodedDescriptorDatabase that is rewritten after every addition.
+class MappedDescriptorDatabaseTestCase : public DescriptorDatabaseTestCase {
+ public:
+  static DescriptorDatabaseTestCase* New() {
+    return new MappedDescriptorDatabaseTestCase;
+  }
+
+  virtual ~MappedDescriptorDatabaseTestCase() {}
+
+  virtual DescriptorDatabase* GetDatabase() { return &database_; }
+  virtual bool AddToDatabase(const FileDescriptorProto& file) {
+    std::string data;
+    file.SerializeToString(&data);
+    bool added = source_.AddCopy(data.data(), data.size());
+    EXPECT_TRUE(source_.WriteImage(&image_));
+    EXPECT_TRUE(database_.Init(image_.data(), image_.size()));
+    return added;
+  }
+
+ private:
+  EncodedDescriptorDatabase source_;
+  std::string image_;
+  MappedDescriptorDatabase database_;
+};
+
 // Specialization for DescriptorPoolDatabase.
 class DescriptorPoolDatabaseTestCase : public DescriptorDatabaseTestCase {
  public:
@@ -476,6 +510,12 @@ INSTANTIATE_TEST_CASE_P(
 INSTANTIATE_TEST_CASE_P(
     MemoryConserving, DescriptorDatabaseTest,
     testing::Values(&EncodedDescriptorDatabaseTestCase::New));
+INSTANTIATE_TEST_CASE_P(
+    Hashed, DescriptorDatabaseTest,
+    testing::Values(&EncodedDescriptorDatabaseTestCase::NewHashed));
+INSTANTIATE_TEST_CASE_P(
+    Mapped, DescriptorDatabaseTest,
+    testing::Values(&MappedDescriptorDatabaseTestCase::New));
 INSTANTIATE_TEST_CASE_P(Pool, DescriptorDatabaseTest,
                         testing::Values(&DescriptorPoolDatabaseTestCase::New));
 
@@ -515,6 +555,130 @@ TEST(EncodedDescriptorDatabaseExtraTest, FindNameOfFileContainingSymbol) {
   EXPECT_FALSE(db.FindNameOfFileContainingSymbol("baz.Baz", &filename));
 }
 
+TEST(EncodedDescriptorDatabaseExtraTest, FindFilesContainingSymbols) {
+  FileDescriptorProto file1, file2;
+  file1.set_name("foo.proto");
+  file1.set_package("foo");
+  file1.add_message_type()->set_name("Foo");
+  file1.add_enum_type()->set_name("FooEnum");
+  file2.set_name("bar.proto");
+  file2.set_package("bar");
+  file2.add_message_type()->set_name("Bar");
+  std::string data1 = file1.SerializeAsString();
+  std::string data2 = file2.SerializeAsString();
+
+  EncodedDescriptorDatabase db;
+  db.EnableHashIndex();
+  ASSERT_TRUE(db.Add(data1.data(), data1.size()));
+
+  std::vector<FileDescriptorProto> files;
+  EXPECT_TRUE(db.FindFilesContainingSymbols(
+      {"foo.Foo", "foo.FooEnum", "foo.Foo.Nested"}, &files));
+  ASSERT_EQ(1, files.size());
+  EXPECT_EQ("foo.proto", files[0].name());
+
+  // Files added after a lookup must be indexed too.
+  ASSERT_TRUE(db.Add(data2.data(), data2.size()));
+  files.clear();
+  EXPECT_FALSE(
+      db.FindFilesContainingSymbols({"bar.Bar", "baz.Baz", "foo.Foo"}, &files));
+  ASSERT_EQ(2, files.size());
+  EXPECT_EQ("bar.proto", files[0].name());
+  EXPECT_EQ("foo.proto", files[1].name());
+}
+
+TEST(EncodedDescriptorDatabaseExtraTest, AddDeferred) {
+  FileDescriptorProto file1, file2;
+  file1.set_name("foo.proto");
+  file1.set_package("foo");
+  file1.add_message_type()->set_name("Foo");
+  file2.set_name("bar.proto");
+  file2.set_package("bar");
+  file2.add_message_type()->set_name("Bar");
+  std::string data1 = file1.SerializeAsString();
+  std::string data2 = file2.SerializeAsString();
+
+  EncodedDescriptorDatabase db;
+  db.AddDeferred(data1.data(), data1.size());
+  FileDescriptorProto file;
+  EXPECT_TRUE(db.FindFileContainingSymbol("foo.Foo", &file));
+  EXPECT_EQ("foo.proto", file.name());
+
+  // Deferred files are indexed before files added later, so the conflict is
+  // reported against the eager one.
+  db.AddDeferred(data2.data(), data2.size());
+  EXPECT_FALSE(db.Add(data2.data(), data2.size()));
+  std::vector<std::string> names;
+  EXPECT_TRUE(db.FindAllFileNames(&names));
+  EXPECT_THAT(names, testing::ElementsAre("bar.proto", "foo.proto"));
+}
+
+#if GTEST_HAS_DEATH_TEST
+
+TEST(EncodedDescriptorDatabaseExtraTest, AddDeferredConflictIsFatal) {
+  FileDescriptorProto file;
+  file.set_name("foo.proto");
+  std::string data = file.SerializeAsString();
+
+  EncodedDescriptorDatabase db;
+  db.AddDeferred(data.data(), data.size());
+  db.AddDeferred(data.data(), data.size());
+  std::vector<std::string> names;
+  EXPECT_DEATH(db.FindAllFileNames(&names), "File already exists");
+}
+
+#endif  // GTEST_HAS_DEATH_TEST
+
+TEST(MappedDescriptorDatabaseExtraTest, BuildsPoolFromImage) {
+  EncodedDescriptorDatabase source;
+  for (const char* file_text :
+       {"name: \"foo.proto\" package: \"foo\" "
+        "message_type { name: \"Foo\" field { name: \"bar\" number: 1 "
+        "  label: LABEL_OPTIONAL type: TYPE_MESSAGE type_name: \".bar.Bar\" } }"
+        "dependency: \"bar.proto\"",
+        "name: \"bar.proto\" package: \"bar\" message_type { name: \"Bar\" }"}) {
+    FileDescriptorProto file;
+    ASSERT_TRUE(TextFormat::ParseFromString(file_text, &file));
+    std::string data = file.SerializeAsString();
+    ASSERT_TRUE(source.AddCopy(data.data(), data.size()));
+  }
+  std::string image;
+  ASSERT_TRUE(source.WriteImage(&image));
+
+  // Images are relocatable, so serve a copy at a different address.
+  std::unique_ptr<uint32_t[]> copy(new uint32_t[image.size() / 4 + 1]);
+  memcpy(copy.get(), image.data(), image.size());
+  MappedDescriptorDatabase database;
+  ASSERT_TRUE(database.Init(copy.get(), image.size()));
+
+  DescriptorPool pool(&database);
+  const Descriptor* foo = pool.FindMessageTypeByName("foo.Foo");
+  ASSERT_TRUE(foo != nullptr);
+  EXPECT_EQ(foo->field(0)->message_type(),
+            pool.FindMessageTypeByName("bar.Bar"));
+}
+
+TEST(MappedDescriptorDatabaseExtraTest, RejectsInvalidImages) {
+  EncodedDescriptorDatabase source;
+  FileDescriptorProto file;
+  file.set_name("foo.proto");
+  file.add_message_type()->set_name("Foo");
+  std::string data = file.SerializeAsString();
+  ASSERT_TRUE(source.Add(data.data(), data.size()));
+  std::string image;
+  ASSERT_TRUE(source.WriteImage(&image));
+
+  MappedDescriptorDatabase database;
+  FileDescriptorProto output;
+  // Truncated, so the tables point past the end.
+  EXPECT_FALSE(database.Init(image.data(), image.size() - 1));
+  EXPECT_FALSE(database.FindFileByName("foo.proto", &output));
+  EXPECT_FALSE(database.Init(data.data(), data.size()));
+  ASSERT_TRUE(database.Init(image.data(), image.size()));
+  EXPECT_TRUE(database.FindFileByName("foo.proto", &output));
+  EXPECT_EQ(output.name(), "foo.proto");
+}
+
 TEST(SimpleDescriptorDatabaseExtraTest, FindAllFileNames) {
   FileDescriptorProto f;
   f.set_name("foo.proto");
@@ -34,8 +34,10 @@
 //
 // This file makes extensive use of RFC 3092.  :)
 
+#include <functional>
 #include <limits>
 #include <memory>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "google/protobuf/any.pb.h"
@@ -2908,6 +2910,225 @@ TEST_F(MiscTest, FieldOptions) {
   EXPECT_EQ(FieldOptions::CORD, bar->options().ctype());
 }
 
+// ===================================================================
+
+TEST(BuildFilesTest, BuildsDependenciesFirst) {
+  FileDescriptorProto a, b, c;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      "name: 'a.proto' message_type { name: 'A' }", &a));
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      "name: 'b.proto' dependency: 'a.proto' "
+      "message_type { name: 'B' field { name: 'a' number: 1 "
+      "  label: LABEL_OPTIONAL type_name: 'A' } }",
+      &b));
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      "name: 'c.proto' dependency: 'b.proto' "
+      "message_type { name: 'C' field { name: 'b' number: 1 "
+      "  label: LABEL_OPTIONAL type_name: 'B' } }",
+      &c));
+
+  DescriptorPool pool;
+  std::vector<const FileDescriptor*> files = pool.BuildFiles({&c, &a, &b});
+  ASSERT_EQ(files.size(), 3u);
+  EXPECT_EQ(files[0], pool.FindFileByName("c.proto"));
+  EXPECT_EQ(files[1], pool.FindFileByName("a.proto"));
+  EXPECT_EQ(files[2], pool.FindFileByName("b.proto"));
+  EXPECT_EQ(files[0]->message_type(0)->field(0)->message_type(),
+            files[2]->message_type(0));
+  EXPECT_EQ(files[2]->message_type(0)->field(0)->message_type(),
+            files[1]->message_type(0));
+}
+
+TEST(BuildFilesTest, AddsNothingOnError) {
+  FileDescriptorProto a, b;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      "name: 'a.proto' message_type { name: 'A' }", &a));
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      "name: 'b.proto' dependency: 'a.proto' "
+      "message_type { name: 'B' field { name: 'a' number: 1 "
+      "  label: LABEL_OPTIONAL type_name: 'Unknown' } }",
+      &b));
+
+  DescriptorPool pool;
+  MockErrorCollector error_collector;
+  EXPECT_TRUE(pool.BuildFilesCollectingErrors({&a, &b}, &error_collector)
+                  .empty());
+  EXPECT_EQ(error_collector.text_,
+            "b.proto: B.a: TYPE: \"Unknown\" is not defined.\n");
+  EXPECT_TRUE(pool.FindFileByName("a.proto") == nullptr);
+  EXPECT_TRUE(pool.FindMessageTypeByName("A") == nullptr);
+
+  // The rolled back file can still be built.
+  std::vector<const FileDescriptor*> files = pool.BuildFiles({&a});
+  ASSERT_EQ(files.size(), 1u);
+  EXPECT_EQ(files[0], pool.FindFileByName("a.proto"));
+}
+
+TEST(BuildFilesReusingTest, ReusesUnchangedFiles) {
+  FileDescriptorProto a, b, c, d;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      "name: 'a.proto' package: 'pkg.sub' "
+      "message_type { name: 'A' extension_range { start: 100 end: 200 } }",
+      &a));
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      "name: 'b.proto' package: 'pkg.sub' dependency: 'a.proto' "
+      "message_type { name: 'B' field { name: 'a' number: 1 "
+      "  label: LABEL_OPTIONAL type_name: 'A' } } "
+      "extension { name: 'ext' number: 100 label: LABEL_OPTIONAL "
+      "  type: TYPE_INT32 extendee: 'A' }",
+      &b));
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      "name: 'c.proto' package: 'other' "
+      "enum_type { name: 'E' value { name: 'E_ZERO' number: 0 } }",
+      &c));
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      "name: 'd.proto' message_type { name: 'D' }", &d));
+
+  auto gen1 = std::make_shared<DescriptorPool>();
+  std::vector<const FileDescriptor*> files1 =
+      gen1->BuildFilesReusing({&a, &b, &c, &d}, nullptr);
+  ASSERT_EQ(files1.size(), 4u);
+
+  // Changing c.proto and dropping d.proto rebuilds c.proto only.
+  c.mutable_enum_type(0)->add_value()->set_name("E_ONE");
+  c.mutable_enum_type(0)->mutable_value(1)->set_number(1);
+  auto gen2 = std::make_shared<DescriptorPool>();
+  std::vector<const FileDescriptor*> files2 =
+      gen2->BuildFilesReusing({&a, &b, &c}, gen1);
+  ASSERT_EQ(files2.size(), 3u);
+  EXPECT_EQ(files2[0], files1[0]);
+  EXPECT_EQ(files2[1], files1[1]);
+  EXPECT_NE(files2[2], files1[2]);
+  EXPECT_EQ(files2[2]->pool(), gen2.get());
+  EXPECT_TRUE(gen2->FindFileByName("d.proto") == nullptr);
+  EXPECT_TRUE(gen2->FindMessageTypeByName("D") == nullptr);
+
+  // Everything of the reused files can be found in the new generation.
+  EXPECT_EQ(gen2->FindFileByName("a.proto"), files1[0]);
+  EXPECT_EQ(gen2->FindMessageTypeByName("pkg.sub.B"),
+            files1[1]->message_type(0));
+  EXPECT_EQ(gen2->FindFieldByName("pkg.sub.B.a"),
+            files1[1]->message_type(0)->field(0));
+  EXPECT_EQ(gen2->FindExtensionByNumber(files1[0]->message_type(0), 100),
+            files1[1]->extension(0));
+  EXPECT_EQ(gen2->FindFileContainingSymbol("pkg.sub"), files1[0]);
+  EXPECT_EQ(gen2->FindFileContainingSymbol("pkg"), files1[0]);
+  EXPECT_EQ(gen2->FindEnumValueByName("other.E_ONE"),
+            files2[2]->enum_type(0)->value(1));
+
+  // gen2 keeps the files it reused from gen1 alive.
+  gen1.reset();
+
+  // Changing a.proto rebuilds b.proto, which depends on it, too.
+  a.mutable_message_type(0)->add_field()->set_name("x");
+  a.mutable_message_type(0)->mutable_field(0)->set_number(1);
+  a.mutable_message_type(0)->mutable_field(0)->set_label(
+      FieldDescriptorProto::LABEL_OPTIONAL);
+  a.mutable_message_type(0)->mutable_field(0)->set_type(
+      FieldDescriptorProto::TYPE_INT32);
+  DescriptorPool gen3;
+  std::vector<const FileDescriptor*> files3 =
+      gen3.BuildFilesReusing({&c, &b, &a}, gen2);
+  ASSERT_EQ(files3.size(), 3u);
+  EXPECT_EQ(files3[0], files2[2]);
+  EXPECT_EQ(files3[1]->pool(), &gen3);
+  EXPECT_EQ(files3[2]->pool(), &gen3);
+  EXPECT_EQ(files3[1]->message_type(0)->field(0)->message_type(),
+            files3[2]->message_type(0));
+  EXPECT_EQ(gen3.FindEnumValueByName("other.E_ONE"),
+            files2[2]->enum_type(0)->value(1));
+}
+
+TEST(DescriptorPoolSpaceUsedTest, GrowsWithBuiltFiles) {
+  DescriptorPoolDatabase database(*DescriptorPool::generated_pool());
+  DescriptorPool pool(&database);
+  const size_t empty = pool.SpaceUsedLong();
+  EXPECT_GT(empty, sizeof(pool));
+
+  ASSERT_TRUE(pool.FindFileByName("google/protobuf/unittest_import.proto") !=
+              nullptr);
+  const size_t with_dependencies = pool.SpaceUsedLong();
+  EXPECT_GT(with_dependencies, empty);
+
+  const FileDescriptor* file =
+      pool.FindFileByName("google/protobuf/unittest.proto");
+  ASSERT_TRUE(file != nullptr);
+  const size_t with_file = pool.SpaceUsedLong();
+  // unittest.proto defines hundreds of fields, each with several names.
+  EXPECT_GT(with_file, with_dependencies + 100 * sizeof(FieldDescriptor));
+
+  // Lazily built lookup tables are accounted for once they exist.
+  file->FindMessageTypeByName("TestAllTypes")
+      ->FindFieldByLowercaseName("optional_int32");
+  EXPECT_GT(pool.SpaceUsedLong(), with_file);
+}
+
+TEST(DescriptorPoolInternedOptionsTest, SharesIdenticalOptions) {
+  DescriptorPool pool;
+  FileDescriptorProto file_proto;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        name: "a.proto"
+        message_type {
+          name: "A"
+          field {
+            name: "x"
+            number: 1
+            label: LABEL_OPTIONAL
+            type: TYPE_INT32
+            options { deprecated: true }
+          }
+          field {
+            name: "y"
+            number: 2
+            label: LABEL_OPTIONAL
+            type: TYPE_INT32
+            options { deprecated: true }
+          }
+          field {
+            name: "z"
+            number: 3
+            label: LABEL_REPEATED
+            type: TYPE_INT32
+            options { deprecated: true packed: true }
+          }
+          field { name: "w" number: 4 label: LABEL_OPTIONAL type: TYPE_INT32 }
+        }
+      )pb",
+      &file_proto));
+  const FileDescriptor* file = pool.BuildFile(file_proto);
+  ASSERT_TRUE(file != nullptr);
+  const Descriptor* a = file->message_type(0);
+  EXPECT_EQ(&a->field(0)->options(), &a->field(1)->options());
+  EXPECT_TRUE(a->field(1)->options().deprecated());
+  EXPECT_NE(&a->field(0)->options(), &a->field(2)->options());
+  EXPECT_TRUE(a->field(2)->options().packed());
+  EXPECT_EQ(&a->field(3)->options(), &FieldOptions::default_instance());
+
+  // A file which fails to build must not leave its options behind.
+  file_proto.set_name("bad.proto");
+  file_proto.mutable_message_type(0)->set_name("B");
+  file_proto.mutable_message_type(0)->mutable_field(3)->set_number(1);
+  EXPECT_TRUE(pool.BuildFile(file_proto) == nullptr);
+
+  // Options are shared across files too.
+  file_proto.set_name("c.proto");
+  file_proto.mutable_message_type(0)->set_name("C");
+  file_proto.mutable_message_type(0)->mutable_field(3)->set_number(4);
+  const FileDescriptor* other = pool.BuildFile(file_proto);
+  ASSERT_TRUE(other != nullptr);
+  EXPECT_EQ(&other->message_type(0)->field(0)->options(),
+            &a->field(0)->options());
+  EXPECT_EQ(&other->message_type(0)->field(2)->options(),
+            &a->field(2)->options());
+
+  // Descriptors still copy out their own options.
+  FileDescriptorProto copy;
+  other->CopyTo(&copy);
+  EXPECT_TRUE(copy.message_type(0).field(1).options().deprecated());
+  EXPECT_FALSE(copy.message_type(0).field(3).has_options());
+}
+
 // ===================================================================
 enum DescriptorPoolMode { NO_DATABASE, FALLBACK_DATABASE };
 
@@ -7444,6 +7665,40 @@ TEST_F(DatabaseBackedPoolTest, UnittestProto) {
   EXPECT_EQ(original_file->DebugString(), file_from_database->DebugString());
 }
 
+TEST_F(DatabaseBackedPoolTest, ConcurrentLookupsWhileBuilding) {
+  // Symbols which have already been built are found without taking the
+  // pool's mutex, so look them up while another thread keeps building files.
+  DescriptorPoolDatabase database(*DescriptorPool::generated_pool());
+  DescriptorPool pool(&database);
+  const Descriptor* all_types =
+      pool.FindMessageTypeByName("protobuf_unittest.TestAllTypes");
+  ASSERT_TRUE(all_types != nullptr);
+  const FieldDescriptor* field =
+      pool.FindFieldByName("protobuf_unittest.TestAllTypes.optional_int32");
+  ASSERT_TRUE(field != nullptr);
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      for (int j = 0; j < 10000; ++j) {
+        EXPECT_EQ(all_types,
+                  pool.FindMessageTypeByName("protobuf_unittest.TestAllTypes"));
+        EXPECT_EQ(field, pool.FindFieldByName(
+                             "protobuf_unittest.TestAllTypes.optional_int32"));
+      }
+    });
+  }
+  EXPECT_TRUE(pool.FindFileByName(
+                  "google/protobuf/unittest_custom_options.proto") != nullptr);
+  EXPECT_TRUE(pool.FindFileByName(
+                  "google/protobuf/unittest_proto3_arena.proto") != nullptr);
+  for (std::thread& reader : readers) reader.join();
+
+  // Symbols built by the writer are visible afterwards.
+  EXPECT_TRUE(pool.FindMessageTypeByName(
+                  "protobuf_unittest.TestMessageWithCustomOptions") != nullptr);
+}
+
 TEST_F(DatabaseBackedPoolTest, DoesntRetryDbUnnecessarily) {
   // Searching for a child of an existing descriptor should never fall back
   // to the DescriptorDatabase even if it isn't found, because we know all
@@ -8380,6 +8635,44 @@ TEST_F(LazilyBuildDependenciesTest, Message) {
   EXPECT_TRUE(pool_.InternalIsFileLoaded("bar.proto"));
 }
 
+TEST_F(LazilyBuildDependenciesTest, PrefetchFilesAsync) {
+  ParseProtoAndAddToDb(
+      "name: 'foo.proto' "
+      "package: 'protobuf_unittest' "
+      "dependency: 'bar.proto' "
+      "message_type { "
+      "  name:'Foo' "
+      "  field { name:'bar' number:1 label:LABEL_OPTIONAL "
+      "type_name:'.protobuf_unittest.Bar' } "
+      "}");
+  AddSimpleMessageProtoFileToDb("bar", "Bar");
+  AddSimpleMessageProtoFileToDb("baz", "Baz");
+  EXPECT_EQ(0, pool_.GetDatabaseBuildStats().files_built);
+
+  std::vector<std::thread> threads;
+  pool_.PrefetchFilesAsync(
+      {"foo.proto", "baz.proto", "missing.proto"},
+      [&](std::function<void()> task) { threads.emplace_back(task); });
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(3, threads.size());
+
+  // Prefetching foo.proto also built bar.proto, which lazily built
+  // dependencies would otherwise have left until its types were used.
+  EXPECT_TRUE(pool_.InternalIsFileLoaded("foo.proto"));
+  EXPECT_TRUE(pool_.InternalIsFileLoaded("bar.proto"));
+  EXPECT_TRUE(pool_.InternalIsFileLoaded("baz.proto"));
+  DescriptorPool::DatabaseBuildStats stats = pool_.GetDatabaseBuildStats();
+  EXPECT_EQ(3, stats.files_built);
+  EXPECT_GT(stats.build_time, absl::ZeroDuration());
+
+  // Using the prefetched files builds nothing more.
+  const Descriptor* foo = pool_.FindMessageTypeByName("protobuf_unittest.Foo");
+  ASSERT_TRUE(foo != nullptr);
+  EXPECT_EQ("protobuf_unittest.Bar",
+            foo->FindFieldByName("bar")->message_type()->full_name());
+  EXPECT_EQ(3, pool_.GetDatabaseBuildStats().files_built);
+}
+
 TEST_F(LazilyBuildDependenciesTest, Enum) {
   ParseProtoAndAddToDb(
       "name: 'foo.proto' "
@@ -155,6 +155,11 @@ class PROTOBUF_EXPORT Duration final :
   Duration* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Duration>(arena);
   }
+  Duration* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Duration* copy = CreateMaybeMessage<Duration>(arena);
+    copy->CopyFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Duration& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -65,14 +65,20 @@
 #include "google/protobuf/dynamic_message.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <new>
+#include <utility>
+#include <vector>
 
+#include "absl/numeric/bits.h"
 #include "google/protobuf/arenastring.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor_legacy.h"
+#include "google/protobuf/dynamic_message_jit.h"
 #include "google/protobuf/extension_set.h"
 #include "google/protobuf/generated_message_reflection.h"
 #include "google/protobuf/generated_message_util.h"
@@ -94,6 +100,9 @@ namespace protobuf {
 using internal::DynamicMapField;
 using internal::ExtensionSet;
 using internal::MapField;
+using internal::SerializationStep;
+using internal::WireFormat;
+using internal::WireFormatLite;
 
 
 using internal::ArenaStringPtr;
@@ -103,6 +112,9 @@ using internal::ArenaStringPtr;
 
 namespace {
 
+// The number of live DynamicMessageFactory::TypeInfo objects.
+std::atomic<int64_t> live_prototype_count{0};
+
 bool IsMapFieldInApi(const FieldDescriptor* field) { return field->is_map(); }
 
 
@@ -198,6 +210,351 @@ inline int AlignOffset(int offset) { return AlignTo(offset, kSafeAlignment); }
 
 #define bitsizeof(T) (sizeof(T) * 8)
 
+template <typename T>
+inline const T& FieldAt(const void* field_ptr) {
+  return *static_cast<const T*>(field_ptr);
+}
+
+// Whether a singular field without a has-bit has a non-default value.  As in
+// Reflection::HasBit(), floating point values are compared bitwise.
+bool HasImplicitValue(const SerializationStep& step, const void* field_ptr) {
+  switch (step.field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_STRING:
+      return !FieldAt<ArenaStringPtr>(field_ptr).Get().empty();
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return FieldAt<Message*>(field_ptr) != nullptr;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return FieldAt<bool>(field_ptr);
+    case FieldDescriptor::CPPTYPE_INT64:
+    case FieldDescriptor::CPPTYPE_UINT64:
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return FieldAt<uint64_t>(field_ptr) != 0;
+    default:
+      return FieldAt<uint32_t>(field_ptr) != 0;
+  }
+}
+
+// The size of a singular field's value, without its tag.
+size_t SingularValueSize(const SerializationStep& step,
+                         const void* field_ptr) {
+  switch (step.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, METHOD) \
+  case FieldDescriptor::TYPE_##TYPE:       \
+    return WireFormatLite::METHOD##Size(FieldAt<CPPTYPE>(field_ptr));
+
+    HANDLE_TYPE(INT32, int32_t, Int32)
+    HANDLE_TYPE(INT64, int64_t, Int64)
+    HANDLE_TYPE(UINT32, uint32_t, UInt32)
+    HANDLE_TYPE(UINT64, uint64_t, UInt64)
+    HANDLE_TYPE(SINT32, int32_t, SInt32)
+    HANDLE_TYPE(SINT64, int64_t, SInt64)
+    HANDLE_TYPE(ENUM, int, Enum)
+#undef HANDLE_TYPE
+
+    case FieldDescriptor::TYPE_FIXED32:
+    case FieldDescriptor::TYPE_SFIXED32:
+    case FieldDescriptor::TYPE_FLOAT:
+      return 4;
+    case FieldDescriptor::TYPE_FIXED64:
+    case FieldDescriptor::TYPE_SFIXED64:
+    case FieldDescriptor::TYPE_DOUBLE:
+      return 8;
+    case FieldDescriptor::TYPE_BOOL:
+      return 1;
+    case FieldDescriptor::TYPE_STRING:
+    case FieldDescriptor::TYPE_BYTES:
+      return WireFormatLite::StringSize(
+          FieldAt<ArenaStringPtr>(field_ptr).Get());
+    case FieldDescriptor::TYPE_MESSAGE:
+      return WireFormatLite::MessageSize(*FieldAt<Message*>(field_ptr));
+    case FieldDescriptor::TYPE_GROUP:
+      return WireFormatLite::GroupSize(*FieldAt<Message*>(field_ptr));
+  }
+  return 0;
+}
+
+// The number of elements of a repeated field and the total size of their
+// values, without tags or a packed length prefix.
+std::pair<int, size_t> RepeatedValueSize(const SerializationStep& step,
+                                         const void* field_ptr) {
+  switch (step.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, METHOD)                                   \
+  case FieldDescriptor::TYPE_##TYPE: {                                       \
+    const auto& values = FieldAt<RepeatedField<CPPTYPE>>(field_ptr);        \
+    return {values.size(), WireFormatLite::METHOD##Size(values)};            \
+  }
+
+    HANDLE_TYPE(INT32, int32_t, Int32)
+    HANDLE_TYPE(INT64, int64_t, Int64)
+    HANDLE_TYPE(UINT32, uint32_t, UInt32)
+    HANDLE_TYPE(UINT64, uint64_t, UInt64)
+    HANDLE_TYPE(SINT32, int32_t, SInt32)
+    HANDLE_TYPE(SINT64, int64_t, SInt64)
+    HANDLE_TYPE(ENUM, int, Enum)
+#undef HANDLE_TYPE
+
+#define HANDLE_TYPE(TYPE, CPPTYPE)                                    \
+  case FieldDescriptor::TYPE_##TYPE: {                                \
+    const int size = FieldAt<RepeatedField<CPPTYPE>>(field_ptr).size(); \
+    return {size, size * sizeof(CPPTYPE)};                            \
+  }
+
+    HANDLE_TYPE(FIXED32, uint32_t)
+    HANDLE_TYPE(FIXED64, uint64_t)
+    HANDLE_TYPE(SFIXED32, int32_t)
+    HANDLE_TYPE(SFIXED64, int64_t)
+    HANDLE_TYPE(FLOAT, float)
+    HANDLE_TYPE(DOUBLE, double)
+    HANDLE_TYPE(BOOL, bool)
+#undef HANDLE_TYPE
+
+    case FieldDescriptor::TYPE_STRING:
+    case FieldDescriptor::TYPE_BYTES: {
+      const auto& values = FieldAt<RepeatedPtrField<std::string>>(field_ptr);
+      size_t size = 0;
+      for (const std::string& value : values) {
+        size += WireFormatLite::StringSize(value);
+      }
+      return {values.size(), size};
+    }
+    case FieldDescriptor::TYPE_MESSAGE:
+    case FieldDescriptor::TYPE_GROUP: {
+      const auto& values = FieldAt<RepeatedPtrField<Message>>(field_ptr);
+      size_t size = 0;
+      for (const Message& value : values) {
+        size += step.type == FieldDescriptor::TYPE_MESSAGE
+                    ? WireFormatLite::MessageSize(value)
+                    : WireFormatLite::GroupSize(value);
+      }
+      return {values.size(), size};
+    }
+  }
+  return {0, 0};
+}
+
+uint8_t* SerializeString(const SerializationStep& step,
+                         const std::string& value, uint8_t* target,
+                         io::EpsCopyOutputStream* stream) {
+  if (step.type == FieldDescriptor::TYPE_STRING) {
+    if (step.strict_utf8) {
+      WireFormatLite::VerifyUtf8String(value.data(), value.length(),
+                                       WireFormatLite::SERIALIZE,
+                                       step.field->full_name().c_str());
+    } else {
+      WireFormat::VerifyUTF8StringNamedField(value.data(), value.length(),
+                                             WireFormat::SERIALIZE,
+                                             step.field->full_name().c_str());
+    }
+  }
+  return stream->WriteString(step.number, value, target);
+}
+
+uint8_t* SerializeMessage(const SerializationStep& step, const Message& value,
+                          uint8_t* target, io::EpsCopyOutputStream* stream) {
+  if (step.type == FieldDescriptor::TYPE_GROUP) {
+    return WireFormatLite::InternalWriteGroup(step.number, value, target,
+                                              stream);
+  }
+  return WireFormatLite::InternalWriteMessage(
+      step.number, value, value.GetCachedSize(), target, stream);
+}
+
+uint8_t* SerializeSingular(const SerializationStep& step,
+                           const void* field_ptr, uint8_t* target,
+                           io::EpsCopyOutputStream* stream) {
+  target = stream->EnsureSpace(target);
+  switch (step.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, METHOD)                  \
+  case FieldDescriptor::TYPE_##TYPE:                        \
+    return WireFormatLite::Write##METHOD##ToArray(          \
+        step.number, FieldAt<CPPTYPE>(field_ptr), target);
+
+    HANDLE_TYPE(INT32, int32_t, Int32)
+    HANDLE_TYPE(INT64, int64_t, Int64)
+    HANDLE_TYPE(UINT32, uint32_t, UInt32)
+    HANDLE_TYPE(UINT64, uint64_t, UInt64)
+    HANDLE_TYPE(SINT32, int32_t, SInt32)
+    HANDLE_TYPE(SINT64, int64_t, SInt64)
+    HANDLE_TYPE(FIXED32, uint32_t, Fixed32)
+    HANDLE_TYPE(FIXED64, uint64_t, Fixed64)
+    HANDLE_TYPE(SFIXED32, int32_t, SFixed32)
+    HANDLE_TYPE(SFIXED64, int64_t, SFixed64)
+    HANDLE_TYPE(FLOAT, float, Float)
+    HANDLE_TYPE(DOUBLE, double, Double)
+    HANDLE_TYPE(BOOL, bool, Bool)
+    HANDLE_TYPE(ENUM, int, Enum)
+#undef HANDLE_TYPE
+
+    case FieldDescriptor::TYPE_STRING:
+    case FieldDescriptor::TYPE_BYTES:
+      return SerializeString(step, FieldAt<ArenaStringPtr>(field_ptr).Get(),
+                             target, stream);
+    case FieldDescriptor::TYPE_MESSAGE:
+    case FieldDescriptor::TYPE_GROUP:
+      return SerializeMessage(step, *FieldAt<Message*>(field_ptr), target,
+                              stream);
+  }
+  return target;
+}
+
+uint8_t* SerializeRepeated(const SerializationStep& step,
+                           const void* field_ptr, uint8_t* target,
+                           io::EpsCopyOutputStream* stream) {
+  switch (step.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, METHOD)                                    \
+  case FieldDescriptor::TYPE_##TYPE:                                          \
+    for (CPPTYPE value : FieldAt<RepeatedField<CPPTYPE>>(field_ptr)) {        \
+      target = stream->EnsureSpace(target);                                   \
+      target =                                                                \
+          WireFormatLite::Write##METHOD##ToArray(step.number, value, target); \
+    }                                                                         \
+    return target;
+
+    HANDLE_TYPE(INT32, int32_t, Int32)
+    HANDLE_TYPE(INT64, int64_t, Int64)
+    HANDLE_TYPE(UINT32, uint32_t, UInt32)
+    HANDLE_TYPE(UINT64, uint64_t, UInt64)
+    HANDLE_TYPE(SINT32, int32_t, SInt32)
+    HANDLE_TYPE(SINT64, int64_t, SInt64)
+    HANDLE_TYPE(FIXED32, uint32_t, Fixed32)
+    HANDLE_TYPE(FIXED64, uint64_t, Fixed64)
+    HANDLE_TYPE(SFIXED32, int32_t, SFixed32)
+    HANDLE_TYPE(SFIXED64, int64_t, SFixed64)
+    HANDLE_TYPE(FLOAT, float, Float)
+    HANDLE_TYPE(DOUBLE, double, Double)
+    HANDLE_TYPE(BOOL, bool, Bool)
+    HANDLE_TYPE(ENUM, int, Enum)
+#undef HANDLE_TYPE
+
+    case FieldDescriptor::TYPE_STRING:
+    case FieldDescriptor::TYPE_BYTES:
+      for (const std::string& value :
+           FieldAt<RepeatedPtrField<std::string>>(field_ptr)) {
+        target = stream->EnsureSpace(target);
+        target = SerializeString(step, value, target, stream);
+      }
+      return target;
+    case FieldDescriptor::TYPE_MESSAGE:
+    case FieldDescriptor::TYPE_GROUP:
+      for (const Message& value :
+           FieldAt<RepeatedPtrField<Message>>(field_ptr)) {
+        target = stream->EnsureSpace(target);
+        target = SerializeMessage(step, value, target, stream);
+      }
+      return target;
+  }
+  return target;
+}
+
+uint8_t* SerializePacked(const SerializationStep& step, const void* field_ptr,
+                         uint8_t* target, io::EpsCopyOutputStream* stream) {
+  const std::pair<int, size_t> count_and_size =
+      RepeatedValueSize(step, field_ptr);
+  if (count_and_size.first == 0) return target;
+  const int size = static_cast<int>(count_and_size.second);
+  target = stream->EnsureSpace(target);
+  switch (step.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, METHOD)                              \
+  case FieldDescriptor::TYPE_##TYPE:                                    \
+    return stream->Write##METHOD##Packed(                               \
+        step.number, FieldAt<RepeatedField<CPPTYPE>>(field_ptr), size, \
+        target);
+
+    HANDLE_TYPE(INT32, int32_t, Int32)
+    HANDLE_TYPE(INT64, int64_t, Int64)
+    HANDLE_TYPE(UINT32, uint32_t, UInt32)
+    HANDLE_TYPE(UINT64, uint64_t, UInt64)
+    HANDLE_TYPE(SINT32, int32_t, SInt32)
+    HANDLE_TYPE(SINT64, int64_t, SInt64)
+    HANDLE_TYPE(ENUM, int, Enum)
+#undef HANDLE_TYPE
+
+#define HANDLE_TYPE(TYPE, CPPTYPE)                                         \
+  case FieldDescriptor::TYPE_##TYPE:                                       \
+    return stream->WriteFixedPacked(                                       \
+        step.number, FieldAt<RepeatedField<CPPTYPE>>(field_ptr), target);
+
+    HANDLE_TYPE(FIXED32, uint32_t)
+    HANDLE_TYPE(FIXED64, uint64_t)
+    HANDLE_TYPE(SFIXED32, int32_t)
+    HANDLE_TYPE(SFIXED64, int64_t)
+    HANDLE_TYPE(FLOAT, float)
+    HANDLE_TYPE(DOUBLE, double)
+    HANDLE_TYPE(BOOL, bool)
+#undef HANDLE_TYPE
+
+    default:
+      ABSL_LOG(FATAL) << "Invalid packed field type";
+  }
+  return target;
+}
+
+bool IsSingularFieldSet(const SerializationStep& step, const void* field_ptr,
+                        const uint32_t* has_bits) {
+  return step.has_bit != static_cast<uint32_t>(-1)
+             ? (has_bits[step.has_bit / 32] >> (step.has_bit % 32) & 1) != 0
+             : HasImplicitValue(step, field_ptr);
+}
+
+// The SerializationStepByteSizeFn and SerializationStepFn that interpret a
+// plan, one step at a time.
+size_t StepByteSize(const SerializationStep& step, const Message& message,
+                    const uint32_t* has_bits) {
+  const void* field_ptr =
+      reinterpret_cast<const uint8_t*>(&message) + step.offset;
+  switch (step.kind) {
+    case SerializationStep::kSingular:
+      if (!IsSingularFieldSet(step, field_ptr, has_bits)) return 0;
+      return step.tag_size + SingularValueSize(step, field_ptr);
+    case SerializationStep::kRepeated: {
+      const std::pair<int, size_t> count_and_size =
+          RepeatedValueSize(step, field_ptr);
+      return count_and_size.first * step.tag_size + count_and_size.second;
+    }
+    case SerializationStep::kPacked: {
+      const size_t data_size = RepeatedValueSize(step, field_ptr).second;
+      if (data_size == 0) return 0;
+      return step.tag_size +
+             WireFormatLite::Int32Size(static_cast<int32_t>(data_size)) +
+             data_size;
+    }
+    case SerializationStep::kExtensions:
+      return 0;
+    case SerializationStep::kReflective:
+      // Unlike InternalSerializeField(), FieldByteSize() expects the field
+      // to be set.
+      if (!step.field->is_repeated() &&
+          !message.GetReflection()->HasField(message, step.field)) {
+        return 0;
+      }
+      return WireFormat::FieldByteSize(step.field, message);
+  }
+  return 0;
+}
+
+uint8_t* SerializeStep(const SerializationStep& step, const Message& message,
+                       const uint32_t* has_bits, uint8_t* target,
+                       io::EpsCopyOutputStream* stream) {
+  const void* field_ptr =
+      reinterpret_cast<const uint8_t*>(&message) + step.offset;
+  switch (step.kind) {
+    case SerializationStep::kSingular:
+      if (!IsSingularFieldSet(step, field_ptr, has_bits)) return target;
+      return SerializeSingular(step, field_ptr, target, stream);
+    case SerializationStep::kRepeated:
+      return SerializeRepeated(step, field_ptr, target, stream);
+    case SerializationStep::kPacked:
+      return SerializePacked(step, field_ptr, target, stream);
+    case SerializationStep::kExtensions:
+      return static_cast<const ExtensionSet*>(field_ptr)->_InternalSerialize(
+          &message, step.number, step.end, target, stream);
+    case SerializationStep::kReflective:
+      return WireFormat::InternalSerializeField(step.field, message, target,
+                                                stream);
+  }
+  return target;
+}
+
 }  // namespace
 
 // ===================================================================
@@ -227,6 +584,12 @@ class DynamicMessage : public Message {
 
   Message* New(Arena* arena) const override;
 
+  void Clear() override;
+
+  size_t ByteSizeLong() const override;
+  uint8_t* _InternalSerialize(uint8_t* target,
+                              io::EpsCopyOutputStream* stream) const override;
+
   int GetCachedSize() const override;
   void SetCachedSize(int size) const override;
 
@@ -262,6 +625,8 @@ class DynamicMessage : public Message {
   inline const void* OffsetToPointer(int offset) const {
     return reinterpret_cast<const uint8_t*>(this) + offset;
   }
+  // The has-bits, or nullptr if the type has none.
+  const uint32_t* HasBits() const;
 
   void* MutableRaw(int i);
   void* MutableExtensionsRaw();
@@ -296,9 +661,28 @@ struct DynamicMessageFactory::TypeInfo {
   const DynamicMessage* prototype;
   int weak_field_map_offset;  // The offset for the weak_field_map;
 
-  TypeInfo() : prototype(nullptr) {}
+  // The fields outside of real oneofs, split for DynamicMessage::Clear(): the
+  // ones with a has-bit, indexed by it, and the rest.
+  std::vector<const FieldDescriptor*> fields_by_has_bit;
+  std::vector<const FieldDescriptor*> fields_without_has_bit;
+
+  // Used by DynamicMessage::ByteSizeLong() and _InternalSerialize(), unless
+  // the type needs the reflective implementation (map entries and MessageSet
+  // wire format).
+  std::vector<SerializationStep> serialization_plan;
+  bool reflective_serialization = false;
+#if HAVE_LLVM
+  // The plan compiled to native code, if the factory was asked to.
+  std::unique_ptr<internal::CompiledSerializationPlan>
+      compiled_serialization_plan;
+#endif  // HAVE_LLVM
+
+  TypeInfo() : prototype(nullptr) {
+    live_prototype_count.fetch_add(1, std::memory_order_relaxed);
+  }
 
   ~TypeInfo() {
+    live_prototype_count.fetch_sub(1, std::memory_order_relaxed);
     delete prototype;
 
     // Scribble the payload to prevent unsanitized opt builds from silently
@@ -613,6 +997,99 @@ Message* DynamicMessage::New(Arena* arena) const {
   }
 }
 
+void DynamicMessage::Clear() {
+  // Parse*FromString() starts with Clear(), so avoid the generic
+  // ReflectionOps::Clear(), which lists every set field first: singular fields
+  // are only visited when their has-bit is set, a word of has-bits at a time.
+  const DynamicMessageFactory::TypeInfo* info = type_info_;
+  const Reflection* reflection = info->reflection.get();
+  if (!info->fields_by_has_bit.empty()) {
+    const uint32_t* has_bits =
+        static_cast<const uint32_t*>(OffsetToPointer(info->has_bits_offset));
+    const size_t words =
+        DivideRoundingUp(static_cast<int>(info->fields_by_has_bit.size()),
+                         bitsizeof(uint32_t));
+    for (size_t i = 0; i < words; ++i) {
+      // ClearField() resets the has-bit, so iterate over a copy of the word.
+      for (uint32_t bits = has_bits[i]; bits != 0; bits &= bits - 1) {
+        reflection->ClearField(
+            this, info->fields_by_has_bit[i * bitsizeof(uint32_t) +
+                                          absl::countr_zero(bits)]);
+      }
+    }
+  }
+  for (const FieldDescriptor* field : info->fields_without_has_bit) {
+    reflection->ClearField(this, field);
+  }
+  for (int i = 0; i < info->type->real_oneof_decl_count(); ++i) {
+    if (*static_cast<const uint32_t*>(MutableOneofCaseRaw(i)) != 0) {
+      reflection->ClearOneof(this, info->type->oneof_decl(i));
+    }
+  }
+  if (info->extensions_offset != -1) {
+    static_cast<ExtensionSet*>(MutableExtensionsRaw())->Clear();
+  }
+  _internal_metadata_.Clear<UnknownFieldSet>();
+}
+
+const uint32_t* DynamicMessage::HasBits() const {
+  if (type_info_->has_bits_offset == -1) return nullptr;
+  return static_cast<const uint32_t*>(
+      OffsetToPointer(type_info_->has_bits_offset));
+}
+
+size_t DynamicMessage::ByteSizeLong() const {
+  const DynamicMessageFactory::TypeInfo* info = type_info_;
+  if (info->reflective_serialization) return Message::ByteSizeLong();
+
+  size_t total_size = 0;
+#if HAVE_LLVM
+  if (info->compiled_serialization_plan != nullptr) {
+    total_size = info->compiled_serialization_plan->ByteSize(*this);
+  } else
+#endif  // HAVE_LLVM
+  {
+    const uint32_t* has_bits = HasBits();
+    for (const SerializationStep& step : info->serialization_plan) {
+      total_size += StepByteSize(step, *this, has_bits);
+    }
+  }
+  if (info->extensions_offset != -1) {
+    total_size +=
+        static_cast<const ExtensionSet*>(OffsetToPointer(info->extensions_offset))
+            ->ByteSize();
+  }
+  total_size += WireFormat::ComputeUnknownFieldsSize(
+      _internal_metadata_.unknown_fields<UnknownFieldSet>(
+          UnknownFieldSet::default_instance));
+  SetCachedSize(internal::ToCachedSize(total_size));
+  return total_size;
+}
+
+uint8_t* DynamicMessage::_InternalSerialize(
+    uint8_t* target, io::EpsCopyOutputStream* stream) const {
+  const DynamicMessageFactory::TypeInfo* info = type_info_;
+  if (info->reflective_serialization) {
+    return Message::_InternalSerialize(target, stream);
+  }
+
+#if HAVE_LLVM
+  if (info->compiled_serialization_plan != nullptr) {
+    target = info->compiled_serialization_plan->Serialize(*this, target, stream);
+  } else
+#endif  // HAVE_LLVM
+  {
+    const uint32_t* has_bits = HasBits();
+    for (const SerializationStep& step : info->serialization_plan) {
+      target = SerializeStep(step, *this, has_bits, target, stream);
+    }
+  }
+  return WireFormat::InternalSerializeUnknownFieldsToArray(
+      _internal_metadata_.unknown_fields<UnknownFieldSet>(
+          UnknownFieldSet::default_instance),
+      target, stream);
+}
+
 int DynamicMessage::GetCachedSize() const {
   return cached_byte_size_.load(std::memory_order_relaxed);
 }
@@ -631,10 +1108,18 @@ Metadata DynamicMessage::GetMetadata() const {
 // ===================================================================
 
 DynamicMessageFactory::DynamicMessageFactory()
-    : pool_(nullptr), delegate_to_generated_factory_(false) {}
+    : pool_(nullptr),
+      delegate_to_generated_factory_(false),
+      underlay_pool_(nullptr),
+      underlay_factory_(nullptr),
+      compile_types_(false) {}
 
 DynamicMessageFactory::DynamicMessageFactory(const DescriptorPool* pool)
-    : pool_(pool), delegate_to_generated_factory_(false) {}
+    : pool_(pool),
+      delegate_to_generated_factory_(false),
+      underlay_pool_(nullptr),
+      underlay_factory_(nullptr),
+      compile_types_(false) {}
 
 DynamicMessageFactory::~DynamicMessageFactory() {
   for (auto iter = prototypes_.begin(); iter != prototypes_.end(); ++iter) {
@@ -642,17 +1127,46 @@ DynamicMessageFactory::~DynamicMessageFactory() {
   }
 }
 
+int64_t DynamicMessageFactory::LivePrototypeCount() {
+  return live_prototype_count.load(std::memory_order_relaxed);
+}
+
 const Message* DynamicMessageFactory::GetPrototype(const Descriptor* type) {
+  const Message* prototype;
+  if (GetDelegatedPrototype(type, &prototype)) return prototype;
+  prototype = prototype_cache_.Find(type);
+  if (prototype != nullptr) return prototype;
+
   absl::MutexLock lock(&prototypes_mutex_);
-  return GetPrototypeNoLock(type);
+  prototype = GetPrototypeNoLock(type);
+  // Types built by this call are complete now that the outermost
+  // GetPrototypeNoLock() has returned, including any recursive ones.
+  if (prototype_cache_.Find(type) == nullptr) {
+    prototype_cache_.Insert(type, prototype);
+  }
+  return prototype;
 }
 
-const Message* DynamicMessageFactory::GetPrototypeNoLock(
-    const Descriptor* type) {
+bool DynamicMessageFactory::GetDelegatedPrototype(const Descriptor* type,
+                                                  const Message** prototype) {
   if (delegate_to_generated_factory_ &&
       type->file()->pool() == DescriptorPool::generated_pool()) {
-    return MessageFactory::generated_factory()->GetPrototype(type);
+    *prototype = MessageFactory::generated_factory()->GetPrototype(type);
+    return true;
+  }
+  if (underlay_factory_ != nullptr && type->file()->pool() == underlay_pool_) {
+    // Types in the underlay never refer back to ours, so the underlay factory
+    // cannot call back into this one while we hold our lock.
+    *prototype = underlay_factory_->GetPrototype(type);
+    return true;
   }
+  return false;
+}
+
+const Message* DynamicMessageFactory::GetPrototypeNoLock(
+    const Descriptor* type) {
+  const Message* delegated;
+  if (GetDelegatedPrototype(type, &delegated)) return delegated;
 
   const TypeInfo** target = &prototypes_[type];
   if (*target != nullptr) {
@@ -708,6 +1222,9 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
         type_info->has_bits_indices.reset(has_bits_indices);
       }
       type_info->has_bits_indices[i] = max_hasbit++;
+      type_info->fields_by_has_bit.push_back(type->field(i));
+    } else if (!InRealOneof(type->field(i))) {
+      type_info->fields_without_has_bit.push_back(type->field(i));
     }
   }
 
@@ -724,6 +1241,39 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
     size = AlignOffset(size);
   }
 
+  // All the fields.  As the C++ generator's PaddingOptimizer does for
+  // generated messages, the singular fields are ordered by decreasing
+  // alignment so that they need no padding between them.  They come first,
+  // next to the has-bits, while the ExtensionSet and the repeated fields,
+  // which are larger and less often touched on every access, go after them.
+  // Within each group, fields keep their declaration order.
+  std::vector<int> field_order;
+  field_order.reserve(type->field_count());
+  for (int i = 0; i < type->field_count(); i++) {
+    // Oneof fields do not use any space.
+    if (!InRealOneof(type->field(i))) field_order.push_back(i);
+  }
+  auto layout_group = [&](int i) {
+    const FieldDescriptor* field = type->field(i);
+    if (field->is_repeated()) return kSafeAlignment + 1;
+    return kSafeAlignment - std::min(kSafeAlignment, FieldSpaceUsed(field));
+  };
+  std::stable_sort(field_order.begin(), field_order.end(), [&](int a, int b) {
+    return layout_group(a) < layout_group(b);
+  });
+  auto lay_out_field = [&](int i) {
+    // Make sure field is aligned to avoid bus errors.
+    int field_size = FieldSpaceUsed(type->field(i));
+    size = AlignTo(size, std::min(kSafeAlignment, field_size));
+    offsets[i] = size;
+    size += field_size;
+  };
+  auto first_repeated =
+      std::find_if(field_order.begin(), field_order.end(),
+                   [&](int i) { return type->field(i)->is_repeated(); });
+  std::for_each(field_order.begin(), first_repeated, lay_out_field);
+  size = AlignOffset(size);
+
   // The ExtensionSet, if any.
   if (type->extension_range_count() > 0) {
     type_info->extensions_offset = size;
@@ -734,19 +1284,7 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
     type_info->extensions_offset = -1;
   }
 
-  // All the fields.
-  //
-  // TODO(b/31226269):  Optimize the order of fields to minimize padding.
-  for (int i = 0; i < type->field_count(); i++) {
-    // Make sure field is aligned to avoid bus errors.
-    // Oneof fields do not use any space.
-    if (!InRealOneof(type->field(i))) {
-      int field_size = FieldSpaceUsed(type->field(i));
-      size = AlignTo(size, std::min(kSafeAlignment, field_size));
-      offsets[i] = size;
-      size += field_size;
-    }
-  }
+  std::for_each(first_repeated, field_order.end(), lay_out_field);
 
   // The oneofs.
   for (int i = 0; i < type->oneof_decl_count(); i++) {
@@ -807,6 +1345,59 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
   type_info->reflection.reset(
       new Reflection(type_info->type, schema, type_info->pool, this));
 
+  // Plan the serialization of the fields, interleaved with the extension
+  // ranges, in field number order as WireFormat::_InternalSerialize() would.
+  type_info->reflective_serialization =
+      type->options().map_entry() ||
+      type->options().message_set_wire_format();
+  if (!type_info->reflective_serialization) {
+    std::vector<SerializationStep>& plan = type_info->serialization_plan;
+    for (int i = 0; i < type->field_count(); i++) {
+      const FieldDescriptor* field = type->field(i);
+      SerializationStep step{};
+      step.type = field->type();
+      step.number = field->number();
+      step.tag_size = static_cast<uint32_t>(
+          WireFormat::TagSize(field->number(), field->type()));
+      step.strict_utf8 = field->requires_utf8_validation();
+      step.has_bit = type_info->has_bits_indices == nullptr
+                         ? static_cast<uint32_t>(-1)
+                         : type_info->has_bits_indices[i];
+      step.field = field;
+      if (InRealOneof(field) || field->is_map() || field->options().weak() ||
+          (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING &&
+           internal::cpp::EffectiveStringCType(field) != FieldOptions::STRING)) {
+        step.kind = SerializationStep::kReflective;
+      } else {
+        step.offset = offsets[i];
+        step.kind = !field->is_repeated() ? SerializationStep::kSingular
+                    : field->is_packed()  ? SerializationStep::kPacked
+                                          : SerializationStep::kRepeated;
+      }
+      plan.push_back(step);
+    }
+    for (int i = 0; i < type->extension_range_count(); i++) {
+      SerializationStep step{};
+      step.kind = SerializationStep::kExtensions;
+      step.number = type->extension_range(i)->start_number();
+      step.end = type->extension_range(i)->end_number();
+      step.offset = type_info->extensions_offset;
+      plan.push_back(step);
+    }
+    std::stable_sort(plan.begin(), plan.end(),
+                     [](const SerializationStep& a, const SerializationStep& b) {
+                       return a.number < b.number;
+                     });
+#if HAVE_LLVM
+    if (compile_types_) {
+      type_info->compiled_serialization_plan =
+          internal::CompiledSerializationPlan::Compile(
+              type->full_name(), plan, type_info->has_bits_offset,
+              &StepByteSize, &SerializeStep);
+    }
+#endif  // HAVE_LLVM
+  }
+
   // Cross link prototypes.
   prototype->CrossLinkPrototypes();
 
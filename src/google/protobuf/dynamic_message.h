@@ -39,6 +39,7 @@
 #define GOOGLE_PROTOBUF_DYNAMIC_MESSAGE_H__
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -46,6 +47,7 @@
 #include "absl/synchronization/mutex.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/port.h"
+#include "google/protobuf/prototype_cache.h"
 #include "google/protobuf/reflection.h"
 #include "google/protobuf/repeated_field.h"
 
@@ -112,6 +114,29 @@ class PROTOBUF_EXPORT DynamicMessageFactory : public MessageFactory {
     delegate_to_generated_factory_ = enable;
   }
 
+  // Call this to tell the DynamicMessageFactory that prototypes for types
+  // defined in `underlay_pool` (typically the underlay of the pool this
+  // factory's types come from) should be taken from `underlay_factory`
+  // instead of being built again.  This lets many pools layered over one
+  // shared underlay also share its prototypes, so that each layer pays only
+  // for its own types.  `underlay_factory` remains property of the caller and
+  // must outlive this factory; it may itself delegate to a further underlay.
+  // Must be called before the first GetPrototype().
+  void SetUnderlayFactory(const DescriptorPool* underlay_pool,
+                          MessageFactory* underlay_factory) {
+    underlay_pool_ = underlay_pool;
+    underlay_factory_ = underlay_factory;
+  }
+
+  // Call this to have the factory compile the ByteSizeLong() and
+  // serialization routines of each type it constructs to native code, which
+  // pays off for types that are serialized many times.  This needs protobuf
+  // to be built with -Dprotobuf_WITH_LLVM=ON; otherwise, or if compiling a
+  // type fails, the factory's messages keep interpreting a per-type
+  // serialization plan, as they do by default.  Must be called before the
+  // first GetPrototype().
+  void SetCompileTypes(bool enable) { compile_types_ = enable; }
+
   // implements MessageFactory ---------------------------------------
 
   // Given a Descriptor, constructs the default (prototype) Message of that
@@ -131,15 +156,30 @@ class PROTOBUF_EXPORT DynamicMessageFactory : public MessageFactory {
   // The method is thread-safe.
   const Message* GetPrototype(const Descriptor* type) override;
 
+  // Returns the number of prototypes currently held by all
+  // DynamicMessageFactory instances in the process.  Each one owns the layout
+  // and reflection of its type, so this tracks the memory factories keep
+  // alive.  Types delegated to another factory are not counted.
+  static int64_t LivePrototypeCount();
+
  private:
   const DescriptorPool* pool_;
   bool delegate_to_generated_factory_;
+  const DescriptorPool* underlay_pool_;
+  MessageFactory* underlay_factory_;
+  bool compile_types_;
 
   struct TypeInfo;
   absl::flat_hash_map<const Descriptor*, const TypeInfo*> prototypes_;
   mutable absl::Mutex prototypes_mutex_;
+  // The completed prototypes in prototypes_, for lookups without the lock.
+  internal::PrototypeCache prototype_cache_;
 
   friend class DynamicMessage;
+  // Returns true and sets `prototype` to the answer of the generated or
+  // underlay factory if `type` is delegated to one.
+  bool GetDelegatedPrototype(const Descriptor* type,
+                             const Message** prototype);
   const Message* GetPrototypeNoLock(const Descriptor* type);
 };
 
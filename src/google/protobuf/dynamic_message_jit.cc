@@ -0,0 +1,562 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Compiles a DynamicMessage type's serialization plan to native code with
+// LLVM's ORC JIT.  Each plan becomes two functions, ByteSize and Serialize,
+// which unroll the plan: singular numeric, enum and bool fields are checked,
+// sized and encoded inline, with their tags as constants, and every other
+// step is a call to the interpreter's function for that step, skipped
+// inline when the step is a singular field whose has-bit is clear.
+
+#if HAVE_LLVM
+#include "google/protobuf/dynamic_message_jit.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/absl_log.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/TargetSelect.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+// The JIT shared by all compiled plans, or nullptr if LLVM cannot target the
+// host.  Leaked, as plans may be freed during static destruction.
+llvm::orc::LLJIT* GetJit() {
+  static llvm::orc::LLJIT* const jit = []() -> llvm::orc::LLJIT* {
+    if (llvm::InitializeNativeTarget() ||
+        llvm::InitializeNativeTargetAsmPrinter()) {
+      ABSL_LOG(WARNING) << "LLVM cannot target this host; DynamicMessage "
+                           "types will not be compiled.";
+      return nullptr;
+    }
+    auto jit = llvm::orc::LLJITBuilder().create();
+    if (!jit) {
+      ABSL_LOG(WARNING) << "Cannot create the DynamicMessage JIT: "
+                        << llvm::toString(jit.takeError());
+      return nullptr;
+    }
+    return jit->release();
+  }();
+  return jit;
+}
+
+uint8_t* EnsureSpace(io::EpsCopyOutputStream* stream, uint8_t* ptr) {
+  return stream->EnsureSpace(ptr);
+}
+
+bool HasHasBit(const SerializationStep& step) {
+  return step.kind == SerializationStep::kSingular &&
+         step.has_bit != static_cast<uint32_t>(-1);
+}
+
+// Whether the compiled code handles a step by itself rather than calling
+// back into the interpreter.
+bool IsInline(const SerializationStep& step) {
+  if (step.kind != SerializationStep::kSingular) return false;
+  switch (step.type) {
+    case FieldDescriptor::TYPE_STRING:
+    case FieldDescriptor::TYPE_BYTES:
+    case FieldDescriptor::TYPE_MESSAGE:
+    case FieldDescriptor::TYPE_GROUP:
+      return false;
+    default:
+      return true;
+  }
+}
+
+// Emits the functions for one plan into a module.
+class PlanCompiler {
+ public:
+  PlanCompiler(llvm::Module& module, const std::vector<SerializationStep>& plan,
+               int has_bits_offset, SerializationStepByteSizeFn step_byte_size,
+               SerializationStepFn serialize_step)
+      : module_(module),
+        context_(module.getContext()),
+        builder_(context_),
+        plan_(plan),
+        has_bits_offset_(has_bits_offset),
+        ptr_type_(llvm::Type::getInt8PtrTy(context_)),
+        size_type_(llvm::Type::getIntNTy(context_, sizeof(size_t) * 8)),
+        i8_(builder_.getInt8Ty()),
+        i32_(builder_.getInt32Ty()),
+        i64_(builder_.getInt64Ty()),
+        step_byte_size_type_(llvm::FunctionType::get(
+            size_type_, {ptr_type_, ptr_type_, ptr_type_}, false)),
+        serialize_step_type_(llvm::FunctionType::get(
+            ptr_type_, {ptr_type_, ptr_type_, ptr_type_, ptr_type_, ptr_type_},
+            false)),
+        ensure_space_type_(llvm::FunctionType::get(
+            ptr_type_, {ptr_type_, ptr_type_}, false)),
+        step_byte_size_(FunctionPointer(
+            reinterpret_cast<const void*>(step_byte_size),
+            step_byte_size_type_)),
+        serialize_step_(FunctionPointer(
+            reinterpret_cast<const void*>(serialize_step),
+            serialize_step_type_)),
+        ensure_space_(FunctionPointer(
+            reinterpret_cast<const void*>(&EnsureSpace), ensure_space_type_)) {
+  }
+
+  // size_t ByteSize(const Message& message)
+  void EmitByteSize(const std::string& name) {
+    llvm::Function* function = llvm::Function::Create(
+        llvm::FunctionType::get(size_type_, {ptr_type_}, false),
+        llvm::Function::ExternalLinkage, name, module_);
+    builder_.SetInsertPoint(
+        llvm::BasicBlock::Create(context_, "entry", function));
+    llvm::Value* message = function->getArg(0);
+    llvm::Value* has_bits = HasBits(message);
+
+    llvm::Value* total = llvm::ConstantInt::get(size_type_, 0);
+    for (const SerializationStep& step : plan_) {
+      llvm::Value* size;
+      if (IsInline(step)) {
+        // Branch-free: the field is loaded and sized even when unset.
+        size = builder_.CreateSelect(
+            IsSet(step, message),
+            builder_.CreateAdd(llvm::ConstantInt::get(size_type_,
+                                                      step.tag_size),
+                               ValueSize(step, message)),
+            llvm::ConstantInt::get(size_type_, 0));
+      } else if (HasHasBit(step)) {
+        // Unset optional strings and messages are common; skip the call.
+        llvm::BasicBlock* before = builder_.GetInsertBlock();
+        llvm::BasicBlock* call =
+            llvm::BasicBlock::Create(context_, "call", function);
+        llvm::BasicBlock* next =
+            llvm::BasicBlock::Create(context_, "next", function);
+        builder_.CreateCondBr(IsSet(step, message), call, next);
+        builder_.SetInsertPoint(call);
+        llvm::Value* called =
+            builder_.CreateCall(step_byte_size_type_, step_byte_size_,
+                                {StepPointer(step), message, has_bits});
+        builder_.CreateBr(next);
+        builder_.SetInsertPoint(next);
+        llvm::PHINode* phi = builder_.CreatePHI(size_type_, 2);
+        phi->addIncoming(llvm::ConstantInt::get(size_type_, 0), before);
+        phi->addIncoming(called, call);
+        size = phi;
+      } else {
+        size = builder_.CreateCall(step_byte_size_type_, step_byte_size_,
+                                   {StepPointer(step), message, has_bits});
+      }
+      total = builder_.CreateAdd(total, size);
+    }
+    builder_.CreateRet(total);
+  }
+
+  // uint8_t* Serialize(const Message& message, uint8_t* target,
+  //                    io::EpsCopyOutputStream* stream)
+  void EmitSerialize(const std::string& name) {
+    llvm::Function* function = llvm::Function::Create(
+        llvm::FunctionType::get(ptr_type_, {ptr_type_, ptr_type_, ptr_type_},
+                                false),
+        llvm::Function::ExternalLinkage, name, module_);
+    builder_.SetInsertPoint(
+        llvm::BasicBlock::Create(context_, "entry", function));
+    llvm::Value* message = function->getArg(0);
+    llvm::Value* target = function->getArg(1);
+    llvm::Value* stream = function->getArg(2);
+    llvm::Value* has_bits = HasBits(message);
+
+    for (const SerializationStep& step : plan_) {
+      if (!IsInline(step) && !HasHasBit(step)) {
+        target = builder_.CreateCall(
+            serialize_step_type_, serialize_step_,
+            {StepPointer(step), message, has_bits, target, stream});
+        continue;
+      }
+      llvm::BasicBlock* before = builder_.GetInsertBlock();
+      llvm::BasicBlock* write =
+          llvm::BasicBlock::Create(context_, "write", function);
+      llvm::BasicBlock* next =
+          llvm::BasicBlock::Create(context_, "next", function);
+      builder_.CreateCondBr(IsSet(step, message), write, next);
+
+      builder_.SetInsertPoint(write);
+      llvm::Value* written;
+      if (IsInline(step)) {
+        written = builder_.CreateCall(ensure_space_type_, ensure_space_,
+                                      {stream, target});
+        written = WriteTag(step, written);
+        written = WriteValue(step, message, written, function);
+      } else {
+        written = builder_.CreateCall(
+            serialize_step_type_, serialize_step_,
+            {StepPointer(step), message, has_bits, target, stream});
+      }
+      llvm::BasicBlock* after_write = builder_.GetInsertBlock();
+      builder_.CreateBr(next);
+
+      builder_.SetInsertPoint(next);
+      llvm::PHINode* phi = builder_.CreatePHI(ptr_type_, 2);
+      phi->addIncoming(target, before);
+      phi->addIncoming(written, after_write);
+      target = phi;
+    }
+    builder_.CreateRet(target);
+  }
+
+ private:
+  llvm::Value* FunctionPointer(const void* function, llvm::FunctionType* type) {
+    return ConstantPointer(function, type->getPointerTo());
+  }
+
+  llvm::Constant* ConstantPointer(const void* pointer, llvm::Type* type) {
+    return llvm::ConstantExpr::getIntToPtr(
+        llvm::ConstantInt::get(size_type_, reinterpret_cast<uintptr_t>(pointer)),
+        type);
+  }
+
+  llvm::Value* StepPointer(const SerializationStep& step) {
+    return ConstantPointer(&step, ptr_type_);
+  }
+
+  llvm::Value* At(llvm::Value* base, uint32_t offset) {
+    return builder_.CreateConstInBoundsGEP1_32(i8_, base, offset);
+  }
+
+  llvm::Value* Load(llvm::Type* type, llvm::Value* base, uint32_t offset) {
+    llvm::Value* address =
+        builder_.CreateBitCast(At(base, offset), type->getPointerTo());
+    return builder_.CreateLoad(type, address);
+  }
+
+  llvm::Value* HasBits(llvm::Value* message) {
+    if (has_bits_offset_ == -1) {
+      return llvm::ConstantPointerNull::get(
+          llvm::cast<llvm::PointerType>(ptr_type_));
+    }
+    return At(message, has_bits_offset_);
+  }
+
+  // The type the field is stored as, integers standing in for floating point
+  // values and bool.
+  llvm::Type* StorageType(const SerializationStep& step) {
+    switch (WireFormatLite::FieldTypeToCppType(
+        static_cast<WireFormatLite::FieldType>(step.type))) {
+      case WireFormatLite::CPPTYPE_INT64:
+      case WireFormatLite::CPPTYPE_UINT64:
+      case WireFormatLite::CPPTYPE_DOUBLE:
+        return i64_;
+      case WireFormatLite::CPPTYPE_BOOL:
+        return i8_;
+      default:
+        return i32_;
+    }
+  }
+
+  // As in SerializeStep(): the has-bit if the field has one, otherwise
+  // whether its bits are non-zero.
+  llvm::Value* IsSet(const SerializationStep& step, llvm::Value* message) {
+    if (step.has_bit != static_cast<uint32_t>(-1)) {
+      llvm::Value* word =
+          Load(i32_, message, has_bits_offset_ + step.has_bit / 32 * 4);
+      return builder_.CreateICmpNE(
+          builder_.CreateAnd(word, 1u << (step.has_bit % 32)),
+          builder_.getInt32(0));
+    }
+    llvm::Type* type = StorageType(step);
+    return builder_.CreateICmpNE(Load(type, message, step.offset),
+                                 llvm::ConstantInt::get(type, 0));
+  }
+
+  // The field's value as the unsigned 64-bit integer its varint encodes.
+  llvm::Value* VarintValue(const SerializationStep& step,
+                           llvm::Value* message) {
+    llvm::Value* value = Load(StorageType(step), message, step.offset);
+    switch (step.type) {
+      case FieldDescriptor::TYPE_INT32:
+      case FieldDescriptor::TYPE_ENUM:
+        return builder_.CreateSExt(value, i64_);
+      case FieldDescriptor::TYPE_UINT32:
+        return builder_.CreateZExt(value, i64_);
+      case FieldDescriptor::TYPE_SINT32:
+        return builder_.CreateZExt(
+            builder_.CreateXor(builder_.CreateShl(value, 1),
+                               builder_.CreateAShr(value, 31)),
+            i64_);
+      case FieldDescriptor::TYPE_SINT64:
+        return builder_.CreateXor(builder_.CreateShl(value, 1),
+                                  builder_.CreateAShr(value, 63));
+      case FieldDescriptor::TYPE_BOOL:
+        return builder_.CreateZExt(
+            builder_.CreateICmpNE(value, builder_.getInt8(0)), i64_);
+      default:
+        return value;
+    }
+  }
+
+  bool IsVarint(const SerializationStep& step) {
+    return WireFormatLite::WireTypeForFieldType(
+               static_cast<WireFormatLite::FieldType>(step.type)) ==
+           WireFormatLite::WIRETYPE_VARINT;
+  }
+
+  // The size of the field's value, without its tag.
+  llvm::Value* ValueSize(const SerializationStep& step, llvm::Value* message) {
+    if (!IsVarint(step) || step.type == FieldDescriptor::TYPE_BOOL) {
+      return llvm::ConstantInt::get(
+          size_type_, step.type == FieldDescriptor::TYPE_BOOL
+                          ? 1
+                          : StorageType(step)->getIntegerBitWidth() / 8);
+    }
+    // As in WireFormatLite::UInt64Size(): (log2(value | 1) * 9 + 73) / 64.
+    llvm::Function* ctlz = llvm::Intrinsic::getDeclaration(
+        &module_, llvm::Intrinsic::ctlz, {i64_});
+    llvm::Value* leading_zeros = builder_.CreateCall(
+        ctlz, {builder_.CreateOr(VarintValue(step, message), 1),
+               builder_.getFalse()});
+    llvm::Value* log2 = builder_.CreateSub(builder_.getInt64(63), leading_zeros);
+    llvm::Value* size = builder_.CreateLShr(
+        builder_.CreateAdd(builder_.CreateMul(log2, builder_.getInt64(9)),
+                           builder_.getInt64(73)),
+        6);
+    return builder_.CreateZExtOrTrunc(size, size_type_);
+  }
+
+  llvm::Value* WriteTag(const SerializationStep& step, llvm::Value* target) {
+    uint8_t tag[5];  // The longest varint32.
+    uint8_t* end = io::CodedOutputStream::WriteVarint32ToArray(
+        WireFormatLite::MakeTag(
+            step.number, WireFormatLite::WireTypeForFieldType(
+                             static_cast<WireFormatLite::FieldType>(step.type))),
+        tag);
+    for (uint8_t* byte = tag; byte != end; ++byte) {
+      builder_.CreateStore(builder_.getInt8(*byte), target);
+      target = At(target, 1);
+    }
+    return target;
+  }
+
+  llvm::Value* WriteValue(const SerializationStep& step, llvm::Value* message,
+                          llvm::Value* target, llvm::Function* function) {
+    if (!IsVarint(step)) {
+      // Fixed-width values are stored little-endian.
+      llvm::Type* type = StorageType(step);
+      llvm::Value* value = Load(type, message, step.offset);
+      if (!module_.getDataLayout().isLittleEndian()) {
+        value = builder_.CreateUnaryIntrinsic(llvm::Intrinsic::bswap, value);
+      }
+      builder_.CreateAlignedStore(
+          value, builder_.CreateBitCast(target, type->getPointerTo()),
+          llvm::MaybeAlign(1));
+      return At(target, type->getIntegerBitWidth() / 8);
+    }
+
+    llvm::Value* value = VarintValue(step, message);
+    llvm::BasicBlock* entry = builder_.GetInsertBlock();
+    llvm::BasicBlock* loop = llvm::BasicBlock::Create(context_, "varint", function);
+    llvm::BasicBlock* more =
+        llvm::BasicBlock::Create(context_, "varint.more", function);
+    llvm::BasicBlock* last =
+        llvm::BasicBlock::Create(context_, "varint.last", function);
+    builder_.CreateBr(loop);
+
+    builder_.SetInsertPoint(loop);
+    llvm::PHINode* remaining = builder_.CreatePHI(i64_, 2);
+    llvm::PHINode* ptr = builder_.CreatePHI(ptr_type_, 2);
+    remaining->addIncoming(value, entry);
+    ptr->addIncoming(target, entry);
+    builder_.CreateCondBr(
+        builder_.CreateICmpULT(remaining, builder_.getInt64(0x80)), last,
+        more);
+
+    builder_.SetInsertPoint(more);
+    builder_.CreateStore(
+        builder_.CreateOr(builder_.CreateTrunc(remaining, i8_), 0x80), ptr);
+    remaining->addIncoming(builder_.CreateLShr(remaining, 7), more);
+    ptr->addIncoming(At(ptr, 1), more);
+    builder_.CreateBr(loop);
+
+    builder_.SetInsertPoint(last);
+    builder_.CreateStore(builder_.CreateTrunc(remaining, i8_), ptr);
+    return At(ptr, 1);
+  }
+
+  llvm::Module& module_;
+  llvm::LLVMContext& context_;
+  llvm::IRBuilder<> builder_;
+  const std::vector<SerializationStep>& plan_;
+  const int has_bits_offset_;
+  llvm::Type* const ptr_type_;
+  llvm::IntegerType* const size_type_;
+  llvm::IntegerType* const i8_;
+  llvm::IntegerType* const i32_;
+  llvm::IntegerType* const i64_;
+  llvm::FunctionType* const step_byte_size_type_;
+  llvm::FunctionType* const serialize_step_type_;
+  llvm::FunctionType* const ensure_space_type_;
+  llvm::Value* const step_byte_size_;
+  llvm::Value* const serialize_step_;
+  llvm::Value* const ensure_space_;
+};
+
+void Optimize(llvm::Module& module) {
+  llvm::LoopAnalysisManager loop_analyses;
+  llvm::FunctionAnalysisManager function_analyses;
+  llvm::CGSCCAnalysisManager cgscc_analyses;
+  llvm::ModuleAnalysisManager module_analyses;
+  llvm::PassBuilder builder;
+  builder.registerModuleAnalyses(module_analyses);
+  builder.registerCGSCCAnalyses(cgscc_analyses);
+  builder.registerFunctionAnalyses(function_analyses);
+  builder.registerLoopAnalyses(loop_analyses);
+  builder.crossRegisterProxies(loop_analyses, function_analyses,
+                               cgscc_analyses, module_analyses);
+  builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2)
+      .run(module, module_analyses);
+}
+
+template <typename Fn>
+Fn LookUp(llvm::orc::LLJIT& jit, llvm::orc::JITDylib& library,
+          const std::string& name) {
+  auto symbol = jit.lookup(library, name);
+  if (!symbol) {
+    ABSL_LOG(ERROR) << "Cannot find " << name << ": "
+                    << llvm::toString(symbol.takeError());
+    return nullptr;
+  }
+#if LLVM_VERSION_MAJOR >= 15
+  return symbol->template toPtr<Fn>();
+#else
+  return reinterpret_cast<Fn>(static_cast<uintptr_t>(symbol->getAddress()));
+#endif
+}
+
+}  // namespace
+
+// Owns the machine code of one plan.
+class CompiledSerializationPlan::Module {
+ public:
+  explicit Module(llvm::orc::ResourceTrackerSP tracker)
+      : tracker_(std::move(tracker)) {}
+  Module(const Module&) = delete;
+  Module& operator=(const Module&) = delete;
+  ~Module() {
+    if (llvm::Error error = tracker_->remove()) {
+      ABSL_LOG(ERROR) << "Cannot free compiled DynamicMessage code: "
+                      << llvm::toString(std::move(error));
+    }
+  }
+
+ private:
+  llvm::orc::ResourceTrackerSP tracker_;
+};
+
+std::unique_ptr<CompiledSerializationPlan> CompiledSerializationPlan::Compile(
+    absl::string_view type_name, const std::vector<SerializationStep>& plan,
+    int has_bits_offset, SerializationStepByteSizeFn step_byte_size,
+    SerializationStepFn serialize_step) {
+  llvm::orc::LLJIT* jit = GetJit();
+  if (jit == nullptr) return nullptr;
+
+  // Symbols share the JIT's main library, so they need unique names.
+  static std::atomic<uint64_t> next_id{0};
+  const std::string prefix =
+      absl::StrCat("protobuf.", type_name, ".",
+                   next_id.fetch_add(1, std::memory_order_relaxed), ".");
+  const std::string byte_size_name = prefix + "ByteSize";
+  const std::string serialize_name = prefix + "Serialize";
+
+  auto context = std::make_unique<llvm::LLVMContext>();
+  auto module = std::make_unique<llvm::Module>(prefix, *context);
+  module->setDataLayout(jit->getDataLayout());
+  module->setTargetTriple(jit->getTargetTriple().str());
+  PlanCompiler compiler(*module, plan, has_bits_offset, step_byte_size,
+                        serialize_step);
+  compiler.EmitByteSize(byte_size_name);
+  compiler.EmitSerialize(serialize_name);
+  if (llvm::verifyModule(*module)) {
+    ABSL_LOG(DFATAL) << "Invalid code generated for " << type_name;
+    return nullptr;
+  }
+  Optimize(*module);
+
+  llvm::orc::JITDylib& library = jit->getMainJITDylib();
+  llvm::orc::ResourceTrackerSP tracker = library.createResourceTracker();
+  if (llvm::Error error = jit->addIRModule(
+          tracker, llvm::orc::ThreadSafeModule(std::move(module),
+                                               std::move(context)))) {
+    ABSL_LOG(WARNING) << "Cannot compile " << type_name << ": "
+                      << llvm::toString(std::move(error));
+    return nullptr;
+  }
+  auto owner = std::make_unique<Module>(std::move(tracker));
+  auto byte_size = LookUp<size_t (*)(const Message&)>(*jit, library,
+                                                      byte_size_name);
+  auto serialize =
+      LookUp<uint8_t* (*)(const Message&, uint8_t*, io::EpsCopyOutputStream*)>(
+          *jit, library, serialize_name);
+  if (byte_size == nullptr || serialize == nullptr) return nullptr;
+  return std::unique_ptr<CompiledSerializationPlan>(
+      new CompiledSerializationPlan(std::move(owner), byte_size, serialize));
+}
+
+CompiledSerializationPlan::CompiledSerializationPlan(
+    std::unique_ptr<Module> module, size_t (*byte_size)(const Message&),
+    uint8_t* (*serialize)(const Message&, uint8_t*, io::EpsCopyOutputStream*))
+    : module_(std::move(module)),
+      byte_size_(byte_size),
+      serialize_(serialize) {}
+
+CompiledSerializationPlan::~CompiledSerializationPlan() = default;
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // HAVE_LLVM
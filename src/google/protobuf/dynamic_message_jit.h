@@ -0,0 +1,138 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file is internal to the protobuf runtime; do not include it.
+//
+// The serialization plan DynamicMessageFactory builds for each type, and
+// the optional backend that compiles a plan to native code with LLVM's ORC
+// JIT.  The backend is only built when protobuf is configured with
+// -Dprotobuf_WITH_LLVM=ON (which defines HAVE_LLVM); see
+// DynamicMessageFactory::SetCompileTypes().
+
+#ifndef GOOGLE_PROTOBUF_DYNAMIC_MESSAGE_JIT_H__
+#define GOOGLE_PROTOBUF_DYNAMIC_MESSAGE_JIT_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// A step of a DynamicMessage type's serialization plan, which
+// DynamicMessage::ByteSizeLong() and _InternalSerialize() walk instead of
+// going through reflection for every field.  Steps are in field number order.
+struct SerializationStep {
+  enum Kind : uint8_t {
+    kSingular,    // A singular field outside of any real oneof.
+    kRepeated,    // A repeated field which is neither packed nor a map.
+    kPacked,      // A packed repeated field.
+    kExtensions,  // The extensions numbered in [number, end).
+    kReflective,  // Any other field, left to WireFormat.
+  };
+  Kind kind;
+  bool strict_utf8;
+  FieldDescriptor::Type type;
+  int number;
+  int end;
+  uint32_t offset;
+  uint32_t has_bit;  // static_cast<uint32_t>(-1) if the field has none.
+  uint32_t tag_size;
+  const FieldDescriptor* field;
+};
+
+// Runs one step of a plan for `message`, whose has-bits are at `has_bits`
+// (nullptr if the type has none).  ByteSize does not count extensions;
+// DynamicMessage adds their size separately.
+using SerializationStepByteSizeFn = size_t (*)(const SerializationStep& step,
+                                               const Message& message,
+                                               const uint32_t* has_bits);
+using SerializationStepFn = uint8_t* (*)(const SerializationStep& step,
+                                         const Message& message,
+                                         const uint32_t* has_bits,
+                                         uint8_t* target,
+                                         io::EpsCopyOutputStream* stream);
+
+// A serialization plan compiled to native code.  Singular numeric, enum and
+// bool fields are sized and written inline; every other step calls back into
+// the interpreter.  The code is freed with the object.
+class PROTOBUF_EXPORT CompiledSerializationPlan {
+ public:
+  // Compiles `plan`, whose steps must outlive the result, for a type whose
+  // has-bits are at `has_bits_offset` (-1 if it has none).  Returns nullptr
+  // if the JIT is unavailable or fails, in which case the caller keeps
+  // interpreting the plan.
+  static std::unique_ptr<CompiledSerializationPlan> Compile(
+      absl::string_view type_name, const std::vector<SerializationStep>& plan,
+      int has_bits_offset, SerializationStepByteSizeFn step_byte_size,
+      SerializationStepFn serialize_step);
+
+  CompiledSerializationPlan(const CompiledSerializationPlan&) = delete;
+  CompiledSerializationPlan& operator=(const CompiledSerializationPlan&) =
+      delete;
+  ~CompiledSerializationPlan();
+
+  // Equivalent to walking the plan with the callbacks given to Compile().
+  size_t ByteSize(const Message& message) const { return byte_size_(message); }
+  uint8_t* Serialize(const Message& message, uint8_t* target,
+                     io::EpsCopyOutputStream* stream) const {
+    return serialize_(message, target, stream);
+  }
+
+ private:
+  class Module;
+
+  CompiledSerializationPlan(std::unique_ptr<Module> module,
+                            size_t (*byte_size)(const Message&),
+                            uint8_t* (*serialize)(const Message&, uint8_t*,
+                                                  io::EpsCopyOutputStream*));
+
+  std::unique_ptr<Module> module_;
+  size_t (*byte_size_)(const Message&);
+  uint8_t* (*serialize_)(const Message&, uint8_t*, io::EpsCopyOutputStream*);
+};
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_DYNAMIC_MESSAGE_JIT_H__
@@ -42,8 +42,13 @@
 
 #include "google/protobuf/dynamic_message.h"
 
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <thread>
+#include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/testing/googletest.h"
@@ -132,6 +137,34 @@ TEST_F(DynamicMessageTest, OnePrototype) {
   EXPECT_EQ(prototype_, factory_.GetPrototype(descriptor_));
 }
 
+TEST_F(DynamicMessageTest, ConcurrentGetPrototype) {
+  // Every thread must see the same prototype for each type, whether it built
+  // the type, waited for another thread to, or found it already published.
+  const FileDescriptor* file = descriptor_->file();
+  DynamicMessageFactory factory(&pool_);
+  constexpr int kThreads = 8;
+  std::vector<std::vector<const Message*>> seen(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < file->message_type_count(); ++i) {
+          const Message* prototype =
+              factory.GetPrototype(file->message_type(i));
+          if (round == 0) seen[t].push_back(prototype);
+          ASSERT_EQ(prototype, seen[t][i]);
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  for (int i = 0; i < file->message_type_count(); ++i) {
+    const Message* prototype = factory.GetPrototype(file->message_type(i));
+    EXPECT_EQ(prototype->GetDescriptor(), file->message_type(i));
+    for (int t = 0; t < kThreads; ++t) EXPECT_EQ(seen[t][i], prototype);
+  }
+}
+
 TEST_F(DynamicMessageTest, Defaults) {
   // Check that all default values are set correctly in the initial message.
   TestUtil::ReflectionTester reflection_tester(descriptor_);
@@ -249,6 +282,155 @@ TEST_P(DynamicMessageTest, Oneof) {
   }
 }
 
+TEST_P(DynamicMessageTest, Clear) {
+  Arena arena;
+  Arena* message_arena = GetParam() ? &arena : nullptr;
+
+  std::unique_ptr<Message> owned;
+  Message* message = prototype_->New(message_arena);
+  if (!GetParam()) owned.reset(message);
+  TestUtil::ReflectionTester reflection_tester(descriptor_);
+  reflection_tester.SetAllFieldsViaReflection(message);
+  message->Clear();
+  reflection_tester.ExpectClearViaReflection(*message);
+  // The message is still usable after being cleared.
+  reflection_tester.SetAllFieldsViaReflection(message);
+  reflection_tester.ExpectAllFieldsSetViaReflection(*message);
+
+  std::unique_ptr<Message> owned_extensions;
+  message = extensions_prototype_->New(message_arena);
+  if (!GetParam()) owned_extensions.reset(message);
+  TestUtil::ReflectionTester extensions_tester(extensions_descriptor_);
+  extensions_tester.SetAllFieldsViaReflection(message);
+  message->Clear();
+  extensions_tester.ExpectClearViaReflection(*message);
+
+  std::unique_ptr<Message> owned_oneof;
+  message = oneof_prototype_->New(message_arena);
+  if (!GetParam()) owned_oneof.reset(message);
+  TestUtil::ReflectionTester oneof_tester(oneof_descriptor_);
+  oneof_tester.SetOneofViaReflection(message);
+  message->Clear();
+  for (int i = 0; i < oneof_descriptor_->oneof_decl_count(); ++i) {
+    EXPECT_FALSE(message->GetReflection()->HasOneof(
+        *message, oneof_descriptor_->oneof_decl(i)));
+  }
+  EXPECT_EQ(0, message->ByteSizeLong());
+
+  std::unique_ptr<Message> owned_proto3;
+  message = proto3_prototype_->New(message_arena);
+  if (!GetParam()) owned_proto3.reset(message);
+  const Reflection* reflection = message->GetReflection();
+  reflection->SetInt32(message,
+                       proto3_descriptor_->FindFieldByName("optional_int32"), 1);
+  reflection->SetString(
+      message, proto3_descriptor_->FindFieldByName("optional_string"), "a");
+  reflection->AddInt64(
+      message, proto3_descriptor_->FindFieldByName("repeated_int64"), 2);
+  reflection->MutableUnknownFields(message)->AddVarint(12345, 1);
+  message->Clear();
+  EXPECT_EQ(0, message->ByteSizeLong());
+}
+
+TEST_P(DynamicMessageTest, Serialize) {
+  // DynamicMessage serializes through a plan of its own; check that it
+  // produces the same bytes as the generated code does.
+  Arena arena;
+  Arena* message_arena = GetParam() ? &arena : nullptr;
+
+  unittest::TestAllTypes all_types;
+  TestUtil::SetAllFields(&all_types);
+  all_types.mutable_unknown_fields()->AddVarint(123456, 7);
+  Message* message = prototype_->New(message_arena);
+  std::unique_ptr<Message> owned(GetParam() ? nullptr : message);
+  ASSERT_TRUE(message->ParseFromString(all_types.SerializeAsString()));
+  EXPECT_EQ(all_types.ByteSizeLong(), message->ByteSizeLong());
+  EXPECT_EQ(all_types.SerializeAsString(), message->SerializeAsString());
+
+  unittest::TestAllExtensions extensions;
+  TestUtil::SetAllExtensions(&extensions);
+  message = extensions_prototype_->New(message_arena);
+  std::unique_ptr<Message> owned_extensions(GetParam() ? nullptr : message);
+  ASSERT_TRUE(message->ParseFromString(extensions.SerializeAsString()));
+  EXPECT_EQ(extensions.SerializeAsString(), message->SerializeAsString());
+
+  unittest::TestPackedTypes packed;
+  TestUtil::SetPackedFields(&packed);
+  message = packed_prototype_->New(message_arena);
+  std::unique_ptr<Message> owned_packed(GetParam() ? nullptr : message);
+  ASSERT_TRUE(message->ParseFromString(packed.SerializeAsString()));
+  EXPECT_EQ(packed.SerializeAsString(), message->SerializeAsString());
+
+  unittest::TestOneof2 oneof;
+  TestUtil::SetOneof1(&oneof);
+  message = oneof_prototype_->New(message_arena);
+  std::unique_ptr<Message> owned_oneof(GetParam() ? nullptr : message);
+  ASSERT_TRUE(message->ParseFromString(oneof.SerializeAsString()));
+  EXPECT_EQ(oneof.SerializeAsString(), message->SerializeAsString());
+
+  proto2_nofieldpresence_unittest::TestAllTypes proto3;
+  proto3.set_optional_int32(1);
+  proto3.set_optional_float(-0.0f);
+  proto3.set_optional_string("a");
+  proto3.mutable_optional_nested_message()->set_bb(0);
+  proto3.add_repeated_int32(1);
+  message = proto3_prototype_->New(message_arena);
+  std::unique_ptr<Message> owned_proto3(GetParam() ? nullptr : message);
+  ASSERT_TRUE(message->ParseFromString(proto3.SerializeAsString()));
+  EXPECT_EQ(proto3.SerializeAsString(), message->SerializeAsString());
+}
+
+TEST_P(DynamicMessageTest, SerializeCompiled) {
+  // Types are only compiled when protobuf is built with LLVM; otherwise this
+  // checks that SetCompileTypes() falls back to the interpreted plan.
+  DynamicMessageFactory factory(&pool_);
+  factory.SetCompileTypes(true);
+  Arena arena;
+  Arena* message_arena = GetParam() ? &arena : nullptr;
+
+  unittest::TestAllTypes all_types;
+  TestUtil::SetAllFields(&all_types);
+  all_types.set_optional_int32(-1);
+  all_types.set_optional_sint64(std::numeric_limits<int64_t>::min());
+  all_types.set_optional_uint64(std::numeric_limits<uint64_t>::max());
+  Message* message = factory.GetPrototype(descriptor_)->New(message_arena);
+  std::unique_ptr<Message> owned(GetParam() ? nullptr : message);
+  ASSERT_TRUE(message->ParseFromString(all_types.SerializeAsString()));
+  EXPECT_EQ(all_types.ByteSizeLong(), message->ByteSizeLong());
+  EXPECT_EQ(all_types.SerializeAsString(), message->SerializeAsString());
+  message->Clear();
+  EXPECT_EQ(0, message->ByteSizeLong());
+  EXPECT_EQ("", message->SerializeAsString());
+
+  unittest::TestAllExtensions extensions;
+  TestUtil::SetAllExtensions(&extensions);
+  message =
+      factory.GetPrototype(extensions_descriptor_)->New(message_arena);
+  std::unique_ptr<Message> owned_extensions(GetParam() ? nullptr : message);
+  ASSERT_TRUE(message->ParseFromString(extensions.SerializeAsString()));
+  EXPECT_EQ(extensions.SerializeAsString(), message->SerializeAsString());
+
+  unittest::TestPackedTypes packed;
+  TestUtil::SetPackedFields(&packed);
+  message = factory.GetPrototype(packed_descriptor_)->New(message_arena);
+  std::unique_ptr<Message> owned_packed(GetParam() ? nullptr : message);
+  ASSERT_TRUE(message->ParseFromString(packed.SerializeAsString()));
+  EXPECT_EQ(packed.SerializeAsString(), message->SerializeAsString());
+
+  proto2_nofieldpresence_unittest::TestAllTypes proto3;
+  proto3.set_optional_int32(1);
+  proto3.set_optional_sint32(-2);
+  proto3.set_optional_float(-0.0f);
+  proto3.set_optional_bool(true);
+  proto3.set_optional_string("a");
+  proto3.add_repeated_int32(1);
+  message = factory.GetPrototype(proto3_descriptor_)->New(message_arena);
+  std::unique_ptr<Message> owned_proto3(GetParam() ? nullptr : message);
+  ASSERT_TRUE(message->ParseFromString(proto3.SerializeAsString()));
+  EXPECT_EQ(proto3.ByteSizeLong(), message->ByteSizeLong());
+  EXPECT_EQ(proto3.SerializeAsString(), message->SerializeAsString());
+}
+
 TEST_P(DynamicMessageTest, SpaceUsed) {
   // Test that SpaceUsedLong() works properly
 
@@ -264,7 +446,12 @@ TEST_P(DynamicMessageTest, SpaceUsed) {
   reflection_tester.SetAllFieldsViaReflection(message);
   EXPECT_LT(initial_space_used, message->SpaceUsedLong());
 
-  if (!GetParam()) {
+  if (GetParam()) {
+    // Only the arena part is counted, which leaves out string contents.
+    EXPECT_LT(initial_space_used, message->SpaceUsedOnArenaLong());
+    EXPECT_LE(message->SpaceUsedOnArenaLong(), message->SpaceUsedLong());
+  } else {
+    EXPECT_EQ(0, message->SpaceUsedOnArenaLong());
     delete message;
   }
 }
@@ -319,6 +506,89 @@ TEST_F(DynamicMessageTest, Proto3) {
   delete message;
 }
 
+TEST_F(DynamicMessageTest, UnderlayFactory) {
+  // A pool layered over pool_, with one file of its own.
+  DescriptorPool overlay_pool(&pool_);
+  FileDescriptorProto overlay_file;
+  overlay_file.set_name("overlay.proto");
+  overlay_file.set_package("overlay");
+  overlay_file.add_dependency("google/protobuf/unittest.proto");
+  DescriptorProto* message = overlay_file.add_message_type();
+  message->set_name("Overlay");
+  FieldDescriptorProto* field = message->add_field();
+  field->set_name("all_types");
+  field->set_number(1);
+  field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+  field->set_type(FieldDescriptorProto::TYPE_MESSAGE);
+  field->set_type_name(".protobuf_unittest.TestAllTypes");
+  ASSERT_TRUE(overlay_pool.BuildFile(overlay_file) != nullptr);
+
+  DynamicMessageFactory overlay_factory;
+  overlay_factory.SetUnderlayFactory(&pool_, &factory_);
+
+  // Types from the underlay come straight from its factory.
+  EXPECT_EQ(prototype_, overlay_factory.GetPrototype(descriptor_));
+
+  const Descriptor* overlay_descriptor =
+      overlay_pool.FindMessageTypeByName("overlay.Overlay");
+  ASSERT_TRUE(overlay_descriptor != nullptr);
+  const Message* overlay_prototype =
+      overlay_factory.GetPrototype(overlay_descriptor);
+  ASSERT_TRUE(overlay_prototype != nullptr);
+  EXPECT_NE(overlay_prototype, factory_.GetPrototype(overlay_descriptor));
+
+  const FieldDescriptor* all_types =
+      overlay_descriptor->FindFieldByName("all_types");
+  const Reflection* reflection = overlay_prototype->GetReflection();
+  EXPECT_EQ(prototype_,
+            &reflection->GetMessage(*overlay_prototype, all_types));
+
+  std::unique_ptr<Message> overlay_message(overlay_prototype->New());
+  Message* sub_message =
+      reflection->MutableMessage(overlay_message.get(), all_types);
+  EXPECT_EQ(prototype_->GetReflection(), sub_message->GetReflection());
+  TestUtil::ReflectionTester reflection_tester(descriptor_);
+  reflection_tester.SetAllFieldsViaReflection(sub_message);
+
+  std::unique_ptr<Message> parsed(overlay_prototype->New());
+  ASSERT_TRUE(parsed->ParseFromString(overlay_message->SerializeAsString()));
+  reflection_tester.ExpectAllFieldsSetViaReflection(
+      reflection->GetMessage(*parsed, all_types));
+}
+
+TEST_F(DynamicMessageTest, LayoutIgnoresDeclarationOrder) {
+  // Fields are laid out by alignment, so interleaving bools with 64-bit
+  // fields costs no padding.
+  FileDescriptorProto file;
+  file.set_name("layout.proto");
+  file.set_package("layout");
+  DescriptorProto* interleaved = file.add_message_type();
+  interleaved->set_name("Interleaved");
+  DescriptorProto* grouped = file.add_message_type();
+  grouped->set_name("Grouped");
+  for (int i = 1; i <= 8; i++) {
+    FieldDescriptorProto* field = interleaved->add_field();
+    field->set_name(absl::StrCat("field", i));
+    field->set_number(i);
+    field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+    field->set_type(i % 2 == 0 ? FieldDescriptorProto::TYPE_INT64
+                               : FieldDescriptorProto::TYPE_BOOL);
+  }
+  // The same fields, int64s first.
+  for (int i = 1; i < 8; i += 2) *grouped->add_field() = interleaved->field(i);
+  for (int i = 0; i < 8; i += 2) *grouped->add_field() = interleaved->field(i);
+  ASSERT_TRUE(pool_.BuildFile(file) != nullptr);
+
+  std::unique_ptr<Message> interleaved_message(
+      factory_.GetPrototype(pool_.FindMessageTypeByName("layout.Interleaved"))
+          ->New());
+  std::unique_ptr<Message> grouped_message(
+      factory_.GetPrototype(pool_.FindMessageTypeByName("layout.Grouped"))
+          ->New());
+  EXPECT_EQ(grouped_message->SpaceUsedLong(),
+            interleaved_message->SpaceUsedLong());
+}
+
 INSTANTIATE_TEST_SUITE_P(UseArena, DynamicMessageTest, ::testing::Bool());
 
 }  // namespace protobuf
@@ -155,6 +155,11 @@ class PROTOBUF_EXPORT Empty final :
   Empty* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Empty>(arena);
   }
+  Empty* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Empty* copy = CreateMaybeMessage<Empty>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::internal::ZeroFieldsBase::CopyFrom;
   inline void CopyFrom(const Empty& from) {
     ::google::protobuf::internal::ZeroFieldsBase::CopyImpl(*this, from);
@@ -34,15 +34,21 @@
 
 #include "google/protobuf/extension_set.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/stubs/common.h"
 #include "google/protobuf/arena.h"
-#include "absl/container/flat_hash_set.h"
-#include "absl/hash/hash.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/extension_set_inl.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/message_lite.h"
@@ -70,20 +76,63 @@ inline WireFormatLite::CppType cpp_type(FieldType type) {
 
 // Registry stuff.
 
-struct ExtensionEq {
-  bool operator()(const ExtensionInfo& lhs, const ExtensionInfo& rhs) const {
-    return lhs.message == rhs.message && lhs.number == rhs.number;
+// The extensions registered for one extendee.  Extension numbers are usually
+// handed out consecutively from the start of an extension range, so lookups
+// mostly index a direct-mapped table rather than hash the number.  The table
+// is built by the first lookup after a registration.
+class ExtendeeExtensions {
+ public:
+  bool Add(const ExtensionInfo& info) {
+    if (!by_number_.try_emplace(info.number, info).second) return false;
+    indexed_.store(false, std::memory_order_relaxed);
+    return true;
   }
-};
 
-struct ExtensionHasher {
-  std::size_t operator()(const ExtensionInfo& info) const {
-    return absl::HashOf(info.message, info.number);
+  const ExtensionInfo* Find(int number) const {
+    if (!indexed_.load(std::memory_order_acquire)) BuildIndex();
+    if (!dense_.empty()) {
+      const uint32_t index =
+          static_cast<uint32_t>(number) - static_cast<uint32_t>(min_number_);
+      return index < dense_.size() ? dense_[index] : nullptr;
+    }
+    auto it = by_number_.find(number);
+    return it == by_number_.end() ? nullptr : &it->second;
+  }
+
+ private:
+  void BuildIndex() const {
+    absl::MutexLock lock(&mutex_);
+    if (indexed_.load(std::memory_order_relaxed)) return;
+    int min_number = std::numeric_limits<int>::max();
+    int max_number = 0;
+    for (const auto& entry : by_number_) {
+      min_number = std::min(min_number, entry.first);
+      max_number = std::max(max_number, entry.first);
+    }
+    // Sparse numbers would make the table mostly holes; hash those instead.
+    const size_t span = static_cast<size_t>(max_number - min_number) + 1;
+    dense_.clear();
+    if (span <= 2 * by_number_.size() + 16) {
+      dense_.resize(span, nullptr);
+      for (const auto& entry : by_number_) {
+        dense_[entry.first - min_number] = &entry.second;
+      }
+      min_number_ = min_number;
+    }
+    indexed_.store(true, std::memory_order_release);
   }
+
+  absl::flat_hash_map<int, ExtensionInfo> by_number_;
+  mutable absl::Mutex mutex_;
+  mutable std::atomic<bool> indexed_{false};
+  mutable int min_number_ = 0;
+  // If not empty, dense_[number - min_number_] points into by_number_.
+  mutable std::vector<const ExtensionInfo*> dense_;
 };
 
 using ExtensionRegistry =
-    absl::flat_hash_set<ExtensionInfo, ExtensionHasher, ExtensionEq>;
+    absl::flat_hash_map<const MessageLite*,
+                        std::unique_ptr<ExtendeeExtensions>>;
 
 static const ExtensionRegistry* global_registry = nullptr;
 
@@ -92,7 +141,12 @@ static const ExtensionRegistry* global_registry = nullptr;
 void Register(const ExtensionInfo& info) {
   static auto local_static_registry = OnShutdownDelete(new ExtensionRegistry);
   global_registry = local_static_registry;
-  if (!local_static_registry->insert(info).second) {
+  std::unique_ptr<ExtendeeExtensions>& extensions =
+      (*local_static_registry)[info.message];
+  if (extensions == nullptr) {
+    extensions = std::make_unique<ExtendeeExtensions>();
+  }
+  if (!extensions->Add(info)) {
     ABSL_LOG(FATAL) << "Multiple extension registrations for type \""
                     << info.message->GetTypeName() << "\", field number "
                     << info.number << ".";
@@ -103,16 +157,9 @@ const ExtensionInfo* FindRegisteredExtension(const MessageLite* extendee,
                                              int number) {
   if (!global_registry) return nullptr;
 
-  ExtensionInfo info;
-  info.message = extendee;
-  info.number = number;
-
-  auto it = global_registry->find(info);
-  if (it == global_registry->end()) {
-    return nullptr;
-  } else {
-    return &*it;
-  }
+  auto it = global_registry->find(extendee);
+  if (it == global_registry->end()) return nullptr;
+  return it->second->Find(number);
 }
 
 }  // namespace
@@ -168,12 +215,15 @@ void ExtensionSet::RegisterMessageExtension(const MessageLite* extendee,
                                             int number, FieldType type,
                                             bool is_repeated, bool is_packed,
                                             const MessageLite* prototype,
-                                            LazyEagerVerifyFnType verify_func) {
+                                            LazyEagerVerifyFnType verify_func,
+                                            bool is_lazy) {
   ABSL_CHECK(type == WireFormatLite::TYPE_MESSAGE ||
              type == WireFormatLite::TYPE_GROUP);
   ExtensionInfo info(extendee, number, type, is_repeated, is_packed,
                      verify_func);
   info.message_info = {prototype};
+  info.is_lazy =
+      is_lazy && !is_repeated && type == WireFormatLite::TYPE_MESSAGE;
   Register(info);
 }
 
@@ -1270,8 +1320,7 @@ uint8_t* ExtensionSet::_InternalSerializeImpl(
     return target;
   }
   const KeyValue* end = flat_end();
-  for (const KeyValue* it = std::lower_bound(
-           flat_begin(), end, start_field_number, KeyValue::FirstComparator());
+  for (const KeyValue* it = FlatLowerBound(start_field_number);
        it != end && it->first < end_field_number; ++it) {
     target = it->second.InternalSerializeFieldWithCachedSizesToArray(
         extendee, this, it->first, target, stream);
@@ -1596,18 +1645,249 @@ bool ExtensionSet::Extension::IsInitialized(const ExtensionSet* ext_set,
 // Dummy key method to avoid weak vtable.
 void ExtensionSet::LazyMessageExtension::UnusedKeyMethod() {}
 
+// The extension is in one of two states:
+//  - Not parsed: message_ is null and bytes_ holds the serialized message
+//    (possibly several concatenated, which parse as their merge).
+//  - Parsed: message_ holds the message.  bytes_ still holds its serialized
+//    form while bytes_current_ is true, i.e. until the first non-const access,
+//    so that an extension that is only read serializes without re-encoding.
+// Const accessors may run concurrently, so the first GetMessage() publishes
+// the parsed message with a compare-and-swap; if two threads race, one of
+// them parses the bytes for nothing.  bytes_ and bytes_current_ only change
+// in non-const methods.
+class ExtensionSet::LazyExtension final
+    : public ExtensionSet::LazyMessageExtension {
+ public:
+  LazyExtension() = default;
+  ~LazyExtension() override { DeleteMessage(); }
+
+  LazyMessageExtension* New(Arena* arena) const override {
+    return Arena::Create<LazyExtension>(arena);
+  }
+
+  const MessageLite& GetMessage(const MessageLite& prototype,
+                                Arena* arena) const override {
+    const MessageLite* message = message_.load(std::memory_order_acquire);
+    if (PROTOBUF_PREDICT_TRUE(message != nullptr)) return *message;
+    if (bytes_.empty()) return prototype;
+    return *Materialize(prototype, arena);
+  }
+
+  MessageLite* MutableMessage(const MessageLite& prototype,
+                              Arena* arena) override {
+    MessageLite* message = message_.load(std::memory_order_relaxed);
+    if (message == nullptr) message = Materialize(prototype, arena);
+    DropBytes();
+    return message;
+  }
+
+  void SetAllocatedMessage(MessageLite* message, Arena* arena) override {
+    Arena* message_arena = message->GetOwningArena();
+    if (message_arena == arena) {
+      UnsafeArenaSetAllocatedMessage(message, arena);
+    } else if (message_arena == nullptr) {
+      arena->Own(message);  // not nullptr because not equal to message_arena
+      UnsafeArenaSetAllocatedMessage(message, arena);
+    } else {
+      MessageLite* copy = message->New(arena);
+      copy->CheckTypeAndMergeFrom(*message);
+      UnsafeArenaSetAllocatedMessage(copy, arena);
+    }
+  }
+
+  void UnsafeArenaSetAllocatedMessage(MessageLite* message,
+                                      Arena* arena) override {
+    DeleteMessage();
+    message_.store(message, std::memory_order_relaxed);
+    DropBytes();
+  }
+
+  PROTOBUF_NODISCARD MessageLite* ReleaseMessage(const MessageLite& prototype,
+                                                 Arena* arena) override {
+    MessageLite* message = UnsafeArenaReleaseMessage(prototype, arena);
+    if (arena == nullptr) return message;
+    // ReleaseMessage() always returns a heap-allocated message.
+    MessageLite* copy = message->New();
+    copy->CheckTypeAndMergeFrom(*message);
+    return copy;
+  }
+
+  MessageLite* UnsafeArenaReleaseMessage(const MessageLite& prototype,
+                                         Arena* arena) override {
+    MessageLite* message = MutableMessage(prototype, arena);
+    message_.store(nullptr, std::memory_order_relaxed);
+    bytes_current_ = true;  // Empty bytes for an absent message.
+    return message;
+  }
+
+  // Like unverified lazy fields, bytes that were never parsed are not checked
+  // for missing required fields.
+  bool IsInitialized(const MessageLite* prototype,
+                     Arena* arena) const override {
+    const MessageLite* message = message_.load(std::memory_order_acquire);
+    return message == nullptr || message->IsInitialized();
+  }
+
+  bool IsEagerSerializeSafe(const MessageLite* prototype,
+                            Arena* arena) const override {
+    return true;
+  }
+
+  size_t ByteSizeLong() const override {
+    if (bytes_current_) return bytes_.size();
+    return message_.load(std::memory_order_relaxed)->ByteSizeLong();
+  }
+
+  size_t SpaceUsedLong() const override {
+    size_t total = sizeof(*this) + StringSpaceUsedExcludingSelfLong(bytes_);
+    const MessageLite* message = message_.load(std::memory_order_acquire);
+    // A MessageLite can't report the memory it uses, so estimate it from the
+    // size of its encoding.
+    if (message != nullptr) total += message->ByteSizeLong();
+    return total;
+  }
+
+  void MergeFrom(const MessageLite* prototype,
+                 const LazyMessageExtension& other, Arena* arena) override {
+    const auto& other_lazy = static_cast<const LazyExtension&>(other);
+    if (bytes_current_ && message_.load(std::memory_order_relaxed) == nullptr &&
+        other_lazy.bytes_current_) {
+      // Concatenated messages parse as their merge, so this stays lazy.
+      bytes_.append(other_lazy.bytes_);
+      return;
+    }
+    MutableMessage(*prototype, arena)
+        ->CheckTypeAndMergeFrom(other_lazy.GetMessage(*prototype, arena));
+  }
+
+  void MergeFromMessage(const MessageLite& msg, Arena* arena) override {
+    MutableMessage(msg, arena)->CheckTypeAndMergeFrom(msg);
+  }
+
+  void Clear() override {
+    MessageLite* message = message_.load(std::memory_order_relaxed);
+    if (message != nullptr) message->Clear();
+    bytes_.clear();
+    bytes_current_ = true;
+  }
+
+  const char* _InternalParse(const MessageLite& prototype, Arena* arena,
+                             LazyVerifyOption option, const char* ptr,
+                             ParseContext* ctx) override {
+    if (!bytes_current_) {
+      // Already parsed and modified: merge the new bytes into the message.
+      return ctx->ParseMessage(message_.load(std::memory_order_relaxed), ptr);
+    }
+    DeleteMessage();
+    message_.store(nullptr, std::memory_order_relaxed);
+    int size = ReadSize(&ptr);
+    GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
+    return ctx->AppendString(ptr, size, &bytes_);
+  }
+
+  uint8_t* WriteMessageToArray(const MessageLite* prototype, int number,
+                               uint8_t* target,
+                               io::EpsCopyOutputStream* stream) const override {
+    if (bytes_current_) return stream->WriteString(number, bytes_, target);
+    const MessageLite* message = message_.load(std::memory_order_relaxed);
+    return WireFormatLite::InternalWriteMessage(
+        number, *message, message->GetCachedSize(), target, stream);
+  }
+
+ private:
+  // Parses bytes_ and publishes the result, or returns the message another
+  // thread published first.
+  MessageLite* Materialize(const MessageLite& prototype, Arena* arena) const {
+    MessageLite* parsed = prototype.New(arena);
+    // Bytes that fail to parse leave what was parsed before the error, as
+    // with unverified lazy fields.
+    (void)parsed->ParsePartialFromString(bytes_);
+    MessageLite* expected = nullptr;
+    if (message_.compare_exchange_strong(expected, parsed,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire)) {
+      return parsed;
+    }
+    if (arena == nullptr) delete parsed;
+    return expected;
+  }
+
+  void DropBytes() {
+    std::string().swap(bytes_);
+    bytes_current_ = false;
+  }
+
+  void DeleteMessage() {
+    MessageLite* message = message_.load(std::memory_order_relaxed);
+    if (message != nullptr && message->GetOwningArena() == nullptr) {
+      delete message;
+    }
+  }
+
+  std::string bytes_;
+  bool bytes_current_ = true;
+  mutable std::atomic<MessageLite*> message_{nullptr};
+};
+
+ExtensionSet::LazyMessageExtension* MaybeCreateLazyExtension(Arena* arena) {
+  return Arena::Create<ExtensionSet::LazyExtension>(arena);
+}
+
+const char* ExtensionSet::ParseLazyMessage(int number,
+                                           const ExtensionInfo& extension,
+                                           const char* ptr,
+                                           internal::ParseContext* ctx) {
+  Extension* ext;
+  if (MaybeNewExtension(number, extension.descriptor, &ext)) {
+    ext->type = WireFormatLite::TYPE_MESSAGE;
+    ext->is_repeated = false;
+    ext->is_packed = false;
+    ext->lazymessage_value = MaybeCreateLazyExtension(arena_);
+    ext->is_lazy = ext->lazymessage_value != nullptr;
+    if (!ext->is_lazy) {
+      ext->message_value = extension.message_info.prototype->New(arena_);
+    }
+  } else {
+    ABSL_DCHECK(!ext->is_repeated);
+    ABSL_DCHECK_EQ(cpp_type(ext->type), WireFormatLite::CPPTYPE_MESSAGE);
+  }
+  ext->is_cleared = false;
+  if (!ext->is_lazy) return ctx->ParseMessage(ext->message_value, ptr);
+  return ext->lazymessage_value->_InternalParse(
+      *extension.message_info.prototype, arena_, LazyVerifyOption::kLazy, ptr,
+      ctx);
+}
+
 const ExtensionSet::Extension* ExtensionSet::FindOrNull(int key) const {
   if (flat_size_ == 0) {
     return nullptr;
   } else if (PROTOBUF_PREDICT_TRUE(!is_large())) {
-    auto it = std::lower_bound(flat_begin(), flat_end() - 1, key,
-                               KeyValue::FirstComparator());
-    return it->first == key ? &it->second : nullptr;
+    const KeyValue* it = FlatLowerBound(key);
+    return it != flat_end() && it->first == key ? &it->second : nullptr;
   } else {
     return FindOrNullInLargeMap(key);
   }
 }
 
+const ExtensionSet::KeyValue* ExtensionSet::FlatLowerBound(int key) const {
+  const KeyValue* begin = flat_begin();
+  const KeyValue* end = flat_end();
+  if (begin == end || key <= begin->first) return begin;
+  const int last = end[-1].first;
+  if (key > last) return end;
+  // The keys are distinct and sorted, so the i-th key is at least
+  // begin->first + i and at most last - (size - 1 - i).  This bounds where
+  // `key` can be found; when the extension numbers in use are dense, as they
+  // usually are in messages with many extensions, it pins it down exactly.
+  const size_t size = static_cast<size_t>(end - begin);
+  const size_t hi = std::min(
+      size - 1, static_cast<size_t>(static_cast<int64_t>(key) - begin->first));
+  const size_t below = static_cast<size_t>(static_cast<int64_t>(last) - key);
+  const size_t lo = size - 1 > below ? size - 1 - below : 0;
+  return std::lower_bound(begin + lo, begin + hi, key,
+                          KeyValue::FirstComparator());
+}
+
 const ExtensionSet::Extension* ExtensionSet::FindOrNullInLargeMap(
     int key) const {
   assert(is_large());
@@ -1635,8 +1915,9 @@ std::pair<ExtensionSet::Extension*, bool> ExtensionSet::Insert(int key) {
     return {&maybe.first->second, maybe.second};
   }
   KeyValue* end = flat_end();
-  KeyValue* it =
-      std::lower_bound(flat_begin(), end, key, KeyValue::FirstComparator());
+  // Extensions are usually parsed in increasing number order, which makes
+  // this an append.
+  KeyValue* it = const_cast<KeyValue*>(FlatLowerBound(key));
   if (it != end && it->first == key) {
     return {&it->second, false};
   }
@@ -1700,8 +1981,7 @@ void ExtensionSet::Erase(int key) {
     return;
   }
   KeyValue* end = flat_end();
-  KeyValue* it =
-      std::lower_bound(flat_begin(), end, key, KeyValue::FirstComparator());
+  KeyValue* it = const_cast<KeyValue*>(FlatLowerBound(key));
   if (it != end && it->first == key) {
     std::copy(it + 1, end, it);
     --flat_size_;
@@ -1727,12 +2007,19 @@ uint8_t* ExtensionSet::Extension::InternalSerializeFieldWithCachedSizesToArray(
     uint8_t* target, io::EpsCopyOutputStream* stream) const {
   if (is_repeated) {
     if (is_packed) {
-      if (cached_size == 0) return target;
+      uint8_t* payload = nullptr;
+      if (PROTOBUF_PREDICT_FALSE(stream->BackpatchesLengths())) {
+        if (GetSize() == 0) return target;
+        payload = stream->BeginBackpatchedLengthDelim(number, target);
+        target = payload;
+      } else {
+        if (cached_size == 0) return target;
 
-      target = stream->EnsureSpace(target);
-      target = WireFormatLite::WriteTagToArray(
-          number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
-      target = WireFormatLite::WriteInt32NoTagToArray(cached_size, target);
+        target = stream->EnsureSpace(target);
+        target = WireFormatLite::WriteTagToArray(
+            number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
+        target = WireFormatLite::WriteInt32NoTagToArray(cached_size, target);
+      }
 
       switch (real_type(type)) {
 #define HANDLE_TYPE(UPPERCASE, CAMELCASE, LOWERCASE)                 \
@@ -1767,6 +2054,9 @@ uint8_t* ExtensionSet::Extension::InternalSerializeFieldWithCachedSizesToArray(
           ABSL_LOG(FATAL) << "Non-primitive types can't be packed.";
           break;
       }
+      if (payload != nullptr) {
+        target = stream->EndBackpatchedLengthDelim(payload, target);
+      }
     } else {
       switch (real_type(type)) {
 #define HANDLE_TYPE(UPPERCASE, CAMELCASE, LOWERCASE)                 \
@@ -103,6 +103,13 @@ typedef bool EnumValidityFunc(int number);
 // extensions that are not compiled in.
 typedef bool EnumValidityFuncWithArg(const void* arg, int number);
 
+// How the bytes of a lazily parsed message are checked: when they are read
+// off the wire (kEager), or only when the message is first accessed (kLazy).
+enum class LazyVerifyOption {
+  kLazy,
+  kEager,
+};
+
 // Information about a registered extension.
 struct ExtensionInfo {
   constexpr ExtensionInfo() : enum_validity_check() {}
@@ -123,6 +130,9 @@ struct ExtensionInfo {
   FieldType type = 0;
   bool is_repeated = false;
   bool is_packed = false;
+  // For singular message extensions: keep the bytes of the message when
+  // parsing, and only parse them when the extension is first accessed.
+  bool is_lazy = false;
 
   struct EnumValidityCheck {
     EnumValidityFuncWithArg* func;
@@ -207,7 +217,8 @@ class PROTOBUF_EXPORT ExtensionSet {
                                        FieldType type, bool is_repeated,
                                        bool is_packed,
                                        const MessageLite* prototype,
-                                       LazyEagerVerifyFnType verify_func);
+                                       LazyEagerVerifyFnType verify_func,
+                                       bool is_lazy = false);
 
   // =================================================================
 
@@ -588,6 +599,10 @@ class PROTOBUF_EXPORT ExtensionSet {
    private:
     virtual void UnusedKeyMethod();  // Dummy key method to avoid weak vtable.
   };
+  // The LazyMessageExtension used for extensions registered as lazy.  It
+  // holds the extension's bytes until the message is first accessed, and can
+  // then be parsed by concurrent readers.
+  class LazyExtension;
   // Give access to function defined below to see LazyMessageExtension.
   friend LazyMessageExtension* MaybeCreateLazyExtension(Arena* arena);
   struct Extension {
@@ -697,6 +712,10 @@ class PROTOBUF_EXPORT ExtensionSet {
   const Extension* FindOrNull(int key) const;
   Extension* FindOrNull(int key);
 
+  // Returns the first entry of the flat map whose key is not less than `key`.
+  // Requires !is_large().
+  const KeyValue* FlatLowerBound(int key) const;
+
   // Helper-functions that only inspect the LargeMap.
   const Extension* FindOrNullInLargeMap(int key) const;
   Extension* FindOrNullInLargeMap(int key);
@@ -826,6 +845,11 @@ class PROTOBUF_EXPORT ExtensionSet {
   // Returns true if extension is present and lazy.
   bool HasLazy(int number) const;
 
+  // Parses a singular message extension registered as lazy, keeping its
+  // bytes for later unless the extension is already present and parsed.
+  const char* ParseLazyMessage(int number, const ExtensionInfo& extension,
+                               const char* ptr, internal::ParseContext* ctx);
+
   // Gets the extension with the given number, creating it if it does not
   // already exist.  Returns true if the extension did not already exist.
   bool MaybeNewExtension(int number, const FieldDescriptor* descriptor,
@@ -1402,6 +1426,13 @@ class MessageTypeTraits {
                                            number, type, false, is_packed,
                                            &Type::default_instance(), fn);
   }
+  template <typename ExtendeeT>
+  static void Register(int number, FieldType type, bool is_packed,
+                       LazyEagerVerifyFnType fn, bool is_lazy) {
+    ExtensionSet::RegisterMessageExtension(
+        &ExtendeeT::default_instance(), number, type, false, is_packed,
+        &Type::default_instance(), fn, is_lazy);
+  }
 };
 
 // Used by WireFormatVerify to extract the verify function from the registry.
@@ -1508,6 +1539,13 @@ class ExtensionIdentifier {
       : number_(number), default_value_(default_value) {
     Register(number, verify_func);
   }
+  // For singular message extensions declared with [unverified_lazy = true].
+  ExtensionIdentifier(int number, typename TypeTraits::ConstType default_value,
+                      LazyEagerVerifyFnType verify_func, bool is_lazy)
+      : number_(number), default_value_(default_value) {
+    TypeTraits::template Register<ExtendeeType>(number, field_type, is_packed,
+                                                verify_func, is_lazy);
+  }
   inline int number() const { return number_; }
   typename TypeTraits::ConstType default_value() const {
     return default_value_;
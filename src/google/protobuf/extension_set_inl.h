@@ -186,6 +186,9 @@ const char* ExtensionSet::ParseFieldWithExtensionInfo(
       }
 
       case WireFormatLite::TYPE_MESSAGE: {
+        if (extension.is_lazy) {
+          return ParseLazyMessage(number, extension, ptr, ctx);
+        }
         MessageLite* value =
             extension.is_repeated
                 ? AddMessage(number, WireFormatLite::TYPE_MESSAGE,
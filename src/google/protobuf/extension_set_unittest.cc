@@ -34,6 +34,11 @@
 
 #include "google/protobuf/extension_set.h"
 
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/arena.h"
 #include "google/protobuf/descriptor.h"
@@ -42,6 +47,7 @@
 #include "google/protobuf/testing/googletest.h"
 #include <gtest/gtest.h>
 #include "absl/base/casts.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/match.h"
 #include "google/protobuf/io/coded_stream.h"
@@ -1413,6 +1419,175 @@ TEST(ExtensionSetTest, BoolExtension) {
   EXPECT_TRUE(msg.GetExtension(protobuf_unittest::optional_bool_extension));
 }
 
+TEST(ExtensionSetTest, LookupWithDenseAndSparseNumbers) {
+  // Extensions 100-199 are dense; the others are spread out around them and
+  // inserted out of order.
+  std::vector<int> numbers;
+  for (int i = 100; i < 200; ++i) numbers.push_back(i);
+  for (int i = 1; i < 20; ++i) numbers.push_back(i * i * 7 % 1000 + 200);
+  for (int i = 1; i < 10; ++i) numbers.push_back(i * 9);
+  ExtensionSet set;
+  absl::flat_hash_set<int> present;
+  for (int number : numbers) {
+    set.SetInt32(number, WireFormatLite::TYPE_INT32, number * 2, nullptr);
+    present.insert(number);
+  }
+  EXPECT_EQ(set.NumExtensions(), static_cast<int>(present.size()));
+  for (int number = 0; number < 1300; ++number) {
+    EXPECT_EQ(set.Has(number), present.contains(number)) << number;
+    EXPECT_EQ(set.GetInt32(number, -1),
+              present.contains(number) ? number * 2 : -1)
+        << number;
+  }
+}
+
+TEST(ExtensionSetTest, ParseFindsRegisteredExtensions) {
+  // TestAllExtensions has dense extension numbers, TestFieldOrderings sparse
+  // ones and TestHugeFieldNumbers a single one near the maximum.
+  unittest::TestAllExtensions dense;
+  TestUtil::SetAllExtensions(&dense);
+  unittest::TestAllExtensions dense_parsed;
+  ASSERT_TRUE(dense_parsed.ParseFromString(dense.SerializeAsString()));
+  TestUtil::ExpectAllExtensionsSet(dense_parsed);
+  EXPECT_EQ(dense_parsed.unknown_fields().field_count(), 0);
+
+  unittest::TestFieldOrderings sparse;
+  sparse.SetExtension(unittest::my_extension_int, 5);
+  sparse.SetExtension(unittest::my_extension_string, "fifty");
+  sparse
+      .MutableExtension(unittest::TestExtensionOrderings2::test_ext_orderings2)
+      ->set_my_string("twelve");
+  unittest::TestFieldOrderings sparse_parsed;
+  ASSERT_TRUE(sparse_parsed.ParseFromString(sparse.SerializeAsString()));
+  EXPECT_EQ(sparse_parsed.GetExtension(unittest::my_extension_int), 5);
+  EXPECT_EQ(sparse_parsed.GetExtension(unittest::my_extension_string),
+            "fifty");
+  EXPECT_EQ(sparse_parsed
+                .GetExtension(
+                    unittest::TestExtensionOrderings2::test_ext_orderings2)
+                .my_string(),
+            "twelve");
+  EXPECT_EQ(sparse_parsed.unknown_fields().field_count(), 0);
+
+  unittest::TestHugeFieldNumbers huge;
+  huge.MutableExtension(unittest::test_all_types)->set_optional_int32(7);
+  unittest::TestHugeFieldNumbers huge_parsed;
+  ASSERT_TRUE(huge_parsed.ParseFromString(huge.SerializeAsString()));
+  EXPECT_EQ(
+      huge_parsed.GetExtension(unittest::test_all_types).optional_int32(), 7);
+
+  // Numbers in the extension ranges with nothing registered, between and
+  // beyond the registered ones, stay unknown fields.
+  std::string unregistered;
+  {
+    io::StringOutputStream output(&unregistered);
+    io::CodedOutputStream coded(&output);
+    for (int number : {6, 49, 51, 99}) {
+      WireFormatLite::WriteInt32(number, number, &coded);
+    }
+  }
+  unittest::TestFieldOrderings unknown_parsed;
+  ASSERT_TRUE(unknown_parsed.ParseFromString(unregistered));
+  EXPECT_EQ(unknown_parsed.unknown_fields().field_count(), 4);
+  EXPECT_FALSE(unknown_parsed.HasExtension(unittest::my_extension_int));
+}
+
+// Extension 28 of TestAllExtensions, holding a NestedMessage whose bb field
+// is set twice.  Parsing it keeps the last value, so the bytes only survive a
+// round trip if they were never parsed.
+std::string UnverifiedLazyExtensionBytes() {
+  return std::string("\xe2\x01\x04\x08\x01\x08\x02", 7);
+}
+
+TEST(ExtensionSetTest, UnverifiedLazyMessageExtension) {
+  unittest::TestAllExtensions message;
+  ASSERT_TRUE(message.ParseFromString(UnverifiedLazyExtensionBytes()));
+  EXPECT_TRUE(message.HasExtension(
+      unittest::optional_unverified_lazy_message_extension));
+  EXPECT_EQ(UnverifiedLazyExtensionBytes(), message.SerializeAsString());
+
+  // Reading the extension parses it but keeps the original bytes.
+  EXPECT_EQ(2, message
+                   .GetExtension(
+                       unittest::optional_unverified_lazy_message_extension)
+                   .bb());
+  EXPECT_EQ(UnverifiedLazyExtensionBytes(), message.SerializeAsString());
+
+  // Modifying it reserializes the message.
+  message.MutableExtension(unittest::optional_unverified_lazy_message_extension)
+      ->set_bb(3);
+  EXPECT_EQ(std::string("\xe2\x01\x02\x08\x03", 5),
+            message.SerializeAsString());
+
+  message.Clear();
+  EXPECT_FALSE(message.HasExtension(
+      unittest::optional_unverified_lazy_message_extension));
+  ASSERT_TRUE(message.ParseFromString(UnverifiedLazyExtensionBytes()));
+  EXPECT_EQ(UnverifiedLazyExtensionBytes(), message.SerializeAsString());
+}
+
+TEST(ExtensionSetTest, UnverifiedLazyMessageExtensionConcurrentReads) {
+  for (int round = 0; round < 20; ++round) {
+    unittest::TestAllExtensions message;
+    ASSERT_TRUE(message.ParseFromString(UnverifiedLazyExtensionBytes()));
+    const unittest::TestAllExtensions& const_message = message;
+
+    std::vector<const unittest::TestAllTypes::NestedMessage*> seen(4);
+    std::vector<std::thread> threads;
+    for (auto& result : seen) {
+      threads.emplace_back([&const_message, &result] {
+        result = &const_message.GetExtension(
+            unittest::optional_unverified_lazy_message_extension);
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    for (const auto* result : seen) {
+      EXPECT_EQ(seen[0], result);
+      EXPECT_EQ(2, result->bb());
+    }
+  }
+}
+
+TEST(ExtensionSetTest, UnverifiedLazyMessageExtensionMergeAndRelease) {
+  unittest::TestAllExtensions source;
+  ASSERT_TRUE(source.ParseFromString(UnverifiedLazyExtensionBytes()));
+
+  // Merging two unparsed extensions concatenates their bytes.
+  unittest::TestAllExtensions merged;
+  ASSERT_TRUE(merged.ParseFromString(UnverifiedLazyExtensionBytes()));
+  merged.MergeFrom(source);
+  EXPECT_EQ(2, merged
+                   .GetExtension(
+                       unittest::optional_unverified_lazy_message_extension)
+                   .bb());
+
+  unittest::TestAllExtensions modified;
+  modified.MutableExtension(unittest::optional_unverified_lazy_message_extension)
+      ->set_bb(5);
+  modified.MergeFrom(source);
+  EXPECT_EQ(2, modified
+                   .GetExtension(
+                       unittest::optional_unverified_lazy_message_extension)
+                   .bb());
+
+  Arena arena;
+  auto* on_arena = Arena::CreateMessage<unittest::TestAllExtensions>(&arena);
+  ASSERT_TRUE(on_arena->ParseFromString(UnverifiedLazyExtensionBytes()));
+  EXPECT_EQ(UnverifiedLazyExtensionBytes(), on_arena->SerializeAsString());
+  std::unique_ptr<unittest::TestAllTypes::NestedMessage> released(
+      on_arena->ReleaseExtension(
+          unittest::optional_unverified_lazy_message_extension));
+  EXPECT_EQ(2, released->bb());
+  EXPECT_FALSE(on_arena->HasExtension(
+      unittest::optional_unverified_lazy_message_extension));
+
+  on_arena->SetAllocatedExtension(
+      unittest::optional_unverified_lazy_message_extension,
+      released.release());
+  EXPECT_EQ(std::string("\xe2\x01\x02\x08\x02", 5),
+            on_arena->SerializeAsString());
+}
+
 TEST(ExtensionSetTest, ConstInit) {
   PROTOBUF_CONSTINIT static ExtensionSet set{};
   EXPECT_EQ(set.NumExtensions(), 0);
@@ -162,7 +162,15 @@ struct NoOpAccessListener {
 }  // namespace protobuf
 }  // namespace google
 
-#ifndef REPLACE_PROTO_LISTENER_IMPL
+#if defined(PROTOBUF_FIELD_ACCESS_SAMPLER)
+#include "google/protobuf/field_access_sampler.h"
+namespace google {
+namespace protobuf {
+template <class T>
+using AccessListener = FieldAccessSampler<T>;
+}  // namespace protobuf
+}  // namespace google
+#elif !defined(REPLACE_PROTO_LISTENER_IMPL)
 namespace google {
 namespace protobuf {
 template <class T>
@@ -173,6 +181,6 @@ using AccessListener = NoOpAccessListener<T>;
 // You can put your implementations of hooks/listeners here.
 // All hooks are subject to approval by protobuf-team@.
 
-#endif  // !REPLACE_PROTO_LISTENER_IMPL
+#endif  // PROTOBUF_FIELD_ACCESS_SAMPLER
 
 #endif  // GOOGLE_PROTOBUF_FIELD_ACCESS_LISTENER_H__
@@ -0,0 +1,133 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/field_access_sampler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+PROTOBUF_CONSTINIT std::atomic<FieldAccessCounts*> g_registered{nullptr};
+
+// The state of a xorshift generator, which picks the sampled accesses at
+// random so that a fixed access pattern cannot alias with the period.
+PROTOBUF_THREAD_LOCAL uint32_t g_sample_state = 0;
+
+}  // namespace
+
+FieldAccessCounts::FieldAccessCounts(absl::string_view (*name_extractor)(),
+                                     int field_count)
+    : name_extractor_(name_extractor),
+      field_count_(field_count),
+      counts_(new std::atomic<uint64_t>[field_count]()),
+      next_(g_registered.load(std::memory_order_relaxed)) {
+  while (!g_registered.compare_exchange_weak(next_, this,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+  }
+}
+
+void FieldAccessCounts::Record(int field_index) {
+  uint32_t state = g_sample_state;
+  if (state == 0) {
+    state = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&state)) | 1;
+  }
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  g_sample_state = state;
+  if (state % kSamplePeriod != 0) return;
+  if (field_index < 0 || field_index >= field_count_) return;
+  counts_[field_index].fetch_add(1, std::memory_order_relaxed);
+}
+
+const FieldAccessCounts* FieldAccessCounts::registered() {
+  return g_registered.load(std::memory_order_acquire);
+}
+
+}  // namespace internal
+
+std::string GetFieldAccessProfile() {
+  std::vector<std::string> lines;
+  for (const internal::FieldAccessCounts* counts =
+           internal::FieldAccessCounts::registered();
+       counts != nullptr; counts = counts->next()) {
+    const Descriptor* descriptor =
+        DescriptorPool::generated_pool()->FindMessageTypeByName(
+            std::string(counts->name()));
+    if (descriptor == nullptr) continue;
+    int field_count = std::min(counts->field_count(), descriptor->field_count());
+    uint64_t max_count = 0;
+    for (int i = 0; i < field_count; ++i) {
+      max_count = std::max(max_count, counts->count(i));
+    }
+    if (max_count == 0) continue;
+    for (int i = 0; i < field_count; ++i) {
+      lines.push_back(absl::StrCat(
+          descriptor->field(i)->full_name(), " ",
+          static_cast<double>(counts->count(i)) / max_count));
+    }
+  }
+  std::sort(lines.begin(), lines.end());
+
+  std::string profile;
+  for (const std::string& line : lines) {
+    absl::StrAppend(&profile, line, "\n");
+  }
+  return profile;
+}
+
+bool WriteFieldAccessProfile(const std::string& path) {
+  std::ofstream output(path, std::ios::trunc);
+  output << GetFieldAccessProfile();
+  output.close();
+  return !output.fail();
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
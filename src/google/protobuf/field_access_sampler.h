@@ -0,0 +1,185 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// FieldAccessSampler is an AccessListener (see field_access_listener.h) that
+// samples which fields of each message type a program accesses.  The samples
+// are written out as a field access profile, which protoc's C++ generator
+// uses to lay out the messages:
+//
+//   protoc --cpp_out=field_access_profile=profile.txt:out foo.proto
+//
+// Rarely accessed fields are then moved out of line, into the split struct
+// of their message, and the most accessed strings are stored inline.
+//
+// To collect a profile:
+//   1. Generate the messages with --cpp_out=inject_field_listener_events:out.
+//   2. Build them, and everything that includes them, with
+//      PROTOBUF_FIELD_ACCESS_SAMPLER defined.
+//   3. Run a representative workload and call WriteFieldAccessProfile()
+//      before the program exits.
+
+#ifndef GOOGLE_PROTOBUF_FIELD_ACCESS_SAMPLER_H__
+#define GOOGLE_PROTOBUF_FIELD_ACCESS_SAMPLER_H__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/field_access_listener.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// The sampled access counts of the fields of one message type.
+class PROTOBUF_EXPORT FieldAccessCounts {
+ public:
+  // Registers the counts for a message type with `field_count` fields, whose
+  // full name `name_extractor` returns.  The counts are never unregistered, so
+  // they must live until the program exits.
+  FieldAccessCounts(absl::string_view (*name_extractor)(), int field_count);
+  FieldAccessCounts(const FieldAccessCounts&) = delete;
+  FieldAccessCounts& operator=(const FieldAccessCounts&) = delete;
+
+  // Counts an access to the field with the given index, for about one in
+  // kSamplePeriod calls.
+  void Record(int field_index);
+
+  static constexpr int kSamplePeriod = 16;
+
+  absl::string_view name() const { return name_extractor_(); }
+  int field_count() const { return field_count_; }
+  uint64_t count(int field_index) const {
+    return counts_[field_index].load(std::memory_order_relaxed);
+  }
+
+  // Returns the most recently registered counts.  The others follow through
+  // next().
+  static const FieldAccessCounts* registered();
+  const FieldAccessCounts* next() const { return next_; }
+
+ private:
+  absl::string_view (*name_extractor_)();
+  int field_count_;
+  std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+  FieldAccessCounts* next_;
+};
+
+}  // namespace internal
+
+template <typename Proto>
+struct FieldAccessSampler : NoOpAccessListener<Proto> {
+  explicit FieldAccessSampler(absl::string_view (*name_extractor)())
+      : NoOpAccessListener<Proto>(name_extractor) {
+    counts_ = new internal::FieldAccessCounts(
+        name_extractor, NoOpAccessListener<Proto>::kFields);
+  }
+
+  template <int kFieldNum>
+  static void OnAdd(const MessageLite* msg, const void* field) {
+    Record(kFieldNum);
+  }
+  template <int kFieldNum>
+  static void OnAddMutable(const MessageLite* msg, const void* field) {
+    Record(kFieldNum);
+  }
+  template <int kFieldNum>
+  static void OnGet(const MessageLite* msg, const void* field) {
+    Record(kFieldNum);
+  }
+  template <int kFieldNum>
+  static void OnClear(const MessageLite* msg, const void* field) {
+    Record(kFieldNum);
+  }
+  template <int kFieldNum>
+  static void OnHas(const MessageLite* msg, const void* field) {
+    Record(kFieldNum);
+  }
+  template <int kFieldNum>
+  static void OnList(const MessageLite* msg, const void* field) {
+    Record(kFieldNum);
+  }
+  template <int kFieldNum>
+  static void OnMutable(const MessageLite* msg, const void* field) {
+    Record(kFieldNum);
+  }
+  template <int kFieldNum>
+  static void OnMutableList(const MessageLite* msg, const void* field) {
+    Record(kFieldNum);
+  }
+  template <int kFieldNum>
+  static void OnRelease(const MessageLite* msg, const void* field) {
+    Record(kFieldNum);
+  }
+  template <int kFieldNum>
+  static void OnSet(const MessageLite* msg, const void* field) {
+    Record(kFieldNum);
+  }
+  template <int kFieldNum>
+  static void OnSize(const MessageLite* msg, const void* field) {
+    Record(kFieldNum);
+  }
+
+ private:
+  static void Record(int field_index) {
+    // Accessors can run before the listener is constructed, during static
+    // initialization.
+    if (counts_ != nullptr) counts_->Record(field_index);
+  }
+
+  static internal::FieldAccessCounts* counts_;
+};
+
+template <typename Proto>
+internal::FieldAccessCounts* FieldAccessSampler<Proto>::counts_ = nullptr;
+
+// Returns the field access profile of every message type sampled so far.  It
+// has one `<full field name> <share>` line per field, where the share is the
+// number of accesses to the field divided by the number of accesses to the most
+// accessed field of its message, from 0 to 1.  Message types that were not
+// accessed, or that are not in the generated pool, are left out.
+PROTOBUF_EXPORT std::string GetFieldAccessProfile();
+
+// Writes GetFieldAccessProfile() to the file at `path`.  Returns false if the
+// file could not be written.
+PROTOBUF_EXPORT bool WriteFieldAccessProfile(const std::string& path);
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_FIELD_ACCESS_SAMPLER_H__
@@ -0,0 +1,100 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/field_access_sampler.h"
+
+#include <string>
+#include <vector>
+
+#include "google/protobuf/testing/file.h"
+#include "google/protobuf/testing/googletest.h"
+#include <gtest/gtest.h>
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+// Stands in for a ForeignMessage generated with inject_field_listener_events.
+struct FakeForeignMessage {
+  static constexpr int _kInternalFieldNumber = 2;
+};
+
+absl::string_view ForeignMessageName() {
+  return "protobuf_unittest.ForeignMessage";
+}
+
+absl::flat_hash_map<std::string, double> ParseProfile(
+    absl::string_view profile) {
+  absl::flat_hash_map<std::string, double> result;
+  for (absl::string_view line : absl::StrSplit(profile, '\n')) {
+    if (line.empty()) continue;
+    std::vector<absl::string_view> parts = absl::StrSplit(line, ' ');
+    EXPECT_EQ(2, parts.size()) << line;
+    if (parts.size() != 2) continue;
+    EXPECT_TRUE(absl::SimpleAtod(parts[1], &result[std::string(parts[0])]))
+        << line;
+  }
+  return result;
+}
+
+TEST(FieldAccessSamplerTest, ProfilesAccessesRelativeToHottestField) {
+  // Makes sure that ForeignMessage is in the generated pool.
+  ASSERT_NE(nullptr, protobuf_unittest::ForeignMessage::descriptor());
+  using Sampler = FieldAccessSampler<FakeForeignMessage>;
+  static auto* sampler = new Sampler(&ForeignMessageName);
+  (void)sampler;
+
+  for (int i = 0; i < 100000; ++i) {
+    Sampler::OnGet<0>(nullptr, nullptr);
+    if (i % 4 == 0) Sampler::OnSet<1>(nullptr, nullptr);
+  }
+
+  std::string profile = GetFieldAccessProfile();
+  absl::flat_hash_map<std::string, double> shares = ParseProfile(profile);
+  ASSERT_EQ(2, shares.size()) << profile;
+  EXPECT_EQ(1, shares["protobuf_unittest.ForeignMessage.c"]);
+  EXPECT_NEAR(0.25, shares["protobuf_unittest.ForeignMessage.d"], 0.05);
+
+  std::string path = absl::StrCat(TestTempDir(), "/field_access_profile");
+  ASSERT_TRUE(WriteFieldAccessProfile(path));
+  std::string written;
+  ASSERT_TRUE(File::GetContents(path, &written, true).ok());
+  EXPECT_EQ(profile, written);
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
@@ -185,6 +185,8 @@ const ::_pbi::TcParseTable<0, 1, 0, 39, 2> FieldMask::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_FieldMask_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // repeated string paths = 1;
     {::_pbi::TcParser::FastUR1,
@@ -263,6 +265,20 @@ void FieldMask::MergeImpl(::google::protobuf::Message& to_msg, const ::google::p
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void FieldMask::MergeFrom(FieldMask&& from) {
+  FieldMask* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_paths()->MergeFrom(
+      std::move(*from._internal_mutable_paths()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const FieldMask&>(from));
+}
+
 void FieldMask::CopyFrom(const FieldMask& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.FieldMask)
   if (&from == this) return;
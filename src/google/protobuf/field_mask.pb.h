@@ -155,6 +155,11 @@ class PROTOBUF_EXPORT FieldMask final :
   FieldMask* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<FieldMask>(arena);
   }
+  FieldMask* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    FieldMask* copy = CreateMaybeMessage<FieldMask>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const FieldMask& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -164,6 +169,7 @@ class PROTOBUF_EXPORT FieldMask final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(FieldMask&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
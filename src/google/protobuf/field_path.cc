@@ -0,0 +1,314 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/field_path.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/generated_message_reflection.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/repeated_field.h"
+#include "google/protobuf/repeated_ptr_field.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+absl::StatusOr<FieldPath> FieldPath::Compile(const Message& prototype,
+                                             absl::string_view path) {
+  FieldPath result;
+  const Message* current = &prototype;
+  std::vector<absl::string_view> parts = absl::StrSplit(path, '.');
+  for (size_t i = 0; i < parts.size(); ++i) {
+    absl::string_view name = parts[i];
+    int index = -1;
+    size_t bracket = name.find('[');
+    if (bracket != absl::string_view::npos) {
+      absl::string_view index_text = name.substr(bracket + 1);
+      if (!absl::ConsumeSuffix(&index_text, "]") ||
+          !absl::SimpleAtoi(index_text, &index) || index < 0) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Invalid index in \"", name, "\" in field path \"", path, "\"."));
+      }
+      name = name.substr(0, bracket);
+    }
+
+    const Descriptor* descriptor = current->GetDescriptor();
+    const FieldDescriptor* field = descriptor->FindFieldByName(name);
+    if (field == nullptr) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("\"", descriptor->full_name(), "\" has no field named \"",
+                       name, "\"."));
+    }
+    if (field->is_map()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Map field \"", field->full_name(), "\" can't be part of a path."));
+    }
+    if (field->is_repeated() && index < 0) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Repeated field \"", field->full_name(), "\" needs an index."));
+    }
+    if (!field->is_repeated() && index >= 0) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Field \"", field->full_name(), "\" is not repeated."));
+    }
+
+    const Reflection* reflection = current->GetReflection();
+    Step step = MakeStep(reflection, field, index);
+    if (i + 1 == parts.size()) {
+      result.leaf_ = step;
+      result.leaf_prototype_ = current;
+      break;
+    }
+    if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Field \"", field->full_name(), "\" is not a message field."));
+    }
+    result.steps_.push_back(step);
+    current = reflection->GetDefaultMessageInstance(field);
+  }
+  return result;
+}
+
+FieldPath::Step FieldPath::MakeStep(const Reflection* reflection,
+                                    const FieldDescriptor* field, int index) {
+  const internal::ReflectionSchema& schema = reflection->schema_;
+  Step step;
+  step.kind = Step::kSingular;
+  step.split = false;
+  step.cpp_type = field->cpp_type();
+  step.offset = 0;
+  step.presence = 0;
+  step.has_bit = static_cast<uint32_t>(-1);
+  step.index = index;
+  step.reflection = reflection;
+  step.field = field;
+
+  if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+      (field->options().weak() || reflection->IsLazyField(field))) {
+    step.kind = Step::kReflection;
+  } else if (field->is_repeated()) {
+    step.kind = Step::kRepeated;
+    step.split = schema.IsSplit(field);
+    step.offset = schema.GetFieldOffset(field);
+  } else if (schema.InRealOneof(field)) {
+    step.kind = Step::kOneof;
+    step.offset = schema.GetFieldOffset(field);
+    step.presence = schema.GetOneofCaseOffset(field->containing_oneof());
+  } else {
+    step.split = schema.IsSplit(field);
+    step.offset = schema.GetFieldOffset(field);
+    step.has_bit = schema.HasBitIndex(field);
+    if (step.has_bit != static_cast<uint32_t>(-1)) {
+      step.presence = schema.HasBitsOffset();
+    }
+  }
+  return step;
+}
+
+const void* FieldPath::FieldAddress(const Step& step, const Message& message) {
+  const void* base =
+      step.split ? step.reflection->GetSplitField(&message) : &message;
+  return static_cast<const char*>(base) + step.offset;
+}
+
+int FieldPath::RepeatedSize(const Step& step, const Message& message) {
+  const void* field = FieldAddress(step, message);
+  switch (step.cpp_type) {
+#define HANDLE_TYPE(CPPTYPE, TYPE)          \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE: \
+    return static_cast<const RepeatedField<TYPE>*>(field)->size();
+
+    HANDLE_TYPE(INT32, int32_t)
+    HANDLE_TYPE(INT64, int64_t)
+    HANDLE_TYPE(UINT32, uint32_t)
+    HANDLE_TYPE(UINT64, uint64_t)
+    HANDLE_TYPE(DOUBLE, double)
+    HANDLE_TYPE(FLOAT, float)
+    HANDLE_TYPE(BOOL, bool)
+    HANDLE_TYPE(ENUM, int)
+#undef HANDLE_TYPE
+
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return static_cast<const RepeatedPtrField<Message>*>(field)->size();
+    default:
+      // Strings may be stored in several ways; let Reflection sort it out.
+      return step.reflection->FieldSize(message, step.field);
+  }
+}
+
+bool FieldPath::StepIsSet(const Step& step, const Message& message) {
+  switch (step.kind) {
+    case Step::kSingular: {
+      if (step.has_bit != static_cast<uint32_t>(-1)) {
+        const uint32_t* has_bits = reinterpret_cast<const uint32_t*>(
+            reinterpret_cast<const char*>(&message) + step.presence);
+        return (has_bits[step.has_bit / 32] >> (step.has_bit % 32)) & 1;
+      }
+      if (step.cpp_type == FieldDescriptor::CPPTYPE_MESSAGE) {
+        return !step.reflection->schema_.IsDefaultInstance(message) &&
+               *static_cast<const Message* const*>(
+                   FieldAddress(step, message)) != nullptr;
+      }
+      return step.reflection->HasField(message, step.field);
+    }
+    case Step::kOneof:
+      return *reinterpret_cast<const uint32_t*>(
+                 reinterpret_cast<const char*>(&message) + step.presence) ==
+             static_cast<uint32_t>(step.field->number());
+    case Step::kRepeated:
+      return step.index < RepeatedSize(step, message);
+    case Step::kReflection:
+      return step.field->is_repeated()
+                 ? step.index < step.reflection->FieldSize(message, step.field)
+                 : step.reflection->HasField(message, step.field);
+  }
+  return false;
+}
+
+const Message* FieldPath::StepMessage(const Step& step,
+                                      const Message& message) {
+  if (!StepIsSet(step, message)) return nullptr;
+  switch (step.kind) {
+    case Step::kSingular:
+    case Step::kOneof:
+      return *static_cast<const Message* const*>(FieldAddress(step, message));
+    case Step::kRepeated:
+      return &static_cast<const RepeatedPtrField<Message>*>(
+                  FieldAddress(step, message))
+                  ->Get(step.index);
+    case Step::kReflection:
+      return step.field->is_repeated()
+                 ? &step.reflection->GetRepeatedMessage(message, step.field,
+                                                        step.index)
+                 : &step.reflection->GetMessage(message, step.field);
+  }
+  return nullptr;
+}
+
+const Message* FieldPath::Resolve(const Message& message) const {
+  ABSL_DCHECK_EQ(message.GetReflection(),
+                 steps_.empty() ? leaf_.reflection : steps_[0].reflection)
+      << "FieldPath used with a message laid out differently from the one it "
+         "was compiled for.";
+  const Message* current = &message;
+  for (const Step& step : steps_) {
+    current = StepMessage(step, *current);
+    if (current == nullptr) return nullptr;
+  }
+  return current;
+}
+
+bool FieldPath::IsSet(const Message& message) const {
+  const Message* container = Resolve(message);
+  return container != nullptr && StepIsSet(leaf_, *container);
+}
+
+const void* FieldPath::ScalarAddress(const Message& message) const {
+  const Message* container = Resolve(message);
+  if (container == nullptr) return nullptr;
+  switch (leaf_.kind) {
+    case Step::kSingular:
+      // Fields that are not set hold their default value.
+      return FieldAddress(leaf_, *container);
+    case Step::kOneof:
+      return StepIsSet(leaf_, *container) ? FieldAddress(leaf_, *container)
+                                          : nullptr;
+    case Step::kRepeated:
+      break;
+    case Step::kReflection:
+      return nullptr;
+  }
+
+  if (!StepIsSet(leaf_, *container)) return nullptr;
+  const void* field = FieldAddress(leaf_, *container);
+  switch (leaf_.cpp_type) {
+#define HANDLE_TYPE(CPPTYPE, TYPE)          \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE: \
+    return &static_cast<const RepeatedField<TYPE>*>(field)->Get(leaf_.index);
+
+    HANDLE_TYPE(INT32, int32_t)
+    HANDLE_TYPE(INT64, int64_t)
+    HANDLE_TYPE(UINT32, uint32_t)
+    HANDLE_TYPE(UINT64, uint64_t)
+    HANDLE_TYPE(DOUBLE, double)
+    HANDLE_TYPE(FLOAT, float)
+    HANDLE_TYPE(BOOL, bool)
+    HANDLE_TYPE(ENUM, int)
+#undef HANDLE_TYPE
+
+    default:
+      return nullptr;
+  }
+}
+
+std::string FieldPath::GetString(const Message& message) const {
+  ABSL_DCHECK_EQ(leaf_.cpp_type, FieldDescriptor::CPPTYPE_STRING)
+      << "FieldPath::GetString() called on non-string field "
+      << leaf_.field->full_name();
+  const Message* container = Resolve(message);
+  if (leaf_.field->is_repeated()) {
+    if (container == nullptr || !StepIsSet(leaf_, *container)) return "";
+    return leaf_.reflection->GetRepeatedString(*container, leaf_.field,
+                                               leaf_.index);
+  }
+  return leaf_.reflection->GetString(
+      container != nullptr ? *container : *leaf_prototype_, leaf_.field);
+}
+
+const Message& FieldPath::GetMessage(const Message& message) const {
+  ABSL_DCHECK_EQ(leaf_.cpp_type, FieldDescriptor::CPPTYPE_MESSAGE)
+      << "FieldPath::GetMessage() called on non-message field "
+      << leaf_.field->full_name();
+  const Message* container = Resolve(message);
+  if (container != nullptr) {
+    const Message* result = StepMessage(leaf_, *container);
+    if (result != nullptr) return *result;
+  }
+  return *leaf_.reflection->GetDefaultMessageInstance(leaf_.field);
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
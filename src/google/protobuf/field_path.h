@@ -0,0 +1,217 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// FieldPath reads a field nested somewhere inside a message, named by a path
+// such as "a.b[3].c", without looking up any descriptors or making virtual
+// calls per read.  The path is resolved once against the layout of a message
+// type, which makes it much cheaper than chaining Reflection::GetMessage()
+// calls when the same path is read from many messages:
+//
+//   absl::StatusOr<FieldPath> path =
+//       FieldPath::Compile(Order::default_instance(), "items[0].price");
+//   ...
+//   double price = path->Get<double>(order);
+//
+// A FieldPath works with generated and dynamic messages alike, but only with
+// messages laid out like the prototype it was compiled against: messages of
+// the same generated class, or created by the same DynamicMessageFactory.
+
+#ifndef GOOGLE_PROTOBUF_FIELD_PATH_H__
+#define GOOGLE_PROTOBUF_FIELD_PATH_H__
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "absl/log/absl_log.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+class PROTOBUF_EXPORT FieldPath {
+ public:
+  // Resolves `path` against the type of `prototype`.  The path is a list of
+  // field names separated by dots; every field but the last must be a message
+  // field.  Repeated fields must be followed by an index in brackets, as in
+  // "a.b[3].c".  Map fields and extensions are not supported.
+  static absl::StatusOr<FieldPath> Compile(const Message& prototype,
+                                           absl::string_view path);
+
+  // The last field in the path.
+  const FieldDescriptor* field() const { return leaf_.field; }
+
+  // Returns true if every message along the path is set, every index is in
+  // range, and the last field is set as reported by Reflection::HasField()
+  // (or, when it is repeated, its index is in range).
+  bool IsSet(const Message& message) const;
+
+  // Reads the last field, which must be a numeric, enum or bool field,
+  // converting its value to T (an arithmetic type) with static_cast.  Enum
+  // values are read as their numbers.  If the field is not reached because a
+  // message along the path is not set or an index is out of range, returns
+  // the field's default value, as chained GetMessage() calls would.
+  template <typename T>
+  T Get(const Message& message) const;
+
+  // Reads the last field, which must be a string or bytes field.  Returns the
+  // field's default value if it is not reached.
+  std::string GetString(const Message& message) const;
+
+  // Reads the last field, which must be a message field.  Returns the default
+  // instance of the field's type if it is not reached or not set.
+  const Message& GetMessage(const Message& message) const;
+
+ private:
+  struct Step {
+    enum Kind : uint8_t {
+      kSingular,    // At `offset` in the message (or its split fields).
+      kOneof,       // At `offset`, if the oneof case at `presence` matches.
+      kRepeated,    // Element `index` of the field at `offset`.
+      kReflection,  // Anything else (e.g. lazy fields): read with Reflection.
+    };
+    Kind kind;
+    bool split;
+    FieldDescriptor::CppType cpp_type;
+    uint32_t offset;
+    // For kSingular, the offset of the has-bits, or -1 if the field has no
+    // has-bit.  For kOneof, the offset of the oneof case.
+    uint32_t presence;
+    uint32_t has_bit;
+    int index;
+    const Reflection* reflection;  // Of the message containing the field.
+    const FieldDescriptor* field;
+  };
+
+  FieldPath() = default;
+
+  static Step MakeStep(const Reflection* reflection,
+                       const FieldDescriptor* field, int index);
+
+  // Returns the address of `step`'s field in `message`.
+  static const void* FieldAddress(const Step& step, const Message& message);
+
+  // Returns the size of `step`'s repeated field in `message`.
+  static int RepeatedSize(const Step& step, const Message& message);
+
+  // Returns the message holding the last field, or nullptr if it is not
+  // reached.
+  const Message* Resolve(const Message& message) const;
+
+  // Returns true if `step`'s field is set in `message`.
+  static bool StepIsSet(const Step& step, const Message& message);
+
+  // Returns the message `step` leads to, or nullptr if it is not set.
+  static const Message* StepMessage(const Step& step, const Message& message);
+
+  // Returns the address of the last field's value, or nullptr if the field's
+  // default value should be read instead.
+  const void* ScalarAddress(const Message& message) const;
+
+  template <typename T>
+  T DefaultScalar() const;
+
+  std::vector<Step> steps_;
+  Step leaf_;
+  // The default instance of the message holding the last field.
+  const Message* leaf_prototype_ = nullptr;
+};
+
+template <typename T>
+T FieldPath::Get(const Message& message) const {
+  static_assert(std::is_arithmetic<T>::value,
+                "FieldPath::Get() reads numeric, enum and bool fields.");
+  const void* value = ScalarAddress(message);
+  if (value == nullptr) return DefaultScalar<T>();
+  switch (leaf_.cpp_type) {
+#define HANDLE_TYPE(CPPTYPE, TYPE)          \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE: \
+    return static_cast<T>(*static_cast<const TYPE*>(value));
+
+    HANDLE_TYPE(INT32, int32_t)
+    HANDLE_TYPE(INT64, int64_t)
+    HANDLE_TYPE(UINT32, uint32_t)
+    HANDLE_TYPE(UINT64, uint64_t)
+    HANDLE_TYPE(DOUBLE, double)
+    HANDLE_TYPE(FLOAT, float)
+    HANDLE_TYPE(BOOL, bool)
+    HANDLE_TYPE(ENUM, int)
+#undef HANDLE_TYPE
+
+    default:
+      ABSL_DLOG(FATAL) << "FieldPath::Get() called on non-scalar field "
+                       << leaf_.field->full_name();
+      return T();
+  }
+}
+
+template <typename T>
+T FieldPath::DefaultScalar() const {
+  const FieldDescriptor* field = leaf_.field;
+  if (field->is_repeated()) return T();
+  switch (leaf_.cpp_type) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return static_cast<T>(field->default_value_int32());
+    case FieldDescriptor::CPPTYPE_INT64:
+      return static_cast<T>(field->default_value_int64());
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return static_cast<T>(field->default_value_uint32());
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return static_cast<T>(field->default_value_uint64());
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return static_cast<T>(field->default_value_double());
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return static_cast<T>(field->default_value_float());
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return static_cast<T>(field->default_value_bool());
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return static_cast<T>(field->default_value_enum()->number());
+    default:
+      return T();
+  }
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_FIELD_PATH_H__
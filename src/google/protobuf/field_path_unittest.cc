@@ -0,0 +1,233 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/field_path.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/map_unittest.pb.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/unittest_proto3.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+FieldPath CompileOrDie(const Message& prototype, absl::string_view path) {
+  absl::StatusOr<FieldPath> result = FieldPath::Compile(prototype, path);
+  EXPECT_TRUE(result.ok()) << result.status();
+  return *std::move(result);
+}
+
+TEST(FieldPathTest, ReadsNestedFields) {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  const Message& prototype = unittest::TestAllTypes::default_instance();
+
+  FieldPath path = CompileOrDie(prototype, "optional_nested_message.bb");
+  EXPECT_TRUE(path.IsSet(message));
+  EXPECT_EQ(118, path.Get<int32_t>(message));
+  EXPECT_EQ(118.0, path.Get<double>(message));
+  EXPECT_EQ(message.GetDescriptor()->nested_type(0)->FindFieldByName("bb"),
+            path.field());
+
+  path = CompileOrDie(prototype, "repeated_nested_message[1].bb");
+  EXPECT_TRUE(path.IsSet(message));
+  EXPECT_EQ(318, path.Get<int64_t>(message));
+
+  path = CompileOrDie(prototype, "repeated_int64[1]");
+  EXPECT_TRUE(path.IsSet(message));
+  EXPECT_EQ(302, path.Get<int64_t>(message));
+
+  path = CompileOrDie(prototype, "optional_nested_enum");
+  EXPECT_EQ(unittest::TestAllTypes::BAZ, path.Get<int>(message));
+
+  path = CompileOrDie(prototype, "optional_string");
+  EXPECT_EQ("115", path.GetString(message));
+
+  path = CompileOrDie(prototype, "repeated_string[0]");
+  EXPECT_EQ("215", path.GetString(message));
+
+  path = CompileOrDie(prototype, "optional_foreign_message");
+  EXPECT_EQ(&message.optional_foreign_message(), &path.GetMessage(message));
+
+  path = CompileOrDie(prototype, "oneof_bytes");
+  EXPECT_TRUE(path.IsSet(message));
+  EXPECT_EQ("604", path.GetString(message));
+
+  unittest::NestedTestAllTypes nested;
+  nested.mutable_child()->mutable_child()->mutable_payload()->set_optional_int32(
+      7);
+  path = CompileOrDie(unittest::NestedTestAllTypes::default_instance(),
+                      "child.child.payload.optional_int32");
+  EXPECT_TRUE(path.IsSet(nested));
+  EXPECT_EQ(7, path.Get<int32_t>(nested));
+}
+
+TEST(FieldPathTest, UnreachedFieldsReadDefaults) {
+  unittest::TestAllTypes message;
+  const Message& prototype = unittest::TestAllTypes::default_instance();
+
+  FieldPath path = CompileOrDie(prototype, "optional_nested_message.bb");
+  EXPECT_FALSE(path.IsSet(message));
+  EXPECT_EQ(0, path.Get<int32_t>(message));
+
+  path = CompileOrDie(prototype, "default_int32");
+  EXPECT_FALSE(path.IsSet(message));
+  EXPECT_EQ(41, path.Get<int32_t>(message));
+
+  path = CompileOrDie(prototype, "default_string");
+  EXPECT_EQ("hello", path.GetString(message));
+
+  path = CompileOrDie(prototype, "repeated_nested_message[2].bb");
+  message.add_repeated_nested_message()->set_bb(1);
+  EXPECT_FALSE(path.IsSet(message));
+  EXPECT_EQ(0, path.Get<int32_t>(message));
+
+  path = CompileOrDie(prototype, "optional_nested_message");
+  EXPECT_EQ(&unittest::TestAllTypes::NestedMessage::default_instance(),
+            &path.GetMessage(message));
+
+  // A submessage cleared after being set is kept, but is no longer set.
+  message.mutable_optional_nested_message()->set_bb(5);
+  message.clear_optional_nested_message();
+  path = CompileOrDie(prototype, "optional_nested_message.bb");
+  EXPECT_FALSE(path.IsSet(message));
+  EXPECT_EQ(0, path.Get<int32_t>(message));
+
+  // Reading a oneof member that is not the one set.
+  message.mutable_oneof_nested_message()->set_bb(9);
+  path = CompileOrDie(prototype, "oneof_nested_message.bb");
+  EXPECT_TRUE(path.IsSet(message));
+  EXPECT_EQ(9, path.Get<int32_t>(message));
+  message.set_oneof_uint32(3);
+  EXPECT_FALSE(path.IsSet(message));
+  EXPECT_EQ(0, path.Get<int32_t>(message));
+  path = CompileOrDie(prototype, "oneof_string");
+  EXPECT_EQ("", path.GetString(message));
+}
+
+TEST(FieldPathTest, LazyFields) {
+  unittest::TestAllTypes message;
+  message.mutable_optional_lazy_message()->set_bb(12);
+  FieldPath path = CompileOrDie(unittest::TestAllTypes::default_instance(),
+                                "optional_lazy_message.bb");
+  EXPECT_TRUE(path.IsSet(message));
+  EXPECT_EQ(12, path.Get<int32_t>(message));
+}
+
+TEST(FieldPathTest, Proto3) {
+  proto3_unittest::TestAllTypes message;
+  const Message& prototype = proto3_unittest::TestAllTypes::default_instance();
+  FieldPath path = CompileOrDie(prototype, "optional_nested_message.bb");
+  EXPECT_FALSE(path.IsSet(message));
+  message.mutable_optional_nested_message()->set_bb(3);
+  EXPECT_TRUE(path.IsSet(message));
+  EXPECT_EQ(3, path.Get<int32_t>(message));
+
+  path = CompileOrDie(prototype, "optional_import_message.d");
+  EXPECT_FALSE(path.IsSet(message));
+  message.mutable_optional_import_message()->set_d(8);
+  EXPECT_TRUE(path.IsSet(message));
+  EXPECT_EQ(8, path.Get<int32_t>(message));
+
+  path = CompileOrDie(prototype, "optional_int32");
+  EXPECT_FALSE(path.IsSet(message));
+  message.set_optional_int32(4);
+  EXPECT_TRUE(path.IsSet(message));
+  EXPECT_EQ(4, path.Get<int32_t>(message));
+}
+
+TEST(FieldPathTest, DynamicMessage) {
+  unittest::TestAllTypes generated;
+  TestUtil::SetAllFields(&generated);
+
+  DynamicMessageFactory factory;
+  const Message* prototype =
+      factory.GetPrototype(unittest::TestAllTypes::descriptor());
+  std::unique_ptr<Message> message(prototype->New());
+  ASSERT_TRUE(message->ParseFromString(generated.SerializeAsString()));
+
+  FieldPath path = CompileOrDie(*prototype, "repeated_nested_message[1].bb");
+  EXPECT_TRUE(path.IsSet(*message));
+  EXPECT_EQ(318, path.Get<int32_t>(*message));
+
+  path = CompileOrDie(*prototype, "optional_import_message.d");
+  EXPECT_EQ(120, path.Get<int32_t>(*message));
+
+  path = CompileOrDie(*prototype, "oneof_bytes");
+  EXPECT_EQ("604", path.GetString(*message));
+
+  path = CompileOrDie(*prototype, "optional_nested_message");
+  EXPECT_EQ(path.GetMessage(*message).GetDescriptor(),
+            unittest::TestAllTypes::NestedMessage::descriptor());
+
+  std::unique_ptr<Message> empty(prototype->New());
+  path = CompileOrDie(*prototype, "optional_nested_message.bb");
+  EXPECT_FALSE(path.IsSet(*empty));
+  EXPECT_EQ(0, path.Get<int32_t>(*empty));
+  path = CompileOrDie(*prototype, "default_double");
+  EXPECT_EQ(52e3, path.Get<double>(*empty));
+}
+
+TEST(FieldPathTest, InvalidPaths) {
+  const Message& prototype = unittest::TestAllTypes::default_instance();
+  for (absl::string_view path : {
+           "",
+           "no_such_field",
+           "optional_nested_message.no_such_field",
+           "optional_int32.bb",
+           "repeated_int32",
+           "repeated_nested_message.bb",
+           "optional_int32[0]",
+           "repeated_int32[x]",
+           "repeated_int32[-1]",
+           "repeated_int32[1",
+           "optional_nested_message.",
+       }) {
+    absl::StatusOr<FieldPath> result = FieldPath::Compile(prototype, path);
+    EXPECT_EQ(absl::StatusCode::kInvalidArgument, result.status().code())
+        << path;
+  }
+
+  absl::StatusOr<FieldPath> result = FieldPath::Compile(
+      unittest::TestMapSubmessage::default_instance(), "test_map.map_int32_int32");
+  EXPECT_EQ(absl::StatusCode::kInvalidArgument, result.status().code());
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
@@ -39,6 +39,8 @@
 #include <cstdint>
 #include <cstring>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/base/casts.h"
 #include "absl/container/flat_hash_map.h"
@@ -48,6 +50,8 @@
 #include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor_legacy.h"
@@ -338,17 +342,95 @@ bool Reflection::IsInlined(const FieldDescriptor* field) const {
   return schema_.IsFieldInlined(field);
 }
 
+const internal::TcParseTableBase* Reflection::GetFieldsTable() const {
+  absl::call_once(fields_table_once_, [&] {
+    const TcParseTableBase* table = GetTcParseTable();
+    // Tables that fall back to reflection have no field entries.
+    if (table->num_field_entries == descriptor_->field_count() &&
+        internal::TcParser::CanSpaceUsedFields(table)) {
+      fields_table_ = table;
+    }
+  });
+  return fields_table_;
+}
+
 size_t Reflection::SpaceUsedLong(const Message& message) const {
+  return SpaceUsedLongImpl(message, /*on_arena=*/false);
+}
+
+size_t Reflection::SpaceUsedOnArenaLong(const Message& message) const {
+  if (message.GetArena() == nullptr) return 0;
+  return SpaceUsedLongImpl(message, /*on_arena=*/true);
+}
+
+size_t Reflection::SubmessageSpaceUsed(const MessageLite& message,
+                                       bool on_arena) {
+  const Message& sub_message = static_cast<const Message&>(message);
+  if (!on_arena) return sub_message.SpaceUsedLong();
+  return sub_message.GetReflection()->SpaceUsedLongImpl(sub_message,
+                                                        /*on_arena=*/true);
+}
+
+size_t Reflection::SpaceUsedLongImpl(const Message& message,
+                                     bool on_arena) const {
   // object_size_ already includes the in-memory representation of each field
   // in the message, so we only need to account for additional memory used by
   // the fields.
   size_t total_size = schema_.GetObjectSize();
 
-  total_size += GetUnknownFields(message).SpaceUsedExcludingSelfLong();
+  // Unknown fields keep their contents on the heap.
+  if (!on_arena) {
+    total_size += GetUnknownFields(message).SpaceUsedExcludingSelfLong();
+  }
 
   if (schema_.HasExtensionSet()) {
     total_size += GetExtensionSet(message).SpaceUsedExcludingSelfLong();
   }
+
+  if (const TcParseTableBase* table = GetFieldsTable()) {
+    total_size += internal::TcParser::SpaceUsedFields(&message, table, on_arena,
+                                                      &SubmessageSpaceUsed);
+  } else {
+    total_size += SpaceUsedFieldsByDescriptor(message, on_arena);
+  }
+#ifndef PROTOBUF_FUZZ_MESSAGE_SPACE_USED_LONG
+  return total_size;
+#else
+  // Use both `this` and `dummy` to generate the seed so that the scale factor
+  // is both per-object and non-predictable, but consistent across multiple
+  // calls in the same binary.
+  static bool dummy;
+  uintptr_t seed =
+      reinterpret_cast<uintptr_t>(&dummy) ^ reinterpret_cast<uintptr_t>(this);
+  // Fuzz the size by +/- 50%.
+  double scale = (static_cast<double>(seed % 10000) / 10000) + 0.5;
+  return total_size * scale;
+#endif
+}
+
+namespace {
+
+// Element handlers for RepeatedPtrFieldBase::SpaceUsedExcludingSelfLong() that
+// only count memory taken from the arena.
+struct ArenaStringSpaceUsedHandler {
+  using Type = std::string;
+  static size_t SpaceUsedLong(const std::string&) {
+    return sizeof(std::string);
+  }
+};
+
+struct ArenaMessageSpaceUsedHandler {
+  using Type = Message;
+  static size_t SpaceUsedLong(const Message& message) {
+    return message.SpaceUsedOnArenaLong();
+  }
+};
+
+}  // namespace
+
+size_t Reflection::SpaceUsedFieldsByDescriptor(const Message& message,
+                                               bool on_arena) const {
+  size_t total_size = 0;
   for (int i = 0; i <= last_non_weak_field_index_; i++) {
     const FieldDescriptor* field = descriptor_->field(i);
     if (field->is_repeated()) {
@@ -373,9 +455,16 @@ size_t Reflection::SpaceUsedLong(const Message& message) const {
           switch (field->options().ctype()) {
             default:  // TODO(kenton):  Support other string reps.
             case FieldOptions::STRING:
-              total_size +=
-                  GetRaw<RepeatedPtrField<std::string> >(message, field)
-                      .SpaceUsedExcludingSelfLong();
+              if (on_arena) {
+                total_size +=
+                    GetRaw<RepeatedPtrFieldBase>(message, field)
+                        .SpaceUsedExcludingSelfLong<
+                            ArenaStringSpaceUsedHandler>();
+              } else {
+                total_size +=
+                    GetRaw<RepeatedPtrField<std::string> >(message, field)
+                        .SpaceUsedExcludingSelfLong();
+              }
               break;
           }
           break;
@@ -384,6 +473,10 @@ size_t Reflection::SpaceUsedLong(const Message& message) const {
           if (IsMapFieldInApi(field)) {
             total_size += GetRaw<internal::MapFieldBase>(message, field)
                               .SpaceUsedExcludingSelfLong();
+          } else if (on_arena) {
+            total_size += GetRaw<RepeatedPtrFieldBase>(message, field)
+                              .SpaceUsedExcludingSelfLong<
+                                  ArenaMessageSpaceUsedHandler>();
           } else {
             // We don't know which subclass of RepeatedPtrFieldBase the type is,
             // so we use RepeatedPtrFieldBase directly.
@@ -413,7 +506,12 @@ size_t Reflection::SpaceUsedLong(const Message& message) const {
         case FieldDescriptor::CPPTYPE_STRING: {
           switch (internal::cpp::EffectiveStringCType(field)) {
             case FieldOptions::CORD:
-              if (schema_.InRealOneof(field)) {
+              if (on_arena) {
+                // Only a oneof cord is allocated apart from the message.
+                if (schema_.InRealOneof(field)) {
+                  total_size += sizeof(absl::Cord);
+                }
+              } else if (schema_.InRealOneof(field)) {
                 total_size += GetField<absl::Cord*>(message, field)
                                   ->EstimatedMemoryUsage();
 
@@ -427,6 +525,7 @@ size_t Reflection::SpaceUsedLong(const Message& message) const {
             default:
             case FieldOptions::STRING:
               if (IsInlined(field)) {
+                if (on_arena) break;
                 const std::string* ptr =
                     &GetField<InlinedStringField>(message, field).GetNoArena();
                 total_size += StringSpaceUsedExcludingSelfLong(*ptr);
@@ -440,8 +539,10 @@ size_t Reflection::SpaceUsedLong(const Message& message) const {
                 if (!str.IsDefault() || schema_.InRealOneof(field)) {
                   // string fields are represented by just a pointer, so also
                   // include sizeof(string) as well.
-                  total_size += sizeof(std::string) +
-                                StringSpaceUsedExcludingSelfLong(str.Get());
+                  total_size += sizeof(std::string);
+                  if (!on_arena) {
+                    total_size += StringSpaceUsedExcludingSelfLong(str.Get());
+                  }
                 }
               }
               break;
@@ -456,26 +557,14 @@ size_t Reflection::SpaceUsedLong(const Message& message) const {
           } else {
             const Message* sub_message = GetRaw<const Message*>(message, field);
             if (sub_message != nullptr) {
-              total_size += sub_message->SpaceUsedLong();
+              total_size += SubmessageSpaceUsed(*sub_message, on_arena);
             }
           }
           break;
       }
     }
   }
-#ifndef PROTOBUF_FUZZ_MESSAGE_SPACE_USED_LONG
   return total_size;
-#else
-  // Use both `this` and `dummy` to generate the seed so that the scale factor
-  // is both per-object and non-predictable, but consistent across multiple
-  // calls in the same binary.
-  static bool dummy;
-  uintptr_t seed =
-      reinterpret_cast<uintptr_t>(&dummy) ^ reinterpret_cast<uintptr_t>(this);
-  // Fuzz the size by +/- 50%.
-  double scale = (static_cast<double>(seed % 10000) / 10000) + 0.5;
-  return total_size * scale;
-#endif
 }
 
 namespace {
@@ -1063,6 +1152,16 @@ void Reflection::Swap(Message* message1, Message* message2) const {
       std::swap(message1, message2);  // Swapping names for pointers!
     }
 
+    // Unknown fields are heap allocated whatever the arena, so they are moved
+    // across instead of being copied along with the rest of the message.
+    UnknownFieldSet unknown1, unknown2;
+    if (!GetUnknownFields(*message1).empty()) {
+      unknown1.Swap(MutableUnknownFields(message1));
+    }
+    if (!GetUnknownFields(*message2).empty()) {
+      unknown2.Swap(MutableUnknownFields(message2));
+    }
+
     Message* temp = message1->New(arena);
     temp->MergeFrom(*message2);
     message2->CopyFrom(*message1);
@@ -1072,6 +1171,12 @@ void Reflection::Swap(Message* message1, Message* message2) const {
 #else   // PROTOBUF_FORCE_COPY_IN_SWAP
     Swap(message1, temp);
 #endif  // !PROTOBUF_FORCE_COPY_IN_SWAP
+    if (!unknown2.empty()) {
+      MutableUnknownFields(message1)->MergeFrom(std::move(unknown2));
+    }
+    if (!unknown1.empty()) {
+      MutableUnknownFields(message2)->MergeFrom(std::move(unknown1));
+    }
     return;
   }
 
@@ -2587,6 +2692,18 @@ bool Reflection::LookupMapValue(const Message& message,
   return GetRaw<MapFieldBase>(message, field).LookupMapValue(key, val);
 }
 
+void Reflection::LookupMapValues(const Message& message,
+                                 const FieldDescriptor* field,
+                                 const MapKey* keys, size_t n,
+                                 MapValueConstRef* vals, bool* found) const {
+  USAGE_CHECK(IsMapFieldInApi(field), "LookupMapValues",
+              "Field is not a map field.");
+  const FieldDescriptor::CppType type =
+      field->message_type()->map_value()->cpp_type();
+  for (size_t i = 0; i < n; ++i) vals[i].SetType(type);
+  GetRaw<MapFieldBase>(message, field).LookupMapValues(keys, n, vals, found);
+}
+
 bool Reflection::DeleteMapValue(Message* message, const FieldDescriptor* field,
                                 const MapKey& key) const {
   USAGE_CHECK(IsMapFieldInApi(field), "DeleteMapValue",
@@ -3075,6 +3192,34 @@ MessageFactory* Reflection::GetMessageFactory() const {
   return message_factory_;
 }
 
+Reflection::ScalarFieldList Reflection::MakeScalarFieldList(
+    absl::Span<const FieldDescriptor* const> fields) const {
+  ScalarFieldList list;
+  list.descriptor_ = descriptor_;
+  list.entries_.reserve(fields.size());
+  for (const FieldDescriptor* field : fields) {
+    USAGE_CHECK_MESSAGE_TYPE(MakeScalarFieldList);
+    USAGE_CHECK_SINGULAR(MakeScalarFieldList);
+    USAGE_CHECK(field->cpp_type() != FieldDescriptor::CPPTYPE_STRING &&
+                    field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE,
+                MakeScalarFieldList,
+                "Field is not a numeric, enum or bool field.");
+    ScalarFieldList::Entry entry;
+    entry.cpp_type = field->cpp_type();
+    entry.field = field;
+    if (field->is_extension() || schema_.InRealOneof(field)) {
+      entry.location = ScalarFieldList::Entry::kReflection;
+      entry.offset = 0;
+    } else {
+      entry.location = schema_.IsSplit(field) ? ScalarFieldList::Entry::kSplit
+                                              : ScalarFieldList::Entry::kMessage;
+      entry.offset = schema_.GetFieldOffset(field);
+    }
+    list.entries_.push_back(entry);
+  }
+  return list;
+}
+
 void* Reflection::RepeatedFieldData(Message* message,
                                     const FieldDescriptor* field,
                                     FieldDescriptor::CppType cpp_type,
@@ -3335,7 +3480,8 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
 
           /* is_lite */ false,          //
           ref_.schema_.IsSplit(field),  //
-          /* uses_codegen */ false      //
+          /* uses_codegen */ false,     //
+          /* presence_probability */ 1  //
       };
     }
 
@@ -3378,7 +3524,9 @@ const internal::TcParseTableBase* Reflection::CreateTcParseTable() const {
       static_cast<uint16_t>(table_info.aux_entries.size()),
       aux_offset,
       schema_.default_instance_,
-      &internal::TcParser::ReflectionFallback};
+      &internal::TcParser::ReflectionFallback,
+      table_info.required_fields_mask,
+      table_info.tracks_required_fields};
 
   // Now copy the rest of the payloads
   PopulateTcParseFastEntries(table_info, res->fast_entry(0));
@@ -3633,8 +3781,43 @@ void AssignDescriptors(const DescriptorTable* table, bool eager) {
   absl::call_once(*table->once, AssignDescriptorsImpl, table, eager);
 }
 
+#ifdef PROTOBUF_DYNAMIC_INIT_STATS
+namespace {
+
+struct DynamicInitStatsRegistry {
+  absl::Mutex mu;
+  std::vector<DynamicInitStats> files ABSL_GUARDED_BY(mu);
+};
+
+DynamicInitStatsRegistry& GetDynamicInitStatsRegistry() {
+  static auto* registry = new DynamicInitStatsRegistry;
+  return *registry;
+}
+
+}  // namespace
+#endif  // PROTOBUF_DYNAMIC_INIT_STATS
+
 AddDescriptorsRunner::AddDescriptorsRunner(const DescriptorTable* table) {
+#ifdef PROTOBUF_DYNAMIC_INIT_STATS
+  const absl::Time start = absl::Now();
+  AddDescriptors(table);
+  const int64_t nanoseconds = absl::ToInt64Nanoseconds(absl::Now() - start);
+  DynamicInitStatsRegistry& registry = GetDynamicInitStatsRegistry();
+  absl::MutexLock lock(&registry.mu);
+  registry.files.push_back({table->filename, nanoseconds});
+#else   // PROTOBUF_DYNAMIC_INIT_STATS
   AddDescriptors(table);
+#endif  // !PROTOBUF_DYNAMIC_INIT_STATS
+}
+
+std::vector<DynamicInitStats> GetDynamicInitStats() {
+#ifdef PROTOBUF_DYNAMIC_INIT_STATS
+  DynamicInitStatsRegistry& registry = GetDynamicInitStatsRegistry();
+  absl::MutexLock lock(&registry.mu);
+  return registry.files;
+#else   // PROTOBUF_DYNAMIC_INIT_STATS
+  return {};
+#endif  // !PROTOBUF_DYNAMIC_INIT_STATS
 }
 
 void RegisterFileLevelMetadata(const DescriptorTable* table) {
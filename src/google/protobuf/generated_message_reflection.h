@@ -38,7 +38,9 @@
 #ifndef GOOGLE_PROTOBUF_GENERATED_MESSAGE_REFLECTION_H__
 #define GOOGLE_PROTOBUF_GENERATED_MESSAGE_REFLECTION_H__
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "google/protobuf/stubs/common.h"
 #include "absl/base/call_once.h"
@@ -361,6 +363,18 @@ struct PROTOBUF_EXPORT AddDescriptorsRunner {
   explicit AddDescriptorsRunner(const DescriptorTable* table);
 };
 
+// Time one generated file spent in AddDescriptorsRunner during dynamic
+// initialization, including the dependencies it registered first.  Collected
+// only when the runtime is built with PROTOBUF_DYNAMIC_INIT_STATS defined.
+struct DynamicInitStats {
+  const char* filename;
+  int64_t nanoseconds;
+};
+
+// Returns the times collected so far in initialization order, or nothing if
+// the runtime was built without PROTOBUF_DYNAMIC_INIT_STATS.
+PROTOBUF_EXPORT std::vector<DynamicInitStats> GetDynamicInitStats();
+
 struct DenseEnumCacheInfo {
   std::atomic<const std::string**> cache;
   int min_val;
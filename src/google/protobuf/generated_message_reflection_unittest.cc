@@ -53,6 +53,7 @@
 #include <gtest/gtest.h>
 #include "absl/log/absl_check.h"
 #include "absl/strings/cord.h"
+#include "absl/types/span.h"
 #include "google/protobuf/map_test_util.h"
 #include "google/protobuf/map_unittest.pb.h"
 #include "google/protobuf/test_util.h"
@@ -603,6 +604,85 @@ TEST(GeneratedMessageReflectionTest, RemoveLast) {
   TestUtil::ExpectLastRepeatedsRemoved(message);
 }
 
+TEST(GeneratedMessageReflectionTest, RepeatedScalarSpan) {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  const Reflection* reflection = message.GetReflection();
+  const Descriptor* descriptor = message.GetDescriptor();
+
+  EXPECT_THAT(reflection->GetRepeatedScalarSpan<int64_t>(
+                  message, descriptor->FindFieldByName("repeated_int64")),
+              testing::ElementsAre(202, 302));
+  EXPECT_THAT(reflection->GetRepeatedScalarSpan<bool>(
+                  message, descriptor->FindFieldByName("repeated_bool")),
+              testing::ElementsAre(true, false));
+  EXPECT_THAT(
+      reflection->GetRepeatedScalarSpan<int32_t>(
+          message, descriptor->FindFieldByName("repeated_nested_enum")),
+      testing::ElementsAre(unittest::TestAllTypes::BAR,
+                           unittest::TestAllTypes::BAZ));
+
+  absl::Span<double> doubles = reflection->GetMutableRepeatedScalarSpan<double>(
+      &message, descriptor->FindFieldByName("repeated_double"));
+  ASSERT_EQ(2, doubles.size());
+  doubles[1] = 1.5;
+  EXPECT_EQ(1.5, message.repeated_double(1));
+
+  unittest::TestAllExtensions extensions;
+  TestUtil::SetAllExtensions(&extensions);
+  const FileDescriptor* file = extensions.GetDescriptor()->file();
+  EXPECT_THAT(extensions.GetReflection()->GetRepeatedScalarSpan<uint32_t>(
+                  extensions,
+                  file->FindExtensionByName("repeated_uint32_extension")),
+              testing::ElementsAre(203, 303));
+}
+
+TEST(GeneratedMessageReflectionTest, GetScalarFields) {
+  unittest::TestAllTypes message;
+  message.set_optional_int32(-3);
+  message.set_optional_uint64(uint64_t{1} << 40);
+  message.set_optional_float(0.5f);
+  message.set_optional_bool(true);
+  message.set_optional_nested_enum(unittest::TestAllTypes::BAZ);
+  message.set_oneof_uint32(7);
+  const Reflection* reflection = message.GetReflection();
+  const Descriptor* descriptor = message.GetDescriptor();
+
+  const Reflection::ScalarFieldList list = reflection->MakeScalarFieldList({
+      descriptor->FindFieldByName("optional_int32"),
+      descriptor->FindFieldByName("optional_uint64"),
+      descriptor->FindFieldByName("optional_float"),
+      descriptor->FindFieldByName("optional_bool"),
+      descriptor->FindFieldByName("optional_nested_enum"),
+      descriptor->FindFieldByName("default_int64"),
+      descriptor->FindFieldByName("oneof_uint32"),
+  });
+  ASSERT_EQ(7, list.size());
+  double values[7];
+  reflection->GetScalarFields(message, list, absl::MakeSpan(values));
+  EXPECT_THAT(values, testing::ElementsAre(-3, 1099511627776.0, 0.5, 1,
+                                           unittest::TestAllTypes::BAZ,
+                                           /* default */ 42, 7));
+
+  // A oneof field that is not set reads as its default.
+  message.set_oneof_string("a");
+  int64_t integers[7];
+  reflection->GetScalarFields(message, list, absl::MakeSpan(integers));
+  EXPECT_EQ(0, integers[6]);
+
+  unittest::TestAllExtensions extensions;
+  extensions.SetExtension(unittest::optional_sint64_extension, -9);
+  const FileDescriptor* file = extensions.GetDescriptor()->file();
+  const Reflection::ScalarFieldList extension_list =
+      extensions.GetReflection()->MakeScalarFieldList(
+          {file->FindExtensionByName("optional_sint64_extension"),
+           file->FindExtensionByName("default_int32_extension")});
+  extensions.GetReflection()->GetScalarFields(
+      extensions, extension_list, absl::MakeSpan(integers, 2));
+  EXPECT_EQ(-9, integers[0]);
+  EXPECT_EQ(41, integers[1]);
+}
+
 TEST(GeneratedMessageReflectionTest, RemoveLastExtensions) {
   unittest::TestAllExtensions message;
   TestUtil::ReflectionTester reflection_tester(
@@ -1340,6 +1420,14 @@ TEST(GeneratedMessageReflectionTest, UsageErrors) {
       "  Message type: protobuf_unittest.TestAllTypes\n"
       "  Field       : protobuf_unittest.ForeignMessage.c\n"
       "  Problem     : Field does not match message type.");
+  EXPECT_DEATH(
+      reflection->MakeScalarFieldList(
+          {descriptor->FindFieldByName("optional_string")}),
+      "Protocol Buffer reflection usage error:\n"
+      "  Method      : google::protobuf::Reflection::MakeScalarFieldList\n"
+      "  Message type: protobuf_unittest.TestAllTypes\n"
+      "  Field       : protobuf_unittest.TestAllTypes.optional_string\n"
+      "  Problem     : Field is not a numeric, enum or bool field.");
 }
 
 #endif  // GTEST_HAS_DEATH_TEST
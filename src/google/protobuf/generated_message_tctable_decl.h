@@ -280,6 +280,9 @@ struct MapAuxInfo {
   uint8_t log_debug_utf8_failure : 1;
   // If true the next aux contains the enum validator.
   uint8_t value_is_validated_enum : 1;
+  // If true the value is a message with required fields. It is only parsed
+  // when the entry contains it, so it may be left uninitialized.
+  uint8_t value_has_required_fields : 1;
   // Size information derived from the actual node type.
   MapNodeSizeInfoT node_size_info;
 };
@@ -292,6 +295,8 @@ struct alignas(uint64_t) TcParseTableBase {
   uint16_t extension_offset;
   uint32_t max_field_number;
   uint8_t fast_idx_mask;
+  // Kept here to fill the padding; see `required_fields_mask`.
+  bool tracks_required_fields;
   uint16_t lookup_table_offset;
   uint32_t skipmap32;
   uint32_t field_entries_offset;
@@ -300,6 +305,11 @@ struct alignas(uint64_t) TcParseTableBase {
   uint16_t num_aux_entries;
   uint32_t aux_offset;
 
+  // Has-bits of the required fields, all of which live in the first has-bit
+  // word. Only meaningful if `tracks_required_fields` is set; otherwise the
+  // parser cannot tell whether this message is initialized.
+  uint32_t required_fields_mask;
+
   const MessageLite* default_instance;
 
   // Handler for fields which are not handled by table dispatch.
@@ -316,17 +326,20 @@ struct alignas(uint64_t) TcParseTableBase {
       uint16_t lookup_table_offset, uint32_t skipmap32,
       uint32_t field_entries_offset, uint16_t num_field_entries,
       uint16_t num_aux_entries, uint32_t aux_offset,
-      const MessageLite* default_instance, TailCallParseFunc fallback)
+      const MessageLite* default_instance, TailCallParseFunc fallback,
+      uint32_t required_fields_mask = 0, bool tracks_required_fields = false)
       : has_bits_offset(has_bits_offset),
         extension_offset(extension_offset),
         max_field_number(max_field_number),
         fast_idx_mask(fast_idx_mask),
+        tracks_required_fields(tracks_required_fields),
         lookup_table_offset(lookup_table_offset),
         skipmap32(skipmap32),
         field_entries_offset(field_entries_offset),
         num_field_entries(num_field_entries),
         num_aux_entries(num_aux_entries),
         aux_offset(aux_offset),
+        required_fields_mask(required_fields_mask),
         default_instance(default_instance),
         fallback(fallback) {}
 
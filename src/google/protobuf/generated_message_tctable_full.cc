@@ -30,13 +30,19 @@
 
 #include <cstdint>
 
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
 #include "google/protobuf/extension_set.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/parse_context.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/unknown_field_set.h"
 #include "google/protobuf/wire_format.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "utf8_validity.h"
 
 // must be last
 #include "google/protobuf/port_def.inc"
@@ -89,6 +95,287 @@ const char* TcParser::ReflectionParseLoop(PROTOBUF_TC_PARAM_DECL) {
   return WireFormat::_InternalParse(DownCast<Message*>(msg), ptr, ctx);
 }
 
+// Verification ///////////////////////////////////////////////////////////////
+
+using FieldEntry = TcParseTableBase::FieldEntry;
+
+namespace {
+
+// The verifier reads from a flat buffer, so every read is bounded by `end`
+// instead of going through the slop bytes of ParseContext.
+
+bool VerifyVarint(const char*& ptr, const char* end, uint64_t* value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (ptr == end) return false;
+    uint8_t byte = static_cast<uint8_t>(*ptr++);
+    result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (byte < 0x80) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool VerifyTag(const char*& ptr, const char* end, uint32_t* tag) {
+  uint64_t value;
+  if (!VerifyVarint(ptr, end, &value) || value > UINT32_MAX) return false;
+  *tag = static_cast<uint32_t>(value);
+  return true;
+}
+
+// Reads a length prefix and returns the payload in [*payload, ptr).
+bool VerifyLength(const char*& ptr, const char* end, const char** payload) {
+  uint64_t size;
+  if (!VerifyVarint(ptr, end, &size) ||
+      size > static_cast<uint64_t>(end - ptr) || size > INT32_MAX) {
+    return false;
+  }
+  *payload = ptr;
+  ptr += size;
+  return true;
+}
+
+bool VerifyFixed(const char*& ptr, const char* end, int size) {
+  if (end - ptr < size) return false;
+  ptr += size;
+  return true;
+}
+
+bool VerifyPackedVarints(const char* ptr, const char* end) {
+  uint64_t value;
+  while (ptr != end) {
+    if (!VerifyVarint(ptr, end, &value)) return false;
+  }
+  return true;
+}
+
+bool VerifyUnknownField(uint32_t tag, const char*& ptr, const char* end,
+                        int depth);
+
+// Skips the fields of an unknown group, up to its matching end tag.
+bool VerifyUnknownGroup(uint32_t start_tag, const char*& ptr, const char* end,
+                        int depth) {
+  if (--depth < 0) return false;
+  while (true) {
+    uint32_t tag;
+    if (!VerifyTag(ptr, end, &tag)) return false;
+    if ((tag & 7) == WireFormatLite::WIRETYPE_END_GROUP) {
+      return tag == start_tag + 1;
+    }
+    if (!VerifyUnknownField(tag, ptr, end, depth)) return false;
+  }
+}
+
+bool VerifyUnknownField(uint32_t tag, const char*& ptr, const char* end,
+                        int depth) {
+  if ((tag >> 3) == 0) return false;
+  switch (tag & 7) {
+    case WireFormatLite::WIRETYPE_VARINT: {
+      uint64_t value;
+      return VerifyVarint(ptr, end, &value);
+    }
+    case WireFormatLite::WIRETYPE_FIXED64:
+      return VerifyFixed(ptr, end, 8);
+    case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+      const char* payload;
+      return VerifyLength(ptr, end, &payload);
+    }
+    case WireFormatLite::WIRETYPE_START_GROUP:
+      return VerifyUnknownGroup(tag, ptr, end, depth);
+    case WireFormatLite::WIRETYPE_FIXED32:
+      return VerifyFixed(ptr, end, 4);
+    default:
+      return false;
+  }
+}
+
+// Returns the prototype of the message field `number` of `parent`, for the
+// cases where the parse table does not hold it.
+const Message* SubmessagePrototype(const Message& parent, uint32_t number) {
+  const FieldDescriptor* field =
+      parent.GetDescriptor()->FindFieldByNumber(static_cast<int>(number));
+  if (field == nullptr || field->message_type() == nullptr) return nullptr;
+  return parent.GetReflection()->GetMessageFactory()->GetPrototype(
+      field->message_type());
+}
+
+}  // namespace
+
+bool TcParser::VerifyMessage(const Message& prototype, absl::string_view data) {
+  const char* ptr = data.data();
+  return VerifyFields(prototype, ptr, data.data() + data.size(), 0,
+                      io::CodedInputStream::GetDefaultRecursionLimit());
+}
+
+bool TcParser::VerifyFields(const Message& prototype, const char*& ptr,
+                            const char* end, uint32_t start_group_tag,
+                            int depth) {
+  const TcParseTableBase* table =
+      prototype.GetReflection()->GetTcParseTable();
+  const FieldEntry* field_entries = table->field_entries_begin();
+
+  // Presence of the field entries, only tracked if there are required fields
+  // to check once the message ends. Tables without field entries fall back to
+  // reflection and cannot tell required fields apart.
+  const Descriptor* descriptor = prototype.GetDescriptor();
+  bool has_required = false;
+  if (table->num_field_entries != 0) {
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+      if (descriptor->field(i)->is_required()) {
+        has_required = true;
+        break;
+      }
+    }
+  }
+  absl::InlinedVector<bool, 32> seen(
+      has_required ? table->num_field_entries : 0);
+
+  while (ptr != end || start_group_tag != 0) {
+    uint32_t tag;
+    if (!VerifyTag(ptr, end, &tag)) return false;
+    const uint32_t wiretype = tag & 7;
+    if (wiretype == WireFormatLite::WIRETYPE_END_GROUP) {
+      if (tag != start_group_tag + 1) return false;
+      break;
+    }
+    const FieldEntry* entry = FindFieldEntry(table, tag >> 3);
+    if (entry != nullptr &&
+        VerifyField(prototype, table, *entry, tag, ptr, end, depth)) {
+      if (has_required) seen[entry - field_entries] = true;
+      continue;
+    }
+    if (ptr == nullptr) return false;
+    // Unknown fields, and known ones with the wrong wire type, are kept as
+    // unknown fields by the parser.
+    if (!VerifyUnknownField(tag, ptr, end, depth)) return false;
+    // Reflection tables leave closed enums to the fallback, which does set
+    // them from varints.
+    if (has_required && entry != nullptr &&
+        (entry->type_card & field_layout::kFkMask) == field_layout::kFkNone &&
+        wiretype == WireFormatLite::WIRETYPE_VARINT) {
+      seen[entry - field_entries] = true;
+    }
+  }
+
+  if (has_required) {
+    for (int i = 0; i < descriptor->field_count(); ++i) {
+      const FieldDescriptor* field = descriptor->field(i);
+      if (!field->is_required()) continue;
+      const FieldEntry* entry = FindFieldEntry(table, field->number());
+      if (entry == nullptr || !seen[entry - field_entries]) return false;
+    }
+  }
+  return true;
+}
+
+// Verifies one occurrence of a field described by `entry`. Returns false
+// without consuming anything if the wire type does not match the field, and
+// sets `ptr` to nullptr if the field is malformed.
+bool TcParser::VerifyField(const Message& prototype,
+                           const TcParseTableBase* table,
+                           const FieldEntry& entry, uint32_t tag,
+                           const char*& ptr, const char* end, int depth) {
+  const uint16_t type_card = entry.type_card;
+  const uint16_t card = type_card & field_layout::kFcMask;
+  const uint16_t rep = type_card & field_layout::kRepMask;
+  const uint32_t wiretype = tag & 7;
+  const bool packed_wiretype =
+      wiretype == WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+  const char* payload;
+
+  switch (type_card & field_layout::kFkMask) {
+    case field_layout::kFkVarint:
+    case field_layout::kFkPackedVarint: {
+      if (wiretype == WireFormatLite::WIRETYPE_VARINT) {
+        uint64_t value;
+        if (VerifyVarint(ptr, end, &value)) return true;
+      } else if (packed_wiretype && card == field_layout::kFcRepeated) {
+        if (VerifyLength(ptr, end, &payload) &&
+            VerifyPackedVarints(payload, ptr)) {
+          return true;
+        }
+      } else {
+        return false;
+      }
+      break;
+    }
+    case field_layout::kFkFixed:
+    case field_layout::kFkPackedFixed: {
+      const int size = rep == field_layout::kRep64Bits ? 8 : 4;
+      const uint32_t fixed_wiretype = rep == field_layout::kRep64Bits
+                                          ? WireFormatLite::WIRETYPE_FIXED64
+                                          : WireFormatLite::WIRETYPE_FIXED32;
+      if (wiretype == fixed_wiretype) {
+        if (VerifyFixed(ptr, end, size)) return true;
+      } else if (packed_wiretype && card == field_layout::kFcRepeated) {
+        if (VerifyLength(ptr, end, &payload) && (ptr - payload) % size == 0) {
+          return true;
+        }
+      } else {
+        return false;
+      }
+      break;
+    }
+    case field_layout::kFkString: {
+      if (!packed_wiretype) return false;
+      if (VerifyLength(ptr, end, &payload) &&
+          ((type_card & field_layout::kTvMask) != field_layout::kTvUtf8 ||
+           utf8_range::IsStructurallyValid(
+               absl::string_view(payload, ptr - payload)))) {
+        return true;
+      }
+      break;
+    }
+    case field_layout::kFkMessage:
+    case field_layout::kFkMap: {
+      const bool is_group = (type_card & field_layout::kFkMask) ==
+                                field_layout::kFkMessage &&
+                            rep == field_layout::kRepGroup;
+      if (wiretype != (is_group ? WireFormatLite::WIRETYPE_START_GROUP
+                                : WireFormatLite::WIRETYPE_LENGTH_DELIMITED)) {
+        return false;
+      }
+      const Message* sub_prototype = nullptr;
+      if ((type_card & field_layout::kFkMask) == field_layout::kFkMessage &&
+          rep != field_layout::kRepLazy) {
+        const auto* aux = table->field_aux(&entry);
+        switch (type_card & field_layout::kTvMask) {
+          case field_layout::kTvTable:
+            sub_prototype =
+                DownCast<const Message*>(aux->table->default_instance);
+            break;
+          case field_layout::kTvDefault:
+            sub_prototype = DownCast<const Message*>(aux->message_default());
+            break;
+          case field_layout::kTvWeakPtr:
+            sub_prototype =
+                DownCast<const Message*>(aux->message_default_weak());
+            break;
+        }
+      }
+      if (sub_prototype == nullptr) {
+        // Map entries and lazy fields have no prototype in the table.
+        sub_prototype = SubmessagePrototype(prototype, tag >> 3);
+        if (sub_prototype == nullptr) return false;
+      }
+      if (--depth < 0) break;
+      if (is_group) {
+        if (VerifyFields(*sub_prototype, ptr, end, tag, depth)) return true;
+      } else if (VerifyLength(ptr, end, &payload) &&
+                 VerifyFields(*sub_prototype, payload, ptr, 0, depth)) {
+        return true;
+      }
+      break;
+    }
+    default:
+      return false;
+  }
+  ptr = nullptr;
+  return false;
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
@@ -379,7 +379,21 @@ std::vector<TailCallTableInfo::FastFieldInfo> SplitFastFieldsForSize(
     info.nonfield_info = *end_group_tag;
   }
 
+  // When several fields map to the same slot, the most frequently present one
+  // gets it. Without a profile all fields tie and the lowest number wins.
+  std::vector<std::pair<float, const TailCallTableInfo::FieldEntryInfo*>>
+      entries_by_hotness;
+  entries_by_hotness.reserve(field_entries.size());
   for (const auto& entry : field_entries) {
+    entries_by_hotness.emplace_back(
+        option_provider.GetForField(entry.field).presence_probability, &entry);
+  }
+  std::stable_sort(
+      entries_by_hotness.begin(), entries_by_hotness.end(),
+      [](const auto& a, const auto& b) { return a.first > b.first; });
+
+  for (const auto& hot_entry : entries_by_hotness) {
+    const auto& entry = *hot_entry.second;
     if (!IsFieldEligibleForFastParsing(entry, option_provider)) {
       continue;
     }
@@ -759,6 +773,19 @@ TailCallTableInfo::TailCallTableInfo(
     auto& entry = field_entries.back();
     entry.type_card = MakeTypeCardForField(field, options);
 
+    if (field->is_required()) {
+      // Only required has-bits in the first word can be checked cheaply at the
+      // end of the parse.
+      if (entry.hasbit_idx >= 0 && entry.hasbit_idx < 32) {
+        required_fields_mask |= uint32_t{1} << entry.hasbit_idx;
+      } else {
+        tracks_required_fields = false;
+      }
+    }
+    // Lazy submessages keep their bytes unparsed, so nothing below them is
+    // tracked.
+    if (HasLazyRep(field, options)) tracks_required_fields = false;
+
     if (field->type() == FieldDescriptor::TYPE_MESSAGE ||
         field->type() == FieldDescriptor::TYPE_GROUP) {
       // Message-typed fields have a FieldAux with the default instance pointer.
@@ -840,22 +867,26 @@ TailCallTableInfo::TailCallTableInfo(
   }
 
   table_size_log2 = 0;  // fallback value
-  int num_fast_fields = -1;
+  double fast_fields_weight = -1;
   auto end_group_tag = GetEndGroupTag(descriptor);
   for (int try_size_log2 : {0, 1, 2, 3, 4, 5}) {
     size_t try_size = 1 << try_size_log2;
     auto split_fields = SplitFastFieldsForSize(end_group_tag, field_entries,
                                                try_size_log2, option_provider);
     ABSL_CHECK_EQ(split_fields.size(), try_size);
-    int try_num_fast_fields = 0;
+    // Each covered field counts by how often it is present, so without a
+    // profile this is the number of fields covered.
+    double try_fast_fields_weight = 0;
     for (const auto& info : split_fields) {
-      if (info.field != nullptr) ++try_num_fast_fields;
+      if (info.field == nullptr) continue;
+      try_fast_fields_weight +=
+          option_provider.GetForField(info.field).presence_probability;
     }
-    // Use this size if (and only if) it covers more fields.
-    if (try_num_fast_fields > num_fast_fields) {
+    // Use this size if (and only if) it covers more (or hotter) fields.
+    if (try_fast_fields_weight > fast_fields_weight) {
       fast_path_fields = std::move(split_fields);
       table_size_log2 = try_size_log2;
-      num_fast_fields = try_num_fast_fields;
+      fast_fields_weight = try_fast_fields_weight;
     }
     // The largest table we allow has the same number of entries as the
     // message has fields, rounded up to the next power of 2 (e.g., a message
@@ -65,6 +65,9 @@ struct PROTOBUF_EXPORT TailCallTableInfo {
     bool is_lite;
     bool should_split;
     bool uses_codegen;
+    // How likely the field is to be present in a parsed message, from 0 to 1.
+    // Hotter fields win fast-path slots over colder ones.
+    float presence_probability;
   };
   class OptionProvider {
    public:
@@ -158,6 +161,11 @@ struct PROTOBUF_EXPORT TailCallTableInfo {
 
   // Table size.
   int table_size_log2;
+
+  // Has-bits of the required fields. See TcParseTableBase for when the parser
+  // can track them.
+  uint32_t required_fields_mask = 0;
+  bool tracks_required_fields = true;
 };
 
 }  // namespace internal
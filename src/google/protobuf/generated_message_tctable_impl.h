@@ -36,7 +36,9 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "absl/functional/function_ref.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/extension_set.h"
 #include "google/protobuf/generated_message_tctable_decl.h"
@@ -378,6 +380,28 @@ inline void AlignFail(std::integral_constant<size_t, 1>,
 enum class TcParseFunction { kNone, PROTOBUF_TC_PARSE_FUNCTION_LIST };
 #undef PROTOBUF_TC_PARSE_FUNCTION_X
 
+// Per-field counts of how TcParser handled the fields it parsed, collected
+// only when the runtime is built with PROTOBUF_TC_PARSER_STATS defined.
+struct TcParserFieldStats {
+  std::string message_name;
+  uint32_t field_number;
+  // Parsed by a fast-path table entry.
+  uint64_t fast_path;
+  // Parsed by a mini-parse routine after missing the fast table.
+  uint64_t mini_parse;
+  // Handed to the table's fallback: extensions, unknown fields, and fields
+  // the mini-parse routines do not handle.
+  uint64_t fallback;
+  // The subset of `fallback` for fields the message does not declare.
+  // Messages with extension ranges only count `fallback`.
+  uint64_t unknown;
+};
+
+// Returns the counts collected so far, or nothing if the runtime was built
+// without PROTOBUF_TC_PARSER_STATS.
+PROTOBUF_EXPORT std::vector<TcParserFieldStats> GetTcParserStats();
+PROTOBUF_EXPORT void ResetTcParserStats();
+
 // TcParser implements most of the parsing logic for tailcall tables.
 class PROTOBUF_EXPORT TcParser final {
  public:
@@ -632,7 +656,8 @@ class PROTOBUF_EXPORT TcParser final {
   template <typename MapField>
   static constexpr MapAuxInfo GetMapAuxInfo(bool fail_on_utf8_failure,
                                             bool log_debug_utf8_failure,
-                                            bool validated_enum_value) {
+                                            bool validated_enum_value,
+                                            bool value_has_required_fields) {
     using MapType = typename MapField::MapType;
     using Node = typename MapType::Node;
     static_assert(alignof(Node) == alignof(NodeBase), "");
@@ -646,6 +671,7 @@ class PROTOBUF_EXPORT TcParser final {
         fail_on_utf8_failure,
         log_debug_utf8_failure,
         validated_enum_value,
+        value_has_required_fields,
         Node::size_info(),
     };
   }
@@ -655,7 +681,71 @@ class PROTOBUF_EXPORT TcParser final {
     Arena::CreateInArenaStorage(static_cast<T*>(p), arena);
   }
 
+  // Table-driven serialization:
+  //
+  // Writes the fields described by `table` in field number order, producing
+  // the same bytes as a generated `_InternalSerialize`. Extensions and unknown
+  // fields are left to the caller. Messages generated with the
+  // `table_driven_serialization` option call this instead of serializing each
+  // field inline; the generator only does so when every field is supported,
+  // i.e. there are no map, lazy, split or weak fields.
+  static uint8_t* SerializeFields(const MessageLite* msg,
+                                  const TcParseTableBase* table,
+                                  uint8_t* target,
+                                  io::EpsCopyOutputStream* stream);
+
+  // Returns the number of bytes SerializeFields() writes, and updates the
+  // cached sizes of the submessages as it goes.  Messages generated with the
+  // `table_driven_methods` option call this from ByteSizeLong().
+  static size_t ByteSizeFields(const MessageLite* msg,
+                               const TcParseTableBase* table);
+
+  // Clears the fields described by `table` that are not in a oneof.  Has-bits,
+  // oneofs and unknown fields are left to the caller, which must clear the
+  // has-bits afterwards.  Scalars are reset to the value in the default
+  // instance; strings and cords must have empty defaults, and must not be
+  // inlined.  Messages generated with the `table_driven_methods` option call
+  // this from Clear().
+  static void ClearFields(MessageLite* msg, const TcParseTableBase* table);
+
+  // Returns the memory used by the fields described by `table`, not counting
+  // `msg` itself, its extensions or its unknown fields.  Each submessage is
+  // measured, object included, by `submessage_space_used`.  With `on_arena`,
+  // only memory taken from the message's arena is counted: the heap buffers
+  // of strings and cords are left out.
+  // Reflection::SpaceUsedLong() calls this for the tables it builds when
+  // CanSpaceUsedFields() allows it.
+  using SpaceUsedFunc = size_t (*)(const MessageLite& msg, bool on_arena);
+  static size_t SpaceUsedFields(const MessageLite* msg,
+                                const TcParseTableBase* table, bool on_arena,
+                                SpaceUsedFunc submessage_space_used);
+  // Returns false if `table` has a field SpaceUsedFields() and
+  // VisitSubmessages() cannot handle: a map, lazy, split or unsupported field.
+  static bool CanSpaceUsedFields(const TcParseTableBase* table);
+
+  // Calls `visit` on each submessage held by the fields described by `table`:
+  // present singular and oneof message fields, and every element of repeated
+  // message fields.  Stops at, and returns false for, the first call that
+  // returns false.  ReflectionOps uses this for the reflection parse tables
+  // that CanSpaceUsedFields() allows.
+  static bool VisitSubmessages(MessageLite* msg, const TcParseTableBase* table,
+                               absl::FunctionRef<bool(MessageLite&)> visit);
+
+  // Implements Message::VerifyFromString(), walking `data` against the
+  // reflection parse tables of `prototype` and its submessages.  Defined in
+  // the full runtime.
+  static bool VerifyMessage(const Message& prototype, absl::string_view data);
+
  private:
+  static bool VerifyFields(const Message& prototype, const char*& ptr,
+                           const char* end, uint32_t start_group_tag,
+                           int depth);
+  static bool VerifyField(const Message& prototype,
+                          const TcParseTableBase* table,
+                          const TcParseTableBase::FieldEntry& entry,
+                          uint32_t tag, const char*& ptr, const char* end,
+                          int depth);
+
   // Optimized small tag varint parser for int32/int64
   template <typename FieldType>
   static const char* FastVarintS1(PROTOBUF_TC_PARAM_DECL);
@@ -696,6 +786,18 @@ class PROTOBUF_EXPORT TcParser final {
     }
   }
 
+  // The body of ParseLoop, and its explicit-stack continuation for deeply
+  // nested messages (see ParseContext::DeferredMessage).
+  static inline const char* ParseFields(MessageLite* msg, const char* ptr,
+                                        ParseContext* ctx,
+                                        const TcParseTableBase* table);
+  static const char* ParseLoopWithStack(MessageLite* msg, const char* ptr,
+                                        ParseContext* ctx,
+                                        const TcParseTableBase* table);
+  static inline bool ArenaLimitExceeded(MessageLite* msg);
+  static inline void CheckRequiredFields(MessageLite* msg, ParseContext* ctx,
+                                         const TcParseTableBase* table);
+
   static const char* TagDispatch(PROTOBUF_TC_PARAM_NO_DATA_DECL);
   static const char* ToTagDispatch(PROTOBUF_TC_PARAM_NO_DATA_DECL);
   static const char* ToParseLoop(PROTOBUF_TC_PARAM_NO_DATA_DECL);
@@ -832,6 +934,48 @@ class PROTOBUF_EXPORT TcParser final {
                                       const TcParseTableBase::FieldEntry& entry,
                                       Arena* arena);
 
+  // Parse statistics, see TcParserFieldStats.
+  friend std::vector<TcParserFieldStats> GetTcParserStats();
+  enum class StatKind { kDispatch, kMiniParse, kFallback, kUnknown };
+  static void RecordStat(const TcParseTableBase* table, uint32_t field_number,
+                         StatKind kind);
+
+  // Table-driven serialization of a single field.
+  static uint8_t* SerializeField(const MessageLite* msg,
+                                 const TcParseTableBase* table,
+                                 const TcParseTableBase::FieldEntry& entry,
+                                 uint32_t field_num, uint8_t* target,
+                                 io::EpsCopyOutputStream* stream);
+  static uint8_t* SerializeRepeatedField(
+      const MessageLite* msg, const TcParseTableBase* table,
+      const TcParseTableBase::FieldEntry& entry, uint32_t field_num,
+      uint8_t* target, io::EpsCopyOutputStream* stream);
+
+  // Table-driven ByteSizeLong() and Clear() of a single field.
+  static size_t ByteSizeField(const MessageLite* msg,
+                              const TcParseTableBase* table,
+                              const TcParseTableBase::FieldEntry& entry,
+                              uint32_t field_num);
+  static size_t ByteSizeRepeatedField(const MessageLite* msg,
+                                      const TcParseTableBase* table,
+                                      const TcParseTableBase::FieldEntry& entry,
+                                      uint32_t field_num);
+  static void ClearField(MessageLite* msg, const TcParseTableBase* table,
+                         const TcParseTableBase::FieldEntry& entry);
+  static size_t SpaceUsedField(const MessageLite* msg,
+                               const TcParseTableBase* table,
+                               const TcParseTableBase::FieldEntry& entry,
+                               uint32_t field_num, bool on_arena,
+                               SpaceUsedFunc submessage_space_used);
+  static size_t SpaceUsedRepeatedField(
+      const MessageLite* msg, const TcParseTableBase::FieldEntry& entry,
+      bool on_arena, SpaceUsedFunc submessage_space_used);
+  // Like RepeatedPtrFieldBase::SpaceUsedExcludingSelfLong(), with
+  // `element_space_used` measuring each allocated element.
+  template <typename F>
+  static size_t RepeatedPtrSpaceUsed(const RepeatedPtrFieldBase& field,
+                                     F element_space_used);
+
   // Mini field lookup:
   static const TcParseTableBase::FieldEntry* FindFieldEntry(
       const TcParseTableBase* table, uint32_t field_num);
@@ -890,6 +1034,12 @@ inline PROTOBUF_ALWAYS_INLINE const char* TcParser::TagDispatch(
   auto* fast_entry = table->fast_entry(idx >> 3);
   TcFieldData data = fast_entry->bits;
   data.data ^= coded_tag;
+#ifdef PROTOBUF_TC_PARSER_STATS
+  uint32_t tag;
+  if (ReadTag(ptr, &tag) != nullptr) {
+    RecordStat(table, tag >> 3, StatKind::kDispatch);
+  }
+#endif  // PROTOBUF_TC_PARSER_STATS
   PROTOBUF_MUSTTAIL return fast_entry->target()(PROTOBUF_TC_PARAM_PASS);
 }
 
@@ -28,12 +28,24 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <cstdint>
+#include <limits>
 #include <numeric>
 #include <string>
 #include <type_traits>
 #include <utility>
-
+#include <vector>
+
+#include "absl/base/attributes.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/absl_log.h"
+#include "absl/numeric/bits.h"
+#include "absl/strings/cord.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/generated_message_tctable_decl.h"
 #include "google/protobuf/generated_message_tctable_impl.h"
 #include "google/protobuf/inlined_string_field.h"
@@ -83,7 +95,7 @@ const char* TcParser::GenericFallbackLite(PROTOBUF_TC_PARAM_DECL) {
 // Core fast parsing implementation:
 //////////////////////////////////////////////////////////////////////////////
 
-PROTOBUF_NOINLINE const char* TcParser::ParseLoop(
+inline PROTOBUF_ALWAYS_INLINE const char* TcParser::ParseFields(
     MessageLite* msg, const char* ptr, ParseContext* ctx,
     const TcParseTableBase* table) {
   // Note: TagDispatch uses a dispatch table at "&table->fast_entries".
@@ -108,6 +120,145 @@ PROTOBUF_NOINLINE const char* TcParser::ParseLoop(
   return ptr;
 }
 
+// Fail the parse once the arena went over its ArenaOptions::max_total_bytes.
+inline bool TcParser::ArenaLimitExceeded(MessageLite* msg) {
+  Arena* arena = msg->GetArenaForAllocation();
+  return PROTOBUF_PREDICT_FALSE(arena != nullptr &&
+                                arena->impl_.max_total_bytes_exceeded());
+}
+
+// Records on `ctx` if `msg`, whose fields were just parsed, may be missing
+// required fields. Submessages do this themselves when they end.
+inline void TcParser::CheckRequiredFields(MessageLite* msg, ParseContext* ctx,
+                                          const TcParseTableBase* table) {
+  const uint32_t mask = table->required_fields_mask;
+  if (PROTOBUF_PREDICT_TRUE(table->tracks_required_fields && mask == 0)) return;
+  if (!table->tracks_required_fields ||
+      (RefAt<uint32_t>(msg, table->has_bits_offset) & mask) != mask) {
+    ctx->SetMaybeUninitialized();
+  }
+}
+
+PROTOBUF_NOINLINE const char* TcParser::ParseLoop(
+    MessageLite* msg, const char* ptr, ParseContext* ctx,
+    const TcParseTableBase* table) {
+  ptr = ParseFields(msg, ptr, ctx, table);
+  if (PROTOBUF_PREDICT_FALSE(ptr != nullptr && ctx->HasDeferredMessage())) {
+    return ParseLoopWithStack(msg, ptr, ctx, table);
+  }
+  if (ArenaLimitExceeded(msg)) return nullptr;
+  if (ptr != nullptr) CheckRequiredFields(msg, ctx, table);
+  return ptr;
+}
+
+// Continues ParseLoop once a field handler deferred a submessage (see
+// ParseContext::DeferredMessage). Suspended parents are kept on `stack`, so
+// nesting below this point costs heap memory instead of native stack.
+PROTOBUF_NOINLINE const char* TcParser::ParseLoopWithStack(
+    MessageLite* msg, const char* ptr, ParseContext* ctx,
+    const TcParseTableBase* table) {
+  struct Frame {
+    MessageLite* msg;
+    const TcParseTableBase* table;
+    // How to leave the submessage that was entered from this frame.
+    ParseContext::DeferredMessage::End end;
+  };
+  std::vector<Frame> stack;
+  while (true) {
+    if (ptr != nullptr && ctx->HasDeferredMessage()) {
+      // Suspend `msg` and descend into the submessage.
+      ParseContext::DeferredMessage deferred = ctx->TakeDeferredMessage();
+      stack.push_back({msg, table, std::move(deferred.end)});
+      msg = deferred.msg;
+      table = deferred.table;
+    } else {
+      // `msg` is complete, or the parse failed: resume the parent. On failure
+      // we still unwind every frame to restore the context's limits.
+      if (ptr != nullptr && ArenaLimitExceeded(msg)) ptr = nullptr;
+      if (ptr != nullptr) CheckRequiredFields(msg, ctx, table);
+      if (stack.empty()) return ptr;
+      Frame& parent = stack.back();
+      ptr = ctx->EndDeferredMessage(ptr, std::move(parent.end));
+      msg = parent.msg;
+      table = parent.table;
+      stack.pop_back();
+      if (ptr == nullptr) continue;
+    }
+    ptr = ParseFields(msg, ptr, ctx, table);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Parse statistics:
+//////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+struct TcParserStatCounts {
+  std::string message_name;
+  uint64_t counts[4] = {};
+};
+
+struct TcParserStatsRegistry {
+  absl::Mutex mu;
+  absl::flat_hash_map<std::pair<const TcParseTableBase*, uint32_t>,
+                      TcParserStatCounts>
+      fields ABSL_GUARDED_BY(mu);
+};
+
+TcParserStatsRegistry& GetTcParserStatsRegistry() {
+  static auto* registry = new TcParserStatsRegistry;
+  return *registry;
+}
+
+}  // namespace
+
+void TcParser::RecordStat(const TcParseTableBase* table,
+                          uint32_t field_number, StatKind kind) {
+  // Names are copied out right away: tables of dynamic messages may go away
+  // before the counts are read.
+  TcParserStatsRegistry& registry = GetTcParserStatsRegistry();
+  absl::MutexLock lock(&registry.mu);
+  auto it = registry.fields.find({table, field_number});
+  if (it == registry.fields.end()) {
+    it = registry.fields.try_emplace({table, field_number}).first;
+    it->second.message_name = std::string(MessageName(table));
+  }
+  ++it->second.counts[static_cast<int>(kind)];
+}
+
+std::vector<TcParserFieldStats> GetTcParserStats() {
+  std::vector<TcParserFieldStats> result;
+#ifdef PROTOBUF_TC_PARSER_STATS
+  TcParserStatsRegistry& registry = GetTcParserStatsRegistry();
+  absl::MutexLock lock(&registry.mu);
+  result.reserve(registry.fields.size());
+  for (const auto& field : registry.fields) {
+    const uint64_t* counts = field.second.counts;
+    TcParserFieldStats stats;
+    stats.message_name = field.second.message_name;
+    stats.field_number = field.first.second;
+    stats.mini_parse = counts[static_cast<int>(TcParser::StatKind::kMiniParse)];
+    stats.fallback = counts[static_cast<int>(TcParser::StatKind::kFallback)];
+    stats.unknown = counts[static_cast<int>(TcParser::StatKind::kUnknown)];
+    // Everything dispatched through the fast table that did not end up in a
+    // mini-parse routine or the fallback was handled by the fast path.
+    const uint64_t dispatched =
+        counts[static_cast<int>(TcParser::StatKind::kDispatch)];
+    const uint64_t slow = stats.mini_parse + stats.fallback;
+    stats.fast_path = dispatched > slow ? dispatched - slow : 0;
+    result.push_back(std::move(stats));
+  }
+#endif  // PROTOBUF_TC_PARSER_STATS
+  return result;
+}
+
+void ResetTcParserStats() {
+  TcParserStatsRegistry& registry = GetTcParserStatsRegistry();
+  absl::MutexLock lock(&registry.mu);
+  registry.fields.clear();
+}
+
 // On the fast path, a (matching) 1-byte tag already has the decoded value.
 static uint32_t FastDecodeTag(uint8_t coded_tag) {
   return coded_tag;
@@ -293,6 +444,16 @@ inline PROTOBUF_ALWAYS_INLINE const char* TcParser::MiniParse(
   }
 
   auto* entry = FindFieldEntry(table, tag >> 3);
+#ifdef PROTOBUF_TC_PARSER_STATS
+  if (entry == nullptr && table->extension_offset == 0) {
+    RecordStat(table, tag >> 3, StatKind::kUnknown);
+  }
+  RecordStat(table, tag >> 3,
+             entry == nullptr || (entry->type_card & field_layout::kFkMask) ==
+                                     field_layout::kFkNone
+                 ? StatKind::kFallback
+                 : StatKind::kMiniParse);
+#endif  // PROTOBUF_TC_PARSER_STATS
   if (entry == nullptr) {
     if (export_called_function) *test_out = {table->fallback, tag};
     data.data = tag;
@@ -428,10 +589,10 @@ inline PROTOBUF_ALWAYS_INLINE const char* TcParser::SingularParseMessageAuxImpl(
       field = inner_table->default_instance->New(msg->GetArenaForAllocation());
     }
     if (group_coding) {
-      return ctx->ParseGroup<TcParser>(field, ptr, FastDecodeTag(saved_tag),
-                                       inner_table);
+      return ctx->ParseGroupOrDefer<TcParser>(
+          field, ptr, FastDecodeTag(saved_tag), inner_table);
     }
-    return ctx->ParseMessage<TcParser>(field, ptr, inner_table);
+    return ctx->ParseMessageOrDefer<TcParser>(field, ptr, inner_table);
   } else {
     if (field == nullptr) {
       const MessageLite* default_instance =
@@ -512,12 +673,13 @@ inline PROTOBUF_ALWAYS_INLINE const char* TcParser::RepeatedParseMessageAuxImpl(
     ptr += sizeof(TagType);
     MessageLite* submsg = field.Add<GenericTypeHandler<MessageLite>>(
         aux_is_table ? aux.table->default_instance : aux.message_default());
+    field.PrefetchNextCleared();
     if (aux_is_table) {
       if (group_coding) {
-        ptr = ctx->ParseGroup<TcParser>(submsg, ptr,
-                                        FastDecodeTag(expected_tag), aux.table);
+        ptr = ctx->ParseGroupOrDefer<TcParser>(
+            submsg, ptr, FastDecodeTag(expected_tag), aux.table);
       } else {
-        ptr = ctx->ParseMessage<TcParser>(submsg, ptr, aux.table);
+        ptr = ctx->ParseMessageOrDefer<TcParser>(submsg, ptr, aux.table);
       }
     } else {
       if (group_coding) {
@@ -529,7 +691,9 @@ inline PROTOBUF_ALWAYS_INLINE const char* TcParser::RepeatedParseMessageAuxImpl(
     if (PROTOBUF_PREDICT_FALSE(ptr == nullptr)) {
       PROTOBUF_MUSTTAIL return Error(PROTOBUF_TC_PARAM_NO_DATA_PASS);
     }
-    if (PROTOBUF_PREDICT_FALSE(!ctx->DataAvailable(ptr))) {
+    // A deferred element is parsed by the loop before we may go on.
+    if (PROTOBUF_PREDICT_FALSE(!ctx->DataAvailable(ptr) ||
+                               (aux_is_table && ctx->HasDeferredMessage()))) {
       PROTOBUF_MUSTTAIL return ToParseLoop(PROTOBUF_TC_PARAM_NO_DATA_PASS);
     }
   } while (UnalignedLoad<TagType>(ptr) == expected_tag);
@@ -804,6 +968,80 @@ bool EnumIsValidAux(int32_t val, uint16_t xform_val,
   return aux.enum_validator(val);
 }
 
+// Returns whether every value in `[values, values + n)` lies in the enum range
+// `[start, start + length)`.  A value is in range iff `value - start`, taken as
+// unsigned, is below `length`, so a whole block reduces to one OR of compares.
+inline bool AllInEnumRange(const int32_t* values, int n, int16_t start,
+                           uint16_t length) {
+  if (length == 0) return n == 0;
+  const uint32_t last = uint32_t{length} - 1;
+  int i = 0;
+#if defined(__SSE2__)
+  // SSE2 has no unsigned compare; compare biased values as signed instead.
+  const __m128i bias = _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+  const __m128i start_v = _mm_set1_epi32(start);
+  const __m128i last_v = _mm_xor_si128(_mm_set1_epi32(last), bias);
+  __m128i invalid = _mm_setzero_si128();
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+    x = _mm_xor_si128(_mm_sub_epi32(x, start_v), bias);
+    invalid = _mm_or_si128(invalid, _mm_cmpgt_epi32(x, last_v));
+  }
+  if (_mm_movemask_epi8(invalid) != 0) return false;
+#endif
+  uint32_t out_of_range = 0;
+  for (; i < n; ++i) {
+    out_of_range |= static_cast<uint32_t>(values[i]) -
+                        static_cast<uint32_t>(int32_t{start}) >
+                    last;
+  }
+  return out_of_range == 0;
+}
+
+// Buffers decoded values of a packed, range-validated enum and validates them
+// a block at a time.  A block that is entirely in range is appended in one go;
+// otherwise it is replayed value by value, handing invalid ones to `unknown`.
+template <typename T>
+class PackedEnumRangeBatch {
+ public:
+  static constexpr int kBlockSize = 32;
+
+  PackedEnumRangeBatch(RepeatedField<T>* field, TcParseTableBase::FieldAux aux)
+      : field_(field), aux_(aux) {}
+
+  int size() const { return size_; }
+
+  template <typename Unknown>
+  void Add(int32_t value, Unknown unknown) {
+    values_[size_++] = value;
+    if (PROTOBUF_PREDICT_FALSE(size_ == kBlockSize)) Flush(unknown);
+  }
+
+  template <typename Unknown>
+  void Flush(Unknown unknown) {
+    if (PROTOBUF_PREDICT_TRUE(AllInEnumRange(values_, size_,
+                                             aux_.enum_range.start,
+                                             aux_.enum_range.length))) {
+      field_->Add(values_, values_ + size_);
+    } else {
+      for (int i = 0; i < size_; ++i) {
+        if (EnumIsValidAux(values_[i], field_layout::kTvRange, aux_)) {
+          field_->Add(values_[i]);
+        } else {
+          unknown(values_[i]);
+        }
+      }
+    }
+    size_ = 0;
+  }
+
+ private:
+  RepeatedField<T>* field_;
+  TcParseTableBase::FieldAux aux_;
+  int size_ = 0;
+  int32_t values_[kBlockSize];
+};
+
 }  // namespace
 
 template <typename FieldType, typename TagType, bool zigzag>
@@ -1037,19 +1275,22 @@ const char* TcParser::PackedVarint(PROTOBUF_TC_PARAM_DECL) {
   // pending hasbits now:
   SyncHasbits(msg, hasbits, table);
   auto* field = &RefAt<RepeatedField<FieldType>>(msg, data.offset());
-  return ctx->ReadPackedVarint(ptr, [field](uint64_t varint) {
-    FieldType val;
-    if (zigzag) {
-      if (sizeof(FieldType) == 8) {
-        val = WireFormatLite::ZigZagDecode64(varint);
-      } else {
-        val = WireFormatLite::ZigZagDecode32(varint);
-      }
-    } else {
-      val = varint;
-    }
-    field->Add(val);
-  });
+  return ctx->ReadPackedVarint(
+      ptr,
+      [field](uint64_t varint) {
+        FieldType val;
+        if (zigzag) {
+          if (sizeof(FieldType) == 8) {
+            val = WireFormatLite::ZigZagDecode64(varint);
+          } else {
+            val = WireFormatLite::ZigZagDecode32(varint);
+          }
+        } else {
+          val = varint;
+        }
+        field->Add(val);
+      },
+      [field](int n) { field->Reserve(field->size() + n); });
 }
 
 PROTOBUF_NOINLINE const char* TcParser::FastV8P1(PROTOBUF_TC_PARAM_DECL) {
@@ -1242,6 +1483,17 @@ const char* TcParser::PackedEnum(PROTOBUF_TC_PARAM_DECL) {
   SyncHasbits(msg, hasbits, table);
   auto* field = &RefAt<RepeatedField<int32_t>>(msg, data.offset());
   const TcParseTableBase::FieldAux aux = *table->field_aux(data.aux_idx());
+  if (xform_val == field_layout::kTvRange) {
+    PackedEnumRangeBatch<int32_t> batch(field, aux);
+    auto unknown = [=](int32_t value) {
+      AddUnknownEnum(msg, table, FastDecodeTag(saved_tag), value);
+    };
+    ptr = ctx->ReadPackedVarint(
+        ptr, [&](int32_t value) { batch.Add(value, unknown); },
+        [&](int n) { field->Reserve(field->size() + batch.size() + n); });
+    batch.Flush(unknown);
+    return ptr;
+  }
   return ctx->ReadPackedVarint(ptr, [=](int32_t value) {
     if (!EnumIsValidAux(value, xform_val, aux)) {
       AddUnknownEnum(msg, table, FastDecodeTag(saved_tag), value);
@@ -1459,6 +1711,23 @@ PROTOBUF_ALWAYS_INLINE inline bool IsValidUTF8(ArenaStringPtr& field) {
   return utf8_range::IsStructurallyValid(field.Get());
 }
 
+enum class Utf8Check { kUnchecked, kValid, kInvalid };
+
+// Validates the payload of the length-delimited field at `ptr` in the input
+// buffer, where it is hot in cache, instead of re-reading the copy after it was
+// parsed. Payloads that continue past the current buffer are left unchecked,
+// and the caller validates the copy as before.
+PROTOBUF_ALWAYS_INLINE inline Utf8Check CheckUtf8InBuffer(const char* ptr,
+                                                          ParseContext* ctx) {
+  int size = ReadSize(&ptr);
+  if (ptr == nullptr || size > ctx->MaximumReadSize(ptr)) {
+    return Utf8Check::kUnchecked;
+  }
+  return utf8_range::IsStructurallyValid(absl::string_view(ptr, size))
+             ? Utf8Check::kValid
+             : Utf8Check::kInvalid;
+}
+
 
 }  // namespace
 
@@ -1472,6 +1741,13 @@ PROTOBUF_ALWAYS_INLINE const char* TcParser::SingularString(
   ptr += sizeof(TagType);
   hasbits |= (uint64_t{1} << data.hasbit_idx());
   auto& field = RefAt<FieldType>(msg, data.offset());
+#ifdef NDEBUG
+  constexpr bool kValidateUtf8 = utf8 == kUtf8;
+#else
+  constexpr bool kValidateUtf8 = utf8 != kNoUtf8;
+#endif
+  const Utf8Check utf8_check =
+      kValidateUtf8 ? CheckUtf8InBuffer(ptr, ctx) : Utf8Check::kUnchecked;
   auto arena = msg->GetArenaForAllocation();
   if (arena) {
     ptr =
@@ -1489,7 +1765,9 @@ PROTOBUF_ALWAYS_INLINE const char* TcParser::SingularString(
 #endif
       PROTOBUF_MUSTTAIL return ToParseLoop(PROTOBUF_TC_PARAM_NO_DATA_PASS);
     default:
-      if (PROTOBUF_PREDICT_TRUE(IsValidUTF8(field))) {
+      if (PROTOBUF_PREDICT_TRUE(utf8_check == Utf8Check::kUnchecked
+                                    ? IsValidUTF8(field)
+                                    : utf8_check == Utf8Check::kValid)) {
         PROTOBUF_MUSTTAIL return ToParseLoop(PROTOBUF_TC_PARAM_NO_DATA_PASS);
       }
       ReportFastUtf8Error(FastDecodeTag(saved_tag), table);
@@ -1577,7 +1855,16 @@ PROTOBUF_ALWAYS_INLINE const char* TcParser::RepeatedString(
   const auto expected_tag = UnalignedLoad<TagType>(ptr);
   auto& field = RefAt<FieldType>(msg, data.offset());
 
-  const auto validate_last_string = [expected_tag, table, &field] {
+#ifdef NDEBUG
+  constexpr bool kValidateUtf8 = utf8 == kUtf8;
+#else
+  constexpr bool kValidateUtf8 = utf8 != kNoUtf8;
+#endif
+  const auto check_next_string = [ctx](const char* p) {
+    return kValidateUtf8 ? CheckUtf8InBuffer(p, ctx) : Utf8Check::kUnchecked;
+  };
+  const auto validate_last_string = [expected_tag, table,
+                                     &field](Utf8Check check) {
     switch (utf8) {
       case kNoUtf8:
 #ifdef NDEBUG
@@ -1586,7 +1873,9 @@ PROTOBUF_ALWAYS_INLINE const char* TcParser::RepeatedString(
         return true;
       default:
         if (PROTOBUF_PREDICT_TRUE(
-                utf8_range::IsStructurallyValid(field[field.size() - 1]))) {
+                check == Utf8Check::kUnchecked
+                    ? utf8_range::IsStructurallyValid(field[field.size() - 1])
+                    : check == Utf8Check::kValid)) {
           return true;
         }
         ReportFastUtf8Error(FastDecodeTag(expected_tag), table);
@@ -1602,9 +1891,11 @@ PROTOBUF_ALWAYS_INLINE const char* TcParser::RepeatedString(
                             field.PrepareForParse())) {
     do {
       ptr += sizeof(TagType);
+      const Utf8Check check = check_next_string(ptr);
       ptr = ParseRepeatedStringOnce(ptr, arena, serial_arena, ctx, field);
 
-      if (PROTOBUF_PREDICT_FALSE(ptr == nullptr || !validate_last_string())) {
+      if (PROTOBUF_PREDICT_FALSE(ptr == nullptr ||
+                                 !validate_last_string(check))) {
         PROTOBUF_MUSTTAIL return Error(PROTOBUF_TC_PARAM_NO_DATA_PASS);
       }
       if (!ctx->DataAvailable(ptr)) break;
@@ -1612,9 +1903,11 @@ PROTOBUF_ALWAYS_INLINE const char* TcParser::RepeatedString(
   } else {
     do {
       ptr += sizeof(TagType);
+      const Utf8Check check = check_next_string(ptr);
       std::string* str = field.Add();
       ptr = InlineGreedyStringParser(str, ptr, ctx);
-      if (PROTOBUF_PREDICT_FALSE(ptr == nullptr || !validate_last_string())) {
+      if (PROTOBUF_PREDICT_FALSE(ptr == nullptr ||
+                                 !validate_last_string(check))) {
         PROTOBUF_MUSTTAIL return Error(PROTOBUF_TC_PARAM_NO_DATA_PASS);
       }
       if (!ctx->DataAvailable(ptr)) break;
@@ -2048,12 +2341,27 @@ PROTOBUF_NOINLINE const char* TcParser::MpPackedVarint(PROTOBUF_TC_PARAM_DECL) {
   uint16_t rep = type_card & field_layout::kRepMask;
   if (rep == field_layout::kRep64Bits) {
     auto* field = &RefAt<RepeatedField<uint64_t>>(msg, entry.offset);
-    return ctx->ReadPackedVarint(ptr, [field, is_zigzag](uint64_t value) {
-      field->Add(is_zigzag ? WireFormatLite::ZigZagDecode64(value) : value);
-    });
+    return ctx->ReadPackedVarint(
+        ptr,
+        [field, is_zigzag](uint64_t value) {
+          field->Add(is_zigzag ? WireFormatLite::ZigZagDecode64(value)
+                               : value);
+        },
+        [field](int n) { field->Reserve(field->size() + n); });
   } else if (rep == field_layout::kRep32Bits) {
     auto* field = &RefAt<RepeatedField<uint32_t>>(msg, entry.offset);
-    if (is_validated_enum) {
+    if (xform_val == field_layout::kTvRange) {
+      const TcParseTableBase::FieldAux aux = *table->field_aux(entry.aux_idx);
+      PackedEnumRangeBatch<uint32_t> batch(field, aux);
+      auto unknown = [=](int32_t value) {
+        AddUnknownEnum(msg, table, data.tag(), value);
+      };
+      ptr = ctx->ReadPackedVarint(
+          ptr, [&](int32_t value) { batch.Add(value, unknown); },
+          [&](int n) { field->Reserve(field->size() + batch.size() + n); });
+      batch.Flush(unknown);
+      return ptr;
+    } else if (is_validated_enum) {
       const TcParseTableBase::FieldAux aux = *table->field_aux(entry.aux_idx);
       return ctx->ReadPackedVarint(ptr, [=](int32_t value) {
         if (!EnumIsValidAux(value, xform_val, aux)) {
@@ -2063,17 +2371,21 @@ PROTOBUF_NOINLINE const char* TcParser::MpPackedVarint(PROTOBUF_TC_PARAM_DECL) {
         }
       });
     } else {
-      return ctx->ReadPackedVarint(ptr, [field, is_zigzag](uint64_t value) {
-        field->Add(is_zigzag ? WireFormatLite::ZigZagDecode32(
-                                   static_cast<uint32_t>(value))
-                             : value);
-      });
+      return ctx->ReadPackedVarint(
+          ptr,
+          [field, is_zigzag](uint64_t value) {
+            field->Add(is_zigzag ? WireFormatLite::ZigZagDecode32(
+                                       static_cast<uint32_t>(value))
+                                 : value);
+          },
+          [field](int n) { field->Reserve(field->size() + n); });
     }
   } else {
     ABSL_DCHECK_EQ(rep, static_cast<uint16_t>(field_layout::kRep8Bits));
     auto* field = &RefAt<RepeatedField<bool>>(msg, entry.offset);
     return ctx->ReadPackedVarint(
-        ptr, [field](uint64_t value) { field->Add(value); });
+        ptr, [field](uint64_t value) { field->Add(value); },
+        [field](int n) { field->Reserve(field->size() + n); });
   }
 
   PROTOBUF_MUSTTAIL return Error(PROTOBUF_TC_PARAM_NO_DATA_PASS);
@@ -2168,7 +2480,9 @@ PROTOBUF_NOINLINE const char* TcParser::MpString(PROTOBUF_TC_PARAM_DECL) {
       } else {
         field = &RefAt<absl::Cord>(base, entry.offset);
       }
-      ptr = InlineCordParser(field, ptr, ctx);
+      int size = ReadSize(&ptr);
+      if (ptr == nullptr) break;
+      ptr = ctx->ReadArenaCord(ptr, size, field, msg->GetArenaForAllocation());
       if (!ptr) break;
       is_valid = MpVerifyUtf8(*field, table, entry, xform_val);
       break;
@@ -2313,9 +2627,10 @@ PROTOBUF_NOINLINE const char* TcParser::MpMessage(PROTOBUF_TC_PARAM_DECL) {
       field = inner_table->default_instance->New(msg->GetArenaForAllocation());
     }
     if (is_group) {
-      return ctx->ParseGroup<TcParser>(field, ptr, decoded_tag, inner_table);
+      return ctx->ParseGroupOrDefer<TcParser>(field, ptr, decoded_tag,
+                                              inner_table);
     }
-    return ctx->ParseMessage<TcParser>(field, ptr, inner_table);
+    return ctx->ParseMessageOrDefer<TcParser>(field, ptr, inner_table);
   } else {
     if (need_init || field == nullptr) {
       const MessageLite* def;
@@ -2370,10 +2685,12 @@ const char* TcParser::MpRepeatedMessage(PROTOBUF_TC_PARAM_DECL) {
     auto* inner_table = aux.table;
     MessageLite* value = field.Add<GenericTypeHandler<MessageLite>>(
         inner_table->default_instance);
+    field.PrefetchNextCleared();
     if (is_group) {
-      return ctx->ParseGroup<TcParser>(value, ptr, decoded_tag, inner_table);
+      return ctx->ParseGroupOrDefer<TcParser>(value, ptr, decoded_tag,
+                                              inner_table);
     }
-    return ctx->ParseMessage<TcParser>(value, ptr, inner_table);
+    return ctx->ParseMessageOrDefer<TcParser>(value, ptr, inner_table);
   } else {
     const MessageLite* def;
     if ((type_card & field_layout::kTvMask) == field_layout::kTvDefault) {
@@ -2384,6 +2701,7 @@ const char* TcParser::MpRepeatedMessage(PROTOBUF_TC_PARAM_DECL) {
       def = aux.message_default_weak();
     }
     MessageLite* value = field.Add<GenericTypeHandler<MessageLite>>(def);
+    field.PrefetchNextCleared();
     if (is_group) {
       return ctx->ParseGroup(value, ptr, decoded_tag);
     }
@@ -2523,6 +2841,28 @@ const char* ReadFixed(void* obj, const char* ptr) {
   return ptr;
 }
 
+// Returns how many entries of a run of consecutive `tag` fields can already
+// be seen in the buffer. `ptr` points at the length of the first entry. Only
+// looks at the wire format, so duplicate keys are counted more than once.
+static int CountBufferedMapEntries(const char* ptr, ParseContext* ctx,
+                                   uint32_t tag) {
+  int count = 0;
+  while (true) {
+    const uint32_t size = ReadSize(&ptr);
+    if (ptr == nullptr ||
+        size > static_cast<uint32_t>(ctx->MaximumReadSize(ptr))) {
+      break;
+    }
+    ptr += size;
+    ++count;
+    if (!ctx->DataAvailable(ptr)) break;
+    uint32_t next_tag;
+    ptr = ReadTag(ptr, &next_tag);
+    if (ptr == nullptr || next_tag != tag) break;
+  }
+  return count;
+}
+
 const char* TcParser::ParseOneMapEntry(
     NodeBase* node, const char* ptr, ParseContext* ctx,
     const TcParseTableBase::FieldAux* aux, const TcParseTableBase* table,
@@ -2657,6 +2997,33 @@ PROTOBUF_NOINLINE const char* TcParser::MpMap(PROTOBUF_TC_PARAM_DECL) {
 
   const uint32_t saved_tag = data.tag();
 
+  // A value message checks its required fields when it is parsed, but an
+  // entry without a value leaves it default constructed.
+  if (map_info.value_has_required_fields) ctx->SetMaybeUninitialized();
+
+  // Size the table once for the entries that follow back to back, instead of
+  // rehashing every time it outgrows its load factor.
+  const int buffered_entries = CountBufferedMapEntries(ptr, ctx, saved_tag);
+  if (buffered_entries > 1) {
+    const size_t n = map.size() + buffered_entries;
+    switch (map_info.key_type_card.cpp_type()) {
+      case MapTypeCard::kBool:
+        // At most two elements; the minimum table size already fits them.
+        break;
+      case MapTypeCard::k32:
+        static_cast<KeyMapBase<uint32_t>&>(map).Reserve(n);
+        break;
+      case MapTypeCard::k64:
+        static_cast<KeyMapBase<uint64_t>&>(map).Reserve(n);
+        break;
+      case MapTypeCard::kString:
+        static_cast<KeyMapBase<std::string>&>(map).Reserve(n);
+        break;
+      default:
+        PROTOBUF_ASSUME(false);
+    }
+  }
+
   while (true) {
     NodeBase* node = map.AllocNode(map_info.node_size_info);
 
@@ -2726,6 +3093,759 @@ PROTOBUF_NOINLINE const char* TcParser::MpMap(PROTOBUF_TC_PARAM_DECL) {
   PROTOBUF_MUSTTAIL return ToTagDispatch(PROTOBUF_TC_PARAM_NO_DATA_PASS);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// Table-driven serialization
+//////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Calls `f(field_num, entry)` for each entry of `table`, in field number
+// order. The field numbers are recovered from the structure FindFieldEntry
+// searches: the clear bits of `skipmap32` for fields 1-32, followed by blocks
+// of 16-field skip maps that end with a 0xFFFFFFFF start.
+template <typename F>
+void ForEachFieldEntry(const TcParseTableBase* table, F f) {
+  const TcParseTableBase::FieldEntry* entries = table->field_entries_begin();
+  uint32_t entry_idx = 0;
+  for (uint32_t present = ~table->skipmap32; present != 0;
+       present &= present - 1) {
+    f(absl::countr_zero(present) + 1, entries[entry_idx++]);
+  }
+  const uint16_t* lookup_table = table->field_lookup_begin();
+  for (;;) {
+    uint32_t fstart = lookup_table[0] | (uint32_t{lookup_table[1]} << 16);
+    if (fstart == 0xFFFFFFFF) return;
+    uint32_t num_skip_entries = lookup_table[2];
+    lookup_table += 3;
+    for (uint32_t i = 0; i < num_skip_entries; ++i, lookup_table += 2) {
+      entry_idx = lookup_table[1];
+      for (uint32_t present = ~uint32_t{lookup_table[0]} & 0xFFFF;
+           present != 0; present &= present - 1) {
+        f(fstart + i * 16 + absl::countr_zero(present), entries[entry_idx++]);
+      }
+    }
+  }
+}
+
+// Converts the in-memory representation of a varint field to the value
+// written on the wire.
+inline uint64_t EncodeVarint(uint64_t raw, uint16_t type_card) {
+  const uint16_t rep = type_card & field_layout::kRepMask;
+  const bool zigzag =
+      (type_card & field_layout::kTvMask) == field_layout::kTvZigZag;
+  if (rep == field_layout::kRep64Bits) {
+    return zigzag ? WireFormatLite::ZigZagEncode64(static_cast<int64_t>(raw))
+                  : raw;
+  }
+  if (rep == field_layout::kRep32Bits) {
+    const int32_t value = static_cast<int32_t>(raw);
+    if (zigzag) return WireFormatLite::ZigZagEncode32(value);
+    if ((type_card & field_layout::kFmtMask) == field_layout::kFmtUnsigned) {
+      return static_cast<uint32_t>(value);
+    }
+    // int32 and enum values are sign-extended.
+    return static_cast<uint64_t>(static_cast<int64_t>(value));
+  }
+  return raw != 0;
+}
+
+inline uint64_t LoadVarint(const void* base, uint32_t offset,
+                           uint16_t type_card) {
+  switch (type_card & field_layout::kRepMask) {
+    case field_layout::kRep64Bits:
+      return TcParser::ReadAt<uint64_t>(base, offset);
+    case field_layout::kRep32Bits:
+      return TcParser::ReadAt<uint32_t>(base, offset);
+    default:
+      return TcParser::ReadAt<bool>(base, offset);
+  }
+}
+
+template <typename T>
+uint8_t* WriteRepeatedVarint(const RepeatedField<T>& field, uint32_t field_num,
+                             uint16_t type_card, bool packed, uint8_t* target,
+                             io::EpsCopyOutputStream* stream) {
+  if (field.empty()) return target;
+  if (packed) {
+    size_t size = 0;
+    for (T value : field) {
+      size += io::CodedOutputStream::VarintSize64(
+          EncodeVarint(static_cast<uint64_t>(value), type_card));
+    }
+    target = stream->EnsureSpace(target);
+    target = WireFormatLite::WriteTagToArray(
+        field_num, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
+    target = io::CodedOutputStream::WriteVarint32ToArray(
+        static_cast<uint32_t>(size), target);
+  }
+  for (T value : field) {
+    target = stream->EnsureSpace(target);
+    if (!packed) {
+      target = WireFormatLite::WriteTagToArray(
+          field_num, WireFormatLite::WIRETYPE_VARINT, target);
+    }
+    target = io::CodedOutputStream::WriteVarint64ToArray(
+        EncodeVarint(static_cast<uint64_t>(value), type_card), target);
+  }
+  return target;
+}
+
+template <typename T>
+uint8_t* WriteRepeatedFixed(const RepeatedField<T>& field, uint32_t field_num,
+                            bool packed, uint8_t* target,
+                            io::EpsCopyOutputStream* stream) {
+  if (field.empty()) return target;
+  if (packed) return stream->WriteFixedPacked(field_num, field, target);
+  for (T value : field) {
+    target = stream->EnsureSpace(target);
+    if (sizeof(T) == 8) {
+      target = WireFormatLite::WriteFixed64ToArray(field_num, value, target);
+    } else {
+      target = WireFormatLite::WriteFixed32ToArray(field_num, value, target);
+    }
+  }
+  return target;
+}
+
+// Returns false if `value` fails the UTF-8 check that the type card asks for.
+// Like the generated serializer, invalid strings are only logged.
+inline bool IsValidUtf8ForSerialize(absl::string_view value,
+                                    uint16_t type_card) {
+  const uint16_t xform_val = type_card & field_layout::kTvMask;
+  bool check = xform_val == field_layout::kTvUtf8;
+#ifndef NDEBUG
+  check |= xform_val == field_layout::kTvUtf8Debug;
+#endif  // !NDEBUG
+  return !check || utf8_range::IsStructurallyValid(value);
+}
+
+}  // namespace
+
+uint8_t* TcParser::SerializeFields(const MessageLite* msg,
+                                   const TcParseTableBase* table,
+                                   uint8_t* target,
+                                   io::EpsCopyOutputStream* stream) {
+  ForEachFieldEntry(table, [&](uint32_t field_num, const FieldEntry& entry) {
+    target = SerializeField(msg, table, entry, field_num, target, stream);
+  });
+  return target;
+}
+
+uint8_t* TcParser::SerializeField(const MessageLite* msg,
+                                  const TcParseTableBase* table,
+                                  const FieldEntry& entry, uint32_t field_num,
+                                  uint8_t* target,
+                                  io::EpsCopyOutputStream* stream) {
+  const uint16_t type_card = entry.type_card;
+  const uint16_t card = type_card & field_layout::kFcMask;
+  if (card == field_layout::kFcRepeated) {
+    return SerializeRepeatedField(msg, table, entry, field_num, target, stream);
+  }
+
+  // Fields with explicit presence are written when set; implicit presence
+  // fields (kFcSingular) when they differ from zero or the empty string.
+  if (card == field_layout::kFcOptional) {
+    const uint32_t has_idx = static_cast<uint32_t>(entry.has_idx);
+    if ((ReadAt<uint32_t>(msg, has_idx / 32 * 4) &
+         (uint32_t{1} << (has_idx % 32))) == 0) {
+      return target;
+    }
+  } else if (card == field_layout::kFcOneof) {
+    if (ReadAt<uint32_t>(msg, entry.has_idx) != field_num) return target;
+  }
+  const bool implicit = card == field_layout::kFcSingular;
+  const uint16_t rep = type_card & field_layout::kRepMask;
+
+  switch (type_card & field_layout::kFkMask) {
+    case field_layout::kFkVarint: {
+      const uint64_t value =
+          EncodeVarint(LoadVarint(msg, entry.offset, type_card), type_card);
+      if (implicit && value == 0) return target;
+      target = stream->EnsureSpace(target);
+      target = WireFormatLite::WriteTagToArray(
+          field_num, WireFormatLite::WIRETYPE_VARINT, target);
+      return io::CodedOutputStream::WriteVarint64ToArray(value, target);
+    }
+    case field_layout::kFkFixed: {
+      if (rep == field_layout::kRep64Bits) {
+        const uint64_t value = ReadAt<uint64_t>(msg, entry.offset);
+        if (implicit && value == 0) return target;
+        target = stream->EnsureSpace(target);
+        return WireFormatLite::WriteFixed64ToArray(field_num, value, target);
+      }
+      const uint32_t value = ReadAt<uint32_t>(msg, entry.offset);
+      if (implicit && value == 0) return target;
+      target = stream->EnsureSpace(target);
+      return WireFormatLite::WriteFixed32ToArray(field_num, value, target);
+    }
+    case field_layout::kFkString: {
+      if (rep == field_layout::kRepCord) {
+        // Cords in a oneof are allocated separately.
+        const auto& value = card == field_layout::kFcOneof
+                                ? *RefAt<absl::Cord*>(msg, entry.offset)
+                                : RefAt<absl::Cord>(msg, entry.offset);
+        if (implicit && value.empty()) return target;
+        return stream->WriteString(field_num, value, target);
+      }
+      absl::string_view value;
+      if (rep == field_layout::kRepIString) {
+        value = RefAt<InlinedStringField>(msg, entry.offset).Get();
+      } else {
+        ABSL_DCHECK_EQ(rep, +field_layout::kRepAString);
+        value = RefAt<ArenaStringPtr>(msg, entry.offset).Get();
+      }
+      if (implicit && value.empty()) return target;
+      if (!IsValidUtf8ForSerialize(value, type_card)) {
+        PrintUTF8ErrorLog(MessageName(table), FieldName(table, &entry),
+                          "serializing", false);
+      }
+      return stream->WriteString(field_num, value, target);
+    }
+    case field_layout::kFkMessage: {
+      const MessageLite* value = RefAt<const MessageLite*>(msg, entry.offset);
+      if (value == nullptr) return target;
+      if (rep == field_layout::kRepGroup) {
+        return WireFormatLite::InternalWriteGroup(field_num, *value, target,
+                                                  stream);
+      }
+      ABSL_DCHECK_EQ(rep, +field_layout::kRepMessage);
+      return WireFormatLite::InternalWriteMessage(
+          field_num, *value, value->GetCachedSize(), target, stream);
+    }
+    default:
+      ABSL_LOG(FATAL) << "Field " << FieldName(table, &entry)
+                      << " does not support table-driven serialization.";
+  }
+  return target;
+}
+
+uint8_t* TcParser::SerializeRepeatedField(const MessageLite* msg,
+                                          const TcParseTableBase* table,
+                                          const FieldEntry& entry,
+                                          uint32_t field_num, uint8_t* target,
+                                          io::EpsCopyOutputStream* stream) {
+  const uint16_t type_card = entry.type_card;
+  const uint16_t rep = type_card & field_layout::kRepMask;
+  const uint16_t kind = type_card & field_layout::kFkMask;
+
+  switch (kind) {
+    case field_layout::kFkVarint:
+    case field_layout::kFkPackedVarint: {
+      const bool packed = kind == field_layout::kFkPackedVarint;
+      if (rep == field_layout::kRep64Bits) {
+        return WriteRepeatedVarint(RefAt<RepeatedField<uint64_t>>(msg,
+                                                                 entry.offset),
+                                   field_num, type_card, packed, target,
+                                   stream);
+      }
+      if (rep == field_layout::kRep32Bits) {
+        return WriteRepeatedVarint(RefAt<RepeatedField<uint32_t>>(msg,
+                                                                 entry.offset),
+                                   field_num, type_card, packed, target,
+                                   stream);
+      }
+      return WriteRepeatedVarint(RefAt<RepeatedField<bool>>(msg, entry.offset),
+                                 field_num, type_card, packed, target, stream);
+    }
+    case field_layout::kFkFixed:
+    case field_layout::kFkPackedFixed: {
+      const bool packed = kind == field_layout::kFkPackedFixed;
+      if (rep == field_layout::kRep64Bits) {
+        return WriteRepeatedFixed(
+            RefAt<RepeatedField<uint64_t>>(msg, entry.offset), field_num,
+            packed, target, stream);
+      }
+      return WriteRepeatedFixed(
+          RefAt<RepeatedField<uint32_t>>(msg, entry.offset), field_num, packed,
+          target, stream);
+    }
+    case field_layout::kFkString: {
+      ABSL_DCHECK_EQ(rep, +field_layout::kRepSString);
+      const auto& field =
+          RefAt<RepeatedPtrField<std::string>>(msg, entry.offset);
+      for (const std::string& value : field) {
+        if (!IsValidUtf8ForSerialize(value, type_card)) {
+          PrintUTF8ErrorLog(MessageName(table), FieldName(table, &entry),
+                            "serializing", false);
+        }
+        target = stream->WriteString(field_num, value, target);
+      }
+      return target;
+    }
+    case field_layout::kFkMessage: {
+      const auto& field = RefAt<RepeatedPtrFieldBase>(msg, entry.offset);
+      const bool is_group = rep == field_layout::kRepGroup;
+      for (int i = 0, n = field.size(); i < n; ++i) {
+        const MessageLite& value =
+            field.Get<GenericTypeHandler<MessageLite>>(i);
+        if (is_group) {
+          target = WireFormatLite::InternalWriteGroup(field_num, value, target,
+                                                      stream);
+        } else {
+          target = WireFormatLite::InternalWriteMessage(
+              field_num, value, value.GetCachedSize(), target, stream);
+        }
+      }
+      return target;
+    }
+    default:
+      ABSL_LOG(FATAL) << "Field " << FieldName(table, &entry)
+                      << " does not support table-driven serialization.";
+  }
+  return target;
+}
+
+namespace {
+
+inline size_t TagSize(uint32_t field_num) {
+  return io::CodedOutputStream::VarintSize32(field_num << 3);
+}
+
+template <typename T>
+size_t RepeatedVarintDataSize(const RepeatedField<T>& field,
+                              uint16_t type_card) {
+  size_t size = 0;
+  for (T value : field) {
+    size += io::CodedOutputStream::VarintSize64(
+        EncodeVarint(static_cast<uint64_t>(value), type_card));
+  }
+  return size;
+}
+
+// Returns the size of `count` repeated scalars that take `data_size` bytes
+// without their tags.
+inline size_t RepeatedScalarSize(int count, size_t data_size,
+                                 uint32_t field_num, bool packed) {
+  if (count == 0) return 0;
+  if (packed) {
+    return TagSize(field_num) + WireFormatLite::LengthDelimitedSize(data_size);
+  }
+  return count * TagSize(field_num) + data_size;
+}
+
+inline size_t MessageSize(const MessageLite& value, uint32_t field_num,
+                          bool is_group) {
+  if (is_group) return 2 * TagSize(field_num) + value.ByteSizeLong();
+  return TagSize(field_num) +
+         WireFormatLite::LengthDelimitedSize(value.ByteSizeLong());
+}
+
+inline bool HasBitIsSet(const MessageLite* msg,
+                        const TcParseTableBase::FieldEntry& entry) {
+  const uint32_t has_idx = static_cast<uint32_t>(entry.has_idx);
+  return (TcParser::ReadAt<uint32_t>(msg, has_idx / 32 * 4) &
+          (uint32_t{1} << (has_idx % 32))) != 0;
+}
+
+}  // namespace
+
+size_t TcParser::ByteSizeFields(const MessageLite* msg,
+                                const TcParseTableBase* table) {
+  size_t size = 0;
+  ForEachFieldEntry(table, [&](uint32_t field_num, const FieldEntry& entry) {
+    size += ByteSizeField(msg, table, entry, field_num);
+  });
+  return size;
+}
+
+size_t TcParser::ByteSizeField(const MessageLite* msg,
+                               const TcParseTableBase* table,
+                               const FieldEntry& entry, uint32_t field_num) {
+  const uint16_t type_card = entry.type_card;
+  const uint16_t card = type_card & field_layout::kFcMask;
+  if (card == field_layout::kFcRepeated) {
+    return ByteSizeRepeatedField(msg, table, entry, field_num);
+  }
+
+  // The same presence rules as in SerializeField().
+  if (card == field_layout::kFcOptional) {
+    if (!HasBitIsSet(msg, entry)) return 0;
+  } else if (card == field_layout::kFcOneof) {
+    if (ReadAt<uint32_t>(msg, entry.has_idx) != field_num) return 0;
+  }
+  const bool implicit = card == field_layout::kFcSingular;
+  const uint16_t rep = type_card & field_layout::kRepMask;
+
+  switch (type_card & field_layout::kFkMask) {
+    case field_layout::kFkVarint: {
+      const uint64_t value =
+          EncodeVarint(LoadVarint(msg, entry.offset, type_card), type_card);
+      if (implicit && value == 0) return 0;
+      return TagSize(field_num) + io::CodedOutputStream::VarintSize64(value);
+    }
+    case field_layout::kFkFixed: {
+      if (rep == field_layout::kRep64Bits) {
+        if (implicit && ReadAt<uint64_t>(msg, entry.offset) == 0) return 0;
+        return TagSize(field_num) + 8;
+      }
+      if (implicit && ReadAt<uint32_t>(msg, entry.offset) == 0) return 0;
+      return TagSize(field_num) + 4;
+    }
+    case field_layout::kFkString: {
+      size_t length;
+      if (rep == field_layout::kRepCord) {
+        length = card == field_layout::kFcOneof
+                     ? RefAt<absl::Cord*>(msg, entry.offset)->size()
+                     : RefAt<absl::Cord>(msg, entry.offset).size();
+      } else if (rep == field_layout::kRepIString) {
+        length = RefAt<InlinedStringField>(msg, entry.offset).Get().size();
+      } else {
+        ABSL_DCHECK_EQ(rep, +field_layout::kRepAString);
+        length = RefAt<ArenaStringPtr>(msg, entry.offset).Get().size();
+      }
+      if (implicit && length == 0) return 0;
+      return TagSize(field_num) + WireFormatLite::LengthDelimitedSize(length);
+    }
+    case field_layout::kFkMessage: {
+      const MessageLite* value = RefAt<const MessageLite*>(msg, entry.offset);
+      if (value == nullptr) return 0;
+      return MessageSize(*value, field_num, rep == field_layout::kRepGroup);
+    }
+    default:
+      ABSL_LOG(FATAL) << "Field " << FieldName(table, &entry)
+                      << " does not support table-driven ByteSizeLong().";
+  }
+  return 0;
+}
+
+size_t TcParser::ByteSizeRepeatedField(const MessageLite* msg,
+                                       const TcParseTableBase* table,
+                                       const FieldEntry& entry,
+                                       uint32_t field_num) {
+  const uint16_t type_card = entry.type_card;
+  const uint16_t rep = type_card & field_layout::kRepMask;
+  const uint16_t kind = type_card & field_layout::kFkMask;
+
+  switch (kind) {
+    case field_layout::kFkVarint:
+    case field_layout::kFkPackedVarint: {
+      const bool packed = kind == field_layout::kFkPackedVarint;
+      if (rep == field_layout::kRep64Bits) {
+        const auto& field = RefAt<RepeatedField<uint64_t>>(msg, entry.offset);
+        return RepeatedScalarSize(field.size(),
+                                  RepeatedVarintDataSize(field, type_card),
+                                  field_num, packed);
+      }
+      if (rep == field_layout::kRep32Bits) {
+        const auto& field = RefAt<RepeatedField<uint32_t>>(msg, entry.offset);
+        return RepeatedScalarSize(field.size(),
+                                  RepeatedVarintDataSize(field, type_card),
+                                  field_num, packed);
+      }
+      const auto& field = RefAt<RepeatedField<bool>>(msg, entry.offset);
+      return RepeatedScalarSize(field.size(), field.size(), field_num, packed);
+    }
+    case field_layout::kFkFixed:
+    case field_layout::kFkPackedFixed: {
+      const bool packed = kind == field_layout::kFkPackedFixed;
+      if (rep == field_layout::kRep64Bits) {
+        const int count =
+            RefAt<RepeatedField<uint64_t>>(msg, entry.offset).size();
+        return RepeatedScalarSize(count, count * size_t{8}, field_num, packed);
+      }
+      const int count = RefAt<RepeatedField<uint32_t>>(msg, entry.offset).size();
+      return RepeatedScalarSize(count, count * size_t{4}, field_num, packed);
+    }
+    case field_layout::kFkString: {
+      size_t size = 0;
+      if (rep == field_layout::kRepCord) {
+        for (const absl::Cord& value :
+             RefAt<RepeatedField<absl::Cord>>(msg, entry.offset)) {
+          size += TagSize(field_num) +
+                  WireFormatLite::LengthDelimitedSize(value.size());
+        }
+        return size;
+      }
+      ABSL_DCHECK_EQ(rep, +field_layout::kRepSString);
+      for (const std::string& value :
+           RefAt<RepeatedPtrField<std::string>>(msg, entry.offset)) {
+        size += TagSize(field_num) +
+                WireFormatLite::LengthDelimitedSize(value.size());
+      }
+      return size;
+    }
+    case field_layout::kFkMessage: {
+      const auto& field = RefAt<RepeatedPtrFieldBase>(msg, entry.offset);
+      const bool is_group = rep == field_layout::kRepGroup;
+      size_t size = 0;
+      for (int i = 0, n = field.size(); i < n; ++i) {
+        size += MessageSize(field.Get<GenericTypeHandler<MessageLite>>(i),
+                            field_num, is_group);
+      }
+      return size;
+    }
+    default:
+      ABSL_LOG(FATAL) << "Field " << FieldName(table, &entry)
+                      << " does not support table-driven ByteSizeLong().";
+  }
+  return 0;
+}
+
+void TcParser::ClearFields(MessageLite* msg, const TcParseTableBase* table) {
+  ForEachFieldEntry(table, [&](uint32_t, const FieldEntry& entry) {
+    ClearField(msg, table, entry);
+  });
+}
+
+void TcParser::ClearField(MessageLite* msg, const TcParseTableBase* table,
+                          const FieldEntry& entry) {
+  const uint16_t type_card = entry.type_card;
+  const uint16_t card = type_card & field_layout::kFcMask;
+  const uint16_t rep = type_card & field_layout::kRepMask;
+  const uint16_t kind = type_card & field_layout::kFkMask;
+  // The caller clears oneofs through their generated clear_<oneof>().
+  if (card == field_layout::kFcOneof) return;
+
+  if (card == field_layout::kFcRepeated) {
+    switch (kind) {
+      case field_layout::kFkVarint:
+      case field_layout::kFkPackedVarint:
+      case field_layout::kFkFixed:
+      case field_layout::kFkPackedFixed:
+        if (rep == field_layout::kRep64Bits) {
+          RefAt<RepeatedField<uint64_t>>(msg, entry.offset).Clear();
+        } else if (rep == field_layout::kRep32Bits) {
+          RefAt<RepeatedField<uint32_t>>(msg, entry.offset).Clear();
+        } else {
+          RefAt<RepeatedField<bool>>(msg, entry.offset).Clear();
+        }
+        return;
+      case field_layout::kFkString:
+        if (rep == field_layout::kRepCord) {
+          RefAt<RepeatedField<absl::Cord>>(msg, entry.offset).Clear();
+        } else {
+          RefAt<RepeatedPtrField<std::string>>(msg, entry.offset).Clear();
+        }
+        return;
+      case field_layout::kFkMessage:
+        RefAt<RepeatedPtrFieldBase>(msg, entry.offset)
+            .Clear<GenericTypeHandler<MessageLite>>();
+        return;
+      default:
+        ABSL_LOG(FATAL) << "Field " << FieldName(table, &entry)
+                        << " does not support table-driven Clear().";
+    }
+  }
+
+  switch (kind) {
+    case field_layout::kFkVarint:
+    case field_layout::kFkFixed: {
+      // Scalars are cheaper to reset than to check, and may have a non-zero
+      // default.
+      const MessageLite* defaults = table->default_instance;
+      if (rep == field_layout::kRep64Bits) {
+        RefAt<uint64_t>(msg, entry.offset) =
+            ReadAt<uint64_t>(defaults, entry.offset);
+      } else if (rep == field_layout::kRep32Bits) {
+        RefAt<uint32_t>(msg, entry.offset) =
+            ReadAt<uint32_t>(defaults, entry.offset);
+      } else {
+        RefAt<bool>(msg, entry.offset) = ReadAt<bool>(defaults, entry.offset);
+      }
+      return;
+    }
+    case field_layout::kFkString:
+      if (rep == field_layout::kRepCord) {
+        RefAt<absl::Cord>(msg, entry.offset).Clear();
+        return;
+      }
+      ABSL_DCHECK_EQ(rep, +field_layout::kRepAString);
+      if (card != field_layout::kFcOptional || HasBitIsSet(msg, entry)) {
+        RefAt<ArenaStringPtr>(msg, entry.offset).ClearToEmpty();
+      }
+      return;
+    case field_layout::kFkMessage: {
+      MessageLite*& value = RefAt<MessageLite*>(msg, entry.offset);
+      if (card == field_layout::kFcOptional) {
+        if (value != nullptr && HasBitIsSet(msg, entry)) value->Clear();
+        return;
+      }
+      // Without a has-bit, presence is the pointer being set.
+      if (msg->GetArena() == nullptr) delete value;
+      value = nullptr;
+      return;
+    }
+    default:
+      ABSL_LOG(FATAL) << "Field " << FieldName(table, &entry)
+                      << " does not support table-driven Clear().";
+  }
+}
+
+bool TcParser::CanSpaceUsedFields(const TcParseTableBase* table) {
+  const FieldEntry* entries = table->field_entries_begin();
+  for (uint16_t i = 0; i < table->num_field_entries; ++i) {
+    const uint16_t type_card = entries[i].type_card;
+    const uint16_t kind = type_card & field_layout::kFkMask;
+    if (kind == field_layout::kFkNone || kind == field_layout::kFkMap ||
+        (type_card & field_layout::kSplitMask) != field_layout::kSplitFalse ||
+        (kind == field_layout::kFkMessage &&
+         (type_card & field_layout::kRepMask) == field_layout::kRepLazy)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TcParser::VisitSubmessages(MessageLite* msg,
+                                const TcParseTableBase* table,
+                                absl::FunctionRef<bool(MessageLite&)> visit) {
+  bool result = true;
+  ForEachFieldEntry(table, [&](uint32_t field_num, const FieldEntry& entry) {
+    if (!result ||
+        (entry.type_card & field_layout::kFkMask) != field_layout::kFkMessage) {
+      return;
+    }
+    switch (entry.type_card & field_layout::kFcMask) {
+      case field_layout::kFcRepeated: {
+        auto& field = RefAt<RepeatedPtrFieldBase>(msg, entry.offset);
+        for (int i = 0; result && i < field.size(); ++i) {
+          result = visit(*field.Mutable<GenericTypeHandler<MessageLite>>(i));
+        }
+        return;
+      }
+      case field_layout::kFcOneof:
+        if (ReadAt<uint32_t>(msg, entry.has_idx) != field_num) return;
+        break;
+      case field_layout::kFcOptional:
+        if (!HasBitIsSet(msg, entry)) return;
+        break;
+      default:
+        // Without a has-bit, presence is the pointer being set, except in the
+        // default instance.
+        if (msg == table->default_instance) return;
+        break;
+    }
+    MessageLite* value = RefAt<MessageLite*>(msg, entry.offset);
+    if (value != nullptr) result = visit(*value);
+  });
+  return result;
+}
+
+size_t TcParser::SpaceUsedFields(const MessageLite* msg,
+                                 const TcParseTableBase* table, bool on_arena,
+                                 SpaceUsedFunc submessage_space_used) {
+  size_t size = 0;
+  ForEachFieldEntry(table, [&](uint32_t field_num, const FieldEntry& entry) {
+    size += SpaceUsedField(msg, table, entry, field_num, on_arena,
+                           submessage_space_used);
+  });
+  return size;
+}
+
+size_t TcParser::SpaceUsedField(const MessageLite* msg,
+                                const TcParseTableBase* table,
+                                const FieldEntry& entry, uint32_t field_num,
+                                bool on_arena,
+                                SpaceUsedFunc submessage_space_used) {
+  const uint16_t type_card = entry.type_card;
+  const uint16_t card = type_card & field_layout::kFcMask;
+  if (card == field_layout::kFcRepeated) {
+    return SpaceUsedRepeatedField(msg, entry, on_arena, submessage_space_used);
+  }
+  const bool is_oneof = card == field_layout::kFcOneof;
+  if (is_oneof && ReadAt<uint32_t>(msg, entry.has_idx) != field_num) return 0;
+  const uint16_t rep = type_card & field_layout::kRepMask;
+
+  // Scalars live in the message object itself.
+  switch (type_card & field_layout::kFkMask) {
+    case field_layout::kFkString:
+      if (rep == field_layout::kRepCord) {
+        // Oneof cords are allocated separately; others are part of `msg`.
+        if (is_oneof) {
+          const absl::Cord* value = RefAt<absl::Cord*>(msg, entry.offset);
+          return on_arena ? sizeof(absl::Cord) : value->EstimatedMemoryUsage();
+        }
+        if (on_arena) return 0;
+        return RefAt<absl::Cord>(msg, entry.offset).EstimatedMemoryUsage() -
+               sizeof(absl::Cord);
+      }
+      if (rep == field_layout::kRepIString) {
+        if (on_arena) return 0;
+        return StringSpaceUsedExcludingSelfLong(
+            RefAt<InlinedStringField>(msg, entry.offset).GetNoArena());
+      } else {
+        ABSL_DCHECK_EQ(rep, +field_layout::kRepAString);
+        // Strings that still point to the default are not counted, except in
+        // oneofs, which have no default instance to point to.
+        const auto& value = RefAt<ArenaStringPtr>(msg, entry.offset);
+        if (value.IsDefault() && !is_oneof) return 0;
+        if (!on_arena) {
+          return sizeof(std::string) +
+                 StringSpaceUsedExcludingSelfLong(value.Get());
+        }
+        return sizeof(std::string);
+      }
+    case field_layout::kFkMessage: {
+      // The default instance points to other default instances, which are
+      // not part of it.
+      if (msg == table->default_instance) return 0;
+      const MessageLite* value = RefAt<const MessageLite*>(msg, entry.offset);
+      return value == nullptr ? 0 : submessage_space_used(*value, on_arena);
+    }
+    default:
+      return 0;
+  }
+}
+
+template <typename F>
+size_t TcParser::RepeatedPtrSpaceUsed(const RepeatedPtrFieldBase& field,
+                                      F element_space_used) {
+  size_t size = static_cast<size_t>(field.total_size_) * sizeof(void*);
+  if (field.rep_ != nullptr) {
+    for (int i = 0; i < field.rep_->allocated_size; ++i) {
+      size += element_space_used(field.rep_->elements[i]);
+    }
+    size += RepeatedPtrFieldBase::kRepHeaderSize;
+  }
+  return size;
+}
+
+size_t TcParser::SpaceUsedRepeatedField(const MessageLite* msg,
+                                        const FieldEntry& entry,
+                                        bool on_arena,
+                                        SpaceUsedFunc submessage_space_used) {
+  const uint16_t type_card = entry.type_card;
+  const uint16_t rep = type_card & field_layout::kRepMask;
+
+  switch (type_card & field_layout::kFkMask) {
+    case field_layout::kFkVarint:
+    case field_layout::kFkPackedVarint:
+    case field_layout::kFkFixed:
+    case field_layout::kFkPackedFixed:
+      // Only the element size matters, not its type.
+      if (rep == field_layout::kRep64Bits) {
+        return RefAt<RepeatedField<uint64_t>>(msg, entry.offset)
+            .SpaceUsedExcludingSelfLong();
+      }
+      if (rep == field_layout::kRep32Bits) {
+        return RefAt<RepeatedField<uint32_t>>(msg, entry.offset)
+            .SpaceUsedExcludingSelfLong();
+      }
+      return RefAt<RepeatedField<bool>>(msg, entry.offset)
+          .SpaceUsedExcludingSelfLong();
+    case field_layout::kFkString: {
+      if (rep == field_layout::kRepCord) {
+        const auto& field = RefAt<RepeatedField<absl::Cord>>(msg, entry.offset);
+        return on_arena ? field.Capacity() * sizeof(absl::Cord)
+                        : field.SpaceUsedExcludingSelfLong();
+      }
+      const auto& field =
+          RefAt<RepeatedPtrField<std::string>>(msg, entry.offset);
+      if (!on_arena) return field.SpaceUsedExcludingSelfLong();
+      return RepeatedPtrSpaceUsed(field,
+                                  [](void*) { return sizeof(std::string); });
+    }
+    case field_layout::kFkMessage:
+      return RepeatedPtrSpaceUsed(
+          RefAt<RepeatedPtrFieldBase>(msg, entry.offset), [&](void* element) {
+            return submessage_space_used(
+                *static_cast<const MessageLite*>(element), on_arena);
+          });
+    default:
+      return 0;
+  }
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
@@ -29,11 +29,25 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
 
 #include "google/protobuf/generated_message_tctable_impl.h"
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
 #include "absl/types/optional.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/generated_message_tctable_gen.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/unittest_proto3.pb.h"
+#include "google/protobuf/unknown_field_set.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/wire_format_lite.h"
 
 namespace google {
@@ -42,6 +56,7 @@ namespace internal {
 
 namespace {
 
+using ::testing::ElementsAre;
 using ::testing::Eq;
 using ::testing::Not;
 using ::testing::Optional;
@@ -280,6 +295,73 @@ MATCHER_P3(IsEntryForFieldNum, table, field_num, field_numbers_table,
   return true;
 }
 
+TEST(PackedVarintTest, CountVarintEnds) {
+  const char kBytes[] = "\x01\x80\x01\xff\xff\x7f\x02\x03\x04\x05\x06\x07";
+  EXPECT_EQ(CountVarintEnds(kBytes, kBytes), 0);
+  EXPECT_EQ(CountVarintEnds(kBytes, kBytes + 2), 1);
+  EXPECT_EQ(CountVarintEnds(kBytes, kBytes + 12), 9);
+}
+
+void AppendVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+TEST(PackedVarintTest, ReadPackedVarintReservesExactCount) {
+  // Mix runs of single byte varints with longer ones.
+  std::vector<uint64_t> values;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    values.push_back(i % 20 < 12 ? i % 128 : i << (i % 50));
+  }
+  std::string payload;
+  for (uint64_t v : values) {
+    AppendVarint(v, &payload);
+  }
+  std::string data;
+  AppendVarint(payload.size(), &data);
+  data += payload;
+
+  const char* ptr;
+  ParseContext ctx(64, false, &ptr, data);
+  std::vector<uint64_t> parsed;
+  int reserved = 0;
+  ptr = ctx.ReadPackedVarint(
+      ptr, [&](uint64_t v) { parsed.push_back(v); },
+      [&](int n) { reserved += n; });
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(parsed, values);
+  EXPECT_EQ(reserved, values.size());
+}
+
+TEST(PackedFixedTest, ReadPackedFixedAcrossBuffers) {
+  std::vector<double> values;
+  for (int i = 0; i < 10000; ++i) values.push_back(i * 0.5);
+  std::string data;
+  AppendVarint(values.size() * sizeof(double), &data);
+  for (double v : values) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    for (int i = 0; i < 8; ++i) data.push_back(static_cast<char>(bits >> 8 * i));
+  }
+
+  // Small blocks make the payload span many buffers.
+  io::ArrayInputStream input(data.data(), static_cast<int>(data.size()),
+                             /*block_size=*/100);
+  const char* ptr;
+  ParseContext ctx(64, false, &ptr, &input);
+  int size = ReadSize(&ptr);
+  ASSERT_NE(ptr, nullptr);
+  RepeatedField<double> field;
+  ptr = ctx.ReadPackedFixed(ptr, size, &field);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_THAT(field, ::testing::ElementsAreArray(values));
+  // Everything was reserved up front.
+  EXPECT_LE(field.Capacity(), values.size() + 16);
+}
+
 TEST(IsEntryForFieldNumTest, Matcher) {
   // clang-format off
   TcParseTable<0, 3, 0, 0, 2> table = {
@@ -820,6 +902,283 @@ TEST_F(FindFieldEntryTest, BigMessage) {
   }
 }
 
+namespace {
+
+// Reports `hot_field` as always present and every other field as absent.
+class PresenceOptionProvider final : public TailCallTableInfo::OptionProvider {
+ public:
+  explicit PresenceOptionProvider(int hot_field) : hot_field_(hot_field) {}
+
+  TailCallTableInfo::PerFieldOptions GetForField(
+      const FieldDescriptor* field) const final {
+    return {
+        field_layout::TransformValidation{},
+        /* is_string_inlined */ false,
+        /* is_implicitly_weak */ false,
+        /* use_direct_tcparser_table */ false,
+        /* is_lite */ false,
+        /* should_split */ false,
+        /* uses_codegen */ true,
+        /* presence_probability */ field->number() == hot_field_ ? 1.f : 0.f,
+    };
+  }
+
+ private:
+  int hot_field_;
+};
+
+std::vector<int> FastFieldNumbers(const TailCallTableInfo& info) {
+  std::vector<int> numbers;
+  for (const auto& fast_field : info.fast_path_fields) {
+    if (fast_field.field != nullptr) {
+      numbers.push_back(fast_field.field->number());
+    }
+  }
+  return numbers;
+}
+
+TEST(TailCallTableInfoTest, HotFieldWinsFastSlot) {
+  // With two fields the table has at most four entries, so fields 1 and 33
+  // compete for the same fast slot.
+  FileDescriptorProto file;
+  file.set_name("fast_slot_test.proto");
+  DescriptorProto* message = file.add_message_type();
+  message->set_name("FastSlot");
+  for (int number : {1, 33}) {
+    FieldDescriptorProto* field = message->add_field();
+    field->set_name(absl::StrCat("field", number));
+    field->set_number(number);
+    field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+    field->set_type(FieldDescriptorProto::TYPE_INT32);
+  }
+  DescriptorPool pool;
+  const FileDescriptor* file_descriptor = pool.BuildFile(file);
+  ASSERT_NE(file_descriptor, nullptr);
+  const Descriptor* descriptor = file_descriptor->message_type(0);
+  std::vector<const FieldDescriptor*> fields = {descriptor->field(0),
+                                                descriptor->field(1)};
+
+  TailCallTableInfo hot_1(descriptor, fields, PresenceOptionProvider(1),
+                          {0, 1}, {});
+  EXPECT_THAT(FastFieldNumbers(hot_1), ElementsAre(1));
+
+  TailCallTableInfo hot_33(descriptor, fields, PresenceOptionProvider(33),
+                           {0, 1}, {});
+  EXPECT_THAT(FastFieldNumbers(hot_33), ElementsAre(33));
+}
+
+}  // namespace
+
+namespace {
+
+TEST(TcParserStatsTest, CountsParsePaths) {
+  protobuf_unittest::TestAllTypes message;
+  message.set_optional_int32(1);
+  std::string data = message.SerializeAsString();
+  // Field 1000, which TestAllTypes does not declare.
+  data.append("\xc0\x3e\x01");
+
+  ResetTcParserStats();
+  ASSERT_TRUE(message.ParseFromString(data));
+  std::vector<TcParserFieldStats> stats = GetTcParserStats();
+#ifdef PROTOBUF_TC_PARSER_STATS
+  const TcParserFieldStats* optional_int32 = nullptr;
+  const TcParserFieldStats* unknown = nullptr;
+  for (const auto& field : stats) {
+    if (field.message_name != "protobuf_unittest.TestAllTypes") continue;
+    if (field.field_number == 1) optional_int32 = &field;
+    if (field.field_number == 1000) unknown = &field;
+  }
+  ASSERT_NE(optional_int32, nullptr);
+  EXPECT_EQ(optional_int32->fast_path, 1);
+  EXPECT_EQ(optional_int32->mini_parse, 0);
+  ASSERT_NE(unknown, nullptr);
+  EXPECT_EQ(unknown->fast_path, 0);
+  EXPECT_EQ(unknown->fallback, 1);
+  EXPECT_EQ(unknown->unknown, 1);
+#else
+  EXPECT_TRUE(stats.empty());
+#endif  // PROTOBUF_TC_PARSER_STATS
+}
+
+// Serializes the fields of `msg` with TcParser::SerializeFields. The messages
+// below have no unknown fields or extensions, so this should match
+// SerializeAsString.
+template <typename T>
+std::string SerializeWithTable(const T& msg) {
+  msg.ByteSizeLong();  // Fills the cached sizes of submessages.
+  std::string out;
+  {
+    io::StringOutputStream output(&out);
+    uint8_t* target;
+    io::EpsCopyOutputStream stream(
+        &output, io::CodedOutputStream::IsDefaultSerializationDeterministic(),
+        &target);
+    target =
+        TcParser::SerializeFields(&msg, TcParser::GetTable<T>(), target, &stream);
+    stream.Trim(target);
+  }
+  return out;
+}
+
+TEST(TableDrivenSerializationTest, MatchesGeneratedSerializer) {
+  protobuf_unittest::TestAllTypes all_types;
+  EXPECT_EQ(SerializeWithTable(all_types), all_types.SerializeAsString());
+  TestUtil::SetAllFields(&all_types);
+  EXPECT_EQ(SerializeWithTable(all_types), all_types.SerializeAsString());
+  all_types.set_oneof_string("oneof");
+  EXPECT_EQ(SerializeWithTable(all_types), all_types.SerializeAsString());
+  all_types.mutable_oneof_nested_message()->set_bb(-1);
+  EXPECT_EQ(SerializeWithTable(all_types), all_types.SerializeAsString());
+
+  protobuf_unittest::TestPackedTypes packed_types;
+  TestUtil::SetPackedFields(&packed_types);
+  EXPECT_EQ(SerializeWithTable(packed_types),
+            packed_types.SerializeAsString());
+
+  // Field numbers above 32 use the skip-entry blocks of the lookup table.
+  protobuf_unittest::TestFieldOrderings orderings;
+  orderings.set_my_int(1);
+  orderings.set_my_string("foo");
+  orderings.set_my_float(1.5);
+  orderings.mutable_optional_nested_message()->set_bb(2);
+  EXPECT_EQ(SerializeWithTable(orderings), orderings.SerializeAsString());
+}
+
+TEST(TableDrivenSerializationTest, ImplicitPresence) {
+  proto3_unittest::TestAllTypes proto3;
+  EXPECT_EQ(SerializeWithTable(proto3), "");
+  proto3.set_optional_int32(-5);
+  proto3.set_optional_sint64(-7);
+  proto3.set_optional_double(-0.0);
+  proto3.set_optional_string("hello");
+  proto3.set_optional_nested_enum(proto3_unittest::TestAllTypes::BAZ);
+  proto3.mutable_optional_nested_message()->set_bb(3);
+  proto3.add_repeated_int32(-1);
+  proto3.add_repeated_int32(300);
+  proto3.add_repeated_fixed64(9);
+  proto3.add_repeated_string("a");
+  proto3.add_repeated_nested_message()->set_bb(4);
+  EXPECT_EQ(SerializeWithTable(proto3), proto3.SerializeAsString());
+}
+
+template <typename T>
+size_t ByteSizeWithTable(const T& msg) {
+  return TcParser::ByteSizeFields(&msg, TcParser::GetTable<T>());
+}
+
+TEST(TableDrivenMethodsTest, ByteSizeMatchesGeneratedByteSize) {
+  protobuf_unittest::TestAllTypes all_types;
+  EXPECT_EQ(ByteSizeWithTable(all_types), size_t{0});
+  TestUtil::SetAllFields(&all_types);
+  EXPECT_EQ(ByteSizeWithTable(all_types), all_types.ByteSizeLong());
+  all_types.mutable_oneof_nested_message()->set_bb(-1);
+  EXPECT_EQ(ByteSizeWithTable(all_types), all_types.ByteSizeLong());
+
+  protobuf_unittest::TestPackedTypes packed_types;
+  TestUtil::SetPackedFields(&packed_types);
+  EXPECT_EQ(ByteSizeWithTable(packed_types), packed_types.ByteSizeLong());
+
+  protobuf_unittest::TestUnpackedTypes unpacked_types;
+  TestUtil::SetUnpackedFields(&unpacked_types);
+  EXPECT_EQ(ByteSizeWithTable(unpacked_types), unpacked_types.ByteSizeLong());
+
+  proto3_unittest::TestAllTypes proto3;
+  proto3.set_optional_int32(-5);
+  proto3.set_optional_string("hello");
+  proto3.add_repeated_int32(300);
+  proto3.add_repeated_nested_message()->set_bb(4);
+  EXPECT_EQ(ByteSizeWithTable(proto3), proto3.ByteSizeLong());
+}
+
+TEST(PackedEnumTest, ValidatesWholeBlocks) {
+  // Enough values to span several validation blocks, with invalid ones in the
+  // middle of a block, at a block boundary and in the trailing partial block.
+  std::vector<int32_t> values;
+  for (int i = 0; i < 100; ++i) {
+    values.push_back(protobuf_unittest::FOREIGN_FOO + i % 3);
+  }
+  values[40] = 7;
+  values[64] = -1;
+  values[99] = 3;
+  std::string payload;
+  {
+    io::StringOutputStream payload_stream(&payload);
+    io::CodedOutputStream out(&payload_stream);
+    for (int32_t value : values) out.WriteVarint32SignExtended(value);
+  }
+  std::string wire;
+  {
+    io::StringOutputStream wire_stream(&wire);
+    io::CodedOutputStream out(&wire_stream);
+    WireFormatLite::WriteBytes(
+        protobuf_unittest::TestPackedTypes::kPackedEnumFieldNumber, payload,
+        &out);
+  }
+
+  protobuf_unittest::TestPackedTypes message;
+  ASSERT_TRUE(message.ParseFromString(wire));
+  std::vector<int32_t> expected_known;
+  std::vector<int64_t> expected_unknown;
+  for (int32_t value : values) {
+    if (protobuf_unittest::ForeignEnum_IsValid(value)) {
+      expected_known.push_back(value);
+    } else {
+      expected_unknown.push_back(value);
+    }
+  }
+  EXPECT_EQ(std::vector<int32_t>(message.packed_enum().begin(),
+                                 message.packed_enum().end()),
+            expected_known);
+  const UnknownFieldSet& unknown =
+      message.GetReflection()->GetUnknownFields(message);
+  std::vector<int64_t> actual_unknown;
+  for (int i = 0; i < unknown.field_count(); ++i) {
+    EXPECT_EQ(unknown.field(i).number(),
+              protobuf_unittest::TestPackedTypes::kPackedEnumFieldNumber);
+    actual_unknown.push_back(static_cast<int32_t>(unknown.field(i).varint()));
+  }
+  EXPECT_EQ(actual_unknown, expected_unknown);
+}
+
+TEST(TableDrivenMethodsTest, ClearFields) {
+  proto3_unittest::TestAllTypes proto3;
+  proto3.set_optional_int32(-5);
+  proto3.set_optional_bool(true);
+  proto3.set_optional_double(1.5);
+  proto3.set_optional_string("hello");
+  proto3.mutable_optional_nested_message()->set_bb(3);
+  proto3.add_repeated_int32(-1);
+  proto3.add_repeated_string("a");
+  proto3.add_repeated_nested_message()->set_bb(4);
+  proto3.set_oneof_uint32(7);
+
+  TcParser::ClearFields(&proto3,
+                        TcParser::GetTable<proto3_unittest::TestAllTypes>());
+  EXPECT_EQ(proto3.optional_int32(), 0);
+  EXPECT_FALSE(proto3.optional_bool());
+  EXPECT_EQ(proto3.optional_double(), 0);
+  EXPECT_EQ(proto3.optional_string(), "");
+  EXPECT_EQ(proto3.optional_nested_message().bb(), 0);
+  EXPECT_EQ(proto3.repeated_int32_size(), 0);
+  EXPECT_EQ(proto3.repeated_string_size(), 0);
+  EXPECT_EQ(proto3.repeated_nested_message_size(), 0);
+  // Oneofs are left to the generated clear_<oneof>().
+  EXPECT_EQ(proto3.oneof_uint32(), 7);
+
+  // Scalars are reset to their declared defaults.
+  protobuf_unittest::TestExtremeDefaultValues defaults;
+  defaults.set_large_uint32(1);
+  defaults.set_small_int64(2);
+  TcParser::ClearFields(
+      &defaults,
+      TcParser::GetTable<protobuf_unittest::TestExtremeDefaultValues>());
+  EXPECT_EQ(defaults.large_uint32(), 0xFFFFFFFFu);
+  EXPECT_EQ(defaults.small_int64(), -0x7FFFFFFFFFFFFFFF);
+}
+
+}  // namespace
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
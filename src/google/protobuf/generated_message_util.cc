@@ -36,6 +36,7 @@
 
 #include <atomic>
 #include <limits>
+#include <string>
 #include <vector>
 
 #include "google/protobuf/arenastring.h"
@@ -386,6 +387,17 @@ void GenericSwap(MessageLite* m1, MessageLite* m2) {
   m2->CheckTypeAndMergeFrom(*tmp);
 }
 
+std::string SerializeForComparison(const MessageLite& message) {
+  std::string result;
+  {
+    io::StringOutputStream output(&result);
+    io::CodedOutputStream coded_output(&output);
+    coded_output.SetSerializationDeterministic(true);
+    message.SerializePartialToCodedStream(&coded_output);
+  }
+  return result;
+}
+
 // Returns a message owned by this Arena.  This may require Own()ing or
 // duplicating the message.
 MessageLite* GetOwnedMessageInternal(Arena* message_arena,
@@ -170,6 +170,11 @@ PROTOBUF_EXPORT void GenericSwap(MessageLite* m1, MessageLite* m2);
 // We specialize GenericSwap for non-lite messages to benefit from reflection.
 PROTOBUF_EXPORT void GenericSwap(Message* m1, Message* m2);
 
+// Returns the deterministic serialization of `message`. The operator== and
+// AbslHashValue() of messages generated with the hash_and_equality option use
+// it for message fields whose type may have been generated without them.
+PROTOBUF_EXPORT std::string SerializeForComparison(const MessageLite& message);
+
 template <typename T>
 T* DuplicateIfNonNull(T* message) {
   // The casts must be reinterpret_cast<> because T might be a forward-declared
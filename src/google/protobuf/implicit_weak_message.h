@@ -60,15 +60,17 @@ class PROTOBUF_EXPORT ImplicitWeakMessage : public MessageLite {
   ImplicitWeakMessage() : data_(new std::string) {}
   explicit constexpr ImplicitWeakMessage(ConstantInitialized)
       : data_(nullptr) {}
+  // On an arena the string is created on the arena too, which registers its
+  // destructor in place of the message's, so the message needs none.
   explicit ImplicitWeakMessage(Arena* arena)
-      : MessageLite(arena), data_(new std::string) {}
+      : MessageLite(arena), data_(Arena::Create<std::string>(arena)) {}
   ImplicitWeakMessage(const ImplicitWeakMessage&) = delete;
   ImplicitWeakMessage& operator=(const ImplicitWeakMessage&) = delete;
 
   ~ImplicitWeakMessage() override {
     // data_ will be null in the default instance, but we can safely call delete
     // here because the default instance will never be destroyed.
-    delete data_;
+    if (GetOwningArena() == nullptr) delete data_;
   }
 
   static const ImplicitWeakMessage* default_instance();
@@ -111,11 +113,12 @@ class PROTOBUF_EXPORT ImplicitWeakMessage : public MessageLite {
   }
 
   typedef void InternalArenaConstructable_;
+  typedef void DestructorSkippable_;
 
  private:
-  // This std::string is allocated on the heap, but we use a raw pointer so that
-  // the default instance can be constant-initialized. In the const methods, we
-  // have to handle the possibility of data_ being null.
+  // This std::string is allocated on the heap or the arena, but we use a raw
+  // pointer so that the default instance can be constant-initialized. In the
+  // const methods, we have to handle the possibility of data_ being null.
   std::string* data_;
 };
 
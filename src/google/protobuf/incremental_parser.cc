@@ -0,0 +1,195 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/incremental_parser.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/message_lite.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using internal::WireFormatLite;
+
+enum class Scan {
+  kComplete,
+  kIncomplete,
+  kMalformed,
+  // The end-group tag of the enclosing group.
+  kEndGroup,
+};
+
+Scan ReadVarint(absl::string_view data, size_t& pos, uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (pos == data.size()) return Scan::kIncomplete;
+    const uint8_t byte = static_cast<uint8_t>(data[pos++]);
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (byte < 0x80) return Scan::kComplete;
+  }
+  return Scan::kMalformed;
+}
+
+// Advances `pos` past the field that starts there, without parsing it.
+// `group_number` is the number of the enclosing group, or 0 at the top level.
+// If `field_end` is not null, it is set to the offset just past the field as
+// soon as the field header tells, which may be beyond the end of `data`.
+Scan SkipField(absl::string_view data, size_t& pos, int depth,
+               uint32_t group_number, size_t* field_end) {
+  uint64_t tag;
+  Scan scan = ReadVarint(data, pos, tag);
+  if (scan != Scan::kComplete) return scan;
+  if (tag > std::numeric_limits<uint32_t>::max() || (tag >> 3) == 0) {
+    return Scan::kMalformed;
+  }
+  const uint32_t field_number = static_cast<uint32_t>(tag >> 3);
+
+  size_t size;
+  switch (WireFormatLite::GetTagWireType(static_cast<uint32_t>(tag))) {
+    case WireFormatLite::WIRETYPE_VARINT: {
+      uint64_t value;
+      return ReadVarint(data, pos, value);
+    }
+    case WireFormatLite::WIRETYPE_FIXED64:
+      size = 8;
+      break;
+    case WireFormatLite::WIRETYPE_FIXED32:
+      size = 4;
+      break;
+    case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+      uint64_t length;
+      scan = ReadVarint(data, pos, length);
+      if (scan != Scan::kComplete) return scan;
+      if (length > static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+        return Scan::kMalformed;
+      }
+      size = static_cast<size_t>(length);
+      break;
+    }
+    case WireFormatLite::WIRETYPE_START_GROUP:
+      if (depth >= io::CodedInputStream::GetDefaultRecursionLimit()) {
+        return Scan::kMalformed;
+      }
+      while (true) {
+        scan = SkipField(data, pos, depth + 1, field_number, nullptr);
+        if (scan == Scan::kEndGroup) return Scan::kComplete;
+        if (scan != Scan::kComplete) return scan;
+      }
+    case WireFormatLite::WIRETYPE_END_GROUP:
+      return field_number == group_number ? Scan::kEndGroup
+                                          : Scan::kMalformed;
+    default:
+      return Scan::kMalformed;
+  }
+
+  if (field_end != nullptr) *field_end = pos + size;
+  if (data.size() - pos < size) return Scan::kIncomplete;
+  pos += size;
+  return Scan::kComplete;
+}
+
+}  // namespace
+
+IncrementalParser::Status IncrementalParser::Feed(absl::string_view data) {
+  if (failed_) return kError;
+  if (!pending_.empty()) {
+    // Complete the field left over from the previous call first.  When its
+    // size is known, only the rest of it is copied from `data`.
+    size_t pos = 0;
+    size_t field_end = 0;
+    if (SkipField(pending_, pos, 0, 0, &field_end) == Scan::kIncomplete &&
+        field_end > pending_.size()) {
+      const size_t missing =
+          std::min(field_end - pending_.size(), data.size());
+      pending_.append(data.data(), missing);
+      data.remove_prefix(missing);
+      if (pending_.size() < field_end) return kNeedMoreData;
+    } else {
+      pending_.append(data.data(), data.size());
+      data = absl::string_view();
+    }
+    const size_t merged = MergeCompleteFields(pending_);
+    if (failed_) return kError;
+    pending_.erase(0, merged);
+    // Either the pending field was completed and merged, or all of `data`
+    // went into pending_.
+    if (!pending_.empty()) return kNeedMoreData;
+  }
+  const size_t merged = MergeCompleteFields(data);
+  if (failed_) return kError;
+  pending_.assign(data.data() + merged, data.size() - merged);
+  return kNeedMoreData;
+}
+
+size_t IncrementalParser::MergeCompleteFields(absl::string_view data) {
+  size_t end = 0;
+  while (end < data.size()) {
+    size_t pos = end;
+    const Scan scan = SkipField(data, pos, 0, 0, nullptr);
+    if (scan == Scan::kIncomplete) break;
+    if (scan != Scan::kComplete) {
+      failed_ = true;
+      return 0;
+    }
+    end = pos;
+  }
+  // One parse call for all of them.
+  if (end > 0 &&
+      !internal::MergeFromImpl<false>(data.substr(0, end), message_,
+                                      MessageLite::kMergePartial)) {
+    failed_ = true;
+    return 0;
+  }
+  return end;
+}
+
+bool IncrementalParser::FinishPartial() {
+  return !failed_ && pending_.empty();
+}
+
+bool IncrementalParser::Finish() {
+  return FinishPartial() && message_->IsInitialized();
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,112 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Push-style parsing of a message whose bytes arrive in pieces, e.g. from a
+// non-blocking socket:
+//
+//   MyMessage message;
+//   IncrementalParser parser(&message);
+//   while (... more bytes in `chunk` ...) {
+//     if (parser.Feed(chunk) == IncrementalParser::kError) ... fail ...
+//   }
+//   if (!parser.Finish()) ... fail ...
+//
+// Each top-level field is merged into the message as soon as all of its bytes
+// have arrived, so only the field that straddles the current end of input is
+// buffered rather than the whole message.  This relies on the wire format
+// guarantee that parsing a concatenation of encoded fields is the same as
+// merging them one after the other.  A single large field, such as a big
+// submessage, is still buffered until it is complete.
+
+#ifndef GOOGLE_PROTOBUF_INCREMENTAL_PARSER_H__
+#define GOOGLE_PROTOBUF_INCREMENTAL_PARSER_H__
+
+#include <cstddef>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+class MessageLite;
+
+class PROTOBUF_EXPORT IncrementalParser {
+ public:
+  enum Status {
+    // All bytes fed so far are consumed or buffered; feed more or Finish().
+    kNeedMoreData,
+    // The input is malformed.  Further calls keep returning kError.
+    kError,
+  };
+
+  // Merges the parsed fields into `message`, which must outlive the parser.
+  // Like MergeFromString(), fields already set in `message` are kept.
+  explicit IncrementalParser(MessageLite* message) : message_(message) {}
+  IncrementalParser(const IncrementalParser&) = delete;
+  IncrementalParser& operator=(const IncrementalParser&) = delete;
+
+  // Consumes the next piece of input.  `data` need not stay alive after the
+  // call: the bytes of an incomplete field are copied.
+  Status Feed(absl::string_view data);
+
+  // Ends the input.  Returns false if a field was cut off, the input was
+  // malformed, or required fields are missing.
+  bool Finish();
+  // Like Finish(), but does not check required fields.
+  bool FinishPartial();
+
+  // Returns the number of bytes buffered for the incomplete field.
+  size_t buffered_bytes() const { return pending_.size(); }
+
+ private:
+  // Merges the complete fields at the start of `data` and returns their size,
+  // or sets failed_.
+  size_t MergeCompleteFields(absl::string_view data);
+
+  MessageLite* message_;
+  // The start of the field that straddles the end of the input so far.
+  std::string pending_;
+  bool failed_ = false;
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_INCREMENTAL_PARSER_H__
@@ -0,0 +1,160 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/io/checksum_stream.h"
+
+#include "absl/crc/crc32c.h"
+#include "absl/log/absl_check.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+// ===================================================================
+
+Crc32cInputStream::Crc32cInputStream(ZeroCopyInputStream* sub_stream,
+                                     absl::crc32c_t initial_crc)
+    : sub_stream_(sub_stream), crc_(initial_crc) {}
+
+absl::crc32c_t Crc32cInputStream::crc32c() const {
+  return absl::ExtendCrc32c(crc_,
+                            absl::string_view(pending_data_, pending_size_));
+}
+
+void Crc32cInputStream::Commit() {
+  crc_ = crc32c();
+  pending_data_ = nullptr;
+  pending_size_ = 0;
+}
+
+bool Crc32cInputStream::Next(const void** data, int* size) {
+  Commit();
+  if (!sub_stream_->Next(data, size)) return false;
+  pending_data_ = static_cast<const char*>(*data);
+  pending_size_ = *size;
+  return true;
+}
+
+void Crc32cInputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(count, pending_size_)
+      << "BackUp() can only return the end of the last buffer.";
+  pending_size_ -= count;
+  sub_stream_->BackUp(count);
+}
+
+bool Crc32cInputStream::Skip(int count) {
+  ABSL_CHECK_GE(count, 0);
+  const void* data;
+  int size;
+  while (count > 0) {
+    if (!Next(&data, &size)) return false;
+    if (size > count) {
+      BackUp(size - count);
+      return true;
+    }
+    count -= size;
+  }
+  return true;
+}
+
+int64_t Crc32cInputStream::ByteCount() const {
+  return sub_stream_->ByteCount();
+}
+
+// ===================================================================
+
+Crc32cOutputStream::Crc32cOutputStream(ZeroCopyOutputStream* sub_stream,
+                                       absl::crc32c_t initial_crc)
+    : sub_stream_(sub_stream), crc_(initial_crc) {}
+
+absl::crc32c_t Crc32cOutputStream::crc32c() const {
+  return absl::ExtendCrc32c(crc_,
+                            absl::string_view(pending_data_, pending_size_));
+}
+
+void Crc32cOutputStream::Commit() {
+  crc_ = crc32c();
+  pending_data_ = nullptr;
+  pending_size_ = 0;
+}
+
+bool Crc32cOutputStream::Next(void** data, int* size) {
+  Commit();
+  if (!sub_stream_->Next(data, size)) return false;
+  pending_data_ = static_cast<const char*>(*data);
+  pending_size_ = *size;
+  return true;
+}
+
+void Crc32cOutputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(count, pending_size_)
+      << "BackUp() can only return the end of the last buffer.";
+  pending_size_ -= count;
+  sub_stream_->BackUp(count);
+}
+
+int64_t Crc32cOutputStream::ByteCount() const {
+  return sub_stream_->ByteCount();
+}
+
+bool Crc32cOutputStream::WriteAliasedRaw(const void* data, int size) {
+  Commit();
+  if (!sub_stream_->WriteAliasedRaw(data, size)) return false;
+  crc_ = absl::ExtendCrc32c(
+      crc_, absl::string_view(static_cast<const char*>(data), size));
+  return true;
+}
+
+bool Crc32cOutputStream::AllowsAliasing() const {
+  return sub_stream_->AllowsAliasing();
+}
+
+bool Crc32cOutputStream::WriteCord(const absl::Cord& cord) {
+  Commit();
+  if (!sub_stream_->WriteCord(cord)) return false;
+  for (absl::string_view chunk : cord.Chunks()) {
+    crc_ = absl::ExtendCrc32c(crc_, chunk);
+  }
+  return true;
+}
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,141 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// This file contains Crc32cInputStream and Crc32cOutputStream, which compute
+// the CRC32C of the data passing through another ZeroCopy stream.
+//
+// Wrapping the stream a message is parsed from or serialized to yields the
+// checksum of its wire format without a second pass over the bytes:
+//
+//   StringOutputStream string_stream(&output);
+//   Crc32cOutputStream crc_stream(&string_stream);
+//   message.SerializeToZeroCopyStream(&crc_stream);
+//   uint32_t crc = static_cast<uint32_t>(crc_stream.crc32c());
+//
+// Each buffer is checksummed once the caller has moved past it (or asked for
+// the checksum), so bytes returned with BackUp() are never counted. The
+// checksum comes from absl::ExtendCrc32c(), which uses the CPU's CRC32
+// instructions when they are available.
+
+#ifndef GOOGLE_PROTOBUF_IO_CHECKSUM_STREAM_H__
+#define GOOGLE_PROTOBUF_IO_CHECKSUM_STREAM_H__
+
+#include <cstdint>
+
+#include "absl/crc/crc32c.h"
+#include "absl/strings/cord.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+// A ZeroCopyInputStream that computes the CRC32C of everything read from
+// `sub_stream`.  Skipped bytes are read through and included in the checksum,
+// so it always covers a contiguous prefix of the underlying data.
+class PROTOBUF_EXPORT Crc32cInputStream final : public ZeroCopyInputStream {
+ public:
+  // `sub_stream` must outlive this stream.  `initial_crc` lets a checksum be
+  // continued from an earlier stream.
+  explicit Crc32cInputStream(ZeroCopyInputStream* sub_stream,
+                             absl::crc32c_t initial_crc = absl::crc32c_t{0});
+  Crc32cInputStream(const Crc32cInputStream&) = delete;
+  Crc32cInputStream& operator=(const Crc32cInputStream&) = delete;
+  ~Crc32cInputStream() override = default;
+
+  // Returns the CRC32C of the bytes consumed so far.
+  absl::crc32c_t crc32c() const;
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  // Folds the last buffer returned by Next() into crc_.
+  void Commit();
+
+  ZeroCopyInputStream* sub_stream_;
+  absl::crc32c_t crc_;
+  // The part of the last buffer returned by Next() that has not been backed
+  // up.  It is added to crc_ lazily so that BackUp() needs no extra work.
+  const char* pending_data_ = nullptr;
+  int pending_size_ = 0;
+};
+
+// A ZeroCopyOutputStream that computes the CRC32C of everything written to
+// `sub_stream`.
+class PROTOBUF_EXPORT Crc32cOutputStream final : public ZeroCopyOutputStream {
+ public:
+  // `sub_stream` must outlive this stream.  `initial_crc` lets a checksum be
+  // continued from an earlier stream.
+  explicit Crc32cOutputStream(ZeroCopyOutputStream* sub_stream,
+                              absl::crc32c_t initial_crc = absl::crc32c_t{0});
+  Crc32cOutputStream(const Crc32cOutputStream&) = delete;
+  Crc32cOutputStream& operator=(const Crc32cOutputStream&) = delete;
+  ~Crc32cOutputStream() override = default;
+
+  // Returns the CRC32C of the bytes written so far.  This includes the
+  // buffer most recently returned by Next(), so it must only be called once
+  // the caller has filled that buffer (or backed up what it didn't use).
+  absl::crc32c_t crc32c() const;
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override;
+  bool WriteAliasedRaw(const void* data, int size) override;
+  bool AllowsAliasing() const override;
+  bool WriteCord(const absl::Cord& cord) override;
+
+ private:
+  // Folds the last buffer returned by Next() into crc_.
+  void Commit();
+
+  ZeroCopyOutputStream* sub_stream_;
+  absl::crc32c_t crc_;
+  // The caller may still be writing to the last buffer returned by Next(), so
+  // it is only checksummed when the next one is requested.
+  const char* pending_data_ = nullptr;
+  int pending_size_ = 0;
+};
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_IO_CHECKSUM_STREAM_H__
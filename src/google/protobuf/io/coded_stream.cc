@@ -732,6 +732,21 @@ int64_t EpsCopyOutputStream::ByteCount(uint8_t* ptr) const {
   return stream_->ByteCount() - delta;
 }
 
+uint8_t* EpsCopyOutputStream::EndBackpatchedLengthDelim(uint8_t* payload,
+                                                       uint8_t* ptr) {
+  // After an error `ptr` points into the patch buffer rather than past
+  // `payload`, and the output is discarded anyway.
+  if (had_error_) return ptr;
+  ABSL_DCHECK(payload <= ptr);  // NOLINT
+  const uint32_t size = static_cast<uint32_t>(ptr - payload);
+  uint8_t* prefix = payload - kMaxLengthPrefixBytes;
+  uint8_t* start = UnsafeWriteSize(size, prefix);
+  if (start != payload) {
+    std::memmove(start, payload, size);
+  }
+  return start + size;
+}
+
 // Flushes what's written out to the underlying ZeroCopyOutputStream buffers.
 // Returns the size remaining in the buffer and sets buffer_end_ to the start
 // of the remaining buffer, ie. [buffer_end_, buffer_end_ + return value)
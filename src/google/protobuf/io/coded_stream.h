@@ -829,6 +829,37 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
   // stream's overall position.
   int64_t ByteCount(uint8_t* ptr) const;
 
+  // Instructs the stream to write submessages and packed fields without
+  // relying on their cached sizes: the length prefix is reserved at its
+  // maximum width, the payload is written, and the prefix is then filled in
+  // and the payload moved down over the unused bytes, so the output is
+  // identical to the regular two-pass serialization.  This lets a message be
+  // serialized without a ByteSizeLong() traversal first.
+  //
+  // Only valid for a stream that writes into a single flat buffer, i.e. one
+  // without an underlying ZeroCopyOutputStream.  If the buffer turns out to
+  // be too small, HadError() becomes true and the output must be discarded.
+  void EnableLengthBackpatching() {
+    ABSL_DCHECK(stream_ == nullptr);
+    backpatch_lengths_ = true;
+  }
+  bool BackpatchesLengths() const { return backpatch_lengths_; }
+
+  // Writes the tag of a length-delimited field and reserves room for its
+  // length.  Returns the start of the payload, which must be passed to
+  // EndBackpatchedLengthDelim() once the payload is written.
+  PROTOBUF_NODISCARD uint8_t* BeginBackpatchedLengthDelim(uint32_t num,
+                                                          uint8_t* ptr) {
+    ABSL_DCHECK(backpatch_lengths_);
+    ptr = EnsureSpace(ptr);
+    ptr = WriteTag(num, 2, ptr);
+    return ptr + kMaxLengthPrefixBytes;
+  }
+  // Fills in the length reserved by BeginBackpatchedLengthDelim() and returns
+  // the new end of the field.
+  PROTOBUF_NODISCARD uint8_t* EndBackpatchedLengthDelim(uint8_t* payload,
+                                                        uint8_t* ptr);
+
 
  private:
   uint8_t* end_;
@@ -839,6 +870,10 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
   bool aliasing_enabled_ = false;  // See EnableAliasing().
   bool is_serialization_deterministic_;
   bool skip_check_consistency = false;
+  bool backpatch_lengths_ = false;  // See EnableLengthBackpatching().
+
+  // Lengths are limited to 2GB, so this is the widest varint they need.
+  static constexpr int kMaxLengthPrefixBytes = 5;
 
   uint8_t* EnsureSpaceFallback(uint8_t* ptr);
   inline uint8_t* Next();
@@ -889,14 +924,45 @@ class PROTOBUF_EXPORT EpsCopyOutputStream {
   PROTOBUF_ALWAYS_INLINE uint8_t* WriteVarintPacked(int num, const T& r,
                                                     int size, uint8_t* ptr,
                                                     const E& encode) {
+    if (PROTOBUF_PREDICT_FALSE(backpatch_lengths_)) {
+      if (r.empty()) return ptr;
+      uint8_t* payload = BeginBackpatchedLengthDelim(num, ptr);
+      ptr = WriteVarints(r.data(), r.data() + r.size(), payload, encode);
+      return EndBackpatchedLengthDelim(payload, ptr);
+    }
     ptr = EnsureSpace(ptr);
     ptr = WriteLengthDelim(num, size, ptr);
-    auto it = r.data();
-    auto end = it + r.size();
-    do {
+    return WriteVarints(r.data(), r.data() + r.size(), ptr, encode);
+  }
+
+  // Writes the elements of [it, end) as varints without tags.  Packed fields
+  // are dominated by values that fit in one byte (small integers, enums,
+  // bools), so blocks of kSlopBytes elements are first checked for that in a
+  // form the compiler vectorizes, and then stored a block at a time.
+  template <typename T, typename E>
+  uint8_t* WriteVarints(const T* it, const T* end, uint8_t* ptr,
+                        const E& encode) {
+    while (end - it >= kSlopBytes) {
+      ptr = EnsureSpace(ptr);
+      decltype(encode(*it)) bits = 0;
+      for (int i = 0; i < kSlopBytes; ++i) bits |= encode(it[i]);
+      if (bits < 0x80) {
+        for (int i = 0; i < kSlopBytes; ++i) {
+          ptr[i] = static_cast<uint8_t>(encode(it[i]));
+        }
+        ptr += kSlopBytes;
+      } else {
+        for (int i = 0; i < kSlopBytes; ++i) {
+          ptr = EnsureSpace(ptr);
+          ptr = UnsafeVarint(encode(it[i]), ptr);
+        }
+      }
+      it += kSlopBytes;
+    }
+    while (it < end) {
       ptr = EnsureSpace(ptr);
       ptr = UnsafeVarint(encode(*it++), ptr);
-    } while (it < end);
+    }
     return ptr;
   }
 
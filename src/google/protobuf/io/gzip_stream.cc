@@ -37,9 +37,21 @@
 #if HAVE_ZLIB
 #include "google/protobuf/io/gzip_stream.h"
 
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include "google/protobuf/stubs/common.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/port.h"
 
 namespace google {
@@ -47,10 +59,19 @@ namespace protobuf {
 namespace io {
 
 static const int kDefaultBufferSize = 65536;
+static const int kDefaultParallelBlockSize = 131072;
 
 GzipInputStream::GzipInputStream(ZeroCopyInputStream* sub_stream, Format format,
                                  int buffer_size)
-    : format_(format), sub_stream_(sub_stream), zerror_(Z_OK), byte_count_(0) {
+    : GzipInputStream(sub_stream, format, buffer_size, nullptr) {}
+
+GzipInputStream::GzipInputStream(ZeroCopyInputStream* sub_stream, Format format,
+                                 int buffer_size, BufferPool* buffer_pool)
+    : format_(format),
+      sub_stream_(sub_stream),
+      zerror_(Z_OK),
+      buffer_pool_(buffer_pool),
+      byte_count_(0) {
   zcontext_.state = Z_NULL;
   zcontext_.zalloc = Z_NULL;
   zcontext_.zfree = Z_NULL;
@@ -65,14 +86,20 @@ GzipInputStream::GzipInputStream(ZeroCopyInputStream* sub_stream, Format format,
   } else {
     output_buffer_length_ = buffer_size;
   }
-  output_buffer_ = operator new(output_buffer_length_);
+  output_buffer_ = buffer_pool_ != nullptr
+                       ? buffer_pool_->Allocate(output_buffer_length_)
+                       : operator new(output_buffer_length_);
   ABSL_CHECK(output_buffer_ != NULL);
   zcontext_.next_out = static_cast<Bytef*>(output_buffer_);
   zcontext_.avail_out = output_buffer_length_;
   output_position_ = output_buffer_;
 }
 GzipInputStream::~GzipInputStream() {
-  internal::SizedDelete(output_buffer_, output_buffer_length_);
+  if (buffer_pool_ != nullptr) {
+    buffer_pool_->Release(output_buffer_, output_buffer_length_);
+  } else {
+    internal::SizedDelete(output_buffer_, output_buffer_length_);
+  }
   zerror_ = inflateEnd(&zcontext_);
 }
 
@@ -202,7 +229,299 @@ GzipOutputStream::Options::Options()
     : format(GZIP),
       buffer_size(kDefaultBufferSize),
       compression_level(Z_DEFAULT_COMPRESSION),
-      compression_strategy(Z_DEFAULT_STRATEGY) {}
+      compression_strategy(Z_DEFAULT_STRATEGY),
+      num_threads(1),
+      block_size(kDefaultParallelBlockSize) {}
+
+// Each block is compressed as a raw deflate stream primed with the window of
+// input before it and ended with a sync flush, which leaves it byte aligned,
+// so the blocks concatenate into a single deflate stream.  The last block is
+// finished instead.  The caller's thread writes the gzip or zlib framing and
+// the compressed blocks in order, combining the blocks' checksums.
+class GzipOutputStream::ParallelDeflater {
+ public:
+  ParallelDeflater(ZeroCopyOutputStream* sub_stream, const Options& options)
+      : sub_stream_(sub_stream),
+        gzip_(options.format == GZIP),
+        level_(options.compression_level),
+        strategy_(options.compression_strategy),
+        block_size_(std::max(options.block_size, 1)),
+        max_pending_(2 * static_cast<size_t>(options.num_threads)),
+        check_(gzip_ ? crc32(0, Z_NULL, 0) : adler32(0, Z_NULL, 0)) {
+    for (int i = 0; i < options.num_threads; ++i) {
+      threads_.emplace_back([this] { Work(); });
+    }
+  }
+
+  ~ParallelDeflater() {
+    {
+      absl::MutexLock lock(&mutex_);
+      stopping_ = true;
+    }
+    for (std::thread& thread : threads_) thread.join();
+  }
+
+  int error() const { return error_; }
+
+  bool Next(void** data, int* size) {
+    if (error_ != Z_OK) return false;
+    if (block_used_ == block_size_) {
+      Submit(/*last=*/false);
+      if (!WriteBlocks(max_pending_)) return false;
+    }
+    if (block_.size() != block_size_) block_.resize(block_size_);
+    *data = &block_[block_used_];
+    *size = static_cast<int>(block_size_ - block_used_);
+    block_used_ = block_size_;
+    return true;
+  }
+
+  void BackUp(int count) {
+    ABSL_CHECK_GE(block_used_, static_cast<size_t>(count));
+    block_used_ -= count;
+  }
+
+  int64_t ByteCount() const { return byte_count_ + block_used_; }
+
+  bool Flush() {
+    if (error_ != Z_OK) return false;
+    if (block_used_ > 0) Submit(/*last=*/false);
+    return WriteBlocks(0);
+  }
+
+  bool Close() {
+    bool ok = error_ == Z_OK;
+    if (ok) {
+      Submit(/*last=*/true);
+      ok = WriteBlocks(0) && WriteTrailer();
+    }
+    error_ = Z_STREAM_END;
+    return ok;
+  }
+
+ private:
+  static constexpr size_t kWindowSize = 32768;
+
+  struct Block {
+    std::string input;
+    // Up to kWindowSize bytes of input preceding this block.
+    std::string dictionary;
+    bool last = false;
+
+    // Set by the worker thread.
+    std::string output;
+    uLong check = 0;
+    int error = Z_OK;
+    bool done = false;  // Guarded by mutex_.
+  };
+
+  void Submit(bool last) {
+    auto block = std::make_unique<Block>();
+    block_.resize(block_used_);
+    block->input = std::move(block_);
+    block->dictionary = window_;
+    block->last = last;
+    const std::string& input = block->input;
+    if (input.size() >= kWindowSize) {
+      window_.assign(input, input.size() - kWindowSize, kWindowSize);
+    } else {
+      window_.append(input);
+      if (window_.size() > kWindowSize) {
+        window_.erase(0, window_.size() - kWindowSize);
+      }
+    }
+    byte_count_ += input.size();
+    block_.clear();
+    block_used_ = 0;
+    {
+      absl::MutexLock lock(&mutex_);
+      queue_.push_back(block.get());
+    }
+    pending_.push_back(std::move(block));
+  }
+
+  // Writes out compressed blocks in order until at most `max_pending` are
+  // left, then any more that are already done.
+  bool WriteBlocks(size_t max_pending) {
+    while (!pending_.empty()) {
+      Block* block = pending_.front().get();
+      {
+        absl::MutexLock lock(&mutex_);
+        if (pending_.size() > max_pending) {
+          mutex_.Await(absl::Condition(&block->done));
+        } else if (!block->done) {
+          break;
+        }
+      }
+      if (block->error != Z_OK) {
+        error_ = block->error;
+        return false;
+      }
+      if (!header_written_) {
+        if (!WriteHeader()) return false;
+        header_written_ = true;
+      }
+      if (!Write(block->output.data(), block->output.size())) return false;
+      const z_off_t length = static_cast<z_off_t>(block->input.size());
+      check_ = gzip_ ? crc32_combine(check_, block->check, length)
+                     : adler32_combine(check_, block->check, length);
+      pending_.pop_front();
+    }
+    return true;
+  }
+
+  bool WriteHeader() {
+    if (gzip_) {
+      // No file name or modification time; OS unknown.
+      const unsigned char header[10] = {0x1f, 0x8b, Z_DEFLATED, 0, 0,
+                                        0,    0,    0,          0, 0xff};
+      return Write(header, sizeof(header));
+    }
+    // CMF for a 32kB window, then FLEVEL and the FCHECK bits, as
+    // deflateInit() would write them.
+    const int level = level_ == Z_DEFAULT_COMPRESSION ? 6 : level_;
+    unsigned int level_flags = 3;
+    if (strategy_ >= Z_HUFFMAN_ONLY || level < 2) {
+      level_flags = 0;
+    } else if (level < 6) {
+      level_flags = 1;
+    } else if (level == 6) {
+      level_flags = 2;
+    }
+    unsigned int header = 0x7800 | (level_flags << 6);
+    header += 31 - header % 31;
+    const unsigned char bytes[2] = {static_cast<unsigned char>(header >> 8),
+                                    static_cast<unsigned char>(header)};
+    return Write(bytes, sizeof(bytes));
+  }
+
+  bool WriteTrailer() {
+    unsigned char trailer[8];
+    if (gzip_) {
+      const uint32_t length = static_cast<uint32_t>(byte_count_);
+      for (int i = 0; i < 4; ++i) {
+        trailer[i] = static_cast<unsigned char>(check_ >> (8 * i));
+        trailer[4 + i] = static_cast<unsigned char>(length >> (8 * i));
+      }
+      return Write(trailer, 8);
+    }
+    for (int i = 0; i < 4; ++i) {
+      trailer[i] = static_cast<unsigned char>(check_ >> (8 * (3 - i)));
+    }
+    return Write(trailer, 4);
+  }
+
+  bool Write(const void* data, size_t size) {
+    const char* from = static_cast<const char*>(data);
+    while (size > 0) {
+      void* buffer;
+      int buffer_size;
+      if (!sub_stream_->Next(&buffer, &buffer_size)) {
+        error_ = Z_BUF_ERROR;
+        return false;
+      }
+      const size_t n = std::min(size, static_cast<size_t>(buffer_size));
+      memcpy(buffer, from, n);
+      sub_stream_->BackUp(buffer_size - static_cast<int>(n));
+      from += n;
+      size -= n;
+    }
+    return true;
+  }
+
+  bool HasWork() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !queue_.empty() || stopping_;
+  }
+
+  void Work() {
+    while (true) {
+      Block* block;
+      {
+        absl::MutexLock lock(&mutex_);
+        mutex_.Await(absl::Condition(this, &ParallelDeflater::HasWork));
+        if (queue_.empty()) return;
+        block = queue_.front();
+        queue_.pop_front();
+      }
+      Compress(block);
+      absl::MutexLock lock(&mutex_);
+      block->done = true;
+    }
+  }
+
+  void Compress(Block* block) const {
+    const std::string& input = block->input;
+    const Bytef* in = reinterpret_cast<const Bytef*>(input.data());
+    const uInt in_size = static_cast<uInt>(input.size());
+    block->check = gzip_ ? crc32(crc32(0, Z_NULL, 0), in, in_size)
+                         : adler32(adler32(0, Z_NULL, 0), in, in_size);
+
+    z_stream zcontext;
+    zcontext.zalloc = Z_NULL;
+    zcontext.zfree = Z_NULL;
+    zcontext.opaque = Z_NULL;
+    // Negative windowBits: a raw deflate stream, with no header or trailer.
+    int error = deflateInit2(&zcontext, level_, Z_DEFLATED, -15,
+                             /* memLevel (default) */ 8, strategy_);
+    if (error != Z_OK) {
+      block->error = error;
+      return;
+    }
+    if (!block->dictionary.empty()) {
+      error = deflateSetDictionary(
+          &zcontext, reinterpret_cast<const Bytef*>(block->dictionary.data()),
+          static_cast<uInt>(block->dictionary.size()));
+    }
+    std::string& output = block->output;
+    output.resize(deflateBound(&zcontext, in_size) + 16);
+    zcontext.next_in = const_cast<Bytef*>(in);
+    zcontext.avail_in = in_size;
+    size_t produced = 0;
+    while (error == Z_OK) {
+      if (produced == output.size()) output.resize(2 * output.size());
+      zcontext.next_out = reinterpret_cast<Bytef*>(&output[produced]);
+      zcontext.avail_out = static_cast<uInt>(output.size() - produced);
+      error = deflate(&zcontext, block->last ? Z_FINISH : Z_SYNC_FLUSH);
+      produced = output.size() - zcontext.avail_out;
+      // A sync flush is complete once deflate() leaves output space.
+      if (!block->last && zcontext.avail_out != 0) break;
+    }
+    output.resize(produced);
+    deflateEnd(&zcontext);
+    if (block->last ? error == Z_STREAM_END
+                    : error == Z_OK || error == Z_BUF_ERROR) {
+      error = Z_OK;
+    }
+    block->error = error;
+  }
+
+  ZeroCopyOutputStream* sub_stream_;
+  const bool gzip_;
+  const int level_;
+  const int strategy_;
+  const size_t block_size_;
+  // The most blocks in flight before Next() waits for the oldest.
+  const size_t max_pending_;
+
+  // The block being filled by the caller.
+  std::string block_;
+  size_t block_used_ = 0;
+  // The last kWindowSize bytes of input submitted so far.
+  std::string window_;
+  int64_t byte_count_ = 0;
+  bool header_written_ = false;
+  uLong check_;
+  int error_ = Z_OK;
+
+  // Submitted blocks, oldest first.  Only the caller's thread uses this.
+  std::deque<std::unique_ptr<Block>> pending_;
+
+  absl::Mutex mutex_;
+  // Blocks waiting for a worker.
+  std::deque<Block*> queue_ ABSL_GUARDED_BY(mutex_);
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<std::thread> threads_;
+};
 
 GzipOutputStream::GzipOutputStream(ZeroCopyOutputStream* sub_stream) {
   Init(sub_stream, Options());
@@ -233,6 +552,11 @@ void GzipOutputStream::Init(ZeroCopyOutputStream* sub_stream,
   zcontext_.avail_in = 0;
   zcontext_.total_in = 0;
   zcontext_.msg = NULL;
+  if (options.num_threads > 1) {
+    parallel_ = std::make_unique<ParallelDeflater>(sub_stream, options);
+    zerror_ = Z_OK;
+    return;
+  }
   // default to GZIP format
   int windowBitsFormat = 16;
   if (options.format == ZLIB) {
@@ -278,6 +602,11 @@ int GzipOutputStream::Deflate(int flush) {
 
 // implements ZeroCopyOutputStream ---------------------------------
 bool GzipOutputStream::Next(void** data, int* size) {
+  if (parallel_ != nullptr) {
+    bool ok = parallel_->Next(data, size);
+    zerror_ = parallel_->error();
+    return ok;
+  }
   if ((zerror_ != Z_OK) && (zerror_ != Z_BUF_ERROR)) {
     return false;
   }
@@ -300,14 +629,24 @@ bool GzipOutputStream::Next(void** data, int* size) {
   return true;
 }
 void GzipOutputStream::BackUp(int count) {
+  if (parallel_ != nullptr) {
+    parallel_->BackUp(count);
+    return;
+  }
   ABSL_CHECK_GE(zcontext_.avail_in, static_cast<uInt>(count));
   zcontext_.avail_in -= count;
 }
 int64_t GzipOutputStream::ByteCount() const {
+  if (parallel_ != nullptr) return parallel_->ByteCount();
   return zcontext_.total_in + zcontext_.avail_in;
 }
 
 bool GzipOutputStream::Flush() {
+  if (parallel_ != nullptr) {
+    bool ok = parallel_->Flush();
+    zerror_ = parallel_->error();
+    return ok;
+  }
   zerror_ = Deflate(Z_FULL_FLUSH);
   // Return true if the flush succeeded or if it was a no-op.
   return (zerror_ == Z_OK) ||
@@ -316,6 +655,11 @@ bool GzipOutputStream::Flush() {
 }
 
 bool GzipOutputStream::Close() {
+  if (parallel_ != nullptr) {
+    bool ok = parallel_->Close();
+    zerror_ = parallel_->error();
+    return ok;
+  }
   if ((zerror_ != Z_OK) && (zerror_ != Z_BUF_ERROR)) {
     return false;
   }
@@ -43,6 +43,8 @@
 #ifndef GOOGLE_PROTOBUF_IO_GZIP_STREAM_H__
 #define GOOGLE_PROTOBUF_IO_GZIP_STREAM_H__
 
+#include <memory>
+
 #include "google/protobuf/stubs/common.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/port.h"
@@ -55,6 +57,8 @@ namespace google {
 namespace protobuf {
 namespace io {
 
+class BufferPool;
+
 // A ZeroCopyInputStream that reads compressed data through zlib
 class PROTOBUF_EXPORT GzipInputStream final : public ZeroCopyInputStream {
  public:
@@ -73,6 +77,10 @@ class PROTOBUF_EXPORT GzipInputStream final : public ZeroCopyInputStream {
   // buffer_size and format may be -1 for default of 64kB and GZIP format
   explicit GzipInputStream(ZeroCopyInputStream* sub_stream,
                            Format format = AUTO, int buffer_size = -1);
+  // As above, but allocates the output buffer from `buffer_pool`, which must
+  // outlive the stream.
+  GzipInputStream(ZeroCopyInputStream* sub_stream, Format format,
+                  int buffer_size, BufferPool* buffer_pool);
   GzipInputStream(const GzipInputStream&) = delete;
   GzipInputStream& operator=(const GzipInputStream&) = delete;
   ~GzipInputStream() override;
@@ -98,6 +106,8 @@ class PROTOBUF_EXPORT GzipInputStream final : public ZeroCopyInputStream {
   void* output_buffer_;
   void* output_position_;
   size_t output_buffer_length_;
+  // The pool output_buffer_ comes from, if any.
+  BufferPool* buffer_pool_;
   int64_t byte_count_;
 
   int Inflate(int flush);
@@ -131,6 +141,17 @@ class PROTOBUF_EXPORT GzipOutputStream final : public ZeroCopyOutputStream {
     // zlib.h for definitions of these constants.
     int compression_strategy;
 
+    // The number of threads to compress on.  With more than one, the input
+    // is cut into blocks of block_size bytes, which are compressed on
+    // background threads and written in order as one stream, the way pigz
+    // does.  Each block is primed with the 32kB of input before it, so the
+    // ratio stays close to that of a single thread.  Defaults to 1, which
+    // compresses on the calling thread.
+    int num_threads;
+
+    // The size of the blocks compressed in parallel.  Defaults to 128kB.
+    int block_size;
+
     Options();  // Initializes with default values.
   };
 
@@ -149,6 +170,7 @@ class PROTOBUF_EXPORT GzipOutputStream final : public ZeroCopyOutputStream {
   inline int ZlibErrorCode() const { return zerror_; }
 
   // Flushes data written so far to zipped data in the underlying stream.
+  // With num_threads > 1 this waits for all blocks to be compressed.
   // It is the caller's responsibility to flush the underlying stream if
   // necessary.
   // Compression may be less efficient stopping and starting around flushes.
@@ -184,6 +206,11 @@ class PROTOBUF_EXPORT GzipOutputStream final : public ZeroCopyOutputStream {
   void* input_buffer_;
   size_t input_buffer_length_;
 
+  // Compresses on background threads, if options.num_threads > 1.  All the
+  // other state is then unused.
+  class ParallelDeflater;
+  std::unique_ptr<ParallelDeflater> parallel_;
+
   // Shared constructor code.
   void Init(ZeroCopyOutputStream* sub_stream, const Options& options);
 
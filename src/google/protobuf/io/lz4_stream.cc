@@ -0,0 +1,250 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the implementation of classes Lz4InputStream and
+// Lz4OutputStream.
+
+#if HAVE_LZ4
+#include "google/protobuf/io/lz4_stream.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "absl/log/absl_check.h"
+#include "google/protobuf/port.h"
+#include "lz4frame.h"
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+static const int kDefaultBufferSize = 65536;
+
+Lz4InputStream::Lz4InputStream(ZeroCopyInputStream* sub_stream,
+                               int buffer_size)
+    : sub_stream_(sub_stream),
+      output_buffer_length_(buffer_size == -1 ? kDefaultBufferSize
+                                              : buffer_size) {
+  ABSL_CHECK_GT(output_buffer_length_, 0u);
+  output_buffer_ = static_cast<char*>(operator new(output_buffer_length_));
+  LZ4F_errorCode_t result =
+      LZ4F_createDecompressionContext(&context_, LZ4F_VERSION);
+  if (LZ4F_isError(result)) error_message_ = LZ4F_getErrorName(result);
+}
+
+Lz4InputStream::~Lz4InputStream() {
+  internal::SizedDelete(output_buffer_, output_buffer_length_);
+  LZ4F_freeDecompressionContext(context_);
+}
+
+bool Lz4InputStream::Decompress() {
+  if (error_message_ != nullptr) return false;
+  byte_count_ += output_end_;
+  output_position_ = 0;
+  output_end_ = 0;
+  while (output_end_ == 0) {
+    // A full output buffer may have left decompressed data inside the
+    // context, which must be drained before reading more input.
+    if (input_size_ == 0 && !flush_pending_) {
+      const void* data;
+      int size;
+      if (!sub_stream_->Next(&data, &size)) {
+        if (in_frame_) error_message_ = "Truncated LZ4 frame";
+        return false;
+      }
+      input_ = static_cast<const char*>(data);
+      input_size_ = size;
+    }
+    size_t output_size = output_buffer_length_;
+    size_t consumed = input_size_;
+    size_t result = LZ4F_decompress(context_, output_buffer_, &output_size,
+                                    input_, &consumed, nullptr);
+    if (LZ4F_isError(result)) {
+      error_message_ = LZ4F_getErrorName(result);
+      return false;
+    }
+    input_ += consumed;
+    input_size_ -= consumed;
+    // 0 means the end of a frame; another may follow.  A call that found
+    // nothing to do reports the size of the next frame's header instead.
+    if (consumed != 0 || output_size != 0) in_frame_ = result != 0;
+    flush_pending_ = output_size == output_buffer_length_;
+    output_end_ = output_size;
+  }
+  return true;
+}
+
+// implements ZeroCopyInputStream ----------------------------------
+bool Lz4InputStream::Next(const void** data, int* size) {
+  if (output_position_ == output_end_ && !Decompress()) return false;
+  *data = output_buffer_ + output_position_;
+  *size = static_cast<int>(output_end_ - output_position_);
+  output_position_ = output_end_;
+  return true;
+}
+void Lz4InputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(static_cast<size_t>(count), output_position_);
+  output_position_ -= count;
+}
+bool Lz4InputStream::Skip(int count) {
+  const void* data;
+  int size = 0;
+  bool ok = Next(&data, &size);
+  while (ok && (size < count)) {
+    count -= size;
+    ok = Next(&data, &size);
+  }
+  if (size > count) {
+    BackUp(size - count);
+  }
+  return ok;
+}
+int64_t Lz4InputStream::ByteCount() const {
+  return byte_count_ + static_cast<int64_t>(output_position_);
+}
+
+// =========================================================================
+
+Lz4OutputStream::Options::Options()
+    : buffer_size(kDefaultBufferSize), compression_level(0) {}
+
+Lz4OutputStream::Lz4OutputStream(ZeroCopyOutputStream* sub_stream)
+    : Lz4OutputStream(sub_stream, Options()) {}
+
+Lz4OutputStream::Lz4OutputStream(ZeroCopyOutputStream* sub_stream,
+                                 const Options& options)
+    : sub_stream_(sub_stream), input_buffer_length_(options.buffer_size) {
+  ABSL_CHECK_GT(options.buffer_size, 0);
+  memset(&preferences_, 0, sizeof(preferences_));
+  preferences_.compressionLevel = options.compression_level;
+  input_buffer_ = static_cast<char*>(operator new(input_buffer_length_));
+  output_buffer_length_ =
+      std::max<size_t>(LZ4F_compressBound(input_buffer_length_, &preferences_),
+                       LZ4F_HEADER_SIZE_MAX);
+  output_buffer_ = static_cast<char*>(operator new(output_buffer_length_));
+  LZ4F_errorCode_t result =
+      LZ4F_createCompressionContext(&context_, LZ4F_VERSION);
+  if (LZ4F_isError(result)) error_message_ = LZ4F_getErrorName(result);
+}
+
+Lz4OutputStream::~Lz4OutputStream() {
+  Close();
+  internal::SizedDelete(input_buffer_, input_buffer_length_);
+  internal::SizedDelete(output_buffer_, output_buffer_length_);
+  LZ4F_freeCompressionContext(context_);
+}
+
+// private
+bool Lz4OutputStream::WriteOutput(size_t result) {
+  if (LZ4F_isError(result)) {
+    error_message_ = LZ4F_getErrorName(result);
+    return false;
+  }
+  const char* output = output_buffer_;
+  while (result > 0) {
+    void* data;
+    int size;
+    if (!sub_stream_->Next(&data, &size)) {
+      error_message_ = "Failed to write to the underlying stream";
+      return false;
+    }
+    const size_t n = std::min<size_t>(size, result);
+    memcpy(data, output, n);
+    output += n;
+    result -= n;
+    if (n < static_cast<size_t>(size)) {
+      sub_stream_->BackUp(static_cast<int>(size - n));
+    }
+  }
+  return true;
+}
+
+bool Lz4OutputStream::Compress() {
+  if (!started_) {
+    started_ = true;
+    if (!WriteOutput(LZ4F_compressBegin(context_, output_buffer_,
+                                        output_buffer_length_,
+                                        &preferences_))) {
+      return false;
+    }
+  }
+  if (input_size_ == 0) return true;
+  if (!WriteOutput(LZ4F_compressUpdate(context_, output_buffer_,
+                                       output_buffer_length_, input_buffer_,
+                                       input_size_, nullptr))) {
+    return false;
+  }
+  byte_count_ += input_size_;
+  input_size_ = 0;
+  return true;
+}
+
+// implements ZeroCopyOutputStream ---------------------------------
+bool Lz4OutputStream::Next(void** data, int* size) {
+  if (closed_ || error_message_ != nullptr) return false;
+  if (input_size_ != 0 && !Compress()) return false;
+  *data = input_buffer_;
+  *size = static_cast<int>(input_buffer_length_);
+  input_size_ = input_buffer_length_;
+  return true;
+}
+void Lz4OutputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(static_cast<size_t>(count), input_size_);
+  input_size_ -= count;
+}
+int64_t Lz4OutputStream::ByteCount() const {
+  return byte_count_ + static_cast<int64_t>(input_size_);
+}
+
+bool Lz4OutputStream::Flush() {
+  if (closed_ || error_message_ != nullptr) return false;
+  return Compress() &&
+         WriteOutput(LZ4F_flush(context_, output_buffer_,
+                                output_buffer_length_, nullptr));
+}
+
+bool Lz4OutputStream::Close() {
+  if (closed_) return error_message_ == nullptr;
+  closed_ = true;
+  if (error_message_ != nullptr) return false;
+  return Compress() &&
+         WriteOutput(LZ4F_compressEnd(context_, output_buffer_,
+                                      output_buffer_length_, nullptr));
+}
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+#endif  // HAVE_LZ4
@@ -0,0 +1,179 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the definition for classes Lz4InputStream and
+// Lz4OutputStream, which are the counterparts of GzipInputStream and
+// GzipOutputStream for the LZ4 frame format.  LZ4 compresses less than
+// zlib or Zstandard but is the fastest of the three by far, which suits
+// data that is written once and read soon after.
+
+#ifndef GOOGLE_PROTOBUF_IO_LZ4_STREAM_H__
+#define GOOGLE_PROTOBUF_IO_LZ4_STREAM_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "lz4frame.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+// A ZeroCopyInputStream that reads LZ4 frames.  Concatenated frames are
+// decompressed one after the other.
+class PROTOBUF_EXPORT Lz4InputStream final : public ZeroCopyInputStream {
+ public:
+  // buffer_size may be -1 for the default of 64kB.
+  explicit Lz4InputStream(ZeroCopyInputStream* sub_stream,
+                          int buffer_size = -1);
+  Lz4InputStream(const Lz4InputStream&) = delete;
+  Lz4InputStream& operator=(const Lz4InputStream&) = delete;
+  ~Lz4InputStream() override;
+
+  // Return last error message or NULL if no error.
+  const char* Lz4ErrorMessage() const { return error_message_; }
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  ZeroCopyInputStream* sub_stream_;
+  LZ4F_dctx* context_ = nullptr;
+  const char* error_message_ = nullptr;
+
+  // The part of the sub stream's last buffer that is not decompressed yet.
+  const char* input_ = nullptr;
+  size_t input_size_ = 0;
+  // Whether the input read so far ends in the middle of a frame.
+  bool in_frame_ = false;
+  // Whether the last decompression filled the output buffer, so that the
+  // context may still hold decompressed data.
+  bool flush_pending_ = false;
+
+  char* output_buffer_;
+  size_t output_buffer_length_;
+  // Decompressed data in [output_position_, output_end_) is yet to be
+  // returned by Next().
+  size_t output_position_ = 0;
+  size_t output_end_ = 0;
+  // Bytes decompressed into the output buffer before its current contents.
+  int64_t byte_count_ = 0;
+
+  // Refills the output buffer.  Returns false at the end of the input or on
+  // error.
+  bool Decompress();
+};
+
+// A ZeroCopyOutputStream that writes an LZ4 frame.
+class PROTOBUF_EXPORT Lz4OutputStream final : public ZeroCopyOutputStream {
+ public:
+  struct PROTOBUF_EXPORT Options {
+    // What size buffer to use internally.  Defaults to 64kB.
+    int buffer_size;
+
+    // 0 selects the default fast mode.  Levels from 3 up to
+    // LZ4F_compressionLevel_max() use LZ4HC, which compresses better and
+    // much more slowly, and negative levels compress faster and less.
+    // Defaults to 0.
+    int compression_level;
+
+    Options();  // Initializes with default values.
+  };
+
+  // Create an Lz4OutputStream with default options.
+  explicit Lz4OutputStream(ZeroCopyOutputStream* sub_stream);
+
+  // Create an Lz4OutputStream with the given options.
+  Lz4OutputStream(ZeroCopyOutputStream* sub_stream, const Options& options);
+  Lz4OutputStream(const Lz4OutputStream&) = delete;
+  Lz4OutputStream& operator=(const Lz4OutputStream&) = delete;
+
+  ~Lz4OutputStream() override;
+
+  // Return last error message or NULL if no error.
+  const char* Lz4ErrorMessage() const { return error_message_; }
+
+  // Flushes data written so far to compressed data in the underlying stream,
+  // so that a reader can decompress it without waiting for Close().  It is
+  // the caller's responsibility to flush the underlying stream if necessary.
+  // Returns true if no error.
+  bool Flush();
+
+  // Writes out all data and ends the LZ4 frame.  It is the caller's
+  // responsibility to close the underlying stream if necessary.
+  // Returns true if no error.
+  bool Close();
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  ZeroCopyOutputStream* sub_stream_;
+  LZ4F_cctx* context_ = nullptr;
+  LZ4F_preferences_t preferences_;
+  const char* error_message_ = nullptr;
+  bool started_ = false;
+  bool closed_ = false;
+
+  char* input_buffer_;
+  size_t input_buffer_length_;
+  // The bytes of the input buffer handed out by Next() and not backed up.
+  size_t input_size_ = 0;
+  // Bytes compressed before the current contents of the input buffer.
+  int64_t byte_count_ = 0;
+
+  // LZ4F needs room for the worst case of every call, which the sub stream's
+  // buffers do not guarantee, so it compresses into this buffer first.
+  char* output_buffer_;
+  size_t output_buffer_length_;
+
+  // Compresses the input buffer.  Returns false on error.
+  bool Compress();
+  // Checks the result of an LZ4F call that wrote `result` bytes to the
+  // output buffer, and copies them to the sub stream.
+  bool WriteOutput(size_t result);
+};
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_IO_LZ4_STREAM_H__
@@ -0,0 +1,162 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/io/ring_buffer_stream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <new>
+
+#include "absl/log/absl_check.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+constexpr size_t RingBuffer::kHeaderSize;
+constexpr size_t RingBuffer::kAlignment;
+
+RingBuffer::RingBuffer(void* region, size_t size)
+    : header_(static_cast<Header*>(region)),
+      data_(static_cast<char*>(region) + kHeaderSize),
+      capacity_(size - kHeaderSize) {
+  ABSL_CHECK_EQ(reinterpret_cast<uintptr_t>(region) % kAlignment, 0u)
+      << "RingBuffer region must be aligned to " << kAlignment << " bytes.";
+  ABSL_CHECK_GT(size, kHeaderSize);
+}
+
+void RingBuffer::Reset() {
+  new (&header_->write_position) std::atomic<uint64_t>(0);
+  new (&header_->read_position) std::atomic<uint64_t>(0);
+}
+
+size_t RingBuffer::size() const {
+  // Load the read position first, so the difference can't be negative.
+  uint64_t read = header_->read_position.load(std::memory_order_acquire);
+  uint64_t write = header_->write_position.load(std::memory_order_acquire);
+  return static_cast<size_t>(write - read);
+}
+
+char* RingBuffer::Contiguous(uint64_t position, uint64_t available,
+                             int* size) const {
+  size_t offset = static_cast<size_t>(position % capacity_);
+  uint64_t n = std::min<uint64_t>(available, capacity_ - offset);
+  *size = static_cast<int>(std::min<uint64_t>(n, INT_MAX));
+  return data_ + offset;
+}
+
+// ===================================================================
+
+RingOutputStream::RingOutputStream(RingBuffer* ring)
+    : ring_(ring),
+      start_(ring->header_->write_position.load(std::memory_order_relaxed)),
+      position_(start_) {}
+
+void RingOutputStream::Commit() {
+  ring_->header_->write_position.store(position_, std::memory_order_release);
+}
+
+bool RingOutputStream::Next(void** data, int* size) {
+  // Acquire, so the consumer is done with the space before it is reused.
+  uint64_t read =
+      ring_->header_->read_position.load(std::memory_order_acquire);
+  uint64_t available = ring_->capacity_ - (position_ - read);
+  if (available == 0) return false;
+  *data = ring_->Contiguous(position_, available, size);
+  position_ += *size;
+  return true;
+}
+
+void RingOutputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(static_cast<uint64_t>(count), position_ - start_);
+  position_ -= count;
+}
+
+int64_t RingOutputStream::ByteCount() const {
+  return static_cast<int64_t>(position_ - start_);
+}
+
+// ===================================================================
+
+RingInputStream::RingInputStream(RingBuffer* ring)
+    : ring_(ring),
+      start_(ring->header_->read_position.load(std::memory_order_relaxed)),
+      position_(start_) {}
+
+void RingInputStream::Commit() {
+  ring_->header_->read_position.store(position_, std::memory_order_release);
+}
+
+bool RingInputStream::Next(const void** data, int* size) {
+  // Acquire, so the producer's writes to the data are visible.
+  uint64_t write =
+      ring_->header_->write_position.load(std::memory_order_acquire);
+  uint64_t available = write - position_;
+  if (available == 0) return false;
+  *data = ring_->Contiguous(position_, available, size);
+  position_ += *size;
+  return true;
+}
+
+void RingInputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(static_cast<uint64_t>(count), position_ - start_);
+  position_ -= count;
+}
+
+bool RingInputStream::Skip(int count) {
+  ABSL_CHECK_GE(count, 0);
+  uint64_t write =
+      ring_->header_->write_position.load(std::memory_order_acquire);
+  uint64_t available = write - position_;
+  if (static_cast<uint64_t>(count) > available) {
+    position_ = write;
+    return false;
+  }
+  position_ += count;
+  return true;
+}
+
+int64_t RingInputStream::ByteCount() const {
+  return static_cast<int64_t>(position_ - start_);
+}
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
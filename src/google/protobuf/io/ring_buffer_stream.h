@@ -0,0 +1,190 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// This file contains RingBuffer, a single-producer single-consumer ring of
+// bytes laid out in caller-provided memory, and RingOutputStream and
+// RingInputStream, which serialize into and parse out of it in place.
+//
+// The ring is meant for passing messages between processes through shared
+// memory: all of its state lives in the region, and its read and write
+// positions are lock-free atomics.  A message that wraps around the end of
+// the region is simply returned as two buffers, whose seam the parser and
+// serializer bridge with their own patch buffers.
+//
+// Producer:
+//
+//   RingBuffer ring(region, region_size);
+//   RingOutputStream output(&ring);
+//   if (message.SerializeToZeroCopyStream(&output)) output.Commit();
+//
+// Consumer:
+//
+//   RingBuffer ring(region, region_size);
+//   RingInputStream input(&ring);
+//   if (message.ParseFromBoundedZeroCopyStream(&input, size)) input.Commit();
+//
+// The ring does not frame messages; write a size before each message (e.g.
+// with SerializeDelimitedToZeroCopyStream()) if the consumer cannot tell
+// where one ends otherwise.
+
+#ifndef GOOGLE_PROTOBUF_IO_RING_BUFFER_STREAM_H__
+#define GOOGLE_PROTOBUF_IO_RING_BUFFER_STREAM_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "google/protobuf/io/zero_copy_stream.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+// A view of a ring buffer stored in a region of memory that may be mapped
+// into several processes.  The region starts with a header holding the read
+// and write positions; the rest holds the data.  One process (or thread) may
+// write to the ring and one may read from it, concurrently.
+class PROTOBUF_EXPORT RingBuffer {
+ public:
+  // The number of bytes at the start of the region taken up by the header.
+  static constexpr size_t kHeaderSize = 128;
+  // The required alignment of the region.
+  static constexpr size_t kAlignment = 64;
+
+  // Attaches to the ring in `region`, which is `size` bytes long.  `region`
+  // must be aligned to kAlignment and `size` must exceed kHeaderSize.  The
+  // ring must have been initialized with Reset() once, by any one party.
+  RingBuffer(void* region, size_t size);
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  // Empties the ring.  Must not be called while another party is using it.
+  void Reset();
+
+  // The number of bytes of data the ring can hold.
+  size_t capacity() const { return capacity_; }
+  // The number of bytes committed by the producer that the consumer has not
+  // yet released.
+  size_t size() const;
+
+ private:
+  friend class RingOutputStream;
+  friend class RingInputStream;
+
+  // The positions count bytes written and read since Reset(); they are
+  // reduced modulo capacity_ to index data_.  They are on separate cache
+  // lines so the producer and consumer don't contend.
+  struct Header {
+    alignas(kAlignment) std::atomic<uint64_t> write_position;
+    alignas(kAlignment) std::atomic<uint64_t> read_position;
+  };
+  static_assert(sizeof(Header) <= kHeaderSize, "header too large");
+#if defined(__cpp_lib_atomic_is_always_lock_free)
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "RingBuffer requires lock-free 64-bit atomics");
+#endif
+
+  // Returns a contiguous piece of data_ starting at `position`, at most
+  // `available` bytes long.
+  char* Contiguous(uint64_t position, uint64_t available, int* size) const;
+
+  Header* header_;
+  char* data_;
+  size_t capacity_;
+};
+
+// A ZeroCopyOutputStream that writes into a RingBuffer.  Nothing written is
+// visible to the consumer until Commit() is called, so a message that fails to
+// serialize (for instance because the ring is full) is simply dropped by
+// destroying the stream.  Next() returns false when the ring is full; it never
+// waits for the consumer.
+class PROTOBUF_EXPORT RingOutputStream final : public ZeroCopyOutputStream {
+ public:
+  // Only one RingOutputStream may be used with a ring at a time.
+  explicit RingOutputStream(RingBuffer* ring);
+  RingOutputStream(const RingOutputStream&) = delete;
+  RingOutputStream& operator=(const RingOutputStream&) = delete;
+  // Discards anything written since the last Commit().
+  ~RingOutputStream() override = default;
+
+  // Publishes everything written so far to the consumer.
+  void Commit();
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  RingBuffer* ring_;
+  uint64_t start_;     // Write position at construction.
+  uint64_t position_;  // Write position including uncommitted data.
+};
+
+// A ZeroCopyInputStream that reads committed data out of a RingBuffer.  The
+// space taken up by the data read is not handed back to the producer until
+// Commit() is called.  Next() returns false once all data committed so far
+// has been read; it never waits for the producer.
+class PROTOBUF_EXPORT RingInputStream final : public ZeroCopyInputStream {
+ public:
+  // Only one RingInputStream may be used with a ring at a time.
+  explicit RingInputStream(RingBuffer* ring);
+  RingInputStream(const RingInputStream&) = delete;
+  RingInputStream& operator=(const RingInputStream&) = delete;
+  // Leaves anything read since the last Commit() in the ring, to be read
+  // again.
+  ~RingInputStream() override = default;
+
+  // Releases the space taken by everything read so far to the producer.
+  void Commit();
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  RingBuffer* ring_;
+  uint64_t start_;     // Read position at construction.
+  uint64_t position_;  // Read position including unreleased data.
+};
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_IO_RING_BUFFER_STREAM_H__
@@ -40,6 +40,12 @@
 #include <string>
 #include <system_error>  // NOLINT(build/c++11)
 
+#if defined(__has_include)
+#if __cplusplus >= 201703L && __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
 #include "absl/log/absl_check.h"
 #include "absl/strings/charconv.h"
 #include "absl/strings/numbers.h"
@@ -131,11 +137,12 @@ double NoLocaleStrtod(const char *str, char **endptr) {
 //    one in that it makes guesses and then uses strtod() to check them.
 //    Their implementation is faster because they use their own code to
 //    generate the digits in the first place rather than use snprintf(),
-//    thus avoiding format string parsing overhead.  However, this makes
-//    it considerably more complicated than the following implementation,
-//    and it is embedded in a larger library.  If speed turns out to be
-//    an issue, we could re-implement this in terms of their
-//    implementation.
+//    thus avoiding format string parsing overhead.
+//
+//    Where the standard library has floating-point std::to_chars(), we
+//    instead start from the shortest representation that round-trips, which
+//    it computes much faster than snprintf(), and lay it out as snprintf()
+//    would have; see FormatShortestGeneral().  The output is unchanged.
 // ----------------------------------------------------------------------
 
 namespace {
@@ -178,12 +185,85 @@ void DelocalizeRadix(char *buffer) {
   }
 }
 
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+// Writes `value` to `buffer` as snprintf(buffer, size, "%.*g", precision,
+// value) would: to_chars() with a precision is specified to match it.
+template <typename T>
+void FormatGeneral(char *buffer, int size, int precision, T value) {
+  auto result = std::to_chars(buffer, buffer + size - 1, value,
+                              std::chars_format::general, precision);
+  // Should never overflow; see above.
+  ABSL_DCHECK(result.ec == std::errc());
+  *result.ptr = '\0';
+}
+
+// Writes `value` to `buffer` as snprintf(buffer, size, "%.*g", precision,
+// value) would and returns true, if that parses back to `value`.  Otherwise
+// returns false.
+//
+// For a `precision` no larger than DBL_DIG (or FLT_DIG for floats), "%.*g"
+// parses back to `value` exactly when the shortest representation that does
+// has at most `precision` digits, and then both have the same digits: the
+// shortest representation is within half an ulp of `value`, which is less
+// than half the distance between `precision`-digit decimals.  So we only
+// need to lay out the shortest representation the way "%g" would.  This does
+// not hold for subnormals, which callers must handle separately.
+template <typename T>
+bool FormatShortestGeneral(char *buffer, int precision, T value) {
+  // [-]d[.ddd]e(+|-)dd[d]
+  char scientific[32];
+  auto result = std::to_chars(scientific, scientific + sizeof(scientific),
+                              value, std::chars_format::scientific);
+  ABSL_DCHECK(result.ec == std::errc());
+  *result.ptr = '\0';
+
+  const char *p = scientific;
+  char *out = buffer;
+  if (*p == '-') *out++ = *p++;
+  char digits[20];
+  int digit_count = 0;
+  for (; *p != 'e'; ++p) {
+    if (*p == '.') continue;
+    if (digit_count == precision) return false;
+    digits[digit_count++] = *p;
+  }
+  int exponent = 0;
+  for (const char *e = p + 2; *e != '\0'; ++e) exponent = exponent * 10 + (*e - '0');
+  if (p[1] == '-') exponent = -exponent;
+
+  if (exponent < -4 || exponent >= precision) {
+    // "%g" uses scientific notation, with trailing zeros removed.
+    memcpy(buffer, scientific, static_cast<size_t>(result.ptr - scientific) + 1);
+    return true;
+  }
+  if (exponent >= 0) {
+    for (int i = 0; i <= exponent; ++i) {
+      *out++ = i < digit_count ? digits[i] : '0';
+    }
+    if (digit_count > exponent + 1) {
+      *out++ = '.';
+      memcpy(out, digits + exponent + 1,
+             static_cast<size_t>(digit_count - exponent - 1));
+      out += digit_count - exponent - 1;
+    }
+  } else {
+    *out++ = '0';
+    *out++ = '.';
+    for (int i = -1; i > exponent; --i) *out++ = '0';
+    memcpy(out, digits, static_cast<size_t>(digit_count));
+    out += digit_count;
+  }
+  *out = '\0';
+  return true;
+}
+#else
 bool safe_strtof(const char *str, float *value) {
   char *endptr;
   errno = 0;  // errno only gets set on errors
   *value = strtof(str, &endptr);
   return *str != 0 && *endptr == 0 && errno == 0;
 }
+#endif
 
 char *FloatToBuffer(float value, char *buffer) {
   // FLT_DIG is 6 for IEEE-754 floats, which are used on almost all
@@ -203,6 +283,15 @@ char *FloatToBuffer(float value, char *buffer) {
     return buffer;
   }
 
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  // strtof() reports subnormal results as out of range, so these have always
+  // been printed with the longer precision.
+  if (std::fpclassify(value) == FP_SUBNORMAL ||
+      !FormatShortestGeneral(buffer, FLT_DIG, value)) {
+    FormatGeneral(buffer, kFloatToBufferSize, FLT_DIG + 3, value);
+  }
+  return buffer;
+#else
   int snprintf_result =
       absl::SNPrintF(buffer, kFloatToBufferSize, "%.*g", FLT_DIG, value);
 
@@ -221,6 +310,7 @@ char *FloatToBuffer(float value, char *buffer) {
 
   DelocalizeRadix(buffer);
   return buffer;
+#endif
 }
 
 char *DoubleToBuffer(double value, char *buffer) {
@@ -241,6 +331,19 @@ char *DoubleToBuffer(double value, char *buffer) {
     return buffer;
   }
 
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  if (std::fpclassify(value) == FP_SUBNORMAL) {
+    // Subnormals have fewer significant bits, so the shortest representation
+    // says nothing about "%.*g"; check that directly.
+    FormatGeneral(buffer, kDoubleToBufferSize, DBL_DIG, value);
+    if (NoLocaleStrtod(buffer, nullptr) != value) {
+      FormatGeneral(buffer, kDoubleToBufferSize, DBL_DIG + 2, value);
+    }
+  } else if (!FormatShortestGeneral(buffer, DBL_DIG, value)) {
+    FormatGeneral(buffer, kDoubleToBufferSize, DBL_DIG + 2, value);
+  }
+  return buffer;
+#else
   int snprintf_result =
       absl::SNPrintF(buffer, kDoubleToBufferSize, "%.*g", DBL_DIG, value);
 
@@ -265,6 +368,7 @@ char *DoubleToBuffer(double value, char *buffer) {
 
   DelocalizeRadix(buffer);
   return buffer;
+#endif
 }
 }  // namespace
 
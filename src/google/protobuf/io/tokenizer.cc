@@ -90,6 +90,9 @@
 
 #include "google/protobuf/io/tokenizer.h"
 
+#include <cstring>
+#include <utility>
+
 #include "google/protobuf/stubs/common.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
@@ -177,6 +180,17 @@ static const int8_t kAsciiToInt[256] = {
 
 inline int DigitValue(char digit) { return kAsciiToInt[digit & 0xFF]; }
 
+// Characters that end a run of plain characters inside a string literal or
+// a block comment.  The bulk scans in ConsumeString() and
+// ConsumeBlockComment() stop at these and let the general code handle them.
+inline bool InStringSpecial(char c, char delimiter) {
+  return c == delimiter || c == '\\' || c == '\n' || c == '\0';
+}
+
+inline bool InBlockCommentSpecial(char c) {
+  return c == '*' || c == '/' || c == '\n' || c == '\0';
+}
+
 // Inline because it's only used in one place.
 inline char TranslateEscape(char c) {
   switch (c) {
@@ -286,6 +300,31 @@ void Tokenizer::NextChar() {
   }
 }
 
+inline void Tokenizer::AdvanceTo(int end) {
+  ABSL_DCHECK_LE(end, buffer_size_);
+  int line = line_;
+  int column = column_;
+  for (const char* p = buffer_ + buffer_pos_; p < buffer_ + end; ++p) {
+    if (*p == '\n') {
+      ++line;
+      column = 0;
+    } else if (*p == '\t') {
+      column += kTabWidth - column % kTabWidth;
+    } else {
+      ++column;
+    }
+  }
+  line_ = line;
+  column_ = column;
+
+  buffer_pos_ = end;
+  if (buffer_pos_ < buffer_size_) {
+    current_char_ = buffer_[buffer_pos_];
+  } else {
+    Refresh();
+  }
+}
+
 void Tokenizer::Refresh() {
   if (read_error_) {
     current_char_ = '\0';
@@ -377,8 +416,14 @@ inline bool Tokenizer::TryConsume(char c) {
 
 template <typename CharacterClass>
 inline void Tokenizer::ConsumeZeroOrMore() {
+  // Scan the rest of the current buffer directly; a run that crosses into
+  // the next buffer is picked up again after the refresh.
   while (CharacterClass::InClass(current_char_)) {
-    NextChar();
+    int end = buffer_pos_ + 1;
+    while (end < buffer_size_ && CharacterClass::InClass(buffer_[end])) {
+      ++end;
+    }
+    AdvanceTo(end);
   }
 }
 
@@ -387,9 +432,7 @@ inline void Tokenizer::ConsumeOneOrMore(const char* error) {
   if (!CharacterClass::InClass(current_char_)) {
     AddError(error);
   } else {
-    do {
-      NextChar();
-    } while (CharacterClass::InClass(current_char_));
+    ConsumeZeroOrMore<CharacterClass>();
   }
 }
 
@@ -455,7 +498,12 @@ void Tokenizer::ConsumeString(char delimiter) {
           NextChar();
           return;
         }
-        NextChar();
+        // Skip to the next character that needs a closer look.
+        int end = buffer_pos_ + 1;
+        while (end < buffer_size_ && !InStringSpecial(buffer_[end], delimiter)) {
+          ++end;
+        }
+        AdvanceTo(end);
         break;
       }
     }
@@ -521,7 +569,18 @@ void Tokenizer::ConsumeLineComment(std::string* content) {
   if (content != NULL) RecordTo(content);
 
   while (current_char_ != '\0' && current_char_ != '\n') {
-    NextChar();
+    // Find the end of the line in the current buffer with memchr(), which
+    // is vectorized on most platforms.
+    const char* begin = buffer_ + buffer_pos_;
+    size_t size = buffer_size_ - buffer_pos_;
+    const void* newline = std::memchr(begin, '\n', size);
+    if (newline != nullptr) {
+      size = static_cast<const char*>(newline) - begin;
+    }
+    // A NUL also ends the comment.
+    const void* nul = std::memchr(begin, '\0', size);
+    if (nul != nullptr) size = static_cast<const char*>(nul) - begin;
+    AdvanceTo(buffer_pos_ + static_cast<int>(size));
   }
   TryConsume('\n');
 
@@ -537,7 +596,11 @@ void Tokenizer::ConsumeBlockComment(std::string* content) {
   while (true) {
     while (current_char_ != '\0' && current_char_ != '*' &&
            current_char_ != '/' && current_char_ != '\n') {
-      NextChar();
+      int end = buffer_pos_ + 1;
+      while (end < buffer_size_ && !InBlockCommentSpecial(buffer_[end])) {
+        ++end;
+      }
+      AdvanceTo(end);
     }
 
     if (TryConsume('\n')) {
@@ -629,14 +692,22 @@ bool Tokenizer::TryConsumeNewline() {
 // -------------------------------------------------------------------
 
 bool Tokenizer::Next() {
-  previous_ = current_;
+  // Every path below overwrites all of current_, so swapping saves copying
+  // the token text.
+  using std::swap;
+  swap(previous_, current_);
 
   while (!read_error_) {
-    StartToken();
-    bool report_token = TryConsumeWhitespace() || TryConsumeNewline();
-    EndToken();
-    if (report_token) {
-      return true;
+    if (report_whitespace_) {
+      StartToken();
+      bool report_token = TryConsumeWhitespace() || TryConsumeNewline();
+      EndToken();
+      if (report_token) {
+        return true;
+      }
+    } else {
+      // Whitespace is never reported, so don't bother recording it.
+      ConsumeZeroOrMore<Whitespace>();
     }
 
     switch (TryConsumeCommentStart()) {
@@ -347,6 +347,10 @@ class PROTOBUF_EXPORT Tokenizer {
   // Read a new buffer from the input.
   void Refresh();
 
+  // Consume buffer_[buffer_pos_, end) at once, as if by calling NextChar()
+  // for each character.  `end` must not exceed buffer_size_.
+  inline void AdvanceTo(int end);
+
   inline void RecordTo(std::string* target);
   inline void StopRecording();
 
@@ -444,6 +444,19 @@ MultiTokenCase kMultiTokenCases[] = {
          {Tokenizer::TYPE_END, "", 0, 37, 37},
      }},
 
+    // Test that tabs in comments affect column numbers correctly.
+    {"foo // a\tb\tc",
+     {
+         {Tokenizer::TYPE_IDENTIFIER, "foo", 0, 0, 3},
+         {Tokenizer::TYPE_END, "", 0, 25, 25},
+     }},
+    {"foo /* a\tb\n\t*/ bar",
+     {
+         {Tokenizer::TYPE_IDENTIFIER, "foo", 0, 0, 3},
+         {Tokenizer::TYPE_IDENTIFIER, "bar", 1, 11, 14},
+         {Tokenizer::TYPE_END, "", 1, 14, 14},
+     }},
+
     // Test that sh-style comments are not ignored by default.
     {"foo # bar\n"
      "baz",
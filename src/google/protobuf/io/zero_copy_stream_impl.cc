@@ -38,10 +38,17 @@
 #include <sys/types.h>
 #include <unistd.h>
 #endif
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/uio.h>
+#endif
 #include <errno.h>
 
 #include <algorithm>
+#include <climits>
+#include <cstring>
 #include <iostream>
+#include <memory>
 
 #include "google/protobuf/stubs/common.h"
 #include "absl/log/absl_check.h"
@@ -170,6 +177,85 @@ int FileInputStream::CopyingFileInputStream::Skip(int count) {
 
 // ===================================================================
 
+MmapInputStream::MmapInputStream(int file_descriptor) {
+#ifndef _WIN32
+  struct stat info;
+  const off_t offset = lseek(file_descriptor, 0, SEEK_CUR);
+  if (offset >= 0 && fstat(file_descriptor, &info) == 0 &&
+      S_ISREG(info.st_mode) && info.st_size >= offset) {
+    size_ = static_cast<size_t>(info.st_size - offset);
+    if (size_ == 0) return;
+    // mmap() offsets must be page aligned, so map from the page holding the
+    // current offset.
+    const off_t page_size = sysconf(_SC_PAGESIZE);
+    const off_t map_offset = offset - offset % page_size;
+    mapping_size_ = size_ + static_cast<size_t>(offset - map_offset);
+    mapping_ = mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE,
+                    file_descriptor, map_offset);
+    if (mapping_ != MAP_FAILED) {
+      // Parsing reads the file front to back exactly once.
+      madvise(mapping_, mapping_size_, MADV_SEQUENTIAL);
+      madvise(mapping_, mapping_size_, MADV_WILLNEED);
+      data_ = static_cast<const char*>(mapping_) + (offset - map_offset);
+      return;
+    }
+  }
+#endif
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  size_ = 0;
+  fallback_ = std::make_unique<FileInputStream>(file_descriptor);
+}
+
+MmapInputStream::~MmapInputStream() {
+#ifndef _WIN32
+  if (mapping_ != nullptr) munmap(mapping_, mapping_size_);
+#endif
+}
+
+bool MmapInputStream::Next(const void** data, int* size) {
+  if (fallback_ != nullptr) return fallback_->Next(data, size);
+  if (position_ == size_) {
+    last_returned_size_ = 0;
+    return false;
+  }
+  // Files over 2GB are returned in INT_MAX-sized chunks.
+  last_returned_size_ =
+      static_cast<int>(std::min<size_t>(size_ - position_, INT_MAX));
+  *data = data_ + position_;
+  *size = last_returned_size_;
+  position_ += last_returned_size_;
+  return true;
+}
+
+void MmapInputStream::BackUp(int count) {
+  if (fallback_ != nullptr) return fallback_->BackUp(count);
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(count, last_returned_size_)
+      << "BackUp() can only be called after a successful Next().";
+  position_ -= count;
+  last_returned_size_ = 0;
+}
+
+bool MmapInputStream::Skip(int count) {
+  if (fallback_ != nullptr) return fallback_->Skip(count);
+  ABSL_CHECK_GE(count, 0);
+  last_returned_size_ = 0;
+  if (static_cast<size_t>(count) > size_ - position_) {
+    position_ = size_;
+    return false;
+  }
+  position_ += count;
+  return true;
+}
+
+int64_t MmapInputStream::ByteCount() const {
+  if (fallback_ != nullptr) return fallback_->ByteCount();
+  return static_cast<int64_t>(position_);
+}
+
+// ===================================================================
+
 FileOutputStream::FileOutputStream(int file_descriptor, int block_size)
     : CopyingOutputStreamAdaptor(&copying_output_, block_size),
       copying_output_(file_descriptor) {}
@@ -246,6 +332,271 @@ bool FileOutputStream::CopyingFileOutputStream::Write(const void* buffer,
   return true;
 }
 
+bool FileOutputStream::CopyingFileOutputStream::WriteGathered(
+    const void* first, int first_size, const void* second, int second_size) {
+#ifdef _WIN32
+  return CopyingOutputStream::WriteGathered(first, first_size, second,
+                                            second_size);
+#else
+  ABSL_CHECK(!is_closed_);
+  struct iovec iov[2];
+  iov[0].iov_base = const_cast<void*>(first);
+  iov[0].iov_len = first_size;
+  iov[1].iov_base = const_cast<void*>(second);
+  iov[1].iov_len = second_size;
+
+  int i = first_size == 0 ? 1 : 0;
+  while (i < 2) {
+    ssize_t bytes;
+    do {
+      bytes = writev(file_, iov + i, 2 - i);
+    } while (bytes < 0 && errno == EINTR);
+
+    if (bytes <= 0) {
+      // Write error.  See the comment in Write() about a zero return.
+      if (bytes < 0) {
+        errno_ = errno;
+      }
+      return false;
+    }
+    // Drop whatever the kernel accepted and retry the rest.
+    size_t written = static_cast<size_t>(bytes);
+    while (i < 2 && written >= iov[i].iov_len) {
+      written -= iov[i].iov_len;
+      ++i;
+    }
+    if (i < 2) {
+      iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + written;
+      iov[i].iov_len -= written;
+    }
+  }
+  return true;
+#endif
+}
+
+// ===================================================================
+
+namespace {
+
+// Aliased data smaller than this is cheaper to copy than to track as a
+// separate segment.
+constexpr int kMinAliasedBytes = 512;
+
+#ifndef _WIN32
+#ifdef IOV_MAX
+constexpr size_t kMaxIovecs = IOV_MAX;
+#else
+constexpr size_t kMaxIovecs = 1024;
+#endif
+#endif
+
+}  // namespace
+
+GatheringFileOutputStream::GatheringFileOutputStream(int file_descriptor)
+    : GatheringFileOutputStream(file_descriptor, Options()) {}
+
+GatheringFileOutputStream::GatheringFileOutputStream(int file_descriptor,
+                                                     const Options& options)
+    : file_(file_descriptor),
+      block_size_(options.block_size > 0 ? options.block_size
+                                         : Options().block_size),
+      flush_threshold_(options.flush_threshold) {}
+
+GatheringFileOutputStream::~GatheringFileOutputStream() {
+  if (is_closed_) return;
+  Flush();
+  if (close_on_delete_) {
+    if (!Close()) {
+      ABSL_LOG(ERROR) << "close() failed: " << strerror(errno_);
+    }
+  }
+}
+
+bool GatheringFileOutputStream::Flush() {
+  if (errno_ != 0) return false;
+  EndSegment();
+  bool ok = WriteSegments();
+  pending_.clear();
+  pending_bytes_ = 0;
+  cords_.clear();
+  blocks_used_ = 0;
+  block_ = nullptr;
+  block_used_ = 0;
+  segment_start_ = 0;
+  return ok;
+}
+
+bool GatheringFileOutputStream::Close() {
+  ABSL_CHECK(!is_closed_);
+
+  bool flush_succeeded = Flush();
+  is_closed_ = true;
+  if (close_no_eintr(file_) != 0) {
+    errno_ = errno;
+    return false;
+  }
+  return flush_succeeded;
+}
+
+bool GatheringFileOutputStream::Next(void** data, int* size) {
+  if (errno_ != 0) return false;
+
+  if (block_ == nullptr || block_used_ == block_size_) {
+    EndSegment();
+    if (!MaybeFlush()) return false;
+    if (blocks_used_ == blocks_.size()) {
+      blocks_.emplace_back(new char[block_size_]);
+    }
+    block_ = blocks_[blocks_used_++].get();
+    block_used_ = 0;
+    segment_start_ = 0;
+  }
+
+  *data = block_ + block_used_;
+  *size = block_size_ - block_used_;
+  block_used_ = block_size_;
+  return true;
+}
+
+void GatheringFileOutputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK(block_ != nullptr && block_used_ == block_size_)
+      << " BackUp() can only be called after Next().";
+  ABSL_CHECK_LE(count, block_used_ - segment_start_)
+      << " Can't back up over more bytes than were returned by the last call"
+         " to Next().";
+
+  block_used_ -= count;
+}
+
+int64_t GatheringFileOutputStream::ByteCount() const {
+  return position_ + pending_bytes_ + (block_used_ - segment_start_);
+}
+
+bool GatheringFileOutputStream::WriteAliasedRaw(const void* data, int size) {
+  if (errno_ != 0) return false;
+  return AppendSegment(static_cast<const char*>(data), size) && MaybeFlush();
+}
+
+bool GatheringFileOutputStream::WriteCord(const absl::Cord& cord) {
+  if (errno_ != 0) return false;
+  if (cord.size() < kMinAliasedBytes) {
+    return ZeroCopyOutputStream::WriteCord(cord);
+  }
+  // Keeps the chunks alive until they are written.
+  cords_.push_back(cord);
+  for (absl::string_view chunk : cords_.back().Chunks()) {
+    if (!AppendSegment(chunk.data(), static_cast<int>(chunk.size()))) {
+      return false;
+    }
+  }
+  return MaybeFlush();
+}
+
+void GatheringFileOutputStream::EndSegment() {
+  if (block_used_ > segment_start_) {
+    pending_.push_back({block_ + segment_start_,
+                        static_cast<size_t>(block_used_ - segment_start_)});
+    pending_bytes_ += block_used_ - segment_start_;
+  }
+  segment_start_ = block_used_;
+}
+
+bool GatheringFileOutputStream::AppendSegment(const char* data, int size) {
+  if (size < kMinAliasedBytes) return CopyRaw(data, size);
+  EndSegment();
+  pending_.push_back({data, static_cast<size_t>(size)});
+  pending_bytes_ += size;
+  return true;
+}
+
+bool GatheringFileOutputStream::CopyRaw(const void* data, int size) {
+  void* out;
+  int out_size;
+  while (size > 0) {
+    if (!Next(&out, &out_size)) return false;
+    if (size <= out_size) {
+      std::memcpy(out, data, size);
+      BackUp(out_size - size);
+      return true;
+    }
+    std::memcpy(out, data, out_size);
+    data = static_cast<const char*>(data) + out_size;
+    size -= out_size;
+  }
+  return true;
+}
+
+bool GatheringFileOutputStream::MaybeFlush() {
+  // The rest of a partially filled block is abandoned; Next() starts over
+  // with the first block after a flush.
+  return pending_bytes_ < flush_threshold_ || Flush();
+}
+
+bool GatheringFileOutputStream::WriteSegments() {
+  if (pending_.empty()) return true;
+  ABSL_CHECK(!is_closed_);
+#ifdef _WIN32
+  for (const Segment& segment : pending_) {
+    size_t total_written = 0;
+    while (total_written < segment.size) {
+      int bytes;
+      do {
+        bytes = write(file_, segment.data + total_written,
+                      segment.size - total_written);
+      } while (bytes < 0 && errno == EINTR);
+      if (bytes <= 0) {
+        // Write error.  See CopyingFileOutputStream::Write() about a zero
+        // return.
+        if (bytes < 0) {
+          errno_ = errno;
+        }
+        return false;
+      }
+      total_written += bytes;
+      position_ += bytes;
+    }
+  }
+  return true;
+#else
+  std::vector<struct iovec> iov(pending_.size());
+  for (size_t i = 0; i < pending_.size(); ++i) {
+    iov[i].iov_base = const_cast<char*>(pending_[i].data);
+    iov[i].iov_len = pending_[i].size;
+  }
+
+  size_t i = 0;
+  while (i < iov.size()) {
+    ssize_t bytes;
+    do {
+      bytes = writev(file_, iov.data() + i,
+                     static_cast<int>(std::min(iov.size() - i, kMaxIovecs)));
+    } while (bytes < 0 && errno == EINTR);
+
+    if (bytes <= 0) {
+      // Write error.  See CopyingFileOutputStream::Write() about a zero
+      // return.
+      if (bytes < 0) {
+        errno_ = errno;
+      }
+      return false;
+    }
+    position_ += bytes;
+    // Drop whatever the kernel accepted and retry the rest.
+    size_t written = static_cast<size_t>(bytes);
+    while (i < iov.size() && written >= iov[i].iov_len) {
+      written -= iov[i].iov_len;
+      ++i;
+    }
+    if (i < iov.size()) {
+      iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + written;
+      iov[i].iov_len -= written;
+    }
+  }
+  return true;
+#endif
+}
+
 // ===================================================================
 
 IstreamInputStream::IstreamInputStream(std::istream* input, int block_size)
@@ -365,6 +716,171 @@ int64_t ConcatenatingInputStream::ByteCount() const {
 }
 
 
+// ===================================================================
+
+PrefetchingInputStream::PrefetchingInputStream(
+    CopyingInputStream* copying_stream)
+    : PrefetchingInputStream(copying_stream, Options()) {}
+
+PrefetchingInputStream::PrefetchingInputStream(
+    CopyingInputStream* copying_stream, const Options& options)
+    : copying_stream_(copying_stream),
+      chunk_size_(options.chunk_size > 0 ? options.chunk_size
+                                         : Options().chunk_size),
+      executor_(options.executor) {
+  const int depth = std::max(options.depth, 2);
+  chunks_.reserve(depth);
+  chunk_sizes_.resize(depth, 0);
+  {
+    absl::MutexLock lock(&mutex_);
+    for (int i = 0; i < depth; ++i) {
+      chunks_.emplace_back(new char[chunk_size_]);
+      free_.push_back(i);
+    }
+  }
+  MaybeScheduleRead();
+}
+
+PrefetchingInputStream::~PrefetchingInputStream() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+    // A scheduled task may not have started yet; it returns as soon as it
+    // sees stopping_.
+    mutex_.Await(absl::Condition(
+        +[](bool* reading) { return !*reading; }, &reading_));
+  }
+  if (reader_.joinable()) reader_.join();
+  if (owns_copying_stream_) {
+    delete copying_stream_;
+  }
+}
+
+bool PrefetchingInputStream::failed() const {
+  absl::MutexLock lock(&mutex_);
+  return failed_;
+}
+
+bool PrefetchingInputStream::CanRead() const {
+  return stopping_ || !free_.empty();
+}
+
+bool PrefetchingInputStream::HasChunkOrEof() const {
+  return eof_ || !ready_.empty();
+}
+
+void PrefetchingInputStream::MaybeScheduleRead() {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (reading_ || eof_ || stopping_ || free_.empty()) return;
+    reading_ = true;
+  }
+  // The executor may run the task inline, so it is called without holding
+  // the lock.
+  if (executor_) {
+    executor_([this] { ReadChunks(/*wait=*/false); });
+  } else {
+    // The thread keeps reading until the input ends, so it is only ever
+    // started once.
+    reader_ = std::thread([this] { ReadChunks(/*wait=*/true); });
+  }
+}
+
+void PrefetchingInputStream::ReadChunks(bool wait) {
+  while (true) {
+    int chunk;
+    {
+      absl::MutexLock lock(&mutex_);
+      if (wait) {
+        mutex_.Await(absl::Condition(this, &PrefetchingInputStream::CanRead));
+      }
+      if (stopping_ || free_.empty()) {
+        reading_ = false;
+        return;
+      }
+      chunk = free_.back();
+      free_.pop_back();
+    }
+
+    int bytes = copying_stream_->Read(chunks_[chunk].get(), chunk_size_);
+
+    absl::MutexLock lock(&mutex_);
+    if (bytes <= 0) {
+      // EOF or read error.
+      free_.push_back(chunk);
+      eof_ = true;
+      failed_ = bytes < 0;
+      reading_ = false;
+      return;
+    }
+    chunk_sizes_[chunk] = bytes;
+    ready_.push_back(chunk);
+  }
+}
+
+bool PrefetchingInputStream::Next(const void** data, int* size) {
+  if (backup_bytes_ > 0) {
+    // We have data left over from a previous BackUp(), so just return that.
+    *data = chunks_[current_].get() + chunk_sizes_[current_] - backup_bytes_;
+    *size = backup_bytes_;
+    backup_bytes_ = 0;
+    return true;
+  }
+
+  {
+    absl::MutexLock lock(&mutex_);
+    if (current_ >= 0) {
+      free_.push_back(current_);
+      current_ = -1;
+    }
+  }
+  MaybeScheduleRead();
+
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &PrefetchingInputStream::HasChunkOrEof));
+  if (ready_.empty()) return false;
+  current_ = ready_.front();
+  ready_.pop_front();
+
+  *data = chunks_[current_].get();
+  *size = chunk_sizes_[current_];
+  position_ += *size;
+  return true;
+}
+
+void PrefetchingInputStream::BackUp(int count) {
+  ABSL_CHECK(backup_bytes_ == 0 && current_ >= 0)
+      << " BackUp() can only be called after Next().";
+  ABSL_CHECK_LE(count, chunk_sizes_[current_])
+      << " Can't back up over more bytes than were returned by the last call"
+         " to Next().";
+  ABSL_CHECK_GE(count, 0) << " Parameter to BackUp() can't be negative.";
+
+  backup_bytes_ = count;
+}
+
+bool PrefetchingInputStream::Skip(int count) {
+  ABSL_CHECK_GE(count, 0);
+
+  // The underlying stream is already being read ahead, so skipped bytes are
+  // read and discarded rather than skipped in the underlying stream.
+  const void* data;
+  int size;
+  while (count > 0) {
+    if (!Next(&data, &size)) return false;
+    if (size > count) {
+      BackUp(size - count);
+      return true;
+    }
+    count -= size;
+  }
+  return true;
+}
+
+int64_t PrefetchingInputStream::ByteCount() const {
+  return position_ - backup_bytes_;
+}
+
 // ===================================================================
 
 }  // namespace io
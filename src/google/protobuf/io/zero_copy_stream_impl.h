@@ -40,10 +40,20 @@
 #ifndef GOOGLE_PROTOBUF_IO_ZERO_COPY_STREAM_IMPL_H__
 #define GOOGLE_PROTOBUF_IO_ZERO_COPY_STREAM_IMPL_H__
 
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "google/protobuf/stubs/common.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/cord.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 
@@ -90,6 +100,10 @@ class PROTOBUF_EXPORT FileInputStream final : public ZeroCopyInputStream {
   // fail.
   int GetErrno() const { return copying_input_.GetErrno(); }
 
+  // Has the stream allocate its buffer from `pool`.  See
+  // CopyingInputStreamAdaptor::SetBufferPool().
+  void SetBufferPool(BufferPool* pool) { impl_.SetBufferPool(pool); }
+
   // implements ZeroCopyInputStream ----------------------------------
   bool Next(const void** data, int* size) override;
   void BackUp(int count) override;
@@ -133,6 +147,55 @@ class PROTOBUF_EXPORT FileInputStream final : public ZeroCopyInputStream {
 
 // ===================================================================
 
+// A ZeroCopyInputStream which maps a file into memory and returns the
+// mapping from Next(), instead of reading the file into a buffer.  Parsing
+// from it sees a flat buffer, like parsing from an array, so large files are
+// parsed without copying them.  The mapping is released when the stream is
+// destroyed.
+//
+// The stream covers everything from the file's current offset to its end at
+// the time of construction, and does not move the offset.  If the file
+// cannot be mapped (because it is a pipe, say, or on Windows), it is read
+// like a FileInputStream instead; see is_mapped().  A mapped file must not be
+// truncated while the stream is in use.
+class PROTOBUF_EXPORT MmapInputStream final : public ZeroCopyInputStream {
+ public:
+  // Does not take ownership of `file_descriptor`.  If the file is mapped,
+  // the descriptor may be closed once this returns.
+  explicit MmapInputStream(int file_descriptor);
+  MmapInputStream(const MmapInputStream&) = delete;
+  MmapInputStream& operator=(const MmapInputStream&) = delete;
+  ~MmapInputStream() override;
+
+  // Returns true if the file was mapped, false if it is read instead.
+  bool is_mapped() const { return fallback_ == nullptr; }
+
+  // If an I/O error has occurred on this file descriptor, this is the
+  // errno from that error.  Otherwise, this is zero.
+  int GetErrno() const {
+    return fallback_ != nullptr ? fallback_->GetErrno() : 0;
+  }
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  // The start and length of the mapping, which begins at a page boundary.
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  // The stream's contents sit at the end of the mapping.
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  size_t position_ = 0;
+  int last_returned_size_ = 0;
+  std::unique_ptr<FileInputStream> fallback_;
+};
+
+// ===================================================================
+
 // A ZeroCopyOutputStream which writes to a file descriptor.
 //
 // FileOutputStream is preferred over using an ofstream with
@@ -186,6 +249,9 @@ class PROTOBUF_EXPORT FileOutputStream final
 
     // implements CopyingOutputStream --------------------------------
     bool Write(const void* buffer, int size) override;
+    // Uses writev() where available.
+    bool WriteGathered(const void* first, int first_size, const void* second,
+                       int second_size) override;
 
    private:
     // The file descriptor.
@@ -202,6 +268,108 @@ class PROTOBUF_EXPORT FileOutputStream final
 
 // ===================================================================
 
+// A ZeroCopyOutputStream which writes to a file descriptor, like
+// FileOutputStream, but which accumulates output until `flush_threshold`
+// bytes are pending and then writes it all out with a single writev().
+// Besides its own buffers, the pending output may reference data passed to
+// WriteAliasedRaw() and the chunks of Cords passed to WriteCord(), so large
+// fields are written straight from where they live.  This trades memory for
+// system calls, which suits high-rate logging.
+//
+// Data passed to WriteAliasedRaw() must remain live until the next Flush(),
+// Close(), or the destruction of the stream.  Cords passed to WriteCord()
+// are retained by the stream, so the caller may drop them right away.
+class PROTOBUF_EXPORT GatheringFileOutputStream final
+    : public ZeroCopyOutputStream {
+ public:
+  struct Options {
+    // The size of the buffers returned by Next().
+    int block_size = 8 << 10;
+    // The number of pending bytes at which the stream writes its output.
+    // Output is also written by Flush(), Close(), and the destructor.
+    int64_t flush_threshold = 256 << 10;
+  };
+
+  explicit GatheringFileOutputStream(int file_descriptor);
+  GatheringFileOutputStream(int file_descriptor, const Options& options);
+  GatheringFileOutputStream(const GatheringFileOutputStream&) = delete;
+  GatheringFileOutputStream& operator=(const GatheringFileOutputStream&) =
+      delete;
+  ~GatheringFileOutputStream() override;
+
+  // Writes all pending data to the file descriptor.  Returns false if a
+  // write error occurred; use GetErrno() to examine the error.
+  bool Flush();
+
+  // Flushes any buffers and closes the underlying file.  Returns false if
+  // an error occurs during the process; use GetErrno() to examine the error.
+  // Even if an error occurs, the file descriptor is closed when this returns.
+  bool Close();
+
+  // By default, the file descriptor is not closed when the stream is
+  // destroyed.  Call SetCloseOnDelete(true) to change that.  See
+  // FileOutputStream::SetCloseOnDelete() for the caveats.
+  void SetCloseOnDelete(bool value) { close_on_delete_ = value; }
+
+  // If an I/O error has occurred on this file descriptor, this is the
+  // errno from that error.  Otherwise, this is zero.  Once an error
+  // occurs, the stream is broken and all subsequent operations will
+  // fail.
+  int GetErrno() const { return errno_; }
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override;
+  bool WriteAliasedRaw(const void* data, int size) override;
+  bool AllowsAliasing() const override { return true; }
+  bool WriteCord(const absl::Cord& cord) override;
+
+ private:
+  struct Segment {
+    const char* data;
+    size_t size;
+  };
+
+  // Appends the bytes written to the current block since the last call to
+  // the pending segments.
+  void EndSegment();
+  // Appends `data` to the pending segments, copying it if it is small.
+  bool AppendSegment(const char* data, int size);
+  // Copies `data` into the stream's own buffers.
+  bool CopyRaw(const void* data, int size);
+  // Flushes if at least flush_threshold_ bytes are pending.
+  bool MaybeFlush();
+  // Writes the pending segments to the file descriptor.
+  bool WriteSegments();
+
+  const int file_;
+  const int block_size_;
+  const int64_t flush_threshold_;
+  bool close_on_delete_ = false;
+  bool is_closed_ = false;
+  int errno_ = 0;
+
+  // Blocks handed out by Next().  They are reused after every flush.
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  // The number of blocks in use since the last flush.
+  size_t blocks_used_ = 0;
+  // The block last returned by Next(), if any, how much of it has been
+  // written, and where the bytes not yet in pending_ start.
+  char* block_ = nullptr;
+  int block_used_ = 0;
+  int segment_start_ = 0;
+
+  // Output not yet written to the file descriptor, in order.
+  std::vector<Segment> pending_;
+  int64_t pending_bytes_ = 0;
+  // Cords whose chunks are referenced by pending_.
+  std::vector<absl::Cord> cords_;
+
+  // Bytes written to the file descriptor so far.
+  int64_t position_ = 0;
+};
+
 // A ZeroCopyInputStream which reads from a C++ istream.
 //
 // Note that for reading files (or anything represented by a file descriptor),
@@ -325,6 +493,103 @@ class PROTOBUF_EXPORT ConcatenatingInputStream final
 
 // ===================================================================
 
+// A ZeroCopyInputStream which reads from a CopyingInputStream ahead of the
+// consumer.  Like CopyingInputStreamAdaptor, it reads the underlying stream
+// in chunks, but it does so in the background: while the caller works on the
+// chunk returned by Next(), up to `depth - 1` further chunks are read, so a
+// slow source (a socket, say, or a remote file system) does not stall the
+// parser on every Next().
+//
+// Reads are issued one at a time, so the CopyingInputStream need not be
+// thread-safe, but it must tolerate being called from a thread other than
+// the consumer's.  The stream itself is not thread-safe: as usual, only one
+// thread may call its methods at a time.
+class PROTOBUF_EXPORT PrefetchingInputStream final
+    : public ZeroCopyInputStream {
+ public:
+  struct Options {
+    // The number of bytes requested from the underlying stream in each
+    // read, and the largest size returned by Next().
+    int chunk_size = 64 << 10;
+    // The number of chunks in the buffer, including the one last returned
+    // by Next().  Values below 2 are treated as 2.
+    int depth = 4;
+    // Runs `task` asynchronously, exactly once.  The task performs blocking
+    // reads until the buffer is full or the input ends.  If unset, the
+    // stream reads on a thread of its own.
+    std::function<void(std::function<void()> task)> executor;
+  };
+
+  // The caller retains ownership of `copying_stream` unless
+  // SetOwnsCopyingStream(true) is called.  Reading starts right away.
+  explicit PrefetchingInputStream(CopyingInputStream* copying_stream);
+  PrefetchingInputStream(CopyingInputStream* copying_stream,
+                         const Options& options);
+  PrefetchingInputStream(const PrefetchingInputStream&) = delete;
+  PrefetchingInputStream& operator=(const PrefetchingInputStream&) = delete;
+  // Waits for an outstanding read of the underlying stream to return.
+  ~PrefetchingInputStream() override;
+
+  // Call SetOwnsCopyingStream(true) to tell the PrefetchingInputStream to
+  // delete the underlying CopyingInputStream when it is destroyed.
+  void SetOwnsCopyingStream(bool value) { owns_copying_stream_ = value; }
+
+  // Returns true if the underlying stream reported a read error.  Only
+  // meaningful once Next() has returned false.
+  bool failed() const;
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  // Reads into free chunks until there are none left, the input ends, or
+  // the stream is being destroyed.  If `wait` is true, waits for a chunk to
+  // be freed instead of returning when there are none.
+  void ReadChunks(bool wait);
+  // Hands ReadChunks() to the executor (or the reader thread) if it is not
+  // already running and there is a chunk to read into.
+  void MaybeScheduleRead() ABSL_LOCKS_EXCLUDED(mutex_);
+  // Conditions waited on by the reader and the consumer, respectively.
+  bool CanRead() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool HasChunkOrEof() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  CopyingInputStream* copying_stream_;
+  bool owns_copying_stream_ = false;
+  const int chunk_size_;
+  std::function<void(std::function<void()>)> executor_;
+
+  // chunks_[i] holds chunk_sizes_[i] bytes once it has been read into.
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  std::vector<int> chunk_sizes_;
+
+  mutable absl::Mutex mutex_;
+  // Chunks which have been read, in stream order.
+  std::deque<int> ready_ ABSL_GUARDED_BY(mutex_);
+  // Chunks which may be read into.
+  std::vector<int> free_ ABSL_GUARDED_BY(mutex_);
+  // True while ReadChunks() is running.
+  bool reading_ ABSL_GUARDED_BY(mutex_) = false;
+  // Set once the underlying stream has returned EOF or an error.
+  bool eof_ ABSL_GUARDED_BY(mutex_) = false;
+  bool failed_ ABSL_GUARDED_BY(mutex_) = false;
+  // Set by the destructor to stop reading.
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+
+  // Only used when no executor is given.
+  std::thread reader_;
+
+  // The chunk last returned by Next(), or -1, and how much of it was backed
+  // up over.  Only touched by the consumer.
+  int current_ = -1;
+  int backup_bytes_ = 0;
+  int64_t position_ = 0;
+};
+
+// ===================================================================
+
 }  // namespace io
 }  // namespace protobuf
 }  // namespace google
@@ -40,9 +40,12 @@
 
 #include "google/protobuf/stubs/common.h"
 #include "absl/base/casts.h"
+#include "absl/base/config.h"
 #include "absl/log/absl_check.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/internal/resize_uninitialized.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/port.h"
 
 // Must be included last
 #include "google/protobuf/port_def.inc"
@@ -183,6 +186,106 @@ int64_t StringOutputStream::ByteCount() const {
 
 // ===================================================================
 
+namespace {
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+// Keeps up to kMaxCachedBuffers released buffers per thread.  Streams on one
+// thread tend to use one or two buffer sizes, so a short list searched from
+// the most recently released buffer is enough.
+//
+// As in the arena's block cache, the state is a trivially destructible thread
+// local, so that it stays valid while other thread locals (which may own
+// streams) are destroyed at thread exit, and a separate Reaper frees the
+// cached buffers.
+class ThreadLocalBufferPool final : public BufferPool {
+ public:
+  void* Allocate(size_t size) override {
+    State& state = state_;
+    for (int i = state.count - 1; i >= 0; --i) {
+      if (state.buffers[i].size == size) {
+        void* buffer = state.buffers[i].p;
+        std::copy(state.buffers + i + 1, state.buffers + state.count,
+                  state.buffers + i);
+        --state.count;
+        return buffer;
+      }
+    }
+    return ::operator new(size);
+  }
+
+  void Release(void* buffer, size_t size) override {
+    State& state = state_;
+    if (state.shut_down || size > kMaxCachedSize ||
+        state.count == kMaxCachedBuffers) {
+      internal::SizedDelete(buffer, size);
+      return;
+    }
+    if (PROTOBUF_PREDICT_FALSE(!state.reaper_installed)) {
+      state.reaper_installed = true;
+      InstallReaper();
+    }
+    state.buffers[state.count++] = {buffer, size};
+  }
+
+ private:
+  static constexpr int kMaxCachedBuffers = 8;
+  static constexpr size_t kMaxCachedSize = 1 << 20;
+
+  struct CachedBuffer {
+    void* p;
+    size_t size;
+  };
+
+  struct State {
+    CachedBuffer buffers[kMaxCachedBuffers];
+    int count;
+    bool reaper_installed;
+    // Set once the thread is exiting; buffers released afterwards are freed.
+    bool shut_down;
+  };
+
+  // Frees the cached buffers of the current thread on thread exit.
+  struct Reaper {
+    ~Reaper() {
+      State& state = state_;
+      state.shut_down = true;
+      while (state.count > 0) {
+        --state.count;
+        internal::SizedDelete(state.buffers[state.count].p,
+                              state.buffers[state.count].size);
+      }
+    }
+  };
+
+  static void InstallReaper() {
+    static thread_local Reaper reaper;
+    (void)reaper;
+  }
+
+  static PROTOBUF_THREAD_LOCAL State state_;
+};
+
+PROTOBUF_CONSTINIT PROTOBUF_THREAD_LOCAL ThreadLocalBufferPool::State
+    ThreadLocalBufferPool::state_{};
+#else   // ABSL_HAVE_THREAD_LOCAL
+class ThreadLocalBufferPool final : public BufferPool {
+ public:
+  void* Allocate(size_t size) override { return ::operator new(size); }
+  void Release(void* buffer, size_t size) override {
+    internal::SizedDelete(buffer, size);
+  }
+};
+#endif  // ABSL_HAVE_THREAD_LOCAL
+
+}  // namespace
+
+BufferPool* BufferPool::ThreadLocalCache() {
+  static BufferPool* const pool = new ThreadLocalBufferPool();
+  return pool;
+}
+
+// ===================================================================
+
 int CopyingInputStream::Skip(int count) {
   char junk[4096];
   int skipped = 0;
@@ -212,6 +315,15 @@ CopyingInputStreamAdaptor::~CopyingInputStreamAdaptor() {
   if (owns_copying_stream_) {
     delete copying_stream_;
   }
+  if (buffer_pool_ != nullptr && buffer_ != nullptr) {
+    buffer_pool_->Release(buffer_.release(), buffer_size_);
+  }
+}
+
+void CopyingInputStreamAdaptor::SetBufferPool(BufferPool* pool) {
+  ABSL_CHECK(buffer_ == nullptr)
+      << " SetBufferPool() must be called before Next().";
+  buffer_pool_ = pool;
 }
 
 bool CopyingInputStreamAdaptor::Next(const void** data, int* size) {
@@ -288,18 +400,30 @@ int64_t CopyingInputStreamAdaptor::ByteCount() const {
 
 void CopyingInputStreamAdaptor::AllocateBufferIfNeeded() {
   if (buffer_.get() == NULL) {
-    buffer_.reset(new uint8_t[buffer_size_]);
+    buffer_.reset(buffer_pool_ != nullptr
+                      ? static_cast<uint8_t*>(
+                            buffer_pool_->Allocate(buffer_size_))
+                      : new uint8_t[buffer_size_]);
   }
 }
 
 void CopyingInputStreamAdaptor::FreeBuffer() {
   ABSL_CHECK_EQ(backup_bytes_, 0);
   buffer_used_ = 0;
+  if (buffer_pool_ != nullptr && buffer_ != nullptr) {
+    buffer_pool_->Release(buffer_.release(), buffer_size_);
+  }
   buffer_.reset();
 }
 
 // ===================================================================
 
+bool CopyingOutputStream::WriteGathered(const void* first, int first_size,
+                                        const void* second, int second_size) {
+  return (first_size == 0 || Write(first, first_size)) &&
+         Write(second, second_size);
+}
+
 CopyingOutputStreamAdaptor::CopyingOutputStreamAdaptor(
     CopyingOutputStream* copying_stream, int block_size)
     : copying_stream_(copying_stream),
@@ -314,6 +438,13 @@ CopyingOutputStreamAdaptor::~CopyingOutputStreamAdaptor() {
   if (owns_copying_stream_) {
     delete copying_stream_;
   }
+  FreeBuffer();
+}
+
+void CopyingOutputStreamAdaptor::SetBufferPool(BufferPool* pool) {
+  ABSL_CHECK(buffer_ == nullptr)
+      << " SetBufferPool() must be called before Next().";
+  buffer_pool_ = pool;
 }
 
 bool CopyingOutputStreamAdaptor::Flush() { return WriteBuffer(); }
@@ -352,11 +483,17 @@ int64_t CopyingOutputStreamAdaptor::ByteCount() const {
 
 bool CopyingOutputStreamAdaptor::WriteAliasedRaw(const void* data, int size) {
   if (size >= buffer_size_) {
-    if (!Flush() || !copying_stream_->Write(data, size)) {
+    if (failed_) return false;
+    // Writes the buffered bytes and `data` together, without first copying
+    // `data` into the buffer.
+    if (!copying_stream_->WriteGathered(buffer_.get(), buffer_used_, data,
+                                        size)) {
+      failed_ = true;
+      FreeBuffer();
       return false;
     }
-    ABSL_DCHECK_EQ(buffer_used_, 0);
-    position_ += size;
+    position_ += buffer_used_ + size;
+    buffer_used_ = 0;
     return true;
   }
 
@@ -410,12 +547,18 @@ bool CopyingOutputStreamAdaptor::WriteBuffer() {
 
 void CopyingOutputStreamAdaptor::AllocateBufferIfNeeded() {
   if (buffer_ == NULL) {
-    buffer_.reset(new uint8_t[buffer_size_]);
+    buffer_.reset(buffer_pool_ != nullptr
+                      ? static_cast<uint8_t*>(
+                            buffer_pool_->Allocate(buffer_size_))
+                      : new uint8_t[buffer_size_]);
   }
 }
 
 void CopyingOutputStreamAdaptor::FreeBuffer() {
   buffer_used_ = 0;
+  if (buffer_pool_ != nullptr && buffer_ != nullptr) {
+    buffer_pool_->Release(buffer_.release(), buffer_size_);
+  }
   buffer_.reset();
 }
 
@@ -487,6 +630,95 @@ bool LimitingInputStream::ReadCord(absl::Cord* cord, int count) {
   return false;
 }
 
+// ===================================================================
+
+CoalescingInputStream::CoalescingInputStream(ZeroCopyInputStream* input)
+    : CoalescingInputStream(input, Options()) {}
+
+CoalescingInputStream::CoalescingInputStream(ZeroCopyInputStream* input,
+                                             const Options& options)
+    : input_(input),
+      min_chunk_size_(std::max(1, options.min_chunk_size)),
+      buffer_size_(std::max(min_chunk_size_, options.buffer_size)) {}
+
+bool CoalescingInputStream::Next(const void** data, int* size) {
+  if (position_ == limit_) {
+    do {
+      if (!input_->Next(data, size)) return false;
+    } while (*size == 0);
+    if (*size >= min_chunk_size_) {
+      returned_buffer_ = false;
+      ++buffers_returned_;
+      return true;
+    }
+    Coalesce(*data, *size);
+  }
+  *data = buffer_.get() + position_;
+  *size = limit_ - position_;
+  position_ = limit_;
+  returned_buffer_ = true;
+  ++buffers_returned_;
+  return true;
+}
+
+void CoalescingInputStream::Coalesce(const void* data, int size) {
+  if (buffer_ == nullptr) buffer_.reset(new char[buffer_size_]);
+  ABSL_DCHECK_LE(size, buffer_size_);
+  std::memcpy(buffer_.get(), data, size);
+  position_ = 0;
+  limit_ = size;
+  ++chunks_coalesced_;
+  while (limit_ < buffer_size_ && input_->Next(&data, &size)) {
+    if (size >= min_chunk_size_) {
+      // Leave it for the next call to Next() to pass through.
+      input_->BackUp(size);
+      break;
+    }
+    int n = std::min(size, buffer_size_ - limit_);
+    std::memcpy(buffer_.get() + limit_, data, n);
+    limit_ += n;
+    if (n < size) input_->BackUp(size - n);
+    if (n > 0) ++chunks_coalesced_;
+  }
+}
+
+void CoalescingInputStream::BackUp(int count) {
+  if (!returned_buffer_) {
+    input_->BackUp(count);
+    return;
+  }
+  ABSL_CHECK_LE(count, position_)
+      << "BackUp() can only return the end of the last buffer.";
+  position_ -= count;
+}
+
+bool CoalescingInputStream::Skip(int count) {
+  returned_buffer_ = false;
+  int buffered = limit_ - position_;
+  if (count <= buffered) {
+    position_ += count;
+    return true;
+  }
+  position_ = limit_;
+  return input_->Skip(count - buffered);
+}
+
+int64_t CoalescingInputStream::ByteCount() const {
+  return input_->ByteCount() - (limit_ - position_);
+}
+
+bool CoalescingInputStream::ReadCord(absl::Cord* cord, int count) {
+  returned_buffer_ = false;
+  int buffered = std::min(count, limit_ - position_);
+  if (buffered > 0) {
+    cord->Append(absl::string_view(buffer_.get() + position_, buffered));
+    position_ += buffered;
+    count -= buffered;
+  }
+  // Large reads can share the underlying stream's memory.
+  return count == 0 || input_->ReadCord(cord, count);
+}
+
 
 // ===================================================================
 CordInputStream::CordInputStream(const absl::Cord* cord)
@@ -689,6 +921,20 @@ int64_t CordOutputStream::ByteCount() const {
   return static_cast<int64_t>(cord_.size() + buffer_.length());
 }
 
+bool CordOutputStream::WriteAliasedRaw(const void* data, int size) {
+  // Small chunks are cheaper to copy than to track as separate nodes.
+  constexpr int kMinAliasedBytes = 512;
+  absl::string_view chunk(static_cast<const char*>(data), size);
+  cord_.Append(std::move(buffer_));
+  if (size < kMinAliasedBytes) {
+    cord_.Append(chunk);
+  } else {
+    cord_.Append(absl::MakeCordFromExternal(chunk, [] {}));
+  }
+  state_ = State::kSteal;  // Attempt to utilize existing capacity in `cord'
+  return true;
+}
+
 bool CordOutputStream::WriteCord(const absl::Cord& cord) {
   cord_.Append(std::move(buffer_));
   cord_.Append(cord);
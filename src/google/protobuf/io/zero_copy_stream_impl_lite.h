@@ -173,6 +173,32 @@ class PROTOBUF_EXPORT StringOutputStream final : public ZeroCopyOutputStream {
 
 // ===================================================================
 
+// An allocator for the buffers of the copying stream adaptors (and of
+// streams built on them, such as FileInputStream and FileOutputStream) and
+// of GzipInputStream.  By default each stream allocates its buffer from the
+// heap and frees it when it is done; a server that creates a stream per
+// request can instead have them draw from a pool, so that buffers are
+// reused rather than allocated and freed over and over.
+class PROTOBUF_EXPORT BufferPool {
+ public:
+  virtual ~BufferPool() {}
+
+  // Returns a buffer of `size` bytes.
+  virtual void* Allocate(size_t size) = 0;
+
+  // Takes back a buffer returned by Allocate(size).  This may be called on a
+  // different thread than the one which allocated the buffer.
+  virtual void Release(void* buffer, size_t size) = 0;
+
+  // Returns a thread-safe pool which keeps a few released buffers per thread
+  // and hands them out again to streams created on the same thread.  Buffers
+  // larger than 1MB are not kept.  Cached buffers are freed when their thread
+  // exits.  The pool is never destroyed.
+  static BufferPool* ThreadLocalCache();
+};
+
+// ===================================================================
+
 // A generic traditional input stream interface.
 //
 // Lots of traditional input streams (e.g. file descriptors, C stdio
@@ -229,6 +255,10 @@ class PROTOBUF_EXPORT CopyingInputStreamAdaptor : public ZeroCopyInputStream {
   // delete the underlying CopyingInputStream when it is destroyed.
   void SetOwnsCopyingStream(bool value) { owns_copying_stream_ = value; }
 
+  // Has the stream allocate its buffer from `pool` instead of the heap.  The
+  // pool must outlive the stream.  Must be called before the first Next().
+  void SetBufferPool(BufferPool* pool);
+
   // implements ZeroCopyInputStream ----------------------------------
   bool Next(const void** data, int* size) override;
   void BackUp(int count) override;
@@ -256,6 +286,9 @@ class PROTOBUF_EXPORT CopyingInputStreamAdaptor : public ZeroCopyInputStream {
   // in use.  Otherwise, it points to an array of size buffer_size_.
   std::unique_ptr<uint8_t[]> buffer_;
   const int buffer_size_;
+  // If set, buffer_ comes from this pool and is released back to it rather
+  // than deleted.
+  BufferPool* buffer_pool_ = nullptr;
 
   // Number of valid bytes currently in the buffer (i.e. the size last
   // returned by Next()).  0 <= buffer_used_ <= buffer_size_.
@@ -287,6 +320,13 @@ class PROTOBUF_EXPORT CopyingOutputStream {
   // Writes "size" bytes from the given buffer to the output.  Returns true
   // if successful, false on a write error.
   virtual bool Write(const void* buffer, int size) = 0;
+
+  // Writes "first_size" bytes from "first" followed by "second_size" bytes
+  // from "second", as if by two calls to Write().  CopyingOutputStreamAdaptor
+  // uses this to write its buffer together with large aliased data, so
+  // streams that can gather both into one system call should override it.
+  virtual bool WriteGathered(const void* first, int first_size,
+                             const void* second, int second_size);
 };
 
 // A ZeroCopyOutputStream which writes to a CopyingOutputStream.  This is
@@ -319,6 +359,10 @@ class PROTOBUF_EXPORT CopyingOutputStreamAdaptor : public ZeroCopyOutputStream {
   // delete the underlying CopyingOutputStream when it is destroyed.
   void SetOwnsCopyingStream(bool value) { owns_copying_stream_ = value; }
 
+  // Has the stream allocate its buffer from `pool` instead of the heap.  The
+  // pool must outlive the stream.  Must be called before the first Next().
+  void SetBufferPool(BufferPool* pool);
+
   // implements ZeroCopyOutputStream ---------------------------------
   bool Next(void** data, int* size) override;
   void BackUp(int count) override;
@@ -350,6 +394,9 @@ class PROTOBUF_EXPORT CopyingOutputStreamAdaptor : public ZeroCopyOutputStream {
   // currently in use.  Otherwise, it points to an array of size buffer_size_.
   std::unique_ptr<uint8_t[]> buffer_;
   const int buffer_size_;
+  // If set, buffer_ comes from this pool and is released back to it rather
+  // than deleted.
+  BufferPool* buffer_pool_ = nullptr;
 
   // Number of valid bytes currently in the buffer (i.e. the size last
   // returned by Next()).  When BackUp() is called, we just reduce this.
@@ -386,6 +433,67 @@ class PROTOBUF_EXPORT LimitingInputStream final : public ZeroCopyInputStream {
 
 // ===================================================================
 
+// A ZeroCopyInputStream which wraps some other stream and merges runs of
+// small chunks into larger buffers.
+//
+// The parser pays a fixed cost at every buffer boundary, so parsing from a
+// stream that returns many tiny chunks (a heavily fragmented Cord, say) can
+// be several times slower than parsing the same bytes from a flat array.
+// Chunks of at least `min_chunk_size` bytes are passed through untouched, so
+// well-behaved input is not copied; smaller ones are copied into an internal
+// buffer until it fills up or a large chunk arrives.
+class PROTOBUF_EXPORT CoalescingInputStream final : public ZeroCopyInputStream {
+ public:
+  struct Options {
+    // Chunks of at least this many bytes are returned without copying.
+    int min_chunk_size = 256;
+    // The capacity of the buffer small chunks are copied into.  Values below
+    // min_chunk_size are treated as min_chunk_size.
+    int buffer_size = 4 << 10;
+  };
+
+  explicit CoalescingInputStream(ZeroCopyInputStream* input);
+  CoalescingInputStream(ZeroCopyInputStream* input, const Options& options);
+  CoalescingInputStream(const CoalescingInputStream&) = delete;
+  CoalescingInputStream& operator=(const CoalescingInputStream&) = delete;
+  ~CoalescingInputStream() override = default;
+
+  // The number of buffers returned by Next(), i.e. the number of boundaries
+  // a reader of this stream crosses.
+  int64_t buffers_returned() const { return buffers_returned_; }
+  // The number of chunks of the underlying stream that were copied into a
+  // larger buffer.
+  int64_t chunks_coalesced() const { return chunks_coalesced_; }
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+  bool ReadCord(absl::Cord* cord, int count) override;
+
+ private:
+  // Copies chunks from input_ into buffer_ for as long as they are small.
+  // `data` and `size` describe the first one.
+  void Coalesce(const void* data, int size);
+
+  ZeroCopyInputStream* input_;
+  const int min_chunk_size_;
+  const int buffer_size_;
+  // Allocated the first time a small chunk is seen.
+  std::unique_ptr<char[]> buffer_;
+  // buffer_[position_, limit_) has been read from input_ but not yet
+  // consumed by the caller.
+  int position_ = 0;
+  int limit_ = 0;
+  // Whether the last buffer returned by Next() was buffer_.
+  bool returned_buffer_ = false;
+  int64_t buffers_returned_ = 0;
+  int64_t chunks_coalesced_ = 0;
+};
+
+// ===================================================================
+
 // A ZeroCopyInputStream backed by a Cord.  This stream implements ReadCord()
 // in a way that can share memory between the source and destination cords
 // rather than copying.
@@ -435,6 +543,20 @@ class PROTOBUF_EXPORT CordInputStream final : public ZeroCopyInputStream {
 // A ZeroCopyOutputStream that writes to a Cord.  This stream implements
 // WriteCord() in a way that can share memory between the source and
 // destination cords rather than copying.
+//
+// It also allows aliasing: large chunks passed to WriteAliasedRaw() become
+// external references in the resulting Cord instead of being copied.  The
+// aliased memory must then outlive the Cord returned by Consume(), so
+// serialization only aliases when asked to explicitly:
+//
+//   CordOutputStream output;
+//   {
+//     CodedOutputStream coded(&output);
+//     coded.EnableAliasing(true);
+//     message.SerializeToCodedStream(&coded);
+//   }
+//   // References the string fields of `message` rather than copying them.
+//   absl::Cord cord = output.Consume();
 class PROTOBUF_EXPORT CordOutputStream final : public ZeroCopyOutputStream {
  public:
   // Creates an OutputStream streaming serialized data into a Cord. `size_hint`,
@@ -485,6 +607,8 @@ class PROTOBUF_EXPORT CordOutputStream final : public ZeroCopyOutputStream {
   bool Next(void** data, int* size) final;
   void BackUp(int count) final;
   int64_t ByteCount() const final;
+  bool WriteAliasedRaw(const void* data, int size) final;
+  bool AllowsAliasing() const final { return true; }
   bool WriteCord(const absl::Cord& cord) final;
 
   // Consumes the serialized data as a cord value. `Consume()` internally
@@ -58,6 +58,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <functional>
 #include <iterator>
 #include <memory>
 #include <sstream>
@@ -72,19 +73,28 @@
 #include <gtest/gtest.h>
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
+#include "absl/crc/crc32c.h"
 #include "absl/status/status.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/cord_buffer.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "google/protobuf/io/checksum_stream.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/io_win32.h"
+#include "google/protobuf/io/ring_buffer_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/test_util2.h"
 
 #if HAVE_ZLIB
 #include "google/protobuf/io/gzip_stream.h"
 #endif
+#if HAVE_ZSTD
+#include "google/protobuf/io/zstd_stream.h"
+#endif
+#if HAVE_LZ4
+#include "google/protobuf/io/lz4_stream.h"
+#endif
 
 
 // Must be included last.
@@ -364,6 +374,74 @@ TEST_F(IoTest, TwoSessionWrite) {
   delete[] buffer;
 }
 
+// A BufferPool which counts the buffers it hands out and takes back.
+class CountingBufferPool : public BufferPool {
+ public:
+  void* Allocate(size_t size) override {
+    ++allocated_;
+    return BufferPool::ThreadLocalCache()->Allocate(size);
+  }
+  void Release(void* buffer, size_t size) override {
+    ++released_;
+    BufferPool::ThreadLocalCache()->Release(buffer, size);
+  }
+
+  int allocated() const { return allocated_; }
+  int released() const { return released_; }
+
+ private:
+  int allocated_ = 0;
+  int released_ = 0;
+};
+
+TEST_F(IoTest, ThreadLocalBufferPoolReusesBuffers) {
+  BufferPool* pool = BufferPool::ThreadLocalCache();
+  void* buffer = pool->Allocate(8192);
+  pool->Release(buffer, 8192);
+  void* other = pool->Allocate(4096);
+  EXPECT_EQ(pool->Allocate(8192), buffer);
+  pool->Release(other, 4096);
+  pool->Release(buffer, 8192);
+
+  // Buffers released on another thread are cached there.
+  std::thread([pool] {
+    void* buffer = pool->Allocate(1024);
+    pool->Release(buffer, 1024);
+  }).join();
+}
+
+TEST_F(IoTest, FileIoWithBufferPool) {
+  std::string filename =
+      absl::StrCat(TestTempDir(), "/zero_copy_stream_test_file");
+  CountingBufferPool pool;
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    int file =
+        open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+    ASSERT_GE(file, 0);
+
+    {
+      FileOutputStream output(file, kBlockSizes[i]);
+      output.SetBufferPool(&pool);
+      WriteStuff(&output);
+      EXPECT_EQ(0, output.GetErrno());
+    }
+
+    ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+    {
+      FileInputStream input(file, kBlockSizes[i]);
+      input.SetBufferPool(&pool);
+      ReadStuff(&input);
+      EXPECT_EQ(0, input.GetErrno());
+    }
+
+    close(file);
+  }
+  EXPECT_GT(pool.allocated(), 0);
+  EXPECT_EQ(pool.allocated(), pool.released());
+}
+
 #if HAVE_ZLIB
 TEST_F(IoTest, GzipIo) {
   const int kBufferSize = 2 * 1024;
@@ -396,6 +474,25 @@ TEST_F(IoTest, GzipIo) {
   delete[] buffer;
 }
 
+TEST_F(IoTest, GzipIoWithBufferPool) {
+  std::string compressed;
+  {
+    StringOutputStream output(&compressed);
+    GzipOutputStream gzout(&output);
+    WriteStuff(&gzout);
+    gzout.Close();
+  }
+
+  CountingBufferPool pool;
+  for (int i = 0; i < 2; i++) {
+    ArrayInputStream input(compressed.data(), compressed.size());
+    GzipInputStream gzin(&input, GzipInputStream::AUTO, -1, &pool);
+    ReadStuff(&gzin);
+  }
+  EXPECT_EQ(pool.allocated(), 2);
+  EXPECT_EQ(pool.released(), 2);
+}
+
 TEST_F(IoTest, GzipIoWithFlush) {
   const int kBufferSize = 2 * 1024;
   uint8* buffer = new uint8[kBufferSize];
@@ -553,6 +650,58 @@ TEST_F(IoTest, ZlibIoInputAutodetect) {
   delete[] buffer;
 }
 
+TEST_F(IoTest, ParallelGzipIo) {
+  const int kBufferSize = 2 * 1024;
+  uint8* buffer = new uint8[kBufferSize];
+  for (auto format : {GzipOutputStream::GZIP, GzipOutputStream::ZLIB}) {
+    // Small blocks, so that WriteStuff() spans several of them.
+    for (int block_size : {1, 7, 64, 4096}) {
+      for (bool flush : {false, true}) {
+        int size;
+        {
+          ArrayOutputStream output(buffer, kBufferSize, kBlockSizes[4]);
+          GzipOutputStream::Options options;
+          options.format = format;
+          options.num_threads = 3;
+          options.block_size = block_size;
+          GzipOutputStream gzout(&output, options);
+          WriteStuff(&gzout);
+          if (flush) EXPECT_TRUE(gzout.Flush());
+          EXPECT_TRUE(gzout.Close());
+          size = output.ByteCount();
+        }
+        {
+          ArrayInputStream input(buffer, size);
+          GzipInputStream gzin(&input, format == GzipOutputStream::GZIP
+                                           ? GzipInputStream::GZIP
+                                           : GzipInputStream::ZLIB);
+          ReadStuff(&gzin);
+        }
+      }
+    }
+  }
+  delete[] buffer;
+}
+
+TEST_F(IoTest, ParallelGzipCompressesAcrossBlocks) {
+  // Each block is primed with the input before it, so repeating a block
+  // costs little.
+  std::string block;
+  for (int i = 0; i < 1000; i++) {
+    absl::StrAppend(&block, i * 7919 % 1000, ",");
+  }
+  std::string data = absl::StrCat(block, block, block, block);
+
+  GzipOutputStream::Options options;
+  options.num_threads = 4;
+  options.block_size = static_cast<int>(block.size());
+  std::string compressed = Compress(data, options);
+  EXPECT_EQ(Uncompress(compressed), data);
+
+  options.num_threads = 1;
+  EXPECT_LT(compressed.size(), 2 * Compress(block, options).size());
+}
+
 std::string IoTest::Compress(const std::string& data,
                              const GzipOutputStream::Options& options) {
   std::string result;
@@ -714,6 +863,212 @@ TEST_F(IoTest, GzipInputByteCountAfterClosedConcatenatedStreams) {
 }
 #endif
 
+#if HAVE_ZSTD
+TEST_F(IoTest, ZstdIo) {
+  const int kBufferSize = 2 * 1024;
+  uint8* buffer = new uint8[kBufferSize];
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      for (int z = 0; z < kBlockSizeCount; z++) {
+        for (bool flush : {false, true}) {
+          int size;
+          {
+            ArrayOutputStream output(buffer, kBufferSize, kBlockSizes[i]);
+            ZstdOutputStream::Options options;
+            if (kBlockSizes[z] != -1) options.buffer_size = kBlockSizes[z];
+            ZstdOutputStream zout(&output, options);
+            WriteStuff(&zout);
+            if (flush) EXPECT_TRUE(zout.Flush());
+            EXPECT_TRUE(zout.Close());
+            size = output.ByteCount();
+          }
+          {
+            ArrayInputStream input(buffer, size, kBlockSizes[j]);
+            ZstdInputStream::Options options;
+            if (kBlockSizes[z] != -1) options.buffer_size = kBlockSizes[z];
+            ZstdInputStream zin(&input, options);
+            ReadStuff(&zin);
+            EXPECT_EQ(zin.ZstdErrorMessage(), nullptr);
+          }
+        }
+      }
+    }
+  }
+  delete[] buffer;
+}
+
+TEST_F(IoTest, ZstdIoLarge) {
+  // Small buffers make the decompressor hold back output between calls.
+  for (int buffer_size : {7, 1024, 65536}) {
+    std::string compressed;
+    {
+      StringOutputStream output(&compressed);
+      ZstdOutputStream::Options options;
+      options.buffer_size = buffer_size;
+      ZstdOutputStream zout(&output, options);
+      WriteStuffLarge(&zout);
+      EXPECT_TRUE(zout.Close());
+    }
+    ZstdInputStream::Options options;
+    options.buffer_size = buffer_size;
+    {
+      ArrayInputStream input(compressed.data(), compressed.size());
+      ZstdInputStream zin(&input, options);
+      ReadStuffLarge(&zin);
+      EXPECT_EQ(zin.ZstdErrorMessage(), nullptr);
+    }
+    {
+      // Concatenated frames read as one stream.
+      std::string concatenated = compressed + compressed;
+      ArrayInputStream input(concatenated.data(), concatenated.size());
+      ZstdInputStream zin(&input, options);
+      const void* data;
+      int size;
+      while (zin.Next(&data, &size)) {
+      }
+      EXPECT_EQ(zin.ByteCount(), 2 * 200055);
+      EXPECT_EQ(zin.ZstdErrorMessage(), nullptr);
+    }
+  }
+}
+
+TEST_F(IoTest, ZstdDictionary) {
+  // Stands in for a trained dictionary: content shared with the data.
+  const std::string dictionary =
+      "Hello world!\nSome text.  Blah blah.abcdefg01234567890123456789foobar";
+  const std::string text = "Hello world!\nSome text.  Blah blah.";
+  auto compress = [&](absl::string_view dict) {
+    std::string compressed;
+    StringOutputStream output(&compressed);
+    ZstdOutputStream::Options options;
+    options.dictionary = dict;
+    ZstdOutputStream zout(&output, options);
+    EXPECT_TRUE(WriteToOutput(&zout, text.data(), text.size()));
+    EXPECT_TRUE(zout.Close());
+    return compressed;
+  };
+  const std::string with_dictionary = compress(dictionary);
+  EXPECT_LT(with_dictionary.size(), compress("").size());
+
+  {
+    ArrayInputStream input(with_dictionary.data(), with_dictionary.size());
+    ZstdInputStream::Options options;
+    options.dictionary = dictionary;
+    ZstdInputStream zin(&input, options);
+    ReadString(&zin, text);
+    EXPECT_EQ(zin.ZstdErrorMessage(), nullptr);
+  }
+  {
+    ArrayInputStream input(with_dictionary.data(), with_dictionary.size());
+    ZstdInputStream zin(&input);
+    const void* data;
+    int size;
+    EXPECT_FALSE(zin.Next(&data, &size));
+    EXPECT_NE(zin.ZstdErrorMessage(), nullptr);
+  }
+}
+
+TEST_F(IoTest, ZstdTruncated) {
+  std::string compressed;
+  {
+    StringOutputStream output(&compressed);
+    ZstdOutputStream zout(&output);
+    WriteStuffLarge(&zout);
+  }
+  compressed.resize(compressed.size() - 1);
+  ArrayInputStream input(compressed.data(), compressed.size());
+  ZstdInputStream zin(&input);
+  const void* data;
+  int size;
+  while (zin.Next(&data, &size)) {
+  }
+  EXPECT_NE(zin.ZstdErrorMessage(), nullptr);
+}
+#endif  // HAVE_ZSTD
+
+#if HAVE_LZ4
+TEST_F(IoTest, Lz4Io) {
+  const int kBufferSize = 2 * 1024;
+  uint8* buffer = new uint8[kBufferSize];
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      for (int z = 0; z < kBlockSizeCount; z++) {
+        for (bool flush : {false, true}) {
+          int size;
+          {
+            ArrayOutputStream output(buffer, kBufferSize, kBlockSizes[i]);
+            Lz4OutputStream::Options options;
+            if (kBlockSizes[z] != -1) options.buffer_size = kBlockSizes[z];
+            Lz4OutputStream lz4out(&output, options);
+            WriteStuff(&lz4out);
+            if (flush) EXPECT_TRUE(lz4out.Flush());
+            EXPECT_TRUE(lz4out.Close());
+            size = output.ByteCount();
+          }
+          {
+            ArrayInputStream input(buffer, size, kBlockSizes[j]);
+            Lz4InputStream lz4in(&input, kBlockSizes[z]);
+            ReadStuff(&lz4in);
+            EXPECT_EQ(lz4in.Lz4ErrorMessage(), nullptr);
+          }
+        }
+      }
+    }
+  }
+  delete[] buffer;
+}
+
+TEST_F(IoTest, Lz4IoLarge) {
+  // Small buffers make the decompressor hold back output between calls.
+  for (int buffer_size : {7, 1024, 65536}) {
+    std::string compressed;
+    {
+      StringOutputStream output(&compressed);
+      Lz4OutputStream::Options options;
+      options.buffer_size = buffer_size;
+      Lz4OutputStream lz4out(&output, options);
+      WriteStuffLarge(&lz4out);
+      EXPECT_TRUE(lz4out.Close());
+    }
+    {
+      ArrayInputStream input(compressed.data(), compressed.size());
+      Lz4InputStream lz4in(&input, buffer_size);
+      ReadStuffLarge(&lz4in);
+      EXPECT_EQ(lz4in.Lz4ErrorMessage(), nullptr);
+    }
+    {
+      // Concatenated frames read as one stream.
+      std::string concatenated = compressed + compressed;
+      ArrayInputStream input(concatenated.data(), concatenated.size());
+      Lz4InputStream lz4in(&input, buffer_size);
+      const void* data;
+      int size;
+      while (lz4in.Next(&data, &size)) {
+      }
+      EXPECT_EQ(lz4in.ByteCount(), 2 * 200055);
+      EXPECT_EQ(lz4in.Lz4ErrorMessage(), nullptr);
+    }
+  }
+}
+
+TEST_F(IoTest, Lz4Truncated) {
+  std::string compressed;
+  {
+    StringOutputStream output(&compressed);
+    Lz4OutputStream lz4out(&output);
+    WriteStuffLarge(&lz4out);
+  }
+  compressed.resize(compressed.size() - 1);
+  ArrayInputStream input(compressed.data(), compressed.size());
+  Lz4InputStream lz4in(&input);
+  const void* data;
+  int size;
+  while (lz4in.Next(&data, &size)) {
+  }
+  EXPECT_NE(lz4in.Lz4ErrorMessage(), nullptr);
+}
+#endif  // HAVE_LZ4
+
 // There is no string input, only string output.  Also, it doesn't support
 // explicit block sizes.  So, we'll only run one test and we'll use
 // ArrayInput to read back the results.
@@ -1393,6 +1748,28 @@ TEST_F(IoTest, WriteLargeCord) {
   EXPECT_EQ(expected, cord);
 }
 
+TEST_F(IoTest, WriteAliasedRawToCord) {
+  const std::string small = "foo bar";
+  const std::string large(4096, 'x');
+
+  CordOutputStream output(absl::Cord("existing:"));
+  ASSERT_TRUE(output.AllowsAliasing());
+  EXPECT_TRUE(output.WriteAliasedRaw(small.data(), small.size()));
+  EXPECT_TRUE(output.WriteAliasedRaw(large.data(), large.size()));
+  absl::Cord cord = output.Consume();
+  EXPECT_EQ(absl::StrCat("existing:", small, large), std::string(cord));
+
+  // Only the large chunk is referenced rather than copied.
+  bool references_small = false;
+  bool references_large = false;
+  for (absl::string_view chunk : cord.Chunks()) {
+    references_small |= chunk.data() == small.data();
+    references_large |= chunk.data() == large.data();
+  }
+  EXPECT_FALSE(references_small);
+  EXPECT_TRUE(references_large);
+}
+
 // Test that large size hints lead to large block sizes.
 TEST_F(IoTest, CordOutputSizeHint) {
   CordOutputStream output1;
@@ -1475,7 +1852,306 @@ TEST_F(IoTest, FileIo) {
   }
 }
 
+TEST_F(IoTest, FileIoWithAliasedWrites) {
+  std::string filename =
+      absl::StrCat(TestTempDir(), "/zero_copy_stream_test_file");
+  const std::string large(10000, 'x');
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    int file =
+        open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+    ASSERT_GE(file, 0);
+
+    {
+      FileOutputStream output(file, kBlockSizes[i]);
+      ASSERT_TRUE(output.AllowsAliasing());
+      // Leaves a partially filled buffer to be written along with `large`.
+      void* data;
+      int size;
+      ASSERT_TRUE(output.Next(&data, &size));
+      memset(data, 'a', size);
+      output.BackUp(size - 1);
+      EXPECT_TRUE(output.WriteAliasedRaw(large.data(), large.size()));
+      EXPECT_TRUE(output.WriteAliasedRaw("b", 1));
+      EXPECT_EQ(output.ByteCount(), static_cast<int64_t>(large.size() + 2));
+      EXPECT_TRUE(output.Flush());
+      EXPECT_EQ(0, output.GetErrno());
+    }
+
+    ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+    {
+      FileInputStream input(file);
+      std::string contents;
+      const void* data;
+      int size;
+      while (input.Next(&data, &size)) {
+        contents.append(static_cast<const char*>(data), size);
+      }
+      EXPECT_EQ(absl::StrCat("a", large, "b"), contents);
+    }
+
+    close(file);
+  }
+}
+
+TEST_F(IoTest, GatheringFileIo) {
+  std::string filename =
+      absl::StrCat(TestTempDir(), "/zero_copy_stream_test_file");
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int64_t flush_threshold : {0, 100, 1 << 20}) {
+      int file =
+          open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+      ASSERT_GE(file, 0);
+
+      {
+        GatheringFileOutputStream::Options options;
+        options.block_size = kBlockSizes[i];
+        options.flush_threshold = flush_threshold;
+        GatheringFileOutputStream output(file, options);
+        WriteStuff(&output);
+        EXPECT_EQ(0, output.GetErrno());
+      }
+
+      ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+      {
+        FileInputStream input(file);
+        ReadStuff(&input);
+        EXPECT_EQ(0, input.GetErrno());
+      }
+
+      close(file);
+    }
+  }
+}
+
+TEST_F(IoTest, GatheringFileIoWithAliasedWrites) {
+  std::string filename =
+      absl::StrCat(TestTempDir(), "/zero_copy_stream_test_file");
+  const std::string large(10000, 'x');
+  std::string expected;
+
+  for (int64_t flush_threshold : {0, 5000, 1 << 20}) {
+    int file =
+        open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+    ASSERT_GE(file, 0);
+
+    {
+      GatheringFileOutputStream::Options options;
+      options.block_size = 64;
+      options.flush_threshold = flush_threshold;
+      GatheringFileOutputStream output(file, options);
+      ASSERT_TRUE(output.AllowsAliasing());
+      expected.clear();
+      for (int j = 0; j < 10; ++j) {
+        // Interleaves buffered, aliased, and Cord output.
+        void* data;
+        int size;
+        ASSERT_TRUE(output.Next(&data, &size));
+        memset(data, 'a' + j, size);
+        output.BackUp(size - 3);
+        expected.append(3, 'a' + j);
+        EXPECT_TRUE(output.WriteAliasedRaw(large.data(), large.size()));
+        expected.append(large);
+        EXPECT_TRUE(output.WriteAliasedRaw("b", 1));
+        expected.append("b");
+        absl::Cord cord = MakeFragmentedCord(std::vector<std::string>{
+            std::string(1000, 'c'), "d", std::string(600, 'e')});
+        EXPECT_TRUE(output.WriteCord(cord));
+        expected.append(std::string(cord));
+        EXPECT_TRUE(output.WriteCord(absl::Cord("f")));
+        expected.append("f");
+        EXPECT_EQ(output.ByteCount(), static_cast<int64_t>(expected.size()));
+      }
+      EXPECT_TRUE(output.Flush());
+      EXPECT_EQ(0, output.GetErrno());
+      EXPECT_EQ(output.ByteCount(), static_cast<int64_t>(expected.size()));
+    }
+
+    ASSERT_NE(lseek(file, 0, SEEK_SET), (off_t)-1);
+
+    {
+      FileInputStream input(file);
+      std::string contents;
+      const void* data;
+      int size;
+      while (input.Next(&data, &size)) {
+        contents.append(static_cast<const char*>(data), size);
+      }
+      EXPECT_EQ(expected, contents);
+    }
+
+    close(file);
+  }
+}
+
+TEST_F(IoTest, MmapIo) {
+  std::string filename =
+      absl::StrCat(TestTempDir(), "/zero_copy_stream_test_file");
+  // Also covers a stream that starts within the file, at an offset that is
+  // not page aligned.
+  for (int prefix_size : {0, 5000}) {
+    int file =
+        open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0777);
+    ASSERT_GE(file, 0);
+
+    {
+      FileOutputStream prefix(file);
+      WriteString(&prefix, std::string(prefix_size, 'p'));
+      EXPECT_TRUE(prefix.Flush());
+      FileOutputStream output(file);
+      WriteStuff(&output);
+      EXPECT_EQ(0, output.GetErrno());
+    }
+
+    ASSERT_NE(lseek(file, prefix_size, SEEK_SET), (off_t)-1);
+
+    {
+      MmapInputStream input(file);
+#ifndef _WIN32
+      EXPECT_TRUE(input.is_mapped());
+#endif
+      ReadStuff(&input);
+      EXPECT_EQ(0, input.GetErrno());
+    }
+
+    close(file);
+  }
+}
+
+#ifndef _WIN32
+TEST_F(IoTest, MmapIoFallsBackToReading) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  {
+    FileOutputStream output(fds[1]);
+    WriteStuff(&output);
+    EXPECT_TRUE(output.Close());
+  }
+
+  MmapInputStream input(fds[0]);
+  EXPECT_FALSE(input.is_mapped());
+  ReadStuff(&input);
+  EXPECT_EQ(0, input.GetErrno());
+  close(fds[0]);
+}
+#endif
+
+// A CopyingInputStream which returns at most `read_size` bytes of `data`
+// from each Read(), then `final_result`.
+class StringCopyingInputStream : public CopyingInputStream {
+ public:
+  StringCopyingInputStream(std::string data, int read_size,
+                           int final_result = 0)
+      : data_(std::move(data)),
+        read_size_(read_size),
+        final_result_(final_result) {}
+
+  int Read(void* buffer, int size) override {
+    if (position_ == data_.size()) return final_result_;
+    size = std::min({size, read_size_,
+                     static_cast<int>(data_.size() - position_)});
+    memcpy(buffer, data_.data() + position_, size);
+    position_ += size;
+    return size;
+  }
+
+ private:
+  std::string data_;
+  int read_size_;
+  int final_result_;
+  size_t position_ = 0;
+};
+
+TEST_F(IoTest, PrefetchingIo) {
+  const int kBufferSize = 256;
+  uint8_t buffer[kBufferSize];
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int depth : {1, 2, 5}) {
+      int size;
+      {
+        ArrayOutputStream output(buffer, kBufferSize, kBlockSizes[i]);
+        size = WriteStuff(&output);
+      }
+      StringCopyingInputStream copying_input(
+          std::string(reinterpret_cast<char*>(buffer), size), 7);
+      PrefetchingInputStream::Options options;
+      options.chunk_size = kBlockSizes[i];
+      options.depth = depth;
+      PrefetchingInputStream input(&copying_input, options);
+      ReadStuff(&input);
+      EXPECT_FALSE(input.failed());
+    }
+  }
+}
+
+TEST_F(IoTest, PrefetchingIoWithExecutor) {
+  const int kBufferSize = 256;
+  uint8_t buffer[kBufferSize];
+  int size;
+  {
+    ArrayOutputStream output(buffer, kBufferSize);
+    size = WriteStuff(&output);
+  }
+
+  // Run tasks inline.
+  {
+    StringCopyingInputStream copying_input(
+        std::string(reinterpret_cast<char*>(buffer), size), 5);
+    PrefetchingInputStream::Options options;
+    options.chunk_size = 10;
+    options.executor = [](std::function<void()> task) { task(); };
+    PrefetchingInputStream input(&copying_input, options);
+    ReadStuff(&input);
+  }
+
+  // Run each task on a thread of its own.
+  std::vector<std::thread> threads;
+  {
+    StringCopyingInputStream copying_input(
+        std::string(reinterpret_cast<char*>(buffer), size), 5);
+    PrefetchingInputStream::Options options;
+    options.chunk_size = 10;
+    options.executor = [&threads](std::function<void()> task) {
+      threads.emplace_back(std::move(task));
+    };
+    PrefetchingInputStream input(&copying_input, options);
+    ReadStuff(&input);
+  }
+  for (std::thread& thread : threads) thread.join();
+}
+
+TEST_F(IoTest, PrefetchingIoReadError) {
+  PrefetchingInputStream input(
+      new StringCopyingInputStream("foobar", 2, /*final_result=*/-1));
+  input.SetOwnsCopyingStream(true);
+  EXPECT_TRUE(input.Skip(5));
+  EXPECT_EQ(input.ByteCount(), 5);
+  const void* data;
+  int size;
+  ASSERT_TRUE(input.Next(&data, &size));
+  EXPECT_EQ(absl::string_view(static_cast<const char*>(data), size), "r");
+  EXPECT_FALSE(input.Next(&data, &size));
+  EXPECT_TRUE(input.failed());
+}
+
+TEST_F(IoTest, PrefetchingIoDestroyedBeforeEnd) {
+  std::string data(1 << 20, 'x');
+  StringCopyingInputStream copying_input(data, 100);
+  PrefetchingInputStream::Options options;
+  options.chunk_size = 100;
+  PrefetchingInputStream input(&copying_input, options);
+  const void* buffer;
+  int size;
+  ASSERT_TRUE(input.Next(&buffer, &size));
+  EXPECT_EQ(size, 100);
+}
+
 #ifndef _WIN32
+// This tests the FileInputStream with a non blocking file.#ifndef _WIN32
 // This tests the FileInputStream with a non blocking file. It opens a pipe in
 // non blocking mode, then starts reading it. The writing thread starts writing
 // 100ms after that.
@@ -1779,6 +2455,253 @@ TEST_F(IoTest, LimitingInputStreamByteCount) {
   EXPECT_EQ(kHalfBufferSize - 1, input.ByteCount());
 }
 
+TEST_F(IoTest, Crc32cIo) {
+  const int kBufferSize = 256;
+  uint8_t buffer[kBufferSize];
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      int size;
+      {
+        ArrayOutputStream array_output(buffer, kBufferSize, kBlockSizes[i]);
+        Crc32cOutputStream output(&array_output);
+        size = WriteStuff(&output);
+        EXPECT_EQ(absl::ComputeCrc32c(absl::string_view(
+                      reinterpret_cast<char*>(buffer), size)),
+                  output.crc32c());
+      }
+      {
+        ArrayInputStream array_input(buffer, size, kBlockSizes[j]);
+        Crc32cInputStream input(&array_input);
+        ReadStuff(&input);
+        // Skipped bytes are checksummed too.
+        EXPECT_EQ(absl::ComputeCrc32c(absl::string_view(
+                      reinterpret_cast<char*>(buffer), size)),
+                  input.crc32c());
+      }
+    }
+  }
+}
+
+TEST_F(IoTest, Crc32cIoWithAliasedWrites) {
+  absl::Cord result;
+  absl::crc32c_t crc;
+  {
+    CordOutputStream cord_output;
+    Crc32cOutputStream output(&cord_output);
+    ASSERT_TRUE(output.AllowsAliasing());
+    WriteString(&output, "Hello ");
+    EXPECT_TRUE(output.WriteAliasedRaw("world", 5));
+    absl::Cord cord = MakeFragmentedCord(
+        std::vector<std::string>{"!", std::string(1000, 'x'), "?"});
+    EXPECT_TRUE(output.WriteCord(cord));
+    WriteString(&output, "done");
+    crc = output.crc32c();
+    result = cord_output.Consume();
+  }
+  std::string str(result);
+  EXPECT_EQ(str, absl::StrCat("Hello world!", std::string(1000, 'x'), "?done"));
+  EXPECT_EQ(absl::ComputeCrc32c(str), crc);
+}
+
+TEST_F(IoTest, Crc32cInputStreamContinuesChecksum) {
+  const std::string data = "0123456789abcdefghij";
+  ArrayInputStream first_input(data.data(), 10, 3);
+  Crc32cInputStream first(&first_input);
+  ReadString(&first, "0123456789");
+
+  ArrayInputStream second_input(data.data() + 10, 10, 3);
+  Crc32cInputStream second(&second_input, first.crc32c());
+  ReadString(&second, "abcdefghij");
+  EXPECT_EQ(absl::ComputeCrc32c(data), second.crc32c());
+}
+
+TEST_F(IoTest, CoalescingIo) {
+  const int kBufferSize = 256;
+  uint8_t buffer[kBufferSize];
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    ArrayOutputStream output(buffer, kBufferSize, kBlockSizes[i]);
+    int size = WriteStuff(&output);
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      for (int min_chunk_size : {1, 4, 16}) {
+        for (int buffer_size : {1, 8, 32}) {
+          ArrayInputStream array_input(buffer, size, kBlockSizes[j]);
+          CoalescingInputStream::Options options;
+          options.min_chunk_size = min_chunk_size;
+          options.buffer_size = buffer_size;
+          CoalescingInputStream input(&array_input, options);
+          ReadStuff(&input);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(IoTest, CoalescingIoMergesSmallChunks) {
+  std::vector<std::string> pieces;
+  std::string expected;
+  for (int i = 0; i < 1000; i++) {
+    pieces.push_back(absl::StrCat(i % 10));
+    expected += pieces.back();
+  }
+  pieces.push_back(std::string(1000, 'x'));
+  expected += pieces.back();
+  absl::Cord cord = MakeFragmentedCord(pieces);
+
+  CordInputStream cord_input(&cord);
+  CoalescingInputStream::Options options;
+  options.min_chunk_size = 64;
+  options.buffer_size = 256;
+  CoalescingInputStream input(&cord_input, options);
+  std::string result;
+  const void* data;
+  int size;
+  while (input.Next(&data, &size)) {
+    result.append(static_cast<const char*>(data), size);
+    EXPECT_EQ(input.ByteCount(), result.size());
+  }
+  EXPECT_EQ(result, expected);
+  int small_chunks = 0;
+  for (absl::string_view chunk : cord.Chunks()) {
+    if (chunk.size() < 64) ++small_chunks;
+  }
+  EXPECT_GE(input.chunks_coalesced(), small_chunks);
+  // Four full buffers of small chunks, and the large chunk as is.
+  EXPECT_EQ(input.buffers_returned(), 5);
+}
+
+TEST_F(IoTest, CoalescingIoReadCord) {
+  absl::Cord cord = MakeFragmentedCord(std::vector<std::string>{
+      "a", "b", "c", std::string(1000, 'd'), "e"});
+
+  CordInputStream cord_input(&cord);
+  CoalescingInputStream input(&cord_input);
+  const void* data;
+  int size;
+  ASSERT_TRUE(input.Next(&data, &size));
+  EXPECT_EQ(absl::string_view(static_cast<const char*>(data), size), "abc");
+  input.BackUp(2);
+
+  absl::Cord result;
+  EXPECT_TRUE(input.ReadCord(&result, 1001));
+  EXPECT_EQ(result, absl::StrCat("bc", std::string(999, 'd')));
+  EXPECT_EQ(input.ByteCount(), 1002);
+  EXPECT_TRUE(input.Skip(1));
+  ASSERT_TRUE(input.Next(&data, &size));
+  EXPECT_EQ(absl::string_view(static_cast<const char*>(data), size), "e");
+  EXPECT_FALSE(input.Next(&data, &size));
+}
+
+TEST_F(IoTest, RingBufferIo) {
+  // Large enough for one WriteStuff() but not two, so that every offset into
+  // the ring is exercised as the writes wrap around.
+  alignas(RingBuffer::kAlignment) char region[RingBuffer::kHeaderSize + 100];
+  RingBuffer ring(region, sizeof(region));
+  ring.Reset();
+  EXPECT_EQ(ring.capacity(), 100u);
+
+  for (int i = 0; i < 10; i++) {
+    {
+      RingOutputStream output(&ring);
+      EXPECT_EQ(WriteStuff(&output), 68);
+      output.Commit();
+    }
+    EXPECT_EQ(ring.size(), 68u);
+    {
+      RingInputStream input(&ring);
+      ReadStuff(&input);
+      input.Commit();
+    }
+    EXPECT_EQ(ring.size(), 0u);
+  }
+}
+
+TEST_F(IoTest, RingBufferFull) {
+  alignas(RingBuffer::kAlignment) char region[RingBuffer::kHeaderSize + 100];
+  RingBuffer ring(region, sizeof(region));
+  ring.Reset();
+
+  {
+    RingOutputStream output(&ring);
+    EXPECT_EQ(WriteStuff(&output), 68);
+    output.Commit();
+  }
+  {
+    // Only 32 bytes are free; a failed write leaves the ring untouched.
+    RingOutputStream output(&ring);
+    EXPECT_FALSE(WriteToOutput(&output, std::string(40, 'x').data(), 40));
+  }
+  EXPECT_EQ(ring.size(), 68u);
+  {
+    // Nothing is released without Commit().
+    RingInputStream input(&ring);
+    ReadString(&input, "Hello world!\n");
+  }
+  EXPECT_EQ(ring.size(), 68u);
+  {
+    RingInputStream input(&ring);
+    ReadStuff(&input);
+    input.Commit();
+  }
+  {
+    RingOutputStream output(&ring);
+    EXPECT_TRUE(WriteToOutput(&output, std::string(100, 'x').data(), 100));
+    void* data;
+    int size;
+    EXPECT_FALSE(output.Next(&data, &size));
+  }
+}
+
+TEST_F(IoTest, RingBufferProducerConsumer) {
+  constexpr int kMessages = 2000;
+  alignas(RingBuffer::kAlignment) char region[RingBuffer::kHeaderSize + 256];
+  RingBuffer(region, sizeof(region)).Reset();
+
+  std::thread producer([&] {
+    RingBuffer ring(region, sizeof(region));
+    for (int i = 0; i < kMessages;) {
+      RingOutputStream output(&ring);
+      bool ok;
+      {
+        CodedOutputStream coded(&output);
+        std::string payload(i % 50, static_cast<char>('a' + i % 26));
+        coded.WriteVarint32(payload.size());
+        coded.WriteString(payload);
+        coded.Trim();
+        ok = !coded.HadError();
+      }
+      if (ok) {
+        output.Commit();
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  RingBuffer ring(region, sizeof(region));
+  for (int i = 0; i < kMessages;) {
+    RingInputStream input(&ring);
+    std::string payload;
+    bool ok;
+    {
+      CodedInputStream coded(&input);
+      uint32_t size;
+      ok = coded.ReadVarint32(&size) && coded.ReadString(&payload, size);
+    }
+    if (ok) {
+      ASSERT_EQ(payload, std::string(i % 50, static_cast<char>('a' + i % 26)));
+      input.Commit();
+      ++i;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_EQ(ring.size(), 0u);
+}
+
 // Check that a zero-size array doesn't confuse the code.
 TEST(ZeroSizeArray, Input) {
   ArrayInputStream input(NULL, 0);
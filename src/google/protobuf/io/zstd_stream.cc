@@ -0,0 +1,243 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the implementation of classes ZstdInputStream and
+// ZstdOutputStream.
+
+#if HAVE_ZSTD
+#include "google/protobuf/io/zstd_stream.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/log/absl_check.h"
+#include "google/protobuf/port.h"
+#include "zstd.h"
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+static const int kDefaultBufferSize = 65536;
+
+ZstdInputStream::Options::Options() : buffer_size(kDefaultBufferSize) {}
+
+ZstdInputStream::ZstdInputStream(ZeroCopyInputStream* sub_stream)
+    : ZstdInputStream(sub_stream, Options()) {}
+
+ZstdInputStream::ZstdInputStream(ZeroCopyInputStream* sub_stream,
+                                 const Options& options)
+    : sub_stream_(sub_stream),
+      context_(ZSTD_createDCtx()),
+      output_buffer_length_(options.buffer_size) {
+  ABSL_CHECK(context_ != nullptr);
+  ABSL_CHECK_GT(options.buffer_size, 0);
+  output_buffer_ = static_cast<char*>(operator new(output_buffer_length_));
+  if (!options.dictionary.empty()) {
+    size_t result = ZSTD_DCtx_loadDictionary(
+        context_, options.dictionary.data(), options.dictionary.size());
+    if (ZSTD_isError(result)) error_message_ = ZSTD_getErrorName(result);
+  }
+}
+
+ZstdInputStream::~ZstdInputStream() {
+  internal::SizedDelete(output_buffer_, output_buffer_length_);
+  ZSTD_freeDCtx(context_);
+}
+
+bool ZstdInputStream::Decompress() {
+  if (error_message_ != nullptr) return false;
+  byte_count_ += output_end_;
+  output_position_ = 0;
+  output_end_ = 0;
+  ZSTD_outBuffer output = {output_buffer_, output_buffer_length_, 0};
+  while (output.pos == 0) {
+    // A full output buffer may have left decompressed data inside the
+    // context, which must be drained before reading more input.
+    if (input_.pos == input_.size && !flush_pending_) {
+      const void* data;
+      int size;
+      if (!sub_stream_->Next(&data, &size)) {
+        if (in_frame_) error_message_ = "Truncated Zstandard frame";
+        return false;
+      }
+      input_ = {data, static_cast<size_t>(size), 0};
+    }
+    const size_t input_position = input_.pos;
+    size_t result = ZSTD_decompressStream(context_, &output, &input_);
+    if (ZSTD_isError(result)) {
+      error_message_ = ZSTD_getErrorName(result);
+      return false;
+    }
+    // 0 means the end of a frame; another may follow.  A call that found
+    // nothing to do reports the size of the next frame's header instead.
+    if (input_.pos != input_position || output.pos != 0) {
+      in_frame_ = result != 0;
+    }
+    flush_pending_ = output.pos == output.size;
+  }
+  output_end_ = output.pos;
+  return true;
+}
+
+// implements ZeroCopyInputStream ----------------------------------
+bool ZstdInputStream::Next(const void** data, int* size) {
+  if (output_position_ == output_end_ && !Decompress()) return false;
+  *data = output_buffer_ + output_position_;
+  *size = static_cast<int>(output_end_ - output_position_);
+  output_position_ = output_end_;
+  return true;
+}
+void ZstdInputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(static_cast<size_t>(count), output_position_);
+  output_position_ -= count;
+}
+bool ZstdInputStream::Skip(int count) {
+  const void* data;
+  int size = 0;
+  bool ok = Next(&data, &size);
+  while (ok && (size < count)) {
+    count -= size;
+    ok = Next(&data, &size);
+  }
+  if (size > count) {
+    BackUp(size - count);
+  }
+  return ok;
+}
+int64_t ZstdInputStream::ByteCount() const {
+  return byte_count_ + static_cast<int64_t>(output_position_);
+}
+
+// =========================================================================
+
+ZstdOutputStream::Options::Options()
+    : buffer_size(kDefaultBufferSize),
+      compression_level(ZSTD_CLEVEL_DEFAULT) {}
+
+ZstdOutputStream::ZstdOutputStream(ZeroCopyOutputStream* sub_stream)
+    : ZstdOutputStream(sub_stream, Options()) {}
+
+ZstdOutputStream::ZstdOutputStream(ZeroCopyOutputStream* sub_stream,
+                                   const Options& options)
+    : sub_stream_(sub_stream),
+      context_(ZSTD_createCCtx()),
+      input_buffer_length_(options.buffer_size) {
+  ABSL_CHECK(context_ != nullptr);
+  ABSL_CHECK_GT(options.buffer_size, 0);
+  input_buffer_ = static_cast<char*>(operator new(input_buffer_length_));
+  size_t result = ZSTD_CCtx_setParameter(context_, ZSTD_c_compressionLevel,
+                                         options.compression_level);
+  if (!ZSTD_isError(result) && !options.dictionary.empty()) {
+    result = ZSTD_CCtx_loadDictionary(context_, options.dictionary.data(),
+                                      options.dictionary.size());
+  }
+  if (ZSTD_isError(result)) error_message_ = ZSTD_getErrorName(result);
+}
+
+ZstdOutputStream::~ZstdOutputStream() {
+  Close();
+  internal::SizedDelete(input_buffer_, input_buffer_length_);
+  ZSTD_freeCCtx(context_);
+}
+
+// private
+bool ZstdOutputStream::Compress(ZSTD_EndDirective directive) {
+  ZSTD_inBuffer input = {input_buffer_, input_size_, 0};
+  while (true) {
+    if (output_.pos == output_.size) {
+      void* data;
+      int size;
+      if (!sub_stream_->Next(&data, &size)) {
+        output_ = {nullptr, 0, 0};
+        error_message_ = "Failed to write to the underlying stream";
+        return false;
+      }
+      output_ = {data, static_cast<size_t>(size), 0};
+    }
+    size_t remaining =
+        ZSTD_compressStream2(context_, &output_, &input, directive);
+    if (ZSTD_isError(remaining)) {
+      error_message_ = ZSTD_getErrorName(remaining);
+      return false;
+    }
+    // Flushing and ending are only done once nothing is left to write out.
+    if (directive == ZSTD_e_continue ? input.pos == input.size
+                                     : remaining == 0) {
+      break;
+    }
+  }
+  byte_count_ += input_size_;
+  input_size_ = 0;
+  if (directive != ZSTD_e_continue) {
+    // Notify lower layer of data.
+    sub_stream_->BackUp(static_cast<int>(output_.size - output_.pos));
+    // We don't own the buffer anymore.
+    output_ = {nullptr, 0, 0};
+  }
+  return true;
+}
+
+// implements ZeroCopyOutputStream ---------------------------------
+bool ZstdOutputStream::Next(void** data, int* size) {
+  if (closed_ || error_message_ != nullptr) return false;
+  if (input_size_ != 0 && !Compress(ZSTD_e_continue)) return false;
+  *data = input_buffer_;
+  *size = static_cast<int>(input_buffer_length_);
+  input_size_ = input_buffer_length_;
+  return true;
+}
+void ZstdOutputStream::BackUp(int count) {
+  ABSL_CHECK_GE(count, 0);
+  ABSL_CHECK_LE(static_cast<size_t>(count), input_size_);
+  input_size_ -= count;
+}
+int64_t ZstdOutputStream::ByteCount() const {
+  return byte_count_ + static_cast<int64_t>(input_size_);
+}
+
+bool ZstdOutputStream::Flush() {
+  if (closed_ || error_message_ != nullptr) return false;
+  return Compress(ZSTD_e_flush);
+}
+
+bool ZstdOutputStream::Close() {
+  if (closed_) return error_message_ == nullptr;
+  closed_ = true;
+  if (error_message_ != nullptr) return false;
+  return Compress(ZSTD_e_end);
+}
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+#endif  // HAVE_ZSTD
@@ -0,0 +1,191 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the definition for classes ZstdInputStream and
+// ZstdOutputStream, which are the counterparts of GzipInputStream and
+// GzipOutputStream for the Zstandard format.  Zstandard compresses
+// serialized protocol buffers about as well as zlib at several times the
+// speed.
+//
+// Streams of small messages, which have too little data of their own to
+// compress well, can share a dictionary trained on similar messages with
+// `zstd --train`.  The same dictionary must be given to both streams.
+
+#ifndef GOOGLE_PROTOBUF_IO_ZSTD_STREAM_H__
+#define GOOGLE_PROTOBUF_IO_ZSTD_STREAM_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "zstd.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+// A ZeroCopyInputStream that reads Zstandard-compressed data.  Concatenated
+// frames are decompressed one after the other.
+class PROTOBUF_EXPORT ZstdInputStream final : public ZeroCopyInputStream {
+ public:
+  struct PROTOBUF_EXPORT Options {
+    // What size buffer to use internally.  Defaults to 64kB.
+    int buffer_size;
+
+    // The dictionary the data was compressed with, if any.  It is copied,
+    // so it need not outlive the stream.
+    absl::string_view dictionary;
+
+    Options();  // Initializes with default values.
+  };
+
+  explicit ZstdInputStream(ZeroCopyInputStream* sub_stream);
+  ZstdInputStream(ZeroCopyInputStream* sub_stream, const Options& options);
+  ZstdInputStream(const ZstdInputStream&) = delete;
+  ZstdInputStream& operator=(const ZstdInputStream&) = delete;
+  ~ZstdInputStream() override;
+
+  // Return last error message or NULL if no error.
+  const char* ZstdErrorMessage() const { return error_message_; }
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  ZeroCopyInputStream* sub_stream_;
+  ZSTD_DCtx* context_;
+  const char* error_message_ = nullptr;
+
+  // The part of the sub stream's last buffer that is not decompressed yet.
+  ZSTD_inBuffer input_ = {nullptr, 0, 0};
+  // Whether the input read so far ends in the middle of a frame.
+  bool in_frame_ = false;
+  // Whether the last decompression filled the output buffer, so that the
+  // context may still hold decompressed data.
+  bool flush_pending_ = false;
+
+  char* output_buffer_;
+  size_t output_buffer_length_;
+  // Decompressed data in [output_position_, output_end_) is yet to be
+  // returned by Next().
+  size_t output_position_ = 0;
+  size_t output_end_ = 0;
+  // Bytes decompressed into the output buffer before its current contents.
+  int64_t byte_count_ = 0;
+
+  // Refills the output buffer.  Returns false at the end of the input or on
+  // error.
+  bool Decompress();
+};
+
+// A ZeroCopyOutputStream that writes Zstandard-compressed data.
+class PROTOBUF_EXPORT ZstdOutputStream final : public ZeroCopyOutputStream {
+ public:
+  struct PROTOBUF_EXPORT Options {
+    // What size buffer to use internally.  Defaults to 64kB.
+    int buffer_size;
+
+    // Between ZSTD_minCLevel() and ZSTD_maxCLevel(), where higher levels
+    // compress better and more slowly.  Defaults to ZSTD_CLEVEL_DEFAULT
+    // (see zstd.h).
+    int compression_level;
+
+    // A dictionary to compress with, if any.  It is copied, so it need not
+    // outlive the stream.
+    absl::string_view dictionary;
+
+    Options();  // Initializes with default values.
+  };
+
+  // Create a ZstdOutputStream with default options.
+  explicit ZstdOutputStream(ZeroCopyOutputStream* sub_stream);
+
+  // Create a ZstdOutputStream with the given options.
+  ZstdOutputStream(ZeroCopyOutputStream* sub_stream, const Options& options);
+  ZstdOutputStream(const ZstdOutputStream&) = delete;
+  ZstdOutputStream& operator=(const ZstdOutputStream&) = delete;
+
+  ~ZstdOutputStream() override;
+
+  // Return last error message or NULL if no error.
+  const char* ZstdErrorMessage() const { return error_message_; }
+
+  // Flushes data written so far to compressed data in the underlying stream,
+  // so that a reader can decompress it without waiting for Close().  It is
+  // the caller's responsibility to flush the underlying stream if necessary.
+  // Compression may be less efficient stopping and starting around flushes.
+  // Returns true if no error.
+  bool Flush();
+
+  // Writes out all data and ends the Zstandard frame.  It is the caller's
+  // responsibility to close the underlying stream if necessary.
+  // Returns true if no error.
+  bool Close();
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size) override;
+  void BackUp(int count) override;
+  int64_t ByteCount() const override;
+
+ private:
+  ZeroCopyOutputStream* sub_stream_;
+  ZSTD_CCtx* context_;
+  const char* error_message_ = nullptr;
+  bool closed_ = false;
+
+  // The part of the sub stream's last buffer that is not filled yet.
+  ZSTD_outBuffer output_ = {nullptr, 0, 0};
+
+  char* input_buffer_;
+  size_t input_buffer_length_;
+  // The bytes of the input buffer handed out by Next() and not backed up.
+  size_t input_size_ = 0;
+  // Bytes compressed before the current contents of the input buffer.
+  int64_t byte_count_ = 0;
+
+  // Compresses the input buffer with the given directive.  Returns false on
+  // error.
+  bool Compress(ZSTD_EndDirective directive);
+};
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_IO_ZSTD_STREAM_H__
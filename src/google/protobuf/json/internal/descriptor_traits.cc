@@ -0,0 +1,135 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/json/internal/descriptor_traits.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "google/protobuf/descriptor.h"
+#include "absl/base/attributes.h"
+#include "absl/base/const_init.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace json_internal {
+namespace {
+// Returns `"name":`, or an empty string if `name` would have to be escaped.
+std::string QuoteKey(absl::string_view name) {
+  for (char c : name) {
+    if (!absl::ascii_isalnum(c) && c != '_') return "";
+  }
+  return absl::StrCat("\"", name, "\":");
+}
+}  // namespace
+
+FieldNameTable::FieldNameTable(const Descriptor& desc)
+    : keys_(static_cast<size_t>(desc.field_count())) {
+  // Insertions do not overwrite, so this follows the lookup order of
+  // Proto2Descriptor::FieldByName().
+  for (int i = 0; i < desc.field_count(); ++i) {
+    fields_by_name_.emplace(desc.field(i)->camelcase_name(), desc.field(i));
+  }
+  for (int i = 0; i < desc.field_count(); ++i) {
+    fields_by_name_.emplace(desc.field(i)->name(), desc.field(i));
+  }
+  for (int i = 0; i < desc.field_count(); ++i) {
+    const FieldDescriptor* field = desc.field(i);
+    if (field->has_json_name()) {
+      fields_by_name_.emplace(field->json_name(), field);
+    }
+
+    absl::string_view name = field->name();
+    absl::string_view json_name =
+        field->has_json_name() ? field->json_name() : field->camelcase_name();
+    auto& keys = keys_[static_cast<size_t>(i)];
+    keys[kJsonName] = QuoteKey(json_name);
+    keys[kProtoName] = QuoteKey(name);
+    if (!name.empty() && absl::ascii_isupper(name[0]) && !json_name.empty() &&
+        !absl::ascii_isupper(json_name[0])) {
+      keys[kLegacyJsonName] = QuoteKey(absl::StrCat(
+          std::string(1, absl::ascii_toupper(name[0])), name.substr(1)));
+    } else {
+      keys[kLegacyJsonName] = keys[kJsonName];
+    }
+  }
+}
+
+const FieldNameTable* FieldNameTable::Get(const Descriptor& desc) {
+  if (desc.file()->pool() != DescriptorPool::generated_pool()) {
+    return nullptr;
+  }
+
+  // Each thread remembers the tables it used last, so that most lookups do not
+  // take the lock.
+  struct CacheEntry {
+    const Descriptor* desc;
+    const FieldNameTable* table;
+  };
+  static constexpr size_t kCacheSize = 32;
+  static PROTOBUF_THREAD_LOCAL CacheEntry cache[kCacheSize];
+  CacheEntry& entry =
+      cache[(reinterpret_cast<uintptr_t>(&desc) / sizeof(Descriptor)) %
+            kCacheSize];
+  if (entry.desc == &desc) {
+    return entry.table;
+  }
+
+  ABSL_CONST_INIT static absl::Mutex mu(absl::kConstInit);
+  static auto* tables = new absl::flat_hash_map<
+      const Descriptor*, std::unique_ptr<const FieldNameTable>>();
+  const FieldNameTable* table;
+  {
+    absl::MutexLock lock(&mu);
+    auto& slot = (*tables)[&desc];
+    if (slot == nullptr) {
+      slot.reset(new FieldNameTable(desc));
+    }
+    table = slot.get();
+  }
+  entry = {&desc, table};
+  return table;
+}
+
+}  // namespace json_internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -39,12 +39,14 @@
 #include <limits>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/type.pb.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/message.h"
 #include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/absl_log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -149,6 +151,50 @@ using Field = typename Traits::Field;
 template <typename Traits>
 using Desc = typename Traits::Desc;
 
+// The JSON names of the fields of a message type, worked out once per type
+// and shared by all parsers and printers.
+//
+// Tables are only kept for types in the generated pool, since its descriptors
+// are never destroyed.
+class FieldNameTable {
+ public:
+  // How the key of a field is spelled; see WriterOptions.
+  enum KeyStyle {
+    kJsonName,
+    // The JSON name, capitalized if the field name is (allow_legacy_syntax).
+    kLegacyJsonName,
+    kProtoName,
+  };
+
+  FieldNameTable(const FieldNameTable&) = delete;
+  FieldNameTable& operator=(const FieldNameTable&) = delete;
+
+  // Returns the table for `desc`, or nullptr if `desc` is not in the generated
+  // pool. Thread-safe.
+  static const FieldNameTable* Get(const Descriptor& desc);
+
+  // Looks up a field by camelcase name, by name, or by custom JSON name, in
+  // that order. Returns nullptr if there is no such field.
+  const FieldDescriptor* FindField(absl::string_view name) const {
+    auto it = fields_by_name_.find(name);
+    return it == fields_by_name_.end() ? nullptr : it->second;
+  }
+
+  // Returns the key for `field`, a field of this type, quoted and followed by a
+  // colon, or an empty string if the key has to be escaped to be written.
+  absl::string_view QuotedKey(const FieldDescriptor* field,
+                              KeyStyle style) const {
+    return keys_[static_cast<size_t>(field->index())][style];
+  }
+
+ private:
+  explicit FieldNameTable(const Descriptor& desc);
+
+  absl::flat_hash_map<absl::string_view, const FieldDescriptor*>
+      fields_by_name_;
+  std::vector<std::array<std::string, 3>> keys_;
+};
+
 // Traits for proto2-ish descriptors.
 struct Proto2Descriptor {
   // A descriptor for introspecting the fields of a message type.
@@ -191,6 +237,13 @@ struct Proto2Descriptor {
 
   static absl::optional<Field> FieldByName(const Desc& d,
                                            absl::string_view name) {
+    if (const FieldNameTable* table = FieldNameTable::Get(d)) {
+      if (const auto* field = table->FindField(name)) {
+        return field;
+      }
+      return absl::nullopt;
+    }
+
     if (const auto* field = d.FindFieldByCamelcaseName(name)) {
       return field;
     }
@@ -234,6 +287,17 @@ struct Proto2Descriptor {
   }
   static absl::string_view FieldFullName(Field f) { return f->full_name(); }
 
+  // Returns the key for `f`, quoted and followed by a colon, if it is known
+  // ahead of time.
+  static absl::optional<absl::string_view> QuotedFieldKey(
+      Field f, FieldNameTable::KeyStyle style) {
+    const FieldNameTable* table = FieldNameTable::Get(*f->containing_type());
+    if (table == nullptr || table->QuotedKey(f, style).empty()) {
+      return absl::nullopt;
+    }
+    return table->QuotedKey(f, style);
+  }
+
   static absl::string_view FieldTypeName(Field f) {
     if (f->type() == FieldDescriptor::TYPE_MESSAGE) {
       return f->message_type()->full_name();
@@ -298,7 +362,8 @@ struct Proto2Descriptor {
         absl::StrFormat("unknown enum value: '%s'", name));
   }
 
-  static absl::StatusOr<std::string> EnumNameByNumber(Field f, int32_t number) {
+  static absl::StatusOr<absl::string_view> EnumNameByNumber(Field f,
+                                                           int32_t number) {
     if (const auto* ev = f->enum_type()->FindValueByNumber(number)) {
       return ev->name();
     }
@@ -401,6 +466,11 @@ struct Proto3Type {
   }
   static absl::string_view FieldFullName(Field f) { return f->proto().name(); }
 
+  static absl::optional<absl::string_view> QuotedFieldKey(
+      Field f, FieldNameTable::KeyStyle style) {
+    return absl::nullopt;
+  }
+
   static absl::string_view FieldTypeName(Field f) {
     absl::string_view url = f->proto().type_url();
 
@@ -494,7 +564,8 @@ struct Proto3Type {
         absl::StrFormat("unknown enum value: '%s'", name));
   }
 
-  static absl::StatusOr<std::string> EnumNameByNumber(Field f, int32_t number) {
+  static absl::StatusOr<absl::string_view> EnumNameByNumber(Field f,
+                                                           int32_t number) {
     auto e = f->EnumType();
     RETURN_IF_ERROR(e.status());
 
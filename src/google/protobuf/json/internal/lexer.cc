@@ -30,8 +30,12 @@
 
 #include "google/protobuf/json/internal/lexer.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include <sys/types.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cfloat>
 #include <cmath>
@@ -52,6 +56,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "google/protobuf/stubs/status_macros.h"
 
 // Must be included last.
@@ -61,6 +66,40 @@ namespace google {
 namespace protobuf {
 namespace json_internal {
 namespace {
+// Returns the length of the longest prefix of `data` made of characters that
+// stand for themselves in any string: printable ASCII other than quotes and
+// backslashes.
+size_t PlainStringPrefixLength(absl::string_view data) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  // Bytes of 0x80 and up are negative as signed chars, so the one signed
+  // compare catches both control characters and non-ASCII bytes.
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i double_quote = _mm_set1_epi8('"');
+  const __m128i single_quote = _mm_set1_epi8('\'');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  for (; i + 16 <= data.size(); i += 16) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data.data() + i));
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmplt_epi8(chunk, space),
+                     _mm_cmpeq_epi8(chunk, double_quote)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, single_quote),
+                     _mm_cmpeq_epi8(chunk, backslash)));
+    int mask = _mm_movemask_epi8(special);
+    if (mask != 0) {
+      return i + static_cast<size_t>(
+                     absl::countr_zero(static_cast<uint32_t>(mask)));
+    }
+  }
+#endif
+  for (; i < data.size(); ++i) {
+    uint8_t c = static_cast<uint8_t>(data[i]);
+    if (c < 0x20 || c >= 0x80 || c == '"' || c == '\'' || c == '\\') break;
+  }
+  return i;
+}
+
 // Randomly inserts bonus whitespace of a few different kinds into a string.
 //
 // This utility is intended to make error messages hostile to machine
@@ -221,9 +260,14 @@ absl::Status JsonLexer::SkipToToken() {
         break;
       case '\r':
       case '\t':
-      case ' ':
-        RETURN_IF_ERROR(Advance(1));
+      case ' ': {
+        // Skip the whole run of blanks in the buffer at once.
+        absl::string_view unread = stream_.Unread();
+        size_t blanks =
+            std::min(unread.find_first_not_of(" \t\r"), unread.size());
+        RETURN_IF_ERROR(Advance(blanks));
         break;
+      }
       default:
         return absl::OkStatus();
     }
@@ -415,6 +459,18 @@ absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseUtf8() {
   while (true) {
     RETURN_IF_ERROR(stream_.BufferAtLeast(1).status());
 
+    // Consume runs of characters that need no checks or unescaping in bulk;
+    // only the characters that end a run go through the switch below.
+    absl::string_view unread = stream_.Unread();
+    size_t plain = PlainStringPrefixLength(unread);
+    if (plain > 0) {
+      if (!on_heap.empty()) {
+        on_heap.append(unread.data(), plain);
+      }
+      RETURN_IF_ERROR(Advance(plain));
+      continue;
+    }
+
     char c = stream_.PeekChar();
     RETURN_IF_ERROR(Advance(1));
     switch (c) {
@@ -535,6 +591,38 @@ absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseBareWord() {
   return ident;
 }
 
+absl::StatusOr<LocationWith<MaybeOwnedString>> JsonLexer::ParseObjectKey() {
+  RETURN_IF_ERROR(SkipToToken());
+
+  absl::StatusOr<LocationWith<MaybeOwnedString>> key;
+  if (stream_.PeekChar() == '"' || stream_.PeekChar() == '\'') {
+    key = ParseUtf8();
+  } else if (options_.allow_legacy_syntax) {
+    key = ParseBareWord();
+  } else {
+    return Invalid("expected '\"'");
+  }
+
+  RETURN_IF_ERROR(key.status());
+  RETURN_IF_ERROR(Expect(":"));
+  return key;
+}
+
+absl::StatusOr<absl::optional<LocationWith<MaybeOwnedString>>>
+JsonLexer::StartObject() {
+  RETURN_IF_ERROR(Expect("{"));
+  RETURN_IF_ERROR(Push());
+
+  if (Peek("}")) {
+    Pop();
+    return absl::nullopt;
+  }
+
+  absl::StatusOr<LocationWith<MaybeOwnedString>> key = ParseObjectKey();
+  RETURN_IF_ERROR(key.status());
+  return absl::make_optional(*std::move(key));
+}
+
 }  // namespace json_internal
 }  // namespace protobuf
 }  // namespace google
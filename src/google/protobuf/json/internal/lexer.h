@@ -48,6 +48,7 @@
 #include "absl/strings/match.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/json/internal/message_path.h"
 #include "google/protobuf/json/internal/zero_copy_buffered_stream.h"
@@ -212,6 +213,19 @@ class JsonLexer {
   template <typename F>
   absl::Status VisitObject(F f);
 
+  // VisitObject() in two steps, for callers that need to see the first key
+  // of an object before deciding how to parse the rest of it.
+  //
+  // StartObject() parses the opening `{` and the first key up to its `:`, or
+  // the whole object if it is empty, in which case it returns nullopt. After
+  // consuming the value of that key, the caller finishes the object with
+  // VisitObjectRest(), which behaves like VisitObject() for the remaining
+  // keys.
+  absl::StatusOr<absl::optional<LocationWith<MaybeOwnedString>>>
+  StartObject();
+  template <typename F>
+  absl::Status VisitObjectRest(F f);
+
   // Parses a single value and discards it.
   absl::Status SkipValue();
 
@@ -268,6 +282,9 @@ class JsonLexer {
   // "unquoted keys" extension.
   absl::StatusOr<LocationWith<MaybeOwnedString>> ParseBareWord();
 
+  // Parses an object key and the `:` that follows it.
+  absl::StatusOr<LocationWith<MaybeOwnedString>> ParseObjectKey();
+
   absl::Status Advance(size_t bytes) {
     RETURN_IF_ERROR(stream_.Advance(bytes));
     json_loc_.offset += static_cast<int>(bytes);
@@ -314,35 +331,28 @@ absl::Status JsonLexer::VisitArray(F f) {
 // `f` should have type `(MaybeOwnedString&) -> absl::Status`.
 template <typename F>
 absl::Status JsonLexer::VisitObject(F f) {
-  RETURN_IF_ERROR(Expect("{"));
-  RETURN_IF_ERROR(Push());
-
-  if (Peek("}")) {
-    Pop();
+  absl::StatusOr<absl::optional<LocationWith<MaybeOwnedString>>> key =
+      StartObject();
+  RETURN_IF_ERROR(key.status());
+  if (!key->has_value()) {
     return absl::OkStatus();
   }
+  RETURN_IF_ERROR(f(**key));
+  return VisitObjectRest(std::move(f));
+}
 
-  bool has_comma = true;
-  do {
+template <typename F>
+absl::Status JsonLexer::VisitObjectRest(F f) {
+  bool has_comma = Peek(",");
+  while (!Peek("}")) {
     if (!has_comma) {
       return Invalid("expected ','");
     }
-    RETURN_IF_ERROR(SkipToToken());
-
-    absl::StatusOr<LocationWith<MaybeOwnedString>> key;
-    if (stream_.PeekChar() == '"' || stream_.PeekChar() == '\'') {
-      key = ParseUtf8();
-    } else if (options_.allow_legacy_syntax) {
-      key = ParseBareWord();
-    } else {
-      return Invalid("expected '\"'");
-    }
-
+    absl::StatusOr<LocationWith<MaybeOwnedString>> key = ParseObjectKey();
     RETURN_IF_ERROR(key.status());
-    RETURN_IF_ERROR(Expect(":"));
     RETURN_IF_ERROR(f(*key));
     has_comma = Peek(",");
-  } while (!Peek("}"));
+  }
   Pop();
 
   if (!options_.allow_legacy_syntax && has_comma) {
@@ -343,6 +343,20 @@ TEST(LexerTest, Cjk) {
   });
 }
 
+TEST(LexerTest, LongStrings) {
+  // Long enough to be scanned in several blocks, with special characters at
+  // either end of a block.
+  Do(R"json("0123456789abcdef0123456789ab\"ef0123'56789abcdéf012\\")json",
+     [](io::ZeroCopyInputStream* stream) {
+       EXPECT_THAT(Value::Parse(stream),
+                   IsOkAndHolds(ValueIs<std::string>(
+                       "0123456789abcdef0123456789ab\"ef0123'"
+                       "56789abcdéf012\\")));
+     });
+  BadInner("\"0123456789abcdef0123456789\1bcdef\"");
+  Bad("\"0123456789abcdef0123456789\xff" "bcdef\"");
+}
+
 TEST(LexerTest, BrokenString) {
   Bad(R"json("broken)json");
   Bad(R"json("broken')json");
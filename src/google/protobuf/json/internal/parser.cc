@@ -326,8 +326,8 @@ absl::StatusOr<double> ParseFp(JsonLexer& lex, Field<Traits> field) {
 }
 
 template <typename Traits>
-absl::StatusOr<std::string> ParseStrOrBytes(JsonLexer& lex,
-                                            Field<Traits> field) {
+absl::StatusOr<MaybeOwnedString> ParseStrOrBytes(JsonLexer& lex,
+                                                 Field<Traits> field) {
   absl::StatusOr<LocationWith<MaybeOwnedString>> str = lex.ParseUtf8();
   RETURN_IF_ERROR(str.status());
 
@@ -341,7 +341,7 @@ absl::StatusOr<std::string> ParseStrOrBytes(JsonLexer& lex,
     b64.resize(decoded->size());
   }
 
-  return std::move(str->value.ToString());
+  return std::move(str->value);
 }
 
 template <typename Traits>
@@ -521,7 +521,7 @@ absl::Status ParseSingular(JsonLexer& lex, Field<Traits> field,
     case FieldDescriptor::TYPE_BYTES: {
       auto x = ParseStrOrBytes<Traits>(lex, field);
       RETURN_IF_ERROR(x.status());
-      Traits::SetString(field, msg, *x);
+      Traits::SetString(field, msg, *std::move(x));
       break;
     }
     case FieldDescriptor::TYPE_ENUM: {
@@ -730,8 +730,7 @@ absl::Status ParseMap(JsonLexer& lex, Field<Traits> field, Msg<Traits>& msg) {
                   break;
                 }
                 case FieldDescriptor::TYPE_STRING: {
-                  Traits::SetString(key_field, entry,
-                                    std::move(key.value.ToString()));
+                  Traits::SetString(key_field, entry, std::move(key.value));
                   break;
                 }
                 default:
@@ -992,32 +991,91 @@ absl::Status ParseFieldMask(JsonLexer& lex, const Desc<Traits>& desc,
   return absl::OkStatus();
 }
 
+// Parses the field `name` of an Any whose packed type, `desc`, is known. The
+// contents of a well-known type are expected inside a JSON field named
+// "value".
+template <typename Traits>
+absl::Status ParseAnyField(JsonLexer& lex, const Desc<Traits>& desc,
+                           MessageType type,
+                           LocationWith<MaybeOwnedString>& name,
+                           Msg<Traits>& msg) {
+  if (name.value == "@type") {
+    RETURN_IF_ERROR(lex.SkipValue());
+    return absl::OkStatus();
+  }
+  if (type != MessageType::kNotWellKnown) {
+    if (name.value != "value") {
+      return lex.Invalid(
+          "fields in a well-known-typed Any must be @type or value");
+    }
+    // Parse the upcoming value as the message itself. This is *not*
+    // an Any reparse because we do not expect to see @type in the
+    // upcoming value.
+    return ParseMessage<Traits>(lex, desc, msg,
+                                /*any_reparse=*/false);
+  }
+
+  return ParseField<Traits>(lex, desc, name.value.AsView(), msg);
+}
+
 template <typename Traits>
 absl::Status ParseAny(JsonLexer& lex, const Desc<Traits>& desc,
                       Msg<Traits>& msg) {
-  // Buffer an entire object. Because @type can occur anywhere, we're forced
-  // to do this.
+  // Until we know that @type comes first, buffer the object: if it does not,
+  // we will need to reparse the object once we have found @type.
   RETURN_IF_ERROR(lex.SkipToToken());
   auto mark = lex.BeginMark();
 
-  // Search for @type, buffering the entire object along the way so we can
-  // reparse it.
+  absl::StatusOr<absl::optional<LocationWith<MaybeOwnedString>>> first_key =
+      lex.StartObject();
+  RETURN_IF_ERROR(first_key.status());
+
+  if (first_key->has_value() && (*first_key)->value == "@type") {
+    // This is the common case, and the order in which we print Any, so the
+    // rest of the object can be parsed in place without buffering it.
+    std::move(mark.value).Discard();
+
+    absl::StatusOr<LocationWith<MaybeOwnedString>> type_url = lex.ParseUtf8();
+    RETURN_IF_ERROR(type_url.status());
+    Traits::SetString(Traits::MustHaveField(desc, 1), msg,
+                      type_url->value.AsView());
+    return Traits::NewDynamic(
+        Traits::MustHaveField(desc, 2), type_url->value.ToString(), msg,
+        [&](const Desc<Traits>& desc, Msg<Traits>& msg) {
+          auto pop = lex.path().Push("<any>", FieldDescriptor::TYPE_MESSAGE,
+                                     Traits::TypeName(desc));
+          MessageType type = ClassifyMessage(Traits::TypeName(desc));
+          return lex.VisitObjectRest(
+              [&](LocationWith<MaybeOwnedString>& name) -> absl::Status {
+                if (name.value == "@type") {
+                  return name.loc.Invalid("repeated @type in Any");
+                }
+                return ParseAnyField<Traits>(lex, desc, type, name, msg);
+              });
+        });
+  }
+
+  // Search the rest of the object for @type, buffering it along the way so we
+  // can reparse it.
   absl::optional<MaybeOwnedString> type_url;
-  RETURN_IF_ERROR(lex.VisitObject(
-      [&](const LocationWith<MaybeOwnedString>& key) -> absl::Status {
-        if (key.value == "@type") {
-          if (type_url.has_value()) {
-            return key.loc.Invalid("repeated @type in Any");
-          }
+  if (first_key->has_value()) {
+    RETURN_IF_ERROR(lex.SkipValue());
+    RETURN_IF_ERROR(lex.VisitObjectRest(
+        [&](const LocationWith<MaybeOwnedString>& key) -> absl::Status {
+          if (key.value == "@type") {
+            if (type_url.has_value()) {
+              return key.loc.Invalid("repeated @type in Any");
+            }
 
-          absl::StatusOr<LocationWith<MaybeOwnedString>> maybe_url =
-              lex.ParseUtf8();
-          RETURN_IF_ERROR(maybe_url.status());
-          type_url = std::move(maybe_url)->value;
-          return absl::OkStatus();
-        }
-        return lex.SkipValue();
-      }));
+            absl::StatusOr<LocationWith<MaybeOwnedString>> maybe_url =
+                lex.ParseUtf8();
+            RETURN_IF_ERROR(maybe_url.status());
+            type_url = std::move(maybe_url)->value;
+            return absl::OkStatus();
+          }
+          return lex.SkipValue();
+        }));
+  }
 
   // Build a new lexer over the skipped object.
   absl::string_view any_text = mark.value.UpToUnread();
@@ -1098,7 +1156,7 @@ absl::Status ParseValue(JsonLexer& lex, const Desc<Traits>& desc,
 
       auto str = lex.ParseUtf8();
       RETURN_IF_ERROR(str.status());
-      Traits::SetString(field, msg, std::move(str->value.ToString()));
+      Traits::SetString(field, msg, std::move(str->value));
       break;
     }
     case JsonLexer::kFalse:
@@ -1276,26 +1334,9 @@ absl::Status ParseMessage(JsonLexer& lex, const Desc<Traits>& desc,
 
   return lex.VisitObject(
       [&](LocationWith<MaybeOwnedString>& name) -> absl::Status {
-        // If this is a well-known type, we expect its contents to be inside
-        // of a JSON field named "value".
         if (any_reparse) {
-          if (name.value == "@type") {
-            RETURN_IF_ERROR(lex.SkipValue());
-            return absl::OkStatus();
-          }
-          if (type != MessageType::kNotWellKnown) {
-            if (name.value != "value") {
-              return lex.Invalid(
-                  "fields in a well-known-typed Any must be @type or value");
-            }
-            // Parse the upcoming value as the message itself. This is *not*
-            // an Any reparse because we do not expect to see @type in the
-            // upcoming value.
-            return ParseMessage<Traits>(lex, desc, msg,
-                                        /*any_reparse=*/false);
-          }
+          return ParseAnyField<Traits>(lex, desc, type, name, msg);
         }
-
         return ParseField<Traits>(lex, desc, name.value.AsView(), msg);
       });
 }
@@ -34,23 +34,28 @@
 #include <cfloat>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 
+#include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/type.pb.h"
 #include "absl/base/attributes.h"
 #include "absl/base/casts.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/json/internal/descriptor_traits.h"
+#include "google/protobuf/json/internal/zero_copy_buffered_stream.h"
+#include "google/protobuf/reflection_ops.h"
 #include "google/protobuf/wire_format_lite.h"
 #include "google/protobuf/stubs/status_macros.h"
 
@@ -126,6 +131,19 @@ struct ParseProto2Descriptor : Proto2Descriptor {
   static absl::Status NewMsg(Field f, Msg& msg, F body) {
     RecordAsSeen(f, msg);
 
+    if (f->is_map()) {
+      // Map entries are built on their own and stored in the map itself,
+      // leaving the map's repeated-field mirror alone.
+      std::unique_ptr<Message> entry(msg.msg_->GetReflection()
+                                         ->GetMessageFactory()
+                                         ->GetPrototype(f->message_type())
+                                         ->New());
+      Msg wrapper(entry.get());
+      RETURN_IF_ERROR(body(*f->message_type(), wrapper));
+      internal::ReflectionOps::InsertMapEntry(msg.msg_, f, entry.get());
+      return absl::OkStatus();
+    }
+
     Message* new_msg;
     if (f->is_repeated()) {
       new_msg = msg.msg_->GetReflection()->AddMessage(msg.msg_, f);
@@ -224,11 +242,22 @@ struct ParseProto2Descriptor : Proto2Descriptor {
   }
 
   static void SetString(Field f, Msg& msg, absl::string_view x) {
+    SetString(f, msg, MaybeOwnedString(std::string(x)));
+  }
+
+  // Moves the string into the field if the lexer already had to copy it,
+  // rather than copying it again.
+  static void SetString(Field f, Msg& msg, MaybeOwnedString&& x) {
     RecordAsSeen(f, msg);
+    std::string& value = x.ToString();
     if (f->is_repeated()) {
-      msg.msg_->GetReflection()->AddString(msg.msg_, f, std::string(x));
+      msg.msg_->GetReflection()->AddString(msg.msg_, f, std::move(value));
+    } else if (internal::cpp::EffectiveStringCType(f) == FieldOptions::CORD) {
+      // Cords adopt large strings instead of copying them.
+      msg.msg_->GetReflection()->SetString(msg.msg_, f,
+                                           absl::Cord(std::move(value)));
     } else {
-      msg.msg_->GetReflection()->SetString(msg.msg_, f, std::string(x));
+      msg.msg_->GetReflection()->SetString(msg.msg_, f, std::move(value));
     }
   }
 
@@ -251,11 +280,38 @@ struct ParseProto2Descriptor : Proto2Descriptor {
 struct ParseProto3Type : Proto3Type {
   class Msg {
    public:
-    explicit Msg(io::ZeroCopyOutputStream* stream) : stream_(stream) {}
+    explicit Msg(io::ZeroCopyOutputStream* stream)
+        : stream_(stream), buf_(&own_buf_) {}
+    ~Msg() { Flush(); }
+
+    Msg(const Msg&) = delete;
+    Msg& operator=(const Msg&) = delete;
 
    private:
     friend ParseProto3Type;
-    io::CodedOutputStream stream_;
+
+    // A submessage of `parent`, written in place at the end of `parent`'s
+    // buffer; the length prefix in front of it is patched in once it is done.
+    explicit Msg(Msg& parent) : stream_(nullptr), buf_(parent.buf_) {}
+
+    // Top-level messages hand their buffer to `stream_` once it holds at least
+    // this many bytes, so only the top-level field being parsed is buffered.
+    static constexpr size_t kFlushThreshold = 4096;
+
+    void MaybeFlush() {
+      if (stream_ != nullptr && buf_->size() >= kFlushThreshold) Flush();
+    }
+
+    void Flush() {
+      if (stream_ == nullptr || buf_->empty()) return;
+      io::CodedOutputStream(stream_).WriteRaw(buf_->data(),
+                                              static_cast<int>(buf_->size()));
+      buf_->clear();
+    }
+
+    io::ZeroCopyOutputStream* stream_;
+    std::string own_buf_;
+    std::string* buf_;
     absl::flat_hash_set<int32_t> parsed_oneofs_indices_;
     absl::flat_hash_set<int32_t> parsed_fields_;
   };
@@ -292,39 +348,53 @@ struct ParseProto3Type : Proto3Type {
     return WithDynamicType(
         f->parent(), type_url, [&](const Desc& desc) -> absl::Status {
           if (f->proto().kind() == google::protobuf::Field::TYPE_GROUP) {
-            msg.stream_.WriteTag(f->proto().number() << 3 |
-                                 WireFormatLite::WIRETYPE_START_GROUP);
-            RETURN_IF_ERROR(body(desc, msg));
-            msg.stream_.WriteTag(f->proto().number() << 3 |
-                                 WireFormatLite::WIRETYPE_END_GROUP);
+            WriteTag(f, msg, WireFormatLite::WIRETYPE_START_GROUP);
+            {
+              Msg new_msg(msg);
+              RETURN_IF_ERROR(body(desc, new_msg));
+            }
+            WriteTag(f, msg, WireFormatLite::WIRETYPE_END_GROUP);
+            msg.MaybeFlush();
             return absl::OkStatus();
           }
 
-          std::string out;
-          io::StringOutputStream stream(&out);
-          Msg new_msg(&stream);
-          RETURN_IF_ERROR(body(desc, new_msg));
+          // The submessage is written straight after its tag, behind a
+          // one-byte length placeholder. Only submessages of 128 bytes or
+          // more need a longer prefix, and are shifted to make room for it.
+          WriteTag(f, msg, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+          std::string& buf = *msg.buf_;
+          size_t start = buf.size();
+          buf.push_back('\0');
+          {
+            Msg new_msg(msg);
+            RETURN_IF_ERROR(body(desc, new_msg));
+          }
 
-          new_msg.stream_.Trim();  // Should probably be called "Flush()".
-          absl::string_view written(
-              out.data(), static_cast<size_t>(new_msg.stream_.ByteCount()));
-          SetString(f, msg, written);
+          uint8_t prefix[5];
+          size_t size = buf.size() - start - 1;
+          size_t prefix_size = static_cast<size_t>(
+              io::CodedOutputStream::WriteVarint32ToArray(
+                  static_cast<uint32_t>(size), prefix) -
+              prefix);
+          if (prefix_size > 1) buf.insert(start + 1, prefix_size - 1, '\0');
+          std::memcpy(&buf[start], prefix, prefix_size);
+          msg.MaybeFlush();
           return absl::OkStatus();
         });
   }
 
   static void SetFloat(Field f, Msg& msg, float x) {
     RecordAsSeen(f, msg);
-    msg.stream_.WriteTag(f->proto().number() << 3 |
-                         WireFormatLite::WIRETYPE_FIXED32);
-    msg.stream_.WriteLittleEndian32(absl::bit_cast<uint32_t>(x));
+    WriteTag(f, msg, WireFormatLite::WIRETYPE_FIXED32);
+    WriteFixed32(msg, absl::bit_cast<uint32_t>(x));
+    msg.MaybeFlush();
   }
 
   static void SetDouble(Field f, Msg& msg, double x) {
     RecordAsSeen(f, msg);
-    msg.stream_.WriteTag(f->proto().number() << 3 |
-                         WireFormatLite::WIRETYPE_FIXED64);
-    msg.stream_.WriteLittleEndian64(absl::bit_cast<uint64_t>(x));
+    WriteTag(f, msg, WireFormatLite::WIRETYPE_FIXED64);
+    WriteFixed64(msg, absl::bit_cast<uint64_t>(x));
+    msg.MaybeFlush();
   }
 
   static void SetInt64(Field f, Msg& msg, int64_t x) {
@@ -353,28 +423,56 @@ struct ParseProto3Type : Proto3Type {
 
   static void SetBool(Field f, Msg& msg, bool x) {
     RecordAsSeen(f, msg);
-    msg.stream_.WriteTag(f->proto().number() << 3);
-    char b = x ? 0x01 : 0x00;
-    msg.stream_.WriteRaw(&b, 1);
+    WriteTag(f, msg, WireFormatLite::WIRETYPE_VARINT);
+    msg.buf_->push_back(x ? 0x01 : 0x00);
+    msg.MaybeFlush();
   }
 
   static void SetString(Field f, Msg& msg, absl::string_view x) {
     RecordAsSeen(f, msg);
-    msg.stream_.WriteTag(f->proto().number() << 3 |
-                         WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
-    msg.stream_.WriteVarint64(static_cast<uint64_t>(x.size()));
-    msg.stream_.WriteRaw(x.data(), x.size());
+    WriteTag(f, msg, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+    WriteVarint(msg, static_cast<uint64_t>(x.size()));
+    msg.buf_->append(x.data(), x.size());
+    msg.MaybeFlush();
+  }
+
+  static void SetString(Field f, Msg& msg, MaybeOwnedString&& x) {
+    SetString(f, msg, x.AsView());
   }
 
   static void SetEnum(Field f, Msg& msg, int32_t x) {
     RecordAsSeen(f, msg);
-    msg.stream_.WriteTag(f->proto().number() << 3);
+    WriteTag(f, msg, WireFormatLite::WIRETYPE_VARINT);
     // Sign extension is deliberate here.
-    msg.stream_.WriteVarint32(x);
+    WriteVarint(msg, static_cast<uint32_t>(x));
+    msg.MaybeFlush();
   }
 
  private:
   using Kind = google::protobuf::Field::Kind;
+
+  static void WriteTag(Field f, Msg& msg, WireFormatLite::WireType type) {
+    WriteVarint(msg, static_cast<uint32_t>(f->proto().number()) << 3 | type);
+  }
+
+  static void WriteVarint(Msg& msg, uint64_t x) {
+    uint8_t bytes[10];
+    uint8_t* end = io::CodedOutputStream::WriteVarint64ToArray(x, bytes);
+    msg.buf_->append(reinterpret_cast<char*>(bytes), end - bytes);
+  }
+
+  static void WriteFixed32(Msg& msg, uint32_t x) {
+    uint8_t bytes[sizeof(x)];
+    io::CodedOutputStream::WriteLittleEndian32ToArray(x, bytes);
+    msg.buf_->append(reinterpret_cast<char*>(bytes), sizeof(bytes));
+  }
+
+  static void WriteFixed64(Msg& msg, uint64_t x) {
+    uint8_t bytes[sizeof(x)];
+    io::CodedOutputStream::WriteLittleEndian64ToArray(x, bytes);
+    msg.buf_->append(reinterpret_cast<char*>(bytes), sizeof(bytes));
+  }
+
   // Sets a field of *some* integer type, with the given kinds for the possible
   // encodings. This avoids quadruplicating this code in the helpers for the
   // four major integer types.
@@ -390,29 +488,27 @@ struct ParseProto3Type : Proto3Type {
             internal::WireFormatLite::ZigZagEncode64(static_cast<int64_t>(x)));
         ABSL_FALLTHROUGH_INTENDED;
       case varint:
-        msg.stream_.WriteTag(f->proto().number() << 3 |
-                             WireFormatLite::WIRETYPE_VARINT);
+        WriteTag(f, msg, WireFormatLite::WIRETYPE_VARINT);
         if (sizeof(Int) == 4) {
-          msg.stream_.WriteVarint32(static_cast<uint32_t>(x));
+          WriteVarint(msg, static_cast<uint32_t>(x));
         } else {
-          msg.stream_.WriteVarint64(static_cast<uint64_t>(x));
+          WriteVarint(msg, static_cast<uint64_t>(x));
         }
         break;
       case fixed: {
         if (sizeof(Int) == 4) {
-          msg.stream_.WriteTag(f->proto().number() << 3 |
-                               WireFormatLite::WIRETYPE_FIXED32);
-          msg.stream_.WriteLittleEndian32(static_cast<uint32_t>(x));
+          WriteTag(f, msg, WireFormatLite::WIRETYPE_FIXED32);
+          WriteFixed32(msg, static_cast<uint32_t>(x));
         } else {
-          msg.stream_.WriteTag(f->proto().number() << 3 |
-                               WireFormatLite::WIRETYPE_FIXED64);
-          msg.stream_.WriteLittleEndian64(static_cast<uint64_t>(x));
+          WriteTag(f, msg, WireFormatLite::WIRETYPE_FIXED64);
+          WriteFixed64(msg, static_cast<uint64_t>(x));
         }
         break;
       }
       default: {  // Unreachable.
       }
     }
+    msg.MaybeFlush();
   }
 };
 }  // namespace json_internal
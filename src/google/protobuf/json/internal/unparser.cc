@@ -30,6 +30,7 @@
 
 #include "google/protobuf/json/internal/unparser.h"
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
 #include <complex>
@@ -41,6 +42,7 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/dynamic_message.h"
@@ -48,17 +50,22 @@
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/json/internal/descriptor_traits.h"
 #include "google/protobuf/json/internal/unparser_traits.h"
 #include "google/protobuf/json/internal/writer.h"
+#include "google/protobuf/wire_format_lite.h"
 #include "google/protobuf/stubs/status_macros.h"
 
 // Must be included last.
@@ -68,6 +75,8 @@ namespace google {
 namespace protobuf {
 namespace json_internal {
 namespace {
+using ::google::protobuf::internal::WireFormatLite;
+
 template <typename Traits>
 bool IsEmpty(const Msg<Traits>& msg, const Desc<Traits>& desc) {
   size_t count = Traits::FieldCount(desc);
@@ -260,15 +269,13 @@ absl::Status WriteSingular(JsonWriter& writer, Field<Traits> field,
   return absl::OkStatus();
 }
 
+// Writes the elements [begin, end) of a repeated field, each preceded by a
+// comma unless `first` is set.
 template <typename Traits>
-absl::Status WriteRepeated(JsonWriter& writer, const Msg<Traits>& msg,
-                           Field<Traits> field) {
-  writer.Write("[");
-  writer.Push();
-
-  size_t count = Traits::GetSize(field, msg);
-  bool first = true;
-  for (size_t i = 0; i < count; ++i) {
+absl::Status WriteElements(JsonWriter& writer, const Msg<Traits>& msg,
+                           Field<Traits> field, size_t begin, size_t end,
+                           bool& first) {
+  for (size_t i = begin; i < end; ++i) {
     if (ClassifyMessage(Traits::FieldTypeName(field)) == MessageType::kValue) {
       bool empty = false;
       RETURN_IF_ERROR(Traits::WithFieldType(
@@ -288,6 +295,69 @@ absl::Status WriteRepeated(JsonWriter& writer, const Msg<Traits>& msg,
     writer.NewLine();
     RETURN_IF_ERROR(WriteSingular<Traits>(writer, field, msg, i));
   }
+  return absl::OkStatus();
+}
+
+// Writes the elements of a repeated message field in chunks, each printed by
+// a task of its own into a buffer of its own.
+template <typename Traits>
+absl::Status WriteElementsInParallel(JsonWriter& writer,
+                                     const Msg<Traits>& msg,
+                                     Field<Traits> field, size_t count,
+                                     bool& first) {
+  const size_t num_tasks = std::min(
+      count,
+      static_cast<size_t>(std::max(1, writer.options().parallel_num_tasks)));
+  std::vector<std::string> chunks(num_tasks);
+  std::vector<absl::Status> statuses(num_tasks);
+  absl::BlockingCounter pending(static_cast<int>(num_tasks));
+  for (size_t task = 0; task < num_tasks; ++task) {
+    writer.options().executor([&, task] {
+      {
+        io::StringOutputStream out(&chunks[task]);
+        JsonWriter chunk_writer(&out, writer);
+        // Every element is preceded by a comma; the one in front of the
+        // first element overall is dropped below.
+        bool chunk_first = false;
+        statuses[task] = WriteElements<Traits>(
+            chunk_writer, msg, field, count * task / num_tasks,
+            count * (task + 1) / num_tasks, chunk_first);
+      }
+      pending.DecrementCount();
+    });
+  }
+  pending.Wait();
+
+  for (size_t task = 0; task < num_tasks; ++task) {
+    RETURN_IF_ERROR(statuses[task]);
+    absl::string_view chunk = chunks[task];
+    if (chunk.empty()) continue;
+    if (first) {
+      first = false;
+      chunk.remove_prefix(1);
+    }
+    writer.Write(chunk);
+  }
+  return absl::OkStatus();
+}
+
+template <typename Traits>
+absl::Status WriteRepeated(JsonWriter& writer, const Msg<Traits>& msg,
+                           Field<Traits> field) {
+  writer.Write("[");
+  writer.Push();
+
+  size_t count = Traits::GetSize(field, msg);
+  bool first = true;
+  if (writer.options().executor &&
+      Traits::FieldType(field) == FieldDescriptor::TYPE_MESSAGE &&
+      count >= static_cast<size_t>(
+                   std::max(1, writer.options().parallel_min_elements))) {
+    RETURN_IF_ERROR(
+        WriteElementsInParallel<Traits>(writer, msg, field, count, first));
+  } else {
+    RETURN_IF_ERROR(WriteElements<Traits>(writer, msg, field, 0, count, first));
+  }
 
   writer.Pop();
   if (!first) {
@@ -412,23 +482,18 @@ absl::Status WriteMap(JsonWriter& writer, const Msg<Traits>& msg,
 }
 
 template <typename Traits>
-absl::Status WriteField(JsonWriter& writer, const Msg<Traits>& msg,
-                        Field<Traits> field, bool& first) {
-  if (!Traits::IsRepeated(field)) {  // Repeated case is handled in
-                                     // WriteRepeated.
-    auto is_empty = IsEmptyValue<Traits>(msg, field);
-    RETURN_IF_ERROR(is_empty.status());
-    if (*is_empty) {
-      // Empty google.protobuf.Values are silently discarded.
-      return absl::OkStatus();
-    }
-  }
-
-  writer.WriteComma(first);
-  writer.NewLine();
-
+void WriteFieldName(JsonWriter& writer, Field<Traits> field) {
+  FieldNameTable::KeyStyle style =
+      writer.options().preserve_proto_field_names
+          ? FieldNameTable::kProtoName
+          : writer.options().allow_legacy_syntax
+                ? FieldNameTable::kLegacyJsonName
+                : FieldNameTable::kJsonName;
+  absl::optional<absl::string_view> key;
   if (Traits::IsExtension(field)) {
     writer.Write(MakeQuoted("[", Traits::FieldFullName(field), "]"), ":");
+  } else if ((key = Traits::QuotedFieldKey(field, style)).has_value()) {
+    writer.Write(*key);
   } else if (writer.options().preserve_proto_field_names) {
     writer.Write(MakeQuoted(Traits::FieldName(field)), ":");
   } else {
@@ -450,6 +515,24 @@ absl::Status WriteField(JsonWriter& writer, const Msg<Traits>& msg,
     }
   }
   writer.Whitespace(" ");
+}
+
+template <typename Traits>
+absl::Status WriteField(JsonWriter& writer, const Msg<Traits>& msg,
+                        Field<Traits> field, bool& first) {
+  if (!Traits::IsRepeated(field)) {  // Repeated case is handled in
+                                     // WriteRepeated.
+    auto is_empty = IsEmptyValue<Traits>(msg, field);
+    RETURN_IF_ERROR(is_empty.status());
+    if (*is_empty) {
+      // Empty google.protobuf.Values are silently discarded.
+      return absl::OkStatus();
+    }
+  }
+
+  writer.WriteComma(first);
+  writer.NewLine();
+  WriteFieldName<Traits>(writer, field);
 
   if (Traits::IsMap(field)) {
     return WriteMap<Traits>(writer, msg, field);
@@ -851,6 +934,197 @@ absl::Status WriteMessage(JsonWriter& writer, const Msg<Traits>& msg,
     }
   }
 }
+
+// The functions below write JSON for wire format as it is read, instead of
+// parsing all of it into an UntypedMessage first; see
+// WriterOptions::stream_canonical_binary_input.
+//
+// Messages other than well-known types are written a field at a time: the
+// records of each field are parsed on their own into an UntypedMessage and
+// written with WriteField(), except for message fields, which are streamed in
+// turn, an element at a time for repeated ones. This keeps memory bounded by
+// the nesting depth of the input (and its largest non-message field), but
+// requires the records of each field to be adjacent, in field number order.
+using StreamTraits = UnparseProto3Type;
+
+absl::Status StreamMessage(JsonWriter& writer, io::CodedInputStream& stream,
+                           const ResolverPool::Message& desc,
+                           bool is_top_level = false);
+
+// Returns whether the record tagged `tag` for `field` is streamed by
+// StreamMessage() rather than parsed into an UntypedMessage.
+bool IsStreamed(const ResolverPool::Field* field, uint32_t tag) {
+  return field->proto().kind() == google::protobuf::Field::TYPE_MESSAGE &&
+         WireFormatLite::GetTagWireType(tag) ==
+             WireFormatLite::WIRETYPE_LENGTH_DELIMITED &&
+         ClassifyMessage(StreamTraits::FieldTypeName(field)) ==
+             MessageType::kNotWellKnown &&
+         !StreamTraits::IsMap(field);
+}
+
+// Writes the length-delimited submessage for `field` at the front of
+// `stream`.
+absl::Status StreamSubmessage(JsonWriter& writer, io::CodedInputStream& stream,
+                              const ResolverPool::Field* field) {
+  auto type = field->MessageType();
+  RETURN_IF_ERROR(type.status());
+
+  uint32_t size;
+  if (!stream.ReadVarint32(&size)) {
+    return absl::InvalidArgumentError("unexpected EOF");
+  }
+  if (!stream.IncrementRecursionDepth()) {
+    return absl::InvalidArgumentError("message nesting is too deep");
+  }
+  auto limit = stream.PushLimit(static_cast<int>(size));
+  RETURN_IF_ERROR(StreamMessage(writer, stream, **type));
+  if (stream.BytesUntilLimit() > 0) {
+    return absl::InvalidArgumentError("unexpected EOF");
+  }
+  stream.PopLimit(limit);
+  stream.DecrementRecursionDepth();
+  return absl::OkStatus();
+}
+
+// Parses the adjacent records of one field of `desc`, the first of which is
+// tagged `tag`, using `buf` as scratch space. On return, `tag` is the tag that
+// follows them.
+absl::StatusOr<UntypedMessage> ParseFieldRecords(
+    io::CodedInputStream& stream, const ResolverPool::Message& desc,
+    uint32_t& tag, std::string& buf) {
+  buf.clear();
+  {
+    io::StringOutputStream out(&buf);
+    io::CodedOutputStream coded_out(&out);
+    int number = WireFormatLite::GetTagFieldNumber(tag);
+    do {
+      if (!WireFormatLite::SkipField(&stream, tag, &coded_out)) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("malformed record for field number %d", number));
+      }
+      tag = stream.ReadTag();
+    } while (tag != 0 && WireFormatLite::GetTagFieldNumber(tag) == number);
+  }
+
+  io::ArrayInputStream in(buf.data(), static_cast<int>(buf.size()));
+  io::CodedInputStream coded_in(&in);
+  return UntypedMessage::ParseFromStream(&desc, coded_in);
+}
+
+absl::Status StreamMessage(JsonWriter& writer, io::CodedInputStream& stream,
+                           const ResolverPool::Message& desc,
+                           bool is_top_level) {
+  if (ClassifyMessage(StreamTraits::TypeName(desc)) !=
+      MessageType::kNotWellKnown) {
+    // Well-known types are small, and written as a whole.
+    auto msg = UntypedMessage::ParseFromStream(&desc, stream);
+    RETURN_IF_ERROR(msg.status());
+    return WriteMessage<StreamTraits>(writer, *msg, desc, is_top_level);
+  }
+
+  // The fields that are written even when absent, as in WriteFields().
+  std::vector<const ResolverPool::Field*> defaults;
+  if (writer.options().always_print_primitive_fields) {
+    for (const ResolverPool::Field& field : desc.FieldsByIndex()) {
+      bool is_singular_message =
+          !StreamTraits::IsRepeated(&field) &&
+          StreamTraits::FieldType(&field) == FieldDescriptor::TYPE_MESSAGE;
+      if (!is_singular_message && !StreamTraits::IsOneof(&field)) {
+        defaults.push_back(&field);
+      }
+    }
+    absl::c_sort(defaults, [](const auto& a, const auto& b) {
+      return StreamTraits::FieldNumber(a) < StreamTraits::FieldNumber(b);
+    });
+  }
+  io::ArrayInputStream no_input(nullptr, 0);
+  io::CodedInputStream no_records(&no_input);
+  auto empty = UntypedMessage::ParseFromStream(&desc, no_records);
+  RETURN_IF_ERROR(empty.status());
+
+  writer.Write("{");
+  writer.Push();
+  bool first = true;
+
+  // Writes the defaults of the fields numbered below `number`, and skips that
+  // of `number` itself.
+  auto next_default = defaults.begin();
+  auto write_defaults_up_to = [&](int32_t number) -> absl::Status {
+    for (; next_default != defaults.end() &&
+           StreamTraits::FieldNumber(*next_default) <= number;
+         ++next_default) {
+      if (StreamTraits::FieldNumber(*next_default) == number) continue;
+      RETURN_IF_ERROR(
+          WriteField<StreamTraits>(writer, *empty, *next_default, first));
+    }
+    return absl::OkStatus();
+  };
+
+  std::string buf;
+  int32_t last_number = 0;
+  uint32_t tag = stream.ReadTag();
+  while (tag != 0) {
+    int32_t number = WireFormatLite::GetTagFieldNumber(tag);
+    const ResolverPool::Field* field = desc.FindField(number);
+    if (field == nullptr) {
+      // Unknown fields are discarded.
+      if (!WireFormatLite::SkipField(&stream, tag)) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("malformed record for field number %d", number));
+      }
+      tag = stream.ReadTag();
+      continue;
+    }
+    if (number <= last_number) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "field number %d is out of order, or its records are not adjacent",
+          number));
+    }
+    last_number = number;
+    RETURN_IF_ERROR(write_defaults_up_to(number));
+
+    if (!IsStreamed(field, tag)) {
+      auto msg = ParseFieldRecords(stream, desc, tag, buf);
+      RETURN_IF_ERROR(msg.status());
+      if (StreamTraits::GetSize(field, *msg) > 0 ||
+          writer.options().always_print_primitive_fields) {
+        RETURN_IF_ERROR(WriteField<StreamTraits>(writer, *msg, field, first));
+      }
+      continue;
+    }
+
+    writer.WriteComma(first);
+    writer.NewLine();
+    WriteFieldName<StreamTraits>(writer, field);
+    if (!StreamTraits::IsRepeated(field)) {
+      RETURN_IF_ERROR(StreamSubmessage(writer, stream, field));
+      tag = stream.ReadTag();
+      continue;
+    }
+
+    writer.Write("[");
+    writer.Push();
+    uint32_t element_tag = tag;
+    bool first_element = true;
+    do {
+      writer.WriteComma(first_element);
+      writer.NewLine();
+      RETURN_IF_ERROR(StreamSubmessage(writer, stream, field));
+      tag = stream.ReadTag();
+    } while (tag == element_tag);
+    writer.Pop();
+    writer.NewLine();
+    writer.Write("]");
+  }
+  RETURN_IF_ERROR(write_defaults_up_to(std::numeric_limits<int32_t>::max()));
+
+  writer.Pop();
+  if (!first) {
+    writer.NewLine();
+  }
+  writer.Write("}");
+  return absl::OkStatus();
+}
 }  // namespace
 
 absl::Status MessageToJsonString(const Message& message, std::string* output,
@@ -872,6 +1146,21 @@ absl::Status MessageToJsonString(const Message& message, std::string* output,
   return absl::OkStatus();
 }
 
+absl::Status MessagesToJsonLines(absl::Span<const Message* const> messages,
+                                 std::string* output,
+                                 json_internal::WriterOptions options) {
+  options.add_whitespace = false;
+  // One writer, and so one output buffer, serves all of the lines.
+  io::StringOutputStream out(output);
+  JsonWriter writer(&out, options);
+  for (const Message* message : messages) {
+    RETURN_IF_ERROR(WriteMessage<UnparseProto2Descriptor>(
+        writer, *message, *message->GetDescriptor(), /*is_top_level=*/true));
+    writer.Write('\n');
+  }
+  return absl::OkStatus();
+}
+
 absl::Status BinaryToJsonStream(google::protobuf::util::TypeResolver* resolver,
                                 const std::string& type_url,
                                 io::ZeroCopyInputStream* binary_input,
@@ -908,14 +1197,18 @@ absl::Status BinaryToJsonStream(google::protobuf::util::TypeResolver* resolver,
 
   io::CodedInputStream stream(tee_input.has_value() ? &*tee_input
                                                     : binary_input);
-  auto msg = UntypedMessage::ParseFromStream(*desc, stream);
-  RETURN_IF_ERROR(msg.status());
-
   JsonWriter writer(tee_output.has_value() ? &*tee_output : json_output,
                     options);
-  absl::Status s = WriteMessage<UnparseProto3Type>(
-      writer, *msg, UnparseProto3Type::GetDesc(*msg),
-      /*is_top_level=*/true);
+  absl::Status s;
+  if (options.stream_canonical_binary_input) {
+    s = StreamMessage(writer, stream, **desc, /*is_top_level=*/true);
+  } else {
+    auto msg = UntypedMessage::ParseFromStream(*desc, stream);
+    RETURN_IF_ERROR(msg.status());
+    s = WriteMessage<UnparseProto3Type>(writer, *msg,
+                                        UnparseProto3Type::GetDesc(*msg),
+                                        /*is_top_level=*/true);
+  }
   if (PROTOBUF_DEBUG) ABSL_DLOG(INFO) << "json2/status: " << s;
   RETURN_IF_ERROR(s);
 
@@ -35,6 +35,7 @@
 
 #include "google/protobuf/message.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "google/protobuf/json/internal/writer.h"
 #include "google/protobuf/util/type_resolver.h"
 
@@ -45,6 +46,11 @@ namespace json_internal {
 // details.
 absl::Status MessageToJsonString(const Message& message, std::string* output,
                                  json_internal::WriterOptions options);
+// Internal version of google::protobuf::json::MessagesToJsonLines; see json.h for
+// details.
+absl::Status MessagesToJsonLines(absl::Span<const Message* const> messages,
+                                 std::string* output,
+                                 json_internal::WriterOptions options);
 // Internal version of google::protobuf::util::BinaryToJsonStream; see json_util.h for
 // details.
 absl::Status BinaryToJsonStream(google::protobuf::util::TypeResolver* resolver,
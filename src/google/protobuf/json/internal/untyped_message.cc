@@ -93,11 +93,11 @@ absl::StatusOr<const ResolverPool::Enum*> ResolverPool::Field::EnumType()
 
 absl::Span<const ResolverPool::Field> ResolverPool::Message::FieldsByIndex()
     const {
-  if (raw_.fields_size() > 0 && fields_ == nullptr) {
-    fields_ = std::unique_ptr<Field[]>(new Field[raw_.fields_size()]);
-    for (size_t i = 0; i < raw_.fields_size(); ++i) {
+  if (raw_->fields_size() > 0 && fields_ == nullptr) {
+    fields_ = std::unique_ptr<Field[]>(new Field[raw_->fields_size()]);
+    for (size_t i = 0; i < raw_->fields_size(); ++i) {
       fields_[i].pool_ = pool_;
-      fields_[i].raw_ = &raw_.fields(i);
+      fields_[i].raw_ = &raw_->fields(i);
       fields_[i].parent_ = this;
     }
   }
@@ -107,7 +107,7 @@ absl::Span<const ResolverPool::Field> ResolverPool::Message::FieldsByIndex()
 
 const ResolverPool::Field* ResolverPool::Message::FindField(
     absl::string_view name) const {
-  if (raw_.fields_size() == 0) {
+  if (raw_->fields_size() == 0) {
     return nullptr;
   }
 
@@ -129,11 +129,11 @@ const ResolverPool::Field* ResolverPool::Message::FindField(
 
 const ResolverPool::Field* ResolverPool::Message::FindField(
     int32_t number) const {
-  if (raw_.fields_size() == 0) {
+  if (raw_->fields_size() == 0) {
     return nullptr;
   }
 
-  bool is_small = raw_.fields_size() < 8;
+  bool is_small = raw_->fields_size() < 8;
   if (is_small || fields_by_number_.empty()) {
     const Field* found = nullptr;
     for (auto& field : FieldsByIndex()) {
@@ -160,7 +160,9 @@ absl::StatusOr<const ResolverPool::Message*> ResolverPool::FindMessage(
 
   auto msg = absl::WrapUnique(new Message(this));
   std::string url_buf(url);
-  RETURN_IF_ERROR(resolver_->ResolveMessageType(url_buf, &msg->raw_));
+  auto type = resolver_->ResolveSharedMessageType(url_buf);
+  RETURN_IF_ERROR(type.status());
+  msg->raw_ = *std::move(type);
 
   return messages_.try_emplace(std::move(url_buf), std::move(msg))
       .first->second.get();
@@ -175,7 +177,9 @@ absl::StatusOr<const ResolverPool::Enum*> ResolverPool::FindEnum(
 
   auto enoom = absl::WrapUnique(new Enum(this));
   std::string url_buf(url);
-  RETURN_IF_ERROR(resolver_->ResolveEnumType(url_buf, &enoom->raw_));
+  auto type = resolver_->ResolveSharedEnumType(url_buf);
+  RETURN_IF_ERROR(type.status());
+  enoom->raw_ = *std::move(type);
 
   return enums_.try_emplace(std::move(url_buf), std::move(enoom))
       .first->second.get();
@@ -112,7 +112,7 @@ class ResolverPool {
     const Field* FindField(absl::string_view name) const;
     const Field* FindField(int32_t number) const;
 
-    const google::protobuf::Type& proto() const { return raw_; }
+    const google::protobuf::Type& proto() const { return *raw_; }
     ResolverPool* pool() const { return pool_; }
 
    private:
@@ -121,7 +121,9 @@ class ResolverPool {
     explicit Message(ResolverPool* pool) : pool_(pool) {}
 
     ResolverPool* pool_;
-    google::protobuf::Type raw_;
+    // Possibly shared with other pools, through
+    // TypeResolver::ResolveSharedMessageType().
+    std::shared_ptr<const google::protobuf::Type> raw_;
     mutable std::unique_ptr<Field[]> fields_;
     mutable absl::flat_hash_map<absl::string_view, const Field*>
         fields_by_name_;
@@ -133,7 +135,7 @@ class ResolverPool {
     Enum(const Enum&) = delete;
     Enum& operator=(const Enum&) = delete;
 
-    const google::protobuf::Enum& proto() const { return raw_; }
+    const google::protobuf::Enum& proto() const { return *raw_; }
     ResolverPool* pool() const { return pool_; }
 
    private:
@@ -142,7 +144,7 @@ class ResolverPool {
     explicit Enum(ResolverPool* pool) : pool_(pool) {}
 
     ResolverPool* pool_;
-    google::protobuf::Enum raw_;
+    std::shared_ptr<const google::protobuf::Enum> raw_;
     mutable absl::flat_hash_map<absl::string_view, google::protobuf::EnumValue*>
         values_;
   };
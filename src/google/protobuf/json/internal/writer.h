@@ -34,6 +34,7 @@
 #include <cfloat>
 #include <cmath>
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <ostream>
@@ -72,6 +73,14 @@ struct WriterOptions {
   // If set, int64 values that can be represented exactly as a double are
   // printed without quotes.
   bool unquote_int64_if_possible = false;
+  // If set, BinaryToJsonStream() converts its input as it reads it. See
+  // json::PrintOptions.
+  bool stream_canonical_binary_input = false;
+  // If set, the elements of large repeated message fields are printed in
+  // chunks by tasks run through `executor`. See json::PrintOptions.
+  std::function<void(std::function<void()>)> executor;
+  int parallel_min_elements = 1024;
+  int parallel_num_tasks = 8;
   // The original parser used by json_util2 accepted a number of non-standard
   // options. Setting this flag enables them.
   //
@@ -112,6 +121,14 @@ class JsonWriter {
   JsonWriter(io::ZeroCopyOutputStream* out, WriterOptions options)
       : sink_(out), options_(options) {}
 
+  // A writer for output that will be inserted into `parent`'s output at its
+  // current position, with the same options and indentation. It does not hand
+  // out further tasks, since those would wait on each other.
+  JsonWriter(io::ZeroCopyOutputStream* out, const JsonWriter& parent)
+      : sink_(out), options_(parent.options_), indent_(parent.indent_) {
+    options_.executor = nullptr;
+  }
+
   const WriterOptions& options() const { return options_; }
 
   void Push() { ++indent_; }
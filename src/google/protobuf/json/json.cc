@@ -30,10 +30,18 @@
 
 #include "google/protobuf/json/json.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/types/span.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/json/internal/parser.h"
 #include "google/protobuf/json/internal/unparser.h"
@@ -58,6 +66,7 @@ absl::Status BinaryToJsonStream(google::protobuf::util::TypeResolver* resolver,
   opts.always_print_enums_as_ints = options.always_print_enums_as_ints;
   opts.always_print_primitive_fields = options.always_print_primitive_fields;
   opts.unquote_int64_if_possible = options.unquote_int64_if_possible;
+  opts.stream_canonical_binary_input = options.stream_canonical_binary_input;
 
   // TODO(b/234868512): Drop this setting.
   opts.allow_legacy_syntax = true;
@@ -112,6 +121,9 @@ absl::Status MessageToJsonString(const Message& message, std::string* output,
   opts.always_print_enums_as_ints = options.always_print_enums_as_ints;
   opts.always_print_primitive_fields = options.always_print_primitive_fields;
   opts.unquote_int64_if_possible = options.unquote_int64_if_possible;
+  opts.executor = options.executor;
+  opts.parallel_min_elements = options.parallel_min_elements;
+  opts.parallel_num_tasks = options.parallel_num_tasks;
 
   // TODO(b/234868512): Drop this setting.
   opts.allow_legacy_syntax = true;
@@ -130,6 +142,85 @@ absl::Status JsonStringToMessage(absl::string_view input, Message* message,
 
   return google::protobuf::json_internal::JsonStringToMessage(input, message, opts);
 }
+
+absl::Status JsonLinesToMessages(absl::string_view input,
+                                 absl::FunctionRef<Message*()> add_message,
+                                 const ParseOptions& options,
+                                 const JsonLinesOptions& lines_options) {
+  google::protobuf::json_internal::ParseOptions opts;
+  opts.ignore_unknown_fields = options.ignore_unknown_fields;
+  opts.case_insensitive_enum_parsing = options.case_insensitive_enum_parsing;
+
+  // TODO(b/234868512): Drop this setting.
+  opts.allow_legacy_syntax = true;
+
+  struct Line {
+    absl::string_view text;
+    int number;
+    Message* message;
+  };
+  std::vector<Line> lines;
+  int number = 0;
+  while (!input.empty()) {
+    ++number;
+    size_t end = input.find('\n');
+    absl::string_view text = input.substr(0, end);
+    input.remove_prefix(end == absl::string_view::npos ? input.size()
+                                                       : end + 1);
+    if (text.find_first_not_of(" \t\r") == absl::string_view::npos) continue;
+    lines.push_back({text, number, add_message()});
+  }
+
+  const int num_lines = static_cast<int>(lines.size());
+  const int num_tasks =
+      std::max(1, std::min(lines_options.num_tasks, num_lines));
+  std::vector<absl::Status> statuses(num_tasks);
+  absl::BlockingCounter pending(num_tasks);
+  for (int task = 0; task < num_tasks; ++task) {
+    const int begin = static_cast<int>(int64_t{num_lines} * task / num_tasks);
+    const int end =
+        static_cast<int>(int64_t{num_lines} * (task + 1) / num_tasks);
+    auto parse = [&, task, begin, end] {
+      for (int i = begin; i < end; ++i) {
+        absl::Status s = google::protobuf::json_internal::JsonStringToMessage(
+            lines[i].text, lines[i].message, opts);
+        if (!s.ok()) {
+          statuses[task] = absl::Status(
+              s.code(), absl::StrCat("line ", lines[i].number, ": ",
+                                     s.message()));
+          break;
+        }
+      }
+      pending.DecrementCount();
+    };
+    if (lines_options.executor) {
+      lines_options.executor(std::move(parse));
+    } else {
+      parse();
+    }
+  }
+  pending.Wait();
+
+  for (absl::Status& s : statuses) {
+    RETURN_IF_ERROR(s);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status MessagesToJsonLines(absl::Span<const Message* const> messages,
+                                 std::string* output,
+                                 const PrintOptions& options) {
+  google::protobuf::json_internal::WriterOptions opts;
+  opts.preserve_proto_field_names = options.preserve_proto_field_names;
+  opts.always_print_enums_as_ints = options.always_print_enums_as_ints;
+  opts.always_print_primitive_fields = options.always_print_primitive_fields;
+  opts.unquote_int64_if_possible = options.unquote_int64_if_possible;
+
+  // TODO(b/234868512): Drop this setting.
+  opts.allow_legacy_syntax = true;
+
+  return google::protobuf::json_internal::MessagesToJsonLines(messages, output, opts);
+}
 }  // namespace json
 }  // namespace protobuf
 }  // namespace google
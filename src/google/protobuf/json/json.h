@@ -33,10 +33,13 @@
 #ifndef GOOGLE_PROTOBUF_JSON_JSON_H__
 #define GOOGLE_PROTOBUF_JSON_JSON_H__
 
+#include <functional>
 #include <string>
 
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/util/type_resolver.h"
 
@@ -75,6 +78,33 @@ struct PrintOptions {
   // If set, int64 values that can be represented exactly as a double are
   // printed without quotes.
   bool unquote_int64_if_possible = false;
+  // If set, BinaryToJsonStream() writes JSON as it reads the binary input,
+  // instead of parsing all of it first, so that its memory use is bounded by
+  // the nesting depth of the input rather than its size. The input must then
+  // be serialized in field number order, with the elements of each repeated
+  // field adjacent, as protobuf serializers do; other inputs are rejected.
+  // Ignored by MessageToJsonString().
+  bool stream_canonical_binary_input = false;
+  // If set, MessageToJsonString() prints the elements of repeated message
+  // fields with at least |parallel_min_elements| elements in chunks, by
+  // |parallel_num_tasks| tasks run through |executor| (see
+  // JsonLinesOptions::executor), and then joins the chunks. The output is the
+  // same as without it. Ignored by BinaryToJsonStream().
+  std::function<void(std::function<void()>)> executor;
+  int parallel_min_elements = 1024;
+  int parallel_num_tasks = 8;
+};
+
+struct JsonLinesOptions {
+  // Runs `task`, either immediately or later on some other thread. The tasks
+  // handed out by a single call are independent of each other and may run in
+  // any order or concurrently; the call blocks until all of them have
+  // finished. If unset, every task runs inline on the calling thread.
+  std::function<void(std::function<void()>)> executor;
+
+  // The number of tasks the lines are split into. Each task parses a
+  // contiguous run of lines.
+  int num_tasks = 8;
 };
 
 // Converts from protobuf message to JSON and appends it to |output|. This is a
@@ -107,6 +137,32 @@ inline absl::Status JsonStringToMessage(absl::string_view input,
   return JsonStringToMessage(input, message, ParseOptions());
 }
 
+// Parses newline-delimited JSON (also known as JSON Lines or NDJSON): each
+// line of |input| that is not blank holds one JSON object, which is parsed
+// into a message obtained from |add_message|. |add_message| is called once
+// per such line, in order and on the calling thread, before any line is
+// parsed, and the messages it returns must stay valid until this returns:
+//
+//   RepeatedPtrField<LogEntry> entries;
+//   absl::Status status = JsonLinesToMessages(
+//       ndjson, [&] { return entries.Add(); }, ParseOptions());
+//
+// This is equivalent to calling JsonStringToMessage() on every line, except
+// that the lines may be parsed concurrently through |lines_options|. If some
+// lines fail to parse, the error for the first of them is returned, prefixed
+// with its line number; the other messages are then unspecified.
+PROTOBUF_EXPORT absl::Status JsonLinesToMessages(
+    absl::string_view input, absl::FunctionRef<Message*()> add_message,
+    const ParseOptions& options,
+    const JsonLinesOptions& lines_options = JsonLinesOptions());
+
+// Converts |messages| to newline-delimited JSON and appends it to |output|:
+// one line per message, each ending in a newline. Newlines inside a message
+// would break the format, so |options.add_whitespace| is ignored.
+PROTOBUF_EXPORT absl::Status MessagesToJsonLines(
+    absl::Span<const Message* const> messages, std::string* output,
+    const PrintOptions& options);
+
 // Converts protobuf binary data to JSON.
 // The conversion will fail if:
 //   1. TypeResolver fails to resolve a type.
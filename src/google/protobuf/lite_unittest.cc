@@ -38,10 +38,13 @@
 
 #include <gtest/gtest.h>
 #include "absl/log/absl_check.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/cord_buffer.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/arena_test_util.h"
+#include "google/protobuf/implicit_weak_message.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
@@ -1346,6 +1349,68 @@ TEST(LiteBasicTest, CodedInputStreamRollback) {
   }
 }
 
+TEST(LiteBasicTest, ParseFromFragmentedCord) {
+  protobuf_unittest::TestAllTypesLite message;
+  TestUtilLite::SetAllFields(&message);
+  message.set_optional_bytes(std::string(1000, 'x'));
+  std::string serialized = message.SerializeAsString();
+
+  // Give every few bytes a chunk of its own.
+  absl::Cord cord;
+  for (size_t i = 0; i < serialized.size(); i += 3) {
+    absl::string_view piece = absl::string_view(serialized).substr(i, 3);
+    auto buffer = absl::CordBuffer::CreateWithDefaultLimit(piece.size());
+    absl::Span<char> out = buffer.available_up_to(piece.size());
+    memcpy(out.data(), piece.data(), out.size());
+    buffer.SetLength(out.size());
+    cord.Append(std::move(buffer));
+  }
+  ASSERT_EQ(cord, serialized);
+
+  protobuf_unittest::TestAllTypesLite parsed;
+  ASSERT_TRUE(parsed.ParseFromCord(cord));
+  EXPECT_EQ(parsed.SerializeAsString(), serialized);
+}
+
+TEST(LiteBasicTest, AppendToCordLargeMessages) {
+  // Sizes that fit the cord's spare capacity, a single custom-limit flat and
+  // only an external buffer.
+  for (size_t bytes : {100, 20000, 1 << 20}) {
+    protobuf_unittest::TestAllTypesLite message;
+    TestUtilLite::SetAllFields(&message);
+    message.set_optional_bytes(std::string(bytes, 'x'));
+    const std::string serialized = message.SerializeAsString();
+
+    absl::Cord cord("prefix");
+    ASSERT_TRUE(message.AppendToCord(&cord));
+    EXPECT_EQ(cord, absl::StrCat("prefix", serialized)) << bytes;
+    EXPECT_EQ(message.SerializeAsCord(), serialized) << bytes;
+
+    protobuf_unittest::TestAllTypesLite parsed;
+    ASSERT_TRUE(parsed.ParseFromCord(message.SerializeAsCord()));
+    EXPECT_EQ(parsed.SerializeAsString(), serialized) << bytes;
+  }
+}
+
+TEST(LiteBasicTest, ImplicitWeakMessageOnArena) {
+  protobuf_unittest::TestAllTypesLite message;
+  TestUtilLite::SetAllFields(&message);
+  std::string serialized = message.SerializeAsString();
+
+  Arena arena;
+  auto* weak = Arena::CreateMessage<internal::ImplicitWeakMessage>(&arena);
+  EXPECT_EQ(weak->GetOwningArena(), &arena);
+  ASSERT_TRUE(weak->ParseFromString(serialized));
+  EXPECT_EQ(weak->SerializeAsString(), serialized);
+
+  protobuf_unittest::TestAllTypesLite parsed;
+  ASSERT_TRUE(parsed.ParseFromString(weak->SerializeAsString()));
+  TestUtilLite::ExpectAllFieldsSet(parsed);
+
+  weak->Clear();
+  EXPECT_EQ(weak->ByteSizeLong(), 0);
+}
+
 }  // namespace
 }  // namespace protobuf
 }  // namespace google
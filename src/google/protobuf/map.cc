@@ -30,12 +30,79 @@
 
 #include "google/protobuf/map.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+#include "absl/log/absl_check.h"
+#include "google/protobuf/map_entry_lite.h"
+
 namespace google {
 namespace protobuf {
 namespace internal {
 
 const TableEntryPtr kGlobalEmptyTable[kGlobalEmptyTableSize] = {};
 
+namespace {
+
+// Threads that once sorted a huge map should not hold on to that much memory.
+constexpr size_t kMaxRetainedScratchBytes = 1 << 20;
+constexpr size_t kScratchAlignment = alignof(std::max_align_t);
+
+struct MapSorterScratchBlock {
+  std::unique_ptr<char[]> data;
+  size_t capacity = 0;
+  // Bytes of `data` handed out, always a prefix since use is LIFO.
+  size_t used = 0;
+  // Bytes handed out including those that did not fit in `data`, and the
+  // most ever outstanding, which `data` grows to the next time it is unused.
+  size_t outstanding = 0;
+  size_t peak = 0;
+};
+
+MapSorterScratchBlock& ThreadMapSorterScratch() {
+  static thread_local MapSorterScratchBlock block;
+  return block;
+}
+
+size_t AlignScratchSize(size_t bytes) {
+  return (bytes + kScratchAlignment - 1) & ~(kScratchAlignment - 1);
+}
+
+}  // namespace
+
+void* MapSorterScratch::Allocate(size_t bytes) {
+  MapSorterScratchBlock& block = ThreadMapSorterScratch();
+  bytes = AlignScratchSize(bytes);
+  block.outstanding += bytes;
+  block.peak = std::max(block.peak, block.outstanding);
+  const size_t wanted = std::min(block.peak, kMaxRetainedScratchBytes);
+  if (block.used == 0 && block.capacity < wanted) {
+    block.data.reset(new char[wanted]);
+    block.capacity = wanted;
+  }
+  if (block.capacity - block.used >= bytes) {
+    void* p = block.data.get() + block.used;
+    block.used += bytes;
+    return p;
+  }
+  return ::operator new(bytes);
+}
+
+void MapSorterScratch::Deallocate(void* p, size_t bytes) {
+  MapSorterScratchBlock& block = ThreadMapSorterScratch();
+  bytes = AlignScratchSize(bytes);
+  block.outstanding -= bytes;
+  char* c = static_cast<char*>(p);
+  if (c >= block.data.get() && c < block.data.get() + block.capacity) {
+    ABSL_DCHECK_EQ(c + bytes, block.data.get() + block.used);
+    block.used -= bytes;
+  } else {
+    ::operator delete(p);
+  }
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
@@ -38,6 +38,8 @@
 #define GOOGLE_PROTOBUF_MAP_H__
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <initializer_list>
 #include <iterator>
@@ -51,9 +53,13 @@
 #endif
 
 #include "google/protobuf/stubs/common.h"
+#include "absl/base/config.h"
 #include "absl/container/btree_map.h"
 #include "absl/hash/hash.h"
 #include "absl/meta/type_traits.h"
+#include "absl/numeric/bits.h"
+#include "absl/numeric/int128.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/arena.h"
 #include "google/protobuf/generated_enum_util.h"
@@ -138,6 +144,8 @@ class MapAllocator {
     if (arena_ == nullptr) {
       return static_cast<pointer>(::operator new(n * sizeof(value_type)));
     } else {
+      arena_->RecordTypeAllocation([] { return absl::string_view("Map"); },
+                                   n * sizeof(value_type));
       return reinterpret_cast<pointer>(
           Arena::CreateArray<uint8_t>(arena_, n * sizeof(value_type)));
     }
@@ -146,6 +154,11 @@ class MapAllocator {
   void deallocate(pointer p, size_type n) {
     if (arena_ == nullptr) {
       internal::SizedDelete(p, n * sizeof(value_type));
+    } else if (n * sizeof(value_type) >= 16) {
+      // Hand the memory back to the arena's free lists so that it can be
+      // reused by later allocations of the same size class, e.g. the next
+      // node or a larger table after a rehash.
+      arena_->ReturnArrayMemory(p, n * sizeof(value_type));
     }
   }
 
@@ -232,9 +245,13 @@ struct TransparentSupport {
 // We add transparent support for std::string keys. We use
 // std::hash<absl::string_view> as it supports the input types we care about.
 // The lookup functions accept arbitrary `K`. This will include any key type
-// that is convertible to absl::string_view.
+// that is convertible to absl::string_view, as well as absl::Cord, which is
+// hashed and compared chunk by chunk instead of being flattened.
 template <>
 struct TransparentSupport<std::string> {
+  template <typename T>
+  using IsCord = std::is_same<absl::remove_cvref_t<T>, absl::Cord>;
+
   // If the element is not convertible to absl::string_view, try to convert to
   // std::string first, and then fallback to support for converting from
   // std::string_view. The ranked overload pattern is used to specify our
@@ -267,27 +284,47 @@ struct TransparentSupport<std::string> {
   struct hash : public absl::Hash<absl::string_view> {
     using is_transparent = void;
 
-    template <typename T>
+    template <typename T, typename = std::enable_if_t<!IsCord<T>::value>>
     size_t operator()(T&& str) const {
       return absl::Hash<absl::string_view>::operator()(
           ImplicitConvert(std::forward<T>(str)));
     }
+    // absl::Hash guarantees that a Cord hashes like the equivalent
+    // string_view.
+    size_t operator()(const absl::Cord& cord) const {
+      return absl::Hash<absl::Cord>()(cord);
+    }
   };
   struct less {
     using is_transparent = void;
 
-    template <typename T, typename U>
+    template <typename T, typename U,
+              typename = std::enable_if_t<!IsCord<T>::value &&
+                                          !IsCord<U>::value>>
     bool operator()(T&& t, U&& u) const {
       return ImplicitConvert(std::forward<T>(t)) <
              ImplicitConvert(std::forward<U>(u));
     }
+    template <typename U>
+    bool operator()(const absl::Cord& t, U&& u) const {
+      return t.Compare(ImplicitConvert(std::forward<U>(u))) < 0;
+    }
+    template <typename T>
+    bool operator()(T&& t, const absl::Cord& u) const {
+      return u.Compare(ImplicitConvert(std::forward<T>(t))) > 0;
+    }
   };
 
-  template <typename T, typename U>
+  template <typename T, typename U,
+            typename = std::enable_if_t<!IsCord<U>::value>>
   static bool Equals(T&& t, U&& u) {
     return ImplicitConvert(std::forward<T>(t)) ==
            ImplicitConvert(std::forward<U>(u));
   }
+  template <typename T>
+  static bool Equals(T&& t, const absl::Cord& u) {
+    return u == ImplicitConvert(std::forward<T>(t));
+  }
 
   template <typename K>
   using key_arg = K;
@@ -705,7 +742,11 @@ class MapIteratorPayload {
 //    `reference_wrapper<const Key>` otherwise. This avoids unnecessary copies
 //    of string keys, for example.
 
-template <typename Key>
+//
+// Integral keys are instead handled by the open addressing specialization
+// below, see KeyMapBase<Key, true>.
+
+template <typename Key, bool = std::is_integral<Key>::value>
 class KeyMapBase : public UntypedMapBase {
   static_assert(!std::is_signed<Key>::value || !std::is_integral<Key>::value,
                 "");
@@ -797,6 +838,9 @@ class KeyMapBase : public UntypedMapBase {
   friend class TcParser;
   friend struct MapTestPeer;
 
+  // Maximum load factor, times 16. Controls the RAM vs CPU tradeoff.
+  static constexpr size_type kMaxMapLoadTimes16 = 12;
+
   PROTOBUF_NOINLINE void erase_no_destroy(size_type b, KeyNode* node) {
     TreeIterator tree_it;
     const bool is_list = revalidate_if_necessary(b, node, &tree_it);
@@ -832,7 +876,27 @@ class KeyMapBase : public UntypedMapBase {
   // this with all the different `char[N]` of the caller.
   template <typename K>
   NodeAndBucket FindHelper(const K& k, TreeIterator* it = nullptr) const {
-    size_type b = BucketNumber(k);
+    return FindInBucket(k, BucketNumber(k), it);
+  }
+
+  // Batched lookup support. FindBatch() computes LookupHash() for a group of
+  // keys and calls PrefetchLookup() on each before any of them is compared by
+  // FindHashed(), so the table misses of the whole group overlap.
+  template <typename K>
+  uint64_t LookupHash(const K& k) const {
+    return BucketNumber(k);
+  }
+  void PrefetchLookup(uint64_t h) const {
+    PROTOBUF_PREFETCH(&table_[h]);
+  }
+  template <typename K>
+  NodeAndBucket FindHashed(const K& k, uint64_t h) const {
+    return FindInBucket(k, static_cast<size_type>(h));
+  }
+
+  template <typename K>
+  NodeAndBucket FindInBucket(const K& k, size_type b,
+                             TreeIterator* it = nullptr) const {
     if (TableEntryIsNonEmptyList(b)) {
       auto* node = internal::TableEntryToNode(table_[b]);
       do {
@@ -864,7 +928,7 @@ class KeyMapBase : public UntypedMapBase {
     if (p.node != nullptr) {
       erase_no_destroy(p.bucket, static_cast<KeyNode*>(p.node));
       to_erase = static_cast<KeyNode*>(p.node);
-    } else if (ResizeIfLoadIsOutOfRange(num_elements_ + 1)) {
+    } else if (Reserve(num_elements_ + 1)) {
       p = FindHelper(node->key());
     }
     const size_type b = p.bucket;  // bucket number
@@ -925,7 +989,6 @@ class KeyMapBase : public UntypedMapBase {
   // policy that sometimes we resize down as well as up, clients can easily
   // keep O(size()) = O(number of buckets) if they want that.
   bool ResizeIfLoadIsOutOfRange(size_type new_size) {
-    const size_type kMaxMapLoadTimes16 = 12;  // controls RAM vs CPU tradeoff
     const size_type hi_cutoff = num_buckets_ * kMaxMapLoadTimes16 / 16;
     const size_type lo_cutoff = hi_cutoff / 4;
     // We don't care how many elements are in trees.  If a lot are,
@@ -956,12 +1019,30 @@ class KeyMapBase : public UntypedMapBase {
     return false;
   }
 
+  // Grows the table, if needed, so that it holds `n` elements without
+  // resizing again. Unlike ResizeIfLoadIsOutOfRange it never shrinks, so
+  // bulk inserts (e.g. parsing) can size the table up front.
+  // Returns whether it did resize.
+  bool Reserve(size_type n) {
+    if (n <= num_elements_) return false;
+    size_type new_num_buckets =
+        (std::max)(num_buckets_, static_cast<size_type>(kMinTableSize));
+    while (n >= new_num_buckets * kMaxMapLoadTimes16 / 16 &&
+           new_num_buckets <= max_size() / 2) {
+      new_num_buckets *= 2;
+    }
+    if (new_num_buckets == num_buckets_) return false;
+    Resize(new_num_buckets);
+    return true;
+  }
+
   // Resize to the given number of buckets.
   void Resize(size_t new_num_buckets) {
     if (num_buckets_ == kGlobalEmptyTableSize) {
       // This is the global empty array.
       // Just overwrite with a new one. No need to transfer or free anything.
-      num_buckets_ = index_of_first_non_null_ = kMinTableSize;
+      num_buckets_ = index_of_first_non_null_ =
+          (std::max)(new_num_buckets, static_cast<size_t>(kMinTableSize));
       table_ = CreateEmptyTable(num_buckets_);
       seed_ = Seed();
       return;
@@ -1080,6 +1161,477 @@ class KeyMapBase : public UntypedMapBase {
     bucket_index = res.bucket;
     return TableEntryIsList(bucket_index);
   }
+
+  // Removes every node from the table, passing each one to `destroy`. The
+  // table itself is kept.
+  template <typename DestroyFn>
+  void ClearTable(DestroyFn destroy) {
+    for (size_type b = 0; b < num_buckets_; b++) {
+      NodeBase* node;
+      if (TableEntryIsNonEmptyList(b)) {
+        node = TableEntryToNode(table_[b]);
+        table_[b] = TableEntryPtr{};
+      } else if (TableEntryIsTree(b)) {
+        Tree* tree = TableEntryToTree<Tree>(table_[b]);
+        table_[b] = TableEntryPtr{};
+        node = tree->begin()->second;
+        DestroyTree(tree);
+      } else {
+        continue;
+      }
+      do {
+        auto* next = node->next;
+        destroy(static_cast<KeyNode*>(node));
+        node = next;
+      } while (node != nullptr);
+    }
+    num_elements_ = 0;
+    index_of_first_non_null_ = num_buckets_;
+  }
+
+  // Like ClearTable() for nodes that need no destruction, as on an arena:
+  // the buckets are reset without visiting the nodes or trees in them.
+  void ForgetNodes() {
+    if (num_elements_ != 0) {
+      std::fill(table_ + index_of_first_non_null_, table_ + num_buckets_,
+                TableEntryPtr{});
+    }
+    num_elements_ = 0;
+    index_of_first_non_null_ = num_buckets_;
+  }
+
+  size_t TableSpaceUsed(size_t sizeof_node) const {
+    return internal::SpaceUsedInTable<Key>(table_, num_buckets_, num_elements_,
+                                           sizeof_node);
+  }
+};
+
+// A group of control bytes of the open addressing table, probed together with
+// word-wide bit tricks. Masks have the high bit of each selected byte set.
+class FlatMapGroup {
+ public:
+  static constexpr size_t kWidth = 8;
+
+  explicit FlatMapGroup(const uint8_t* pos) { memcpy(&ctrl_, pos, kWidth); }
+
+  // Slots whose control byte is `h2`. May include false positives right
+  // after a true match, so callers must still compare the keys.
+  uint64_t Match(uint8_t h2) const {
+    const uint64_t x = ctrl_ ^ (kLsbs * h2);
+    return (x - kLsbs) & ~x & kMsbs;
+  }
+  uint64_t MaskEmpty() const { return ctrl_ & ~(ctrl_ << 6) & kMsbs; }
+  uint64_t MaskEmptyOrDeleted() const { return ctrl_ & kMsbs; }
+
+  // Index in the group of the first selected byte, and `mask` without it.
+  static size_t LowestIndex(uint64_t mask) {
+#ifdef ABSL_IS_BIG_ENDIAN
+    return static_cast<size_t>(absl::countl_zero(mask)) >> 3;
+#else
+    return static_cast<size_t>(absl::countr_zero(mask)) >> 3;
+#endif
+  }
+  static uint64_t ClearLowest(uint64_t mask) {
+#ifdef ABSL_IS_BIG_ENDIAN
+    return mask & ~(uint64_t{1} << (63 - absl::countl_zero(mask)));
+#else
+    return mask & (mask - 1);
+#endif
+  }
+
+ private:
+  static constexpr uint64_t kLsbs = 0x0101010101010101;
+  static constexpr uint64_t kMsbs = 0x8080808080808080;
+  uint64_t ctrl_;
+};
+
+// KeyMapBase for integral keys is an open addressing table in the style of
+// absl's SwissTable. Nodes are still allocated individually, so pointers to
+// elements are stable and the node based interfaces of UntypedMapBase (eg
+// AllocNode and InsertOrReplaceNode, used by the table-driven parser) are
+// unchanged, but lookups probe a flat array instead of following chains:
+// 1. Every slot has a control byte: empty, deleted, or the low 7 bits of
+//    the hash of the key in the slot. Groups of control bytes are matched
+//    against the hash at once, so a lookup compares keys (and touches
+//    nodes) almost only for the element it is looking for.
+// 2. The table is a single allocation pointed to by table_: the number of
+//    slots that can still be filled before a rehash, num_buckets_ control
+//    bytes followed by a copy of the first group so that loading a group
+//    never wraps around, and num_buckets_ node pointers.
+// 3. Erasing leaves a tombstone. Tombstones are reused by insertions and
+//    dropped when the table is rehashed. They keep erase(iterator) from
+//    moving any other element, so erasing while iterating is safe.
+// 4. bucket_index_ in iterators is the slot index. Like in the chaining
+//    table it is revalidated when the map was rehashed in the meantime.
+// 5. The probe sequence is derived from a strong mix of the key xor'ed with
+//    the per-map seed, so inputs that collide in one map do not collide in
+//    others.
+template <typename Key>
+class KeyMapBase<Key, true> : public UntypedMapBase {
+  static_assert(!std::is_signed<Key>::value, "");
+
+ public:
+  using hasher = typename TransparentSupport<Key>::hash;
+
+  using UntypedMapBase::UntypedMapBase;
+
+ protected:
+  using KeyNode = internal::KeyNode<Key>;
+  using Group = FlatMapGroup;
+
+  static constexpr uint8_t kEmpty = 0x80;
+  static constexpr uint8_t kDeleted = 0xFE;
+  static constexpr size_type kGroupWidth = Group::kWidth;
+
+  class KeyIteratorBase : protected MapIteratorPayload {
+   public:
+    // node_ is always correct, bucket_index_ is the slot of node_ unless the
+    // map was rehashed since.
+    KeyIteratorBase() = default;
+
+    explicit KeyIteratorBase(const KeyMapBase* m) {
+      m_ = m;
+      SearchFrom(m->index_of_first_non_null_);
+    }
+
+    KeyIteratorBase(KeyNode* n, const KeyMapBase* m, size_type index)
+        : MapIteratorPayload(n, m, index) {}
+
+    // Advance through slots, looking for the first that is full.
+    // If nothing is found then leave node_ == nullptr.
+    void SearchFrom(size_type start) {
+      const KeyMapBase& m = map();
+      const size_type i = m.FindFullFrom(start);
+      if (i < m.num_buckets_) {
+        node_ = m.slots()[i];
+        bucket_index_ = i;
+      } else {
+        node_ = nullptr;
+        bucket_index_ = 0;
+      }
+    }
+
+    bool Equals(const KeyIteratorBase& other) const {
+      return node_ == other.node_;
+    }
+
+    void PlusPlus() {
+      const KeyMapBase& m = map();
+      if (PROTOBUF_PREDICT_FALSE(bucket_index_ >= m.num_buckets_ ||
+                                 m.slots()[bucket_index_] != node_)) {
+        bucket_index_ =
+            m.FindHelper(static_cast<KeyNode*>(node_)->key()).bucket;
+      }
+      SearchFrom(bucket_index_ + 1);
+    }
+
+    auto& map() const { return static_cast<const KeyMapBase&>(*m_); }
+  };
+
+ public:
+  hasher hash_function() const { return {}; }
+
+ protected:
+  friend class TcParser;
+  friend struct MapTestPeer;
+
+  PROTOBUF_NOINLINE void erase_no_destroy(size_type b, KeyNode* node) {
+    if (b >= num_buckets_ || slots()[b] != node) {
+      b = FindHelper(node->key()).bucket;
+    }
+    ABSL_DCHECK_EQ(slots()[b], static_cast<NodeBase*>(node));
+    SetCtrl(b, kDeleted);
+    slots()[b] = nullptr;
+    if (--num_elements_ == 0) {
+      // Nothing to probe past anymore, so drop all the tombstones.
+      ResetTable();
+    } else if (b == index_of_first_non_null_) {
+      index_of_first_non_null_ = FindFullFrom(b + 1);
+    }
+  }
+
+  // Looks up `k`. If it is not found, the bucket returned is the slot where
+  // it would be inserted.
+  template <typename K>
+  NodeAndBucket FindHelper(const K& k) const {
+    return FindHashed(k, LookupHash(k));
+  }
+
+  // See the chained KeyMapBase for how FindBatch() uses these.
+  template <typename K>
+  uint64_t LookupHash(const K& k) const {
+    return Hash(static_cast<Key>(k));
+  }
+  void PrefetchLookup(uint64_t h) const {
+    const size_type offset = H1(h) & (num_buckets_ - 1);
+    PROTOBUF_PREFETCH(ctrl() + offset);
+    PROTOBUF_PREFETCH(slots() + offset);
+  }
+  template <typename K>
+  NodeAndBucket FindHashed(const K& k, uint64_t h) const {
+    if (PROTOBUF_PREDICT_FALSE(num_buckets_ == kGlobalEmptyTableSize)) {
+      return {nullptr, 0};
+    }
+    const Key key = static_cast<Key>(k);
+    const uint8_t h2 = H2(h);
+    const size_type mask = num_buckets_ - 1;
+    size_type offset = H1(h) & mask;
+    size_type available = num_buckets_;
+    for (size_type step = kGroupWidth;; step += kGroupWidth) {
+      const Group g(ctrl() + offset);
+      for (uint64_t m = g.Match(h2); m != 0; m = Group::ClearLowest(m)) {
+        const size_type b = (offset + Group::LowestIndex(m)) & mask;
+        NodeBase* node = slots()[b];
+        if (static_cast<KeyNode*>(node)->key() == key) return {node, b};
+      }
+      if (available == num_buckets_) {
+        const uint64_t m = g.MaskEmptyOrDeleted();
+        if (m != 0) available = (offset + Group::LowestIndex(m)) & mask;
+      }
+      if (g.MaskEmpty() != 0) return {nullptr, available};
+      offset = (offset + step) & mask;
+    }
+  }
+
+  // Insert the given node.
+  // If the key is a duplicate, it inserts the new node and returns the old one.
+  // Gives ownership to the caller.
+  // If the key is unique, it returns `nullptr`.
+  KeyNode* InsertOrReplaceNode(KeyNode* node) {
+    auto p = FindHelper(node->key());
+    if (p.node != nullptr) {
+      slots()[p.bucket] = node;
+      return static_cast<KeyNode*>(p.node);
+    }
+    if (Reserve(num_elements_ + 1)) {
+      p = FindHelper(node->key());
+    }
+    InsertUnique(p.bucket, node);
+    ++num_elements_;
+    return nullptr;
+  }
+
+  // Insert the given Node in slot b, which must be the one FindHelper
+  // returned for its key. num_elements_ is not modified.
+  void InsertUnique(size_type b, KeyNode* node) {
+    ABSL_DCHECK(FindHelper(node->key()).node == nullptr);
+    InsertAt(b, H2(Hash(node->key())), node);
+  }
+
+  void InsertAt(size_type b, uint8_t h2, NodeBase* node) {
+    ABSL_DCHECK_NE(ctrl()[b] & kEmpty, 0);
+    if (ctrl()[b] == kEmpty) --growth_left();
+    SetCtrl(b, h2);
+    slots()[b] = node;
+    index_of_first_non_null_ = (std::min)(index_of_first_non_null_, b);
+  }
+
+  // Returns whether it did resize. Like for the chaining table this is only
+  // used when num_elements_ increases, and it can also shrink the table.
+  // When no empty slot is left it rehashes, into a table of the same size if
+  // most of the used slots are tombstones.
+  bool ResizeIfLoadIsOutOfRange(size_type new_size) {
+    if (PROTOBUF_PREDICT_FALSE(num_buckets_ == kGlobalEmptyTableSize)) {
+      Resize(kMinTableSize);
+      return true;
+    }
+    const size_type hi_cutoff = MaxLoad(num_buckets_);
+    const size_type lo_cutoff = hi_cutoff / 4;
+    if (PROTOBUF_PREDICT_FALSE(growth_left() == 0)) {
+      if (new_size > hi_cutoff / 2 && num_buckets_ <= max_size() / 2) {
+        Resize(num_buckets_ * 2);
+      } else {
+        Resize(num_buckets_);
+      }
+      return true;
+    } else if (PROTOBUF_PREDICT_FALSE(new_size <= lo_cutoff &&
+                                      num_buckets_ > kMinTableSize)) {
+      // Unlike chains, slots cannot be overfilled, so shrink only as far as
+      // still leaves room for a few more inserts.
+      const size_type hypothetical_size = new_size * 5 / 4 + 1;
+      size_type new_num_buckets = num_buckets_;
+      while (new_num_buckets > kMinTableSize &&
+             MaxLoad(new_num_buckets / 2) >= hypothetical_size) {
+        new_num_buckets /= 2;
+      }
+      if (new_num_buckets != num_buckets_) {
+        Resize(new_num_buckets);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Grows the table, if needed, so that `n` elements can be inserted without
+  // resizing again. Never shrinks; returns whether it did resize.
+  bool Reserve(size_type n) {
+    if (n <= num_elements_) return false;
+    size_type new_num_buckets =
+        num_buckets_ == kGlobalEmptyTableSize ? kMinTableSize : num_buckets_;
+    while (MaxLoad(new_num_buckets) < n && new_num_buckets <= max_size() / 2) {
+      new_num_buckets *= 2;
+    }
+    if (new_num_buckets == num_buckets_) {
+      if (growth_left() >= n - num_elements_) return false;
+      // Enough slots, but tombstones hold some of them. Rehash them away, into
+      // a bigger table if this one would still be more than half full.
+      if (n > MaxLoad(num_buckets_) / 2 && num_buckets_ <= max_size() / 2) {
+        new_num_buckets *= 2;
+      }
+    }
+    Resize(new_num_buckets);
+    return true;
+  }
+
+  // Resize to the given number of slots.
+  void Resize(size_t new_num_buckets) {
+    if (num_buckets_ == kGlobalEmptyTableSize) {
+      // This is the global empty array.
+      // Just overwrite with a new one. No need to transfer or free anything.
+      num_buckets_ = index_of_first_non_null_ =
+          (std::max)(new_num_buckets, static_cast<size_t>(kMinTableSize));
+      table_ = CreateEmptyTable(num_buckets_);
+      seed_ = Seed();
+      return;
+    }
+
+    ABSL_DCHECK_GE(new_num_buckets, kMinTableSize);
+    ABSL_DCHECK_LT(num_elements_, MaxLoad(new_num_buckets));
+    const auto old_table = table_;
+    const size_type old_table_size = num_buckets_;
+    const uint8_t* old_ctrl = ctrl();
+    NodeBase* const* old_slots = slots();
+    num_buckets_ = new_num_buckets;
+    table_ = CreateEmptyTable(num_buckets_);
+    const size_type start = index_of_first_non_null_;
+    index_of_first_non_null_ = num_buckets_;
+    for (size_type i = start; i < old_table_size; ++i) {
+      if (old_ctrl[i] & kEmpty) continue;
+      NodeBase* node = old_slots[i];
+      const uint64_t h = Hash(static_cast<KeyNode*>(node)->key());
+      InsertAt(FindFirstNonFull(h), H2(h), node);
+    }
+    DeleteTable(old_table, old_table_size);
+  }
+
+  template <typename K>
+  size_type BucketNumber(const K& k) const {
+    return H1(Hash(static_cast<Key>(k))) & (num_buckets_ - 1);
+  }
+
+  // Removes every node from the table, passing each one to `destroy`. The
+  // table itself is kept.
+  template <typename DestroyFn>
+  void ClearTable(DestroyFn destroy) {
+    if (num_buckets_ == kGlobalEmptyTableSize) return;
+    if (num_elements_ != 0) {
+      for (size_type i = index_of_first_non_null_; i < num_buckets_; ++i) {
+        if (!(ctrl()[i] & kEmpty)) destroy(static_cast<KeyNode*>(slots()[i]));
+      }
+    }
+    num_elements_ = 0;
+    ResetTable();
+  }
+
+  // Like ClearTable() for nodes that need no destruction, as on an arena.
+  void ForgetNodes() {
+    if (num_buckets_ == kGlobalEmptyTableSize) return;
+    num_elements_ = 0;
+    ResetTable();
+  }
+
+  size_t TableSpaceUsed(size_t sizeof_node) const {
+    return sizeof(TableEntryPtr) * TableUnits(num_buckets_) +
+           sizeof_node * num_elements_;
+  }
+
+  TableEntryPtr* CreateEmptyTable(size_type n) {
+    ABSL_DCHECK_GE(n, size_type{kMinTableSize});
+    ABSL_DCHECK_EQ(n & (n - 1), 0u);
+    TableEntryPtr* result =
+        AllocFor<TableEntryPtr>(alloc_).allocate(TableUnits(n));
+    InitTable(result, n);
+    return result;
+  }
+
+  void DeleteTable(TableEntryPtr* table, size_type n) {
+    UntypedMapBase::DeleteTable(table, TableUnits(n));
+  }
+
+ private:
+  static uint64_t H1(uint64_t h) { return h >> 7; }
+  static uint8_t H2(uint64_t h) { return static_cast<uint8_t>(h & 0x7F); }
+
+  // The multiply and fold mixing of absl::Hash, keyed with the seed.
+  uint64_t Hash(Key key) const {
+    const absl::uint128 m = absl::uint128(static_cast<uint64_t>(key) ^ seed_) *
+                            uint64_t{0x9ddfea08eb382d69};
+    return absl::Uint128High64(m) ^ absl::Uint128Low64(m);
+  }
+
+  // The number of elements a table of n slots holds before it is rehashed.
+  static size_type MaxLoad(size_type n) { return n - n / 8; }
+
+  static size_type CtrlBytes(size_type n) {
+    // Rounded up so that the node pointers are aligned.
+    return (n + kGroupWidth + sizeof(NodeBase*) - 1) &
+           ~(sizeof(NodeBase*) - 1);
+  }
+  static size_type TableUnits(size_type n) {
+    static_assert(sizeof(size_type) % sizeof(TableEntryPtr) == 0, "");
+    static_assert(sizeof(NodeBase*) == sizeof(TableEntryPtr), "");
+    return (sizeof(size_type) + CtrlBytes(n)) / sizeof(TableEntryPtr) + n;
+  }
+
+  static void InitTable(TableEntryPtr* table, size_type n) {
+    auto* p = reinterpret_cast<char*>(table);
+    *reinterpret_cast<size_type*>(p) = MaxLoad(n);
+    p += sizeof(size_type);
+    memset(p, kEmpty, n + kGroupWidth);
+    memset(p + CtrlBytes(n), 0, n * sizeof(NodeBase*));
+  }
+
+  // Empties the table without touching the nodes.
+  void ResetTable() {
+    InitTable(table_, num_buckets_);
+    index_of_first_non_null_ = num_buckets_;
+  }
+
+  size_type& growth_left() { return *reinterpret_cast<size_type*>(table_); }
+  uint8_t* ctrl() const {
+    return reinterpret_cast<uint8_t*>(table_) + sizeof(size_type);
+  }
+  NodeBase** slots() const {
+    return reinterpret_cast<NodeBase**>(ctrl() + CtrlBytes(num_buckets_));
+  }
+
+  // Sets the control byte of slot b, and of its copy after the last slot.
+  void SetCtrl(size_type b, uint8_t c) {
+    ctrl()[b] = c;
+    if (b < kGroupWidth) ctrl()[num_buckets_ + b] = c;
+  }
+
+  // Index of the first full slot at or after `start`, or num_buckets_.
+  // A byte-at-a-time scan keeps iteration free of a load->mask->ctz
+  // dependency chain; at typical load factors the next full slot is close.
+  size_type FindFullFrom(size_type start) const {
+    const uint8_t* c = ctrl();
+    for (size_type i = start; i < num_buckets_; ++i) {
+      if (!(c[i] & kEmpty)) return i;
+    }
+    return num_buckets_;
+  }
+
+  // First empty slot in the probe sequence of `h`, for rehashing.
+  size_type FindFirstNonFull(uint64_t h) const {
+    const size_type mask = num_buckets_ - 1;
+    size_type offset = H1(h) & mask;
+    for (size_type step = kGroupWidth;; step += kGroupWidth) {
+      const uint64_t m = Group(ctrl() + offset).MaskEmptyOrDeleted();
+      if (m != 0) return (offset + Group::LowestIndex(m)) & mask;
+      offset = (offset + step) & mask;
+    }
+  }
 };
 
 template <typename T, typename K>
@@ -1358,6 +1910,19 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
     return find(key) != end();
   }
 
+  // Looks up `keys[0..n)` and stores the result of find() for each of them in
+  // `out[0..n)`. Keys are hashed and their buckets prefetched a group at a
+  // time before any of them is compared, so the cache misses of a large
+  // batch overlap instead of being paid one lookup after another.
+  template <typename K = key_type>
+  void FindBatch(const key_arg<K>* keys, size_t n, const_iterator* out) const {
+    const_cast<Map*>(this)->template FindBatchImpl<K>(keys, n, out);
+  }
+  template <typename K = key_type>
+  void FindBatch(const key_arg<K>* keys, size_t n, iterator* out) {
+    FindBatchImpl<K>(keys, n, out);
+  }
+
   template <typename K = key_type>
   std::pair<const_iterator, const_iterator> equal_range(
       const key_arg<K>& key) const {
@@ -1451,27 +2016,14 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
   }
 
   void clear() {
-    for (size_type b = 0; b < this->num_buckets_; b++) {
-      internal::NodeBase* node;
-      if (this->TableEntryIsNonEmptyList(b)) {
-        node = internal::TableEntryToNode(this->table_[b]);
-        this->table_[b] = TableEntryPtr{};
-      } else if (this->TableEntryIsTree(b)) {
-        Tree* tree = internal::TableEntryToTree<Tree>(this->table_[b]);
-        this->table_[b] = TableEntryPtr{};
-        node = NodeFromTreeIterator(tree->begin());
-        this->DestroyTree(tree);
-      } else {
-        continue;
-      }
-      do {
-        auto* next = node->next;
-        DestroyNode(static_cast<Node*>(node));
-        node = next;
-      } while (node != nullptr);
+    if (this->arena() != nullptr) {
+      // DestroyNode() is a no-op on an arena, so skip walking the nodes.
+      this->ForgetNodes();
+      return;
     }
-    this->num_elements_ = 0;
-    this->index_of_first_non_null_ = this->num_buckets_;
+    this->ClearTable([this](typename Base::KeyNode* node) {
+      DestroyNode(static_cast<Node*>(node));
+    });
   }
 
   // Assign
@@ -1498,6 +2050,43 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
 
   void InternalSwap(Map* other) { this->Swap(other); }
 
+  // Merges `other` into this map the way MapMergeFrom() does, but takes the
+  // nodes of `other` instead of copying them when both maps allocate from the
+  // same arena (or both from the heap). An empty map just swaps tables.
+  // `other` is left empty.
+  void InternalMergeFrom(Map&& other) {
+    if (this == &other) return;
+    if (arena() != other.arena()) {
+      for (const auto& elem : other) {
+        (*this)[elem.first] = elem.second;
+      }
+      other.clear();
+      return;
+    }
+    if (this->empty()) {
+      InternalSwap(&other);
+      return;
+    }
+    for (auto it = other.begin(); it != other.end();) {
+      auto* node = static_cast<Node*>(it.node_);
+      const size_type other_bucket = it.bucket_index_;
+      ++it;
+      auto p = this->FindHelper(node->kv.first);
+      if (p.node != nullptr) {
+        // Keep our node and let other.clear() dispose of theirs.
+        static_cast<Node*>(p.node)->kv.second = std::move(node->kv.second);
+        continue;
+      }
+      other.erase_no_destroy(other_bucket, node);
+      if (this->ResizeIfLoadIsOutOfRange(this->num_elements_ + 1)) {
+        p = this->FindHelper(node->kv.first);
+      }
+      this->InsertUnique(p.bucket, node);
+      ++this->num_elements_;
+    }
+    other.clear();
+  }
+
   hasher hash_function() const { return {}; }
 
   size_t SpaceUsedExcludingSelfLong() const {
@@ -1509,6 +2098,26 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
   struct Rank1 {};
   struct Rank0 : Rank1 {};
 
+  template <typename K, typename It>
+  void FindBatchImpl(const key_arg<K>* keys, size_t n, It* out) {
+    // Large enough to cover the memory latency, small enough for the hashes
+    // to stay in registers or on the stack.
+    constexpr size_t kGroup = 16;
+    uint64_t hashes[kGroup];
+    for (size_t start = 0; start < n; start += kGroup) {
+      const size_t count = std::min(kGroup, n - start);
+      for (size_t i = 0; i < count; ++i) {
+        hashes[i] = this->LookupHash(keys[start + i]);
+        this->PrefetchLookup(hashes[i]);
+      }
+      for (size_t i = 0; i < count; ++i) {
+        auto res = this->FindHashed(keys[start + i], hashes[i]);
+        out[start + i] =
+            iterator(static_cast<Node*>(res.node), this, res.bucket);
+      }
+    }
+  }
+
   // Linked-list nodes, as one would expect for a chaining hash table.
   struct Node : Base::KeyNode {
     static constexpr internal::MapNodeSizeInfoT size_info() {
@@ -1518,18 +2127,10 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
     value_type kv;
   };
 
-  using Tree = internal::TreeForMap<Key>;
-  using TreeIterator = typename Tree::iterator;
-  using TableEntryPtr = internal::TableEntryPtr;
-
-  static Node* NodeFromTreeIterator(TreeIterator it) {
+  void DestroyNode(Node* node) {
     static_assert(
         PROTOBUF_FIELD_OFFSET(Node, kv.first) == Base::KeyNode::kOffset, "");
     static_assert(alignof(Node) == alignof(internal::NodeBase), "");
-    return static_cast<Node*>(it->second);
-  }
-
-  void DestroyNode(Node* node) {
     if (this->alloc_.arena() == nullptr) {
       node->kv.first.~key_type();
       node->kv.second.~mapped_type();
@@ -1538,8 +2139,7 @@ class Map : private internal::KeyMapBase<internal::KeyForBase<Key>> {
   }
 
   size_t SpaceUsedInternal() const {
-    return internal::SpaceUsedInTable<Key>(this->table_, this->num_buckets_,
-                                           this->num_elements_, sizeof(Node));
+    return this->TableSpaceUsed(sizeof(Node));
   }
 
   // We try to construct `init_type` from `Args` with a fall back to
@@ -1656,6 +2256,10 @@ PROTOBUF_NOINLINE void MapMergeFrom(Map<T...>& dest, const Map<T...>& src) {
     dest[elem.first] = elem.second;
   }
 }
+template <typename... T>
+PROTOBUF_NOINLINE void MapMergeFrom(Map<T...>& dest, Map<T...>&& src) {
+  dest.InternalMergeFrom(std::move(src));
+}
 }  // namespace internal
 
 }  // namespace protobuf
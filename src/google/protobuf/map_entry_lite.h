@@ -34,7 +34,10 @@
 #include <assert.h>
 
 #include <algorithm>
+#include <cstddef>
+#include <new>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #include "google/protobuf/arena.h"
@@ -460,6 +463,43 @@ class MapEntryLite : public MapEntryImpl<T, MessageLite, Key, Value,
 
 // Helpers for deterministic serialization =============================
 
+// Scratch memory for the sorters below.  It is kept per thread and reused
+// across serializations, so that deterministic serialization of maps does not
+// allocate once warmed up.  Sorters of nested maps are alive at the same time,
+// so memory must be returned in the reverse order it was handed out.
+class PROTOBUF_EXPORT MapSorterScratch {
+ public:
+  static void* Allocate(size_t bytes);
+  static void Deallocate(void* p, size_t bytes);
+};
+
+// The sorting array of MapSorterFlat and MapSorterPtr, in scratch memory.
+template <typename T>
+class MapSorterItems {
+ public:
+  static_assert(std::is_trivially_destructible<T>::value,
+                "Sorting arrays are never destroyed element-wise");
+
+  explicit MapSorterItems(size_t size)
+      : size_(size),
+        items_(size == 0 ? nullptr
+                         : static_cast<T*>(MapSorterScratch::Allocate(
+                               size * sizeof(T)))) {}
+  MapSorterItems(const MapSorterItems&) = delete;
+  MapSorterItems& operator=(const MapSorterItems&) = delete;
+  ~MapSorterItems() {
+    if (items_ != nullptr) {
+      MapSorterScratch::Deallocate(items_, size_ * sizeof(T));
+    }
+  }
+
+  T* get() const { return items_; }
+
+ private:
+  size_t size_;
+  T* items_;
+};
+
 // Iterator base for MapSorterFlat and MapSorterPtr.
 template <typename storage_type>
 struct MapSorterIt {
@@ -495,14 +535,13 @@ class MapSorterFlat {
     reference operator*() const { return *this->operator->(); }
   };
 
-  explicit MapSorterFlat(const MapT& m)
-      : size_(m.size()), items_(size_ ? new storage_type[size_] : nullptr) {
+  explicit MapSorterFlat(const MapT& m) : size_(m.size()), items_(size_) {
     if (!size_) return;
-    storage_type* it = &items_[0];
+    storage_type* it = items_.get();
     for (const auto& entry : m) {
-      *it++ = {entry.first, &entry};
+      ::new (it++) storage_type(entry.first, &entry);
     }
-    std::sort(&items_[0], &items_[size_],
+    std::sort(items_.get(), items_.get() + size_,
               [](const storage_type& a, const storage_type& b) {
                 return a.first < b.first;
               });
@@ -513,7 +552,7 @@ class MapSorterFlat {
 
  private:
   size_t size_;
-  std::unique_ptr<storage_type[]> items_;
+  MapSorterItems<storage_type> items_;
 };
 
 // MapSorterPtr stores and sorts pointers to map entries. This type is used for
@@ -538,14 +577,13 @@ class MapSorterPtr {
     reference operator*() const { return *this->operator->(); }
   };
 
-  explicit MapSorterPtr(const MapT& m)
-      : size_(m.size()), items_(size_ ? new storage_type[size_] : nullptr) {
+  explicit MapSorterPtr(const MapT& m) : size_(m.size()), items_(size_) {
     if (!size_) return;
-    storage_type* it = &items_[0];
+    storage_type* it = items_.get();
     for (const auto& entry : m) {
       *it++ = &entry;
     }
-    std::sort(&items_[0], &items_[size_],
+    std::sort(items_.get(), items_.get() + size_,
               [](const storage_type& a, const storage_type& b) {
                 return a->first < b->first;
               });
@@ -556,7 +594,7 @@ class MapSorterPtr {
 
  private:
   size_t size_;
-  std::unique_ptr<storage_type[]> items_;
+  MapSorterItems<storage_type> items_;
 };
 
 }  // namespace internal
@@ -88,6 +88,13 @@ MapFieldBase::ReflectionPayload& MapFieldBase::PayloadSlow() const {
   return *ToPayload(p);
 }
 
+void MapFieldBase::LookupMapValues(const MapKey* map_keys, size_t n,
+                                   MapValueConstRef* vals, bool* found) const {
+  for (size_t i = 0; i < n; ++i) {
+    found[i] = LookupMapValue(map_keys[i], &vals[i]);
+  }
+}
+
 void MapFieldBase::Swap(MapFieldBase* other) {
   if (arena() == other->arena()) {
     InternalSwap(other);
@@ -363,6 +363,11 @@ class PROTOBUF_EXPORT MapFieldBase : public MapFieldBaseForParse {
   virtual bool LookupMapValue(const MapKey& map_key,
                               MapValueConstRef* val) const = 0;
   bool LookupMapValue(const MapKey&, MapValueRef*) const = delete;
+  // Looks up `map_keys[0..n)` at once. For each key, `found[i]` tells whether
+  // it is present and, if so, `vals[i]` is set to its value. Typed map fields
+  // hash and prefetch the whole batch up front through Map::FindBatch().
+  virtual void LookupMapValues(const MapKey* map_keys, size_t n,
+                               MapValueConstRef* vals, bool* found) const;
 
   // Returns whether changes to the map are reflected in the repeated field.
   bool IsRepeatedFieldValid() const;
@@ -602,6 +607,8 @@ class TypeDefinedMapFieldBase : public MapFieldBase {
   bool ContainsMapKey(const MapKey& map_key) const final;
   bool LookupMapValue(const MapKey& map_key, MapValueConstRef* val) const final;
   bool LookupMapValue(const MapKey&, MapValueRef*) const = delete;
+  void LookupMapValues(const MapKey* map_keys, size_t n, MapValueConstRef* vals,
+                       bool* found) const final;
   bool DeleteMapValue(const MapKey& map_key) final;
   bool InsertOrLookupMapValue(const MapKey& map_key, MapValueRef* val) override;
 };
@@ -31,12 +31,14 @@
 #ifndef GOOGLE_PROTOBUF_MAP_FIELD_INL_H__
 #define GOOGLE_PROTOBUF_MAP_FIELD_INL_H__
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <tuple>
 #include <type_traits>
 
 #include "absl/base/casts.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/map.h"
 #include "google/protobuf/map_field.h"
 #include "google/protobuf/map_type_handler.h"
@@ -84,6 +86,20 @@ inline MapKey UnwrapMapKey(const MapKey& map_key) {
   return map_key;
 }
 
+// The type used to look a MapKey up in a Map<Key, T> without copying it.
+template <typename Key>
+struct MapLookupKey {
+  using type = Key;
+  static Key Get(const MapKey& map_key) { return UnwrapMapKey<Key>(map_key); }
+};
+template <>
+struct MapLookupKey<std::string> {
+  using type = absl::string_view;
+  static absl::string_view Get(const MapKey& map_key) {
+    return map_key.GetStringValue();
+  }
+};
+
 // SetMapKey
 inline void SetMapKey(MapKey* map_key, int32_t value) {
   map_key->SetInt32Value(value);
@@ -198,6 +214,28 @@ bool TypeDefinedMapFieldBase<Key, T>::LookupMapValue(
   return true;
 }
 
+template <typename Key, typename T>
+void TypeDefinedMapFieldBase<Key, T>::LookupMapValues(
+    const MapKey* map_keys, size_t n, MapValueConstRef* vals,
+    bool* found) const {
+  using LookupKey = MapLookupKey<Key>;
+  const auto& map = GetMap();
+  constexpr size_t kChunk = 16;
+  typename LookupKey::type keys[kChunk];
+  typename Map<Key, T>::const_iterator iters[kChunk];
+  for (size_t start = 0; start < n; start += kChunk) {
+    const size_t count = std::min(kChunk, n - start);
+    for (size_t i = 0; i < count; ++i) {
+      keys[i] = LookupKey::Get(map_keys[start + i]);
+    }
+    map.template FindBatch<typename LookupKey::type>(keys, count, iters);
+    for (size_t i = 0; i < count; ++i) {
+      found[start + i] = iters[i] != map.end();
+      if (found[start + i]) vals[start + i].SetValueOrCopy(&iters[i]->second);
+    }
+  }
+}
+
 template <typename Key, typename T>
 bool TypeDefinedMapFieldBase<Key, T>::DeleteMapValue(const MapKey& map_key) {
   return MutableMap()->erase(UnwrapMapKey<Key>(map_key));
@@ -29,6 +29,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <memory>
+#include <vector>
 
 #include "google/protobuf/arena.h"
 #include "google/protobuf/map.h"
@@ -209,6 +210,42 @@ TEST_P(MapFieldBasePrimitiveTest, Arena) {
   }
 }
 
+TEST_P(MapFieldBasePrimitiveTest, LookupMapValues) {
+  MapKey keys[3];
+  keys[0].SetInt32Value(1);
+  keys[1].SetInt32Value(7);
+  keys[2].SetInt32Value(0);
+  MapValueConstRef vals[3];
+  bool found[3];
+  map_field_base_->LookupMapValues(keys, 3, vals, found);
+  EXPECT_TRUE(found[0]);
+  EXPECT_FALSE(found[1]);
+  EXPECT_TRUE(found[2]);
+}
+
+TEST(MapFieldTest, LookupMapValuesForStrings) {
+  MapField<unittest::TestMap_MapStringStringEntry_DoNotUse, std::string,
+           std::string, WireFormatLite::TYPE_STRING,
+           WireFormatLite::TYPE_STRING>
+      map_field;
+  (*map_field.MutableMap())["a"] = "x";
+  (*map_field.MutableMap())["b"] = "y";
+
+  // More keys than one internal chunk, to cover the chunk boundaries.
+  std::vector<MapKey> keys(40);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i].SetStringValue(i % 3 == 0 ? "a" : i % 3 == 1 ? "b" : "c");
+  }
+  std::vector<MapValueConstRef> vals(keys.size());
+  std::unique_ptr<bool[]> found(new bool[keys.size()]);
+  static_cast<const MapFieldBase&>(map_field).LookupMapValues(
+      keys.data(), keys.size(), vals.data(), found.get());
+  // The values are checked through Reflection, which knows their type.
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(found[i], i % 3 != 2) << i;
+  }
+}
+
 TEST_P(MapFieldBasePrimitiveTest, EnforceNoArena) {
   std::unique_ptr<MapFieldBaseStub> map_field(
       Arena::CreateMessage<MapFieldBaseStub>(nullptr));
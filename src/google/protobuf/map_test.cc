@@ -29,12 +29,15 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
 #include "google/protobuf/arena_test_util.h"
 #include "google/protobuf/map_proto2_unittest.pb.h"
 #include "google/protobuf/map_unittest.pb.h"
@@ -97,6 +100,46 @@ TEST(MapTest, AlignedOnArena) { MapTest_Aligned<AlignedAsDefault, true>(); }
 TEST(MapTest, Aligned8) { MapTest_Aligned<AlignedAs8>(); }
 TEST(MapTest, Aligned8OnArena) { MapTest_Aligned<AlignedAs8, true>(); }
 
+TEST(MapSorterScratchTest, ReusesMemoryForNestedSorters) {
+  // Sorters for a map, a map in one of its values, and a sibling of that.
+  auto nested_sorts = [] {
+    std::array<void*, 3> p;
+    p[0] = MapSorterScratch::Allocate(100);
+    p[1] = MapSorterScratch::Allocate(1000);
+    MapSorterScratch::Deallocate(p[1], 1000);
+    p[2] = MapSorterScratch::Allocate(10);
+    MapSorterScratch::Deallocate(p[2], 10);
+    MapSorterScratch::Deallocate(p[0], 100);
+    return p;
+  };
+  // The first round sizes the scratch block, and later rounds reuse it.
+  nested_sorts();
+  std::array<void*, 3> first = nested_sorts();
+  EXPECT_LT(first[0], first[1]);
+  EXPECT_EQ(first[1], first[2]);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(first[1]) % alignof(std::max_align_t),
+            0);
+  EXPECT_EQ(nested_sorts(), first);
+}
+
+TEST(MapSorterScratchTest, SortsLargeMapsDeterministically) {
+  Map<int32_t, int32_t> map;
+  for (int32_t i = 0; i < 10000; ++i) map[(i * 7919) % 10000] = i;
+  // Larger than the retained scratch memory, so this sorts on the heap.
+  Map<std::string, int32_t> large_keys;
+  for (int32_t i = 0; i < 200000; ++i) large_keys[absl::StrCat(i)] = i;
+  MapSorterFlat<Map<int32_t, int32_t>> sorted(map);
+  int32_t expected = 0;
+  for (const auto& entry : sorted) EXPECT_EQ(entry.first, expected++);
+  EXPECT_EQ(expected, 10000);
+  MapSorterPtr<Map<std::string, int32_t>> sorted_keys(large_keys);
+  const std::string* last = nullptr;
+  for (const auto& entry : sorted_keys) {
+    if (last != nullptr) EXPECT_LT(*last, entry.first);
+    last = &entry.first;
+  }
+}
+
 
 
 }  // namespace
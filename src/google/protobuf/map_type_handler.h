@@ -704,6 +704,12 @@ struct MapEntryFuncs {
   static uint8_t* InternalSerialize(int field_number, const Key& key,
                                     const Value& value, uint8_t* ptr,
                                     io::EpsCopyOutputStream* stream) {
+    if (stream->BackpatchesLengths()) {
+      uint8_t* payload = stream->BeginBackpatchedLengthDelim(field_number, ptr);
+      ptr = KeyTypeHandler::Write(kKeyFieldNumber, key, payload, stream);
+      ptr = ValueTypeHandler::Write(kValueFieldNumber, value, ptr, stream);
+      return stream->EndBackpatchedLengthDelim(payload, ptr);
+    }
     ptr = stream->EnsureSpace(ptr);
     ptr = WireFormatLite::WriteTagToArray(
         field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, ptr);
@@ -54,7 +54,9 @@
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/map_field.h"
 #include "google/protobuf/map_field_inl.h"
+#include "google/protobuf/message_trace.h"
 #include "google/protobuf/parse_context.h"
+#include "google/protobuf/prototype_cache.h"
 #include "google/protobuf/reflection_internal.h"
 #include "google/protobuf/reflection_ops.h"
 #include "google/protobuf/unknown_field_set.h"
@@ -82,6 +84,7 @@ using internal::WireFormat;
 using internal::WireFormatLite;
 
 void Message::MergeFrom(const Message& from) {
+  internal::MessageTraceScope trace(MessageTraceEvent::kMergeFrom, this);
   auto* class_to = GetClassData();
   auto* class_from = from.GetClassData();
   auto* merge_to_from = class_to ? class_to->merge_to_from : nullptr;
@@ -91,6 +94,13 @@ void Message::MergeFrom(const Message& from) {
     };
   }
   merge_to_from(*this, from);
+  trace.Done(true);
+}
+
+Message* Message::Clone(Arena* arena) const {
+  Message* copy = New(arena);
+  copy->MergeFrom(*this);
+  return copy;
 }
 
 void Message::CheckTypeAndMergeFrom(const MessageLite& other) {
@@ -159,6 +169,10 @@ void Message::DiscardUnknownFields() {
   return ReflectionOps::DiscardUnknownFields(this);
 }
 
+bool Message::VerifyFromString(absl::string_view data) const {
+  return internal::TcParser::VerifyMessage(*this, data);
+}
+
 const char* Message::_InternalParse(const char* ptr,
                                     internal::ParseContext* ctx) {
 #if defined(PROTOBUF_USE_TABLE_PARSER_ON_REFLECTION)
@@ -211,6 +225,10 @@ size_t Message::SpaceUsedLong() const {
   return GetReflection()->SpaceUsedLong(*this);
 }
 
+size_t Message::SpaceUsedOnArenaLong() const {
+  return GetReflection()->SpaceUsedOnArenaLong(*this);
+}
+
 uint64_t Message::GetInvariantPerBuild(uint64_t salt) {
   return salt;
 }
@@ -297,6 +315,9 @@ class GeneratedMessageFactory final : public MessageFactory {
   absl::Mutex mutex_;
   absl::flat_hash_map<const Descriptor*, const Message*> type_map_
       ABSL_GUARDED_BY(mutex_);
+  // The types GetPrototype() has returned, for lookups without the lock.
+  // Inserted into under mutex_.
+  internal::PrototypeCache prototype_cache_;
 };
 
 GeneratedMessageFactory* GeneratedMessageFactory::singleton() {
@@ -331,8 +352,7 @@ void GeneratedMessageFactory::RegisterType(const Descriptor* descriptor,
 
 const Message* GeneratedMessageFactory::GetPrototype(const Descriptor* type) {
   {
-    absl::ReaderMutexLock lock(&mutex_);
-    const Message* result = FindInTypeMap(type);
+    const Message* result = prototype_cache_.Find(type);
     if (result != nullptr) return result;
   }
 
@@ -364,6 +384,8 @@ const Message* GeneratedMessageFactory::GetPrototype(const Descriptor* type) {
   if (result == nullptr) {
     ABSL_DLOG(FATAL) << "Type appears to be in generated pool but wasn't "
                      << "registered: " << type->full_name();
+  } else if (prototype_cache_.Find(type) == nullptr) {
+    prototype_cache_.Insert(type, result);
   }
 
   return result;
@@ -454,6 +476,8 @@ PROTOBUF_NOINLINE
 template void InternalMetadata::DoClear<UnknownFieldSet>();
 template void InternalMetadata::DoMergeFrom<UnknownFieldSet>(
     const UnknownFieldSet& other);
+template void InternalMetadata::DoMergeFromAndDestroy<UnknownFieldSet>(
+    UnknownFieldSet* other);
 template void InternalMetadata::DoSwap<UnknownFieldSet>(UnknownFieldSet* other);
 template Arena* InternalMetadata::DeleteOutOfLineHelper<UnknownFieldSet>();
 template UnknownFieldSet*
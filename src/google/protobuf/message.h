@@ -124,6 +124,7 @@
 #include "absl/functional/function_ref.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/generated_message_reflection.h"
 #include "google/protobuf/generated_message_tctable_decl.h"
@@ -150,6 +151,7 @@ class MessageFactory;
 // Defined in other files.
 class AssignDescriptorsHelper;
 class DynamicMessageFactory;
+class FieldPath;
 class GeneratedMessageReflectionTestHelper;
 class MapKey;
 class MapValueConstRef;
@@ -175,6 +177,7 @@ class CodedOutputStream;     // coded_stream.h
 namespace python {
 class MapReflectionFriend;  // scalar_map_container.h
 class MessageReflectionFriend;
+class RepeatedScalarReflectionFriend;  // repeated_scalar_container.cc
 }  // namespace python
 namespace expr {
 class CelMapReflectionFriend;  // field_backed_map_impl.cc
@@ -264,6 +267,9 @@ class PROTOBUF_EXPORT Message : public MessageLite {
   // if arena is a nullptr.
   Message* New(Arena* arena) const override = 0;
 
+  // Returns a copy of this message; see MessageLite::Clone().
+  Message* Clone(Arena* arena = nullptr) const;
+
   // Make this message into a copy of the given message.  The given message
   // must have the same descriptor, but need not necessarily be the same class.
   // By default this is just implemented as "Clear(); MergeFrom(from);".
@@ -302,6 +308,17 @@ class PROTOBUF_EXPORT Message : public MessageLite {
   // See Reflection::GetUnknownFields() for more on unknown fields.
   void DiscardUnknownFields();
 
+  // Returns whether ParseFromString(data) would succeed for this message type,
+  // without parsing: tags, wire types, lengths, UTF-8 of proto3 strings,
+  // nesting depth and required fields are checked by walking the wire bytes
+  // against the parse tables, and nothing is stored.  This message's contents
+  // are not used.
+  //
+  // Unlike parsing, required fields must be present in each occurrence of a
+  // submessage rather than in their merge, and the contents of extensions and
+  // MessageSet items are only checked for well-formed wire format.
+  bool VerifyFromString(absl::string_view data) const;
+
   // Computes (an estimate of) the total number of bytes currently used for
   // storing the message in memory.  The default implementation calls the
   // Reflection object's SpaceUsed() method.
@@ -320,6 +337,12 @@ class PROTOBUF_EXPORT Message : public MessageLite {
     return internal::ToIntSize(SpaceUsedLong());
   }
 
+  // Like SpaceUsedLong(), but only counts memory taken from the message's
+  // arena, which is what the message costs until the arena is reset.  The heap
+  // buffers of strings and cords, and unknown fields, are left out.  Returns 0
+  // for messages that are not on an arena.
+  size_t SpaceUsedOnArenaLong() const;
+
   // Debugging & Testing----------------------------------------------
 
   // Generates a human-readable form of this message for debugging purposes.
@@ -426,9 +449,11 @@ class PROTOBUF_EXPORT Message : public MessageLite {
 
 namespace internal {
 // Creates and returns an allocation for a split message.
-void* CreateSplitMessageGeneric(Arena* arena, const void* default_split,
-                                size_t size, const void* message,
-                                const void* default_message);
+PROTOBUF_EXPORT void* CreateSplitMessageGeneric(Arena* arena,
+                                                const void* default_split,
+                                                size_t size,
+                                                const void* message,
+                                                const void* default_message);
 
 // Forward-declare interfaces used to implement RepeatedFieldRef.
 // These are protobuf internals that users shouldn't care about.
@@ -504,6 +529,9 @@ class PROTOBUF_EXPORT Reflection final {
     return internal::ToIntSize(SpaceUsedLong(message));
   }
 
+  // See Message::SpaceUsedOnArenaLong().
+  size_t SpaceUsedOnArenaLong(const Message& message) const;
+
   // Returns true if the given message is a default message instance.
   bool IsDefaultInstance(const Message& message) const {
     return schema_.IsDefaultInstance(message);
@@ -878,6 +906,67 @@ class PROTOBUF_EXPORT Reflection final {
   MutableRepeatedFieldRef<T> GetMutableRepeatedFieldRef(
       Message* message, const FieldDescriptor* field) const;
 
+  // Bulk accessors ------------------------------------------------------------
+  // For code that reads many values through reflection, such as generic
+  // feature extractors, these avoid a call and a type check per value.
+
+  // Returns the elements of a repeated numeric, enum or bool field, which
+  // must not be a map.  T must match the field's cpp type as in the table
+  // above, with int32_t for enums.  The span is invalidated by any change to
+  // the size of the field.
+  template <typename T>
+  absl::Span<const T> GetRepeatedScalarSpan(const Message& message,
+                                            const FieldDescriptor* field) const;
+
+  // Like GetRepeatedScalarSpan(), but the elements can be modified in place.
+  template <typename T>
+  absl::Span<T> GetMutableRepeatedScalarSpan(
+      Message* message, const FieldDescriptor* field) const;
+
+  // A list of singular numeric, enum and bool fields of one message type, with
+  // the location of each field's value resolved once, to read them all with
+  // GetScalarFields().  Create it with MakeScalarFieldList() on the
+  // Reflection of the type it will be used with.  A list can be shared
+  // between threads.
+  class PROTOBUF_EXPORT ScalarFieldList {
+   public:
+    ScalarFieldList() = default;
+
+    size_t size() const { return entries_.size(); }
+
+   private:
+    friend class Reflection;
+
+    struct Entry {
+      enum Location : uint8_t {
+        kMessage,     // At `offset` in the message.
+        kSplit,       // At `offset` in the message's split fields.
+        kReflection,  // In a oneof or an extension: read with Get*().
+      };
+      Location location;
+      FieldDescriptor::CppType cpp_type;
+      uint32_t offset;
+      const FieldDescriptor* field;
+    };
+
+    const Descriptor* descriptor_ = nullptr;
+    std::vector<Entry> entries_;
+  };
+
+  // Resolves `fields`, which must be singular numeric, enum or bool fields of
+  // this message type or extensions of it.
+  ScalarFieldList MakeScalarFieldList(
+      absl::Span<const FieldDescriptor* const> fields) const;
+
+  // Reads the fields in `list` from `message` into `values`, which must have
+  // one element per field, converting each value to T (an arithmetic type)
+  // with static_cast.  Enum values are read as their numbers.  Fields that
+  // are not set read as their defaults, as they do with GetInt32() and the
+  // like.
+  template <typename T>
+  void GetScalarFields(const Message& message, const ScalarFieldList& list,
+                       absl::Span<T> values) const;
+
   // DEPRECATED. Please use Get(Mutable)RepeatedFieldRef() for repeated field
   // access. The following repeated field accessors will be removed in the
   // future.
@@ -1091,6 +1180,20 @@ class PROTOBUF_EXPORT Reflection final {
     return tcparse_table_;
   }
 
+  // SpaceUsedLong() and ReflectionOps walk the parse table instead of the
+  // descriptor when the table describes every field in a way
+  // TcParser::SpaceUsedFields() and VisitSubmessages() handle.
+  mutable absl::once_flag fields_table_once_;
+  mutable const TcParseTableBase* fields_table_ = nullptr;
+
+  // Returns the parse table if it can be walked as above, or nullptr.
+  const TcParseTableBase* GetFieldsTable() const;
+
+  size_t SpaceUsedLongImpl(const Message& message, bool on_arena) const;
+  static size_t SubmessageSpaceUsed(const MessageLite& message, bool on_arena);
+  size_t SpaceUsedFieldsByDescriptor(const Message& message,
+                                     bool on_arena) const;
+
   const TcParseTableBase* CreateTcParseTable() const;
   const TcParseTableBase* CreateTcParseTableReflectionOnly() const;
   void PopulateTcParseFastEntries(
@@ -1109,15 +1212,18 @@ class PROTOBUF_EXPORT Reflection final {
   friend class MessageLayoutInspector;
   friend class AssignDescriptorsHelper;
   friend class DynamicMessageFactory;
+  friend class FieldPath;
   friend class GeneratedMessageReflectionTestHelper;
   friend class python::MapReflectionFriend;
   friend class python::MessageReflectionFriend;
+  friend class python::RepeatedScalarReflectionFriend;
   friend class util::MessageDifferencer;
 #define GOOGLE_PROTOBUF_HAS_CEL_MAP_REFLECTION_FRIEND
   friend class expr::CelMapReflectionFriend;
   friend class internal::MapFieldReflectionTest;
   friend class internal::MapKeySorter;
   friend class internal::WireFormat;
+  friend class internal::TcParser;
   friend class internal::ReflectionOps;
   friend class internal::SwapFieldHelper;
   friend struct internal::FuzzPeer;
@@ -1157,6 +1263,14 @@ class PROTOBUF_EXPORT Reflection final {
   bool LookupMapValue(const Message&, const FieldDescriptor*, const MapKey&,
                       MapValueRef*) const = delete;
 
+  // Batched form of LookupMapValue(): for each of the `n` keys, sets
+  // `found[i]` and, if the key is present, saves its value pointer to
+  // `vals[i]`. The keys are hashed and their buckets prefetched together,
+  // which is cheaper than `n` separate lookups on large maps.
+  void LookupMapValues(const Message& message, const FieldDescriptor* field,
+                       const MapKey* keys, size_t n, MapValueConstRef* vals,
+                       bool* found) const;
+
   // Delete and returns true if key is in the map field. Returns false
   // otherwise.
   bool DeleteMapValue(Message* message, const FieldDescriptor* field,
@@ -1237,6 +1351,11 @@ class PROTOBUF_EXPORT Reflection final {
 
   // Returns the `_split_` pointer. Requires: IsSplit() == true.
   inline const void* GetSplitField(const Message* message) const;
+
+  // Reads one entry of a ScalarFieldList through the regular accessors.
+  template <typename T>
+  T GetScalarFieldByReflection(const Message& message,
+                               const ScalarFieldList::Entry& entry) const;
   // Returns the address of the `_split_` pointer. Requires: IsSplit() == true.
   inline void** MutableSplitField(Message* message) const;
 
@@ -1556,6 +1675,85 @@ void** Reflection::MutableSplitField(Message* message) const {
   return internal::GetPointerAtOffset<void*>(message, schema_.SplitOffset());
 }
 
+template <typename T>
+absl::Span<const T> Reflection::GetRepeatedScalarSpan(
+    const Message& message, const FieldDescriptor* field) const {
+  const RepeatedField<T>& repeated =
+      GetRepeatedFieldInternal<T>(message, field);
+  return absl::MakeConstSpan(repeated.data(), repeated.size());
+}
+
+template <typename T>
+absl::Span<T> Reflection::GetMutableRepeatedScalarSpan(
+    Message* message, const FieldDescriptor* field) const {
+  RepeatedField<T>* repeated = MutableRepeatedFieldInternal<T>(message, field);
+  return absl::MakeSpan(repeated->mutable_data(), repeated->size());
+}
+
+template <typename T>
+void Reflection::GetScalarFields(const Message& message,
+                                 const ScalarFieldList& list,
+                                 absl::Span<T> values) const {
+  ABSL_DCHECK_EQ(list.descriptor_, descriptor_);
+  ABSL_DCHECK_EQ(list.size(), values.size());
+  const void* split =
+      schema_.IsSplit() ? GetSplitField(&message) : nullptr;
+  for (size_t i = 0; i < list.entries_.size(); ++i) {
+    const ScalarFieldList::Entry& entry = list.entries_[i];
+    if (entry.location == ScalarFieldList::Entry::kReflection) {
+      values[i] = GetScalarFieldByReflection<T>(message, entry);
+      continue;
+    }
+    const void* base =
+        entry.location == ScalarFieldList::Entry::kSplit ? split : &message;
+    const char* value = static_cast<const char*>(base) + entry.offset;
+    switch (entry.cpp_type) {
+#define HANDLE_TYPE(CPPTYPE, TYPE)                                         \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:                                 \
+    values[i] = static_cast<T>(*reinterpret_cast<const TYPE*>(value));     \
+    break;
+
+      HANDLE_TYPE(INT32, int32_t)
+      HANDLE_TYPE(INT64, int64_t)
+      HANDLE_TYPE(UINT32, uint32_t)
+      HANDLE_TYPE(UINT64, uint64_t)
+      HANDLE_TYPE(DOUBLE, double)
+      HANDLE_TYPE(FLOAT, float)
+      HANDLE_TYPE(BOOL, bool)
+      HANDLE_TYPE(ENUM, int)
+#undef HANDLE_TYPE
+
+      default:
+        break;
+    }
+  }
+}
+
+template <typename T>
+T Reflection::GetScalarFieldByReflection(
+    const Message& message, const ScalarFieldList::Entry& entry) const {
+  switch (entry.cpp_type) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return static_cast<T>(GetInt32(message, entry.field));
+    case FieldDescriptor::CPPTYPE_INT64:
+      return static_cast<T>(GetInt64(message, entry.field));
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return static_cast<T>(GetUInt32(message, entry.field));
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return static_cast<T>(GetUInt64(message, entry.field));
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return static_cast<T>(GetDouble(message, entry.field));
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return static_cast<T>(GetFloat(message, entry.field));
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return static_cast<T>(GetBool(message, entry.field));
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return static_cast<T>(GetEnumValue(message, entry.field));
+    default:
+      return T();
+  }
+}
+
 template <typename Type>
 const Type& Reflection::GetRaw(const Message& message,
                                const FieldDescriptor* field) const {
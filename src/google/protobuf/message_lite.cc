@@ -35,6 +35,7 @@
 
 #include "google/protobuf/message_lite.h"
 
+#include <algorithm>
 #include <climits>
 #include <cstddef>
 #include <cstdint>
@@ -58,6 +59,7 @@
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message_trace.h"
 #include "google/protobuf/parse_context.h"
 
 
@@ -67,6 +69,12 @@
 namespace google {
 namespace protobuf {
 
+MessageLite* MessageLite::Clone(Arena* arena) const {
+  MessageLite* copy = New(arena);
+  copy->CheckTypeAndMergeFrom(*this);
+  return copy;
+}
+
 std::string MessageLite::InitializationErrorString() const {
   return "(cannot determine missing fields for lite message)";
 }
@@ -114,10 +122,14 @@ inline absl::string_view as_string_view(const void* data, int size) {
 inline bool CheckFieldPresence(const internal::ParseContext& ctx,
                                const MessageLite& msg,
                                MessageLite::ParseFlags parse_flags) {
-  (void)ctx;  // Parameter is used by Google-internal code.
   if (PROTOBUF_PREDICT_FALSE((parse_flags & MessageLite::kMergePartial) != 0)) {
     return true;
   }
+  // A parse (not a merge) starts from a cleared message, so every message in
+  // the result went through the parser, which checked its required fields.
+  if ((parse_flags & MessageLite::kParse) != 0 && !ctx.MaybeUninitialized()) {
+    return true;
+  }
   return msg.IsInitializedWithErrors();
 }
 
@@ -132,13 +144,15 @@ namespace internal {
 template <bool aliasing>
 bool MergeFromImpl(absl::string_view input, MessageLite* msg,
                    MessageLite::ParseFlags parse_flags) {
+  MessageTraceScope trace(MessageTraceEvent::kParse, msg);
   const char* ptr;
   internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
                              aliasing, &ptr, input);
   ptr = msg->_InternalParse(ptr, &ctx);
   // ctx has an explicit limit set (length of string_view).
   if (PROTOBUF_PREDICT_TRUE(ptr && ctx.EndedAtLimit())) {
-    return CheckFieldPresence(ctx, *msg, parse_flags);
+    trace.set_bytes(input.size());
+    return trace.Done(CheckFieldPresence(ctx, *msg, parse_flags));
   }
   return false;
 }
@@ -146,13 +160,16 @@ bool MergeFromImpl(absl::string_view input, MessageLite* msg,
 template <bool aliasing>
 bool MergeFromImpl(io::ZeroCopyInputStream* input, MessageLite* msg,
                    MessageLite::ParseFlags parse_flags) {
+  MessageTraceScope trace(MessageTraceEvent::kParse, msg);
+  const int64_t start_byte_count = trace.sampled() ? input->ByteCount() : 0;
   const char* ptr;
   internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
                              aliasing, &ptr, input);
   ptr = msg->_InternalParse(ptr, &ctx);
   // ctx has no explicit limit (hence we end on end of stream)
   if (PROTOBUF_PREDICT_TRUE(ptr && ctx.EndedAtEndOfStream())) {
-    return CheckFieldPresence(ctx, *msg, parse_flags);
+    if (trace.sampled()) trace.set_bytes(input->ByteCount() - start_byte_count);
+    return trace.Done(CheckFieldPresence(ctx, *msg, parse_flags));
   }
   return false;
 }
@@ -160,6 +177,7 @@ bool MergeFromImpl(io::ZeroCopyInputStream* input, MessageLite* msg,
 template <bool aliasing>
 bool MergeFromImpl(BoundedZCIS input, MessageLite* msg,
                    MessageLite::ParseFlags parse_flags) {
+  MessageTraceScope trace(MessageTraceEvent::kParse, msg);
   const char* ptr;
   internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
                              aliasing, &ptr, input.zcis, input.limit);
@@ -167,7 +185,8 @@ bool MergeFromImpl(BoundedZCIS input, MessageLite* msg,
   if (PROTOBUF_PREDICT_FALSE(!ptr)) return false;
   ctx.BackUp(ptr);
   if (PROTOBUF_PREDICT_TRUE(ctx.EndedAtLimit())) {
-    return CheckFieldPresence(ctx, *msg, parse_flags);
+    trace.set_bytes(input.limit);
+    return trace.Done(CheckFieldPresence(ctx, *msg, parse_flags));
   }
   return false;
 }
@@ -219,6 +238,8 @@ class ZeroCopyCodedInputStream : public io::ZeroCopyInputStream {
 
 bool MessageLite::MergeFromImpl(io::CodedInputStream* input,
                                 MessageLite::ParseFlags parse_flags) {
+  internal::MessageTraceScope trace(MessageTraceEvent::kParse, this);
+  const int start_position = input->CurrentPosition();
   ZeroCopyCodedInputStream zcis(input);
   const char* ptr;
   internal::ParseContext ctx(input->RecursionBudget(), zcis.aliasing_enabled(),
@@ -239,7 +260,8 @@ bool MessageLite::MergeFromImpl(io::CodedInputStream* input,
   } else {
     input->SetConsumed();
   }
-  return CheckFieldPresence(ctx, *this, parse_flags);
+  trace.set_bytes(input->CurrentPosition() - start_position);
+  return trace.Done(CheckFieldPresence(ctx, *this, parse_flags));
 }
 
 bool MessageLite::MergePartialFromCodedStream(io::CodedInputStream* input) {
@@ -340,10 +362,15 @@ struct SourceWrapper<absl::Cord> {
     absl::optional<absl::string_view> flat = cord->TryFlat();
     if (flat && flat->size() <= ParseContext::kMaxCordBytesToCopy) {
       return MergeFromImpl<alias>(*flat, msg, parse_flags);
-    } else {
-      io::CordInputStream input(cord);
-      return MergeFromImpl<alias>(&input, msg, parse_flags);
     }
+    io::CordInputStream input(cord);
+    if (!alias) {
+      // Fragmented cords would otherwise cost a buffer flip in the parser
+      // every few bytes.  Aliased parses must point into the cord itself.
+      io::CoalescingInputStream coalescing_input(&input);
+      return MergeFromImpl<alias>(&coalescing_input, msg, parse_flags);
+    }
+    return MergeFromImpl<alias>(&input, msg, parse_flags);
   }
 
   const absl::Cord* const cord;
@@ -395,6 +422,47 @@ inline uint8_t* SerializeToArrayImpl(const MessageLite& msg, uint8_t* target,
   }
 }
 
+// Serializes `msg` into [target, target + size) without computing its size
+// first.  Returns the end of the output, or nullptr if it did not fit.
+inline uint8_t* SerializeSinglePassImpl(const MessageLite& msg,
+                                        uint8_t* target, int size) {
+  // Without slop bytes to spare the stream would have to write into its own
+  // patch buffer, which backpatching cannot see past.
+  if (size <= io::EpsCopyOutputStream::kSlopBytes) return nullptr;
+  io::EpsCopyOutputStream out(
+      target, size,
+      io::CodedOutputStream::IsDefaultSerializationDeterministic());
+  // Unlike the constructor, this leaves kSlopBytes at the end of the buffer
+  // to detect overflow, since the size is not known up front.
+  uint8_t* ptr = out.SetInitialBuffer(target, size);
+  out.EnableLengthBackpatching();
+  ptr = msg._InternalSerialize(ptr, &out);
+  if (out.HadError()) return nullptr;
+  ABSL_DCHECK_LE(ptr, target + size);
+  return ptr;
+}
+
+// Grows `output` by `max_size` bytes, has `write(target)` fill them and keeps
+// as many as it returns.  With C++23 resize_and_overwrite the bytes are written
+// inside the call, so no standard library zero-fills them first; absl's helper
+// only avoids that on libc++.
+template <typename Write>
+inline void StringAppendWritten(std::string* output, size_t max_size,
+                                Write write) {
+  const size_t old_size = output->size();
+#if defined(__cpp_lib_string_resize_and_overwrite)
+  output->resize_and_overwrite(old_size + max_size, [&](char* data, size_t) {
+    return old_size + write(reinterpret_cast<uint8_t*>(data + old_size));
+  });
+#else
+  absl::strings_internal::STLStringResizeUninitializedAmortized(
+      output, old_size + max_size);
+  const size_t written = write(
+      reinterpret_cast<uint8_t*>(io::mutable_string_data(output) + old_size));
+  if (written != max_size) output->resize(old_size + written);
+#endif
+}
+
 uint8_t* MessageLite::SerializeWithCachedSizesToArray(uint8_t* target) const {
   // We only optimize this when using optimize_for = SPEED.  In other cases
   // we just use the CodedOutputStream path.
@@ -409,6 +477,7 @@ bool MessageLite::SerializeToCodedStream(io::CodedOutputStream* output) const {
 
 bool MessageLite::SerializePartialToCodedStream(
     io::CodedOutputStream* output) const {
+  internal::MessageTraceScope trace(MessageTraceEvent::kSerialize, this);
   const size_t size = ByteSizeLong();  // Force size to be cached.
   if (size > INT_MAX) {
     ABSL_LOG(ERROR) << GetTypeName()
@@ -428,7 +497,8 @@ bool MessageLite::SerializePartialToCodedStream(
                              final_byte_count - original_byte_count, *this);
   }
 
-  return true;
+  trace.set_bytes(size);
+  return trace.Done(true);
 }
 
 bool MessageLite::SerializeToZeroCopyStream(
@@ -438,46 +508,88 @@ bool MessageLite::SerializeToZeroCopyStream(
   return SerializePartialToZeroCopyStream(output);
 }
 
-bool MessageLite::SerializePartialToZeroCopyStream(
-    io::ZeroCopyOutputStream* output) const {
-  const size_t size = ByteSizeLong();  // Force size to be cached.
-  if (size > INT_MAX) {
-    ABSL_LOG(ERROR) << GetTypeName()
-                    << " exceeded maximum protobuf size of 2GB: " << size;
-    return false;
-  }
-
+// With `aliasing`, large string fields are handed to the stream by reference
+// (see io::ZeroCopyOutputStream::WriteAliasedRaw()), so the caller must know
+// that the stream is done with them by the time this returns.
+// The message's sizes must already be cached.
+static bool SerializeWithCachedSizesToZeroCopyStream(
+    const MessageLite& msg, io::ZeroCopyOutputStream* output, bool aliasing) {
   uint8_t* target;
   io::EpsCopyOutputStream stream(
       output, io::CodedOutputStream::IsDefaultSerializationDeterministic(),
       &target);
-  target = _InternalSerialize(target, &stream);
+  if (aliasing) stream.EnableAliasing(true);
+  target = msg._InternalSerialize(target, &stream);
   stream.Trim(target);
   if (stream.HadError()) return false;
   return true;
 }
 
+static bool CheckSerializedSize(const MessageLite& msg, size_t size) {
+  if (size > INT_MAX) {
+    ABSL_LOG(ERROR) << msg.GetTypeName()
+                    << " exceeded maximum protobuf size of 2GB: " << size;
+    return false;
+  }
+  return true;
+}
+
+static bool SerializePartialToZeroCopyStreamImpl(
+    const MessageLite& msg, io::ZeroCopyOutputStream* output, bool aliasing) {
+  internal::MessageTraceScope trace(MessageTraceEvent::kSerialize, &msg);
+  // Force size to be cached.
+  const size_t size = msg.ByteSizeLong();
+  trace.set_bytes(size);
+  return trace.Done(
+      CheckSerializedSize(msg, size) &&
+      SerializeWithCachedSizesToZeroCopyStream(msg, output, aliasing));
+}
+
+bool MessageLite::SerializePartialToZeroCopyStream(
+    io::ZeroCopyOutputStream* output) const {
+  return SerializePartialToZeroCopyStreamImpl(*this, output,
+                                              /*aliasing=*/false);
+}
+
 bool MessageLite::SerializeToFileDescriptor(int file_descriptor) const {
-  io::FileOutputStream output(file_descriptor);
-  return SerializeToZeroCopyStream(&output) && output.Flush();
+  ABSL_DCHECK(IsInitialized())
+      << InitializationErrorMessage("serialize", *this);
+  return SerializePartialToFileDescriptor(file_descriptor);
 }
 
 bool MessageLite::SerializePartialToFileDescriptor(int file_descriptor) const {
-  io::FileOutputStream output(file_descriptor);
-  return SerializePartialToZeroCopyStream(&output) && output.Flush();
+  internal::MessageTraceScope trace(MessageTraceEvent::kSerialize, this);
+  const size_t size = ByteSizeLong();  // Force size to be cached.
+  if (!CheckSerializedSize(*this, size)) return false;
+  trace.set_bytes(size);
+  // Size the buffer to the message, so that anything up to the cap is
+  // serialized in place and handed to the kernel in a single write() instead
+  // of one per default-sized block.  The slack keeps the stream's end-of-buffer
+  // handling from needing a second buffer.
+  constexpr size_t kSlack = 64;
+  constexpr size_t kMaxBlockSize = 1 << 20;
+  io::FileOutputStream output(
+      file_descriptor,
+      static_cast<int>(std::min(size + kSlack, kMaxBlockSize)));
+  // FileOutputStream writes aliased data out immediately, so large fields
+  // can go straight to the file instead of through its buffer.
+  return trace.Done(SerializeWithCachedSizesToZeroCopyStream(
+                        *this, &output, /*aliasing=*/true) &&
+                    output.Flush());
 }
 
 bool MessageLite::SerializeToOstream(std::ostream* output) const {
-  {
-    io::OstreamOutputStream zero_copy_output(output);
-    if (!SerializeToZeroCopyStream(&zero_copy_output)) return false;
-  }
+  ABSL_DCHECK(IsInitialized())
+      << InitializationErrorMessage("serialize", *this);
+  if (!SerializePartialToOstream(output)) return false;
   return output->good();
 }
 
 bool MessageLite::SerializePartialToOstream(std::ostream* output) const {
   io::OstreamOutputStream zero_copy_output(output);
-  return SerializePartialToZeroCopyStream(&zero_copy_output);
+  // Like FileOutputStream, this writes aliased data out immediately.
+  return SerializePartialToZeroCopyStreamImpl(*this, &zero_copy_output,
+                                              /*aliasing=*/true);
 }
 
 bool MessageLite::AppendToString(std::string* output) const {
@@ -487,7 +599,7 @@ bool MessageLite::AppendToString(std::string* output) const {
 }
 
 bool MessageLite::AppendPartialToString(std::string* output) const {
-  size_t old_size = output->size();
+  internal::MessageTraceScope trace(MessageTraceEvent::kSerialize, this);
   size_t byte_size = ByteSizeLong();
   if (byte_size > INT_MAX) {
     ABSL_LOG(ERROR) << GetTypeName()
@@ -495,12 +607,12 @@ bool MessageLite::AppendPartialToString(std::string* output) const {
     return false;
   }
 
-  absl::strings_internal::STLStringResizeUninitializedAmortized(
-      output, old_size + byte_size);
-  uint8_t* start =
-      reinterpret_cast<uint8_t*>(io::mutable_string_data(output) + old_size);
-  SerializeToArrayImpl(*this, start, byte_size);
-  return true;
+  StringAppendWritten(output, byte_size, [&](uint8_t* start) {
+    SerializeToArrayImpl(*this, start, byte_size);
+    return byte_size;
+  });
+  trace.set_bytes(byte_size);
+  return trace.Done(true);
 }
 
 bool MessageLite::SerializeToString(std::string* output) const {
@@ -520,6 +632,7 @@ bool MessageLite::SerializeToArray(void* data, int size) const {
 }
 
 bool MessageLite::SerializePartialToArray(void* data, int size) const {
+  internal::MessageTraceScope trace(MessageTraceEvent::kSerialize, this);
   const size_t byte_size = ByteSizeLong();
   if (byte_size > INT_MAX) {
     ABSL_LOG(ERROR) << GetTypeName()
@@ -529,7 +642,49 @@ bool MessageLite::SerializePartialToArray(void* data, int size) const {
   if (size < static_cast<int64_t>(byte_size)) return false;
   uint8_t* start = reinterpret_cast<uint8_t*>(data);
   SerializeToArrayImpl(*this, start, byte_size);
-  return true;
+  trace.set_bytes(byte_size);
+  return trace.Done(true);
+}
+
+bool MessageLite::SerializePartialToArraySinglePass(void* data, int size,
+                                                    int* bytes_written) const {
+  internal::MessageTraceScope trace(MessageTraceEvent::kSerialize, this);
+  uint8_t* start = reinterpret_cast<uint8_t*>(data);
+  uint8_t* end = SerializeSinglePassImpl(*this, start, size);
+  if (end == nullptr) {
+    if (!SerializePartialToArray(data, size)) return false;
+    *bytes_written = GetCachedSize();
+  } else {
+    *bytes_written = static_cast<int>(end - start);
+  }
+  trace.set_bytes(*bytes_written);
+  return trace.Done(true);
+}
+
+bool MessageLite::AppendPartialToStringSinglePass(std::string* output) const {
+  internal::MessageTraceScope trace(MessageTraceEvent::kSerialize, this);
+  // Enough for small messages even when `output` has no capacity yet.
+  constexpr size_t kMinSpareCapacity = 256;
+  const size_t old_size = output->size();
+  const size_t spare = std::max(output->capacity() - old_size,
+                                kMinSpareCapacity);
+  if (spare <= INT_MAX) {
+    bool fit = false;
+    StringAppendWritten(output, spare, [&](uint8_t* start) -> size_t {
+      uint8_t* end =
+          SerializeSinglePassImpl(*this, start, static_cast<int>(spare));
+      if (end == nullptr) return 0;
+      fit = true;
+      return end - start;
+    });
+    if (fit) {
+      trace.set_bytes(output->size() - old_size);
+      return trace.Done(true);
+    }
+  }
+  const bool success = AppendPartialToString(output);
+  trace.set_bytes(output->size() - old_size);
+  return trace.Done(success);
 }
 
 std::string MessageLite::SerializeAsString() const {
@@ -555,18 +710,31 @@ bool MessageLite::AppendToCord(absl::Cord* output) const {
 }
 
 bool MessageLite::AppendPartialToCord(absl::Cord* output) const {
-  // For efficiency, we'd like to pass a size hint to CordOutputStream with
-  // the exact total size expected.
+  internal::MessageTraceScope trace(MessageTraceEvent::kSerialize, this);
   const size_t size = ByteSizeLong();
   const size_t total_size = size + output->size();
   if (size > INT_MAX) {
     ABSL_LOG(ERROR) << "Exceeded maximum protobuf size of 2GB.";
     return false;
   }
+  trace.set_bytes(size);
 
-
-  // Allocate a CordBuffer (which may utilize private capacity in 'output').
+  // Serialize straight into a buffer of at least `size` bytes whenever one is
+  // available, so no bytes pass through the stream's patch buffer.  Small
+  // messages first try the private capacity in `output`, then a single flat
+  // of up to kCustomLimit bytes.
   absl::CordBuffer buffer = output->GetAppendBuffer(size);
+  if (buffer.capacity() - buffer.length() < size &&
+      size <= absl::CordBuffer::kCustomLimit) {
+    // The capacity is rounded down to an allocation size, so ask for twice
+    // what is needed.
+    absl::CordBuffer flat = absl::CordBuffer::CreateWithCustomLimit(
+        absl::CordBuffer::kCustomLimit, 2 * size);
+    if (flat.capacity() >= size) {
+      output->Append(std::move(buffer));
+      buffer = std::move(flat);
+    }
+  }
   absl::Span<char> available = buffer.available();
   auto target = reinterpret_cast<uint8_t*>(available.data());
   if (available.size() >= size) {
@@ -580,23 +748,22 @@ bool MessageLite::AppendPartialToCord(absl::Cord* output) const {
     buffer.IncreaseLengthBy(size);
     output->Append(std::move(buffer));
     ABSL_DCHECK_EQ(output->size(), total_size);
-    return true;
+    return trace.Done(true);
   }
 
-  // Donate the buffer to the CordOutputStream with length := capacity.
-  // This follows the eager `EpsCopyOutputStream` initialization logic.
-  buffer.SetLength(buffer.capacity());
-  io::CordOutputStream output_stream(std::move(*output), std::move(buffer),
-                                     total_size);
-  io::EpsCopyOutputStream out(
-      target, static_cast<int>(available.size()), &output_stream,
-      io::CodedOutputStream::IsDefaultSerializationDeterministic(), &target);
-  target = _InternalSerialize(target, &out);
-  out.Trim(target);
-  if (out.HadError()) return false;
-  *output = output_stream.Consume();
+  // Larger messages are serialized into one allocation of exactly `size`
+  // bytes which the cord adopts, instead of through a CordOutputStream that
+  // hands out flats of at most kDefaultLimit bytes and copies across each
+  // boundary.
+  output->Append(std::move(buffer));
+  char* data = new char[size];
+  SerializeToArrayImpl(*this, reinterpret_cast<uint8_t*>(data),
+                       static_cast<int>(size));
+  output->Append(absl::MakeCordFromExternal(
+      absl::string_view(data, size),
+      [](absl::string_view external) { delete[] external.data(); }));
   ABSL_DCHECK_EQ(output->size(), total_size);
-  return true;
+  return trace.Done(true);
 }
 
 bool MessageLite::SerializeToCord(absl::Cord* output) const {
@@ -650,6 +817,17 @@ void InternalMetadata::DoMergeFrom<std::string>(const std::string& other) {
   mutable_unknown_fields<std::string>()->append(other);
 }
 
+template <>
+void InternalMetadata::DoMergeFromAndDestroy<std::string>(std::string* other) {
+  std::string* unknown_fields = mutable_unknown_fields<std::string>();
+  if (unknown_fields->empty()) {
+    unknown_fields->swap(*other);
+  } else {
+    unknown_fields->append(*other);
+  }
+  other->clear();
+}
+
 template <>
 void InternalMetadata::DoSwap<std::string>(std::string* other) {
   mutable_unknown_fields<std::string>()->swap(*other);
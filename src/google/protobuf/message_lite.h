@@ -187,6 +187,13 @@ class PROTOBUF_EXPORT MessageLite {
   // if arena is a nullptr.
   virtual MessageLite* New(Arena* arena) const = 0;
 
+  // Returns a copy of this message, constructed on `arena` if it is not
+  // null.  Ownership is as for New(arena).  The copy is merged straight into
+  // the new, empty instance, which skips the Clear() that New() followed by
+  // CopyFrom() would do.  Generated classes provide a faster overload that
+  // returns their own type.
+  MessageLite* Clone(Arena* arena = nullptr) const;
+
   Arena* GetArena() const { return _internal_metadata_.arena(); }
 
   // Clear all fields of the message and set them to their default values.
@@ -350,6 +357,14 @@ class PROTOBUF_EXPORT MessageLite {
   bool SerializeToArray(void* data, int size) const;
   // Like SerializeToArray(), but allows missing required fields.
   bool SerializePartialToArray(void* data, int size) const;
+  // Like SerializePartialToArray(), but writes the message in a single
+  // traversal instead of computing its size first, and stores the number of
+  // bytes written in `*bytes_written`.  The output is identical.  Falls back
+  // to the regular path when fewer than io::EpsCopyOutputStream::kSlopBytes
+  // bytes of `data` are left over after the message, so callers that size
+  // `data` generously get the full benefit.
+  bool SerializePartialToArraySinglePass(void* data, int size,
+                                         int* bytes_written) const;
 
   // Make a string encoding the message. Is equivalent to calling
   // SerializeToString() on a string and using that.  Returns the empty
@@ -377,6 +392,10 @@ class PROTOBUF_EXPORT MessageLite {
   bool AppendToString(std::string* output) const;
   // Like AppendToString(), but allows missing required fields.
   bool AppendPartialToString(std::string* output) const;
+  // Like AppendPartialToString(), but serializes into the spare capacity of
+  // `output` in a single traversal (see SerializePartialToArraySinglePass()).
+  // Useful when `output` is reused across messages of similar size.
+  bool AppendPartialToStringSinglePass(std::string* output) const;
 
   // Reads a protocol buffer from a Cord and merges it into this message.
   bool MergeFromCord(const absl::Cord& cord);
@@ -0,0 +1,313 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Recycles the arenas and messages of short-lived requests, e.g. in RPC
+// handlers:
+//
+//   void Handle(absl::string_view payload) {
+//     auto request = MessagePool<MyRequest>::Acquire();
+//     if (!request->ParseFromString(payload)) return;
+//     auto* response = Arena::Create<MyResponse>(request.arena());
+//     ...
+//   }  // `request` and everything on its arena are released here.
+//
+// Each thread keeps a small free list of arenas, each holding an already
+// constructed message. Acquire() pops from the calling thread's list and
+// release pushes onto it, so both are O(1) and do not synchronize with other
+// threads. A released arena is Reset(), keeping its first block, and a fresh
+// message is constructed on it right away.
+//
+// The first block of each arena is sized from the memory recently used by
+// released arenas of the same thread, so that a typical request fits in it
+// and does not allocate any further blocks.
+
+#ifndef GOOGLE_PROTOBUF_MESSAGE_POOL_H__
+#define GOOGLE_PROTOBUF_MESSAGE_POOL_H__
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/arena.h"
+#include "google/protobuf/message_lite.h"
+#include "google/protobuf/port.h"
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+// Tuning of a MessagePool<T>. See MessagePool<T>::Configure().
+struct MessagePoolOptions {
+  // The maximum number of idle arenas each thread keeps. Arenas released while
+  // the calling thread's list is full are destroyed.
+  size_t max_cached_per_thread = 4;
+
+  // Bounds on the size of the first block of pooled arenas. Requests using
+  // more memory than max_initial_block_size still work; their arenas just
+  // allocate further blocks, which are freed when the arena is released.
+  size_t min_initial_block_size = 1024;
+  size_t max_initial_block_size = 1024 * 1024;
+};
+
+// A snapshot of the counters of a MessagePool<T>. The counters are updated
+// with relaxed atomics, so a snapshot taken while other threads use the pool
+// is only approximately consistent.
+struct MessagePoolStats {
+  // Calls to Acquire(), and how many of them were served from the calling
+  // thread's free list rather than by creating a new arena.
+  uint64_t acquires = 0;
+  uint64_t hits = 0;
+  // Released messages, and how many of their arenas were destroyed because
+  // the free list was full.
+  uint64_t releases = 0;
+  uint64_t discards = 0;
+  // Released arenas whose first block was reallocated because recent requests
+  // used considerably more or less memory than it holds.
+  uint64_t resizes = 0;
+
+  double hit_rate() const {
+    return acquires == 0 ? 0.0 : static_cast<double>(hits) / acquires;
+  }
+};
+
+// A per-thread pool of messages of type T, each on its own arena. The pool is
+// global per type; all members are static.
+template <typename T>
+class MessagePool {
+  static_assert(std::is_base_of<MessageLite, T>::value,
+                "MessagePool only holds messages");
+
+  struct Entry;
+
+ public:
+  // Owns an acquired message and its arena, and gives both back to the pool
+  // when destroyed or reset(). Objects created on arena() are destroyed along
+  // with the message.
+  class Handle {
+   public:
+    Handle() = default;
+    Handle(Handle&& other) noexcept : entry_(std::move(other.entry_)) {}
+    Handle& operator=(Handle&& other) noexcept {
+      if (this != &other) {
+        reset();
+        entry_ = std::move(other.entry_);
+      }
+      return *this;
+    }
+    ~Handle() { reset(); }
+
+    T* get() const { return entry_ == nullptr ? nullptr : entry_->message; }
+    T& operator*() const { return *get(); }
+    T* operator->() const { return get(); }
+    explicit operator bool() const { return entry_ != nullptr; }
+
+    Arena* arena() const {
+      return entry_ == nullptr ? nullptr : entry_->arena.get();
+    }
+
+    // Releases the message to the calling thread's pool. The message and all
+    // other objects on arena() must no longer be used.
+    void reset() {
+      if (entry_ != nullptr) Release(std::move(entry_));
+    }
+
+   private:
+    friend class MessagePool;
+    explicit Handle(std::unique_ptr<Entry> entry) : entry_(std::move(entry)) {}
+
+    std::unique_ptr<Entry> entry_;
+  };
+
+  MessagePool() = delete;
+
+  // Returns a default constructed message on an arena of its own.
+  static Handle Acquire() {
+    ThreadCache& cache = LocalCache();
+    Counters& counters = GlobalCounters();
+    counters.acquires.fetch_add(1, std::memory_order_relaxed);
+    if (!cache.free.empty()) {
+      counters.hits.fetch_add(1, std::memory_order_relaxed);
+      std::unique_ptr<Entry> entry = std::move(cache.free.back());
+      cache.free.pop_back();
+      return Handle(std::move(entry));
+    }
+    return Handle(
+        std::make_unique<Entry>(cache.TargetBlockSize(LoadOptions())));
+  }
+
+  // Replaces the options of the pool. Threads apply them as they release
+  // messages; arenas already cached are not affected until then.
+  static void Configure(const MessagePoolOptions& options) {
+    Counters& counters = GlobalCounters();
+    counters.max_cached_per_thread.store(options.max_cached_per_thread,
+                                         std::memory_order_relaxed);
+    counters.min_initial_block_size.store(options.min_initial_block_size,
+                                          std::memory_order_relaxed);
+    counters.max_initial_block_size.store(options.max_initial_block_size,
+                                          std::memory_order_relaxed);
+  }
+
+  static MessagePoolStats GetStats() {
+    const Counters& counters = GlobalCounters();
+    MessagePoolStats stats;
+    stats.acquires = counters.acquires.load(std::memory_order_relaxed);
+    stats.hits = counters.hits.load(std::memory_order_relaxed);
+    stats.releases = counters.releases.load(std::memory_order_relaxed);
+    stats.discards = counters.discards.load(std::memory_order_relaxed);
+    stats.resizes = counters.resizes.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  // Destroys the idle arenas of the calling thread.
+  static void ClearThreadCache() { LocalCache().free.clear(); }
+
+ private:
+  // The number of releases the first block size is derived from.
+  static constexpr size_t kHistorySize = 16;
+
+  struct Entry {
+    explicit Entry(size_t size)
+        : block(new char[size]), block_size(size) {
+      ArenaOptions options;
+      options.initial_block = block.get();
+      options.initial_block_size = block_size;
+      arena = std::make_unique<Arena>(options);
+      message = Arena::Create<T>(arena.get());
+    }
+
+    // Declared before `arena` so that the arena is destroyed first.
+    std::unique_ptr<char[]> block;
+    size_t block_size;
+    std::unique_ptr<Arena> arena;
+    T* message;
+  };
+
+  struct ThreadCache {
+    std::vector<std::unique_ptr<Entry>> free;
+    // Bytes used by the most recently released arenas, as a ring buffer.
+    std::array<uint64_t, kHistorySize> history{};
+    size_t next = 0;
+
+    void Record(uint64_t used) {
+      history[next] = used;
+      next = (next + 1) % kHistorySize;
+    }
+
+    // The largest recent usage plus room for block headers and fragmentation,
+    // rounded up to a multiple of 1KiB.
+    size_t TargetBlockSize(const MessagePoolOptions& options) const {
+      uint64_t used = *std::max_element(history.begin(), history.end());
+      uint64_t size = (used + used / 8 + 256 + 1023) & ~uint64_t{1023};
+      size = std::max<uint64_t>(size, options.min_initial_block_size);
+      size = std::min<uint64_t>(size, options.max_initial_block_size);
+      return static_cast<size_t>(size);
+    }
+  };
+
+  struct Counters {
+    std::atomic<uint64_t> acquires{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> releases{0};
+    std::atomic<uint64_t> discards{0};
+    std::atomic<uint64_t> resizes{0};
+
+    std::atomic<size_t> max_cached_per_thread{
+        MessagePoolOptions().max_cached_per_thread};
+    std::atomic<size_t> min_initial_block_size{
+        MessagePoolOptions().min_initial_block_size};
+    std::atomic<size_t> max_initial_block_size{
+        MessagePoolOptions().max_initial_block_size};
+  };
+
+  static Counters& GlobalCounters() {
+    static Counters* counters = new Counters();
+    return *counters;
+  }
+
+  static MessagePoolOptions LoadOptions() {
+    const Counters& counters = GlobalCounters();
+    MessagePoolOptions options;
+    options.max_cached_per_thread =
+        counters.max_cached_per_thread.load(std::memory_order_relaxed);
+    options.min_initial_block_size =
+        counters.min_initial_block_size.load(std::memory_order_relaxed);
+    options.max_initial_block_size =
+        counters.max_initial_block_size.load(std::memory_order_relaxed);
+    return options;
+  }
+
+  // Messages must not be released from destructors of other thread_local
+  // objects, which may run after this cache is gone.
+  static ThreadCache& LocalCache() {
+    static thread_local ThreadCache cache;
+    return cache;
+  }
+
+  static void Release(std::unique_ptr<Entry> entry) {
+    ThreadCache& cache = LocalCache();
+    Counters& counters = GlobalCounters();
+    const MessagePoolOptions options = LoadOptions();
+    counters.releases.fetch_add(1, std::memory_order_relaxed);
+    cache.Record(entry->arena->SpaceUsed());
+    if (cache.free.size() >= options.max_cached_per_thread) {
+      counters.discards.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    const size_t target = cache.TargetBlockSize(options);
+    if (entry->block_size < target || entry->block_size / 2 > target) {
+      counters.resizes.fetch_add(1, std::memory_order_relaxed);
+      entry.reset();
+      entry = std::make_unique<Entry>(target);
+    } else {
+      entry->arena->Reset();
+      entry->message = Arena::Create<T>(entry->arena.get());
+    }
+    cache.free.push_back(std::move(entry));
+  }
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_MESSAGE_POOL_H__
@@ -0,0 +1,104 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/message_trace.h"
+
+#include <atomic>
+#include <string>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+#if defined(PROTOBUF_MESSAGE_TRACE)
+namespace {
+
+PROTOBUF_CONSTINIT std::atomic<int> message_trace_sampling_period{1};
+
+}  // namespace
+
+PROTOBUF_CONSTINIT std::atomic<MessageTraceSink*> message_trace_sink{nullptr};
+PROTOBUF_THREAD_LOCAL MessageTraceState message_trace_state = {
+    /*next_sample=*/0, /*active=*/false};
+
+void MessageTraceScope::Start(MessageTraceEvent::Kind kind,
+                              const MessageLite* msg) {
+  sink_ = message_trace_sink.load(std::memory_order_acquire);
+  if (sink_ == nullptr) return;
+  message_trace_state.next_sample =
+      message_trace_sampling_period.load(std::memory_order_relaxed);
+  message_trace_state.active = true;
+  kind_ = kind;
+  msg_ = msg;
+  start_ = absl::Now();
+}
+
+void MessageTraceScope::Finish() {
+  MessageTraceEvent event;
+  event.duration = absl::Now() - start_;
+  event.kind = kind_;
+  // Only looked up for sampled calls, as it copies the name.
+  std::string type_name;
+  if (msg_ != nullptr) type_name = msg_->GetTypeName();
+  event.type_name = type_name;
+  event.bytes = bytes_;
+  event.success = success_;
+  // Still active, so that calls made by the sink are not traced.
+  sink_->Record(event);
+  message_trace_state.active = false;
+}
+
+#endif  // PROTOBUF_MESSAGE_TRACE
+
+}  // namespace internal
+
+void SetMessageTraceSink(MessageTraceSink* sink, int sampling_period) {
+#if defined(PROTOBUF_MESSAGE_TRACE)
+  internal::message_trace_sampling_period.store(
+      sampling_period > 0 ? sampling_period : 1, std::memory_order_relaxed);
+  internal::message_trace_sink.store(sink, std::memory_order_release);
+  internal::message_trace_state.next_sample = 0;
+#else
+  (void)sink;
+  (void)sampling_period;
+#endif  // PROTOBUF_MESSAGE_TRACE
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
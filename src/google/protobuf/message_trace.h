@@ -0,0 +1,188 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Sampled latency and size tracing of parse, serialize and merge calls, and
+// of arena resets and destruction, for attributing their cost to message
+// types in production:
+//
+//   class MyTraceSink : public MessageTraceSink {
+//     void Record(const MessageTraceEvent& event) override {
+//       ... export event.type_name, event.bytes, event.duration ...
+//     }
+//   };
+//   static MyTraceSink* sink = new MyTraceSink;
+//   SetMessageTraceSink(sink, /*sampling_period=*/1000);
+//
+// The hooks are only compiled into the runtime when it is built with
+// PROTOBUF_MESSAGE_TRACE defined. Otherwise they compile to nothing and
+// SetMessageTraceSink() has no effect.
+
+#ifndef GOOGLE_PROTOBUF_MESSAGE_TRACE_H__
+#define GOOGLE_PROTOBUF_MESSAGE_TRACE_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+class MessageLite;
+
+struct MessageTraceEvent {
+  enum Kind {
+    // MessageLite::ParseFrom*() and MergeFrom*() from wire format input.
+    kParse,
+    // MessageLite::Serialize*() and Append*().
+    kSerialize,
+    // Message::MergeFrom() from another message.
+    kMergeFrom,
+    // Arena::Reset() and arena destruction.
+    kArenaReset,
+    kArenaDestroy,
+  };
+  Kind kind;
+  // Full name of the message type. Empty for arena events.
+  absl::string_view type_name;
+  // Wire format bytes parsed or serialized, or bytes the arena released.
+  // 0 where not known, e.g. for a parse that failed.
+  size_t bytes;
+  absl::Duration duration;
+  bool success;
+};
+
+class PROTOBUF_EXPORT MessageTraceSink {
+ public:
+  virtual ~MessageTraceSink() = default;
+
+  // Called right after a sampled call returns, on the thread that made it.
+  // May be called concurrently from several threads. Calls made by Record()
+  // itself are not traced.
+  virtual void Record(const MessageTraceEvent& event) = 0;
+};
+
+// Reports one in every `sampling_period` traced calls on each thread to
+// `sink`, which must stay alive until it is replaced. The next call on the
+// calling thread is always reported. Passing nullptr turns tracing off.
+PROTOBUF_EXPORT void SetMessageTraceSink(MessageTraceSink* sink,
+                                         int sampling_period = 1);
+
+namespace internal {
+
+#if defined(PROTOBUF_MESSAGE_TRACE)
+
+struct MessageTraceState {
+  // Calls left on this thread until the next one is sampled.
+  int64_t next_sample;
+  // Set while a sampled call runs, so that nested calls (e.g. a serializer
+  // falling back to another) are not reported twice.
+  bool active;
+};
+
+PROTOBUF_EXPORT extern PROTOBUF_CONSTINIT std::atomic<MessageTraceSink*>
+    message_trace_sink;
+PROTOBUF_EXPORT extern PROTOBUF_THREAD_LOCAL MessageTraceState
+    message_trace_state;
+
+// Times the enclosing call and reports it on destruction if it was sampled.
+// Calls count as failed unless Done(true) was called.
+class PROTOBUF_EXPORT MessageTraceScope {
+ public:
+  MessageTraceScope(MessageTraceEvent::Kind kind, const MessageLite* msg) {
+    if (PROTOBUF_PREDICT_TRUE(
+            message_trace_sink.load(std::memory_order_relaxed) == nullptr)) {
+      return;
+    }
+    if (--message_trace_state.next_sample > 0 || message_trace_state.active) {
+      return;
+    }
+    Start(kind, msg);
+  }
+  MessageTraceScope(const MessageTraceScope&) = delete;
+  MessageTraceScope& operator=(const MessageTraceScope&) = delete;
+  ~MessageTraceScope() {
+    if (PROTOBUF_PREDICT_FALSE(sink_ != nullptr)) Finish();
+  }
+
+  // Whether the call is reported. Lets callers skip work that only feeds
+  // set_bytes().
+  bool sampled() const { return sink_ != nullptr; }
+  void set_bytes(size_t bytes) { bytes_ = bytes; }
+  // Returns `success`, for `return trace.Done(...);`.
+  bool Done(bool success) {
+    success_ = success;
+    return success;
+  }
+
+ private:
+  void Start(MessageTraceEvent::Kind kind, const MessageLite* msg);
+  void Finish();
+
+  MessageTraceSink* sink_ = nullptr;
+  MessageTraceEvent::Kind kind_;
+  const MessageLite* msg_;
+  absl::Time start_;
+  size_t bytes_ = 0;
+  bool success_ = false;
+};
+
+#else  // PROTOBUF_MESSAGE_TRACE
+
+class MessageTraceScope {
+ public:
+  MessageTraceScope(MessageTraceEvent::Kind, const MessageLite*) {}
+  MessageTraceScope(const MessageTraceScope&) = delete;
+  MessageTraceScope& operator=(const MessageTraceScope&) = delete;
+
+  bool sampled() const { return false; }
+  void set_bytes(size_t) {}
+  bool Done(bool success) { return success; }
+};
+
+#endif  // PROTOBUF_MESSAGE_TRACE
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_MESSAGE_TRACE_H__
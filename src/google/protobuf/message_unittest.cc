@@ -32,6 +32,7 @@
 //  Based on original Protocol Buffers design by
 //  Sanjay Ghemawat, Jeff Dean, and others.
 
+#include "google/protobuf/map_unittest.pb.h"
 #include "google/protobuf/unittest.pb.h"
 
 #define MESSAGE_TEST_NAME MessageTest
@@ -32,6 +32,7 @@
 #define GOOGLE_PROTOBUF_METADATA_LITE_H__
 
 #include <string>
+#include <utility>
 
 #include "google/protobuf/arena.h"
 #include "google/protobuf/port.h"
@@ -154,6 +155,15 @@ class PROTOBUF_EXPORT InternalMetadata {
     }
   }
 
+  // Like MergeFrom() above, but takes over other's unknown fields instead of
+  // copying them, leaving other without any.
+  template <typename T>
+  PROTOBUF_NDEBUG_INLINE void MergeFrom(InternalMetadata&& other) {
+    if (other.have_unknown_fields()) {
+      DoMergeFromAndDestroy<T>(other.mutable_unknown_fields<T>());
+    }
+  }
+
   template <typename T>
   PROTOBUF_NDEBUG_INLINE void Clear() {
     if (have_unknown_fields()) {
@@ -225,6 +235,11 @@ class PROTOBUF_EXPORT InternalMetadata {
     mutable_unknown_fields<T>()->MergeFrom(other);
   }
 
+  template <typename T>
+  PROTOBUF_NOINLINE void DoMergeFromAndDestroy(T* other) {
+    mutable_unknown_fields<T>()->MergeFrom(std::move(*other));
+  }
+
   template <typename T>
   PROTOBUF_NOINLINE void DoSwap(T* other) {
     mutable_unknown_fields<T>()->Swap(other);
@@ -242,6 +257,9 @@ template <>
 PROTOBUF_EXPORT void InternalMetadata::DoMergeFrom<std::string>(
     const std::string& other);
 template <>
+PROTOBUF_EXPORT void InternalMetadata::DoMergeFromAndDestroy<std::string>(
+    std::string* other);
+template <>
 PROTOBUF_EXPORT void InternalMetadata::DoSwap<std::string>(std::string* other);
 
 // Instantiated once in message.cc (where the definition of UnknownFieldSet is
@@ -251,6 +269,9 @@ InternalMetadata::DoClear<UnknownFieldSet>();
 extern template PROTOBUF_EXPORT void
 InternalMetadata::DoMergeFrom<UnknownFieldSet>(const UnknownFieldSet& other);
 extern template PROTOBUF_EXPORT void
+InternalMetadata::DoMergeFromAndDestroy<UnknownFieldSet>(
+    UnknownFieldSet* other);
+extern template PROTOBUF_EXPORT void
 InternalMetadata::DoSwap<UnknownFieldSet>(UnknownFieldSet* other);
 extern template PROTOBUF_EXPORT Arena*
 InternalMetadata::DeleteOutOfLineHelper<UnknownFieldSet>();
@@ -36,6 +36,7 @@
 #include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/message_lite.h"
+#include "google/protobuf/repeated_bit_field.h"
 #include "google/protobuf/repeated_field.h"
 #include "google/protobuf/wire_format_lite.h"
 #include "utf8_validity.h"
@@ -288,6 +289,34 @@ const char* EpsCopyInputStream::ReadCordFallback(const char* ptr, int size,
   return ptr;
 }
 
+const char* EpsCopyInputStream::ReadArenaCord(const char* ptr, int size,
+                                              absl::Cord* cord, Arena* arena) {
+  // Short payloads are stored inline in the cord and long ones read from a
+  // stream share the stream's buffers, so neither allocates cord chunks.
+  constexpr int kMaxInlineCordBytes = 15;
+  if (arena == nullptr || !arena->impl_.arena_owned_cords() ||
+      size <= kMaxInlineCordBytes ||
+      (zcis_ != nullptr && size > kMaxCordBytesToCopy)) {
+    return ReadCord(ptr, size, cord);
+  }
+  // Don't allocate on the arena for a size not backed by the input.
+  if (size > buffer_end_ - ptr + limit_) return nullptr;
+  char* data = Arena::CreateArray<char>(arena, size);
+  if (size <= buffer_end_ + kSlopBytes - ptr) {
+    memcpy(data, ptr, size);
+    ptr += size;
+  } else {
+    char* out = data;
+    ptr = AppendSize(ptr, size, [&out](const char* p, int s) {
+      memcpy(out, p, s);
+      out += s;
+    });
+    if (ptr == nullptr) return nullptr;
+  }
+  *cord = absl::MakeCordFromExternal(absl::string_view(data, size),
+                                     [](absl::string_view) {});
+  return ptr;
+}
 
 const char* EpsCopyInputStream::InitFrom(io::ZeroCopyInputStream* zcis) {
   zcis_ = zcis;
@@ -335,6 +364,44 @@ const char* ParseContext::ParseMessage(MessageLite* msg, const char* ptr) {
   return ptr;
 }
 
+const char* ParseContext::DeferMessage(MessageLite* msg, const char* ptr,
+                                       const TcParseTableBase* table) {
+  LimitToken old;
+  ptr = ReadSizeAndPushLimitAndDepth(ptr, &old);
+  if (ptr == nullptr) return ptr;
+  deferred_.msg = msg;
+  deferred_.table = table;
+  deferred_.end.old_limit = std::move(old);
+  deferred_.end.group_tag = 0;
+  SetLastTag(kDeferredMessageTag);
+  return ptr;
+}
+
+const char* ParseContext::DeferGroup(MessageLite* msg, const char* ptr,
+                                     uint32_t tag,
+                                     const TcParseTableBase* table) {
+  if (--depth_ < 0) return nullptr;
+  group_depth_++;
+  deferred_.msg = msg;
+  deferred_.table = table;
+  deferred_.end.group_tag = tag;
+  SetLastTag(kDeferredMessageTag);
+  return ptr;
+}
+
+const char* ParseContext::EndDeferredMessage(const char* ptr,
+                                             DeferredMessage::End end) {
+  if (end.group_tag == 0) {
+    depth_++;
+    if (!PopLimit(std::move(end.old_limit))) return nullptr;
+    return ptr;
+  }
+  group_depth_--;
+  depth_++;
+  if (PROTOBUF_PREDICT_FALSE(!ConsumeEndGroup(end.group_tag))) return nullptr;
+  return ptr;
+}
+
 inline void WriteVarint(uint64_t val, std::string* s) {
   while (val >= 128) {
     uint8_t c = val | 0x80;
@@ -496,6 +563,13 @@ const char* PackedBoolParser(void* object, const char* ptr, ParseContext* ctx) {
   return VarintParser<bool, false>(object, ptr, ctx);
 }
 
+const char* PackedBitFieldParser(void* object, const char* ptr,
+                                 ParseContext* ctx) {
+  return ctx->ReadPackedVarint(ptr, [object](uint64_t varint) {
+    static_cast<RepeatedBitField*>(object)->Add(varint != 0);
+  });
+}
+
 template <typename T>
 const char* FixedParser(void* object, const char* ptr, ParseContext* ctx) {
   int size = ReadSize(&ptr);
@@ -39,6 +39,7 @@
 #include "absl/base/config.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
+#include "absl/numeric/bits.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/internal/resize_uninitialized.h"
 #include "absl/strings/string_view.h"
@@ -69,6 +70,8 @@ class MessageFactory;
 
 namespace internal {
 
+struct TcParseTableBase;
+
 // Template code below needs to know about the existence of these functions.
 PROTOBUF_EXPORT void WriteVarint(uint32_t num, uint64_t val, std::string* s);
 PROTOBUF_EXPORT void WriteLengthDelimited(uint32_t num, absl::string_view val,
@@ -243,6 +246,11 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
     }
     return ReadCordFallback(ptr, size, cord);
   }
+  // Like ReadCord, but copies the payload into `arena` if it was created with
+  // ArenaOptions::arena_owned_cords.
+  PROTOBUF_NODISCARD const char* ReadArenaCord(const char* ptr, int size,
+                                               ::absl::Cord* cord,
+                                               Arena* arena);
 
 
   template <typename Tag, typename T>
@@ -254,7 +262,15 @@ class PROTOBUF_EXPORT EpsCopyInputStream {
   PROTOBUF_NODISCARD const char* ReadPackedFixed(const char* ptr, int size,
                                                  RepeatedField<T>* out);
   template <typename Add>
-  PROTOBUF_NODISCARD const char* ReadPackedVarint(const char* ptr, Add add);
+  PROTOBUF_NODISCARD const char* ReadPackedVarint(const char* ptr, Add add) {
+    return ReadPackedVarint(ptr, add, [](int) {});
+  }
+  // As above, but calls `reserve(n)` before decoding each buffered part of the
+  // payload, with `n` the exact number of varints that part completes, so the
+  // caller can reserve its storage up front.
+  template <typename Add, typename Reserve>
+  PROTOBUF_NODISCARD const char* ReadPackedVarint(const char* ptr, Add add,
+                                                  Reserve reserve);
 
   uint32_t LastTag() const { return last_tag_minus_1_ + 1; }
   bool ConsumeEndGroup(uint32_t start_tag) {
@@ -477,9 +493,15 @@ class PROTOBUF_EXPORT ParseContext : public EpsCopyInputStream {
     MessageFactory* factory = nullptr;
   };
 
+  // Number of nested messages that TcParser parses by native recursion before
+  // it switches to an explicit, heap-allocated stack (see DeferredMessage).
+  static constexpr int kRecursiveParseDepth = 32;
+
   template <typename... T>
   ParseContext(int depth, bool aliasing, const char** start, T&&... args)
-      : EpsCopyInputStream(aliasing), depth_(depth) {
+      : EpsCopyInputStream(aliasing),
+        depth_(depth),
+        defer_depth_(depth - kRecursiveParseDepth) {
     *start = InitFrom(std::forward<T>(args)...);
   }
 
@@ -504,6 +526,7 @@ class PROTOBUF_EXPORT ParseContext : public EpsCopyInputStream {
   ParseContext Spawn(const char** start, T&&... args) {
     ParseContext spawned(depth_, false, start, std::forward<T>(args)...);
     // Transfer key context states.
+    spawned.defer_depth_ = defer_depth_;
     spawned.data_ = data_;
     return spawned;
   }
@@ -573,7 +596,82 @@ class PROTOBUF_EXPORT ParseContext : public EpsCopyInputStream {
     return ptr;
   }
 
+  // Explicit-stack parsing of deeply nested messages.
+  //
+  // Past kRecursiveParseDepth levels of nesting, the TcParser message field
+  // handlers do not recurse into the submessage. Instead they enter it (push
+  // its limit, or open the group) and hand it to the enclosing
+  // TcParser::ParseLoop as a DeferredMessage, which keeps the parent on a heap
+  // allocated stack and parses the child in the same native frame. The
+  // recursion limit still applies, but it is now bounded by memory rather
+  // than by the thread's stack.
+  //
+  // Only handlers that return straight to the parse loop after the submessage
+  // may use the *OrDefer variants.
+  struct DeferredMessage {
+    // Restores the parent's limit or group state; see EndDeferredMessage.
+    struct End {
+      LimitToken old_limit;
+      uint32_t group_tag;  // 0 for length-delimited submessages.
+    };
+    MessageLite* msg;
+    const TcParseTableBase* table;
+    End end;
+  };
+
+  template <typename TcParser>
+  PROTOBUF_NODISCARD PROTOBUF_ALWAYS_INLINE const char* ParseMessageOrDefer(
+      MessageLite* msg, const char* ptr, const TcParseTableBase* table) {
+    if (PROTOBUF_PREDICT_FALSE(depth_ <= defer_depth_)) {
+      return DeferMessage(msg, ptr, table);
+    }
+    return ParseMessage<TcParser>(msg, ptr, table);
+  }
+
+  template <typename TcParser>
+  PROTOBUF_NODISCARD PROTOBUF_ALWAYS_INLINE const char* ParseGroupOrDefer(
+      MessageLite* msg, const char* ptr, uint32_t tag,
+      const TcParseTableBase* table) {
+    if (PROTOBUF_PREDICT_FALSE(depth_ <= defer_depth_)) {
+      return DeferGroup(msg, ptr, tag, table);
+    }
+    return ParseGroup<TcParser>(msg, ptr, tag, table);
+  }
+
+  // True if the last field handler deferred a submessage. The parse loop
+  // stops on it like on an end-group tag.
+  bool HasDeferredMessage() const { return LastTag() == kDeferredMessageTag; }
+
+  DeferredMessage TakeDeferredMessage() {
+    ABSL_DCHECK(HasDeferredMessage());
+    SetLastTag(1);
+    return std::move(deferred_);
+  }
+
+  // Leaves a deferred submessage once its fields are parsed, mirroring the
+  // tail of ParseMessage/ParseGroup. Like them, it must also be called when
+  // parsing failed (ptr == nullptr) to keep the limits consistent.
+  PROTOBUF_NODISCARD const char* EndDeferredMessage(const char* ptr,
+                                                    DeferredMessage::End end);
+
+  // Set when a message parsed with this context may lack required fields, or
+  // when the parser cannot tell (see TcParseTableBase::required_fields_mask).
+  // If it stays unset, parsing into a cleared message produced an initialized
+  // message, and the post-parse IsInitialized() walk can be skipped.
+  void SetMaybeUninitialized() { maybe_uninitialized_ = true; }
+  bool MaybeUninitialized() const { return maybe_uninitialized_; }
+
  private:
+  // Field number 0 with an invalid wire type: never set from the wire.
+  static constexpr uint32_t kDeferredMessageTag = 7;
+
+  PROTOBUF_NODISCARD const char* DeferMessage(MessageLite* msg,
+                                              const char* ptr,
+                                              const TcParseTableBase* table);
+  PROTOBUF_NODISCARD const char* DeferGroup(MessageLite* msg, const char* ptr,
+                                            uint32_t tag,
+                                            const TcParseTableBase* table);
+
   // Out-of-line routine to save space in ParseContext::ParseMessage<T>
   //   LimitToken old;
   //   ptr = ReadSizeAndPushLimitAndDepth(ptr, &old)
@@ -599,6 +697,11 @@ class PROTOBUF_EXPORT ParseContext : public EpsCopyInputStream {
   // Unfortunately necessary for the fringe case of ending on 0 or end-group tag
   // in the last kSlopBytes of a ZeroCopyInputStream chunk.
   int group_depth_ = INT_MIN;
+  // Submessages entered at or below this depth are deferred to the parse loop
+  // instead of being parsed recursively.
+  int defer_depth_;
+  DeferredMessage deferred_;
+  bool maybe_uninitialized_ = false;
   Data data_;
 };
 
@@ -1197,6 +1300,13 @@ const char* EpsCopyInputStream::ReadPackedFixed(const char* ptr, int size,
                                                 RepeatedField<T>* out) {
   GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
   int nbytes = static_cast<int>(buffer_end_ + kSlopBytes - ptr);
+  if (size > nbytes && size <= BytesUntilLimit(ptr)) {
+    // The payload spans several buffers. Reserve all of it (up to a static safe
+    // size, as for strings) so that the chunked copies below never regrow and
+    // copy the field again.
+    out->Reserve(out->size() +
+                 std::min<int>(size, kSafeStringSize) / sizeof(T));
+  }
   while (size > nbytes) {
     int num = nbytes / sizeof(T);
     int old_entries = out->size();
@@ -1233,9 +1343,31 @@ const char* EpsCopyInputStream::ReadPackedFixed(const char* ptr, int size,
   return ptr;
 }
 
+// Returns the number of varints ending in [ptr, end), which is the number of
+// bytes without the continuation bit. Counts eight bytes at a time.
+inline int CountVarintEnds(const char* ptr, const char* end) {
+  constexpr uint64_t kContinuationBits = 0x8080808080808080;
+  int count = 0;
+  for (; end - ptr >= 8; ptr += 8) {
+    count += absl::popcount(~UnalignedLoad<uint64_t>(ptr) & kContinuationBits);
+  }
+  for (; ptr < end; ++ptr) count += static_cast<uint8_t>(*ptr) < 0x80;
+  return count;
+}
+
 template <typename Add>
 const char* ReadPackedVarintArray(const char* ptr, const char* end, Add add) {
   while (ptr < end) {
+    // Runs of single byte varints (small values, enums, bools) are common
+    // enough that checking eight at a time pays off.
+    if (end - ptr >= 8) {
+      uint64_t word = UnalignedLoad<uint64_t>(ptr);
+      if ((word & 0x8080808080808080) == 0) {
+        for (int i = 0; i < 8; ++i) add(static_cast<uint8_t>(ptr[i]));
+        ptr += 8;
+        continue;
+      }
+    }
     uint64_t varint;
     ptr = VarintParse(ptr, &varint);
     if (ptr == nullptr) return nullptr;
@@ -1244,12 +1376,18 @@ const char* ReadPackedVarintArray(const char* ptr, const char* end, Add add) {
   return ptr;
 }
 
-template <typename Add>
-const char* EpsCopyInputStream::ReadPackedVarint(const char* ptr, Add add) {
+template <typename Add, typename Reserve>
+const char* EpsCopyInputStream::ReadPackedVarint(const char* ptr, Add add,
+                                                 Reserve reserve) {
   int size = ReadSize(&ptr);
   GOOGLE_PROTOBUF_PARSER_ASSERT(ptr);
   int chunk_size = static_cast<int>(buffer_end_ - ptr);
   while (size > chunk_size) {
+    // A varint that starts before buffer_end_ is decoded from the slop bytes,
+    // so it is part of this chunk even though it ends past buffer_end_.
+    const bool straddles =
+        ptr < buffer_end_ && static_cast<uint8_t>(buffer_end_[-1]) >= 0x80;
+    reserve(CountVarintEnds(ptr, buffer_end_) + straddles);
     ptr = ReadPackedVarintArray(ptr, buffer_end_, add);
     if (ptr == nullptr) return nullptr;
     int overrun = static_cast<int>(ptr - buffer_end_);
@@ -1262,6 +1400,7 @@ const char* EpsCopyInputStream::ReadPackedVarint(const char* ptr, Add add) {
       std::memcpy(buf, buffer_end_, kSlopBytes);
       ABSL_CHECK_LE(size - chunk_size, kSlopBytes);
       auto end = buf + (size - chunk_size);
+      reserve(CountVarintEnds(buf + overrun, end));
       auto res = ReadPackedVarintArray(buf + overrun, end, add);
       if (res == nullptr || res != end) return nullptr;
       return buffer_end_ + (res - buf);
@@ -1276,6 +1415,7 @@ const char* EpsCopyInputStream::ReadPackedVarint(const char* ptr, Add add) {
     chunk_size = static_cast<int>(buffer_end_ - ptr);
   }
   auto end = ptr + size;
+  reserve(CountVarintEnds(ptr, end));
   ptr = ReadPackedVarintArray(ptr, end, add);
   return end == ptr ? ptr : nullptr;
 }
@@ -1417,6 +1557,9 @@ PROTOBUF_NODISCARD const char* PackedEnumParserArg(
 
 PROTOBUF_NODISCARD PROTOBUF_EXPORT const char* PackedBoolParser(
     void* object, const char* ptr, ParseContext* ctx);
+// Parses packed bools into a RepeatedBitField.
+PROTOBUF_NODISCARD PROTOBUF_EXPORT const char* PackedBitFieldParser(
+    void* object, const char* ptr, ParseContext* ctx);
 PROTOBUF_NODISCARD PROTOBUF_EXPORT const char* PackedFixed32Parser(
     void* object, const char* ptr, ParseContext* ctx);
 PROTOBUF_NODISCARD PROTOBUF_EXPORT const char* PackedSFixed32Parser(
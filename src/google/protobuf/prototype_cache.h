@@ -0,0 +1,149 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A map from message types to their prototypes that can be read without
+// taking a lock, for the MessageFactory implementations to put in front of
+// their mutex-guarded maps.
+
+#ifndef GOOGLE_PROTOBUF_PROTOTYPE_CACHE_H__
+#define GOOGLE_PROTOBUF_PROTOTYPE_CACHE_H__
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "absl/hash/hash.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+class Descriptor;
+class Message;
+
+namespace internal {
+
+// An insert-only open-addressing hash table from Descriptor to prototype.
+// Find() never locks and may run concurrently with Insert(), but calls to
+// Insert() must be serialized by the caller.  Only fully constructed
+// prototypes may be inserted, since readers use them as soon as they appear.
+// Tables outgrown by Insert() are kept until destruction, as readers may
+// still be probing them.
+class PrototypeCache {
+ public:
+  PrototypeCache() = default;
+  PrototypeCache(const PrototypeCache&) = delete;
+  PrototypeCache& operator=(const PrototypeCache&) = delete;
+  ~PrototypeCache() {
+    Table* table = table_.load(std::memory_order_relaxed);
+    while (table != nullptr) {
+      Table* previous = table->previous;
+      delete table;
+      table = previous;
+    }
+  }
+
+  // Returns the prototype inserted for `type`, or nullptr.
+  const Message* Find(const Descriptor* type) const {
+    const Table* table = table_.load(std::memory_order_acquire);
+    if (table == nullptr) return nullptr;
+    for (size_t i = Hash(type);; ++i) {
+      const Slot& slot = table->slots[i & table->mask];
+      const Descriptor* key = slot.key.load(std::memory_order_acquire);
+      if (key == type) return slot.value.load(std::memory_order_relaxed);
+      if (key == nullptr) return nullptr;
+    }
+  }
+
+  // Adds `prototype` for `type`, which must not be present yet.
+  void Insert(const Descriptor* type, const Message* prototype) {
+    Table* table = table_.load(std::memory_order_relaxed);
+    if (table == nullptr || 2 * (size_ + 1) > table->mask + 1) {
+      Table* grown = new Table(table == nullptr ? 16 : 2 * (table->mask + 1));
+      grown->previous = table;
+      for (size_t i = 0; table != nullptr && i <= table->mask; ++i) {
+        const Slot& slot = table->slots[i];
+        const Descriptor* key = slot.key.load(std::memory_order_relaxed);
+        if (key != nullptr) {
+          Place(grown, key, slot.value.load(std::memory_order_relaxed));
+        }
+      }
+      table_.store(grown, std::memory_order_release);
+      table = grown;
+    }
+    Place(table, type, prototype);
+    ++size_;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<const Descriptor*> key{nullptr};
+    std::atomic<const Message*> value{nullptr};
+  };
+  struct Table {
+    explicit Table(size_t capacity)
+        : mask(capacity - 1), slots(new Slot[capacity]) {}
+    const size_t mask;
+    const std::unique_ptr<Slot[]> slots;
+    Table* previous = nullptr;
+  };
+
+  static size_t Hash(const Descriptor* type) {
+    return absl::Hash<const Descriptor*>()(type);
+  }
+
+  // Stores the value before publishing the key, so that a reader that sees
+  // the key also sees the value.
+  static void Place(Table* table, const Descriptor* type,
+                    const Message* prototype) {
+    for (size_t i = Hash(type);; ++i) {
+      Slot& slot = table->slots[i & table->mask];
+      if (slot.key.load(std::memory_order_relaxed) == nullptr) {
+        slot.value.store(prototype, std::memory_order_relaxed);
+        slot.key.store(type, std::memory_order_release);
+        return;
+      }
+    }
+  }
+
+  std::atomic<Table*> table_{nullptr};
+  // Only accessed by Insert().
+  size_t size_ = 0;
+};
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_PROTOTYPE_CACHE_H__
@@ -41,6 +41,7 @@
 #include "absl/strings/str_cat.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/generated_message_tctable_impl.h"
 #include "google/protobuf/map_field.h"
 #include "google/protobuf/map_field_inl.h"
 #include "google/protobuf/unknown_field_set.h"
@@ -64,6 +65,25 @@ static const Reflection* GetReflectionOrDie(const Message& m) {
   return r;
 }
 
+static bool IsInitializedVisitor(MessageLite& sub_message) {
+  return sub_message.IsInitialized();
+}
+
+void ReflectionOps::ListFieldsOutsideTable(
+    const Reflection* reflection, const Message& message,
+    const TcParseTableBase** table,
+    std::vector<const FieldDescriptor*>* fields) {
+  *table = reflection->GetFieldsTable();
+  if (*table == nullptr) {
+    reflection->ListFields(message, fields);
+    return;
+  }
+  if (reflection->HasExtensionSet(message)) {
+    reflection->GetExtensionSet(message).AppendToList(
+        message.GetDescriptor(), reflection->descriptor_pool_, fields);
+  }
+}
+
 void ReflectionOps::Copy(const Message& from, Message* to) {
   if (&from == to) return;
   Clear(to);
@@ -104,6 +124,10 @@ void ReflectionOps::Merge(const Message& from, Message* to) {
           continue;
         }
       }
+      if (field->is_map()) {
+        MergeMapField(from, to, field);
+        continue;
+      }
       int count = from_reflection->FieldSize(from, field);
       for (int j = 0; j < count; j++) {
         switch (field->cpp_type()) {
@@ -178,6 +202,126 @@ void ReflectionOps::Merge(const Message& from, Message* to) {
   }
 }
 
+namespace {
+
+void SetMapValue(const FieldDescriptor* value_field, Message* entry,
+                 MapValueRef* value) {
+  const Reflection* reflection = entry->GetReflection();
+  switch (value_field->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, METHOD)                                         \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:                                   \
+    value->Set##METHOD##Value(reflection->Get##METHOD(*entry, value_field)); \
+    break;
+
+    HANDLE_TYPE(INT32, Int32);
+    HANDLE_TYPE(INT64, Int64);
+    HANDLE_TYPE(UINT32, UInt32);
+    HANDLE_TYPE(UINT64, UInt64);
+    HANDLE_TYPE(FLOAT, Float);
+    HANDLE_TYPE(DOUBLE, Double);
+    HANDLE_TYPE(BOOL, Bool);
+    HANDLE_TYPE(STRING, String);
+#undef HANDLE_TYPE
+
+    case FieldDescriptor::CPPTYPE_ENUM:
+      value->SetEnumValue(reflection->GetEnumValue(*entry, value_field));
+      break;
+    case FieldDescriptor::CPPTYPE_MESSAGE: {
+      Message* to = value->MutableMessageValue();
+      if (!reflection->HasField(*entry, value_field)) {
+        to->Clear();
+        break;
+      }
+      // The entry is given up by the caller, so its value is swapped into the
+      // map instead of copied.
+      Message* from = reflection->MutableMessage(entry, value_field);
+      if (from->GetReflection() == to->GetReflection()) {
+        to->GetReflection()->Swap(to, from);
+      } else {
+        to->CopyFrom(*from);
+      }
+      break;
+    }
+  }
+}
+
+void CopyMapValue(const FieldDescriptor* value_field,
+                  const MapValueRef& from, MapValueRef* to) {
+  switch (value_field->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, METHOD)                   \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:             \
+    to->Set##METHOD##Value(from.Get##METHOD##Value()); \
+    break;
+
+    HANDLE_TYPE(INT32, Int32);
+    HANDLE_TYPE(INT64, Int64);
+    HANDLE_TYPE(UINT32, UInt32);
+    HANDLE_TYPE(UINT64, UInt64);
+    HANDLE_TYPE(FLOAT, Float);
+    HANDLE_TYPE(DOUBLE, Double);
+    HANDLE_TYPE(BOOL, Bool);
+    HANDLE_TYPE(STRING, String);
+    HANDLE_TYPE(ENUM, Enum);
+#undef HANDLE_TYPE
+
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      to->MutableMessageValue()->CopyFrom(from.GetMessageValue());
+      break;
+  }
+}
+
+}  // namespace
+
+void ReflectionOps::InsertMapEntry(Message* message,
+                                   const FieldDescriptor* field,
+                                   Message* entry) {
+  const Reflection* entry_reflection = entry->GetReflection();
+  const FieldDescriptor* key_field = field->message_type()->map_key();
+  MapKey key;
+  switch (key_field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      key.SetInt32Value(entry_reflection->GetInt32(*entry, key_field));
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      key.SetInt64Value(entry_reflection->GetInt64(*entry, key_field));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      key.SetUInt32Value(entry_reflection->GetUInt32(*entry, key_field));
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      key.SetUInt64Value(entry_reflection->GetUInt64(*entry, key_field));
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      key.SetBoolValue(entry_reflection->GetBool(*entry, key_field));
+      break;
+    case FieldDescriptor::CPPTYPE_STRING:
+      key.SetStringValue(entry_reflection->GetString(*entry, key_field));
+      break;
+    default:
+      ABSL_LOG(FATAL) << "Invalid map key type: "
+                      << key_field->cpp_type_name();
+  }
+  MapValueRef value;
+  message->GetReflection()->InsertOrLookupMapValue(message, field, key,
+                                                   &value);
+  SetMapValue(field->message_type()->map_value(), entry, &value);
+}
+
+void ReflectionOps::MergeMapField(const Message& from, Message* to,
+                                  const FieldDescriptor* field) {
+  const Reflection* from_reflection = from.GetReflection();
+  const Reflection* to_reflection = to->GetReflection();
+  const FieldDescriptor* value_field = field->message_type()->map_value();
+  Message* mutable_from = const_cast<Message*>(&from);
+  for (MapIterator it = from_reflection->MapBegin(mutable_from, field),
+                   end = from_reflection->MapEnd(mutable_from, field);
+       it != end; ++it) {
+    MapValueRef value;
+    to_reflection->InsertOrLookupMapValue(to, field, it.GetKey(), &value);
+    CopyMapValue(value_field, it.GetValueRef(), &value);
+  }
+}
+
 void ReflectionOps::Clear(Message* message) {
   const Reflection* reflection = GetReflectionOrDie(*message);
 
@@ -210,7 +354,14 @@ bool ReflectionOps::IsInitialized(const Message& message, bool check_fields,
       }
     }
 
-    if (check_descendants) {
+    const TcParseTableBase* table =
+        check_descendants ? reflection->GetFieldsTable() : nullptr;
+    if (table != nullptr) {
+      if (!TcParser::VisitSubmessages(const_cast<Message*>(&message), table,
+                                      IsInitializedVisitor)) {
+        return false;
+      }
+    } else if (check_descendants) {
       for (const FieldDescriptor* field = begin; field != end; ++field) {
         if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
           const Descriptor* message_type = field->message_type();
@@ -283,9 +434,15 @@ bool ReflectionOps::IsInitialized(const Message& message) {
 
   // Check that sub-messages are initialized.
   std::vector<const FieldDescriptor*> fields;
+  const TcParseTableBase* table;
   // Should be safe to skip stripped fields because required fields are not
   // stripped.
-  reflection->ListFields(message, &fields);
+  ListFieldsOutsideTable(reflection, message, &table, &fields);
+  if (table != nullptr &&
+      !TcParser::VisitSubmessages(const_cast<Message*>(&message), table,
+                                  IsInitializedVisitor)) {
+    return false;
+  }
   for (const FieldDescriptor* field : fields) {
     if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
 
@@ -343,7 +500,14 @@ void ReflectionOps::DiscardUnknownFields(Message* message) {
   // Walk through the fields of this message and DiscardUnknownFields on any
   // messages present.
   std::vector<const FieldDescriptor*> fields;
-  reflection->ListFields(*message, &fields);
+  const TcParseTableBase* table;
+  ListFieldsOutsideTable(reflection, *message, &table, &fields);
+  if (table != nullptr) {
+    TcParser::VisitSubmessages(message, table, [](MessageLite& sub_message) {
+      static_cast<Message&>(sub_message).DiscardUnknownFields();
+      return true;
+    });
+  }
   for (const FieldDescriptor* field : fields) {
     // Skip over non-message fields.
     if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
@@ -79,6 +79,31 @@ class PROTOBUF_EXPORT ReflectionOps {
   static void FindInitializationErrors(const Message& message,
                                        const std::string& prefix,
                                        std::vector<std::string>* errors);
+
+  // Stores the key and value of `entry`, a message of the entry type of map
+  // `field`, in that map of `message`, replacing the value of an equal key.
+  // A message value is swapped out of `entry` rather than copied, so `entry`
+  // is left unspecified. Unlike AddMessage(), this writes to the map itself
+  // and leaves its repeated-field mirror alone, so readers of the map don't
+  // have to rebuild it.
+  static void InsertMapEntry(Message* message, const FieldDescriptor* field,
+                             Message* entry);
+
+ private:
+  // Merges map `field` of `from` into `to` entry by entry, for maps that
+  // cannot be merged wholesale.
+  static void MergeMapField(const Message& from, Message* to,
+                            const FieldDescriptor* field);
+
+  // Lists the set fields of `message` that must be handled through
+  // reflection.  If the reflection parse table can be walked, `*table` is set
+  // to it and only extensions are listed: the caller walks the regular fields
+  // with TcParser::VisitSubmessages().  Otherwise `*table` is null and this
+  // is ListFields().
+  static void ListFieldsOutsideTable(
+      const Reflection* reflection, const Message& message,
+      const TcParseTableBase** table,
+      std::vector<const FieldDescriptor*>* fields);
 };
 
 }  // namespace internal
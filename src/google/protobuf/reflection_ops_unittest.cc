@@ -297,6 +297,17 @@ TEST(ReflectionOpsTest, DiscardUnknownFields) {
             message.repeated_nested_message(0).unknown_fields().field_count());
 }
 
+TEST(ReflectionOpsTest, DiscardUnknownFieldsInOneof) {
+  unittest::TestAllTypes message;
+  message.mutable_oneof_nested_message()->mutable_unknown_fields()->AddVarint(
+      123456, 654321);
+  EXPECT_EQ(1, message.oneof_nested_message().unknown_fields().field_count());
+
+  ReflectionOps::DiscardUnknownFields(&message);
+  EXPECT_TRUE(message.has_oneof_nested_message());
+  EXPECT_EQ(0, message.oneof_nested_message().unknown_fields().field_count());
+}
+
 TEST(ReflectionOpsTest, DiscardUnknownExtensions) {
   unittest::TestAllExtensions message;
   TestUtil::SetAllExtensions(&message);
@@ -1293,6 +1293,24 @@ void MapReflectionTester::ExpectMapFieldsSetViaReflection(
         EXPECT_EQ(map_value_const_ref.GetStringValue(), vals[i]);
       }
     }
+    if (!reflection
+             ->GetRaw<internal::MapFieldBase>(message, F("map_string_string"))
+             .IsRepeatedFieldValid()) {
+      // Check the batched lookup, including a missing key.
+      MapKey batch_keys[3];
+      batch_keys[0].SetStringValue(keys[1]);
+      batch_keys[1].SetStringValue("missing");
+      batch_keys[2].SetStringValue(keys[0]);
+      MapValueConstRef batch_vals[3];
+      bool found[3];
+      reflection->LookupMapValues(message, F("map_string_string"), batch_keys,
+                                  3, batch_vals, found);
+      EXPECT_TRUE(found[0]);
+      EXPECT_EQ(batch_vals[0].GetStringValue(), vals[1]);
+      EXPECT_FALSE(found[1]);
+      EXPECT_TRUE(found[2]);
+      EXPECT_EQ(batch_vals[2].GetStringValue(), vals[0]);
+    }
   }
   {
     absl::flat_hash_map<int32_t, std::string> map;
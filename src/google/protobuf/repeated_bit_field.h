@@ -0,0 +1,208 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// RepeatedBitField stores a repeated bool field as a bitset, one bit per
+// element instead of one byte. The C++ generator uses it for the fields named
+// in its bitpacked_fields option. It has the parts of the RepeatedField<bool>
+// interface that do not hand out references to elements, so there is no
+// mutable_data(), no iterators and no element pointers.
+
+#ifndef GOOGLE_PROTOBUF_REPEATED_BIT_FIELD_H__
+#define GOOGLE_PROTOBUF_REPEATED_BIT_FIELD_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "absl/log/absl_check.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/port.h"
+#include "google/protobuf/repeated_field.h"
+#include "google/protobuf/wire_format_lite.h"
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+class RepeatedBitField final {
+ public:
+  constexpr RepeatedBitField() : words_(), size_(0) {}
+  explicit RepeatedBitField(Arena* arena) : words_(arena), size_(0) {}
+  RepeatedBitField(const RepeatedBitField& other)
+      : words_(other.words_), size_(other.size_) {}
+  RepeatedBitField& operator=(const RepeatedBitField& other) {
+    CopyFrom(other);
+    return *this;
+  }
+  ~RepeatedBitField() = default;
+
+  bool empty() const { return size_ == 0; }
+  int size() const { return size_; }
+
+  bool Get(int index) const {
+    ABSL_DCHECK_GE(index, 0);
+    ABSL_DCHECK_LT(index, size_);
+    return (words_.Get(index / kBitsPerWord) >> (index % kBitsPerWord)) & 1;
+  }
+  bool operator[](int index) const { return Get(index); }
+
+  void Set(int index, bool value) {
+    ABSL_DCHECK_GE(index, 0);
+    ABSL_DCHECK_LT(index, size_);
+    uint64_t& word = words_[index / kBitsPerWord];
+    const uint64_t bit = uint64_t{1} << (index % kBitsPerWord);
+    word = value ? word | bit : word & ~bit;
+  }
+
+  void Add(bool value) {
+    // Bits past the end are always zero, so only set bits need writing.
+    if (size_ % kBitsPerWord == 0) words_.Add(0);
+    if (value) {
+      words_[size_ / kBitsPerWord] |= uint64_t{1} << (size_ % kBitsPerWord);
+    }
+    ++size_;
+  }
+
+  void RemoveLast() {
+    ABSL_DCHECK_GT(size_, 0);
+    Truncate(size_ - 1);
+  }
+
+  void Truncate(int new_size) {
+    ABSL_DCHECK_GE(new_size, 0);
+    ABSL_DCHECK_LE(new_size, size_);
+    size_ = new_size;
+    words_.Truncate(WordsFor(new_size));
+    if (new_size % kBitsPerWord != 0) {
+      words_[new_size / kBitsPerWord] &=
+          (uint64_t{1} << (new_size % kBitsPerWord)) - 1;
+    }
+  }
+
+  void Clear() {
+    words_.Clear();
+    size_ = 0;
+  }
+
+  // Reserves space for `new_size` elements in total.
+  void Reserve(int new_size) { words_.Reserve(WordsFor(new_size)); }
+
+  // Appends the elements of `other`, whole words at a time when this field
+  // ends on a word boundary.
+  void MergeFrom(const RepeatedBitField& other) {
+    ABSL_DCHECK_NE(&other, this);
+    if (size_ % kBitsPerWord == 0) {
+      words_.MergeFrom(other.words_);
+      size_ += other.size_;
+      return;
+    }
+    Reserve(size_ + other.size_);
+    for (int i = 0; i < other.size_; ++i) Add(other.Get(i));
+  }
+
+  void CopyFrom(const RepeatedBitField& other) {
+    if (&other == this) return;
+    Clear();
+    MergeFrom(other);
+  }
+
+  void Swap(RepeatedBitField* other) {
+    if (this == other) return;
+    words_.Swap(&other->words_);
+    std::swap(size_, other->size_);
+  }
+
+  Arena* GetArena() { return words_.GetArena(); }
+
+  size_t SpaceUsedExcludingSelfLong() const {
+    return words_.SpaceUsedExcludingSelfLong();
+  }
+
+  // Writes the elements as a packed field: the tag, the length and one
+  // single-byte varint per element, written straight from the bits.
+  uint8_t* InternalWritePacked(int field_number, uint8_t* target,
+                               io::EpsCopyOutputStream* stream) const {
+    target = stream->EnsureSpace(target);
+    target = internal::WireFormatLite::WriteTagToArray(
+        field_number, internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+        target);
+    target = io::CodedOutputStream::WriteVarint32ToArray(
+        static_cast<uint32_t>(size_), target);
+    // EnsureSpace leaves room for kSlopBytes, which divides a word, so each
+    // chunk comes from a single word.
+    constexpr int kChunk = io::EpsCopyOutputStream::kSlopBytes;
+    static_assert(kBitsPerWord % kChunk == 0, "");
+    for (int i = 0; i < size_;) {
+      target = stream->EnsureSpace(target);
+      const int end = std::min(size_, i + kChunk);
+      uint64_t word = words_.Get(i / kBitsPerWord) >> (i % kBitsPerWord);
+      for (; i < end; ++i, word >>= 1) {
+        *target++ = static_cast<uint8_t>(word & 1);
+      }
+    }
+    return target;
+  }
+
+  // For generated code only.
+  void InternalSwap(RepeatedBitField* other) {
+    words_.InternalSwap(&other->words_);
+    std::swap(size_, other->size_);
+  }
+
+ private:
+  friend class Arena;
+  typedef void InternalArenaConstructable_;
+  // The words live on the arena too, so there is nothing to destroy.
+  typedef void DestructorSkippable_;
+
+  static constexpr int kBitsPerWord = 64;
+
+  static int WordsFor(int size) {
+    return (size + kBitsPerWord - 1) / kBitsPerWord;
+  }
+
+  RepeatedField<uint64_t> words_;
+  int size_;
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_REPEATED_BIT_FIELD_H__
@@ -58,6 +58,7 @@
 #include "absl/log/absl_check.h"
 #include "absl/meta/type_traits.h"
 #include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/generated_enum_util.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/port.h"
@@ -242,6 +243,10 @@ class RepeatedField final
   // array is grown, it will always be at least doubled in size.
   void Reserve(int new_size);
 
+  // Reallocates the array to fit size(), or frees it if the field is empty.
+  // On an arena the old array is returned to the arena for reuse.
+  void ShrinkToFit();
+
   // Resizes the RepeatedField to a new, smaller size.  This is O(1).
   // Except for RepeatedField<Cord>, for which it is O(size-new_size).
   void Truncate(int new_size);
@@ -309,6 +314,9 @@ class RepeatedField final
     return internal::ToIntSize(SpaceUsedExcludingSelfLong());
   }
 
+  // Returns the part of SpaceUsedExcludingSelfLong() taken by unused capacity.
+  size_t SpaceRetainedLong() const;
+
   // Removes the element referenced by position.
   //
   // Returns an iterator to the element immediately following the removed
@@ -913,6 +921,11 @@ inline size_t RepeatedField<Element>::SpaceUsedExcludingSelfLong() const {
   return total_size_ > 0 ? (total_size_ * sizeof(Element) + kRepHeaderSize) : 0;
 }
 
+template <typename Element>
+inline size_t RepeatedField<Element>::SpaceRetainedLong() const {
+  return total_size_ > 0 ? (total_size_ - current_size_) * sizeof(Element) : 0;
+}
+
 namespace internal {
 // Returns the new size for a reserved field based on its 'total_size' and the
 // requested 'new_size'. The result is clamped to the closed interval:
@@ -978,6 +991,8 @@ PROTOBUF_NOINLINE void RepeatedField<Element>::GrowNoAnnotate(int current_size,
     new_size = static_cast<int>(num_available);
     new_rep = static_cast<Rep*>(res.p);
   } else {
+    arena->RecordTypeAllocation(
+        [] { return absl::string_view("RepeatedField"); }, bytes);
     new_rep = reinterpret_cast<Rep*>(Arena::CreateArray<char>(arena, bytes));
   }
   new_rep->arena = arena;
@@ -1003,6 +1018,43 @@ PROTOBUF_NOINLINE void RepeatedField<Element>::GrowNoAnnotate(int current_size,
   arena_or_elements_ = new_rep->elements();
 }
 
+template <typename Element>
+PROTOBUF_NOINLINE void RepeatedField<Element>::ShrinkToFit() {
+  if (total_size_ == 0) return;
+  const int size = current_size_;
+  Arena* arena = GetOwningArena();
+  if (size > 0 &&
+      internal::CalculateReserveSize<Element, kRepHeaderSize>(0, size) >=
+          total_size_) {
+    // A fresh array would not be any smaller.
+    return;
+  }
+  AnnotateSize(size, total_size_);
+  Rep* old_rep = rep();
+  const size_t old_bytes = total_size_ * sizeof(Element) + kRepHeaderSize;
+  total_size_ = 0;
+  arena_or_elements_ = arena;
+  if (size > 0) {
+    GrowNoAnnotate(0, size);
+    Element* pnew = unsafe_elements();
+    Element* pold = old_rep->elements();
+    if (std::is_trivial<Element>::value) {
+      memcpy(static_cast<void*>(pnew), pold, size * sizeof(Element));
+    } else {
+      for (Element* end = pnew + size; pnew != end; ++pnew, ++pold) {
+        ::new (static_cast<void*>(pnew)) Element(std::move(*pold));
+        pold->~Element();
+      }
+    }
+  }
+  if (arena == nullptr) {
+    internal::SizedDelete(old_rep, old_bytes);
+  } else {
+    arena->ReturnArrayMemory(old_rep, old_bytes);
+  }
+  AnnotateSize(Capacity(), size);
+}
+
 // TODO(b/266411038): we should really be able to make this:
 // template <bool annotate_size = true>
 // void Grow();
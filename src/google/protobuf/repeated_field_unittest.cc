@@ -62,6 +62,7 @@
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/parse_context.h"
+#include "google/protobuf/repeated_bit_field.h"
 #include "google/protobuf/repeated_field.h"
 #include "google/protobuf/repeated_ptr_field.h"
 #include "google/protobuf/unittest.pb.h"
@@ -511,6 +512,55 @@ TEST(RepeatedField, ReserveHuge) {
 #endif  // PROTOBUF_TEST_ALLOW_LARGE_ALLOC
 }
 
+TEST(RepeatedField, ShrinkToFit) {
+  RepeatedField<int> field;
+  for (int i = 0; i < 1000; ++i) field.Add(i);
+  field.Truncate(10);
+  EXPECT_EQ(field.SpaceRetainedLong(),
+            (field.Capacity() - field.size()) * sizeof(int));
+
+  field.ShrinkToFit();
+  EXPECT_GE(field.Capacity(), 10);
+  EXPECT_LT(field.Capacity(), 1000);
+  EXPECT_THAT(field, ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+
+  // Shrinking again is a no-op.
+  const int* data = field.data();
+  field.ShrinkToFit();
+  EXPECT_EQ(field.data(), data);
+
+  field.Clear();
+  field.ShrinkToFit();
+  EXPECT_EQ(field.Capacity(), 0);
+  EXPECT_EQ(field.SpaceUsedExcludingSelfLong(), 0);
+  EXPECT_EQ(field.SpaceRetainedLong(), 0);
+  field.Add(1);
+  EXPECT_THAT(field, ElementsAre(1));
+}
+
+TEST(RepeatedField, ShrinkToFitOnArena) {
+  Arena arena;
+  auto* field = Arena::CreateMessage<RepeatedField<int64_t>>(&arena);
+  for (int i = 0; i < 1000; ++i) field->Add(i);
+  field->Truncate(3);
+  field->ShrinkToFit();
+  EXPECT_LT(field->Capacity(), 1000);
+  EXPECT_THAT(*field, ElementsAre(0, 1, 2));
+
+  field->Clear();
+  field->ShrinkToFit();
+  EXPECT_EQ(field->Capacity(), 0);
+}
+
+TEST(RepeatedField, ShrinkToFitMovesNonTrivialElements) {
+  RepeatedField<absl::Cord> field;
+  for (int i = 0; i < 100; ++i) field.Add(absl::Cord(absl::StrCat(i)));
+  field.Truncate(2);
+  field.ShrinkToFit();
+  EXPECT_LT(field.Capacity(), 100);
+  EXPECT_THAT(field, ElementsAre("0", "1"));
+}
+
 TEST(RepeatedField, MergeFrom) {
   RepeatedField<int> source, destination;
   source.Add(4);
@@ -1235,6 +1285,100 @@ TEST(RepeatedField, Cleanups) {
   EXPECT_THAT(growth.cleanups, testing::UnorderedElementsAre(ptr));
 }
 
+// ===================================================================
+// RepeatedBitField tests.
+
+TEST(RepeatedBitField, AddSetTruncate) {
+  RepeatedBitField field;
+  EXPECT_TRUE(field.empty());
+  for (int i = 0; i < 130; ++i) field.Add(i % 3 == 0);
+  ASSERT_EQ(field.size(), 130);
+  for (int i = 0; i < 130; ++i) EXPECT_EQ(field.Get(i), i % 3 == 0) << i;
+
+  field.Set(64, true);
+  field.Set(0, false);
+  EXPECT_TRUE(field.Get(64));
+  EXPECT_FALSE(field.Get(0));
+
+  // Bits past the new size must not come back when the field grows again.
+  field.Truncate(65);
+  EXPECT_EQ(field.size(), 65);
+  field.Add(false);
+  field.Add(false);
+  EXPECT_TRUE(field.Get(64));
+  EXPECT_FALSE(field.Get(65));
+  EXPECT_FALSE(field.Get(66));
+
+  field.RemoveLast();
+  EXPECT_EQ(field.size(), 66);
+  field.Clear();
+  EXPECT_TRUE(field.empty());
+}
+
+TEST(RepeatedBitField, MergeAndCopy) {
+  RepeatedBitField a;
+  RepeatedBitField b;
+  for (int i = 0; i < 5; ++i) a.Add(i % 2 == 0);
+  for (int i = 0; i < 70; ++i) b.Add(i % 7 == 0);
+
+  RepeatedBitField merged(a);
+  merged.MergeFrom(b);
+  ASSERT_EQ(merged.size(), 75);
+  for (int i = 0; i < 5; ++i) EXPECT_EQ(merged.Get(i), i % 2 == 0) << i;
+  for (int i = 0; i < 70; ++i) EXPECT_EQ(merged.Get(5 + i), i % 7 == 0) << i;
+
+  RepeatedBitField copy;
+  copy = b;
+  copy.MergeFrom(a);
+  ASSERT_EQ(copy.size(), 75);
+  EXPECT_TRUE(copy.Get(63));
+  EXPECT_TRUE(copy.Get(70));
+  EXPECT_FALSE(copy.Get(71));
+
+  copy.Swap(&a);
+  EXPECT_EQ(copy.size(), 5);
+  EXPECT_EQ(a.size(), 75);
+}
+
+TEST(RepeatedBitField, OnArena) {
+  Arena arena;
+  auto* field = Arena::CreateMessage<RepeatedBitField>(&arena);
+  EXPECT_EQ(field->GetArena(), &arena);
+  for (int i = 0; i < 200; ++i) field->Add(true);
+  EXPECT_EQ(field->size(), 200);
+  EXPECT_TRUE(field->Get(199));
+}
+
+TEST(RepeatedBitField, PackedRoundTrip) {
+  RepeatedBitField field;
+  std::string expected = "\x0a";
+  expected.push_back(100);
+  for (int i = 0; i < 100; ++i) {
+    field.Add(i % 5 == 1);
+    expected.push_back(i % 5 == 1 ? 1 : 0);
+  }
+
+  std::string serialized;
+  {
+    io::StringOutputStream string_stream(&serialized);
+    io::CodedOutputStream output(&string_stream);
+    uint8_t* target = output.Cur();
+    target = field.InternalWritePacked(1, target, output.EpsCopy());
+    output.SetCur(target);
+  }
+  EXPECT_EQ(serialized, expected);
+
+  RepeatedBitField parsed;
+  absl::string_view payload(serialized);
+  payload.remove_prefix(1);  // The tag.
+  const char* ptr;
+  internal::ParseContext ctx(64, false, &ptr, payload);
+  ptr = internal::PackedBitFieldParser(&parsed, ptr, &ctx);
+  ASSERT_NE(ptr, nullptr);
+  ASSERT_EQ(parsed.size(), 100);
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(parsed.Get(i), i % 5 == 1) << i;
+}
+
 // ===================================================================
 // RepeatedPtrField tests.  These pretty much just mirror the RepeatedField
 // tests above.
@@ -1590,6 +1734,130 @@ TEST(RepeatedPtrField, ClearedElements) {
   PROTOBUF_IGNORE_DEPRECATION_STOP
 }
 
+TEST(RepeatedPtrField, TrimCleared) {
+  PROTOBUF_IGNORE_DEPRECATION_START
+  RepeatedPtrField<std::string> field;
+  for (int i = 0; i < 10; ++i) field.Add()->assign(100, 'x');
+  const std::string* first = &field.Get(0);
+  field.Clear();
+  EXPECT_EQ(field.ClearedCount(), 10);
+  const size_t retained = field.SpaceRetainedLong();
+  EXPECT_GE(retained, 10 * sizeof(std::string));
+
+  field.TrimCleared(3);
+  EXPECT_EQ(field.ClearedCount(), 3);
+  EXPECT_LT(field.SpaceRetainedLong(), retained);
+  // The oldest cleared objects are the ones kept.
+  EXPECT_EQ(field.Add(), first);
+
+  field.TrimCleared(5);
+  EXPECT_EQ(field.ClearedCount(), 2);
+  PROTOBUF_IGNORE_DEPRECATION_STOP
+}
+
+TEST(RepeatedPtrField, ShrinkToFit) {
+  PROTOBUF_IGNORE_DEPRECATION_START
+  RepeatedPtrField<std::string> field;
+  for (int i = 0; i < 100; ++i) field.Add(absl::StrCat(i));
+  while (field.size() > 2) field.RemoveLast();
+
+  field.ShrinkToFit();
+  EXPECT_EQ(field.ClearedCount(), 0);
+  EXPECT_LT(field.Capacity(), 100);
+  EXPECT_THAT(field, ElementsAre("0", "1"));
+  EXPECT_EQ(field.SpaceRetainedLong(),
+            (field.Capacity() - field.size()) * sizeof(std::string*));
+
+  field.Clear();
+  field.ShrinkToFit();
+  EXPECT_EQ(field.Capacity(), 0);
+  EXPECT_EQ(field.SpaceUsedExcludingSelfLong(), 0);
+  EXPECT_EQ(field.SpaceRetainedLong(), 0);
+  field.Add("again");
+  EXPECT_THAT(field, ElementsAre("again"));
+  PROTOBUF_IGNORE_DEPRECATION_STOP
+}
+
+TEST(RepeatedPtrField, ShrinkToFitOnArena) {
+  PROTOBUF_IGNORE_DEPRECATION_START
+  Arena arena;
+  auto* field = Arena::CreateMessage<RepeatedPtrField<TestAllTypes>>(&arena);
+  for (int i = 0; i < 100; ++i) field->Add()->set_optional_int32(i);
+  field->Clear();
+  field->Add()->set_optional_int32(7);
+
+  field->ShrinkToFit();
+  EXPECT_EQ(field->ClearedCount(), 0);
+  EXPECT_LT(field->Capacity(), 100);
+  ASSERT_EQ(field->size(), 1);
+  EXPECT_EQ(field->Get(0).optional_int32(), 7);
+  EXPECT_EQ(field->Get(0).GetArena(), &arena);
+  PROTOBUF_IGNORE_DEPRECATION_STOP
+}
+
+TEST(RepeatedPtrField, PreallocateElementsOnArena) {
+  PROTOBUF_IGNORE_DEPRECATION_START
+  Arena arena;
+  auto* field = Arena::CreateMessage<RepeatedPtrField<TestAllTypes>>(&arena);
+  field->Add()->set_optional_int32(1);
+  field->PreallocateElements(10);
+  EXPECT_EQ(field->ClearedCount(), 10);
+  EXPECT_GE(field->Capacity(), 11);
+
+  const size_t space_used = arena.SpaceUsed();
+  std::vector<TestAllTypes*> added;
+  for (int i = 0; i < 10; ++i) added.push_back(field->Add());
+  EXPECT_EQ(arena.SpaceUsed(), space_used);
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_EQ(reinterpret_cast<char*>(added[i]),
+              reinterpret_cast<char*>(added[i - 1]) + sizeof(TestAllTypes));
+    EXPECT_EQ(added[i]->GetArena(), &arena);
+  }
+
+  // Existing cleared objects count towards `n`.
+  field->RemoveLast();
+  field->PreallocateElements(3);
+  EXPECT_EQ(field->ClearedCount(), 3);
+  PROTOBUF_IGNORE_DEPRECATION_STOP
+}
+
+TEST(RepeatedPtrField, PreallocateElementsOnHeap) {
+  PROTOBUF_IGNORE_DEPRECATION_START
+  RepeatedPtrField<std::string> field;
+  field.PreallocateElements(10);
+  EXPECT_EQ(field.ClearedCount(), 0);
+  EXPECT_GE(field.Capacity(), 10);
+  PROTOBUF_IGNORE_DEPRECATION_STOP
+}
+
+TEST(RepeatedPtrField, PreallocateStringsOnArena) {
+  Arena arena;
+  auto* field = Arena::CreateMessage<RepeatedPtrField<std::string>>(&arena);
+  field->PreallocateElements(4);
+  for (int i = 0; i < 4; ++i) field->Add()->assign(absl::StrCat(i));
+  EXPECT_THAT(*field, ElementsAre("0", "1", "2", "3"));
+}
+
+TEST(RepeatedPtrField, PreallocatedElementsAreUsedByParsing) {
+  TestAllTypes source;
+  for (int i = 0; i < 8; ++i) {
+    source.add_repeated_nested_message()->set_bb(i);
+  }
+  const std::string data = source.SerializeAsString();
+
+  Arena arena;
+  auto* message = Arena::CreateMessage<TestAllTypes>(&arena);
+  message->mutable_repeated_nested_message()->PreallocateElements(8);
+  const auto* first = message->add_repeated_nested_message();
+  message->mutable_repeated_nested_message()->RemoveLast();
+  ASSERT_TRUE(message->ParseFromString(data));
+  ASSERT_EQ(message->repeated_nested_message_size(), 8);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(message->repeated_nested_message(i).bb(), i);
+    EXPECT_EQ(&message->repeated_nested_message(i), first + i);
+  }
+}
+
 // Test all code paths in AddAllocated().
 TEST(RepeatedPtrField, AddAllocated) {
   RepeatedPtrField<std::string> field;
@@ -1661,6 +1929,61 @@ TEST(RepeatedPtrField, MergeFrom) {
   EXPECT_EQ("5", destination.Get(4));
 }
 
+TEST(RepeatedPtrField, MergeFromRvalueStealsElements) {
+  RepeatedPtrField<std::string> source, destination;
+  source.Add()->assign("3");
+  source.Add()->assign("4");
+  destination.Add()->assign("1");
+  destination.Add()->assign("2");
+  destination.Add()->assign("cleared");
+  destination.RemoveLast();
+  const std::string* stolen = &source.Get(0);
+
+  destination.MergeFrom(std::move(source));
+
+  ASSERT_EQ(4, destination.size());
+  EXPECT_EQ("1", destination.Get(0));
+  EXPECT_EQ("2", destination.Get(1));
+  EXPECT_EQ(stolen, &destination.Get(2));
+  EXPECT_EQ("4", destination.Get(3));
+  EXPECT_EQ(1, destination.ClearedCount());
+  EXPECT_TRUE(source.empty());
+}
+
+TEST(RepeatedPtrField, MergeFromRvalueIntoEmpty) {
+  Arena arena;
+  auto* source = Arena::CreateMessage<RepeatedPtrField<TestAllTypes>>(&arena);
+  auto* destination =
+      Arena::CreateMessage<RepeatedPtrField<TestAllTypes>>(&arena);
+  source->Add()->set_optional_int32(1);
+  source->Add()->set_optional_int32(2);
+  const TestAllTypes* stolen = &source->Get(1);
+
+  destination->MergeFrom(std::move(*source));
+
+  ASSERT_EQ(2, destination->size());
+  EXPECT_EQ(1, destination->Get(0).optional_int32());
+  EXPECT_EQ(stolen, &destination->Get(1));
+  EXPECT_TRUE(source->empty());
+}
+
+TEST(RepeatedPtrField, MergeFromRvalueAcrossArenasCopies) {
+  Arena arena;
+  RepeatedPtrField<std::string> source;
+  auto* destination =
+      Arena::CreateMessage<RepeatedPtrField<std::string>>(&arena);
+  destination->Add()->assign("1");
+  source.Add()->assign("2");
+  const std::string* original = &source.Get(0);
+
+  destination->MergeFrom(std::move(source));
+
+  ASSERT_EQ(2, destination->size());
+  EXPECT_EQ("2", destination->Get(1));
+  EXPECT_NE(original, &destination->Get(1));
+  EXPECT_TRUE(source.empty());
+}
+
 
 TEST(RepeatedPtrField, CopyFrom) {
   RepeatedPtrField<std::string> source, destination;
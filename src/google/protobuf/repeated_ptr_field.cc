@@ -35,6 +35,7 @@
 #include <algorithm>
 
 #include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/implicit_weak_message.h"
 #include "google/protobuf/port.h"
 #include "google/protobuf/repeated_field.h"
@@ -69,6 +70,8 @@ void** RepeatedPtrFieldBase::InternalExtend(int extend_amount) {
     new_size = (res.n - kRepHeaderSize) / sizeof(old_rep->elements[0]);
     rep_ = reinterpret_cast<Rep*>(res.p);
   } else {
+    arena->RecordTypeAllocation(
+        [] { return absl::string_view("RepeatedPtrField"); }, bytes);
     rep_ = reinterpret_cast<Rep*>(Arena::CreateArray<char>(arena, bytes));
   }
   const int old_total_size = total_size_;
@@ -99,6 +102,66 @@ void RepeatedPtrFieldBase::Reserve(int new_size) {
   }
 }
 
+void RepeatedPtrFieldBase::ShrinkRepToFit() {
+  ABSL_DCHECK_EQ(ClearedCount(), 0);
+  const int size = current_size_;
+  if (rep_ == nullptr || total_size_ == size) return;
+  if (size > 0 &&
+      internal::CalculateReserveSize<void*, kRepHeaderSize>(0, size) >=
+          total_size_) {
+    // A fresh array would not be any smaller.
+    return;
+  }
+  Rep* old_rep = rep_;
+  const size_t old_bytes =
+      total_size_ * sizeof(old_rep->elements[0]) + kRepHeaderSize;
+  rep_ = nullptr;
+  total_size_ = 0;
+  if (size > 0) {
+    ExchangeCurrentSize(0);
+    InternalExtend(size);
+    memcpy(rep_->elements, old_rep->elements,
+           size * sizeof(rep_->elements[0]));
+    rep_->allocated_size = size;
+    ExchangeCurrentSize(size);
+  }
+  if (arena_ == nullptr) {
+    internal::SizedDelete(old_rep, old_bytes);
+  } else {
+    arena_->ReturnArrayMemory(old_rep, old_bytes);
+  }
+}
+
+void RepeatedPtrFieldBase::StealElementsFrom(RepeatedPtrFieldBase* other) {
+  ABSL_DCHECK_NE(other, this);
+  ABSL_DCHECK_EQ(arena_, other->arena_);
+  const int n = other->current_size_;
+  if (n == 0) return;
+  if (rep_ == nullptr || rep_->allocated_size == 0) {
+    // Nothing of ours to keep, so just take the whole array, along with
+    // any cleared objects of `other`.
+    InternalSwap(other);
+    return;
+  }
+  // Make room for the new elements and keep our cleared objects after them.
+  const int cleared = rep_->allocated_size - current_size_;
+  Reserve(rep_->allocated_size + n);
+  void** elements = rep_->elements;
+  memmove(elements + current_size_ + n, elements + current_size_,
+          cleared * sizeof(elements[0]));
+  memcpy(elements + current_size_, other->rep_->elements,
+         n * sizeof(elements[0]));
+  rep_->allocated_size += n;
+  ExchangeCurrentSize(current_size_ + n);
+
+  Rep* other_rep = other->rep_;
+  const int other_cleared = other_rep->allocated_size - n;
+  memmove(other_rep->elements, other_rep->elements + n,
+          other_cleared * sizeof(other_rep->elements[0]));
+  other_rep->allocated_size = other_cleared;
+  other->ExchangeCurrentSize(0);
+}
+
 void RepeatedPtrFieldBase::DestroyProtos() {
   ABSL_DCHECK(rep_);
   ABSL_DCHECK(arena_ == nullptr);
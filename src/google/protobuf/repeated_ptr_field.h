@@ -302,6 +302,11 @@ class PROTOBUF_EXPORT RepeatedPtrFieldBase {
                       &RepeatedPtrFieldBase::MergeFromInnerLoop<TypeHandler>);
   }
 
+  // Appends the elements of `other` by taking their pointers rather than
+  // copying them. Both fields must be on the same arena (or both on the
+  // heap). `other` is left empty.
+  void StealElementsFrom(RepeatedPtrFieldBase* other);
+
   inline void InternalSwap(RepeatedPtrFieldBase* rhs) {
     ABSL_DCHECK(this != rhs);
 
@@ -496,6 +501,54 @@ class PROTOBUF_EXPORT RepeatedPtrFieldBase {
     return rep_ ? (rep_->allocated_size - current_size_) : 0;
   }
 
+  // Deletes all but the first `max_cleared` cleared objects.  On an arena the
+  // objects are only dropped from the pool; their memory is reclaimed with the
+  // arena.
+  template <typename TypeHandler>
+  void TrimCleared(int max_cleared) {
+    ABSL_DCHECK_GE(max_cleared, 0);
+    if (ClearedCount() <= max_cleared) return;
+    const int keep = current_size_ + max_cleared;
+    for (int i = keep; i < rep_->allocated_size; ++i) {
+      TypeHandler::Delete(cast<TypeHandler>(rep_->elements[i]), arena_);
+    }
+    rep_->allocated_size = keep;
+  }
+
+  template <typename TypeHandler>
+  void ShrinkToFit() {
+    TrimCleared<TypeHandler>(0);
+    ShrinkRepToFit();
+  }
+
+  // Adds new cleared objects until the next `n` calls to Add() need no
+  // allocation.  On an arena the new objects are created contiguously.
+  template <typename TypeHandler>
+  void PreallocateElements(int n) {
+    const int needed = n - ClearedCount();
+    if (needed <= 0) return;
+    Reserve(current_size_ + n);
+    if (arena_ == nullptr) return;
+    TypeHandler::NewContiguous(arena_, needed,
+                               rep_->elements + rep_->allocated_size);
+    rep_->allocated_size += needed;
+  }
+
+  // Bytes of SpaceUsedExcludingSelfLong() that are not needed by the current
+  // elements: unused pointer slots and cleared objects kept for reuse.
+  template <typename TypeHandler>
+  size_t SpaceRetainedLong() const {
+    size_t retained_bytes =
+        static_cast<size_t>(total_size_ - current_size_) * sizeof(void*);
+    if (rep_ != nullptr) {
+      for (int i = current_size_; i < rep_->allocated_size; ++i) {
+        retained_bytes +=
+            TypeHandler::SpaceUsedLong(*cast<TypeHandler>(rep_->elements[i]));
+      }
+    }
+    return retained_bytes;
+  }
+
   template <typename TypeHandler>
   void AddCleared(typename TypeHandler::Type* value) {
     ABSL_DCHECK(GetOwningArena() == nullptr)
@@ -758,11 +811,24 @@ class PROTOBUF_EXPORT RepeatedPtrFieldBase {
   // |extend_amount| must be > 0.
   void** InternalExtend(int extend_amount);
 
+  // Reallocates the pointer array to fit exactly the current elements, or
+  // frees it if there are none.  Requires that there are no cleared objects.
+  void ShrinkRepToFit();
+
   // Internal helper for Add: adds "obj" as the next element in the
   // array, including potentially resizing the array with Reserve if
   // needed
   void* AddOutOfLineHelper(void* obj);
 
+  // Starts loading the cleared object that the next Add() will reuse, if
+  // there is one. The parser calls this before filling in the current
+  // element, so that the load overlaps with the parsing.
+  void PrefetchNextCleared() const {
+    if (rep_ != nullptr && current_size_ < rep_->allocated_size) {
+      PROTOBUF_PREFETCH(rep_->elements[current_size_]);
+    }
+  }
+
   // The reflection implementation needs to call protected methods directly,
   // reinterpreting pointers as being to Message instead of a specific Message
   // subclass.
@@ -807,6 +873,22 @@ class GenericTypeHandler {
                                               Arena* arena = nullptr) {
     return New(arena);
   }
+  // Creates `n` elements on `arena` from a single allocation, so that they are
+  // laid out contiguously, and stores pointers to them in `elements`.
+  static void NewContiguous(Arena* arena, int n, void** elements) {
+    ABSL_DCHECK(arena != nullptr);
+    const size_t bytes = sizeof(GenericType) * static_cast<size_t>(n);
+    arena->RecordTypeAllocation(&Arena::ArenazTypeName<GenericType>::Get,
+                                bytes);
+    char* mem =
+        static_cast<char*>(arena->AllocateAligned(bytes, alignof(GenericType)));
+    for (int i = 0; i < n; ++i) {
+      auto* element =
+          reinterpret_cast<GenericType*>(mem + i * sizeof(GenericType));
+      Arena::CreateInArenaStorage(element, arena);
+      elements[i] = element;
+    }
+  }
   static inline void Delete(GenericType* value, Arena* arena) {
     if (arena == nullptr) {
       delete value;
@@ -881,6 +963,11 @@ class StringTypeHandler {
                                               Arena* arena) {
     return New(arena);
   }
+  // Arena strings already come from dedicated string blocks, which keeps
+  // them contiguous.
+  static void NewContiguous(Arena* arena, int n, void** elements) {
+    for (int i = 0; i < n; ++i) elements[i] = New(arena);
+  }
   static inline Arena* GetOwningArena(std::string*) { return nullptr; }
   static inline void Delete(std::string* value, Arena* arena) {
     if (arena == nullptr) {
@@ -985,6 +1072,10 @@ class RepeatedPtrField final : private internal::RepeatedPtrFieldBase {
 
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear();
   void MergeFrom(const RepeatedPtrField& other);
+  // Like MergeFrom(const RepeatedPtrField&), but when both fields are on the
+  // same arena the elements of `other` are moved over by pointer instead of
+  // being copied. `other` is left empty either way.
+  void MergeFrom(RepeatedPtrField&& other);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void CopyFrom(const RepeatedPtrField& other);
 
   // Replaces the contents with RepeatedPtrField(begin, end).
@@ -996,6 +1087,20 @@ class RepeatedPtrField final : private internal::RepeatedPtrFieldBase {
   // array is grown, it will always be at least doubled in size.
   void Reserve(int new_size);
 
+  // Releases memory kept only for reuse: cleared objects are deleted and the
+  // pointer array is reallocated to fit size(), or freed if the field is
+  // empty.  Useful for long-lived messages that are cleared and refilled, so
+  // that a single large input does not pin its peak footprint forever.
+  void ShrinkToFit();
+
+  // Makes sure the next `n` calls to Add(), including those made while
+  // parsing into this field, reuse elements that already exist.  On an arena
+  // the elements are created together from one allocation, so they end up
+  // next to each other rather than interleaved with their own contents, which
+  // speeds up later iteration.  Off an arena, elements must be deletable one
+  // by one, so this only reserves the pointer array.
+  void PreallocateElements(int n);
+
   int Capacity() const;
 
   // Gets the underlying array.  This pointer is possibly invalidated by
@@ -1067,6 +1172,10 @@ class RepeatedPtrField final : private internal::RepeatedPtrFieldBase {
     return internal::ToIntSize(SpaceUsedExcludingSelfLong());
   }
 
+  // Returns the part of SpaceUsedExcludingSelfLong() that is held only for
+  // reuse: unused pointer slots plus the cleared objects themselves.
+  size_t SpaceRetainedLong() const;
+
   // Advanced memory management --------------------------------------
   // When hardcore memory management becomes necessary -- as it sometimes
   // does here at Google -- the following methods may be useful.
@@ -1168,6 +1277,11 @@ class RepeatedPtrField final : private internal::RepeatedPtrFieldBase {
   Element* ReleaseCleared();
 #endif  // !PROTOBUF_FUTURE_REMOVE_CLEARED_API
 
+  // Deletes cleared objects until at most `max_cleared` are kept for reuse.
+  // On an arena the objects are dropped from the pool, but their memory is
+  // only reclaimed with the arena.
+  void TrimCleared(int max_cleared);
+
   // Removes the element referenced by position.
   //
   // Returns an iterator to the element immediately following the removed
@@ -1495,6 +1609,20 @@ inline void RepeatedPtrField<Element>::MergeFrom(
   RepeatedPtrFieldBase::MergeFrom<TypeHandler>(other);
 }
 
+template <typename Element>
+inline void RepeatedPtrField<Element>::MergeFrom(RepeatedPtrField&& other) {
+  if (GetOwningArena() != other.GetOwningArena()
+#ifdef PROTOBUF_FORCE_COPY_IN_MOVE
+      || GetOwningArena() == nullptr
+#endif  // PROTOBUF_FORCE_COPY_IN_MOVE
+  ) {
+    MergeFrom(other);
+    other.Clear();
+  } else {
+    RepeatedPtrFieldBase::StealElementsFrom(&other);
+  }
+}
+
 template <typename Element>
 inline void RepeatedPtrField<Element>::CopyFrom(const RepeatedPtrField& other) {
   RepeatedPtrFieldBase::CopyFrom<TypeHandler>(other);
@@ -1598,6 +1726,26 @@ inline int RepeatedPtrField<Element>::ClearedCount() const {
   return RepeatedPtrFieldBase::ClearedCount();
 }
 
+template <typename Element>
+inline void RepeatedPtrField<Element>::TrimCleared(int max_cleared) {
+  RepeatedPtrFieldBase::TrimCleared<TypeHandler>(max_cleared);
+}
+
+template <typename Element>
+inline void RepeatedPtrField<Element>::ShrinkToFit() {
+  RepeatedPtrFieldBase::ShrinkToFit<TypeHandler>();
+}
+
+template <typename Element>
+inline void RepeatedPtrField<Element>::PreallocateElements(int n) {
+  RepeatedPtrFieldBase::PreallocateElements<TypeHandler>(n);
+}
+
+template <typename Element>
+inline size_t RepeatedPtrField<Element>::SpaceRetainedLong() const {
+  return RepeatedPtrFieldBase::SpaceRetainedLong<TypeHandler>();
+}
+
 #ifndef PROTOBUF_FUTURE_REMOVE_CLEARED_API
 template <typename Element>
 inline void RepeatedPtrField<Element>::AddCleared(Element* value) {
@@ -1894,6 +2042,25 @@ RepeatedPtrField<Element>::pointer_end() const {
       const_cast<const void* const*>(raw_data() + size()));
 }
 
+namespace internal {
+
+// How many elements ahead of itself a loop over a repeated message field
+// prefetches. The elements are allocated one by one, so the hardware
+// prefetcher, which follows the pointer array just fine, cannot follow them.
+constexpr int kRepeatedPtrPrefetchDistance = 4;
+
+// Called by generated serialization and ByteSizeLong() loops at element `i`.
+template <typename Element>
+PROTOBUF_ALWAYS_INLINE void PrefetchRepeatedPtrAhead(
+    const RepeatedPtrField<Element>& field, int i) {
+  const int ahead = i + kRepeatedPtrPrefetchDistance;
+  if (ahead < field.size()) {
+    PROTOBUF_PREFETCH(field.data()[ahead]);
+  }
+}
+
+}  // namespace internal
+
 // Iterators and helper functions that follow the spirit of the STL
 // std::back_insert_iterator and std::back_inserter but are tailor-made
 // for RepeatedField and RepeatedPtrField. Typical usage would be:
@@ -0,0 +1,102 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/runtime_metrics.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "google/protobuf/arenaz_sampler.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/generated_message_tctable_impl.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+void CollectArenaMetrics(RuntimeMetrics::Arenas* arenas) {
+#if defined(PROTOBUF_ARENAZ_SAMPLE)
+  internal::GlobalThreadSafeArenazSampler().Iterate(
+      [&](const internal::ThreadSafeArenaStats& info) {
+        const int64_t weight = std::max<int64_t>(info.weight, 1);
+        ++arenas->sampled_arenas;
+        for (const auto& block : info.block_histogram) {
+          arenas->num_blocks +=
+              weight * block.num_allocations.load(std::memory_order_relaxed);
+          arenas->bytes_allocated +=
+              weight * static_cast<int64_t>(
+                           block.bytes_allocated.load(std::memory_order_relaxed));
+          arenas->bytes_used +=
+              weight * static_cast<int64_t>(
+                           block.bytes_used.load(std::memory_order_relaxed));
+          arenas->bytes_wasted +=
+              weight * static_cast<int64_t>(
+                           block.bytes_wasted.load(std::memory_order_relaxed));
+        }
+      });
+#else
+  (void)arenas;
+#endif  // defined(PROTOBUF_ARENAZ_SAMPLE)
+}
+
+}  // namespace
+
+RuntimeMetrics GetRuntimeMetrics() {
+  RuntimeMetrics metrics;
+  CollectArenaMetrics(&metrics.arenas);
+
+  const DescriptorPool* pool = DescriptorPool::generated_pool();
+  metrics.generated_pool.space_used =
+      static_cast<int64_t>(pool->SpaceUsedLong());
+  DescriptorPool::DatabaseBuildStats build_stats =
+      pool->GetDatabaseBuildStats();
+  metrics.generated_pool.files_built = build_stats.files_built;
+  metrics.generated_pool.build_time = build_stats.build_time;
+
+  metrics.dynamic_message_prototypes =
+      DynamicMessageFactory::LivePrototypeCount();
+
+  for (const auto& field : internal::GetTcParserStats()) {
+    metrics.parse.fast_path += field.fast_path;
+    metrics.parse.mini_parse += field.mini_parse;
+    metrics.parse.fallback += field.fallback;
+    metrics.parse.unknown += field.unknown;
+  }
+  return metrics;
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,102 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// GetRuntimeMetrics() takes a snapshot of the process-wide counters the
+// protobuf runtime keeps about its memory use and its slow paths, so that a
+// server can export them to its monitoring system alongside its own metrics.
+// Taking a snapshot reads atomic counters and walks the live arenaz samples
+// and the allocation list of the generated pool; it does not stop other
+// threads, so it is cheap enough to do every few seconds.
+//
+// Some counters are only collected when the runtime is built with the
+// matching define, and read as zero otherwise:
+//   PROTOBUF_ARENAZ_SAMPLE     RuntimeMetrics::arenas
+//   PROTOBUF_TC_PARSER_STATS   RuntimeMetrics::parse
+
+#ifndef GOOGLE_PROTOBUF_RUNTIME_METRICS_H__
+#define GOOGLE_PROTOBUF_RUNTIME_METRICS_H__
+
+#include <cstdint>
+
+#include "absl/time/time.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+struct RuntimeMetrics {
+  // Memory of the thread-safe arenas sampled by arenaz, each sample weighted
+  // by the number of arenas it stands for, so the totals estimate all live
+  // arenas.
+  struct Arenas {
+    int64_t sampled_arenas = 0;
+    // The blocks the arenas got from the system allocator or the block
+    // cache, and their total size.
+    int64_t num_blocks = 0;
+    int64_t bytes_allocated = 0;
+    // Of the blocks the arenas moved on from: the bytes handed out to
+    // objects, and the bytes left unused at their end.
+    int64_t bytes_used = 0;
+    int64_t bytes_wasted = 0;
+  } arenas;
+
+  // DescriptorPool::generated_pool().
+  struct GeneratedPool {
+    // DescriptorPool::SpaceUsedLong().
+    int64_t space_used = 0;
+    // Files built lazily from the descriptors embedded in generated code,
+    // and the wall time spent building them.
+    int64_t files_built = 0;
+    absl::Duration build_time;
+  } generated_pool;
+
+  // DynamicMessageFactory::LivePrototypeCount().
+  int64_t dynamic_message_prototypes = 0;
+
+  // How TcParser handled the fields it parsed, summed over all message types
+  // (see TcParserFieldStats).
+  struct Parse {
+    uint64_t fast_path = 0;
+    uint64_t mini_parse = 0;
+    uint64_t fallback = 0;
+    uint64_t unknown = 0;
+  } parse;
+};
+
+PROTOBUF_EXPORT RuntimeMetrics GetRuntimeMetrics();
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_RUNTIME_METRICS_H__
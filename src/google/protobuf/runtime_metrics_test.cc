@@ -0,0 +1,89 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/runtime_metrics.h"
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+#include "absl/time/time.h"
+#include "google/protobuf/dynamic_message.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+TEST(RuntimeMetricsTest, GeneratedPool) {
+  // Building the descriptor of a generated type goes through the database of
+  // the generated pool.
+  ASSERT_NE(protobuf_unittest::TestAllTypes::descriptor(), nullptr);
+
+  RuntimeMetrics metrics = GetRuntimeMetrics();
+  EXPECT_GT(metrics.generated_pool.space_used, 0);
+  EXPECT_GT(metrics.generated_pool.files_built, 0);
+  EXPECT_GE(metrics.generated_pool.build_time, absl::ZeroDuration());
+}
+
+TEST(RuntimeMetricsTest, DynamicMessagePrototypes) {
+  const int64_t before = GetRuntimeMetrics().dynamic_message_prototypes;
+  {
+    // ForeignMessage has no message fields, whose types would get their own
+    // prototypes.
+    DynamicMessageFactory factory;
+    factory.GetPrototype(protobuf_unittest::ForeignMessage::descriptor());
+    factory.GetPrototype(protobuf_unittest::ForeignMessage::descriptor());
+    EXPECT_EQ(GetRuntimeMetrics().dynamic_message_prototypes, before + 1);
+
+    // Delegated types are owned by the generated factory.
+    DynamicMessageFactory delegating;
+    delegating.SetDelegateToGeneratedFactory(true);
+    delegating.GetPrototype(protobuf_unittest::TestAllTypes::descriptor());
+    EXPECT_EQ(GetRuntimeMetrics().dynamic_message_prototypes, before + 1);
+  }
+  EXPECT_EQ(GetRuntimeMetrics().dynamic_message_prototypes, before);
+}
+
+TEST(RuntimeMetricsTest, CountersWithoutInstrumentationAreZero) {
+  RuntimeMetrics metrics = GetRuntimeMetrics();
+#if !defined(PROTOBUF_ARENAZ_SAMPLE)
+  EXPECT_EQ(metrics.arenas.sampled_arenas, 0);
+  EXPECT_EQ(metrics.arenas.bytes_allocated, 0);
+#endif  // !PROTOBUF_ARENAZ_SAMPLE
+#if !defined(PROTOBUF_TC_PARSER_STATS)
+  EXPECT_EQ(metrics.parse.fallback, 0);
+  EXPECT_EQ(metrics.parse.fast_path, 0);
+#endif  // !PROTOBUF_TC_PARSER_STATS
+  (void)metrics;
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
@@ -134,13 +134,16 @@ class PROTOBUF_EXPORT SerialArena {
     // the pattern we are looking for.
     const size_t index = absl::bit_width(size - 1) - 4;
 
-    if (index >= cached_block_length_) return nullptr;
-    auto& cached_head = cached_blocks_[index];
-    if (cached_head == nullptr) return nullptr;
-
-    void* ret = cached_head;
-    PROTOBUF_UNPOISON_MEMORY_REGION(ret, size);
-    cached_head = cached_head->next;
+    void* ret = nullptr;
+    if (index < cached_block_length_) {
+      auto& cached_head = cached_blocks_[index];
+      if (cached_head != nullptr) {
+        ret = cached_head;
+        PROTOBUF_UNPOISON_MEMORY_REGION(ret, size);
+        cached_head = cached_head->next;
+      }
+    }
+    RecordCachedBlockLookup(index, ret != nullptr);
     return ret;
   }
 
@@ -296,6 +299,26 @@ class PROTOBUF_EXPORT SerialArena {
 
   std::vector<void*> PeekCleanupListForTesting();
 
+  // Snapshot of the bump allocation state, used to implement
+  // Arena::Checkpoint() and Arena::RewindTo().
+  struct Checkpoint {
+    ArenaBlock* head;
+    char* ptr;
+    char* limit;
+    StringBlock* string_block;
+    size_t string_block_unused;
+    size_t space_used;
+  };
+
+  Checkpoint CreateCheckpoint() {
+    return {head(),
+            ptr(),
+            limit_,
+            string_block_,
+            string_block_unused_.load(std::memory_order_relaxed),
+            space_used_.load(std::memory_order_relaxed)};
+  }
+
  private:
   bool MaybeAllocateString(void*& p);
   ABSL_ATTRIBUTE_RETURNS_NONNULL void* AllocateFromStringBlockFallback();
@@ -335,6 +358,16 @@ class PROTOBUF_EXPORT SerialArena {
   SizedPtr Free(Deallocator deallocator);
 
   static size_t FreeStringBlocks(StringBlock* string_block, size_t unused);
+  // Runs the cleanups of `b` and all blocks after it. The cleanup nodes of `b`
+  // must be synced to the limit.
+  static void CleanupBlocks(ArenaBlock* b);
+
+  // Runs the cleanups registered and destroys the strings allocated after
+  // `checkpoint`, then frees all blocks allocated after it through
+  // `deallocator` and restores the bump pointer.
+  template <typename Deallocator>
+  void RewindTo(const Checkpoint& checkpoint, Deallocator deallocator);
+  void RewindStringBlocks(const Checkpoint& checkpoint);
 
   // Adds 'used` to space_used_ in relaxed atomic order.
   void AddSpaceUsed(size_t space_used) {
@@ -372,11 +405,13 @@ class PROTOBUF_EXPORT SerialArena {
   std::atomic<size_t> space_allocated_{0};
   ThreadSafeArena& parent_;
 
-  // Repeated*Field and Arena play together to reduce memory consumption by
+  // Repeated*Field, Map and Arena play together to reduce memory consumption by
   // reusing blocks. Currently, natural growth of the repeated field types makes
   // them allocate blocks of size `8 + 2^N, N>=3`.
   // When the repeated field grows returns the previous block and we put it in
-  // this free list.
+  // this free list. Map returns its old bucket arrays on rehash and its nodes
+  // on erase the same way, and StringBlocks are carved out of cached blocks
+  // when one of a suitable size class is available.
   // `cached_blocks_[i]` points to the free list for blocks of size `8+2^(i+3)`.
   // The array of freelists is grown when needed in `ReturnArrayMemory()`.
   struct CachedBlock {
@@ -403,6 +438,10 @@ class PROTOBUF_EXPORT SerialArena {
   inline explicit SerialArena(ThreadSafeArena& parent);
   inline SerialArena(FirstSerialArena, ArenaBlock* b, ThreadSafeArena& parent);
 
+  // Reports a lookup in size class `index` of `cached_blocks_` to the arena
+  // sampler. Defined in thread_safe_arena.h.
+  inline void RecordCachedBlockLookup(size_t index, bool hit);
+
   void* AllocateAlignedFallback(size_t n);
   void* AllocateAlignedWithCleanupFallback(size_t n, size_t align,
                                            void (*destructor)(void*));
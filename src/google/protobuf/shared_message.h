@@ -0,0 +1,144 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// SharedMessage<T> is a reference-counted handle to an immutable message.
+// Copying the handle shares the message instead of copying it, and the
+// message is only copied when one of the handles sharing it asks to modify
+// it:
+//
+//   SharedMessage<CatalogEntry> entry(std::move(parsed_entry));
+//   std::vector<SharedMessage<CatalogEntry>> results(1000, entry);  // O(1) each
+//   results[0].Mutable()->set_price(0);  // Copies the entry for results[0].
+//
+// Messages allocated on an arena can also point to a shared message as a
+// submessage, see UnsafeArenaShare().
+
+#ifndef GOOGLE_PROTOBUF_SHARED_MESSAGE_H__
+#define GOOGLE_PROTOBUF_SHARED_MESSAGE_H__
+
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+#include "absl/log/absl_check.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/message_lite.h"
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+template <typename T>
+class SharedMessage {
+  static_assert(std::is_base_of<MessageLite, T>::value,
+                "SharedMessage holds generated message types.");
+
+ public:
+  // Shares an empty message.
+  SharedMessage() : rep_(new Rep(T())) {}
+  // Shares `message`, which is moved out of.
+  explicit SharedMessage(T&& message) : rep_(new Rep(std::move(message))) {}
+
+  SharedMessage(const SharedMessage& other) : rep_(other.rep_) { rep_->Ref(); }
+  SharedMessage& operator=(const SharedMessage& other) {
+    other.rep_->Ref();
+    Unref(rep_);
+    rep_ = other.rep_;
+    return *this;
+  }
+  ~SharedMessage() { Unref(rep_); }
+
+  const T& get() const { return rep_->message; }
+  const T& operator*() const { return get(); }
+  const T* operator->() const { return &get(); }
+
+  // Returns true if no other handle shares the message.
+  bool unique() const {
+    return rep_->refs.load(std::memory_order_acquire) == 1;
+  }
+
+  // Returns the message for modification, after copying it if other handles
+  // share it.  The pointer is valid until this handle is copied, assigned or
+  // destroyed.
+  T* Mutable() {
+    if (!unique()) {
+      Rep* copy = new Rep(T(rep_->message));
+      Unref(rep_);
+      rep_ = copy;
+    }
+    return &rep_->message;
+  }
+
+  // Returns the message for use as a submessage of messages allocated on
+  // `arena`, and keeps it alive until `arena` is destroyed.  This shares the
+  // message with any number of messages on the arena in O(1):
+  //
+  //   response->unsafe_arena_set_allocated_entry(
+  //       entry.UnsafeArenaShare(response->GetArena()));
+  //
+  // As with other unsafe_arena_ methods, the caller must make sure the
+  // message is not modified, or cleared, through the messages pointing to it.
+  T* UnsafeArenaShare(Arena* arena) const {
+    ABSL_DCHECK(arena != nullptr);
+    rep_->Ref();
+    arena->OwnCustomDestructor(rep_, &UnrefVoid);
+    return &rep_->message;
+  }
+
+ private:
+  struct Rep {
+    explicit Rep(T&& m) : message(std::move(m)) {}
+
+    void Ref() { refs.fetch_add(1, std::memory_order_relaxed); }
+
+    std::atomic<int> refs{1};
+    T message;
+  };
+
+  static void Unref(Rep* rep) {
+    if (rep->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete rep;
+  }
+  static void UnrefVoid(void* rep) { Unref(static_cast<Rep*>(rep)); }
+
+  Rep* rep_;
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_SHARED_MESSAGE_H__
@@ -0,0 +1,129 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "google/protobuf/shared_message.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "google/protobuf/arena.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using unittest::TestAllTypes;
+
+SharedMessage<TestAllTypes> MakeShared() {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  return SharedMessage<TestAllTypes>(std::move(message));
+}
+
+TEST(SharedMessageTest, CopiesShareTheMessage) {
+  SharedMessage<TestAllTypes> shared = MakeShared();
+  EXPECT_TRUE(shared.unique());
+  TestUtil::ExpectAllFieldsSet(*shared);
+
+  std::vector<SharedMessage<TestAllTypes>> copies(10, shared);
+  EXPECT_FALSE(shared.unique());
+  for (const auto& copy : copies) EXPECT_EQ(&shared.get(), &copy.get());
+
+  SharedMessage<TestAllTypes> empty;
+  EXPECT_EQ(0, empty->ByteSizeLong());
+  empty = copies[0];
+  EXPECT_EQ(&shared.get(), &empty.get());
+  copies.clear();
+  empty = SharedMessage<TestAllTypes>();
+  EXPECT_TRUE(shared.unique());
+}
+
+TEST(SharedMessageTest, MutableCopiesOnWrite) {
+  SharedMessage<TestAllTypes> shared = MakeShared();
+  const TestAllTypes* original = &shared.get();
+  // Not shared: modified in place.
+  shared.Mutable()->set_optional_int32(1);
+  EXPECT_EQ(original, &shared.get());
+
+  SharedMessage<TestAllTypes> copy = shared;
+  copy.Mutable()->set_optional_int32(2);
+  EXPECT_NE(original, &copy.get());
+  EXPECT_EQ(original, &shared.get());
+  EXPECT_EQ(1, shared->optional_int32());
+  EXPECT_EQ(2, copy->optional_int32());
+  EXPECT_EQ(shared->optional_string(), copy->optional_string());
+  EXPECT_TRUE(shared.unique());
+  EXPECT_TRUE(copy.unique());
+}
+
+TEST(SharedMessageTest, ConcurrentCopies) {
+  SharedMessage<TestAllTypes> shared = MakeShared();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([shared] {
+      for (int j = 0; j < 1000; ++j) {
+        SharedMessage<TestAllTypes> copy = shared;
+        EXPECT_EQ(101, copy->optional_int32());
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_TRUE(shared.unique());
+}
+
+TEST(SharedMessageTest, UnsafeArenaShare) {
+  std::string expected;
+  const TestAllTypes* shared_address;
+  Arena arena;
+  {
+    SharedMessage<TestAllTypes> shared = MakeShared();
+    shared_address = &shared.get();
+    for (int i = 0; i < 3; ++i) {
+      auto* output =
+          Arena::CreateMessage<unittest::NestedTestAllTypes>(&arena);
+      output->unsafe_arena_set_allocated_payload(
+          shared.UnsafeArenaShare(&arena));
+      EXPECT_EQ(shared_address, &output->payload());
+      if (expected.empty()) expected = output->SerializeAsString();
+      EXPECT_EQ(expected, output->SerializeAsString());
+    }
+  }
+  // The arena keeps the message alive after the last handle is gone.
+  TestUtil::ExpectAllFieldsSet(*shared_address);
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
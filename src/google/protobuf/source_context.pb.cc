@@ -199,6 +199,8 @@ const ::_pbi::TcParseTable<0, 1, 0, 47, 2> SourceContext::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_SourceContext_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // string file_name = 1;
     {::_pbi::TcParser::FastUS1,
@@ -155,6 +155,11 @@ class PROTOBUF_EXPORT SourceContext final :
   SourceContext* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<SourceContext>(arena);
   }
+  SourceContext* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    SourceContext* copy = CreateMaybeMessage<SourceContext>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const SourceContext& from);
   using ::google::protobuf::Message::MergeFrom;
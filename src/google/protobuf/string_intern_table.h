@@ -0,0 +1,107 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// StringInternTable holds a single copy of each short string value that string
+// fields of arena messages share, instead of allocating one copy per field.
+// It pays off for large in-memory datasets where many messages hold the same
+// few values, such as host names or enum-like labels:
+//
+//   StringInternTable table;
+//   ArenaOptions options;
+//   options.string_intern_table = &table;
+//   Arena arena(options);
+//   for (...) {
+//     LogRecord* record = Arena::CreateMessage<LogRecord>(&arena);
+//     record->ParseFromString(...);  // record->host() is interned
+//   }
+//
+// Only singular string and bytes fields parsed into messages on such an arena
+// are interned. Repeated fields keep one string per element, as their
+// elements are handed out as mutable std::string objects.
+
+#ifndef GOOGLE_PROTOBUF_STRING_INTERN_TABLE_H__
+#define GOOGLE_PROTOBUF_STRING_INTERN_TABLE_H__
+
+#include <cstddef>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/arena.h"
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+class PROTOBUF_EXPORT StringInternTable {
+ public:
+  // Values longer than `max_length` bytes are never interned, and once the
+  // table holds `max_entries` values, new values are no longer added. This
+  // bounds the memory spent on values that turn out not to repeat.
+  explicit StringInternTable(size_t max_length = 64,
+                             size_t max_entries = 64 * 1024);
+  StringInternTable(const StringInternTable&) = delete;
+  StringInternTable& operator=(const StringInternTable&) = delete;
+  ~StringInternTable();
+
+  // Returns the table's copy of `value`, adding it if needed. Returns null if
+  // `value` is longer than max_length() or the table is full. The returned
+  // string is immutable and lives as long as the table. Thread safe.
+  const std::string* Intern(absl::string_view value);
+
+  size_t max_length() const { return max_length_; }
+
+  // Returns the number of distinct values in the table.
+  size_t size() const;
+
+ private:
+  const size_t max_length_;
+  const size_t max_entries_;
+  mutable absl::Mutex mu_;
+  // Owns the interned strings; keys of `strings_` point into them.
+  Arena arena_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<absl::string_view, const std::string*> strings_
+      ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_STRING_INTERN_TABLE_H__
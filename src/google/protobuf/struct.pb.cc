@@ -304,6 +304,8 @@ const ::_pbi::TcParseTable<0, 1, 2, 37, 2> Struct::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_Struct_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
   }}, {{
@@ -313,7 +315,7 @@ const ::_pbi::TcParseTable<0, 1, 2, 37, 2> Struct::_table_ = {
     {PROTOBUF_FIELD_OFFSET(Struct, _impl_.fields_), 0, 0,
     (0 | ::_fl::kFcRepeated | ::_fl::kMap)},
   }}, {{
-    {::_pbi::TcParser::GetMapAuxInfo<decltype(Struct()._impl_.fields_)>(1, 0, 0)},
+    {::_pbi::TcParser::GetMapAuxInfo<decltype(Struct()._impl_.fields_)>(1, 0, 0, 0)},
     {::_pbi::TcParser::CreateInArenaStorageCb<::google::protobuf::Value>},
   }}, {{
     "\26\6\0\0\0\0\0\0"
@@ -397,6 +399,20 @@ void Struct::MergeImpl(::google::protobuf::Message& to_msg, const ::google::prot
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void Struct::MergeFrom(Struct&& from) {
+  Struct* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  ::_pbi::MapMergeFrom(*_this->_internal_mutable_fields(),
+                       std::move(*from._internal_mutable_fields()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const Struct&>(from));
+}
+
 void Struct::CopyFrom(const Struct& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.Struct)
   if (&from == this) return;
@@ -609,6 +625,8 @@ const ::_pbi::TcParseTable<0, 6, 2, 42, 2> Value::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_Value_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
   }}, {{
@@ -894,6 +912,8 @@ const ::_pbi::TcParseTable<0, 1, 1, 0, 2> ListValue::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_ListValue_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // repeated .google.protobuf.Value values = 1;
     {::_pbi::TcParser::FastMtR1,
@@ -919,6 +939,7 @@ const ::_pbi::TcParseTable<0, 1, 1, 0, 2> ListValue::_table_ = {
   // repeated .google.protobuf.Value values = 1;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_values_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_values(), i);
     const auto& repfield = this->_internal_values().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(1, repfield, repfield.GetCachedSize(), target, stream);
@@ -942,9 +963,10 @@ const ::_pbi::TcParseTable<0, 1, 1, 0, 2> ListValue::_table_ = {
 
   // repeated .google.protobuf.Value values = 1;
   total_size += 1UL * this->_internal_values_size();
-  for (const auto& msg : this->_internal_values()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_values_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_values(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_values().Get(i));
   }
 
   return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
@@ -969,6 +991,20 @@ void ListValue::MergeImpl(::google::protobuf::Message& to_msg, const ::google::p
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void ListValue::MergeFrom(ListValue&& from) {
+  ListValue* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_values()->MergeFrom(
+      std::move(*from._internal_mutable_values()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const ListValue&>(from));
+}
+
 void ListValue::CopyFrom(const ListValue& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.ListValue)
   if (&from == this) return;
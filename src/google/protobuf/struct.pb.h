@@ -230,6 +230,11 @@ class PROTOBUF_EXPORT Struct final :
   Struct* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Struct>(arena);
   }
+  Struct* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Struct* copy = CreateMaybeMessage<Struct>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Struct& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -239,6 +244,7 @@ class PROTOBUF_EXPORT Struct final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(Struct&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -405,6 +411,11 @@ class PROTOBUF_EXPORT Value final :
   Value* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Value>(arena);
   }
+  Value* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Value* copy = CreateMaybeMessage<Value>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Value& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -666,6 +677,11 @@ class PROTOBUF_EXPORT ListValue final :
   ListValue* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<ListValue>(arena);
   }
+  ListValue* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    ListValue* copy = CreateMaybeMessage<ListValue>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const ListValue& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -675,6 +691,7 @@ class PROTOBUF_EXPORT ListValue final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(ListValue&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -41,12 +41,16 @@
 #include <atomic>
 #include <climits>
 #include <cmath>
+#include <cstring>
 #include <limits>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/escaping.h"
@@ -54,6 +58,8 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "google/protobuf/any.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/descriptor.pb.h"
@@ -67,6 +73,7 @@
 #include "google/protobuf/map_field.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/reflection_mode.h"
+#include "google/protobuf/reflection_ops.h"
 #include "google/protobuf/repeated_field.h"
 #include "google/protobuf/unknown_field_set.h"
 #include "google/protobuf/wire_format_lite.h"
@@ -518,8 +525,7 @@ class TextFormat::Parser::ParserImpl {
       DO(ConsumeBeforeWhitespace("]"));
       TryConsumeWhitespace();
 
-      field = finder_ ? finder_->FindExtension(message, field_name)
-                      : DefaultFinderFindExtension(message, field_name);
+      field = FindExtension(message, field_name);
 
       if (field == nullptr) {
         if (!allow_unknown_field_ && !allow_unknown_extension_) {
@@ -765,7 +771,16 @@ class TextFormat::Parser::ParserImpl {
     DO(ConsumeMessageDelimiter(&delimiter));
     MessageFactory* factory =
         finder_ ? finder_->FindExtensionFactory(field) : nullptr;
-    if (field->is_repeated()) {
+    if (field->is_map()) {
+      // Store the entry in the map itself; appending it to the map's
+      // repeated-field mirror would make every later map access resync.
+      std::unique_ptr<Message> entry(
+          reflection->GetMessageFactory()
+              ->GetPrototype(field->message_type())
+              ->New());
+      DO(ConsumeMessage(entry.get(), delimiter));
+      internal::ReflectionOps::InsertMapEntry(message, field, entry.get());
+    } else if (field->is_repeated()) {
       DO(ConsumeMessage(reflection->AddMessage(message, field, factory),
                         delimiter));
     } else {
@@ -812,7 +827,7 @@ class TextFormat::Parser::ParserImpl {
 // not the default, setting it to the default should not be treated as a no-op.
 #define SET_FIELD(CPPTYPE, CPPTYPELCASE, VALUE)                   \
   if (field->is_repeated()) {                                     \
-    reflection->Add##CPPTYPE(message, field, VALUE);              \
+    reflection->Add##CPPTYPE(message, field, std::move(VALUE));   \
   } else {                                                        \
     if (error_on_no_op_fields_ && !field->has_presence() &&       \
         field->default_value_##CPPTYPELCASE() ==                  \
@@ -1036,8 +1051,23 @@ class TextFormat::Parser::ParserImpl {
     return true;
   }
 
+  // Looks up the extension of `message` named `name`. With the default
+  // finder every pool lookup takes the pool's mutex, so results are
+  // remembered for the rest of the parse; inputs that set the same
+  // extensions in many messages then pay for each name only once.
+  const FieldDescriptor* FindExtension(Message* message,
+                                       const std::string& name) {
+    if (finder_ != nullptr) return finder_->FindExtension(message, name);
+    auto key = std::make_pair(message->GetDescriptor(), name);
+    auto it = extension_cache_.find(key);
+    if (it != extension_cache_.end()) return it->second;
+    const FieldDescriptor* field = DefaultFinderFindExtension(message, name);
+    extension_cache_.emplace(std::move(key), field);
+    return field;
+  }
+
   // Returns true if the current token's text is equal to that specified.
-  bool LookingAt(const std::string& text) {
+  bool LookingAt(absl::string_view text) {
     return tokenizer_.current().text == text;
   }
 
@@ -1306,7 +1336,7 @@ class TextFormat::Parser::ParserImpl {
   // Consumes a token and confirms that it matches that specified in the
   // value parameter. Returns false if the token found does not match that
   // which was specified.
-  bool Consume(const std::string& value) {
+  bool Consume(absl::string_view value) {
     const std::string& current_value = tokenizer_.current().text;
 
     if (current_value != value) {
@@ -1322,7 +1352,7 @@ class TextFormat::Parser::ParserImpl {
 
   // Similar to `Consume`, but the following token may be tokenized as
   // TYPE_WHITESPACE.
-  bool ConsumeBeforeWhitespace(const std::string& value) {
+  bool ConsumeBeforeWhitespace(absl::string_view value) {
     // Report whitespace after this token, but only once.
     tokenizer_.set_report_whitespace(true);
     bool result = Consume(value);
@@ -1332,7 +1362,7 @@ class TextFormat::Parser::ParserImpl {
 
   // Attempts to consume the supplied value. Returns false if a the
   // token found does not match the value specified.
-  bool TryConsume(const std::string& value) {
+  bool TryConsume(absl::string_view value) {
     if (tokenizer_.current().text == value) {
       tokenizer_.Next();
       return true;
@@ -1343,7 +1373,7 @@ class TextFormat::Parser::ParserImpl {
 
   // Similar to `TryConsume`, but the following token may be tokenized as
   // TYPE_WHITESPACE.
-  bool TryConsumeBeforeWhitespace(const std::string& value) {
+  bool TryConsumeBeforeWhitespace(absl::string_view value) {
     // Report whitespace after this token, but only once.
     tokenizer_.set_report_whitespace(true);
     bool result = TryConsume(value);
@@ -1354,8 +1384,9 @@ class TextFormat::Parser::ParserImpl {
   bool TryConsumeWhitespace() {
     had_silent_marker_ = false;
     if (LookingAtType(io::Tokenizer::TYPE_WHITESPACE)) {
-      if (tokenizer_.current().text ==
-          absl::StrCat(" ", internal::kDebugStringSilentMarkerForDetection)) {
+      absl::string_view text = tokenizer_.current().text;
+      if (absl::ConsumePrefix(&text, " ") &&
+          text == internal::kDebugStringSilentMarkerForDetection) {
         had_silent_marker_ = true;
       }
       tokenizer_.Next();
@@ -1407,6 +1438,10 @@ class TextFormat::Parser::ParserImpl {
   bool had_errors_;
   bool error_on_no_op_fields_;
 
+  // Extensions found by FindExtension(), keyed by extendee and name.
+  absl::flat_hash_map<std::pair<const Descriptor*, std::string>,
+                      const FieldDescriptor*>
+      extension_cache_;
 };
 
 // ===========================================================================
@@ -1470,21 +1505,21 @@ class TextFormat::Printer::TextGenerator
   // Print text to the output stream.
   void Print(const char* text, size_t size) override {
     if (indent_level_ > 0) {
-      size_t pos = 0;  // The number of bytes we've written so far.
-      for (size_t i = 0; i < size; i++) {
-        if (text[i] == '\n') {
-          // Saw newline.  If there is more text, we may need to insert an
-          // indent here.  So, write what we have so far, including the '\n'.
-          Write(text + pos, i - pos + 1);
-          pos = i + 1;
-
-          // Setting this true will cause the next Write() to insert an indent
-          // first.
-          at_start_of_line_ = true;
-        }
+      const char* end = text + size;
+      const char* newline;
+      while ((newline = static_cast<const char*>(
+                  memchr(text, '\n', end - text))) != nullptr) {
+        // Saw newline.  If there is more text, we may need to insert an
+        // indent here.  So, write what we have so far, including the '\n'.
+        Write(text, newline - text + 1);
+        text = newline + 1;
+
+        // Setting this true will cause the next Write() to insert an indent
+        // first.
+        at_start_of_line_ = true;
       }
       // Write the rest.
-      Write(text + pos, size - pos);
+      Write(text, end - text);
     } else {
       Write(text, size);
       if (size > 0 && text[size - 1] == '\n') {
@@ -1596,6 +1631,34 @@ class TextFormat::Printer::TextGenerator
   int initial_indent_level_;
 };
 
+namespace {
+
+// Strings are escaped this many bytes at a time, so that printing a huge
+// string or bytes field holds only a bounded escaped copy on top of the
+// output stream's buffer. Both escapings used here map each byte on its own,
+// so the pieces join up to the same text.
+constexpr size_t kEscapePieceSize = 64 << 10;
+
+template <typename Escape>
+void PrintEscaped(absl::string_view value, Escape escape,
+                  TextFormat::BaseTextGenerator* generator) {
+  while (value.size() > kEscapePieceSize) {
+    generator->PrintString(escape(value.substr(0, kEscapePieceSize)));
+    value.remove_prefix(kEscapePieceSize);
+  }
+  generator->PrintString(escape(value));
+}
+
+std::string EscapeBytes(absl::string_view value) {
+  return absl::CEscape(value);
+}
+
+std::string EscapeUtf8(absl::string_view value) {
+  return absl::Utf8SafeCEscape(value);
+}
+
+}  // namespace
+
 // ===========================================================================
 //  An internal field value printer that may insert a silent marker in
 //  DebugStrings.
@@ -1621,7 +1684,7 @@ class TextFormat::Printer::FastFieldValuePrinterUtf8Escaping
   void PrintString(const std::string& val,
                    TextFormat::BaseTextGenerator* generator) const override {
     generator->PrintLiteral("\"");
-    generator->PrintString(absl::Utf8SafeCEscape(val));
+    PrintEscaped(val, EscapeUtf8, generator);
     generator->PrintLiteral("\"");
   }
   void PrintBytes(const std::string& val,
@@ -1688,8 +1751,358 @@ bool CheckParseInputSize(T& input, io::ErrorCollector* error_collector) {
   return true;
 }
 
+// A top-level `name { ... }` or `name < ... >` entry of a text format input.
+struct TopLevelEntry {
+  absl::string_view name;
+  size_t begin;  // Offset of the name.
+  size_t end;    // Offset just past the closing delimiter.
+};
+
+bool IsWordChar(char c) {
+  return absl::ascii_isalnum(c) || c == '_' || c == '.';
+}
+
+// Returns the offset just past the string literal that starts at `pos`, or
+// npos if it is not terminated.
+size_t SkipStringLiteral(absl::string_view input, size_t pos) {
+  const char quote = input[pos];
+  for (++pos; pos < input.size(); ++pos) {
+    if (input[pos] == '\\') {
+      ++pos;
+    } else if (input[pos] == quote) {
+      return pos + 1;
+    }
+  }
+  return absl::string_view::npos;
+}
+
+// Returns the offset just past the delimiter that closes the one at `pos`,
+// or npos if there is none. Strings and comments are skipped. Kinds of
+// delimiters are not matched against each other; the parser checks that.
+size_t SkipDelimited(absl::string_view input, size_t pos) {
+  int depth = 0;
+  while (pos < input.size()) {
+    switch (input[pos]) {
+      case '{':
+      case '<':
+      case '[':
+        ++depth;
+        ++pos;
+        break;
+      case '}':
+      case '>':
+      case ']':
+        ++pos;
+        if (--depth == 0) return pos;
+        break;
+      case '"':
+      case '\'':
+        pos = SkipStringLiteral(input, pos);
+        if (pos == absl::string_view::npos) return pos;
+        break;
+      case '#':
+        pos = input.find('\n', pos);
+        if (pos == absl::string_view::npos) return pos;
+        break;
+      default:
+        ++pos;
+    }
+  }
+  return absl::string_view::npos;
+}
+
+// Finds the top-level entries of `input` that are a name, optionally
+// followed by ':', and a message body. Names of top-level lists
+// (`name: [ ... ]`) go to `list_names`. This is only a scan for delimiters:
+// anything that is not valid text format is left to the parser. Returns
+// false if a string or delimiter is not closed.
+bool ScanTopLevelEntries(absl::string_view input,
+                         std::vector<TopLevelEntry>* entries,
+                         std::vector<absl::string_view>* list_names) {
+  // The name that would start an entry here, if any.
+  size_t name_begin = absl::string_view::npos;
+  absl::string_view name;
+  bool had_colon = false;
+  size_t pos = 0;
+  while (pos < input.size()) {
+    const char c = input[pos];
+    if (c == '#') {
+      pos = input.find('\n', pos);
+      if (pos == absl::string_view::npos) break;
+    } else if (absl::ascii_isspace(c)) {
+      ++pos;
+    } else if (IsWordChar(c)) {
+      const size_t begin = pos;
+      while (pos < input.size() && IsWordChar(input[pos])) ++pos;
+      if (absl::ascii_isalpha(c) || c == '_') {
+        name_begin = begin;
+        name = input.substr(begin, pos - begin);
+        had_colon = false;
+      } else {
+        name_begin = absl::string_view::npos;
+      }
+    } else if (c == ':' && name_begin != absl::string_view::npos &&
+               !had_colon) {
+      had_colon = true;
+      ++pos;
+    } else if (c == '{' || c == '<' || c == '[') {
+      const size_t end = SkipDelimited(input, pos);
+      if (end == absl::string_view::npos) return false;
+      if (name_begin != absl::string_view::npos) {
+        if (c == '[') {
+          list_names->push_back(name);
+        } else {
+          entries->push_back({name, name_begin, end});
+        }
+      }
+      name_begin = absl::string_view::npos;
+      pos = end;
+    } else if (c == '"' || c == '\'') {
+      pos = SkipStringLiteral(input, pos);
+      if (pos == absl::string_view::npos) return false;
+      name_begin = absl::string_view::npos;
+    } else {
+      name_begin = absl::string_view::npos;
+      ++pos;
+    }
+  }
+  return true;
+}
+
+// Overwrites text[begin, end) with spaces, keeping newlines and tabs so that
+// the tokenizer reports the same lines and columns for the rest.
+void BlankOut(std::string& text, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    if (text[i] != '\n' && text[i] != '\t') text[i] = ' ';
+  }
+}
+
+// Keeps the warnings reported while parsing part of an input, with line
+// numbers relative to the whole input, so that they can be reported in
+// order once all parts have parsed. Errors are not kept: after one, the
+// input is parsed again serially.
+class PartErrorCollector : public io::ErrorCollector {
+ public:
+  struct Warning {
+    int line;
+    int column;
+    std::string message;
+  };
+
+  explicit PartErrorCollector(int first_line) : first_line_(first_line) {}
+
+  void RecordError(int /* line */, int /* column */,
+                   absl::string_view /* message */) override {}
+
+  void RecordWarning(int line, int column,
+                     absl::string_view message) override {
+    warnings_.push_back(
+        {line < 0 ? line : line + first_line_, column, std::string(message)});
+  }
+
+  std::vector<Warning>& warnings() { return warnings_; }
+
+ private:
+  const int first_line_;
+  std::vector<Warning> warnings_;
+};
+
+// Reports a problem outside of a ParserImpl the way ParserImpl does.
+void ReportParseProblem(io::ErrorCollector* error_collector,
+                        const Descriptor* root_message_type, bool is_error,
+                        int line, int column, absl::string_view message) {
+  if (error_collector != nullptr) {
+    if (is_error) {
+      error_collector->RecordError(line, column, message);
+    } else {
+      error_collector->RecordWarning(line, column, message);
+    }
+    return;
+  }
+  const std::string position =
+      line >= 0 ? absl::StrCat((line + 1), ":", (column + 1), ": ") : "";
+  if (is_error) {
+    ABSL_LOG(ERROR) << "Error parsing text-format "
+                    << root_message_type->full_name() << ": " << position
+                    << message;
+  } else {
+    ABSL_LOG(WARNING) << "Warning parsing text-format "
+                      << root_message_type->full_name() << ": " << position
+                      << message;
+  }
+}
+
 }  // namespace
 
+bool TextFormat::Parser::TryMergeInParallel(absl::string_view input,
+                                            Message* output,
+                                            bool allow_singular_overwrites,
+                                            bool* result) {
+  if (parse_info_tree_ != nullptr || allow_field_number_ ||
+      allow_case_insensitive_field_) {
+    return false;
+  }
+  std::vector<TopLevelEntry> entries;
+  std::vector<absl::string_view> list_names;
+  if (!ScanTopLevelEntries(input, &entries, &list_names)) return false;
+
+  // Only entries of repeated message fields that never appear in another
+  // form can be split off without reordering them.
+  const Descriptor* descriptor = output->GetDescriptor();
+  auto splittable = [descriptor](absl::string_view name) {
+    const FieldDescriptor* field = descriptor->FindFieldByName(name);
+    return field != nullptr && field->is_repeated() && !field->is_map() &&
+                   field->type() == FieldDescriptor::TYPE_MESSAGE
+               ? field
+               : nullptr;
+  };
+  absl::flat_hash_set<const FieldDescriptor*> excluded;
+  for (absl::string_view name : list_names) {
+    if (const FieldDescriptor* field = splittable(name)) excluded.insert(field);
+  }
+  std::vector<const FieldDescriptor*> fields;
+  std::vector<TopLevelEntry> split;
+  for (const TopLevelEntry& entry : entries) {
+    const FieldDescriptor* field = splittable(entry.name);
+    if (field == nullptr || excluded.contains(field)) continue;
+    if (std::find(fields.begin(), fields.end(), field) == fields.end()) {
+      fields.push_back(field);
+    }
+    split.push_back(entry);
+  }
+  const int num_entries = static_cast<int>(split.size());
+  if (num_entries == 0 || num_entries < parallel_min_entries_) return false;
+
+  // Every part keeps its text at the same line and column as in `input`,
+  // with the bytes of other parts blanked out, so that positions in warnings
+  // need at most a line offset.
+  struct Part {
+    std::string text;
+    Message* message = nullptr;
+    std::unique_ptr<PartErrorCollector> warnings;
+    bool ok = false;
+  };
+  const int num_tasks =
+      std::max(1, std::min(parallel_num_tasks_, num_entries));
+  std::vector<Part> parts(num_tasks + 1);
+  Arena* arena = output->GetArena();
+  std::vector<std::unique_ptr<Message>> owned;
+  auto new_message = [&] {
+    Message* message = output->New(arena);
+    if (arena == nullptr) owned.emplace_back(message);
+    return message;
+  };
+
+  Part& rest = parts[num_tasks];
+  rest.text = std::string(input);
+  for (const TopLevelEntry& entry : split) {
+    BlankOut(rest.text, entry.begin, entry.end);
+  }
+  rest.message = new_message();
+  rest.warnings = std::make_unique<PartErrorCollector>(0);
+
+  size_t line_start = 0;
+  int line = 0;
+  for (int task = 0; task < num_tasks; ++task) {
+    const int begin = static_cast<int>(int64_t{num_entries} * task / num_tasks);
+    const int end =
+        static_cast<int>(int64_t{num_entries} * (task + 1) / num_tasks);
+    const size_t first_line_start =
+        input.rfind('\n', split[begin].begin) + 1;  // npos + 1 == 0
+    line += static_cast<int>(std::count(input.begin() + line_start,
+                                        input.begin() + first_line_start,
+                                        '\n'));
+    line_start = first_line_start;
+
+    Part& part = parts[task];
+    part.text = std::string(
+        input.substr(line_start, split[end - 1].end - line_start));
+    size_t kept = line_start;
+    for (int i = begin; i < end; ++i) {
+      BlankOut(part.text, kept - line_start, split[i].begin - line_start);
+      kept = split[i].end;
+    }
+    part.message = new_message();
+    part.warnings = std::make_unique<PartErrorCollector>(line);
+  }
+
+  const ParserImpl::SingularOverwritePolicy overwrites_policy =
+      allow_singular_overwrites ? ParserImpl::ALLOW_SINGULAR_OVERWRITES
+                                : ParserImpl::FORBID_SINGULAR_OVERWRITES;
+  auto parse = [&](Part& part) {
+    io::ArrayInputStream input_stream(part.text.data(),
+                                      static_cast<int>(part.text.size()));
+    ParserImpl parser(descriptor, &input_stream, part.warnings.get(), finder_,
+                      nullptr, overwrites_policy, allow_case_insensitive_field_,
+                      allow_unknown_field_, allow_unknown_extension_,
+                      allow_unknown_enum_, allow_field_number_,
+                      allow_relaxed_whitespace_, allow_partial_,
+                      recursion_limit_, error_on_no_op_fields_);
+    part.ok = parser.Parse(part.message);
+  };
+  absl::BlockingCounter pending(num_tasks);
+  for (int task = 0; task < num_tasks; ++task) {
+    executor_([&, task] {
+      parse(parts[task]);
+      pending.DecrementCount();
+    });
+  }
+  parse(rest);
+  pending.Wait();
+  for (const Part& part : parts) {
+    if (!part.ok) return false;
+  }
+
+  const Reflection* reflection = output->GetReflection();
+  if (allow_singular_overwrites) {
+    output->MergeFrom(*rest.message);
+  } else {
+    // Parse() cleared the output, so the rest can simply take its place.
+    reflection->Swap(output, rest.message);
+  }
+  std::vector<Message*> moved;
+  for (int task = 0; task < num_tasks; ++task) {
+    Message* message = parts[task].message;
+    for (const FieldDescriptor* field : fields) {
+      moved.resize(reflection->FieldSize(*message, field));
+      for (size_t i = moved.size(); i > 0; --i) {
+        moved[i - 1] = reflection->UnsafeArenaReleaseLast(message, field);
+      }
+      for (Message* entry : moved) {
+        reflection->UnsafeArenaAddAllocatedMessage(output, field, entry);
+      }
+    }
+  }
+
+  std::vector<PartErrorCollector::Warning> warnings;
+  for (Part& part : parts) {
+    for (auto& warning : part.warnings->warnings()) {
+      warnings.push_back(std::move(warning));
+    }
+  }
+  std::stable_sort(warnings.begin(), warnings.end(),
+                   [](const PartErrorCollector::Warning& a,
+                      const PartErrorCollector::Warning& b) {
+                     return std::make_pair(a.line, a.column) <
+                            std::make_pair(b.line, b.column);
+                   });
+  for (const auto& warning : warnings) {
+    ReportParseProblem(error_collector_, descriptor, /*is_error=*/false,
+                       warning.line, warning.column, warning.message);
+  }
+
+  *result = true;
+  if (!allow_partial_ && !output->IsInitialized()) {
+    std::vector<std::string> missing_fields;
+    output->FindInitializationErrors(&missing_fields);
+    ReportParseProblem(error_collector_, descriptor, /*is_error=*/true, -1, 0,
+                       absl::StrCat("Message missing required fields: ",
+                                    absl::StrJoin(missing_fields, ", ")));
+    *result = false;
+  }
+  return true;
+}
+
 bool TextFormat::Parser::Parse(io::ZeroCopyInputStream* input,
                                Message* output) {
   output->Clear();
@@ -1710,6 +2123,14 @@ bool TextFormat::Parser::Parse(io::ZeroCopyInputStream* input,
 bool TextFormat::Parser::ParseFromString(absl::string_view input,
                                          Message* output) {
   DO(CheckParseInputSize(input, error_collector_));
+  if (executor_ != nullptr) {
+    output->Clear();
+    bool result;
+    if (TryMergeInParallel(input, output, allow_singular_overwrites_,
+                           &result)) {
+      return result;
+    }
+  }
   io::ArrayInputStream input_stream(input.data(), input.size());
   return Parse(&input_stream, output);
 }
@@ -1735,6 +2156,12 @@ bool TextFormat::Parser::Merge(io::ZeroCopyInputStream* input,
 bool TextFormat::Parser::MergeFromString(absl::string_view input,
                                          Message* output) {
   DO(CheckParseInputSize(input, error_collector_));
+  bool result;
+  if (executor_ != nullptr &&
+      TryMergeInParallel(input, output, /*allow_singular_overwrites=*/true,
+                         &result)) {
+    return result;
+  }
   io::ArrayInputStream input_stream(input.data(), input.size());
   return Merge(&input_stream, output);
 }
@@ -1922,7 +2349,7 @@ void TextFormat::FastFieldValuePrinter::PrintEnum(
 void TextFormat::FastFieldValuePrinter::PrintString(
     const std::string& val, BaseTextGenerator* generator) const {
   generator->PrintLiteral("\"");
-  generator->PrintString(absl::CEscape(val));
+  PrintEscaped(val, EscapeBytes, generator);
   generator->PrintLiteral("\"");
 }
 void TextFormat::FastFieldValuePrinter::PrintBytes(
@@ -2214,7 +2641,9 @@ bool TextFormat::Printer::PrintAny(const Message& message,
   const Reflection* reflection = message.GetReflection();
 
   // Extract the full type name from the type_url field.
-  const std::string& type_url = reflection->GetString(message, type_url_field);
+  std::string type_url_scratch;
+  const std::string& type_url = reflection->GetStringReference(
+      message, type_url_field, &type_url_scratch);
   std::string url_prefix;
   std::string full_type_name;
   if (!internal::ParseAnyTypeUrl(type_url, &url_prefix, &full_type_name)) {
@@ -2233,7 +2662,11 @@ bool TextFormat::Printer::PrintAny(const Message& message,
   DynamicMessageFactory factory;
   std::unique_ptr<Message> value_message(
       factory.GetPrototype(value_descriptor)->New());
-  std::string serialized_value = reflection->GetString(message, value_field);
+  // Parse straight from the packed bytes; for a large payload a copy would
+  // double what printing needs.
+  std::string value_scratch;
+  const std::string& serialized_value =
+      reflection->GetStringReference(message, value_field, &value_scratch);
   if (!value_message->ParseFromString(serialized_value)) {
     ABSL_LOG(WARNING) << type_url << ": failed to parse contents";
     return false;
@@ -2265,11 +2698,12 @@ void TextFormat::Printer::Print(const Message& message,
     PrintUnknownFields(unknown_fields, generator, kUnknownFieldRecursionLimit);
     return;
   }
-  const Descriptor* descriptor = message.GetDescriptor();
-  auto itr = custom_message_printers_.find(descriptor);
-  if (itr != custom_message_printers_.end()) {
-    itr->second->Print(message, single_line_mode_, generator);
-    return;
+  if (!custom_message_printers_.empty()) {
+    auto itr = custom_message_printers_.find(message.GetDescriptor());
+    if (itr != custom_message_printers_.end()) {
+      itr->second->Print(message, single_line_mode_, generator);
+      return;
+    }
   }
   PrintMessage(message, generator);
 }
@@ -2352,9 +2786,9 @@ class MapEntryMessageComparator {
         return first < second;
       }
       case FieldDescriptor::CPPTYPE_STRING: {
-        std::string first = reflection->GetString(*a, field_);
-        std::string second = reflection->GetString(*b, field_);
-        return first < second;
+        std::string first_scratch, second_scratch;
+        return reflection->GetStringReference(*a, field_, &first_scratch) <
+               reflection->GetStringReference(*b, field_, &second_scratch);
       }
       default:
         ABSL_DLOG(FATAL) << "Invalid key for map field.";
@@ -2797,7 +3231,7 @@ void TextFormat::Printer::PrintUnknownFields(
           // This field is not parseable as a Message (or we ran out of
           // recursion budget). So it is probably just a plain string.
           generator->PrintMaybeWithMarker(MarkerToken(), ": ", "\"");
-          generator->PrintString(absl::CEscape(value));
+          PrintEscaped(value, EscapeBytes, generator);
           if (single_line_mode_) {
             generator->PrintLiteral("\" ");
           } else {
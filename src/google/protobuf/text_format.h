@@ -39,8 +39,10 @@
 #define GOOGLE_PROTOBUF_TEXT_FORMAT_H__
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/port.h"
@@ -88,6 +90,12 @@ class PROTOBUF_EXPORT TextFormat {
 
   // Outputs a textual representation of the given message to the given
   // output stream. Returns false if printing fails.
+  //
+  // The text is written to the stream as it is generated, and long string
+  // and bytes values are escaped piecewise, so printing needs little memory
+  // beyond the stream's own buffer. To dump a very large message, print it
+  // to an io::FileOutputStream rather than building a string with
+  // PrintToString() or DebugString().
   static bool Print(const Message& message, io::ZeroCopyOutputStream* output);
 
   // Print the fields in an UnknownFieldSet.  They are printed by tag number
@@ -494,6 +502,11 @@ class PROTOBUF_EXPORT TextFormat {
 
     const FastFieldValuePrinter* GetFieldPrinter(
         const FieldDescriptor* field) const {
+      // This is called for every value printed, so skip hashing `field` in
+      // the common case of a printer without any custom field printers.
+      if (custom_printers_.empty()) {
+        return default_field_value_printer_.get();
+      }
       auto it = custom_printers_.find(field);
       return it == custom_printers_.end() ? default_field_value_printer_.get()
                                           : it->second.get();
@@ -706,6 +719,27 @@ class PROTOBUF_EXPORT TextFormat {
       error_on_no_op_fields_ = return_error;
     }
 
+    // Makes ParseFromString() and MergeFromString() parse large top-level
+    // repeated message fields on several threads. When the input has at least
+    // `min_entries` top-level entries written as `name { ... }` or
+    // `name < ... >` for such fields, they are split into `num_tasks`
+    // contiguous runs. Each run is parsed into a message of its own by a task
+    // handed to `executor` (see json::JsonLinesOptions::executor), and the
+    // entries are then moved into the output in their original order. The
+    // rest of the input is parsed on the calling thread.
+    //
+    // The result, errors and warnings are the same as without it: if any
+    // part fails to parse, the whole input is parsed again serially to
+    // report the errors. The finder, if any, must be safe to call from
+    // several threads. Ignored when locations are written, or when field
+    // numbers or case-insensitive field names are allowed.
+    void ParseInParallel(std::function<void(std::function<void()>)> executor,
+                         int min_entries = 1024, int num_tasks = 8) {
+      executor_ = std::move(executor);
+      parallel_min_entries_ = min_entries;
+      parallel_num_tasks_ = num_tasks;
+    }
+
    private:
     // Forward declaration of an internal class used to parse text
     // representations (see text_format.cc for implementation).
@@ -716,6 +750,13 @@ class PROTOBUF_EXPORT TextFormat {
     bool MergeUsingImpl(io::ZeroCopyInputStream* input, Message* output,
                         ParserImpl* parser_impl);
 
+    // Merges `input` into `output` as ParseInParallel() describes. Returns
+    // false, leaving `output` unchanged, if the input does not qualify or
+    // fails to parse; the caller then parses it serially. Otherwise sets
+    // `*result` to what MergeUsingImpl() would have returned.
+    bool TryMergeInParallel(absl::string_view input, Message* output,
+                            bool allow_singular_overwrites, bool* result);
+
     io::ErrorCollector* error_collector_;
     const Finder* finder_;
     ParseInfoTree* parse_info_tree_;
@@ -729,6 +770,9 @@ class PROTOBUF_EXPORT TextFormat {
     bool allow_singular_overwrites_;
     int recursion_limit_;
     bool error_on_no_op_fields_ = false;
+    std::function<void(std::function<void()>)> executor_;
+    int parallel_min_entries_ = 1024;
+    int parallel_num_tasks_ = 8;
   };
 
 
@@ -38,9 +38,13 @@
 #include <stdlib.h>
 
 #include <atomic>
+#include <functional>
 #include <limits>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "google/protobuf/testing/file.h"
 #include "google/protobuf/testing/file.h"
@@ -268,6 +272,34 @@ TEST_F(TextFormatTest, Utf8DebugString) {
   EXPECT_EQ(correct_string, debug_string);
 }
 
+TEST_F(TextFormatTest, PrintLongStringsInPieces) {
+  // Long values are escaped in pieces; escapes and UTF-8 sequences that
+  // straddle a piece boundary must come out as if escaped at once.
+  std::string bytes;
+  for (int i = 0; i < 200000; ++i) bytes.push_back(static_cast<char>(i % 251));
+  std::string utf8;
+  while (utf8.size() < 200000) utf8 += "a\350\260\267\"\n";
+  proto_.set_optional_bytes(bytes);
+  proto_.set_optional_string(utf8);
+
+  TextFormat::Printer printer;
+  printer.SetUseUtf8StringEscaping(true);
+  std::string text;
+  ASSERT_TRUE(printer.PrintToString(proto_, &text));
+  EXPECT_EQ(absl::StrCat("optional_string: \"", absl::Utf8SafeCEscape(utf8),
+                         "\"\noptional_bytes: \"", absl::CEscape(bytes),
+                         "\"\n"),
+            text);
+
+  // Streaming through small buffers gives the same text.
+  std::string streamed(text.size(), '\0');
+  io::ArrayOutputStream output(&streamed[0], static_cast<int>(streamed.size()),
+                               /*block_size=*/1000);
+  ASSERT_TRUE(printer.Print(proto_, &output));
+  EXPECT_EQ(output.ByteCount(), static_cast<int64_t>(text.size()));
+  EXPECT_EQ(text, streamed);
+}
+
 TEST_F(TextFormatTest, PrintUnknownFields) {
   // Test printing of unknown fields in a message.
 
@@ -850,6 +882,22 @@ TEST_F(TextFormatExtensionsTest, ParseExtensions) {
   TestUtil::ExpectAllExtensionsSet(proto_);
 }
 
+TEST_F(TextFormatExtensionsTest, ParseRepeatedExtensionManyTimes) {
+  // The parser remembers extension lookups; later occurrences must resolve
+  // to the same field.
+  EXPECT_TRUE(TextFormat::ParseFromString(
+      "[protobuf_unittest.repeated_int32_extension]: 1\n"
+      "[protobuf_unittest.optional_int32_extension]: 7\n"
+      "[protobuf_unittest.repeated_int32_extension]: 2\n"
+      "[protobuf_unittest.repeated_int32_extension]: 3\n",
+      &proto_));
+  ASSERT_EQ(3, proto_.ExtensionSize(unittest::repeated_int32_extension));
+  EXPECT_EQ(1, proto_.GetExtension(unittest::repeated_int32_extension, 0));
+  EXPECT_EQ(2, proto_.GetExtension(unittest::repeated_int32_extension, 1));
+  EXPECT_EQ(3, proto_.GetExtension(unittest::repeated_int32_extension, 2));
+  EXPECT_EQ(7, proto_.GetExtension(unittest::optional_int32_extension));
+}
+
 TEST_F(TextFormatTest, ParseEnumFieldFromNumber) {
   // Create a parse string with a numerical value for an enum field.
   std::string parse_string =
@@ -2194,6 +2242,85 @@ TEST_F(TextFormatParserTest, ParseSkippedFieldWithAdditionalWhiteSpaces) {
   EXPECT_EQ(text, "optional_int32: 321\n");
 }
 
+TEST_F(TextFormatParserTest, ParseInParallelMatchesSerial) {
+  std::string input = "optional_int32: 1\n";
+  for (int i = 0; i < 50; ++i) {
+    absl::StrAppend(&input, "repeated_nested_message { bb: ", i, " }\n");
+    if (i % 4 == 0) {
+      absl::StrAppend(&input, "repeated_foreign_message: < c: ", i,
+                      " >  # '{' \"\n");
+    }
+    if (i % 10 == 0) absl::StrAppend(&input, "repeated_string: \"}\"\n");
+  }
+  absl::StrAppend(&input, "repeated_nested_message: [{ bb: 50 }]\n");
+  unittest::TestAllTypes serial;
+  ASSERT_TRUE(parser_.ParseFromString(input, &serial));
+  ASSERT_EQ(serial.repeated_nested_message_size(), 51);
+
+  std::vector<std::thread> threads;
+  parser_.ParseInParallel(
+      [&](std::function<void()> task) {
+        threads.emplace_back(std::move(task));
+      },
+      /*min_entries=*/10, /*num_tasks=*/3);
+  unittest::TestAllTypes parallel;
+  bool parsed = parser_.ParseFromString(input, &parallel);
+  for (auto& thread : threads) thread.join();
+  ASSERT_TRUE(parsed);
+  // The list keeps repeated_nested_message serial; only the 13 entries of
+  // repeated_foreign_message are split off.
+  EXPECT_EQ(threads.size(), 3u);
+  EXPECT_EQ(parallel.DebugString(), serial.DebugString());
+
+  threads.clear();
+  Arena arena;
+  auto* merged = Arena::CreateMessage<unittest::TestAllTypes>(&arena);
+  merged->add_repeated_foreign_message()->set_c(-1);
+  ASSERT_TRUE(parser_.MergeFromString(input, merged));
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(threads.size(), 3u);
+  ASSERT_EQ(merged->repeated_foreign_message_size(),
+            serial.repeated_foreign_message_size() + 1);
+  EXPECT_EQ(merged->repeated_foreign_message(0).c(), -1);
+  merged->mutable_repeated_foreign_message()->DeleteSubrange(0, 1);
+  EXPECT_EQ(merged->DebugString(), serial.DebugString());
+}
+
+TEST_F(TextFormatParserTest, ParseInParallelReportsErrorsLikeSerial) {
+  std::string input;
+  for (int i = 0; i < 20; ++i) {
+    absl::StrAppend(&input, "repeated_nested_message {\n  bb: ", i, "\n}\n");
+  }
+  absl::StrAppend(&input, "\trepeated_nested_message { bb: x }\n");
+  parser_.ParseInParallel(
+      [](std::function<void()> task) { task(); }, /*min_entries=*/2,
+      /*num_tasks=*/4);
+  ExpectFailure(input, "Expected integer, got: x", 61, 39);
+
+  // Warnings from all parts are reported in order, at their own positions.
+  parser_.AllowUnknownField(true);
+  MockErrorCollector error_collector;
+  parser_.RecordErrorsTo(&error_collector);
+  unittest::TestAllTypes proto;
+  EXPECT_TRUE(parser_.ParseFromString(
+      "repeated_nested_message { bb: 1 }\n"
+      "unknown1: 1\n"
+      "repeated_nested_message {\n"
+      "  unknown2: 2 }\n"
+      "repeated_nested_message { bb: 3 } unknown3: 3\n",
+      &proto));
+  EXPECT_EQ(proto.repeated_nested_message_size(), 3);
+  EXPECT_EQ(
+      "2:9: WARNING:Message type \"protobuf_unittest.TestAllTypes\" has no "
+      "field named \"unknown1\".\n"
+      "4:11: WARNING:Message type \"protobuf_unittest.TestAllTypes.NestedMessage"
+      "\" has no field named \"unknown2\".\n"
+      "5:43: WARNING:Message type \"protobuf_unittest.TestAllTypes\" has no "
+      "field named \"unknown3\".\n",
+      error_collector.text_);
+  parser_.RecordErrorsTo(nullptr);
+}
+
 class TextFormatMessageSetTest : public testing::Test {
  protected:
   static const char proto_text_format_[];
@@ -126,6 +126,44 @@ class PROTOBUF_EXPORT ThreadSafeArena {
 
   void* AllocateFromStringBlock();
 
+  // Returns true if parsed cord payloads should be copied into this arena.
+  bool arena_owned_cords() const {
+    const AllocationPolicy* policy = AllocPolicy();
+    return policy != nullptr && policy->arena_owned_cords;
+  }
+
+  // Returns the table parsed strings are interned into, or null.
+  StringInternTable* string_intern_table() const {
+    const AllocationPolicy* policy = AllocPolicy();
+    return policy != nullptr ? policy->string_intern_table : nullptr;
+  }
+
+  // Attributes `n` bytes to `type_name()` in the type profile of a sampled
+  // arena. See `SetThreadSafeArenazTypeProfileEnabled()`.
+  void RecordTypeAllocation(ArenazTypeNameFn type_name, size_t n) {
+    ThreadSafeArenaStats::RecordTypeAllocation(arena_stats_.MutableStats(),
+                                               type_name, n);
+  }
+
+  // Returns true once the blocks of the arena add up to more than the
+  // policy's max_total_bytes. Checked by the parser after each message.
+  bool max_total_bytes_exceeded() const {
+    return max_total_bytes_exceeded_.load(std::memory_order_relaxed);
+  }
+
+  // State captured by Checkpoint() for the calling thread's SerialArena.
+  struct Checkpoint {
+    uint64_t lifecycle_id;
+    SerialArena* serial;
+    SerialArena::Checkpoint state;
+  };
+
+  Checkpoint CreateCheckpoint();
+  void RewindTo(const Checkpoint& checkpoint);
+
+  // Joins the lifetimes of this arena and `other`. See Arena::Fuse().
+  bool Fuse(ThreadSafeArena& other);
+
   std::vector<void*> PeekCleanupListForTesting();
 
  private:
@@ -136,6 +174,8 @@ class PROTOBUF_EXPORT ThreadSafeArena {
   static uint64_t GetNextLifeCycleId();
 
   class SerialArenaChunk;
+  class SerialArenaTable;
+  class FuseGroup;
 
   // Returns a new SerialArenaChunk that has {id, serial} at slot 0. It may
   // grow based on "prev_num_slots".
@@ -153,6 +193,13 @@ class PROTOBUF_EXPORT ThreadSafeArena {
   // Adds SerialArena to the chunked list. May create a new chunk.
   void AddSerialArena(void* id, SerialArena* serial);
 
+  // Adds {id, serial} to the lookup table if there is one, rebuilding it from
+  // the chunked list when it is full. `new_chunk` is true if the caller just
+  // added a chunk, which creates the first table once there are enough.
+  void AddToSerialArenaTable(void* id, SerialArena* serial, bool new_chunk);
+  // Returns the SerialArena of `id` by walking the chunked list.
+  SerialArena* FindSerialArenaInChunks(void* id) const;
+
   // Members are declared here to track sizeof(ThreadSafeArena) and hotness
   // centrally.
 
@@ -162,10 +209,20 @@ class PROTOBUF_EXPORT ThreadSafeArena {
   TaggedAllocationPolicyPtr alloc_policy_;  // Tagged pointer to AllocPolicy.
   ThreadSafeArenaStatsHandle arena_stats_;
 
-  // Adding a new chunk to head_ must be protected by mutex_.
+  // Adding a new chunk to head_ or replacing table_ must be protected by
+  // mutex_.
   absl::Mutex mutex_;
   // Pointer to a linked list of SerialArenaChunk.
   std::atomic<SerialArenaChunk*> head_{nullptr};
+  // Hash table indexing the chunked list by thread, so that the first
+  // allocation of a thread on an arena shared by many threads does not scan
+  // every chunk. Only created once the arena outgrows its first few chunks.
+  std::atomic<SerialArenaTable*> table_{nullptr};
+  // Set by CheckMaxTotalBytes(), cleared on Reset().
+  std::atomic<bool> max_total_bytes_exceeded_{false};
+  // The group of arenas this one was fused with, or null. Only changed while
+  // holding the global fuse mutex; see Fuse().
+  std::atomic<FuseGroup*> fuse_group_{nullptr};
 
   void* first_owner_;
   // Must be declared after alloc_policy_; otherwise, it may lose info on
@@ -182,9 +239,21 @@ class PROTOBUF_EXPORT ThreadSafeArena {
 
   void Init();
 
+  // Sets max_total_bytes_exceeded_ if the policy has a budget and the arena
+  // went over it. Called whenever the arena grew.
+  void CheckMaxTotalBytes();
+
   // Delete or Destruct all objects owned by the arena.
   void CleanupList();
 
+  // Returns true if the blocks of the arena can outlive it, i.e. it neither
+  // uses a user-provided initial block nor a custom allocation policy.
+  bool IsFusable() const;
+  // Hands all blocks and pending cleanups of the arena over to its fuse group
+  // and leaves the group, destroying the group if this was its last member.
+  // The arena must be re-initialized or destroyed afterwards.
+  void LeaveFuseGroup();
+
   inline void CacheSerialArena(SerialArena* serial) {
     thread_cache().last_serial_arena = serial;
     thread_cache().last_lifecycle_id_seen = tag_and_id_;
@@ -285,6 +354,11 @@ class PROTOBUF_EXPORT ThreadSafeArena {
                 "kSerialArenaSize must be a multiple of 8.");
 };
 
+inline void SerialArena::RecordCachedBlockLookup(size_t index, bool hit) {
+  ThreadSafeArenaStats::RecordCachedBlockLookup(
+      parent_.arena_stats_.MutableStats(), index, hit);
+}
+
 }  // namespace internal
 }  // namespace protobuf
 }  // namespace google
@@ -183,6 +183,8 @@ const ::_pbi::TcParseTable<1, 2, 0, 0, 2> Timestamp::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_Timestamp_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // int32 nanos = 2;
     {::_pbi::TcParser::SingularVarintNoZag1<::uint32_t, offsetof(Timestamp, _impl_.nanos_), 63>(),
@@ -283,8 +285,12 @@ void Timestamp::MergeImpl(::google::protobuf::Message& to_msg, const ::google::p
 void Timestamp::CopyFrom(const Timestamp& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.Timestamp)
   if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  ::memcpy(&_impl_.seconds_, &from._impl_.seconds_,
+      static_cast<::size_t>(reinterpret_cast<char*>(&_impl_.nanos_) -
+      reinterpret_cast<char*>(&_impl_.seconds_)) + sizeof(_impl_.nanos_));
+  _internal_metadata_.Clear<::google::protobuf::UnknownFieldSet>();
+  _internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      from._internal_metadata_);
 }
 
 PROTOBUF_NOINLINE bool Timestamp::IsInitialized() const {
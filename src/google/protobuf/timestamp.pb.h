@@ -155,6 +155,11 @@ class PROTOBUF_EXPORT Timestamp final :
   Timestamp* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Timestamp>(arena);
   }
+  Timestamp* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Timestamp* copy = CreateMaybeMessage<Timestamp>(arena);
+    copy->CopyFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Timestamp& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -593,6 +593,8 @@ const ::_pbi::TcParseTable<3, 7, 3, 46, 2> Type::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_Type_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // string name = 1;
@@ -670,6 +672,7 @@ const ::_pbi::TcParseTable<3, 7, 3, 46, 2> Type::_table_ = {
   // repeated .google.protobuf.Field fields = 2;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_fields_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_fields(), i);
     const auto& repfield = this->_internal_fields().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(2, repfield, repfield.GetCachedSize(), target, stream);
@@ -686,6 +689,7 @@ const ::_pbi::TcParseTable<3, 7, 3, 46, 2> Type::_table_ = {
   // repeated .google.protobuf.Option options = 4;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_options_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_options(), i);
     const auto& repfield = this->_internal_options().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(4, repfield, repfield.GetCachedSize(), target, stream);
@@ -732,9 +736,10 @@ const ::_pbi::TcParseTable<3, 7, 3, 46, 2> Type::_table_ = {
 
   // repeated .google.protobuf.Field fields = 2;
   total_size += 1UL * this->_internal_fields_size();
-  for (const auto& msg : this->_internal_fields()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_fields_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_fields(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_fields().Get(i));
   }
 
   // repeated string oneofs = 3;
@@ -746,9 +751,10 @@ const ::_pbi::TcParseTable<3, 7, 3, 46, 2> Type::_table_ = {
 
   // repeated .google.protobuf.Option options = 4;
   total_size += 1UL * this->_internal_options_size();
-  for (const auto& msg : this->_internal_options()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_options_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_options(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_options().Get(i));
   }
 
   // string name = 1;
@@ -814,6 +820,24 @@ void Type::MergeImpl(::google::protobuf::Message& to_msg, const ::google::protob
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void Type::MergeFrom(Type&& from) {
+  Type* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_fields()->MergeFrom(
+      std::move(*from._internal_mutable_fields()));
+  _this->_internal_mutable_oneofs()->MergeFrom(
+      std::move(*from._internal_mutable_oneofs()));
+  _this->_internal_mutable_options()->MergeFrom(
+      std::move(*from._internal_mutable_options()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const Type&>(from));
+}
+
 void Type::CopyFrom(const Type& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.Type)
   if (&from == this) return;
@@ -1002,6 +1026,8 @@ const ::_pbi::TcParseTable<4, 10, 1, 72, 2> Field::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_Field_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // .google.protobuf.Field.Kind kind = 1;
@@ -1144,6 +1170,7 @@ const ::_pbi::TcParseTable<4, 10, 1, 72, 2> Field::_table_ = {
   // repeated .google.protobuf.Option options = 9;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_options_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_options(), i);
     const auto& repfield = this->_internal_options().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(9, repfield, repfield.GetCachedSize(), target, stream);
@@ -1183,9 +1210,10 @@ const ::_pbi::TcParseTable<4, 10, 1, 72, 2> Field::_table_ = {
 
   // repeated .google.protobuf.Option options = 9;
   total_size += 1UL * this->_internal_options_size();
-  for (const auto& msg : this->_internal_options()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_options_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_options(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_options().Get(i));
   }
 
   // string name = 4;
@@ -1290,6 +1318,20 @@ void Field::MergeImpl(::google::protobuf::Message& to_msg, const ::google::proto
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void Field::MergeFrom(Field&& from) {
+  Field* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_options()->MergeFrom(
+      std::move(*from._internal_mutable_options()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const Field&>(from));
+}
+
 void Field::CopyFrom(const Field& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.Field)
   if (&from == this) return;
@@ -1468,6 +1510,8 @@ const ::_pbi::TcParseTable<3, 6, 3, 40, 2> Enum::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_Enum_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // string name = 1;
@@ -1539,6 +1583,7 @@ const ::_pbi::TcParseTable<3, 6, 3, 40, 2> Enum::_table_ = {
   // repeated .google.protobuf.EnumValue enumvalue = 2;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_enumvalue_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_enumvalue(), i);
     const auto& repfield = this->_internal_enumvalue().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(2, repfield, repfield.GetCachedSize(), target, stream);
@@ -1547,6 +1592,7 @@ const ::_pbi::TcParseTable<3, 6, 3, 40, 2> Enum::_table_ = {
   // repeated .google.protobuf.Option options = 3;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_options_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_options(), i);
     const auto& repfield = this->_internal_options().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(3, repfield, repfield.GetCachedSize(), target, stream);
@@ -1593,16 +1639,18 @@ const ::_pbi::TcParseTable<3, 6, 3, 40, 2> Enum::_table_ = {
 
   // repeated .google.protobuf.EnumValue enumvalue = 2;
   total_size += 1UL * this->_internal_enumvalue_size();
-  for (const auto& msg : this->_internal_enumvalue()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_enumvalue_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_enumvalue(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_enumvalue().Get(i));
   }
 
   // repeated .google.protobuf.Option options = 3;
   total_size += 1UL * this->_internal_options_size();
-  for (const auto& msg : this->_internal_options()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_options_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_options(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_options().Get(i));
   }
 
   // string name = 1;
@@ -1667,6 +1715,22 @@ void Enum::MergeImpl(::google::protobuf::Message& to_msg, const ::google::protob
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void Enum::MergeFrom(Enum&& from) {
+  Enum* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_enumvalue()->MergeFrom(
+      std::move(*from._internal_mutable_enumvalue()));
+  _this->_internal_mutable_options()->MergeFrom(
+      std::move(*from._internal_mutable_options()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const Enum&>(from));
+}
+
 void Enum::CopyFrom(const Enum& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.Enum)
   if (&from == this) return;
@@ -1796,6 +1860,8 @@ const ::_pbi::TcParseTable<2, 3, 1, 38, 2> EnumValue::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_EnumValue_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     {::_pbi::TcParser::MiniParse, {}},
     // string name = 1;
@@ -1852,6 +1918,7 @@ const ::_pbi::TcParseTable<2, 3, 1, 38, 2> EnumValue::_table_ = {
   // repeated .google.protobuf.Option options = 3;
   for (unsigned i = 0,
       n = static_cast<unsigned>(this->_internal_options_size()); i < n; i++) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_options(), i);
     const auto& repfield = this->_internal_options().Get(i);
     target = ::google::protobuf::internal::WireFormatLite::
         InternalWriteMessage(3, repfield, repfield.GetCachedSize(), target, stream);
@@ -1875,9 +1942,10 @@ const ::_pbi::TcParseTable<2, 3, 1, 38, 2> EnumValue::_table_ = {
 
   // repeated .google.protobuf.Option options = 3;
   total_size += 1UL * this->_internal_options_size();
-  for (const auto& msg : this->_internal_options()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormatLite::MessageSize(msg);
+  for (int i = 0, n = this->_internal_options_size(); i < n; ++i) {
+    ::google::protobuf::internal::PrefetchRepeatedPtrAhead(this->_internal_options(), i);
+    total_size += ::google::protobuf::internal::WireFormatLite::MessageSize(
+        this->_internal_options().Get(i));
   }
 
   // string name = 1;
@@ -1920,6 +1988,20 @@ void EnumValue::MergeImpl(::google::protobuf::Message& to_msg, const ::google::p
   _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(from._internal_metadata_);
 }
 
+void EnumValue::MergeFrom(EnumValue&& from) {
+  EnumValue* const _this = this;
+  ABSL_DCHECK_NE(&from, _this);
+  // Take over the repeated and map fields and the unknown fields
+  // first. Repeated and map fields are moved by pointer when both
+  // messages share an arena, and `from` is left with all of them
+  // empty for the copying merge below either way.
+  _this->_internal_mutable_options()->MergeFrom(
+      std::move(*from._internal_mutable_options()));
+  _this->_internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      std::move(from._internal_metadata_));
+  MergeFrom(static_cast<const EnumValue&>(from));
+}
+
 void EnumValue::CopyFrom(const EnumValue& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.EnumValue)
   if (&from == this) return;
@@ -2060,6 +2142,8 @@ const ::_pbi::TcParseTable<1, 2, 1, 35, 2> Option::_table_ = {
     offsetof(decltype(_table_), aux_entries),
     &_Option_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // .google.protobuf.Any value = 2;
     {::_pbi::TcParser::FastMtS1,
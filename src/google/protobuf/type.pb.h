@@ -294,6 +294,11 @@ class PROTOBUF_EXPORT Type final :
   Type* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Type>(arena);
   }
+  Type* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Type* copy = CreateMaybeMessage<Type>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Type& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -303,6 +308,7 @@ class PROTOBUF_EXPORT Type final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(Type&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -574,6 +580,11 @@ class PROTOBUF_EXPORT Field final :
   Field* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Field>(arena);
   }
+  Field* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Field* copy = CreateMaybeMessage<Field>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Field& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -583,6 +594,7 @@ class PROTOBUF_EXPORT Field final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(Field&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -929,6 +941,11 @@ class PROTOBUF_EXPORT Enum final :
   Enum* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Enum>(arena);
   }
+  Enum* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Enum* copy = CreateMaybeMessage<Enum>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Enum& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -938,6 +955,7 @@ class PROTOBUF_EXPORT Enum final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(Enum&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -1179,6 +1197,11 @@ class PROTOBUF_EXPORT EnumValue final :
   EnumValue* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<EnumValue>(arena);
   }
+  EnumValue* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    EnumValue* copy = CreateMaybeMessage<EnumValue>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const EnumValue& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -1188,6 +1211,7 @@ class PROTOBUF_EXPORT EnumValue final :
   private:
   static void MergeImpl(::google::protobuf::Message& to_msg, const ::google::protobuf::Message& from_msg);
   public:
+  void MergeFrom(EnumValue&& from);
   PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
@@ -1373,6 +1397,11 @@ class PROTOBUF_EXPORT Option final :
   Option* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Option>(arena);
   }
+  Option* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Option* copy = CreateMaybeMessage<Option>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Option& from);
   using ::google::protobuf::Message::MergeFrom;
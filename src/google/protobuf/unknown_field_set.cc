@@ -34,6 +34,8 @@
 
 #include "google/protobuf/unknown_field_set.h"
 
+#include <atomic>
+
 #include "absl/log/absl_check.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/internal/resize_uninitialized.h"
@@ -55,53 +57,119 @@
 namespace google {
 namespace protobuf {
 
+namespace {
+
+PROTOBUF_CONSTINIT std::atomic<bool> parse_lazily{false};
+
+// Decodes fields serialized by a lazy parse, which were checked to be
+// well-formed when they were first parsed.
+void ParseSerializedFields(const std::string& bytes, UnknownFieldSet* unknown) {
+  const char* ptr;
+  internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
+                             false, &ptr, absl::string_view(bytes));
+  ptr = internal::UnknownGroupParse(unknown, ptr, &ctx);
+  ABSL_DCHECK(ptr != nullptr && ctx.EndedAtEndOfStream());
+}
+
+}  // namespace
+
+void UnknownFieldSet::SetParseLazily(bool lazy) {
+  parse_lazily.store(lazy, std::memory_order_relaxed);
+}
+
 const UnknownFieldSet& UnknownFieldSet::default_instance() {
   static auto instance = internal::OnShutdownDelete(new UnknownFieldSet());
   return *instance;
 }
 
 void UnknownFieldSet::ClearFallback() {
-  ABSL_DCHECK(!fields_.empty());
-  int n = fields_.size();
-  do {
-    (fields_)[--n].Delete();
-  } while (n > 0);
+  ABSL_DCHECK(!fields_.empty() || serialized_ != nullptr);
+  for (UnknownField& field : fields_) field.Delete();
   fields_.clear();
+  delete serialized_;
+  serialized_ = nullptr;
 }
 
-void UnknownFieldSet::InternalMergeFrom(const UnknownFieldSet& other) {
-  int other_field_count = other.field_count();
-  if (other_field_count > 0) {
-    fields_.reserve(fields_.size() + other_field_count);
-    for (int i = 0; i < other_field_count; i++) {
-      fields_.push_back((other.fields_)[i]);
-      fields_.back().DeepCopy((other.fields_)[i]);
-    }
+void UnknownFieldSet::FlushSerializedSlow() {
+  // Detach the serialized fields first: adding the decoded fields must not
+  // flush them again.
+  SerializedFields* serialized = serialized_;
+  serialized_ = nullptr;
+  UnknownFieldSet* parsed = serialized->parsed.load(std::memory_order_acquire);
+  if (parsed != nullptr) {
+    MergeFromAndDestroy(parsed);
+  } else {
+    ParseSerializedFields(serialized->bytes, this);
+  }
+  delete serialized;
+}
+
+const UnknownFieldSet& UnknownFieldSet::ParsedSerialized() const {
+  UnknownFieldSet* parsed = serialized_->parsed.load(std::memory_order_acquire);
+  if (PROTOBUF_PREDICT_TRUE(parsed != nullptr)) return *parsed;
+  // Several threads may decode the fields at once; the first to finish wins.
+  auto* decoded = new UnknownFieldSet;
+  ParseSerializedFields(serialized_->bytes, decoded);
+  if (serialized_->parsed.compare_exchange_strong(parsed, decoded,
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_acquire)) {
+    return *decoded;
   }
+  delete decoded;
+  return *parsed;
+}
+
+std::string* UnknownFieldSet::MutableSerializedBytes() {
+  if (serialized_ == nullptr) {
+    serialized_ = new SerializedFields;
+  } else if (serialized_->parsed.load(std::memory_order_relaxed) != nullptr) {
+    // More bytes are coming; the decoded fields are out of date.
+    delete serialized_->parsed.exchange(nullptr, std::memory_order_relaxed);
+  }
+  return &serialized_->bytes;
+}
+
+void UnknownFieldSet::InternalMergeFrom(const UnknownFieldSet& other) {
+  MergeFrom(other);
 }
 
 void UnknownFieldSet::MergeFrom(const UnknownFieldSet& other) {
-  int other_field_count = other.field_count();
-  if (other_field_count > 0) {
-    fields_.reserve(fields_.size() + other_field_count);
-    for (int i = 0; i < other_field_count; i++) {
-      fields_.push_back((other.fields_)[i]);
-      fields_.back().DeepCopy((other.fields_)[i]);
+  if (!other.fields_.empty()) {
+    FlushSerialized();
+    fields_.reserve(fields_.size() + other.fields_.size());
+    for (const UnknownField& field : other.fields_) {
+      fields_.push_back(field);
+      fields_.back().DeepCopy(field);
     }
   }
+  if (other.serialized_ != nullptr) {
+    MutableSerializedBytes()->append(other.serialized_->bytes);
+  }
 }
 
 // A specialized MergeFrom for performance when we are merging from an UFS that
 // is temporary and can be destroyed in the process.
 void UnknownFieldSet::MergeFromAndDestroy(UnknownFieldSet* other) {
-  if (fields_.empty()) {
-    fields_ = std::move(other->fields_);
-  } else {
-    fields_.insert(fields_.end(),
-                   std::make_move_iterator(other->fields_.begin()),
-                   std::make_move_iterator(other->fields_.end()));
+  if (!other->fields_.empty()) {
+    FlushSerialized();
+    if (fields_.empty()) {
+      fields_ = std::move(other->fields_);
+    } else {
+      fields_.insert(fields_.end(),
+                     std::make_move_iterator(other->fields_.begin()),
+                     std::make_move_iterator(other->fields_.end()));
+    }
+    other->fields_.clear();
+  }
+  if (other->serialized_ != nullptr) {
+    if (serialized_ == nullptr) {
+      std::swap(serialized_, other->serialized_);
+    } else {
+      MutableSerializedBytes()->append(other->serialized_->bytes);
+      delete other->serialized_;
+      other->serialized_ = nullptr;
+    }
   }
-  other->fields_.clear();
 }
 
 void UnknownFieldSet::MergeToInternalMetadata(
@@ -110,9 +178,14 @@ void UnknownFieldSet::MergeToInternalMetadata(
 }
 
 size_t UnknownFieldSet::SpaceUsedExcludingSelfLong() const {
-  if (fields_.empty()) return 0;
-
   size_t total_size = sizeof(UnknownField) * fields_.capacity();
+  if (serialized_ != nullptr) {
+    total_size += sizeof(*serialized_) +
+                  internal::StringSpaceUsedExcludingSelfLong(serialized_->bytes);
+    const UnknownFieldSet* parsed =
+        serialized_->parsed.load(std::memory_order_acquire);
+    if (parsed != nullptr) total_size += parsed->SpaceUsedLong();
+  }
 
   for (const UnknownField& field : fields_) {
     switch (field.type()) {
@@ -136,6 +209,7 @@ size_t UnknownFieldSet::SpaceUsedLong() const {
 }
 
 void UnknownFieldSet::AddVarint(int number, uint64_t value) {
+  FlushSerialized();
   fields_.emplace_back();
   auto& field = fields_.back();
   field.number_ = number;
@@ -144,6 +218,7 @@ void UnknownFieldSet::AddVarint(int number, uint64_t value) {
 }
 
 void UnknownFieldSet::AddFixed32(int number, uint32_t value) {
+  FlushSerialized();
   fields_.emplace_back();
   auto& field = fields_.back();
   field.number_ = number;
@@ -152,6 +227,7 @@ void UnknownFieldSet::AddFixed32(int number, uint32_t value) {
 }
 
 void UnknownFieldSet::AddFixed64(int number, uint64_t value) {
+  FlushSerialized();
   fields_.emplace_back();
   auto& field = fields_.back();
   field.number_ = number;
@@ -160,6 +236,7 @@ void UnknownFieldSet::AddFixed64(int number, uint64_t value) {
 }
 
 std::string* UnknownFieldSet::AddLengthDelimited(int number) {
+  FlushSerialized();
   fields_.emplace_back();
   auto& field = fields_.back();
   field.number_ = number;
@@ -170,6 +247,7 @@ std::string* UnknownFieldSet::AddLengthDelimited(int number) {
 
 
 UnknownFieldSet* UnknownFieldSet::AddGroup(int number) {
+  FlushSerialized();
   fields_.emplace_back();
   auto& field = fields_.back();
   field.number_ = number;
@@ -179,11 +257,29 @@ UnknownFieldSet* UnknownFieldSet::AddGroup(int number) {
 }
 
 void UnknownFieldSet::AddField(const UnknownField& field) {
+  FlushSerialized();
   fields_.push_back(field);
   fields_.back().DeepCopy(field);
 }
 
+void UnknownFieldSet::AddFields(const UnknownFieldSet& other, int start,
+                                int num) {
+  ABSL_DCHECK_GE(start, 0);
+  ABSL_DCHECK_GE(num, 0);
+  ABSL_DCHECK_LE(start + num, other.field_count());
+  FlushSerialized();
+  // After the reserve, other may alias this without push_back invalidating
+  // the field being copied.
+  fields_.reserve(fields_.size() + static_cast<size_t>(num));
+  for (int i = 0; i < num; ++i) {
+    const UnknownField& field = other.field(start + i);
+    fields_.push_back(field);
+    fields_.back().DeepCopy(field);
+  }
+}
+
 void UnknownFieldSet::DeleteSubrange(int start, int num) {
+  FlushSerialized();
   // Delete the specified fields.
   for (int i = 0; i < num; ++i) {
     (fields_)[i + start].Delete();
@@ -199,6 +295,7 @@ void UnknownFieldSet::DeleteSubrange(int start, int num) {
 }
 
 void UnknownFieldSet::DeleteByNumber(int number) {
+  FlushSerialized();
   size_t left = 0;  // The number of fields left after deletion.
   for (size_t i = 0; i < fields_.size(); ++i) {
     UnknownField* field = &(fields_)[i];
@@ -341,6 +438,11 @@ class UnknownFieldParserHelper {
     return WireFormatParser(*this, ptr, ctx);
   }
 
+  // Appends the field, still serialized, to the set's serialized fields.
+  const char* ParseLazily(uint32_t tag, const char* ptr, ParseContext* ctx) {
+    return UnknownFieldParse(tag, unknown_->MutableSerializedBytes(), ptr, ctx);
+  }
+
  private:
   UnknownFieldSet* unknown_;
 };
@@ -354,6 +456,9 @@ const char* UnknownGroupParse(UnknownFieldSet* unknown, const char* ptr,
 const char* UnknownFieldParse(uint64_t tag, UnknownFieldSet* unknown,
                               const char* ptr, ParseContext* ctx) {
   UnknownFieldParserHelper field_parser(unknown);
+  if (parse_lazily.load(std::memory_order_relaxed)) {
+    return field_parser.ParseLazily(static_cast<uint32_t>(tag), ptr, ctx);
+  }
   return FieldParser(tag, field_parser, ptr, ctx);
 }
 
@@ -40,7 +40,9 @@
 
 #include <assert.h>
 
+#include <atomic>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/stubs/common.h"
@@ -64,6 +66,7 @@ namespace protobuf {
 namespace internal {
 class InternalMetadata;           // metadata_lite.h
 class WireFormat;                 // wire_format.h
+class UnknownFieldParserHelper;   // unknown_field_set.cc
 class MessageSetFieldSkipperUsingCord;
 // extension_set_heavy.cc
 }  // namespace internal
@@ -105,6 +108,10 @@ class PROTOBUF_EXPORT UnknownFieldSet {
   // Similar to above, but this function will destroy the contents of other.
   void MergeFromAndDestroy(UnknownFieldSet* other);
 
+  // Merge the contents of some other UnknownFieldSet with this one, taking
+  // over its fields rather than copying them.  other is left empty.
+  void MergeFrom(UnknownFieldSet&& other) { MergeFromAndDestroy(&other); }
+
   // Merge the contents an UnknownFieldSet with the UnknownFieldSet in
   // *metadata, if there is one.  If *metadata doesn't have an UnknownFieldSet
   // then add one to it and make it be a copy of the first arg.
@@ -150,6 +157,10 @@ class PROTOBUF_EXPORT UnknownFieldSet {
   // Adds an unknown field from another set.
   void AddField(const UnknownField& field);
 
+  // Adds the fields of another set with indices [start .. start+num-1],
+  // growing this set only once for all of them.
+  void AddFields(const UnknownFieldSet& other, int start, int num);
+
   // Delete fields with indices in the range [start .. start+num-1].
   // Caution: implementation moves all fields with indices [start+num .. ].
   void DeleteSubrange(int start, int num);
@@ -159,6 +170,15 @@ class PROTOBUF_EXPORT UnknownFieldSet {
   // Caution: implementation moves all fields after the first deleted field.
   void DeleteByNumber(int number);
 
+  // If enabled, parsing a message keeps its unknown fields in their
+  // serialized form and decodes them into UnknownFields only when they are
+  // first accessed through field_count(), field() or a mutating method.
+  // Messages that are serialized again without their unknown fields being
+  // looked at, as by a proxy, then don't pay for an UnknownField and a heap
+  // allocated string per field.  Decoding on const access is thread-safe.
+  // This applies to all messages parsed in the process, and is off by default.
+  static void SetParseLazily(bool lazy);
+
   // Parsing helpers -------------------------------------------------
   // These work exactly like the similarly-named methods of Message.
 
@@ -185,11 +205,37 @@ class PROTOBUF_EXPORT UnknownFieldSet {
  private:
   // For InternalMergeFrom
   friend class UnknownField;
+  // For the serialized fields.
+  friend class internal::UnknownFieldParserHelper;
+  friend class internal::WireFormat;
+
+  // Fields kept in serialized form by a lazy parse.  They logically follow
+  // the fields in fields_.
+  struct SerializedFields {
+    ~SerializedFields() { delete parsed.load(std::memory_order_relaxed); }
+
+    std::string bytes;
+    // The fields in `bytes`, decoded by the first const access that needs
+    // them.
+    std::atomic<UnknownFieldSet*> parsed{nullptr};
+  };
+
   // Merges from other UnknownFieldSet. This method assumes, that this object
   // is newly created and has no fields.
   void InternalMergeFrom(const UnknownFieldSet& other);
   void ClearFallback();
 
+  // Decodes any serialized fields and appends them to fields_.
+  void FlushSerialized() {
+    if (PROTOBUF_PREDICT_FALSE(serialized_ != nullptr)) FlushSerializedSlow();
+  }
+  void FlushSerializedSlow();
+  // Returns the serialized fields, decoding them if needed.  Requires
+  // serialized_ != nullptr.
+  const UnknownFieldSet& ParsedSerialized() const;
+  // Returns the bytes that serialized fields are appended to by a lazy parse.
+  std::string* MutableSerializedBytes();
+
   template <typename MessageType,
             typename std::enable_if<
                 std::is_base_of<Message, MessageType>::value, int>::type = 0>
@@ -212,6 +258,7 @@ class PROTOBUF_EXPORT UnknownFieldSet {
   }
 
   std::vector<UnknownField> fields_;
+  SerializedFields* serialized_ = nullptr;
 };
 
 namespace internal {
@@ -306,24 +353,37 @@ inline UnknownFieldSet::~UnknownFieldSet() { Clear(); }
 inline void UnknownFieldSet::ClearAndFreeMemory() { Clear(); }
 
 inline void UnknownFieldSet::Clear() {
-  if (!fields_.empty()) {
+  if (!fields_.empty() || serialized_ != nullptr) {
     ClearFallback();
   }
 }
 
-inline bool UnknownFieldSet::empty() const { return fields_.empty(); }
+inline bool UnknownFieldSet::empty() const {
+  return fields_.empty() && serialized_ == nullptr;
+}
 
 inline void UnknownFieldSet::Swap(UnknownFieldSet* x) {
   fields_.swap(x->fields_);
+  std::swap(serialized_, x->serialized_);
 }
 
 inline int UnknownFieldSet::field_count() const {
+  if (PROTOBUF_PREDICT_FALSE(serialized_ != nullptr)) {
+    return static_cast<int>(fields_.size() +
+                            ParsedSerialized().fields_.size());
+  }
   return static_cast<int>(fields_.size());
 }
 inline const UnknownField& UnknownFieldSet::field(int index) const {
+  if (PROTOBUF_PREDICT_FALSE(serialized_ != nullptr) &&
+      static_cast<size_t>(index) >= fields_.size()) {
+    return ParsedSerialized()
+        .fields_[static_cast<size_t>(index) - fields_.size()];
+  }
   return (fields_)[static_cast<size_t>(index)];
 }
 inline UnknownField* UnknownFieldSet::mutable_field(int index) {
+  FlushSerialized();
   return &(fields_)[static_cast<size_t>(index)];
 }
 
@@ -38,6 +38,8 @@
 #include "google/protobuf/unknown_field_set.h"
 
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/stubs/callback.h"
@@ -51,6 +53,7 @@
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "google/protobuf/arena.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
@@ -119,6 +122,20 @@ class UnknownFieldSetTest : public testing::Test {
   UnknownFieldSet* unknown_fields_;
 };
 
+// Like UnknownFieldSetTest, but empty_message_ keeps its unknown fields
+// serialized.  eager_message_ is parsed from the same data as usual.
+class LazyUnknownFieldSetTest : public UnknownFieldSetTest {
+ protected:
+  void SetUp() override {
+    UnknownFieldSet::SetParseLazily(true);
+    UnknownFieldSetTest::SetUp();
+    UnknownFieldSet::SetParseLazily(false);
+    ASSERT_TRUE(eager_message_.ParseFromString(all_fields_data_));
+  }
+
+  unittest::TestEmptyMessage eager_message_;
+};
+
 namespace {
 
 TEST_F(UnknownFieldSetTest, AllFieldsPresent) {
@@ -320,6 +337,72 @@ TEST_F(UnknownFieldSetTest, MergeFrom) {
       destination_text);
 }
 
+TEST_F(UnknownFieldSetTest, MergeFromRvalue) {
+  UnknownFieldSet source, destination;
+  destination.AddVarint(1, 1);
+  source.AddVarint(2, 2);
+  source.AddLengthDelimited(3, "payload");
+  const std::string* payload = &source.field(1).length_delimited();
+
+  destination.MergeFrom(std::move(source));
+
+  EXPECT_TRUE(source.empty());
+  ASSERT_EQ(3, destination.field_count());
+  EXPECT_EQ(1, destination.field(0).number());
+  EXPECT_EQ(2, destination.field(1).number());
+  EXPECT_EQ("payload", destination.field(2).length_delimited());
+  // The payload was moved over, not copied.
+  EXPECT_EQ(payload, &destination.field(2).length_delimited());
+}
+
+TEST_F(UnknownFieldSetTest, AddFields) {
+  UnknownFieldSet source, destination;
+  source.AddVarint(1, 1);
+  source.AddLengthDelimited(2, "two");
+  source.AddVarint(3, 3);
+  source.AddGroup(4)->AddVarint(5, 5);
+
+  destination.AddFields(source, 1, 3);
+  ASSERT_EQ(3, destination.field_count());
+  EXPECT_EQ("two", destination.field(0).length_delimited());
+  EXPECT_NE(&source.field(1).length_delimited(),
+            &destination.field(0).length_delimited());
+  EXPECT_EQ(3, destination.field(1).varint());
+  EXPECT_EQ(5, destination.field(2).group().field(0).varint());
+
+  // Adding a range of the set to itself.
+  destination.AddFields(destination, 0, 3);
+  ASSERT_EQ(6, destination.field_count());
+  EXPECT_EQ("two", destination.field(3).length_delimited());
+  EXPECT_EQ(5, destination.field(5).group().field(0).varint());
+  EXPECT_EQ(4, source.field_count());
+}
+
+TEST_F(UnknownFieldSetTest, SwapAcrossArenasMovesUnknownFields) {
+  Arena arena;
+  auto* arena_message =
+      Arena::CreateMessage<unittest::TestEmptyMessage>(&arena);
+  arena_message->mutable_unknown_fields()->AddLengthDelimited(1, "arena");
+  unittest::TestEmptyMessage heap_message;
+  heap_message.mutable_unknown_fields()->AddLengthDelimited(2, "heap");
+  const std::string* arena_payload =
+      &arena_message->unknown_fields().field(0).length_delimited();
+  const std::string* heap_payload =
+      &heap_message.unknown_fields().field(0).length_delimited();
+
+  heap_message.GetReflection()->Swap(arena_message, &heap_message);
+
+  ASSERT_EQ(1, arena_message->unknown_fields().field_count());
+  ASSERT_EQ(1, heap_message.unknown_fields().field_count());
+  EXPECT_EQ("heap",
+            arena_message->unknown_fields().field(0).length_delimited());
+  EXPECT_EQ("arena", heap_message.unknown_fields().field(0).length_delimited());
+  EXPECT_EQ(heap_payload,
+            &arena_message->unknown_fields().field(0).length_delimited());
+  EXPECT_EQ(arena_payload,
+            &heap_message.unknown_fields().field(0).length_delimited());
+}
+
 TEST_F(UnknownFieldSetTest, MergeFromMessage) {
   unittest::TestEmptyMessage source, destination;
 
@@ -754,6 +837,71 @@ TEST_F(UnknownFieldSetTest, SerializeToCord_TestPackedTypes) {
   EXPECT_THAT(message.packed_uint64(), ElementsAre(5, 6, 7));
 }
 
+TEST_F(LazyUnknownFieldSetTest, SerializeWithoutDecoding) {
+  EXPECT_FALSE(empty_message_.unknown_fields().empty());
+  EXPECT_EQ(all_fields_data_.size(), empty_message_.ByteSizeLong());
+  EXPECT_EQ(all_fields_data_, empty_message_.SerializeAsString());
+  EXPECT_LT(empty_message_.unknown_fields().SpaceUsedExcludingSelfLong(),
+            eager_message_.unknown_fields().SpaceUsedExcludingSelfLong());
+
+  // Reading the fields decodes them, but serialization still uses the bytes.
+  EXPECT_EQ(eager_message_.DebugString(), empty_message_.DebugString());
+  EXPECT_EQ(eager_message_.unknown_fields().field_count(),
+            unknown_fields_->field_count());
+  EXPECT_EQ(all_fields_data_, empty_message_.SerializeAsString());
+}
+
+TEST_F(LazyUnknownFieldSetTest, Modify) {
+  for (auto* message : {&empty_message_, &eager_message_}) {
+    UnknownFieldSet* unknown_fields = message->mutable_unknown_fields();
+    unknown_fields->AddVarint(123456, 1);
+    unknown_fields->DeleteByNumber(
+        unittest::TestAllTypes::kOptionalInt32FieldNumber);
+    unknown_fields->mutable_field(0)->set_varint(7);
+  }
+  EXPECT_EQ(eager_message_.unknown_fields().field_count(),
+            unknown_fields_->field_count());
+  EXPECT_EQ(eager_message_.SerializeAsString(),
+            empty_message_.SerializeAsString());
+  EXPECT_EQ(eager_message_.DebugString(), empty_message_.DebugString());
+
+  empty_message_.Clear();
+  EXPECT_TRUE(empty_message_.unknown_fields().empty());
+  EXPECT_EQ(0, empty_message_.ByteSizeLong());
+}
+
+TEST_F(LazyUnknownFieldSetTest, MergeAndSwap) {
+  unittest::TestEmptyMessage message;
+  message.mutable_unknown_fields()->AddVarint(123456, 1);
+  message.MergeFrom(empty_message_);
+  message.MergeFrom(empty_message_);
+
+  unittest::TestEmptyMessage expected;
+  expected.mutable_unknown_fields()->AddVarint(123456, 1);
+  expected.MergeFrom(eager_message_);
+  expected.MergeFrom(eager_message_);
+  EXPECT_EQ(expected.SerializeAsString(), message.SerializeAsString());
+  EXPECT_EQ(expected.DebugString(), message.DebugString());
+
+  message.Swap(&empty_message_);
+  EXPECT_EQ(eager_message_.DebugString(), message.DebugString());
+  EXPECT_EQ(expected.DebugString(), empty_message_.DebugString());
+}
+
+TEST_F(LazyUnknownFieldSetTest, ConcurrentReads) {
+  const UnknownFieldSet& unknown_fields = empty_message_.unknown_fields();
+  std::vector<const UnknownField*> seen(4);
+  std::vector<std::thread> threads;
+  for (auto& result : seen) {
+    threads.emplace_back([&unknown_fields, &result] {
+      result = &unknown_fields.field(unknown_fields.field_count() - 1);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (const UnknownField* result : seen) EXPECT_EQ(seen[0], result);
+  EXPECT_EQ(eager_message_.DebugString(), empty_message_.DebugString());
+}
+
 }  // namespace
 
 }  // namespace protobuf
@@ -34,6 +34,10 @@
 #include "google/protobuf/util/delimited_message_util.h"
 
 #include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/parse_context.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
 
 namespace google {
 namespace protobuf {
@@ -94,6 +98,33 @@ bool ParseDelimitedFromCodedStream(MessageLite* message,
   return true;
 }
 
+bool ParseDelimitedBatchFromZeroCopyStream(
+    int max_messages, io::ZeroCopyInputStream* input,
+    absl::FunctionRef<MessageLite*()> new_message, bool* clean_eof) {
+  if (clean_eof != nullptr) *clean_eof = false;
+  const char* ptr;
+  internal::ParseContext ctx(io::CodedInputStream::GetDefaultRecursionLimit(),
+                             false, &ptr, input);
+  for (int i = 0; i < max_messages; ++i) {
+    if (ctx.Done(&ptr)) {
+      if (ptr == nullptr) return false;
+      if (clean_eof != nullptr) *clean_eof = true;
+      break;
+    }
+    // The whole batch shares the parse context, so each message only costs
+    // a limit push and pop on it.
+    MessageLite* message = new_message();
+    ptr = ctx.ParseMessage(message, ptr);
+    if (PROTOBUF_PREDICT_FALSE(ptr == nullptr)) return false;
+    if (PROTOBUF_PREDICT_FALSE(!message->IsInitialized())) {
+      ctx.BackUp(ptr);
+      return false;
+    }
+  }
+  ctx.BackUp(ptr);
+  return true;
+}
+
 bool SerializeDelimitedToZeroCopyStream(const MessageLite& message,
                                         io::ZeroCopyOutputStream* output) {
   io::CodedOutputStream coded_output(output);
@@ -127,3 +158,5 @@ bool SerializeDelimitedToCodedStream(const MessageLite& message,
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
+
+#include "google/protobuf/port_undef.inc"
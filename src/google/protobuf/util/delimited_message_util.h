@@ -36,9 +36,11 @@
 
 #include <ostream>
 
+#include "absl/functional/function_ref.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/repeated_ptr_field.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -88,6 +90,32 @@ bool PROTOBUF_EXPORT ParseDelimitedFromCodedStream(MessageLite* message,
                                                    io::CodedInputStream* input,
                                                    bool* clean_eof);
 
+// Reads up to |max_messages| consecutive size-delimited messages from the
+// given stream, parsing each into the message returned by a call to
+// |new_message|. All messages are parsed in a single parse session, which is
+// much cheaper than calling ParseDelimitedFromZeroCopyStream() once per
+// message when the messages are small. Data after the last message read is
+// left in the stream.
+//
+// Returns false if the data is malformed or a message is missing required
+// fields; the last message handed out may then be partially parsed. If the
+// stream ends cleanly before |max_messages| messages were read, returns true
+// and sets |*clean_eof| (if not NULL) to true.
+bool PROTOBUF_EXPORT ParseDelimitedBatchFromZeroCopyStream(
+    int max_messages, io::ZeroCopyInputStream* input,
+    absl::FunctionRef<MessageLite*()> new_message, bool* clean_eof);
+
+// As above, appending the messages to |messages|. If |messages| is on an
+// arena, so are the parsed messages.
+template <typename T>
+bool ParseDelimitedBatchFromZeroCopyStream(RepeatedPtrField<T>* messages,
+                                           int max_messages,
+                                           io::ZeroCopyInputStream* input,
+                                           bool* clean_eof) {
+  return ParseDelimitedBatchFromZeroCopyStream(
+      max_messages, input, [messages] { return messages->Add(); }, clean_eof);
+}
+
 // Write a single size-delimited message from the given stream. Delimited
 // format allows a single file or stream to contain multiple messages,
 // whereas normally writing multiple non-delimited messages to the same
@@ -34,9 +34,13 @@
 #include "google/protobuf/util/delimited_message_util.h"
 
 #include <sstream>
+#include <string>
 
 #include "google/protobuf/testing/googletest.h"
 #include <gtest/gtest.h>
+#include "google/protobuf/arena.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/repeated_ptr_field.h"
 #include "google/protobuf/test_util.h"
 #include "google/protobuf/unittest.pb.h"
 
@@ -111,6 +115,60 @@ TEST(DelimitedMessageUtilTest, FailsAtEndOfStream) {
   }
 }
 
+TEST(DelimitedMessageUtilTest, ParseBatch) {
+  std::string data;
+  {
+    io::StringOutputStream output(&data);
+    for (int i = 0; i < 5; ++i) {
+      protobuf_unittest::ForeignMessage message;
+      message.set_c(i);
+      EXPECT_TRUE(SerializeDelimitedToZeroCopyStream(message, &output));
+    }
+  }
+
+  // Small blocks make the messages straddle buffer boundaries.
+  io::ArrayInputStream input(data.data(), static_cast<int>(data.size()), 3);
+  Arena arena;
+  auto* messages = Arena::CreateMessage<
+      RepeatedPtrField<protobuf_unittest::ForeignMessage>>(&arena);
+  bool clean_eof = true;
+  EXPECT_TRUE(
+      ParseDelimitedBatchFromZeroCopyStream(messages, 3, &input, &clean_eof));
+  EXPECT_FALSE(clean_eof);
+  ASSERT_EQ(messages->size(), 3);
+  EXPECT_EQ(messages->Get(2).c(), 2);
+  EXPECT_EQ(messages->Get(2).GetArena(), &arena);
+
+  // The batch left the rest of the stream in place.
+  protobuf_unittest::ForeignMessage next;
+  EXPECT_TRUE(ParseDelimitedFromZeroCopyStream(&next, &input, &clean_eof));
+  EXPECT_EQ(next.c(), 3);
+
+  EXPECT_TRUE(
+      ParseDelimitedBatchFromZeroCopyStream(messages, 3, &input, &clean_eof));
+  EXPECT_TRUE(clean_eof);
+  ASSERT_EQ(messages->size(), 4);
+  EXPECT_EQ(messages->Get(3).c(), 4);
+}
+
+TEST(DelimitedMessageUtilTest, ParseBatchFailsOnTruncatedMessage) {
+  std::string data;
+  {
+    io::StringOutputStream output(&data);
+    protobuf_unittest::ForeignMessage message;
+    message.set_c(42);
+    EXPECT_TRUE(SerializeDelimitedToZeroCopyStream(message, &output));
+  }
+  data.pop_back();
+
+  io::ArrayInputStream input(data.data(), static_cast<int>(data.size()));
+  RepeatedPtrField<protobuf_unittest::ForeignMessage> messages;
+  bool clean_eof = true;
+  EXPECT_FALSE(
+      ParseDelimitedBatchFromZeroCopyStream(&messages, 2, &input, &clean_eof));
+  EXPECT_FALSE(clean_eof);
+}
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
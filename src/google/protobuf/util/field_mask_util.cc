@@ -33,9 +33,11 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/log/die_if_null.h"
@@ -44,7 +46,9 @@
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/message.h"
+#include "google/protobuf/wire_reader.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -182,6 +186,85 @@ void FieldMaskUtil::GetFieldMaskForAllFields(const Descriptor* descriptor,
 }
 
 namespace {
+
+// Merges 'field' from 'source' into 'destination', as selected by a leaf of
+// a FieldMask.
+void MergeField(const FieldDescriptor* field, const Message& source,
+                const FieldMaskUtil::MergeOptions& options,
+                Message* destination) {
+  const Reflection* source_reflection = source.GetReflection();
+  const Reflection* destination_reflection = destination->GetReflection();
+  if (!field->is_repeated()) {
+    switch (field->cpp_type()) {
+#define COPY_VALUE(TYPE, Name)                                              \
+  case FieldDescriptor::CPPTYPE_##TYPE: {                                   \
+    if (source_reflection->HasField(source, field)) {                       \
+      destination_reflection->Set##Name(                                    \
+          destination, field, source_reflection->Get##Name(source, field)); \
+    } else {                                                                \
+      destination_reflection->ClearField(destination, field);               \
+    }                                                                       \
+    break;                                                                  \
+  }
+      COPY_VALUE(BOOL, Bool)
+      COPY_VALUE(INT32, Int32)
+      COPY_VALUE(INT64, Int64)
+      COPY_VALUE(UINT32, UInt32)
+      COPY_VALUE(UINT64, UInt64)
+      COPY_VALUE(FLOAT, Float)
+      COPY_VALUE(DOUBLE, Double)
+      COPY_VALUE(ENUM, Enum)
+      COPY_VALUE(STRING, String)
+#undef COPY_VALUE
+      case FieldDescriptor::CPPTYPE_MESSAGE: {
+        if (options.replace_message_fields()) {
+          destination_reflection->ClearField(destination, field);
+        }
+        if (source_reflection->HasField(source, field)) {
+          destination_reflection->MutableMessage(destination, field)
+              ->MergeFrom(source_reflection->GetMessage(source, field));
+        }
+        break;
+      }
+    }
+  } else {
+    if (options.replace_repeated_fields()) {
+      destination_reflection->ClearField(destination, field);
+    }
+    switch (field->cpp_type()) {
+#define COPY_REPEATED_VALUE(TYPE, Name)                            \
+  case FieldDescriptor::CPPTYPE_##TYPE: {                          \
+    int size = source_reflection->FieldSize(source, field);        \
+    for (int i = 0; i < size; ++i) {                               \
+      destination_reflection->Add##Name(                           \
+          destination, field,                                      \
+          source_reflection->GetRepeated##Name(source, field, i)); \
+    }                                                              \
+    break;                                                         \
+  }
+      COPY_REPEATED_VALUE(BOOL, Bool)
+      COPY_REPEATED_VALUE(INT32, Int32)
+      COPY_REPEATED_VALUE(INT64, Int64)
+      COPY_REPEATED_VALUE(UINT32, UInt32)
+      COPY_REPEATED_VALUE(UINT64, UInt64)
+      COPY_REPEATED_VALUE(FLOAT, Float)
+      COPY_REPEATED_VALUE(DOUBLE, Double)
+      COPY_REPEATED_VALUE(ENUM, Enum)
+      COPY_REPEATED_VALUE(STRING, String)
+#undef COPY_REPEATED_VALUE
+      case FieldDescriptor::CPPTYPE_MESSAGE: {
+        int size = source_reflection->FieldSize(source, field);
+        for (int i = 0; i < size; ++i) {
+          destination_reflection->AddMessage(destination, field)
+              ->MergeFrom(
+                  source_reflection->GetRepeatedMessage(source, field, i));
+        }
+        break;
+      }
+    }
+  }
+}
+
 // A FieldMaskTree represents a FieldMask in a tree structure. For example,
 // given a FieldMask "foo.bar,foo.baz,bar.baz", the FieldMaskTree will be:
 //
@@ -255,7 +338,6 @@ class FieldMaskTree {
     return TrimMessage(&root_, message);
   }
 
- private:
   struct Node {
     Node() = default;
     Node(const Node&) = delete;
@@ -270,6 +352,9 @@ class FieldMaskTree {
     absl::btree_map<std::string, std::unique_ptr<Node>> children;
   };
 
+  const Node& root() const { return root_; }
+
+ private:
   // Merge a sub-tree to mask. This method adds the field paths represented
   // by all leaf nodes descended from "node" to mask.
   void MergeToFieldMask(absl::string_view prefix, const Node* node,
@@ -477,75 +562,7 @@ void FieldMaskTree::MergeMessage(const Node* node, const Message& source,
                    destination_reflection->MutableMessage(destination, field));
       continue;
     }
-    if (!field->is_repeated()) {
-      switch (field->cpp_type()) {
-#define COPY_VALUE(TYPE, Name)                                              \
-  case FieldDescriptor::CPPTYPE_##TYPE: {                                   \
-    if (source_reflection->HasField(source, field)) {                       \
-      destination_reflection->Set##Name(                                    \
-          destination, field, source_reflection->Get##Name(source, field)); \
-    } else {                                                                \
-      destination_reflection->ClearField(destination, field);               \
-    }                                                                       \
-    break;                                                                  \
-  }
-        COPY_VALUE(BOOL, Bool)
-        COPY_VALUE(INT32, Int32)
-        COPY_VALUE(INT64, Int64)
-        COPY_VALUE(UINT32, UInt32)
-        COPY_VALUE(UINT64, UInt64)
-        COPY_VALUE(FLOAT, Float)
-        COPY_VALUE(DOUBLE, Double)
-        COPY_VALUE(ENUM, Enum)
-        COPY_VALUE(STRING, String)
-#undef COPY_VALUE
-        case FieldDescriptor::CPPTYPE_MESSAGE: {
-          if (options.replace_message_fields()) {
-            destination_reflection->ClearField(destination, field);
-          }
-          if (source_reflection->HasField(source, field)) {
-            destination_reflection->MutableMessage(destination, field)
-                ->MergeFrom(source_reflection->GetMessage(source, field));
-          }
-          break;
-        }
-      }
-    } else {
-      if (options.replace_repeated_fields()) {
-        destination_reflection->ClearField(destination, field);
-      }
-      switch (field->cpp_type()) {
-#define COPY_REPEATED_VALUE(TYPE, Name)                            \
-  case FieldDescriptor::CPPTYPE_##TYPE: {                          \
-    int size = source_reflection->FieldSize(source, field);        \
-    for (int i = 0; i < size; ++i) {                               \
-      destination_reflection->Add##Name(                           \
-          destination, field,                                      \
-          source_reflection->GetRepeated##Name(source, field, i)); \
-    }                                                              \
-    break;                                                         \
-  }
-        COPY_REPEATED_VALUE(BOOL, Bool)
-        COPY_REPEATED_VALUE(INT32, Int32)
-        COPY_REPEATED_VALUE(INT64, Int64)
-        COPY_REPEATED_VALUE(UINT32, UInt32)
-        COPY_REPEATED_VALUE(UINT64, UInt64)
-        COPY_REPEATED_VALUE(FLOAT, Float)
-        COPY_REPEATED_VALUE(DOUBLE, Double)
-        COPY_REPEATED_VALUE(ENUM, Enum)
-        COPY_REPEATED_VALUE(STRING, String)
-#undef COPY_REPEATED_VALUE
-        case FieldDescriptor::CPPTYPE_MESSAGE: {
-          int size = source_reflection->FieldSize(source, field);
-          for (int i = 0; i < size; ++i) {
-            destination_reflection->AddMessage(destination, field)
-                ->MergeFrom(
-                    source_reflection->GetRepeatedMessage(source, field, i));
-          }
-          break;
-        }
-      }
-    }
+    MergeField(field, source, options, destination);
   }
 }
 
@@ -619,6 +636,247 @@ bool FieldMaskTree::TrimMessage(const Node* node, Message* message) {
 
 }  // namespace
 
+// The paths of a CompiledFieldMask below one message. Names the message type
+// does not have are kept for IsPathInFieldMask(), which matches by name.
+struct FieldMaskUtil::CompiledFieldMask::Node {
+  // Compiles the subtree 'tree' of a FieldMaskTree against 'descriptor',
+  // which is null below fields that are not messages.
+  template <typename TreeNode>
+  void Build(const Descriptor* descriptor, const TreeNode& tree) {
+    if (descriptor != nullptr) selected.resize(descriptor->field_count());
+    for (const auto& kv : tree.children) {
+      const FieldDescriptor* field =
+          descriptor == nullptr ? nullptr
+                                : descriptor->FindFieldByName(kv.first);
+      std::unique_ptr<Node>& child = by_name[kv.first];
+      if (!kv.second->children.empty()) {
+        child = absl::make_unique<Node>();
+        child->Build(field == nullptr ? nullptr : field->message_type(),
+                     *kv.second);
+      }
+      if (field == nullptr) continue;
+      selected[field->index()] = true;
+      fields.emplace_back(field, child.get());
+    }
+  }
+
+  bool Contains(absl::string_view path) const {
+    const Node* node = this;
+    for (absl::string_view name : absl::StrSplit(path, '.')) {
+      auto it = node->by_name.find(name);
+      if (it == node->by_name.end()) return false;
+      if (it->second == nullptr) return true;
+      node = it->second.get();
+    }
+    // Parent paths are not covered by their children.
+    return false;
+  }
+
+  void Merge(const Message& source, const FieldMaskUtil::MergeOptions& options,
+             Message* destination) const {
+    const Reflection* source_reflection = source.GetReflection();
+    const Reflection* destination_reflection = destination->GetReflection();
+    for (const auto& field_and_child : fields) {
+      const FieldDescriptor* field = field_and_child.first;
+      const Node* child = field_and_child.second;
+      if (child == nullptr) {
+        MergeField(field, source, options, destination);
+      } else if (!field->is_repeated() &&
+                 field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+        child->Merge(
+            source_reflection->GetMessage(source, field), options,
+            destination_reflection->MutableMessage(destination, field));
+      }
+    }
+  }
+
+  bool Trim(Message* message) const {
+    const Reflection* reflection = message->GetReflection();
+    const Descriptor* descriptor = message->GetDescriptor();
+    bool modified = false;
+    for (int index = 0; index < descriptor->field_count(); ++index) {
+      if (selected[index]) continue;
+      const FieldDescriptor* field = descriptor->field(index);
+      if (field->is_repeated() ? reflection->FieldSize(*message, field) != 0
+                               : reflection->HasField(*message, field)) {
+        modified = true;
+      }
+      reflection->ClearField(message, field);
+    }
+    for (const auto& field_and_child : fields) {
+      const FieldDescriptor* field = field_and_child.first;
+      const Node* child = field_and_child.second;
+      if (child != nullptr && !field->is_repeated() &&
+          field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+          reflection->HasField(*message, field)) {
+        modified = child->Trim(reflection->MutableMessage(message, field)) ||
+                   modified;
+      }
+    }
+    return modified;
+  }
+
+  // What is selected below each name: null for everything.
+  absl::flat_hash_map<std::string, std::unique_ptr<Node>> by_name;
+  // The selected fields of the message type, in name order, with what is
+  // selected below them.
+  std::vector<std::pair<const FieldDescriptor*, const Node*>> fields;
+  // Whether each field of the message type, by index, is selected.
+  std::vector<bool> selected;
+};
+
+FieldMaskUtil::CompiledFieldMask::CompiledFieldMask(
+    const Descriptor* descriptor, const FieldMask& mask)
+    : descriptor_(ABSL_DIE_IF_NULL(descriptor)) {
+  FieldMaskTree tree;
+  tree.MergeFromFieldMask(mask);
+  if (tree.root().children.empty()) return;
+  root_ = absl::make_unique<Node>();
+  root_->Build(descriptor, tree.root());
+  tree.AddRequiredFieldPath(descriptor);
+  root_with_required_ = absl::make_unique<Node>();
+  root_with_required_->Build(descriptor, tree.root());
+}
+
+FieldMaskUtil::CompiledFieldMask::~CompiledFieldMask() {}
+
+// Maps the selected field numbers of a message to the projection of their
+// own fields. A null child selects the field with everything below it.
+struct FieldMaskUtil::ParseProjection::Node {
+  explicit Node(const Descriptor* descriptor) : descriptor(descriptor) {}
+
+  // Copies the records of the message 'data' that this node selects to
+  // 'out', filtering length-delimited records that have a projection of
+  // their own. With 'keep_unknown', records of fields that 'descriptor' does
+  // not have, such as unknown fields and extensions, are copied as well.
+  bool Filter(absl::string_view data, bool keep_unknown,
+              std::string* out) const;
+
+  const Descriptor* descriptor;
+  absl::flat_hash_map<int, std::unique_ptr<Node>> children;
+};
+
+namespace {
+
+// Builds the projection tree of 'mask' under 'root'. Paths are only followed
+// into fields with a message type. A sub-path of any other field names no
+// field, so the path is ignored, unless 'keep_scalar_subpaths' is set, in which
+// case the field is selected as a whole, as TrimMessage() keeps it.
+template <typename Node>
+void AddProjectionPaths(const FieldMask& mask, bool keep_scalar_subpaths,
+                        Node* root) {
+  for (const std::string& path : mask.paths()) {
+    Node* node = root;
+    std::vector<absl::string_view> parts = absl::StrSplit(path, '.');
+    for (size_t i = 0; i < parts.size(); ++i) {
+      const FieldDescriptor* field =
+          node->descriptor->FindFieldByName(parts[i]);
+      if (field == nullptr) break;
+      auto it = node->children.find(field->number());
+      if (it != node->children.end() && it->second == nullptr) {
+        // Already selected as a whole.
+        break;
+      }
+      if (i + 1 == parts.size()) {
+        node->children[field->number()] = nullptr;
+        break;
+      }
+      if (field->message_type() == nullptr) {
+        if (keep_scalar_subpaths) node->children[field->number()] = nullptr;
+        break;
+      }
+      if (it == node->children.end()) {
+        it = node->children
+                 .emplace(field->number(),
+                          absl::make_unique<Node>(field->message_type()))
+                 .first;
+      }
+      node = it->second.get();
+    }
+  }
+}
+
+}  // namespace
+
+FieldMaskUtil::ParseProjection::ParseProjection(const Descriptor* descriptor,
+                                                const FieldMask& mask)
+    : descriptor_(ABSL_DIE_IF_NULL(descriptor)) {
+  if (mask.paths().empty()) return;
+  root_ = absl::make_unique<Node>(descriptor);
+  AddProjectionPaths(mask, /*keep_scalar_subpaths=*/false, root_.get());
+  trim_root_ = absl::make_unique<Node>(descriptor);
+  AddProjectionPaths(mask, /*keep_scalar_subpaths=*/true, trim_root_.get());
+}
+
+FieldMaskUtil::ParseProjection::~ParseProjection() {}
+
+namespace {
+
+void AppendVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+}  // namespace
+
+bool FieldMaskUtil::ParseProjection::Node::Filter(absl::string_view data,
+                                                 bool keep_unknown,
+                                                 std::string* out) const {
+  WireReader reader(data);
+  size_t start = 0;
+  while (reader.Next()) {
+    const size_t end = data.size() - reader.remaining().size();
+    auto it = children.find(reader.field_number());
+    if (it != children.end() && it->second != nullptr &&
+        reader.wire_type() == WireReader::kLengthDelimited) {
+      std::string filtered;
+      if (!it->second->Filter(reader.bytes(), keep_unknown, &filtered)) {
+        return false;
+      }
+      AppendVarint(reader.tag(), out);
+      AppendVarint(filtered.size(), out);
+      out->append(filtered);
+    } else if (it != children.end() ||
+               (keep_unknown &&
+                descriptor->FindFieldByNumber(reader.field_number()) ==
+                    nullptr)) {
+      out->append(data.data() + start, end - start);
+    }
+    start = end;
+  }
+  return !reader.failed();
+}
+
+bool FieldMaskUtil::MergeProjectedFromString(absl::string_view data,
+                                             const ParseProjection& projection,
+                                             Message* message) {
+  ABSL_CHECK(message->GetDescriptor() == projection.descriptor());
+  std::string filtered;
+  if (projection.root_ != nullptr) {
+    if (!projection.root_->Filter(data, /*keep_unknown=*/false, &filtered)) {
+      return false;
+    }
+    data = filtered;
+  }
+  io::CodedInputStream input(reinterpret_cast<const uint8_t*>(data.data()),
+                             static_cast<int>(data.size()));
+  return message->MergePartialFromCodedStream(&input);
+}
+
+bool FieldMaskUtil::TrimSerialized(absl::string_view data,
+                                   const ParseProjection& projection,
+                                   std::string* output) {
+  output->clear();
+  if (projection.trim_root_ == nullptr) {
+    output->assign(data.data(), data.size());
+    return true;
+  }
+  return projection.trim_root_->Filter(data, /*keep_unknown=*/true, output);
+}
+
 void FieldMaskUtil::ToCanonicalForm(const FieldMask& mask, FieldMask* out) {
   FieldMaskTree tree;
   tree.MergeFromFieldMask(mask);
@@ -713,6 +971,36 @@ bool FieldMaskUtil::TrimMessage(const FieldMask& mask, Message* message,
   return tree.TrimMessage(ABSL_DIE_IF_NULL(message));
 }
 
+bool FieldMaskUtil::IsPathInFieldMask(absl::string_view path,
+                                      const CompiledFieldMask& mask) {
+  return mask.root_ != nullptr && mask.root_->Contains(path);
+}
+
+void FieldMaskUtil::MergeMessageTo(const Message& source,
+                                   const CompiledFieldMask& mask,
+                                   const MergeOptions& options,
+                                   Message* destination) {
+  ABSL_CHECK(source.GetDescriptor() == mask.descriptor());
+  ABSL_CHECK(destination->GetDescriptor() == mask.descriptor());
+  if (mask.root_ != nullptr) {
+    mask.root_->Merge(source, options, destination);
+  }
+}
+
+bool FieldMaskUtil::TrimMessage(const CompiledFieldMask& mask,
+                                Message* message) {
+  return TrimMessage(mask, message, TrimOptions());
+}
+
+bool FieldMaskUtil::TrimMessage(const CompiledFieldMask& mask,
+                                Message* message, const TrimOptions& options) {
+  ABSL_CHECK(ABSL_DIE_IF_NULL(message)->GetDescriptor() == mask.descriptor());
+  const CompiledFieldMask::Node* root = options.keep_required_fields()
+                                            ? mask.root_with_required_.get()
+                                            : mask.root_.get();
+  return root != nullptr && root->Trim(message);
+}
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
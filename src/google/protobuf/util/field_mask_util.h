@@ -34,6 +34,7 @@
 #define GOOGLE_PROTOBUF_UTIL_FIELD_MASK_UTIL_H__
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -181,6 +182,39 @@ class PROTOBUF_EXPORT FieldMaskUtil {
   static bool TrimMessage(const FieldMask& mask, Message* message,
                           const TrimOptions& options);
 
+  class CompiledFieldMask;
+  // Same as the functions above, but with the paths of the mask already
+  // resolved against the message type, for masks that are applied many
+  // times. The messages must be of the type the mask was compiled for.
+  static bool IsPathInFieldMask(absl::string_view path,
+                                const CompiledFieldMask& mask);
+  static void MergeMessageTo(const Message& source,
+                             const CompiledFieldMask& mask,
+                             const MergeOptions& options, Message* destination);
+  static bool TrimMessage(const CompiledFieldMask& mask, Message* message);
+  static bool TrimMessage(const CompiledFieldMask& mask, Message* message,
+                          const TrimOptions& options);
+
+  class ParseProjection;
+  // Parses 'data' and merges into 'message' only the fields covered by
+  // 'projection'. Everything else, including whole unselected subtrees, is
+  // skipped on the wire without being stored, not even as unknown fields.
+  // Required fields are not checked, since a projection usually leaves some
+  // of them out. Returns false if 'data' is malformed.
+  static bool MergeProjectedFromString(absl::string_view data,
+                                       const ParseProjection& projection,
+                                       Message* message);
+
+  // Writes to 'output' the serialized message 'data' without the fields
+  // that TrimMessage() would clear, without parsing it: the records of kept
+  // fields are copied as they are, and only submessages the mask has
+  // sub-paths for are rewritten. Unknown fields and extensions are kept, as
+  // TrimMessage() does. Sub-paths of repeated message fields apply to every
+  // element. Returns false if 'data' is malformed.
+  static bool TrimSerialized(absl::string_view data,
+                             const ParseProjection& projection,
+                             std::string* output);
+
  private:
   friend class SnakeCaseCamelCaseTest;
   // Converts a field name from snake_case to camelCase:
@@ -256,6 +290,59 @@ class PROTOBUF_EXPORT FieldMaskUtil::TrimOptions {
   bool keep_required_fields_;
 };
 
+// A FieldMask in canonical form, with its paths resolved to the fields of a
+// message type. It is immutable, so one instance can be used from many
+// threads at once. Paths naming fields the type does not have select
+// nothing, and sub-paths are only followed for singular message fields, as
+// with the FieldMask overloads.
+class PROTOBUF_EXPORT FieldMaskUtil::CompiledFieldMask {
+ public:
+  CompiledFieldMask(const Descriptor* descriptor, const FieldMask& mask);
+  CompiledFieldMask(const CompiledFieldMask&) = delete;
+  CompiledFieldMask& operator=(const CompiledFieldMask&) = delete;
+  ~CompiledFieldMask();
+
+  const Descriptor* descriptor() const { return descriptor_; }
+
+ private:
+  friend class FieldMaskUtil;
+  struct Node;
+
+  const Descriptor* descriptor_;
+  // Null if the mask has no paths.
+  std::unique_ptr<Node> root_;
+  // root_ with the required fields of the selected messages added, for
+  // TrimOptions::keep_required_fields().
+  std::unique_ptr<Node> root_with_required_;
+};
+
+// A FieldMask compiled against a message type for use with
+// MergeProjectedFromString(). Compiling resolves the paths to field numbers
+// once, so a projection should be built once and reused for many parses.
+// Paths that do not name a field are ignored, including sub-paths of fields
+// that are not messages. An empty FieldMask keeps every field. Message fields
+// parsed as groups and map fields are kept or skipped as a whole.
+class PROTOBUF_EXPORT FieldMaskUtil::ParseProjection {
+ public:
+  ParseProjection(const Descriptor* descriptor, const FieldMask& mask);
+  ParseProjection(const ParseProjection&) = delete;
+  ParseProjection& operator=(const ParseProjection&) = delete;
+  ~ParseProjection();
+
+  const Descriptor* descriptor() const { return descriptor_; }
+
+ private:
+  friend class FieldMaskUtil;
+  struct Node;
+
+  const Descriptor* descriptor_;
+  // Null if the mask has no paths.
+  std::unique_ptr<Node> root_;
+  // root_ for TrimSerialized(), where a sub-path of a field that is not a
+  // message selects the whole field, as in TrimMessage().
+  std::unique_ptr<Node> trim_root_;
+};
+
 }  // namespace util
 }  // namespace protobuf
 }  // namespace google
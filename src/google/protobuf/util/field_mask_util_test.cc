@@ -32,10 +32,13 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "google/protobuf/field_mask.pb.h"
 #include <gtest/gtest.h>
+#include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/test_util.h"
 #include "google/protobuf/unittest.pb.h"
 
@@ -827,6 +830,193 @@ TEST(FieldMaskUtilTest, TrimMessageReturnValue) {
   // supported.
 }
 
+TEST(FieldMaskUtilTest, CompiledFieldMaskMatchesFieldMask) {
+  NestedTestAllTypes message;
+  TestUtil::SetAllFields(message.mutable_payload());
+  TestUtil::SetAllFields(message.mutable_child()->mutable_payload());
+  message.mutable_child()->mutable_child()->mutable_payload()
+      ->set_optional_int32(5);
+
+  const char* kMasks[] = {
+      "",
+      "payload",
+      "payload.optional_int32,payload.repeated_nested_message,"
+      "child.payload.optional_string,child.child",
+      "child.payload,child.payload.optional_int32,child",
+      "payload.no_such_field,child.no_such_field.x",
+      "payload.optional_int32.x,payload.optional_nested_message.bb",
+  };
+  const char* kPaths[] = {
+      "payload",
+      "payload.optional_int32",
+      "payload.optional_int64",
+      "child",
+      "child.child.payload",
+      "child.payload.optional_string",
+      "no_such_field",
+      "payload.no_such_field",
+      "child.no_such_field.x.y",
+  };
+  for (const char* mask_string : kMasks) {
+    SCOPED_TRACE(mask_string);
+    FieldMask mask;
+    FieldMaskUtil::FromString(mask_string, &mask);
+    const FieldMaskUtil::CompiledFieldMask compiled(
+        NestedTestAllTypes::descriptor(), mask);
+
+    for (const char* path : kPaths) {
+      EXPECT_EQ(FieldMaskUtil::IsPathInFieldMask(path, compiled),
+                FieldMaskUtil::IsPathInFieldMask(path, mask))
+          << path;
+    }
+
+    for (bool replace : {false, true}) {
+      FieldMaskUtil::MergeOptions options;
+      options.set_replace_message_fields(replace);
+      options.set_replace_repeated_fields(replace);
+      NestedTestAllTypes expected = message;
+      NestedTestAllTypes merged = message;
+      FieldMaskUtil::MergeMessageTo(message, mask, options, &expected);
+      FieldMaskUtil::MergeMessageTo(message, compiled, options, &merged);
+      EXPECT_EQ(merged.SerializeAsString(), expected.SerializeAsString());
+    }
+
+    NestedTestAllTypes expected = message;
+    NestedTestAllTypes trimmed = message;
+    EXPECT_EQ(FieldMaskUtil::TrimMessage(compiled, &trimmed),
+              FieldMaskUtil::TrimMessage(mask, &expected));
+    EXPECT_EQ(trimmed.SerializeAsString(), expected.SerializeAsString());
+  }
+}
+
+TEST(FieldMaskUtilTest, CompiledFieldMaskKeepsRequiredFields) {
+  TestRequired message;
+  message.set_a(1);
+  message.set_b(2);
+  message.set_c(3);
+  message.set_dummy2(4);
+  FieldMask mask;
+  FieldMaskUtil::FromString("dummy2", &mask);
+  const FieldMaskUtil::CompiledFieldMask compiled(TestRequired::descriptor(),
+                                                  mask);
+  FieldMaskUtil::TrimOptions options;
+  options.set_keep_required_fields(true);
+
+  TestRequired trimmed = message;
+  EXPECT_FALSE(FieldMaskUtil::TrimMessage(compiled, &trimmed, options));
+  EXPECT_EQ(trimmed.SerializeAsString(), message.SerializeAsString());
+  EXPECT_TRUE(FieldMaskUtil::TrimMessage(compiled, &trimmed));
+  EXPECT_FALSE(trimmed.has_a());
+  EXPECT_EQ(trimmed.dummy2(), 4);
+}
+
+TEST(FieldMaskUtilTest, MergeProjectedFromString) {
+  NestedTestAllTypes message;
+  TestUtil::SetAllFields(message.mutable_payload());
+  TestUtil::SetAllFields(message.mutable_child()->mutable_payload());
+  message.mutable_child()->mutable_child()->mutable_payload()
+      ->set_optional_int32(5);
+  std::string data = message.SerializeAsString();
+
+  FieldMask mask;
+  FieldMaskUtil::FromString(
+      "payload.optional_int32,payload.repeated_nested_message,"
+      "child.payload.optional_string,child.child",
+      &mask);
+  FieldMaskUtil::ParseProjection projection(NestedTestAllTypes::descriptor(),
+                                            mask);
+
+  NestedTestAllTypes projected;
+  ASSERT_TRUE(
+      FieldMaskUtil::MergeProjectedFromString(data, projection, &projected));
+  NestedTestAllTypes expected = message;
+  FieldMaskUtil::TrimMessage(mask, &expected);
+  EXPECT_EQ(projected.SerializeAsString(), expected.SerializeAsString());
+  EXPECT_TRUE(projected.payload().unknown_fields().empty());
+  EXPECT_EQ(projected.child().child().payload().optional_int32(), 5);
+
+  // The same projection works for dynamic messages of the type.
+  DynamicMessageFactory factory;
+  std::unique_ptr<Message> dynamic(
+      factory.GetPrototype(NestedTestAllTypes::descriptor())->New());
+  FieldMaskUtil::ParseProjection dynamic_projection(dynamic->GetDescriptor(),
+                                                    mask);
+  ASSERT_TRUE(FieldMaskUtil::MergeProjectedFromString(data, dynamic_projection,
+                                                      dynamic.get()));
+  EXPECT_EQ(dynamic->SerializeAsString(), expected.SerializeAsString());
+
+  // Malformed input is rejected even inside skipped fields.
+  data.pop_back();
+  projected.Clear();
+  EXPECT_FALSE(
+      FieldMaskUtil::MergeProjectedFromString(data, projection, &projected));
+}
+
+TEST(FieldMaskUtilTest, MergeProjectedFromStringIgnoresScalarSubPaths) {
+  NestedTestAllTypes message;
+  TestUtil::SetAllFields(message.mutable_payload());
+  std::string data = message.SerializeAsString();
+
+  FieldMask mask;
+  FieldMaskUtil::FromString(
+      "payload.optional_string.x,payload.optional_int32.y,"
+      "payload.optional_nested_message.bb",
+      &mask);
+  FieldMaskUtil::ParseProjection projection(NestedTestAllTypes::descriptor(),
+                                            mask);
+
+  NestedTestAllTypes projected;
+  ASSERT_TRUE(
+      FieldMaskUtil::MergeProjectedFromString(data, projection, &projected));
+  EXPECT_FALSE(projected.payload().has_optional_string());
+  EXPECT_FALSE(projected.payload().has_optional_int32());
+  EXPECT_EQ(projected.payload().optional_nested_message().bb(),
+            message.payload().optional_nested_message().bb());
+  EXPECT_TRUE(projected.payload().unknown_fields().empty());
+}
+
+TEST(FieldMaskUtilTest, TrimSerialized) {
+  NestedTestAllTypes message;
+  TestUtil::SetAllFields(message.mutable_payload());
+  TestUtil::SetAllFields(message.mutable_child()->mutable_payload());
+  message.mutable_child()->mutable_payload()->mutable_unknown_fields()
+      ->AddVarint(123456, 7);
+  message.mutable_unknown_fields()->AddLengthDelimited(654321, "unknown");
+  const std::string data = message.SerializeAsString();
+
+  const char* kMasks[] = {
+      "",
+      "payload",
+      "payload.optional_int32,payload.optional_nested_message.bb,"
+      "child.payload.optional_string",
+      "child.payload.optional_string.x,payload.no_such_field",
+      "no_such_field",
+  };
+  for (const char* mask_string : kMasks) {
+    SCOPED_TRACE(mask_string);
+    FieldMask mask;
+    FieldMaskUtil::FromString(mask_string, &mask);
+    FieldMaskUtil::ParseProjection projection(NestedTestAllTypes::descriptor(),
+                                              mask);
+    std::string trimmed;
+    ASSERT_TRUE(FieldMaskUtil::TrimSerialized(data, projection, &trimmed));
+    NestedTestAllTypes parsed;
+    ASSERT_TRUE(parsed.ParseFromString(trimmed));
+
+    NestedTestAllTypes expected = message;
+    FieldMaskUtil::TrimMessage(mask, &expected);
+    EXPECT_EQ(parsed.SerializeAsString(), expected.SerializeAsString());
+  }
+
+  FieldMask mask;
+  FieldMaskUtil::FromString("payload", &mask);
+  FieldMaskUtil::ParseProjection projection(NestedTestAllTypes::descriptor(),
+                                            mask);
+  std::string trimmed;
+  EXPECT_FALSE(FieldMaskUtil::TrimSerialized(data.substr(0, data.size() - 1),
+                                             projection, &trimmed));
+}
+
 
 }  // namespace
 }  // namespace util
@@ -0,0 +1,123 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// FrozenMessage<T> holds a message that is serialized many times without
+// changing in between, e.g. a configuration pushed to many subscribers.
+//
+// Serializing a message normally starts with a ByteSizeLong() pass over the
+// whole tree, because any field may have changed since the last call. A
+// FrozenMessage only hands out mutable access through Mutable(), so it knows
+// when the message changed: it serializes the message once and reuses those
+// bytes until the next Mutable() call.
+//
+//   util::FrozenMessage<Config> config(LoadConfig());
+//   for (Subscriber& subscriber : subscribers) {
+//     subscriber.Send(config.Serialized());
+//   }
+//   ...
+//   config.Mutable()->set_version(2);  // The next Serialized() re-encodes.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_FROZEN_MESSAGE_H__
+#define GOOGLE_PROTOBUF_UTIL_FROZEN_MESSAGE_H__
+
+#include <string>
+#include <utility>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// The first serialization after construction or Mutable() writes the cache,
+// so concurrent serializations must be synchronized externally until
+// is_frozen() is true. After that, all const methods are thread-safe.
+template <typename T>
+class FrozenMessage {
+ public:
+  FrozenMessage() = default;
+  explicit FrozenMessage(T message) : message_(std::move(message)) {}
+
+  const T& Get() const { return message_; }
+
+  // Returns the message for modification and drops the cached bytes.
+  T* Mutable() {
+    frozen_ = false;
+    encoded_.clear();
+    return &message_;
+  }
+
+  // Serializes the message now, so that later calls do not have to.
+  void Freeze() const {
+    if (frozen_) return;
+    message_.SerializePartialToString(&encoded_);
+    frozen_ = true;
+  }
+
+  // Returns true if the cached bytes match the message.
+  bool is_frozen() const { return frozen_; }
+
+  // Returns the serialized message. The reference stays valid until the next
+  // call to Mutable().
+  const std::string& Serialized() const {
+    Freeze();
+    return encoded_;
+  }
+
+  size_t ByteSizeLong() const { return Serialized().size(); }
+
+  void AppendToString(std::string* output) const {
+    output->append(Serialized());
+  }
+
+  bool SerializeToZeroCopyStream(io::ZeroCopyOutputStream* output) const {
+    const std::string& encoded = Serialized();
+    io::CodedOutputStream coded_output(output);
+    coded_output.WriteRaw(encoded.data(), static_cast<int>(encoded.size()));
+    return !coded_output.HadError();
+  }
+
+ private:
+  T message_;
+  mutable std::string encoded_;
+  mutable bool frozen_ = false;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_FROZEN_MESSAGE_H__
@@ -0,0 +1,89 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/frozen_message.h"
+
+#include <string>
+
+#include "google/protobuf/testing/googletest.h"
+#include <gtest/gtest.h>
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+TEST(FrozenMessageTest, SerializesOnce) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  FrozenMessage<TestAllTypes> frozen(message);
+  EXPECT_FALSE(frozen.is_frozen());
+
+  const std::string& encoded = frozen.Serialized();
+  EXPECT_TRUE(frozen.is_frozen());
+  EXPECT_EQ(encoded, message.SerializeAsString());
+  EXPECT_EQ(frozen.ByteSizeLong(), encoded.size());
+  // The same bytes are handed out again.
+  EXPECT_EQ(&frozen.Serialized(), &encoded);
+
+  std::string appended = "prefix";
+  frozen.AppendToString(&appended);
+  EXPECT_EQ(appended, "prefix" + encoded);
+
+  std::string streamed;
+  {
+    io::StringOutputStream output(&streamed);
+    EXPECT_TRUE(frozen.SerializeToZeroCopyStream(&output));
+  }
+  EXPECT_EQ(streamed, encoded);
+}
+
+TEST(FrozenMessageTest, MutableInvalidates) {
+  FrozenMessage<TestAllTypes> frozen;
+  frozen.Freeze();
+  EXPECT_TRUE(frozen.is_frozen());
+  EXPECT_EQ(frozen.Serialized(), "");
+
+  frozen.Mutable()->set_optional_int32(5);
+  EXPECT_FALSE(frozen.is_frozen());
+  EXPECT_EQ(frozen.Get().optional_int32(), 5);
+  EXPECT_EQ(frozen.Serialized(), frozen.Get().SerializeAsString());
+  EXPECT_TRUE(frozen.is_frozen());
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
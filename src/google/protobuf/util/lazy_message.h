@@ -0,0 +1,169 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// LazyMessage<T> holds the serialized form of a message and only parses it
+// when its contents are first accessed.
+//
+// Message and bytes fields share a wire format, so a service that only reads
+// a few fields of a large message can declare the submessages it rarely looks
+// at as `bytes` in its own copy of the schema and wrap them in a LazyMessage:
+//
+//   // routing.proto: mirrors Request, but with `Payload payload = 7;`
+//   // replaced by `bytes payload = 7;`.
+//   RoutingRequest request;
+//   request.ParseFromString(data);
+//   util::LazyMessage<Payload> payload;
+//   payload.SetEncoded(request.payload());
+//   if (NeedsPayload(request)) Handle(payload.Get());
+//
+// When the payload is never touched, its bytes are never parsed, and
+// re-serializing forwards them unchanged.
+//
+// This is not support for `[lazy = true]`: the C++ generator and runtime still
+// parse fields with that option eagerly, so deferring a submessage takes the
+// schema change above.  Repeated submessages can be deferred the same way, as
+// `repeated bytes` with one LazyMessage per element.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_LAZY_MESSAGE_H__
+#define GOOGLE_PROTOBUF_UTIL_LAZY_MESSAGE_H__
+
+#include <string>
+#include <utility>
+
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Unlike a regular message, an unparsed LazyMessage is modified by its first
+// const access, so concurrent calls to Get() must be synchronized externally
+// until is_parsed() is true.
+template <typename T>
+class LazyMessage {
+ public:
+  LazyMessage() = default;
+  // The parsed message, if any, is allocated on `arena`.
+  explicit LazyMessage(Arena* arena) : arena_(arena) {}
+  LazyMessage(const LazyMessage&) = delete;
+  LazyMessage& operator=(const LazyMessage&) = delete;
+  ~LazyMessage() {
+    if (arena_ == nullptr) delete message_;
+  }
+
+  // Replaces the contents with the serialized message `encoded`, which is
+  // not parsed until the next call to Get() or Mutable().
+  void SetEncoded(absl::Cord encoded) {
+    Clear();
+    encoded_ = std::move(encoded);
+  }
+  void SetEncoded(absl::string_view encoded) {
+    SetEncoded(absl::Cord(encoded));
+  }
+
+  void Clear() {
+    encoded_.Clear();
+    parse_failed_ = false;
+    if (message_ != nullptr) message_->Clear();
+    parsed_ = false;
+  }
+
+  // Returns true once the encoded bytes have been parsed (or if there never
+  // were any).
+  bool is_parsed() const { return parsed_ || encoded_.empty(); }
+
+  // Returns true if parsing the encoded bytes failed. Get() then returns
+  // whatever was parsed before the error.
+  bool parse_failed() const {
+    EnsureParsed();
+    return parse_failed_;
+  }
+
+  const T& Get() const {
+    EnsureParsed();
+    return message_ != nullptr ? *message_ : T::default_instance();
+  }
+
+  // Parses the encoded bytes if needed and returns the message for
+  // modification. The encoded bytes are dropped, so later serialization
+  // reflects the changes.
+  T* Mutable() {
+    EnsureParsed();
+    if (message_ == nullptr) message_ = Arena::CreateMessage<T>(arena_);
+    return message_;
+  }
+
+  // Returns the serialized message: the original bytes if they were never
+  // parsed, and a fresh serialization otherwise.
+  absl::Cord SerializeAsCord() const {
+    if (!parsed_) return encoded_;
+    absl::Cord output;
+    if (message_ == nullptr) return output;
+    message_->AppendPartialToCord(&output);
+    return output;
+  }
+  std::string SerializeAsString() const {
+    return std::string(SerializeAsCord());
+  }
+
+  size_t ByteSizeLong() const {
+    if (!parsed_) return encoded_.size();
+    return message_ != nullptr ? message_->ByteSizeLong() : 0;
+  }
+
+ private:
+  void EnsureParsed() const {
+    if (parsed_) return;
+    parsed_ = true;
+    if (encoded_.empty()) return;
+    if (message_ == nullptr) message_ = Arena::CreateMessage<T>(arena_);
+    parse_failed_ = !message_->ParsePartialFromCord(encoded_);
+    encoded_.Clear();
+  }
+
+  Arena* const arena_ = nullptr;
+  mutable T* message_ = nullptr;
+  mutable absl::Cord encoded_;
+  mutable bool parsed_ = false;
+  mutable bool parse_failed_ = false;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_LAZY_MESSAGE_H__
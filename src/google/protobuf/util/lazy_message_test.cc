@@ -0,0 +1,108 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/lazy_message.h"
+
+#include <string>
+
+#include "google/protobuf/testing/googletest.h"
+#include <gtest/gtest.h>
+#include "absl/strings/cord.h"
+#include "google/protobuf/arena.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+TEST(LazyMessageTest, ParsesOnFirstAccess) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string data = message.SerializeAsString();
+
+  LazyMessage<TestAllTypes> lazy;
+  lazy.SetEncoded(data);
+  EXPECT_FALSE(lazy.is_parsed());
+  EXPECT_EQ(lazy.ByteSizeLong(), data.size());
+  // Untouched bytes are forwarded as they are.
+  EXPECT_EQ(lazy.SerializeAsString(), data);
+  EXPECT_FALSE(lazy.is_parsed());
+
+  TestUtil::ExpectAllFieldsSet(lazy.Get());
+  EXPECT_TRUE(lazy.is_parsed());
+  EXPECT_FALSE(lazy.parse_failed());
+}
+
+TEST(LazyMessageTest, MutableReserializes) {
+  TestAllTypes message;
+  message.set_optional_int32(1);
+
+  LazyMessage<TestAllTypes> lazy;
+  lazy.SetEncoded(absl::Cord(message.SerializeAsString()));
+  lazy.Mutable()->set_optional_int32(2);
+
+  TestAllTypes reparsed;
+  ASSERT_TRUE(reparsed.ParseFromString(lazy.SerializeAsString()));
+  EXPECT_EQ(reparsed.optional_int32(), 2);
+}
+
+TEST(LazyMessageTest, EmptyAndMalformed) {
+  LazyMessage<TestAllTypes> lazy;
+  EXPECT_TRUE(lazy.is_parsed());
+  EXPECT_EQ(&lazy.Get(), &TestAllTypes::default_instance());
+  lazy.Mutable()->set_optional_int32(3);
+  EXPECT_EQ(lazy.Get().optional_int32(), 3);
+  EXPECT_GT(lazy.ByteSizeLong(), 0);
+
+  lazy.SetEncoded(absl::string_view("\x08", 1));
+  EXPECT_FALSE(lazy.is_parsed());
+  EXPECT_TRUE(lazy.parse_failed());
+  EXPECT_FALSE(lazy.Get().has_optional_int32());
+}
+
+TEST(LazyMessageTest, AllocatesOnArena) {
+  TestAllTypes message;
+  message.set_optional_string("on the arena");
+
+  Arena arena;
+  LazyMessage<TestAllTypes> lazy(&arena);
+  lazy.SetEncoded(message.SerializeAsString());
+  EXPECT_EQ(lazy.Get().GetArena(), &arena);
+  EXPECT_EQ(lazy.Get().optional_string(), "on the arena");
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
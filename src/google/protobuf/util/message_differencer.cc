@@ -35,12 +35,15 @@
 #include "google/protobuf/util/message_differencer.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <limits>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor.h"
@@ -51,16 +54,21 @@
 #include "google/protobuf/text_format.h"
 #include "absl/container/fixed_array.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/log/absl_check.h"
 #include "absl/log/absl_log.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/printer.h"
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/util/field_comparator.h"
+#include "google/protobuf/util/wire_hash.h"
 
 // Always include as last one, otherwise it can break compilation
 #include "google/protobuf/port_def.inc"
@@ -88,6 +96,45 @@ std::string PrintShortTextFormat(const google::protobuf::Message& message) {
   return debug_string;
 }
 
+// Appends the value of a scalar field (element `index` if it is repeated, or
+// -1 if it is singular) to `key`, so that two values compare equal under the
+// default field comparator only if they append the same bytes. Returns false
+// for message and floating point fields, which have no such exact key.
+bool AppendScalarMatchKey(const Message& message, const FieldDescriptor* field,
+                          int index, std::string* key) {
+  const Reflection* reflection = message.GetReflection();
+  const bool repeated = index >= 0;
+  switch (field->cpp_type()) {
+#define APPEND_KEY(CPPTYPE, METHOD)                                      \
+  case FieldDescriptor::CPPTYPE_##CPPTYPE:                               \
+    absl::StrAppend(                                                     \
+        key,                                                             \
+        repeated ? reflection->GetRepeated##METHOD(message, field, index) \
+                 : reflection->Get##METHOD(message, field),              \
+        ",");                                                            \
+    return true;
+
+    APPEND_KEY(INT32, Int32);
+    APPEND_KEY(INT64, Int64);
+    APPEND_KEY(UINT32, UInt32);
+    APPEND_KEY(UINT64, UInt64);
+    APPEND_KEY(BOOL, Bool);
+    APPEND_KEY(ENUM, EnumValue);
+#undef APPEND_KEY
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch;
+      const std::string& value =
+          repeated ? reflection->GetRepeatedStringReference(message, field,
+                                                            index, &scratch)
+                   : reflection->GetStringReference(message, field, &scratch);
+      absl::StrAppend(key, value.size(), ":", value);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
 }  // namespace
 
 // A reporter to report the total number of diffs.
@@ -172,6 +219,35 @@ class MessageDifferencer::MultipleFieldsMapKeyComparator
     return true;
   }
 
+  const std::vector<std::vector<const FieldDescriptor*> >& key_field_paths()
+      const {
+    return key_field_paths_;
+  }
+
+  // Appends to `key` the values of the key fields of `element`, such that
+  // IsMatch() can only hold for elements with equal keys. Returns false if a
+  // key field is repeated or has no exact key (see AppendScalarMatchKey).
+  bool AppendMatchKey(const Message& element, std::string* key) const {
+    for (const auto& path : key_field_paths_) {
+      const Message* message = &element;
+      for (size_t i = 0; i + 1 < path.size() && message != nullptr; ++i) {
+        if (message->GetReflection()->HasField(*message, path[i])) {
+          message = &message->GetReflection()->GetMessage(*message, path[i]);
+        } else {
+          // Elements missing the same ancestor of the key field match.
+          absl::StrAppend(key, "missing@", i, ",");
+          message = nullptr;
+        }
+      }
+      if (message == nullptr) continue;
+      if (path.back()->is_repeated() ||
+          !AppendScalarMatchKey(*message, path.back(), -1, key)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
  private:
   bool IsMatchInternal(
       const Message& message1, const Message& message2, int unpacked_any,
@@ -320,6 +396,17 @@ bool MessageDifferencer::ApproximatelyEquivalent(const Message& message1,
   return differencer.Compare(message1, message2);
 }
 
+bool MessageDifferencer::EqualsSerialized(const Descriptor* descriptor,
+                                          absl::string_view data1,
+                                          absl::string_view data2) {
+  if (data1 == data2) return true;
+  std::string canonical1;
+  std::string canonical2;
+  return CanonicalizeSerializedMessage(descriptor, data1, &canonical1) &&
+         CanonicalizeSerializedMessage(descriptor, data2, &canonical2) &&
+         canonical1 == canonical2;
+}
+
 // ===========================================================================
 
 MessageDifferencer::MessageDifferencer()
@@ -552,6 +639,9 @@ bool MessageDifferencer::FieldBefore(const FieldDescriptor* field1,
 
 bool MessageDifferencer::Compare(const Message& message1,
                                  const Message& message2) {
+  if (compare_serialized_first_ && SerializeToSameBytes(message1, message2)) {
+    return true;
+  }
   std::vector<SpecificField> parent_fields;
   force_compare_no_presence_fields_.clear();
   force_compare_failure_triggering_fields_.clear();
@@ -571,6 +661,150 @@ bool MessageDifferencer::Compare(const Message& message1,
   return result;
 }
 
+namespace {
+
+// Returns true if a message of type `descriptor` can hold a field for which
+// `holds` returns true, directly or in a submessage. Extensions and Any
+// payloads may hold anything.
+template <typename Predicate>
+bool MayHoldField(const Descriptor* descriptor, Predicate holds) {
+  std::vector<const Descriptor*> pending = {descriptor};
+  absl::flat_hash_set<const Descriptor*> seen = {descriptor};
+  while (!pending.empty()) {
+    const Descriptor* type = pending.back();
+    pending.pop_back();
+    if (type->extension_range_count() > 0 ||
+        type->full_name() == internal::kAnyFullTypeName) {
+      return true;
+    }
+    for (int i = 0; i < type->field_count(); ++i) {
+      const FieldDescriptor* field = type->field(i);
+      if (holds(field)) return true;
+      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+          seen.insert(field->message_type()).second) {
+        pending.push_back(field->message_type());
+      }
+    }
+  }
+  return false;
+}
+
+// Returns true if a message of type `descriptor` can hold a float or double.
+bool MayHoldFloatingPoint(const Descriptor* descriptor) {
+  return MayHoldField(descriptor, [](const FieldDescriptor* field) {
+    return field->cpp_type() == FieldDescriptor::CPPTYPE_FLOAT ||
+           field->cpp_type() == FieldDescriptor::CPPTYPE_DOUBLE;
+  });
+}
+
+// Returns true if a message of type `descriptor` can hold an Any.
+bool MayHoldAny(const Descriptor* descriptor) {
+  return MayHoldField(descriptor,
+                      [](const FieldDescriptor*) { return false; });
+}
+
+std::string SerializeDeterministically(const Message& message) {
+  std::string serialized;
+  {
+    io::StringOutputStream output_stream(&serialized);
+    io::CodedOutputStream output(&output_stream);
+    output.SetSerializationDeterministic(true);
+    message.SerializePartialToCodedStream(&output);
+  }
+  return serialized;
+}
+
+// A call to a Reporter method, to be made later.
+struct BufferedReport {
+  void (MessageDifferencer::Reporter::*method)(
+      const Message&, const Message&,
+      const std::vector<MessageDifferencer::SpecificField>&);
+  const Message* message1;
+  const Message* message2;
+  std::vector<MessageDifferencer::SpecificField> field_path;
+};
+
+// Appends the calls made to it to the vector passed to set_reports().
+class BufferingReporter : public MessageDifferencer::Reporter {
+ public:
+  using SpecificField = MessageDifferencer::SpecificField;
+
+  void set_reports(std::vector<BufferedReport>* reports) {
+    reports_ = reports;
+  }
+
+  void ReportAdded(const Message& message1, const Message& message2,
+                   const std::vector<SpecificField>& field_path) override {
+    Buffer(&Reporter::ReportAdded, message1, message2, field_path);
+  }
+  void ReportDeleted(const Message& message1, const Message& message2,
+                     const std::vector<SpecificField>& field_path) override {
+    Buffer(&Reporter::ReportDeleted, message1, message2, field_path);
+  }
+  void ReportModified(const Message& message1, const Message& message2,
+                      const std::vector<SpecificField>& field_path) override {
+    Buffer(&Reporter::ReportModified, message1, message2, field_path);
+  }
+  void ReportMoved(const Message& message1, const Message& message2,
+                   const std::vector<SpecificField>& field_path) override {
+    Buffer(&Reporter::ReportMoved, message1, message2, field_path);
+  }
+  void ReportMatched(const Message& message1, const Message& message2,
+                     const std::vector<SpecificField>& field_path) override {
+    Buffer(&Reporter::ReportMatched, message1, message2, field_path);
+  }
+  void ReportIgnored(const Message& message1, const Message& message2,
+                     const std::vector<SpecificField>& field_path) override {
+    Buffer(&Reporter::ReportIgnored, message1, message2, field_path);
+  }
+  void ReportUnknownFieldIgnored(
+      const Message& message1, const Message& message2,
+      const std::vector<SpecificField>& field_path) override {
+    Buffer(&Reporter::ReportUnknownFieldIgnored, message1, message2,
+           field_path);
+  }
+
+ private:
+  void Buffer(decltype(BufferedReport::method) method, const Message& message1,
+              const Message& message2,
+              const std::vector<SpecificField>& field_path) {
+    reports_->push_back({method, &message1, &message2, field_path});
+  }
+
+  std::vector<BufferedReport>* reports_ = nullptr;
+};
+
+}  // namespace
+
+struct MessageDifferencer::ElementComparison {
+  bool equal = false;
+  std::vector<BufferedReport> reports;
+};
+
+bool MessageDifferencer::SerializeToSameBytes(const Message& message1,
+                                              const Message& message2) {
+  // Reporters expect to hear about matched and ignored fields too.
+  if (reporter_ != nullptr || output_string_ != nullptr ||
+      field_comparator_kind_ != kFCDefault) {
+    return false;
+  }
+  const Descriptor* descriptor = message1.GetDescriptor();
+  if (message2.GetDescriptor() != descriptor) return false;
+  // Equal bytes mean equal values, except that NaN may differ from itself.
+  if (!field_comparator_.default_impl->treat_nan_as_equal()) {
+    auto it = may_hold_floating_point_.find(descriptor);
+    if (it == may_hold_floating_point_.end()) {
+      it = may_hold_floating_point_
+               .emplace(descriptor, MayHoldFloatingPoint(descriptor))
+               .first;
+    }
+    if (it->second) return false;
+  }
+  if (message1.ByteSizeLong() != message2.ByteSizeLong()) return false;
+  return SerializeDeterministically(message1) ==
+         SerializeDeterministically(message2);
+}
+
 bool MessageDifferencer::CompareWithFields(
     const Message& message1, const Message& message2,
     const std::vector<const FieldDescriptor*>& message1_fields_arg,
@@ -1247,6 +1481,16 @@ bool MessageDifferencer::CompareRepeatedRep(
     }
   }
 
+  // Large fields of messages may compare their paired elements on the
+  // executor up front. What that reports is replayed below, in order.
+  std::vector<ElementComparison> comparisons;
+  if (executor_ != nullptr &&
+      repeated_field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    CompareElementsInParallel(message1, message2, unpacked_any, repeated_field,
+                              simple_list ? nullptr : &match_list1,
+                              *parent_fields, &comparisons);
+  }
+
   bool fieldDifferent = false;
   SpecificField specific_field;
   specific_field.message1 = &message1;
@@ -1297,9 +1541,18 @@ bool MessageDifferencer::CompareRepeatedRep(
       next_unmatched_index = match_list1[i] + 1;
     }
 
-    const bool result = CompareFieldValueUsingParentFields(
-        message1, message2, unpacked_any, repeated_field, i,
-        specific_field.new_index, parent_fields);
+    bool result;
+    if (comparisons.empty()) {
+      result = CompareFieldValueUsingParentFields(
+          message1, message2, unpacked_any, repeated_field, i,
+          specific_field.new_index, parent_fields);
+    } else {
+      result = comparisons[i].equal;
+      for (const BufferedReport& report : comparisons[i].reports) {
+        (reporter_->*report.method)(*report.message1, *report.message2,
+                                    report.field_path);
+      }
+    }
 
     // If we have found differences, either report them or terminate if
     // no reporter is present. Note that ReportModified, ReportMoved, and
@@ -1352,6 +1605,118 @@ bool MessageDifferencer::CompareRepeatedRep(
   return !fieldDifferent;
 }
 
+void MessageDifferencer::CompareElementsInParallel(
+    const Message& message1, const Message& message2, int unpacked_any,
+    const FieldDescriptor* repeated_field, const std::vector<int>* match_list1,
+    const std::vector<SpecificField>& parent_fields,
+    std::vector<ElementComparison>* comparisons) {
+  const int count1 =
+      message1.GetReflection()->FieldSize(message1, repeated_field);
+  const int count2 =
+      message2.GetReflection()->FieldSize(message2, repeated_field);
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = 0; i < count1; ++i) {
+    const int j = match_list1 != nullptr ? (*match_list1)[i]
+                  : i < count2           ? i
+                                         : -1;
+    if (j >= 0) pairs.emplace_back(i, j);
+  }
+  if (pairs.empty() ||
+      static_cast<int>(pairs.size()) < parallel_min_elements_) {
+    return;
+  }
+  // Reports point into the compared messages, but Any payloads are unpacked
+  // into temporaries that are gone by the time they are replayed.
+  const bool reporting = reporter_ != nullptr;
+  if (reporting && MayHoldAny(repeated_field->message_type())) return;
+
+  const int num_tasks = std::max(
+      1, std::min(parallel_num_tasks_, static_cast<int>(pairs.size())));
+  std::vector<std::unique_ptr<BufferingReporter>> reporters;
+  std::vector<std::unique_ptr<MessageDifferencer>> workers;
+  for (int t = 0; t < num_tasks; ++t) {
+    reporters.push_back(reporting ? std::make_unique<BufferingReporter>()
+                                  : nullptr);
+    workers.push_back(NewWorker(reporters.back().get()));
+    if (workers.back() == nullptr) return;
+  }
+
+  comparisons->resize(count1);
+  std::atomic<bool> found_difference{false};
+  absl::BlockingCounter done(num_tasks);
+  for (int t = 0; t < num_tasks; ++t) {
+    const size_t begin = pairs.size() * t / num_tasks;
+    const size_t end = pairs.size() * (t + 1) / num_tasks;
+    executor_([&, t, begin, end] {
+      std::vector<SpecificField> fields(parent_fields);
+      for (size_t k = begin; k < end; ++k) {
+        // Without a reporter, the first difference decides the result, so
+        // the remaining elements can be left as unequal.
+        if (!reporting && found_difference.load(std::memory_order_relaxed)) {
+          break;
+        }
+        ElementComparison& comparison = (*comparisons)[pairs[k].first];
+        if (reporting) reporters[t]->set_reports(&comparison.reports);
+        comparison.equal = workers[t]->CompareFieldValueUsingParentFields(
+            message1, message2, unpacked_any, repeated_field, pairs[k].first,
+            pairs[k].second, &fields);
+        if (!comparison.equal) {
+          found_difference.store(true, std::memory_order_relaxed);
+        }
+      }
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+
+  for (const auto& worker : workers) {
+    force_compare_no_presence_fields_.insert(
+        worker->force_compare_no_presence_fields_.begin(),
+        worker->force_compare_no_presence_fields_.end());
+    force_compare_failure_triggering_fields_.insert(
+        worker->force_compare_failure_triggering_fields_.begin(),
+        worker->force_compare_failure_triggering_fields_.end());
+  }
+}
+
+std::unique_ptr<MessageDifferencer> MessageDifferencer::NewWorker(
+    Reporter* reporter) const {
+  // User-supplied criteria and comparators need not be thread-safe.
+  if (!ignore_criteria_.empty() || field_comparator_kind_ != kFCDefault) {
+    return nullptr;
+  }
+  auto worker = std::make_unique<MessageDifferencer>();
+  for (const auto& entry : map_field_key_comparator_) {
+    if (std::find(owned_key_comparators_.begin(), owned_key_comparators_.end(),
+                  entry.second) == owned_key_comparators_.end()) {
+      return nullptr;
+    }
+    // The comparators made by TreatAsMap*() call back into their differencer.
+    MapKeyComparator* key_comparator = new MultipleFieldsMapKeyComparator(
+        worker.get(),
+        static_cast<const MultipleFieldsMapKeyComparator*>(entry.second)
+            ->key_field_paths());
+    worker->owned_key_comparators_.push_back(key_comparator);
+    worker->map_field_key_comparator_[entry.first] = key_comparator;
+  }
+  worker->reporter_ = reporter;
+  // DefaultFieldComparator only reads its settings when comparing.
+  worker->field_comparator_.default_impl = field_comparator_.default_impl;
+  worker->message_field_comparison_ = message_field_comparison_;
+  worker->scope_ = scope_;
+  worker->force_compare_no_presence_fields_ = force_compare_no_presence_fields_;
+  worker->repeated_field_comparison_ = repeated_field_comparison_;
+  worker->repeated_field_comparisons_ = repeated_field_comparisons_;
+  worker->ignored_fields_ = ignored_fields_;
+  worker->report_matches_ = report_matches_;
+  worker->report_moves_ = report_moves_;
+  worker->report_ignores_ = report_ignores_;
+  worker->force_compare_no_presence_ = force_compare_no_presence_;
+  worker->match_indices_for_smart_list_callback_ =
+      match_indices_for_smart_list_callback_;
+  return worker;
+}
+
 bool MessageDifferencer::CompareFieldValue(const Message& message1,
                                            const Message& message2,
                                            int unpacked_any,
@@ -1876,6 +2241,46 @@ bool MaximumMatcher::FindArgumentPathDFS(int v, std::vector<bool>* visited) {
 
 }  // namespace
 
+bool MessageDifferencer::AppendElementMatchKey(
+    const Message& message, const FieldDescriptor* repeated_field,
+    const MapKeyComparator* key_comparator, int index, std::string* key) {
+  if (repeated_field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+    return key_comparator == nullptr &&
+           AppendScalarMatchKey(message, repeated_field, index, key);
+  }
+  const Message& element =
+      message.GetReflection()->GetRepeatedMessage(message, repeated_field,
+                                                  index);
+  if (key_comparator == &map_entry_key_comparator_) {
+    // An ignored key makes MapEntryKeyComparator compare whole entries.
+    const FieldDescriptor* key_field =
+        element.GetDescriptor()->FindFieldByNumber(1);
+    return !ignored_fields_.contains(key_field) &&
+           AppendScalarMatchKey(element, key_field, -1, key);
+  }
+  if (key_comparator != nullptr) {
+    // Only the comparators made by TreatAsMap*() are known to compare exact
+    // field values.
+    if (std::find(owned_key_comparators_.begin(), owned_key_comparators_.end(),
+                  key_comparator) == owned_key_comparators_.end()) {
+      return false;
+    }
+    return static_cast<const MultipleFieldsMapKeyComparator*>(key_comparator)
+        ->AppendMatchKey(element, key);
+  }
+  // Equal elements have equal values for their singular scalar fields. Any
+  // payloads may be compared unpacked, so give up on them.
+  const Descriptor* descriptor = element.GetDescriptor();
+  if (descriptor->full_name() == internal::kAnyFullTypeName) return false;
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (field->is_repeated() || ignored_fields_.contains(field)) continue;
+    // Message and floating point fields are left out of the key.
+    AppendScalarMatchKey(element, field, -1, key);
+  }
+  return true;
+}
+
 bool MessageDifferencer::MatchRepeatedFieldIndices(
     const Message& message1, const Message& message2, int unpacked_any,
     const FieldDescriptor* repeated_field,
@@ -1939,7 +2344,53 @@ bool MessageDifferencer::MatchRepeatedFieldIndices(
         }
       }
     }
-    for (int i = start_offset; i < count1; ++i) {
+    // Outside of SMART_SET, element i is matched with the first unmatched
+    // element of message2 accepted by IsMatch(). When every element has an
+    // exact match key, only the elements of message2 with the same key are
+    // tried, so large sets and maps match in linear rather than quadratic
+    // time. Custom comparators and ignore criteria may accept elements whose
+    // field values differ, so they keep trying every pair.
+    std::vector<std::string> keys1;
+    absl::flat_hash_map<std::string, std::vector<int>> candidates;
+    bool use_match_keys = !is_treated_as_smart_set &&
+                          field_comparator_kind_ == kFCDefault &&
+                          ignore_criteria_.empty() && start_offset < count1 &&
+                          start_offset < count2;
+    for (int i = start_offset; use_match_keys && i < count1; ++i) {
+      keys1.emplace_back();
+      use_match_keys = AppendElementMatchKey(message1, repeated_field,
+                                             key_comparator, i, &keys1.back());
+    }
+    for (int j = start_offset; use_match_keys && j < count2; ++j) {
+      std::string key;
+      use_match_keys =
+          AppendElementMatchKey(message2, repeated_field, key_comparator, j,
+                                &key);
+      candidates[std::move(key)].push_back(j);
+    }
+    for (int i = start_offset; use_match_keys && i < count1; ++i) {
+      int matched_j = -1;
+      auto it = candidates.find(keys1[i - start_offset]);
+      if (it != candidates.end()) {
+        for (int j : it->second) {
+          if (match_list2->at(j) == -1 &&
+              IsMatch(repeated_field, key_comparator, &message1, &message2,
+                      unpacked_any, parent_fields, nullptr, i, j)) {
+            matched_j = j;
+            break;
+          }
+        }
+      }
+      if (matched_j != -1) {
+        match_list1->at(i) = matched_j;
+        match_list2->at(matched_j) = i;
+      } else if (reporter == nullptr) {
+        return false;
+      } else {
+        success = false;
+      }
+    }
+    for (int i = start_offset; !use_match_keys && i < count1; ++i) {
       // Indicates any matched elements for this repeated field.
       bool match = false;
       int matched_j = -1;
@@ -46,6 +46,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/descriptor.h"  // FieldDescriptor
@@ -56,6 +57,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/absl_check.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/util/field_comparator.h"
 
 // Always include as last one, otherwise it can break compilation
@@ -176,6 +178,17 @@ class PROTOBUF_EXPORT MessageDifferencer {
   static bool ApproximatelyEquivalent(const Message& message1,
                                       const Message& message2);
 
+  // Determines whether `data1` and `data2`, two serialized messages of type
+  // `descriptor`, parse to messages that Equals() considers equal, without
+  // parsing them. Identical bytes are equal right away; otherwise the
+  // canonical forms of the two serializations are compared, see
+  // util::CanonicalizeSerializedMessage(). Unlike Equals(), NaNs compare
+  // equal to each other. Returns false if the serializations differ and
+  // either of them is malformed.
+  static bool EqualsSerialized(const Descriptor* descriptor,
+                               absl::string_view data1,
+                               absl::string_view data2);
+
   // Identifies an individual field in a message instance.  Used for field_path,
   // below.
   struct SpecificField {
@@ -596,6 +609,38 @@ class PROTOBUF_EXPORT MessageDifferencer {
     report_ignores_ = report_ignores;
   }
 
+  // Tells the differencer to first check whether the two messages passed to
+  // Compare() serialize, deterministically, to the same bytes, and to return
+  // true without comparing them field by field if they do. This pays off when
+  // most compared messages are equal, as in change detection, and costs two
+  // serializations for every pair that is not. The check is skipped when a
+  // Reporter is set, when the field comparator is not a
+  // DefaultFieldComparator, and when the messages could hold a NaN that the
+  // comparator would not treat as equal to itself. The default for a new
+  // differencer is false.
+  void set_compare_serialized_first(bool value) {
+    compare_serialized_first_ = value;
+  }
+
+  // Tells the differencer to compare the elements of repeated message fields
+  // and map fields with at least `min_elements` paired elements as
+  // `num_tasks` chunks, each run through `executor`, which must run the
+  // function it is passed, at once or later and on any thread. Every chunk
+  // uses its own copy of this differencer's settings, and what it reports is
+  // handed to the Reporter in the same order as a serial comparison would.
+  // Chunks do not nest: fields within the elements are compared serially.
+  // Fields are compared serially when an IgnoreCriteria, a custom
+  // MapKeyComparator or a FieldComparator other than a DefaultFieldComparator
+  // is set, as those need not be thread-safe, and, when reporting, for
+  // elements that can hold a google.protobuf.Any. By default, there is no
+  // executor and every field is compared serially.
+  void set_executor(std::function<void(std::function<void()>)> executor,
+                    int min_elements = 1024, int num_tasks = 8) {
+    executor_ = std::move(executor);
+    parallel_min_elements_ = min_elements;
+    parallel_num_tasks_ = num_tasks;
+  }
+
   // Sets the scope of the comparison (as defined in the Scope enumeration
   // above) that is used by this differencer when determining which fields to
   // compare between the messages.
@@ -940,6 +985,41 @@ class PROTOBUF_EXPORT MessageDifferencer {
       const std::vector<SpecificField>& parent_fields,
       std::vector<int>* match_list1, std::vector<int>* match_list2);
 
+  // Appends to `key` a string that is equal for element `index` of
+  // `repeated_field` and any element it could be matched with by IsMatch().
+  // MatchRepeatedFieldIndices() uses it to only try IsMatch() on elements
+  // with equal keys. Returns false if no such key is known, e.g. for a custom
+  // MapKeyComparator.
+  bool AppendElementMatchKey(const Message& message,
+                             const FieldDescriptor* repeated_field,
+                             const MapKeyComparator* key_comparator, int index,
+                             std::string* key);
+
+  // The result of comparing one pair of elements on the executor, with what
+  // was reported meanwhile. Defined in the .cc file.
+  struct ElementComparison;
+
+  // Compares the paired elements of repeated message field `repeated_field`
+  // on executor_, storing the result for element i of message1 at
+  // (*comparisons)[i]. Elements of message1 are paired with
+  // (*match_list1)[i], or with the same index if match_list1 is null. Leaves
+  // `comparisons` empty if the field should be compared serially.
+  void CompareElementsInParallel(
+      const Message& message1, const Message& message2, int unpacked_any,
+      const FieldDescriptor* repeated_field,
+      const std::vector<int>* match_list1,
+      const std::vector<SpecificField>& parent_fields,
+      std::vector<ElementComparison>* comparisons);
+
+  // Returns a differencer with the same settings, reporting to `reporter`,
+  // to compare elements on another thread, or null if a setting may not be
+  // thread-safe.
+  std::unique_ptr<MessageDifferencer> NewWorker(Reporter* reporter) const;
+
+  // Returns true if set_compare_serialized_first() applies to the two
+  // messages and their deterministic serializations are equal.
+  bool SerializeToSameBytes(const Message& message1, const Message& message2);
+
   // Checks if index is equal to new_index in all the specific fields.
   static bool CheckPathChanged(const std::vector<SpecificField>& parent_fields);
 
@@ -985,6 +1065,13 @@ class PROTOBUF_EXPORT MessageDifferencer {
   bool report_moves_;
   bool report_ignores_;
   bool force_compare_no_presence_ = false;
+  bool compare_serialized_first_ = false;
+  // Whether messages of a type can hold a float or double, for
+  // SerializeToSameBytes().
+  absl::flat_hash_map<const Descriptor*, bool> may_hold_floating_point_;
+  std::function<void(std::function<void()>)> executor_;
+  int parallel_min_elements_ = 1024;
+  int parallel_num_tasks_ = 8;
 
   std::string* output_string_;
 
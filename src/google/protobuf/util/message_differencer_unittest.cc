@@ -37,8 +37,12 @@
 #include "google/protobuf/util/message_differencer.h"
 
 #include <algorithm>
+#include <functional>
+#include <limits>
 #include <random>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/stubs/common.h"
@@ -198,6 +202,68 @@ TEST(MessageDifferencerTest, MapFieldEqualityTest) {
   EXPECT_FALSE(util::MessageDifferencer::Equals(msg1, msg2));
 }
 
+TEST(MessageDifferencerTest, CompareSerializedFirst) {
+  unittest::TestAllTypes msg1;
+  unittest::TestAllTypes msg2;
+  TestUtil::SetAllFields(&msg1);
+  TestUtil::SetAllFields(&msg2);
+
+  // TestAllTypes has floating point fields, so NaN must compare equal for the
+  // serialized comparison to be used.
+  util::DefaultFieldComparator field_comparator;
+  field_comparator.set_treat_nan_as_equal(true);
+  util::MessageDifferencer differencer;
+  differencer.set_field_comparator(&field_comparator);
+  differencer.set_compare_serialized_first(true);
+  EXPECT_TRUE(differencer.Compare(msg1, msg2));
+
+  msg1.set_optional_int32(-1);
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+  std::string diff;
+  differencer.ReportDifferencesToString(&diff);
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+  EXPECT_EQ("modified: optional_int32: -1 -> 101\n", diff);
+}
+
+TEST(MessageDifferencerTest, CompareSerializedFirstKeepsNaNUnequal) {
+  unittest::TestAllTypes msg1;
+  unittest::TestAllTypes msg2;
+  msg1.set_optional_double(std::numeric_limits<double>::quiet_NaN());
+  msg2.set_optional_double(std::numeric_limits<double>::quiet_NaN());
+
+  // The serializations are equal, but by default NaN differs from itself.
+  util::MessageDifferencer differencer;
+  differencer.set_compare_serialized_first(true);
+  EXPECT_FALSE(differencer.Compare(msg1, msg2));
+
+  util::DefaultFieldComparator field_comparator;
+  field_comparator.set_treat_nan_as_equal(true);
+  differencer.set_field_comparator(&field_comparator);
+  EXPECT_TRUE(differencer.Compare(msg1, msg2));
+}
+
+TEST(MessageDifferencerTest, EqualsSerialized) {
+  unittest::TestAllTypes msg1;
+  unittest::TestAllTypes msg2;
+  TestUtil::SetAllFields(&msg1);
+  msg2.set_optional_int32(msg1.optional_int32());
+  msg1.clear_optional_int32();
+
+  // The same fields in a different order.
+  const std::string data1 = msg1.SerializeAsString() + msg2.SerializeAsString();
+  const std::string data2 = msg2.SerializeAsString() + msg1.SerializeAsString();
+  EXPECT_TRUE(util::MessageDifferencer::EqualsSerialized(
+      unittest::TestAllTypes::descriptor(), data1, data2));
+
+  msg2.set_optional_int32(-1);
+  EXPECT_FALSE(util::MessageDifferencer::EqualsSerialized(
+      unittest::TestAllTypes::descriptor(), data1,
+      msg2.SerializeAsString() + msg1.SerializeAsString()));
+  EXPECT_FALSE(util::MessageDifferencer::EqualsSerialized(
+      unittest::TestAllTypes::descriptor(), data1,
+      data2.substr(0, data2.size() - 1)));
+}
+
 TEST(MessageDifferencerTest, BasicPartialEqualityTest) {
   // Create the testing protos
   unittest::TestAllTypes msg1;
@@ -2114,6 +2180,107 @@ TEST(MessageDifferencerTest, TreatRepeatedFieldAsMapWithIgnoredKeyFields) {
   EXPECT_TRUE(differ.Compare(msg1, msg2));
 }
 
+TEST(MessageDifferencerTest, LargeRepeatedFieldMatchesLikePairwise) {
+  // Large sets and maps are matched by key, unless an ignore criteria is set.
+  // TestIgnorer ignores nothing in item, so both must report the same diffs.
+  protobuf_unittest::TestDiffMessage msg1;
+  protobuf_unittest::TestDiffMessage msg2;
+  for (int i = 0; i < 600; ++i) {
+    auto* item = msg1.add_item();
+    item->set_a(i % 300);
+    item->set_b(absl::StrCat("b", i % 7));
+    msg1.add_rv(i % 300);
+  }
+  for (int i = 599; i >= 0; --i) {
+    auto* item = msg2.add_item();
+    item->set_a(i % 300);
+    item->set_b(absl::StrCat("b", i % 7));
+    msg2.add_rv(i % 300);
+  }
+  msg2.mutable_item(10)->set_b("changed");
+  msg2.mutable_item(20)->clear_a();
+  msg2.set_rv(30, 1000);
+
+  const FieldDescriptor* item = GetFieldDescriptor(msg1, "item");
+  const FieldDescriptor* a = GetFieldDescriptor(msg1, "item.a");
+  const FieldDescriptor* b = GetFieldDescriptor(msg1, "item.b");
+  for (int treatment = 0; treatment < 3; ++treatment) {
+    std::string diff_by_key;
+    std::string diff_pairwise;
+    for (bool pairwise : {false, true}) {
+      util::MessageDifferencer differencer;
+      if (treatment == 0) {
+        differencer.TreatAsSet(item);
+      } else if (treatment == 1) {
+        differencer.TreatAsMap(item, a);
+      } else {
+        differencer.TreatAsMapWithMultipleFieldsAsKey(item, {a, b});
+      }
+      differencer.TreatAsSet(GetFieldDescriptor(msg1, "rv"));
+      if (pairwise) {
+        differencer.AddIgnoreCriteria(absl::WrapUnique(new TestIgnorer));
+      }
+      EXPECT_TRUE(differencer.Compare(msg1, msg1));
+      EXPECT_FALSE(differencer.Compare(msg1, msg2));
+      differencer.ReportDifferencesToString(pairwise ? &diff_pairwise
+                                                     : &diff_by_key);
+      EXPECT_FALSE(differencer.Compare(msg1, msg2));
+    }
+    EXPECT_FALSE(diff_by_key.empty());
+    EXPECT_EQ(diff_pairwise, diff_by_key) << "treatment " << treatment;
+  }
+}
+
+TEST(MessageDifferencerTest, ParallelComparisonReportsLikeSerial) {
+  protobuf_unittest::TestDiffMessage msg1;
+  for (int i = 0; i < 100; ++i) {
+    auto* item = msg1.add_item();
+    item->set_a(i);
+    item->mutable_m()->set_c(i);
+    (*item->mutable_mp())[absl::StrCat("k", i % 3)] = i;
+  }
+  protobuf_unittest::TestDiffMessage msg2 = msg1;
+  msg2.mutable_item(3)->mutable_m()->set_c(-3);
+  (*msg2.mutable_item(40)->mutable_mp())["k0"] = -40;
+  msg2.mutable_item(41)->clear_m();
+  msg2.mutable_item()->SwapElements(50, 60);
+  msg2.add_item()->set_a(1000);
+
+  const FieldDescriptor* item = GetFieldDescriptor(msg1, "item");
+  const FieldDescriptor* key = GetFieldDescriptor(msg1, "item.a");
+  for (bool as_map : {false, true}) {
+    std::string serial;
+    {
+      util::MessageDifferencer differencer;
+      if (as_map) differencer.TreatAsMap(item, key);
+      differencer.set_report_matches(true);
+      differencer.ReportDifferencesToString(&serial);
+      EXPECT_FALSE(differencer.Compare(msg1, msg2));
+    }
+
+    std::vector<std::thread> threads;
+    std::string parallel;
+    {
+      util::MessageDifferencer differencer;
+      if (as_map) differencer.TreatAsMap(item, key);
+      differencer.set_report_matches(true);
+      differencer.set_executor(
+          [&](std::function<void()> task) {
+            threads.emplace_back(std::move(task));
+          },
+          /*min_elements=*/10, /*num_tasks=*/3);
+      EXPECT_TRUE(differencer.Compare(msg1, msg1));
+      EXPECT_FALSE(differencer.Compare(msg1, msg2));
+      differencer.ReportDifferencesToString(&parallel);
+      EXPECT_FALSE(differencer.Compare(msg1, msg2));
+    }
+    for (auto& thread : threads) thread.join();
+    // The comparison without a reporter stops at the differing sizes.
+    EXPECT_EQ(threads.size(), 6u);
+    EXPECT_EQ(parallel, serial) << "as_map " << as_map;
+  }
+}
+
 // Takes the product of all elements of item.ra as the key for key comparison.
 class ValueProductMapKeyComparator
     : public util::MessageDifferencer::MapKeyComparator {
@@ -0,0 +1,264 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/parallel_parse.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/log/absl_check.h"
+#include "absl/log/absl_log.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "google/protobuf/wire_reader.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+namespace {
+
+using internal::WireFormat;
+using internal::WireFormatLite;
+
+struct ElementRange {
+  int offset;
+  int size;
+};
+
+// Splits the top level of `data` into the payloads of `field_number`'s
+// length-delimited records, appended to `elements`, and the bytes of every
+// other record, appended to `rest` in their original order.
+bool SplitTopLevel(absl::string_view data, int field_number,
+                   std::vector<ElementRange>* elements, std::string* rest) {
+  WireReader reader(data);
+  size_t start = 0;
+  while (reader.Next()) {
+    const size_t end = data.size() - reader.remaining().size();
+    if (reader.field_number() == field_number &&
+        reader.wire_type() == WireReader::kLengthDelimited) {
+      elements->push_back(
+          {static_cast<int>(reader.bytes().data() - data.data()),
+           static_cast<int>(reader.bytes().size())});
+    } else {
+      rest->append(data.data() + start, end - start);
+    }
+    start = end;
+  }
+  return !reader.failed();
+}
+
+// Splits [0, size) into `num_tasks` contiguous runs and calls `run(task,
+// begin, end)` for each of them through `options.executor`. Returns once all
+// of them have finished.
+void RunTasks(const ParallelParseOptions& options, int size, int num_tasks,
+              absl::FunctionRef<void(int task, int begin, int end)> run) {
+  absl::BlockingCounter pending(num_tasks);
+  for (int task = 0; task < num_tasks; ++task) {
+    const int begin = static_cast<int>(int64_t{size} * task / num_tasks);
+    const int end = static_cast<int>(int64_t{size} * (task + 1) / num_tasks);
+    auto work = [&, task, begin, end] {
+      run(task, begin, end);
+      pending.DecrementCount();
+    };
+    if (options.executor) {
+      options.executor(std::move(work));
+    } else {
+      work();
+    }
+  }
+  pending.Wait();
+}
+
+}  // namespace
+
+bool ParseWithParallelRepeatedField(absl::string_view data,
+                                    const FieldDescriptor* field,
+                                    Message* message,
+                                    const ParallelParseOptions& options) {
+  ABSL_CHECK(field->containing_type() == message->GetDescriptor());
+  ABSL_CHECK(field->is_repeated());
+  ABSL_CHECK_EQ(field->cpp_type(), FieldDescriptor::CPPTYPE_MESSAGE);
+
+  message->Clear();
+  std::vector<ElementRange> ranges;
+  std::string rest;
+  if (!SplitTopLevel(data, field->number(), &ranges, &rest)) return false;
+
+  // The elements are created up front on the calling thread, so the workers
+  // only touch the element they are parsing and never the repeated field.
+  const Reflection* reflection = message->GetReflection();
+  std::vector<Message*> elements;
+  elements.reserve(ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    elements.push_back(reflection->AddMessage(message, field));
+  }
+
+  const int num_ranges = static_cast<int>(ranges.size());
+  const int num_tasks = std::max(1, std::min(options.num_tasks, num_ranges));
+  std::atomic<bool> ok{true};
+  RunTasks(options, num_ranges, num_tasks, [&](int, int begin, int end) {
+    for (int i = begin; i < end && ok.load(std::memory_order_relaxed); ++i) {
+      if (!elements[i]->ParsePartialFromArray(data.data() + ranges[i].offset,
+                                              ranges[i].size)) {
+        ok.store(false, std::memory_order_relaxed);
+      }
+    }
+  });
+  if (!ok.load(std::memory_order_relaxed)) return false;
+
+  if (!rest.empty()) {
+    io::CodedInputStream input(reinterpret_cast<const uint8_t*>(rest.data()),
+                               static_cast<int>(rest.size()));
+    if (!message->MergePartialFromCodedStream(&input)) return false;
+  }
+  return message->IsInitialized();
+}
+
+bool SerializeWithParallelRepeatedField(const Message& message,
+                                        const FieldDescriptor* field,
+                                        std::string* output,
+                                        const ParallelParseOptions& options) {
+  const Descriptor* descriptor = message.GetDescriptor();
+  ABSL_CHECK(field->containing_type() == descriptor);
+  ABSL_CHECK(field->is_repeated() && !field->is_map());
+  ABSL_CHECK_EQ(field->type(), FieldDescriptor::TYPE_MESSAGE);
+  ABSL_CHECK(!descriptor->options().message_set_wire_format());
+
+  if (!message.IsInitialized()) return false;
+  const Reflection* reflection = message.GetReflection();
+  const int num_elements = reflection->FieldSize(message, field);
+  if (num_elements == 0) return message.SerializeToString(output);
+
+  // ListFields() returns the fields in the order they are serialized in, so
+  // the bytes of `field` go between those of `before` and `after`.
+  std::vector<const FieldDescriptor*> before;
+  reflection->ListFields(message, &before);
+  auto it = std::find(before.begin(), before.end(), field);
+  std::vector<const FieldDescriptor*> after(it + 1, before.end());
+  before.erase(it, before.end());
+
+  // Sizing the other fields caches the sizes of their submessages too.
+  size_t before_size = 0;
+  for (const FieldDescriptor* f : before) {
+    before_size += WireFormat::FieldByteSize(f, message);
+  }
+  size_t after_size = WireFormat::ComputeUnknownFieldsSize(
+      reflection->GetUnknownFields(message));
+  for (const FieldDescriptor* f : after) {
+    after_size += WireFormat::FieldByteSize(f, message);
+  }
+
+  const int num_tasks = std::max(1, std::min(options.num_tasks, num_elements));
+  const size_t tag_size = WireFormatLite::TagSize(
+      field->number(), WireFormatLite::TYPE_MESSAGE);
+  std::vector<size_t> task_sizes(num_tasks);
+  RunTasks(options, num_elements, num_tasks, [&](int task, int begin, int end) {
+    size_t size = 0;
+    for (int i = begin; i < end; ++i) {
+      size += tag_size + WireFormatLite::LengthDelimitedSize(
+                             reflection->GetRepeatedMessage(message, field, i)
+                                 .ByteSizeLong());
+    }
+    task_sizes[task] = size;
+  });
+
+  std::vector<size_t> task_offsets(num_tasks);
+  size_t total_size = before_size;
+  for (int task = 0; task < num_tasks; ++task) {
+    task_offsets[task] = total_size;
+    total_size += task_sizes[task];
+  }
+  total_size += after_size;
+  if (total_size > INT_MAX) {
+    ABSL_LOG(ERROR) << descriptor->full_name()
+                    << " exceeded maximum protobuf size of 2GB: "
+                    << total_size;
+    return false;
+  }
+
+  output->resize(total_size);
+  uint8_t* const start = reinterpret_cast<uint8_t*>(&(*output)[0]);
+  const bool deterministic =
+      io::CodedOutputStream::IsDefaultSerializationDeterministic();
+
+  uint8_t* target = start;
+  io::EpsCopyOutputStream before_stream(target, static_cast<int>(before_size),
+                                        deterministic);
+  for (const FieldDescriptor* f : before) {
+    target = WireFormat::InternalSerializeField(f, message, target,
+                                                &before_stream);
+  }
+
+  RunTasks(options, num_elements, num_tasks, [&](int task, int begin, int end) {
+    uint8_t* ptr = start + task_offsets[task];
+    io::EpsCopyOutputStream stream(ptr, static_cast<int>(task_sizes[task]),
+                                   deterministic);
+    for (int i = begin; i < end; ++i) {
+      const Message& element =
+          reflection->GetRepeatedMessage(message, field, i);
+      ptr = WireFormatLite::InternalWriteMessage(
+          field->number(), element, element.GetCachedSize(), ptr, &stream);
+    }
+    ABSL_DCHECK_EQ(ptr, start + task_offsets[task] + task_sizes[task]);
+  });
+
+  target = start + total_size - after_size;
+  io::EpsCopyOutputStream after_stream(target, static_cast<int>(after_size),
+                                       deterministic);
+  for (const FieldDescriptor* f : after) {
+    target = WireFormat::InternalSerializeField(f, message, target,
+                                                &after_stream);
+  }
+  target = WireFormat::InternalSerializeUnknownFieldsToArray(
+      reflection->GetUnknownFields(message), target, &after_stream);
+  ABSL_DCHECK_EQ(target, start + total_size);
+  return true;
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,104 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Utilities for parsing and serializing messages whose payload is dominated by
+// one large repeated message field, spreading the work on that field's
+// elements over several threads.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_PARALLEL_PARSE_H__
+#define GOOGLE_PROTOBUF_UTIL_PARALLEL_PARSE_H__
+
+#include <functional>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+struct PROTOBUF_EXPORT ParallelParseOptions {
+  // Runs `task`, either immediately or later on some other thread. The tasks
+  // handed out by a single parse are independent of each other and may run
+  // in any order or concurrently; the parse blocks until all of them have
+  // finished. If unset, every task runs inline on the calling thread.
+  std::function<void(std::function<void()>)> executor;
+
+  // The number of tasks the elements of the repeated field are split into.
+  // Each task parses a contiguous run of elements.
+  int num_tasks = 8;
+};
+
+// Parses `data`, the serialized form of a message of `message`'s type, into
+// `message`, replacing its previous contents. The elements of `field`, which
+// must be a repeated message field of that type, are parsed concurrently
+// through `options.executor`; everything else is parsed on the calling
+// thread. Element order is preserved, so the result is the same as that of
+// `message->ParseFromString(data)`.
+//
+// The top level of `data` is scanned once to find the elements, so this only
+// pays off when `field` accounts for most of the input. If `message` lives on
+// an arena, the elements are allocated on that arena and each worker thread
+// allocates from its own part of it.
+//
+// Returns false if `data` is malformed or if required fields are missing.
+bool PROTOBUF_EXPORT ParseWithParallelRepeatedField(
+    absl::string_view data, const FieldDescriptor* field, Message* message,
+    const ParallelParseOptions& options = ParallelParseOptions());
+
+// Serializes `message` into `output`, replacing its previous contents. The
+// elements of `field`, which must be a non-map repeated message field of
+// `message`'s type, are sized and then written concurrently through
+// `options.executor`: each task serializes a contiguous run of elements
+// straight into its precomputed slice of `output`. Everything else is
+// serialized on the calling thread. The bytes are the same as those of
+// `message.SerializeToString(output)`.
+//
+// The elements' cached sizes are updated, so `message` must not be
+// serialized or otherwise accessed by another thread in the meantime.
+//
+// Returns false if required fields are missing or the result would exceed
+// 2GB.
+bool PROTOBUF_EXPORT SerializeWithParallelRepeatedField(
+    const Message& message, const FieldDescriptor* field, std::string* output,
+    const ParallelParseOptions& options = ParallelParseOptions());
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_PARALLEL_PARSE_H__
@@ -0,0 +1,182 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/parallel_parse.h"
+
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "google/protobuf/testing/googletest.h"
+#include <gtest/gtest.h>
+#include "google/protobuf/arena.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+TestAllTypes MakeLargeMessage() {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  for (int i = 0; i < 1000; ++i) {
+    message.add_repeated_foreign_message()->set_c(i);
+  }
+  return message;
+}
+
+const FieldDescriptor* RepeatedForeignMessage() {
+  return TestAllTypes::descriptor()->FindFieldByName(
+      "repeated_foreign_message");
+}
+
+TEST(ParallelParseTest, InlineMatchesSerialParse) {
+  std::string data = MakeLargeMessage().SerializeAsString();
+  TestAllTypes expected;
+  ASSERT_TRUE(expected.ParseFromString(data));
+
+  TestAllTypes parsed;
+  parsed.set_optional_string("overwritten");
+  ASSERT_TRUE(
+      ParseWithParallelRepeatedField(data, RepeatedForeignMessage(), &parsed));
+  EXPECT_EQ(parsed.SerializeAsString(), expected.SerializeAsString());
+}
+
+TEST(ParallelParseTest, ThreadsOnArenaPreserveOrder) {
+  std::string data = MakeLargeMessage().SerializeAsString();
+  std::vector<std::thread> threads;
+  ParallelParseOptions options;
+  options.num_tasks = 4;
+  options.executor = [&](std::function<void()> task) {
+    threads.emplace_back(std::move(task));
+  };
+
+  Arena arena;
+  auto* parsed = Arena::CreateMessage<TestAllTypes>(&arena);
+  bool ok = ParseWithParallelRepeatedField(data, RepeatedForeignMessage(),
+                                           parsed, options);
+  for (auto& thread : threads) thread.join();
+  ASSERT_TRUE(ok);
+  EXPECT_EQ(threads.size(), 4u);
+
+  TestUtil::ExpectAllFieldsSet(*parsed);
+  ASSERT_EQ(parsed->repeated_foreign_message_size(), 1002);
+  // SetAllFields adds two elements ahead of the ones added above.
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(parsed->repeated_foreign_message(i + 2).c(), i);
+    EXPECT_EQ(parsed->repeated_foreign_message(i + 2).GetArena(), &arena);
+  }
+}
+
+TEST(ParallelParseTest, MalformedElementFails) {
+  TestAllTypes message;
+  message.add_repeated_foreign_message()->set_c(1);
+  std::string data = message.SerializeAsString();
+  // Truncate the element's payload while keeping its length prefix.
+  data.pop_back();
+
+  TestAllTypes parsed;
+  EXPECT_FALSE(
+      ParseWithParallelRepeatedField(data, RepeatedForeignMessage(), &parsed));
+
+  // A record whose payload is fine but which is not a valid ForeignMessage.
+  // Field 49, size 1, holding a tag with no value.
+  std::string bad_element = "\x8a\x03\x01\x08";
+  EXPECT_FALSE(ParseWithParallelRepeatedField(
+      bad_element, RepeatedForeignMessage(), &parsed));
+}
+
+TEST(ParallelParseTest, MissingRequiredFieldsFail) {
+  protobuf_unittest::TestRequiredForeign message;
+  message.add_repeated_message()->set_a(1);
+  std::string data = message.SerializePartialAsString();
+
+  protobuf_unittest::TestRequiredForeign parsed;
+  const FieldDescriptor* field =
+      parsed.GetDescriptor()->FindFieldByName("repeated_message");
+  EXPECT_FALSE(ParseWithParallelRepeatedField(data, field, &parsed));
+  EXPECT_EQ(parsed.repeated_message_size(), 1);
+  EXPECT_EQ(parsed.repeated_message(0).a(), 1);
+}
+
+TEST(ParallelParseTest, ParallelSerializeMatchesSerialSerialize) {
+  TestAllTypes message = MakeLargeMessage();
+  message.GetReflection()->MutableUnknownFields(&message)->AddVarint(12345, 1);
+  std::vector<std::thread> threads;
+  ParallelParseOptions options;
+  options.num_tasks = 4;
+  options.executor = [&](std::function<void()> task) {
+    threads.emplace_back(std::move(task));
+  };
+
+  std::string serialized = "overwritten";
+  bool ok = SerializeWithParallelRepeatedField(
+      message, RepeatedForeignMessage(), &serialized, options);
+  for (auto& thread : threads) thread.join();
+  ASSERT_TRUE(ok);
+  // Both phases, sizing and writing, go through the executor.
+  EXPECT_EQ(threads.size(), 8u);
+  EXPECT_EQ(serialized, message.SerializeAsString());
+}
+
+TEST(ParallelParseTest, ParallelSerializeEdgeCases) {
+  TestAllTypes message;
+  message.set_optional_int32(1);
+  std::string serialized;
+  ASSERT_TRUE(SerializeWithParallelRepeatedField(
+      message, RepeatedForeignMessage(), &serialized));
+  EXPECT_EQ(serialized, message.SerializeAsString());
+
+  // More tasks than elements.
+  message.add_repeated_foreign_message()->set_c(1);
+  ParallelParseOptions options;
+  options.num_tasks = 100;
+  ASSERT_TRUE(SerializeWithParallelRepeatedField(
+      message, RepeatedForeignMessage(), &serialized, options));
+  EXPECT_EQ(serialized, message.SerializeAsString());
+
+  protobuf_unittest::TestRequiredForeign incomplete;
+  incomplete.add_repeated_message()->set_a(1);
+  EXPECT_FALSE(SerializeWithParallelRepeatedField(
+      incomplete,
+      incomplete.GetDescriptor()->FindFieldByName("repeated_message"),
+      &serialized));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
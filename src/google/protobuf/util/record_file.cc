@@ -0,0 +1,572 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/record_file.h"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/crc/crc32c.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message_lite.h"
+#include "google/protobuf/util/delimited_message_util.h"
+
+#if HAVE_ZLIB
+#include "google/protobuf/io/gzip_stream.h"
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+constexpr absl::string_view kBlockMagic = "pbrb";
+constexpr absl::string_view kIndexMagic = "pbri";
+constexpr size_t kBlockHeaderSize = 28;
+constexpr size_t kIndexEntrySize = 16;
+constexpr size_t kTrailerSize = 28;
+
+#if HAVE_ZLIB
+constexpr bool kHaveZlib = true;
+#else
+constexpr bool kHaveZlib = false;
+#endif
+
+enum Compression : uint32_t {
+  kNoCompression = 0,
+  kZlibCompression = 1,
+};
+
+struct BlockHeader {
+  uint32_t stored_size;
+  uint32_t raw_size;
+  uint32_t record_count;
+  uint32_t compression;
+  uint32_t crc;
+};
+
+uint8_t* Store32(uint32_t value, uint8_t* target) {
+  return io::CodedOutputStream::WriteLittleEndian32ToArray(value, target);
+}
+
+uint8_t* Store64(uint64_t value, uint8_t* target) {
+  return io::CodedOutputStream::WriteLittleEndian64ToArray(value, target);
+}
+
+uint32_t Load32(absl::string_view data, size_t offset) {
+  uint32_t value;
+  io::CodedInputStream::ReadLittleEndian32FromArray(
+      reinterpret_cast<const uint8_t*>(data.data() + offset), &value);
+  return value;
+}
+
+uint64_t Load64(absl::string_view data, size_t offset) {
+  uint64_t value;
+  io::CodedInputStream::ReadLittleEndian64FromArray(
+      reinterpret_cast<const uint8_t*>(data.data() + offset), &value);
+  return value;
+}
+
+uint32_t Crc32c(absl::string_view data) {
+  return static_cast<uint32_t>(absl::ComputeCrc32c(data));
+}
+
+bool WriteAll(io::ZeroCopyOutputStream* output, absl::string_view data) {
+  void* buffer;
+  int size;
+  while (!data.empty()) {
+    if (!output->Next(&buffer, &size)) return false;
+    if (static_cast<size_t>(size) > data.size()) {
+      std::memcpy(buffer, data.data(), data.size());
+      output->BackUp(size - static_cast<int>(data.size()));
+      return true;
+    }
+    std::memcpy(buffer, data.data(), size);
+    data.remove_prefix(size);
+  }
+  return true;
+}
+
+absl::Status ParseBlockHeader(absl::string_view data, BlockHeader* header) {
+  if (data.substr(0, kBlockMagic.size()) != kBlockMagic) {
+    return absl::DataLossError("Bad block magic.");
+  }
+  if (Crc32c(data.substr(0, kBlockHeaderSize - 4)) !=
+      Load32(data, kBlockHeaderSize - 4)) {
+    return absl::DataLossError("Block header checksum mismatch.");
+  }
+  header->stored_size = Load32(data, 4);
+  header->raw_size = Load32(data, 8);
+  header->record_count = Load32(data, 12);
+  header->compression = Load32(data, 16);
+  header->crc = Load32(data, 20);
+  return absl::OkStatus();
+}
+
+// Checks the contents of a block against its header and decompresses them if
+// needed.  `*raw` points into `stored` or `scratch`.
+absl::Status DecodeBlock(const BlockHeader& header, absl::string_view stored,
+                         std::string* scratch, absl::string_view* raw) {
+  if (Crc32c(stored) != header.crc) {
+    return absl::DataLossError("Block checksum mismatch.");
+  }
+  switch (header.compression) {
+    case kNoCompression:
+      *raw = stored;
+      break;
+#if HAVE_ZLIB
+    case kZlibCompression: {
+      io::ArrayInputStream input(stored.data(), static_cast<int>(stored.size()));
+      io::GzipInputStream gzip(&input, io::GzipInputStream::ZLIB);
+      scratch->clear();
+      scratch->reserve(header.raw_size);
+      const void* data;
+      int size;
+      while (gzip.Next(&data, &size)) {
+        scratch->append(static_cast<const char*>(data), size);
+      }
+      if (gzip.ZlibErrorCode() < 0) {
+        return absl::DataLossError("Block does not decompress.");
+      }
+      *raw = *scratch;
+      break;
+    }
+#endif
+    default:
+      return absl::UnimplementedError(
+          absl::StrCat("Unsupported block compression ", header.compression));
+  }
+  if (raw->size() != header.raw_size) {
+    return absl::DataLossError("Block size mismatch.");
+  }
+  return absl::OkStatus();
+}
+
+// Splits the contents of a block into its `count` records.
+absl::Status SplitRecords(absl::string_view raw, uint32_t count,
+                          std::vector<absl::string_view>* records) {
+  io::CodedInputStream input(reinterpret_cast<const uint8_t*>(raw.data()),
+                             static_cast<int>(raw.size()));
+  records->clear();
+  records->reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t size;
+    if (!input.ReadVarint32(&size)) {
+      return absl::DataLossError("Truncated record.");
+    }
+    const int position = input.CurrentPosition();
+    if (size > raw.size() - position) {
+      return absl::DataLossError("Truncated record.");
+    }
+    records->push_back(raw.substr(position, size));
+    input.Skip(static_cast<int>(size));
+  }
+  if (static_cast<size_t>(input.CurrentPosition()) != raw.size()) {
+    return absl::DataLossError("Trailing data in block.");
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+// ===================================================================
+
+RecordFileWriter::RecordFileWriter(io::ZeroCopyOutputStream* output)
+    : RecordFileWriter(output, Options()) {}
+
+RecordFileWriter::RecordFileWriter(io::ZeroCopyOutputStream* output,
+                                   const Options& options)
+    : output_(output),
+      block_size_(options.block_size),
+      compress_(options.compress && kHaveZlib) {}
+
+RecordFileWriter::~RecordFileWriter() { Close(); }
+
+bool RecordFileWriter::Write(const MessageLite& message) {
+  if (failed_ || closed_) return false;
+  {
+    io::StringOutputStream output(&block_);
+    if (!SerializeDelimitedToZeroCopyStream(message, &output)) return false;
+  }
+  ++block_records_;
+  ++record_count_;
+  return block_.size() < static_cast<size_t>(block_size_) || WriteBlock();
+}
+
+bool RecordFileWriter::WriteSerialized(absl::string_view record) {
+  if (failed_ || closed_) return false;
+  if (record.size() > INT_MAX) return false;
+  {
+    io::StringOutputStream output(&block_);
+    io::CodedOutputStream coded_output(&output);
+    coded_output.WriteVarint32(static_cast<uint32_t>(record.size()));
+    coded_output.WriteRaw(record.data(), static_cast<int>(record.size()));
+  }
+  ++block_records_;
+  ++record_count_;
+  return block_.size() < static_cast<size_t>(block_size_) || WriteBlock();
+}
+
+bool RecordFileWriter::WriteBlock() {
+  if (block_records_ == 0) return !failed_;
+
+  absl::string_view stored = block_;
+  uint32_t compression = kNoCompression;
+#if HAVE_ZLIB
+  std::string compressed;
+  if (compress_) {
+    io::StringOutputStream output(&compressed);
+    io::GzipOutputStream::Options options;
+    options.format = io::GzipOutputStream::ZLIB;
+    io::GzipOutputStream gzip(&output, options);
+    if (!WriteAll(&gzip, block_) || !gzip.Close()) {
+      failed_ = true;
+      return false;
+    }
+    stored = compressed;
+    compression = kZlibCompression;
+  }
+#endif
+
+  uint8_t header[kBlockHeaderSize];
+  std::memcpy(header, kBlockMagic.data(), kBlockMagic.size());
+  uint8_t* target = header + kBlockMagic.size();
+  target = Store32(static_cast<uint32_t>(stored.size()), target);
+  target = Store32(static_cast<uint32_t>(block_.size()), target);
+  target = Store32(block_records_, target);
+  target = Store32(compression, target);
+  target = Store32(Crc32c(stored), target);
+  Store32(Crc32c(absl::string_view(reinterpret_cast<char*>(header),
+                                   kBlockHeaderSize - 4)),
+          target);
+
+  index_.push_back({offset_, record_count_ - block_records_});
+  const bool ok = WriteRaw(absl::string_view(reinterpret_cast<char*>(header),
+                                             kBlockHeaderSize)) &&
+                  WriteRaw(stored);
+  block_.clear();
+  block_records_ = 0;
+  return ok;
+}
+
+bool RecordFileWriter::WriteRaw(absl::string_view data) {
+  if (failed_) return false;
+  if (!WriteAll(output_, data)) {
+    failed_ = true;
+    return false;
+  }
+  offset_ += data.size();
+  return true;
+}
+
+bool RecordFileWriter::Close() {
+  if (closed_) return !failed_;
+  WriteBlock();
+  closed_ = true;
+
+  std::string index(index_.size() * kIndexEntrySize + kTrailerSize, '\0');
+  uint8_t* target = reinterpret_cast<uint8_t*>(&index[0]);
+  for (const IndexEntry& entry : index_) {
+    target = Store64(entry.offset, target);
+    target = Store64(entry.first_record, target);
+  }
+  target = Store64(offset_, target);
+  target = Store64(record_count_, target);
+  target = Store32(static_cast<uint32_t>(index_.size()), target);
+  target = Store32(Crc32c(absl::string_view(index).substr(
+                       0, index.size() - kTrailerSize + 20)),
+                   target);
+  std::memcpy(target, kIndexMagic.data(), kIndexMagic.size());
+  return WriteRaw(index);
+}
+
+// ===================================================================
+
+RecordFileReader::RecordFileReader(absl::string_view contents,
+                                   int file_descriptor, int64_t size)
+    : contents_(contents), file_descriptor_(file_descriptor), size_(size) {}
+
+absl::StatusOr<std::unique_ptr<RecordFileReader>> RecordFileReader::Open(
+    absl::string_view contents) {
+  std::unique_ptr<RecordFileReader> reader(new RecordFileReader(
+      contents, -1, static_cast<int64_t>(contents.size())));
+  absl::Status status = reader->Init();
+  if (!status.ok()) return status;
+  return reader;
+}
+
+absl::StatusOr<std::unique_ptr<RecordFileReader>> RecordFileReader::OpenFile(
+    int file_descriptor) {
+#ifdef _WIN32
+  return absl::UnimplementedError("OpenFile() is not available on Windows.");
+#else
+  struct stat info;
+  if (fstat(file_descriptor, &info) != 0) {
+    return absl::InternalError(
+        absl::StrCat("fstat() failed: ", strerror(errno)));
+  }
+  std::unique_ptr<RecordFileReader> reader(new RecordFileReader(
+      absl::string_view(), file_descriptor, info.st_size));
+  absl::Status status = reader->Init();
+  if (!status.ok()) return status;
+  return reader;
+#endif
+}
+
+absl::Status RecordFileReader::ReadAt(int64_t offset, size_t size,
+                                      std::string* scratch,
+                                      absl::string_view* data) const {
+  if (offset < 0 || offset > size_ ||
+      size > static_cast<uint64_t>(size_ - offset)) {
+    return absl::DataLossError("Offset out of range; file is truncated.");
+  }
+  if (file_descriptor_ < 0) {
+    *data = contents_.substr(offset, size);
+    return absl::OkStatus();
+  }
+#ifdef _WIN32
+  return absl::UnimplementedError("Reading files is not supported.");
+#else
+  scratch->resize(size);
+  size_t total_read = 0;
+  while (total_read < size) {
+    ssize_t bytes;
+    do {
+      bytes = pread(file_descriptor_, &(*scratch)[total_read],
+                    size - total_read, offset + total_read);
+    } while (bytes < 0 && errno == EINTR);
+    if (bytes < 0) {
+      return absl::InternalError(
+          absl::StrCat("pread() failed: ", strerror(errno)));
+    }
+    if (bytes == 0) {
+      return absl::DataLossError("Unexpected end of file.");
+    }
+    total_read += bytes;
+  }
+  *data = *scratch;
+  return absl::OkStatus();
+#endif
+}
+
+absl::Status RecordFileReader::Init() {
+  if (size_ < static_cast<int64_t>(kTrailerSize)) {
+    return absl::DataLossError("File is too small to hold a record file.");
+  }
+  std::string scratch;
+  absl::string_view trailer;
+  absl::Status status =
+      ReadAt(size_ - kTrailerSize, kTrailerSize, &scratch, &trailer);
+  if (!status.ok()) return status;
+  if (trailer.substr(kTrailerSize - kIndexMagic.size()) != kIndexMagic) {
+    return absl::DataLossError("Bad trailer magic; the index is missing.");
+  }
+  const uint64_t index_offset = Load64(trailer, 0);
+  const uint64_t record_count = Load64(trailer, 8);
+  const uint32_t block_count = Load32(trailer, 16);
+  const uint32_t crc = Load32(trailer, 20);
+  if (index_offset + uint64_t{block_count} * kIndexEntrySize !=
+      static_cast<uint64_t>(size_) - kTrailerSize) {
+    return absl::DataLossError("Index size mismatch.");
+  }
+  const std::string trailer_fields(trailer.substr(0, 20));
+
+  absl::string_view index;
+  status = ReadAt(index_offset, block_count * kIndexEntrySize, &scratch, &index);
+  if (!status.ok()) return status;
+  absl::crc32c_t expected_crc = absl::ExtendCrc32c(
+      absl::ComputeCrc32c(index), trailer_fields);
+  if (static_cast<uint32_t>(expected_crc) != crc) {
+    return absl::DataLossError("Index checksum mismatch.");
+  }
+
+  if (block_count == 0 && record_count != 0) {
+    return absl::DataLossError("Malformed index.");
+  }
+  blocks_.resize(block_count);
+  for (uint32_t i = 0; i < block_count; ++i) {
+    blocks_[i].offset = static_cast<int64_t>(Load64(index, i * kIndexEntrySize));
+    blocks_[i].first_record =
+        static_cast<int64_t>(Load64(index, i * kIndexEntrySize + 8));
+    const Block* previous = i > 0 ? &blocks_[i - 1] : nullptr;
+    if ((previous == nullptr && blocks_[i].first_record != 0) ||
+        blocks_[i].offset < 0 ||
+        static_cast<uint64_t>(blocks_[i].offset) >= index_offset ||
+        blocks_[i].first_record < 0 ||
+        static_cast<uint64_t>(blocks_[i].first_record) >= record_count ||
+        (previous != nullptr && (blocks_[i].offset <= previous->offset ||
+                                 blocks_[i].first_record <=
+                                     previous->first_record))) {
+      return absl::DataLossError("Malformed index.");
+    }
+  }
+  record_count_ = static_cast<int64_t>(record_count);
+  return absl::OkStatus();
+}
+
+absl::Status RecordFileReader::ReadBlock(
+    int block,
+    absl::FunctionRef<void(int64_t index, absl::string_view record)> fn)
+    const {
+  if (block < 0 || block >= block_count()) {
+    return absl::OutOfRangeError(absl::StrCat("No block ", block, "."));
+  }
+  std::string header_scratch;
+  absl::string_view header_data;
+  absl::Status status = ReadAt(blocks_[block].offset, kBlockHeaderSize,
+                               &header_scratch, &header_data);
+  if (!status.ok()) return status;
+  BlockHeader header;
+  status = ParseBlockHeader(header_data, &header);
+  if (!status.ok()) return status;
+
+  const int64_t next_first_record = block + 1 < block_count()
+                                        ? blocks_[block + 1].first_record
+                                        : record_count_;
+  if (header.record_count !=
+      static_cast<uint64_t>(next_first_record - blocks_[block].first_record)) {
+    return absl::DataLossError("Block record count does not match the index.");
+  }
+
+  std::string stored_scratch;
+  absl::string_view stored;
+  status = ReadAt(blocks_[block].offset + kBlockHeaderSize, header.stored_size,
+                  &stored_scratch, &stored);
+  if (!status.ok()) return status;
+  std::string raw_scratch;
+  absl::string_view raw;
+  status = DecodeBlock(header, stored, &raw_scratch, &raw);
+  if (!status.ok()) return status;
+  std::vector<absl::string_view> records;
+  status = SplitRecords(raw, header.record_count, &records);
+  if (!status.ok()) return status;
+
+  for (size_t i = 0; i < records.size(); ++i) {
+    fn(blocks_[block].first_record + static_cast<int64_t>(i), records[i]);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RecordFileReader::ReadRecord(int64_t index,
+                                          MessageLite* message) const {
+  if (index < 0 || index >= record_count_) {
+    return absl::OutOfRangeError(absl::StrCat("No record ", index, "."));
+  }
+  // The last block whose first record is at most `index`.
+  auto it = std::upper_bound(
+      blocks_.begin(), blocks_.end(), index,
+      [](int64_t index, const Block& block) {
+        return index < block.first_record;
+      });
+  const int block = static_cast<int>(it - blocks_.begin()) - 1;
+  bool parsed = false;
+  absl::Status status =
+      ReadBlock(block, [&](int64_t record_index, absl::string_view record) {
+        if (record_index == index) {
+          parsed = message->ParseFromArray(record.data(),
+                                           static_cast<int>(record.size()));
+        }
+      });
+  if (!status.ok()) return status;
+  if (!parsed) {
+    return absl::DataLossError(
+        absl::StrCat("Record ", index, " does not parse."));
+  }
+  return absl::OkStatus();
+}
+
+void RecordFileReader::Recover(
+    absl::string_view contents,
+    absl::FunctionRef<void(absl::string_view record)> fn,
+    int64_t* skipped_bytes) {
+  // Blocks end where a valid index begins.
+  size_t end = contents.size();
+  if (std::unique_ptr<RecordFileReader> reader =
+          Open(contents).value_or(nullptr)) {
+    end = contents.size() - kTrailerSize -
+          reader->blocks_.size() * kIndexEntrySize;
+  }
+
+  int64_t skipped = 0;
+  std::string scratch;
+  std::vector<absl::string_view> records;
+  size_t position = 0;
+  while (position < end) {
+    BlockHeader header;
+    absl::string_view raw;
+    if (end - position >= kBlockHeaderSize &&
+        ParseBlockHeader(contents.substr(position, kBlockHeaderSize), &header)
+            .ok() &&
+        header.stored_size <= end - position - kBlockHeaderSize &&
+        DecodeBlock(header,
+                    contents.substr(position + kBlockHeaderSize,
+                                    header.stored_size),
+                    &scratch, &raw)
+            .ok() &&
+        SplitRecords(raw, header.record_count, &records).ok()) {
+      for (absl::string_view record : records) fn(record);
+      position += kBlockHeaderSize + header.stored_size;
+      continue;
+    }
+    // Resynchronizes on the next block header.
+    size_t next = contents.substr(0, end).find(kBlockMagic, position + 1);
+    if (next == absl::string_view::npos) next = end;
+    skipped += static_cast<int64_t>(next - position);
+    position = next;
+  }
+  if (skipped_bytes != nullptr) *skipped_bytes = skipped;
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
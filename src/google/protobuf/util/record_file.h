@@ -0,0 +1,226 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A record file holds a sequence of messages, like a file written with
+// SerializeDelimitedToZeroCopyStream(), but is laid out for random access:
+//
+//   util::RecordFileWriter writer(&output);
+//   for (const Event& event : events) writer.Write(event);
+//   if (!writer.Close()) return Error();
+//   ...
+//   absl::StatusOr<std::unique_ptr<util::RecordFileReader>> reader =
+//       util::RecordFileReader::OpenFile(fd);
+//   Event event;
+//   absl::Status status = (*reader)->ReadRecord(12345678, &event);
+//
+// Records are size-delimited messages grouped into blocks of about
+// Options::block_size bytes.  Each block starts with a header giving its size
+// and record count, its compression, and CRC32C checksums of the header and
+// the block's contents.  After the last block comes an index holding the
+// offset and the number of the first record of every block, and a fixed-size
+// trailer locating the index.  So reading one record touches the trailer,
+// the index, and one block, and blocks can be read on several threads at
+// once.  If the index is lost (a writer that crashed before Close(), say),
+// Recover() still finds every intact block by its header.
+//
+// All integers are stored little-endian.  A block header is 28 bytes:
+//
+//   magic "pbrb" | stored size | raw size | record count | compression |
+//   contents CRC32C | header CRC32C
+//
+// where "stored size" is the number of bytes of contents following the
+// header and "raw size" is their size once decompressed.  An index entry is
+// a 64-bit block offset followed by a 64-bit first record number.  The
+// 28-byte trailer is:
+//
+//   index offset (64 bits) | record count (64 bits) | block count |
+//   index CRC32C | magic "pbri"
+//
+// where the CRC covers the index entries and the first three trailer fields.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_RECORD_FILE_H__
+#define GOOGLE_PROTOBUF_UTIL_RECORD_FILE_H__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+class PROTOBUF_EXPORT RecordFileWriter {
+ public:
+  struct Options {
+    // Records are written out in blocks once this many bytes of them are
+    // buffered.  A block holds at least one record, however large.
+    int block_size = 64 << 10;
+    // Compresses every block with zlib.  Ignored (blocks are stored
+    // uncompressed) if protobuf was built without zlib.
+    bool compress = false;
+  };
+
+  // Writes a record file to `output`, which must outlive the writer.
+  // Offsets in the file are relative to output->ByteCount() at the time of
+  // construction, so the file must be read back from that point on.
+  explicit RecordFileWriter(io::ZeroCopyOutputStream* output);
+  RecordFileWriter(io::ZeroCopyOutputStream* output, const Options& options);
+  RecordFileWriter(const RecordFileWriter&) = delete;
+  RecordFileWriter& operator=(const RecordFileWriter&) = delete;
+  // Calls Close() if it has not been called yet.
+  ~RecordFileWriter();
+
+  // Appends a record.  Returns false if the message is too large (2GB or
+  // more) or if writing to the stream failed.
+  bool Write(const MessageLite& message);
+  // Appends an already serialized record.
+  bool WriteSerialized(absl::string_view record);
+
+  // Writes the last block, the index and the trailer.  Returns false if
+  // writing to the stream failed at any point.  Nothing may be written
+  // afterwards.
+  bool Close();
+
+  // The number of records written so far.
+  int64_t record_count() const { return record_count_; }
+
+ private:
+  struct IndexEntry {
+    int64_t offset;
+    int64_t first_record;
+  };
+
+  // Writes out the buffered records, if any, as a block.
+  bool WriteBlock();
+  bool WriteRaw(absl::string_view data);
+
+  io::ZeroCopyOutputStream* output_;
+  const int block_size_;
+  const bool compress_;
+  bool failed_ = false;
+  bool closed_ = false;
+
+  // Size-delimited records of the current block.
+  std::string block_;
+  int block_records_ = 0;
+  std::vector<IndexEntry> index_;
+  int64_t record_count_ = 0;
+  // Bytes written to output_ so far.
+  int64_t offset_ = 0;
+};
+
+class PROTOBUF_EXPORT RecordFileReader {
+ public:
+  // Opens the record file held in `contents` (which may be a mapped file).
+  // `contents` must outlive the reader.
+  static absl::StatusOr<std::unique_ptr<RecordFileReader>> Open(
+      absl::string_view contents);
+
+  // Opens the record file read from `file_descriptor` with pread(), which
+  // leaves the file offset alone, so the descriptor may be shared.  Does not
+  // take ownership of the descriptor.  Not available on Windows.
+  static absl::StatusOr<std::unique_ptr<RecordFileReader>> OpenFile(
+      int file_descriptor);
+
+  RecordFileReader(const RecordFileReader&) = delete;
+  RecordFileReader& operator=(const RecordFileReader&) = delete;
+
+  int64_t record_count() const { return record_count_; }
+  int block_count() const { return static_cast<int>(blocks_.size()); }
+  // The number of the first record in block `block`.
+  int64_t block_first_record(int block) const {
+    return blocks_[block].first_record;
+  }
+
+  // Parses record `index` into `message`, reading only the block which
+  // holds it.  Fails if the block is corrupt or the record does not parse.
+  absl::Status ReadRecord(int64_t index, MessageLite* message) const;
+
+  // Calls `fn` with the number and the serialized bytes of each record of
+  // block `block`, in order.  The bytes are only valid during the call.
+  //
+  // The reader is thread-safe: several threads may call ReadRecord() and
+  // ReadBlock() at once, for instance to process the blocks in parallel.
+  absl::Status ReadBlock(
+      int block,
+      absl::FunctionRef<void(int64_t index, absl::string_view record)> fn)
+      const;
+
+  // Scans `contents` from the start without using the index, calling `fn`
+  // for every record of every block that is intact, and skipping over
+  // corrupt data to the next valid block header.  Works on files that lack
+  // an index, such as a file whose writer never called Close().  If
+  // `skipped_bytes` is not null, it is set to the number of bytes skipped.
+  static void Recover(
+      absl::string_view contents,
+      absl::FunctionRef<void(absl::string_view record)> fn,
+      int64_t* skipped_bytes);
+
+ private:
+  struct Block {
+    int64_t offset;
+    int64_t first_record;
+  };
+
+  RecordFileReader(absl::string_view contents, int file_descriptor,
+                   int64_t size);
+
+  // Reads the trailer and index.
+  absl::Status Init();
+  // Sets `*data` to `size` bytes of the file from `offset`.  Reads into
+  // `scratch` unless the file is held in memory.
+  absl::Status ReadAt(int64_t offset, size_t size, std::string* scratch,
+                      absl::string_view* data) const;
+
+  absl::string_view contents_;
+  int file_descriptor_ = -1;
+  int64_t size_;
+  int64_t record_count_ = 0;
+  std::vector<Block> blocks_;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_RECORD_FILE_H__
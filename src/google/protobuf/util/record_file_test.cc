@@ -0,0 +1,226 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/record_file.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "google/protobuf/testing/googletest.h"
+#include <gtest/gtest.h>
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+TestAllTypes MakeRecord(int i) {
+  TestAllTypes message;
+  message.set_optional_int64(i);
+  message.set_optional_string(std::string(i % 100, 'x'));
+  return message;
+}
+
+std::string WriteRecords(int count, const RecordFileWriter::Options& options) {
+  std::string file;
+  io::StringOutputStream output(&file);
+  RecordFileWriter writer(&output, options);
+  for (int i = 0; i < count; ++i) {
+    EXPECT_TRUE(writer.Write(MakeRecord(i)));
+  }
+  EXPECT_EQ(writer.record_count(), count);
+  EXPECT_TRUE(writer.Close());
+  return file;
+}
+
+class RecordFileTest : public testing::TestWithParam<bool> {
+ protected:
+  RecordFileWriter::Options Options(int block_size) {
+    RecordFileWriter::Options options;
+    options.block_size = block_size;
+    options.compress = GetParam();
+    return options;
+  }
+};
+
+TEST_P(RecordFileTest, ReadsRecordsInAnyOrder) {
+  const int kRecords = 1000;
+  std::string file = WriteRecords(kRecords, Options(1000));
+
+  auto reader = RecordFileReader::Open(file);
+  ASSERT_TRUE(reader.ok()) << reader.status();
+  EXPECT_EQ((*reader)->record_count(), kRecords);
+  EXPECT_GT((*reader)->block_count(), 10);
+
+  for (int i : {999, 0, 500, 1, 998, 123}) {
+    TestAllTypes message;
+    ASSERT_TRUE((*reader)->ReadRecord(i, &message).ok());
+    EXPECT_EQ(message.optional_int64(), i);
+    EXPECT_EQ(message.optional_string().size(), i % 100);
+  }
+  TestAllTypes message;
+  EXPECT_EQ((*reader)->ReadRecord(kRecords, &message).code(),
+            absl::StatusCode::kOutOfRange);
+}
+
+TEST_P(RecordFileTest, ReadsBlocksInParallel) {
+  const int kRecords = 1000;
+  std::string file = WriteRecords(kRecords, Options(500));
+  auto reader = RecordFileReader::Open(file);
+  ASSERT_TRUE(reader.ok()) << reader.status();
+
+  const RecordFileReader& shared_reader = **reader;
+  std::vector<int> seen(kRecords);
+  std::vector<std::thread> threads;
+  const int kThreads = 4;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int block = t; block < shared_reader.block_count();
+           block += kThreads) {
+        EXPECT_TRUE(shared_reader
+                        .ReadBlock(block,
+                                   [&](int64_t index, absl::string_view data) {
+                                     TestAllTypes message;
+                                     ASSERT_TRUE(message.ParseFromArray(
+                                         data.data(), data.size()));
+                                     EXPECT_EQ(message.optional_int64(), index);
+                                     ++seen[index];
+                                   })
+                        .ok());
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  for (int count : seen) EXPECT_EQ(count, 1);
+}
+
+TEST_P(RecordFileTest, RecoversFromCorruption) {
+  const int kRecords = 1000;
+  std::string file = WriteRecords(kRecords, Options(1000));
+  auto reader = RecordFileReader::Open(file);
+  ASSERT_TRUE(reader.ok()) << reader.status();
+  const int64_t lost_first = (*reader)->block_first_record(3);
+  const int64_t lost_end = (*reader)->block_first_record(4);
+
+  // Damages the fourth block, which starts at the fourth block magic, and
+  // then cuts off the index.
+  std::string damaged = file;
+  size_t damaged_offset = damaged.find("pbrb");
+  for (int i = 0; i < 3; ++i) {
+    damaged_offset = damaged.find("pbrb", damaged_offset + 1);
+  }
+  damaged[damaged_offset + 40] ^= 0x55;
+  EXPECT_TRUE(RecordFileReader::Open(damaged).ok());
+  TestAllTypes message;
+  EXPECT_EQ((*RecordFileReader::Open(damaged))->ReadRecord(lost_first, &message)
+                .code(),
+            absl::StatusCode::kDataLoss);
+  damaged.resize(damaged.size() - 10);
+  EXPECT_FALSE(RecordFileReader::Open(damaged).ok());
+
+  std::vector<int64_t> recovered;
+  int64_t skipped_bytes;
+  RecordFileReader::Recover(
+      damaged,
+      [&](absl::string_view data) {
+        TestAllTypes message;
+        ASSERT_TRUE(message.ParseFromArray(data.data(), data.size()));
+        recovered.push_back(message.optional_int64());
+      },
+      &skipped_bytes);
+  EXPECT_GT(skipped_bytes, 0);
+  ASSERT_EQ(recovered.size(), kRecords - (lost_end - lost_first));
+  for (size_t i = 0; i < recovered.size(); ++i) {
+    EXPECT_EQ(recovered[i],
+              static_cast<int64_t>(i) < lost_first
+                  ? static_cast<int64_t>(i)
+                  : static_cast<int64_t>(i) + (lost_end - lost_first));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Compression, RecordFileTest, testing::Bool());
+
+TEST(RecordFileWriterTest, EmptyFile) {
+  std::string file = WriteRecords(0, RecordFileWriter::Options());
+  auto reader = RecordFileReader::Open(file);
+  ASSERT_TRUE(reader.ok()) << reader.status();
+  EXPECT_EQ((*reader)->record_count(), 0);
+  EXPECT_EQ((*reader)->block_count(), 0);
+}
+
+TEST(RecordFileWriterTest, RecoversFileWithoutIndex) {
+  std::string file;
+  std::string partial;
+  {
+    io::StringOutputStream output(&file);
+    RecordFileWriter::Options options;
+    options.block_size = 100;
+    RecordFileWriter writer(&output, options);
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_TRUE(writer.WriteSerialized(absl::StrCat("record ", i)));
+    }
+    // What a writer which crashed before Close() leaves behind.
+    partial = file;
+  }
+  EXPECT_TRUE(RecordFileReader::Open(file).ok());
+  EXPECT_FALSE(RecordFileReader::Open(partial).ok());
+
+  std::vector<std::string> recovered;
+  int64_t skipped_bytes;
+  auto append = [&](absl::string_view data) { recovered.emplace_back(data); };
+  RecordFileReader::Recover(partial, append, &skipped_bytes);
+  EXPECT_EQ(skipped_bytes, 0);
+  ASSERT_GT(recovered.size(), 10);
+  for (size_t i = 0; i < recovered.size(); ++i) {
+    EXPECT_EQ(recovered[i], absl::StrCat("record ", i));
+  }
+
+  // A torn last block is skipped.
+  const size_t complete = recovered.size();
+  recovered.clear();
+  partial.resize(partial.size() - 5);
+  RecordFileReader::Recover(partial, append, &skipped_bytes);
+  EXPECT_GT(skipped_bytes, 0);
+  EXPECT_LT(recovered.size(), complete);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,126 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/repeated_field_stream_writer.h"
+
+#include <climits>
+#include <cstdint>
+#include <string>
+
+#include "absl/log/absl_check.h"
+#include "absl/log/absl_log.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/message_lite.h"
+#include "google/protobuf/wire_format_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+using internal::WireFormatLite;
+
+RepeatedFieldStreamWriter::RepeatedFieldStreamWriter(
+    const MessageLite& fields, int field_number,
+    io::ZeroCopyOutputStream* output)
+    : output_(output),
+      tag_(WireFormatLite::MakeTag(field_number,
+                                   WireFormatLite::WIRETYPE_LENGTH_DELIMITED)) {
+  const std::string serialized = fields.SerializePartialAsString();
+  // Serialization emits known fields in field number order, followed by
+  // unknown fields, so everything from the first record numbered above the
+  // streamed field goes after its elements.
+  io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(serialized.data()),
+      static_cast<int>(serialized.size()));
+  int split = static_cast<int>(serialized.size());
+  while (true) {
+    const int record_begin = input.CurrentPosition();
+    const uint32_t tag = input.ReadTag();
+    if (tag == 0) break;
+    if (WireFormatLite::GetTagFieldNumber(tag) > field_number) {
+      split = record_begin;
+      break;
+    }
+    if (!WireFormatLite::SkipField(&input, tag)) break;
+  }
+  output_.WriteRaw(serialized.data(), split);
+  trailing_fields_ = serialized.substr(split);
+}
+
+RepeatedFieldStreamWriter::~RepeatedFieldStreamWriter() {
+  if (!finished_) Finish();
+}
+
+void RepeatedFieldStreamWriter::Add(const MessageLite& element) {
+  ABSL_DCHECK(!finished_);
+  const size_t size = element.ByteSizeLong();
+  if (size > INT_MAX) {
+    ABSL_LOG(ERROR) << element.GetTypeName()
+                    << " exceeded maximum protobuf size of 2GB: " << size;
+    oversized_element_ = true;
+    return;
+  }
+  output_.WriteTag(tag_);
+  output_.WriteVarint32(static_cast<uint32_t>(size));
+  element.SerializeWithCachedSizes(&output_);
+}
+
+void RepeatedFieldStreamWriter::AddBytes(absl::string_view element) {
+  ABSL_DCHECK(!finished_);
+  if (element.size() > INT_MAX) {
+    ABSL_LOG(ERROR) << "String field exceeded maximum size of 2GB: "
+                    << element.size();
+    oversized_element_ = true;
+    return;
+  }
+  output_.WriteTag(tag_);
+  output_.WriteVarint32(static_cast<uint32_t>(element.size()));
+  output_.WriteRaw(element.data(), static_cast<int>(element.size()));
+}
+
+bool RepeatedFieldStreamWriter::Finish() {
+  ABSL_DCHECK(!finished_);
+  finished_ = true;
+  output_.WriteRaw(trailing_fields_.data(),
+                   static_cast<int>(trailing_fields_.size()));
+  output_.Trim();
+  return !oversized_element_ && !output_.HadError();
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
@@ -0,0 +1,105 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// RepeatedFieldStreamWriter serializes a message with one huge repeated
+// field without holding the field in memory. The other fields are given as a
+// message up front, and the elements of the repeated field are appended one
+// at a time as they are produced:
+//
+//   Response header;
+//   header.set_status(Response::OK);
+//   util::RepeatedFieldStreamWriter writer(
+//       header, Response::kEntriesFieldNumber, &output);
+//   for (const Row& row : rows) writer.Add(ToEntry(row));
+//   if (!writer.Finish()) return Error();
+//
+// The output is byte for byte what serializing the complete message would
+// produce, and memory use does not depend on the number of elements.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_REPEATED_FIELD_STREAM_WRITER_H__
+#define GOOGLE_PROTOBUF_UTIL_REPEATED_FIELD_STREAM_WRITER_H__
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+class PROTOBUF_EXPORT RepeatedFieldStreamWriter {
+ public:
+  // Starts writing to `output` a message with the fields of `fields`, plus
+  // the elements of the repeated field `field_number` passed to Add(). The
+  // field must be a message, string or bytes field. Its elements in `fields`,
+  // if any, come before the added ones.
+  RepeatedFieldStreamWriter(const MessageLite& fields, int field_number,
+                            io::ZeroCopyOutputStream* output);
+  RepeatedFieldStreamWriter(const RepeatedFieldStreamWriter&) = delete;
+  RepeatedFieldStreamWriter& operator=(const RepeatedFieldStreamWriter&) =
+      delete;
+  // Calls Finish() if it has not been called yet.
+  ~RepeatedFieldStreamWriter();
+
+  // Appends an element to a repeated message field. The element's cached
+  // sizes are updated.
+  void Add(const MessageLite& element);
+  // Appends an element to a repeated string or bytes field.
+  void AddBytes(absl::string_view element);
+
+  // Writes the fields that follow the repeated field on the wire and flushes
+  // the output. Returns false if writing to the output failed at any point.
+  // Nothing may be added afterwards.
+  bool Finish();
+
+ private:
+  io::CodedOutputStream output_;
+  const uint32_t tag_;
+  // The serialized fields that go after the streamed field.
+  std::string trailing_fields_;
+  // Set if an element was dropped for exceeding the 2GB limit.
+  bool oversized_element_ = false;
+  bool finished_ = false;
+};
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_REPEATED_FIELD_STREAM_WRITER_H__
@@ -0,0 +1,94 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/repeated_field_stream_writer.h"
+
+#include <string>
+
+#include "google/protobuf/testing/googletest.h"
+#include <gtest/gtest.h>
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+TEST(RepeatedFieldStreamWriterTest, MatchesRegularSerialization) {
+  TestAllTypes fields;
+  TestUtil::SetAllFields(&fields);
+  fields.clear_repeated_nested_message();
+  TestAllTypes expected = fields;
+
+  std::string output;
+  {
+    io::StringOutputStream stream(&output);
+    RepeatedFieldStreamWriter writer(
+        fields, TestAllTypes::kRepeatedNestedMessageFieldNumber, &stream);
+    TestAllTypes::NestedMessage element;
+    for (int i = 0; i < 1000; ++i) {
+      element.set_bb(i);
+      writer.Add(element);
+      *expected.add_repeated_nested_message() = element;
+    }
+    EXPECT_TRUE(writer.Finish());
+  }
+  EXPECT_EQ(output, expected.SerializeAsString());
+}
+
+TEST(RepeatedFieldStreamWriterTest, AppendsToExistingElements) {
+  TestAllTypes fields;
+  fields.set_optional_int32(1);
+  fields.add_repeated_string("first");
+  fields.set_default_int32(2);
+  TestAllTypes expected = fields;
+  expected.add_repeated_string("second");
+  expected.add_repeated_string(std::string(100000, 'x'));
+
+  std::string output;
+  {
+    io::StringOutputStream stream(&output);
+    RepeatedFieldStreamWriter writer(
+        fields, TestAllTypes::kRepeatedStringFieldNumber, &stream);
+    writer.AddBytes("second");
+    writer.AddBytes(std::string(100000, 'x'));
+    // The destructor finishes the message.
+  }
+  EXPECT_EQ(output, expected.SerializeAsString());
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
@@ -30,8 +30,12 @@
 
 #include "google/protobuf/util/time_util.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 
 #include "google/protobuf/duration.pb.h"
 #include "google/protobuf/timestamp.pb.h"
@@ -156,7 +160,174 @@ std::string FormatTime(int64_t seconds, int32_t nanos) {
   return result;
 }
 
+// Writes `value` as exactly `width` decimal digits and returns the end.
+char* WriteDigits(uint32_t value, int width, char* out) {
+  for (int i = width - 1; i >= 0; --i) {
+    out[i] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+  return out + width;
+}
+
+// Writes ".", then `nanos` the way FormatNanos() does.
+char* WriteNanos(int32_t nanos, char* out) {
+  *out++ = '.';
+  if (nanos % kNanosPerMillisecond == 0) {
+    return WriteDigits(nanos / kNanosPerMillisecond, 3, out);
+  } else if (nanos % kNanosPerMicrosecond == 0) {
+    return WriteDigits(nanos / kNanosPerMicrosecond, 6, out);
+  } else {
+    return WriteDigits(nanos, 9, out);
+  }
+}
+
+// Converts between days since 1970-01-01 and proleptic Gregorian dates, using
+// the era-based algorithms from
+// https://howardhinnant.github.io/date_algorithms.html.
+void CivilFromDays(int64_t days, int32_t* year, uint32_t* month,
+                   uint32_t* day) {
+  days += 719468;
+  const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const uint32_t doe = static_cast<uint32_t>(days - era * 146097);
+  const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const uint32_t mp = (5 * doy + 2) / 153;
+  *day = doy - (153 * mp + 2) / 5 + 1;
+  *month = mp < 10 ? mp + 3 : mp - 9;
+  *year = static_cast<int32_t>(yoe + era * 400 + (*month <= 2 ? 1 : 0));
+}
+
+int64_t DaysFromCivil(int32_t year, uint32_t month, uint32_t day) {
+  year -= month <= 2 ? 1 : 0;
+  const int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const uint32_t yoe = static_cast<uint32_t>(year - era * 400);
+  const uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 +
+                       day - 1;
+  const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+// Writes the same text as FormatTime() for a valid Timestamp and returns the
+// end. At most TimeUtil::kTimestampStringMaxLength bytes are written.
+char* FormatTimeTo(int64_t seconds, int32_t nanos, char* out) {
+  int64_t days = seconds / 86400;
+  int64_t second_of_day = seconds % 86400;
+  if (second_of_day < 0) {
+    days -= 1;
+    second_of_day += 86400;
+  }
+  int32_t year;
+  uint32_t month, day;
+  CivilFromDays(days, &year, &month, &day);
+  const uint32_t sod = static_cast<uint32_t>(second_of_day);
+  out = WriteDigits(static_cast<uint32_t>(year), 4, out);
+  *out++ = '-';
+  out = WriteDigits(month, 2, out);
+  *out++ = '-';
+  out = WriteDigits(day, 2, out);
+  *out++ = 'T';
+  out = WriteDigits(sod / kSecondsPerHour, 2, out);
+  *out++ = ':';
+  out = WriteDigits(sod / kSecondsPerMinute % 60, 2, out);
+  *out++ = ':';
+  out = WriteDigits(sod % kSecondsPerMinute, 2, out);
+  if (nanos != 0) out = WriteNanos(nanos, out);
+  *out++ = 'Z';
+  return out;
+}
+
+// Reads exactly `width` decimal digits from the front of `value`.
+bool ConsumeDigits(absl::string_view& value, int width, uint32_t* result) {
+  if (value.size() < static_cast<size_t>(width)) return false;
+  uint32_t n = 0;
+  for (int i = 0; i < width; ++i) {
+    uint32_t digit = static_cast<uint32_t>(value[i] - '0');
+    if (digit >= 10) return false;
+    n = n * 10 + digit;
+  }
+  value.remove_prefix(width);
+  *result = n;
+  return true;
+}
+
+bool ConsumeChar(absl::string_view& value, char c) {
+  if (value.empty() || value[0] != c) return false;
+  value.remove_prefix(1);
+  return true;
+}
+
+// Reads 1 to 9 digits as a fraction of a second, scaled to nanoseconds.
+bool ConsumeNanos(absl::string_view& value, int32_t* nanos) {
+  int digits = 0;
+  uint32_t n = 0;
+  while (digits < static_cast<int>(value.size()) &&
+         static_cast<uint32_t>(value[digits] - '0') < 10) {
+    if (++digits > 9) return false;
+    n = n * 10 + static_cast<uint32_t>(value[digits - 1] - '0');
+  }
+  if (digits == 0) return false;
+  value.remove_prefix(digits);
+  for (int i = digits; i < 9; ++i) n *= 10;
+  *nanos = static_cast<int32_t>(n);
+  return true;
+}
+
+// Parses the fixed form "YYYY-MM-DDThh:mm:ss[.f](Z|+hh:mm|-hh:mm)", with one
+// to nine fractional digits, without allocating. Returns false for anything
+// else, including inputs absl::ParseTime() also accepts (lowercase
+// separators, leap seconds, more fractional digits); callers fall back to
+// ParseTime() for those.
+bool ParseTimeFast(absl::string_view value, int64_t* seconds,
+                   int32_t* nanos) {
+  static constexpr uint8_t kDaysInMonth[] = {31, 28, 31, 30, 31, 30,
+                                             31, 31, 30, 31, 30, 31};
+  uint32_t year, month, day, hour, minute, second;
+  if (!ConsumeDigits(value, 4, &year) || !ConsumeChar(value, '-') ||
+      !ConsumeDigits(value, 2, &month) || !ConsumeChar(value, '-') ||
+      !ConsumeDigits(value, 2, &day) || !ConsumeChar(value, 'T') ||
+      !ConsumeDigits(value, 2, &hour) || !ConsumeChar(value, ':') ||
+      !ConsumeDigits(value, 2, &minute) || !ConsumeChar(value, ':') ||
+      !ConsumeDigits(value, 2, &second)) {
+    return false;
+  }
+  if (year == 0 || month < 1 || month > 12 || day < 1 || hour > 23 ||
+      minute > 59 || second > 59) {
+    return false;
+  }
+  const bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+  if (day > kDaysInMonth[month - 1] + (month == 2 && leap ? 1 : 0)) {
+    return false;
+  }
+  *nanos = 0;
+  if (ConsumeChar(value, '.') && !ConsumeNanos(value, nanos)) return false;
+
+  int64_t offset = 0;
+  if (!ConsumeChar(value, 'Z')) {
+    if (value.empty() || (value[0] != '+' && value[0] != '-')) return false;
+    const bool negative = value[0] == '-';
+    value.remove_prefix(1);
+    uint32_t offset_hours, offset_minutes;
+    if (!ConsumeDigits(value, 2, &offset_hours) || !ConsumeChar(value, ':') ||
+        !ConsumeDigits(value, 2, &offset_minutes) || offset_hours > 23 ||
+        offset_minutes > 59) {
+      return false;
+    }
+    offset =
+        offset_hours * kSecondsPerHour + offset_minutes * kSecondsPerMinute;
+    if (negative) offset = -offset;
+  }
+  if (!value.empty()) return false;
+
+  *seconds = DaysFromCivil(static_cast<int32_t>(year), month, day) * 86400 +
+             hour * kSecondsPerHour + minute * kSecondsPerMinute + second -
+             offset;
+  return true;
+}
+
 bool ParseTime(absl::string_view value, int64_t* seconds, int32_t* nanos) {
+  if (ParseTimeFast(value, seconds, nanos)) {
+    return true;
+  }
   absl::Time result;
   if (!absl::ParseTime(absl::RFC3339_full, value, &result, nullptr)) {
     return false;
@@ -202,10 +373,44 @@ constexpr int64_t TimeUtil::kDurationMaxSeconds;
 constexpr int64_t TimeUtil::kDurationMinSeconds;
 constexpr int32_t TimeUtil::kDurationMaxNanoseconds;
 constexpr int32_t TimeUtil::kDurationMinNanoseconds;
+constexpr size_t TimeUtil::kTimestampStringMaxLength;
+constexpr size_t TimeUtil::kDurationStringMaxLength;
 #endif  // !_MSC_VER
 
 std::string TimeUtil::ToString(const Timestamp& timestamp) {
-  return FormatTime(timestamp.seconds(), timestamp.nanos());
+  if (!IsTimestampValid(timestamp)) {
+    return FormatTime(timestamp.seconds(), timestamp.nanos());
+  }
+  char buffer[kTimestampStringMaxLength];
+  return std::string(buffer, ToChars(timestamp, buffer));
+}
+
+size_t TimeUtil::ToChars(const Timestamp& timestamp, char* buffer) {
+  ABSL_DCHECK(IsTimestampValid(timestamp))
+      << "Timestamp is outside of the valid range";
+  return static_cast<size_t>(
+      FormatTimeTo(timestamp.seconds(), timestamp.nanos(), buffer) - buffer);
+}
+
+void TimeUtil::ToStrings(const RepeatedPtrField<Timestamp>& timestamps,
+                         std::vector<std::string>* out) {
+  out->reserve(out->size() + timestamps.size());
+  for (const Timestamp& timestamp : timestamps) {
+    out->push_back(ToString(timestamp));
+  }
+}
+
+bool TimeUtil::FromStrings(absl::Span<const absl::string_view> values,
+                           RepeatedPtrField<Timestamp>* timestamps) {
+  const int old_size = timestamps->size();
+  timestamps->Reserve(old_size + static_cast<int>(values.size()));
+  for (absl::string_view value : values) {
+    if (!FromString(value, timestamps->Add())) {
+      timestamps->DeleteSubrange(old_size, timestamps->size() - old_size);
+      return false;
+    }
+  }
+  return true;
 }
 
 bool TimeUtil::FromString(absl::string_view value, Timestamp* timestamp) {
@@ -228,6 +433,10 @@ Timestamp TimeUtil::GetCurrentTime() {
 Timestamp TimeUtil::GetEpoch() { return Timestamp(); }
 
 std::string TimeUtil::ToString(const Duration& duration) {
+  if (IsDurationValid(duration)) {
+    char buffer[kDurationStringMaxLength];
+    return std::string(buffer, ToChars(duration, buffer));
+  }
   std::string result;
   int64_t seconds = duration.seconds();
   int32_t nanos = duration.nanos();
@@ -244,6 +453,32 @@ std::string TimeUtil::ToString(const Duration& duration) {
   return result;
 }
 
+size_t TimeUtil::ToChars(const Duration& duration, char* buffer) {
+  ABSL_DCHECK(IsDurationValid(duration))
+      << "Duration is outside of the valid range";
+  char* out = buffer;
+  uint64_t seconds = static_cast<uint64_t>(duration.seconds());
+  int32_t nanos = duration.nanos();
+  if (duration.seconds() < 0 || nanos < 0) {
+    *out++ = '-';
+    seconds = 0 - seconds;
+    nanos = -nanos;
+  }
+  // At most 12 digits for a valid Duration.
+  char digits[20];
+  char* end = digits + sizeof(digits);
+  char* begin = end;
+  do {
+    *--begin = static_cast<char>('0' + seconds % 10);
+    seconds /= 10;
+  } while (seconds != 0);
+  memcpy(out, begin, end - begin);
+  out += end - begin;
+  if (nanos != 0) out = WriteNanos(nanos, out);
+  *out++ = 's';
+  return static_cast<size_t>(out - buffer);
+}
+
 static int64_t Pow(int64_t x, int y) {
   int64_t result = 1;
   for (int i = 0; i < y; ++i) {
@@ -252,7 +487,33 @@ static int64_t Pow(int64_t x, int y) {
   return result;
 }
 
+// Parses the fixed form "[-]D[.f]s", with 1 to 12 integral and 1 to 9
+// fractional digits, without allocating. Returns false for anything else;
+// callers fall back to the general parser for those.
+static bool ParseDurationFast(absl::string_view value, Duration* duration) {
+  if (value.empty() || value.back() != 's') return false;
+  value.remove_suffix(1);
+  const bool negative = ConsumeChar(value, '-');
+  int digits = 0;
+  int64_t seconds = 0;
+  while (!value.empty() && static_cast<uint32_t>(value[0] - '0') < 10) {
+    if (++digits > 12) return false;
+    seconds = seconds * 10 + (value[0] - '0');
+    value.remove_prefix(1);
+  }
+  if (digits == 0) return false;
+  int32_t nanos = 0;
+  if (ConsumeChar(value, '.') && !ConsumeNanos(value, &nanos)) return false;
+  if (!value.empty()) return false;
+  duration->set_seconds(negative ? -seconds : seconds);
+  duration->set_nanos(negative ? -nanos : nanos);
+  return true;
+}
+
 bool TimeUtil::FromString(absl::string_view value, Duration* duration) {
+  if (ParseDurationFast(value, duration)) {
+    return true;
+  }
   if (value.length() <= 1 || value[value.length() - 1] != 's') {
     return false;
   }
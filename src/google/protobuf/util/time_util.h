@@ -33,10 +33,12 @@
 #ifndef GOOGLE_PROTOBUF_UTIL_TIME_UTIL_H__
 #define GOOGLE_PROTOBUF_UTIL_TIME_UTIL_H__
 
+#include <cstddef>
 #include <cstdint>
 #include <ctime>
 #include <ostream>
 #include <string>
+#include <vector>
 #ifdef _MSC_VER
 #ifdef _XBOX_ONE
 struct timeval {
@@ -52,6 +54,9 @@ struct timeval {
 
 #include "google/protobuf/duration.pb.h"
 #include "google/protobuf/timestamp.pb.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "google/protobuf/repeated_ptr_field.h"
 
 // Must be included last.
 #include "google/protobuf/port_def.inc"
@@ -122,6 +127,29 @@ class PROTOBUF_EXPORT TimeUtil {
   static std::string ToString(const Duration& duration);
   static bool FromString(absl::string_view value, Duration* duration);
 
+  // Allocation-free counterparts of ToString() for hot paths. They write the
+  // same text into `buffer`, which must have room for at least
+  // kTimestampStringMaxLength (resp. kDurationStringMaxLength) bytes, and
+  // return the number of bytes written. No terminating NUL is written. The
+  // input must be valid, see IsTimestampValid() and IsDurationValid().
+  //
+  // Example:
+  //   char buffer[TimeUtil::kTimestampStringMaxLength];
+  //   out.append(buffer, TimeUtil::ToChars(timestamp, buffer));
+  static constexpr size_t kTimestampStringMaxLength = 30;
+  static constexpr size_t kDurationStringMaxLength = 24;
+  static size_t ToChars(const Timestamp& timestamp, char* buffer);
+  static size_t ToChars(const Duration& duration, char* buffer);
+
+  // Batch conversions for repeated Timestamps. ToStrings() appends the string
+  // form of every element to `out`. FromStrings() parses every element of
+  // `values` and appends the results to `timestamps`; if any of them fails to
+  // parse it returns false and leaves `timestamps` unchanged.
+  static void ToStrings(const RepeatedPtrField<Timestamp>& timestamps,
+                        std::vector<std::string>* out);
+  static bool FromStrings(absl::Span<const absl::string_view> values,
+                          RepeatedPtrField<Timestamp>* timestamps);
+
   // Gets the current UTC time.
   static Timestamp GetCurrentTime();
   // Returns the Time representing "1970-01-01 00:00:00".
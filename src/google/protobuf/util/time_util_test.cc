@@ -32,6 +32,8 @@
 
 #include <cstdint>
 #include <ctime>
+#include <string>
+#include <vector>
 
 #include "google/protobuf/duration.pb.h"
 #include "google/protobuf/timestamp.pb.h"
@@ -133,6 +135,86 @@ TEST(TimeUtilTest, DurationStringFormat) {
   EXPECT_EQ(-999999999, d.nanos());
 }
 
+TEST(TimeUtilTest, ToCharsMatchesToString) {
+  char buffer[TimeUtil::kTimestampStringMaxLength];
+  const int64_t kNanos[] = {0, -1, 10000000, 1234567890123456789,
+                            -951782400000000000};
+  for (int64_t nanos : kNanos) {
+    Timestamp timestamp = TimeUtil::NanosecondsToTimestamp(nanos);
+    EXPECT_EQ(std::string(buffer, TimeUtil::ToChars(timestamp, buffer)),
+              TimeUtil::ToString(timestamp));
+  }
+  Timestamp end;
+  ASSERT_TRUE(TimeUtil::FromString("9999-12-31T23:59:59.999999999Z", &end));
+  EXPECT_EQ(TimeUtil::kTimestampStringMaxLength,
+            TimeUtil::ToChars(end, buffer));
+
+  char duration_buffer[TimeUtil::kDurationStringMaxLength];
+  Duration d = TimeUtil::NanosecondsToDuration(-1500000000);
+  EXPECT_EQ("-1.500s", std::string(duration_buffer,
+                                   TimeUtil::ToChars(d, duration_buffer)));
+  ASSERT_TRUE(TimeUtil::FromString("-315576000000.999999999s", &d));
+  EXPECT_EQ(TimeUtil::kDurationStringMaxLength,
+            TimeUtil::ToChars(d, duration_buffer));
+}
+
+TEST(TimeUtilTest, TimestampParsingEdgeCases) {
+  Timestamp time;
+  // Leap days are only valid in leap years.
+  EXPECT_TRUE(TimeUtil::FromString("2000-02-29T00:00:00Z", &time));
+  EXPECT_EQ("2000-02-29T00:00:00Z", TimeUtil::ToString(time));
+  EXPECT_FALSE(TimeUtil::FromString("1900-02-29T00:00:00Z", &time));
+  EXPECT_FALSE(TimeUtil::FromString("1970-04-31T00:00:00Z", &time));
+  EXPECT_FALSE(TimeUtil::FromString("1970-01-01T24:00:00Z", &time));
+  EXPECT_FALSE(TimeUtil::FromString("1970-01-01T00:00:00", &time));
+  EXPECT_FALSE(TimeUtil::FromString("1970-01-01T00:00:00.Z", &time));
+
+  // Positive offsets are behind UTC.
+  EXPECT_TRUE(TimeUtil::FromString("1970-01-01T05:30:00.5+05:30", &time));
+  EXPECT_EQ(0, time.seconds());
+  EXPECT_EQ(500000000, time.nanos());
+
+  // Forms outside the fixed layout are still accepted.
+  EXPECT_TRUE(TimeUtil::FromString("1970-01-01t00:00:00.0000000001z", &time));
+  EXPECT_EQ(0, TimeUtil::TimestampToNanoseconds(time));
+
+  Duration d;
+  EXPECT_TRUE(TimeUtil::FromString("-0.5s", &d));
+  EXPECT_EQ(0, d.seconds());
+  EXPECT_EQ(-500000000, d.nanos());
+  EXPECT_TRUE(TimeUtil::FromString("+2s", &d));
+  EXPECT_EQ(2, d.seconds());
+  EXPECT_FALSE(TimeUtil::FromString("1.5", &d));
+  EXPECT_FALSE(TimeUtil::FromString("1x.5s", &d));
+}
+
+TEST(TimeUtilTest, BatchConversion) {
+  RepeatedPtrField<Timestamp> timestamps;
+  *timestamps.Add() = TimeUtil::NanosecondsToTimestamp(0);
+  *timestamps.Add() = TimeUtil::NanosecondsToTimestamp(-1);
+  *timestamps.Add() = TimeUtil::NanosecondsToTimestamp(10000);
+
+  std::vector<std::string> strings = {"unchanged"};
+  TimeUtil::ToStrings(timestamps, &strings);
+  ASSERT_EQ(4, strings.size());
+  EXPECT_EQ("unchanged", strings[0]);
+  EXPECT_EQ("1970-01-01T00:00:00Z", strings[1]);
+  EXPECT_EQ("1969-12-31T23:59:59.999999999Z", strings[2]);
+  EXPECT_EQ("1970-01-01T00:00:00.000010Z", strings[3]);
+
+  RepeatedPtrField<Timestamp> parsed;
+  std::vector<absl::string_view> views(strings.begin() + 1, strings.end());
+  EXPECT_TRUE(TimeUtil::FromStrings(views, &parsed));
+  ASSERT_EQ(3, parsed.size());
+  for (int i = 0; i < parsed.size(); ++i) {
+    EXPECT_EQ(timestamps.Get(i), parsed.Get(i));
+  }
+
+  views.push_back("not a timestamp");
+  EXPECT_FALSE(TimeUtil::FromStrings(views, &parsed));
+  EXPECT_EQ(3, parsed.size());
+}
+
 TEST(TimeUtilTest, GetEpoch) {
   EXPECT_EQ(0, TimeUtil::TimestampToNanoseconds(TimeUtil::GetEpoch()));
 }
@@ -33,10 +33,13 @@
 #ifndef GOOGLE_PROTOBUF_UTIL_TYPE_RESOLVER_H__
 #define GOOGLE_PROTOBUF_UTIL_TYPE_RESOLVER_H__
 
+#include <memory>
 #include <string>
+#include <utility>
 
 #include "google/protobuf/type.pb.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "google/protobuf/port.h"
 
 
@@ -65,6 +68,27 @@ class PROTOBUF_EXPORT TypeResolver {
   // Resolves a type url for an enum type.
   virtual absl::Status ResolveEnumType(const std::string& type_url,
                                        google::protobuf::Enum* enum_type) = 0;
+
+  // Like ResolveMessageType() and ResolveEnumType(), but the result may be
+  // shared with other callers and threads, so it must not be modified. The
+  // defaults resolve into a fresh object on every call; resolvers that keep
+  // what they resolve, like the one NewCachingTypeResolver() returns,
+  // override them to hand out that copy instead.
+  virtual absl::StatusOr<std::shared_ptr<const google::protobuf::Type>>
+  ResolveSharedMessageType(const std::string& type_url) {
+    auto message_type = std::make_shared<google::protobuf::Type>();
+    absl::Status status = ResolveMessageType(type_url, message_type.get());
+    if (!status.ok()) return status;
+    return std::shared_ptr<const google::protobuf::Type>(
+        std::move(message_type));
+  }
+  virtual absl::StatusOr<std::shared_ptr<const google::protobuf::Enum>>
+  ResolveSharedEnumType(const std::string& type_url) {
+    auto enum_type = std::make_shared<google::protobuf::Enum>();
+    absl::Status status = ResolveEnumType(type_url, enum_type.get());
+    if (!status.ok()) return status;
+    return std::shared_ptr<const google::protobuf::Enum>(std::move(enum_type));
+  }
 };
 
 }  // namespace util
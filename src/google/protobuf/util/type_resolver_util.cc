@@ -30,19 +30,25 @@
 
 #include "google/protobuf/util/type_resolver_util.h"
 
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/source_context.pb.h"
 #include "google/protobuf/type.pb.h"
 #include "google/protobuf/wrappers.pb.h"
 #include "google/protobuf/descriptor.pb.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/absl_log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "absl/synchronization/mutex.h"
 #include "google/protobuf/descriptor_legacy.h"
 #include "google/protobuf/io/strtod.h"
 #include "google/protobuf/util/type_resolver.h"
@@ -376,6 +382,86 @@ class DescriptorPoolTypeResolver : public TypeResolver {
   const DescriptorPool* pool_;
 };
 
+class CachingTypeResolver : public TypeResolver {
+ public:
+  explicit CachingTypeResolver(TypeResolver* resolver) : resolver_(resolver) {}
+
+  absl::Status ResolveMessageType(const std::string& type_url,
+                                  Type* type) override {
+    auto shared = ResolveSharedMessageType(type_url);
+    if (!shared.ok()) {
+      return shared.status();
+    }
+    *type = **shared;
+    return absl::Status();
+  }
+
+  absl::Status ResolveEnumType(const std::string& type_url,
+                               Enum* enum_type) override {
+    auto shared = ResolveSharedEnumType(type_url);
+    if (!shared.ok()) {
+      return shared.status();
+    }
+    *enum_type = **shared;
+    return absl::Status();
+  }
+
+  absl::StatusOr<std::shared_ptr<const Type>> ResolveSharedMessageType(
+      const std::string& type_url) override {
+    return Find<Type>(type_url, messages_);
+  }
+
+  absl::StatusOr<std::shared_ptr<const Enum>> ResolveSharedEnumType(
+      const std::string& type_url) override {
+    return Find<Enum>(type_url, enums_);
+  }
+
+ private:
+  template <typename T>
+  using Cache = absl::flat_hash_map<std::string, std::shared_ptr<const T>>;
+
+  template <typename T>
+  absl::StatusOr<std::shared_ptr<const T>> Find(const std::string& type_url,
+                                                Cache<T>& cache) {
+    {
+      absl::ReaderMutexLock lock(&mutex_);
+      auto it = cache.find(type_url);
+      if (it != cache.end()) {
+        return it->second;
+      }
+    }
+    // Resolve without holding the lock. Threads that miss on the same URL at
+    // once may all resolve it, but only the first result is kept.
+    auto resolved = Resolve<T>(type_url);
+    if (!resolved.ok()) {
+      return resolved.status();
+    }
+    absl::MutexLock lock(&mutex_);
+    return cache.try_emplace(type_url, *std::move(resolved)).first->second;
+  }
+
+  template <typename T>
+  absl::StatusOr<std::shared_ptr<const T>> Resolve(
+      const std::string& type_url);
+
+  TypeResolver* resolver_;
+  absl::Mutex mutex_;
+  Cache<Type> messages_ ABSL_GUARDED_BY(mutex_);
+  Cache<Enum> enums_ ABSL_GUARDED_BY(mutex_);
+};
+
+template <>
+absl::StatusOr<std::shared_ptr<const Type>> CachingTypeResolver::Resolve(
+    const std::string& type_url) {
+  return resolver_->ResolveSharedMessageType(type_url);
+}
+
+template <>
+absl::StatusOr<std::shared_ptr<const Enum>> CachingTypeResolver::Resolve(
+    const std::string& type_url) {
+  return resolver_->ResolveSharedEnumType(type_url);
+}
+
 }  // namespace
 
 TypeResolver* NewTypeResolverForDescriptorPool(absl::string_view url_prefix,
@@ -383,6 +469,10 @@ TypeResolver* NewTypeResolverForDescriptorPool(absl::string_view url_prefix,
   return new DescriptorPoolTypeResolver(url_prefix, pool);
 }
 
+TypeResolver* NewCachingTypeResolver(TypeResolver* resolver) {
+  return new CachingTypeResolver(resolver);
+}
+
 // Performs a direct conversion from a descriptor to a type proto.
 Type ConvertDescriptorToType(absl::string_view url_prefix,
                              const Descriptor& descriptor) {
@@ -51,6 +51,15 @@ class TypeResolver;
 PROTOBUF_EXPORT TypeResolver* NewTypeResolverForDescriptorPool(
     absl::string_view url_prefix, const DescriptorPool* pool);
 
+// Creates a TypeResolver that resolves each type URL through `resolver` once
+// and serves later requests for it from memory, so that transcoding many
+// messages of the same types does not convert their descriptors again every
+// time. Failed lookups are not remembered. The returned resolver is
+// thread-safe, and shares what it resolved through ResolveSharedMessageType()
+// and ResolveSharedEnumType(). Caller takes ownership of the returned
+// TypeResolver; `resolver` is not owned and must outlive it.
+PROTOBUF_EXPORT TypeResolver* NewCachingTypeResolver(TypeResolver* resolver);
+
 // Performs a direct conversion from a descriptor to a type proto.
 PROTOBUF_EXPORT google::protobuf::Type ConvertDescriptorToType(
     absl::string_view url_prefix, const Descriptor& descriptor);
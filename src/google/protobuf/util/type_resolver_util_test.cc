@@ -30,10 +30,12 @@
 
 #include "google/protobuf/util/type_resolver_util.h"
 
+#include <atomic>
 #include <cstdint>
 #include <limits>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "google/protobuf/any.pb.h"
@@ -695,6 +697,95 @@ TEST(ConvertDescriptorToTypeTest, TestCustomEnumOptions) {
       HasInt32Option(value->options(), "protobuf_unittest.enum_value_opt1", 123));
 }
 
+// Forwards to a resolver while counting calls.
+class CountingTypeResolver : public TypeResolver {
+ public:
+  explicit CountingTypeResolver(TypeResolver* resolver)
+      : resolver_(resolver) {}
+
+  absl::Status ResolveMessageType(const std::string& type_url,
+                                  Type* type) override {
+    ++message_calls_;
+    return resolver_->ResolveMessageType(type_url, type);
+  }
+
+  absl::Status ResolveEnumType(const std::string& type_url,
+                               Enum* enum_type) override {
+    ++enum_calls_;
+    return resolver_->ResolveEnumType(type_url, enum_type);
+  }
+
+  int message_calls() const { return message_calls_; }
+  int enum_calls() const { return enum_calls_; }
+
+ private:
+  TypeResolver* resolver_;
+  std::atomic<int> message_calls_{0};
+  std::atomic<int> enum_calls_{0};
+};
+
+TEST(CachingTypeResolverTest, ResolvesEachTypeOnce) {
+  std::unique_ptr<TypeResolver> pool_resolver(NewTypeResolverForDescriptorPool(
+      kUrlPrefix, DescriptorPool::generated_pool()));
+  CountingTypeResolver counting(pool_resolver.get());
+  std::unique_ptr<TypeResolver> resolver(NewCachingTypeResolver(&counting));
+  const std::string url = GetTypeUrl<protobuf_unittest::TestAllTypes>();
+
+  Type expected, type;
+  ASSERT_TRUE(pool_resolver->ResolveMessageType(url, &expected).ok());
+  ASSERT_TRUE(resolver->ResolveMessageType(url, &type).ok());
+  EXPECT_EQ(expected.SerializeAsString(), type.SerializeAsString());
+  auto shared1 = resolver->ResolveSharedMessageType(url);
+  auto shared2 = resolver->ResolveSharedMessageType(url);
+  ASSERT_TRUE(shared1.ok());
+  ASSERT_TRUE(shared2.ok());
+  EXPECT_EQ(shared1->get(), shared2->get());
+  EXPECT_EQ(1, counting.message_calls());
+
+  const std::string enum_url =
+      GetTypeUrl("protobuf_unittest.TestAllTypes.NestedEnum");
+  Enum enum_type;
+  ASSERT_TRUE(resolver->ResolveEnumType(enum_url, &enum_type).ok());
+  ASSERT_TRUE(resolver->ResolveEnumType(enum_url, &enum_type).ok());
+  EXPECT_TRUE(EnumHasValue(enum_type, "FOO", 1));
+  EXPECT_EQ(1, counting.enum_calls());
+
+  // Failures are not remembered.
+  const std::string unknown_url = GetTypeUrl("unknown.Type");
+  EXPECT_FALSE(resolver->ResolveMessageType(unknown_url, &type).ok());
+  EXPECT_FALSE(resolver->ResolveMessageType(unknown_url, &type).ok());
+  EXPECT_EQ(3, counting.message_calls());
+}
+
+TEST(CachingTypeResolverTest, ConcurrentResolve) {
+  std::unique_ptr<TypeResolver> pool_resolver(NewTypeResolverForDescriptorPool(
+      kUrlPrefix, DescriptorPool::generated_pool()));
+  std::unique_ptr<TypeResolver> resolver(
+      NewCachingTypeResolver(pool_resolver.get()));
+  const std::string urls[] = {
+      GetTypeUrl<protobuf_unittest::TestAllTypes>(),
+      GetTypeUrl<protobuf_unittest::TestMap>(),
+      GetTypeUrl<protobuf_unittest::ForeignMessage>(),
+  };
+  std::vector<std::thread> threads;
+  std::vector<const Type*> seen(8 * 3);
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 3; ++i) {
+        auto type = resolver->ResolveSharedMessageType(urls[i]);
+        ASSERT_TRUE(type.ok());
+        seen[t * 3 + i] = type->get();
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int t = 1; t < 8; ++t) {
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(seen[i], seen[t * 3 + i]);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace util
 }  // namespace protobuf
@@ -0,0 +1,423 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/wire_hash.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "google/protobuf/wire_reader.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+namespace {
+
+using internal::WireFormatLite;
+
+// Same as the default recursion limit of io::CodedInputStream.
+constexpr int kMaxDepth = 100;
+
+struct Record {
+  uint32_t tag;
+  // The field the record belongs to, or null if it is an unknown field,
+  // including one whose wire type does not match its field.
+  const FieldDescriptor* field;
+  // The whole record, tag included.
+  absl::string_view bytes;
+  // The payload of a length-delimited record or the body of a group.
+  absl::string_view payload;
+  // The value of a varint or fixed record.
+  uint64_t value;
+};
+
+int FieldNumber(const Record& record) {
+  return WireFormatLite::GetTagFieldNumber(record.tag);
+}
+
+WireFormatLite::WireType RecordWireType(const Record& record) {
+  return WireFormatLite::GetTagWireType(record.tag);
+}
+
+bool ReadRecords(absl::string_view data, std::vector<Record>* records) {
+  WireReader reader(data);
+  size_t begin = 0;
+  while (reader.Next()) {
+    const size_t end = data.size() - reader.remaining().size();
+    Record record{reader.tag(), nullptr, data.substr(begin, end - begin), {},
+                  0};
+    switch (reader.wire_type()) {
+      case WireReader::kVarint:
+        record.value = reader.varint();
+        break;
+      case WireReader::kFixed64:
+        record.value = reader.fixed64();
+        break;
+      case WireReader::kFixed32:
+        record.value = reader.fixed32();
+        break;
+      default:
+        record.payload = reader.bytes();
+        break;
+    }
+    records->push_back(record);
+    begin = end;
+  }
+  return !reader.failed();
+}
+
+const FieldDescriptor* FindField(const Descriptor* descriptor, int number) {
+  const FieldDescriptor* field = descriptor->FindFieldByNumber(number);
+  if (field == nullptr && descriptor->IsExtensionNumber(number)) {
+    field = descriptor->file()->pool()->FindExtensionByNumber(descriptor,
+                                                              number);
+  }
+  return field;
+}
+
+WireFormatLite::WireType WireTypeForField(const FieldDescriptor* field) {
+  return WireFormatLite::WireTypeForFieldType(
+      static_cast<WireFormatLite::FieldType>(field->type()));
+}
+
+void AppendVarint(uint64_t value, std::string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+void AppendTag(int number, WireFormatLite::WireType wire_type,
+               std::string* output) {
+  AppendVarint(WireFormatLite::MakeTag(number, wire_type), output);
+}
+
+void AppendValue(WireFormatLite::WireType wire_type, uint64_t value,
+                 std::string* output) {
+  switch (wire_type) {
+    case WireFormatLite::WIRETYPE_FIXED32:
+    case WireFormatLite::WIRETYPE_FIXED64: {
+      const int size = wire_type == WireFormatLite::WIRETYPE_FIXED32 ? 4 : 8;
+      for (int i = 0; i < size; ++i) {
+        output->push_back(static_cast<char>(value >> (8 * i)));
+      }
+      break;
+    }
+    default:
+      AppendVarint(value, output);
+      break;
+  }
+}
+
+void AppendLengthDelimited(int number, absl::string_view payload,
+                           std::string* output) {
+  AppendTag(number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+  AppendVarint(payload.size(), output);
+  output->append(payload.data(), payload.size());
+}
+
+// Returns the raw value `value` of `field` as it would be serialized after a
+// parse. A zero result is the default value of the field.
+uint64_t NormalizeValue(const FieldDescriptor* field, uint64_t value) {
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_INT32:
+    case FieldDescriptor::TYPE_ENUM:
+      // Parsed as 32 bits and serialized sign extended.
+      return static_cast<uint64_t>(
+          static_cast<int64_t>(static_cast<int32_t>(value)));
+    case FieldDescriptor::TYPE_UINT32:
+    case FieldDescriptor::TYPE_SINT32:
+      return static_cast<uint32_t>(value);
+    case FieldDescriptor::TYPE_BOOL:
+      return value != 0;
+    case FieldDescriptor::TYPE_FLOAT: {
+      const uint32_t bits = static_cast<uint32_t>(value);
+      float number;
+      std::memcpy(&number, &bits, sizeof(number));
+      if (number != number) return 0x7fc00000;
+      return number == 0 ? 0 : bits;
+    }
+    case FieldDescriptor::TYPE_DOUBLE: {
+      double number;
+      std::memcpy(&number, &value, sizeof(number));
+      if (number != number) return 0x7ff8000000000000;
+      return number == 0 ? 0 : value;
+    }
+    default:
+      return value;
+  }
+}
+
+// Appends to `values` the scalars of `field` in the packed payload `payload`.
+bool ReadPacked(const FieldDescriptor* field, absl::string_view payload,
+                std::vector<uint64_t>* values) {
+  io::CodedInputStream input(reinterpret_cast<const uint8_t*>(payload.data()),
+                             static_cast<int>(payload.size()));
+  while (input.CurrentPosition() < static_cast<int>(payload.size())) {
+    uint64_t value;
+    switch (WireTypeForField(field)) {
+      case WireFormatLite::WIRETYPE_FIXED32: {
+        uint32_t value32;
+        if (!input.ReadLittleEndian32(&value32)) return false;
+        value = value32;
+        break;
+      }
+      case WireFormatLite::WIRETYPE_FIXED64:
+        if (!input.ReadLittleEndian64(&value)) return false;
+        break;
+      default:
+        if (!input.ReadVarint64(&value)) return false;
+        break;
+    }
+    values->push_back(NormalizeValue(field, value));
+  }
+  return true;
+}
+
+// Returns the key record at the start of the canonical map entry `entry`,
+// which is empty if the key has its default value.
+absl::string_view MapEntryKey(absl::string_view entry) {
+  WireReader reader(entry);
+  if (!reader.Next() || reader.field_number() != 1) {
+    return absl::string_view();
+  }
+  return entry.substr(0, entry.size() - reader.remaining().size());
+}
+
+bool Canonicalize(const Descriptor* descriptor, absl::string_view data,
+                  int depth, std::string* output);
+
+void AppendMessage(const FieldDescriptor* field, absl::string_view body,
+                   std::string* output) {
+  if (field->type() == FieldDescriptor::TYPE_GROUP) {
+    AppendTag(field->number(), WireFormatLite::WIRETYPE_START_GROUP, output);
+    output->append(body.data(), body.size());
+    AppendTag(field->number(), WireFormatLite::WIRETYPE_END_GROUP, output);
+  } else {
+    AppendLengthDelimited(field->number(), body, output);
+  }
+}
+
+// Appends the canonical form of `field`, which occurs in `records` in wire
+// order.
+bool CanonicalizeField(const FieldDescriptor* field,
+                       absl::Span<const Record> records, int depth,
+                       std::string* output) {
+  // The key and value of a map entry are defaulted when missing, so they
+  // behave like fields without presence.
+  const bool implicit_presence =
+      !field->has_presence() ||
+      field->containing_type()->options().map_entry();
+  const Record& last = records.back();
+
+  if (field->is_map()) {
+    absl::btree_map<std::string, std::string> entries;
+    for (const Record& record : records) {
+      std::string entry;
+      if (!Canonicalize(field->message_type(), record.payload, depth + 1,
+                        &entry)) {
+        return false;
+      }
+      std::string key(MapEntryKey(entry));
+      entries[std::move(key)] = std::move(entry);
+    }
+    for (const auto& entry : entries) {
+      AppendLengthDelimited(field->number(), entry.second, output);
+    }
+    return true;
+  }
+
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_MESSAGE: {
+      if (field->is_repeated()) {
+        for (const Record& record : records) {
+          std::string body;
+          if (!Canonicalize(field->message_type(), record.payload, depth + 1,
+                            &body)) {
+            return false;
+          }
+          AppendMessage(field, body, output);
+        }
+        return true;
+      }
+      // Occurrences of a singular message field are merged, which is what
+      // parsing their concatenation does.
+      std::string merged;
+      absl::string_view payload = last.payload;
+      if (records.size() > 1) {
+        for (const Record& record : records) {
+          merged.append(record.payload.data(), record.payload.size());
+        }
+        payload = merged;
+      }
+      std::string body;
+      if (!Canonicalize(field->message_type(), payload, depth + 1, &body)) {
+        return false;
+      }
+      if (implicit_presence && body.empty()) return true;
+      AppendMessage(field, body, output);
+      return true;
+    }
+    case FieldDescriptor::CPPTYPE_STRING:
+      if (field->is_repeated()) {
+        for (const Record& record : records) {
+          AppendLengthDelimited(field->number(), record.payload, output);
+        }
+      } else if (!implicit_presence || !last.payload.empty()) {
+        AppendLengthDelimited(field->number(), last.payload, output);
+      }
+      return true;
+    default:
+      break;
+  }
+
+  const WireFormatLite::WireType wire_type = WireTypeForField(field);
+  if (!field->is_repeated()) {
+    const uint64_t value = NormalizeValue(field, last.value);
+    if (implicit_presence && value == 0) return true;
+    AppendTag(field->number(), wire_type, output);
+    AppendValue(wire_type, value, output);
+    return true;
+  }
+  std::vector<uint64_t> values;
+  for (const Record& record : records) {
+    if (RecordWireType(record) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (!ReadPacked(field, record.payload, &values)) return false;
+    } else {
+      values.push_back(NormalizeValue(field, record.value));
+    }
+  }
+  if (values.empty()) return true;
+  std::string packed;
+  for (uint64_t value : values) AppendValue(wire_type, value, &packed);
+  AppendLengthDelimited(field->number(), packed, output);
+  return true;
+}
+
+bool Canonicalize(const Descriptor* descriptor, absl::string_view data,
+                  int depth, std::string* output) {
+  if (depth > kMaxDepth) return false;
+  std::vector<Record> records;
+  if (!ReadRecords(data, &records)) return false;
+
+  // Setting a member of a oneof clears the others, so only the member that
+  // occurs last on the wire is kept.
+  absl::flat_hash_map<const OneofDescriptor*, const FieldDescriptor*>
+      oneof_cases;
+  for (Record& record : records) {
+    const FieldDescriptor* field = FindField(descriptor, FieldNumber(record));
+    if (field == nullptr) continue;
+    const WireFormatLite::WireType wire_type = RecordWireType(record);
+    if (wire_type != WireTypeForField(field) &&
+        !(field->is_packable() &&
+          wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED)) {
+      continue;
+    }
+    record.field = field;
+    if (field->real_containing_oneof() != nullptr) {
+      oneof_cases[field->real_containing_oneof()] = field;
+    }
+  }
+
+  // Known records go before the unknown ones with the same number.
+  std::stable_sort(records.begin(), records.end(),
+                   [](const Record& a, const Record& b) {
+                     return std::make_pair(FieldNumber(a), a.field == nullptr) <
+                            std::make_pair(FieldNumber(b), b.field == nullptr);
+                   });
+  for (size_t begin = 0; begin < records.size();) {
+    const Record& first = records[begin];
+    size_t end = begin + 1;
+    while (end < records.size() &&
+           FieldNumber(records[end]) == FieldNumber(first) &&
+           records[end].field == first.field) {
+      ++end;
+    }
+    if (first.field == nullptr) {
+      for (size_t i = begin; i < end; ++i) {
+        output->append(records[i].bytes.data(), records[i].bytes.size());
+      }
+    } else if (first.field->real_containing_oneof() == nullptr ||
+               oneof_cases[first.field->real_containing_oneof()] ==
+                   first.field) {
+      if (!CanonicalizeField(first.field,
+                             absl::MakeConstSpan(&records[begin], end - begin),
+                             depth, output)) {
+        return false;
+      }
+    }
+    begin = end;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool CanonicalizeSerializedMessage(const Descriptor* descriptor,
+                                   absl::string_view data,
+                                   std::string* output) {
+  output->clear();
+  return Canonicalize(descriptor, data, 0, output);
+}
+
+absl::optional<size_t> HashSerializedMessage(const Descriptor* descriptor,
+                                             absl::string_view data) {
+  std::string canonical;
+  if (!CanonicalizeSerializedMessage(descriptor, data, &canonical)) {
+    return absl::nullopt;
+  }
+  return absl::Hash<std::string>()(canonical);
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
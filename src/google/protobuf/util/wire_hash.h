@@ -0,0 +1,97 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Canonical form and content hash of serialized messages, computed from the
+// wire bytes without parsing them into a message object.
+//
+// Equal messages can serialize to different bytes: fields may come in any
+// order, map entries in any order, repeated scalars packed or not, a singular
+// field may occur several times, and so on. CanonicalizeSerializedMessage()
+// rewrites a serialization into a form that is the same for all of them, so
+// the canonical bytes can be compared or hashed directly. This replaces the
+// parse, deterministic serialization and hash round trip usually done to
+// deduplicate messages by content.
+//
+//   absl::optional<size_t> hash =
+//       util::HashSerializedMessage(Request::descriptor(), wire);
+
+#ifndef GOOGLE_PROTOBUF_UTIL_WIRE_HASH_H__
+#define GOOGLE_PROTOBUF_UTIL_WIRE_HASH_H__
+
+#include <cstddef>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "google/protobuf/descriptor.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+// Writes to `*output` the canonical form of `data`, a serialized message of
+// type `descriptor`. Two serializations have the same canonical form if and
+// only if they parse to messages that MessageDifferencer::Equals() considers
+// equal, except that NaNs compare equal to each other here. In the canonical
+// form:
+//   * known fields come in field number order, each followed by the unknown
+//     records with the same number, which keep their order;
+//   * a singular field occurs at most once, with the last value on the wire,
+//     and occurrences of a singular message field are merged;
+//   * only the last member set of a oneof is kept;
+//   * fields without presence that hold their default value are dropped;
+//   * repeated scalars are packed, whatever their encoding on the wire;
+//   * map entries are sorted by key, and only the last entry for a key is
+//     kept;
+//   * negative zero and NaN floating point values are normalized.
+// The canonical form is itself a serialization of the message. Extensions
+// are recognized if they are in the pool of `descriptor`, and are treated as
+// unknown fields otherwise. Returns false if `data` is malformed.
+PROTOBUF_EXPORT bool CanonicalizeSerializedMessage(const Descriptor* descriptor,
+                                                   absl::string_view data,
+                                                   std::string* output);
+
+// Returns a hash of the canonical form of `data`, so equal messages hash the
+// same however they were serialized, or nullopt if `data` is malformed. Like
+// absl::Hash, the hash is only stable within a process; persist a
+// fingerprint of the canonical form instead.
+PROTOBUF_EXPORT absl::optional<size_t> HashSerializedMessage(
+    const Descriptor* descriptor, absl::string_view data);
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_WIRE_HASH_H__
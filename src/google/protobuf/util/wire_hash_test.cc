@@ -0,0 +1,212 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/wire_hash.h"
+
+#include <string>
+
+#include "google/protobuf/testing/googletest.h"
+#include <gtest/gtest.h>
+#include "google/protobuf/map_unittest.pb.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/unittest_proto3.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+using ::protobuf_unittest::TestMap;
+using ::protobuf_unittest::TestPackedTypes;
+using ::protobuf_unittest::TestUnpackedTypes;
+
+std::string Canonical(const Descriptor* descriptor, const std::string& data) {
+  std::string canonical;
+  EXPECT_TRUE(CanonicalizeSerializedMessage(descriptor, data, &canonical));
+  return canonical;
+}
+
+TEST(WireHashTest, CanonicalFormParsesToTheSameMessage) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string canonical =
+      Canonical(TestAllTypes::descriptor(), message.SerializeAsString());
+
+  TestAllTypes parsed;
+  ASSERT_TRUE(parsed.ParseFromString(canonical));
+  EXPECT_EQ(parsed.SerializeAsString(), message.SerializeAsString());
+  EXPECT_EQ(Canonical(TestAllTypes::descriptor(), canonical), canonical);
+}
+
+TEST(WireHashTest, IgnoresFieldOrder) {
+  TestAllTypes first, second;
+  first.set_optional_int32(1);
+  first.add_repeated_string("a");
+  second.set_optional_string("b");
+  second.mutable_optional_nested_message()->set_bb(2);
+
+  const std::string forward =
+      first.SerializeAsString() + second.SerializeAsString();
+  const std::string backward =
+      second.SerializeAsString() + first.SerializeAsString();
+  ASSERT_NE(forward, backward);
+  EXPECT_EQ(Canonical(TestAllTypes::descriptor(), forward),
+            Canonical(TestAllTypes::descriptor(), backward));
+  EXPECT_EQ(HashSerializedMessage(TestAllTypes::descriptor(), forward),
+            HashSerializedMessage(TestAllTypes::descriptor(), backward));
+}
+
+TEST(WireHashTest, KeepsRepeatedOrder) {
+  TestAllTypes forward, backward;
+  forward.add_repeated_int32(1);
+  forward.add_repeated_int32(2);
+  backward.add_repeated_int32(2);
+  backward.add_repeated_int32(1);
+
+  EXPECT_NE(Canonical(TestAllTypes::descriptor(), forward.SerializeAsString()),
+            Canonical(TestAllTypes::descriptor(),
+                      backward.SerializeAsString()));
+}
+
+TEST(WireHashTest, NormalizesPackedEncoding) {
+  TestPackedTypes packed;
+  TestUtil::SetPackedFields(&packed);
+  TestUnpackedTypes unpacked;
+  TestUtil::SetUnpackedFields(&unpacked);
+
+  // The two types use the same field numbers.
+  EXPECT_EQ(Canonical(TestPackedTypes::descriptor(),
+                      packed.SerializeAsString()),
+            Canonical(TestPackedTypes::descriptor(),
+                      unpacked.SerializeAsString()));
+}
+
+TEST(WireHashTest, LastValueOfSingularFieldWins) {
+  TestAllTypes first, second, expected;
+  first.set_optional_int32(1);
+  first.mutable_optional_nested_message()->set_bb(1);
+  second.set_optional_int32(2);
+  second.mutable_optional_foreign_message()->set_c(3);
+  expected.set_optional_int32(2);
+  expected.mutable_optional_nested_message()->set_bb(1);
+  expected.mutable_optional_foreign_message()->set_c(3);
+
+  EXPECT_EQ(Canonical(TestAllTypes::descriptor(),
+                      first.SerializeAsString() + second.SerializeAsString()),
+            Canonical(TestAllTypes::descriptor(),
+                      expected.SerializeAsString()));
+}
+
+TEST(WireHashTest, MergesSingularMessages) {
+  TestAllTypes first, second, expected;
+  first.mutable_optional_foreign_message()->set_c(1);
+  second.mutable_optional_foreign_message()->set_d(2);
+  expected.mutable_optional_foreign_message()->set_c(1);
+  expected.mutable_optional_foreign_message()->set_d(2);
+
+  EXPECT_EQ(Canonical(TestAllTypes::descriptor(),
+                      first.SerializeAsString() + second.SerializeAsString()),
+            Canonical(TestAllTypes::descriptor(),
+                      expected.SerializeAsString()));
+}
+
+TEST(WireHashTest, KeepsLastOneofMember) {
+  TestAllTypes first, second;
+  first.set_oneof_uint32(1);
+  second.set_oneof_string("last");
+
+  EXPECT_EQ(Canonical(TestAllTypes::descriptor(),
+                      first.SerializeAsString() + second.SerializeAsString()),
+            Canonical(TestAllTypes::descriptor(), second.SerializeAsString()));
+}
+
+TEST(WireHashTest, IgnoresMapEntryOrder) {
+  TestMap first, second, overwritten;
+  (*first.mutable_map_int32_int32())[1] = 10;
+  (*first.mutable_map_string_string())["a"] = "x";
+  (*second.mutable_map_int32_int32())[2] = 20;
+  (*second.mutable_map_int32_int32())[0] = 0;
+  (*overwritten.mutable_map_int32_int32())[1] = 11;
+
+  EXPECT_EQ(Canonical(TestMap::descriptor(),
+                      first.SerializeAsString() + second.SerializeAsString()),
+            Canonical(TestMap::descriptor(),
+                      second.SerializeAsString() + first.SerializeAsString()));
+  // The last entry for a key wins.
+  TestMap expected = second;
+  (*expected.mutable_map_int32_int32())[1] = 11;
+  (*expected.mutable_map_string_string())["a"] = "x";
+  EXPECT_EQ(Canonical(TestMap::descriptor(),
+                      first.SerializeAsString() + second.SerializeAsString() +
+                          overwritten.SerializeAsString()),
+            Canonical(TestMap::descriptor(), expected.SerializeAsString()));
+}
+
+TEST(WireHashTest, DropsDefaultsOfFieldsWithoutPresence) {
+  proto3_unittest::TestAllTypes message;
+  message.set_optional_int32(0);
+  message.set_optional_double(-0.0);
+  // An explicit zero, which the serializer would not write.
+  const std::string explicit_zero("\x08\x00", 2);
+
+  EXPECT_EQ(Canonical(proto3_unittest::TestAllTypes::descriptor(),
+                      explicit_zero + message.SerializeAsString()),
+            "");
+}
+
+TEST(WireHashTest, KeepsUnknownFields) {
+  TestAllTypes message;
+  message.set_optional_int32(1);
+  const std::string unknown("\xf8\xff\x0f\x01", 4);
+
+  EXPECT_NE(Canonical(TestAllTypes::descriptor(),
+                      message.SerializeAsString() + unknown),
+            Canonical(TestAllTypes::descriptor(), message.SerializeAsString()));
+  EXPECT_EQ(Canonical(TestAllTypes::descriptor(),
+                      unknown + message.SerializeAsString()),
+            Canonical(TestAllTypes::descriptor(),
+                      message.SerializeAsString() + unknown));
+}
+
+TEST(WireHashTest, Malformed) {
+  TestAllTypes message;
+  message.mutable_optional_nested_message()->set_bb(1);
+  std::string data = message.SerializeAsString();
+  data.pop_back();
+
+  EXPECT_FALSE(HashSerializedMessage(TestAllTypes::descriptor(), data));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
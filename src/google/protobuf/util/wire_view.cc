@@ -0,0 +1,146 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/wire_view.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "google/protobuf/message_lite.h"
+#include "google/protobuf/wire_reader.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+namespace {
+
+// Calls `visit(reader)` with `reader` on every top-level record of `data`.
+// Returns false if `data` is malformed.
+template <typename Visit>
+bool ForEachRecord(absl::string_view data, Visit visit) {
+  WireReader reader(data);
+  while (reader.Next()) visit(reader);
+  return !reader.failed();
+}
+
+// Visits the length-delimited records of field `number`, skipping all others.
+template <typename Visit>
+bool ForEachLengthDelimited(absl::string_view data, int number, Visit visit) {
+  return ForEachRecord(data, [&](const WireReader& reader) {
+    if (reader.field_number() == number &&
+        reader.wire_type() == WireReader::kLengthDelimited) {
+      visit(reader.bytes());
+    }
+  });
+}
+
+}  // namespace
+
+bool WireView::IsWellFormed() const {
+  return ForEachRecord(data_, [](const WireReader&) {});
+}
+
+absl::optional<absl::string_view> WireView::GetBytes(int number) const {
+  absl::optional<absl::string_view> result;
+  ForEachLengthDelimited(data_, number,
+                         [&](absl::string_view payload) { result = payload; });
+  return result;
+}
+
+std::vector<absl::string_view> WireView::GetRepeatedBytes(int number) const {
+  std::vector<absl::string_view> result;
+  ForEachLengthDelimited(data_, number, [&](absl::string_view payload) {
+    result.push_back(payload);
+  });
+  return result;
+}
+
+absl::optional<WireView> WireView::GetMessage(int number) const {
+  absl::optional<absl::string_view> payload = GetBytes(number);
+  if (!payload.has_value()) return absl::nullopt;
+  return WireView(*payload);
+}
+
+absl::optional<uint64_t> WireView::GetVarint(int number) const {
+  absl::optional<uint64_t> result;
+  ForEachRecord(data_, [&](const WireReader& reader) {
+    if (reader.field_number() == number &&
+        reader.wire_type() == WireReader::kVarint) {
+      result = reader.varint();
+    }
+  });
+  return result;
+}
+
+bool PatchSerializedMessage(absl::string_view data,
+                            const MessageLite& updates,
+                            absl::Span<const int> clear_fields,
+                            std::string* output) {
+  const std::string replacement = updates.SerializePartialAsString();
+  std::vector<int> replaced(clear_fields.begin(), clear_fields.end());
+  ForEachRecord(replacement, [&](const WireReader& reader) {
+    replaced.push_back(reader.field_number());
+  });
+  std::sort(replaced.begin(), replaced.end());
+
+  output->clear();
+  output->reserve(data.size() + replacement.size());
+  // Runs of kept records are appended in one go.
+  size_t kept_begin = 0;
+  size_t record_begin = 0;
+  const bool well_formed = ForEachRecord(data, [&](const WireReader& reader) {
+    const size_t record_end = data.size() - reader.remaining().size();
+    if (std::binary_search(replaced.begin(), replaced.end(),
+                           reader.field_number())) {
+      output->append(data.data() + kept_begin, record_begin - kept_begin);
+      kept_begin = record_end;
+    }
+    record_begin = record_end;
+  });
+  if (!well_formed) return false;
+  output->append(data.data() + kept_begin, data.size() - kept_begin);
+  output->append(replacement);
+  return true;
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
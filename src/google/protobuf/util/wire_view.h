@@ -0,0 +1,126 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// WireView reads individual fields of a serialized message without parsing
+// it into a message object. String, bytes and submessage payloads are
+// returned as views into the input, so nothing is copied. The input must
+// outlive the WireView and every view obtained from it, e.g. because it is a
+// memory-mapped file or a pinned network buffer.
+//
+// Every lookup scans the top level of the message, so WireView suits reading
+// a handful of fields; parse into a message to read many.
+//
+//   util::WireView request(buffer);
+//   absl::optional<util::WireView> header = request.GetMessage(1);
+//   absl::optional<absl::string_view> user =
+//       header ? header->GetBytes(3) : absl::nullopt;
+//
+// PatchSerializedMessage() is the writing counterpart: it replaces a few
+// top-level fields of a serialized message and copies the rest verbatim.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_WIRE_VIEW_H__
+#define GOOGLE_PROTOBUF_UTIL_WIRE_VIEW_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "google/protobuf/message_lite.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+class PROTOBUF_EXPORT WireView {
+ public:
+  explicit WireView(absl::string_view data) : data_(data) {}
+
+  // The serialized message this view reads.
+  absl::string_view data() const { return data_; }
+
+  // Returns false if the top level of the message is malformed. The getters
+  // only see the fields before the first malformed record.
+  bool IsWellFormed() const;
+
+  // Returns the payload of the last occurrence of the length-delimited field
+  // `number` (a string, bytes or message field), like the accessor of a
+  // singular string field.
+  absl::optional<absl::string_view> GetBytes(int number) const;
+
+  // Returns the payloads of all occurrences of the length-delimited field
+  // `number`, in order, like the elements of a repeated string field.
+  std::vector<absl::string_view> GetRepeatedBytes(int number) const;
+
+  // Returns a view of the last occurrence of the submessage field `number`.
+  // Unlike a parse, earlier occurrences are not merged into it.
+  absl::optional<WireView> GetMessage(int number) const;
+
+  // Returns the last value of the varint field `number`, as the raw uint64_t
+  // on the wire. Packed occurrences are not decoded.
+  absl::optional<uint64_t> GetVarint(int number) const;
+
+ private:
+  absl::string_view data_;
+};
+
+// Writes to `*output` the serialized message `data` with the top-level fields
+// that are present in `updates` replaced by their values there, and the
+// fields numbered in `clear_fields` removed. All other records are copied
+// byte for byte without being parsed, so this is much cheaper than a parse,
+// modify and serialize round trip when only a few fields change.
+//
+// Fields are replaced, not merged: previous occurrences of a repeated field
+// or a submessage are dropped entirely. `clear_fields` is also the way to set
+// a field without presence back to its default, since `updates` does not
+// serialize it. The replaced fields move to the end of the output, which
+// parses to the same message. Returns false if `data` is malformed.
+//
+//   Request update;
+//   update.set_deadline_ms(50);
+//   util::PatchSerializedMessage(wire, update, {Request::kTraceIdFieldNumber},
+//                                &patched);
+PROTOBUF_EXPORT bool PatchSerializedMessage(absl::string_view data,
+                                            const MessageLite& updates,
+                                            absl::Span<const int> clear_fields,
+                                            std::string* output);
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_WIRE_VIEW_H__
@@ -0,0 +1,175 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/wire_view.h"
+
+#include <string>
+
+#include "google/protobuf/testing/googletest.h"
+#include <gtest/gtest.h>
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+
+TEST(WireViewTest, ReadsFieldsAsViewsIntoTheInput) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string data = message.SerializeAsString();
+
+  WireView view(data);
+  EXPECT_TRUE(view.IsWellFormed());
+
+  absl::optional<absl::string_view> bytes =
+      view.GetBytes(TestAllTypes::kOptionalStringFieldNumber);
+  ASSERT_TRUE(bytes.has_value());
+  EXPECT_EQ(*bytes, message.optional_string());
+  // The payload aliases the input instead of copying it.
+  EXPECT_GE(bytes->data(), data.data());
+  EXPECT_LE(bytes->data() + bytes->size(), data.data() + data.size());
+
+  std::vector<absl::string_view> repeated =
+      view.GetRepeatedBytes(TestAllTypes::kRepeatedStringFieldNumber);
+  ASSERT_EQ(repeated.size(), 2);
+  EXPECT_EQ(repeated[0], message.repeated_string(0));
+  EXPECT_EQ(repeated[1], message.repeated_string(1));
+
+  EXPECT_EQ(view.GetVarint(TestAllTypes::kOptionalInt32FieldNumber),
+            message.optional_int32());
+
+  absl::optional<WireView> nested =
+      view.GetMessage(TestAllTypes::kOptionalNestedMessageFieldNumber);
+  ASSERT_TRUE(nested.has_value());
+  EXPECT_EQ(nested->GetVarint(TestAllTypes::NestedMessage::kBbFieldNumber),
+            message.optional_nested_message().bb());
+}
+
+TEST(WireViewTest, MissingFields) {
+  TestAllTypes message;
+  message.set_optional_int32(1);
+  std::string data = message.SerializeAsString();
+
+  WireView view(data);
+  EXPECT_FALSE(view.GetBytes(TestAllTypes::kOptionalStringFieldNumber));
+  EXPECT_TRUE(
+      view.GetRepeatedBytes(TestAllTypes::kRepeatedStringFieldNumber).empty());
+  EXPECT_FALSE(
+      view.GetMessage(TestAllTypes::kOptionalNestedMessageFieldNumber));
+  EXPECT_FALSE(view.GetVarint(TestAllTypes::kOptionalInt64FieldNumber));
+}
+
+TEST(WireViewTest, LastOccurrenceWins) {
+  TestAllTypes first, second;
+  first.set_optional_string("first");
+  second.set_optional_string("second");
+  std::string data = first.SerializeAsString() + second.SerializeAsString();
+
+  EXPECT_EQ(WireView(data).GetBytes(TestAllTypes::kOptionalStringFieldNumber),
+            "second");
+}
+
+TEST(WireViewTest, Malformed) {
+  TestAllTypes message;
+  message.set_optional_string("hello");
+  std::string data = message.SerializeAsString();
+  data.pop_back();
+
+  WireView view(data);
+  EXPECT_FALSE(view.IsWellFormed());
+  EXPECT_FALSE(view.GetBytes(TestAllTypes::kOptionalStringFieldNumber));
+}
+
+TEST(PatchSerializedMessageTest, ReplacesOnlyTheUpdatedFields) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  std::string data = message.SerializeAsString();
+
+  TestAllTypes updates;
+  updates.set_optional_int32(-7);
+  updates.set_optional_string("patched");
+  updates.add_repeated_int64(42);
+  updates.mutable_optional_nested_message()->set_bb(9);
+  std::string patched;
+  ASSERT_TRUE(PatchSerializedMessage(
+      data, updates, {TestAllTypes::kOptionalBytesFieldNumber}, &patched));
+
+  TestAllTypes expected = message;
+  expected.set_optional_int32(-7);
+  expected.set_optional_string("patched");
+  expected.clear_repeated_int64();
+  expected.add_repeated_int64(42);
+  expected.mutable_optional_nested_message()->Clear();
+  expected.mutable_optional_nested_message()->set_bb(9);
+  expected.clear_optional_bytes();
+
+  TestAllTypes parsed;
+  ASSERT_TRUE(parsed.ParseFromString(patched));
+  EXPECT_EQ(parsed.SerializeAsString(), expected.SerializeAsString());
+}
+
+TEST(PatchSerializedMessageTest, KeepsUntouchedRecordsVerbatim) {
+  TestAllTypes message;
+  message.set_optional_int32(1);
+  message.set_optional_string("keep");
+  // An unknown field with an overlong varint, which a parse and serialize
+  // round trip would re-encode.
+  const std::string unknown("\xf8\xff\x0f\x81\x80\x00", 6);
+  std::string data = message.SerializeAsString() + unknown;
+
+  TestAllTypes updates;
+  updates.set_optional_int32(2);
+  std::string patched;
+  ASSERT_TRUE(PatchSerializedMessage(data, updates, {}, &patched));
+
+  TestAllTypes kept;
+  kept.set_optional_string("keep");
+  EXPECT_EQ(patched,
+            kept.SerializeAsString() + unknown + updates.SerializeAsString());
+}
+
+TEST(PatchSerializedMessageTest, Malformed) {
+  TestAllTypes message;
+  message.set_optional_string("hello");
+  std::string data = message.SerializeAsString();
+  data.pop_back();
+
+  std::string patched;
+  EXPECT_FALSE(PatchSerializedMessage(data, TestAllTypes(), {}, &patched));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
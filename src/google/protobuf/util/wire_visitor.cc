@@ -0,0 +1,392 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/wire_visitor.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/endian.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/wire_format.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "google/protobuf/wire_reader.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+using internal::WireFormat;
+using internal::WireFormatLite;
+
+WireVisitPlan::WireVisitPlan(const Descriptor* descriptor) {
+  absl::flat_hash_map<const Descriptor*, int> indices;
+  AddMessage(descriptor, &indices);
+}
+
+int WireVisitPlan::AddMessage(
+    const Descriptor* descriptor,
+    absl::flat_hash_map<const Descriptor*, int>* indices) {
+  const int index = static_cast<int>(messages_.size());
+  auto inserted = indices->try_emplace(descriptor, index);
+  if (!inserted.second) return inserted.first->second;
+  messages_.push_back({descriptor, {}, {}});
+
+  std::vector<const FieldDescriptor*> fields;
+  fields.reserve(descriptor->field_count());
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    fields.push_back(descriptor->field(i));
+  }
+  descriptor->file()->pool()->FindAllExtensions(descriptor, &fields);
+
+  // Low field numbers are looked up by index; the vector is bounded so that
+  // a few huge field numbers do not blow it up.
+  int max_dense = 0;
+  for (const FieldDescriptor* field : fields) {
+    if (field->number() <= 8 * static_cast<int>(fields.size()) + 64) {
+      max_dense = std::max(max_dense, field->number());
+    }
+  }
+  std::vector<Field> dense(max_dense + 1);
+  absl::flat_hash_map<int, Field> sparse;
+  for (const FieldDescriptor* field : fields) {
+    Field entry;
+    entry.field = field;
+    entry.wire_type = static_cast<WireReader::WireType>(
+        WireFormat::WireTypeForFieldType(field->type()));
+    entry.packable = field->is_packable();
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      // Recursion may grow messages_, so only index into it afterwards.
+      entry.message = AddMessage(field->message_type(), indices);
+    }
+    if (field->number() <= max_dense) {
+      dense[field->number()] = entry;
+    } else {
+      sparse[field->number()] = entry;
+    }
+  }
+  messages_[index].dense = std::move(dense);
+  messages_[index].sparse = std::move(sparse);
+  return index;
+}
+
+class WireWalker {
+ public:
+  WireWalker(const WireVisitPlan& plan, WireVisitor* visitor)
+      : plan_(plan), visitor_(visitor) {}
+
+  // Visits the fields in `data`, a message of type plan_.messages_[index],
+  // writing the result to `out` unless it is null.
+  bool Walk(int index, absl::string_view data, int depth,
+            io::CodedOutputStream* out) {
+    const WireVisitPlan::Message& message = plan_.messages_[index];
+    WireReader reader(data);
+    while (true) {
+      const char* start = reader.remaining().data();
+      if (!reader.Next()) break;
+      const absl::string_view record(
+          start, static_cast<size_t>(reader.remaining().data() - start));
+      const WireVisitPlan::Field* field =
+          plan_.Find(message, reader.field_number());
+      if (field != nullptr && reader.wire_type() == field->wire_type) {
+        if (field->message >= 0) {
+          if (!WalkMessage(*field, reader, record, depth, out)) return false;
+        } else {
+          VisitValue(field->field, reader, record, out);
+        }
+      } else if (field != nullptr && field->packable &&
+                 reader.wire_type() == WireReader::kLengthDelimited) {
+        if (!VisitPacked(*field, reader, record, depth, out)) return false;
+      } else {
+        VisitValue(nullptr, reader, record, out);
+      }
+    }
+    return !reader.failed();
+  }
+
+ private:
+  bool WalkMessage(const WireVisitPlan::Field& field, const WireReader& reader,
+                   absl::string_view record, int depth,
+                   io::CodedOutputStream* out) {
+    switch (visitor_->EnterMessage(field.field)) {
+      case WireVisitor::kDrop:
+        return true;
+      case WireVisitor::kSkip:
+        if (out != nullptr) {
+          out->WriteRaw(record.data(), static_cast<int>(record.size()));
+        }
+        return true;
+      case WireVisitor::kKeep:
+        break;
+    }
+    if (depth >= io::CodedInputStream::GetDefaultRecursionLimit()) {
+      return false;
+    }
+    bool ok;
+    if (out == nullptr) {
+      ok = Walk(field.message, reader.bytes(), depth + 1, nullptr);
+    } else {
+      // The new contents must be complete before their length is written.
+      std::string& contents = Scratch(depth);
+      contents.clear();
+      {
+        io::StringOutputStream stream(&contents);
+        io::CodedOutputStream nested(&stream);
+        ok = Walk(field.message, reader.bytes(), depth + 1, &nested);
+      }
+      if (ok) {
+        out->WriteTag(reader.tag());
+        if (reader.wire_type() == WireReader::kStartGroup) {
+          out->WriteString(contents);
+          out->WriteTag(WireFormatLite::MakeTag(
+              reader.field_number(), WireFormatLite::WIRETYPE_END_GROUP));
+        } else {
+          out->WriteVarint32(static_cast<uint32_t>(contents.size()));
+          out->WriteString(contents);
+        }
+      }
+    }
+    visitor_->LeaveMessage(field.field);
+    return ok;
+  }
+
+  void VisitValue(const FieldDescriptor* field, const WireReader& reader,
+                  absl::string_view record, io::CodedOutputStream* out) {
+    WireValue value;
+    value.field = field;
+    value.number = reader.field_number();
+    value.wire_type = reader.wire_type();
+    value.packed = false;
+    value.value = reader.varint();
+    value.bytes = reader.bytes();
+    switch (value.wire_type) {
+      case WireReader::kVarint:
+      case WireReader::kFixed64:
+      case WireReader::kFixed32:
+        value.bytes = absl::string_view();
+        break;
+      default:
+        value.value = 0;
+        break;
+    }
+    const WireValue original = value;
+    if (visitor_->OnValue(&value) == WireVisitor::kDrop || out == nullptr) {
+      return;
+    }
+    if (Unchanged(value, original)) {
+      out->WriteRaw(record.data(), static_cast<int>(record.size()));
+      return;
+    }
+    out->WriteTag(reader.tag());
+    switch (value.wire_type) {
+      case WireReader::kVarint:
+        out->WriteVarint64(value.value);
+        break;
+      case WireReader::kFixed64:
+        out->WriteLittleEndian64(value.value);
+        break;
+      case WireReader::kFixed32:
+        out->WriteLittleEndian32(static_cast<uint32_t>(value.value));
+        break;
+      case WireReader::kLengthDelimited:
+        out->WriteVarint32(static_cast<uint32_t>(value.bytes.size()));
+        out->WriteRaw(value.bytes.data(), static_cast<int>(value.bytes.size()));
+        break;
+      case WireReader::kStartGroup:
+        out->WriteRaw(value.bytes.data(), static_cast<int>(value.bytes.size()));
+        out->WriteTag(WireFormatLite::MakeTag(
+            value.number, WireFormatLite::WIRETYPE_END_GROUP));
+        break;
+      default:
+        break;
+    }
+  }
+
+  bool VisitPacked(const WireVisitPlan::Field& field, const WireReader& reader,
+                   absl::string_view record, int depth,
+                   io::CodedOutputStream* out) {
+    WireValue value;
+    value.field = field.field;
+    value.number = reader.field_number();
+    value.wire_type = field.wire_type;
+    value.packed = true;
+
+    std::string* packed = nullptr;
+    if (out != nullptr) {
+      packed = &Scratch(depth);
+      packed->clear();
+    }
+    bool changed = false;
+    absl::string_view payload = reader.bytes();
+    while (!payload.empty()) {
+      const char* start = payload.data();
+      if (!ReadElement(field.wire_type, &payload, &value.value)) return false;
+      const uint64_t original = value.value;
+      value.bytes = absl::string_view();
+      const WireVisitor::Action action = visitor_->OnValue(&value);
+      if (packed == nullptr) continue;
+      if (action == WireVisitor::kDrop) {
+        changed = true;
+      } else if (value.value == original) {
+        packed->append(start, static_cast<size_t>(payload.data() - start));
+      } else {
+        changed = true;
+        AppendElement(field.wire_type, value.value, packed);
+      }
+    }
+    if (out == nullptr) return true;
+    if (!changed) {
+      out->WriteRaw(record.data(), static_cast<int>(record.size()));
+    } else if (!packed->empty()) {
+      out->WriteTag(reader.tag());
+      out->WriteVarint32(static_cast<uint32_t>(packed->size()));
+      out->WriteString(*packed);
+    }
+    return true;
+  }
+
+  static bool Unchanged(const WireValue& value, const WireValue& original) {
+    return value.value == original.value &&
+           value.bytes.data() == original.bytes.data() &&
+           value.bytes.size() == original.bytes.size();
+  }
+
+  // Reads one element of a packed field from the front of `payload`.
+  static bool ReadElement(WireReader::WireType wire_type,
+                          absl::string_view* payload, uint64_t* value) {
+    switch (wire_type) {
+      case WireReader::kVarint: {
+        uint64_t result = 0;
+        for (size_t i = 0; i < payload->size() && i < 10; ++i) {
+          const uint8_t byte = static_cast<uint8_t>((*payload)[i]);
+          result |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+          if (byte < 0x80) {
+            *value = result;
+            payload->remove_prefix(i + 1);
+            return true;
+          }
+        }
+        return false;
+      }
+      case WireReader::kFixed64: {
+        if (payload->size() < sizeof(uint64_t)) return false;
+        uint64_t result;
+        std::memcpy(&result, payload->data(), sizeof(result));
+        *value = internal::little_endian::ToHost(result);
+        payload->remove_prefix(sizeof(result));
+        return true;
+      }
+      case WireReader::kFixed32: {
+        if (payload->size() < sizeof(uint32_t)) return false;
+        uint32_t result;
+        std::memcpy(&result, payload->data(), sizeof(result));
+        *value = internal::little_endian::ToHost(result);
+        payload->remove_prefix(sizeof(result));
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
+  static void AppendElement(WireReader::WireType wire_type, uint64_t value,
+                            std::string* packed) {
+    uint8_t buffer[10];  // The longest varint.
+    uint8_t* end;
+    switch (wire_type) {
+      case WireReader::kFixed64:
+        end = io::CodedOutputStream::WriteLittleEndian64ToArray(value, buffer);
+        break;
+      case WireReader::kFixed32:
+        end = io::CodedOutputStream::WriteLittleEndian32ToArray(
+            static_cast<uint32_t>(value), buffer);
+        break;
+      default:
+        end = io::CodedOutputStream::WriteVarint64ToArray(value, buffer);
+        break;
+    }
+    packed->append(reinterpret_cast<const char*>(buffer),
+                   static_cast<size_t>(end - buffer));
+  }
+
+  // A buffer for rewriting a submessage or packed field found at `depth`.
+  // Kept across calls to reuse its capacity; a deque keeps the buffers of
+  // the enclosing levels in place while deeper ones are added.
+  std::string& Scratch(int depth) {
+    while (scratch_.size() <= static_cast<size_t>(depth)) {
+      scratch_.emplace_back();
+    }
+    return scratch_[depth];
+  }
+
+  const WireVisitPlan& plan_;
+  WireVisitor* visitor_;
+  std::deque<std::string> scratch_;
+};
+
+bool VisitWire(const WireVisitPlan& plan, absl::string_view data,
+               WireVisitor* visitor) {
+  return WireWalker(plan, visitor).Walk(0, data, 0, nullptr);
+}
+
+bool TransformWire(const WireVisitPlan& plan, absl::string_view data,
+                   WireVisitor* visitor, io::ZeroCopyOutputStream* output) {
+  io::CodedOutputStream out(output);
+  if (!WireWalker(plan, visitor).Walk(0, data, 0, &out)) {
+    return false;
+  }
+  out.Trim();
+  return !out.HadError();
+}
+
+bool TransformWire(const WireVisitPlan& plan, absl::string_view data,
+                   WireVisitor* visitor, std::string* output) {
+  output->clear();
+  io::StringOutputStream stream(output);
+  return TransformWire(plan, data, visitor, &stream);
+}
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
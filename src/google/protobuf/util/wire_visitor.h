@@ -0,0 +1,206 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Schema-aware walking and rewriting of serialized messages without parsing
+// them into message objects, for tools such as redactors, field rewriters and
+// samplers:
+//
+//   class RedactSsn : public util::WireVisitor {
+//    public:
+//     Action OnValue(WireValue* value) override {
+//       if (value->field == ssn_field_) value->bytes = "<redacted>";
+//       return kKeep;
+//     }
+//     ...
+//   };
+//
+//   static const auto* plan = new util::WireVisitPlan(Person::descriptor());
+//   RedactSsn redactor;
+//   std::string redacted;
+//   if (!util::TransformWire(*plan, serialized, &redactor, &redacted)) {
+//     ... fail ...
+//   }
+//
+// A WireVisitPlan is compiled once per root message type: it maps each field
+// number of every message type reachable from the root to its descriptor and
+// expected wire type, so visiting does no reflection or descriptor lookups.
+// Fields that are kept unchanged are copied to the output byte for byte.
+//
+// Unlike PatchSerializedMessage() in wire_view.h, which replaces top-level
+// fields by number, this sees every value at every level together with its
+// field.
+
+#ifndef GOOGLE_PROTOBUF_UTIL_WIRE_VISITOR_H__
+#define GOOGLE_PROTOBUF_UTIL_WIRE_VISITOR_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/wire_reader.h"
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace util {
+
+class WireWalker;
+
+// The per-type lookup tables that drive a visit. Immutable once built, so one
+// plan can be shared by concurrent visits.
+class PROTOBUF_EXPORT WireVisitPlan {
+ public:
+  // Builds the plan for `descriptor` and every message type reachable from
+  // it, including through the extensions known to its pool at this point.
+  explicit WireVisitPlan(const Descriptor* descriptor);
+  WireVisitPlan(const WireVisitPlan&) = delete;
+  WireVisitPlan& operator=(const WireVisitPlan&) = delete;
+
+  const Descriptor* descriptor() const { return messages_[0].descriptor; }
+
+ private:
+  friend class WireWalker;
+
+  struct Field {
+    const FieldDescriptor* field = nullptr;
+    // The index in messages_ of a message or group field's type, or -1.
+    int message = -1;
+    // The wire type of a single value.
+    WireReader::WireType wire_type = WireReader::kVarint;
+    // Whether values may also arrive packed.
+    bool packable = false;
+  };
+  struct Message {
+    const Descriptor* descriptor;
+    // Indexed by field number, for the low field numbers.
+    std::vector<Field> dense;
+    // The remaining fields and extensions.
+    absl::flat_hash_map<int, Field> sparse;
+  };
+
+  int AddMessage(const Descriptor* descriptor,
+                 absl::flat_hash_map<const Descriptor*, int>* indices);
+  const Field* Find(const Message& message, int number) const {
+    if (static_cast<size_t>(number) < message.dense.size()) {
+      const Field& field = message.dense[number];
+      return field.field != nullptr ? &field : nullptr;
+    }
+    auto it = message.sparse.find(number);
+    return it != message.sparse.end() ? &it->second : nullptr;
+  }
+
+  std::vector<Message> messages_;
+};
+
+// A single value on the wire: a scalar, a string or bytes value, one element
+// of a packed field, or an unknown field.
+struct WireValue {
+  // The field, or null if it is unknown to the plan or arrived with a wire
+  // type that does not match its declaration.
+  const FieldDescriptor* field;
+  int number;
+  // The wire type of this value; kVarint, kFixed32 or kFixed64 for an
+  // element of a packed field.
+  WireReader::WireType wire_type;
+  // Whether this is an element of a packed field.
+  bool packed;
+  // The raw value of a kVarint, kFixed32 or kFixed64 value. Signed, zigzag
+  // and floating point values are left for the visitor to decode; see
+  // WireFormatLite.
+  uint64_t value;
+  // The payload of a kLengthDelimited value, or the contents of an unknown
+  // group.
+  absl::string_view bytes;
+};
+
+// Receives the values of a serialized message in wire order. Submessages and
+// groups of known message types are entered instead of being reported as
+// values.
+class PROTOBUF_EXPORT WireVisitor {
+ public:
+  enum Action {
+    // Keep the value or submessage. A modified value is re-encoded.
+    kKeep,
+    // Leave it out of the output.
+    kDrop,
+    // For EnterMessage(): keep the submessage unchanged without visiting it.
+    kSkip,
+  };
+
+  virtual ~WireVisitor() = default;
+
+  // Called for every value that is not a known submessage or group. The
+  // visitor may change `value->value` or `value->bytes`; a new `bytes` must
+  // stay valid until OnValue() is called again or the visit ends.
+  virtual Action OnValue(WireValue* /*value*/) { return kKeep; }
+
+  // Called before the contents of a submessage or group are visited. Unless
+  // this returns kDrop or kSkip, LeaveMessage() is called after them.
+  virtual Action EnterMessage(const FieldDescriptor* /*field*/) {
+    return kKeep;
+  }
+  virtual void LeaveMessage(const FieldDescriptor* /*field*/) {}
+};
+
+// Walks `data`, a serialized message of `plan.descriptor()`'s type, calling
+// `visitor` for its contents. Returns false if `data` is malformed or nests
+// deeper than the default recursion limit.
+PROTOBUF_EXPORT bool VisitWire(const WireVisitPlan& plan,
+                               absl::string_view data, WireVisitor* visitor);
+
+// Like VisitWire(), and also writes `data` to `output` with the visitor's
+// changes applied. Submessages that are entered are rewritten through a
+// scratch buffer since their length may change; everything else is written
+// straight to `output`.
+PROTOBUF_EXPORT bool TransformWire(const WireVisitPlan& plan,
+                                   absl::string_view data, WireVisitor* visitor,
+                                   io::ZeroCopyOutputStream* output);
+// Same as above, replacing the contents of `output`.
+PROTOBUF_EXPORT bool TransformWire(const WireVisitPlan& plan,
+                                   absl::string_view data, WireVisitor* visitor,
+                                   std::string* output);
+
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_UTIL_WIRE_VISITOR_H__
@@ -0,0 +1,212 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/util/wire_visitor.h"
+
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+
+namespace google {
+namespace protobuf {
+namespace util {
+namespace {
+
+using ::protobuf_unittest::TestAllTypes;
+using ::protobuf_unittest::TestPackedTypes;
+using ::protobuf_unittest::TestUnpackedTypes;
+
+// Counts what it sees and changes nothing.
+class CountingVisitor : public WireVisitor {
+ public:
+  Action OnValue(WireValue* value) override {
+    ++values;
+    if (value->field == nullptr) ++unknown;
+    if (value->packed) ++packed;
+    return kKeep;
+  }
+  Action EnterMessage(const FieldDescriptor*) override {
+    ++entered;
+    return kKeep;
+  }
+  void LeaveMessage(const FieldDescriptor*) override { ++left; }
+
+  int values = 0;
+  int unknown = 0;
+  int packed = 0;
+  int entered = 0;
+  int left = 0;
+};
+
+TEST(WireVisitorTest, IdentityTransformKeepsBytes) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  message.GetReflection()->MutableUnknownFields(&message)->AddVarint(12345, 1);
+  const std::string data = message.SerializeAsString();
+
+  WireVisitPlan plan(TestAllTypes::descriptor());
+  CountingVisitor visitor;
+  std::string output;
+  ASSERT_TRUE(TransformWire(plan, data, &visitor, &output));
+  EXPECT_EQ(output, data);
+  EXPECT_EQ(visitor.unknown, 1);
+  EXPECT_EQ(visitor.packed, 0);
+  EXPECT_GT(visitor.entered, 10);
+  EXPECT_EQ(visitor.entered, visitor.left);
+
+  CountingVisitor counter;
+  ASSERT_TRUE(VisitWire(plan, data, &counter));
+  EXPECT_EQ(counter.values, visitor.values);
+}
+
+class RedactingVisitor : public WireVisitor {
+ public:
+  Action OnValue(WireValue* value) override {
+    if (value->field == nullptr) return kDrop;
+    if (value->field->name() == "optional_string") {
+      value->bytes = "redacted";
+    } else if (value->field->name() == "optional_int32") {
+      return kDrop;
+    } else if (value->field->name() == "bb") {
+      value->value *= 2;
+    }
+    return kKeep;
+  }
+  Action EnterMessage(const FieldDescriptor* field) override {
+    if (field->name() == "repeatedgroup") return kDrop;
+    if (field->name() == "optional_foreign_message") return kSkip;
+    return kKeep;
+  }
+};
+
+TEST(WireVisitorTest, RewritesValuesAndSubmessages) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  message.GetReflection()->MutableUnknownFields(&message)->AddVarint(12345, 1);
+  WireVisitPlan plan(TestAllTypes::descriptor());
+  RedactingVisitor visitor;
+  std::string output;
+  ASSERT_TRUE(
+      TransformWire(plan, message.SerializeAsString(), &visitor, &output));
+
+  TestAllTypes expected = message;
+  expected.mutable_unknown_fields()->Clear();
+  expected.set_optional_string("redacted");
+  expected.clear_optional_int32();
+  expected.clear_repeatedgroup();
+  auto double_bb = [](TestAllTypes::NestedMessage* nested) {
+    if (nested->has_bb()) nested->set_bb(2 * nested->bb());
+  };
+  double_bb(expected.mutable_optional_nested_message());
+  double_bb(expected.mutable_optional_lazy_message());
+  if (expected.has_optional_unverified_lazy_message()) {
+    double_bb(expected.mutable_optional_unverified_lazy_message());
+  }
+  for (auto& nested : *expected.mutable_repeated_nested_message()) {
+    double_bb(&nested);
+  }
+  for (auto& nested : *expected.mutable_repeated_lazy_message()) {
+    double_bb(&nested);
+  }
+  if (expected.has_oneof_nested_message()) {
+    double_bb(expected.mutable_oneof_nested_message());
+  }
+
+  TestAllTypes result;
+  ASSERT_TRUE(result.ParseFromString(output));
+  EXPECT_EQ(result.SerializeAsString(), expected.SerializeAsString());
+}
+
+// Doubles every value of packed_int32 and drops the other packed fields'
+// values.
+class PackedVisitor : public WireVisitor {
+ public:
+  Action OnValue(WireValue* value) override {
+    if (value->field->name() != "packed_int32") return kDrop;
+    packed = value->packed;
+    value->value *= 2;
+    return kKeep;
+  }
+
+  bool packed = false;
+};
+
+TEST(WireVisitorTest, PackedAndUnpacked) {
+  TestPackedTypes message;
+  TestUtil::SetPackedFields(&message);
+  WireVisitPlan plan(TestPackedTypes::descriptor());
+  PackedVisitor visitor;
+  std::string output;
+  ASSERT_TRUE(
+      TransformWire(plan, message.SerializeAsString(), &visitor, &output));
+  EXPECT_TRUE(visitor.packed);
+  TestPackedTypes result;
+  ASSERT_TRUE(result.ParseFromString(output));
+  ASSERT_EQ(result.packed_int32_size(), 2);
+  EXPECT_EQ(result.packed_int32(0), 1202);
+  EXPECT_EQ(result.packed_int32(1), 1402);
+  EXPECT_EQ(result.packed_int64_size(), 0);
+
+  // Packable fields are accepted unpacked too, as the parser does.
+  TestUnpackedTypes unpacked;
+  TestUtil::SetUnpackedFields(&unpacked);
+  ASSERT_TRUE(
+      TransformWire(plan, unpacked.SerializeAsString(), &visitor, &output));
+  EXPECT_FALSE(visitor.packed);
+  ASSERT_TRUE(result.ParseFromString(output));
+  ASSERT_EQ(result.packed_int32_size(), 2);
+  EXPECT_EQ(result.packed_int32(1), 1402);
+}
+
+TEST(WireVisitorTest, MalformedInput) {
+  TestAllTypes message;
+  message.mutable_optional_nested_message()->set_bb(1);
+  std::string data = message.SerializeAsString();
+  data.pop_back();
+
+  WireVisitPlan plan(TestAllTypes::descriptor());
+  CountingVisitor visitor;
+  std::string output;
+  EXPECT_FALSE(VisitWire(plan, data, &visitor));
+  EXPECT_FALSE(TransformWire(plan, data, &visitor, &output));
+  // A packed int32 with a truncated varint.
+  EXPECT_FALSE(VisitWire(WireVisitPlan(TestPackedTypes::descriptor()),
+                         absl::string_view("\xd2\x05\x01\x80"), &visitor));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace protobuf
+}  // namespace google
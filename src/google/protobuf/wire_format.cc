@@ -34,6 +34,7 @@
 
 #include "google/protobuf/wire_format.h"
 
+#include <memory>
 #include <stack>
 #include <string>
 #include <vector>
@@ -52,6 +53,7 @@
 #include "google/protobuf/message.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/parse_context.h"
+#include "google/protobuf/reflection_ops.h"
 #include "google/protobuf/unknown_field_set.h"
 
 
@@ -193,9 +195,9 @@ bool WireFormat::ReadPackedEnumPreserveUnknowns(io::CodedInputStream* input,
 uint8_t* WireFormat::InternalSerializeUnknownFieldsToArray(
     const UnknownFieldSet& unknown_fields, uint8_t* target,
     io::EpsCopyOutputStream* stream) {
-  for (int i = 0; i < unknown_fields.field_count(); i++) {
-    const UnknownField& field = unknown_fields.field(i);
-
+  // Fields still serialized from a lazy parse are written as they are, after
+  // the decoded ones.
+  for (const UnknownField& field : unknown_fields.fields_) {
     target = stream->EnsureSpace(target);
     switch (field.type()) {
       case UnknownField::TYPE_VARINT:
@@ -225,6 +227,11 @@ uint8_t* WireFormat::InternalSerializeUnknownFieldsToArray(
         break;
     }
   }
+  if (unknown_fields.serialized_ != nullptr) {
+    const std::string& bytes = unknown_fields.serialized_->bytes;
+    target = stream->WriteRaw(bytes.data(), static_cast<int>(bytes.size()),
+                              target);
+  }
   return target;
 }
 
@@ -267,9 +274,7 @@ uint8_t* WireFormat::InternalSerializeUnknownMessageSetItemsToArray(
 size_t WireFormat::ComputeUnknownFieldsSize(
     const UnknownFieldSet& unknown_fields) {
   size_t size = 0;
-  for (int i = 0; i < unknown_fields.field_count(); i++) {
-    const UnknownField& field = unknown_fields.field(i);
-
+  for (const UnknownField& field : unknown_fields.fields_) {
     switch (field.type()) {
       case UnknownField::TYPE_VARINT:
         size += io::CodedOutputStream::VarintSize32(WireFormatLite::MakeTag(
@@ -302,6 +307,9 @@ size_t WireFormat::ComputeUnknownFieldsSize(
         break;
     }
   }
+  if (unknown_fields.serialized_ != nullptr) {
+    size += unknown_fields.serialized_->bytes.size();
+  }
 
   return size;
 }
@@ -793,6 +801,8 @@ const char* WireFormat::_InternalParse(Message* msg, const char* ptr,
   const Reflection* reflection = msg->GetReflection();
   ABSL_DCHECK(descriptor);
   ABSL_DCHECK(reflection);
+  // Required fields are not tracked by this parser.
+  ctx->SetMaybeUninitialized();
   if (descriptor->options().message_set_wire_format()) {
     MessageSetParser message_set{msg, descriptor, reflection};
     return message_set.ParseMessageSet(ptr, ctx);
@@ -1029,32 +1039,40 @@ const char* WireFormat::_InternalParseAndMergeField(
     }
 
     case FieldDescriptor::TYPE_MESSAGE: {
-      Message* sub_message;
-      if (field->is_repeated()) {
-        sub_message = reflection->AddMessage(msg, field, ctx->data().factory);
-      } else {
-        sub_message =
-            reflection->MutableMessage(msg, field, ctx->data().factory);
-      }
-      ptr = ctx->ParseMessage(sub_message, ptr);
+      if (field->is_map()) {
+        // Parse the entry on its own and store it in the map itself, rather
+        // than appending it to the map's repeated-field mirror.
+        std::unique_ptr<Message> entry(
+            reflection->GetMessageFactory()
+                ->GetPrototype(field->message_type())
+                ->New());
+        ptr = ctx->ParseMessage(entry.get(), ptr);
+        if (ptr == nullptr) return nullptr;
 
-      // For map entries, if the value is an unknown enum we have to push it
-      // into the unknown field set and remove it from the list.
-      if (ptr != nullptr && field->is_map()) {
+        // If the value is an unknown enum we have to push the entry into the
+        // unknown field set instead.
         auto* value_field = field->message_type()->map_value();
         auto* enum_type = value_field->enum_type();
         if (enum_type != nullptr &&
             !internal::cpp::HasPreservingUnknownEnumSemantics(value_field) &&
-            enum_type->FindValueByNumber(
-                sub_message->GetReflection()->GetEnumValue(
-                    *sub_message, value_field)) == nullptr) {
+            enum_type->FindValueByNumber(entry->GetReflection()->GetEnumValue(
+                *entry, value_field)) == nullptr) {
           reflection->MutableUnknownFields(msg)->AddLengthDelimited(
-              field->number(), sub_message->SerializeAsString());
-          reflection->RemoveLast(msg, field);
+              field->number(), entry->SerializeAsString());
+        } else {
+          ReflectionOps::InsertMapEntry(msg, field, entry.get());
         }
+        return ptr;
       }
 
-      return ptr;
+      Message* sub_message;
+      if (field->is_repeated()) {
+        sub_message = reflection->AddMessage(msg, field, ctx->data().factory);
+      } else {
+        sub_message =
+            reflection->MutableMessage(msg, field, ctx->data().factory);
+      }
+      return ctx->ParseMessage(sub_message, ptr);
     }
   }
 
@@ -1224,6 +1242,15 @@ static uint8_t* InternalSerializeMapEntry(const FieldDescriptor* field,
   const FieldDescriptor* key_field = field->message_type()->field(0);
   const FieldDescriptor* value_field = field->message_type()->field(1);
 
+  if (PROTOBUF_PREDICT_FALSE(stream->BackpatchesLengths())) {
+    uint8_t* payload =
+        stream->BeginBackpatchedLengthDelim(field->number(), target);
+    target = SerializeMapKeyWithCachedSizes(key_field, key, payload, stream);
+    target =
+        SerializeMapValueRefWithCachedSizes(value_field, value, target, stream);
+    return stream->EndBackpatchedLengthDelim(payload, target);
+  }
+
   size_t size = kMapEntryTagByteSize;
   size += MapKeyDataOnlyByteSize(key_field, key);
   size += MapValueRefDataOnlyByteSize(value_field, value);
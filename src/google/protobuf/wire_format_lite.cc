@@ -34,6 +34,10 @@
 
 #include "google/protobuf/wire_format_lite.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <limits>
 #include <stack>
 #include <string>
@@ -551,6 +555,12 @@ uint8_t* WireFormatLite::InternalWriteMessage(int field_number,
                                               const MessageLite& value,
                                               int cached_size, uint8_t* target,
                                               io::EpsCopyOutputStream* stream) {
+  if (PROTOBUF_PREDICT_FALSE(stream->BackpatchesLengths())) {
+    uint8_t* payload =
+        stream->BeginBackpatchedLengthDelim(field_number, target);
+    target = value._InternalSerialize(payload, stream);
+    return stream->EndBackpatchedLengthDelim(payload, target);
+  }
   target = stream->EnsureSpace(target);
   target = WriteTagToArray(field_number, WIRETYPE_LENGTH_DELIMITED, target);
   target = io::CodedOutputStream::WriteVarint32ToArray(
@@ -708,10 +718,49 @@ static size_t VarintSize64(const T* data, const int n) {
   return sum;
 }
 
-// GCC does not recognize the vectorization opportunity
-// and other platforms are untested, in those cases using the optimized
-// varint size routine for each element is faster.
-// Hence we enable it only for clang
+#if defined(__SSE2__) && !defined(__clang__)
+// GCC does not recognize the vectorization opportunity in VarintSize(), so
+// this spells out the same computation with SSE2, which every x86-64 CPU
+// has.  Unsigned compares are done as signed ones on biased values.
+template <bool ZigZag, bool SignExtended, typename T>
+static size_t VarintSizeSse2(const T* data, const int n) {
+  const __m128i bias = _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+  const __m128i limit1 = _mm_xor_si128(_mm_set1_epi32(0x7F), bias);
+  const __m128i limit2 = _mm_xor_si128(_mm_set1_epi32(0x3FFF), bias);
+  const __m128i limit3 = _mm_xor_si128(_mm_set1_epi32(0x1FFFFF), bias);
+  const __m128i limit4 = _mm_xor_si128(_mm_set1_epi32(0xFFFFFFF), bias);
+  // Each lane counts down once per limit its values exceed.
+  __m128i extra = _mm_setzero_si128();
+  __m128i negatives = _mm_setzero_si128();
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    if (ZigZag) {
+      x = _mm_xor_si128(_mm_slli_epi32(x, 1), _mm_srai_epi32(x, 31));
+    } else if (SignExtended) {
+      negatives = _mm_add_epi32(negatives, _mm_srli_epi32(x, 31));
+    }
+    x = _mm_xor_si128(x, bias);
+    extra = _mm_add_epi32(extra, _mm_cmpgt_epi32(x, limit1));
+    extra = _mm_add_epi32(extra, _mm_cmpgt_epi32(x, limit2));
+    extra = _mm_add_epi32(extra, _mm_cmpgt_epi32(x, limit3));
+    extra = _mm_add_epi32(extra, _mm_cmpgt_epi32(x, limit4));
+  }
+  int32_t extra_lanes[4];
+  int32_t negative_lanes[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(extra_lanes), extra);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(negative_lanes), negatives);
+  size_t sum = static_cast<size_t>(i);
+  for (int lane = 0; lane < 4; ++lane) {
+    sum += static_cast<size_t>(-extra_lanes[lane]);
+    sum += 5 * static_cast<size_t>(negative_lanes[lane]);
+  }
+  return sum + VarintSize<ZigZag, SignExtended>(data + i, n - i);
+}
+#endif
+
+// Other platforms are untested, in those cases using the optimized varint
+// size routine for each element is faster.
 #if defined(__SSE__) && defined(__clang__)
 size_t WireFormatLite::Int32Size(const RepeatedField<int32_t>& value) {
   return VarintSize<false, true>(value.data(), value.size());
@@ -730,7 +779,26 @@ size_t WireFormatLite::EnumSize(const RepeatedField<int>& value) {
   return VarintSize<false, true>(value.data(), value.size());
 }
 
-#else  // !(defined(__SSE4_1__) && defined(__clang__))
+#elif defined(__SSE2__)
+
+size_t WireFormatLite::Int32Size(const RepeatedField<int32_t>& value) {
+  return VarintSizeSse2<false, true>(value.data(), value.size());
+}
+
+size_t WireFormatLite::UInt32Size(const RepeatedField<uint32_t>& value) {
+  return VarintSizeSse2<false, false>(value.data(), value.size());
+}
+
+size_t WireFormatLite::SInt32Size(const RepeatedField<int32_t>& value) {
+  return VarintSizeSse2<true, false>(value.data(), value.size());
+}
+
+size_t WireFormatLite::EnumSize(const RepeatedField<int>& value) {
+  // On ILP64, sizeof(int) == 8, which would require a different template.
+  return VarintSizeSse2<false, true>(value.data(), value.size());
+}
+
+#else  // !defined(__SSE2__)
 
 size_t WireFormatLite::Int32Size(const RepeatedField<int32_t>& value) {
   size_t out = 0;
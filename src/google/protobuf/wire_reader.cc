@@ -0,0 +1,151 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/wire_reader.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "absl/strings/string_view.h"
+#include "google/protobuf/endian.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/parse_context.h"
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+// Near the end of the input, fields are decoded from a zero-padded copy of
+// this size, like the patch buffer of EpsCopyInputStream.
+constexpr size_t kPatchSize = 32;
+
+}  // namespace
+
+bool WireReader::Fail() {
+  failed_ = true;
+  end_ = ptr_;
+  return false;
+}
+
+bool WireReader::Next() {
+  if (ptr_ == end_) {
+    // A reader inside a group must stop at the group's end tag.
+    if (group_number_ != 0 && group_end_ == nullptr && !failed_) {
+      return Fail();
+    }
+    return false;
+  }
+
+  // The decoding primitives may read past the end of a field, like the
+  // generated parsers do into the slop region of EpsCopyInputStream. Near
+  // the end of the input, decode from a zero-padded copy instead; a zero byte
+  // ends any varint, and the bounds are checked against the real input below.
+  const size_t available = static_cast<size_t>(end_ - ptr_);
+  char patch[kPatchSize];
+  const char* start = ptr_;
+  if (available < sizeof(patch)) {
+    std::memset(patch, 0, sizeof(patch));
+    std::memcpy(patch, ptr_, available);
+    start = patch;
+  }
+
+  const char* p = internal::ReadTag(start, &tag_);
+  if (p == nullptr || field_number() == 0) return Fail();
+  size_t size;
+  switch (wire_type()) {
+    case kVarint:
+      p = internal::VarintParse(p, &value_);
+      if (p == nullptr) return Fail();
+      size = static_cast<size_t>(p - start);
+      break;
+    case kFixed64:
+      value_ = internal::little_endian::ToHost(
+          internal::UnalignedLoad<uint64_t>(p));
+      size = static_cast<size_t>(p - start) + sizeof(uint64_t);
+      break;
+    case kFixed32:
+      value_ = internal::little_endian::ToHost(
+          internal::UnalignedLoad<uint32_t>(p));
+      size = static_cast<size_t>(p - start) + sizeof(uint32_t);
+      break;
+    case kLengthDelimited: {
+      const uint32_t length = internal::ReadSize(&p);
+      if (p == nullptr) return Fail();
+      const size_t header = static_cast<size_t>(p - start);
+      if (header > available || length > available - header) return Fail();
+      bytes_ = absl::string_view(ptr_ + header, length);
+      size = header + length;
+      break;
+    }
+    case kStartGroup: {
+      const size_t header = static_cast<size_t>(p - start);
+      if (header > available) return Fail();
+      size = SkipGroup(header);
+      if (size == 0) return Fail();
+      break;
+    }
+    case kEndGroup: {
+      const size_t header = static_cast<size_t>(p - start);
+      if (header > available || tag_ >> 3 != group_number_) return Fail();
+      group_end_ = ptr_;
+      ptr_ += header;
+      end_ = ptr_;
+      return false;
+    }
+    default:
+      return Fail();
+  }
+  if (size > available) return Fail();
+  ptr_ += size;
+  return true;
+}
+
+size_t WireReader::SkipGroup(size_t offset) {
+  if (depth_ >= io::CodedInputStream::GetDefaultRecursionLimit()) return 0;
+  const char* contents = ptr_ + offset;
+  WireReader group(
+      absl::string_view(contents, static_cast<size_t>(end_ - contents)),
+      depth_ + 1, tag_ >> 3);
+  while (group.Next()) {
+  }
+  if (group.failed_) return 0;
+  bytes_ = absl::string_view(contents,
+                             static_cast<size_t>(group.group_end_ - contents));
+  return static_cast<size_t>(group.ptr_ - ptr_);
+}
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
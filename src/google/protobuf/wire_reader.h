@@ -0,0 +1,154 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A zero-copy reader for the protocol buffer wire format, for code that
+// processes encoded messages by hand rather than parsing them into message
+// objects:
+//
+//   WireReader reader(data);
+//   while (reader.Next()) {
+//     switch (reader.field_number()) {
+//       case 1:  // int64
+//         total += static_cast<int64_t>(reader.varint());
+//         break;
+//       case 2: {  // a submessage
+//         WireReader sub = reader.Descend();
+//         while (sub.Next()) { ... }
+//         if (sub.failed()) ... fail ...
+//         break;
+//       }
+//     }
+//   }
+//   if (reader.failed()) ... fail ...
+//
+// It decodes with the same primitives as the generated parsers rather than
+// going through CodedInputStream, and never copies: length-delimited values
+// are views into the input, which must outlive the reader and its views.
+// Unlike the parsers, it does not know about field types, so interpreting a
+// value (zigzag, packed, ...) is up to the caller; see WireFormatLite for
+// helpers.
+
+#ifndef GOOGLE_PROTOBUF_WIRE_READER_H__
+#define GOOGLE_PROTOBUF_WIRE_READER_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+
+#ifdef SWIG
+#error "You cannot SWIG proto headers"
+#endif
+
+// Must be included last.
+#include "google/protobuf/port_def.inc"
+
+namespace google {
+namespace protobuf {
+
+class PROTOBUF_EXPORT WireReader {
+ public:
+  // The wire types, with the values they have in a tag.
+  enum WireType {
+    kVarint = 0,
+    kFixed64 = 1,
+    kLengthDelimited = 2,
+    kStartGroup = 3,
+    kEndGroup = 4,
+    kFixed32 = 5,
+  };
+
+  explicit WireReader(absl::string_view data)
+      : WireReader(data, /*depth=*/0, /*group_number=*/0) {}
+
+  // Advances to the next field.  Returns false at the end of the input or if
+  // the input is malformed, which failed() tells apart.  A group is returned
+  // as a single field whose bytes() are its contents, like a submessage;
+  // kEndGroup is never returned.
+  bool Next();
+
+  // Whether malformed input was found.  Once set, Next() returns false.
+  bool failed() const { return failed_; }
+
+  // The current field, valid after Next() returned true.
+  uint32_t tag() const { return tag_; }
+  int field_number() const { return static_cast<int>(tag_ >> 3); }
+  WireType wire_type() const { return static_cast<WireType>(tag_ & 7); }
+
+  // The value of a kVarint field.
+  uint64_t varint() const { return value_; }
+  // The value of a kFixed64 or kFixed32 field.
+  uint64_t fixed64() const { return value_; }
+  uint32_t fixed32() const { return static_cast<uint32_t>(value_); }
+  // The payload of a kLengthDelimited field, or the contents of a group
+  // without its end tag.
+  absl::string_view bytes() const { return bytes_; }
+  // Returns a reader over bytes(), for descending into a submessage or
+  // group.
+  WireReader Descend() const { return WireReader(bytes_); }
+
+  // The input after the current field.
+  absl::string_view remaining() const {
+    return absl::string_view(ptr_, static_cast<size_t>(end_ - ptr_));
+  }
+
+ private:
+  WireReader(absl::string_view data, int depth, uint32_t group_number)
+      : ptr_(data.data()),
+        end_(data.data() + data.size()),
+        depth_(depth),
+        group_number_(group_number) {}
+
+  bool Fail();
+  // Finds the end of the group whose contents start at ptr_ + `offset` and
+  // sets bytes_ to them.  Returns the size of the field from ptr_ through its
+  // end tag, or 0 if the group is malformed.
+  size_t SkipGroup(size_t offset);
+
+  const char* ptr_;
+  const char* end_;
+  uint32_t tag_ = 0;
+  uint64_t value_ = 0;
+  absl::string_view bytes_;
+  // How many groups enclose this reader's input, and the field number of the
+  // innermost one, or 0.  A reader inside a group stops at its end tag.
+  int depth_;
+  uint32_t group_number_;
+  // Where the end tag of that group starts, once it has been read.
+  const char* group_end_ = nullptr;
+  bool failed_ = false;
+};
+
+}  // namespace protobuf
+}  // namespace google
+
+#include "google/protobuf/port_undef.inc"
+
+#endif  // GOOGLE_PROTOBUF_WIRE_READER_H__
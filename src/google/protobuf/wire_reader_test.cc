@@ -0,0 +1,175 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "google/protobuf/wire_reader.h"
+
+#include <cstdint>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/escaping.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/test_util.h"
+#include "google/protobuf/unittest.pb.h"
+#include "google/protobuf/wire_format_lite.h"
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using ::google::protobuf::internal::WireFormatLite;
+using ::protobuf_unittest::TestAllTypes;
+
+TEST(WireReaderTest, MatchesCodedInputStream) {
+  TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  const std::string data = message.SerializeAsString();
+
+  io::CodedInputStream input(reinterpret_cast<const uint8_t*>(data.data()),
+                             static_cast<int>(data.size()));
+  WireReader reader(data);
+  int fields = 0;
+  while (reader.Next()) {
+    ++fields;
+    const uint32_t tag = input.ReadTag();
+    ASSERT_EQ(reader.tag(), tag);
+    switch (reader.wire_type()) {
+      case WireReader::kVarint: {
+        uint64_t value;
+        ASSERT_TRUE(input.ReadVarint64(&value));
+        EXPECT_EQ(reader.varint(), value);
+        break;
+      }
+      case WireReader::kFixed64: {
+        uint64_t value;
+        ASSERT_TRUE(input.ReadLittleEndian64(&value));
+        EXPECT_EQ(reader.fixed64(), value);
+        break;
+      }
+      case WireReader::kFixed32: {
+        uint32_t value;
+        ASSERT_TRUE(input.ReadLittleEndian32(&value));
+        EXPECT_EQ(reader.fixed32(), value);
+        break;
+      }
+      case WireReader::kLengthDelimited: {
+        std::string value;
+        ASSERT_TRUE(WireFormatLite::ReadBytes(&input, &value));
+        EXPECT_EQ(reader.bytes(), value);
+        break;
+      }
+      case WireReader::kStartGroup: {
+        const int start = input.CurrentPosition();
+        ASSERT_TRUE(WireFormatLite::SkipField(&input, tag));
+        const int end_tag_size = io::CodedOutputStream::VarintSize32(
+            WireFormatLite::MakeTag(reader.field_number(),
+                                    WireFormatLite::WIRETYPE_END_GROUP));
+        EXPECT_EQ(reader.bytes(),
+                  absl::string_view(data).substr(
+                      start, input.CurrentPosition() - start - end_tag_size));
+        break;
+      }
+      default:
+        FAIL() << reader.wire_type();
+    }
+    EXPECT_EQ(reader.remaining().size(), data.size() - input.CurrentPosition());
+  }
+  EXPECT_FALSE(reader.failed());
+  EXPECT_EQ(input.ReadTag(), 0);
+  EXPECT_GT(fields, 100);
+}
+
+TEST(WireReaderTest, DescendsIntoSubmessagesAndGroups) {
+  TestAllTypes message;
+  message.set_optional_int32(-1);
+  message.mutable_optionalgroup()->set_a(17);
+  message.mutable_optional_nested_message()->set_bb(42);
+  const std::string data = message.SerializeAsString();
+
+  WireReader reader(data);
+  ASSERT_TRUE(reader.Next());
+  EXPECT_EQ(reader.field_number(), 1);
+  EXPECT_EQ(static_cast<int32_t>(reader.varint()), -1);
+
+  ASSERT_TRUE(reader.Next());
+  EXPECT_EQ(reader.field_number(), 16);
+  EXPECT_EQ(reader.wire_type(), WireReader::kStartGroup);
+  WireReader group = reader.Descend();
+  ASSERT_TRUE(group.Next());
+  EXPECT_EQ(group.field_number(), 17);
+  EXPECT_EQ(group.varint(), 17);
+  EXPECT_FALSE(group.Next());
+  EXPECT_FALSE(group.failed());
+
+  ASSERT_TRUE(reader.Next());
+  EXPECT_EQ(reader.field_number(), 18);
+  WireReader nested = reader.Descend();
+  ASSERT_TRUE(nested.Next());
+  EXPECT_EQ(nested.field_number(), 1);
+  EXPECT_EQ(nested.varint(), 42);
+  EXPECT_FALSE(nested.Next());
+
+  EXPECT_FALSE(reader.Next());
+  EXPECT_FALSE(reader.failed());
+}
+
+TEST(WireReaderTest, MalformedInput) {
+  TestAllTypes message;
+  message.set_optional_string("hello");
+  std::string truncated = message.SerializeAsString();
+  truncated.pop_back();
+
+  for (absl::string_view data : {
+           absl::string_view(truncated),
+           absl::string_view("\x00\x01", 2),  // Field number 0.
+           absl::string_view("\x08\x80"),      // Unterminated varint.
+           absl::string_view("\x09\x01\x02"),  // Short fixed64.
+           absl::string_view("\x0c"),          // Stray end group.
+           absl::string_view("\x0b\x08\x01"),  // Unterminated group.
+           absl::string_view("\x0b\x14"),      // Mismatched end group.
+           absl::string_view("\x0e"),          // Wire type 6.
+       }) {
+    SCOPED_TRACE(absl::CEscape(data));
+    WireReader reader(data);
+    while (reader.Next()) {
+    }
+    EXPECT_TRUE(reader.failed());
+    EXPECT_FALSE(reader.Next());
+  }
+
+  WireReader empty("");
+  EXPECT_FALSE(empty.Next());
+  EXPECT_FALSE(empty.failed());
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
@@ -398,6 +398,8 @@ const ::_pbi::TcParseTable<0, 1, 0, 0, 2> DoubleValue::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_DoubleValue_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // double value = 1;
     {::_pbi::TcParser::FastF64S1,
@@ -490,8 +492,10 @@ void DoubleValue::MergeImpl(::google::protobuf::Message& to_msg, const ::google:
 void DoubleValue::CopyFrom(const DoubleValue& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.DoubleValue)
   if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  _impl_.value_ = from._impl_.value_;
+  _internal_metadata_.Clear<::google::protobuf::UnknownFieldSet>();
+  _internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      from._internal_metadata_);
 }
 
 PROTOBUF_NOINLINE bool DoubleValue::IsInitialized() const {
@@ -576,6 +580,8 @@ const ::_pbi::TcParseTable<0, 1, 0, 0, 2> FloatValue::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_FloatValue_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // float value = 1;
     {::_pbi::TcParser::FastF32S1,
@@ -668,8 +674,10 @@ void FloatValue::MergeImpl(::google::protobuf::Message& to_msg, const ::google::
 void FloatValue::CopyFrom(const FloatValue& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.FloatValue)
   if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  _impl_.value_ = from._impl_.value_;
+  _internal_metadata_.Clear<::google::protobuf::UnknownFieldSet>();
+  _internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      from._internal_metadata_);
 }
 
 PROTOBUF_NOINLINE bool FloatValue::IsInitialized() const {
@@ -754,6 +762,8 @@ const ::_pbi::TcParseTable<0, 1, 0, 0, 2> Int64Value::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_Int64Value_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // int64 value = 1;
     {::_pbi::TcParser::SingularVarintNoZag1<::uint64_t, offsetof(Int64Value, _impl_.value_), 63>(),
@@ -832,8 +842,10 @@ void Int64Value::MergeImpl(::google::protobuf::Message& to_msg, const ::google::
 void Int64Value::CopyFrom(const Int64Value& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.Int64Value)
   if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  _impl_.value_ = from._impl_.value_;
+  _internal_metadata_.Clear<::google::protobuf::UnknownFieldSet>();
+  _internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      from._internal_metadata_);
 }
 
 PROTOBUF_NOINLINE bool Int64Value::IsInitialized() const {
@@ -918,6 +930,8 @@ const ::_pbi::TcParseTable<0, 1, 0, 0, 2> UInt64Value::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_UInt64Value_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // uint64 value = 1;
     {::_pbi::TcParser::SingularVarintNoZag1<::uint64_t, offsetof(UInt64Value, _impl_.value_), 63>(),
@@ -996,8 +1010,10 @@ void UInt64Value::MergeImpl(::google::protobuf::Message& to_msg, const ::google:
 void UInt64Value::CopyFrom(const UInt64Value& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.UInt64Value)
   if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  _impl_.value_ = from._impl_.value_;
+  _internal_metadata_.Clear<::google::protobuf::UnknownFieldSet>();
+  _internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      from._internal_metadata_);
 }
 
 PROTOBUF_NOINLINE bool UInt64Value::IsInitialized() const {
@@ -1082,6 +1098,8 @@ const ::_pbi::TcParseTable<0, 1, 0, 0, 2> Int32Value::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_Int32Value_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // int32 value = 1;
     {::_pbi::TcParser::SingularVarintNoZag1<::uint32_t, offsetof(Int32Value, _impl_.value_), 63>(),
@@ -1160,8 +1178,10 @@ void Int32Value::MergeImpl(::google::protobuf::Message& to_msg, const ::google::
 void Int32Value::CopyFrom(const Int32Value& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.Int32Value)
   if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  _impl_.value_ = from._impl_.value_;
+  _internal_metadata_.Clear<::google::protobuf::UnknownFieldSet>();
+  _internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      from._internal_metadata_);
 }
 
 PROTOBUF_NOINLINE bool Int32Value::IsInitialized() const {
@@ -1246,6 +1266,8 @@ const ::_pbi::TcParseTable<0, 1, 0, 0, 2> UInt32Value::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_UInt32Value_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // uint32 value = 1;
     {::_pbi::TcParser::SingularVarintNoZag1<::uint32_t, offsetof(UInt32Value, _impl_.value_), 63>(),
@@ -1324,8 +1346,10 @@ void UInt32Value::MergeImpl(::google::protobuf::Message& to_msg, const ::google:
 void UInt32Value::CopyFrom(const UInt32Value& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.UInt32Value)
   if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  _impl_.value_ = from._impl_.value_;
+  _internal_metadata_.Clear<::google::protobuf::UnknownFieldSet>();
+  _internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      from._internal_metadata_);
 }
 
 PROTOBUF_NOINLINE bool UInt32Value::IsInitialized() const {
@@ -1410,6 +1434,8 @@ const ::_pbi::TcParseTable<0, 1, 0, 0, 2> BoolValue::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_BoolValue_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // bool value = 1;
     {::_pbi::TcParser::SingularVarintNoZag1<bool, offsetof(BoolValue, _impl_.value_), 63>(),
@@ -1487,8 +1513,10 @@ void BoolValue::MergeImpl(::google::protobuf::Message& to_msg, const ::google::p
 void BoolValue::CopyFrom(const BoolValue& from) {
 // @@protoc_insertion_point(class_specific_copy_from_start:google.protobuf.BoolValue)
   if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  _impl_.value_ = from._impl_.value_;
+  _internal_metadata_.Clear<::google::protobuf::UnknownFieldSet>();
+  _internal_metadata_.MergeFrom<::google::protobuf::UnknownFieldSet>(
+      from._internal_metadata_);
 }
 
 PROTOBUF_NOINLINE bool BoolValue::IsInitialized() const {
@@ -1591,6 +1619,8 @@ const ::_pbi::TcParseTable<0, 1, 0, 41, 2> StringValue::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_StringValue_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // string value = 1;
     {::_pbi::TcParser::FastUS1,
@@ -1780,6 +1810,8 @@ const ::_pbi::TcParseTable<0, 1, 0, 0, 2> BytesValue::_table_ = {
     offsetof(decltype(_table_), field_names),  // no aux_entries
     &_BytesValue_default_instance_._instance,
     ::_pbi::TcParser::GenericFallback,  // fallback
+    0,  // required_fields_mask
+    true,  // tracks_required_fields
   }, {{
     // bytes value = 1;
     {::_pbi::TcParser::FastBS1,
@@ -195,6 +195,11 @@ class PROTOBUF_EXPORT DoubleValue final :
   DoubleValue* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<DoubleValue>(arena);
   }
+  DoubleValue* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    DoubleValue* copy = CreateMaybeMessage<DoubleValue>(arena);
+    copy->CopyFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const DoubleValue& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -351,6 +356,11 @@ class PROTOBUF_EXPORT FloatValue final :
   FloatValue* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<FloatValue>(arena);
   }
+  FloatValue* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    FloatValue* copy = CreateMaybeMessage<FloatValue>(arena);
+    copy->CopyFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const FloatValue& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -507,6 +517,11 @@ class PROTOBUF_EXPORT Int64Value final :
   Int64Value* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Int64Value>(arena);
   }
+  Int64Value* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Int64Value* copy = CreateMaybeMessage<Int64Value>(arena);
+    copy->CopyFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Int64Value& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -663,6 +678,11 @@ class PROTOBUF_EXPORT UInt64Value final :
   UInt64Value* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<UInt64Value>(arena);
   }
+  UInt64Value* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    UInt64Value* copy = CreateMaybeMessage<UInt64Value>(arena);
+    copy->CopyFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const UInt64Value& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -819,6 +839,11 @@ class PROTOBUF_EXPORT Int32Value final :
   Int32Value* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<Int32Value>(arena);
   }
+  Int32Value* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    Int32Value* copy = CreateMaybeMessage<Int32Value>(arena);
+    copy->CopyFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const Int32Value& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -975,6 +1000,11 @@ class PROTOBUF_EXPORT UInt32Value final :
   UInt32Value* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<UInt32Value>(arena);
   }
+  UInt32Value* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    UInt32Value* copy = CreateMaybeMessage<UInt32Value>(arena);
+    copy->CopyFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const UInt32Value& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -1131,6 +1161,11 @@ class PROTOBUF_EXPORT BoolValue final :
   BoolValue* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<BoolValue>(arena);
   }
+  BoolValue* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    BoolValue* copy = CreateMaybeMessage<BoolValue>(arena);
+    copy->CopyFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const BoolValue& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -1287,6 +1322,11 @@ class PROTOBUF_EXPORT StringValue final :
   StringValue* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<StringValue>(arena);
   }
+  StringValue* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    StringValue* copy = CreateMaybeMessage<StringValue>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const StringValue& from);
   using ::google::protobuf::Message::MergeFrom;
@@ -1449,6 +1489,11 @@ class PROTOBUF_EXPORT BytesValue final :
   BytesValue* New(::google::protobuf::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<BytesValue>(arena);
   }
+  BytesValue* Clone(::google::protobuf::Arena* arena = nullptr) const {
+    BytesValue* copy = CreateMaybeMessage<BytesValue>(arena);
+    copy->MergeFrom(*this);
+    return copy;
+  }
   using ::google::protobuf::Message::CopyFrom;
   void CopyFrom(const BytesValue& from);
   using ::google::protobuf::Message::MergeFrom;